@@ -116,13 +116,18 @@
  * and reception is set through BOOT_COM_USB_TX_MAX_DATA and BOOT_COM_USB_RX_MAX_DATA,
  * respectively.
  *
+ * Packets are sent over the bulk endpoints of a vendor interface, each one preceded by
+ * a length byte, so they are not limited to the 64 bytes of an endpoint. They are set
+ * to the largest packet XCP can announce, which makes each PROGRAM_MAX command carry 254
+ * bytes of program data per round trip. The TinyUSB vendor FIFOs (tusb_config.h) must
+ * hold a complete packet plus its length byte.
  */
 /** \brief Enable/disable USB transport layer. */
 #define BOOT_COM_USB_ENABLE             (1)
 /** \brief Configure number of bytes in the target->host data packet. */
-#define BOOT_COM_USB_TX_MAX_DATA        (63)
+#define BOOT_COM_USB_TX_MAX_DATA        (255)
 /** \brief Configure number of bytes in the host->target data packet. */
-#define BOOT_COM_USB_RX_MAX_DATA        (63)
+#define BOOT_COM_USB_RX_MAX_DATA        (255)
 
 /* The CAN communication interface is selected by setting the BOOT_COM_CAN_ENABLE
  * configurable to 1. Configurable BOOT_COM_CAN_BAUDRATE selects the communication speed
@@ -158,12 +163,19 @@
  * and reception is set through BOOT_COM_RS232_TX_MAX_DATA and BOOT_COM_RS232_RX_MAX_DATA,
  * respectively. It is common for a microcontroller to have more than 1 UART interface
  * on board. The zero-based BOOT_COM_RS232_CHANNEL_INDEX selects the UART interface.
+ * With BOOT_COM_RS232_AUTOBAUD_ENABLE set to 1, the bootloader detects the speed of the
+ * host from its first XCP CONNECT: it starts at BOOT_COM_RS232_BAUDRATE and steps down
+ * through the standard speeds to 57600 bits/second until the CONNECT arrives intact,
+ * and keeps that speed until the next reset. Hosts faster than BOOT_COM_RS232_BAUDRATE
+ * are not detected.
  *
  */
 /** \brief Enable/disable UART transport layer. */
 #define BOOT_COM_RS232_ENABLE            (1)
 /** \brief Configure the desired communication speed. */
-#define BOOT_COM_RS232_BAUDRATE          (57600)
+#define BOOT_COM_RS232_BAUDRATE          (921600)
+/** \brief Enable/disable detecting the communication speed of the host. */
+#define BOOT_COM_RS232_AUTOBAUD_ENABLE   (1)
 /** \brief Configure number of bytes in the target->host data packet. */
 #define BOOT_COM_RS232_TX_MAX_DATA       (129)
 /** \brief Configure number of bytes in the host->target data packet. */
@@ -186,6 +198,31 @@
 /** \brief Enable/disable the backdoor override hook functions. */
 #define BOOT_BACKDOOR_HOOKS_ENABLE      (0)
 
+/* The timed backdoor keeps the bootloader waiting for a host before it starts the user
+ * program. Where the board is power cycled without ever being updated, for example on a
+ * production test line, this wait can be skipped. When BOOT_BACKDOOR_FAST_START_ENABLE
+ * is set to 1, hook function BackDoorFastStartHook() is called once the bootloader is
+ * initialized. It requests a fast start when the strap pin configured with
+ * BOOT_BACKDOOR_FAST_START_PORT and BOOT_BACKDOOR_FAST_START_PIN is pulled high, or
+ * when the RAM word at BOOT_BACKDOOR_FAST_START_ADDR holds BOOT_BACKDOOR_FAST_START_MAGIC.
+ * The RAM word survives a software reset only, and is cleared when it is read. The
+ * user program is then started right away, after its checksum was verified. Without a
+ * valid user program, or with the backdoor entry pushbutton pressed, the bootloader
+ * stays active as usual.
+ */
+/** \brief Enable/disable the fast start of the user program. */
+#define BOOT_BACKDOOR_FAST_START_ENABLE (1)
+/** \brief GPIO port of the fast start strap pin. */
+#define BOOT_BACKDOOR_FAST_START_PORT   (GPIOE)
+/** \brief Fast start strap pin, pulled low internally. */
+#define BOOT_BACKDOOR_FAST_START_PIN    (LL_GPIO_PIN_2)
+/** \brief Address of the fast start RAM word: the last 32 bytes of SRAM2, which the
+ *         user program's linker script reserves, and the bootloader does not use.
+ */
+#define BOOT_BACKDOOR_FAST_START_ADDR   (0x2004FFE0)
+/** \brief Value of the fast start RAM word that requests a fast start. */
+#define BOOT_BACKDOOR_FAST_START_MAGIC  (0x46535452)
+
 
 /****************************************************************************************
 *   N O N - V O L A T I L E   M E M O R Y   D R I V E R   C O N F I G U R A T I O N
@@ -205,6 +242,71 @@
 /** \brief Enable/disable hooks functions to override the user program checksum handling. */
 #define BOOT_NVM_CHECKSUM_HOOKS_ENABLE  (0)
 
+/* The flash driver collects the data to program in blocks of BOOT_FLASH_WRITE_BLOCK_SIZE
+ * bytes and programs each block in one go. Blocks as large as a flash sector have the
+ * fewest block switches and programming setups per image. The flash block manager keeps
+ * a few blocks in RAM.
+ */
+/** \brief Size of a flash block for writing, a power of two up to the 8 KB sector. */
+#define BOOT_FLASH_WRITE_BLOCK_SIZE     (8192)
+
+/* The checksum only covers the first entries of the user program's vector table. It shows
+ * that a programming session completed, but not that the rest of the user program is
+ * still intact. With BOOT_FLASH_IMAGE_CRC_ENABLE set to 1, the flash driver additionally
+ * writes the size and the CRC32 of the entire user program right after the checksum, and
+ * verifies them before every start of the user program. The CRC32 is computed by the CRC
+ * calculation unit, so this costs about as long as reading the user program from flash.
+ * The user program's linker script reserves the words for the checksum, the size and the
+ * CRC32 right after its vector table.
+ */
+/** \brief Enable/disable the CRC32 of the entire user program. */
+#define BOOT_FLASH_IMAGE_CRC_ENABLE     (1)
+
+/* Most firmware updates only change part of the user program. With
+ * BOOT_FLASH_SKIP_UNCHANGED_ENABLE set to 1, the flash driver defers the erase of a
+ * sector until a block of data for it differs from what the sector already holds, and
+ * does not program blocks that are unchanged. Sectors that only receive unchanged data
+ * are not erased at all. The sector holding the vector table is still erased right away,
+ * so an interrupted update cannot leave a valid checksum behind.
+ */
+/** \brief Enable/disable skipping the erase and programming of unchanged sectors. */
+#define BOOT_FLASH_SKIP_UNCHANGED_ENABLE (1)
+
+/* For A/B updates, the user program writes a new version of itself to the same range of
+ * the other flash bank while it keeps running. With BOOT_FLASH_BANK_SWAP_ENABLE set to 1,
+ * hook function FlashBankSwapHook() is called once the bootloader is initialized. When
+ * the RAM word at BOOT_FLASH_BANK_SWAP_ADDR holds BOOT_FLASH_BANK_SWAP_MAGIC, the flash
+ * driver checks the checksum and the CRC32 of the image in the other bank, copies the
+ * bootloader and the user program's persistent storage sectors over, and toggles the
+ * SWAP_BANK option byte. The reset that follows starts the new user program from bank 1,
+ * and the previous one stays in bank 2. If the image is not valid, nothing changes. The
+ * user program's linker script limits it to one bank, without the bank's last three
+ * sectors.
+ */
+/** \brief Enable/disable swapping the flash banks on request of the user program. */
+#define BOOT_FLASH_BANK_SWAP_ENABLE     (1)
+/** \brief Address of the bank swap RAM word, next to the fast start RAM word. */
+#define BOOT_FLASH_BANK_SWAP_ADDR       (0x2004FFE4)
+/** \brief Value of the bank swap RAM word that requests a bank swap. */
+#define BOOT_FLASH_BANK_SWAP_MAGIC      (0x53574150)
+
+/* Over the UART, an update takes as long as its bytes take on the line. With
+ * BOOT_FLASH_UNPACK_ENABLE set to 1, the flash driver also accepts the user program as a
+ * heatshrink compressed stream, programmed from BOOT_FLASH_UNPACK_ADDR on. The stream is
+ * decompressed while it is received and programmed from the start of the user program,
+ * so host tools send it like any other S-record file. Its window and lookahead sizes
+ * must be those given to the heatshrink encoder. The build generates the compressed
+ * file next to the regular one when heatshrink is installed.
+ */
+/** \brief Enable/disable receiving the user program as a compressed stream. */
+#define BOOT_FLASH_UNPACK_ENABLE        (1)
+/** \brief Start of the window of the compressed stream, outside of all memories. */
+#define BOOT_FLASH_UNPACK_ADDR          (0xC0000000)
+/** \brief Window size of the compressed stream, as heatshrink's -w option. */
+#define BOOT_FLASH_UNPACK_WINDOW_BITS   (11)
+/** \brief Lookahead size of the compressed stream, as heatshrink's -l option. */
+#define BOOT_FLASH_UNPACK_LOOKAHEAD_BITS (4)
+
 
 /****************************************************************************************
 *   W A T C H D O G   D R I V E R   C O N F I G U R A T I O N
@@ -63,6 +63,62 @@ blt_bool BackDoorEntryHook(void)
 #endif /* BOOT_BACKDOOR_HOOKS_ENABLE > 0 */
 
 
+#if (BOOT_BACKDOOR_FAST_START_ENABLE > 0)
+/************************************************************************************//**
+** \brief     Checks if the user program should be started without waiting in the
+**            backdoor. The fast start RAM word is cleared, so that the next reset
+**            opens the backdoor again, unless it is requested anew.
+** \return    BLT_TRUE if a fast start is requested, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+blt_bool BackDoorFastStartHook(void)
+{
+  volatile blt_int32u *ramWord = (volatile blt_int32u *)BOOT_BACKDOOR_FAST_START_ADDR;
+  blt_bool result = BLT_FALSE;
+
+  /* fast start requested by the user program or a debugger before a software reset */
+  if (*ramWord == BOOT_BACKDOOR_FAST_START_MAGIC)
+  {
+    result = BLT_TRUE;
+  }
+  *ramWord = 0;
+
+  /* fast start strapped on the board, e.g. by a production test fixture */
+  if (LL_GPIO_IsInputPinSet(BOOT_BACKDOOR_FAST_START_PORT,
+                            BOOT_BACKDOOR_FAST_START_PIN) != 0)
+  {
+    result = BLT_TRUE;
+  }
+
+  return result;
+} /*** end of BackDoorFastStartHook ***/
+#endif /* BOOT_BACKDOOR_FAST_START_ENABLE > 0 */
+
+
+#if (BOOT_FLASH_BANK_SWAP_ENABLE > 0)
+/************************************************************************************//**
+** \brief     Checks if the user program requested a swap of the flash banks, to start
+**            the new user program that it wrote to the other bank. The bank swap RAM
+**            word is cleared, so that the request is acted upon once only.
+** \return    BLT_TRUE if a bank swap is requested, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+blt_bool FlashBankSwapHook(void)
+{
+  volatile blt_int32u *ramWord = (volatile blt_int32u *)BOOT_FLASH_BANK_SWAP_ADDR;
+  blt_bool result = BLT_FALSE;
+
+  if (*ramWord == BOOT_FLASH_BANK_SWAP_MAGIC)
+  {
+    result = BLT_TRUE;
+  }
+  *ramWord = 0;
+
+  return result;
+} /*** end of FlashBankSwapHook ***/
+#endif /* BOOT_FLASH_BANK_SWAP_ENABLE > 0 */
+
+
 /****************************************************************************************
 *   C P U   D R I V E R   H O O K   F U N C T I O N S
 ****************************************************************************************/
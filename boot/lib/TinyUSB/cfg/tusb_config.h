@@ -108,8 +108,9 @@
 
 // Vendor FIFO size of TX and RX
 // If not configured vendor endpoints will not be buffered
-#define CFG_TUD_VENDOR_RX_BUFSIZE (64)
-#define CFG_TUD_VENDOR_TX_BUFSIZE (64)
+// Each must hold at least one XCP packet and its length byte (blt_conf.h)
+#define CFG_TUD_VENDOR_RX_BUFSIZE (512)
+#define CFG_TUD_VENDOR_TX_BUFSIZE (512)
 #ifdef __cplusplus
  }
 #endif
@@ -39,6 +39,9 @@
 #include "stm32h5xx_ll_gpio.h"                   /* STM32 LL GPIO header               */
 #include "stm32h5xx_ll_icache.h"                 /* STM32 LL internal cache header     */
 #include "stm32h5xx_ll_crs.h"                    /* STM32 LL CRS header                */
+#if (BOOT_FLASH_BANK_SWAP_ENABLE > 0)
+#include "flash.h"                               /* flash driver header                */
+#endif
 
 
 /****************************************************************************************
@@ -46,6 +49,12 @@
 ****************************************************************************************/
 static void Init(void);
 static void SystemClock_Config(void);
+#if (BOOT_BACKDOOR_FAST_START_ENABLE > 0)
+extern blt_bool BackDoorFastStartHook(void);
+#endif
+#if (BOOT_FLASH_BANK_SWAP_ENABLE > 0)
+extern blt_bool FlashBankSwapHook(void);
+#endif
 
 
 /************************************************************************************//**
@@ -60,6 +69,25 @@ int main(void)
   Init();
   /* Initialize the bootloader */
   BootInit();
+#if (BOOT_FLASH_BANK_SWAP_ENABLE > 0)
+  /* Start the user program in the other flash bank, when the running user program
+   * requested it. This function does not return if the banks are swapped. Otherwise
+   * the bootloader carries on with the user program in bank 1.
+   */
+  if (FlashBankSwapHook() == BLT_TRUE)
+  {
+    (void)FlashSwapBanks();
+  }
+#endif
+#if (BOOT_BACKDOOR_FAST_START_ENABLE > 0)
+  /* Skip the backdoor when a fast start is requested. This function does not return
+   * if a valid user program is present.
+   */
+  if (BackDoorFastStartHook() == BLT_TRUE)
+  {
+    CpuStartUserProgram();
+  }
+#endif
 #if (BOOT_COM_DEFERRED_INIT_ENABLE == 1)
   /* The bootloader is configured to NOT initialize the TCP/IP network stack by default
    * to bypass unnecessary delay times before starting the user program. The TCP/IP net-
@@ -268,6 +296,13 @@ void HAL_MspInit(void)
   GPIO_InitStruct.Mode = LL_GPIO_MODE_INPUT;
   GPIO_InitStruct.Pull = LL_GPIO_PULL_NO;
   LL_GPIO_Init(GPIOC, &GPIO_InitStruct);
+#if (BOOT_BACKDOOR_FAST_START_ENABLE > 0)
+  /* Configure GPIO pin for the fast start strap. */
+  GPIO_InitStruct.Pin = BOOT_BACKDOOR_FAST_START_PIN;
+  GPIO_InitStruct.Mode = LL_GPIO_MODE_INPUT;
+  GPIO_InitStruct.Pull = LL_GPIO_PULL_DOWN;
+  LL_GPIO_Init(BOOT_BACKDOOR_FAST_START_PORT, &GPIO_InitStruct);
+#endif
 #if (BOOT_COM_RS232_ENABLE > 0)
   /* UART TX and RX GPIO pin configuration. */
   GPIO_InitStruct.Pin = LL_GPIO_PIN_8 | LL_GPIO_PIN_9;
@@ -42,8 +42,18 @@
 #define FLASH_INVALID_SECTOR_IDX        (0xff)
 /** \brief Value for an invalid flash address. */
 #define FLASH_INVALID_ADDRESS           (0xffffffff)
+#ifndef BOOT_FLASH_WRITE_BLOCK_SIZE
+/** \brief Size of a flash block for writing. Larger blocks take fewer switches of the
+ *         flash block manager, at the cost of RAM for each of its blocks.
+ */
+#define BOOT_FLASH_WRITE_BLOCK_SIZE     (1024)
+#endif
 /** \brief Standard size of a flash block for writing. */
-#define FLASH_WRITE_BLOCK_SIZE          (1024)
+#define FLASH_WRITE_BLOCK_SIZE          (BOOT_FLASH_WRITE_BLOCK_SIZE)
+/** \brief Number of bytes programmed at once, a quad word. */
+#define FLASH_QWORD_SIZE                (16U)
+/** \brief Number of quad words programmed between services of the watchdog. */
+#define FLASH_QWORDS_PER_COP_SERVICE    (64U)
 /** \brief Total numbers of sectors in array flashLayout[]. */
 #define FLASH_TOTAL_SECTORS             (sizeof(flashLayout)/sizeof(flashLayout[0]))
 /** \brief End address of the bootloader programmable flash. */
@@ -60,14 +70,135 @@
 #define BOOT_FLASH_VECTOR_TABLE_CS_OFFSET    (0x24C)
 #endif
 
+#ifndef BOOT_FLASH_IMAGE_CRC_ENABLE
+/** \brief Enable/disable the CRC32 of the entire user program. When enabled, the
+ *         bootloader writes the size of the user program and its CRC32 right after the
+ *         checksum, and only starts the user program if the CRC32 still matches.
+ */
+#define BOOT_FLASH_IMAGE_CRC_ENABLE          (0)
+#endif
+
+#if (BOOT_FLASH_IMAGE_CRC_ENABLE > 0)
+/** \brief Offset into the user program's vector table of its size in bytes. */
+#define FLASH_IMAGE_SIZE_OFFSET              (BOOT_FLASH_VECTOR_TABLE_CS_OFFSET + 4)
+/** \brief Offset into the user program's vector table of its CRC32. */
+#define FLASH_IMAGE_CRC_OFFSET               (BOOT_FLASH_VECTOR_TABLE_CS_OFFSET + 8)
+#endif
+
+#ifndef BOOT_FLASH_SKIP_UNCHANGED_ENABLE
+/** \brief Enable/disable skipping the erase and programming of unchanged flash sectors.
+ *         When enabled, the erase of a sector is deferred until a block of data for
+ *         it differs from what the sector already holds. Blocks that match are not
+ *         programmed. A sector that only receives matching blocks is never erased.
+ */
+#define BOOT_FLASH_SKIP_UNCHANGED_ENABLE     (0)
+#endif
+
+/** \brief Number of flash blocks that the bootloader can program. */
+#define FLASH_TOTAL_BLOCKS                   ((BOOT_NVM_SIZE_KB*1024)/FLASH_WRITE_BLOCK_SIZE)
+
+#if (BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0)
+/** \brief Size of the largest flash sector in flashLayout[]. */
+#define FLASH_MAX_SECTOR_SIZE                (0x20000)
+#endif
+
+#ifndef BOOT_FLASH_BANK_SWAP_ENABLE
+/** \brief Enable/disable swapping the flash banks to start the user program that the
+ *         running user program wrote to the same range of the other bank.
+ */
+#define BOOT_FLASH_BANK_SWAP_ENABLE          (0)
+#endif
+
+#if (BOOT_FLASH_BANK_SWAP_ENABLE > 0)
+/** \brief Size of each of the two flash banks. */
+#define FLASH_SWAP_BANK_SIZE                 ((BOOT_NVM_SIZE_KB * 1024U) / 2U)
+/** \brief Size of the bootloader, in front of the user program in both banks. */
+#define FLASH_SWAP_BOOT_SIZE                 (flashLayout[0].sector_start - FLASH_BASE)
+/** \brief Start of the user program's counterpart in the other flash bank. */
+#define FLASH_SWAP_IMAGE_START               (flashLayout[0].sector_start + \
+                                              FLASH_SWAP_BANK_SIZE)
+/** \brief Size of the user program's persistent storage at the end of each bank: its
+ *         key-value store sectors, followed by its storage sector.
+ */
+#define FLASH_SWAP_STORAGE_SIZE              (3U * FLASH_SECTOR_SIZE)
+/** \brief Largest user program in the other flash bank. The user program's persistent
+ *         storage at the end of each bank is left out.
+ */
+#define FLASH_SWAP_IMAGE_MAX_SIZE            (FLASH_SWAP_BANK_SIZE - FLASH_SWAP_BOOT_SIZE - \
+                                              FLASH_SWAP_STORAGE_SIZE)
+#endif
+
+#ifndef BOOT_FLASH_UNPACK_ENABLE
+/** \brief Enable/disable receiving the user program as a heatshrink compressed stream.
+ *         When enabled, data programmed to the window at BOOT_FLASH_UNPACK_ADDR is
+ *         decompressed on the fly and programmed from the start of the user program.
+ */
+#define BOOT_FLASH_UNPACK_ENABLE             (0)
+#endif
+
+#if (BOOT_FLASH_UNPACK_ENABLE > 0)
+#ifndef BOOT_FLASH_UNPACK_ADDR
+/** \brief Start of the window that the compressed stream is programmed to. The window
+ *         is not backed by memory and must not overlap the flash device.
+ */
+#define BOOT_FLASH_UNPACK_ADDR               (0xC0000000)
+#endif
+#ifndef BOOT_FLASH_UNPACK_WINDOW_BITS
+/** \brief Window size of the compressed stream, as heatshrink's -w option. */
+#define BOOT_FLASH_UNPACK_WINDOW_BITS        (11)
+#endif
+#ifndef BOOT_FLASH_UNPACK_LOOKAHEAD_BITS
+/** \brief Lookahead size of the compressed stream, as heatshrink's -l option. */
+#define BOOT_FLASH_UNPACK_LOOKAHEAD_BITS     (4)
+#endif
+/** \brief Size of the window, which no compressed stream of a user program exceeds. */
+#define FLASH_UNPACK_WINDOW_SIZE             (BOOT_NVM_SIZE_KB * 1024U)
+/** \brief Size of the history of decompressed data that back-references copy from. */
+#define FLASH_UNPACK_HISTORY_SIZE            (1U << BOOT_FLASH_UNPACK_WINDOW_BITS)
+/** \brief Number of bytes decompressed before they go to the flash block manager. */
+#define FLASH_UNPACK_CHUNK_SIZE              (128)
+#endif
+
 
 /****************************************************************************************
 * Plausibility checks
 ****************************************************************************************/
+#if (FLASH_WRITE_BLOCK_SIZE < 1024) || (FLASH_WRITE_BLOCK_SIZE > FLASH_SECTOR_SIZE) || \
+    ((FLASH_WRITE_BLOCK_SIZE & (FLASH_WRITE_BLOCK_SIZE - 1)) != 0)
+#error "BOOT_FLASH_WRITE_BLOCK_SIZE must be a power of two from 1024 up to the sector size."
+#endif
+
 #if (BOOT_FLASH_VECTOR_TABLE_CS_OFFSET >= FLASH_WRITE_BLOCK_SIZE)
 #error "BOOT_FLASH_VECTOR_TABLE_CS_OFFSET is set too high. It must be located in the first writable block."
 #endif
 
+#if (BOOT_FLASH_IMAGE_CRC_ENABLE > 0)
+#if ((FLASH_IMAGE_CRC_OFFSET + 4) > FLASH_WRITE_BLOCK_SIZE)
+#error "BOOT_FLASH_VECTOR_TABLE_CS_OFFSET is set too high. The image size and CRC32 must be located in the first writable block."
+#endif
+#endif
+
+#if (BOOT_FLASH_BANK_SWAP_ENABLE > 0) && (BOOT_FLASH_IMAGE_CRC_ENABLE == 0)
+#error "BOOT_FLASH_BANK_SWAP_ENABLE needs BOOT_FLASH_IMAGE_CRC_ENABLE to check the other bank."
+#endif
+
+#if (BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0) && (BOOT_FLASH_CRYPTO_HOOKS_ENABLE > 0)
+#error "BOOT_FLASH_SKIP_UNCHANGED_ENABLE cannot compare encrypted data with flash."
+#endif
+
+#if (BOOT_FLASH_UNPACK_ENABLE > 0)
+#if (BOOT_FLASH_UNPACK_WINDOW_BITS < 4) || (BOOT_FLASH_UNPACK_WINDOW_BITS > 15)
+#error "BOOT_FLASH_UNPACK_WINDOW_BITS must be in the range 4 to 15."
+#endif
+#if (BOOT_FLASH_UNPACK_LOOKAHEAD_BITS < 3) || \
+    (BOOT_FLASH_UNPACK_LOOKAHEAD_BITS >= BOOT_FLASH_UNPACK_WINDOW_BITS)
+#error "BOOT_FLASH_UNPACK_LOOKAHEAD_BITS must be at least 3 and below the window bits."
+#endif
+#if (BOOT_FLASH_CRYPTO_HOOKS_ENABLE > 0)
+#error "BOOT_FLASH_UNPACK_ENABLE cannot decompress encrypted data."
+#endif
+#endif
+
 #ifndef BOOT_FLASH_CUSTOM_LAYOUT_ENABLE
 #define BOOT_FLASH_CUSTOM_LAYOUT_ENABLE (0u)
 #endif
@@ -96,6 +227,37 @@ typedef struct
   blt_int8u data[FLASH_WRITE_BLOCK_SIZE] __ALIGNED(32);
 } tFlashBlockInfo;
 
+#if (BOOT_FLASH_UNPACK_ENABLE > 0)
+/** \brief Fields of the compressed stream, in the order that they follow each other. */
+typedef enum
+{
+  FLASH_UNPACK_TAG,                              /**< 1 for a literal, 0 otherwise     */
+  FLASH_UNPACK_LITERAL,                          /**< 8-bit literal byte               */
+  FLASH_UNPACK_INDEX,                            /**< back-reference distance - 1      */
+  FLASH_UNPACK_COUNT                             /**< back-reference length - 1        */
+} tFlashUnpackField;
+
+/** \brief    Structure type for the state of the decompression.
+ *  \details  The stream is heatshrink's: a bit stream, most significant bit first, of
+ *            tagged literals and back-references into the last FLASH_UNPACK_HISTORY_SIZE
+ *            decompressed bytes, which start out as zeros. It is decompressed into
+ *            .chunk, which then goes to the flash block manager as any other data.
+ */
+typedef struct
+{
+  blt_int32u        stream_offset;               /**< offset of the next stream byte   */
+  tFlashUnpackField field;                       /**< field that is being read         */
+  blt_int8u         field_bits;                  /**< bits of the field still to read  */
+  blt_int16u        field_value;                 /**< bits of the field read so far    */
+  blt_int16u        index;                       /**< index of the back-reference      */
+  blt_int32u        out_size;                    /**< decompressed bytes so far        */
+  blt_addr          erased_end;                  /**< end of the erased sectors        */
+  blt_int32u        chunk_len;                   /**< bytes in chunk[]                 */
+  blt_int8u         chunk[FLASH_UNPACK_CHUNK_SIZE];
+  blt_int8u         history[FLASH_UNPACK_HISTORY_SIZE];
+} tFlashUnpackInfo;
+#endif
+
 
 /****************************************************************************************
 * Hook functions
@@ -115,11 +277,31 @@ static blt_bool  FlashAddToBlock(tFlashBlockInfo *block, blt_addr address,
                                  blt_int8u *data, blt_int32u len);
 static blt_bool  FlashWriteBlock(tFlashBlockInfo *block);
 static blt_bool  FlashEmptyCheckSector(blt_int8u sector_idx);
+static void      FlashMarkErased(blt_int8u sector_idx);
+static blt_bool  FlashProgramBlock(tFlashBlockInfo *block);
 static blt_bool  FlashEraseSectors(blt_int8u first_sector_idx, 
                                    blt_int8u last_sector_idx);
 static blt_int8u FlashGetSectorIdx(blt_addr address);
 static blt_int32u FlashGetBank(blt_addr address);
 static blt_int32u FlashGetPage(blt_addr address);
+static blt_bool  FlashVerifyImage(blt_addr image_start, blt_int32u max_size);
+#if (BOOT_FLASH_IMAGE_CRC_ENABLE > 0)
+static blt_int32u FlashComputeImageCrc(const blt_int8u *boot_block, blt_addr image_start,
+                                       blt_int32u size);
+#endif
+#if (BOOT_FLASH_BANK_SWAP_ENABLE > 0)
+static blt_bool  FlashCopySectors(blt_addr dst, blt_addr src, blt_int32u len);
+#endif
+#if (BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0)
+static blt_bool  FlashBlockUnchanged(tFlashBlockInfo *block);
+static blt_bool  FlashErasePendingSector(blt_int8u sector_idx);
+static blt_bool  FlashFinishPendingErase(void);
+#endif
+#if (BOOT_FLASH_UNPACK_ENABLE > 0)
+static blt_bool  FlashUnpackWrite(blt_int32u offset, blt_int32u len, blt_int8u *data);
+static blt_bool  FlashUnpackPut(blt_int8u value);
+static blt_bool  FlashUnpackFlush(void);
+#endif
 
 
 /****************************************************************************************
@@ -223,6 +405,47 @@ static tFlashBlockInfo blockInfo;
  */
 static tFlashBlockInfo bootBlockInfo;
 
+/** \brief   Bit per flash block, set while the block is known to be erased, because its
+ *           sector was erased and the block was not programmed since. Such a block is
+ *           not read from flash when the block manager starts on it.
+ */
+static blt_int8u flashBlockErased[FLASH_TOTAL_BLOCKS/8];
+
+#if (BOOT_FLASH_IMAGE_CRC_ENABLE > 0)
+/** \brief   End address of the data programmed during this session, plus one. This
+ *           determines the size of the user program that the CRC32 covers.
+ */
+static blt_addr flashImageEnd;
+#endif
+
+#if (BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0)
+/** \brief   Sectors that were requested to be erased, but that were not erased yet,
+ *           because all blocks that were programmed into them so far were unchanged.
+ */
+static blt_bool flashErasePending[FLASH_TOTAL_SECTORS];
+
+/** \brief   Bit per flash block, set when data for the block was received. */
+static blt_int8u flashBlockReceived[FLASH_TOTAL_BLOCKS/8];
+
+/** \brief   Bit per flash block, set when the block was not programmed because flash
+ *           already held its data.
+ */
+static blt_int8u flashBlockSkipped[FLASH_TOTAL_BLOCKS/8];
+
+/** \brief   Copy of the skipped blocks of a sector, while that sector is erased after
+ *           all, so that they can be programmed again.
+ */
+static blt_int8u flashSectorCopy[FLASH_MAX_SECTOR_SIZE] __ALIGNED(32);
+
+/** \brief   Block used to program the skipped blocks again. */
+static tFlashBlockInfo restoreBlockInfo;
+#endif
+
+#if (BOOT_FLASH_UNPACK_ENABLE > 0)
+/** \brief   State of the decompression of the compressed stream. */
+static tFlashUnpackInfo flashUnpack;
+#endif
+
 
 /************************************************************************************//**
 ** \brief     Initializes the flash driver.
@@ -248,6 +471,16 @@ void FlashInit(void)
   /* init the flash block info structs by setting the address to an invalid address */
   blockInfo.base_addr = FLASH_INVALID_ADDRESS;
   bootBlockInfo.base_addr = FLASH_INVALID_ADDRESS;
+#if (BOOT_FLASH_IMAGE_CRC_ENABLE > 0)
+  flashImageEnd = 0;
+  /* enable the clock of the CRC calculation unit */
+  RCC->AHB1ENR |= RCC_AHB1ENR_CRCEN;
+  (void)RCC->AHB1ENR;
+#endif
+#if (BOOT_FLASH_UNPACK_ENABLE > 0)
+  flashUnpack.stream_offset = 0;
+  flashUnpack.chunk_len = 0;
+#endif
 } /*** end of FlashInit ***/
 
 
@@ -265,6 +498,22 @@ blt_bool FlashWrite(blt_addr addr, blt_int32u len, blt_int8u *data)
 {
   blt_bool result = BLT_TRUE;
   blt_addr base_addr;
+#if (BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0)
+  blt_int32u block_idx;
+#endif
+
+#if (BOOT_FLASH_UNPACK_ENABLE > 0)
+  /* data for the window is a compressed stream, to decompress into the user program */
+  if ((addr >= BOOT_FLASH_UNPACK_ADDR) &&
+      ((addr - BOOT_FLASH_UNPACK_ADDR) < FLASH_UNPACK_WINDOW_SIZE))
+  {
+    if ((len - 1) >= (FLASH_UNPACK_WINDOW_SIZE - (addr - BOOT_FLASH_UNPACK_ADDR)))
+    {
+      return BLT_FALSE;
+    }
+    return FlashUnpackWrite(addr - BOOT_FLASH_UNPACK_ADDR, len, data);
+  }
+#endif
 
   /* validate the len parameter */
   if ((len - 1) > (FLASH_END_ADDRESS - addr))
@@ -300,6 +549,27 @@ blt_bool FlashWrite(blt_addr addr, blt_int32u len, blt_int8u *data)
     }
   }
 
+#if (BOOT_FLASH_IMAGE_CRC_ENABLE > 0)
+  /* keep track of where the user program ends */
+  if ((result == BLT_TRUE) && ((addr + len) > flashImageEnd))
+  {
+    flashImageEnd = addr + len;
+  }
+#endif
+
+#if (BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0)
+  /* keep track of the blocks that data was received for */
+  if (result == BLT_TRUE)
+  {
+    for (base_addr = (addr/FLASH_WRITE_BLOCK_SIZE)*FLASH_WRITE_BLOCK_SIZE;
+         base_addr < (addr + len); base_addr += FLASH_WRITE_BLOCK_SIZE)
+    {
+      block_idx = (base_addr - flashLayout[0].sector_start) / FLASH_WRITE_BLOCK_SIZE;
+      flashBlockReceived[block_idx/8] |= (blt_int8u)(1U << (block_idx%8));
+    }
+  }
+#endif
+
   /* give the result back to the caller */
   return result;
 } /*** end of FlashWrite ***/
@@ -319,6 +589,20 @@ blt_bool FlashErase(blt_addr addr, blt_int32u len)
   blt_bool  result = BLT_TRUE;
   blt_int8u first_sector_idx;
   blt_int8u last_sector_idx;
+#if (BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0)
+  blt_int8u sector_idx;
+#endif
+
+#if (BOOT_FLASH_UNPACK_ENABLE > 0)
+  /* the window is not backed by memory. the sectors of the user program are erased
+   * while the stream is decompressed, as only then their number is known.
+   */
+  if ((addr >= BOOT_FLASH_UNPACK_ADDR) &&
+      ((addr - BOOT_FLASH_UNPACK_ADDR) < FLASH_UNPACK_WINDOW_SIZE))
+  {
+    return BLT_TRUE;
+  }
+#endif
 
   /* validate the len parameter */
   if ((len - 1) > (FLASH_END_ADDRESS - addr))
@@ -343,8 +627,34 @@ blt_bool FlashErase(blt_addr addr, blt_int32u len)
   /* only continue if all is okay so far */
   if (result == BLT_TRUE)
   {
+#if (BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0)
+    /* the sector with the bootblock is erased right away. this way an interrupted
+     * programming session still invalidates the checksum of the user program.
+     */
+    if (first_sector_idx == 0)
+    {
+      result = FlashEraseSectors(0, 0);
+      first_sector_idx++;
+    }
+    /* defer erasing the other sectors, until a block of data differs from what the
+     * sector already holds.
+     */
+    for (sector_idx = first_sector_idx;
+         (sector_idx <= last_sector_idx) && (result == BLT_TRUE); sector_idx++)
+    {
+      if (FlashEmptyCheckSector(sector_idx) == BLT_FALSE)
+      {
+        flashErasePending[sector_idx] = BLT_TRUE;
+      }
+      else
+      {
+        FlashMarkErased(sector_idx);
+      }
+    }
+#else
     /* erase the sectors */
     result = FlashEraseSectors(first_sector_idx, last_sector_idx);
+#endif
   }
 
   /* give the result back to the caller */
@@ -365,6 +675,18 @@ blt_bool FlashWriteChecksum(void)
 {
   blt_bool   result = BLT_TRUE;
   blt_int32u signature_checksum = 0;
+#if (BOOT_FLASH_IMAGE_CRC_ENABLE > 0)
+  blt_int32u image_size;
+  blt_int32u image_crc;
+#endif
+
+#if (BOOT_FLASH_UNPACK_ENABLE > 0)
+  /* the end of a compressed stream is still to be passed to the block manager */
+  if (FlashUnpackFlush() == BLT_FALSE)
+  {
+    return BLT_FALSE;
+  }
+#endif
 
   /* for the STM32 target we defined the checksum as the Two's complement value of the
    * sum of the first 7 exception addresses.
@@ -423,6 +745,49 @@ blt_bool FlashWriteChecksum(void)
       result = FlashWrite(flashLayout[0].sector_start+BOOT_FLASH_VECTOR_TABLE_CS_OFFSET,
                           sizeof(blt_addr), (blt_int8u *)&signature_checksum);
     }
+
+#if (BOOT_FLASH_IMAGE_CRC_ENABLE > 0)
+    /* the CRC32 is computed over flash memory, except for the bootblock, which is only
+     * programmed by FlashDone(). so program the currently active block first.
+     */
+    if ((result == BLT_TRUE) && (blockInfo.base_addr != FLASH_INVALID_ADDRESS))
+    {
+      result = FlashWriteBlock(&blockInfo);
+      blockInfo.base_addr = FLASH_INVALID_ADDRESS;
+    }
+#if (BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0)
+    /* the sectors must be in their final state before the CRC32 is computed */
+    if (result == BLT_TRUE)
+    {
+      result = FlashFinishPendingErase();
+    }
+#endif
+
+    /* only continue if all is okay so far */
+    if (result == BLT_TRUE)
+    {
+      /* the size covers at least the bootblock's CRC32 and is a multiple of 4 bytes.
+       * the bytes up to the next multiple of 4 are still in the erased 0xFF state.
+       */
+      image_size = flashImageEnd - flashLayout[0].sector_start;
+      if (image_size < (FLASH_IMAGE_CRC_OFFSET + sizeof(blt_int32u)))
+      {
+        image_size = FLASH_IMAGE_CRC_OFFSET + sizeof(blt_int32u);
+      }
+      image_size = (image_size + 3U) & ~3U;
+      image_crc = FlashComputeImageCrc(bootBlockInfo.data, flashLayout[0].sector_start,
+                                       image_size);
+
+      /* write the size and the CRC32 */
+      result = FlashWrite(flashLayout[0].sector_start+FLASH_IMAGE_SIZE_OFFSET,
+                          sizeof(blt_int32u), (blt_int8u *)&image_size);
+      if (result == BLT_TRUE)
+      {
+        result = FlashWrite(flashLayout[0].sector_start+FLASH_IMAGE_CRC_OFFSET,
+                            sizeof(blt_int32u), (blt_int8u *)&image_crc);
+      }
+    }
+#endif
   }
   
   /* give the result back to the caller */
@@ -438,31 +803,79 @@ blt_bool FlashWriteChecksum(void)
 ****************************************************************************************/
 blt_bool FlashVerifyChecksum(void)
 {
-  blt_bool   result = BLT_TRUE;
-  blt_int32u signature_checksum = 0;
+  return FlashVerifyImage(flashLayout[0].sector_start,
+                          FLASH_END_ADDRESS - flashLayout[0].sector_start + 1);
+} /*** end of FlashVerifyChecksum ***/
 
-  /* verify the checksum based on how it was written by FlashWriteChecksum(). */
-  signature_checksum += *((blt_int32u *)(flashLayout[0].sector_start));
-  signature_checksum += *((blt_int32u *)(flashLayout[0].sector_start+0x04));
-  signature_checksum += *((blt_int32u *)(flashLayout[0].sector_start+0x08));
-  signature_checksum += *((blt_int32u *)(flashLayout[0].sector_start+0x0C));
-  signature_checksum += *((blt_int32u *)(flashLayout[0].sector_start+0x10));
-  signature_checksum += *((blt_int32u *)(flashLayout[0].sector_start+0x14));
-  signature_checksum += *((blt_int32u *)(flashLayout[0].sector_start+0x18));
-  /* add the checksum value that was written by FlashWriteChecksum(). Since this was a
-   * Two complement's value, the resulting value should equal 0.
-   */ 
-  signature_checksum += *((blt_int32u *)(flashLayout[0].sector_start+BOOT_FLASH_VECTOR_TABLE_CS_OFFSET));
-  /* sum should add up to an unsigned 32-bit value of 0 */
-  if (signature_checksum != 0)
+
+#if (BOOT_FLASH_BANK_SWAP_ENABLE > 0)
+/************************************************************************************//**
+** \brief     Swaps the flash banks, so that the user program that the running user
+**            program wrote to the other bank is started after the next reset. The
+**            image in the other bank is checked like the user program in bank 1. The
+**            bootloader and the persistent storage sectors are copied over first, so
+**            that both are in place after the swap.
+** \return    BLT_FALSE if the image in the other bank is not valid, or the swap failed.
+**            The function does not return otherwise, as the device is reset.
+**
+****************************************************************************************/
+blt_bool FlashSwapBanks(void)
+{
+  blt_bool                 result;
+  FLASH_OBProgramInitTypeDef obInit;
+
+  /* only swap to a complete user program */
+  result = FlashVerifyImage(FLASH_SWAP_IMAGE_START, FLASH_SWAP_IMAGE_MAX_SIZE);
+
+  /* the bootloader also runs from the start of the other bank after the swap */
+  if (result == BLT_TRUE)
   {
-    /* checksum not okay */
+    result = FlashCopySectors(FLASH_BASE + FLASH_SWAP_BANK_SIZE, FLASH_BASE,
+                              FLASH_SWAP_BOOT_SIZE);
+  }
+
+  /* the user program keeps its persistent storage in the last sectors of bank 2, which
+   * become the last sectors of bank 1 with the swap. copy them to the other bank.
+   */
+  if (result == BLT_TRUE)
+  {
+    result = FlashCopySectors(FLASH_BASE + FLASH_SWAP_BANK_SIZE - FLASH_SWAP_STORAGE_SIZE,
+                              FLASH_BASE + (2U * FLASH_SWAP_BANK_SIZE) -
+                              FLASH_SWAP_STORAGE_SIZE,
+                              FLASH_SWAP_STORAGE_SIZE);
+  }
+
+  /* toggle the bank swap option byte */
+  if (result == BLT_TRUE)
+  {
+    obInit.OptionType = OPTIONBYTE_USER;
+    obInit.USERType = OB_USER_SWAP_BANK;
+    if ((FLASH->OPTSR_CUR & FLASH_OPTSR_SWAP_BANK) != 0U)
+    {
+      obInit.USERConfig = OB_SWAP_BANK_DISABLE;
+    }
+    else
+    {
+      obInit.USERConfig = OB_SWAP_BANK_ENABLE;
+    }
+
+    HAL_FLASH_Unlock();
+    HAL_FLASH_OB_Unlock();
+    if (HAL_FLASHEx_OBProgram(&obInit) == HAL_OK)
+    {
+      /* load the option bytes. the swap takes effect with the reset */
+      (void)HAL_FLASH_OB_Launch();
+      NVIC_SystemReset();
+    }
+    HAL_FLASH_OB_Lock();
+    HAL_FLASH_Lock();
     result = BLT_FALSE;
   }
-  
+
   /* give the result back to the caller */
   return result;
-} /*** end of FlashVerifyChecksum ***/
+} /*** end of FlashSwapBanks ***/
+#endif /* BOOT_FLASH_BANK_SWAP_ENABLE > 0 */
 
 
 /************************************************************************************//**
@@ -499,6 +912,15 @@ blt_bool FlashDone(void)
     }
   }
 
+#if (BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0)
+  /* only continue if all is okay so far */
+  if (result == BLT_TRUE)
+  {
+    /* erase what the deferred erases would have erased, and was not programmed */
+    result = FlashFinishPendingErase();
+  }
+#endif
+
   /* give the result back to the caller */
   return result;
 } /*** end of FlashDone ***/
@@ -531,7 +953,8 @@ blt_addr FlashGetUserProgBaseAddress(void)
 ****************************************************************************************/
 static blt_bool FlashInitBlock(tFlashBlockInfo *block, blt_addr address)
 {
-  blt_bool result = BLT_TRUE;
+  blt_bool   result = BLT_TRUE;
+  blt_int32u block_idx;
 
   /* check address alignment */
   if ((address % FLASH_WRITE_BLOCK_SIZE) != 0)
@@ -546,9 +969,20 @@ static blt_bool FlashInitBlock(tFlashBlockInfo *block, blt_addr address)
     /* make sure that we are initializing a new block and not the same one */
     if (block->base_addr != address)
     {
-      /* set the base address and copies the current data from flash */
+      /* set the base address and copies the current data from flash, unless the flash
+       * is known to hold nothing but the erased value.
+       */
       block->base_addr = address;
-      CpuMemCopy((blt_addr)block->data, address, FLASH_WRITE_BLOCK_SIZE);
+      block_idx = (address - flashLayout[0].sector_start) / FLASH_WRITE_BLOCK_SIZE;
+      if ((address >= flashLayout[0].sector_start) && (block_idx < FLASH_TOTAL_BLOCKS) &&
+          ((flashBlockErased[block_idx/8] & (1U << (block_idx%8))) != 0))
+      {
+        CpuMemSet((blt_addr)block->data, 0xff, FLASH_WRITE_BLOCK_SIZE);
+      }
+      else
+      {
+        CpuMemCopy((blt_addr)block->data, address, FLASH_WRITE_BLOCK_SIZE);
+      }
     }
   }
 
@@ -720,13 +1154,13 @@ static blt_bool FlashAddToBlock(tFlashBlockInfo *block, blt_addr address,
 static blt_bool FlashWriteBlock(tFlashBlockInfo *block)
 {
   blt_bool        result = BLT_TRUE;
-  blt_addr        prog_addr;
-  blt_int32u      data_addr;
-  blt_int32u      qword_cnt;
-  const blt_int8u qword_byte_num = 16U;
   blt_addr        word_addr;
   blt_int32u      word_data;
   blt_int32u      word_cnt;
+#if (BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0)
+  blt_int8u       sector_idx;
+  blt_int32u      block_idx;
+#endif
 
   /* check that the address is actually within flash */
   if (FlashGetSectorIdx(block->base_addr) == FLASH_INVALID_SECTOR_IDX)
@@ -734,6 +1168,27 @@ static blt_bool FlashWriteBlock(tFlashBlockInfo *block)
     result = BLT_FALSE;
   }
 
+#if (BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0)
+  /* only continue if all is okay so far */
+  if (result == BLT_TRUE)
+  {
+    sector_idx = FlashGetSectorIdx(block->base_addr);
+    if (flashErasePending[sector_idx] == BLT_TRUE)
+    {
+      /* no need to erase and program the sector for a block that did not change */
+      if (FlashBlockUnchanged(block) == BLT_TRUE)
+      {
+        block_idx = (block->base_addr - flashLayout[0].sector_start) /
+                    FLASH_WRITE_BLOCK_SIZE;
+        flashBlockSkipped[block_idx/8] |= (blt_int8u)(1U << (block_idx%8));
+        return BLT_TRUE;
+      }
+      /* the block changed, so the sector has to be erased after all */
+      result = FlashErasePendingSector(sector_idx);
+    }
+  }
+#endif
+
 #if (BOOT_FLASH_CRYPTO_HOOKS_ENABLE > 0)
   #if (BOOT_NVM_CHECKSUM_HOOKS_ENABLE == 0)
   /* note that the bootblock is already decrypted in FlashWriteChecksum(), if the
@@ -754,28 +1209,7 @@ static blt_bool FlashWriteBlock(tFlashBlockInfo *block)
   /* only continue with programming if all is okay so far */
   if (result == BLT_TRUE)
   {
-    /* unlock the flash peripheral to enable the flash control register access */
-    HAL_FLASH_Unlock();
-
-    /* program all quad words (128 bits = 16 bytes) in the block one by one */
-    for (qword_cnt=0; qword_cnt<(FLASH_WRITE_BLOCK_SIZE/qword_byte_num); qword_cnt++)
-    {
-      /* calculate the destination address in flash of this quad word */
-      prog_addr = block->base_addr + (qword_cnt * qword_byte_num);
-      /* set the base address in ram that holds the data to program */
-      data_addr = (blt_int32u)(&block->data[qword_cnt * qword_byte_num]);
-      /* keep the watchdog happy */
-      CopService();
-      /* program the quad word data at 'data_addr' to memory address 'prog_addr' */
-      if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_QUADWORD, prog_addr, data_addr) != HAL_OK)
-      {
-        result = BLT_FALSE;
-        break;
-      }
-    }
-
-    /* lock the flash peripheral to disable the flash control register access */
-    HAL_FLASH_Lock();
+    result = FlashProgramBlock(block);
   }
 
   /* flush the instruction cache because flash memory was just changed (programmed). */
@@ -805,6 +1239,92 @@ static blt_bool FlashWriteBlock(tFlashBlockInfo *block)
 } /*** end of FlashWriteBlock ***/
 
 
+/************************************************************************************//**
+** \brief     Programs the block->data to flash, one quad word after the other. The PG
+**            bit stays set for the entire block, and each quad word only waits for the
+**            previous one to leave the write buffer, instead of going through the HAL's
+**            programming function with its timeout handling for every quad word.
+** \param     block   Pointer to flash block info structure to operate on.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashProgramBlock(tFlashBlockInfo *block)
+{
+  blt_bool                result = BLT_TRUE;
+  blt_int32u              qword_cnt;
+  volatile blt_int32u    *dst = (volatile blt_int32u *)block->base_addr;
+  const blt_int32u       *src = (const blt_int32u *)block->data;
+  blt_int32u              block_idx;
+  blt_int32u              primask_bit;
+
+  /* unlock the flash peripheral to enable the flash control register access */
+  HAL_FLASH_Unlock();
+
+  /* make sure that no earlier operation is still ongoing or left an error behind */
+  if (FLASH_WaitForLastOperation(FLASH_TIMEOUT_VALUE) != HAL_OK)
+  {
+    result = BLT_FALSE;
+  }
+
+  /* only continue if all is okay so far */
+  if (result == BLT_TRUE)
+  {
+    SET_BIT(FLASH->NSCR, FLASH_CR_PG);
+    for (qword_cnt=0; qword_cnt<(FLASH_WRITE_BLOCK_SIZE/FLASH_QWORD_SIZE); qword_cnt++)
+    {
+      /* keep the watchdog happy */
+      if ((qword_cnt % FLASH_QWORDS_PER_COP_SERVICE) == 0)
+      {
+        CopService();
+      }
+      /* the four words of a quad word must reach the write buffer back to back */
+      primask_bit = __get_PRIMASK();
+      __disable_irq();
+      dst[0] = src[0];
+      dst[1] = src[1];
+      dst[2] = src[2];
+      dst[3] = src[3];
+      __ISB();
+      __DSB();
+      __set_PRIMASK(primask_bit);
+      dst += 4;
+      src += 4;
+      /* wait for the quad word to be programmed */
+      while ((FLASH->NSSR & (FLASH_FLAG_BSY | FLASH_FLAG_WBNE | FLASH_FLAG_DBNE)) != 0U)
+      {
+        ;
+      }
+      if ((FLASH->NSSR & FLASH_FLAG_SR_ERRORS) != 0U)
+      {
+        break;
+      }
+    }
+    /* collect and clear the error flags, if any */
+    if (FLASH_WaitForLastOperation(FLASH_TIMEOUT_VALUE) != HAL_OK)
+    {
+      result = BLT_FALSE;
+    }
+    CLEAR_BIT(FLASH->NSCR, FLASH_CR_PG);
+  }
+
+  /* lock the flash peripheral to disable the flash control register access */
+  HAL_FLASH_Lock();
+
+  /* the block is no longer known to be erased, whether programming succeeded or not */
+  if (block->base_addr >= flashLayout[0].sector_start)
+  {
+    block_idx = (block->base_addr - flashLayout[0].sector_start) / FLASH_WRITE_BLOCK_SIZE;
+    if (block_idx < FLASH_TOTAL_BLOCKS)
+    {
+      flashBlockErased[block_idx/8] &= (blt_int8u)~(1U << (block_idx%8));
+    }
+  }
+
+  /* give the result back to the caller */
+  return result;
+} /*** end of FlashProgramBlock ***/
+
+
 /************************************************************************************//**
 ** \brief     Checks if the flash sector is already completely erased.
 ** \param     sector_idx flash sector number index into flashLayout[].
@@ -855,6 +1375,28 @@ static blt_bool FlashEmptyCheckSector(blt_int8u sector_idx)
 } /*** end of FlashEmptyCheckSector ***/
 
 
+/************************************************************************************//**
+** \brief     Flags the blocks of a sector as erased.
+** \param     sector_idx flash sector number index into flashLayout[].
+** \return    none.
+**
+****************************************************************************************/
+static void FlashMarkErased(blt_int8u sector_idx)
+{
+  blt_int32u block_idx;
+  blt_int32u last_block_idx;
+
+  block_idx = (flashLayout[sector_idx].sector_start - flashLayout[0].sector_start) /
+              FLASH_WRITE_BLOCK_SIZE;
+  last_block_idx = block_idx +
+                   (flashLayout[sector_idx].sector_size / FLASH_WRITE_BLOCK_SIZE);
+  for (; (block_idx < last_block_idx) && (block_idx < FLASH_TOTAL_BLOCKS); block_idx++)
+  {
+    flashBlockErased[block_idx/8] |= (blt_int8u)(1U << (block_idx%8));
+  }
+} /*** end of FlashMarkErased ***/
+
+
 /************************************************************************************//**
 ** \brief     Erases the flash sectors from indices first_sector_idx up until
 **            last_sector_idx into the flashLayout[] array.
@@ -940,6 +1482,8 @@ static blt_bool FlashEraseSectors(blt_int8u first_sector_idx, blt_int8u last_sec
           break;
         }
       }
+      /* the blocks of the sector no longer need to be read before programming them */
+      FlashMarkErased(sectorIdx);
     }
 
     /* lock the flash peripheral to disable the flash control register access. */
@@ -988,7 +1532,7 @@ static blt_int8u FlashGetSectorIdx(blt_addr address)
 
 
 /************************************************************************************//**
-** \brief     Determines the flash bank that the address belongs to.
+** \brief     Determines the physical flash bank that the address belongs to.
 ** \param     address Flash memory address.
 ** \return    FLASH_BANK_1 if the address belongs to bank 1, FLASH_BANK_2 otherwise.
 **
@@ -1008,6 +1552,14 @@ static blt_int32u FlashGetBank(blt_addr address)
     result = FLASH_BANK_2;
   }
 
+  /* erase operations select the physical bank. with the banks swapped, the addresses of
+   * bank 1 are served by bank 2 and vice versa.
+   */
+  if ((FLASH->OPTSR_CUR & FLASH_OPTSR_SWAP_BANK) != 0U)
+  {
+    result = (result == FLASH_BANK_1) ? FLASH_BANK_2 : FLASH_BANK_1;
+  }
+
   /* give the result back to the caller */
   return result;
 } /** end of FlashGetBank ***/
@@ -1045,4 +1597,503 @@ static blt_int32u FlashGetPage(blt_addr address)
 } /*** end of FlashGetPage ***/
 
 
+/************************************************************************************//**
+** \brief     Verifies the checksum of a user program and, if enabled, its CRC32.
+** \param     image_start Start address of the user program's vector table.
+** \param     max_size Largest plausible size of the user program in bytes.
+** \return    BLT_TRUE if the user program is valid, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashVerifyImage(blt_addr image_start, blt_int32u max_size)
+{
+  blt_bool   result = BLT_TRUE;
+  blt_int32u signature_checksum = 0;
+#if (BOOT_FLASH_IMAGE_CRC_ENABLE > 0)
+  blt_int32u image_size;
+#else
+  (void)max_size;
+#endif
+
+  /* verify the checksum based on how it was written by FlashWriteChecksum(). */
+  signature_checksum += *((blt_int32u *)(image_start));
+  signature_checksum += *((blt_int32u *)(image_start+0x04));
+  signature_checksum += *((blt_int32u *)(image_start+0x08));
+  signature_checksum += *((blt_int32u *)(image_start+0x0C));
+  signature_checksum += *((blt_int32u *)(image_start+0x10));
+  signature_checksum += *((blt_int32u *)(image_start+0x14));
+  signature_checksum += *((blt_int32u *)(image_start+0x18));
+  /* add the checksum value that was written by FlashWriteChecksum(). Since this was a
+   * Two complement's value, the resulting value should equal 0.
+   */ 
+  signature_checksum += *((blt_int32u *)(image_start+BOOT_FLASH_VECTOR_TABLE_CS_OFFSET));
+  /* sum should add up to an unsigned 32-bit value of 0 */
+  if (signature_checksum != 0)
+  {
+    /* checksum not okay */
+    result = BLT_FALSE;
+  }
+
+#if (BOOT_FLASH_IMAGE_CRC_ENABLE > 0)
+  /* only continue if all is okay so far */
+  if (result == BLT_TRUE)
+  {
+    /* verify the CRC32 of the entire user program, as written by FlashWriteChecksum() */
+    image_size = *((blt_int32u *)(image_start+FLASH_IMAGE_SIZE_OFFSET));
+    if ((image_size < (FLASH_IMAGE_CRC_OFFSET + sizeof(blt_int32u))) ||
+        (image_size > max_size) ||
+        ((image_size % sizeof(blt_int32u)) != 0))
+    {
+      /* size not plausible, e.g. still erased */
+      result = BLT_FALSE;
+    }
+    else if (FlashComputeImageCrc((const blt_int8u *)image_start, image_start,
+                                  image_size) !=
+             *((blt_int32u *)(image_start+FLASH_IMAGE_CRC_OFFSET)))
+    {
+      /* user program changed since it was programmed */
+      result = BLT_FALSE;
+    }
+  }
+#endif
+  
+  /* give the result back to the caller */
+  return result;
+} /*** end of FlashVerifyImage ***/
+
+
+#if (BOOT_FLASH_IMAGE_CRC_ENABLE > 0)
+/************************************************************************************//**
+** \brief     Computes the CRC32 of the user program with the CRC calculation unit. The
+**            words that hold the size and the CRC32 themselves are skipped.
+** \param     boot_block Contents of the bootblock. This is either the bootblock's RAM
+**            buffer, while it is not yet programmed, or its location in flash memory.
+** \param     image_start Start address of the user program in flash memory.
+** \param     size Size of the user program in bytes. Must be a multiple of 4.
+** \return    The CRC32 (polynomial 0x04C11DB7, initial value 0xFFFFFFFF).
+**
+****************************************************************************************/
+static blt_int32u FlashComputeImageCrc(const blt_int8u *boot_block, blt_addr image_start,
+                                       blt_int32u size)
+{
+  const blt_int32u *boot_words = (const blt_int32u *)boot_block;
+  const blt_int32u *flash_words = (const blt_int32u *)image_start;
+  blt_int32u word_num = size / sizeof(blt_int32u);
+  blt_int32u word_cnt;
+
+  /* start a new calculation with the default polynomial and initial value */
+  CRC->CR = CRC_CR_RESET;
+
+  /* the bootblock comes from the caller's buffer */
+  for (word_cnt=0; (word_cnt<(FLASH_WRITE_BLOCK_SIZE/sizeof(blt_int32u))) &&
+                   (word_cnt<word_num); word_cnt++)
+  {
+    if ((word_cnt != (FLASH_IMAGE_SIZE_OFFSET/sizeof(blt_int32u))) &&
+        (word_cnt != (FLASH_IMAGE_CRC_OFFSET/sizeof(blt_int32u))))
+    {
+      CRC->DR = boot_words[word_cnt];
+    }
+  }
+
+  /* the rest of the user program is read straight from flash, one word per write to the
+   * data register, so the CRC32 takes little more time than reading the flash memory.
+   */
+  for ( ; word_cnt<word_num; word_cnt++)
+  {
+    CRC->DR = flash_words[word_cnt];
+    /* keep the watchdog happy, every 64 kbytes */
+    if ((word_cnt & 0x3FFFU) == 0)
+    {
+      CopService();
+    }
+  }
+
+  return CRC->DR;
+} /*** end of FlashComputeImageCrc ***/
+#endif /* BOOT_FLASH_IMAGE_CRC_ENABLE > 0 */
+
+
+#if (BOOT_FLASH_BANK_SWAP_ENABLE > 0)
+/************************************************************************************//**
+** \brief     Copies whole flash sectors, outside of flashLayout[]. Sectors that already
+**            hold the data are left as they are.
+** \param     dst Start address of the first destination sector.
+** \param     src Start address of the data to copy.
+** \param     len Number of bytes, a multiple of FLASH_SECTOR_SIZE.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashCopySectors(blt_addr dst, blt_addr src, blt_int32u len)
+{
+  blt_bool               result = BLT_TRUE;
+  FLASH_EraseInitTypeDef eraseInitStruct;
+  uint32_t               pageEraseError = 0;
+  blt_int32u             offset;
+  blt_int32u             sector_end;
+  blt_int32u             word_cnt;
+  blt_bool               unchanged;
+
+  for (offset = 0; (offset < len) && (result == BLT_TRUE); offset = sector_end)
+  {
+    sector_end = offset + FLASH_SECTOR_SIZE;
+    /* keep the watchdog happy */
+    CopService();
+
+    /* no need to erase and program a sector that already holds the data */
+    unchanged = BLT_TRUE;
+    for (word_cnt = offset; word_cnt < sector_end; word_cnt += sizeof(blt_int32u))
+    {
+      if (*(volatile blt_int32u *)(dst + word_cnt) !=
+          *(volatile blt_int32u *)(src + word_cnt))
+      {
+        unchanged = BLT_FALSE;
+        break;
+      }
+    }
+    if (unchanged == BLT_TRUE)
+    {
+      continue;
+    }
+
+    HAL_FLASH_Unlock();
+    eraseInitStruct.TypeErase = FLASH_TYPEERASE_SECTORS;
+    eraseInitStruct.Banks = FlashGetBank(dst + offset);
+    eraseInitStruct.Sector = FlashGetPage(dst + offset);
+    eraseInitStruct.NbSectors = 1;
+    if (HAL_FLASHEx_Erase(&eraseInitStruct, &pageEraseError) != HAL_OK)
+    {
+      result = BLT_FALSE;
+    }
+    /* program the sector one quad word (128 bits = 16 bytes) at a time */
+    for (word_cnt = offset; (word_cnt < sector_end) && (result == BLT_TRUE);
+         word_cnt += 16U)
+    {
+      if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_QUADWORD, dst + word_cnt,
+                            src + word_cnt) != HAL_OK)
+      {
+        result = BLT_FALSE;
+      }
+    }
+    HAL_FLASH_Lock();
+
+    /* flush the instruction cache because flash memory was just changed. */
+    LL_ICACHE_Invalidate();
+
+    /* verify that the data is actually there */
+    for (word_cnt = offset; (word_cnt < sector_end) && (result == BLT_TRUE);
+         word_cnt += sizeof(blt_int32u))
+    {
+      if (*(volatile blt_int32u *)(dst + word_cnt) !=
+          *(volatile blt_int32u *)(src + word_cnt))
+      {
+        result = BLT_FALSE;
+      }
+    }
+  }
+
+  /* give the result back to the caller */
+  return result;
+} /*** end of FlashCopySectors ***/
+#endif /* BOOT_FLASH_BANK_SWAP_ENABLE > 0 */
+
+
+#if (BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0)
+/************************************************************************************//**
+** \brief     Checks if flash memory already holds the data of a block.
+** \param     block   Pointer to flash block info structure to operate on.
+** \return    BLT_TRUE if the block is unchanged, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashBlockUnchanged(tFlashBlockInfo *block)
+{
+  blt_int32u const volatile *flash_words = (blt_int32u const volatile *)block->base_addr;
+  blt_int32u const *block_words = (blt_int32u const *)block->data;
+  blt_int32u word_cnt;
+
+  for (word_cnt=0; word_cnt<(FLASH_WRITE_BLOCK_SIZE/sizeof(blt_int32u)); word_cnt++)
+  {
+    if (flash_words[word_cnt] != block_words[word_cnt])
+    {
+      return BLT_FALSE;
+    }
+  }
+  return BLT_TRUE;
+} /*** end of FlashBlockUnchanged ***/
+
+
+/************************************************************************************//**
+** \brief     Performs the deferred erase of a sector. The blocks of the sector that were
+**            skipped, because they were unchanged, are programmed again afterwards.
+** \param     sector_idx flash sector number index into flashLayout[].
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashErasePendingSector(blt_int8u sector_idx)
+{
+  blt_bool   result;
+  blt_addr   sector_addr = flashLayout[sector_idx].sector_start;
+  blt_int32u sector_size = flashLayout[sector_idx].sector_size;
+  blt_int32u first_block_idx = (sector_addr - flashLayout[0].sector_start) /
+                               FLASH_WRITE_BLOCK_SIZE;
+  blt_int32u block_idx;
+  blt_int32u offset;
+
+  ASSERT_RT(sector_size <= FLASH_MAX_SECTOR_SIZE);
+
+  /* keep a copy of the skipped blocks, which are erased together with the sector */
+  for (offset = 0; offset < sector_size; offset += FLASH_WRITE_BLOCK_SIZE)
+  {
+    block_idx = first_block_idx + (offset / FLASH_WRITE_BLOCK_SIZE);
+    if ((flashBlockSkipped[block_idx/8] & (1U << (block_idx%8))) != 0)
+    {
+      CpuMemCopy((blt_addr)&flashSectorCopy[offset], sector_addr + offset,
+                 FLASH_WRITE_BLOCK_SIZE);
+    }
+  }
+
+  /* perform the erase. the sector is no longer pending, so its blocks are now
+   * programmed as usual.
+   */
+  flashErasePending[sector_idx] = BLT_FALSE;
+  result = FlashEraseSectors(sector_idx, sector_idx);
+
+  /* program the skipped blocks again */
+  for (offset = 0; (offset < sector_size) && (result == BLT_TRUE);
+       offset += FLASH_WRITE_BLOCK_SIZE)
+  {
+    block_idx = first_block_idx + (offset / FLASH_WRITE_BLOCK_SIZE);
+    if ((flashBlockSkipped[block_idx/8] & (1U << (block_idx%8))) != 0)
+    {
+      flashBlockSkipped[block_idx/8] &= (blt_int8u)~(1U << (block_idx%8));
+      restoreBlockInfo.base_addr = sector_addr + offset;
+      CpuMemCopy((blt_addr)restoreBlockInfo.data, (blt_addr)&flashSectorCopy[offset],
+                 FLASH_WRITE_BLOCK_SIZE);
+      result = FlashWriteBlock(&restoreBlockInfo);
+    }
+  }
+
+  return result;
+} /*** end of FlashErasePendingSector ***/
+
+
+/************************************************************************************//**
+** \brief     Completes the deferred erases at the end of the programming session. A
+**            sector that still holds data in blocks that were not programmed during
+**            this session is erased after all, so it ends up the same as if it was
+**            erased right away. Otherwise erasing the sector is skipped altogether.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashFinishPendingErase(void)
+{
+  blt_bool   result = BLT_TRUE;
+  blt_int8u  sector_idx;
+  blt_addr   block_addr;
+  blt_addr   sector_end;
+  blt_int32u block_idx;
+  blt_int32u word_cnt;
+
+  for (sector_idx = 0; (sector_idx < FLASH_TOTAL_SECTORS) && (result == BLT_TRUE);
+       sector_idx++)
+  {
+    if (flashErasePending[sector_idx] == BLT_FALSE)
+    {
+      continue;
+    }
+    sector_end = flashLayout[sector_idx].sector_start + flashLayout[sector_idx].sector_size;
+    for (block_addr = flashLayout[sector_idx].sector_start;
+         (block_addr < sector_end) && (flashErasePending[sector_idx] == BLT_TRUE);
+         block_addr += FLASH_WRITE_BLOCK_SIZE)
+    {
+      block_idx = (block_addr - flashLayout[0].sector_start) / FLASH_WRITE_BLOCK_SIZE;
+      if ((flashBlockReceived[block_idx/8] & (1U << (block_idx%8))) != 0)
+      {
+        continue;
+      }
+      /* keep the watchdog happy */
+      CopService();
+      for (word_cnt=0; word_cnt<(FLASH_WRITE_BLOCK_SIZE/sizeof(blt_int32u)); word_cnt++)
+      {
+        if (((blt_int32u const volatile *)block_addr)[word_cnt] != 0xFFFFFFFFu)
+        {
+          /* stale data that the erase would have removed */
+          result = FlashErasePendingSector(sector_idx);
+          break;
+        }
+      }
+    }
+    flashErasePending[sector_idx] = BLT_FALSE;
+  }
+
+  /* start the next programming session with a clean slate */
+  CpuMemSet((blt_addr)flashBlockReceived, 0, sizeof(flashBlockReceived));
+  CpuMemSet((blt_addr)flashBlockSkipped, 0, sizeof(flashBlockSkipped));
+
+  return result;
+} /*** end of FlashFinishPendingErase ***/
+#endif /* BOOT_FLASH_SKIP_UNCHANGED_ENABLE > 0 */
+
+
+#if (BOOT_FLASH_UNPACK_ENABLE > 0)
+/************************************************************************************//**
+** \brief     Decompresses the next part of the compressed stream into the user program.
+**            The stream must be programmed in order. A stream that starts over at offset
+**            0 starts a new user program.
+** \param     offset Offset of the data into the compressed stream.
+** \param     len    Length in bytes.
+** \param     data   Pointer to the data buffer.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashUnpackWrite(blt_int32u offset, blt_int32u len, blt_int8u *data)
+{
+  blt_bool   result = BLT_TRUE;
+  blt_int32u byte_idx;
+  blt_int8u  bit_mask;
+  blt_int32u count;
+
+  if (offset == 0)
+  {
+    /* start of a new stream */
+    flashUnpack.field = FLASH_UNPACK_TAG;
+    flashUnpack.field_bits = 1;
+    flashUnpack.field_value = 0;
+    flashUnpack.out_size = 0;
+    flashUnpack.erased_end = flashLayout[0].sector_start;
+    flashUnpack.chunk_len = 0;
+    CpuMemSet((blt_addr)flashUnpack.history, 0, sizeof(flashUnpack.history));
+  }
+  else if (offset != flashUnpack.stream_offset)
+  {
+    /* a gap or a repeat in the stream cannot be decompressed */
+    return BLT_FALSE;
+  }
+  flashUnpack.stream_offset = offset + len;
+
+  for (byte_idx = 0; (byte_idx < len) && (result == BLT_TRUE); byte_idx++)
+  {
+    for (bit_mask = 0x80; (bit_mask != 0) && (result == BLT_TRUE); bit_mask >>= 1)
+    {
+      /* shift in the next bit of the field */
+      flashUnpack.field_value <<= 1;
+      if ((data[byte_idx] & bit_mask) != 0)
+      {
+        flashUnpack.field_value |= 1;
+      }
+      if (--flashUnpack.field_bits > 0)
+      {
+        continue;
+      }
+      /* the field is complete */
+      switch (flashUnpack.field)
+      {
+        case FLASH_UNPACK_TAG:
+          if (flashUnpack.field_value != 0)
+          {
+            flashUnpack.field = FLASH_UNPACK_LITERAL;
+            flashUnpack.field_bits = 8;
+          }
+          else
+          {
+            flashUnpack.field = FLASH_UNPACK_INDEX;
+            flashUnpack.field_bits = BOOT_FLASH_UNPACK_WINDOW_BITS;
+          }
+          break;
+        case FLASH_UNPACK_LITERAL:
+          result = FlashUnpackPut((blt_int8u)flashUnpack.field_value);
+          flashUnpack.field = FLASH_UNPACK_TAG;
+          flashUnpack.field_bits = 1;
+          break;
+        case FLASH_UNPACK_INDEX:
+          flashUnpack.index = flashUnpack.field_value;
+          flashUnpack.field = FLASH_UNPACK_COUNT;
+          flashUnpack.field_bits = BOOT_FLASH_UNPACK_LOOKAHEAD_BITS;
+          break;
+        default:
+          /* copy the back-reference, which may overlap the bytes that it produces */
+          for (count = (blt_int32u)flashUnpack.field_value + 1;
+               (count > 0) && (result == BLT_TRUE); count--)
+          {
+            result = FlashUnpackPut(flashUnpack.history[
+              (flashUnpack.out_size - flashUnpack.index - 1) %
+              FLASH_UNPACK_HISTORY_SIZE]);
+          }
+          flashUnpack.field = FLASH_UNPACK_TAG;
+          flashUnpack.field_bits = 1;
+          break;
+      }
+      flashUnpack.field_value = 0;
+    }
+  }
+
+  /* give the result back to the caller */
+  return result;
+} /*** end of FlashUnpackWrite ***/
+
+
+/************************************************************************************//**
+** \brief     Appends a decompressed byte to the user program.
+** \param     value The byte.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashUnpackPut(blt_int8u value)
+{
+  flashUnpack.history[flashUnpack.out_size % FLASH_UNPACK_HISTORY_SIZE] = value;
+  flashUnpack.out_size++;
+  flashUnpack.chunk[flashUnpack.chunk_len++] = value;
+  if (flashUnpack.chunk_len < FLASH_UNPACK_CHUNK_SIZE)
+  {
+    return BLT_TRUE;
+  }
+  return FlashUnpackFlush();
+} /*** end of FlashUnpackPut ***/
+
+
+/************************************************************************************//**
+** \brief     Passes the decompressed bytes collected so far to the flash block manager,
+**            after erasing the sectors of the user program that they reach into.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashUnpackFlush(void)
+{
+  blt_bool  result = BLT_TRUE;
+  blt_addr  chunk_addr;
+  blt_int8u sector_idx;
+
+  if (flashUnpack.chunk_len == 0)
+  {
+    return BLT_TRUE;
+  }
+  chunk_addr = flashLayout[0].sector_start + flashUnpack.out_size - flashUnpack.chunk_len;
+
+  /* erase the sectors that this chunk is the first to reach into */
+  while ((result == BLT_TRUE) &&
+         (flashUnpack.erased_end < (chunk_addr + flashUnpack.chunk_len)))
+  {
+    sector_idx = FlashGetSectorIdx(flashUnpack.erased_end);
+    if (sector_idx == FLASH_INVALID_SECTOR_IDX)
+    {
+      /* the user program does not fit */
+      result = BLT_FALSE;
+      break;
+    }
+    result = FlashErase(flashLayout[sector_idx].sector_start,
+                        flashLayout[sector_idx].sector_size);
+    flashUnpack.erased_end = flashLayout[sector_idx].sector_start +
+                             flashLayout[sector_idx].sector_size;
+  }
+
+  if (result == BLT_TRUE)
+  {
+    result = FlashWrite(chunk_addr, flashUnpack.chunk_len, flashUnpack.chunk);
+  }
+  flashUnpack.chunk_len = 0;
+
+  /* give the result back to the caller */
+  return result;
+} /*** end of FlashUnpackFlush ***/
+#endif /* BOOT_FLASH_UNPACK_ENABLE > 0 */
+
+
 /*********************************** end of flash.c ************************************/
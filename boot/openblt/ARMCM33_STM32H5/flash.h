@@ -38,6 +38,9 @@ blt_bool FlashWriteChecksum(void);
 blt_bool FlashVerifyChecksum(void);
 blt_bool FlashDone(void);
 blt_addr FlashGetUserProgBaseAddress(void);
+#if (BOOT_FLASH_BANK_SWAP_ENABLE > 0)
+blt_bool FlashSwapBanks(void);
+#endif
 
 
 #endif /* FLASH_H */
@@ -44,6 +44,8 @@
 #define RS232_CTO_RX_PACKET_TIMEOUT_MS (200u)
 /** \brief Timeout for transmitting a byte in milliseconds. */
 #define RS232_BYTE_TX_TIMEOUT_MS       (10u)
+/** \brief XCP command code of the CONNECT packet, the first the host sends. */
+#define RS232_XCP_CMD_CONNECT          (0xFFu)
 /* map the configured UART channel index to the STM32's USART peripheral. */
 #if (BOOT_COM_RS232_CHANNEL_INDEX == 0)
 /** \brief Set UART base address to USART1. */
@@ -87,8 +89,37 @@
 /****************************************************************************************
 * Function prototypes
 ****************************************************************************************/
+static void     Rs232Configure(blt_int32u baudrate);
 static blt_bool Rs232ReceiveByte(blt_int8u *data);
+static blt_bool Rs232LineError(void);
 static void     Rs232TransmitByte(blt_int8u data);
+#if (BOOT_COM_RS232_AUTOBAUD_ENABLE > 0)
+static void     Rs232AutobaudNext(void);
+#endif
+
+
+#if (BOOT_COM_RS232_AUTOBAUD_ENABLE > 0)
+/****************************************************************************************
+* Local constant declarations
+****************************************************************************************/
+/** \brief Communication speeds for the autobaud detection, fastest first. Speeds closer
+ *         than about 10% apart are left out, as bytes sent at one can be received
+ *         at the other without errors.
+ */
+static const blt_int32u rs232AutobaudRates[] =
+{
+  3000000, 2000000, 921600, 460800, 230400, 115200, 57600
+};
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Speed currently listened at. */
+static blt_int32u rs232Baudrate;
+/** \brief BLT_TRUE once a CONNECT was received at rs232Baudrate. */
+static blt_bool   rs232AutobaudLocked;
+#endif
 
 
 /************************************************************************************//**
@@ -98,8 +129,6 @@ static void     Rs232TransmitByte(blt_int8u data);
 ****************************************************************************************/
 void Rs232Init(void)
 {
-  LL_USART_InitTypeDef USART_InitStruct = {0};
-
   /* The current implementation supports USART1 - UART12. throw an assertion error in
    * case a different UART channel is configured.
    */
@@ -116,10 +145,30 @@ void Rs232Init(void)
             (BOOT_COM_RS232_CHANNEL_INDEX == 10) ||
             (BOOT_COM_RS232_CHANNEL_INDEX == 11));
 
+  #if (BOOT_COM_RS232_AUTOBAUD_ENABLE > 0)
+  /* listen at the configured speed until the host connects. */
+  rs232Baudrate = BOOT_COM_RS232_BAUDRATE;
+  rs232AutobaudLocked = BLT_FALSE;
+  #endif
+  Rs232Configure(BOOT_COM_RS232_BAUDRATE);
+} /*** end of Rs232Init ***/
+
+
+/************************************************************************************//**
+** \brief     Configures the UART for a communication speed.
+** \param     baudrate Communication speed in bits/second.
+** \return    none.
+**
+****************************************************************************************/
+static void Rs232Configure(blt_int32u baudrate)
+{
+  LL_USART_InitTypeDef USART_InitStruct = {0};
+
   /* disable the peripheral */
   LL_USART_Disable(USART_CHANNEL);
-  USART_InitStruct.PrescalerValue = LL_USART_PRESCALER_DIV8;
-  USART_InitStruct.BaudRate = BOOT_COM_RS232_BAUDRATE;
+  /* undivided kernel clock, for an accurate divider at the high speeds. */
+  USART_InitStruct.PrescalerValue = LL_USART_PRESCALER_DIV1;
+  USART_InitStruct.BaudRate = baudrate;
   USART_InitStruct.DataWidth = LL_USART_DATAWIDTH_8B;
   USART_InitStruct.StopBits = LL_USART_STOPBITS_1;
   USART_InitStruct.Parity = LL_USART_PARITY_NONE;
@@ -129,10 +178,13 @@ void Rs232Init(void)
   LL_USART_Init(USART_CHANNEL, &USART_InitStruct);
   LL_USART_SetTXFIFOThreshold(USART_CHANNEL, LL_USART_FIFOTHRESHOLD_1_8);
   LL_USART_SetRXFIFOThreshold(USART_CHANNEL, LL_USART_FIFOTHRESHOLD_1_8);
-  LL_USART_DisableFIFO(USART_CHANNEL);
+  /* the receive FIFO holds 8 bytes, so that at high speeds bytes are not lost while
+   * the main loop services the other interfaces between two polls.
+   */
+  LL_USART_EnableFIFO(USART_CHANNEL);
   LL_USART_ConfigAsyncMode(USART_CHANNEL);
   LL_USART_Enable(USART_CHANNEL);
-} /*** end of Rs232Init ***/
+} /*** end of Rs232Configure ***/
 
 
 /************************************************************************************//**
@@ -195,6 +247,21 @@ blt_bool Rs232ReceivePacket(blt_int8u *data, blt_int8u *len)
   blt_int8u  csLen = 0;
   #endif
 
+  #if (BOOT_COM_RS232_AUTOBAUD_ENABLE > 0)
+  /* garbled bytes before the host connected most likely mean that it talks at another
+   * speed. try the next one and start over with the packet.
+   */
+  if ( (Rs232LineError() == BLT_TRUE) && (rs232AutobaudLocked == BLT_FALSE) )
+  {
+    Rs232AutobaudNext();
+    xcpCtoRxInProgress = BLT_FALSE;
+    return BLT_FALSE;
+  }
+  #else
+  /* garbled bytes end up in a packet that the host gets no response to and retries. */
+  (void)Rs232LineError();
+  #endif
+
   /* start of cto packet received? */
   if (xcpCtoRxInProgress == BLT_FALSE)
   {
@@ -211,6 +278,13 @@ blt_bool Rs232ReceivePacket(blt_int8u *data, blt_int8u *len)
         /* indicate that a cto packet is being received */
         xcpCtoRxInProgress = BLT_TRUE;
       }
+      #if (BOOT_COM_RS232_AUTOBAUD_ENABLE > 0)
+      else if (rs232AutobaudLocked == BLT_FALSE)
+      {
+        /* no valid packet length, so most likely the wrong speed. */
+        Rs232AutobaudNext();
+      }
+      #endif
     }
   }
   else
@@ -245,6 +319,18 @@ blt_bool Rs232ReceivePacket(blt_int8u *data, blt_int8u *len)
         CpuMemCopy((blt_int32u)data, (blt_int32u)&xcpCtoReqPacket[1], xcpCtoRxLength);
         /* done with cto packet reception */
         xcpCtoRxInProgress = BLT_FALSE;
+        #if (BOOT_COM_RS232_AUTOBAUD_ENABLE > 0)
+        if (rs232AutobaudLocked == BLT_FALSE)
+        {
+          /* only a CONNECT tells that the speed is right. keep it from then on. */
+          if ( (xcpCtoRxLength == 0) || (data[0] != RS232_XCP_CMD_CONNECT) )
+          {
+            Rs232AutobaudNext();
+            return BLT_FALSE;
+          }
+          rs232AutobaudLocked = BLT_TRUE;
+        }
+        #endif
         /* set the packet length */
         *len = xcpCtoRxLength;
         /* packet reception complete */
@@ -260,6 +346,13 @@ blt_bool Rs232ReceivePacket(blt_int8u *data, blt_int8u *len)
          * discards the already received packet bytes, allowing the host to retry.
          */
         xcpCtoRxInProgress = BLT_FALSE;
+        #if (BOOT_COM_RS232_AUTOBAUD_ENABLE > 0)
+        if (rs232AutobaudLocked == BLT_FALSE)
+        {
+          /* fewer bytes than announced, so most likely the wrong speed. */
+          Rs232AutobaudNext();
+        }
+        #endif
       }
     }
   }
@@ -292,6 +385,63 @@ static blt_bool Rs232ReceiveByte(blt_int8u *data)
 } /*** end of Rs232ReceiveByte ***/
 
 
+/************************************************************************************//**
+** \brief     Checks for and clears receive errors.
+** \details   A framing or noise error means that a byte was garbled. An overrun means
+**            that bytes were lost. Either way the current packet is lost.
+** \return    BLT_TRUE if a receive error occurred since the last call, BLT_FALSE
+**            otherwise.
+**
+****************************************************************************************/
+static blt_bool Rs232LineError(void)
+{
+  blt_bool result = BLT_FALSE;
+
+  if ( (LL_USART_IsActiveFlag_FE(USART_CHANNEL) != 0) ||
+       (LL_USART_IsActiveFlag_NE(USART_CHANNEL) != 0) ||
+       (LL_USART_IsActiveFlag_ORE(USART_CHANNEL) != 0) )
+  {
+    LL_USART_ClearFlag_FE(USART_CHANNEL);
+    LL_USART_ClearFlag_NE(USART_CHANNEL);
+    LL_USART_ClearFlag_ORE(USART_CHANNEL);
+    result = BLT_TRUE;
+  }
+  return result;
+} /*** end of Rs232LineError ***/
+
+
+#if (BOOT_COM_RS232_AUTOBAUD_ENABLE > 0)
+/************************************************************************************//**
+** \brief     Moves the autobaud detection on to the next slower speed.
+** \details   Detection starts at BOOT_COM_RS232_BAUDRATE and goes down the speeds of
+**            rs232AutobaudRates below it, then starts over. Going down, the host is
+**            never faster than the UART, so bytes at the wrong speed always show up
+**            garbled rather than going unnoticed. The host retries its CONNECT.
+** \return    none.
+**
+****************************************************************************************/
+static void Rs232AutobaudNext(void)
+{
+  blt_int32u next = BOOT_COM_RS232_BAUDRATE;
+  blt_int8u  idx;
+
+  for (idx = 0; idx < (sizeof(rs232AutobaudRates)/sizeof(rs232AutobaudRates[0])); idx++)
+  {
+    if (rs232AutobaudRates[idx] < rs232Baudrate)
+    {
+      next = rs232AutobaudRates[idx];
+      break;
+    }
+  }
+  rs232Baudrate = next;
+  Rs232Configure(rs232Baudrate);
+  /* drop what was received at the previous speed. */
+  LL_USART_RequestRxDataFlush(USART_CHANNEL);
+  (void)Rs232LineError();
+} /*** end of Rs232AutobaudNext ***/
+#endif
+
+
 /************************************************************************************//**
 ** \brief     Transmits a communication interface byte.
 ** \param     data Value of byte that is to be transmitted.
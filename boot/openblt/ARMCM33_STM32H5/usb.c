@@ -162,13 +162,18 @@ blt_bool UsbReceivePacket(blt_int8u *data, blt_int8u *len)
       }
     }
   }
-  else
+
+  /* cto packet reception in progress? */
+  if (xcpCtoRxInProgress == BLT_TRUE)
   {
-    /* store the next packet byte */
-    if (UsbReceiveByte(&xcpCtoReqPacket[xcpCtoRxLength+1]) == BLT_TRUE)
+    /* store as many of the remaining packet bytes as were received. reading them one
+     * at a time would take a pass through the bootloader's task per byte.
+     */
+    if (tud_vendor_available())
     {
       /* increment the packet data count */
-      xcpCtoRxLength++;
+      xcpCtoRxLength += (blt_int8u)tud_vendor_read(&xcpCtoReqPacket[xcpCtoRxLength+1],
+                                                   xcpCtoReqPacket[0] - xcpCtoRxLength);
 
       /* check to see if the entire packet was received */
       if (xcpCtoRxLength == xcpCtoReqPacket[0])
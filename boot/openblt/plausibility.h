@@ -219,6 +219,10 @@
 #error "BOOT_COM_RS232_CS_TYPE must be 0 (none) or 1 (byte)"
 #endif
 
+#ifndef BOOT_COM_RS232_AUTOBAUD_ENABLE
+#define BOOT_COM_RS232_AUTOBAUD_ENABLE   (0)
+#endif
+
 #endif /* BOOT_COM_RS232_ENABLE > 0 */
 
 #ifndef BOOT_COM_MBRTU_ENABLE
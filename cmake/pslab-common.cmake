@@ -11,6 +11,94 @@ endif()
 set(CMAKE_C_STANDARD 23)
 set(CMAKE_C_STANDARD_REQUIRED ON)
 
+# Memory profile, sizing the USB, SCPI and log buffers together, and the
+# number of SCPI sessions, which each take a set of USB and SCPI buffers:
+#   default    - sizes set in the sources
+#   throughput - large USB TX rings to keep the endpoints busy
+#   lowmem     - small buffers for a smaller RAM footprint
+# Ring buffer sizes must be powers of 2; this is checked at compile time.
+set(PSLAB_PROFILE "default" CACHE STRING "Buffer memory profile")
+set_property(CACHE PSLAB_PROFILE PROPERTY STRINGS
+    "default" "throughput" "lowmem"
+)
+
+if(PSLAB_PROFILE STREQUAL "throughput")
+    add_compile_definitions(
+        PSLAB_USB_RX_BUFFER_SIZE=1024
+        PSLAB_USB_TX_BUFFER_SIZE=4096
+        PSLAB_USB_BULK_TX_BUFFER_SIZE=16384
+        PSLAB_SCPI_INPUT_BUFFER_SIZE=512
+    )
+elseif(PSLAB_PROFILE STREQUAL "lowmem")
+    add_compile_definitions(
+        PSLAB_USB_RX_BUFFER_SIZE=256
+        PSLAB_USB_TX_BUFFER_SIZE=256
+        PSLAB_USB_BULK_TX_BUFFER_SIZE=1024
+        PSLAB_SCPI_INPUT_BUFFER_SIZE=128
+        PSLAB_SCPI_SESSIONS=1
+        PSLAB_LOG_UART_BUFFER_SIZE=256
+        PSLAB_STDOUT_BUFFER_SIZE=128
+        LOG_BUFFER_SIZE=256
+        LOG_DRAIN_BUFFER_SIZE=256
+    )
+elseif(NOT PSLAB_PROFILE STREQUAL "default")
+    message(FATAL_ERROR "Unknown PSLAB_PROFILE: ${PSLAB_PROFILE}")
+endif()
+message(STATUS "Buffer memory profile: ${PSLAB_PROFILE}")
+
+# Argument checks of per-byte and per-sample functions, see CHECK_ARGUMENT
+# in util/error.h. They are on in debug builds and off in the others; test
+# builds always keep them, as the tests expect the errors they throw.
+if(CMAKE_BUILD_TYPE STREQUAL "Debug" OR BUILD_TESTS)
+    set(PSLAB_CHECK_ARGUMENTS_DEFAULT ON)
+else()
+    set(PSLAB_CHECK_ARGUMENTS_DEFAULT OFF)
+endif()
+option(PSLAB_CHECK_ARGUMENTS "Check arguments on hot paths"
+    ${PSLAB_CHECK_ARGUMENTS_DEFAULT}
+)
+if(BUILD_TESTS OR PSLAB_CHECK_ARGUMENTS)
+    add_compile_definitions(PSLAB_CHECK_ARGUMENTS=1)
+else()
+    add_compile_definitions(PSLAB_CHECK_ARGUMENTS=0)
+endif()
+message(STATUS "Hot path argument checks: ${PSLAB_CHECK_ARGUMENTS}")
+
+# Isochronous sample interface, see usb_ll.h. It takes the endpoints of the
+# UART bridge, which is unavailable in these builds.
+option(PSLAB_USB_ISO "Isochronous USB sample interface instead of the bridge"
+    OFF
+)
+if(PSLAB_USB_ISO)
+    add_compile_definitions(PSLAB_USB_ISO=1)
+else()
+    add_compile_definitions(PSLAB_USB_ISO=0)
+endif()
+message(STATUS "Isochronous sample interface: ${PSLAB_USB_ISO}")
+
+# Log and event trace output on the SWO pin from startup, see itm_ll.h,
+# leaving the log UART to other traffic. Both can also be switched at run
+# time with SYSTem:LOG:SINK and SYSTem:TRACe:ITM.
+option(PSLAB_LOG_ITM "Log and trace on SWO instead of the log UART" OFF)
+if(PSLAB_LOG_ITM)
+    add_compile_definitions(PSLAB_LOG_ITM=1)
+else()
+    add_compile_definitions(PSLAB_LOG_ITM=0)
+endif()
+message(STATUS "Log and trace on SWO: ${PSLAB_LOG_ITM}")
+
+# Fully buffered stdout: printf output goes to the log UART in chunks of
+# PSLAB_STDOUT_BUFFER_SIZE bytes, and at least every 10 ms, instead of at
+# each newline. Cheaper under heavy printf use, but chunks may split lines
+# of the log output on the same UART.
+option(PSLAB_STDOUT_FULL_BUFFERING "Fully buffered stdout" OFF)
+if(PSLAB_STDOUT_FULL_BUFFERING)
+    add_compile_definitions(PSLAB_STDOUT_FULL_BUFFERING=1)
+else()
+    add_compile_definitions(PSLAB_STDOUT_FULL_BUFFERING=0)
+endif()
+message(STATUS "Fully buffered stdout: ${PSLAB_STDOUT_FULL_BUFFERING}")
+
 # Common source formatting and linting targets
 function(setup_code_quality_targets)
     # Glob all C source files in the current directory and subdirectories
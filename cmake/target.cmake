@@ -1,15 +1,63 @@
-# Target build configuration for STM32H563
+# Target build configuration for STM32H563, or for a Linux host
 
 # Platform selection
 set(PLATFORM "h563xx" CACHE STRING "Target platform")
-set_property(CACHE PLATFORM PROPERTY STRINGS "h563xx")
+set_property(CACHE PLATFORM PROPERTY STRINGS "h563xx" "native")
 
 # Find required packages for target
-find_package(CMSIS COMPONENTS STM32H563ZI REQUIRED)
-find_package(HAL COMPONENTS STM32H5 REQUIRED)
+if(PLATFORM STREQUAL "h563xx")
+    find_package(CMSIS COMPONENTS STM32H563ZI REQUIRED)
+    find_package(HAL COMPONENTS STM32H5 REQUIRED)
+endif()
 
-# Add subdirectories
-add_subdirectory(boot)
+# Report the RAM and flash budget of a firmware image after linking: the
+# fill level of each memory region of the linker script, the size of each
+# output section, and a map file next to the image for the details.
+function(pslab_print_memory_usage TARGET)
+    if(NOT PLATFORM STREQUAL "h563xx")
+        return()
+    endif()
+    target_link_options(${TARGET} PRIVATE
+        -Wl,--print-memory-usage
+        -Wl,-Map=${CMAKE_CURRENT_BINARY_DIR}/${TARGET}.map
+    )
+    add_custom_command(TARGET ${TARGET} POST_BUILD
+        COMMAND ${CMAKE_SIZE} -A -x "$<TARGET_FILE:${TARGET}>"
+        COMMENT "Section sizes of ${TARGET}:"
+        VERBATIM
+    )
+endfunction()
+
+# Generate a heatshrink compressed S-record file of a firmware image, for the
+# bootloader to decompress while it receives it. The window and lookahead
+# sizes, and the address of the stream, match BOOT_FLASH_UNPACK_* in
+# boot/blt_conf.h. Skipped when heatshrink is not installed.
+function(pslab_generate_compressed_srec TARGET)
+    if(NOT PLATFORM STREQUAL "h563xx")
+        return()
+    endif()
+    find_program(HEATSHRINK_EXECUTABLE heatshrink)
+    if(NOT HEATSHRINK_EXECUTABLE)
+        message(STATUS "heatshrink not found, no compressed image of ${TARGET}")
+        return()
+    endif()
+    set(BASE ${CMAKE_CURRENT_BINARY_DIR}/${TARGET})
+    add_custom_command(TARGET ${TARGET} POST_BUILD
+        COMMAND ${CMAKE_OBJCOPY} -O binary --gap-fill=0xff
+            "$<TARGET_FILE:${TARGET}>" ${BASE}.bin
+        COMMAND ${HEATSHRINK_EXECUTABLE} -e -w 11 -l 4 ${BASE}.bin ${BASE}.hs
+        COMMAND ${CMAKE_OBJCOPY} -I binary -O srec
+            --change-addresses=0xC0000000 ${BASE}.hs ${BASE}.hs.srec
+        BYPRODUCTS ${BASE}.bin ${BASE}.hs ${BASE}.hs.srec
+        COMMENT "Generating compressed image ${TARGET}.hs.srec"
+        VERBATIM
+    )
+endfunction()
+
+# Add subdirectories; the bootloader only exists for the target
+if(PLATFORM STREQUAL "h563xx")
+    add_subdirectory(boot)
+endif()
 add_subdirectory(lib)
 add_subdirectory(src)
 
@@ -45,6 +45,9 @@
 //--------------------------------------------------------------------+
 #define BULK_PACKET_SIZE (TUD_OPT_HIGH_SPEED ? 512 : 64)
 
+// SERIAL_STATE notification: 8 byte header followed by the 2 byte UART state bitmap
+#define CDC_NOTIF_SERIAL_STATE_SIZE 10
+
 typedef struct {
   uint8_t itf_num;
   uint8_t ep_notif;
@@ -74,6 +77,7 @@ typedef struct {
 typedef struct {
   TUD_EPBUF_DEF(epout, CFG_TUD_CDC_EP_BUFSIZE);
   TUD_EPBUF_DEF(epin, CFG_TUD_CDC_EP_BUFSIZE);
+  TUD_EPBUF_DEF(epnotif, CDC_NOTIF_SERIAL_STATE_SIZE);
 } cdcd_epbuf_t;
 
 //--------------------------------------------------------------------+
@@ -228,6 +232,35 @@ bool tud_cdc_n_write_clear(uint8_t itf) {
   return tu_fifo_clear(&_cdcd_itf[itf].tx_ff);
 }
 
+//--------------------------------------------------------------------+
+// NOTIFICATION API
+//--------------------------------------------------------------------+
+bool tud_cdc_n_notify_serial_state(uint8_t itf, uint16_t state) {
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  cdcd_epbuf_t* p_epbuf = &_cdcd_epbuf[itf];
+  const uint8_t rhport = 0;
+
+  // Skip if usb is not ready yet or the interface has no notification endpoint
+  TU_VERIFY(tud_ready() && p_cdc->ep_notif);
+
+  // Fails while the previous notification has not been collected by the host
+  TU_VERIFY(usbd_edpt_claim(rhport, p_cdc->ep_notif));
+
+  uint8_t* buf = p_epbuf->epnotif;
+  buf[0] = 0xA1; // Class request, device to host, interface recipient
+  buf[1] = CDC_NOTIF_SERIAL_STATE;
+  buf[2] = 0; // wValue
+  buf[3] = 0;
+  buf[4] = p_cdc->itf_num; // wIndex
+  buf[5] = 0;
+  buf[6] = 2; // wLength
+  buf[7] = 0;
+  buf[8] = TU_U16_LOW(state);
+  buf[9] = TU_U16_HIGH(state);
+
+  return usbd_edpt_xfer(rhport, p_cdc->ep_notif, buf, CDC_NOTIF_SERIAL_STATE_SIZE);
+}
+
 //--------------------------------------------------------------------+
 // USBD Driver API
 //--------------------------------------------------------------------+
@@ -453,7 +486,7 @@ bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
   // Identify which interface to use
   for (itf = 0; itf < CFG_TUD_CDC; itf++) {
     p_cdc = &_cdcd_itf[itf];
-    if ((ep_addr == p_cdc->ep_out) || (ep_addr == p_cdc->ep_in)) {
+    if ((ep_addr == p_cdc->ep_out) || (ep_addr == p_cdc->ep_in) || (ep_addr == p_cdc->ep_notif)) {
       break;
     }
   }
@@ -502,7 +535,7 @@ bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
     }
   }
 
-  // nothing to do with notif endpoint for now
+  // nothing to do once a notification has been sent, the endpoint is released by the stack
 
   return true;
 }
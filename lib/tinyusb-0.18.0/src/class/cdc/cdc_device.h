@@ -116,6 +116,10 @@ uint32_t tud_cdc_n_write_available(uint8_t itf);
 // Clear the transmit FIFO
 bool tud_cdc_n_write_clear(uint8_t itf);
 
+// Send a SERIAL_STATE notification with the UART state bitmap on the notification endpoint.
+// Return false if the device is not ready or the previous notification is still pending.
+bool tud_cdc_n_notify_serial_state(uint8_t itf, uint16_t state);
+
 //--------------------------------------------------------------------+
 // Application API (Single Port)
 //--------------------------------------------------------------------+
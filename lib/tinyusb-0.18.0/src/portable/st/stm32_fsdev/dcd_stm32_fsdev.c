@@ -76,7 +76,8 @@
  * - Packet buffer memory is copied in the interrupt.
  *   - This is better for performance, but means interrupts are disabled for longer
  *   - DMA may be the best choice, but it could also be pushed to the USBD task.
- * - No double-buffering
+ * - Double-buffering only for ISO endpoints, and for bulk endpoints selected with
+ *   CFG_TUD_FSDEV_DBUF_BULK_IN / CFG_TUD_FSDEV_DBUF_BULK_OUT
  * - No DMA
  * - Minimal error handling
  *   - Perhaps error interrupts should be reported to the stack, or cause a device reset?
@@ -127,6 +128,18 @@
 // MACRO CONSTANT TYPEDEF
 //--------------------------------------------------------------------+
 
+// Bulk endpoints to double buffer, as masks of endpoint numbers (bit n for endpoint n) per direction.
+// A double buffered endpoint takes a hardware endpoint of its own instead of sharing it with the
+// endpoint of the same number in the other direction, and PMA for two packets. OUT transfers on
+// these endpoints must be a non-zero multiple of the packet size.
+#ifndef CFG_TUD_FSDEV_DBUF_BULK_IN
+  #define CFG_TUD_FSDEV_DBUF_BULK_IN 0
+#endif
+
+#ifndef CFG_TUD_FSDEV_DBUF_BULK_OUT
+  #define CFG_TUD_FSDEV_DBUF_BULK_OUT 0
+#endif
+
 // One of these for every EP IN & OUT, uses a bit of RAM....
 typedef struct {
   uint8_t *buffer;
@@ -136,6 +149,12 @@ typedef struct {
   uint16_t max_packet_size;
   uint8_t ep_idx;   // index for USB_EPnR register
   bool iso_in_sending; // Workaround for ISO IN EP doesn't have interrupt mask
+  // Double buffered bulk endpoint, see dbuf_in_pump() and dbuf_out_receive()
+  bool dbuf;
+  bool dbuf_busy;    // Transfer not yet reported complete
+  bool dbuf_staged;  // IN: packet in the application buffer, not yet handed over
+  bool dbuf_sending; // IN: packet handed over to the USB side, not yet sent
+  bool dbuf_held;    // OUT: packet received while no transfer was queued
 } xfer_ctl_t;
 
 // EP allocator
@@ -143,6 +162,7 @@ typedef struct {
   uint8_t ep_num;
   uint8_t ep_type;
   bool allocated[2];
+  bool exclusive; // Both directions taken by one double buffered endpoint
 } ep_alloc_t;
 
 static xfer_ctl_t xfer_status[CFG_TUD_ENDPPOINT_MAX][2];
@@ -161,7 +181,7 @@ static bool edpt_xfer(uint8_t rhport, uint8_t ep_num, tusb_dir_t dir);
 // PMA allocation/access
 static uint16_t ep_buf_ptr; ///< Points to first free memory location
 static uint32_t dcd_pma_alloc(uint16_t len, bool dbuf);
-static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type);
+static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type, bool exclusive);
 static bool dcd_write_packet_memory(uint16_t dst, const void *__restrict src, uint16_t nbytes);
 static bool dcd_read_packet_memory(void *__restrict dst, uint16_t src, uint16_t nbytes);
 
@@ -170,6 +190,12 @@ static bool dcd_read_packet_memory_ff(tu_fifo_t *ff, uint16_t src, uint16_t wNBy
 
 static void edpt0_open(uint8_t rhport);
 
+// Double buffered bulk endpoints
+static void edpt_init_reg(uint32_t *ep_reg, xfer_ctl_t *xfer, uint32_t ep_ix, tusb_dir_t dir);
+static void dbuf_in_stage(xfer_ctl_t *xfer, uint32_t ep_ix);
+static bool dbuf_in_pump(xfer_ctl_t *xfer, uint32_t ep_ix);
+static bool dbuf_out_receive(xfer_ctl_t *xfer, uint32_t ep_ix);
+
 TU_ATTR_ALWAYS_INLINE static inline void edpt0_prepare_setup(void) {
    btable_set_rx_bufsize(0, BTABLE_BUF_RX, 8);
 }
@@ -266,6 +292,7 @@ static void handle_bus_reset(uint8_t rhport) {
     ep_alloc_status[i].ep_type = 0xFF;
     ep_alloc_status[i].allocated[0] = false;
     ep_alloc_status[i].allocated[1] = false;
+    ep_alloc_status[i].exclusive = false;
   }
 
   // Reset PMA allocation
@@ -295,6 +322,14 @@ static void handle_ctr_tx(uint32_t ep_id) {
     btable_set_count(ep_id, buf_id, 0);
   }
 
+  if (xfer->dbuf) {
+    xfer->dbuf_sending = false;
+    if (dbuf_in_pump(xfer, ep_id)) {
+      dcd_event_xfer_complete(0, ep_num | TUSB_DIR_IN_MASK, xfer->total_len, XFER_RESULT_SUCCESS, true);
+    }
+    return;
+  }
+
   if (xfer->total_len != xfer->queued_len) {
     dcd_transmit_packet(xfer, ep_id);
   } else {
@@ -330,6 +365,13 @@ static void handle_ctr_rx(uint32_t ep_id) {
   bool const is_iso = ep_is_iso(ep_reg);
   xfer_ctl_t* xfer = xfer_ctl_ptr(ep_num, TUSB_DIR_OUT);
 
+  if (xfer->dbuf) {
+    if (dbuf_out_receive(xfer, ep_id)) {
+      dcd_event_xfer_complete(0, ep_num, xfer->queued_len, XFER_RESULT_SUCCESS, true);
+    }
+    return;
+  }
+
   uint8_t buf_id;
   if (is_iso) {
     buf_id = (ep_reg & USB_EP_DTOG_RX) ? 0 : 1; // ISO are double buffered
@@ -514,12 +556,28 @@ static uint32_t dcd_pma_alloc(uint16_t len, bool dbuf)
 /***
  * Allocate hardware endpoint
  */
-static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type)
+static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type, bool exclusive)
 {
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
 
   for (uint8_t i = 0; i < FSDEV_EP_COUNT; i++) {
+    // Double buffered endpoints share their hardware endpoint with nothing
+    if (ep_alloc_status[i].exclusive) {
+      continue;
+    }
+    if (exclusive) {
+      if (ep_alloc_status[i].allocated[0] || ep_alloc_status[i].allocated[1]) {
+        continue;
+      }
+      ep_alloc_status[i].ep_num = epnum;
+      ep_alloc_status[i].ep_type = ep_type;
+      ep_alloc_status[i].allocated[0] = true;
+      ep_alloc_status[i].allocated[1] = true;
+      ep_alloc_status[i].exclusive = true;
+      return i;
+    }
+
     // Check if already allocated
     if (ep_alloc_status[i].allocated[dir] &&
         ep_alloc_status[i].ep_type == ep_type &&
@@ -546,14 +604,14 @@ static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type)
   }
 
   // Allocation failed
-  TU_ASSERT(0);
+  TU_ASSERT(0, 0xFF);
 }
 
 void edpt0_open(uint8_t rhport) {
   (void) rhport;
 
-  dcd_ep_alloc(0x0, TUSB_XFER_CONTROL);
-  dcd_ep_alloc(0x80, TUSB_XFER_CONTROL);
+  dcd_ep_alloc(0x0, TUSB_XFER_CONTROL, false);
+  dcd_ep_alloc(0x80, TUSB_XFER_CONTROL, false);
 
   xfer_status[0][0].max_packet_size = CFG_TUD_ENDPOINT0_SIZE;
   xfer_status[0][0].ep_idx = 0;
@@ -583,7 +641,9 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const *desc_ep) {
   uint8_t const ep_num = tu_edpt_number(ep_addr);
   tusb_dir_t const dir = tu_edpt_dir(ep_addr);
   const uint16_t packet_size = tu_edpt_packet_size(desc_ep);
-  uint8_t const ep_idx = dcd_ep_alloc(ep_addr, desc_ep->bmAttributes.xfer);
+  uint32_t const dbuf_mask = (dir == TUSB_DIR_IN) ? CFG_TUD_FSDEV_DBUF_BULK_IN : CFG_TUD_FSDEV_DBUF_BULK_OUT;
+  bool const dbuf = desc_ep->bmAttributes.xfer == TUSB_XFER_BULK && (dbuf_mask & TU_BIT(ep_num));
+  uint8_t const ep_idx = dcd_ep_alloc(ep_addr, desc_ep->bmAttributes.xfer, dbuf);
   TU_ASSERT(ep_idx < FSDEV_EP_COUNT);
 
   uint32_t ep_reg = ep_read(ep_idx) & ~USB_EPREG_MASK;
@@ -604,21 +664,30 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const *desc_ep) {
   }
 
   /* Create a packet memory buffer area. */
-  uint16_t pma_addr = dcd_pma_alloc(packet_size, false);
-  btable_set_addr(ep_idx, dir == TUSB_DIR_IN ? BTABLE_BUF_TX : BTABLE_BUF_RX, pma_addr);
-
   xfer_ctl_t *xfer = xfer_ctl_ptr(ep_num, dir);
   xfer->max_packet_size = packet_size;
   xfer->ep_idx = ep_idx;
+  xfer->dbuf = dbuf;
+  xfer->dbuf_busy = xfer->dbuf_staged = xfer->dbuf_sending = xfer->dbuf_held = false;
 
-  ep_change_status(&ep_reg, dir, EP_STAT_NAK);
-  ep_change_dtog(&ep_reg, dir, 0);
+  if (dbuf) {
+    // Both buffer descriptors serve the one direction; SW_BUF is the other direction's DTOG bit
+    uint32_t pma_addr = dcd_pma_alloc(packet_size, true);
+    btable_set_addr(ep_idx, 0, (uint16_t) pma_addr);
+    btable_set_addr(ep_idx, 1, (uint16_t) (pma_addr >> 16));
+    ep_reg |= USB_EP_KIND;
+  } else {
+    uint16_t pma_addr = dcd_pma_alloc(packet_size, false);
+    btable_set_addr(ep_idx, dir == TUSB_DIR_IN ? BTABLE_BUF_TX : BTABLE_BUF_RX, pma_addr);
+  }
+
+  edpt_init_reg(&ep_reg, xfer, ep_idx, dir);
 
-  // reserve other direction toggle bits
+  // reserve other direction toggle bits; SW_BUF of a double buffered endpoint was set above
   if (dir == TUSB_DIR_IN) {
-    ep_reg &= ~(USB_EPRX_STAT | USB_EP_DTOG_RX);
+    ep_reg &= ~(USB_EPRX_STAT | (dbuf ? 0 : USB_EP_DTOG_RX));
   } else {
-    ep_reg &= ~(USB_EPTX_STAT | USB_EP_DTOG_TX);
+    ep_reg &= ~(USB_EPTX_STAT | (dbuf ? 0 : USB_EP_DTOG_TX));
   }
 
   ep_write(ep_idx, ep_reg, true);
@@ -637,6 +706,7 @@ void dcd_edpt_close_all(uint8_t rhport) {
     ep_alloc_status[i].ep_type = 0xFF;
     ep_alloc_status[i].allocated[0] = false;
     ep_alloc_status[i].allocated[1] = false;
+    ep_alloc_status[i].exclusive = false;
   }
 
   dcd_int_enable(rhport);
@@ -650,7 +720,7 @@ bool dcd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packet
 
   uint8_t const ep_num = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
-  uint8_t const ep_idx = dcd_ep_alloc(ep_addr, TUSB_XFER_ISOCHRONOUS);
+  uint8_t const ep_idx = dcd_ep_alloc(ep_addr, TUSB_XFER_ISOCHRONOUS, false);
 
   /* Create a packet memory buffer area. Enable double buffering for devices with 2048 bytes PMA,
      for smaller devices double buffering occupy too much space. */
@@ -694,6 +764,122 @@ bool dcd_edpt_iso_activate(uint8_t rhport, tusb_desc_endpoint_t const *desc_ep)
   return true;
 }
 
+//--------------------------------------------------------------------+
+// Double buffered bulk endpoints
+//
+// The USB side uses the buffer selected by the endpoint's DTOG bit and toggles it after each packet;
+// the application uses the buffer selected by SW_BUF, the DTOG bit of the unused direction. While
+// the two are equal the endpoint NAKs, so toggling SW_BUF hands a buffer over to the USB side.
+//--------------------------------------------------------------------+
+
+// Hand a buffer over to the USB side and keep the endpoint valid. Called from the
+// endpoint's CTR interrupt or with it disabled.
+static void dbuf_toggle_sw(uint32_t ep_ix, tusb_dir_t dir) {
+  tusb_dir_t const other = (dir == TUSB_DIR_IN) ? TUSB_DIR_OUT : TUSB_DIR_IN;
+  uint32_t ep_reg = ep_read(ep_ix) | USB_EP_CTR_TX | USB_EP_CTR_RX; // reserve CTR
+  ep_reg &= USB_EPREG_MASK | EP_STAT_MASK(dir);
+  ep_change_status(&ep_reg, dir, EP_STAT_VALID);
+  ep_reg |= EP_DTOG_MASK(other);
+  ep_write(ep_ix, ep_reg, false);
+}
+
+// Set the status and toggle bits of an endpoint to their state after opening, in a register
+// value holding the current bits
+static void edpt_init_reg(uint32_t *ep_reg, xfer_ctl_t *xfer, uint32_t ep_ix, tusb_dir_t dir) {
+  if (!xfer->dbuf) {
+    ep_change_status(ep_reg, dir, EP_STAT_NAK);
+    ep_change_dtog(ep_reg, dir, 0);
+    return;
+  }
+
+  tusb_dir_t const other = (dir == TUSB_DIR_IN) ? TUSB_DIR_OUT : TUSB_DIR_IN;
+  xfer->dbuf_busy = xfer->dbuf_staged = xfer->dbuf_sending = xfer->dbuf_held = false;
+
+  if (dir == TUSB_DIR_IN) {
+    // Both bits equal: nothing to send until a packet is handed over
+    ep_change_status(ep_reg, dir, EP_STAT_NAK);
+    ep_change_dtog(ep_reg, dir, 0);
+    ep_change_dtog(ep_reg, other, 0);
+  } else {
+    // USB side receives into buffer 0 straight away; a packet that arrives before a
+    // transfer is queued is held in PMA
+    btable_set_rx_bufsize(ep_ix, 0, xfer->max_packet_size);
+    btable_set_rx_bufsize(ep_ix, 1, xfer->max_packet_size);
+    ep_change_status(ep_reg, dir, EP_STAT_VALID);
+    ep_change_dtog(ep_reg, dir, 0);
+    ep_change_dtog(ep_reg, other, 1);
+  }
+}
+
+// Copy the next packet of a transfer, possibly a ZLP, into the application side buffer of an IN endpoint
+static void dbuf_in_stage(xfer_ctl_t *xfer, uint32_t ep_ix) {
+  uint16_t const len = tu_min16(xfer->total_len - xfer->queued_len, xfer->max_packet_size);
+  uint8_t const buf_id = (ep_read(ep_ix) & USB_EP_DTOG_RX) ? 1 : 0; // SW_BUF
+  uint16_t const addr_ptr = (uint16_t) btable_get_addr(ep_ix, buf_id);
+
+  if (xfer->ff) {
+    dcd_write_packet_memory_ff(xfer->ff, addr_ptr, len);
+  } else {
+    dcd_write_packet_memory(addr_ptr, &(xfer->buffer[xfer->queued_len]), len);
+  }
+  xfer->queued_len += len;
+  btable_set_count(ep_ix, buf_id, len);
+  xfer->dbuf_staged = true;
+}
+
+// Keep an IN endpoint fed: one packet is sent while the next is staged. A transfer is complete once its
+// last packet has been handed over, so the next transfer is staged while that packet is sent.
+// Returns true when the transfer completes.
+static bool dbuf_in_pump(xfer_ctl_t *xfer, uint32_t ep_ix) {
+  for (;;) {
+    if (!xfer->dbuf_staged && xfer->dbuf_busy && xfer->queued_len < xfer->total_len) {
+      dbuf_in_stage(xfer, ep_ix);
+    }
+    if (!xfer->dbuf_staged || xfer->dbuf_sending) {
+      break;
+    }
+    dbuf_toggle_sw(ep_ix, TUSB_DIR_IN);
+    xfer->dbuf_staged = false;
+    xfer->dbuf_sending = true;
+  }
+
+  if (xfer->dbuf_busy && !xfer->dbuf_staged && xfer->queued_len == xfer->total_len) {
+    xfer->dbuf_busy = false;
+    return true;
+  }
+  return false;
+}
+
+// Take the packet an OUT endpoint has just received, waiting for SW_BUF. The other buffer is handed
+// back before the copy, so the next packet is received meanwhile; without a transfer queued the packet
+// is held until there is one. Returns true when the transfer completes.
+static bool dbuf_out_receive(xfer_ctl_t *xfer, uint32_t ep_ix) {
+  uint8_t const buf_id = (ep_read(ep_ix) & USB_EP_DTOG_RX) ? 0 : 1; // the buffer DTOG left
+  if (!xfer->dbuf_busy) {
+    xfer->dbuf_held = true;
+    return false;
+  }
+
+  dbuf_toggle_sw(ep_ix, TUSB_DIR_OUT);
+  xfer->dbuf_held = false;
+
+  // Transfers are whole packets, so a packet always fits
+  uint16_t const rx_count = btable_get_count(ep_ix, buf_id);
+  uint16_t const pma_addr = (uint16_t) btable_get_addr(ep_ix, buf_id);
+  if (xfer->ff) {
+    dcd_read_packet_memory_ff(xfer->ff, pma_addr, rx_count);
+  } else {
+    dcd_read_packet_memory(xfer->buffer + xfer->queued_len, pma_addr, rx_count);
+  }
+  xfer->queued_len += rx_count;
+
+  if ((rx_count < xfer->max_packet_size) || (xfer->queued_len >= xfer->total_len)) {
+    xfer->dbuf_busy = false;
+    return true;
+  }
+  return false;
+}
+
 // Currently, single-buffered, and only 64 bytes at a time (max)
 static void dcd_transmit_packet(xfer_ctl_t *xfer, uint16_t ep_ix) {
   uint16_t len = tu_min16(xfer->total_len - xfer->queued_len, xfer->max_packet_size);
@@ -732,7 +918,30 @@ static bool edpt_xfer(uint8_t rhport, uint8_t ep_num, tusb_dir_t dir) {
   xfer_ctl_t *xfer = xfer_ctl_ptr(ep_num, dir);
   uint8_t const ep_idx = xfer->ep_idx;
 
-  if (dir == TUSB_DIR_IN) {
+  if (xfer->dbuf) {
+    bool complete;
+    if (dir == TUSB_DIR_OUT) {
+      TU_ASSERT(xfer->total_len && (xfer->total_len % xfer->max_packet_size) == 0);
+    }
+
+    // The endpoint's CTR interrupt works on the same state
+    dcd_int_disable(rhport);
+    xfer->dbuf_busy = true;
+    if (dir == TUSB_DIR_IN) {
+      dbuf_in_stage(xfer, ep_idx); // Possibly a ZLP
+      complete = dbuf_in_pump(xfer, ep_idx);
+    } else {
+      // A packet that arrived before this transfer is taken at once
+      complete = xfer->dbuf_held && dbuf_out_receive(xfer, ep_idx);
+    }
+    dcd_int_enable(rhport);
+
+    if (complete) {
+      uint8_t const ep_addr = ep_num | (dir == TUSB_DIR_IN ? TUSB_DIR_IN_MASK : 0);
+      uint16_t const len = (dir == TUSB_DIR_IN) ? xfer->total_len : xfer->queued_len;
+      dcd_event_xfer_complete(0, ep_addr, len, XFER_RESULT_SUCCESS, false);
+    }
+  } else if (dir == TUSB_DIR_IN) {
     dcd_transmit_packet(xfer, ep_idx);
   } else {
     uint32_t ep_reg = ep_read(ep_idx) | USB_EP_CTR_TX | USB_EP_CTR_RX; // reserve CTR
@@ -803,6 +1012,17 @@ void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
   uint8_t const ep_idx = xfer->ep_idx;
 
   uint32_t ep_reg = ep_read(ep_idx) | USB_EP_CTR_TX | USB_EP_CTR_RX; // reserve CTR bits
+
+  if (xfer->dbuf) {
+    tusb_dir_t const other = (dir == TUSB_DIR_IN) ? TUSB_DIR_OUT : TUSB_DIR_IN;
+    ep_reg &= USB_EPREG_MASK | EP_STAT_MASK(dir) | EP_DTOG_MASK(dir) | EP_DTOG_MASK(other);
+    dcd_int_disable(rhport);
+    edpt_init_reg(&ep_reg, xfer, ep_idx, dir);
+    ep_write(ep_idx, ep_reg, false);
+    dcd_int_enable(rhport);
+    return;
+  }
+
   ep_reg &= USB_EPREG_MASK | EP_STAT_MASK(dir) | EP_DTOG_MASK(dir);
 
   if (!ep_is_iso(ep_reg)) {
@@ -5,14 +5,35 @@
 #define CFG_TUSB_MCU            OPT_MCU_STM32H5
 #define CFG_TUSB_RHPORT0_MODE   OPT_MODE_DEVICE
 
-// Enable only CDC (virtual COM port)
-#define CFG_TUD_CDC             1
+// CDC (virtual COM ports) for SCPI, logs and the UART bridge, vendor bulk
+// for sample data. With PSLAB_USB_ISO, an isochronous sample interface
+// takes the place of the UART bridge (see usb_ll.h).
+#if defined(PSLAB_USB_ISO) && PSLAB_USB_ISO
+#define CFG_TUD_CDC             2
+#else
+#define CFG_TUD_CDC             3
+#endif
 #define CFG_TUD_MSC             0
 #define CFG_TUD_HID             0
-#define CFG_TUD_VENDOR          0
+#define CFG_TUD_VENDOR          1
 
 #define CFG_TUD_ENDPOINT0_SIZE  64
 #define CFG_TUD_CDC_RX_BUFSIZE  64
 #define CFG_TUD_CDC_TX_BUFSIZE  64
 
+#define CFG_TUD_VENDOR_EPSIZE      64
+#define CFG_TUD_VENDOR_RX_BUFSIZE  64
+#define CFG_TUD_VENDOR_TX_BUFSIZE  512
+
+// Double buffered bulk endpoints of the FSDEV driver, bit n for endpoint n.
+// Each takes a hardware endpoint of its own, so only builds that leave one
+// free use them: with PSLAB_USB_ISO, the SCPI serial port can send a packet
+// while the next one is copied.
+#if defined(PSLAB_USB_ISO) && PSLAB_USB_ISO
+#define CFG_TUD_FSDEV_DBUF_BULK_IN  (1u << 2)
+#else
+#define CFG_TUD_FSDEV_DBUF_BULK_IN  0
+#endif
+#define CFG_TUD_FSDEV_DBUF_BULK_OUT 0
+
 #endif  // TUSB_CONFIG_H
@@ -0,0 +1,494 @@
+/**
+ * @file bench.c
+ * @brief On-target benchmarks, the main program of the pslab-mini-bench image
+ *
+ * Times the firmware hot paths on the STM32H563 with the CPU cycle counter,
+ * including the flash wait states, cache misses and DMA contention that
+ * host benchmarks cannot show:
+ * - circular buffer byte and block operations, and typed ring blocks of
+ *   the same size in bytes
+ * - LOG_write
+ * - ADC DMA into a DSO buffer at the maximum sample rate, the DSO interrupt
+ *   handler, the latency from that interrupt to the scheduler task waiting
+ *   for its event, and DSO_start of an acquisition staged by DSO_prepare
+ * - USB_write throughput on the SCPI serial port
+ *
+ * The first three run once after reset and are reported on the log UART.
+ * The USB benchmark runs each time a host opens the serial port, e.g. with
+ * `cat /dev/ttyACM0 > /dev/null`, and reports once the data has been sent.
+ *
+ * Each micro-benchmark is warmed up once, so that code and data are cached,
+ * and then timed over BENCH_RUNS runs. Interrupts stay enabled, as in the
+ * firmware, so the minimum is the undisturbed figure and the maximum
+ * includes interrupt handlers that ran in between.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "system/bus/usb.h"
+#include "system/clock.h"
+#include "system/instrument/dso.h"
+#include "system/led.h"
+#include "system/profile.h"
+#include "system/scheduler.h"
+#include "system/system.h"
+#include "util/error.h"
+#include "util/logging.h"
+#include "util/ring.h"
+#include "util/util.h"
+
+enum {
+    BENCH_RUNS = 64, // Timed runs per micro-benchmark
+    BENCH_BATCH = 256, // Operations per timed run
+    RESULTS_MAX = 8,
+    RING_SIZE = 1024,
+    CHUNK_SIZE = 64, // Bytes per circular buffer write and read
+    SAMPLE_CHUNK = CHUNK_SIZE / sizeof(uint16_t), // Per typed ring operation
+    LOG_BATCH = 4, // Messages per timed run, so that they fit the log buffer
+    DSO_SAMPLES = 4096,
+    DSO_RUNS = 16,
+    DSO_TIMEOUT = 100, // ms per acquisition
+    USB_RX_BUFFER_SIZE = 256,
+    USB_TX_BUFFER_SIZE = 4096,
+    USB_PATTERN_SIZE = 512,
+    USB_BYTES = 1024 * 1024, // Bytes sent per USB benchmark
+    USB_TIMEOUT = 10000, // ms
+    USB_PERIOD = 1, // ms
+    LOG_PERIOD = 10, // ms
+    BLINK_PERIOD = 1000, // ms
+};
+
+/**
+ * @brief Timings of a benchmark, reported once all have run
+ */
+typedef struct {
+    char const *name;
+    PROFILE_Stats stats; // Cycles per run
+    uint32_t ops; // Operations per run
+} Result;
+
+static Result g_results[RESULTS_MAX];
+static uint32_t g_result_count = 0;
+
+static uint8_t g_ring_data[RING_SIZE];
+static CircularBuffer g_ring;
+static uint8_t g_chunk[CHUNK_SIZE];
+static uint16_t g_sample_ring_data[RING_SIZE];
+static RingU16 g_sample_ring;
+static uint16_t g_samples[SAMPLE_CHUNK];
+
+static uint8_t g_log_scratch[LOG_LINE_SIZE_MAX];
+
+static uint16_t g_dso_buffer[DSO_SAMPLES];
+static uint32_t volatile g_dso_done_cycles = 0;
+static bool volatile g_dso_done = false;
+static bool g_dso_seen = false;
+static PROFILE_Stats g_dso_latency = { 0 };
+
+static uint8_t g_usb_rx_data[USB_RX_BUFFER_SIZE];
+static uint8_t g_usb_tx_data[USB_TX_BUFFER_SIZE];
+static CircularBuffer g_usb_rx_buffer;
+static CircularBuffer g_usb_tx_buffer;
+static USB_Handle *g_usb = nullptr;
+static uint8_t g_usb_pattern[USB_PATTERN_SIZE];
+static bool volatile g_host_open = false;
+static bool g_usb_measured = false;
+static bool g_ready = false; // Boot benchmarks have been reported
+
+/**
+ * @brief Add a run to timings, as PROFILE_end does for zones
+ */
+static void record(PROFILE_Stats *stats, uint32_t cycles)
+{
+    if (stats->count == 0 || cycles < stats->min) {
+        stats->min = cycles;
+    }
+    if (cycles > stats->max) {
+        stats->max = cycles;
+    }
+    stats->total += cycles;
+    stats->count++;
+}
+
+/**
+ * @brief Keep a result that report_results prints
+ */
+static void
+add_result(char const *name, PROFILE_Stats const *stats, uint32_t ops)
+{
+    if (g_result_count < RESULTS_MAX) {
+        g_results[g_result_count++] = (Result){
+            .name = name,
+            .stats = *stats,
+            .ops = ops,
+        };
+    }
+}
+
+/**
+ * @brief Time a micro-benchmark
+ *
+ * @param name Benchmark name
+ * @param run Performs ops operations
+ * @param ops Operations per run
+ * @param after Untimed cleanup after each run, or nullptr
+ */
+static void measure(
+    char const *name,
+    void (*run)(void),
+    uint32_t ops,
+    void (*after)(void)
+)
+{
+    PROFILE_Stats stats = { 0 };
+
+    run();
+    if (after) {
+        after();
+    }
+    for (uint32_t i = 0; i < BENCH_RUNS; ++i) {
+        uint32_t const start = PROFILE_begin();
+        run();
+        record(&stats, PROFILE_begin() - start);
+        if (after) {
+            after();
+        }
+    }
+    add_result(name, &stats, ops);
+}
+
+static void run_put_get(void)
+{
+    uint8_t byte = 0;
+    for (uint32_t i = 0; i < BENCH_BATCH; ++i) {
+        circular_buffer_put(&g_ring, (uint8_t)i);
+        circular_buffer_get(&g_ring, &byte);
+    }
+}
+
+static void run_write_read(void)
+{
+    for (uint32_t i = 0; i < BENCH_BATCH; ++i) {
+        circular_buffer_write(&g_ring, g_chunk, CHUNK_SIZE);
+        circular_buffer_read(&g_ring, g_chunk, CHUNK_SIZE);
+    }
+}
+
+static void run_ring_u16_write_read(void)
+{
+    for (uint32_t i = 0; i < BENCH_BATCH; ++i) {
+        ring_u16_write(&g_sample_ring, g_samples, SAMPLE_CHUNK);
+        ring_u16_read(&g_sample_ring, g_samples, SAMPLE_CHUNK);
+    }
+}
+
+static void run_log_write(void)
+{
+    for (uint32_t i = 0; i < LOG_BATCH; ++i) {
+        LOG_write(LOG_LEVEL_INFO, "ADC overrun on channel %u", (unsigned)i);
+    }
+}
+
+/**
+ * @brief Drop the messages written by run_log_write
+ */
+static void discard_log(void)
+{
+    while (LOG_read_lines(g_log_scratch, sizeof(g_log_scratch)) > 0) {
+    }
+}
+
+/**
+ * @brief Wait until LOG_task has passed all messages to the log UART
+ */
+static void flush_log(void)
+{
+    while (LOG_available() > 0) {
+        LOG_task(0xF);
+    }
+}
+
+static void run_micro_benchmarks(void)
+{
+    circular_buffer_init(&g_ring, g_ring_data, sizeof(g_ring_data));
+    for (uint32_t i = 0; i < CHUNK_SIZE; ++i) {
+        g_chunk[i] = (uint8_t)i;
+    }
+    measure("circular_buffer_put_get", run_put_get, BENCH_BATCH, nullptr);
+    measure(
+        "circular_buffer_write_read_64", run_write_read, BENCH_BATCH, nullptr
+    );
+    ring_u16_init(&g_sample_ring, g_sample_ring_data, RING_SIZE);
+    measure(
+        "ring_u16_write_read_32",
+        run_ring_u16_write_read,
+        BENCH_BATCH,
+        nullptr
+    );
+
+    // Keep the benchmark messages from the UART; boot messages still
+    // waiting for it are dropped with them
+    flush_log();
+    SYSTEM_set_log_sink(SYSTEM_LOG_SINK_QUERY);
+    discard_log();
+    measure("LOG_write", run_log_write, LOG_BATCH, discard_log);
+    SYSTEM_set_log_sink(SYSTEM_LOG_SINK_UART);
+}
+
+/**
+ * @brief DSO completion, called from the ADC DMA interrupt
+ */
+static void dso_complete(void)
+{
+    g_dso_done_cycles = PROFILE_begin();
+    g_dso_done = true;
+}
+
+/**
+ * @brief Scheduler task woken by the DSO event
+ */
+static void dso_event_task(void)
+{
+    if (g_dso_done && !g_dso_seen) {
+        record(&g_dso_latency, PROFILE_begin() - g_dso_done_cycles);
+        g_dso_seen = true;
+    }
+}
+
+/**
+ * @brief Wait for the acquisition to be seen by the DSO event task
+ *
+ * @throws ERROR_TIMEOUT if it does not complete
+ */
+static void wait_for_dso(DSO_Handle *dso)
+{
+    uint32_t const start_tick = SYSTEM_get_tick();
+    while (!g_dso_seen && SYSTEM_get_tick() - start_tick < DSO_TIMEOUT) {
+        SCHEDULER_step();
+    }
+    DSO_stop(dso);
+    if (!g_dso_seen) {
+        THROW(ERROR_TIMEOUT);
+    }
+}
+
+/**
+ * @brief Time single-shot acquisitions at the maximum sample rate
+ *
+ * The main loop steps the scheduler while waiting, so the latency is that
+ * of an awake core; a sleeping one adds its wake-up time.
+ */
+static void run_dso_benchmark(void)
+{
+    DSO_Config config = DSO_CONFIG_DEFAULT;
+    config.sample_rate =
+        DSO_get_max_sample_rate(DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT);
+    config.buffer = g_dso_buffer;
+    config.buffer_size = DSO_SAMPLES;
+    config.complete_callback = dso_complete;
+
+    PROFILE_Stats acquisition = { 0 };
+    PROFILE_Stats arm = { 0 };
+    // Read after CATCH, so kept out of registers
+    DSO_Handle *volatile dso = nullptr;
+    Error err = ERROR_NONE;
+
+    TRY
+    {
+        dso = DSO_init(&config);
+        PROFILE_clear();
+
+        for (uint32_t i = 0; i < DSO_RUNS; ++i) {
+            g_dso_done = false;
+            g_dso_seen = false;
+            uint32_t const start = PROFILE_begin();
+            DSO_start(dso);
+            wait_for_dso(dso);
+            record(&acquisition, g_dso_done_cycles - start);
+
+            // The same acquisition, staged ahead
+            g_dso_done = false;
+            g_dso_seen = false;
+            DSO_prepare(dso);
+            uint32_t const arm_start = PROFILE_begin();
+            DSO_start(dso);
+            record(&arm, PROFILE_begin() - arm_start);
+            wait_for_dso(dso);
+        }
+    }
+    CATCH(err)
+    {
+        LOG_write(LOG_LEVEL_ERROR, "bench dso failed: 0x%08X", err);
+    }
+    if (dso) {
+        DSO_deinit(dso);
+    }
+    if (err != ERROR_NONE) {
+        return;
+    }
+
+    PROFILE_Stats const isr = PROFILE_get(PROFILE_ZONE_DSO_ISR);
+    add_result("dso_adc_dma_4096", &acquisition, DSO_SAMPLES);
+    add_result("dso_isr", &isr, 1);
+    add_result("dso_event_to_task", &g_dso_latency, 1);
+    add_result("dso_start_prepared", &arm, 1);
+    LOG_write(
+        LOG_LEVEL_INFO,
+        "bench dso sample rate %u Hz",
+        (unsigned)config.sample_rate
+    );
+}
+
+/**
+ * @brief Print the kept results on the log UART
+ *
+ * Times are per operation, with mean and nanoseconds rounded down.
+ */
+static void report_results(void)
+{
+    uint32_t const frequency = PROFILE_get_frequency();
+
+    LOG_write(
+        LOG_LEVEL_INFO, "bench core clock %u Hz", (unsigned)frequency
+    );
+    flush_log();
+    for (uint32_t i = 0; i < g_result_count; ++i) {
+        Result const *result = &g_results[i];
+        PROFILE_Stats const *stats = &result->stats;
+        uint64_t const ops = (uint64_t)stats->count * result->ops;
+        uint64_t const mean_x100 = ops ? (stats->total * 100U) / ops : 0;
+        uint64_t const mean_ns =
+            (stats->total * 1000000000U) / ((ops ? ops : 1) * frequency);
+        LOG_write(
+            LOG_LEVEL_INFO,
+            "bench %s: min %u mean %u.%02u max %u cycles/op, %u ns/op",
+            result->name,
+            (unsigned)(stats->min / result->ops),
+            (unsigned)(mean_x100 / 100U),
+            (unsigned)(mean_x100 % 100U),
+            (unsigned)(stats->max / result->ops),
+            (unsigned)mean_ns
+        );
+        flush_log();
+    }
+}
+
+static void line_state_callback(USB_Handle *handle, bool dtr, bool rts)
+{
+    (void)handle;
+    (void)rts;
+    g_host_open = dtr;
+}
+
+/**
+ * @brief Send USB_BYTES to the host as fast as it reads them
+ */
+static void run_usb_benchmark(void)
+{
+    uint32_t sent = 0;
+    uint32_t const start_tick = SYSTEM_get_tick();
+    uint64_t const start_us = SYSTEM_get_time_us64();
+
+    while (sent < USB_BYTES && g_host_open &&
+           SYSTEM_get_tick() - start_tick < USB_TIMEOUT) {
+        uint32_t const offset = sent % USB_PATTERN_SIZE;
+        uint32_t const remaining = USB_BYTES - sent;
+        uint32_t const len = USB_PATTERN_SIZE - offset < remaining
+                                 ? USB_PATTERN_SIZE - offset
+                                 : remaining;
+        sent += USB_write(g_usb, &g_usb_pattern[offset], len);
+        USB_task(g_usb);
+    }
+    USB_flush(g_usb);
+    while (USB_tx_busy(g_usb) && g_host_open &&
+           SYSTEM_get_tick() - start_tick < USB_TIMEOUT) {
+        USB_task(g_usb);
+    }
+
+    uint64_t const elapsed_us = SYSTEM_get_time_us64() - start_us;
+    LOG_write(
+        LOG_LEVEL_INFO,
+        "bench usb_write: %u bytes in %u us, %u bytes/s",
+        (unsigned)sent,
+        (unsigned)elapsed_us,
+        (unsigned)((sent * 1000000ULL) / (elapsed_us ? elapsed_us : 1))
+    );
+}
+
+static void usb_task(void)
+{
+    USB_task(g_usb);
+
+    // Input is not used
+    uint8_t discard[64];
+    while (USB_read(g_usb, discard, sizeof(discard)) > 0) {
+    }
+
+    if (!g_host_open) {
+        // Measure again the next time the port is opened
+        g_usb_measured = false;
+    } else if (g_ready && !g_usb_measured) {
+        g_usb_measured = true;
+        run_usb_benchmark();
+    }
+}
+
+static void run_log(void) { LOG_task(0xF); }
+
+static void blink(void) { LED_toggle(LED_YELLOW); }
+
+int main(void)
+{
+    SYSTEM_init();
+    SYSTEM_init_deferred();
+    LOG_write(LOG_LEVEL_INFO, "Benchmark firmware");
+    // Results are only comparable at the clock that instruments run at
+    CLOCK_request();
+
+    // Printable lines, so that a terminal can show the data
+    for (uint32_t i = 0; i < USB_PATTERN_SIZE; ++i) {
+        g_usb_pattern[i] = (i % 64) == 63 ? '\n' : (uint8_t)('A' + (i % 26));
+    }
+    circular_buffer_init(
+        &g_usb_rx_buffer, g_usb_rx_data, sizeof(g_usb_rx_data)
+    );
+    circular_buffer_init(
+        &g_usb_tx_buffer, g_usb_tx_data, sizeof(g_usb_tx_data)
+    );
+    g_usb =
+        USB_init(USB_INTERFACE_CDC, &g_usb_rx_buffer, &g_usb_tx_buffer);
+    USB_set_line_state_callback(g_usb, line_state_callback);
+    // Only full packets while the benchmark keeps the TX buffer filled
+    USB_set_flush_policy(g_usb, USB_FLUSH_FULL_PACKETS, 0);
+
+    SCHEDULER_init();
+    SCHEDULER_add(&(SCHEDULER_Task){
+        .function = dso_event_task,
+        .events = SCHEDULER_EVENT_DSO,
+        .priority = 0,
+    });
+    SCHEDULER_add(&(SCHEDULER_Task){
+        .function = usb_task,
+        .period = USB_PERIOD,
+        .events = SCHEDULER_EVENT_USB_RX,
+        .priority = 1,
+    });
+    SCHEDULER_add(&(SCHEDULER_Task){
+        .function = run_log,
+        .period = LOG_PERIOD,
+        .priority = 2,
+    });
+    SCHEDULER_add(&(SCHEDULER_Task){
+        .function = blink,
+        .period = BLINK_PERIOD,
+        .priority = 3,
+    });
+
+    run_micro_benchmarks();
+    run_dso_benchmark();
+    report_results();
+    g_ready = true;
+
+    SCHEDULER_run();
+}
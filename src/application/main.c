@@ -1,35 +1,105 @@
+#include <stdbool.h>
 
 #include "protocol.h"
+#include "system/datalog.h"
 #include "system/led.h"
+#include "system/profile.h"
+#include "system/scheduler.h"
+#include "system/sweep.h"
+#include "system/syscalls.h"
 #include "system/system.h"
+#include "system/trace.h"
 #include "util/error.h"
 #include "util/logging.h"
 
+enum {
+    PROTOCOL_PERIOD = 1, // ms, as a fallback to the USB and DSO events
+    DATALOG_PERIOD = 1, // ms
+    SWEEP_PERIOD = 1, // ms
+    LOG_PERIOD = 10, // ms
+    STDOUT_PERIOD = 10, // ms, longest fully buffered stdout output waits
+    REFERENCE_PERIOD = 100, // ms, a VREFINT conversion every other call
+    BLINK_PERIOD = 1000, // ms
+};
+
+static void run_protocol(void)
+{
+    PROFILE_BEGIN(PROFILE_ZONE_PROTOCOL);
+    TRACE_record(TRACE_EVENT_PROTOCOL_BEGIN, 0);
+    protocol_task();
+    TRACE_record(TRACE_EVENT_PROTOCOL_END, 0);
+    PROFILE_END(PROFILE_ZONE_PROTOCOL);
+}
+
+static void run_log(void)
+{
+    PROFILE_BEGIN(PROFILE_ZONE_LOG);
+    TRACE_record(TRACE_EVENT_LOG_BEGIN, 0);
+    LOG_task(0xF);
+    TRACE_record(TRACE_EVENT_LOG_END, 0);
+    PROFILE_END(PROFILE_ZONE_LOG);
+}
+
+static void blink(void) { LED_toggle(LED_YELLOW); }
+
 int main(void)
 {
     SYSTEM_init();
+
+    // USB first, so the host enumerates while the rest comes up
+    bool const protocol_ready = protocol_init();
+    PROFILE_boot_mark(PROFILE_BOOT_USB);
+    SYSTEM_init_deferred();
     LOG_INIT("Main application");
 
-    // Initialize the protocol
-    if (!protocol_init()) {
+    if (!protocol_ready) {
         LOG_ERROR("Failed to initialize protocol");
         return -1;
     }
 
-    // Main application loop
-    while (1) {
-        // Process protocol tasks
-        protocol_task();
-
-        LOG_task(0xF);
-
-        static uint32_t last_toggle = 0;
-        uint32_t const blink_period = 1000; // 1 second
-        if (SYSTEM_get_tick() - last_toggle >= blink_period) {
-            LED_toggle(LED_YELLOW);
-            last_toggle = SYSTEM_get_tick();
-        }
-    }
+    SCHEDULER_init();
+    SCHEDULER_add(&(SCHEDULER_Task){
+        .function = run_protocol,
+        .period = PROTOCOL_PERIOD,
+        .events = SCHEDULER_EVENT_USB_RX | SCHEDULER_EVENT_DSO,
+        .priority = 0,
+    });
+    // Returns at once unless the data logger is in use
+    SCHEDULER_add(&(SCHEDULER_Task){
+        .function = DATALOG_task,
+        .period = DATALOG_PERIOD,
+        .priority = 1,
+    });
+    // Returns at once unless a frequency response sweep is running
+    SCHEDULER_add(&(SCHEDULER_Task){
+        .function = SWEEP_task,
+        .period = SWEEP_PERIOD,
+        .priority = 1,
+    });
+    SCHEDULER_add(&(SCHEDULER_Task){
+        .function = run_log,
+        .period = LOG_PERIOD,
+        .priority = 1,
+    });
+    // Writes out fully buffered printf output
+    SCHEDULER_add(&(SCHEDULER_Task){
+        .function = syscalls_task,
+        .period = STDOUT_PERIOD,
+        .priority = 1,
+    });
+    // Follows supply drift between captures
+    SCHEDULER_add(&(SCHEDULER_Task){
+        .function = SYSTEM_track_reference,
+        .period = REFERENCE_PERIOD,
+        .priority = 2,
+    });
+    SCHEDULER_add(&(SCHEDULER_Task){
+        .function = blink,
+        .period = BLINK_PERIOD,
+        .priority = 2,
+    });
 
-    __builtin_unreachable();
+    // Main application loop
+    PROFILE_boot_mark(PROFILE_BOOT_READY);
+    SCHEDULER_run();
 }
@@ -0,0 +1,452 @@
+/**
+ * @file binary.c
+ * @brief Binary command protocol
+ *
+ * A compact alternative to SCPI for high-rate automation, served on the USB
+ * bulk data interface once SYSTem:COMMunicate:BINary ON has enabled it. It
+ * uses neither text parsing nor number formatting, and the host may send
+ * many requests without waiting for each response; responses come in
+ * request order.
+ *
+ * All fields are little-endian. A request is
+ *
+ *     0xB5 | opcode | tag | length (2) | payload | CRC (2)
+ *
+ * and its response is
+ *
+ *     0xB5 | opcode + 0x80 | tag | status | length (4) | payload | CRC (2)
+ *
+ * where tag is copied from the request, status is an Error code from
+ * util/error.h, ERROR_NONE on success, and the CRC is the CRC-16 of
+ * util/crc.h over all preceding bytes but the first. Requests carry up to
+ * 64 payload bytes. Bytes that do not start a valid request are skipped,
+ * so a corrupted request gets no response.
+ *
+ * Opcodes:
+ * - 0x00 PING: answers with the request payload
+ * - 0x01 DMM READ: payload is the DMM_Channel as one byte; answers with the
+ *   voltage in volts as a Q16.16 fixed-point number
+ * - 0x10 DSO INITIATE: starts a capture with the settings made with SCPI
+ * - 0x11 DSO FETCH: answers with the raw 16-bit samples of the completed
+ *   capture, or ERROR_RESOURCE_BUSY while it is still running; the CRC
+ *   unit checksums the samples while they are being sent
+ *
+ * Requests wait while an oscilloscope stream uses the bulk interface.
+ * The protocol cannot be enabled while SYSTem:TEST:USB runs on it.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lib/scpi/error.h"
+#include "lib/scpi/scpi.h"
+
+#include "system/checksum.h"
+#include "system/instrument/dmm.h"
+#include "system/system.h"
+#include "util/crc.h"
+#include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/si_prefix.h"
+
+enum {
+    BINARY_SYNC = 0xB5,
+    BINARY_RESPONSE = 0x80, // Set in the opcode of a response
+    REQUEST_HEADER_SIZE = 5, // Sync, opcode, tag, 16-bit payload length
+    RESPONSE_HEADER_SIZE = 8, // Sync, opcode, tag, status, 32-bit length
+    CRC_SIZE = 2,
+    PAYLOAD_MAX = 64, // Longest request and short response payload
+    REQUEST_SIZE_MAX = REQUEST_HEADER_SIZE + PAYLOAD_MAX + CRC_SIZE,
+    RESPONSE_SIZE_MAX = RESPONSE_HEADER_SIZE + PAYLOAD_MAX + CRC_SIZE,
+    DMM_READ_TIMEOUT = SI_MILLI_DIV, // 1 second, in ticks
+};
+
+typedef enum {
+    OPCODE_PING = 0x00,
+    OPCODE_DMM_READ = 0x01,
+    OPCODE_DSO_INITIATE = 0x10,
+    OPCODE_DSO_FETCH = 0x11,
+} Opcode;
+
+// Bulk interface access, implemented in common.c
+extern bool protocol_bulk_open(void);
+extern uint32_t protocol_read_bulk(uint8_t *data, uint32_t len);
+extern uint32_t protocol_write_bulk(uint8_t const *data, uint32_t len);
+extern uint32_t protocol_bulk_tx_free(void);
+extern bool protocol_write_bulk_buffer(uint8_t const *data, uint32_t len);
+extern bool protocol_bulk_tx_pending(void);
+
+// Oscilloscope access, implemented in dso.c
+extern Error dso_capture_start(void);
+extern Error dso_capture_data(uint16_t const **samples, uint32_t *count);
+extern bool dso_stream_on_bulk(void);
+
+// Link test access, implemented in linktest.c
+extern bool linktest_running(void);
+
+// Binary protocol state (internal to this module)
+static struct {
+    bool enabled;
+    bool block_pending; // DSO FETCH samples are sent in place
+    bool trailer_pending; // Their CRC, once computed, is still to be sent
+    CHECKSUM_Job checksum;
+    uint32_t rx_len;
+    uint8_t rx[REQUEST_SIZE_MAX];
+} g_binary = { .enabled = false, .block_pending = false, .rx_len = 0 };
+
+/**
+ * @brief Check whether the binary protocol is served
+ */
+bool binary_is_enabled(void) { return g_binary.enabled; }
+
+/**
+ * @brief Reset binary protocol state, the bulk interface is closed
+ */
+void binary_reset_state(void)
+{
+    g_binary.enabled = false;
+    g_binary.block_pending = false;
+    if (g_binary.trailer_pending) {
+        CHECKSUM_cancel(&g_binary.checksum);
+        g_binary.trailer_pending = false;
+    }
+    g_binary.rx_len = 0;
+}
+
+static void put_le16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void put_le32(uint8_t *out, uint32_t value)
+{
+    put_le16(out, (uint16_t)value);
+    put_le16(out + 2, (uint16_t)(value >> 16));
+}
+
+static uint16_t get_le16(uint8_t const *in)
+{
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+/**
+ * @brief Drop bytes from the start of the receive buffer
+ */
+static void discard_rx(uint32_t len)
+{
+    g_binary.rx_len -= len;
+    memmove(g_binary.rx, g_binary.rx + len, g_binary.rx_len);
+}
+
+/**
+ * @brief Find the next valid request in the receive buffer
+ *
+ * Skips bytes up to the start of a request with a valid length and CRC.
+ *
+ * @return Size of the request at the start of the buffer, or 0 if there is
+ *         no complete request yet
+ */
+static uint32_t next_request(void)
+{
+    while (g_binary.rx_len > 0) {
+        if (g_binary.rx[0] != BINARY_SYNC) {
+            discard_rx(1);
+            continue;
+        }
+        if (g_binary.rx_len < REQUEST_HEADER_SIZE) {
+            return 0;
+        }
+
+        uint32_t const payload_len = get_le16(&g_binary.rx[3]);
+        if (payload_len > PAYLOAD_MAX) {
+            discard_rx(1);
+            continue;
+        }
+        uint32_t const size = REQUEST_HEADER_SIZE + payload_len + CRC_SIZE;
+        if (g_binary.rx_len < size) {
+            return 0;
+        }
+
+        uint16_t const crc = CRC16_update(
+            CRC16_INIT, &g_binary.rx[1], size - CRC_SIZE - 1
+        );
+        if (crc != get_le16(&g_binary.rx[size - CRC_SIZE])) {
+            discard_rx(1);
+            continue;
+        }
+        return size;
+    }
+    return 0;
+}
+
+/**
+ * @brief Fill in a response header
+ *
+ * @return CRC over the header, to be continued over the payload
+ */
+static uint16_t response_header(
+    uint8_t *out,
+    uint8_t opcode,
+    uint8_t tag,
+    Error status,
+    uint32_t payload_len
+)
+{
+    out[0] = BINARY_SYNC;
+    out[1] = opcode | BINARY_RESPONSE;
+    out[2] = tag;
+    out[3] = (uint8_t)status;
+    put_le32(&out[4], payload_len);
+    return CRC16_update(CRC16_INIT, &out[1], RESPONSE_HEADER_SIZE - 1);
+}
+
+/**
+ * @brief Send a response with a short payload
+ *
+ * The caller has made sure the bulk TX buffer holds RESPONSE_SIZE_MAX.
+ */
+static void send_response(
+    uint8_t opcode,
+    uint8_t tag,
+    Error status,
+    uint8_t const *payload,
+    uint32_t payload_len
+)
+{
+    uint8_t frame[RESPONSE_SIZE_MAX];
+    uint16_t crc = response_header(frame, opcode, tag, status, payload_len);
+
+    memcpy(&frame[RESPONSE_HEADER_SIZE], payload, payload_len);
+    crc = CRC16_update(crc, payload, payload_len);
+    put_le16(&frame[RESPONSE_HEADER_SIZE + payload_len], crc);
+    protocol_write_bulk(
+        frame, RESPONSE_HEADER_SIZE + payload_len + CRC_SIZE
+    );
+}
+
+/**
+ * @brief Send a response whose payload is sent in place
+ *
+ * The CRC follows with send_trailer, once the CRC unit has gone through
+ * the payload.
+ *
+ * @return false if another buffer is still queued, nothing was sent
+ */
+static bool send_block_response(
+    uint8_t opcode,
+    uint8_t tag,
+    uint8_t const *payload,
+    uint32_t payload_len
+)
+{
+    if (protocol_bulk_tx_pending()) {
+        return false;
+    }
+
+    uint8_t header[RESPONSE_HEADER_SIZE];
+    CHECKSUM_start(
+        &g_binary.checksum,
+        CHECKSUM_CRC16,
+        response_header(header, opcode, tag, ERROR_NONE, payload_len),
+        payload,
+        payload_len
+    );
+
+    protocol_write_bulk(header, sizeof(header));
+    protocol_write_bulk_buffer(payload, payload_len);
+    g_binary.trailer_pending = true;
+    g_binary.block_pending = true;
+    return true;
+}
+
+/**
+ * @brief Send the CRC of a payload sent in place, once computed
+ *
+ * @return false while the CRC unit is still at it
+ */
+static bool send_trailer(void)
+{
+    uint32_t crc = 0;
+    if (!CHECKSUM_result(&g_binary.checksum, &crc)) {
+        return false;
+    }
+
+    // Data written after the queued buffer is sent after it
+    uint8_t trailer[CRC_SIZE];
+    put_le16(trailer, (uint16_t)crc);
+    protocol_write_bulk(trailer, sizeof(trailer));
+    g_binary.trailer_pending = false;
+    return true;
+}
+
+/**
+ * @brief DMM READ: single reading of a channel with default settings
+ */
+static Error dmm_read(uint8_t const *payload, uint32_t len, uint8_t *out)
+{
+    if (len != 1) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    config.channel = (DMM_Channel)payload[0];
+
+    Error err = ERROR_NONE;
+    DMM_Handle *handle = nullptr;
+    TRY { handle = DMM_init(&config); }
+    CATCH(err) { return err; }
+
+    FIXED_Q1616 voltage = 0;
+    uint32_t const start_time = SYSTEM_get_tick();
+    bool ready = false;
+    while (err == ERROR_NONE && !ready) {
+        err = DMM_try_read_voltage(handle, &voltage, &ready);
+        if (!ready && SYSTEM_get_tick() - start_time > DMM_READ_TIMEOUT) {
+            err = ERROR_TIMEOUT;
+        }
+    }
+    DMM_deinit(handle);
+
+    put_le32(out, (uint32_t)voltage);
+    return err;
+}
+
+/**
+ * @brief Execute one request and send its response
+ */
+static void execute(
+    uint8_t opcode,
+    uint8_t tag,
+    uint8_t const *payload,
+    uint32_t len
+)
+{
+    uint8_t out[PAYLOAD_MAX];
+    uint32_t out_len = 0;
+    Error status = ERROR_NONE;
+
+    switch (opcode) {
+    case OPCODE_PING:
+        memcpy(out, payload, len);
+        out_len = len;
+        break;
+    case OPCODE_DMM_READ:
+        status = dmm_read(payload, len, out);
+        out_len = status == ERROR_NONE ? sizeof(FIXED_Q1616) : 0;
+        break;
+    case OPCODE_DSO_INITIATE:
+        status = len == 0 ? dso_capture_start() : ERROR_INVALID_ARGUMENT;
+        break;
+    case OPCODE_DSO_FETCH: {
+        uint16_t const *samples = nullptr;
+        uint32_t count = 0;
+        status = len == 0 ? dso_capture_data(&samples, &count)
+                          : ERROR_INVALID_ARGUMENT;
+        if (status == ERROR_NONE &&
+            send_block_response(
+                opcode,
+                tag,
+                (uint8_t const *)samples,
+                count * sizeof(uint16_t)
+            )) {
+            return;
+        }
+        if (status == ERROR_NONE) {
+            status = ERROR_RESOURCE_BUSY;
+        }
+        break;
+    }
+    default:
+        status = ERROR_INVALID_ARGUMENT;
+        break;
+    }
+
+    send_response(opcode, tag, status, out, out_len);
+}
+
+/**
+ * @brief Serve binary requests, called from protocol_task
+ */
+void binary_task(void)
+{
+    if (!g_binary.enabled || dso_stream_on_bulk()) {
+        return;
+    }
+
+    // Hold further responses until a capture has been sent
+    if (g_binary.trailer_pending && !send_trailer()) {
+        return;
+    }
+    if (g_binary.block_pending) {
+        g_binary.block_pending = protocol_bulk_tx_pending();
+        if (g_binary.block_pending) {
+            return;
+        }
+    }
+
+    g_binary.rx_len += protocol_read_bulk(
+        g_binary.rx + g_binary.rx_len, sizeof(g_binary.rx) - g_binary.rx_len
+    );
+
+    // Pipelined requests are answered in one pass, as TX space allows
+    uint32_t size = 0;
+    while (!g_binary.block_pending &&
+           protocol_bulk_tx_free() >= RESPONSE_SIZE_MAX &&
+           (size = next_request()) > 0) {
+        execute(
+            g_binary.rx[1],
+            g_binary.rx[2],
+            &g_binary.rx[REQUEST_HEADER_SIZE],
+            size - REQUEST_HEADER_SIZE - CRC_SIZE
+        );
+        discard_rx(size);
+
+        // Make room for the next requests
+        g_binary.rx_len += protocol_read_bulk(
+            g_binary.rx + g_binary.rx_len,
+            sizeof(g_binary.rx) - g_binary.rx_len
+        );
+    }
+}
+
+/**
+ * @brief SYSTem:COMMunicate:BINary - Enable or disable the binary protocol
+ *
+ * Enabling opens the USB bulk interface, on which the protocol is served.
+ * Fails while SYSTem:TEST:USB runs on the interface.
+ */
+scpi_result_t scpi_cmd_system_communicate_binary(scpi_t *context)
+{
+    scpi_bool_t enable = false;
+
+    if (!SCPI_ParamBool(context, &enable, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (enable && (linktest_running() || !protocol_bulk_open())) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    if (enable && !g_binary.enabled) {
+        g_binary.rx_len = 0;
+    }
+    if (!enable && g_binary.trailer_pending) {
+        // A capture cut short leaves the CRC unit to others
+        CHECKSUM_cancel(&g_binary.checksum);
+        g_binary.trailer_pending = false;
+    }
+    g_binary.enabled = enable;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:COMMunicate:BINary? - Query whether the binary protocol runs
+ */
+scpi_result_t scpi_cmd_system_communicate_binary_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_binary.enabled);
+    return SCPI_RES_OK;
+}
@@ -4,35 +4,138 @@
  *
  * This module implements the common SCPI protocol infrastructure including
  * USB communication, SCPI context management, and IEEE 488.2 commands.
+ *
+ * Each host talks to its own SCPI session: the SCPI port is session 0, and
+ * further sessions can be opened on the USB bridge port and on UART buses.
+ * One parser serves them in turn, a line at a time, see select_session.
  */
 
 #include "protocol.h"
 
+#include <assert.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "lib/scpi/error.h"
 #include "lib/scpi/scpi.h"
 
+#include "system/bus/bridge.h"
+#include "system/bus/loopback.h"
+#include "system/bus/uart.h"
 #include "system/bus/usb.h"
+#include "system/profile.h"
 #include "system/system.h"
+#include "system/trace.h"
+#include "system/update.h"
+#include "util/arena.h"
 #include "util/error.h"
+#include "util/format.h"
+#include "util/logging.h"
 #include "util/util.h"
 
+// Buffer sizes, set together by the PSLAB_PROFILE build option
+#ifndef PSLAB_USB_RX_BUFFER_SIZE
+#define PSLAB_USB_RX_BUFFER_SIZE 512
+#endif
+#ifndef PSLAB_USB_TX_BUFFER_SIZE
+#define PSLAB_USB_TX_BUFFER_SIZE 512
+#endif
+#ifndef PSLAB_USB_BULK_TX_BUFFER_SIZE
+#define PSLAB_USB_BULK_TX_BUFFER_SIZE 4096
+#endif
+#ifndef PSLAB_SCPI_INPUT_BUFFER_SIZE
+#define PSLAB_SCPI_INPUT_BUFFER_SIZE 256
+#endif
+#ifndef PSLAB_SCPI_SESSIONS
+#define PSLAB_SCPI_SESSIONS 3
+#endif
+
 // Buffer sizes for USB communication (internal to this module)
 enum {
-    USB_RX_BUFFER_SIZE = 512,
-    USB_TX_BUFFER_SIZE = 512,
-    SCPI_INPUT_BUFFER_SIZE = 256,
-    SCPI_ERROR_QUEUE_SIZE = 16
+    USB_RX_BUFFER_SIZE = PSLAB_USB_RX_BUFFER_SIZE,
+    USB_TX_BUFFER_SIZE = PSLAB_USB_TX_BUFFER_SIZE,
+    USB_BULK_RX_BUFFER_SIZE = 64,
+    USB_BULK_TX_BUFFER_SIZE = PSLAB_USB_BULK_TX_BUFFER_SIZE,
+    // The isochronous interface receives nothing, and its data is sent in
+    // place; the TX buffer only carries block headers
+    USB_ISO_RX_BUFFER_SIZE = 16,
+    USB_ISO_TX_BUFFER_SIZE = 256,
+    SCPI_INPUT_BUFFER_SIZE = PSLAB_SCPI_INPUT_BUFFER_SIZE,
+    SCPI_ERROR_QUEUE_SIZE = 16,
+    PROFILE_VALUES = 4, // Values per zone from SYSTem:PROFile?
+    LOG_QUERY_BUFFER_SIZE = 512, // Lines per SYSTem:LOG? block
+    TRACE_QUERY_RECORDS = 128, // Records per SYSTem:TRACe? block
+    RESULT_ASCII_BUFFER_SIZE = 128, // Formatted values written at a time
+    USB_READ_SIZE = 64, // Bytes read from the USB RX buffer at a time
+    PENDING_OPERATIONS_MAX = 8, // See protocol_operation_pending
+    SESSIONS_MAX = PSLAB_SCPI_SESSIONS, // The SCPI port and the others
+    SESSION_WRITE_TIMEOUT = 1000, // ms a UART response waits for space
 };
 
+static_assert(
+    CIRCULAR_BUFFER_SIZE_VALID(USB_RX_BUFFER_SIZE),
+    "USB_RX_BUFFER_SIZE must be a power of 2"
+);
+static_assert(
+    CIRCULAR_BUFFER_SIZE_VALID(USB_TX_BUFFER_SIZE),
+    "USB_TX_BUFFER_SIZE must be a power of 2"
+);
+static_assert(
+    CIRCULAR_BUFFER_SIZE_VALID(USB_BULK_TX_BUFFER_SIZE),
+    "USB_BULK_TX_BUFFER_SIZE must be a power of 2"
+);
+static_assert(
+    LOG_QUERY_BUFFER_SIZE >= LOG_LINE_SIZE_MAX,
+    "LOG_QUERY_BUFFER_SIZE must hold one full log line"
+);
+static_assert(SESSIONS_MAX >= 1, "PSLAB_SCPI_SESSIONS must be at least 1");
+// The input buffer is linear, but must hold one full command line
+static_assert(
+    SCPI_INPUT_BUFFER_SIZE >= 128, "SCPI_INPUT_BUFFER_SIZE is too small"
+);
+
 // Forward declarations of DMM functions needed by common
 extern scpi_result_t scpi_cmd_configure_voltage_dc(scpi_t *context);
+extern scpi_result_t scpi_cmd_configure_average(scpi_t *context);
+extern scpi_result_t scpi_cmd_configure_average_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_configure_nplc(scpi_t *context);
+extern scpi_result_t scpi_cmd_configure_nplc_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_configure_line_frequency(scpi_t *context);
+extern scpi_result_t scpi_cmd_configure_line_frequency_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_format_data(scpi_t *context);
+extern scpi_result_t scpi_cmd_format_data_q(scpi_t *context);
 extern scpi_result_t scpi_cmd_initiate_voltage_dc(scpi_t *context);
+extern scpi_result_t scpi_cmd_initiate_continuous(scpi_t *context);
+extern scpi_result_t scpi_cmd_initiate_continuous_q(scpi_t *context);
 extern scpi_result_t scpi_cmd_fetch_voltage_dc(scpi_t *context);
+extern scpi_result_t scpi_cmd_fetch_statistics(scpi_t *context);
 extern scpi_result_t scpi_cmd_read_voltage_dc(scpi_t *context);
 extern scpi_result_t scpi_cmd_measure_voltage_dc(scpi_t *context);
+extern scpi_result_t scpi_cmd_scan_voltage_dc(scpi_t *context);
+extern scpi_result_t scpi_cmd_differential_voltage_dc(scpi_t *context);
+extern scpi_result_t scpi_cmd_read_array_voltage_dc(scpi_t *context);
+extern scpi_result_t scpi_cmd_read_converge_voltage_dc(scpi_t *context);
+extern scpi_result_t scpi_cmd_configure_voltage_ac(scpi_t *context);
+extern scpi_result_t scpi_cmd_read_voltage_ac(scpi_t *context);
+extern scpi_result_t scpi_cmd_measure_voltage_ac(scpi_t *context);
+extern scpi_result_t scpi_cmd_calibration_value(scpi_t *context);
+extern scpi_result_t scpi_cmd_calibration_value_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_calibration_store(scpi_t *context);
+extern scpi_result_t scpi_cmd_calibration_reset(scpi_t *context);
+extern scpi_result_t scpi_cmd_watch_limits(scpi_t *context);
+extern scpi_result_t scpi_cmd_watch_limits_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_watch_state(scpi_t *context);
+extern scpi_result_t scpi_cmd_watch_state_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_watch_event_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_count_level(scpi_t *context);
+extern scpi_result_t scpi_cmd_count_level_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_count_timestamps(scpi_t *context);
+extern scpi_result_t scpi_cmd_count_timestamps_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_count_state(scpi_t *context);
+extern scpi_result_t scpi_cmd_count_state_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_count_events_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_count_timestamps_data_q(scpi_t *context);
 extern void dmm_reset_state(void);
 
 // Forward declarations of DSO functions needed by common
@@ -41,76 +144,2299 @@ extern scpi_result_t scpi_cmd_configure_oscilloscope_channel_q(scpi_t *context);
 extern scpi_result_t scpi_cmd_configure_oscilloscope_timebase(scpi_t *context);
 extern scpi_result_t scpi_cmd_configure_oscilloscope_timebase_q(scpi_t *context
 );
+extern scpi_result_t scpi_cmd_configure_oscilloscope_apply(scpi_t *context);
+extern scpi_result_t scpi_cmd_save_setup(scpi_t *context);
+extern scpi_result_t scpi_cmd_recall_setup(scpi_t *context);
 extern scpi_result_t scpi_cmd_configure_oscilloscope_acquire_points(
     scpi_t *context
 );
 extern scpi_result_t scpi_cmd_configure_oscilloscope_acquire_points_q(
     scpi_t *context
 );
+extern scpi_result_t scpi_cmd_configure_oscilloscope_acquire_points_max_q(
+    scpi_t *context
+);
 extern scpi_result_t scpi_cmd_configure_oscilloscope_acquire_srate_q(
     scpi_t *context
 );
+extern scpi_result_t scpi_cmd_configure_oscilloscope_acquire_stime_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_configure_oscilloscope_acquire_type(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_configure_oscilloscope_acquire_type_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_configure_oscilloscope_acquire_decimation_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_configure_oscilloscope_acquire_resolution(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_configure_oscilloscope_acquire_resolution_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_configure_oscilloscope_acquire_records(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_configure_oscilloscope_acquire_records_q(
+    scpi_t *context
+);
 extern scpi_result_t scpi_cmd_initiate_oscilloscope(scpi_t *context);
 extern scpi_result_t scpi_cmd_fetch_oscilloscope_data_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_fetch_oscilloscope_etime_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_fetch_oscilloscope_new_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_fetch_oscilloscope_histogram_q(scpi_t *context
+);
+extern scpi_result_t scpi_cmd_fetch_oscilloscope_mask_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_mask_oscilloscope_data(scpi_t *context);
+extern scpi_result_t scpi_cmd_mask_oscilloscope_state(scpi_t *context);
+extern scpi_result_t scpi_cmd_mask_oscilloscope_state_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_fetch_oscilloscope_measure_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_fetch_oscilloscope_spectrum_q(scpi_t *context);
+extern scpi_result_t
+scpi_cmd_fetch_oscilloscope_spectrum_peaks_q(scpi_t *context);
+extern scpi_result_t
+scpi_cmd_fetch_oscilloscope_spectrum_distortion_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_format_oscilloscope_data(scpi_t *context);
+extern scpi_result_t scpi_cmd_format_oscilloscope_data_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_format_oscilloscope_header(scpi_t *context);
+extern scpi_result_t scpi_cmd_format_oscilloscope_header_q(scpi_t *context);
+extern scpi_result_t
+scpi_cmd_calibration_oscilloscope_interleave(scpi_t *context);
+extern scpi_result_t
+scpi_cmd_calibration_oscilloscope_interleave_q(scpi_t *context);
+extern scpi_result_t
+scpi_cmd_calibration_oscilloscope_interleave_reset(scpi_t *context);
 extern scpi_result_t scpi_cmd_read_oscilloscope_q(scpi_t *context);
 extern scpi_result_t scpi_cmd_measure_oscilloscope_q(scpi_t *context);
 extern scpi_result_t scpi_cmd_abort_oscilloscope(scpi_t *context);
+extern scpi_result_t scpi_cmd_autoset_oscilloscope(scpi_t *context);
 extern scpi_result_t scpi_cmd_status_oscilloscope_acquisition_q(scpi_t *context
 );
+extern scpi_result_t scpi_cmd_status_oscilloscope_integrity_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_start(scpi_t *context);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_stop(scpi_t *context);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_overruns_q(scpi_t *context
+);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_interface(scpi_t *context);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_interface_q(scpi_t *context
+);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_decimation_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_decimation_auto(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_decimation_auto_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_math(scpi_t *context);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_math_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_math_gain(scpi_t *context);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_math_gain_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_math_only(scpi_t *context);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_math_only_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_record(scpi_t *context);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_record_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_record_rate_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_stream_oscilloscope_record_statistics_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_roll_oscilloscope_start(scpi_t *context);
+extern scpi_result_t scpi_cmd_roll_oscilloscope_stop(scpi_t *context);
+extern scpi_result_t scpi_cmd_roll_oscilloscope_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_roll_oscilloscope_skipped_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_histogram_oscilloscope_range(scpi_t *context);
+extern scpi_result_t scpi_cmd_histogram_oscilloscope_range_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_histogram_oscilloscope_start(scpi_t *context);
+extern scpi_result_t scpi_cmd_histogram_oscilloscope_stop(scpi_t *context);
+extern scpi_result_t scpi_cmd_histogram_oscilloscope_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_histogram_oscilloscope_count_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_trigger_oscilloscope_mode(scpi_t *context);
+extern scpi_result_t scpi_cmd_trigger_oscilloscope_mode_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_trigger_oscilloscope_level(scpi_t *context);
+extern scpi_result_t scpi_cmd_trigger_oscilloscope_level_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_trigger_oscilloscope_pretrigger(scpi_t *context
+);
+extern scpi_result_t scpi_cmd_trigger_oscilloscope_pretrigger_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_trigger_oscilloscope_position_q(scpi_t *context
+);
+extern scpi_result_t scpi_cmd_segment_oscilloscope_count(scpi_t *context);
+extern scpi_result_t scpi_cmd_segment_oscilloscope_count_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_segment_oscilloscope_acquired_q(scpi_t *context
+);
+extern scpi_result_t scpi_cmd_segment_oscilloscope_timestamps_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_segment_oscilloscope_positions_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_average_oscilloscope_count(scpi_t *context);
+extern scpi_result_t scpi_cmd_average_oscilloscope_count_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_average_oscilloscope_acquired_q(
+    scpi_t *context
+);
 extern void dso_reset_state(void);
+extern Arena const *dso_sample_arena(void);
+extern void dso_stream_task(void);
+extern void dso_histogram_task(void);
+extern void dso_autoset_task(void);
+
+// Logic analyzer command handlers (implemented in la.c)
+extern scpi_result_t scpi_cmd_configure_la_acquire_srate(scpi_t *context);
+extern scpi_result_t scpi_cmd_configure_la_acquire_srate_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_configure_la_acquire_points(scpi_t *context);
+extern scpi_result_t scpi_cmd_configure_la_acquire_points_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_configure_la_acquire_points_max_q(
+    scpi_t *context
+);
+extern scpi_result_t scpi_cmd_configure_la_acquire_storage(scpi_t *context);
+extern scpi_result_t scpi_cmd_configure_la_acquire_storage_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_trigger_la_pattern(scpi_t *context);
+extern scpi_result_t scpi_cmd_trigger_la_pattern_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_initiate_la(scpi_t *context);
+extern scpi_result_t scpi_cmd_abort_la(scpi_t *context);
+extern scpi_result_t scpi_cmd_fetch_la_data_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_read_la_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_status_la_acquisition_q(scpi_t *context);
+extern void la_reset_state(void);
+
+// Waveform generator command handlers (implemented in wavegen.c)
+extern scpi_result_t scpi_cmd_wavegen_function(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_function_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_frequency(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_frequency_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_frequency_millihertz(scpi_t *context);
+extern scpi_result_t
+scpi_cmd_wavegen_frequency_millihertz_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_mode(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_mode_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_voltage_amplitude(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_voltage_amplitude_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_voltage_offset(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_voltage_offset_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_data(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_data_points(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_data_points_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_output(scpi_t *context);
+extern scpi_result_t scpi_cmd_wavegen_output_q(scpi_t *context);
+extern void wavegen_reset_state(void);
+
+// Frequency counter command handlers (implemented in counter.c)
+extern scpi_result_t scpi_cmd_frequency_measure_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_frequency_period_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_frequency_gate(scpi_t *context);
+extern scpi_result_t scpi_cmd_frequency_gate_q(scpi_t *context);
+extern void counter_reset_state(void);
+
+// Power meter command handlers (implemented in power.c)
+extern scpi_result_t scpi_cmd_power_configure(scpi_t *context);
+extern scpi_result_t scpi_cmd_power_configure_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_power_scale(scpi_t *context);
+extern scpi_result_t scpi_cmd_power_scale_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_power_initiate(scpi_t *context);
+extern scpi_result_t scpi_cmd_power_abort(scpi_t *context);
+extern scpi_result_t scpi_cmd_power_clear(scpi_t *context);
+extern scpi_result_t scpi_cmd_power_state_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_power_fetch_q(scpi_t *context);
+extern void power_reset_state(void);
+
+// Frequency response sweep command handlers (implemented in sweep.c)
+extern scpi_result_t scpi_cmd_sweep_frequency(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_frequency_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_points(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_points_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_spacing(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_spacing_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_voltage(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_voltage_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_settle(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_settle_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_cycles(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_cycles_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_initiate(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_abort(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_state_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_count_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_sweep_data_q(scpi_t *context);
+extern void sweep_reset_state(void);
+
+// PWM generator command handlers (implemented in pwm.c)
+extern scpi_result_t scpi_cmd_pwm_frequency(scpi_t *context);
+extern scpi_result_t scpi_cmd_pwm_frequency_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_pwm_duty(scpi_t *context);
+extern scpi_result_t scpi_cmd_pwm_duty_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_pwm_phase(scpi_t *context);
+extern scpi_result_t scpi_cmd_pwm_phase_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_pwm_enable(scpi_t *context);
+extern scpi_result_t scpi_cmd_pwm_enable_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_pwm_output(scpi_t *context);
+extern scpi_result_t scpi_cmd_pwm_output_q(scpi_t *context);
+extern void pwm_reset_state(void);
+
+// Synchronized start command handlers (implemented in sync.c)
+extern scpi_result_t scpi_cmd_initiate_all(scpi_t *context);
+extern scpi_result_t scpi_cmd_initiate_all_arm(scpi_t *context);
+extern scpi_result_t scpi_cmd_initiate_all_arm_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_initiate_all_source(scpi_t *context);
+extern scpi_result_t scpi_cmd_initiate_all_source_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_initiate_all_output(scpi_t *context);
+extern scpi_result_t scpi_cmd_initiate_all_output_q(scpi_t *context);
+extern void sync_reset_state(void);
+
+// I2C bus pass-through command handlers (implemented in i2c.c)
+extern scpi_result_t scpi_cmd_bus_i2c_frequency(scpi_t *context);
+extern scpi_result_t scpi_cmd_bus_i2c_frequency_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_bus_i2c_register_size(scpi_t *context);
+extern scpi_result_t scpi_cmd_bus_i2c_register_size_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_bus_i2c_write(scpi_t *context);
+extern scpi_result_t scpi_cmd_bus_i2c_read_q(scpi_t *context);
+extern void i2c_reset_state(void);
+
+// SPI bus pass-through command handlers (implemented in spi.c)
+extern scpi_result_t scpi_cmd_bus_spi_frequency(scpi_t *context);
+extern scpi_result_t scpi_cmd_bus_spi_frequency_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_bus_spi_mode(scpi_t *context);
+extern scpi_result_t scpi_cmd_bus_spi_mode_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_bus_spi_order(scpi_t *context);
+extern scpi_result_t scpi_cmd_bus_spi_order_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_bus_spi_transfer_q(scpi_t *context);
+extern void spi_reset_state(void);
+
+// Data logger command handlers (implemented in datalog.c)
+extern scpi_result_t scpi_cmd_log_channels(scpi_t *context);
+extern scpi_result_t scpi_cmd_log_channels_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_log_interval(scpi_t *context);
+extern scpi_result_t scpi_cmd_log_interval_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_log_start(scpi_t *context);
+extern scpi_result_t scpi_cmd_log_stop(scpi_t *context);
+extern scpi_result_t scpi_cmd_log_state_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_log_capacity_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_log_size_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_log_count_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_log_session_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_log_data_q(scpi_t *context);
+extern void datalog_reset_state(void);
+
+// Sequence engine command handlers (implemented in sequence.c)
+extern scpi_result_t scpi_cmd_sequence_define(scpi_t *context);
+extern scpi_result_t scpi_cmd_sequence_run(scpi_t *context);
+extern scpi_result_t scpi_cmd_sequence_abort(scpi_t *context);
+extern scpi_result_t scpi_cmd_sequence_state_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_sequence_line_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_sequence_wait(scpi_t *context);
+extern scpi_result_t scpi_cmd_sequence_limit(scpi_t *context);
+extern scpi_result_t scpi_cmd_sequence_result_q(scpi_t *context);
+extern scpi_result_t scpi_cmd_sequence_failures_q(scpi_t *context);
+extern void sequence_reset_state(void);
+extern bool sequence_capturing(void);
+extern bool sequence_running(void);
+extern size_t sequence_write(char const *data, size_t len);
+extern void sequence_task(scpi_t *context);
+
+// Forward declarations of binary protocol functions needed by common
+extern scpi_result_t scpi_cmd_system_communicate_binary(scpi_t *context);
+extern scpi_result_t scpi_cmd_system_communicate_binary_q(scpi_t *context);
+extern void binary_reset_state(void);
+extern void binary_task(void);
+
+// Forward declarations of USB link test functions needed by common
+extern scpi_result_t scpi_cmd_system_test_usb(scpi_t *context);
+extern scpi_result_t scpi_cmd_system_test_usb_stop(scpi_t *context);
+extern scpi_result_t scpi_cmd_system_test_usb_q(scpi_t *context);
+extern void linktest_reset_state(void);
+extern void linktest_task(void);
+
+// Bulk data interface, opened on demand by instrument modules
+static uint8_t g_usb_bulk_rx_buffer_data[USB_BULK_RX_BUFFER_SIZE];
+static uint8_t g_usb_bulk_tx_buffer_data[USB_BULK_TX_BUFFER_SIZE];
+static CircularBuffer g_usb_bulk_rx_buffer;
+static CircularBuffer g_usb_bulk_tx_buffer;
+static USB_Handle *g_usb_bulk_handle = nullptr;
+
+// Isochronous data interface of PSLAB_USB_ISO builds, opened on demand
+static uint8_t g_usb_iso_rx_buffer_data[USB_ISO_RX_BUFFER_SIZE];
+static uint8_t g_usb_iso_tx_buffer_data[USB_ISO_TX_BUFFER_SIZE];
+static CircularBuffer g_usb_iso_rx_buffer;
+static CircularBuffer g_usb_iso_tx_buffer;
+static USB_Handle *g_usb_iso_handle = nullptr;
+
+// Protocol state (internal to common.c)
+static bool g_protocol_initialized = false;
+
+// Result block being sent from instrument memory, see protocol_result_block
+static bool g_block_pending = false;
+
+// OPERation status events raised since the last protocol_task pass, see
+// protocol_operation_event
+static uint16_t volatile g_operation_events = 0;
+
+// Query whose response waits for an instrument, see protocol_defer
+static struct {
+    scpi_command_callback_t resume; // nullptr while no query is deferred
+    bool resuming; // resume is running from protocol_task
+} g_deferred = { .resume = nullptr, .resuming = false };
+
+// Where the input scanner is in the byte stream, see feed_input
+typedef enum {
+    SCAN_TEXT, // Program text, passed to the parser
+    SCAN_QUOTED, // Inside a string, where '#' starts no block
+    SCAN_HASH, // '#' held back, the header may start a block
+    SCAN_LENGTH, // Header held back while its length digits arrive
+    SCAN_BLOCK, // Block that fits the input buffer, passed to the parser
+    SCAN_STREAM, // Streamed block, passed to its destination
+    SCAN_SEPARATOR, // After a streamed block, whose ';' is dropped
+} ScanState;
+
+// Arbitrary block parameters too large for the input buffer, streamed
+// past the parser into their destination, see protocol_block_receive
+static struct {
+    ScanState state;
+    char quote; // Quote that ends the string
+    char header[11]; // '#', the digit count and up to 9 length digits
+    uint32_t header_len;
+    uint32_t digits; // Length digits still to come
+    uint32_t line_len; // Bytes of the current line, header included
+    uint32_t length; // Block bytes still to come
+    uint32_t announced; // Length of the block streamed by the command
+    uint8_t *destination; // nullptr while unclaimed, the block is dropped
+    uint32_t received; // Bytes written to destination
+    scpi_command_callback_t complete;
+} g_stream = { .state = SCAN_TEXT };
+
+// Overlapped commands whose operations may still be running, see
+// protocol_operation_pending
+static struct {
+    bool (*done)(void); // nullptr for a free entry
+    uint32_t timeout; // ms a wait for the operation lasts at most
+} g_pending[PENDING_OPERATIONS_MAX];
+
+// Port a session is opened on, see session_open_usb and session_open_uart
+typedef enum {
+    PORT_NONE = 0, // Free session
+    PORT_USB, // USB serial port
+    PORT_UART, // UART bus
+} SessionPort;
+
+// SCPI session: a host on one port, with its own parser input, error queue
+// and status registers; the instruments and their operations are shared
+typedef struct {
+    SessionPort port;
+    uint32_t number; // USB interface or UART bus
+    USB_Handle *usb; // Set for PORT_USB
+    UART_Handle *uart; // Set for PORT_UART
+    bool closing; // Closed by protocol_task once no line is half done
+    uint8_t rx_data[USB_RX_BUFFER_SIZE];
+    uint8_t tx_data[USB_TX_BUFFER_SIZE];
+    CircularBuffer rx_buffer;
+    CircularBuffer tx_buffer;
+    scpi_t context;
+    char input_buffer[SCPI_INPUT_BUFFER_SIZE];
+    scpi_error_t error_queue[SCPI_ERROR_QUEUE_SIZE];
+    bool flush_pending; // A response has ended since the last flush
+    bool srq_ring; // Ring indicator sent with the last service request
+    // *OPC, *OPC? and *WAI waiting for the pending operations, see
+    // hold_input
+    struct {
+        bool opc; // *OPC sets the OPC bit of the ESR once they are done
+        bool opc_query; // *OPC? answers once they are done
+        bool holding; // Commands after *WAI or *OPC? wait in input
+        uint32_t start; // Tick at which the wait began
+        char input[SCPI_INPUT_BUFFER_SIZE + USB_READ_SIZE];
+        uint32_t length;
+    } wait;
+} Session;
+
+// Session 0 is the SCPI port, opened by protocol_init; the others are
+// opened with SYSTem:COMMunicate:SESSion, see select_session
+static Session g_sessions[SESSIONS_MAX];
+
+// Session whose input the parser runs
+static Session *g_session = &g_sessions[0];
+
+/**
+ * @brief Check whether *OPC, *OPC? or *WAI wait in a session
+ */
+static bool session_waiting(Session const *session)
+{
+    return session->wait.opc || session->wait.opc_query ||
+           session->wait.holding;
+}
+
+/**
+ * @brief Drop a deferred query that another response has overtaken
+ *
+ * As with an IEEE 488.2 interrupted query, the deferred response is lost
+ * and an error is queued.
+ */
+static void interrupt_deferred(void)
+{
+    if (!g_deferred.resume || g_deferred.resuming) {
+        return;
+    }
+
+    g_deferred.resume = nullptr;
+    SCPI_ErrorPush(&g_session->context, SCPI_ERROR_EXECUTION_ERROR);
+}
+
+/**
+ * @brief USB RX callback - called when data is received
+ */
+static void usb_rx_callback(USB_Handle *handle, uint32_t bytes_available)
+{
+    (void)handle; // Unused parameter
+    (void)bytes_available; // Unused parameter
+    // Data processing will happen in the main protocol task
+}
+
+/**
+ * @brief Write to a UART session, waiting for TX buffer space
+ *
+ * A UART drains its TX buffer by itself, at the line rate, so a response
+ * larger than the buffer holds up the main loop only until it is sent.
+ *
+ * @return Number of bytes written, less only if the UART is stuck
+ */
+static uint32_t
+uart_write_all(Session *session, uint8_t const *data, uint32_t len)
+{
+    uint32_t written = 0;
+
+    while (written < len) {
+        uint32_t const count =
+            UART_write(session->uart, &data[written], len - written);
+        written += count;
+        if (count == 0 &&
+            !UART_flush(session->uart, SESSION_WRITE_TIMEOUT)) {
+            LOG_ERROR("Protocol: UART session stuck, response cut");
+            break;
+        }
+    }
+    return written;
+}
+
+/**
+ * @brief SCPI write function - sends data to the session's port
+ *
+ * The responses of a line run by the sequence engine go to its result
+ * table instead.
+ */
+static size_t protocol_write(scpi_t *context, char const *data, size_t len)
+{
+    Session *const session = context->user_context;
+
+    if (session->port == PORT_NONE) {
+        return 0;
+    }
+
+    interrupt_deferred();
+
+    if (sequence_capturing()) {
+        return sequence_write(data, len);
+    }
+    if (session->uart) {
+        return uart_write_all(session, (uint8_t const *)data, (uint32_t)len);
+    }
+    return USB_write(session->usb, (uint8_t const *)data, (uint32_t)len);
+}
+
+/**
+ * @brief SCPI flush function - marks the end of a response
+ *
+ * The flush itself is left to protocol_task, so that the responses to a
+ * burst of commands go out together rather than in one short packet each.
+ */
+static scpi_result_t protocol_flush(scpi_t *context)
+{
+    Session *const session = context->user_context;
+
+    session->flush_pending = true;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Write raw bytes to the host outside of an SCPI response
+ *
+ * Used by instrument modules that push data to the host unsolicited. The
+ * data goes to the SCPI port, whichever session asked for it.
+ *
+ * @return Number of bytes accepted by the USB TX buffer
+ */
+uint32_t protocol_write_raw(uint8_t const *data, uint32_t len)
+{
+    if (!g_sessions[0].usb) {
+        return 0;
+    }
+
+    return USB_write(g_sessions[0].usb, data, len);
+}
+
+/**
+ * @brief Send a caller-owned buffer to the host without a copy
+ *
+ * The unsolicited counterpart of protocol_result_block, for data pushed by
+ * instrument modules.
+ *
+ * @return true if queued, see USB_write_buffer
+ */
+bool protocol_write_raw_buffer(uint8_t const *data, uint32_t len)
+{
+    if (!g_sessions[0].usb) {
+        return false;
+    }
+
+    return USB_write_buffer(g_sessions[0].usb, data, len);
+}
+
+/**
+ * @brief Check if a buffer queued with protocol_write_raw_buffer, or the
+ * data of a result block, is still being sent
+ */
+bool protocol_raw_tx_pending(void)
+{
+    return g_sessions[0].usb && USB_tx_buffer_pending(g_sessions[0].usb);
+}
+
+/**
+ * @brief Open the USB bulk data interface
+ *
+ * The bulk interface carries binary sample data only and is opened the first
+ * time an instrument module selects it.
+ *
+ * @return true if the interface is open
+ */
+bool protocol_bulk_open(void)
+{
+    if (g_usb_bulk_handle) {
+        return true;
+    }
+
+    circular_buffer_init(
+        &g_usb_bulk_rx_buffer,
+        g_usb_bulk_rx_buffer_data,
+        USB_BULK_RX_BUFFER_SIZE
+    );
+    circular_buffer_init(
+        &g_usb_bulk_tx_buffer,
+        g_usb_bulk_tx_buffer_data,
+        USB_BULK_TX_BUFFER_SIZE
+    );
+
+    Error err = ERROR_NONE;
+    TRY
+    {
+        g_usb_bulk_handle = USB_init(
+            USB_INTERFACE_BULK, &g_usb_bulk_rx_buffer, &g_usb_bulk_tx_buffer
+        );
+    }
+    CATCH(err) { g_usb_bulk_handle = nullptr; }
+
+    if (!g_usb_bulk_handle) {
+        return false;
+    }
+
+    USB_set_event_driven(g_usb_bulk_handle, true);
+    return true;
+}
+
+/**
+ * @brief Write raw bytes to the USB bulk data interface
+ *
+ * @return Number of bytes accepted by the bulk TX buffer
+ */
+uint32_t protocol_write_bulk(uint8_t const *data, uint32_t len)
+{
+    if (!g_usb_bulk_handle) {
+        return 0;
+    }
+
+    return USB_write(g_usb_bulk_handle, data, len);
+}
+
+/**
+ * @brief Read bytes the host sent on the USB bulk data interface
+ *
+ * @return Number of bytes read
+ */
+uint32_t protocol_read_bulk(uint8_t *data, uint32_t len)
+{
+    if (!g_usb_bulk_handle) {
+        return 0;
+    }
+
+    return USB_read(g_usb_bulk_handle, data, len);
+}
+
+/**
+ * @brief Get the free space of the bulk TX buffer
+ *
+ * @return Number of bytes protocol_write_bulk accepts at once
+ */
+uint32_t protocol_bulk_tx_free(void)
+{
+    if (!g_usb_bulk_handle) {
+        return 0;
+    }
+
+    return USB_tx_free_space(g_usb_bulk_handle);
+}
+
+/**
+ * @brief Send a caller-owned buffer on the bulk interface without a copy
+ *
+ * @return true if queued, see USB_write_buffer
+ */
+bool protocol_write_bulk_buffer(uint8_t const *data, uint32_t len)
+{
+    if (!g_usb_bulk_handle) {
+        return false;
+    }
+
+    return USB_write_buffer(g_usb_bulk_handle, data, len);
+}
+
+/**
+ * @brief Check if a buffer queued with protocol_write_bulk_buffer is still
+ * being sent
+ */
+bool protocol_bulk_tx_pending(void)
+{
+    return g_usb_bulk_handle && USB_tx_buffer_pending(g_usb_bulk_handle);
+}
+
+/**
+ * @brief Open the USB isochronous data interface
+ *
+ * Like the bulk interface, it carries binary sample data only and is opened
+ * the first time an instrument module selects it. Builds without
+ * PSLAB_USB_ISO have no such interface.
+ *
+ * @return true if the interface is open
+ */
+bool protocol_iso_open(void)
+{
+    if (g_usb_iso_handle) {
+        return true;
+    }
+
+    circular_buffer_init(
+        &g_usb_iso_rx_buffer,
+        g_usb_iso_rx_buffer_data,
+        USB_ISO_RX_BUFFER_SIZE
+    );
+    circular_buffer_init(
+        &g_usb_iso_tx_buffer,
+        g_usb_iso_tx_buffer_data,
+        USB_ISO_TX_BUFFER_SIZE
+    );
+
+    Error err = ERROR_NONE;
+    TRY
+    {
+        g_usb_iso_handle = USB_init(
+            USB_INTERFACE_ISO, &g_usb_iso_rx_buffer, &g_usb_iso_tx_buffer
+        );
+    }
+    CATCH(err) { g_usb_iso_handle = nullptr; }
+
+    if (!g_usb_iso_handle) {
+        return false;
+    }
+
+    USB_set_event_driven(g_usb_iso_handle, true);
+    return true;
+}
+
+/**
+ * @brief Write raw bytes to the USB isochronous data interface
+ *
+ * @return Number of bytes accepted by the isochronous TX buffer
+ */
+uint32_t protocol_write_iso(uint8_t const *data, uint32_t len)
+{
+    if (!g_usb_iso_handle) {
+        return 0;
+    }
+
+    return USB_write(g_usb_iso_handle, data, len);
+}
+
+/**
+ * @brief Send a caller-owned buffer on the isochronous interface without a
+ * copy
+ *
+ * @return true if queued, see USB_write_buffer
+ */
+bool protocol_write_iso_buffer(uint8_t const *data, uint32_t len)
+{
+    if (!g_usb_iso_handle) {
+        return false;
+    }
+
+    return USB_write_buffer(g_usb_iso_handle, data, len);
+}
+
+/**
+ * @brief Check if a buffer queued with protocol_write_iso_buffer is still
+ * being sent
+ */
+bool protocol_iso_tx_pending(void)
+{
+    return g_usb_iso_handle && USB_tx_buffer_pending(g_usb_iso_handle);
+}
+
+/**
+ * @brief Send a result arbitrary block with a prefix from instrument memory
+ *
+ * Like protocol_result_block, but the block starts with a short prefix,
+ * such as a record header, which is copied through the parser ahead of the
+ * data.
+ *
+ * @param context SCPI context of the query
+ * @param prefix Bytes to send first, may be nullptr if prefix_len is 0
+ * @param prefix_len Prefix length in bytes
+ * @param data Block data, left unchanged by the caller until it is sent
+ * @param len Length of the data in bytes, without the prefix
+ */
+void protocol_result_block_prefixed(
+    scpi_t *context,
+    uint8_t const *prefix,
+    uint32_t prefix_len,
+    uint8_t const *data,
+    uint32_t len
+)
+{
+    SCPI_ResultArbitraryBlockHeader(context, prefix_len + len);
+    if (prefix_len > 0) {
+        SCPI_ResultArbitraryBlockData(context, prefix, prefix_len);
+    }
+
+    // The result table of a sequence takes a copy, as does a UART
+    Session *const session = context->user_context;
+    if (!session->usb || sequence_capturing() ||
+        !USB_write_buffer(session->usb, data, len)) {
+        SCPI_ResultArbitraryBlockData(context, data, len);
+        return;
+    }
+
+    // Complete the block as SCPI_ResultArbitraryBlockData would
+    context->arbitrary_remaining = 0;
+    context->output_count++;
+    g_block_pending = true;
+}
+
+/**
+ * @brief Send a result arbitrary block straight from instrument memory
+ *
+ * The header goes through the parser, the data is handed to the USB layer
+ * without a copy, so the block may be larger than the TX buffer. Input is
+ * held until the data has been sent, so that no command can change it
+ * meanwhile. A UART session copies the data through the parser instead.
+ *
+ * @param context SCPI context of the query
+ * @param data Block data, left unchanged by the caller until it is sent
+ * @param len Block length in bytes
+ */
+void protocol_result_block(scpi_t *context, uint8_t const *data, uint32_t len)
+{
+    protocol_result_block_prefixed(context, nullptr, 0, data, len);
+}
+
+/**
+ * @brief Send 32-bit integers as ASCII response data
+ *
+ * Gives the response of SCPI_ResultArrayInt32 or SCPI_ResultArrayUInt32
+ * with SCPI_FORMAT_ASCII, but formats the values with FORMAT_int32 and
+ * FORMAT_uint32 and writes them in comma-separated runs, rather than with
+ * two writes per value.
+ *
+ * @param context SCPI context of the query
+ * @param values Values, int32_t if is_signed, uint32_t otherwise
+ * @param count Number of values
+ * @param is_signed Whether the values are signed
+ */
+static void result_ascii(
+    scpi_t *context,
+    void const *values,
+    size_t count,
+    bool is_signed
+)
+{
+    char buffer[RESULT_ASCII_BUFFER_SIZE];
+    size_t length = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        // The parser separates runs, as it does separate results
+        if (length > sizeof(buffer) - (FORMAT_INT32_SIZE_MAX + 1)) {
+            SCPI_ResultCharacters(context, buffer, length);
+            length = 0;
+        }
+        if (length > 0) {
+            buffer[length++] = ',';
+        }
+        if (is_signed) {
+            int32_t const value = ((int32_t const *)values)[i];
+            length += FORMAT_int32(value, &buffer[length]);
+        } else {
+            uint32_t const value = ((uint32_t const *)values)[i];
+            length += FORMAT_uint32(value, &buffer[length]);
+        }
+    }
+
+    if (length > 0) {
+        SCPI_ResultCharacters(context, buffer, length);
+    }
+}
+
+/**
+ * @brief Send signed integers as ASCII response data, see result_ascii
+ */
+void protocol_result_int32_ascii(
+    scpi_t *context,
+    int32_t const *values,
+    size_t count
+)
+{
+    result_ascii(context, values, count, true);
+}
+
+/**
+ * @brief Send unsigned integers as ASCII response data, see result_ascii
+ */
+void protocol_result_uint32_ascii(
+    scpi_t *context,
+    uint32_t const *values,
+    size_t count
+)
+{
+    result_ascii(context, values, count, false);
+}
+
+/**
+ * @brief Answer the current query later, from protocol_task
+ *
+ * A query handler that has to wait for an instrument returns the result of
+ * this function instead of blocking. protocol_task then calls resume in
+ * place of the handler each time it runs, while further commands are
+ * still processed, until resume answers or fails without deferring again.
+ *
+ * resume is called outside the parser, so it must not read parameters.
+ * Another query's response overtaking the deferred one drops it with an
+ * execution error, as does deferring a new query.
+ *
+ * @param context SCPI context of the query
+ * @param resume Handler that completes the query
+ * @return Result for the query handler to return
+ */
+scpi_result_t protocol_defer(scpi_t *context, scpi_command_callback_t resume)
+{
+    interrupt_deferred();
+    g_deferred.resume = resume;
+
+    // Fail the command without an error, so that the parser neither queues
+    // an error nor ends the response line
+    context->cmd_error = true;
+    return SCPI_RES_ERR;
+}
+
+/**
+ * @brief Check whether a deferred query is being resumed
+ *
+ * @return true while protocol_task runs the resume handler
+ */
+bool protocol_is_resuming(void) { return g_deferred.resuming; }
+
+/**
+ * @brief Give a deferred query the chance to answer
+ */
+static void resume_deferred(void)
+{
+    scpi_command_callback_t const resume = g_deferred.resume;
+    if (!resume) {
+        return;
+    }
+
+    g_deferred.resume = nullptr;
+    g_deferred.resuming = true;
+    scpi_t *const context = &g_session->context;
+    context->cmd_error = false;
+    context->output_count = 0;
+    scpi_result_t const result = resume(context);
+    g_deferred.resuming = false;
+
+    if (g_deferred.resume) {
+        return; // Deferred again
+    }
+
+    if (result != SCPI_RES_OK && !context->cmd_error) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+    }
+    if (context->cmd_error) {
+        return;
+    }
+
+    // End the response line as the parser would have
+    if (context->output_count > 0) {
+        protocol_write(context, SCPI_LINE_ENDING, strlen(SCPI_LINE_ENDING));
+        protocol_flush(context);
+    }
+}
+
+/**
+ * @brief Raise OPERation status events
+ *
+ * Instrument modules report completed operations as bits of the OPERation
+ * status event register. protocol_task latches them into the register;
+ * bits enabled with STATus:OPERation:ENABle then set the OPER bit of the
+ * status byte, and a service request follows if *SRE enables that. Until
+ * STATus:OPERation? or *CLS clears the register, further events of an
+ * enabled bit raise no new request. Safe to call from interrupt context.
+ *
+ * The instrument-defined bits are allocated here:
+ * - bit 8: oscilloscope acquisition complete (dso.c)
+ * - bit 9: DMM burst complete (dmm.c)
+ * - bit 10: oscilloscope stream error (dso.c)
+ * - bit 11: DMM watch limit crossed (dmm.c)
+ *
+ * @param bits Event bits to set
+ */
+void protocol_operation_event(uint16_t bits)
+{
+    __atomic_fetch_or(&g_operation_events, bits, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Get the length of the arbitrary block streamed to the command
+ *
+ * An arbitrary block too large for the SCPI input buffer reaches its
+ * command empty, and is streamed past the parser instead. A command that
+ * takes such blocks checks this for the length of the block announced by
+ * its header, and claims it with protocol_block_receive. The block must be
+ * the last parameter of its command.
+ *
+ * @return Announced length, 0 if the block parameter is not streamed
+ */
+uint32_t protocol_block_streamed(void) { return g_stream.announced; }
+
+/**
+ * @brief Claim a streamed arbitrary block for the current command
+ *
+ * Only to be called from the command of the block, while
+ * protocol_block_streamed returns its length. protocol_task then reads the
+ * block from the RX buffer of the session straight into the destination,
+ * as fast as it arrives, and calls complete once it is all in, with the
+ * SCPI context to push errors to. A block no command claims is dropped with
+ * an input buffer overrun error.
+ *
+ * @param destination Memory for protocol_block_streamed() bytes
+ * @param complete Called when the block has been received
+ */
+void protocol_block_receive(
+    void *destination,
+    scpi_command_callback_t complete
+)
+{
+    g_stream.destination = destination;
+    g_stream.complete = complete;
+}
+
+/**
+ * @brief Report an overlapped command whose operation is still running
+ *
+ * For commands that start an operation and return before it completes,
+ * such as an acquisition. *OPC, *OPC? and *WAI wait for the operation
+ * until done returns true, which protocol_task checks each pass, or for
+ * timeout ms at most, after which the wait ends with a system error and
+ * the operation is left running. done must return true as well once the
+ * operation is aborted or replaced. Reporting the same done again, e.g.
+ * for the next acquisition, replaces its timeout.
+ *
+ * @param done Check whether the operation has completed
+ * @param timeout Longest wait for the operation, in ms
+ */
+void protocol_operation_pending(bool (*done)(void), uint32_t timeout)
+{
+    size_t entry = PENDING_OPERATIONS_MAX;
+
+    for (size_t i = 0; i < PENDING_OPERATIONS_MAX; ++i) {
+        if (g_pending[i].done == done) {
+            entry = i;
+            break;
+        }
+        if (!g_pending[i].done && entry == PENDING_OPERATIONS_MAX) {
+            entry = i;
+        }
+    }
+    if (entry == PENDING_OPERATIONS_MAX) {
+        LOG_ERROR("Protocol: Too many pending operations");
+        return;
+    }
+
+    g_pending[entry].done = done;
+    g_pending[entry].timeout = timeout;
+}
+
+/**
+ * @brief Drop the pending operations that are done or waited on too long
+ *
+ * A deferred query counts as pending too, so that waits keep the order of
+ * the responses.
+ *
+ * @return true if an operation is still pending
+ */
+static bool poll_operations(void)
+{
+    bool const waiting = session_waiting(g_session);
+    bool pending = g_deferred.resume != nullptr;
+
+    for (size_t i = 0; i < PENDING_OPERATIONS_MAX; ++i) {
+        if (!g_pending[i].done) {
+            continue;
+        }
+        if (g_pending[i].done()) {
+            g_pending[i].done = nullptr;
+            continue;
+        }
+        uint32_t const waited = SYSTEM_get_tick() - g_session->wait.start;
+        if (waiting && waited > g_pending[i].timeout) {
+            LOG_ERROR("Protocol: Gave up waiting for an operation");
+            SCPI_ErrorPush(&g_session->context, SCPI_ERROR_SYSTEM_ERROR);
+            g_pending[i].done = nullptr;
+            continue;
+        }
+        pending = true;
+    }
+    return pending;
+}
+
+/**
+ * @brief Start waiting for the pending operations, unless already waiting
+ */
+static void begin_wait(void)
+{
+    if (!session_waiting(g_session)) {
+        g_session->wait.start = SYSTEM_get_tick();
+    }
+}
+
+/**
+ * @brief Hold the commands after the current one while operations pend
+ *
+ * The rest of the line is taken from the parser, which then finds nothing
+ * more to run on it, and is parsed as a line of its own once the
+ * operations are done, as after a streamed block. Lines received
+ * meanwhile wait in the RX buffer of the session; feed_input holds the
+ * rest of the bytes it was given.
+ *
+ * @return true if input is held
+ */
+static bool hold_input(scpi_t *context)
+{
+    if (!poll_operations()) {
+        return false;
+    }
+    begin_wait();
+    g_session->wait.holding = true;
+
+    // feed_input passes the parser one line at a time, which ends the
+    // input buffer; the next command follows the separator
+    lex_state_t const *const lex = &context->param_list.lex_state;
+    char *rest = lex->buffer + lex->len;
+    char *const end = context->buffer.data + context->buffer.position;
+    while (rest < end && (*rest == ' ' || *rest == '\t')) {
+        ++rest;
+    }
+    if (rest < end && *rest == ';') {
+        ++rest;
+    }
+
+    uint32_t const length = (uint32_t)(end - rest);
+    memcpy(g_session->wait.input, rest, length);
+    g_session->wait.length = length;
+
+    // Leave the parser blanks up to the line ending
+    for (; rest < end && *rest != '\r' && *rest != '\n'; ++rest) {
+        *rest = ' ';
+    }
+    return true;
+}
+
+/**
+ * @brief *OPC - Set the OPC bit of the ESR once no operation is pending
+ */
+static scpi_result_t scpi_cmd_opc(scpi_t *context)
+{
+    if (!poll_operations()) {
+        SCPI_RegSetBits(context, SCPI_REG_ESR, ESR_OPC);
+        return SCPI_RES_OK;
+    }
+    begin_wait();
+    g_session->wait.opc = true;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief *OPC? - Answer 1 once no operation is pending
+ *
+ * The commands after it wait until then, see hold_input.
+ */
+static scpi_result_t scpi_cmd_opc_q(scpi_t *context)
+{
+    if (!hold_input(context)) {
+        SCPI_ResultInt32(context, 1);
+        return SCPI_RES_OK;
+    }
+    g_session->wait.opc_query = true;
+
+    // As for protocol_defer, fail without an error or a line ending
+    context->cmd_error = true;
+    return SCPI_RES_ERR;
+}
+
+/**
+ * @brief *WAI - Run the commands after it once no operation is pending
+ */
+static scpi_result_t scpi_cmd_wai(scpi_t *context)
+{
+    (void)hold_input(context);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief *CLS - Clear the status, and forget an *OPC still waiting
+ */
+static scpi_result_t scpi_cmd_cls(scpi_t *context)
+{
+    g_session->wait.opc = false;
+    return SCPI_CoreCls(context);
+}
+
+/**
+ * @brief Latch the OPERation status events raised since the last pass
+ *
+ * Into the registers of every session, as the operations are shared.
+ */
+static void latch_operation_events(void)
+{
+    uint16_t const bits =
+        __atomic_exchange_n(&g_operation_events, 0, __ATOMIC_RELAXED);
+
+    if (!bits) {
+        return;
+    }
+    for (size_t i = 0; i < SESSIONS_MAX; ++i) {
+        if (g_sessions[i].port != PORT_NONE) {
+            SCPI_RegSetBits(&g_sessions[i].context, SCPI_REG_OPER, bits);
+        }
+    }
+}
+
+/**
+ * @brief SCPI control function - signals service requests to the host
+ *
+ * A CDC serial port has no service request line. Each request toggles the
+ * ring indicator of a SERIAL_STATE notification on the interrupt endpoint
+ * instead, which host serial drivers report as a modem status change, e.g.
+ * to TIOCMIWAIT on Linux. The status byte goes in the reserved upper byte
+ * of the state, for hosts that read the endpoint themselves. A UART
+ * session has no such signal; its host polls *STB? instead.
+ */
+static scpi_result_t
+protocol_control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_t val)
+{
+    Session *const session = context->user_context;
+
+    if (ctrl != SCPI_CTRL_SRQ || !session->usb) {
+        return SCPI_RES_OK;
+    }
+
+    session->srq_ring = !session->srq_ring;
+    uint16_t state = (uint16_t)((val & 0xFFU) << 8U);
+    if (session->srq_ring) {
+        state |= USB_SERIAL_STATE_RING;
+    }
+    USB_notify(session->usb, state);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SCPI reset function
+ */
+static scpi_result_t protocol_reset(scpi_t *context)
+{
+    (void)context; // Unused parameter
+
+    // A reset clears the output queue, including a deferred response, and
+    // the instruments reset below end their operations
+    g_deferred.resume = nullptr;
+    g_block_pending = false;
+    for (size_t i = 0; i < PENDING_OPERATIONS_MAX; ++i) {
+        g_pending[i].done = nullptr;
+    }
+    g_session->wait.opc = false;
+
+    // Drop an armed synchronized start (implemented in sync.c)
+    sync_reset_state();
+
+    // Reset DMM state (implemented in dmm.c)
+    dmm_reset_state();
+
+    // Reset DSO state (implemented in dso.c)
+    dso_reset_state();
+
+    // Reset logic analyzer state (implemented in la.c)
+    la_reset_state();
+
+    // Reset waveform generator state (implemented in wavegen.c)
+    wavegen_reset_state();
+
+    // Reset frequency counter state (implemented in counter.c)
+    counter_reset_state();
+
+    // Stop the power meter (implemented in power.c)
+    power_reset_state();
+
+    // Stop a frequency response sweep (implemented in sweep.c)
+    sweep_reset_state();
+
+    // Reset PWM generator state (implemented in pwm.c)
+    pwm_reset_state();
+
+    // Release the I2C bus (implemented in i2c.c)
+    i2c_reset_state();
+
+    // Release the SPI bus (implemented in spi.c)
+    spi_reset_state();
+
+    // End a log and release the SPI bus (implemented in datalog.c)
+    datalog_reset_state();
+
+    // Stop a running sequence (implemented in sequence.c)
+    sequence_reset_state();
+
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Clamp a cycle count to a SCPI integer
+ */
+static int32_t saturate_int32(uint64_t value)
+{
+    return value > INT32_MAX ? INT32_MAX : (int32_t)value;
+}
+
+/**
+ * @brief SYSTem:PROFile? - Query the profiled zone durations
+ *
+ * Returns the cycle counter frequency in Hz, followed by the run count and
+ * the shortest, longest and mean run in cycles of each zone in
+ * PROFILE_Zone order.
+ */
+static scpi_result_t scpi_cmd_system_profile_q(scpi_t *context)
+{
+    int32_t values[1 + (PROFILE_ZONE_COUNT * PROFILE_VALUES)];
+    uint32_t count = 0;
+
+    values[count++] = saturate_int32(PROFILE_get_frequency());
+    for (uint32_t zone = 0; zone < PROFILE_ZONE_COUNT; ++zone) {
+        PROFILE_Stats const stats = PROFILE_get((PROFILE_Zone)zone);
+        values[count++] = saturate_int32(stats.count);
+        values[count++] = saturate_int32(stats.min);
+        values[count++] = saturate_int32(stats.max);
+        values[count++] =
+            saturate_int32(stats.count > 0 ? stats.total / stats.count : 0);
+    }
+
+    SCPI_ResultArrayInt32(context, values, count, SCPI_FORMAT_ASCII);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:PROFile:CLEar - Discard the profiled zone durations
+ */
+static scpi_result_t scpi_cmd_system_profile_clear(scpi_t *context)
+{
+    (void)context; // Unused parameter
+
+    PROFILE_clear();
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t scpi_cmd_system_statistics_commands_q(scpi_t *context);
+
+static scpi_result_t scpi_cmd_system_statistics_commands_clear(
+    scpi_t *context
+);
+
+/**
+ * @brief SYSTem:BOOT? - Query when the boot stages completed
+ *
+ * Returns the completion time of each stage in microseconds, in
+ * PROFILE_BootStage order, 0 for stages that have not completed.
+ */
+static scpi_result_t scpi_cmd_system_boot_q(scpi_t *context)
+{
+    int32_t values[PROFILE_BOOT_COUNT];
+
+    for (uint32_t stage = 0; stage < PROFILE_BOOT_COUNT; ++stage) {
+        values[stage] =
+            saturate_int32(PROFILE_get_boot_time((PROFILE_BootStage)stage));
+    }
+
+    SCPI_ResultArrayInt32(
+        context, values, PROFILE_BOOT_COUNT, SCPI_FORMAT_ASCII
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:MEMory? - Query the heap and sample memory usage
+ *
+ * Returns, in bytes, the heap size, use, peak and headroom, followed by the
+ * DSO sample memory size, use, peak and largest free block. The peaks cover
+ * the time since startup.
+ */
+static scpi_result_t scpi_cmd_system_memory_q(scpi_t *context)
+{
+    SYSTEM_HeapStats const heap = SYSTEM_get_heap_stats();
+    Arena const *const samples = dso_sample_arena();
+    int32_t const values[] = {
+        saturate_int32(heap.size),     saturate_int32(heap.used),
+        saturate_int32(heap.peak),     saturate_int32(heap.headroom),
+        saturate_int32(samples->size), saturate_int32(samples->used),
+        saturate_int32(samples->peak), saturate_int32(ARENA_available(samples)),
+    };
+
+    SCPI_ResultArrayInt32(
+        context, values, sizeof(values) / sizeof(values[0]), SCPI_FORMAT_ASCII
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:STACk? - Query the deepest use of the stacks
+ *
+ * Returns, in bytes, the size and deepest use of the main loop stack, then
+ * of the interrupt stack. A use equal to the size means the stack may have
+ * overflowed.
+ */
+static scpi_result_t scpi_cmd_system_stack_q(scpi_t *context)
+{
+    SYSTEM_StackStats const stacks = SYSTEM_get_stack_stats();
+    int32_t const values[] = {
+        saturate_int32(stacks.main.size),
+        saturate_int32(stacks.main.peak),
+        saturate_int32(stacks.interrupt.size),
+        saturate_int32(stacks.interrupt.peak),
+    };
+
+    SCPI_ResultArrayInt32(
+        context, values, sizeof(values) / sizeof(values[0]), SCPI_FORMAT_ASCII
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:IRQ? - Query the interrupt priorities in effect
+ *
+ * Returns the name, preemption priority and enabled state of each interrupt
+ * the drivers use, from the highest planned priority to the lowest. Lower
+ * numbers preempt higher ones.
+ */
+static scpi_result_t scpi_cmd_system_irq_q(scpi_t *context)
+{
+    SYSTEM_IrqInfo info[SYSTEM_IRQ_INFO_MAX];
+    size_t const count = SYSTEM_get_irq_info(info, SYSTEM_IRQ_INFO_MAX);
+
+    for (size_t i = 0; i < count; ++i) {
+        SCPI_ResultMnemonic(context, info[i].name);
+        SCPI_ResultUInt32(context, info[i].priority);
+        SCPI_ResultBool(context, info[i].enabled);
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:TIME:SOF? - Query the local time of a USB start-of-frame
+ *
+ * Returns the frame count, whose low 11 bits are the host's frame number,
+ * and the local time of the frame in microseconds, on the clock of the
+ * capture timestamps. Queues an execution error while frames are not
+ * coming in.
+ */
+static scpi_result_t scpi_cmd_system_time_sof_q(scpi_t *context)
+{
+    uint32_t frame = 0;
+    uint32_t time_us = 0;
+
+    if (!USB_get_frame_stamp(&frame, &time_us)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultUInt32(context, frame);
+    SCPI_ResultUInt32(context, time_us);
+    return SCPI_RES_OK;
+}
+
+// Modules of SYSTem:LOG:LEVel, in LOG_Module order
+static scpi_choice_def_t const g_LOG_MODULE_CHOICES[] = {
+    { "DEFault", LOG_MODULE_DEFAULT },
+    { "DSO", LOG_MODULE_DSO },
+    { "DMM", LOG_MODULE_DMM },
+    { "USB", LOG_MODULE_USB },
+    { "UART", LOG_MODULE_UART },
+    { "ADC", LOG_MODULE_ADC_LL },
+    SCPI_CHOICE_LIST_END
+};
+
+// Levels of SYSTem:LOG:LEVel, in LOG_Level order
+static scpi_choice_def_t const g_LOG_LEVEL_CHOICES[] = {
+    { "ERRor", LOG_LEVEL_ERROR },
+    { "WARNing", LOG_LEVEL_WARN },
+    { "INFO", LOG_LEVEL_INFO },
+    { "DEBug", LOG_LEVEL_DEBUG },
+    SCPI_CHOICE_LIST_END
+};
+
+/**
+ * @brief SYSTem:LOG:LEVel - Set the most verbose level a module logs
+ *
+ * Parameters are the module and the level, e.g. SYST:LOG:LEV DSO,DEB.
+ */
+static scpi_result_t scpi_cmd_system_log_level(scpi_t *context)
+{
+    int32_t module = -1;
+    int32_t level = -1;
+
+    if (!SCPI_ParamChoice(context, g_LOG_MODULE_CHOICES, &module, true) ||
+        !SCPI_ParamChoice(context, g_LOG_LEVEL_CHOICES, &level, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    (void)LOG_set_level((LOG_Module)module, (LOG_Level)level);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:LOG:LEVel? - Query the most verbose level a module logs
+ *
+ * Returns ERR, WARN, INFO or DEB.
+ */
+static scpi_result_t scpi_cmd_system_log_level_q(scpi_t *context)
+{
+    static char const *const level_mnemonics[] = { "ERR", "WARN", "INFO",
+                                                   "DEB" };
+    int32_t module = -1;
+
+    if (!SCPI_ParamChoice(context, g_LOG_MODULE_CHOICES, &module, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultMnemonic(
+        context, level_mnemonics[LOG_get_level((LOG_Module)module)]
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:LOG:STATistics? - Query the logging statistics
+ *
+ * Returns the number of messages written, dropped because the log buffer
+ * was full and output, followed by the high-water mark and the capacity
+ * of the log buffer in bytes.
+ */
+static scpi_result_t scpi_cmd_system_log_statistics_q(scpi_t *context)
+{
+    LOG_Stats const stats = LOG_get_stats();
+    int32_t const values[] = {
+        saturate_int32(stats.written),
+        saturate_int32(stats.dropped),
+        saturate_int32(stats.drained),
+        saturate_int32(stats.high_water),
+        saturate_int32(stats.capacity),
+    };
+
+    SCPI_ResultArrayInt32(
+        context, values, sizeof(values) / sizeof(values[0]), SCPI_FORMAT_ASCII
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:LOG:STATistics:CLEar - Restart the logging statistics
+ */
+static scpi_result_t scpi_cmd_system_log_statistics_clear(scpi_t *context)
+{
+    (void)context; // Unused parameter
+
+    LOG_clear_stats();
+    return SCPI_RES_OK;
+}
+
+// Destinations of SYSTem:LOG:SINK, in SYSTEM_LogSink order
+static scpi_choice_def_t const g_LOG_SINK_CHOICES[] = {
+    { "UART", SYSTEM_LOG_SINK_UART },
+    { "USB", SYSTEM_LOG_SINK_USB },
+    { "QUERy", SYSTEM_LOG_SINK_QUERY },
+    { "ITM", SYSTEM_LOG_SINK_ITM },
+    SCPI_CHOICE_LIST_END
+};
+
+/**
+ * @brief SYSTem:LOG:SINK - Select where log messages are sent
+ *
+ * UART is the log UART, USB the second USB serial port, QUERy keeps
+ * messages until they are read with SYSTem:LOG?, and ITM sends them out of
+ * the SWO pin on ITM stimulus port 0.
+ */
+static scpi_result_t scpi_cmd_system_log_sink(scpi_t *context)
+{
+    int32_t sink = -1;
+
+    if (!SCPI_ParamChoice(context, g_LOG_SINK_CHOICES, &sink, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    Error err = ERROR_NONE;
+    TRY { SYSTEM_set_log_sink((SYSTEM_LogSink)sink); }
+    CATCH(err)
+    {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:LOG:SINK? - Query where log messages are sent
+ *
+ * Returns UART, USB, QUER or ITM.
+ */
+static scpi_result_t scpi_cmd_system_log_sink_q(scpi_t *context)
+{
+    static char const *const sink_mnemonics[] = {
+        "UART", "USB", "QUER", "ITM"
+    };
+
+    SCPI_ResultMnemonic(context, sink_mnemonics[SYSTEM_get_log_sink()]);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:LOG? - Read the next batch of log lines
+ *
+ * Returns a definite length arbitrary block of formatted lines, empty once
+ * no message is left. Usually paired with SYSTem:LOG:SINK QUERy, so that
+ * LOG_task does not send the messages elsewhere first.
+ */
+static scpi_result_t scpi_cmd_system_log_q(scpi_t *context)
+{
+    // Held until the block has been sent, see protocol_result_block
+    static uint8_t lines[LOG_QUERY_BUFFER_SIZE];
+
+    uint32_t const len = LOG_read_lines(lines, sizeof(lines));
+    protocol_result_block(context, lines, len);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:TRACe? [<sequence>] - Read records of the event trace
+ *
+ * Returns a definite length arbitrary block of little-endian 32-bit words:
+ * the sequence number of the first record, the sequence number the next
+ * event will get and the cycle counter frequency in Hz, followed by up to
+ * TRACE_QUERY_RECORDS records in TRACE_Record layout. The block starts at
+ * the record numbered <sequence>, or at the oldest one kept if that is
+ * gone or the parameter is omitted. Passing the first sequence number plus
+ * the record count to the next query follows the trace live.
+ */
+static scpi_result_t scpi_cmd_system_trace_q(scpi_t *context)
+{
+    // Held until the block has been sent, see protocol_result_block
+    static struct {
+        uint32_t first;
+        uint32_t next;
+        uint32_t frequency;
+        TRACE_Record records[TRACE_QUERY_RECORDS];
+    } block;
+    // Behind the oldest record, so that TRACE_read starts at the oldest
+    uint32_t sequence = TRACE_get_sequence() - TRACE_CAPACITY;
+
+    (void)SCPI_ParamUInt32(context, &sequence, false);
+    if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t const count =
+        TRACE_read(&sequence, block.records, TRACE_QUERY_RECORDS);
+    block.first = sequence;
+    block.next = TRACE_get_sequence();
+    block.frequency = PROFILE_get_frequency();
+    protocol_result_block(
+        context,
+        (uint8_t const *)&block,
+        sizeof(block) - ((TRACE_QUERY_RECORDS - count) * sizeof(TRACE_Record))
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:TRACe:STATe {ON|OFF} - Enable or disable event tracing
+ */
+static scpi_result_t scpi_cmd_system_trace_state(scpi_t *context)
+{
+    scpi_bool_t enabled = false;
+
+    if (!SCPI_ParamBool(context, &enabled, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    TRACE_set_enabled(enabled);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:TRACe:STATe? - Query whether event tracing is enabled
+ */
+static scpi_result_t scpi_cmd_system_trace_state_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, TRACE_is_enabled());
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:TRACe:ITM {ON|OFF} - Stream trace records out of SWO
+ */
+static scpi_result_t scpi_cmd_system_trace_itm(scpi_t *context)
+{
+    scpi_bool_t enabled = false;
+
+    if (!SCPI_ParamBool(context, &enabled, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    SYSTEM_set_trace_itm(enabled);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:TRACe:ITM? - Query whether trace records go out of SWO
+ */
+static scpi_result_t scpi_cmd_system_trace_itm_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, SYSTEM_get_trace_itm());
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:TRACe:CLEar - Discard the event trace
+ */
+static scpi_result_t scpi_cmd_system_trace_clear(scpi_t *context)
+{
+    (void)context; // Unused parameter
+
+    TRACE_clear();
+    return SCPI_RES_OK;
+}
+
+// Parities of SYSTem:COMMunicate:SERial, in UART_LineParity order
+static scpi_choice_def_t const g_UART_PARITY_CHOICES[] = {
+    { "NONE", UART_LINE_PARITY_NONE },
+    { "EVEN", UART_LINE_PARITY_EVEN },
+    { "ODD", UART_LINE_PARITY_ODD },
+    SCPI_CHOICE_LIST_END
+};
+
+/**
+ * @brief SYSTem:COMMunicate:SERial - Set the system UART line settings
+ *
+ * Parameters are the baudrate, then optionally the parity and the number of
+ * stop bits, e.g. SYST:COMM:SER 2000000,EVEN,1. Omitted settings are kept.
+ */
+static scpi_result_t scpi_cmd_system_communicate_serial(scpi_t *context)
+{
+    UART_LineConfig config = SYSTEM_get_uart_config();
+    int32_t parity = config.parity;
+    uint32_t stop_bits = config.stop_bits == UART_LINE_STOP_BITS_2 ? 2 : 1;
+
+    if (!SCPI_ParamUInt32(context, &config.baudrate, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    (void)SCPI_ParamChoice(context, g_UART_PARITY_CHOICES, &parity, false);
+    (void)SCPI_ParamUInt32(context, &stop_bits, false);
+    if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+    if (stop_bits != 1 && stop_bits != 2) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    config.parity = (UART_LineParity)parity;
+    config.stop_bits =
+        stop_bits == 2 ? UART_LINE_STOP_BITS_2 : UART_LINE_STOP_BITS_1;
+    // 8x oversampling only above the highest 16x baudrate
+    config.oversampling = UART_LINE_OVERSAMPLING_AUTO;
+
+    Error err = ERROR_NONE;
+    TRY { SYSTEM_configure_uart(&config); }
+    CATCH(err)
+    {
+        SCPI_ErrorPush(
+            context,
+            err == ERROR_INVALID_ARGUMENT ? SCPI_ERROR_ILLEGAL_PARAMETER_VALUE
+                                          : SCPI_ERROR_EXECUTION_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:COMMunicate:SERial? - Query the system UART line settings
+ *
+ * Returns the baudrate, NONE, EVEN or ODD, and the number of stop bits.
+ */
+static scpi_result_t scpi_cmd_system_communicate_serial_q(scpi_t *context)
+{
+    static char const *const parity_mnemonics[] = { "NONE", "EVEN", "ODD" };
+    UART_LineConfig const config = SYSTEM_get_uart_config();
+
+    SCPI_ResultUInt32(context, config.baudrate);
+    SCPI_ResultMnemonic(context, parity_mnemonics[config.parity]);
+    SCPI_ResultUInt32(
+        context, config.stop_bits == UART_LINE_STOP_BITS_2 ? 2 : 1
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:COMMunicate:BRIDge - Bridge the USB bridge port to a UART
+ *
+ * Parameter is the UART bus, e.g. SYST:COMM:BRID 0. The bridge runs until
+ * SYSTem:COMMunicate:BRIDge:STOP.
+ */
+static scpi_result_t scpi_cmd_system_communicate_bridge(scpi_t *context)
+{
+    uint32_t bus = 0;
+
+    if (!SCPI_ParamUInt32(context, &bus, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    Error err = ERROR_NONE;
+    TRY { BRIDGE_start(bus); }
+    CATCH(err)
+    {
+        SCPI_ErrorPush(
+            context,
+            err == ERROR_INVALID_ARGUMENT ? SCPI_ERROR_ILLEGAL_PARAMETER_VALUE
+                                          : SCPI_ERROR_EXECUTION_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:COMMunicate:BRIDge:STOP - Stop the USB-UART bridge
+ */
+static scpi_result_t scpi_cmd_system_communicate_bridge_stop(scpi_t *context)
+{
+    (void)context;
+    BRIDGE_stop();
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:COMMunicate:BRIDge? - Query the bridged UART bus
+ *
+ * Returns the UART bus, or OFF when the bridge is not running.
+ */
+static scpi_result_t scpi_cmd_system_communicate_bridge_q(scpi_t *context)
+{
+    size_t bus = 0;
+
+    if (BRIDGE_active(&bus)) {
+        SCPI_ResultUInt32(context, (uint32_t)bus);
+    } else {
+        SCPI_ResultMnemonic(context, "OFF");
+    }
+    return SCPI_RES_OK;
+}
+
+static void session_start(Session *session);
+
+/**
+ * @brief Open a session on a USB serial port
+ *
+ * @return false if the interface cannot be opened
+ */
+static bool session_open_usb(Session *session, uint32_t interface)
+{
+    circular_buffer_init(
+        &session->rx_buffer, session->rx_data, USB_RX_BUFFER_SIZE
+    );
+    circular_buffer_init(
+        &session->tx_buffer, session->tx_data, USB_TX_BUFFER_SIZE
+    );
+
+    session->usb =
+        USB_init(interface, &session->rx_buffer, &session->tx_buffer);
+    if (!session->usb) {
+        return false;
+    }
+
+    USB_set_rx_callback(session->usb, usb_rx_callback, 1);
+
+    // Service USB from its interrupt so responses are not held up by
+    // commands that block the main loop
+    USB_set_event_driven(session->usb, true);
+
+    session->port = PORT_USB;
+    session->number = interface;
+    session_start(session);
+    return true;
+}
+
+/**
+ * @brief Open a session on a UART bus, 8N1 at the given baudrate
+ */
+static void session_open_uart(
+    Session *session,
+    uint32_t bus,
+    uint32_t baud,
+    bool flow_control
+)
+{
+    circular_buffer_init(
+        &session->rx_buffer, session->rx_data, USB_RX_BUFFER_SIZE
+    );
+    circular_buffer_init(
+        &session->tx_buffer, session->tx_data, USB_TX_BUFFER_SIZE
+    );
+
+    session->uart = UART_init(bus, &session->rx_buffer, &session->tx_buffer);
+
+    Error err = ERROR_NONE;
+    TRY
+    {
+        UART_LineConfig config = UART_LINE_CONFIG_DEFAULT;
+        config.baudrate = baud;
+        config.flow_control = flow_control;
+        UART_configure(session->uart, &config);
+    }
+    CATCH(err)
+    {
+        UART_deinit(session->uart);
+        session->uart = nullptr;
+        THROW(err);
+    }
+
+    session->port = PORT_UART;
+    session->number = bus;
+    session_start(session);
+}
+
+/**
+ * @brief Close a session and release its port
+ */
+static void session_close(Session *session)
+{
+    if (session->usb) {
+        USB_deinit(session->usb);
+    }
+    if (session->uart) {
+        UART_deinit(session->uart);
+    }
+    memset(session, 0, sizeof(*session));
+    if (g_session == session) {
+        g_session = &g_sessions[0];
+    }
+}
+
+/**
+ * @brief Find a session to open, session 0 aside
+ *
+ * @return Free session, nullptr if all are open
+ */
+static Session *free_session(void)
+{
+    for (size_t i = 1; i < SESSIONS_MAX; ++i) {
+        if (g_sessions[i].port == PORT_NONE) {
+            return &g_sessions[i];
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Get the number of a session, as SYSTem:COMMunicate:SESSion? has it
+ */
+static uint32_t session_number(Session const *session)
+{
+    return (uint32_t)(session - g_sessions);
+}
+
+/**
+ * @brief SYSTem:COMMunicate:SESSion:USB - Open a session on the USB bridge
+ * port
+ *
+ * The bridge port is the device's second USB serial port; the session
+ * takes it while no bridge runs, see SYSTem:COMMunicate:BRIDge.
+ */
+static scpi_result_t scpi_cmd_system_communicate_session_usb(scpi_t *context)
+{
+    Session *const session = free_session();
+
+    if (!session) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    bool opened = false;
+    Error err = ERROR_NONE;
+    TRY { opened = session_open_usb(session, USB_INTERFACE_BRIDGE); }
+    CATCH(err) { opened = false; }
+    if (!opened) {
+        memset(session, 0, sizeof(*session));
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+// Flow control of SYSTem:COMMunicate:SESSion:UART
+static scpi_choice_def_t const g_UART_FLOW_CHOICES[] = {
+    { "NONE", false },
+    { "HARDware", true },
+    SCPI_CHOICE_LIST_END
+};
+
+/**
+ * @brief SYSTem:COMMunicate:SESSion:UART - Open a session on a UART bus
+ *
+ * Parameters are the UART bus, then optionally the baudrate (115200 by
+ * default) and the flow control, NONE or HARDware for RTS/CTS (NONE by
+ * default), e.g. SYST:COMM:SESS:UART 1,921600,HARD. The line is 8N1.
+ */
+static scpi_result_t scpi_cmd_system_communicate_session_uart(scpi_t *context)
+{
+    uint32_t bus = 0;
+    uint32_t baudrate = UART_LINE_CONFIG_DEFAULT.baudrate;
+    int32_t flow_control = false;
+
+    if (!SCPI_ParamUInt32(context, &bus, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    (void)SCPI_ParamUInt32(context, &baudrate, false);
+    (void)SCPI_ParamChoice(
+        context, g_UART_FLOW_CHOICES, &flow_control, false
+    );
+    if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    Session *const session = free_session();
+    if (!session) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    Error err = ERROR_NONE;
+    TRY { session_open_uart(session, bus, baudrate, flow_control != 0); }
+    CATCH(err)
+    {
+        memset(session, 0, sizeof(*session));
+        SCPI_ErrorPush(
+            context,
+            err == ERROR_INVALID_ARGUMENT ? SCPI_ERROR_ILLEGAL_PARAMETER_VALUE
+                                          : SCPI_ERROR_EXECUTION_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:COMMunicate:SESSion:CLOSe - Close a session
+ *
+ * Parameter is the session, by default the one the command came from.
+ * Session 0, the SCPI port, stays open. The session closes once its
+ * current line has run.
+ */
+static scpi_result_t scpi_cmd_system_communicate_session_close(scpi_t *context)
+{
+    uint32_t number = session_number(context->user_context);
+
+    (void)SCPI_ParamUInt32(context, &number, false);
+    if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+    if (number == 0 || number >= SESSIONS_MAX ||
+        g_sessions[number].port == PORT_NONE) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_sessions[number].closing = true;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:COMMunicate:SESSion? - Query the session of the command
+ *
+ * Returns its number, 0 for the SCPI port.
+ */
+static scpi_result_t scpi_cmd_system_communicate_session_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, session_number(context->user_context));
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:COMMunicate:SESSion:CATalog? - Query the ports of the
+ * sessions
+ *
+ * Returns one mnemonic per session, in session order: CDC for the SCPI
+ * port, BRID for the USB bridge port, UART<bus> for a UART bus, and OFF
+ * for a free session.
+ */
+static scpi_result_t
+scpi_cmd_system_communicate_session_catalog_q(scpi_t *context)
+{
+    for (size_t i = 0; i < SESSIONS_MAX; ++i) {
+        Session const *const session = &g_sessions[i];
+        char mnemonic[sizeof("UART") + FORMAT_UINT32_SIZE_MAX] = "OFF";
+        if (session->port == PORT_USB) {
+            strcpy(
+                mnemonic,
+                session->number == USB_INTERFACE_CDC ? "CDC" : "BRID"
+            );
+        } else if (session->port == PORT_UART) {
+            strcpy(mnemonic, "UART");
+            size_t const length =
+                4 + FORMAT_uint32(session->number, &mnemonic[4]);
+            mnemonic[length] = '\0';
+        }
+        SCPI_ResultMnemonic(context, mnemonic);
+    }
+    return SCPI_RES_OK;
+}
+
+// Loopbacks of SYSTem:TEST:UART
+static scpi_choice_def_t const g_LOOPBACK_CHOICES[] = {
+    { "INTernal", 0 },
+    { "EXTernal", 1 },
+    SCPI_CHOICE_LIST_END
+};
 
-// Static storage for buffers
-static uint8_t g_usb_rx_buffer_data[USB_RX_BUFFER_SIZE];
-static uint8_t g_usb_tx_buffer_data[USB_TX_BUFFER_SIZE];
-static CircularBuffer g_usb_rx_buffer;
-static CircularBuffer g_usb_tx_buffer;
-static USB_Handle *g_usb_handle = nullptr;
+static bool loopback_done(void) { return !LOOPBACK_running(); }
 
-// SCPI context and buffers (internal to protocol module)
-static scpi_t g_scpi_context;
-static char g_scpi_input_buffer[SCPI_INPUT_BUFFER_SIZE];
-static scpi_error_t g_scpi_error_queue_data[SCPI_ERROR_QUEUE_SIZE];
+/**
+ * @brief SYSTem:TEST:UART - Start a UART loopback self-test
+ *
+ * Parameters are the UART bus and the baudrate, then optionally the bytes
+ * of the throughput phase (16384 by default) and INTernal, looping back
+ * inside the USART, or EXTernal, for a strap between TX and RX, e.g.
+ * SYST:TEST:UART 1,2000000,65536,EXT.
+ */
+static scpi_result_t scpi_cmd_system_test_uart(scpi_t *context)
+{
+    uint32_t bus = 0;
+    uint32_t baudrate = 0;
+    uint32_t bytes = LOOPBACK_BYTES_DEFAULT;
+    int32_t external = 0;
 
-// Protocol state (internal to common.c)
-static bool g_protocol_initialized = false;
+    if (!SCPI_ParamUInt32(context, &bus, true) ||
+        !SCPI_ParamUInt32(context, &baudrate, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    (void)SCPI_ParamUInt32(context, &bytes, false);
+    (void)SCPI_ParamChoice(context, g_LOOPBACK_CHOICES, &external, false);
+    if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    Error err = ERROR_NONE;
+    TRY { LOOPBACK_start(bus, baudrate, bytes, external != 0); }
+    CATCH(err)
+    {
+        SCPI_ErrorPush(
+            context,
+            err == ERROR_INVALID_ARGUMENT ? SCPI_ERROR_ILLEGAL_PARAMETER_VALUE
+                                          : SCPI_ERROR_EXECUTION_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+
+    // The test gives up by itself once its bytes are overdue
+    protocol_operation_pending(loopback_done, UINT32_MAX);
+    return SCPI_RES_OK;
+}
 
 /**
- * @brief USB RX callback - called when data is received
+ * @brief SYSTem:TEST:UART:STOP - Stop the UART loopback self-test
  */
-static void usb_rx_callback(USB_Handle *handle, uint32_t bytes_available)
+static scpi_result_t scpi_cmd_system_test_uart_stop(scpi_t *context)
 {
-    (void)handle; // Unused parameter
-    (void)bytes_available; // Unused parameter
-    // Data processing will happen in the main protocol task
+    (void)context;
+    LOOPBACK_stop();
+    return SCPI_RES_OK;
 }
 
 /**
- * @brief SCPI write function - sends data via USB
+ * @brief SYSTem:TEST:UART? - Query the UART loopback self-test results
+ *
+ * Returns whether the test runs, the baudrate, the bytes received in the
+ * throughput phase, their rate in bytes/s, the errors, the RX overruns, and
+ * the shortest, mean and longest latency of single bytes in us.
  */
-static size_t protocol_write(scpi_t *context, char const *data, size_t len)
+static scpi_result_t scpi_cmd_system_test_uart_q(scpi_t *context)
 {
-    (void)context; // Unused parameter
+    LOOPBACK_Result const result = LOOPBACK_get_result();
+    uint32_t const values[] = {
+        result.running ? 1 : 0,
+        result.baudrate,
+        result.bytes,
+        result.bytes_per_second,
+        result.errors,
+        result.overruns,
+        result.latency_min_us,
+        result.latency_mean_us,
+        result.latency_max_us,
+    };
 
-    if (!g_usb_handle) {
-        return 0;
+    SCPI_ResultArrayUInt32(
+        context, values, sizeof(values) / sizeof(values[0]), SCPI_FORMAT_ASCII
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Map an error from the update module to a SCPI error
+ */
+static int16_t update_scpi_error(Error err)
+{
+    switch (err) {
+    case ERROR_INVALID_ARGUMENT:
+        return SCPI_ERROR_ILLEGAL_PARAMETER_VALUE;
+    case ERROR_DEVICE_NOT_READY:
+        return SCPI_ERROR_SETTINGS_CONFLICT;
+    default:
+        return SCPI_ERROR_EXECUTION_ERROR;
     }
+}
 
-    return USB_write(g_usb_handle, (uint8_t const *)data, (uint32_t)len);
+/**
+ * @brief SYSTem:UPDate:BEGin - Start writing a new firmware image
+ *
+ * The image goes to the inactive flash bank while the instrument carries
+ * on. Any image written before is dropped.
+ */
+static scpi_result_t scpi_cmd_system_update_begin(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    TRY { UPDATE_begin(); }
+    CATCH(err)
+    {
+        SCPI_ErrorPush(context, update_scpi_error(err));
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
 }
 
 /**
- * @brief SCPI reset function
+ * @brief SYSTem:UPDate:DATA - Write part of the firmware image
+ *
+ * Parameters are the offset into the image, a multiple of 16, and the
+ * bytes as a definite length arbitrary block, e.g.
+ * SYST:UPD:DATA 1024,#3128<128 bytes>. Parts must fit the SCPI input
+ * buffer along with the command, so 128 bytes is a convenient size.
  */
-static scpi_result_t protocol_reset(scpi_t *context)
+static scpi_result_t scpi_cmd_system_update_data(scpi_t *context)
 {
-    (void)context; // Unused parameter
+    uint32_t offset = 0;
+    char const *data = nullptr;
+    size_t size = 0;
 
-    // Reset DMM state (implemented in dmm.c)
-    dmm_reset_state();
+    if (!SCPI_ParamUInt32(context, &offset, true) ||
+        !SCPI_ParamArbitraryBlock(context, &data, &size, true)) {
+        return SCPI_RES_ERR;
+    }
 
-    // Reset DSO state (implemented in dso.c)
-    dso_reset_state();
+    Error err = ERROR_NONE;
+    TRY { UPDATE_write(offset, data, (uint32_t)size); }
+    CATCH(err)
+    {
+        SCPI_ErrorPush(context, update_scpi_error(err));
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:UPDate:END - Seal the firmware image once fully written
+ */
+static scpi_result_t scpi_cmd_system_update_end(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    TRY { UPDATE_finish(); }
+    CATCH(err)
+    {
+        SCPI_ErrorPush(context, update_scpi_error(err));
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:UPDate:APPLy - Reboot into the sealed firmware image
+ *
+ * The bootloader checks the image, swaps the flash banks and starts it.
+ * The previous firmware stays in the inactive bank.
+ */
+static scpi_result_t scpi_cmd_system_update_apply(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    TRY { UPDATE_apply(); }
+    CATCH(err)
+    {
+        SCPI_ErrorPush(context, update_scpi_error(err));
+        return SCPI_RES_ERR;
+    }
+    SYSTEM_reset();
+}
 
+/**
+ * @brief SYSTem:UPDate:STATe? - Query the progress of the firmware update
+ *
+ * Returns IDLE, REC or READY.
+ */
+static scpi_result_t scpi_cmd_system_update_state_q(scpi_t *context)
+{
+    static char const *const state_mnemonics[] = { "IDLE", "REC", "READY" };
+
+    SCPI_ResultMnemonic(context, state_mnemonics[UPDATE_get_state()]);
     return SCPI_RES_OK;
 }
 
@@ -118,39 +2444,140 @@ static scpi_result_t protocol_reset(scpi_t *context)
 static scpi_interface_t g_scpi_interface = {
     .error = nullptr,
     .write = protocol_write,
-    .control = nullptr,
-    .flush = nullptr,
+    .control = protocol_control,
+    .flush = protocol_flush,
     .reset = protocol_reset,
 };
 
 // SCPI command tree
+//
+// The parser tries the patterns in table order and takes the first match,
+// so each command costs one pattern match per entry ahead of it. No header
+// matches two patterns, which leaves the order free for speed.
 static scpi_command_t const g_SCPI_COMMANDS[] = {
+    // Queries a test executive polls at high rate, matched first
+    { "*OPC?", scpi_cmd_opc_q },
+    { "DMM:READ[:VOLTage][:DC]?", scpi_cmd_read_voltage_dc },
+    { "OSCilloscope:FETCh[:DATa]?", scpi_cmd_fetch_oscilloscope_data_q },
+
     // IEEE 488.2 mandatory commands
     { "*RST", SCPI_CoreRst },
     { "*IDN?", SCPI_CoreIdnQ },
     { "*TST?", SCPI_CoreTstQ },
-    { "*CLS", SCPI_CoreCls },
+    { "*CLS", scpi_cmd_cls },
     { "*ESE", SCPI_CoreEse },
     { "*ESE?", SCPI_CoreEseQ },
     { "*ESR?", SCPI_CoreEsrQ },
-    { "*OPC", SCPI_CoreOpc },
-    { "*OPC?", SCPI_CoreOpcQ },
+    { "*OPC", scpi_cmd_opc },
     { "*SRE", SCPI_CoreSre },
     { "*SRE?", SCPI_CoreSreQ },
     { "*STB?", SCPI_CoreStbQ },
-    { "*WAI", SCPI_CoreWai },
+    { "*WAI", scpi_cmd_wai },
+    { "*SAV", scpi_cmd_save_setup },
+    { "*RCL", scpi_cmd_recall_setup },
 
     /* Required SCPI commands (SCPI std V1999.0 4.2.1) */
     { "SYSTem:ERRor[:NEXT]?", SCPI_SystemErrorNextQ },
     { "SYSTem:ERRor:COUNt?", SCPI_SystemErrorCountQ },
     { "SYSTem:VERSion?", SCPI_SystemVersionQ },
+    { "STATus:OPERation[:EVENt]?", SCPI_StatusOperationEventQ },
+    { "STATus:OPERation:CONDition?", SCPI_StatusOperationConditionQ },
+    { "STATus:OPERation:ENABle", SCPI_StatusOperationEnable },
+    { "STATus:OPERation:ENABle?", SCPI_StatusOperationEnableQ },
+    { "STATus:PRESet", SCPI_StatusPreset },
+    { "SYSTem:PROFile?", scpi_cmd_system_profile_q },
+    { "SYSTem:PROFile:CLEar", scpi_cmd_system_profile_clear },
+    { "SYSTem:STATistics:COMMands?", scpi_cmd_system_statistics_commands_q },
+    { "SYSTem:STATistics:COMMands:CLEar",
+      scpi_cmd_system_statistics_commands_clear },
+    { "SYSTem:BOOT?", scpi_cmd_system_boot_q },
+    { "SYSTem:MEMory?", scpi_cmd_system_memory_q },
+    { "SYSTem:STACk?", scpi_cmd_system_stack_q },
+    { "SYSTem:IRQ?", scpi_cmd_system_irq_q },
+    { "SYSTem:TIME:SOF?", scpi_cmd_system_time_sof_q },
+    { "SYSTem:LOG:LEVel", scpi_cmd_system_log_level },
+    { "SYSTem:LOG:LEVel?", scpi_cmd_system_log_level_q },
+    { "SYSTem:LOG:STATistics?", scpi_cmd_system_log_statistics_q },
+    { "SYSTem:LOG:STATistics:CLEar", scpi_cmd_system_log_statistics_clear },
+    { "SYSTem:LOG:SINK", scpi_cmd_system_log_sink },
+    { "SYSTem:LOG:SINK?", scpi_cmd_system_log_sink_q },
+    { "SYSTem:LOG?", scpi_cmd_system_log_q },
+    { "SYSTem:TRACe?", scpi_cmd_system_trace_q },
+    { "SYSTem:TRACe:STATe", scpi_cmd_system_trace_state },
+    { "SYSTem:TRACe:STATe?", scpi_cmd_system_trace_state_q },
+    { "SYSTem:TRACe:ITM", scpi_cmd_system_trace_itm },
+    { "SYSTem:TRACe:ITM?", scpi_cmd_system_trace_itm_q },
+    { "SYSTem:TRACe:CLEar", scpi_cmd_system_trace_clear },
+    { "SYSTem:COMMunicate:SERial", scpi_cmd_system_communicate_serial },
+    { "SYSTem:COMMunicate:SERial?", scpi_cmd_system_communicate_serial_q },
+    { "SYSTem:COMMunicate:BRIDge", scpi_cmd_system_communicate_bridge },
+    { "SYSTem:COMMunicate:BRIDge:STOP",
+      scpi_cmd_system_communicate_bridge_stop },
+    { "SYSTem:COMMunicate:BRIDge?", scpi_cmd_system_communicate_bridge_q },
+    { "SYSTem:COMMunicate:SESSion:USB",
+      scpi_cmd_system_communicate_session_usb },
+    { "SYSTem:COMMunicate:SESSion:UART",
+      scpi_cmd_system_communicate_session_uart },
+    { "SYSTem:COMMunicate:SESSion:CLOSe",
+      scpi_cmd_system_communicate_session_close },
+    { "SYSTem:COMMunicate:SESSion?", scpi_cmd_system_communicate_session_q },
+    { "SYSTem:COMMunicate:SESSion:CATalog?",
+      scpi_cmd_system_communicate_session_catalog_q },
+    { "SYSTem:COMMunicate:BINary", scpi_cmd_system_communicate_binary },
+    { "SYSTem:COMMunicate:BINary?", scpi_cmd_system_communicate_binary_q },
+    { "SYSTem:TEST:USB", scpi_cmd_system_test_usb },
+    { "SYSTem:TEST:USB:STOP", scpi_cmd_system_test_usb_stop },
+    { "SYSTem:TEST:USB?", scpi_cmd_system_test_usb_q },
+    { "SYSTem:TEST:UART", scpi_cmd_system_test_uart },
+    { "SYSTem:TEST:UART:STOP", scpi_cmd_system_test_uart_stop },
+    { "SYSTem:TEST:UART?", scpi_cmd_system_test_uart_q },
+    { "SYSTem:UPDate:BEGin", scpi_cmd_system_update_begin },
+    { "SYSTem:UPDate:DATA", scpi_cmd_system_update_data },
+    { "SYSTem:UPDate:END", scpi_cmd_system_update_end },
+    { "SYSTem:UPDate:APPLy", scpi_cmd_system_update_apply },
+    { "SYSTem:UPDate:STATe?", scpi_cmd_system_update_state_q },
 
     // DMM commands (Digital Multimeter)
     { "DMM:CONFigure[:VOLTage][:DC]", scpi_cmd_configure_voltage_dc },
+    { "DMM:CONFigure:AVERage", scpi_cmd_configure_average },
+    { "DMM:CONFigure:AVERage?", scpi_cmd_configure_average_q },
+    { "DMM:CONFigure:NPLCycles", scpi_cmd_configure_nplc },
+    { "DMM:CONFigure:NPLCycles?", scpi_cmd_configure_nplc_q },
+    { "DMM:CONFigure:LFRequency", scpi_cmd_configure_line_frequency },
+    { "DMM:CONFigure:LFRequency?", scpi_cmd_configure_line_frequency_q },
+    { "DMM:FORMat[:DATa]", scpi_cmd_format_data },
+    { "DMM:FORMat[:DATa]?", scpi_cmd_format_data_q },
     { "DMM:INITiate[:VOLTage][:DC]", scpi_cmd_initiate_voltage_dc },
+    { "DMM:INITiate:CONTinuous", scpi_cmd_initiate_continuous },
+    { "DMM:INITiate:CONTinuous?", scpi_cmd_initiate_continuous_q },
     { "DMM:FETCh[:VOLTage][:DC]?", scpi_cmd_fetch_voltage_dc },
-    { "DMM:READ[:VOLTage][:DC]?", scpi_cmd_read_voltage_dc },
+    { "DMM:FETCh:STATistics?", scpi_cmd_fetch_statistics },
     { "DMM:MEASure[:VOLTage][:DC]?", scpi_cmd_measure_voltage_dc },
+    { "DMM:SCAN[:VOLTage][:DC]?", scpi_cmd_scan_voltage_dc },
+    { "DMM:DIFFerential[:VOLTage][:DC]?", scpi_cmd_differential_voltage_dc },
+    { "DMM:READ:ARRay[:VOLTage][:DC]?", scpi_cmd_read_array_voltage_dc },
+    { "DMM:READ:CONVerge[:VOLTage][:DC]?",
+      scpi_cmd_read_converge_voltage_dc },
+    { "DMM:CONFigure:VOLTage:AC", scpi_cmd_configure_voltage_ac },
+    { "DMM:READ:VOLTage:AC?", scpi_cmd_read_voltage_ac },
+    { "DMM:MEASure:VOLTage:AC?", scpi_cmd_measure_voltage_ac },
+    { "DMM:CALibration[:VALue]", scpi_cmd_calibration_value },
+    { "DMM:CALibration[:VALue]?", scpi_cmd_calibration_value_q },
+    { "DMM:CALibration:STORe", scpi_cmd_calibration_store },
+    { "DMM:CALibration:RESet", scpi_cmd_calibration_reset },
+    { "DMM:WATCh:LIMits", scpi_cmd_watch_limits },
+    { "DMM:WATCh:LIMits?", scpi_cmd_watch_limits_q },
+    { "DMM:WATCh[:STATe]", scpi_cmd_watch_state },
+    { "DMM:WATCh[:STATe]?", scpi_cmd_watch_state_q },
+    { "DMM:WATCh:EVENt?", scpi_cmd_watch_event_q },
+    { "DMM:COUNt:LEVel", scpi_cmd_count_level },
+    { "DMM:COUNt:LEVel?", scpi_cmd_count_level_q },
+    { "DMM:COUNt:TIMestamps", scpi_cmd_count_timestamps },
+    { "DMM:COUNt:TIMestamps?", scpi_cmd_count_timestamps_q },
+    { "DMM:COUNt:TIMestamps:DATa?", scpi_cmd_count_timestamps_data_q },
+    { "DMM:COUNt[:STATe]", scpi_cmd_count_state },
+    { "DMM:COUNt[:STATe]?", scpi_cmd_count_state_q },
+    { "DMM:COUNt:EVENts?", scpi_cmd_count_events_q },
 
     // DSO commands (Digital Storage Oscilloscope)
     { "OSCilloscope:CONFigure:CHANnel",
@@ -165,19 +2592,351 @@ static scpi_command_t const g_SCPI_COMMANDS[] = {
       scpi_cmd_configure_oscilloscope_acquire_points },
     { "OSCilloscope:CONFigure:ACQuire[:POINts]?",
       scpi_cmd_configure_oscilloscope_acquire_points_q },
+    { "OSCilloscope:CONFigure:ACQuire:POINts:MAXimum?",
+      scpi_cmd_configure_oscilloscope_acquire_points_max_q },
+    { "OSCilloscope:CONFigure:APPLy",
+      scpi_cmd_configure_oscilloscope_apply },
     { "OSCilloscope:CONFigure:ACQuire:SRATe?",
       scpi_cmd_configure_oscilloscope_acquire_srate_q },
+    { "OSCilloscope:CONFigure:ACQuire:STIMe?",
+      scpi_cmd_configure_oscilloscope_acquire_stime_q },
+    { "OSCilloscope:CONFigure:ACQuire:TYPE",
+      scpi_cmd_configure_oscilloscope_acquire_type },
+    { "OSCilloscope:CONFigure:ACQuire:TYPE?",
+      scpi_cmd_configure_oscilloscope_acquire_type_q },
+    { "OSCilloscope:CONFigure:ACQuire:DECimation?",
+      scpi_cmd_configure_oscilloscope_acquire_decimation_q },
+    { "OSCilloscope:CONFigure:ACQuire:RESolution",
+      scpi_cmd_configure_oscilloscope_acquire_resolution },
+    { "OSCilloscope:CONFigure:ACQuire:RESolution?",
+      scpi_cmd_configure_oscilloscope_acquire_resolution_q },
+    { "OSCilloscope:CONFigure:ACQuire:RECords",
+      scpi_cmd_configure_oscilloscope_acquire_records },
+    { "OSCilloscope:CONFigure:ACQuire:RECords?",
+      scpi_cmd_configure_oscilloscope_acquire_records_q },
+    { "OSCilloscope:TRIGger[:MODE]", scpi_cmd_trigger_oscilloscope_mode },
+    { "OSCilloscope:TRIGger[:MODE]?", scpi_cmd_trigger_oscilloscope_mode_q },
+    { "OSCilloscope:TRIGger:LEVel", scpi_cmd_trigger_oscilloscope_level },
+    { "OSCilloscope:TRIGger:LEVel?", scpi_cmd_trigger_oscilloscope_level_q },
+    { "OSCilloscope:TRIGger:PRETrigger",
+      scpi_cmd_trigger_oscilloscope_pretrigger },
+    { "OSCilloscope:TRIGger:PRETrigger?",
+      scpi_cmd_trigger_oscilloscope_pretrigger_q },
+    { "OSCilloscope:TRIGger:POSition?",
+      scpi_cmd_trigger_oscilloscope_position_q },
+    { "OSCilloscope:SEGMent[:COUNt]", scpi_cmd_segment_oscilloscope_count },
+    { "OSCilloscope:SEGMent[:COUNt]?", scpi_cmd_segment_oscilloscope_count_q },
+    { "OSCilloscope:SEGMent:ACQuired?",
+      scpi_cmd_segment_oscilloscope_acquired_q },
+    { "OSCilloscope:SEGMent:TIMEstamps?",
+      scpi_cmd_segment_oscilloscope_timestamps_q },
+    { "OSCilloscope:SEGMent:POSitions?",
+      scpi_cmd_segment_oscilloscope_positions_q },
+    { "OSCilloscope:AVERage[:COUNt]", scpi_cmd_average_oscilloscope_count },
+    { "OSCilloscope:AVERage[:COUNt]?", scpi_cmd_average_oscilloscope_count_q },
+    { "OSCilloscope:AVERage:ACQuired?",
+      scpi_cmd_average_oscilloscope_acquired_q },
     { "OSCilloscope:INITiate", scpi_cmd_initiate_oscilloscope },
-    { "OSCilloscope:FETCh[:DATa]?", scpi_cmd_fetch_oscilloscope_data_q },
+    { "OSCilloscope:FETCh:ETIMe?", scpi_cmd_fetch_oscilloscope_etime_q },
+    { "OSCilloscope:FETCh:NEW?", scpi_cmd_fetch_oscilloscope_new_q },
+    { "OSCilloscope:FETCh:HISTogram?",
+      scpi_cmd_fetch_oscilloscope_histogram_q },
+    { "OSCilloscope:FETCh:MASK?", scpi_cmd_fetch_oscilloscope_mask_q },
+    { "OSCilloscope:MASK:DATA", scpi_cmd_mask_oscilloscope_data },
+    { "OSCilloscope:MASK[:STATe]", scpi_cmd_mask_oscilloscope_state },
+    { "OSCilloscope:MASK[:STATe]?", scpi_cmd_mask_oscilloscope_state_q },
+    { "OSCilloscope:FETCh:MEASure?",
+      scpi_cmd_fetch_oscilloscope_measure_q },
+    { "OSCilloscope:FETCh:SPECtrum?",
+      scpi_cmd_fetch_oscilloscope_spectrum_q },
+    { "OSCilloscope:FETCh:SPECtrum:PEAKs?",
+      scpi_cmd_fetch_oscilloscope_spectrum_peaks_q },
+    { "OSCilloscope:FETCh:SPECtrum:DISTortion?",
+      scpi_cmd_fetch_oscilloscope_spectrum_distortion_q },
+    { "OSCilloscope:FORMat[:DATa]", scpi_cmd_format_oscilloscope_data },
+    { "OSCilloscope:FORMat[:DATa]?", scpi_cmd_format_oscilloscope_data_q },
+    { "OSCilloscope:FORMat:HEADer", scpi_cmd_format_oscilloscope_header },
+    { "OSCilloscope:FORMat:HEADer?", scpi_cmd_format_oscilloscope_header_q },
+    { "OSCilloscope:CALibration:INTerleave",
+      scpi_cmd_calibration_oscilloscope_interleave },
+    { "OSCilloscope:CALibration:INTerleave?",
+      scpi_cmd_calibration_oscilloscope_interleave_q },
+    { "OSCilloscope:CALibration:INTerleave:RESet",
+      scpi_cmd_calibration_oscilloscope_interleave_reset },
     { "OSCilloscope:READ?", scpi_cmd_read_oscilloscope_q },
     { "OSCilloscope:MEASure?", scpi_cmd_measure_oscilloscope_q },
     { "OSCilloscope:ABORt", scpi_cmd_abort_oscilloscope },
+    { "OSCilloscope:AUTOset", scpi_cmd_autoset_oscilloscope },
     { "OSCilloscope:STATus:ACQuisition?",
       scpi_cmd_status_oscilloscope_acquisition_q },
+    { "OSCilloscope:STATus:INTegrity?",
+      scpi_cmd_status_oscilloscope_integrity_q },
+    { "OSCilloscope:STReam[:STARt]", scpi_cmd_stream_oscilloscope_start },
+    { "OSCilloscope:STReam:STOP", scpi_cmd_stream_oscilloscope_stop },
+    { "OSCilloscope:STReam?", scpi_cmd_stream_oscilloscope_q },
+    { "OSCilloscope:STReam:OVERruns?",
+      scpi_cmd_stream_oscilloscope_overruns_q },
+    { "OSCilloscope:STReam:INTerface",
+      scpi_cmd_stream_oscilloscope_interface },
+    { "OSCilloscope:STReam:INTerface?",
+      scpi_cmd_stream_oscilloscope_interface_q },
+    { "OSCilloscope:STReam:DECimation?",
+      scpi_cmd_stream_oscilloscope_decimation_q },
+    { "OSCilloscope:STReam:DECimation:AUTO",
+      scpi_cmd_stream_oscilloscope_decimation_auto },
+    { "OSCilloscope:STReam:DECimation:AUTO?",
+      scpi_cmd_stream_oscilloscope_decimation_auto_q },
+    { "OSCilloscope:STReam:MATH", scpi_cmd_stream_oscilloscope_math },
+    { "OSCilloscope:STReam:MATH?", scpi_cmd_stream_oscilloscope_math_q },
+    { "OSCilloscope:STReam:MATH:GAIN",
+      scpi_cmd_stream_oscilloscope_math_gain },
+    { "OSCilloscope:STReam:MATH:GAIN?",
+      scpi_cmd_stream_oscilloscope_math_gain_q },
+    { "OSCilloscope:STReam:MATH:ONLY",
+      scpi_cmd_stream_oscilloscope_math_only },
+    { "OSCilloscope:STReam:MATH:ONLY?",
+      scpi_cmd_stream_oscilloscope_math_only_q },
+    { "OSCilloscope:STReam:RECord[:STARt]",
+      scpi_cmd_stream_oscilloscope_record },
+    { "OSCilloscope:STReam:RECord?", scpi_cmd_stream_oscilloscope_record_q },
+    { "OSCilloscope:STReam:RECord:RATE?",
+      scpi_cmd_stream_oscilloscope_record_rate_q },
+    { "OSCilloscope:STReam:RECord:STATistics?",
+      scpi_cmd_stream_oscilloscope_record_statistics_q },
+    { "OSCilloscope:ROLL[:STARt]", scpi_cmd_roll_oscilloscope_start },
+    { "OSCilloscope:ROLL:STOP", scpi_cmd_roll_oscilloscope_stop },
+    { "OSCilloscope:ROLL?", scpi_cmd_roll_oscilloscope_q },
+    { "OSCilloscope:ROLL:SKIPped?", scpi_cmd_roll_oscilloscope_skipped_q },
+    { "OSCilloscope:HISTogram:RANGe", scpi_cmd_histogram_oscilloscope_range },
+    { "OSCilloscope:HISTogram:RANGe?",
+      scpi_cmd_histogram_oscilloscope_range_q },
+    { "OSCilloscope:HISTogram[:STARt]", scpi_cmd_histogram_oscilloscope_start },
+    { "OSCilloscope:HISTogram:STOP", scpi_cmd_histogram_oscilloscope_stop },
+    { "OSCilloscope:HISTogram?", scpi_cmd_histogram_oscilloscope_q },
+    { "OSCilloscope:HISTogram:COUNt?",
+      scpi_cmd_histogram_oscilloscope_count_q },
+
+    // Logic analyzer commands
+    { "LA:CONFigure:ACQuire:SRATe", scpi_cmd_configure_la_acquire_srate },
+    { "LA:CONFigure:ACQuire:SRATe?", scpi_cmd_configure_la_acquire_srate_q },
+    { "LA:CONFigure:ACQuire[:POINts]", scpi_cmd_configure_la_acquire_points },
+    { "LA:CONFigure:ACQuire[:POINts]?",
+      scpi_cmd_configure_la_acquire_points_q },
+    { "LA:CONFigure:ACQuire:POINts:MAXimum?",
+      scpi_cmd_configure_la_acquire_points_max_q },
+    { "LA:CONFigure:ACQuire:STORage",
+      scpi_cmd_configure_la_acquire_storage },
+    { "LA:CONFigure:ACQuire:STORage?",
+      scpi_cmd_configure_la_acquire_storage_q },
+    { "LA:TRIGger:PATTern", scpi_cmd_trigger_la_pattern },
+    { "LA:TRIGger:PATTern?", scpi_cmd_trigger_la_pattern_q },
+    { "LA:INITiate", scpi_cmd_initiate_la },
+    { "LA:ABORt", scpi_cmd_abort_la },
+    { "LA:FETCh[:DATa]?", scpi_cmd_fetch_la_data_q },
+    { "LA:READ?", scpi_cmd_read_la_q },
+    { "LA:STATus:ACQuisition?", scpi_cmd_status_la_acquisition_q },
+
+    // Waveform generator commands
+    { "WAVegen:FUNCtion", scpi_cmd_wavegen_function },
+    { "WAVegen:FUNCtion?", scpi_cmd_wavegen_function_q },
+    { "WAVegen:FREQuency", scpi_cmd_wavegen_frequency },
+    { "WAVegen:FREQuency?", scpi_cmd_wavegen_frequency_q },
+    { "WAVegen:FREQuency:MILLihertz", scpi_cmd_wavegen_frequency_millihertz },
+    { "WAVegen:FREQuency:MILLihertz?",
+      scpi_cmd_wavegen_frequency_millihertz_q },
+    { "WAVegen:MODE", scpi_cmd_wavegen_mode },
+    { "WAVegen:MODE?", scpi_cmd_wavegen_mode_q },
+    { "WAVegen:VOLTage:AMPLitude", scpi_cmd_wavegen_voltage_amplitude },
+    { "WAVegen:VOLTage:AMPLitude?", scpi_cmd_wavegen_voltage_amplitude_q },
+    { "WAVegen:VOLTage:OFFSet", scpi_cmd_wavegen_voltage_offset },
+    { "WAVegen:VOLTage:OFFSet?", scpi_cmd_wavegen_voltage_offset_q },
+    { "WAVegen:DATA", scpi_cmd_wavegen_data },
+    { "WAVegen:DATA:POINts", scpi_cmd_wavegen_data_points },
+    { "WAVegen:DATA:POINts?", scpi_cmd_wavegen_data_points_q },
+    { "WAVegen:OUTPut[:STATe]", scpi_cmd_wavegen_output },
+    { "WAVegen:OUTPut[:STATe]?", scpi_cmd_wavegen_output_q },
+
+    // Frequency counter commands
+    { "FREQuency:MEASure?", scpi_cmd_frequency_measure_q },
+    { "FREQuency:PERiod?", scpi_cmd_frequency_period_q },
+    { "FREQuency:GATE", scpi_cmd_frequency_gate },
+    { "FREQuency:GATE?", scpi_cmd_frequency_gate_q },
+
+    // Power meter commands
+    { "POWer:CONFigure", scpi_cmd_power_configure },
+    { "POWer:CONFigure?", scpi_cmd_power_configure_q },
+    { "POWer:SCALe", scpi_cmd_power_scale },
+    { "POWer:SCALe?", scpi_cmd_power_scale_q },
+    { "POWer:INITiate", scpi_cmd_power_initiate },
+    { "POWer:ABORt", scpi_cmd_power_abort },
+    { "POWer:CLEar", scpi_cmd_power_clear },
+    { "POWer:STATe?", scpi_cmd_power_state_q },
+    { "POWer:FETCh?", scpi_cmd_power_fetch_q },
+
+    // Frequency response sweep commands
+    { "SWEep:FREQuency", scpi_cmd_sweep_frequency },
+    { "SWEep:FREQuency?", scpi_cmd_sweep_frequency_q },
+    { "SWEep:POINts", scpi_cmd_sweep_points },
+    { "SWEep:POINts?", scpi_cmd_sweep_points_q },
+    { "SWEep:SPACing", scpi_cmd_sweep_spacing },
+    { "SWEep:SPACing?", scpi_cmd_sweep_spacing_q },
+    { "SWEep:VOLTage", scpi_cmd_sweep_voltage },
+    { "SWEep:VOLTage?", scpi_cmd_sweep_voltage_q },
+    { "SWEep:SETTle", scpi_cmd_sweep_settle },
+    { "SWEep:SETTle?", scpi_cmd_sweep_settle_q },
+    { "SWEep:CYCLes", scpi_cmd_sweep_cycles },
+    { "SWEep:CYCLes?", scpi_cmd_sweep_cycles_q },
+    { "SWEep:INITiate", scpi_cmd_sweep_initiate },
+    { "SWEep:ABORt", scpi_cmd_sweep_abort },
+    { "SWEep:STATe?", scpi_cmd_sweep_state_q },
+    { "SWEep:COUNt?", scpi_cmd_sweep_count_q },
+    { "SWEep:DATA?", scpi_cmd_sweep_data_q },
+
+    // PWM generator commands
+    { "PWM:FREQuency", scpi_cmd_pwm_frequency },
+    { "PWM:FREQuency?", scpi_cmd_pwm_frequency_q },
+    { "PWM:DUTY", scpi_cmd_pwm_duty },
+    { "PWM:DUTY?", scpi_cmd_pwm_duty_q },
+    { "PWM:PHASe", scpi_cmd_pwm_phase },
+    { "PWM:PHASe?", scpi_cmd_pwm_phase_q },
+    { "PWM:ENABle", scpi_cmd_pwm_enable },
+    { "PWM:ENABle?", scpi_cmd_pwm_enable_q },
+    { "PWM:OUTPut[:STATe]", scpi_cmd_pwm_output },
+    { "PWM:OUTPut[:STATe]?", scpi_cmd_pwm_output_q },
+
+    // Synchronized start commands
+    { "INITiate:ALL", scpi_cmd_initiate_all },
+    { "INITiate:ALL:ARM", scpi_cmd_initiate_all_arm },
+    { "INITiate:ALL:ARM?", scpi_cmd_initiate_all_arm_q },
+    { "INITiate:ALL:SOURce", scpi_cmd_initiate_all_source },
+    { "INITiate:ALL:SOURce?", scpi_cmd_initiate_all_source_q },
+    { "INITiate:ALL:OUTPut", scpi_cmd_initiate_all_output },
+    { "INITiate:ALL:OUTPut?", scpi_cmd_initiate_all_output_q },
+
+    // I2C bus pass-through commands
+    { "BUS:I2C:FREQuency", scpi_cmd_bus_i2c_frequency },
+    { "BUS:I2C:FREQuency?", scpi_cmd_bus_i2c_frequency_q },
+    { "BUS:I2C:REGister:SIZE", scpi_cmd_bus_i2c_register_size },
+    { "BUS:I2C:REGister:SIZE?", scpi_cmd_bus_i2c_register_size_q },
+    { "BUS:I2C:WRITe", scpi_cmd_bus_i2c_write },
+    { "BUS:I2C:READ?", scpi_cmd_bus_i2c_read_q },
+    { "BUS:SPI:FREQuency", scpi_cmd_bus_spi_frequency },
+    { "BUS:SPI:FREQuency?", scpi_cmd_bus_spi_frequency_q },
+    { "BUS:SPI:MODE", scpi_cmd_bus_spi_mode },
+    { "BUS:SPI:MODE?", scpi_cmd_bus_spi_mode_q },
+    { "BUS:SPI:ORDer", scpi_cmd_bus_spi_order },
+    { "BUS:SPI:ORDer?", scpi_cmd_bus_spi_order_q },
+    { "BUS:SPI:TRANsfer?", scpi_cmd_bus_spi_transfer_q },
+    { "LOG:CHANnels", scpi_cmd_log_channels },
+    { "LOG:CHANnels?", scpi_cmd_log_channels_q },
+    { "LOG:INTerval", scpi_cmd_log_interval },
+    { "LOG:INTerval?", scpi_cmd_log_interval_q },
+    { "LOG:STARt", scpi_cmd_log_start },
+    { "LOG:STOP", scpi_cmd_log_stop },
+    { "LOG:STATe?", scpi_cmd_log_state_q },
+    { "LOG:CAPacity?", scpi_cmd_log_capacity_q },
+    { "LOG:SIZE?", scpi_cmd_log_size_q },
+    { "LOG:COUNt?", scpi_cmd_log_count_q },
+    { "LOG:SESSion?", scpi_cmd_log_session_q },
+    { "LOG:DATA?", scpi_cmd_log_data_q },
+    { "SEQuence:DEFine", scpi_cmd_sequence_define },
+    { "SEQuence:RUN", scpi_cmd_sequence_run },
+    { "SEQuence:ABORt", scpi_cmd_sequence_abort },
+    { "SEQuence:STATe?", scpi_cmd_sequence_state_q },
+    { "SEQuence:LINE?", scpi_cmd_sequence_line_q },
+    { "SEQuence:WAIT", scpi_cmd_sequence_wait },
+    { "SEQuence:LIMit", scpi_cmd_sequence_limit },
+    { "SEQuence:RESult?", scpi_cmd_sequence_result_q },
+    { "SEQuence:FAILures?", scpi_cmd_sequence_failures_q },
 
     SCPI_CMD_LIST_END
 };
 
+enum {
+    // Entries of g_SCPI_COMMANDS, without the end marker
+    SCPI_COMMAND_COUNT =
+        (sizeof(g_SCPI_COMMANDS) / sizeof(g_SCPI_COMMANDS[0])) - 1,
+};
+
+// Handler durations of each g_SCPI_COMMANDS entry, in table order
+static PROFILE_Stats g_command_stats[SCPI_COMMAND_COUNT];
+
+// The tree the parser matches: the patterns of g_SCPI_COMMANDS, tagged
+// with their index and all dispatched through dispatch_command
+static scpi_command_t g_scpi_dispatch[SCPI_COMMAND_COUNT + 1];
+
+/**
+ * @brief Run the handler of the matched command and time it
+ *
+ * Only the call itself is timed: the rest of a deferred query, and the
+ * operation an overlapped command starts, run later from protocol_task.
+ */
+static scpi_result_t dispatch_command(scpi_t *context)
+{
+    int32_t const index = SCPI_CmdTag(context);
+    uint32_t const start = PROFILE_begin();
+    scpi_result_t const result = g_SCPI_COMMANDS[index].callback(context);
+    PROFILE_record(&g_command_stats[index], start);
+    return result;
+}
+
+/**
+ * @brief Fill the dispatch tree from g_SCPI_COMMANDS, once
+ */
+static void dispatch_init(void)
+{
+    if (g_scpi_dispatch[0].pattern != nullptr) {
+        return;
+    }
+    for (size_t i = 0; i < SCPI_COMMAND_COUNT; ++i) {
+        g_scpi_dispatch[i] = (scpi_command_t){
+            .pattern = g_SCPI_COMMANDS[i].pattern,
+            .callback = dispatch_command,
+            .tag = (int32_t)i,
+        };
+    }
+    g_scpi_dispatch[SCPI_COMMAND_COUNT] = g_SCPI_COMMANDS[SCPI_COMMAND_COUNT];
+}
+
+/**
+ * @brief SYSTem:STATistics:COMMands? - Query the SCPI command durations
+ *
+ * Returns the cycle counter frequency in Hz, followed by the pattern, the
+ * call count and the shortest, longest and mean handler run in cycles of
+ * each command called since startup or the last clear, in table order.
+ */
+static scpi_result_t scpi_cmd_system_statistics_commands_q(scpi_t *context)
+{
+    SCPI_ResultInt32(context, saturate_int32(PROFILE_get_frequency()));
+    for (size_t i = 0; i < SCPI_COMMAND_COUNT; ++i) {
+        PROFILE_Stats const *const stats = &g_command_stats[i];
+        if (stats->count == 0) {
+            continue;
+        }
+        SCPI_ResultMnemonic(context, g_SCPI_COMMANDS[i].pattern);
+        SCPI_ResultInt32(context, saturate_int32(stats->count));
+        SCPI_ResultInt32(context, saturate_int32(stats->min));
+        SCPI_ResultInt32(context, saturate_int32(stats->max));
+        SCPI_ResultInt32(
+            context, saturate_int32(stats->total / stats->count)
+        );
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:STATistics:COMMands:CLEar - Discard the command durations
+ */
+static scpi_result_t scpi_cmd_system_statistics_commands_clear(
+    scpi_t *context
+)
+{
+    (void)context; // Unused parameter
+
+    memset(g_command_stats, 0, sizeof(g_command_stats));
+    return SCPI_RES_OK;
+}
+
 /**
  * @brief Initialize the SCPI protocol
  */
@@ -187,43 +2946,37 @@ bool protocol_init(void)
         return true;
     }
 
-    // Initialize USB RX buffer
-    circular_buffer_init(
-        &g_usb_rx_buffer, g_usb_rx_buffer_data, USB_RX_BUFFER_SIZE
-    );
-
-    // Initialize USB TX buffer
-    circular_buffer_init(
-        &g_usb_tx_buffer, g_usb_tx_buffer_data, USB_TX_BUFFER_SIZE
-    );
-
-    // Initialize USB interface
-    g_usb_handle = USB_init(0, &g_usb_rx_buffer, &g_usb_tx_buffer);
-    if (!g_usb_handle) {
+    // Session 0 on the SCPI port
+    g_session = &g_sessions[0];
+    if (!session_open_usb(g_session, USB_INTERFACE_CDC)) {
         return false;
     }
 
-    // Set USB RX callback
-    USB_set_rx_callback(g_usb_handle, usb_rx_callback, 1);
+    g_protocol_initialized = true;
+    return true;
+}
 
-    // Initialize SCPI context
+/**
+ * @brief Initialize the SCPI context of a session just opened
+ */
+static void session_start(Session *session)
+{
+    dispatch_init();
     SCPI_Init(
-        &g_scpi_context,
-        g_SCPI_COMMANDS,
+        &session->context,
+        g_scpi_dispatch,
         &g_scpi_interface,
         scpi_units_def,
         "FOSSASIA",
         "PSLab",
         "1.0",
         "v1.0.0",
-        g_scpi_input_buffer,
+        session->input_buffer,
         SCPI_INPUT_BUFFER_SIZE,
-        g_scpi_error_queue_data,
+        session->error_queue,
         SCPI_ERROR_QUEUE_SIZE
     );
-
-    g_protocol_initialized = true;
-    return true;
+    session->context.user_context = session;
 }
 
 /**
@@ -235,41 +2988,455 @@ void protocol_deinit(void)
         return;
     }
 
+    // The binary protocol and the link test go with the bulk interface
+    binary_reset_state();
+    linktest_reset_state();
+
     // Deinitialize USB
-    if (g_usb_handle) {
-        USB_deinit(g_usb_handle);
-        g_usb_handle = nullptr;
+    if (g_usb_iso_handle) {
+        USB_deinit(g_usb_iso_handle);
+        g_usb_iso_handle = nullptr;
+    }
+    if (g_usb_bulk_handle) {
+        USB_deinit(g_usb_bulk_handle);
+        g_usb_bulk_handle = nullptr;
+    }
+    for (size_t i = SESSIONS_MAX; i-- > 0;) {
+        if (g_sessions[i].port != PORT_NONE) {
+            session_close(&g_sessions[i]);
+        }
     }
 
     protocol_reset((scpi_t *)0);
+    g_stream.state = SCAN_TEXT;
+    g_stream.line_len = 0;
+    g_stream.destination = nullptr;
+    g_operation_events = 0;
     g_protocol_initialized = false;
 }
 
+/**
+ * @brief Pass program text to the parser
+ */
+static void parse_input(char const *data, uint32_t len)
+{
+    if (len > 0) {
+        SCPI_Input(&g_session->context, data, (int)len);
+    }
+}
+
+/**
+ * @brief Check whether the parser is free for a line of a sequence
+ *
+ * It is not while part of a host line is in the input buffer or a block
+ * is streamed, while *WAI or *OPC? hold commands, or while a deferred
+ * query or a result block is outstanding.
+ */
+bool protocol_input_idle(void)
+{
+    return g_session->context.buffer.position == 0 &&
+           g_stream.state == SCAN_TEXT && !g_session->wait.holding &&
+           !g_session->wait.opc_query && !g_deferred.resume &&
+           !g_block_pending;
+}
+
+/**
+ * @brief Run a command line of a sequence, see sequence_task
+ *
+ * @param line Line, without its line ending
+ * @param len Length of the line
+ */
+void protocol_run_line(char const *line, uint32_t len)
+{
+    parse_input(line, len);
+    parse_input("\n", 1);
+}
+
+/**
+ * @brief Pass the held block header to the parser, as it starts no stream
+ */
+static void release_header(void)
+{
+    parse_input(g_stream.header, g_stream.header_len);
+    g_stream.state = SCAN_TEXT;
+}
+
+/**
+ * @brief Run the command of a block too large for the input buffer
+ *
+ * The command gets an empty block in its place, which ends its line, and
+ * may claim the block meanwhile, see protocol_block_streamed.
+ */
+static void start_stream(uint32_t length)
+{
+    static char const EMPTY_BLOCK[] = "#10\n";
+    int32_t const errors = SCPI_ErrorCount(&g_session->context);
+
+    g_stream.announced = length;
+    g_stream.destination = nullptr;
+    g_stream.complete = nullptr;
+    g_stream.received = 0;
+    parse_input(EMPTY_BLOCK, sizeof(EMPTY_BLOCK) - 1);
+    g_stream.announced = 0;
+
+    // Unless the command failed already, say why the block is dropped
+    if (!g_stream.destination &&
+        SCPI_ErrorCount(&g_session->context) == errors) {
+        SCPI_ErrorPush(&g_session->context, SCPI_ERROR_INPUT_BUFFER_OVERRUN);
+    }
+    g_stream.length = length;
+    g_stream.state = SCAN_STREAM;
+}
+
+/**
+ * @brief Account for bytes of the streamed block, received or dropped
+ */
+static void stream_received(uint32_t count)
+{
+    g_stream.received += count;
+    g_stream.length -= count;
+    if (g_stream.length > 0) {
+        return;
+    }
+
+    g_stream.state = SCAN_SEPARATOR;
+    if (g_stream.destination && g_stream.complete) {
+        (void)g_stream.complete(&g_session->context);
+    }
+    g_stream.destination = nullptr;
+}
+
+/**
+ * @brief Pass received bytes to the parser, streaming large blocks past it
+ *
+ * Scans the input for definite length arbitrary block headers outside of
+ * strings. A block that fits the input buffer along with the rest of its
+ * line goes to the parser as it is; a larger one is streamed, see
+ * protocol_block_streamed. The rest of the line after a streamed block
+ * is parsed as a line of its own, its leading ';' dropped.
+ */
+static void feed_input(char const *data, uint32_t len)
+{
+    uint32_t start = 0; // First byte not passed on yet
+    uint32_t i = 0;
+
+    while (i < len) {
+        char const c = data[i];
+        uint32_t count = 0;
+
+        switch (g_stream.state) {
+        case SCAN_TEXT:
+        case SCAN_QUOTED:
+            ++g_stream.line_len;
+            ++i;
+            if (c == '\n') {
+                g_stream.line_len = 0;
+                g_stream.state = SCAN_TEXT;
+                // One line at a time, so that *WAI can hold those after it
+                parse_input(&data[start], i - start);
+                start = i;
+                if (g_session->wait.holding) {
+                    Session *const session = g_session;
+                    memcpy(
+                        &session->wait.input[session->wait.length],
+                        &data[i],
+                        len - i
+                    );
+                    session->wait.length += len - i;
+                    return;
+                }
+            } else if (g_stream.state == SCAN_QUOTED) {
+                if (c == g_stream.quote) {
+                    g_stream.state = SCAN_TEXT;
+                }
+            } else if (c == '"' || c == '\'') {
+                g_stream.quote = c;
+                g_stream.state = SCAN_QUOTED;
+            } else if (c == '#') {
+                parse_input(&data[start], i - 1 - start);
+                start = i;
+                g_stream.header[0] = c;
+                g_stream.header_len = 1;
+                g_stream.state = SCAN_HASH;
+            }
+            break;
+        case SCAN_HASH:
+            // Not a definite length block, e.g. #H1F; c is text again
+            if (c < '1' || c > '9') {
+                release_header();
+                start = i;
+                break;
+            }
+            g_stream.header[g_stream.header_len++] = c;
+            g_stream.digits = (uint32_t)(c - '0');
+            g_stream.length = 0;
+            g_stream.state = SCAN_LENGTH;
+            ++g_stream.line_len;
+            ++i;
+            break;
+        case SCAN_LENGTH:
+            if (c < '0' || c > '9') {
+                release_header();
+                start = i;
+                break;
+            }
+            g_stream.header[g_stream.header_len++] = c;
+            g_stream.length = (g_stream.length * 10) + (uint32_t)(c - '0');
+            ++g_stream.line_len;
+            start = ++i;
+            if (--g_stream.digits > 0) {
+                break;
+            }
+            // Room for the line ending as well
+            if (g_stream.line_len + g_stream.length + 2 <
+                SCPI_INPUT_BUFFER_SIZE) {
+                release_header();
+                g_stream.state =
+                    g_stream.length > 0 ? SCAN_BLOCK : SCAN_TEXT;
+            } else {
+                start_stream(g_stream.length);
+            }
+            break;
+        case SCAN_BLOCK:
+            count = len - i < g_stream.length ? len - i : g_stream.length;
+            g_stream.line_len += count;
+            g_stream.length -= count;
+            i += count;
+            if (g_stream.length == 0) {
+                g_stream.state = SCAN_TEXT;
+            }
+            break;
+        case SCAN_STREAM:
+            count = len - i < g_stream.length ? len - i : g_stream.length;
+            if (g_stream.destination) {
+                memcpy(
+                    &g_stream.destination[g_stream.received],
+                    &data[i],
+                    count
+                );
+            }
+            i += count;
+            start = i;
+            stream_received(count);
+            break;
+        case SCAN_SEPARATOR:
+            if (c == ';') {
+                start = ++i;
+            }
+            g_stream.line_len = 0;
+            g_stream.state = SCAN_TEXT;
+            break;
+        }
+    }
+
+    // A held header is passed on once it is complete
+    if (g_stream.state != SCAN_HASH && g_stream.state != SCAN_LENGTH) {
+        parse_input(&data[start], len - start);
+    }
+}
+
+/**
+ * @brief End the waits of *OPC, *OPC? and *WAI once nothing is pending
+ */
+static void complete_wait(void)
+{
+    Session *const session = g_session;
+
+    if (!session_waiting(session)) {
+        return;
+    }
+    if (poll_operations()) {
+        return;
+    }
+
+    if (session->wait.opc) {
+        session->wait.opc = false;
+        SCPI_RegSetBits(&session->context, SCPI_REG_ESR, ESR_OPC);
+    }
+    if (session->wait.opc_query) {
+        session->wait.opc_query = false;
+        session->context.output_count = 0;
+        SCPI_ResultInt32(&session->context, 1);
+        protocol_write(
+            &session->context, SCPI_LINE_ENDING, strlen(SCPI_LINE_ENDING)
+        );
+        protocol_flush(&session->context);
+    }
+    if (session->wait.holding) {
+        // Fed from a copy, as another *WAI may hold input again
+        char input[sizeof(session->wait.input)];
+        uint32_t const length = session->wait.length;
+        memcpy(input, session->wait.input, length);
+        session->wait.holding = false;
+        session->wait.length = 0;
+        feed_input(input, length);
+    }
+}
+
+/**
+ * @brief Check whether a session's port has received bytes
+ */
+static bool session_rx_ready(Session *session)
+{
+    if (session->uart) {
+        return UART_rx_ready(session->uart);
+    }
+    return USB_rx_ready(session->usb);
+}
+
+/**
+ * @brief Read received bytes from a session's port
+ *
+ * @return Number of bytes read
+ */
+static uint32_t session_read(Session *session, uint8_t *data, uint32_t len)
+{
+    if (session->uart) {
+        return UART_read(session->uart, data, len);
+    }
+    return USB_read(session->usb, data, len);
+}
+
+/**
+ * @brief Close the sessions asked to, and turn the parser to the next one
+ * with input or a wait to end
+ *
+ * The sessions take turns, one per pass, but only between lines of the
+ * current one and while nothing of it is outstanding: no block being sent
+ * or streamed, no deferred query and no sequence. Each line thus runs
+ * whole against the shared instruments, as it would from a single host.
+ * Commands held by *WAI or *OPC? leave the parser to the others.
+ */
+static void select_session(void)
+{
+    if (g_session->context.buffer.position != 0 ||
+        g_stream.state != SCAN_TEXT || g_stream.line_len != 0 ||
+        g_deferred.resume || g_block_pending || sequence_running()) {
+        return;
+    }
+
+    for (size_t i = 1; i < SESSIONS_MAX; ++i) {
+        if (g_sessions[i].closing) {
+            LOG_INFO("Protocol: Session %u closed", (unsigned)i);
+            session_close(&g_sessions[i]);
+        }
+    }
+
+    size_t const current = session_number(g_session);
+    for (size_t step = 1; step < SESSIONS_MAX; ++step) {
+        Session *const session = &g_sessions[(current + step) % SESSIONS_MAX];
+        if (session->port != PORT_NONE &&
+            (session_waiting(session) || session_rx_ready(session))) {
+            g_session = session;
+            return;
+        }
+    }
+}
+
 /**
  * @brief Main protocol task - processes USB data and SCPI commands
  */
 void protocol_task(void)
 {
-    if (!g_protocol_initialized || !g_usb_handle) {
+    if (!g_protocol_initialized || !g_sessions[0].usb) {
         return;
     }
 
     // Step USB task
-    USB_task(g_usb_handle);
+    for (size_t i = 0; i < SESSIONS_MAX; ++i) {
+        if (g_sessions[i].usb) {
+            USB_task(g_sessions[i].usb);
+        }
+    }
+    if (g_usb_bulk_handle) {
+        USB_task(g_usb_bulk_handle);
+    }
+    if (g_usb_iso_handle) {
+        USB_task(g_usb_iso_handle);
+    }
+
+    // Hold input while a result block is sent from instrument memory
+    if (g_block_pending) {
+        g_block_pending = USB_tx_buffer_pending(g_session->usb);
+    }
+
+    select_session();
+    Session *const session = g_session;
+
+    // Run the commands held by *WAI or *OPC? once their wait is over
+    if (!g_block_pending) {
+        complete_wait();
+    }
+
+    // Execute all commands received so far back to back; the parser works
+    // on one line at a time, so a burst may span any number of reads. A
+    // line of a sequence runs first to its end.
+    while (!g_block_pending && !session->wait.holding &&
+           !sequence_capturing() && session_rx_ready(session)) {
+        // A claimed block is read straight into its destination
+        if (g_stream.state == SCAN_STREAM && g_stream.destination) {
+            uint32_t const count = session_read(
+                session,
+                &g_stream.destination[g_stream.received],
+                g_stream.length
+            );
+            if (count == 0) {
+                break;
+            }
+            stream_received(count);
+            continue;
+        }
+
+        uint8_t buffer[USB_READ_SIZE];
+        uint32_t bytes_read = session_read(session, buffer, sizeof(buffer));
+
+        if (bytes_read == 0) {
+            break;
+        }
+
+        // Feed data to SCPI parser
+        feed_input((char *)buffer, bytes_read);
+    }
 
-    // Process incoming USB data
-    if (USB_rx_ready(g_usb_handle)) {
-        uint8_t buffer[64];
-        uint32_t bytes_read = USB_read(g_usb_handle, buffer, sizeof(buffer));
+    // Serve binary requests from the bulk interface
+    binary_task();
 
-        if (bytes_read > 0) {
-            // Feed data to SCPI parser
-            SCPI_Input(&g_scpi_context, (char *)buffer, (int)bytes_read);
+    // Push the pattern of a running USB link test
+    linktest_task();
+
+    // Answer a deferred query once its instrument is done
+    resume_deferred();
+
+    // Run the next lines of a running sequence
+    sequence_task(&g_session->context);
+
+    // Push any completed oscilloscope stream blocks
+    dso_stream_task();
+
+    // Bin the blocks of a running oscilloscope histogram
+    dso_histogram_task();
+
+    // Measure the probes of a running oscilloscope autoset
+    dso_autoset_task();
+
+    // Raise the service requests of operations completed meanwhile
+    latch_operation_events();
+
+    // One flush for all responses completed in this pass; a UART sends
+    // as soon as it is written to
+    for (size_t i = 0; i < SESSIONS_MAX; ++i) {
+        if (!g_sessions[i].flush_pending) {
+            continue;
+        }
+        g_sessions[i].flush_pending = false;
+        if (g_sessions[i].usb) {
+            USB_flush(g_sessions[i].usb);
         }
+        PROFILE_boot_mark(PROFILE_BOOT_FIRST_RESPONSE);
     }
 }
 
 /**
  * @brief Check if protocol is initialized
  */
-bool protocol_is_initialized(void) { return g_protocol_initialized; }
\ No newline at end of file
+bool protocol_is_initialized(void) { return g_protocol_initialized; }
@@ -0,0 +1,193 @@
+/**
+ * @file counter.c
+ * @brief Frequency counter SCPI commands implementation
+ *
+ * This module implements the FREQuency command tree. Each query takes a
+ * measurement over the gate time and answers once it is done, so other
+ * commands wait for it. The counter is only initialized while measuring,
+ * which leaves its input to the ADC otherwise.
+ *
+ * Results are integers, microhertz and picoseconds, which keep the
+ * counter's resolution without floating-point formatting.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lib/scpi/error.h"
+#include "lib/scpi/scpi.h"
+
+#include "system/instrument/counter.h"
+#include "system/system.h"
+#include "util/error.h"
+#include "util/logging.h"
+
+enum {
+    GATE_TIME_DEFAULT = 100, // ms
+    MEASURE_TIMEOUT_MARGIN = 1000, // ms allowed beyond two gate times
+};
+
+// Deferred query responses, implemented in common.c
+extern scpi_result_t
+protocol_defer(scpi_t *context, scpi_command_callback_t resume);
+
+// Counter state (internal to this module)
+static struct {
+    COUNTER_Handle *handle;
+    uint32_t gate_time; // ms
+    bool period; // The query in progress answers the period
+    uint32_t start; // Tick the measurement started at
+} g_counter_state = {
+    .handle = nullptr,
+    .gate_time = GATE_TIME_DEFAULT,
+    .period = false,
+    .start = 0,
+};
+
+static void release_handle(void)
+{
+    if (g_counter_state.handle) {
+        COUNTER_deinit(g_counter_state.handle);
+        g_counter_state.handle = nullptr;
+    }
+}
+
+/**
+ * @brief Reset counter state to default values
+ */
+void counter_reset_state(void)
+{
+    release_handle();
+    g_counter_state.gate_time = GATE_TIME_DEFAULT;
+    g_counter_state.period = false;
+}
+
+static scpi_result_t finish_measure(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    COUNTER_Result result = { 0 };
+    bool ready = false;
+
+    // Ended by a reset
+    if (!g_counter_state.handle) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    TRY { ready = COUNTER_read(g_counter_state.handle, &result); }
+    CATCH(err)
+    {
+        LOG_ERROR("COUNTER read error: 0x%08X", err);
+        release_handle();
+        SCPI_ErrorPush(
+            context,
+            err == ERROR_RESOURCE_UNAVAILABLE ? SCPI_ERROR_EXECUTION_ERROR
+                                              : SCPI_ERROR_SYSTEM_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+
+    if (!ready) {
+        // An overrun measures once more, at a lower capture rate
+        uint32_t const timeout =
+            2 * g_counter_state.gate_time + MEASURE_TIMEOUT_MARGIN;
+        if (SYSTEM_get_tick() - g_counter_state.start > timeout) {
+            LOG_ERROR("COUNTER measurement timeout");
+            release_handle();
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+        return protocol_defer(context, finish_measure);
+    }
+
+    release_handle();
+    SCPI_ResultUInt64(
+        context, g_counter_state.period ? result.period : result.frequency
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Start a measurement and answer once it is done
+ */
+static scpi_result_t measure(scpi_t *context, bool period)
+{
+    Error err = ERROR_NONE;
+    COUNTER_Config config = COUNTER_CONFIG_DEFAULT;
+
+    release_handle();
+    config.gate_time = g_counter_state.gate_time;
+
+    TRY
+    {
+        g_counter_state.handle = COUNTER_init(&config);
+        COUNTER_start(g_counter_state.handle);
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("COUNTER start error: 0x%08X", err);
+        release_handle();
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_counter_state.period = period;
+    g_counter_state.start = SYSTEM_get_tick();
+    return finish_measure(context);
+}
+
+/**
+ * @brief FREQuency:MEASure? - Measure the frequency of the counter input
+ *
+ * Counts the rising edges on PA0 over the gate time and returns their
+ * frequency in microhertz, or 0 without a signal.
+ */
+scpi_result_t scpi_cmd_frequency_measure_q(scpi_t *context)
+{
+    return measure(context, false);
+}
+
+/**
+ * @brief FREQuency:PERiod? - Measure the period of the counter input
+ *
+ * Returns the mean period over the gate time in picoseconds, or 0 without
+ * a signal.
+ */
+scpi_result_t scpi_cmd_frequency_period_q(scpi_t *context)
+{
+    return measure(context, true);
+}
+
+/**
+ * @brief FREQuency:GATE - Set the gate time of the measurements
+ *
+ * Syntax: FREQuency:GATE <ms>
+ *
+ * Longer gates resolve the frequency finer, one timer clock period over
+ * the gate, and take as long to answer.
+ */
+scpi_result_t scpi_cmd_frequency_gate(scpi_t *context)
+{
+    uint32_t gate_time = 0;
+
+    if (!SCPI_ParamUInt32(context, &gate_time, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (gate_time < COUNTER_GATE_TIME_MIN ||
+        gate_time > COUNTER_GATE_TIME_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_counter_state.gate_time = gate_time;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief FREQuency:GATE? - Query the gate time in ms
+ */
+scpi_result_t scpi_cmd_frequency_gate_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_counter_state.gate_time);
+    return SCPI_RES_OK;
+}
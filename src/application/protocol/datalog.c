@@ -0,0 +1,414 @@
+/**
+ * @file datalog.c
+ * @brief Data logger SCPI commands implementation
+ *
+ * This module implements the LOG command tree, which records DMM scans on
+ * the external SPI flash without a host and reads the log back afterwards.
+ * The logger takes the SPI bus on the first LOG command and keeps it until
+ * a reset, which also ends a log in progress.
+ *
+ * The log is read back as raw flash bytes in the format documented in
+ * system/datalog.h, a block of up to DATA_CHUNK_MAX bytes per query.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lib/scpi/error.h"
+#include "lib/scpi/scpi.h"
+
+#include "system/datalog.h"
+#include "system/system.h"
+#include "util/error.h"
+#include "util/logging.h"
+
+enum {
+    DATA_CHUNK_MAX = DATALOG_SECTOR_SIZE, // Bytes per LOG:DATA? query
+    DETECT_TIMEOUT = 10, // ms to identify the flash, far longer than it takes
+    READ_TIMEOUT = 100, // ms for a read, far longer than it takes
+    INTERVAL_DEFAULT = 1000, // ms
+    INTERVAL_MAX = 86400000, // ms, a day
+};
+
+// Host output and deferred query responses, implemented in common.c
+extern void
+protocol_result_block(scpi_t *context, uint8_t const *data, uint32_t len);
+extern scpi_result_t
+protocol_defer(scpi_t *context, scpi_command_callback_t resume);
+
+// Mnemonics of LOG:STATe?, in DATALOG_State order
+static char const *const g_STATE_NAMES[] = {
+    "OFF", "DET", "READY", "RUN", "FLUSH", "FULL", "ERR",
+};
+
+// Logger state (internal to this module)
+static struct {
+    bool initialized; // DATALOG_init has been called since the last reset
+    DATALOG_Config config;
+    // Held until the block has been sent, see protocol_result_block
+    uint8_t data[DATA_CHUNK_MAX];
+    uint32_t read_size;
+    uint32_t read_start; // Tick the read was started at
+} g_datalog_state = {
+    .initialized = false,
+    .config = {
+        .interval = INTERVAL_DEFAULT,
+        .dmm = {
+            .oversampling_ratio = 16,
+            .scan_count = 1,
+            .scan_channels = { 0 },
+        },
+    },
+};
+
+/**
+ * @brief Reset logger state to default values
+ *
+ * A log in progress ends; the page not yet programmed is lost.
+ */
+void datalog_reset_state(void)
+{
+    if (g_datalog_state.initialized) {
+        DATALOG_deinit();
+        g_datalog_state.initialized = false;
+    }
+    g_datalog_state.config = (DATALOG_Config){
+        .interval = INTERVAL_DEFAULT,
+        .dmm = {
+            .oversampling_ratio = 16,
+            .scan_count = 1,
+            .scan_channels = { 0 },
+        },
+    };
+}
+
+/**
+ * @brief Take the SPI bus and identify the flash on first use
+ *
+ * The identification is a few bytes on the bus, so it is waited for.
+ */
+static bool acquire_logger(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    DATALOG_Status status = { 0 };
+
+    if (!g_datalog_state.initialized) {
+        TRY { DATALOG_init(); }
+        CATCH(err)
+        {
+            LOG_ERROR("Data logger init error: 0x%08X", err);
+            SCPI_ErrorPush(
+                context,
+                err == ERROR_RESOURCE_BUSY ? SCPI_ERROR_EXECUTION_ERROR
+                                           : SCPI_ERROR_SYSTEM_ERROR
+            );
+            return false;
+        }
+        g_datalog_state.initialized = true;
+
+        uint32_t const start = SYSTEM_get_tick();
+        DATALOG_get_status(&status);
+        while (status.state == DATALOG_STATE_DETECTING &&
+               SYSTEM_get_tick() - start <= DETECT_TIMEOUT) {
+            DATALOG_task();
+            DATALOG_get_status(&status);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Get the logger status, taking the bus on first use
+ */
+static bool get_status(scpi_t *context, DATALOG_Status *status)
+{
+    if (!acquire_logger(context)) {
+        return false;
+    }
+    DATALOG_get_status(status);
+    return true;
+}
+
+/**
+ * @brief LOG:CHANnels - Set the channels of each record
+ *
+ * Syntax: LOG:CHANnels <channel>{,<channel>}
+ *
+ * Applies to the next LOG:STARt. The channels are converted back to back,
+ * as by DMM:SCAN.
+ */
+scpi_result_t scpi_cmd_log_channels(scpi_t *context)
+{
+    DMM_Config config = g_datalog_state.config.dmm;
+    uint32_t channel = 0;
+
+    config.scan_count = 0;
+    while (SCPI_ParamUInt32(context, &channel, config.scan_count == 0)) {
+        if (config.scan_count == DMM_SCAN_CHANNELS_MAX) {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        }
+        config.scan_channels[config.scan_count] = (DMM_Channel)channel;
+        config.scan_count += 1;
+    }
+    // Missing or malformed channels have been reported by the parser
+    if (config.scan_count == 0 || SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    g_datalog_state.config.dmm = config;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LOG:CHANnels? - Query the channels of each record
+ */
+scpi_result_t scpi_cmd_log_channels_q(scpi_t *context)
+{
+    DMM_Config const *const config = &g_datalog_state.config.dmm;
+
+    for (uint32_t i = 0; i < config->scan_count; i++) {
+        SCPI_ResultUInt32(context, (uint32_t)config->scan_channels[i]);
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LOG:INTerval - Set the time between records
+ *
+ * Syntax: LOG:INTerval <ms>
+ *
+ * Applies to the next LOG:STARt.
+ */
+scpi_result_t scpi_cmd_log_interval(scpi_t *context)
+{
+    uint32_t interval = 0;
+
+    if (!SCPI_ParamUInt32(context, &interval, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (interval < DATALOG_INTERVAL_MIN || interval > INTERVAL_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_datalog_state.config.interval = interval;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LOG:INTerval? - Query the time between records in ms
+ */
+scpi_result_t scpi_cmd_log_interval_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_datalog_state.config.interval);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LOG:STARt - Start a new log, overwriting the one on the flash
+ *
+ * The DMM and its ADC stay with the logger until LOG:STOP.
+ */
+scpi_result_t scpi_cmd_log_start(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+
+    if (!acquire_logger(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    TRY { DATALOG_start(&g_datalog_state.config); }
+    CATCH(err)
+    {
+        LOG_ERROR("Data logger start error: 0x%08X", err);
+        switch (err) {
+        case ERROR_INVALID_ARGUMENT:
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            break;
+        case ERROR_DEVICE_NOT_READY:
+        case ERROR_RESOURCE_BUSY:
+            SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+            break;
+        default:
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            break;
+        }
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LOG:STOP - Stop recording
+ *
+ * The records taken so far are programmed in the background; LOG:STATe?
+ * answers FLUSH until they are.
+ */
+scpi_result_t scpi_cmd_log_stop(scpi_t *context)
+{
+    (void)context;
+
+    if (g_datalog_state.initialized) {
+        DATALOG_stop();
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LOG:STATe? - Query the logger state
+ *
+ * Returns OFF, DET, READY, RUN, FLUSH, FULL or ERR, the last if no flash
+ * answered or it failed.
+ */
+scpi_result_t scpi_cmd_log_state_q(scpi_t *context)
+{
+    DATALOG_Status status = { 0 };
+
+    if (!get_status(context, &status)) {
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultMnemonic(context, g_STATE_NAMES[status.state]);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LOG:CAPacity? - Query the bytes of flash available for the log
+ */
+scpi_result_t scpi_cmd_log_capacity_q(scpi_t *context)
+{
+    DATALOG_Status status = { 0 };
+
+    if (!get_status(context, &status)) {
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32(context, status.capacity);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LOG:SIZE? - Query the bytes of the log programmed so far
+ *
+ * Whole pages, so records still in RAM are not counted. Only known for
+ * the log started since the last reset; 0 otherwise, in which case the
+ * end of an older log is the first page without its session.
+ */
+scpi_result_t scpi_cmd_log_size_q(scpi_t *context)
+{
+    DATALOG_Status status = { 0 };
+
+    if (!get_status(context, &status)) {
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32(context, status.size);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LOG:COUNt? - Query the records taken and dropped
+ *
+ * Returns <taken>,<dropped>. Records are dropped when the flash falls
+ * behind the interval.
+ */
+scpi_result_t scpi_cmd_log_count_q(scpi_t *context)
+{
+    DATALOG_Status status = { 0 };
+
+    if (!get_status(context, &status)) {
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32(context, status.records);
+    SCPI_ResultUInt32(context, status.dropped);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LOG:SESSion? - Query the session of the log on the flash
+ */
+scpi_result_t scpi_cmd_log_session_q(scpi_t *context)
+{
+    DATALOG_Status status = { 0 };
+
+    if (!get_status(context, &status)) {
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32(context, status.session);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Answer a read of the log once it is done
+ */
+static scpi_result_t finish_read(scpi_t *context)
+{
+    // Ended by a reset
+    if (!g_datalog_state.initialized) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    SPI_Status const status = DATALOG_read_status();
+    if (status == SPI_STATUS_PENDING) {
+        if (SYSTEM_get_tick() - g_datalog_state.read_start > READ_TIMEOUT) {
+            LOG_ERROR("Data logger read timeout");
+            datalog_reset_state();
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+        return protocol_defer(context, finish_read);
+    }
+
+    if (status != SPI_STATUS_OK) {
+        LOG_ERROR("Data logger read failed: %d", (int)status);
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    protocol_result_block(
+        context, g_datalog_state.data, g_datalog_state.read_size
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LOG:DATA? - Read bytes of the flash
+ *
+ * Syntax: LOG:DATA? <offset>,<count>
+ *
+ * Answers count bytes from offset, 1 to DATA_CHUNK_MAX of them, as a
+ * definite length arbitrary block. Refused while recording.
+ */
+scpi_result_t scpi_cmd_log_data_q(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    uint32_t offset = 0;
+    uint32_t count = 0;
+
+    if (!SCPI_ParamUInt32(context, &offset, true) ||
+        !SCPI_ParamUInt32(context, &count, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (count == 0 || count > DATA_CHUNK_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    if (!acquire_logger(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    TRY { DATALOG_read(offset, g_datalog_state.data, count); }
+    CATCH(err)
+    {
+        LOG_ERROR("Data logger read error: 0x%08X", err);
+        SCPI_ErrorPush(
+            context,
+            err == ERROR_INVALID_ARGUMENT ? SCPI_ERROR_ILLEGAL_PARAMETER_VALUE
+                                          : SCPI_ERROR_EXECUTION_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+
+    g_datalog_state.read_size = count;
+    g_datalog_state.read_start = SYSTEM_get_tick();
+    return finish_read(context);
+}
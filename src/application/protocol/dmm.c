@@ -6,12 +6,15 @@
  * functionality, including voltage measurement configuration and reading.
  */
 
+#define LOG_MODULE LOG_MODULE_DMM
+
 #include <stdio.h>
 #include <string.h>
 
 #include "lib/scpi/error.h"
 #include "lib/scpi/scpi.h"
 
+#include "system/instrument/calibration.h"
 #include "system/instrument/dmm.h"
 #include "system/system.h"
 #include "util/error.h"
@@ -19,19 +22,136 @@
 #include "util/si_prefix.h"
 #include "util/util.h"
 
+enum {
+    BURST_CHUNK_SAMPLES = 32, // Burst samples converted at a time
+    BURST_TIMEOUT_MARGIN = 1000, // ms allowed beyond the burst duration
+    // AC readings span 100 ms, whole cycles of both 50 Hz and 60 Hz mains
+    AC_SAMPLES_DEFAULT = 1024,
+    AC_RATE_DEFAULT = 10240, // Hz
+    // OPERation status event, see protocol_operation_event
+    OPER_BURST_COMPLETE = 1U << 9,
+    OPER_WATCH = 1U << 11,
+    // DMM:WATCh:LIMits defaults, the full input range
+    WATCH_LOW_DEFAULT = 0, // mV
+    WATCH_HIGH_DEFAULT = 3300, // mV
+    // DMM:COUNt:LEVel defaults
+    COUNT_LEVEL_DEFAULT = 1650, // mV
+    COUNT_HYSTERESIS_DEFAULT = 50, // mV
+    // DMM:READ:CONVerge?
+    CONVERGE_SAMPLES_MIN = 4, // Readings before their spread is trusted
+    CONVERGE_TIMEOUT_DEFAULT = 1000, // ms
+    CONVERGE_TIMEOUT_MAX = 60000, // ms
+};
+
+// Host output, deferred query responses, status events and overlapped
+// commands, in common.c
+extern void
+protocol_result_block(scpi_t *context, uint8_t const *data, uint32_t len);
+extern void protocol_result_int32_ascii(
+    scpi_t *context,
+    int32_t const *values,
+    size_t count
+);
+extern void protocol_result_uint32_ascii(
+    scpi_t *context,
+    uint32_t const *values,
+    size_t count
+);
+extern scpi_result_t
+protocol_defer(scpi_t *context, scpi_command_callback_t resume);
+extern void protocol_operation_event(uint16_t bits);
+extern void protocol_operation_pending(bool (*done)(void), uint32_t timeout);
+
+// Voltage response formats (DMM:FORMat)
+typedef enum {
+    DATA_FORMAT_ASCII, // Comma-separated millivolts
+    DATA_FORMAT_REAL32, // Little-endian IEEE 754 single precision volts
+    DATA_FORMAT_INT32, // Little-endian 32-bit millivolts
+    DATA_FORMAT_Q16, // Little-endian Q16.16 volts, as measured
+} DataFormat;
+
+// Burst readings in millivolts, sent from here without a copy
+static int16_t g_burst_millivolts[DMM_BURST_SAMPLES_MAX];
+
 // DMM state (internal to this module)
 static struct {
     DMM_Handle *dmm_handle;
     DMM_Config dmm_config;
     FIXED_Q1616 cached_voltage;
     bool has_cached_voltage;
+    bool continuous; // Started by DMM:INITiate:CONTinuous ON
+    DataFormat data_format;
+    // Timed burst of DMM:READ:ARRay?, answered once it has completed
+    DMM_Handle *burst_handle;
+    uint32_t burst_start; // Tick at which the burst started
+    uint32_t burst_timeout; // ms to wait for the burst to complete
+    // AC voltage bursts (DMM:CONFigure:VOLTage:AC)
+    uint32_t ac_samples;
+    uint32_t ac_rate;
+    // Window of DMM:WATCh, in mV
+    int32_t watch_low;
+    int32_t watch_high;
+    bool watching; // DMM:WATCh ON on the running measurement
+    // Level crossings of DMM:COUNt, in mV; a count and a watch exclude
+    // each other, as they share the watchdog
+    int32_t count_level;
+    int32_t count_hysteresis;
+    bool count_timestamps; // DMM:COUNt:TIMestamps ON
+    bool counting; // DMM:COUNt ON on the running measurement
+    // Converging reading of DMM:READ:CONVerge?, answered once the standard
+    // error of its mean is below the resolution; the sums are of the
+    // readings minus the first, in Q16.16 volts
+    DMM_Handle *converge_handle;
+    uint32_t converge_start; // Tick at which the reading started
+    uint32_t converge_timeout; // ms to accumulate readings for at most
+    uint32_t converge_resolution; // µV
+    uint32_t converge_sequence; // Of the latest reading accumulated
+    uint32_t converge_count; // Readings accumulated
+    FIXED_Q1616 converge_origin;
+    int64_t converge_sum;
+    int64_t converge_sum_squares;
 } g_dmm_state = {
     .dmm_handle = nullptr,
     .dmm_config = DMM_CONFIG_DEFAULT,
     .cached_voltage = 0,
     .has_cached_voltage = false,
+    .continuous = false,
+    .data_format = DATA_FORMAT_ASCII,
+    .burst_handle = nullptr,
+    .ac_samples = AC_SAMPLES_DEFAULT,
+    .ac_rate = AC_RATE_DEFAULT,
+    .watch_low = WATCH_LOW_DEFAULT,
+    .watch_high = WATCH_HIGH_DEFAULT,
+    .watching = false,
+    .count_level = COUNT_LEVEL_DEFAULT,
+    .count_hysteresis = COUNT_HYSTERESIS_DEFAULT,
+    .count_timestamps = false,
+    .counting = false,
+    .converge_handle = nullptr,
 };
 
+/**
+ * @brief End a timed burst, answered or not
+ */
+static void stop_burst(void)
+{
+    if (g_dmm_state.burst_handle) {
+        DMM_deinit(g_dmm_state.burst_handle);
+        g_dmm_state.burst_handle = nullptr;
+    }
+}
+
+/**
+ * @brief End a converging reading, answered or not
+ */
+static void stop_converge(void)
+{
+    if (g_dmm_state.converge_handle) {
+        DMM_deinit(g_dmm_state.converge_handle);
+        g_dmm_state.converge_handle = nullptr;
+    }
+}
+
 /**
  * @brief Reset DMM state to default values
  */
@@ -46,22 +166,145 @@ void dmm_reset_state(void)
     g_dmm_state.dmm_config = (DMM_Config)DMM_CONFIG_DEFAULT;
     g_dmm_state.cached_voltage = 0;
     g_dmm_state.has_cached_voltage = false;
+    g_dmm_state.continuous = false;
+    g_dmm_state.data_format = DATA_FORMAT_ASCII;
+    g_dmm_state.ac_samples = AC_SAMPLES_DEFAULT;
+    g_dmm_state.ac_rate = AC_RATE_DEFAULT;
+    g_dmm_state.watch_low = WATCH_LOW_DEFAULT;
+    g_dmm_state.watch_high = WATCH_HIGH_DEFAULT;
+    g_dmm_state.watching = false;
+    g_dmm_state.count_level = COUNT_LEVEL_DEFAULT;
+    g_dmm_state.count_hysteresis = COUNT_HYSTERESIS_DEFAULT;
+    g_dmm_state.count_timestamps = false;
+    g_dmm_state.counting = false;
+    stop_burst();
+    stop_converge();
 }
 
 /**
- * @brief DMM:CONFigure:VOLTage:DC - Configure DC voltage measurement parameters
+ * @brief Stop a running measurement so that its ADC can be reconfigured
  */
-scpi_result_t scpi_cmd_configure_voltage_dc(scpi_t *context)
+static void stop_measurement(void)
+{
+    // A pending burst or converging reading gives the DMM up to the new
+    // measurement
+    stop_burst();
+    stop_converge();
+    if (g_dmm_state.dmm_handle) {
+        DMM_deinit(g_dmm_state.dmm_handle);
+        g_dmm_state.dmm_handle = nullptr;
+    }
+    g_dmm_state.continuous = false;
+    g_dmm_state.watching = false; // Ended by DMM_deinit
+    g_dmm_state.counting = false;
+}
+
+/**
+ * @brief Whether the configuration averages in the background
+ */
+static bool config_is_averaging(void)
+{
+    return g_dmm_state.dmm_config.average_window > 0 ||
+           g_dmm_state.dmm_config.nplc > 0;
+}
+
+/**
+ * @brief Whether the running measurement keeps converting between reads
+ */
+static bool measurement_is_continuous(void)
+{
+    return g_dmm_state.dmm_handle &&
+           (g_dmm_state.continuous || config_is_averaging());
+}
+
+/**
+ * @brief Time to wait for a reading, in ms, covering a whole aperture
+ */
+static uint32_t reading_timeout(void)
+{
+    DMM_Config const *config = &g_dmm_state.dmm_config;
+    uint32_t timeout = SI_MILLI_DIV; // 1 second timeout
+
+    if (config->nplc > 0) {
+        timeout += (config->nplc * SI_MILLI_DIV) / config->line_frequency;
+    }
+    return timeout;
+}
+
+/**
+ * @brief Convert volts to millivolts for SCPI output, truncating
+ *
+ * Calibrated readings can be slightly negative near 0 V.
+ */
+static int32_t to_millivolts(FIXED_Q1616 volts)
+{
+    return (int32_t)(((int64_t)volts * (int64_t)SI_MILLI_DIV) / FIXED_SCALE);
+}
+
+/**
+ * @brief Convert Q16.16 to an integer number of millionths, rounded
+ */
+static int32_t to_millionths(FIXED_Q1616 value)
+{
+    int64_t const scaled = (int64_t)value * (int64_t)SI_MICRO_DIV;
+    int64_t const half = FIXED_SCALE / 2;
+    return (int32_t)((scaled + (scaled >= 0 ? half : -half)) / FIXED_SCALE);
+}
+
+/**
+ * @brief Send voltages in the selected DMM:FORMat
+ *
+ * @param context SCPI context
+ * @param voltages Calibrated voltages
+ * @param count Number of voltages, at most DMM_SCAN_CHANNELS_MAX
+ */
+static void
+result_voltages(scpi_t *context, FIXED_Q1616 const *voltages, size_t count)
+{
+    int32_t integers[DMM_SCAN_CHANNELS_MAX] = { 0 };
+    float reals[DMM_SCAN_CHANNELS_MAX] = { 0 };
+
+    switch (g_dmm_state.data_format) {
+    case DATA_FORMAT_REAL32:
+        for (size_t i = 0; i < count; ++i) {
+            reals[i] = FIXED_TO_FLOAT(voltages[i]);
+        }
+        SCPI_ResultArrayFloat(
+            context, reals, count, SCPI_FORMAT_LITTLEENDIAN
+        );
+        break;
+    case DATA_FORMAT_Q16:
+        SCPI_ResultArrayInt32(
+            context, voltages, count, SCPI_FORMAT_LITTLEENDIAN
+        );
+        break;
+    case DATA_FORMAT_INT32:
+        for (size_t i = 0; i < count; ++i) {
+            integers[i] = to_millivolts(voltages[i]);
+        }
+        SCPI_ResultArrayInt32(
+            context, integers, count, SCPI_FORMAT_LITTLEENDIAN
+        );
+        break;
+    case DATA_FORMAT_ASCII:
+    default:
+        for (size_t i = 0; i < count; ++i) {
+            integers[i] = to_millivolts(voltages[i]);
+        }
+        protocol_result_int32_ascii(context, integers, count);
+        break;
+    }
+}
+
+/**
+ * @brief Validate a configuration by initializing and deinitializing it
+ */
+static scpi_result_t validate_config(scpi_t *context, DMM_Config const *config)
 {
     Error err = ERROR_NONE;
-    DMM_Config config = DMM_CONFIG_DEFAULT;
     DMM_Handle *temp_handle = nullptr;
 
-    // Parse channel parameter if provided
-    SCPI_ParamUInt32(context, (uint32_t *)&config.channel, false);
-
-    // Validate configuration by attempting to initialize and deinitialize
-    TRY { temp_handle = DMM_init(&config); }
+    TRY { temp_handle = DMM_init(config); }
     CATCH(err)
     {
         switch (err) {
@@ -75,25 +318,251 @@ scpi_result_t scpi_cmd_configure_voltage_dc(scpi_t *context)
         }
     }
 
-    // Configuration is valid, clean up and store it
     DMM_deinit(temp_handle);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:CONFigure:VOLTage:DC - Configure DC voltage measurement parameters
+ */
+scpi_result_t scpi_cmd_configure_voltage_dc(scpi_t *context)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+
+    // Parse channel parameter if provided
+    SCPI_ParamUInt32(context, (uint32_t *)&config.channel, false);
+
+    // The averaging window and aperture are configured separately
+    config.average_window = g_dmm_state.dmm_config.average_window;
+    config.nplc = g_dmm_state.dmm_config.nplc;
+    config.line_frequency = g_dmm_state.dmm_config.line_frequency;
+
+    // Validate configuration by attempting to initialize and deinitialize
+    stop_measurement();
+    if (validate_config(context, &config) != SCPI_RES_OK) {
+        return SCPI_RES_ERR;
+    }
+
+    // Configuration is valid, store it
+    g_dmm_state.dmm_config = config;
+
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:CONFigure:AVERage - Set the background averaging window
+ *
+ * A window of 0 turns averaging off, so that every reading is a single
+ * conversion. Otherwise the DMM converts continuously after INIT and
+ * FETCh returns the mean over the latest window without waiting.
+ */
+scpi_result_t scpi_cmd_configure_average(scpi_t *context)
+{
+    DMM_Config config = g_dmm_state.dmm_config;
+
+    if (!SCPI_ParamUInt32(context, &config.average_window, true)) {
+        return SCPI_RES_ERR;
+    }
+    // A window in samples replaces an aperture in power-line cycles
+    if (config.average_window > 0) {
+        config.nplc = 0;
+    }
+
+    stop_measurement();
+    if (validate_config(context, &config) != SCPI_RES_OK) {
+        return SCPI_RES_ERR;
+    }
+
+    g_dmm_state.dmm_config = config;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:CONFigure:AVERage? - Query the background averaging window
+ */
+scpi_result_t scpi_cmd_configure_average_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_dmm_state.dmm_config.average_window);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:CONFigure:NPLCycles - Set the aperture in power-line cycles
+ *
+ * An aperture of 0 turns it off. Otherwise the DMM converts continuously
+ * after INIT, like DMM:CONFigure:AVERage, but over a window the DMM picks
+ * to span exactly that many mains cycles, and FETCh returns its mean.
+ */
+scpi_result_t scpi_cmd_configure_nplc(scpi_t *context)
+{
+    DMM_Config config = g_dmm_state.dmm_config;
+
+    if (!SCPI_ParamUInt32(context, &config.nplc, true)) {
+        return SCPI_RES_ERR;
+    }
+    // An aperture in power-line cycles replaces a window in samples
+    if (config.nplc > 0) {
+        config.average_window = 0;
+    }
+
+    stop_measurement();
+    if (validate_config(context, &config) != SCPI_RES_OK) {
+        return SCPI_RES_ERR;
+    }
+
+    g_dmm_state.dmm_config = config;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:CONFigure:NPLCycles? - Query the aperture in power-line cycles
+ */
+scpi_result_t scpi_cmd_configure_nplc_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_dmm_state.dmm_config.nplc);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:CONFigure:LFRequency - Set the power-line frequency
+ *
+ * Syntax: DMM:CONFigure:LFRequency {50|60}
+ */
+scpi_result_t scpi_cmd_configure_line_frequency(scpi_t *context)
+{
+    DMM_Config config = g_dmm_state.dmm_config;
+
+    if (!SCPI_ParamUInt32(context, &config.line_frequency, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (config.line_frequency != 50 && config.line_frequency != 60) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    stop_measurement();
+    if (validate_config(context, &config) != SCPI_RES_OK) {
+        return SCPI_RES_ERR;
+    }
+
     g_dmm_state.dmm_config = config;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:CONFigure:LFRequency? - Query the power-line frequency
+ */
+scpi_result_t scpi_cmd_configure_line_frequency_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_dmm_state.dmm_config.line_frequency);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:FORMat[:DATa] - Select the format of voltage responses
+ *
+ * Syntax: DMM:FORMat[:DATa] {ASCii|REAL[,32]|INTeger[,32]|Q16}
+ *
+ * ASCii (the default) sends comma-separated millivolts. REAL,32 sends
+ * IEEE 754 single precision volts, INTeger,32 sends 32-bit millivolts and
+ * Q16 sends the Q16.16 volts as measured, each in a little-endian block.
+ * Applies to FETCh?, READ?, MEASure?, SCAN? and FETCh:STATistics?.
+ */
+scpi_result_t scpi_cmd_format_data(scpi_t *context)
+{
+    scpi_choice_def_t const format_choices[] = {
+        { "ASCii", DATA_FORMAT_ASCII },
+        { "REAL", DATA_FORMAT_REAL32 },
+        { "INTeger", DATA_FORMAT_INT32 },
+        { "Q16", DATA_FORMAT_Q16 },
+        SCPI_CHOICE_LIST_END
+    };
+
+    int32_t format_choice = -1;
+    uint32_t length = 32;
+
+    if (!SCPI_ParamChoice(context, format_choices, &format_choice, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    // Only REAL and INTeger take a length, and only 32 bits are supported
+    bool const has_length = SCPI_ParamUInt32(context, &length, false);
+    bool const sized = format_choice == DATA_FORMAT_REAL32 ||
+                       format_choice == DATA_FORMAT_INT32;
+    if ((has_length && !sized) || length != 32) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_dmm_state.data_format = (DataFormat)format_choice;
+    return SCPI_RES_OK;
+}
 
+/**
+ * @brief DMM:FORMat[:DATa]? - Query the format of voltage responses
+ *
+ * Returns ASC, REAL,32, INT,32 or Q16.
+ */
+scpi_result_t scpi_cmd_format_data_q(scpi_t *context)
+{
+    switch (g_dmm_state.data_format) {
+    case DATA_FORMAT_REAL32:
+        SCPI_ResultMnemonic(context, "REAL");
+        SCPI_ResultUInt32(context, 32);
+        break;
+    case DATA_FORMAT_INT32:
+        SCPI_ResultMnemonic(context, "INT");
+        SCPI_ResultUInt32(context, 32);
+        break;
+    case DATA_FORMAT_Q16:
+        SCPI_ResultMnemonic(context, "Q16");
+        break;
+    case DATA_FORMAT_ASCII:
+    default:
+        SCPI_ResultMnemonic(context, "ASC");
+        break;
+    }
     return SCPI_RES_OK;
 }
 
+/**
+ * @brief Whether the averaging window or burst started last has filled
+ */
+static bool measurement_done(void)
+{
+    Error err = ERROR_NONE;
+    bool done = true;
+
+    TRY
+    {
+        if (g_dmm_state.burst_handle) {
+            FIXED_Q1616 first = 0;
+            done = DMM_read_burst(g_dmm_state.burst_handle, &first, 0, 1) > 0;
+        } else if (g_dmm_state.dmm_handle && config_is_averaging()) {
+            DMM_Statistics statistics = { 0 };
+            done = DMM_read_statistics(g_dmm_state.dmm_handle, &statistics);
+        }
+    }
+    CATCH(err)
+    {
+        done = true;
+    }
+    return done;
+}
+
 /**
  * @brief DMM:INITiate:VOLTage:DC - Initialize DMM and start voltage measurement
+ *
+ * Overlapped while averaging: *OPC, *OPC? and *WAI wait for the first
+ * window, or the first whole aperture.
  */
 scpi_result_t scpi_cmd_initiate_voltage_dc(scpi_t *context)
 {
     Error err = ERROR_NONE;
 
     // Clean up any existing DMM handle
-    if (g_dmm_state.dmm_handle) {
-        DMM_deinit(g_dmm_state.dmm_handle);
-        g_dmm_state.dmm_handle = nullptr;
-    }
+    stop_measurement();
 
     // Clear cached voltage since we're starting a new measurement
     g_dmm_state.has_cached_voltage = false;
@@ -109,45 +578,92 @@ scpi_result_t scpi_cmd_initiate_voltage_dc(scpi_t *context)
         return SCPI_RES_ERR;
     }
 
+    if (config_is_averaging()) {
+        protocol_operation_pending(measurement_done, reading_timeout());
+    }
     return SCPI_RES_OK;
 }
 
 /**
- * @brief Helper function to fetch a new voltage reading
+ * @brief DMM:INITiate:CONTinuous - Start or stop free-running measurement
+ *
+ * While on, the DMM converts in the background and FETCh and READ return
+ * the latest conversion without waiting for one.
  */
-static scpi_result_t fetch_new_voltage_dc(scpi_t *context)
+scpi_result_t scpi_cmd_initiate_continuous(scpi_t *context)
 {
     Error err = ERROR_NONE;
-    FIXED_Q1616 voltage = 0;
-    uint32_t timeout = SI_MILLI_DIV; // 1 second timeout
-    uint32_t start_time = SYSTEM_get_tick();
+    scpi_bool_t enable = false;
 
-    // Read ADC value with timeout
-    TRY
-    {
-        while (!DMM_read_voltage(g_dmm_state.dmm_handle, &voltage)) {
-            // Wait for ADC to be ready
-            if (SYSTEM_get_tick() - start_time > timeout) {
-                LOG_ERROR("DMM read timeout");
-                SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
-                return SCPI_RES_ERR;
-            }
-        }
+    if (!SCPI_ParamBool(context, &enable, true)) {
+        return SCPI_RES_ERR;
     }
+
+    stop_measurement();
+    g_dmm_state.has_cached_voltage = false;
+    g_dmm_state.cached_voltage = 0;
+    if (!enable) {
+        return SCPI_RES_OK;
+    }
+
+    DMM_Config config = g_dmm_state.dmm_config;
+    config.free_running = true;
+    TRY { g_dmm_state.dmm_handle = DMM_init(&config); }
     CATCH(err)
     {
-        LOG_ERROR("DMM read error: 0x%08X", err);
+        LOG_ERROR("DMM continuous initialization error: 0x%08X", err);
         SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
         return SCPI_RES_ERR;
     }
+    g_dmm_state.continuous = true;
+
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:INITiate:CONTinuous? - Query whether the DMM is free running
+ */
+scpi_result_t scpi_cmd_initiate_continuous_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, measurement_is_continuous());
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Helper function to fetch a new voltage reading
+ */
+static scpi_result_t fetch_new_voltage_dc(scpi_t *context)
+{
+    FIXED_Q1616 voltage = 0;
+    uint32_t timeout = reading_timeout();
+    uint32_t start_time = SYSTEM_get_tick();
+
+    // Read ADC value with timeout
+    bool ready = false;
+    while (!ready) {
+        Error const err =
+            DMM_try_read_voltage(g_dmm_state.dmm_handle, &voltage, &ready);
+        if (err != ERROR_NONE) {
+            LOG_ERROR("DMM read error: 0x%08X", err);
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+        // Wait for ADC to be ready
+        if (!ready && SYSTEM_get_tick() - start_time > timeout) {
+            LOG_ERROR("DMM read timeout");
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+    }
 
     // Cache the new reading
     g_dmm_state.cached_voltage = voltage;
     g_dmm_state.has_cached_voltage = true;
 
-    // Clean up DMM handle
-    DMM_deinit(g_dmm_state.dmm_handle);
-    g_dmm_state.dmm_handle = nullptr;
+    // A free-running DMM keeps converting for the next FETCh
+    if (!measurement_is_continuous()) {
+        stop_measurement();
+    }
     return SCPI_RES_OK;
 }
 
@@ -169,23 +685,83 @@ scpi_result_t scpi_cmd_fetch_voltage_dc(scpi_t *context)
         return SCPI_RES_ERR;
     }
 
-    // Convert Q16.16 to millivolts for SCPI output
-    int32_t voltage_millivolts =
-        FIXED_TO_INT(g_dmm_state.cached_voltage * SI_MILLI_DIV);
-    SCPI_ResultUInt32(context, voltage_millivolts);
+    result_voltages(context, &g_dmm_state.cached_voltage, 1);
     return SCPI_RES_OK;
 }
 
 /**
- * @brief DMM:READ:VOLTage:DC? - Initiate and fetch voltage measurement
+ * @brief DMM:FETCh:STATistics? - Fetch statistics over the averaging window
+ *
+ * Returns mean, RMS, minimum and maximum in the DMM:FORMat, followed by
+ * the number of samples they cover. Needs an averaging measurement started
+ * with INIT.
  */
-scpi_result_t scpi_cmd_read_voltage_dc(scpi_t *context)
+scpi_result_t scpi_cmd_fetch_statistics(scpi_t *context)
 {
-    scpi_result_t result = SCPI_RES_OK;
+    Error err = ERROR_NONE;
+    DMM_Statistics statistics = { 0 };
+    bool valid = false;
 
-    // Initiate measurement
-    result = scpi_cmd_initiate_voltage_dc(context);
-    if (result != SCPI_RES_OK) {
+    if (!g_dmm_state.dmm_handle || !config_is_averaging()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t timeout = reading_timeout();
+    uint32_t start_time = SYSTEM_get_tick();
+
+    // Only the first reading after INIT has to wait for half a window, or
+    // the whole aperture
+    TRY
+    {
+        DMM_Handle *handle = g_dmm_state.dmm_handle;
+        while (!(valid = DMM_read_statistics(handle, &statistics))) {
+            if (SYSTEM_get_tick() - start_time > timeout) {
+                break;
+            }
+        }
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("DMM statistics read error: 0x%08X", err);
+        valid = false;
+    }
+
+    if (!valid) {
+        LOG_ERROR("DMM statistics unavailable");
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    FIXED_Q1616 const voltages[] = {
+        statistics.mean,
+        statistics.rms,
+        statistics.min,
+        statistics.max,
+    };
+    result_voltages(
+        context, voltages, sizeof(voltages) / sizeof(voltages[0])
+    );
+    int32_t const samples = (int32_t)statistics.samples;
+    protocol_result_int32_ascii(context, &samples, 1);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:READ:VOLTage:DC? - Initiate and fetch voltage measurement
+ */
+scpi_result_t scpi_cmd_read_voltage_dc(scpi_t *context)
+{
+    scpi_result_t result = SCPI_RES_OK;
+
+    // A free-running measurement always has a current value
+    if (measurement_is_continuous()) {
+        return scpi_cmd_fetch_voltage_dc(context);
+    }
+
+    // Initiate measurement
+    result = scpi_cmd_initiate_voltage_dc(context);
+    if (result != SCPI_RES_OK) {
         return result;
     }
 
@@ -209,4 +785,1012 @@ scpi_result_t scpi_cmd_measure_voltage_dc(scpi_t *context)
 
     // Read (initiate + fetch)
     return scpi_cmd_read_voltage_dc(context);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Parse the channel list of DMM:SCAN into a scan configuration
+ */
+static bool parse_scan_channels(scpi_t *context, DMM_Config *config)
+{
+    uint32_t channel = 0;
+
+    config->scan_count = 0;
+    while (SCPI_ParamUInt32(context, &channel, config->scan_count == 0)) {
+        if (config->scan_count == DMM_SCAN_CHANNELS_MAX) {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return false;
+        }
+        config->scan_channels[config->scan_count] = (DMM_Channel)channel;
+        config->scan_count += 1;
+    }
+
+    // Missing or malformed channels have been reported by the parser
+    return config->scan_count > 0 && !SCPI_ParamErrorOccurred(context);
+}
+
+/**
+ * @brief DMM:SCAN:VOLTage:DC? - Measure DC voltage on a list of channels
+ *
+ * All channels are converted back to back on a single trigger, so one
+ * DMM_init covers the whole list.
+ */
+scpi_result_t scpi_cmd_scan_voltage_dc(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    DMM_Config config = g_dmm_state.dmm_config;
+    DMM_Handle *handle = nullptr;
+    FIXED_Q1616 voltages[DMM_SCAN_CHANNELS_MAX] = { 0 };
+    uint32_t count = 0;
+
+    if (!parse_scan_channels(context, &config)) {
+        return SCPI_RES_ERR;
+    }
+
+    // A scan replaces any pending single-channel measurement
+    stop_measurement();
+    config.average_window = 0;
+    config.nplc = 0;
+
+    TRY { handle = DMM_init(&config); }
+    CATCH(err)
+    {
+        switch (err) {
+        case ERROR_INVALID_ARGUMENT:
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        default:
+            LOG_ERROR("DMM scan initialization error: 0x%08X", err);
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    uint32_t timeout = SI_MILLI_DIV; // 1 second timeout
+    uint32_t start_time = SYSTEM_get_tick();
+
+    TRY
+    {
+        while ((count = DMM_read_scan(handle, voltages, config.scan_count)) ==
+               0) {
+            if (SYSTEM_get_tick() - start_time > timeout) {
+                break;
+            }
+        }
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("DMM scan read error: 0x%08X", err);
+        count = 0;
+    }
+    DMM_deinit(handle);
+
+    if (count == 0) {
+        LOG_ERROR("DMM scan failed");
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    result_voltages(context, voltages, count);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:DIFFerential:VOLTage:DC? - Measure the difference of two channels
+ *
+ * ADC1 and ADC2 convert the two channels on the same trigger. Returns the
+ * difference followed by the positive and the negative leg.
+ */
+scpi_result_t scpi_cmd_differential_voltage_dc(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    DMM_Config config = g_dmm_state.dmm_config;
+    DMM_Handle *handle = nullptr;
+    DMM_Differential reading = { 0 };
+    bool valid = false;
+
+    if (!SCPI_ParamUInt32(context, (uint32_t *)&config.channel, true) ||
+        !SCPI_ParamUInt32(
+            context, (uint32_t *)&config.negative_channel, true
+        )) {
+        return SCPI_RES_ERR;
+    }
+
+    // A differential reading replaces any pending measurement
+    stop_measurement();
+    config.differential = true;
+    config.scan_count = 0;
+    config.average_window = 0;
+    config.nplc = 0;
+
+    TRY { handle = DMM_init(&config); }
+    CATCH(err)
+    {
+        switch (err) {
+        case ERROR_INVALID_ARGUMENT:
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        default:
+            LOG_ERROR("DMM differential initialization error: 0x%08X", err);
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    uint32_t timeout = SI_MILLI_DIV; // 1 second timeout
+    uint32_t start_time = SYSTEM_get_tick();
+
+    TRY
+    {
+        while (!(valid = DMM_read_differential(handle, &reading))) {
+            if (SYSTEM_get_tick() - start_time > timeout) {
+                break;
+            }
+        }
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("DMM differential read error: 0x%08X", err);
+        valid = false;
+    }
+    DMM_deinit(handle);
+
+    if (!valid) {
+        LOG_ERROR("DMM differential reading failed");
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    FIXED_Q1616 const voltages[] = {
+        reading.difference,
+        reading.positive,
+        reading.negative,
+    };
+    result_voltages(
+        context, voltages, sizeof(voltages) / sizeof(voltages[0])
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Send the voltages of the completed burst
+ *
+ * A block of DMM_BURST_SAMPLES_MAX readings is larger than the USB TX
+ * buffer, so it is sent as a block from g_burst_millivolts.
+ */
+static void result_burst(scpi_t *context)
+{
+    FIXED_Q1616 voltages[BURST_CHUNK_SAMPLES];
+
+    // Reading a completed burst does not fail
+    uint32_t offset = 0;
+    uint32_t count = 0;
+    while ((count = DMM_read_burst(
+                g_dmm_state.burst_handle,
+                voltages,
+                offset,
+                BURST_CHUNK_SAMPLES
+            )) > 0) {
+        for (uint32_t i = 0; i < count; ++i) {
+            g_burst_millivolts[offset + i] =
+                (int16_t)to_millivolts(voltages[i]);
+        }
+        offset += count;
+    }
+
+    protocol_result_block(
+        context,
+        (uint8_t const *)g_burst_millivolts,
+        offset * sizeof(g_burst_millivolts[0])
+    );
+}
+
+/**
+ * @brief Answer DMM:READ:ARRay? once the burst has completed
+ *
+ * The query is deferred until then, so the main loop keeps running during
+ * long bursts.
+ */
+static scpi_result_t finish_read_array(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    FIXED_Q1616 first = 0;
+    uint32_t ready = 0;
+
+    // Ended by another DMM command or a reset
+    if (!g_dmm_state.burst_handle) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    TRY { ready = DMM_read_burst(g_dmm_state.burst_handle, &first, 0, 1); }
+    CATCH(err)
+    {
+        LOG_ERROR("DMM burst read error: 0x%08X", err);
+        stop_burst();
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    if (ready == 0) {
+        if (SYSTEM_get_tick() - g_dmm_state.burst_start >
+            g_dmm_state.burst_timeout) {
+            LOG_ERROR("DMM burst timeout");
+            stop_burst();
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+        return protocol_defer(context, finish_read_array);
+    }
+
+    protocol_operation_event(OPER_BURST_COMPLETE);
+    result_burst(context);
+    stop_burst();
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Start a timed burst, replacing any running measurement
+ */
+static scpi_result_t start_burst(scpi_t *context, DMM_Config *config)
+{
+    Error err = ERROR_NONE;
+
+    stop_measurement();
+    g_dmm_state.has_cached_voltage = false;
+    g_dmm_state.cached_voltage = 0;
+    config->average_window = 0;
+    config->nplc = 0;
+    config->free_running = false;
+
+    TRY { g_dmm_state.burst_handle = DMM_init(config); }
+    CATCH(err)
+    {
+        switch (err) {
+        case ERROR_INVALID_ARGUMENT:
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        default:
+            LOG_ERROR("DMM burst initialization error: 0x%08X", err);
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    // Wait for the whole burst, rounded up to the next ms, and a margin
+    uint64_t const burst_ms = (uint64_t)config->burst_samples * SI_MILLI_DIV;
+    uint32_t const rate = config->burst_rate;
+    g_dmm_state.burst_start = SYSTEM_get_tick();
+    g_dmm_state.burst_timeout =
+        (uint32_t)((burst_ms + rate - 1) / rate) + BURST_TIMEOUT_MARGIN;
+
+    protocol_operation_pending(measurement_done, g_dmm_state.burst_timeout);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:READ:ARRay? - Take a timed burst of voltage readings
+ *
+ * Syntax: DMM:READ:ARRay? <count>,<rate_hz>
+ *
+ * Takes count readings (up to DMM_BURST_SAMPLES_MAX) of the configured
+ * channel, rate_hz per second, paced by a timer and transferred by DMA.
+ * Once all have been taken, returns them as a definite-length block of
+ * little-endian 16-bit millivolts. Replaces any running measurement.
+ */
+scpi_result_t scpi_cmd_read_array_voltage_dc(scpi_t *context)
+{
+    DMM_Config config = g_dmm_state.dmm_config;
+
+    if (!SCPI_ParamUInt32(context, &config.burst_samples, true) ||
+        !SCPI_ParamUInt32(context, &config.burst_rate, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (config.burst_samples == 0 || config.burst_rate == 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    if (start_burst(context, &config) != SCPI_RES_OK) {
+        return SCPI_RES_ERR;
+    }
+    return finish_read_array(context);
+}
+
+/**
+ * @brief Standard error of the mean of the converging reading, in µV
+ *
+ * From n * sum of squares - sum^2, which is exact in 64 bits for up to
+ * DMM_AVERAGE_WINDOW_MAX readings; needs at least two.
+ */
+static uint32_t converge_standard_error(void)
+{
+    uint64_t const n = g_dmm_state.converge_count;
+    int64_t const sum = g_dmm_state.converge_sum;
+    int64_t const spread =
+        ((int64_t)n * g_dmm_state.converge_sum_squares) - (sum * sum);
+    uint64_t const divisor = n * n * (n - 1);
+
+    if (spread <= 0) {
+        return 0;
+    }
+
+    // Variance of the mean in 2^-48 V^2, scaled up before the division
+    // where the spread leaves room
+    uint64_t const scaled = (uint64_t)spread;
+    uint64_t const variance = scaled < (1ULL << 47)
+                                  ? (scaled << 16) / divisor
+                                  : (scaled / divisor) << 16;
+    uint64_t const deviation = FIXED_isqrt64(variance); // 2^-24 V
+
+    return (uint32_t)(((deviation * SI_MICRO_DIV) + (1ULL << 23)) >> 24);
+}
+
+/**
+ * @brief Answer DMM:READ:CONVerge? once the reading has converged
+ *
+ * Accumulates each new conversion the free-running DMM publishes, and is
+ * deferred until the standard error of their mean is at most the
+ * resolution, DMM_AVERAGE_WINDOW_MAX readings have been taken or the
+ * timeout has passed.
+ */
+static scpi_result_t finish_read_converge(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    FIXED_Q1616 voltage = 0;
+    uint32_t sequence = 0;
+    bool ready = false;
+
+    // Ended by another DMM command or a reset
+    if (!g_dmm_state.converge_handle) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    TRY
+    {
+        ready = DMM_read_latest(
+            g_dmm_state.converge_handle, &voltage, &sequence
+        );
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("DMM converging read error: 0x%08X", err);
+        stop_converge();
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    // A reading with an unchanged sequence number repeats the last one
+    if (ready && (g_dmm_state.converge_count == 0 ||
+                  sequence != g_dmm_state.converge_sequence)) {
+        if (g_dmm_state.converge_count == 0) {
+            g_dmm_state.converge_origin = voltage;
+        }
+        int64_t const deviation =
+            (int64_t)voltage - g_dmm_state.converge_origin;
+        g_dmm_state.converge_sequence = sequence;
+        g_dmm_state.converge_count++;
+        g_dmm_state.converge_sum += deviation;
+        g_dmm_state.converge_sum_squares += deviation * deviation;
+    }
+
+    uint32_t const count = g_dmm_state.converge_count;
+    uint32_t const standard_error =
+        count >= CONVERGE_SAMPLES_MIN ? converge_standard_error() : 0;
+    bool const converged = count >= CONVERGE_SAMPLES_MIN &&
+                           standard_error <= g_dmm_state.converge_resolution;
+    bool const timed_out = SYSTEM_get_tick() - g_dmm_state.converge_start >
+                           g_dmm_state.converge_timeout;
+
+    if (!converged && count < DMM_AVERAGE_WINDOW_MAX && !timed_out) {
+        return protocol_defer(context, finish_read_converge);
+    }
+    if (count == 0) {
+        LOG_ERROR("DMM converging read timeout");
+        stop_converge();
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    int64_t const sum = g_dmm_state.converge_sum;
+    int64_t const half = (int64_t)count / 2;
+    FIXED_Q1616 const mean =
+        g_dmm_state.converge_origin +
+        (FIXED_Q1616)((sum + (sum >= 0 ? half : -half)) / (int64_t)count);
+    stop_converge();
+
+    // FETCh repeats the mean until the next measurement
+    g_dmm_state.cached_voltage = mean;
+    g_dmm_state.has_cached_voltage = true;
+
+    result_voltages(context, &mean, 1);
+    int32_t const values[] = {
+        (int32_t)count,
+        count >= 2 ? (int32_t)converge_standard_error() : 0,
+    };
+    protocol_result_int32_ascii(
+        context, values, sizeof(values) / sizeof(values[0])
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:READ:CONVerge? - Average DC readings until they converge
+ *
+ * Syntax: DMM:READ:CONVerge? <resolution_uV>[,<timeout_ms>]
+ *
+ * Runs the configured channel free running and averages its readings
+ * until the standard error of their mean is at most resolution_uV, after
+ * at least CONVERGE_SAMPLES_MIN readings, or until DMM_AVERAGE_WINDOW_MAX
+ * readings or timeout_ms (1000 by default, up to 60000) have passed.
+ * Returns the mean in the DMM:FORMat, then the number of readings and the
+ * standard error in µV. Replaces any running measurement; the averaging
+ * window and aperture do not apply.
+ */
+scpi_result_t scpi_cmd_read_converge_voltage_dc(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    uint32_t resolution = 0;
+    uint32_t timeout = CONVERGE_TIMEOUT_DEFAULT;
+
+    if (!SCPI_ParamUInt32(context, &resolution, true)) {
+        return SCPI_RES_ERR;
+    }
+    SCPI_ParamUInt32(context, &timeout, false);
+    if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+    if (resolution == 0 || timeout == 0 || timeout > CONVERGE_TIMEOUT_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    stop_measurement();
+    g_dmm_state.has_cached_voltage = false;
+    g_dmm_state.cached_voltage = 0;
+
+    DMM_Config config = g_dmm_state.dmm_config;
+    config.average_window = 0;
+    config.nplc = 0;
+    config.free_running = true;
+
+    TRY { g_dmm_state.converge_handle = DMM_init(&config); }
+    CATCH(err)
+    {
+        switch (err) {
+        case ERROR_INVALID_ARGUMENT:
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        default:
+            LOG_ERROR("DMM converging read initialization error: 0x%08X", err);
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    g_dmm_state.converge_start = SYSTEM_get_tick();
+    g_dmm_state.converge_timeout = timeout;
+    g_dmm_state.converge_resolution = resolution;
+    g_dmm_state.converge_count = 0;
+    g_dmm_state.converge_sum = 0;
+    g_dmm_state.converge_sum_squares = 0;
+    return finish_read_converge(context);
+}
+
+/**
+ * @brief DMM:CONFigure:VOLTage:AC - Configure true-RMS AC voltage readings
+ *
+ * Syntax: DMM:CONFigure:VOLTage:AC [<channel>[,<rate_hz>[,<samples>]]]
+ *
+ * Each AC reading is a timed burst of samples conversions at rate_hz,
+ * 1024 at 10240 Hz by default. A burst spanning a whole number of signal
+ * cycles gives the exact RMS; a partial cycle adds an error that shrinks
+ * as the burst spans more cycles.
+ */
+scpi_result_t scpi_cmd_configure_voltage_ac(scpi_t *context)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    uint32_t rate = AC_RATE_DEFAULT;
+    uint32_t samples = AC_SAMPLES_DEFAULT;
+
+    SCPI_ParamUInt32(context, (uint32_t *)&config.channel, false);
+    SCPI_ParamUInt32(context, &rate, false);
+    SCPI_ParamUInt32(context, &samples, false);
+    if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+    if (rate == 0 || samples == 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    stop_measurement();
+    config.burst_samples = samples;
+    config.burst_rate = rate;
+    if (validate_config(context, &config) != SCPI_RES_OK) {
+        return SCPI_RES_ERR;
+    }
+
+    // The channel is shared with DC readings
+    g_dmm_state.dmm_config.channel = config.channel;
+    g_dmm_state.ac_samples = samples;
+    g_dmm_state.ac_rate = rate;
+
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Answer DMM:READ:VOLTage:AC? once the burst has completed
+ */
+static scpi_result_t finish_read_ac(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    DMM_Statistics stats = { 0 };
+    bool ready = false;
+
+    // Ended by another DMM command or a reset
+    if (!g_dmm_state.burst_handle) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    TRY { ready = DMM_read_burst_statistics(g_dmm_state.burst_handle, &stats); }
+    CATCH(err)
+    {
+        LOG_ERROR("DMM AC read error: 0x%08X", err);
+        stop_burst();
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    if (!ready) {
+        if (SYSTEM_get_tick() - g_dmm_state.burst_start >
+            g_dmm_state.burst_timeout) {
+            LOG_ERROR("DMM AC burst timeout");
+            stop_burst();
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+        return protocol_defer(context, finish_read_ac);
+    }
+
+    stop_burst();
+    result_voltages(context, &stats.ac_rms, 1);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:READ:VOLTage:AC? - Take a true-RMS AC voltage reading
+ *
+ * Takes the burst set by DMM:CONFigure:VOLTage:AC on the configured
+ * channel and returns the RMS of its samples about their mean, so that
+ * any DC component is removed. Replaces any running measurement.
+ */
+scpi_result_t scpi_cmd_read_voltage_ac(scpi_t *context)
+{
+    DMM_Config config = g_dmm_state.dmm_config;
+
+    config.burst_samples = g_dmm_state.ac_samples;
+    config.burst_rate = g_dmm_state.ac_rate;
+    if (start_burst(context, &config) != SCPI_RES_OK) {
+        return SCPI_RES_ERR;
+    }
+    return finish_read_ac(context);
+}
+
+/**
+ * @brief DMM:MEASure:VOLTage:AC? - Configure and take an AC voltage reading
+ */
+scpi_result_t scpi_cmd_measure_voltage_ac(scpi_t *context)
+{
+    if (scpi_cmd_configure_voltage_ac(context) != SCPI_RES_OK) {
+        return SCPI_RES_ERR;
+    }
+    return scpi_cmd_read_voltage_ac(context);
+}
+
+/**
+ * @brief DMM:CALibration[:VALue] - Set the correction for a channel
+ *
+ * Takes the channel, the gain in parts per million and the offset in
+ * microvolts. Readings are corrected to reading * gain + offset from the
+ * next reading on. The correction is lost on power-off unless stored with
+ * DMM:CALibration:STORe.
+ */
+scpi_result_t scpi_cmd_calibration_value(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    uint32_t channel = 0;
+    int32_t gain_ppm = 0;
+    int32_t offset_uv = 0;
+
+    if (!SCPI_ParamUInt32(context, &channel, true) ||
+        !SCPI_ParamInt32(context, &gain_ppm, true) ||
+        !SCPI_ParamInt32(context, &offset_uv, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    CALIBRATION_Entry const entry = {
+        .gain = FIXED_from_fraction(gain_ppm, (int32_t)SI_MICRO_DIV),
+        .offset = FIXED_from_fraction(offset_uv, (int32_t)SI_MICRO_DIV),
+    };
+
+    TRY { CALIBRATION_set(CALIBRATION_MODE_DMM, channel, &entry); }
+    CATCH(err)
+    {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:CALibration[:VALue]? - Query the correction for a channel
+ *
+ * Returns the gain in parts per million and the offset in microvolts.
+ */
+scpi_result_t scpi_cmd_calibration_value_q(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    uint32_t channel = 0;
+    CALIBRATION_Entry entry = CALIBRATION_ENTRY_IDENTITY;
+
+    if (!SCPI_ParamUInt32(context, &channel, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    TRY { entry = CALIBRATION_get(CALIBRATION_MODE_DMM, channel); }
+    CATCH(err)
+    {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    int32_t const results[] = {
+        to_millionths(entry.gain),
+        to_millionths(entry.offset),
+    };
+    size_t const count = sizeof(results) / sizeof(results[0]);
+    protocol_result_int32_ascii(context, results, count);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:CALibration:STORe - Keep the corrections across power cycles
+ */
+scpi_result_t scpi_cmd_calibration_store(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+
+    TRY { CALIBRATION_save(); }
+    CATCH(err)
+    {
+        LOG_ERROR("DMM calibration store error: 0x%08X", err);
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:CALibration:RESet - Remove all corrections, without storing
+ */
+scpi_result_t scpi_cmd_calibration_reset(scpi_t *context)
+{
+    (void)context; // Unused parameter
+
+    CALIBRATION_clear();
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Raise the OPERation event of a watch, from interrupt context
+ */
+static void watch_crossed(void) { protocol_operation_event(OPER_WATCH); }
+
+/**
+ * @brief DMM:WATCh:LIMits - Set the window of a watch
+ *
+ * Takes the lowest and highest voltage inside the window in millivolts,
+ * as read. A running watch moves to the new window.
+ */
+scpi_result_t scpi_cmd_watch_limits(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    int32_t low = 0;
+    int32_t high = 0;
+
+    if (!SCPI_ParamInt32(context, &low, true) ||
+        !SCPI_ParamInt32(context, &high, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (low > high) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_dmm_state.watch_low = low;
+    g_dmm_state.watch_high = high;
+    if (!g_dmm_state.watching) {
+        return SCPI_RES_OK;
+    }
+
+    TRY
+    {
+        DMM_watch_start(
+            g_dmm_state.dmm_handle,
+            FIXED_from_fraction(low, SI_MILLI_DIV),
+            FIXED_from_fraction(high, SI_MILLI_DIV),
+            watch_crossed
+        );
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("DMM watch error: 0x%08X", err);
+        g_dmm_state.watching = false;
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:WATCh:LIMits? - Query the window of a watch, in millivolts
+ */
+scpi_result_t scpi_cmd_watch_limits_q(scpi_t *context)
+{
+    int32_t const results[] = {
+        g_dmm_state.watch_low,
+        g_dmm_state.watch_high,
+    };
+    size_t const count = sizeof(results) / sizeof(results[0]);
+    protocol_result_int32_ascii(context, results, count);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:WATCh[:STATe] - Start or stop watching the running measurement
+ *
+ * The first reading outside DMM:WATCh:LIMits sets bit 11 of the OPERation
+ * status event register, which can raise a service request, and latches
+ * for DMM:WATCh:EVENt?. Every conversion is compared in hardware, so that
+ * short excursions are caught. Needs a continuous or averaging
+ * measurement, and ends with it.
+ */
+scpi_result_t scpi_cmd_watch_state(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    scpi_bool_t enable = false;
+
+    if (!SCPI_ParamBool(context, &enable, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (!enable) {
+        DMM_watch_stop(g_dmm_state.dmm_handle);
+        g_dmm_state.watching = false;
+        return SCPI_RES_OK;
+    }
+
+    if (!measurement_is_continuous()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_SETTINGS_CONFLICT);
+        return SCPI_RES_ERR;
+    }
+
+    TRY
+    {
+        DMM_watch_start(
+            g_dmm_state.dmm_handle,
+            FIXED_from_fraction(g_dmm_state.watch_low, SI_MILLI_DIV),
+            FIXED_from_fraction(g_dmm_state.watch_high, SI_MILLI_DIV),
+            watch_crossed
+        );
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("DMM watch error: 0x%08X", err);
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    g_dmm_state.watching = true;
+    g_dmm_state.counting = false; // Ended by DMM_watch_start
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:WATCh[:STATe]? - Query whether a watch is running
+ */
+scpi_result_t scpi_cmd_watch_state_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_dmm_state.watching);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:WATCh:EVENt? - Query and clear the latched crossing
+ *
+ * Returns 1 if a reading has fallen outside the window since the watch
+ * started or the last query that returned 1, and watches for the next.
+ */
+scpi_result_t scpi_cmd_watch_event_q(scpi_t *context)
+{
+    SCPI_ResultBool(
+        context,
+        g_dmm_state.watching && DMM_watch_event(g_dmm_state.dmm_handle)
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Start counting at the DMM:COUNt settings, see DMM_count_start
+ *
+ * @return false, with an error queued, if the count did not start
+ */
+static bool start_count(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+
+    TRY
+    {
+        DMM_count_start(
+            g_dmm_state.dmm_handle,
+            FIXED_from_fraction(g_dmm_state.count_level, SI_MILLI_DIV),
+            FIXED_from_fraction(g_dmm_state.count_hysteresis, SI_MILLI_DIV),
+            g_dmm_state.count_timestamps
+        );
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("DMM count error: 0x%08X", err);
+        g_dmm_state.counting = false;
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return false;
+    }
+    g_dmm_state.counting = true;
+    g_dmm_state.watching = false; // Ended by DMM_count_start
+    return true;
+}
+
+/**
+ * @brief DMM:COUNt:LEVel - Set the level whose crossings are counted
+ *
+ * Syntax: DMM:COUNt:LEVel <level>[,<hysteresis>]
+ *
+ * Takes the level a reading rises above and the fall below it that arms
+ * the next count, in millivolts, as read. A running count restarts at the
+ * new level.
+ */
+scpi_result_t scpi_cmd_count_level(scpi_t *context)
+{
+    int32_t level = 0;
+    int32_t hysteresis = g_dmm_state.count_hysteresis;
+
+    if (!SCPI_ParamInt32(context, &level, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (!SCPI_ParamInt32(context, &hysteresis, false) &&
+        SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+    if (hysteresis < 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_dmm_state.count_level = level;
+    g_dmm_state.count_hysteresis = hysteresis;
+    if (g_dmm_state.counting && !start_count(context)) {
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:COUNt:LEVel? - Query the level and hysteresis, in millivolts
+ */
+scpi_result_t scpi_cmd_count_level_q(scpi_t *context)
+{
+    int32_t const results[] = {
+        g_dmm_state.count_level,
+        g_dmm_state.count_hysteresis,
+    };
+    size_t const count = sizeof(results) / sizeof(results[0]);
+    protocol_result_int32_ascii(context, results, count);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:COUNt:TIMestamps - Keep the time of each counted crossing
+ *
+ * Takes effect when the count next starts.
+ */
+scpi_result_t scpi_cmd_count_timestamps(scpi_t *context)
+{
+    scpi_bool_t enable = false;
+
+    if (!SCPI_ParamBool(context, &enable, true)) {
+        return SCPI_RES_ERR;
+    }
+    g_dmm_state.count_timestamps = enable;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:COUNt:TIMestamps? - Query whether crossing times are kept
+ */
+scpi_result_t scpi_cmd_count_timestamps_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_dmm_state.count_timestamps);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:COUNt[:STATe] - Start or stop counting level crossings
+ *
+ * Every conversion of the running measurement is compared in hardware,
+ * and only crossings reach the CPU. Needs a continuous or averaging
+ * measurement, and ends with it. Starting a count ends a watch, and
+ * starting a watch ends a count.
+ */
+scpi_result_t scpi_cmd_count_state(scpi_t *context)
+{
+    scpi_bool_t enable = false;
+
+    if (!SCPI_ParamBool(context, &enable, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (!enable) {
+        DMM_count_stop(g_dmm_state.dmm_handle);
+        g_dmm_state.counting = false;
+        return SCPI_RES_OK;
+    }
+
+    if (!measurement_is_continuous()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_SETTINGS_CONFLICT);
+        return SCPI_RES_ERR;
+    }
+    return start_count(context) ? SCPI_RES_OK : SCPI_RES_ERR;
+}
+
+/**
+ * @brief DMM:COUNt[:STATe]? - Query whether crossings are being counted
+ */
+scpi_result_t scpi_cmd_count_state_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_dmm_state.counting);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:COUNt:EVENts? - Query the crossings counted since the start
+ */
+scpi_result_t scpi_cmd_count_events_q(scpi_t *context)
+{
+    uint32_t const events = g_dmm_state.counting
+                                ? DMM_count_events(g_dmm_state.dmm_handle)
+                                : 0;
+    protocol_result_uint32_ascii(context, &events, 1);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DMM:COUNt:TIMestamps:DATa? - Take the kept crossing times
+ *
+ * Returns the number of times, then the times in microseconds since the
+ * count started, oldest first.
+ */
+scpi_result_t scpi_cmd_count_timestamps_data_q(scpi_t *context)
+{
+    uint32_t results[1 + DMM_COUNT_TIMESTAMPS_MAX] = { 0 };
+
+    if (g_dmm_state.counting) {
+        results[0] = DMM_count_take_timestamps(
+            g_dmm_state.dmm_handle, &results[1], DMM_COUNT_TIMESTAMPS_MAX
+        );
+    }
+    protocol_result_uint32_ascii(context, results, 1 + results[0]);
+    return SCPI_RES_OK;
+}
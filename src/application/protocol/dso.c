@@ -7,22 +7,313 @@
  * data acquisition.
  */
 
+#define LOG_MODULE LOG_MODULE_DSO
+
+#include <assert.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "lib/scpi/error.h"
 #include "lib/scpi/scpi.h"
 
+#include "system/bus/usb.h"
+#include "system/checksum.h"
 #include "system/instrument/dso.h"
 #include "system/system.h"
+#include "util/arena.h"
+#include "util/channel_math.h"
+#include "util/crc.h"
+#include "util/decimate.h"
+#include "util/delta_codec.h"
 #include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/histogram.h"
+#include "util/mask.h"
+#include "util/pipeline.h"
+#include "util/ring.h"
 #include "util/si_prefix.h"
+#include "util/spectrum.h"
 #include "util/util.h"
 
 enum {
     TIMEBASE_DEFAULT = 100, // 100 µs / div
     BUFFER_SIZE_DEFAULT = 512,
     HORIZONTAL_DIVISIONS = 10, // Standard oscilloscope divisions
+    STREAM_HEADER_SIZE = 16, // "#<digits><length>" block header
+    // Stream blocks waiting to be sent; holds one more than the two halves
+    // the DSO can lend at once
+    STREAM_QUEUE_SIZE = 4,
+    // Largest factor stream blocks are averaged down by after gaps, see
+    // OSCilloscope:STReam:DECimation:AUTO
+    STREAM_DECIMATION_MAX = 64,
+    // OSCilloscope:STReam:RECord: share of the link rate a record may fill,
+    // link rate assumed until SYSTem:TEST:USB has measured one, and the
+    // shortest block, in which the protocol task converts and queues the
+    // one before
+    RECORD_LINK_SHARE = 80, // Percent
+    RECORD_LINK_RATE_DEFAULT = 800000, // Bytes/s, full-speed bulk
+    RECORD_BLOCK_TIME_MIN = 2000, // µs
+    PACK_CHUNK_SAMPLES = 64, // Samples packed per write; must be even
+    FETCH_ALL_CHANNELS = 0, // FETCh:DATa? without a channel parameter
+    MEASUREMENT_VALUES = 7, // Values per channel from FETCh:MEASure?
+    SPECTRUM_PEAKS_DEFAULT = 5, // Peaks from FETCh:SPECtrum:PEAKs?
+    SPECTRUM_PEAKS_MAX = 16,
+    SPECTRUM_HARMONICS_DEFAULT = 5, // 2nd to 5th for FETCh:SPECtrum:DIST?
+    SPECTRUM_HARMONICS_MAX = 10,
+    DISTORTION_VALUES = 5, // Values from FETCh:SPECtrum:DISTortion?
+    SETUP_SLOTS = 4, // Setups kept by *SAV, numbered from 0
+    RECORDS_MAX = 2, // Records captured in turn, ACQuire:RECords
+    // Acquisition and stream block bytes: all of SRAM3 except 16 KB for
+    // the instruments' own DMA buffers
+    SAMPLE_MEMORY_SIZE = 304 * 1024,
+    // Longest acquisition, a multiple of 4 as continuous mode needs
+    POINTS_MAX = (SAMPLE_MEMORY_SIZE / sizeof(uint16_t)) & ~3U,
+    // OPERation status events, see protocol_operation_event
+    OPER_ACQUISITION_COMPLETE = 1U << 8,
+    OPER_STREAM_ERROR = 1U << 10,
+    CAPTURE_HEADER_VERSION = 1, // Layout of CaptureHeader
+    // CaptureHeader flags
+    CAPTURE_FLAG_AFFECTED = 1U << 0, // ADC overrun or DMA error hit it
+    CAPTURE_FLAG_TRIGGERED = 1U << 1, // trigger_index holds the trigger
+    STREAM_HEADER_VERSION = 2, // Layout of StreamHeader
+    STREAM_CRC_SIZE = 4, // CRC-32 after the data, with StreamHeader
+    // StreamHeader flags
+    STREAM_FLAG_GAP = 1U << 0, // Samples are missing just before the block
+    STREAM_FLAG_MATH = 1U << 1, // Frames end with the math channel
+    STREAM_FLAG_MATH_ONLY = 1U << 2, // Frames hold the math channel alone
+    STREAM_FLAG_END = 1U << 3, // Last block of a record, data is RecordStats
+    // OSCilloscope:AUTOset
+    AUTOSET_PROBES = 4, // Probe captures, each ten times longer
+    AUTOSET_PROBE_POINTS = 1000, // Samples per channel of a probe
+    AUTOSET_POINTS = 2000, // Most samples per channel chosen
+    AUTOSET_POINTS_MIN = 100, // Fewest samples per channel chosen
+    AUTOSET_CYCLES = 2, // Periods shown, before rounding up the timebase
+    AUTOSET_SIGNAL_MIN_MV = 20, // Smaller swings count as no signal
+    AUTOSET_PROBE_MARGIN = 100, // ms past twice a probe before giving up
+};
+
+// Sample data formats for FETCh and streaming (OSCilloscope:FORMat)
+typedef enum {
+    DATA_FORMAT_INT16, // Raw little-endian 16-bit words
+    DATA_FORMAT_PACKED, // Two 12-bit samples in three bytes
+    DATA_FORMAT_INT8, // Upper 8 of the sample bits
+    DATA_FORMAT_DELTA, // Lossless delta/run-length code, see delta_codec.h
+    DATA_FORMAT_MVOLT, // Calibrated little-endian 16-bit millivolts
+} DataFormat;
+
+// Interface stream blocks are sent on
+typedef enum {
+    STREAM_INTERFACE_CDC, // SCPI serial port
+    STREAM_INTERFACE_BULK, // Vendor bulk interface
+    STREAM_INTERFACE_ISO, // Isochronous interface, PSLAB_USB_ISO builds
+} StreamInterface;
+
+// Part of a record sent by OSCilloscope:FETCh:DATa?, in frames: one sample
+// per channel sent
+typedef struct {
+    uint32_t start; // First frame
+    uint32_t count; // Frames, 0 for all from start on
+    uint32_t stride; // Frames from one sent to the next
+} FetchWindow;
+
+/**
+ * @brief Samples picked out of a buffer: frames of width samples, the
+ * first sample of each stride samples after that of the previous one
+ *
+ * Contiguous when width equals stride.
+ */
+typedef struct {
+    uint32_t width; // Samples per frame sent
+    uint32_t stride; // Samples from the start of a frame to the next
+} SampleLayout;
+
+// Converted samples of the last OSCilloscope:FETCh:DATa? that was not sent
+// in place, for the next fetch of the same samples in the same format. It
+// is the last block in sample memory, and gives way to any other block.
+typedef struct {
+    uint8_t *data; // In sample memory, nullptr if empty
+    uint32_t len; // Bytes in data
+    uint32_t sequence; // Capture the samples belong to
+    DataFormat format;
+    uint16_t const *samples; // First sample converted
+    uint32_t count;
+    SampleLayout layout;
+} FetchCache;
+
+// Record header sent ahead of the samples by OSCilloscope:FETCh:DATa? with
+// OSCilloscope:FORMat:HEADer ON; sent as is, so little-endian
+typedef struct {
+    uint8_t version; // CAPTURE_HEADER_VERSION
+    uint8_t size; // Header size in bytes
+    uint8_t channels; // Samples per frame
+    uint8_t channel_map; // Bit n set if channel n + 1 is captured
+    uint8_t format; // DataFormat
+    uint8_t resolution; // Sample bits
+    uint8_t flags; // CAPTURE_FLAG_*
+    uint8_t decimation; // DSO_Decimation
+    uint32_t sample_rate; // Record sample rate in Hz
+    uint32_t points; // Samples in the record, all channels
+    uint32_t trigger_index; // DSO_get_trigger_index
+    uint32_t timestamp_us; // DSO_get_start_time_us
+    uint32_t sequence; // Captures completed since *RST, this one included
+    uint32_t segments; // Segments in the record
+    uint32_t sof_frame; // USB_get_frame_stamp at fetch time, 0 if none
+    uint32_t sof_time_us; // Local time of that frame, on timestamp_us' clock
+} CaptureHeader;
+
+static_assert(sizeof(CaptureHeader) == 40, "CaptureHeader must be packed");
+
+// Block header sent ahead of the samples of each stream block with
+// OSCilloscope:FORMat:HEADer ON; sent as is, so little-endian
+typedef struct {
+    uint8_t version; // STREAM_HEADER_VERSION
+    uint8_t size; // Header size in bytes
+    uint8_t format; // DataFormat
+    uint8_t flags; // STREAM_FLAG_*
+    uint32_t sequence; // Blocks completed since the start, dropped included
+    uint32_t gaps; // Pauses and dropped blocks before this block
+    uint32_t decimation; // Samples averaged into each sample of the block
+    uint32_t sample_rate; // Sample rate of the block in Hz
+    uint32_t samples; // Samples in the block, all channels
+} StreamHeader;
+
+static_assert(sizeof(StreamHeader) == 24, "StreamHeader must be packed");
+
+// Statistics of a record, sent as the data of its last block and returned
+// by OSCilloscope:STReam:RECord:STATistics?; little-endian
+typedef struct {
+    uint64_t samples; // Samples sent, all channels
+    uint32_t blocks; // Sample blocks sent
+    uint32_t drops; // Gaps: pauses and dropped blocks
+    uint32_t queue_depth_max; // Most blocks waiting to be sent at once
+    uint32_t rate; // OSCilloscope:STReam:RECord:RATE? at the start, in Hz
+} RecordStats;
+
+static_assert(sizeof(RecordStats) == 24, "RecordStats must be packed");
+
+// Stream settings a record overrides, restored once it ends
+typedef struct {
+    DataFormat data_format;
+    bool data_header;
+    StreamInterface interface;
+    bool auto_decimation;
+    bool math_enabled;
+} StreamSettings;
+
+// Math channel after *RST: the difference, or the mean with SUM
+#define STREAM_MATH_DEFAULT                                                    \
+    {                                                                          \
+        .function = CHANNEL_MATH_DIFFERENCE,                                   \
+        .gains = { FIXED_Q15_FROM_FLOAT(0.5), FIXED_Q15_FROM_FLOAT(0.5) },     \
+        .sample_bits = 12, .math_only = false,                                 \
+    }
+
+// Raw host output, implemented in common.c
+extern uint32_t protocol_write_raw(uint8_t const *data, uint32_t len);
+extern bool protocol_bulk_open(void);
+extern uint32_t protocol_write_bulk(uint8_t const *data, uint32_t len);
+extern bool protocol_write_raw_buffer(uint8_t const *data, uint32_t len);
+extern bool protocol_raw_tx_pending(void);
+extern bool protocol_write_bulk_buffer(uint8_t const *data, uint32_t len);
+extern bool protocol_bulk_tx_pending(void);
+extern bool protocol_iso_open(void);
+extern uint32_t protocol_write_iso(uint8_t const *data, uint32_t len);
+extern bool protocol_write_iso_buffer(uint8_t const *data, uint32_t len);
+extern bool protocol_iso_tx_pending(void);
+extern void
+protocol_result_block(scpi_t *context, uint8_t const *data, uint32_t len);
+extern void protocol_result_block_prefixed(
+    scpi_t *context,
+    uint8_t const *prefix,
+    uint32_t prefix_len,
+    uint8_t const *data,
+    uint32_t len
+);
+extern void protocol_result_int32_ascii(
+    scpi_t *context,
+    int32_t const *values,
+    size_t count
+);
+extern void protocol_result_uint32_ascii(
+    scpi_t *context,
+    uint32_t const *values,
+    size_t count
+);
+
+// Measured link rate, implemented in linktest.c
+extern uint32_t linktest_tx_rate(void);
+
+// Streamed arbitrary blocks, implemented in common.c
+extern uint32_t protocol_block_streamed(void);
+extern void protocol_block_receive(
+    void *destination,
+    scpi_command_callback_t complete
+);
+
+// Deferred query responses, status events and overlapped commands,
+// implemented in common.c
+extern scpi_result_t
+protocol_defer(scpi_t *context, scpi_command_callback_t resume);
+extern bool protocol_is_resuming(void);
+extern void protocol_operation_event(uint16_t bits);
+extern void protocol_operation_pending(bool (*done)(void), uint32_t timeout);
+
+// Capture settings, applied to every single-shot configuration; the
+// resolution also applies to streams
+typedef struct {
+    DSO_TriggerMode trigger_mode;
+    uint16_t trigger_level;
+    uint32_t pretrigger;
+    uint32_t segments;
+    uint32_t averages;
+    uint32_t records;
+    DSO_Decimation decimation;
+    DSO_Resolution resolution;
+} CaptureSettings;
+
+// Oscilloscope setup, saved by *SAV and applied as a whole by *RCL and
+// OSCilloscope:CONFigure:APPLy
+typedef struct {
+    DSO_Mode mode;
+    DSO_Channel channel;
+    uint32_t timebase_us;
+    uint32_t points;
+    CaptureSettings capture;
+    DataFormat data_format;
+    bool data_header;
+} Setup;
+
+// Spectrum of the last capture, held in sample memory after the
+// acquisition buffer
+typedef struct {
+    int32_t *work;
+    FIXED_Q1616 *bins; // size / 2 bins in Q16.16 ADC codes
+    uint32_t size;
+    uint32_t sample_rate;
+} Spectrum;
+
+// Completed half of the continuous buffer, lent by the DSO
+typedef struct {
+    uint16_t const *samples;
+    uint32_t count;
+    uint32_t sequence; // StreamHeader fields, taken when the block came in
+    uint32_t gaps;
+} StreamBlock;
+
+RING_DEFINE(StreamBlockRing, stream_block_ring, StreamBlock)
+
+// Data of the last block of a record, sent in place
+static RecordStats g_record_end ARENA_DMA_MEMORY;
+
+// Sample memory: the acquisition buffer is always its first block, followed
+// by the encoded stream block while streaming
+static uint8_t g_sample_memory[SAMPLE_MEMORY_SIZE] ARENA_DMA_MEMORY;
+static Arena g_sample_arena = {
+    .base = g_sample_memory,
+    .size = SAMPLE_MEMORY_SIZE,
+    .used = 0,
+    .peak = 0,
 };
 
 // DSO state (internal to this module)
@@ -30,20 +321,321 @@ static struct {
     DSO_Handle *dso_handle;
     uint16_t *acquisition_buffer;
     uint32_t acquisition_buffer_size;
+    uint32_t *accumulator; // Sums of averaged captures, behind the buffer
+    // Records captured in turn, the acquisition buffer being one of them;
+    // the second follows the accumulator, nullptr with a single record
+    uint16_t *records[RECORDS_MAX];
     uint32_t timebase_us;
     bool acquisition_complete;
+    uint32_t volatile capture_sequence; // Captures completed since reset
+    DataFormat data_format;
+    bool data_header; // Fetched records start with a CaptureHeader
+    CaptureSettings capture;
+    // Fetch query waiting for the acquisition, see finish_acquisition
+    uint32_t fetch_start; // Tick at which it started waiting
+    uint32_t fetch_argument; // Its parameter, parsed before deferring
+    FetchWindow fetch_window; // Frames OSCilloscope:FETCh:DATa? sends
+    FetchCache fetch_cache;
+    // Streaming state; the queue is filled from the DSO callback
+    bool streaming;
+    StreamInterface stream_interface;
+    StreamBlockRing stream_queue;
+    StreamBlock stream_queue_storage[STREAM_QUEUE_SIZE];
+    uint32_t stream_overruns;
+    uint32_t stream_dropped; // Blocks dropped by all streams since reset
+    uint32_t stream_sequence; // Blocks completed since the stream started
+    uint32_t stream_gaps; // Gaps the next block will follow
+    uint32_t stream_gaps_sent; // Gaps before the block latched last
+    // Automatic decimation: after a gap, blocks are averaged down by twice
+    // the factor, into the reduced copy
+    bool stream_auto_decimation;
+    uint32_t stream_decimation;
+    uint16_t *stream_reduced;
+    // Math channel of dual-channel streams (OSCilloscope:MATH), computed
+    // into its own copy of the block
+    bool stream_math_enabled;
+    CHANNEL_MATH_Config stream_math;
+    uint16_t *stream_math_block;
+    // Block currently being transmitted (header, data, trailer); the data
+    // is sent in place, from the lent block or the encoded copy. The
+    // trailer holds the CRC, with StreamHeader, and the line ending; the
+    // CRC unit checksums the data while it is being sent
+    char stream_header[STREAM_HEADER_SIZE + sizeof(StreamHeader)];
+    uint32_t stream_header_len;
+    uint8_t const *stream_data;
+    uint32_t stream_data_len;
+    uint8_t stream_trailer[STREAM_CRC_SIZE + sizeof(SCPI_LINE_ENDING)];
+    uint32_t stream_trailer_len;
+    bool stream_crc_pending; // The CRC is not in the trailer yet
+    CHECKSUM_Job stream_checksum;
+    uint16_t const *stream_lent; // Block to return once its data is sent
+    uint8_t *stream_encoded; // Converted block, unless format is INT16
+    uint32_t stream_tx_offset;
+    uint32_t stream_tx_len;
+    // Recorder, OSCilloscope:STReam:RECord: a stream with fixed settings
+    // that, once stopped, sends what is queued and ends with RecordStats
+    bool recording;
+    bool record_ending; // Acquisition stopped, the queue drains
+    bool record_end_sent; // The RecordStats block is latched
+    StreamSettings record_saved; // Settings before the record
+    RecordStats record_stats; // Of the running or last record
+    // Roll mode: continuous acquisition into the acquisition buffer as a
+    // ring, read with OSCilloscope:FETCh:NEW?
+    bool rolling;
+    uint32_t roll_fetched; // Sample count up to which NEW? has sent
+    uint32_t roll_index; // Buffer index of the next sample to send
+    uint32_t roll_skipped; // Samples overwritten before NEW? sent them
+    // Histogram mode: continuous acquisition whose blocks go through a
+    // pipeline into the bins, read with OSCilloscope:FETCh:HISTogram?
+    bool histogram_active;
+    HISTOGRAM_State histogram; // Bins behind the buffer, or nullptr
+    PIPELINE_State histogram_pipeline; // Filled from the DSO callback
+    PIPELINE_Block histogram_queue_storage[STREAM_QUEUE_SIZE];
+    uint16_t histogram_low; // Codes binned, OSCilloscope:HISTogram:RANGe
+    uint16_t histogram_high;
+    // Mask test of every completed capture, OSCilloscope:MASK
+    MASK_Limit *mask; // One limit per buffer sample, behind the buffer
+    bool mask_enabled;
+    bool mask_valid; // mask_result belongs to the last capture
+    MASK_Result mask_result;
+    // OSCilloscope:AUTOset: probe captures run in turn from
+    // dso_autoset_task, from the shortest
+    bool autoset_active;
+    uint32_t autoset_probe; // Probe being captured
+    uint32_t autoset_start; // Tick it started at
+    scpi_t *autoset_context; // Context of the command, for errors
+    Setup autoset_setup; // Setup before the probes, restored after
 } g_dso_state = {
     .dso_handle = nullptr,
     .acquisition_buffer = nullptr,
     .acquisition_buffer_size = 0,
+    .accumulator = nullptr,
     .timebase_us = TIMEBASE_DEFAULT,
     .acquisition_complete = false,
+    .data_format = DATA_FORMAT_INT16,
+    .data_header = false,
+    .capture = { .trigger_mode = DSO_TRIGGER_NONE,
+                 .segments = 1,
+                 .averages = 1,
+                 .records = 1 },
+    .streaming = false,
+    .stream_interface = STREAM_INTERFACE_CDC,
+    .stream_auto_decimation = false,
+    .stream_decimation = 1,
+    .stream_math_enabled = false,
+    .stream_math = STREAM_MATH_DEFAULT,
+    .recording = false,
+    .rolling = false,
+    .histogram_active = false,
+    .histogram = { .bins = nullptr },
+    .histogram_low = 0,
+    .histogram_high = HISTOGRAM_BINS_MAX - 1,
+    .mask = nullptr,
+    .mask_enabled = false,
+    .mask_valid = false,
+    .autoset_active = false,
 };
 
+// Saved setups; *RST leaves them alone
+static struct {
+    Setup setup;
+    bool saved;
+} g_setup_slots[SETUP_SLOTS];
+
 /**
  * @brief DSO completion callback - called when acquisition is complete
  */
-void dso_complete_callback(void) { g_dso_state.acquisition_complete = true; }
+void dso_complete_callback(void)
+{
+    g_dso_state.mask_valid = g_dso_state.mask_enabled && g_dso_state.mask;
+    if (g_dso_state.mask_valid) {
+        MASK_test(
+            g_dso_state.mask,
+            g_dso_state.acquisition_buffer,
+            g_dso_state.acquisition_buffer_size,
+            &g_dso_state.mask_result
+        );
+    }
+
+    g_dso_state.acquisition_complete = true;
+    g_dso_state.capture_sequence++;
+    protocol_operation_event(OPER_ACQUISITION_COMPLETE);
+}
+
+/**
+ * @brief DSO block callback - called from interrupt context in stream mode
+ *
+ * Queues the lent buffer half for dso_stream_task, which returns it to the
+ * DSO once it has been sent. The DSO lends at most two halves at a time, so
+ * the queue only overflows if blocks are not returned; such a block is
+ * returned at once and counted as an overrun.
+ */
+void dso_stream_block_callback(uint16_t const *block, uint32_t samples)
+{
+    StreamBlock const entry = {
+        .samples = block,
+        .count = samples,
+        .sequence = g_dso_state.stream_sequence++,
+        .gaps = g_dso_state.stream_gaps,
+    };
+    // The DSO pauses after this block if the other half is still lent,
+    // queued or being sent
+    bool const pausing =
+        !stream_block_ring_is_empty(&g_dso_state.stream_queue) ||
+        g_dso_state.stream_lent != nullptr;
+
+    if (!stream_block_ring_put(&g_dso_state.stream_queue, entry)) {
+        g_dso_state.stream_overruns++;
+        g_dso_state.stream_dropped++;
+        g_dso_state.stream_gaps++;
+        DSO_release_block(g_dso_state.dso_handle, block);
+        protocol_operation_event(OPER_STREAM_ERROR);
+        return;
+    }
+    if (pausing) {
+        g_dso_state.stream_gaps++;
+    }
+
+    uint32_t const depth =
+        stream_block_ring_available(&g_dso_state.stream_queue);
+    if (depth > g_dso_state.record_stats.queue_depth_max) {
+        g_dso_state.record_stats.queue_depth_max = depth;
+    }
+}
+
+/**
+ * @brief Empty the fetch cache and give its memory back
+ */
+static void fetch_cache_drop(void)
+{
+    ARENA_release(&g_sample_arena, g_dso_state.fetch_cache.data);
+    g_dso_state.fetch_cache.data = nullptr;
+}
+
+/**
+ * @brief Allocate a block of sample memory, in place of the fetch cache
+ */
+static void *sample_alloc(uint32_t size)
+{
+    fetch_cache_drop();
+    return ARENA_alloc(&g_sample_arena, size);
+}
+
+/**
+ * @brief Release a block of sample memory and every block after it
+ *
+ * The fetch cache is always among them.
+ */
+static void sample_release(void const *block)
+{
+    if (block != nullptr) {
+        fetch_cache_drop();
+        ARENA_release(&g_sample_arena, block);
+    }
+}
+
+/**
+ * @brief Give back the stream settings saved by a record
+ */
+static void record_restore_settings(void)
+{
+    StreamSettings const *const saved = &g_dso_state.record_saved;
+
+    g_dso_state.data_format = saved->data_format;
+    g_dso_state.data_header = saved->data_header;
+    g_dso_state.stream_interface = saved->interface;
+    g_dso_state.stream_auto_decimation = saved->auto_decimation;
+    g_dso_state.stream_math_enabled = saved->math_enabled;
+}
+
+/**
+ * @brief Clear streaming bookkeeping
+ *
+ * Blocks still queued or being sent are dropped without returning them;
+ * the DSO takes all of them back when it is started again. A record ends
+ * here however it was stopped.
+ */
+static void stream_reset(void)
+{
+    g_dso_state.streaming = false;
+    if (g_dso_state.recording) {
+        g_dso_state.record_stats.drops = g_dso_state.stream_gaps;
+        record_restore_settings();
+        g_dso_state.recording = false;
+        g_dso_state.record_ending = false;
+    }
+    stream_block_ring_init(
+        &g_dso_state.stream_queue,
+        g_dso_state.stream_queue_storage,
+        STREAM_QUEUE_SIZE
+    );
+    g_dso_state.stream_lent = nullptr;
+    g_dso_state.stream_tx_offset = 0;
+    g_dso_state.stream_tx_len = 0;
+    g_dso_state.stream_sequence = 0;
+    g_dso_state.stream_gaps = 0;
+    g_dso_state.stream_gaps_sent = 0;
+    g_dso_state.stream_decimation = 1;
+    if (g_dso_state.stream_crc_pending) {
+        CHECKSUM_cancel(&g_dso_state.stream_checksum);
+        g_dso_state.stream_crc_pending = false;
+    }
+    // The reduced copy comes first, so releasing it goes last
+    sample_release(g_dso_state.stream_encoded);
+    sample_release(g_dso_state.stream_math_block);
+    sample_release(g_dso_state.stream_reduced);
+    g_dso_state.stream_encoded = nullptr;
+    g_dso_state.stream_math_block = nullptr;
+    g_dso_state.stream_reduced = nullptr;
+}
+
+/**
+ * @brief Reserve the acquisition buffer at the start of sample memory
+ *
+ * Any stream block, histogram or mask behind the previous buffer is
+ * dropped. The buffer always starts at the same address, so a DSO handle
+ * configured with the previous size keeps a valid pointer. With averaging
+ * set, the accumulator follows the buffer, and is left out if it does not
+ * fit; so is the second record, which follows them with two records set.
+ *
+ * @param samples Buffer size in samples
+ * @return Acquisition buffer, or nullptr if it does not fit
+ */
+static uint16_t *reserve_acquisition_buffer(uint32_t samples)
+{
+    g_dso_state.stream_encoded = nullptr;
+    g_dso_state.stream_math_block = nullptr;
+    g_dso_state.stream_reduced = nullptr;
+    g_dso_state.accumulator = nullptr;
+    g_dso_state.records[0] = nullptr;
+    g_dso_state.records[1] = nullptr;
+    g_dso_state.histogram = (HISTOGRAM_State){ .bins = nullptr };
+    g_dso_state.mask = nullptr;
+    g_dso_state.mask_enabled = false;
+    ARENA_reset(&g_sample_arena);
+    g_dso_state.fetch_cache.data = nullptr;
+    if (samples > POINTS_MAX) {
+        return nullptr;
+    }
+
+    uint16_t *const buffer =
+        sample_alloc(samples * sizeof(uint16_t));
+    if (buffer && g_dso_state.capture.averages > 1) {
+        g_dso_state.accumulator =
+            sample_alloc(samples * sizeof(uint32_t));
+    }
+    g_dso_state.records[0] = buffer;
+    if (buffer && g_dso_state.capture.records > 1) {
+        g_dso_state.records[1] =
+            sample_alloc(samples * sizeof(uint16_t));
+    }
+    return buffer;
+}
+
+/**
+ * @brief Sample memory arena, for SYSTem:MEMory?
+ */
+Arena const *dso_sample_arena(void) { return &g_sample_arena; }
 
 /**
  * @brief Reset DSO state to default values
@@ -57,15 +649,61 @@ void dso_reset_state(void)
         g_dso_state.dso_handle = nullptr;
     }
 
-    // Free acquisition buffer if allocated
-    if (g_dso_state.acquisition_buffer) {
-        free(g_dso_state.acquisition_buffer);
-        g_dso_state.acquisition_buffer = nullptr;
-    }
+    // Release the acquisition buffer and any blocks behind it
+    ARENA_reset(&g_sample_arena);
+    g_dso_state.fetch_cache.data = nullptr;
+    g_dso_state.acquisition_buffer = nullptr;
+    g_dso_state.accumulator = nullptr;
+    g_dso_state.records[0] = nullptr;
+    g_dso_state.records[1] = nullptr;
+    g_dso_state.histogram = (HISTOGRAM_State){ .bins = nullptr };
+    g_dso_state.mask = nullptr;
+    g_dso_state.mask_enabled = false;
+    g_dso_state.mask_valid = false;
 
     g_dso_state.acquisition_buffer_size = 0;
     g_dso_state.timebase_us = TIMEBASE_DEFAULT;
     g_dso_state.acquisition_complete = false;
+    g_dso_state.capture_sequence = 0;
+    g_dso_state.data_format = DATA_FORMAT_INT16;
+    g_dso_state.data_header = false;
+    g_dso_state.capture = (CaptureSettings){
+        .trigger_mode = DSO_TRIGGER_NONE,
+        .segments = 1,
+        .averages = 1,
+        .records = 1,
+    };
+    g_dso_state.stream_overruns = 0;
+    g_dso_state.stream_dropped = 0;
+    g_dso_state.stream_interface = STREAM_INTERFACE_CDC;
+    g_dso_state.stream_auto_decimation = false;
+    g_dso_state.stream_math_enabled = false;
+    g_dso_state.stream_math = (CHANNEL_MATH_Config)STREAM_MATH_DEFAULT;
+    g_dso_state.recording = false; // Its saved settings give way to these
+    stream_reset();
+    g_dso_state.rolling = false;
+    g_dso_state.roll_fetched = 0;
+    g_dso_state.roll_index = 0;
+    g_dso_state.roll_skipped = 0;
+    g_dso_state.histogram_active = false;
+    g_dso_state.histogram_low = 0;
+    g_dso_state.histogram_high = HISTOGRAM_BINS_MAX - 1;
+    g_dso_state.autoset_active = false;
+}
+
+/**
+ * @brief Sample rate at which a buffer spans the timebase
+ *
+ * @param buffer_size Buffer size in samples
+ * @return Sample rate in Hz, all channels, 0 if below 1 Hz
+ */
+static uint32_t timebase_sample_rate(uint32_t buffer_size)
+{
+    // Total acquisition time = timebase_us * 10 divisions
+    uint64_t const duration_us =
+        (uint64_t)g_dso_state.timebase_us * HORIZONTAL_DIVISIONS;
+    uint64_t const rate = ((uint64_t)buffer_size * SI_MICRO_DIV) / duration_us;
+    return rate > UINT32_MAX ? UINT32_MAX : (uint32_t)rate;
 }
 
 /**
@@ -89,10 +727,7 @@ static scpi_result_t configure_sample_rate_and_buffer(
 )
 {
     // Calculate sample rate using current timebase
-    // Total acquisition time = timebase_us * 10 divisions
-    // sample_rate = buffer_size * 1,000,000 / (timebase_us * 10)
-    uint32_t sample_rate = (buffer_size * SI_MICRO_DIV) /
-                           (g_dso_state.timebase_us * HORIZONTAL_DIVISIONS);
+    uint32_t const sample_rate = timebase_sample_rate(buffer_size);
 
     // Validate calculated sample rate (must be > 0)
     if (sample_rate == 0) {
@@ -102,28 +737,31 @@ static scpi_result_t configure_sample_rate_and_buffer(
 
     // Check if sample rate is achievable with current DSO mode
     // Use the mode parameter (the new mode being set)
-    uint32_t max_sample_rate = DSO_get_max_sample_rate(mode);
+    uint32_t max_sample_rate =
+        DSO_get_max_sample_rate(mode, g_dso_state.capture.resolution);
 
     if (sample_rate > max_sample_rate) {
         SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
         return SCPI_RES_ERR;
     }
 
-    // Allocate buffer if needed
-    uint16_t *new_buffer = nullptr;
+    // Resize the buffer if needed, or add the accumulator or second record
+    // behind it
+    uint16_t *new_buffer = g_dso_state.acquisition_buffer;
+    bool const averaging = g_dso_state.capture.averages > 1;
+    bool const alternating = g_dso_state.capture.records > 1;
 
-    if (!g_dso_state.acquisition_buffer ||
-        g_dso_state.acquisition_buffer_size != buffer_size) {
-
-        new_buffer = realloc(
-            g_dso_state.acquisition_buffer, buffer_size * sizeof(uint16_t)
-        );
-        if (!new_buffer) {
+    if (!new_buffer || g_dso_state.acquisition_buffer_size != buffer_size ||
+        (averaging && !g_dso_state.accumulator) ||
+        (alternating && !g_dso_state.records[1])) {
+        new_buffer = reserve_acquisition_buffer(buffer_size);
+        if (!new_buffer || (averaging && !g_dso_state.accumulator) ||
+            (alternating && !g_dso_state.records[1])) {
+            // Keep the current buffer reserved
+            reserve_acquisition_buffer(g_dso_state.acquisition_buffer_size);
             SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
             return SCPI_RES_ERR;
         }
-    } else {
-        new_buffer = g_dso_state.acquisition_buffer;
     }
 
     // Update configuration
@@ -134,6 +772,44 @@ static scpi_result_t configure_sample_rate_and_buffer(
     return SCPI_RES_OK;
 }
 
+/**
+ * @brief Helper function to pick the decimation factor for a configuration
+ *
+ * Oversamples by the largest whole factor the ADC supports at the stored
+ * sample rate, up to DSO_DECIMATION_FACTOR_MAX (half of it with four
+ * channels). The filter takes an even factor up to
+ * DECIMATE_FILTER_FACTOR_MAX; below DECIMATE_FILTER_FACTOR_MIN the
+ * configuration is rejected by the DSO.
+ *
+ * @param config Configuration with mode, sample rate and decimation set
+ * @return ADC samples per stored sample, 1 when not decimating
+ */
+static uint32_t decimation_factor(DSO_Config const *config)
+{
+    if (config->decimation == DSO_DECIMATION_NONE || config->sample_rate == 0) {
+        return 1;
+    }
+
+    uint32_t const factor =
+        DSO_get_max_sample_rate(config->mode, config->resolution) /
+        config->sample_rate;
+    uint32_t const factor_max = config->mode == DSO_MODE_QUAD_CHANNEL
+                                    ? DSO_DECIMATION_FACTOR_MAX / 2
+                                    : DSO_DECIMATION_FACTOR_MAX;
+
+    if (config->decimation == DSO_DECIMATION_FILTER) {
+        uint32_t const filter_max = factor_max < DECIMATE_FILTER_FACTOR_MAX
+                                        ? factor_max
+                                        : DECIMATE_FILTER_FACTOR_MAX;
+        uint32_t const even = (factor > filter_max ? filter_max : factor) & ~1U;
+        return even > 1 ? even : 2;
+    }
+    if (factor > factor_max) {
+        return factor_max;
+    }
+    return factor > 1 ? factor : 1;
+}
+
 /**
  * @brief Helper function to apply DSO configuration changes
  *
@@ -147,6 +823,20 @@ static scpi_result_t configure_sample_rate_and_buffer(
 static scpi_result_t apply_dso_config(scpi_t *context, DSO_Config *new_config)
 {
     new_config->complete_callback = dso_complete_callback;
+    // Streams are free-running; capture settings only apply to single shots
+    bool const single_shot = !new_config->continuous;
+    new_config->trigger_mode =
+        single_shot ? g_dso_state.capture.trigger_mode : DSO_TRIGGER_NONE;
+    new_config->trigger_level = g_dso_state.capture.trigger_level;
+    new_config->pretrigger = g_dso_state.capture.pretrigger;
+    new_config->segments = single_shot ? g_dso_state.capture.segments : 1;
+    new_config->averages = single_shot ? g_dso_state.capture.averages : 1;
+    new_config->accumulator =
+        new_config->averages > 1 ? g_dso_state.accumulator : nullptr;
+    new_config->decimation =
+        single_shot ? g_dso_state.capture.decimation : DSO_DECIMATION_NONE;
+    new_config->resolution = g_dso_state.capture.resolution;
+    new_config->decimation_factor = decimation_factor(new_config);
     Error err = ERROR_NONE;
 
     TRY
@@ -161,10 +851,9 @@ static scpi_result_t apply_dso_config(scpi_t *context, DSO_Config *new_config)
     }
     CATCH(err)
     {
-        // If the new buffer is not the same as the acquisition buffer, free
-        // it here. Otherwise, keep the existing buffer.
-        if (new_config->buffer != g_dso_state.acquisition_buffer) {
-            free(new_config->buffer);
+        // Shrink or grow the reservation back to the existing buffer
+        if (new_config->buffer_size != g_dso_state.acquisition_buffer_size) {
+            reserve_acquisition_buffer(g_dso_state.acquisition_buffer_size);
         }
 
         switch (err) {
@@ -181,32 +870,80 @@ static scpi_result_t apply_dso_config(scpi_t *context, DSO_Config *new_config)
         }
     }
 
-    // Update state - the buffer pointer may have changed due to realloc
+    // Update state - the buffer is new on first configuration
     g_dso_state.acquisition_buffer = new_config->buffer;
     g_dso_state.acquisition_buffer_size = new_config->buffer_size;
     g_dso_state.acquisition_complete = false;
+    fetch_cache_drop();
 
     return SCPI_RES_OK;
 }
 
 /**
- * @brief OSCilloscope:CONFigure:CHANnel - Set DSO channel
+ * @brief Helper function to parse a channel selection
  *
- * Syntax: OSCilloscope:CONFigure:CHANnel {CH1|CH2|CH1CH2}
+ * @param context SCPI context for error reporting
+ * @param[out] mode DSO mode of the selection
+ * @param[out] channel Input channel, the primary one in multi-channel modes
+ * @return true on success, false if the parameter is missing or invalid
  */
-scpi_result_t scpi_cmd_configure_oscilloscope_channel(scpi_t *context)
+static bool parse_channel(
+    scpi_t *context,
+    DSO_Mode *mode,
+    DSO_Channel *channel
+)
 {
-    enum { CHANNEL_CH1, CHANNEL_CH2, CHANNEL_CH1CH2 };
-    scpi_choice_def_t const channel_choices[] = { { "CH1", CHANNEL_CH1 },
-                                                  { "CH2", CHANNEL_CH2 },
-                                                  { "CH1CH2", CHANNEL_CH1CH2 },
-                                                  SCPI_CHOICE_LIST_END };
+    enum { CHANNEL_CH1, CHANNEL_CH2, CHANNEL_CH1CH2, CHANNEL_CH1CH2CH3CH4 };
+    scpi_choice_def_t const channel_choices[] = {
+        { "CH1", CHANNEL_CH1 },
+        { "CH2", CHANNEL_CH2 },
+        { "CH1CH2", CHANNEL_CH1CH2 },
+        { "CH1CH2CH3CH4", CHANNEL_CH1CH2CH3CH4 },
+        SCPI_CHOICE_LIST_END
+    };
 
     int32_t channel_choice = -1;
 
     // Parse required parameter using SCPI_ParamChoice
     if (!SCPI_ParamChoice(context, channel_choices, &channel_choice, true)) {
         SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return false;
+    }
+
+    switch (channel_choice) {
+    case CHANNEL_CH1:
+        *channel = DSO_CHANNEL_0;
+        *mode = DSO_MODE_SINGLE_CHANNEL;
+        return true;
+    case CHANNEL_CH2:
+        *channel = DSO_CHANNEL_1;
+        *mode = DSO_MODE_SINGLE_CHANNEL;
+        return true;
+    case CHANNEL_CH1CH2:
+        *channel = DSO_CHANNEL_0; // Primary channel
+        *mode = DSO_MODE_DUAL_CHANNEL;
+        return true;
+    case CHANNEL_CH1CH2CH3CH4:
+        *channel = DSO_CHANNEL_0; // Primary channel
+        *mode = DSO_MODE_QUAD_CHANNEL;
+        return true;
+    default:
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return false;
+    }
+}
+
+/**
+ * @brief OSCilloscope:CONFigure:CHANnel - Set DSO channel
+ *
+ * Syntax: OSCilloscope:CONFigure:CHANnel {CH1|CH2|CH1CH2|CH1CH2CH3CH4}
+ */
+scpi_result_t scpi_cmd_configure_oscilloscope_channel(scpi_t *context)
+{
+    DSO_Mode mode = DSO_MODE_SINGLE_CHANNEL;
+    DSO_Channel channel = DSO_CHANNEL_0;
+
+    if (!parse_channel(context, &mode, &channel)) {
         return SCPI_RES_ERR;
     }
 
@@ -221,25 +958,8 @@ scpi_result_t scpi_cmd_configure_oscilloscope_channel(scpi_t *context)
     DSO_Config config = g_dso_state.dso_handle
                             ? DSO_get_config(g_dso_state.dso_handle)
                             : (DSO_Config)DSO_CONFIG_DEFAULT;
-
-    // Update channel and mode based on choice
-    switch (channel_choice) {
-    case CHANNEL_CH1:
-        config.channel = DSO_CHANNEL_0;
-        config.mode = DSO_MODE_SINGLE_CHANNEL;
-        break;
-    case CHANNEL_CH2:
-        config.channel = DSO_CHANNEL_1;
-        config.mode = DSO_MODE_SINGLE_CHANNEL;
-        break;
-    case CHANNEL_CH1CH2:
-        config.channel = DSO_CHANNEL_0; // Primary channel
-        config.mode = DSO_MODE_DUAL_CHANNEL;
-        break;
-    default:
-        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
-        return SCPI_RES_ERR;
-    }
+    config.mode = mode;
+    config.channel = channel;
 
     // Use current buffer size, or default if not set
     uint32_t buffer_size = g_dso_state.acquisition_buffer_size > 0
@@ -266,6 +986,7 @@ scpi_result_t scpi_cmd_configure_oscilloscope_channel(scpi_t *context)
  * "CH1" - Single channel mode, channel 1
  * "CH2" - Single channel mode, channel 2
  * "CH1CH2" - Dual channel mode
+ * "CH1CH2CH3CH4" - Four channel mode
  */
 scpi_result_t scpi_cmd_configure_oscilloscope_channel_q(scpi_t *context)
 {
@@ -273,7 +994,9 @@ scpi_result_t scpi_cmd_configure_oscilloscope_channel_q(scpi_t *context)
                             ? DSO_get_config(g_dso_state.dso_handle)
                             : (DSO_Config)DSO_CONFIG_DEFAULT;
 
-    if (config.mode == DSO_MODE_DUAL_CHANNEL) {
+    if (config.mode == DSO_MODE_QUAD_CHANNEL) {
+        SCPI_ResultText(context, "CH1CH2CH3CH4");
+    } else if (config.mode == DSO_MODE_DUAL_CHANNEL) {
         SCPI_ResultText(context, "CH1CH2");
     } else if (config.channel == DSO_CHANNEL_0) {
         SCPI_ResultText(context, "CH1");
@@ -413,11 +1136,27 @@ scpi_result_t scpi_cmd_configure_oscilloscope_acquire_points_q(scpi_t *context)
     return SCPI_RES_OK;
 }
 
+/**
+ * @brief OSCilloscope:CONFigure:ACQuire:POINts:MAXimum? - Query the longest
+ * acquisition
+ *
+ * Returns the largest buffer size in samples that fits the sample memory. It
+ * is the same in every mode; in CH1CH2 mode both channels share it.
+ */
+scpi_result_t scpi_cmd_configure_oscilloscope_acquire_points_max_q(
+    scpi_t *context
+)
+{
+    SCPI_ResultUInt32(context, POINTS_MAX);
+    return SCPI_RES_OK;
+}
+
 /**
  * @brief OSCilloscope:CONFigure:ACQuire:SRATe? - Query current DSO sample rate
  *
  * Returns the currently configured sample rate in samples per second.
- * The sample rate is calculated based on the timebase and buffer size.
+ * The sample rate is calculated based on the timebase and buffer size and
+ * reported as achieved by the sample clock, rounded to the nearest Hz.
  */
 scpi_result_t scpi_cmd_configure_oscilloscope_acquire_srate_q(scpi_t *context)
 {
@@ -429,182 +1168,4202 @@ scpi_result_t scpi_cmd_configure_oscilloscope_acquire_srate_q(scpi_t *context)
 }
 
 /**
- * @brief OSCilloscope:INITiate - Start DSO data acquisition
+ * @brief OSCilloscope:CONFigure:ACQuire:STIMe? - Query the ADC sampling time
+ *
+ * Returns the time in ns each ADC samples its input before converting it,
+ * the longest that still keeps up with the current sample rate.
  */
-scpi_result_t scpi_cmd_initiate_oscilloscope(scpi_t *context)
+scpi_result_t scpi_cmd_configure_oscilloscope_acquire_stime_q(scpi_t *context)
 {
-    Error err = ERROR_NONE;
+    DSO_Config config = g_dso_state.dso_handle
+                            ? DSO_get_config(g_dso_state.dso_handle)
+                            : (DSO_Config)DSO_CONFIG_DEFAULT;
+    SCPI_ResultUInt32(context, DSO_get_sample_time_ns(&config));
+    return SCPI_RES_OK;
+}
 
-    // If DSO is not configured, initialize with default configuration
-    if (!g_dso_state.dso_handle) {
-        DSO_Config config = (DSO_Config)DSO_CONFIG_DEFAULT;
+/**
+ * @brief Helper function to update the trigger, segment and decimation
+ * settings
+ *
+ * Stores the new settings and reapplies the DSO configuration. The previous
+ * settings are restored if the DSO rejects the new ones.
+ *
+ * @param context SCPI context for error reporting
+ * @param settings New capture settings
+ * @return SCPI_RES_OK on success, SCPI_RES_ERR on failure
+ */
+static scpi_result_t set_capture(
+    scpi_t *context,
+    CaptureSettings const *settings
+)
+{
+    if (g_dso_state.streaming ||
+        (g_dso_state.dso_handle &&
+         DSO_is_acquisition_in_progress(g_dso_state.dso_handle))) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
 
-        // Use current buffer size, or default if not set
-        uint32_t buffer_size = g_dso_state.acquisition_buffer_size > 0
-                                   ? g_dso_state.acquisition_buffer_size
-                                   : BUFFER_SIZE_DEFAULT;
+    CaptureSettings const old_settings = g_dso_state.capture;
+    g_dso_state.capture = *settings;
 
-        // Configure sample rate and buffer using helper function
-        scpi_result_t result = configure_sample_rate_and_buffer(
-            context, buffer_size, config.mode, &config
-        );
-        if (result != SCPI_RES_OK) {
-            return result;
-        }
+    DSO_Config config = g_dso_state.dso_handle
+                            ? DSO_get_config(g_dso_state.dso_handle)
+                            : (DSO_Config)DSO_CONFIG_DEFAULT;
 
-        // Apply default configuration
+    uint32_t buffer_size = g_dso_state.acquisition_buffer_size > 0
+                               ? g_dso_state.acquisition_buffer_size
+                               : BUFFER_SIZE_DEFAULT;
+
+    scpi_result_t result = configure_sample_rate_and_buffer(
+        context, buffer_size, config.mode, &config
+    );
+    if (result == SCPI_RES_OK) {
         result = apply_dso_config(context, &config);
-        if (result != SCPI_RES_OK) {
-            return result;
-        }
     }
 
-    // Clear acquisition flags
-    g_dso_state.acquisition_complete = false;
-
-    // Start acquisition
-    TRY { DSO_start(g_dso_state.dso_handle); }
-    CATCH(err)
-    {
-        LOG_ERROR("DSO start error: 0x%08X", err);
-        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
-        return SCPI_RES_ERR;
+    if (result != SCPI_RES_OK) {
+        g_dso_state.capture = old_settings;
     }
-
-    return SCPI_RES_OK;
+    return result;
 }
 
 /**
- * @brief OSCilloscope:ABORt - Abort ongoing oscilloscope acquisition
+ * @brief Helper function to apply a complete oscilloscope setup
+ *
+ * Channel, timebase, points and capture settings take effect together, with
+ * a single reconfiguration of the DSO. The previous setup is kept if the DSO
+ * rejects the new one.
+ *
+ * @param context SCPI context for error reporting
+ * @param setup Setup to apply
+ * @return SCPI_RES_OK on success, SCPI_RES_ERR on failure
  */
-scpi_result_t scpi_cmd_abort_oscilloscope(scpi_t *context)
+static scpi_result_t apply_setup(scpi_t *context, Setup const *setup)
 {
-    (void)context;
+    if (g_dso_state.streaming ||
+        (g_dso_state.dso_handle &&
+         DSO_is_acquisition_in_progress(g_dso_state.dso_handle))) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
 
-    if (g_dso_state.dso_handle) {
-        DSO_stop(g_dso_state.dso_handle);
-        DSO_deinit(g_dso_state.dso_handle);
-        g_dso_state.dso_handle = nullptr;
+    uint32_t const old_timebase_us = g_dso_state.timebase_us;
+    CaptureSettings const old_settings = g_dso_state.capture;
+    g_dso_state.timebase_us = setup->timebase_us;
+    g_dso_state.capture = setup->capture;
+
+    DSO_Config config = g_dso_state.dso_handle
+                            ? DSO_get_config(g_dso_state.dso_handle)
+                            : (DSO_Config)DSO_CONFIG_DEFAULT;
+    config.mode = setup->mode;
+    config.channel = setup->channel;
+
+    scpi_result_t result = configure_sample_rate_and_buffer(
+        context, setup->points, config.mode, &config
+    );
+    if (result == SCPI_RES_OK) {
+        result = apply_dso_config(context, &config);
     }
 
-    g_dso_state.acquisition_complete = false;
+    if (result != SCPI_RES_OK) {
+        g_dso_state.timebase_us = old_timebase_us;
+        g_dso_state.capture = old_settings;
+        return result;
+    }
 
+    g_dso_state.data_format = setup->data_format;
+    g_dso_state.data_header = setup->data_header;
     return SCPI_RES_OK;
 }
 
 /**
- * @brief OSCilloscope:FETCh:DATa? - Fetch the oscilloscope data
+ * @brief Helper function to take a snapshot of the current setup
  */
-scpi_result_t scpi_cmd_fetch_oscilloscope_data_q(scpi_t *context)
+static Setup current_setup(void)
 {
-    // Check if DSO is configured
-    if (!g_dso_state.dso_handle || !g_dso_state.acquisition_buffer) {
+    DSO_Config const config = g_dso_state.dso_handle
+                                  ? DSO_get_config(g_dso_state.dso_handle)
+                                  : (DSO_Config)DSO_CONFIG_DEFAULT;
+
+    return (Setup){
+        .mode = config.mode,
+        .channel = config.channel,
+        .timebase_us = g_dso_state.timebase_us,
+        .points = g_dso_state.acquisition_buffer_size > 0
+                      ? g_dso_state.acquisition_buffer_size
+                      : BUFFER_SIZE_DEFAULT,
+        .capture = g_dso_state.capture,
+        .data_format = g_dso_state.data_format,
+        .data_header = g_dso_state.data_header,
+    };
+}
+
+/**
+ * @brief OSCilloscope:CONFigure:APPLy - Set channel, timebase and points
+ *
+ * Syntax: OSCilloscope:CONFigure:APPLy {CH1|CH2|CH1CH2|CH1CH2CH3CH4},
+ * <timebase_us>,<points>
+ *
+ * Same as OSCilloscope:CONFigure:CHANnel, TIMEbase and ACQuire:POINts in a
+ * row, but the DSO is reconfigured once, and only if all three parameters
+ * are accepted. The sample rate follows from the new timebase and points.
+ */
+scpi_result_t scpi_cmd_configure_oscilloscope_apply(scpi_t *context)
+{
+    Setup setup = {
+        .capture = g_dso_state.capture,
+        .data_format = g_dso_state.data_format,
+        .data_header = g_dso_state.data_header,
+    };
+
+    if (!parse_channel(context, &setup.mode, &setup.channel)) {
+        return SCPI_RES_ERR;
+    }
+    if (!SCPI_ParamUInt32(context, &setup.timebase_us, true) ||
+        !SCPI_ParamUInt32(context, &setup.points, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    if (setup.timebase_us == 0 || setup.points == 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    return apply_setup(context, &setup);
+}
+
+/**
+ * @brief Helper function to parse a setup slot number
+ */
+static bool parse_setup_slot(scpi_t *context, uint32_t *slot)
+{
+    if (!SCPI_ParamUInt32(context, slot, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return false;
+    }
+    if (*slot >= SETUP_SLOTS) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief *SAV - Save the oscilloscope setup
+ *
+ * Syntax: *SAV <slot>
+ *
+ * Keeps channel, timebase, points, trigger, segment, acquisition type,
+ * resolution and data format settings in one of SETUP_SLOTS slots in RAM.
+ * Saved setups survive *RST, but not a power cycle.
+ */
+scpi_result_t scpi_cmd_save_setup(scpi_t *context)
+{
+    uint32_t slot = 0;
+
+    if (!parse_setup_slot(context, &slot)) {
+        return SCPI_RES_ERR;
+    }
+
+    g_setup_slots[slot].setup = current_setup();
+    g_setup_slots[slot].saved = true;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief *RCL - Recall an oscilloscope setup saved with *SAV
+ *
+ * Syntax: *RCL <slot>
+ *
+ * All saved settings take effect with a single reconfiguration of the DSO.
+ * Fails with an execution error if the slot is empty, or while an
+ * acquisition or stream is running.
+ */
+scpi_result_t scpi_cmd_recall_setup(scpi_t *context)
+{
+    uint32_t slot = 0;
+
+    if (!parse_setup_slot(context, &slot)) {
+        return SCPI_RES_ERR;
+    }
+    if (!g_setup_slots[slot].saved) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    return apply_setup(context, &g_setup_slots[slot].setup);
+}
+
+/**
+ * @brief OSCilloscope:CONFigure:ACQuire:TYPE - Set the acquisition type
+ *
+ * Syntax: OSCilloscope:CONFigure:ACQuire:TYPE {NORMal|PEAK|AVERage|FILTer}
+ *
+ * NORMal (the default) stores every ADC sample. PEAK and AVERage sample at
+ * the highest whole multiple of the sample rate the ADC supports (up to
+ * 256x) and reduce each group on the device: PEAK stores alternating
+ * minimum and maximum samples so that short glitches stay visible, AVERage
+ * stores box-car averages. FILTer samples at the highest even multiple up
+ * to 64x and stores the output of an anti-aliasing CIC and FIR low-pass,
+ * flat to 0.4 times the sample rate and 78 dB down from 0.6 times it; it
+ * needs at least 8x. The fetched record keeps its size and sample rate.
+ * Decimation does not apply to streaming and cannot be combined with a
+ * trigger.
+ */
+scpi_result_t scpi_cmd_configure_oscilloscope_acquire_type(scpi_t *context)
+{
+    scpi_choice_def_t const type_choices[] = {
+        { "NORMal", DSO_DECIMATION_NONE },
+        { "PEAK", DSO_DECIMATION_PEAK },
+        { "AVERage", DSO_DECIMATION_AVERAGE },
+        { "FILTer", DSO_DECIMATION_FILTER },
+        SCPI_CHOICE_LIST_END
+    };
+
+    int32_t type_choice = -1;
+
+    if (!SCPI_ParamChoice(context, type_choices, &type_choice, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    CaptureSettings settings = g_dso_state.capture;
+    settings.decimation = (DSO_Decimation)type_choice;
+    return set_capture(context, &settings);
+}
+
+/**
+ * @brief OSCilloscope:CONFigure:ACQuire:TYPE? - Query the acquisition type
+ *
+ * Returns NORM, PEAK, AVER or FILT.
+ */
+scpi_result_t scpi_cmd_configure_oscilloscope_acquire_type_q(scpi_t *context)
+{
+    switch (g_dso_state.capture.decimation) {
+    case DSO_DECIMATION_PEAK:
+        SCPI_ResultMnemonic(context, "PEAK");
+        break;
+    case DSO_DECIMATION_AVERAGE:
+        SCPI_ResultMnemonic(context, "AVER");
+        break;
+    case DSO_DECIMATION_FILTER:
+        SCPI_ResultMnemonic(context, "FILT");
+        break;
+    case DSO_DECIMATION_NONE:
+    default:
+        SCPI_ResultMnemonic(context, "NORM");
+        break;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:CONFigure:ACQuire:DECimation? - Query the oversampling
+ *
+ * Returns the number of ADC samples reduced to each stored sample, or 1 if
+ * every sample is stored.
+ */
+scpi_result_t scpi_cmd_configure_oscilloscope_acquire_decimation_q(
+    scpi_t *context
+)
+{
+    uint32_t factor = 1;
+
+    if (g_dso_state.dso_handle) {
+        DSO_Config const config = DSO_get_config(g_dso_state.dso_handle);
+        if (config.decimation != DSO_DECIMATION_NONE) {
+            factor = config.decimation_factor;
+        }
+    }
+
+    SCPI_ResultUInt32(context, factor);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Sample bits for a DSO resolution
+ */
+static uint32_t resolution_bits(DSO_Resolution resolution)
+{
+    switch (resolution) {
+    case DSO_RESOLUTION_10BIT:
+        return 10;
+    case DSO_RESOLUTION_8BIT:
+        return 8;
+    case DSO_RESOLUTION_HIGH:
+        return 15;
+    case DSO_RESOLUTION_12BIT:
+    default:
+        return 12;
+    }
+}
+
+/**
+ * @brief Sample value of a full-scale input at the configured resolution
+ */
+static uint16_t sample_max(void)
+{
+    DSO_Resolution const resolution = g_dso_state.capture.resolution;
+
+    if (resolution == DSO_RESOLUTION_HIGH) {
+        return DSO_SAMPLE_MAX_HIGH;
+    }
+    return DSO_SAMPLE_MAX >> (12 - resolution_bits(resolution));
+}
+
+/**
+ * @brief OSCilloscope:CONFigure:ACQuire:RESolution - Set the ADC resolution
+ *
+ * Syntax: OSCilloscope:CONFigure:ACQuire:RESolution {15|12|10|8}
+ *
+ * Lower resolutions convert faster, raising the maximum sample rate used
+ * for timebase checks and decimation. Samples keep their raw scale (0 to
+ * 255 at 8 bits) in FETCh and stream data; the trigger level stays on the
+ * 12-bit scale. 15 bits oversample 12-bit conversions in the ADC (see
+ * DSO_RESOLUTION_HIGH). Applies to single shots and streams.
+ */
+scpi_result_t scpi_cmd_configure_oscilloscope_acquire_resolution(
+    scpi_t *context
+)
+{
+    uint32_t bits = 0;
+
+    if (!SCPI_ParamUInt32(context, &bits, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    CaptureSettings settings = g_dso_state.capture;
+    switch (bits) {
+    case 15:
+        settings.resolution = DSO_RESOLUTION_HIGH;
+        break;
+    case 12:
+        settings.resolution = DSO_RESOLUTION_12BIT;
+        break;
+    case 10:
+        settings.resolution = DSO_RESOLUTION_10BIT;
+        break;
+    case 8:
+        settings.resolution = DSO_RESOLUTION_8BIT;
+        break;
+    default:
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    return set_capture(context, &settings);
+}
+
+/**
+ * @brief OSCilloscope:CONFigure:ACQuire:RESolution? - Query the resolution
+ *
+ * Returns the number of bits per sample.
+ */
+scpi_result_t scpi_cmd_configure_oscilloscope_acquire_resolution_q(
+    scpi_t *context
+)
+{
+    SCPI_ResultUInt32(context, resolution_bits(g_dso_state.capture.resolution));
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:CONFigure:ACQuire:RECords - Set the capture records
+ *
+ * Syntax: OSCilloscope:CONFigure:ACQuire:RECords {1|2}
+ *
+ * With two records, a second acquisition buffer follows the first, and
+ * FETCh:DATa? starts the next capture into the other record before sending
+ * the completed one, so that capture and transfer overlap. Each FETCh:DATa?
+ * then sends the capture started by the one before it, and other fetch
+ * queries wait for that capture too. Two records halve the largest number
+ * of points.
+ */
+scpi_result_t scpi_cmd_configure_oscilloscope_acquire_records(
+    scpi_t *context
+)
+{
+    uint32_t records = 0;
+
+    if (!SCPI_ParamUInt32(context, &records, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    if (records == 0 || records > RECORDS_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    CaptureSettings settings = g_dso_state.capture;
+    settings.records = records;
+    return set_capture(context, &settings);
+}
+
+/**
+ * @brief OSCilloscope:CONFigure:ACQuire:RECords? - Query the capture records
+ */
+scpi_result_t scpi_cmd_configure_oscilloscope_acquire_records_q(
+    scpi_t *context
+)
+{
+    SCPI_ResultUInt32(context, g_dso_state.capture.records);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:TRIGger[:MODE] - Set the capture trigger condition
+ *
+ * Syntax: OSCilloscope:TRIGger[:MODE] {NONE|RISing|FALLing|ABOVe|BELow}
+ *
+ * NONE (the default) captures immediately. RISing and FALLing wait for the
+ * signal to cross the trigger level; ABOVe and BELow wait for it to be on
+ * that side of the level. Triggering uses the ADC analog watchdog on CH1
+ * (CH2 in single-channel CH2 mode) and does not apply to streaming.
+ */
+scpi_result_t scpi_cmd_trigger_oscilloscope_mode(scpi_t *context)
+{
+    scpi_choice_def_t const mode_choices[] = {
+        { "NONE", DSO_TRIGGER_NONE },
+        { "RISing", DSO_TRIGGER_RISING },
+        { "FALLing", DSO_TRIGGER_FALLING },
+        { "ABOVe", DSO_TRIGGER_ABOVE },
+        { "BELow", DSO_TRIGGER_BELOW },
+        SCPI_CHOICE_LIST_END
+    };
+
+    int32_t mode_choice = -1;
+
+    if (!SCPI_ParamChoice(context, mode_choices, &mode_choice, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    CaptureSettings settings = g_dso_state.capture;
+    settings.trigger_mode = (DSO_TriggerMode)mode_choice;
+    return set_capture(context, &settings);
+}
+
+/**
+ * @brief OSCilloscope:TRIGger[:MODE]? - Query the capture trigger condition
+ *
+ * Returns NONE, RIS, FALL, ABOV or BEL.
+ */
+scpi_result_t scpi_cmd_trigger_oscilloscope_mode_q(scpi_t *context)
+{
+    switch (g_dso_state.capture.trigger_mode) {
+    case DSO_TRIGGER_RISING:
+        SCPI_ResultMnemonic(context, "RIS");
+        break;
+    case DSO_TRIGGER_FALLING:
+        SCPI_ResultMnemonic(context, "FALL");
+        break;
+    case DSO_TRIGGER_ABOVE:
+        SCPI_ResultMnemonic(context, "ABOV");
+        break;
+    case DSO_TRIGGER_BELOW:
+        SCPI_ResultMnemonic(context, "BEL");
+        break;
+    case DSO_TRIGGER_NONE:
+    default:
+        SCPI_ResultMnemonic(context, "NONE");
+        break;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:TRIGger:LEVel - Set the trigger level
+ *
+ * Syntax: OSCilloscope:TRIGger:LEVel <counts>
+ *
+ * The level is given in raw ADC counts (0 to 4095).
+ */
+scpi_result_t scpi_cmd_trigger_oscilloscope_level(scpi_t *context)
+{
+    uint32_t level = 0;
+
+    if (!SCPI_ParamUInt32(context, &level, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    if (level > DSO_TRIGGER_LEVEL_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    CaptureSettings settings = g_dso_state.capture;
+    settings.trigger_level = (uint16_t)level;
+    return set_capture(context, &settings);
+}
+
+/**
+ * @brief OSCilloscope:TRIGger:LEVel? - Query the trigger level
+ */
+scpi_result_t scpi_cmd_trigger_oscilloscope_level_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_dso_state.capture.trigger_level);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:TRIGger:PRETrigger - Set the pretrigger sample count
+ *
+ * Syntax: OSCilloscope:TRIGger:PRETrigger <samples>
+ *
+ * Number of samples recorded before the trigger, which must be less than
+ * the acquisition buffer size (the segment size for segmented captures).
+ */
+scpi_result_t scpi_cmd_trigger_oscilloscope_pretrigger(scpi_t *context)
+{
+    uint32_t pretrigger = 0;
+
+    if (!SCPI_ParamUInt32(context, &pretrigger, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    CaptureSettings settings = g_dso_state.capture;
+    settings.pretrigger = pretrigger;
+    return set_capture(context, &settings);
+}
+
+/**
+ * @brief OSCilloscope:TRIGger:PRETrigger? - Query the pretrigger sample count
+ */
+scpi_result_t scpi_cmd_trigger_oscilloscope_pretrigger_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_dso_state.capture.pretrigger);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:TRIGger:POSition? - Query the trigger position
+ *
+ * Returns the index in the fetched data of the first sample after the
+ * trigger fired, or 0 for untriggered or incomplete captures.
+ */
+scpi_result_t scpi_cmd_trigger_oscilloscope_position_q(scpi_t *context)
+{
+    uint32_t position = 0;
+
+    if (g_dso_state.dso_handle) {
+        position = DSO_get_trigger_index(g_dso_state.dso_handle);
+    }
+
+    SCPI_ResultUInt32(context, position);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:SEGMent[:COUNt] - Set the number of capture segments
+ *
+ * Syntax: OSCilloscope:SEGMent[:COUNt] <segments>
+ *
+ * Splits the acquisition buffer into equal segments (1 to 64) that are
+ * filled by consecutive triggers without host involvement. The buffer size
+ * must be a multiple of 4 * segments and a trigger must be set when more
+ * than one segment is used. FETCh returns all segments back to back.
+ */
+scpi_result_t scpi_cmd_segment_oscilloscope_count(scpi_t *context)
+{
+    uint32_t segments = 0;
+
+    if (!SCPI_ParamUInt32(context, &segments, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    if (segments == 0 || segments > DSO_SEGMENTS_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    CaptureSettings settings = g_dso_state.capture;
+    settings.segments = segments;
+    return set_capture(context, &settings);
+}
+
+/**
+ * @brief OSCilloscope:SEGMent[:COUNt]? - Query the number of segments
+ */
+scpi_result_t scpi_cmd_segment_oscilloscope_count_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_dso_state.capture.segments);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:SEGMent:ACQuired? - Query completed segments
+ *
+ * Returns the number of segments captured since the last INITiate. May be
+ * polled during acquisition to track progress.
+ */
+scpi_result_t scpi_cmd_segment_oscilloscope_acquired_q(scpi_t *context)
+{
+    uint32_t acquired = 0;
+
+    if (g_dso_state.dso_handle) {
+        acquired = DSO_get_segments_acquired(g_dso_state.dso_handle);
+    }
+
+    SCPI_ResultUInt32(context, acquired);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Helper function to return one field of every acquired segment
+ *
+ * @param context SCPI context for results
+ * @param timestamps Return timestamps instead of trigger positions
+ * @return SCPI_RES_OK
+ */
+static scpi_result_t result_segments(scpi_t *context, bool timestamps)
+{
+    uint32_t values[DSO_SEGMENTS_MAX];
+    uint32_t count = 0;
+
+    if (g_dso_state.dso_handle) {
+        count = DSO_get_segments_acquired(g_dso_state.dso_handle);
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        DSO_Segment const segment = DSO_get_segment(g_dso_state.dso_handle, i);
+        values[i] = timestamps ? segment.timestamp_us : segment.trigger_index;
+    }
+
+    protocol_result_uint32_ascii(context, values, count);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:SEGMent:TIMEstamps? - Query segment trigger times
+ *
+ * Returns one value per acquired segment: the time in microseconds from
+ * INITiate to the trigger of that segment.
+ */
+scpi_result_t scpi_cmd_segment_oscilloscope_timestamps_q(scpi_t *context)
+{
+    return result_segments(context, true);
+}
+
+/**
+ * @brief OSCilloscope:SEGMent:POSitions? - Query segment trigger positions
+ *
+ * Returns one value per acquired segment: the index within that segment of
+ * the first sample after its trigger fired.
+ */
+scpi_result_t scpi_cmd_segment_oscilloscope_positions_q(scpi_t *context)
+{
+    return result_segments(context, false);
+}
+
+/**
+ * @brief OSCilloscope:AVERage[:COUNt] - Set the number of averaged captures
+ *
+ * Syntax: OSCilloscope:AVERage[:COUNt] <captures>
+ *
+ * With more than one capture (up to 256), INITiate acquires that many
+ * triggered captures in a row and FETCh returns their mean, aligned on the
+ * trigger. Averaging needs a trigger and a single segment, and a second
+ * buffer of 32-bit sums behind the acquisition buffer.
+ */
+scpi_result_t scpi_cmd_average_oscilloscope_count(scpi_t *context)
+{
+    uint32_t averages = 0;
+
+    if (!SCPI_ParamUInt32(context, &averages, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    if (averages == 0 || averages > DSO_AVERAGES_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    CaptureSettings settings = g_dso_state.capture;
+    settings.averages = averages;
+    return set_capture(context, &settings);
+}
+
+/**
+ * @brief OSCilloscope:AVERage[:COUNt]? - Query the number of averages
+ */
+scpi_result_t scpi_cmd_average_oscilloscope_count_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_dso_state.capture.averages);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:AVERage:ACQuired? - Query completed captures
+ *
+ * Returns the number of captures summed since the last INITiate. May be
+ * polled during acquisition to track progress.
+ */
+scpi_result_t scpi_cmd_average_oscilloscope_acquired_q(scpi_t *context)
+{
+    uint32_t acquired = 0;
+
+    if (g_dso_state.dso_handle) {
+        acquired = DSO_get_averages_acquired(g_dso_state.dso_handle);
+    }
+
+    SCPI_ResultUInt32(context, acquired);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Whether the acquisition of OSCilloscope:INITiate is over
+ */
+static bool acquisition_done(void)
+{
+    return !g_dso_state.dso_handle ||
+           !DSO_is_acquisition_in_progress(g_dso_state.dso_handle);
+}
+
+/**
+ * @brief OSCilloscope:INITiate - Start DSO data acquisition
+ *
+ * Overlapped: *OPC, *OPC? and *WAI wait for the acquisition, for as long
+ * as FETCh would.
+ */
+scpi_result_t scpi_cmd_initiate_oscilloscope(scpi_t *context)
+{
+    if (g_dso_state.streaming || g_dso_state.rolling ||
+        g_dso_state.histogram_active || g_dso_state.autoset_active) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    // If DSO is not configured, initialize with default configuration
+    if (!g_dso_state.dso_handle) {
+        DSO_Config config = (DSO_Config)DSO_CONFIG_DEFAULT;
+
+        // Use current buffer size, or default if not set
+        uint32_t buffer_size = g_dso_state.acquisition_buffer_size > 0
+                                   ? g_dso_state.acquisition_buffer_size
+                                   : BUFFER_SIZE_DEFAULT;
+
+        // Configure sample rate and buffer using helper function
+        scpi_result_t result = configure_sample_rate_and_buffer(
+            context, buffer_size, config.mode, &config
+        );
+        if (result != SCPI_RES_OK) {
+            return result;
+        }
+
+        // Apply default configuration
+        result = apply_dso_config(context, &config);
+        if (result != SCPI_RES_OK) {
+            return result;
+        }
+    }
+
+    // Clear acquisition flags
+    g_dso_state.acquisition_complete = false;
+    fetch_cache_drop();
+
+    // Start acquisition
+    Error const err = DSO_try_start(g_dso_state.dso_handle);
+    if (err != ERROR_NONE) {
+        LOG_ERROR("DSO start error: 0x%08X", err);
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    protocol_operation_pending(acquisition_done, SI_MILLI_DIV);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:ABORt - Abort ongoing oscilloscope acquisition
+ */
+scpi_result_t scpi_cmd_abort_oscilloscope(scpi_t *context)
+{
+    (void)context;
+
+    if (g_dso_state.dso_handle) {
+        DSO_stop(g_dso_state.dso_handle);
+        DSO_deinit(g_dso_state.dso_handle);
+        g_dso_state.dso_handle = nullptr;
+    }
+
+    g_dso_state.acquisition_complete = false;
+    g_dso_state.autoset_active = false;
+    stream_reset();
+
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Number of bytes needed for a number of samples in a data format
+ */
+static uint32_t format_size(DataFormat format, uint32_t samples)
+{
+    switch (format) {
+    case DATA_FORMAT_PACKED:
+        return ((samples * 3) + 1) / 2;
+    case DATA_FORMAT_INT8:
+        return samples;
+    case DATA_FORMAT_INT16:
+    case DATA_FORMAT_MVOLT:
+    default:
+        return samples * sizeof(uint16_t);
+    }
+}
+
+/**
+ * @brief Convert samples to millivolts, chunk by chunk
+ *
+ * Samples are scaled for the configured resolution.
+ *
+ * @param out Output buffer, at least format_size(DATA_FORMAT_MVOLT, count)
+ *            bytes; need not be aligned
+ * @return Number of bytes written
+ */
+static uint32_t convert_millivolts(
+    uint16_t const *samples,
+    uint32_t count,
+    uint8_t *out
+)
+{
+    int16_t millivolts[PACK_CHUNK_SAMPLES];
+    int32_t const full_scale = (int32_t)DSO_get_reference_voltage();
+    int32_t const scale = FIXED_code_scale(full_scale, sample_max());
+    uint32_t len = 0;
+
+    for (uint32_t i = 0; i < count; i += PACK_CHUNK_SAMPLES) {
+        uint32_t const remaining = count - i;
+        uint32_t const n =
+            remaining < PACK_CHUNK_SAMPLES ? remaining : PACK_CHUNK_SAMPLES;
+        FIXED_scale_u16_array_to_i16(&samples[i], n, scale, millivolts);
+        memcpy(&out[len], millivolts, n * sizeof(int16_t));
+        len += n * sizeof(int16_t);
+    }
+
+    return len;
+}
+
+/**
+ * @brief Convert samples to a compact data format
+ *
+ * INT8 keeps the upper 8 bits of the configured resolution, so it is
+ * lossless at 8 bits, and PACKED keeps the upper 12 bits.
+ *
+ * In packed format, each pair of samples is stored in three bytes: the low
+ * byte of the first sample, then the high nibble of the first sample with
+ * the low nibble of the second sample above it, then the high byte of the
+ * second sample. An odd trailing sample takes two bytes.
+ *
+ * @param format DATA_FORMAT_PACKED, DATA_FORMAT_INT8, DATA_FORMAT_MVOLT or
+ *               DATA_FORMAT_INT16, which is copied as is
+ * @param samples Samples to convert
+ * @param count Number of samples
+ * @param out Output buffer, at least format_size(format, count) bytes
+ * @return Number of bytes written
+ */
+static uint32_t pack_samples(
+    DataFormat format,
+    uint16_t const *samples,
+    uint32_t count,
+    uint8_t *out
+)
+{
+    uint32_t len = 0;
+
+    if (format == DATA_FORMAT_INT16) {
+        memcpy(out, samples, count * sizeof(uint16_t));
+        return count * sizeof(uint16_t);
+    }
+
+    if (format == DATA_FORMAT_MVOLT) {
+        return convert_millivolts(samples, count, out);
+    }
+
+    if (format == DATA_FORMAT_INT8) {
+        uint32_t const shift =
+            resolution_bits(g_dso_state.capture.resolution) - 8;
+        for (uint32_t i = 0; i < count; ++i) {
+            out[len++] = (uint8_t)(samples[i] >> shift);
+        }
+        return len;
+    }
+
+    uint32_t const bits = resolution_bits(g_dso_state.capture.resolution);
+    uint32_t const shift = bits > 12 ? bits - 12 : 0;
+    uint32_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        uint16_t const first = samples[i] >> shift;
+        uint16_t const second = samples[i + 1] >> shift;
+        out[len++] = (uint8_t)first;
+        out[len++] = (uint8_t)(((first >> 8) & 0x0F) | ((second & 0x0F) << 4));
+        out[len++] = (uint8_t)(second >> 4);
+    }
+    if (i < count) {
+        uint16_t const last = samples[i] >> shift;
+        out[len++] = (uint8_t)last;
+        out[len++] = (uint8_t)((last >> 8) & 0x0F);
+    }
+
+    return len;
+}
+
+/**
+ * @brief Upper bound on converted size of a number of samples
+ */
+static uint32_t format_bound(DataFormat format, uint32_t samples)
+{
+    if (format == DATA_FORMAT_DELTA) {
+        return DELTA_ENCODE_BOUND(samples);
+    }
+    return format_size(format, samples);
+}
+
+/**
+ * @brief Convert a complete block of samples to a non-INT16 data format
+ *
+ * @param out Output buffer, at least format_bound(format, count) bytes
+ * @return Number of bytes written
+ */
+static uint32_t encode_samples(
+    DataFormat format,
+    uint16_t const *samples,
+    uint32_t count,
+    uint8_t *out
+)
+{
+    if (format != DATA_FORMAT_DELTA) {
+        return pack_samples(format, samples, count, out);
+    }
+
+    DELTA_Encoder encoder;
+    DELTA_encoder_init(&encoder);
+    uint32_t const len = DELTA_encode(&encoder, samples, count, out);
+    return len + DELTA_encode_finish(&encoder, out + len);
+}
+
+// Every sample, in order
+static SampleLayout const g_CONTIGUOUS = { .width = 1, .stride = 1 };
+
+/**
+ * @brief Get samples i to i + n of a laid out sequence as a contiguous
+ * array
+ *
+ * @param scratch Room for n samples, used unless the layout is contiguous
+ * @return Pointer to the n samples
+ */
+static uint16_t const *gather_samples(
+    uint16_t const *samples,
+    SampleLayout layout,
+    uint32_t i,
+    uint32_t n,
+    uint16_t *scratch
+)
+{
+    if (layout.width == layout.stride) {
+        return &samples[i];
+    }
+
+    for (uint32_t j = 0; j < n; ++j) {
+        uint32_t const k = i + j;
+        scratch[j] =
+            samples[((k / layout.width) * layout.stride) + (k % layout.width)];
+    }
+    return scratch;
+}
+
+/**
+ * @brief Size of a laid out sequence of samples in the delta format
+ */
+static uint32_t
+delta_size(uint16_t const *samples, uint32_t count, SampleLayout layout)
+{
+    if (layout.width == layout.stride) {
+        return DELTA_encoded_size(samples, count);
+    }
+
+    uint16_t gathered[PACK_CHUNK_SAMPLES];
+    DELTA_Encoder encoder;
+    DELTA_encoder_init(&encoder);
+    uint32_t len = 0;
+
+    for (uint32_t i = 0; i < count; i += PACK_CHUNK_SAMPLES) {
+        uint32_t const remaining = count - i;
+        uint32_t const n =
+            remaining < PACK_CHUNK_SAMPLES ? remaining : PACK_CHUNK_SAMPLES;
+        len += DELTA_encode(
+            &encoder,
+            gather_samples(samples, layout, i, n, gathered),
+            n,
+            nullptr
+        );
+    }
+    return len + DELTA_encode_finish(&encoder, nullptr);
+}
+
+/**
+ * @brief Convert samples and send them as part of an arbitrary block
+ *
+ * Samples are converted in small chunks on the way out, so no second copy
+ * of the acquisition buffer is needed. A layout that is not contiguous
+ * picks samples out, such as one channel of interleaved frames or every
+ * tenth frame.
+ *
+ * @param encoder Delta encoder carried across the parts of a block
+ * @param samples First sample to send
+ * @param count Number of samples to send; even unless last, for PACKed
+ * @param layout Samples sent out of those from samples on
+ * @param last Whether this is the last part, which finishes the encoder
+ */
+static void result_packed_data(
+    scpi_t *context,
+    DataFormat format,
+    DELTA_Encoder *encoder,
+    uint16_t const *samples,
+    uint32_t count,
+    SampleLayout layout,
+    bool last
+)
+{
+    uint8_t chunk[DELTA_ENCODE_BOUND(PACK_CHUNK_SAMPLES)];
+    uint16_t gathered[PACK_CHUNK_SAMPLES];
+
+    for (uint32_t i = 0; i < count; i += PACK_CHUNK_SAMPLES) {
+        uint32_t const remaining = count - i;
+        uint32_t const n =
+            remaining < PACK_CHUNK_SAMPLES ? remaining : PACK_CHUNK_SAMPLES;
+        uint16_t const *const block =
+            gather_samples(samples, layout, i, n, gathered);
+        uint32_t len = 0;
+        if (format == DATA_FORMAT_DELTA) {
+            len = DELTA_encode(encoder, block, n, chunk);
+            if (last && n == remaining) {
+                len += DELTA_encode_finish(encoder, chunk + len);
+            }
+        } else {
+            len = pack_samples(format, block, n, chunk);
+        }
+        // A zero-length write would count the block as complete twice
+        if (len > 0) {
+            SCPI_ResultArbitraryBlockData(context, chunk, len);
+        }
+    }
+}
+
+/**
+ * @brief Output samples as an arbitrary block in a converted data format
+ *
+ * The delta format needs a sizing pass over the samples first, since the
+ * block header carries the length. With a layout that is not contiguous,
+ * INT16 samples are copied too.
+ *
+ * @param prefix Bytes sent ahead of the samples, may be nullptr if
+ *               prefix_len is 0
+ * @param samples First sample to send
+ * @param count Number of samples to send
+ * @param layout Samples sent out of those from samples on
+ */
+static void result_packed_block(
+    scpi_t *context,
+    uint8_t const *prefix,
+    uint32_t prefix_len,
+    DataFormat format,
+    uint16_t const *samples,
+    uint32_t count,
+    SampleLayout layout
+)
+{
+    DELTA_Encoder encoder;
+    DELTA_encoder_init(&encoder);
+
+    SCPI_ResultArbitraryBlockHeader(
+        context,
+        prefix_len + (format == DATA_FORMAT_DELTA
+                          ? delta_size(samples, count, layout)
+                          : format_size(format, count))
+    );
+    if (prefix_len > 0) {
+        SCPI_ResultArbitraryBlockData(context, prefix, prefix_len);
+    }
+
+    result_packed_data(context, format, &encoder, samples, count, layout, true);
+}
+
+/**
+ * @brief Convert laid out samples into a buffer
+ *
+ * @param samples First sample to convert
+ * @param count Number of samples to convert
+ * @param layout Samples converted out of those from samples on
+ * @param out Output buffer, at least format_bound(format, count) bytes
+ * @return Number of bytes written
+ */
+static uint32_t encode_layout(
+    DataFormat format,
+    uint16_t const *samples,
+    uint32_t count,
+    SampleLayout layout,
+    uint8_t *out
+)
+{
+    if (layout.width == layout.stride) {
+        return encode_samples(format, samples, count, out);
+    }
+
+    uint16_t gathered[PACK_CHUNK_SAMPLES];
+    DELTA_Encoder encoder;
+    DELTA_encoder_init(&encoder);
+    uint32_t len = 0;
+
+    for (uint32_t i = 0; i < count; i += PACK_CHUNK_SAMPLES) {
+        uint32_t const remaining = count - i;
+        uint32_t const n =
+            remaining < PACK_CHUNK_SAMPLES ? remaining : PACK_CHUNK_SAMPLES;
+        uint16_t const *const block =
+            gather_samples(samples, layout, i, n, gathered);
+        len += format == DATA_FORMAT_DELTA
+                   ? DELTA_encode(&encoder, block, n, &out[len])
+                   : pack_samples(format, block, n, &out[len]);
+    }
+    if (format == DATA_FORMAT_DELTA) {
+        len += DELTA_encode_finish(&encoder, &out[len]);
+    }
+    return len;
+}
+
+/**
+ * @brief Get converted samples of the completed capture from the fetch
+ * cache
+ *
+ * If the cache holds other samples, another format or an earlier capture,
+ * the samples are converted into it instead, as long as sample memory has
+ * room for them.
+ *
+ * @param samples First sample to send
+ * @param count Number of samples to send
+ * @param layout Samples sent out of those from samples on
+ * @return Cache holding the samples, or nullptr if they do not fit
+ */
+static FetchCache const *fetch_cache_get(
+    DataFormat format,
+    uint16_t const *samples,
+    uint32_t count,
+    SampleLayout layout
+)
+{
+    FetchCache *const cache = &g_dso_state.fetch_cache;
+
+    if (cache->data && cache->sequence == g_dso_state.capture_sequence &&
+        cache->format == format && cache->samples == samples &&
+        cache->count == count && cache->layout.width == layout.width &&
+        cache->layout.stride == layout.stride) {
+        return cache;
+    }
+
+    fetch_cache_drop();
+    uint8_t *const data =
+        ARENA_alloc(&g_sample_arena, format_bound(format, count));
+    if (!data) {
+        return nullptr;
+    }
+    uint32_t const len = encode_layout(format, samples, count, layout, data);
+    // Give back the rest of the bound; allocated again at once, the block
+    // keeps its address and contents
+    ARENA_release(&g_sample_arena, data);
+    *cache = (FetchCache){
+        .data = ARENA_alloc(&g_sample_arena, len),
+        .len = len,
+        .sequence = g_dso_state.capture_sequence,
+        .format = format,
+        .samples = samples,
+        .count = count,
+        .layout = layout,
+    };
+    return cache;
+}
+
+/**
+ * @brief Output a run of samples from a ring buffer as an arbitrary block
+ *
+ * The run is sent in the given data format, INT16 included, copied chunk
+ * by chunk so that it can wrap around the end of the ring.
+ *
+ * @param ring First sample of the ring
+ * @param size Number of samples in the ring, even
+ * @param start Index of the first sample to send, even
+ * @param count Number of samples to send, even and at most size
+ */
+static void result_ring_block(
+    scpi_t *context,
+    DataFormat format,
+    uint16_t const *ring,
+    uint32_t size,
+    uint32_t start,
+    uint32_t count
+)
+{
+    uint32_t const first = count < size - start ? count : size - start;
+    uint32_t const second = count - first;
+    uint32_t len = format_size(format, count);
+
+    if (format == DATA_FORMAT_DELTA) {
+        DELTA_Encoder sizing;
+        DELTA_encoder_init(&sizing);
+        len = DELTA_encode(&sizing, &ring[start], first, nullptr);
+        len += DELTA_encode(&sizing, ring, second, nullptr);
+        len += DELTA_encode_finish(&sizing, nullptr);
+    }
+
+    DELTA_Encoder encoder;
+    DELTA_encoder_init(&encoder);
+    SCPI_ResultArbitraryBlockHeader(context, len);
+    result_packed_data(
+        context,
+        format,
+        &encoder,
+        &ring[start],
+        first,
+        g_CONTIGUOUS,
+        second == 0
+    );
+    result_packed_data(
+        context, format, &encoder, ring, second, g_CONTIGUOUS, true
+    );
+}
+
+/**
+ * @brief OSCilloscope:FORMat[:DATa] - Select the sample data format
+ *
+ * Syntax: OSCilloscope:FORMat[:DATa] {INT16|PACKed|INT8|DELTa|MVOLts}
+ *
+ * INT16 (the default) sends each sample as a little-endian 16-bit word.
+ * PACKed sends two 12-bit samples in three bytes; INT8 sends the upper 8 bits
+ * of each sample at the configured resolution. DELTa sends a lossless
+ * delta/run-length code. MVOLts sends each sample as little-endian 16-bit
+ * millivolts, calibrated against the measured ADC reference. Applies to
+ * FETCh and to stream blocks; cannot be changed while streaming.
+ */
+scpi_result_t scpi_cmd_format_oscilloscope_data(scpi_t *context)
+{
+    scpi_choice_def_t const format_choices[] = {
+        { "INT16", DATA_FORMAT_INT16 },
+        { "PACKed", DATA_FORMAT_PACKED },
+        { "INT8", DATA_FORMAT_INT8 },
+        { "DELTa", DATA_FORMAT_DELTA },
+        { "MVOLts", DATA_FORMAT_MVOLT },
+        SCPI_CHOICE_LIST_END
+    };
+
+    int32_t format_choice = -1;
+
+    if (!SCPI_ParamChoice(context, format_choices, &format_choice, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    if (g_dso_state.streaming) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.data_format = (DataFormat)format_choice;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:FORMat[:DATa]? - Query the sample data format
+ *
+ * Returns INT16, PACK, INT8, DELT or MVOL.
+ */
+scpi_result_t scpi_cmd_format_oscilloscope_data_q(scpi_t *context)
+{
+    switch (g_dso_state.data_format) {
+    case DATA_FORMAT_PACKED:
+        SCPI_ResultMnemonic(context, "PACK");
+        break;
+    case DATA_FORMAT_INT8:
+        SCPI_ResultMnemonic(context, "INT8");
+        break;
+    case DATA_FORMAT_DELTA:
+        SCPI_ResultMnemonic(context, "DELT");
+        break;
+    case DATA_FORMAT_MVOLT:
+        SCPI_ResultMnemonic(context, "MVOL");
+        break;
+    case DATA_FORMAT_INT16:
+    default:
+        SCPI_ResultMnemonic(context, "INT16");
+        break;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:FORMat:HEADer - Prefix fetched records with a header
+ *
+ * Syntax: OSCilloscope:FORMat:HEADer {ON|OFF|1|0}
+ *
+ * With ON, the block from OSCilloscope:FETCh:DATa? starts with a 40-byte
+ * CaptureHeader describing the capture, so that no further queries are
+ * needed to interpret it, and each stream block with a 24-byte
+ * StreamHeader that numbers the block and marks gaps in the stream; the
+ * block then ends with the CRC-32 of the header and the data, computed by
+ * the CRC unit. OFF by default and after *RST.
+ */
+scpi_result_t scpi_cmd_format_oscilloscope_header(scpi_t *context)
+{
+    bool enable = false;
+
+    if (!SCPI_ParamBool(context, &enable, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.data_header = enable;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:FORMat:HEADer? - Query the record header setting
+ *
+ * Returns 1 if fetched records start with a header, 0 otherwise.
+ */
+scpi_result_t scpi_cmd_format_oscilloscope_header_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_dso_state.data_header);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Complete the current acquisition and stop the DSO
+ *
+ * While the acquisition is in progress, the query is deferred to resume,
+ * which is called again from the protocol task until the acquisition
+ * completes or times out. The main loop keeps running meanwhile, so USB
+ * is serviced and OSCilloscope:ABORt ends the wait.
+ *
+ * @param context SCPI context for error reporting
+ * @param resume Fetch handler to answer the query, without parameters
+ * @return SCPI_RES_OK once a capture has completed; otherwise the result
+ *         for the query handler to return
+ */
+static scpi_result_t
+finish_acquisition(scpi_t *context, scpi_command_callback_t resume)
+{
+    // Check if DSO is configured and not owned by a continuous mode
+    if (!g_dso_state.dso_handle || !g_dso_state.acquisition_buffer ||
+        g_dso_state.streaming || g_dso_state.rolling ||
+        g_dso_state.histogram_active) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    // If acquisition is still in progress, answer once it completes
+    if (DSO_is_acquisition_in_progress(g_dso_state.dso_handle)) {
+        uint32_t const timeout = SI_MILLI_DIV; // 1 second timeout
+        uint32_t const now = SYSTEM_get_tick();
+
+        if (!protocol_is_resuming()) {
+            g_dso_state.fetch_start = now;
+        } else if (now - g_dso_state.fetch_start > timeout) {
+            LOG_ERROR("DSO acquisition timeout - stopping acquisition");
+            DSO_stop(g_dso_state.dso_handle);
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+        return protocol_defer(context, resume);
+    }
+
+    // Check if acquisition completed successfully
+    if (!g_dso_state.acquisition_complete) {
+        DSO_stop(g_dso_state.dso_handle);
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    DSO_stop(g_dso_state.dso_handle);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Convert Q16.16 to an integer number of millionths, rounded
+ */
+static int32_t to_millionths(FIXED_Q1616 value)
+{
+    int64_t const scaled = (int64_t)value * (int64_t)SI_MICRO_DIV;
+    int64_t const half = FIXED_SCALE / 2;
+    return (int32_t)((scaled + (scaled >= 0 ? half : -half)) / FIXED_SCALE);
+}
+
+/**
+ * @brief OSCilloscope:CALibration:INTerleave - Estimate the ADC mismatch
+ *
+ * Estimates the offset and gain mismatch between the two ADCs interleaved
+ * in single-channel mode from the last capture, and corrects it in later
+ * single-channel captures. See DSO_calibrate_interleave.
+ */
+scpi_result_t scpi_cmd_calibration_oscilloscope_interleave(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+
+    if (!g_dso_state.dso_handle || !g_dso_state.acquisition_complete) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    TRY { DSO_calibrate_interleave(g_dso_state.dso_handle); }
+    CATCH(err)
+    {
+        SCPI_ErrorPush(
+            context,
+            err == ERROR_CALIBRATION_FAILED ? SCPI_ERROR_CALIBRATION_FAILED
+                                            : SCPI_ERROR_EXECUTION_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:CALibration:INTerleave? - Query the ADC mismatch
+ * correction
+ *
+ * Returns the gain applied to the second ADC's samples in parts per
+ * million and the offset added after it in millionths of a 12-bit code.
+ */
+scpi_result_t scpi_cmd_calibration_oscilloscope_interleave_q(scpi_t *context)
+{
+    INTERLEAVE_Correction const correction = DSO_get_interleave();
+    int32_t const results[] = {
+        to_millionths(correction.gain),
+        to_millionths(correction.offset),
+    };
+    size_t const count = sizeof(results) / sizeof(results[0]);
+
+    protocol_result_int32_ascii(context, results, count);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:CALibration:INTerleave:RESet - Drop the ADC mismatch
+ * correction
+ */
+scpi_result_t
+scpi_cmd_calibration_oscilloscope_interleave_reset(scpi_t *context)
+{
+    (void)context; // Unused parameter
+
+    DSO_reset_interleave();
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Start a capture with the configured settings
+ *
+ * For the binary protocol. Unlike OSCilloscope:INITiate, this does not set
+ * up a default configuration.
+ *
+ * @return ERROR_NONE once started, ERROR_DEVICE_NOT_READY if the DSO is not
+ *         configured or streams, or the error returned by DSO_try_start
+ */
+Error dso_capture_start(void)
+{
+    if (!g_dso_state.dso_handle || g_dso_state.streaming ||
+        g_dso_state.rolling || g_dso_state.histogram_active) {
+        return ERROR_DEVICE_NOT_READY;
+    }
+
+    g_dso_state.acquisition_complete = false;
+    fetch_cache_drop();
+
+    Error const err = DSO_try_start(g_dso_state.dso_handle);
+    if (err != ERROR_NONE) {
+        LOG_ERROR("DSO start error: 0x%08X", err);
+    }
+    return err;
+}
+
+/**
+ * @brief Get the raw samples of the completed capture
+ *
+ * For the binary protocol. Does not wait for the capture, the host polls
+ * instead.
+ *
+ * @param samples Set to the acquisition buffer, valid until the next
+ *                capture is configured or started
+ * @param count Set to the number of samples
+ * @return ERROR_NONE, ERROR_RESOURCE_BUSY while the capture is running, or
+ *         ERROR_DEVICE_NOT_READY if there is no completed capture
+ */
+Error dso_capture_data(uint16_t const **samples, uint32_t *count)
+{
+    if (!g_dso_state.dso_handle || !g_dso_state.acquisition_buffer ||
+        g_dso_state.streaming || g_dso_state.rolling ||
+        g_dso_state.histogram_active) {
+        return ERROR_DEVICE_NOT_READY;
+    }
+    if (DSO_is_acquisition_in_progress(g_dso_state.dso_handle)) {
+        return ERROR_RESOURCE_BUSY;
+    }
+
+    DSO_stop(g_dso_state.dso_handle);
+    if (!g_dso_state.acquisition_complete) {
+        return ERROR_DEVICE_NOT_READY;
+    }
+
+    *samples = g_dso_state.acquisition_buffer;
+    *count = g_dso_state.acquisition_buffer_size;
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Number of channels captured in a DSO mode
+ */
+static uint32_t mode_channels(DSO_Mode mode)
+{
+    switch (mode) {
+    case DSO_MODE_QUAD_CHANNEL:
+        return 4;
+    case DSO_MODE_DUAL_CHANNEL:
+        return 2;
+    case DSO_MODE_SINGLE_CHANNEL:
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Locate a channel in the interleaved frames of the capture
+ *
+ * @param config Configuration of the capture
+ * @param channel Channel number, 1 to 4
+ * @param offset Set to the position of the channel within a frame
+ * @param stride Set to the number of samples in a frame
+ * @return false if the channel was not captured
+ */
+static bool capture_channel(
+    DSO_Config const *config,
+    uint32_t channel,
+    uint32_t *offset,
+    uint32_t *stride
+)
+{
+    if (config->mode == DSO_MODE_SINGLE_CHANNEL) {
+        *offset = 0;
+        *stride = 1;
+        return channel == (uint32_t)config->channel + 1;
+    }
+
+    *offset = channel - 1;
+    *stride = mode_channels(config->mode);
+    return channel <= *stride;
+}
+
+/**
+ * @brief Describe the completed capture for OSCilloscope:FETCh:DATa?
+ *
+ * @param config Configuration of the capture
+ * @param channel Channel sent, or FETCH_ALL_CHANNELS
+ * @param points Samples sent, all channels
+ */
+static CaptureHeader capture_header(
+    DSO_Config const *config,
+    uint32_t channel,
+    uint32_t points
+)
+{
+    DSO_Handle *const handle = g_dso_state.dso_handle;
+    DSO_Diagnostics const diagnostics = DSO_get_diagnostics(handle);
+    uint32_t const trigger_index = DSO_get_trigger_index(handle);
+    uint32_t channels = mode_channels(config->mode);
+    uint8_t channel_map = config->mode == DSO_MODE_SINGLE_CHANNEL
+                              ? (uint8_t)(1U << config->channel)
+                              : (uint8_t)((1U << channels) - 1U);
+    uint8_t flags = 0;
+
+    if (channel != FETCH_ALL_CHANNELS) {
+        channels = 1;
+        channel_map = (uint8_t)(1U << (channel - 1));
+    }
+    if (diagnostics.capture_affected) {
+        flags |= CAPTURE_FLAG_AFFECTED;
+    }
+    if (g_dso_state.capture.trigger_mode != DSO_TRIGGER_NONE) {
+        flags |= CAPTURE_FLAG_TRIGGERED;
+    }
+
+    // A frame stamp taken now, rather than at the start, is one the host
+    // can match to its frame numbers without wrapping ambiguity
+    uint32_t sof_frame = 0;
+    uint32_t sof_time_us = 0;
+    (void)USB_get_frame_stamp(&sof_frame, &sof_time_us);
+
+    return (CaptureHeader){
+        .version = CAPTURE_HEADER_VERSION,
+        .size = sizeof(CaptureHeader),
+        .channels = (uint8_t)channels,
+        .channel_map = channel_map,
+        .format = (uint8_t)g_dso_state.data_format,
+        .resolution = (uint8_t)resolution_bits(g_dso_state.capture.resolution),
+        .flags = flags,
+        .decimation = (uint8_t)g_dso_state.capture.decimation,
+        .sample_rate = config->sample_rate,
+        .points = points,
+        .trigger_index = trigger_index,
+        .timestamp_us = DSO_get_start_time_us(handle),
+        .sequence = g_dso_state.capture_sequence,
+        .segments = g_dso_state.capture.segments,
+        .sof_frame = sof_frame,
+        .sof_time_us = sof_time_us,
+    };
+}
+
+/**
+ * @brief Start capturing into the other record
+ *
+ * With two records, called once a completed record is about to be sent, so
+ * that the next capture runs during the transfer. The DSO is retargeted to
+ * the record not being sent, which keeps the ADC as initialized. Failures
+ * are logged, and leave the DSO stopped as after a single record.
+ */
+static void start_next_record(void)
+{
+    DSO_Handle *const handle = g_dso_state.dso_handle;
+    uint16_t *const next = g_dso_state.acquisition_buffer ==
+                                   g_dso_state.records[0]
+                               ? g_dso_state.records[1]
+                               : g_dso_state.records[0];
+    Error err = ERROR_NONE;
+
+    if (next == nullptr) {
+        return;
+    }
+
+    DSO_Config config = DSO_get_config(handle);
+    config.buffer = next;
+    TRY { DSO_set_config(handle, &config); }
+    CATCH(err)
+    {
+        LOG_ERROR("DSO record switch error: 0x%08X", err);
+        return;
+    }
+    g_dso_state.acquisition_buffer = next;
+
+    if (dso_capture_start() == ERROR_NONE) {
+        protocol_operation_pending(acquisition_done, SI_MILLI_DIV);
+    }
+}
+
+/**
+ * @brief Send the data of OSCilloscope:FETCh:DATa?
+ *
+ * Resumable; the channel is in g_dso_state.fetch_argument.
+ */
+static scpi_result_t fetch_data(scpi_t *context)
+{
+    scpi_result_t const result = finish_acquisition(context, fetch_data);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    uint32_t const channel = g_dso_state.fetch_argument;
+    FetchWindow const window = g_dso_state.fetch_window;
+    bool const windowed =
+        window.start != 0 || window.count != 0 || window.stride != 1;
+    uint16_t const *samples = g_dso_state.acquisition_buffer;
+    uint32_t frames = g_dso_state.acquisition_buffer_size;
+    SampleLayout layout = g_CONTIGUOUS;
+    DSO_Config config = { 0 };
+
+    if (g_dso_state.data_header || channel != FETCH_ALL_CHANNELS || windowed) {
+        config = DSO_get_config(g_dso_state.dso_handle);
+    }
+    if (channel != FETCH_ALL_CHANNELS) {
+        uint32_t offset = 0;
+        if (!capture_channel(&config, channel, &offset, &layout.stride)) {
+            SCPI_ErrorPush(context, SCPI_ERROR_SETTINGS_CONFLICT);
+            return SCPI_RES_ERR;
+        }
+        samples += offset;
+        frames /= layout.stride;
+    } else if (windowed) {
+        // Whole frames of all channels
+        layout.width = mode_channels(config.mode);
+        layout.stride = layout.width;
+        frames /= layout.width;
+    }
+
+    if (window.start >= frames) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    // The window is cut at the end of the record
+    uint32_t const available =
+        ((frames - window.start - 1) / window.stride) + 1;
+    uint32_t const count = window.count != 0 && window.count < available
+                               ? window.count
+                               : available;
+    samples += window.start * layout.stride;
+    layout.stride *= window.stride;
+
+    CaptureHeader header = { 0 };
+    uint32_t header_size = 0;
+    if (g_dso_state.data_header) {
+        header = capture_header(&config, channel, count * layout.width);
+        header_size = sizeof(header);
+    }
+
+    // The other record fills while this one is sent
+    if (g_dso_state.capture.records > 1) {
+        start_next_record();
+    }
+
+    // Output acquisition data as SCPI arbitrary block
+    if (g_dso_state.data_format != DATA_FORMAT_INT16 ||
+        layout.width != layout.stride) {
+        // Converted once per capture, for hosts that each fetch it
+        FetchCache const *const cache = fetch_cache_get(
+            g_dso_state.data_format, samples, count * layout.width, layout
+        );
+        if (cache) {
+            protocol_result_block_prefixed(
+                context,
+                (uint8_t const *)&header,
+                header_size,
+                cache->data,
+                cache->len
+            );
+            return SCPI_RES_OK;
+        }
+        // Without room for the cache, converted on the way out
+        result_packed_block(
+            context,
+            (uint8_t const *)&header,
+            header_size,
+            g_dso_state.data_format,
+            samples,
+            count * layout.width,
+            layout
+        );
+        return SCPI_RES_OK;
+    }
+
+    // Sent in place, the TX buffer is much smaller than a capture
+    protocol_result_block_prefixed(
+        context,
+        (uint8_t const *)&header,
+        header_size,
+        (uint8_t const *)samples,
+        count * layout.width * sizeof(uint16_t)
+    );
+
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:FETCh:DATa? - Fetch the oscilloscope data
+ *
+ * Syntax: OSCilloscope:FETCh[:DATa]? [{CH1|CH2|CH3|CH4}][,<start>,<count>
+ *         [,<stride>]]
+ *
+ * The data is sent in the format selected with OSCilloscope:FORMat, after
+ * a CaptureHeader if OSCilloscope:FORMat:HEADer is ON. Without a channel,
+ * multi-channel captures are sent as interleaved frames; with one, only
+ * the samples of that channel are sent, de-interleaved on the way out.
+ * A window sends <count> frames from frame <start> on, every <stride>-th
+ * (1 by default), cut at the end of the record; the channel may be left
+ * out ahead of it.
+ */
+scpi_result_t scpi_cmd_fetch_oscilloscope_data_q(scpi_t *context)
+{
+    scpi_choice_def_t const channel_choices[] = {
+        { "CH1", 1 },
+        { "CH2", 2 },
+        { "CH3", 3 },
+        { "CH4", 4 },
+        SCPI_CHOICE_LIST_END
+    };
+    int32_t channel = FETCH_ALL_CHANNELS;
+    FetchWindow window = { .start = 0, .count = 0, .stride = 1 };
+    bool windowed = false;
+    scpi_parameter_t param;
+
+    if (SCPI_Parameter(context, &param, false)) {
+        if (SCPI_ParamIsNumber(&param, false)) {
+            windowed = SCPI_ParamToUInt32(context, &param, &window.start);
+        } else {
+            (void)SCPI_ParamToChoice(
+                context, &param, channel_choices, &channel
+            );
+            windowed = SCPI_ParamUInt32(context, &window.start, false);
+        }
+    }
+    if (windowed) {
+        if (!SCPI_ParamUInt32(context, &window.count, true)) {
+            SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+            return SCPI_RES_ERR;
+        }
+        (void)SCPI_ParamUInt32(context, &window.stride, false);
+    }
+    if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+    if (windowed && (window.count == 0 || window.stride == 0)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.fetch_argument = (uint32_t)channel;
+    g_dso_state.fetch_window = window;
+    return fetch_data(context);
+}
+
+/**
+ * @brief Send the record of OSCilloscope:FETCh:ETIMe?
+ *
+ * Resumable; the step count is in g_dso_state.fetch_argument.
+ */
+static scpi_result_t fetch_etime(scpi_t *context)
+{
+    uint32_t const steps = g_dso_state.fetch_argument;
+    Error err = ERROR_NONE;
+
+    scpi_result_t const result = finish_acquisition(context, fetch_etime);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    uint32_t const size =
+        g_dso_state.acquisition_buffer_size / g_dso_state.capture.segments;
+    uint16_t *record = sample_alloc(size * sizeof(uint16_t));
+    if (record == nullptr) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t used = 0;
+    TRY
+    {
+        used = DSO_get_equivalent_time(
+            g_dso_state.dso_handle, steps, record, size
+        );
+    }
+    CATCH(err)
+    {
+        // Not an edge-triggered single-channel capture without decimation
+        sample_release(record);
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    if (used == 0) {
+        sample_release(record);
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    if (g_dso_state.data_format != DATA_FORMAT_INT16) {
+        result_packed_block(
+            context,
+            nullptr,
+            0,
+            g_dso_state.data_format,
+            record,
+            size,
+            g_CONTIGUOUS
+        );
+    } else {
+        SCPI_ResultArbitraryBlock(
+            context, (char *)record, size * sizeof(uint16_t)
+        );
+    }
+
+    sample_release(record);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:FETCh:ETIMe? - Fetch an equivalent-time record
+ *
+ * Syntax: OSCilloscope:FETCh:ETIMe? <steps>
+ *
+ * Interleaves the segments of an edge-triggered single-channel capture of a
+ * repetitive signal into one record at <steps> (2 to 64) times the sample
+ * rate, aligned on the interpolated trigger crossing of each segment. The
+ * record has as many points as a segment and is sent in the format selected
+ * with OSCilloscope:FORMat.
+ */
+scpi_result_t scpi_cmd_fetch_oscilloscope_etime_q(scpi_t *context)
+{
+    uint32_t steps = 0;
+
+    if (!SCPI_ParamUInt32(context, &steps, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    if (steps < 2 || steps > DSO_ETS_STEPS_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.fetch_argument = steps;
+    return fetch_etime(context);
+}
+
+/**
+ * @brief OSCilloscope:FETCh:MEASure? - Fetch measurements of the capture
+ *
+ * Returns, for each captured channel in turn, the peak-to-peak, mean and
+ * RMS voltage in millivolts, the frequency in millihertz, the period and
+ * the 10-90% rise time in nanoseconds, and the duty cycle in per mille.
+ * Timing values are 0 if the capture holds no complete cycle.
+ */
+scpi_result_t scpi_cmd_fetch_oscilloscope_measure_q(scpi_t *context)
+{
+    int32_t values[4 * MEASUREMENT_VALUES]; // Up to four channels
+    uint32_t count = 0;
+    Error err = ERROR_NONE;
+
+    scpi_result_t const result =
+        finish_acquisition(context, scpi_cmd_fetch_oscilloscope_measure_q);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    DSO_Config const config = DSO_get_config(g_dso_state.dso_handle);
+    uint32_t const channels = mode_channels(config.mode);
+
+    TRY
+    {
+        for (uint32_t channel = 0; channel < channels; ++channel) {
+            DSO_Measurements measurements;
+            DSO_measure(g_dso_state.dso_handle, channel, &measurements);
+
+            uint32_t const fields[MEASUREMENT_VALUES] = {
+                measurements.peak_to_peak_mv,
+                measurements.mean_mv,
+                measurements.rms_mv,
+                measurements.frequency_mhz,
+                measurements.period_ns,
+                measurements.rise_time_ns,
+                measurements.duty_cycle_permille,
+            };
+            for (uint32_t i = 0; i < MEASUREMENT_VALUES; ++i) {
+                values[count++] =
+                    fields[i] > INT32_MAX ? INT32_MAX : (int32_t)fields[i];
+            }
+        }
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("DSO measurement error: 0x%08X", err);
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    protocol_result_int32_ascii(context, values, count);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Transform the first captured channel of the last capture
+ *
+ * Uses the largest power-of-two FFT size that a segment holds and that
+ * fits in the free sample memory. Release spectrum->work when done.
+ *
+ * @param context SCPI context for error reporting
+ * @param spectrum Output spectrum
+ * @param resume Fetch handler to defer to, see finish_acquisition
+ * @return SCPI_RES_OK if spectrum holds the bins; otherwise the result for
+ *         the query handler to return
+ */
+static scpi_result_t compute_spectrum(
+    scpi_t *context,
+    Spectrum *spectrum,
+    scpi_command_callback_t resume
+)
+{
+    Error err = ERROR_NONE;
+
+    scpi_result_t const result = finish_acquisition(context, resume);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    DSO_Config const config = DSO_get_config(g_dso_state.dso_handle);
+    uint32_t const samples = g_dso_state.acquisition_buffer_size /
+                             g_dso_state.capture.segments /
+                             mode_channels(config.mode);
+
+    *spectrum = (Spectrum){ .sample_rate = config.sample_rate };
+    for (uint32_t size = SPECTRUM_SIZE_MAX; size >= SPECTRUM_SIZE_MIN;
+         size /= 2) {
+        if (size > samples) {
+            continue;
+        }
+        spectrum->work =
+            sample_alloc(2 * size * sizeof(int32_t));
+        if (spectrum->work == nullptr) {
+            continue;
+        }
+        spectrum->bins =
+            sample_alloc((size / 2) * sizeof(FIXED_Q1616));
+        if (spectrum->bins != nullptr) {
+            spectrum->size = size;
+            break;
+        }
+        sample_release(spectrum->work);
+    }
+
+    if (spectrum->size == 0) {
+        // Too few samples per channel, or no memory left for the FFT
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    TRY
+    {
+        DSO_get_spectrum(
+            g_dso_state.dso_handle,
+            0,
+            spectrum->size,
+            spectrum->work,
+            spectrum->bins
+        );
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("DSO spectrum error: 0x%08X", err);
+        sample_release(spectrum->work);
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Factor converting Q16.16 ADC codes to microvolts
+ */
+static int32_t microvolt_scale(void)
+{
+    int32_t const full_scale =
+        (int32_t)(DSO_get_reference_voltage() * SI_KILO_INT);
+    return FIXED_code_scale(full_scale, sample_max());
+}
+
+/**
+ * @brief Frequency of a spectrum bin in millihertz
+ *
+ * @param bin Bin index in Q16.16, may be interpolated
+ */
+static int32_t bin_frequency(Spectrum const *spectrum, FIXED_Q1616 bin)
+{
+    uint64_t const scaled =
+        (uint64_t)bin * spectrum->sample_rate * SI_MILLI_DIV;
+    uint64_t const unit = (uint64_t)spectrum->size * FIXED_SCALE;
+    uint64_t const frequency = (scaled + (unit / 2)) / unit;
+    return frequency > INT32_MAX ? INT32_MAX : (int32_t)frequency;
+}
+
+/**
+ * @brief OSCilloscope:FETCh:SPECtrum? - Fetch the amplitude spectrum
+ *
+ * Returns the amplitude spectrum of the first captured channel as a block
+ * of little-endian 32-bit amplitudes in microvolts, from DC up to below
+ * half the sample rate. With N amplitudes, bin k is at
+ * k * sample rate / (2 * N).
+ */
+scpi_result_t scpi_cmd_fetch_oscilloscope_spectrum_q(scpi_t *context)
+{
+    Spectrum spectrum;
+
+    scpi_result_t const result = compute_spectrum(
+        context, &spectrum, scpi_cmd_fetch_oscilloscope_spectrum_q
+    );
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    uint32_t const count = spectrum.size / 2;
+    int32_t const scale = microvolt_scale();
+    for (uint32_t k = 0; k < count; ++k) {
+        spectrum.bins[k] = FIXED_scale_code(spectrum.bins[k], scale);
+    }
+
+    SCPI_ResultArrayInt32(
+        context, spectrum.bins, count, SCPI_FORMAT_LITTLEENDIAN
+    );
+    sample_release(spectrum.work);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Send the peaks of OSCilloscope:FETCh:SPECtrum:PEAKs?
+ *
+ * Resumable; the peak count is in g_dso_state.fetch_argument.
+ */
+static scpi_result_t fetch_spectrum_peaks(scpi_t *context)
+{
+    uint32_t const max_peaks = g_dso_state.fetch_argument;
+    uint32_t peaks[SPECTRUM_PEAKS_MAX];
+    int32_t values[2 * SPECTRUM_PEAKS_MAX];
+    Spectrum spectrum;
+
+    scpi_result_t const result =
+        compute_spectrum(context, &spectrum, fetch_spectrum_peaks);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    uint32_t const found = SPECTRUM_find_peaks(
+        spectrum.bins, spectrum.size / 2, peaks, max_peaks
+    );
+    int32_t const scale = microvolt_scale();
+    for (uint32_t i = 0; i < found; ++i) {
+        values[2 * i] =
+            bin_frequency(&spectrum, FIXED_from_int((int32_t)peaks[i]));
+        values[(2 * i) + 1] =
+            FIXED_scale_code(spectrum.bins[peaks[i]], scale);
+    }
+    sample_release(spectrum.work);
+
+    protocol_result_int32_ascii(context, values, 2 * found);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:FETCh:SPECtrum:PEAKs? - Fetch the strongest tones
+ *
+ * Syntax: OSCilloscope:FETCh:SPECtrum:PEAKs? [<count>]
+ *
+ * Returns up to <count> (1 to 16, default 5) peaks of the spectrum of the
+ * first captured channel by decreasing amplitude, each as its bin
+ * frequency in millihertz followed by its amplitude in microvolts.
+ */
+scpi_result_t scpi_cmd_fetch_oscilloscope_spectrum_peaks_q(scpi_t *context)
+{
+    uint32_t max_peaks = SPECTRUM_PEAKS_DEFAULT;
+
+    SCPI_ParamUInt32(context, &max_peaks, false);
+    if (max_peaks < 1 || max_peaks > SPECTRUM_PEAKS_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.fetch_argument = max_peaks;
+    return fetch_spectrum_peaks(context);
+}
+
+/**
+ * @brief Send the results of OSCilloscope:FETCh:SPECtrum:DISTortion?
+ *
+ * Resumable; the highest harmonic is in g_dso_state.fetch_argument.
+ */
+static scpi_result_t fetch_spectrum_distortion(scpi_t *context)
+{
+    uint32_t const harmonics = g_dso_state.fetch_argument;
+    SPECTRUM_Distortion distortion;
+    Spectrum spectrum;
+
+    scpi_result_t const result =
+        compute_spectrum(context, &spectrum, fetch_spectrum_distortion);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    SPECTRUM_distortion(
+        spectrum.bins, spectrum.size / 2, harmonics, &distortion
+    );
+    sample_release(spectrum.work);
+
+    int32_t const values[DISTORTION_VALUES] = {
+        bin_frequency(&spectrum, distortion.fundamental),
+        FIXED_scale_code(distortion.amplitude, microvolt_scale()),
+        distortion.thd_cdb,
+        distortion.snr_cdb,
+        (int32_t)distortion.harmonics,
+    };
+    protocol_result_int32_ascii(context, values, DISTORTION_VALUES);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:FETCh:SPECtrum:DISTortion? - Fetch THD and SNR
+ *
+ * Syntax: OSCilloscope:FETCh:SPECtrum:DISTortion? [<harmonics>]
+ *
+ * Measures the strongest tone of the first captured channel against its
+ * 2nd to <harmonics>th harmonics (2 to 10, default 5). Returns the tone's
+ * frequency in millihertz, its amplitude in microvolts, the THD and the
+ * SNR in hundredths of a dB, and the number of harmonics that were below
+ * half the sample rate.
+ */
+scpi_result_t scpi_cmd_fetch_oscilloscope_spectrum_distortion_q(
+    scpi_t *context
+)
+{
+    uint32_t harmonics = SPECTRUM_HARMONICS_DEFAULT;
+
+    SCPI_ParamUInt32(context, &harmonics, false);
+    if (harmonics < 2 || harmonics > SPECTRUM_HARMONICS_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.fetch_argument = harmonics;
+    return fetch_spectrum_distortion(context);
+}
+
+/**
+ * @brief Decode a (lower, upper) pair of 16-bit little-endian codes
+ */
+static MASK_Limit decode_limit(uint8_t const *pair)
+{
+    return (MASK_Limit){
+        .lower = (uint16_t)(pair[0] | (pair[1] << 8)),
+        .upper = (uint16_t)(pair[2] | (pair[3] << 8)),
+    };
+}
+
+// Samples of the mask part being streamed in, checked once received
+static struct {
+    uint32_t first;
+    uint32_t count;
+} g_mask_stream;
+
+/**
+ * @brief Check the limits of a streamed mask part once they are all in
+ *
+ * The limits were received in place, so inverted ones are opened rather
+ * than kept.
+ */
+static scpi_result_t mask_data_received(scpi_t *context)
+{
+    MASK_Limit *const limits = &g_dso_state.mask[g_mask_stream.first];
+    bool valid = true;
+
+    for (uint32_t i = 0; i < g_mask_stream.count; ++i) {
+        if (limits[i].lower > limits[i].upper) {
+            limits[i] = (MASK_Limit)MASK_LIMIT_OPEN;
+            valid = false;
+        }
+    }
+    if (!valid) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:MASK:DATA - Upload part of the mask
+ *
+ * Parameters are the index of the first sample, and its limits as a
+ * definite length arbitrary block of (lower, upper) pairs of 16-bit
+ * little-endian codes, e.g. OSC:MASK:DATA 0,#216<4 pairs>. Samples are
+ * indexed as in OSCilloscope:FETCh:DATa?, all channels interleaved. A
+ * block too large for the SCPI input buffer is streamed into the mask as
+ * it arrives. The mask spans the acquisition buffer; samples not uploaded
+ * always pass. Resizing the buffer, or switching averaging on or off,
+ * clears the mask.
+ */
+scpi_result_t scpi_cmd_mask_oscilloscope_data(scpi_t *context)
+{
+    uint32_t first = 0;
+    char const *data = nullptr;
+    size_t size = 0;
+
+    if (!SCPI_ParamUInt32(context, &first, true) ||
+        !SCPI_ParamArbitraryBlock(context, &data, &size, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    uint32_t const streamed = protocol_block_streamed();
+    if (streamed > 0) {
+        size = streamed;
+    }
+
+    if (!g_dso_state.acquisition_buffer ||
+        (g_dso_state.dso_handle &&
+         DSO_is_acquisition_in_progress(g_dso_state.dso_handle))) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t const points = g_dso_state.acquisition_buffer_size;
+    uint32_t const count = (uint32_t)size / sizeof(MASK_Limit);
+    if (size % sizeof(MASK_Limit) != 0 || first > points ||
+        count > points - first) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    uint8_t const *const pairs = (uint8_t const *)data;
+    for (uint32_t i = 0; i < count && streamed == 0; ++i) {
+        MASK_Limit const limit = decode_limit(&pairs[i * sizeof(MASK_Limit)]);
+        if (limit.lower > limit.upper) {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    if (!g_dso_state.mask) {
+        // The mask goes right behind the buffer, ahead of the histogram
+        sample_release(g_dso_state.histogram.bins);
+        g_dso_state.histogram = (HISTOGRAM_State){ .bins = nullptr };
+        g_dso_state.mask =
+            sample_alloc(points * sizeof(MASK_Limit));
+        if (!g_dso_state.mask) {
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+        for (uint32_t i = 0; i < points; ++i) {
+            g_dso_state.mask[i] = (MASK_Limit)MASK_LIMIT_OPEN;
+        }
+    }
+
+    if (streamed > 0) {
+        // Little-endian pairs land in the mask as they are
+        g_mask_stream.first = first;
+        g_mask_stream.count = count;
+        protocol_block_receive(&g_dso_state.mask[first], mask_data_received);
+        return SCPI_RES_OK;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        g_dso_state.mask[first + i] =
+            decode_limit(&pairs[i * sizeof(MASK_Limit)]);
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:MASK[:STATe] - Switch the mask test on or off
+ *
+ * Syntax: OSCilloscope:MASK[:STATe] <ON|OFF|1|0>
+ *
+ * While on, every completed capture is tested against the mask as it
+ * completes, and OSCilloscope:FETCh:MASK? returns the outcome. A mask must
+ * have been uploaded with OSCilloscope:MASK:DATA.
+ */
+scpi_result_t scpi_cmd_mask_oscilloscope_state(scpi_t *context)
+{
+    scpi_bool_t enabled = false;
+
+    if (!SCPI_ParamBool(context, &enabled, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    if ((enabled && !g_dso_state.mask) ||
+        (g_dso_state.dso_handle &&
+         DSO_is_acquisition_in_progress(g_dso_state.dso_handle))) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.mask_enabled = enabled;
+    g_dso_state.mask_valid = false;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:MASK[:STATe]? - Query whether the mask test is on
+ */
+scpi_result_t scpi_cmd_mask_oscilloscope_state_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_dso_state.mask_enabled);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:FETCh:MASK? - Fetch the mask test of the capture
+ *
+ * Returns 1 if the capture passed and 0 if it failed, the number of
+ * samples outside their limits, and the index of the first of them, or -1
+ * if it passed. Waits for the capture like OSCilloscope:FETCh:DATa?.
+ */
+scpi_result_t scpi_cmd_fetch_oscilloscope_mask_q(scpi_t *context)
+{
+    scpi_result_t const result =
+        finish_acquisition(context, scpi_cmd_fetch_oscilloscope_mask_q);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    if (!g_dso_state.mask_valid) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    MASK_Result const *const outcome = &g_dso_state.mask_result;
+    SCPI_ResultBool(context, outcome->violations == 0);
+    SCPI_ResultUInt32(context, outcome->violations);
+    SCPI_ResultInt32(
+        context,
+        outcome->first == MASK_NO_FAILURE ? -1 : (int32_t)outcome->first
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:READ? - Initiate and fetch oscilloscope data
+ */
+scpi_result_t scpi_cmd_read_oscilloscope_q(scpi_t *context)
+{
+    scpi_result_t result = SCPI_RES_OK;
+
+    // Abort any ongoing acquisition
+    if (g_dso_state.dso_handle &&
+        DSO_is_acquisition_in_progress(g_dso_state.dso_handle)) {
+        result = scpi_cmd_abort_oscilloscope(context);
+        if (result != SCPI_RES_OK) {
+            return result;
+        }
+    }
+
+    // Initiate acquisition
+    result = scpi_cmd_initiate_oscilloscope(context);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    // Fetch the result
+    return scpi_cmd_fetch_oscilloscope_data_q(context);
+}
+
+/**
+ * @brief OSCilloscope:MEASure? - Configure, initiate, and fetch oscilloscope
+ * measurements
+ *
+ * This is a convenience command that combines configuration, acquisition
+ * and measurement; see OSCilloscope:FETCh:MEASure? for the results.
+ * Parameters: channel
+ */
+scpi_result_t scpi_cmd_measure_oscilloscope_q(scpi_t *context)
+{
+    scpi_result_t result = SCPI_RES_OK;
+
+    // Configure (validate the configuration)
+    result = scpi_cmd_configure_oscilloscope_channel(context);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    // Abort any ongoing acquisition
+    if (g_dso_state.dso_handle &&
+        DSO_is_acquisition_in_progress(g_dso_state.dso_handle)) {
+        result = scpi_cmd_abort_oscilloscope(context);
+        if (result != SCPI_RES_OK) {
+            return result;
+        }
+    }
+
+    result = scpi_cmd_initiate_oscilloscope(context);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    return scpi_cmd_fetch_oscilloscope_measure_q(context);
+}
+
+/**
+ * @brief Round a timebase up to the next 1-2-5 step
+ */
+static uint32_t timebase_step(uint32_t timebase_us)
+{
+    static uint32_t const mantissas[] = { 1, 2, 5 };
+
+    for (uint64_t decade = 1; decade <= UINT32_MAX; decade *= 10) {
+        for (size_t i = 0; i < sizeof(mantissas) / sizeof(mantissas[0]);
+             ++i) {
+            uint64_t const step = mantissas[i] * decade;
+            if (step >= timebase_us && step <= UINT32_MAX) {
+                return (uint32_t)step;
+            }
+        }
+    }
+    return UINT32_MAX;
+}
+
+/**
+ * @brief Timebase of an OSCilloscope:AUTOset probe capture
+ *
+ * The first probe is as short as the ADC allows with AUTOSET_PROBE_POINTS
+ * per channel, each further probe ten times longer.
+ */
+static uint32_t autoset_probe_timebase(Setup const *setup, uint32_t probe)
+{
+    uint64_t const points =
+        (uint64_t)AUTOSET_PROBE_POINTS * mode_channels(setup->mode);
+    uint64_t const rate_max =
+        DSO_get_max_sample_rate(setup->mode, setup->capture.resolution);
+    uint64_t const unit = rate_max * HORIZONTAL_DIVISIONS;
+    uint64_t timebase_us = ((points * SI_MICRO_DIV) + unit - 1) / unit;
+
+    timebase_us = timebase_us > 0 ? timebase_us : 1;
+    for (uint32_t i = 0; i < probe; ++i) {
+        timebase_us *= 10;
+    }
+    return (uint32_t)timebase_us;
+}
+
+/**
+ * @brief Configure and start the current OSCilloscope:AUTOset probe
+ *
+ * Probes are free-running single records, whatever the capture settings.
+ *
+ * @return SCPI_RES_OK once started, SCPI_RES_ERR with the error pushed
+ */
+static scpi_result_t autoset_start_probe(scpi_t *context)
+{
+    Setup probe = g_dso_state.autoset_setup;
+
+    probe.timebase_us =
+        autoset_probe_timebase(&probe, g_dso_state.autoset_probe);
+    probe.points = AUTOSET_PROBE_POINTS * mode_channels(probe.mode);
+    probe.capture = (CaptureSettings){
+        .trigger_mode = DSO_TRIGGER_NONE,
+        .segments = 1,
+        .averages = 1,
+        .records = 1,
+        .decimation = DSO_DECIMATION_NONE,
+        .resolution = probe.capture.resolution,
+    };
+
+    scpi_result_t const result = apply_setup(context, &probe);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    if (dso_capture_start() != ERROR_NONE) {
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+    g_dso_state.autoset_start = SYSTEM_get_tick();
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief End OSCilloscope:AUTOset with the setup for a signal period
+ *
+ * Picks the shortest 1-2-5 timebase that shows about AUTOSET_CYCLES
+ * periods and the most points up to AUTOSET_POINTS per channel that the ADC
+ * keeps up with, lengthening the timebase while fewer than
+ * AUTOSET_POINTS_MIN fit.
+ * Without a period, the setup from before the probes is restored and an
+ * execution error reported.
+ *
+ * @param period_ns Period found, 0 if none
+ */
+static void autoset_finish(scpi_t *context, uint32_t period_ns)
+{
+    Setup setup = g_dso_state.autoset_setup;
+
+    g_dso_state.autoset_active = false;
+    if (period_ns == 0) {
+        LOG_INFO("DSO autoset: no periodic signal found");
+        (void)apply_setup(context, &setup);
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return;
+    }
+
+    uint64_t const channels = mode_channels(setup.mode);
+    uint64_t const rate_max =
+        DSO_get_max_sample_rate(setup.mode, setup.capture.resolution);
+    uint64_t const span_ns = (uint64_t)period_ns * AUTOSET_CYCLES;
+    uint64_t const divisions_ns = (uint64_t)HORIZONTAL_DIVISIONS * SI_KILO_INT;
+    uint32_t timebase_us = timebase_step(
+        (uint32_t)((span_ns + (divisions_ns / 2)) / divisions_ns)
+    );
+    uint64_t points = 0;
+
+    for (;;) {
+        uint64_t const duration_us =
+            (uint64_t)timebase_us * HORIZONTAL_DIVISIONS;
+        points = (rate_max * duration_us) / SI_MICRO_DIV;
+        if (points > AUTOSET_POINTS * channels) {
+            points = AUTOSET_POINTS * channels;
+        }
+        // A multiple of 4, as continuous mode needs
+        points &= ~3ULL;
+        if (points >= AUTOSET_POINTS_MIN * channels ||
+            timebase_us == UINT32_MAX) {
+            break;
+        }
+        timebase_us = timebase_step(timebase_us + 1);
+    }
+
+    setup.timebase_us = timebase_us;
+    setup.points = (uint32_t)points;
+    LOG_INFO(
+        "DSO autoset: period %u ns, %u us/div, %u points",
+        period_ns,
+        setup.timebase_us,
+        setup.points
+    );
+    if (apply_setup(context, &setup) != SCPI_RES_OK) {
+        (void)apply_setup(context, &g_dso_state.autoset_setup);
+    }
+}
+
+/**
+ * @brief Whether OSCilloscope:AUTOset is over
+ */
+static bool autoset_done(void) { return !g_dso_state.autoset_active; }
+
+/**
+ * @brief OSCilloscope:AUTOset - Pick timebase and points for the signal
+ *
+ * Captures the primary channel at up to AUTOSET_PROBES decreasing sample
+ * rates, from the fastest, until the measurement engine finds a period and
+ * a swing of at least AUTOSET_SIGNAL_MIN_MV, then sets the timebase and
+ * points for it. Channel, capture settings and data format are kept.
+ *
+ * Overlapped: *OPC, *OPC? and *WAI wait for the new setup.
+ */
+scpi_result_t scpi_cmd_autoset_oscilloscope(scpi_t *context)
+{
+    if (g_dso_state.streaming || g_dso_state.rolling ||
+        g_dso_state.histogram_active || g_dso_state.autoset_active ||
+        (g_dso_state.dso_handle &&
+         DSO_is_acquisition_in_progress(g_dso_state.dso_handle))) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.autoset_setup = current_setup();
+    g_dso_state.autoset_probe = 0;
+    g_dso_state.autoset_context = context;
+
+    if (autoset_start_probe(context) != SCPI_RES_OK) {
+        (void)apply_setup(context, &g_dso_state.autoset_setup);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.autoset_active = true;
+    // Each probe times out on its own
+    protocol_operation_pending(autoset_done, UINT32_MAX);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Measure completed OSCilloscope:AUTOset probes
+ *
+ * Must be called periodically from the protocol task. Starts the next probe
+ * while no period is found, and applies the setup once one is, or once the
+ * last probe has come back empty.
+ */
+void dso_autoset_task(void)
+{
+    if (!g_dso_state.autoset_active) {
+        return;
+    }
+
+    scpi_t *const context = g_dso_state.autoset_context;
+    DSO_Measurements measurements = { 0 };
+    Error err = ERROR_NONE;
+
+    if (DSO_is_acquisition_in_progress(g_dso_state.dso_handle)) {
+        uint32_t const capture_ms =
+            (g_dso_state.timebase_us * HORIZONTAL_DIVISIONS) / SI_MILLI_DIV;
+        uint32_t const timeout = (2 * capture_ms) + AUTOSET_PROBE_MARGIN;
+
+        if (SYSTEM_get_tick() - g_dso_state.autoset_start > timeout) {
+            LOG_ERROR("DSO autoset: probe capture timeout");
+            DSO_stop(g_dso_state.dso_handle);
+            g_dso_state.autoset_active = false;
+            (void)apply_setup(context, &g_dso_state.autoset_setup);
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        }
+        return;
+    }
+
+    DSO_stop(g_dso_state.dso_handle);
+    TRY
+    {
+        if (g_dso_state.acquisition_complete) {
+            DSO_measure(g_dso_state.dso_handle, 0, &measurements);
+        }
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("DSO measurement error: 0x%08X", err);
+    }
+
+    if (measurements.period_ns > 0 &&
+        measurements.peak_to_peak_mv >= AUTOSET_SIGNAL_MIN_MV) {
+        autoset_finish(context, measurements.period_ns);
+        return;
+    }
+
+    if (++g_dso_state.autoset_probe == AUTOSET_PROBES) {
+        autoset_finish(context, 0);
+        return;
+    }
+    if (autoset_start_probe(context) != SCPI_RES_OK) {
+        autoset_finish(context, 0);
+    }
+}
+
+/**
+ * @brief OSCilloscope:STATus:ACQuisition? - Query acquisition status
+ *
+ * Returns:
+ * 0 - No acquisition started
+ * 1 - Acquisition in progress
+ * 2 - Acquisition complete
+ */
+scpi_result_t scpi_cmd_status_oscilloscope_acquisition_q(scpi_t *context)
+{
+    uint32_t status = 0;
+
+    if (g_dso_state.acquisition_buffer) {
+        if (g_dso_state.dso_handle &&
+            DSO_is_acquisition_in_progress(g_dso_state.dso_handle)) {
+            status = 1;
+        } else if (g_dso_state.acquisition_complete) {
+            status = 2;
+        }
+    }
+
+    SCPI_ResultUInt32(context, status);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STATus:INTegrity? - Query data integrity counters
+ *
+ * Returns: <overruns>,<dma_errors>,<dropped>,<affected>
+ * - overruns: ADC overruns since startup
+ * - dma_errors: ADC DMA transfer errors since startup
+ * - dropped: Stream gaps since the last reset
+ * - affected: 1 if an error hit the current or last capture, else 0
+ */
+scpi_result_t scpi_cmd_status_oscilloscope_integrity_q(scpi_t *context)
+{
+    DSO_Diagnostics const diagnostics =
+        DSO_get_diagnostics(g_dso_state.dso_handle);
+
+    SCPI_ResultUInt32(context, diagnostics.adc_overruns);
+    SCPI_ResultUInt32(context, diagnostics.dma_errors);
+    SCPI_ResultUInt32(
+        context,
+        g_dso_state.stream_dropped +
+            (g_dso_state.streaming ? diagnostics.stream_pauses : 0)
+    );
+    SCPI_ResultUInt32(context, diagnostics.capture_affected ? 1 : 0);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Pauses of the running stream while blocks were still being sent
+ */
+static uint32_t stream_pauses(void)
+{
+    if (!g_dso_state.streaming) {
+        return 0;
+    }
+    return DSO_get_diagnostics(g_dso_state.dso_handle).stream_pauses;
+}
+
+/**
+ * @brief Set the continuous flag on the current DSO configuration
+ *
+ * @param context SCPI context for error reporting
+ * @param continuous true to switch to continuous acquisition
+ * @param block_callback Consumer of the buffer halves when continuous, or
+ *                       nullptr to overwrite the buffer in a ring
+ * @return SCPI_RES_OK on success, SCPI_RES_ERR on failure
+ */
+static scpi_result_t set_stream_config(
+    scpi_t *context,
+    bool continuous,
+    DSO_BlockCallback block_callback
+)
+{
+    DSO_Config config = g_dso_state.dso_handle
+                            ? DSO_get_config(g_dso_state.dso_handle)
+                            : (DSO_Config)DSO_CONFIG_DEFAULT;
+
+    uint32_t buffer_size = g_dso_state.acquisition_buffer_size > 0
+                               ? g_dso_state.acquisition_buffer_size
+                               : BUFFER_SIZE_DEFAULT;
+
+    scpi_result_t result = configure_sample_rate_and_buffer(
+        context, buffer_size, config.mode, &config
+    );
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    config.continuous = continuous;
+    config.block_callback = continuous ? block_callback : nullptr;
+
+    return apply_dso_config(context, &config);
+}
+
+/**
+ * @brief Start a stream with the current stream settings
+ *
+ * @param context SCPI context for error reporting
+ * @return SCPI_RES_OK on success, SCPI_RES_ERR on failure
+ */
+static scpi_result_t stream_start(scpi_t *context)
+{
+    if (g_dso_state.dso_handle &&
+        DSO_is_acquisition_in_progress(g_dso_state.dso_handle)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    scpi_result_t result =
+        set_stream_config(context, true, dso_stream_block_callback);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    // An isochronous stream gets one packet per frame and no more, so a
+    // rate it cannot carry would only keep the DSO paused
+    if (g_dso_state.stream_interface == STREAM_INTERFACE_ISO) {
+        DSO_Config const config = DSO_get_config(g_dso_state.dso_handle);
+        uint32_t const bytes_per_second =
+            format_bound(g_dso_state.data_format, config.sample_rate);
+        if (bytes_per_second > USB_ISO_PACKET_SIZE * SI_KILO_INT) {
+            SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    // The math channel combines the two channels of a dual capture into
+    // signed Q15 words, which only the INT16 format carries as they are
+    if (g_dso_state.stream_math_enabled &&
+        (DSO_get_config(g_dso_state.dso_handle).mode != DSO_MODE_DUAL_CHANNEL ||
+         g_dso_state.data_format != DATA_FORMAT_INT16)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    stream_reset();
+    g_dso_state.stream_overruns = 0;
+
+    // Each stream block is one half of the acquisition buffer
+    uint32_t const block_samples = g_dso_state.acquisition_buffer_size / 2;
+    if (g_dso_state.stream_auto_decimation) {
+        // Decimated blocks are at most half as long
+        g_dso_state.stream_reduced =
+            sample_alloc((block_samples / 2) * sizeof(uint16_t));
+        if (!g_dso_state.stream_reduced) {
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+    }
+    if (g_dso_state.stream_math_enabled) {
+        CHANNEL_MATH_Config *const math = &g_dso_state.stream_math;
+        math->sample_bits = resolution_bits(g_dso_state.capture.resolution);
+        g_dso_state.stream_math_block = sample_alloc(
+            (block_samples / 2) * CHANNEL_MATH_frame_size(math) *
+                sizeof(uint16_t)
+        );
+        if (!g_dso_state.stream_math_block) {
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+    }
+    if (g_dso_state.data_format != DATA_FORMAT_INT16) {
+        uint32_t const block_bytes =
+            format_bound(g_dso_state.data_format, block_samples);
+        g_dso_state.stream_encoded = sample_alloc(block_bytes);
+        if (!g_dso_state.stream_encoded) {
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    Error const err = DSO_try_start(g_dso_state.dso_handle);
+    if (err != ERROR_NONE) {
+        LOG_ERROR("DSO stream start error: 0x%08X", err);
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.streaming = true;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam[:STARt] - Start streaming oscilloscope data
+ *
+ * Switches the DSO to continuous double-buffered acquisition and pushes each
+ * completed buffer half to the host as a definite-length arbitrary block
+ * ("#<digits><length><data>" followed by a line ending), without waiting
+ * for a query. Blocks are sent in the format selected with
+ * OSCilloscope:FORMat. The acquisition buffer size must be a multiple of 4.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_start(scpi_t *context)
+{
+    if (g_dso_state.streaming) {
+        return SCPI_RES_OK;
+    }
+    return stream_start(context);
+}
+
+/**
+ * @brief OSCilloscope:STReam:STOP - Stop streaming oscilloscope data
+ *
+ * Stops acquisition and returns the DSO to single-shot captures. A block
+ * already being transmitted is discarded, except by a record, which sends
+ * the blocks it has queued and its RecordStats first.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_stop(scpi_t *context)
+{
+    if (!g_dso_state.streaming || g_dso_state.record_ending) {
+        return SCPI_RES_OK;
+    }
+
+    // Keep the gaps of this stream for OSCilloscope:STReam:OVERruns?
+    uint32_t const pauses = stream_pauses();
+    g_dso_state.stream_overruns += pauses;
+    g_dso_state.stream_dropped += pauses;
+
+    DSO_stop(g_dso_state.dso_handle);
+    if (g_dso_state.recording) {
+        // The stopped DSO leaves the queued blocks as they are
+        g_dso_state.record_ending = true;
+    } else {
+        stream_reset();
+    }
+
+    return set_stream_config(context, false, nullptr);
+}
+
+/**
+ * @brief OSCilloscope:STReam? - Query whether streaming is active
+ *
+ * Returns 1 while streaming, 0 otherwise.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_dso_state.streaming);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:OVERruns? - Query gaps in the stream
+ *
+ * Returns the number of times since streaming was last started that
+ * acquisition paused because both buffer halves were still waiting to be
+ * sent. Blocks are never overwritten while they are sent; each pause
+ * leaves a gap between two blocks instead.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_overruns_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_dso_state.stream_overruns + stream_pauses());
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:INTerface - Select the stream output interface
+ *
+ * Syntax: OSCilloscope:STReam:INTerface {CDC|BULK|ISO}
+ *
+ * CDC (the default) sends stream blocks on the SCPI serial port. BULK sends
+ * them on the vendor bulk interface instead, leaving the serial port free
+ * for commands. ISO sends them on the isochronous interface of builds with
+ * PSLAB_USB_ISO, one packet per frame at a fixed bandwidth; other builds
+ * refuse it. Block framing is identical on all interfaces. Cannot be
+ * changed while streaming.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_interface(scpi_t *context)
+{
+    scpi_choice_def_t const interface_choices[] = {
+        { "CDC", STREAM_INTERFACE_CDC },
+        { "BULK", STREAM_INTERFACE_BULK },
+        { "ISO", STREAM_INTERFACE_ISO },
+        SCPI_CHOICE_LIST_END
+    };
+
+    int32_t interface_choice = -1;
+
+    if (!SCPI_ParamChoice(
+            context, interface_choices, &interface_choice, true
+        )) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    if (g_dso_state.streaming) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    if ((interface_choice == STREAM_INTERFACE_BULK && !protocol_bulk_open()) ||
+        (interface_choice == STREAM_INTERFACE_ISO && !protocol_iso_open())) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.stream_interface = (StreamInterface)interface_choice;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:INTerface? - Query the stream output interface
+ *
+ * Returns "CDC", "BULK" or "ISO".
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_interface_q(scpi_t *context)
+{
+    static char const *const names[] = {
+        [STREAM_INTERFACE_CDC] = "CDC",
+        [STREAM_INTERFACE_BULK] = "BULK",
+        [STREAM_INTERFACE_ISO] = "ISO",
+    };
+
+    SCPI_ResultMnemonic(context, names[g_dso_state.stream_interface]);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:DECimation:AUTO - Decimate streams after gaps
+ *
+ * Syntax: OSCilloscope:STReam:DECimation:AUTO {ON|OFF|1|0}
+ *
+ * With ON, each block that follows a gap in the stream, a pause of the
+ * acquisition or a dropped block, doubles the factor by which this and
+ * later blocks are averaged down, up to 64, so that a host that cannot keep
+ * up gets fewer samples instead of more gaps. The factor restarts at 1 with
+ * the stream, and is reported in the StreamHeader of each block (see
+ * OSCilloscope:FORMat:HEADer) and by OSCilloscope:STReam:DECimation?. OFF
+ * by default and after *RST; cannot be changed while streaming.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_decimation_auto(scpi_t *context)
+{
+    bool enable = false;
+
+    if (!SCPI_ParamBool(context, &enable, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    if (g_dso_state.streaming) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.stream_auto_decimation = enable;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:DECimation:AUTO? - Query automatic decimation
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_decimation_auto_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_dso_state.stream_auto_decimation);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:DECimation? - Query the stream decimation
+ *
+ * Returns the factor by which stream blocks are averaged down, 1 when they
+ * are not.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_decimation_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_dso_state.stream_decimation);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:MATH - Select the math channel of streams
+ *
+ * Syntax: OSCilloscope:STReam:MATH {OFF|DIFFerence|PRODuct|SUM}
+ *
+ * Adds a math channel to each frame of a dual-channel stream, computed in
+ * Q15 from CH1 and CH2 as fractions of full scale: CH1 - CH2, CH1 * CH2,
+ * or the sum with the gains of OSCilloscope:STReam:MATH:GAIN. The results
+ * are signed, so the stream format must be INT16. Each block follows any
+ * automatic decimation, and its StreamHeader flags the layout. OFF by
+ * default and after *RST; cannot be changed while streaming.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_math(scpi_t *context)
+{
+    enum { MATH_OFF = -1 };
+    scpi_choice_def_t const math_choices[] = {
+        { "OFF", MATH_OFF },
+        { "DIFFerence", CHANNEL_MATH_DIFFERENCE },
+        { "PRODuct", CHANNEL_MATH_PRODUCT },
+        { "SUM", CHANNEL_MATH_SUM },
+        SCPI_CHOICE_LIST_END
+    };
+    int32_t choice = MATH_OFF;
+
+    if (!SCPI_ParamChoice(context, math_choices, &choice, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    if (g_dso_state.streaming) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.stream_math_enabled = choice != MATH_OFF;
+    if (g_dso_state.stream_math_enabled) {
+        g_dso_state.stream_math.function = (CHANNEL_MATH_Function)choice;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:MATH? - Query the math channel of streams
+ *
+ * Returns "OFF", "DIFF", "PROD" or "SUM".
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_math_q(scpi_t *context)
+{
+    static char const *const names[] = {
+        [CHANNEL_MATH_DIFFERENCE] = "DIFF",
+        [CHANNEL_MATH_PRODUCT] = "PROD",
+        [CHANNEL_MATH_SUM] = "SUM",
+    };
+
+    SCPI_ResultMnemonic(
+        context,
+        g_dso_state.stream_math_enabled
+            ? names[g_dso_state.stream_math.function]
+            : "OFF"
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:MATH:GAIN - Set the gains of the SUM channel
+ *
+ * Syntax: OSCilloscope:STReam:MATH:GAIN <gain1>,<gain2>
+ *
+ * Q15 gains of CH1 and CH2, -32768 to 32767 for -1 to just below 1; the
+ * sum saturates. 16384,16384 by default and after *RST, the mean of the
+ * two channels. Cannot be changed while streaming.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_math_gain(scpi_t *context)
+{
+    int32_t gains[2] = { 0 };
+
+    if (!SCPI_ParamInt32(context, &gains[0], true) ||
+        !SCPI_ParamInt32(context, &gains[1], true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        if (gains[i] < INT16_MIN || gains[i] > INT16_MAX) {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    if (g_dso_state.streaming) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.stream_math.gains[0] = (FIXED_Q15)gains[0];
+    g_dso_state.stream_math.gains[1] = (FIXED_Q15)gains[1];
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:MATH:GAIN? - Query the gains of the SUM channel
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_math_gain_q(scpi_t *context)
+{
+    SCPI_ResultInt32(context, g_dso_state.stream_math.gains[0]);
+    SCPI_ResultInt32(context, g_dso_state.stream_math.gains[1]);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:MATH:ONLY - Send only the math channel
+ *
+ * Syntax: OSCilloscope:STReam:MATH:ONLY {ON|OFF|1|0}
+ *
+ * With ON, stream blocks carry the math channel alone, one sample per
+ * frame instead of three, which halves the data of the capture. OFF by
+ * default and after *RST; cannot be changed while streaming.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_math_only(scpi_t *context)
+{
+    bool enable = false;
+
+    if (!SCPI_ParamBool(context, &enable, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    if (g_dso_state.streaming) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.stream_math.math_only = enable;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:MATH:ONLY? - Query whether only math is sent
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_math_only_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_dso_state.stream_math.math_only);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Data format of records: the smallest that keeps every sample bit
+ */
+static DataFormat record_format(DSO_Resolution resolution)
+{
+    uint32_t const bits = resolution_bits(resolution);
+
+    if (bits <= 8) {
+        return DATA_FORMAT_INT8;
+    }
+    return bits <= 12 ? DATA_FORMAT_PACKED : DATA_FORMAT_INT16;
+}
+
+/**
+ * @brief Highest sample rate a record sends without gaps
+ *
+ * The lowest of three limits for the current mode, resolution and buffer
+ * size: the ADC, RECORD_LINK_SHARE of the link rate, measured by the last
+ * SYSTem:TEST:USB or else RECORD_LINK_RATE_DEFAULT, in packed samples and
+ * block framing, and half a buffer every RECORD_BLOCK_TIME_MIN.
+ *
+ * @return Sample rate in Hz, all channels
+ */
+static uint32_t record_rate(void)
+{
+    DSO_Config const config = g_dso_state.dso_handle
+                                  ? DSO_get_config(g_dso_state.dso_handle)
+                                  : (DSO_Config)DSO_CONFIG_DEFAULT;
+    DSO_Resolution const resolution = g_dso_state.capture.resolution;
+    uint32_t const buffer_size = g_dso_state.acquisition_buffer_size > 0
+                                     ? g_dso_state.acquisition_buffer_size
+                                     : BUFFER_SIZE_DEFAULT;
+    uint64_t const block_samples = buffer_size / 2;
+    uint64_t const block_bytes =
+        format_size(record_format(resolution), (uint32_t)block_samples) +
+        STREAM_HEADER_SIZE + sizeof(StreamHeader) + STREAM_CRC_SIZE +
+        strlen(SCPI_LINE_ENDING);
+
+    uint32_t const measured = linktest_tx_rate();
+    uint64_t const link =
+        (uint64_t)(measured > 0 ? measured : RECORD_LINK_RATE_DEFAULT) *
+        RECORD_LINK_SHARE / 100;
+    uint64_t rate = link * block_samples / block_bytes;
+
+    uint64_t const block_rate =
+        block_samples * SI_MICRO_DIV / RECORD_BLOCK_TIME_MIN;
+    if (block_rate < rate) {
+        rate = block_rate;
+    }
+    uint32_t const adc_rate = DSO_get_max_sample_rate(config.mode, resolution);
+    return rate < adc_rate ? (uint32_t)rate : adc_rate;
+}
+
+/**
+ * @brief OSCilloscope:STReam:RECord[:STARt] - Start a gap-free record
+ *
+ * Streams on the bulk interface with the settings a long recording needs,
+ * whatever the stream settings: the format of record_format, the
+ * StreamHeader and CRC on every block, and neither automatic decimation
+ * nor a math channel. The stream settings come back once the record ends.
+ * Refused unless the sample rate set by the timebase and points is at most
+ * OSCilloscope:STReam:RECord:RATE?. OSCilloscope:STReam:STOP ends the
+ * record once the blocks queued have been sent, with a block flagged
+ * STREAM_FLAG_END whose data is the RecordStats of the record.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_record(scpi_t *context)
+{
+    if (g_dso_state.recording && !g_dso_state.record_ending) {
+        return SCPI_RES_OK;
+    }
+
+    if (g_dso_state.streaming || !protocol_bulk_open()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t const rate = record_rate();
+    uint32_t const buffer_size = g_dso_state.acquisition_buffer_size > 0
+                                     ? g_dso_state.acquisition_buffer_size
+                                     : BUFFER_SIZE_DEFAULT;
+    uint32_t const sample_rate = timebase_sample_rate(buffer_size);
+    if (sample_rate > rate) {
+        LOG_WARN(
+            "DSO record at %lu Hz above the gap-free %lu Hz",
+            (unsigned long)sample_rate,
+            (unsigned long)rate
+        );
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_dso_state.record_saved = (StreamSettings){
+        .data_format = g_dso_state.data_format,
+        .data_header = g_dso_state.data_header,
+        .interface = g_dso_state.stream_interface,
+        .auto_decimation = g_dso_state.stream_auto_decimation,
+        .math_enabled = g_dso_state.stream_math_enabled,
+    };
+    g_dso_state.data_format = record_format(g_dso_state.capture.resolution);
+    g_dso_state.data_header = true;
+    g_dso_state.stream_interface = STREAM_INTERFACE_BULK;
+    g_dso_state.stream_auto_decimation = false;
+    g_dso_state.stream_math_enabled = false;
+    g_dso_state.record_stats = (RecordStats){ .rate = rate };
+
+    scpi_result_t const result = stream_start(context);
+    if (result != SCPI_RES_OK) {
+        record_restore_settings();
+        return result;
+    }
+
+    g_dso_state.recording = true;
+    g_dso_state.record_ending = false;
+    g_dso_state.record_end_sent = false;
+    LOG_INFO(
+        "DSO record at %lu Hz, gap-free up to %lu Hz",
+        (unsigned long)sample_rate,
+        (unsigned long)rate
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:RECord? - Query whether a record runs
+ *
+ * Returns 1 from the start of a record until its RecordStats block has
+ * been sent, 0 otherwise.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_record_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_dso_state.recording);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:RECord:RATE? - Query the gap-free record rate
+ *
+ * Returns the highest sample rate in Hz, all channels, at which a record
+ * of the current mode, resolution and points keeps up, see record_rate.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_record_rate_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, record_rate());
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:STReam:RECord:STATistics? - Query record statistics
+ *
+ * Returns <samples>,<drops>,<depth> of the running or last record: the
+ * samples sent, the gaps, and the most blocks that waited to be sent at
+ * once.
+ */
+scpi_result_t scpi_cmd_stream_oscilloscope_record_statistics_q(
+    scpi_t *context
+)
+{
+    RecordStats const *const stats = &g_dso_state.record_stats;
+    uint64_t const values[] = {
+        stats->samples,
+        g_dso_state.recording ? g_dso_state.stream_gaps : stats->drops,
+        stats->queue_depth_max,
+    };
+
+    SCPI_ResultArrayUInt64(
+        context, values, sizeof(values) / sizeof(values[0]), SCPI_FORMAT_ASCII
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:ROLL[:STARt] - Start roll mode
+ *
+ * Switches the DSO to continuous acquisition that overwrites the
+ * acquisition buffer in a ring, for slow timebases. Nothing is sent until
+ * the host asks for the samples written since its last request with
+ * OSCilloscope:FETCh:NEW?. The acquisition buffer size must be a multiple
+ * of 4.
+ */
+scpi_result_t scpi_cmd_roll_oscilloscope_start(scpi_t *context)
+{
+    if (g_dso_state.rolling) {
+        return SCPI_RES_OK;
+    }
+
+    if (g_dso_state.dso_handle &&
+        DSO_is_acquisition_in_progress(g_dso_state.dso_handle)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    scpi_result_t const result = set_stream_config(context, true, nullptr);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    Error const err = DSO_try_start(g_dso_state.dso_handle);
+    if (err != ERROR_NONE) {
+        LOG_ERROR("DSO roll start error: 0x%08X", err);
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    // The ring holds no capture to fetch
+    g_dso_state.acquisition_complete = false;
+    g_dso_state.rolling = true;
+    g_dso_state.roll_fetched = 0;
+    g_dso_state.roll_index = 0;
+    g_dso_state.roll_skipped = 0;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:ROLL:STOP - Stop roll mode
+ *
+ * Stops acquisition and returns the DSO to single-shot captures.
+ */
+scpi_result_t scpi_cmd_roll_oscilloscope_stop(scpi_t *context)
+{
+    if (!g_dso_state.rolling) {
+        return SCPI_RES_OK;
+    }
+
+    DSO_stop(g_dso_state.dso_handle);
+    g_dso_state.rolling = false;
+
+    return set_stream_config(context, false, nullptr);
+}
+
+/**
+ * @brief OSCilloscope:ROLL? - Query whether roll mode is active
+ */
+scpi_result_t scpi_cmd_roll_oscilloscope_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_dso_state.rolling);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:ROLL:SKIPped? - Query samples lost in roll mode
+ *
+ * Returns the number of samples since roll mode was started that were not
+ * fetched in time and were skipped by OSCilloscope:FETCh:NEW?.
+ */
+scpi_result_t scpi_cmd_roll_oscilloscope_skipped_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_dso_state.roll_skipped);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:FETCh:NEW? - Fetch the samples written in roll mode
+ *
+ * Sends the samples written since the previous OSCilloscope:FETCh:NEW?
+ * (or since roll mode started), in whole frames and the format selected
+ * with OSCilloscope:FORMat. At most half the buffer is sent, since the
+ * older half may be overwritten while it goes out; samples before that
+ * are skipped and counted.
+ */
+scpi_result_t scpi_cmd_fetch_oscilloscope_new_q(scpi_t *context)
+{
+    if (!g_dso_state.rolling) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    DSO_Handle *const handle = g_dso_state.dso_handle;
+    DSO_Config const config = DSO_get_config(handle);
+    uint32_t const channels = mode_channels(config.mode);
+    // Whole frames, and pairs of samples for the packed format
+    uint32_t const granule = channels > 2 ? channels : 2;
+    uint32_t const size = g_dso_state.acquisition_buffer_size;
+    uint32_t const limit = size / 2;
+
+    uint32_t written = DSO_get_samples_written(handle);
+    written -= written % granule;
+    uint32_t count = written - g_dso_state.roll_fetched;
+    uint32_t start = g_dso_state.roll_index;
+
+    if (count > limit) {
+        uint32_t const skipped = count - limit;
+        g_dso_state.roll_skipped += skipped;
+        start = (start + (skipped % size)) % size;
+        count = limit;
+    }
+
+    result_ring_block(
+        context,
+        g_dso_state.data_format,
+        g_dso_state.acquisition_buffer,
+        size,
+        start,
+        count
+    );
+
+    g_dso_state.roll_fetched = written;
+    g_dso_state.roll_index = (start + count) % size;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief DSO block callback in histogram mode, from interrupt context
+ *
+ * The DSO lends at most two halves at a time, so the pipeline only
+ * overflows if blocks are not returned; such a block is returned at once.
+ */
+static void histogram_block_callback(uint16_t const *block, uint32_t samples)
+{
+    if (!PIPELINE_push(&g_dso_state.histogram_pipeline, block, samples)) {
+        DSO_release_block(g_dso_state.dso_handle, block);
+    }
+}
+
+/**
+ * @brief Histogram pipeline sink, bins a block
+ */
+static bool histogram_sink(void *context, PIPELINE_Block const *block)
+{
+    HISTOGRAM_add(context, block->data, block->count);
+    return true;
+}
+
+/**
+ * @brief Pipeline release function, returns a block to the DSO
+ */
+static void release_dso_block(void *context, void const *data)
+{
+    (void)context;
+    DSO_release_block(g_dso_state.dso_handle, data);
+}
+
+/**
+ * @brief Bin the blocks queued in histogram mode and return them to the DSO
+ */
+static void histogram_drain(void)
+{
+    PIPELINE_run(&g_dso_state.histogram_pipeline);
+}
+
+/**
+ * @brief OSCilloscope:HISTogram:RANGe - Set the codes binned
+ *
+ * Syntax: OSCilloscope:HISTogram:RANGe <low>,<high>
+ *
+ * One bin per code from low to high, at most 4096 bins. Takes effect at
+ * the next OSCilloscope:HISTogram:STARt.
+ */
+scpi_result_t scpi_cmd_histogram_oscilloscope_range(scpi_t *context)
+{
+    uint32_t low = 0;
+    uint32_t high = 0;
+
+    if (!SCPI_ParamUInt32(context, &low, true) ||
+        !SCPI_ParamUInt32(context, &high, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    if (low > high || high >= HISTOGRAM_BINS_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    if (g_dso_state.histogram_active) {
         SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
         return SCPI_RES_ERR;
     }
 
-    // If acquisition is still in progress, wait for completion
+    g_dso_state.histogram_low = (uint16_t)low;
+    g_dso_state.histogram_high = (uint16_t)high;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:HISTogram:RANGe? - Query the codes binned
+ */
+scpi_result_t scpi_cmd_histogram_oscilloscope_range_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_dso_state.histogram_low);
+    SCPI_ResultUInt32(context, g_dso_state.histogram_high);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:HISTogram[:STARt] - Start histogram mode
+ *
+ * Syntax: OSCilloscope:HISTogram[:STARt] [{CH1|CH2|CH3|CH4}]
+ *
+ * Clears the histogram and switches the DSO to continuous acquisition.
+ * Each completed buffer half is binned by the protocol task and handed
+ * back; no samples are sent. Without a channel, the first captured channel
+ * is binned. The acquisition buffer size must be a multiple of 4.
+ */
+scpi_result_t scpi_cmd_histogram_oscilloscope_start(scpi_t *context)
+{
+    scpi_choice_def_t const channel_choices[] = {
+        { "CH1", 1 },
+        { "CH2", 2 },
+        { "CH3", 3 },
+        { "CH4", 4 },
+        SCPI_CHOICE_LIST_END
+    };
+    int32_t channel = FETCH_ALL_CHANNELS;
+
+    SCPI_ParamChoice(context, channel_choices, &channel, false);
+    if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (g_dso_state.histogram_active) {
+        return SCPI_RES_OK;
+    }
+
     if (g_dso_state.dso_handle &&
         DSO_is_acquisition_in_progress(g_dso_state.dso_handle)) {
-        uint32_t timeout = SI_MILLI_DIV; // 1 second timeout
-        uint32_t start_time = SYSTEM_get_tick();
-
-        while (DSO_is_acquisition_in_progress(g_dso_state.dso_handle)) {
-            if (SYSTEM_get_tick() - start_time > timeout) {
-                LOG_ERROR("DSO acquisition timeout - stopping acquisition");
-                DSO_stop(g_dso_state.dso_handle);
-                SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
-                return SCPI_RES_ERR;
-            }
-        }
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
     }
 
-    // Check if acquisition completed successfully
-    if (!g_dso_state.acquisition_complete) {
-        DSO_stop(g_dso_state.dso_handle);
-        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+    // The channel mode is kept, so check it before reconfiguring
+    DSO_Config const config = g_dso_state.dso_handle
+                                  ? DSO_get_config(g_dso_state.dso_handle)
+                                  : (DSO_Config)DSO_CONFIG_DEFAULT;
+    if (channel == FETCH_ALL_CHANNELS) {
+        channel = config.mode == DSO_MODE_SINGLE_CHANNEL
+                      ? (int32_t)config.channel + 1
+                      : 1;
+    }
+    uint32_t offset = 0;
+    uint32_t stride = 1;
+    if (!capture_channel(&config, (uint32_t)channel, &offset, &stride)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_SETTINGS_CONFLICT);
+        return SCPI_RES_ERR;
+    }
+
+    scpi_result_t const result =
+        set_stream_config(context, true, histogram_block_callback);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+
+    // Bins follow the buffer, in place of those of the previous histogram
+    stream_reset();
+    sample_release(g_dso_state.histogram.bins);
+    uint32_t const bin_count =
+        (uint32_t)(g_dso_state.histogram_high - g_dso_state.histogram_low) +
+        1;
+    uint32_t *const bins =
+        sample_alloc(bin_count * sizeof(uint32_t));
+    bool ready = bins && HISTOGRAM_init(
+                             &g_dso_state.histogram,
+                             bins,
+                             g_dso_state.histogram_low,
+                             g_dso_state.histogram_high,
+                             stride,
+                             offset
+                         );
+    ready = ready && PIPELINE_init(
+                         &g_dso_state.histogram_pipeline,
+                         &(PIPELINE_Config){
+                             .storage = g_dso_state.histogram_queue_storage,
+                             .size = STREAM_QUEUE_SIZE,
+                             .sink = { .function = histogram_sink,
+                                       .context = &g_dso_state.histogram },
+                             .release = release_dso_block,
+                         }
+                     );
+    if (!ready) {
+        g_dso_state.histogram = (HISTOGRAM_State){ .bins = nullptr };
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    Error const err = DSO_try_start(g_dso_state.dso_handle);
+    if (err != ERROR_NONE) {
+        LOG_ERROR("DSO histogram start error: 0x%08X", err);
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
         return SCPI_RES_ERR;
     }
 
+    g_dso_state.acquisition_complete = false;
+    g_dso_state.histogram_active = true;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:HISTogram:STOP - Stop histogram mode
+ *
+ * Stops acquisition, bins the blocks still queued and returns the DSO to
+ * single-shot captures. The histogram can still be fetched.
+ */
+scpi_result_t scpi_cmd_histogram_oscilloscope_stop(scpi_t *context)
+{
+    if (!g_dso_state.histogram_active) {
+        return SCPI_RES_OK;
+    }
+
     DSO_stop(g_dso_state.dso_handle);
+    histogram_drain();
+    g_dso_state.histogram_active = false;
+
+    return set_stream_config(context, false, nullptr);
+}
+
+/**
+ * @brief OSCilloscope:HISTogram? - Query whether histogram mode is active
+ */
+scpi_result_t scpi_cmd_histogram_oscilloscope_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_dso_state.histogram_active);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:HISTogram:COUNt? - Query the samples binned
+ *
+ * Returns three values: samples within the range, samples below it and
+ * samples above it, since the histogram was started.
+ */
+scpi_result_t scpi_cmd_histogram_oscilloscope_count_q(scpi_t *context)
+{
+    SCPI_ResultUInt64(context, g_dso_state.histogram.counted);
+    SCPI_ResultUInt64(context, g_dso_state.histogram.below);
+    SCPI_ResultUInt64(context, g_dso_state.histogram.above);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief OSCilloscope:FETCh:HISTogram? - Fetch the histogram
+ *
+ * Sends one little-endian uint32 counter per code of the range as a
+ * definite-length block. May be sent while histogram mode runs; the bins
+ * are copied as they stand when the query is answered.
+ */
+scpi_result_t scpi_cmd_fetch_oscilloscope_histogram_q(scpi_t *context)
+{
+    HISTOGRAM_State const *const histogram = &g_dso_state.histogram;
+
+    if (!histogram->bins) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
 
-    // Output acquisition data as SCPI arbitrary block
-    size_t data_size = g_dso_state.acquisition_buffer_size * sizeof(uint16_t);
     SCPI_ResultArbitraryBlock(
-        context, (char *)g_dso_state.acquisition_buffer, data_size
+        context, histogram->bins, histogram->bin_count * sizeof(uint32_t)
     );
-
     return SCPI_RES_OK;
 }
 
 /**
- * @brief OSCilloscope:READ? - Initiate and fetch oscilloscope data
+ * @brief Bin the blocks acquired in histogram mode
+ *
+ * Must be called periodically from the protocol task. Acquisition pauses
+ * while both buffer halves wait to be binned, which leaves gaps in the
+ * sampled signal but does not bias the histogram.
  */
-scpi_result_t scpi_cmd_read_oscilloscope_q(scpi_t *context)
+void dso_histogram_task(void)
 {
-    scpi_result_t result = SCPI_RES_OK;
+    if (g_dso_state.histogram_active) {
+        histogram_drain();
+    }
+}
 
-    // Abort any ongoing acquisition
-    if (g_dso_state.dso_handle &&
-        DSO_is_acquisition_in_progress(g_dso_state.dso_handle)) {
-        result = scpi_cmd_abort_oscilloscope(context);
-        if (result != SCPI_RES_OK) {
-            return result;
+/**
+ * @brief Raise the automatic stream decimation after a gap
+ *
+ * The factor doubles for as long as it divides the frames of a block, up
+ * to STREAM_DECIMATION_MAX; it is not lowered again until the stream is
+ * restarted.
+ *
+ * @param frames Frames in a block
+ */
+static void stream_raise_decimation(uint32_t frames)
+{
+    uint32_t const next = g_dso_state.stream_decimation * 2;
+
+    if (next <= STREAM_DECIMATION_MAX && frames % next == 0) {
+        g_dso_state.stream_decimation = next;
+        LOG_INFO("DSO stream decimation raised to %lu", (unsigned long)next);
+    }
+}
+
+/**
+ * @brief Frame a latched block for transmission
+ *
+ * Sets up the length header, the StreamHeader and CRC with
+ * OSCilloscope:FORMat:HEADer ON, and the line ending around the data,
+ * which is sent in place.
+ *
+ * @param header StreamHeader of the block
+ * @param data Data of the block
+ * @param data_len Bytes of data
+ */
+static void stream_frame(
+    StreamHeader const *header,
+    uint8_t const *data,
+    uint32_t data_len
+)
+{
+    uint32_t const header_size =
+        g_dso_state.data_header ? sizeof(StreamHeader) : 0;
+    uint32_t const crc_size = g_dso_state.data_header ? STREAM_CRC_SIZE : 0;
+
+    char length[STREAM_HEADER_SIZE];
+    int const digits = snprintf(
+        length,
+        sizeof(length),
+        "%lu",
+        (unsigned long)(header_size + data_len + crc_size)
+    );
+
+    g_dso_state.stream_header_len = (uint32_t)snprintf(
+        g_dso_state.stream_header,
+        STREAM_HEADER_SIZE,
+        "#%d%s",
+        digits,
+        length
+    );
+    memcpy(
+        &g_dso_state.stream_header[g_dso_state.stream_header_len],
+        header,
+        header_size
+    );
+    g_dso_state.stream_header_len += header_size;
+    g_dso_state.stream_data = data;
+    g_dso_state.stream_data_len = data_len;
+
+    // The CRC covers the StreamHeader and the data
+    if (g_dso_state.data_header) {
+        CHECKSUM_start(
+            &g_dso_state.stream_checksum,
+            CHECKSUM_CRC32,
+            CRC32_update(CRC32_INIT, header, sizeof(*header)),
+            data,
+            data_len
+        );
+        g_dso_state.stream_crc_pending = true;
+    }
+    memcpy(
+        &g_dso_state.stream_trailer[crc_size],
+        SCPI_LINE_ENDING,
+        strlen(SCPI_LINE_ENDING)
+    );
+    g_dso_state.stream_trailer_len =
+        crc_size + (uint32_t)strlen(SCPI_LINE_ENDING);
+
+    g_dso_state.stream_tx_offset = 0;
+    g_dso_state.stream_tx_len = g_dso_state.stream_header_len + data_len +
+                                g_dso_state.stream_trailer_len;
+}
+
+/**
+ * @brief Latch the oldest queued block for transmission
+ *
+ * A block that follows a gap raises the decimation first, with automatic
+ * decimation on. A decimated block is averaged into the reduced copy and
+ * returned to the DSO at once, as is one that is given a math channel or
+ * converted.
+ *
+ * @return true if a block is ready to be sent
+ */
+static bool stream_latch_block(void)
+{
+    StreamBlock block;
+
+    if (!stream_block_ring_get(&g_dso_state.stream_queue, &block)) {
+        return false;
+    }
+
+    bool const gap = block.gaps != g_dso_state.stream_gaps_sent;
+    g_dso_state.stream_gaps_sent = block.gaps;
+
+    DSO_Config config = { 0 };
+    if (g_dso_state.stream_reduced || g_dso_state.data_header) {
+        config = DSO_get_config(g_dso_state.dso_handle);
+    }
+    uint32_t const channels = mode_channels(config.mode);
+    if (gap && g_dso_state.stream_reduced) {
+        stream_raise_decimation(block.count / channels);
+    }
+
+    uint16_t const *samples = block.samples;
+    uint32_t count = block.count;
+    if (g_dso_state.stream_decimation > 1) {
+        count = DECIMATE_average(
+            samples,
+            count,
+            channels,
+            g_dso_state.stream_decimation,
+            g_dso_state.stream_reduced
+        );
+        samples = g_dso_state.stream_reduced;
+        DSO_release_block(g_dso_state.dso_handle, block.samples);
+    }
+    if (g_dso_state.stream_math_block) {
+        count = CHANNEL_MATH_apply(
+            &g_dso_state.stream_math,
+            samples,
+            count,
+            g_dso_state.stream_math_block
+        );
+        if (samples == block.samples) {
+            DSO_release_block(g_dso_state.dso_handle, block.samples);
         }
+        samples = g_dso_state.stream_math_block;
     }
 
-    // Initiate acquisition
-    result = scpi_cmd_initiate_oscilloscope(context);
-    if (result != SCPI_RES_OK) {
-        return result;
+    uint8_t const *data = (uint8_t const *)samples;
+    uint32_t data_len = count * sizeof(uint16_t);
+
+    if (g_dso_state.stream_encoded) {
+        // Converting copies the block, so the DSO can have it back at once
+        data_len = encode_samples(
+            g_dso_state.data_format,
+            samples,
+            count,
+            g_dso_state.stream_encoded
+        );
+        data = g_dso_state.stream_encoded;
+        if (samples == block.samples) {
+            DSO_release_block(g_dso_state.dso_handle, block.samples);
+        }
+    } else if (samples == block.samples) {
+        g_dso_state.stream_lent = block.samples;
     }
 
-    // Fetch the result
-    return scpi_cmd_fetch_oscilloscope_data_q(context);
+    uint8_t flags = gap ? STREAM_FLAG_GAP : 0;
+    if (g_dso_state.stream_math_block) {
+        flags |= g_dso_state.stream_math.math_only ? STREAM_FLAG_MATH_ONLY
+                                                   : STREAM_FLAG_MATH;
+    }
+    StreamHeader const header = {
+        .version = STREAM_HEADER_VERSION,
+        .size = sizeof(StreamHeader),
+        .format = (uint8_t)g_dso_state.data_format,
+        .flags = flags,
+        .sequence = block.sequence,
+        .gaps = block.gaps,
+        .decimation = g_dso_state.stream_decimation,
+        .sample_rate = config.sample_rate / g_dso_state.stream_decimation,
+        .samples = count,
+    };
+    stream_frame(&header, data, data_len);
+
+    // Kept for OSCilloscope:STReam:RECord:STATistics?
+    g_dso_state.record_stats.samples += count;
+    g_dso_state.record_stats.blocks++;
+    return true;
 }
 
 /**
- * @brief OSCilloscope:MEASure? - Configure, initiate, and fetch oscilloscope
- * data
+ * @brief Latch the RecordStats block that ends a stopped record
  *
- * This is a convenience command that combines configuration and measurement.
- * Parameters: channel, mode, sample_rate, buffer_size
+ * Called once the queue has drained; on the call after the block has been
+ * sent, the record is over and the stream settings are given back.
+ *
+ * @return true if the block is ready to be sent
  */
-scpi_result_t scpi_cmd_measure_oscilloscope_q(scpi_t *context)
+static bool record_latch_end(void)
 {
-    scpi_result_t result = SCPI_RES_OK;
+    if (g_dso_state.record_end_sent) {
+        stream_reset();
+        return false;
+    }
 
-    // Configure (validate the configuration)
-    result = scpi_cmd_configure_oscilloscope_channel(context);
-    if (result != SCPI_RES_OK) {
-        return result;
+    DSO_Config const config = DSO_get_config(g_dso_state.dso_handle);
+    StreamHeader const header = {
+        .version = STREAM_HEADER_VERSION,
+        .size = sizeof(StreamHeader),
+        .format = (uint8_t)g_dso_state.data_format,
+        .flags = STREAM_FLAG_END,
+        .sequence = g_dso_state.stream_sequence,
+        .gaps = g_dso_state.stream_gaps,
+        .decimation = 1,
+        .sample_rate = config.sample_rate,
+        .samples = 0,
+    };
+
+    g_dso_state.record_stats.drops = g_dso_state.stream_gaps;
+    g_record_end = g_dso_state.record_stats;
+    stream_frame(
+        &header, (uint8_t const *)&g_record_end, sizeof(g_record_end)
+    );
+    g_dso_state.record_end_sent = true;
+    return true;
+}
+
+/**
+ * @brief Put the CRC of the latched block into its trailer, once computed
+ *
+ * @return false while the CRC unit is still at it
+ */
+static bool stream_trailer_ready(void)
+{
+    uint32_t crc = 0;
+
+    if (!g_dso_state.stream_crc_pending) {
+        return true;
+    }
+    if (!CHECKSUM_result(&g_dso_state.stream_checksum, &crc)) {
+        return false;
     }
+    for (uint32_t i = 0; i < STREAM_CRC_SIZE; ++i) {
+        g_dso_state.stream_trailer[i] = (uint8_t)(crc >> (8 * i));
+    }
+    g_dso_state.stream_crc_pending = false;
+    return true;
+}
 
-    // Read (initiate + fetch)
-    return scpi_cmd_read_oscilloscope_q(context);
+/**
+ * @brief Check whether the data of the last block is still being sent
+ */
+static bool stream_data_pending(void)
+{
+    switch (g_dso_state.stream_interface) {
+    case STREAM_INTERFACE_BULK:
+        return protocol_bulk_tx_pending();
+    case STREAM_INTERFACE_ISO:
+        return protocol_iso_tx_pending();
+    case STREAM_INTERFACE_CDC:
+    default:
+        return protocol_raw_tx_pending();
+    }
 }
 
 /**
- * @brief OSCilloscope:STATus:ACQuisition? - Query acquisition status
+ * @brief Hand the data of the latched block to the selected interface
  *
- * Returns:
- * 0 - No acquisition started
- * 1 - Acquisition in progress
- * 2 - Acquisition complete
+ * @return true if queued, false while another buffer is being sent
  */
-scpi_result_t scpi_cmd_status_oscilloscope_acquisition_q(scpi_t *context)
+static bool stream_write_data(uint8_t const *data, uint32_t len)
 {
-    uint32_t status = 0;
+    switch (g_dso_state.stream_interface) {
+    case STREAM_INTERFACE_BULK:
+        return protocol_write_bulk_buffer(data, len);
+    case STREAM_INTERFACE_ISO:
+        return protocol_write_iso_buffer(data, len);
+    case STREAM_INTERFACE_CDC:
+    default:
+        return protocol_write_raw_buffer(data, len);
+    }
+}
 
-    if (g_dso_state.acquisition_buffer) {
-        if (g_dso_state.dso_handle &&
-            DSO_is_acquisition_in_progress(g_dso_state.dso_handle)) {
-            status = 1;
-        } else if (g_dso_state.acquisition_complete) {
-            status = 2;
+/**
+ * @brief Copy block framing into the selected interface's TX buffer
+ *
+ * @return Number of bytes accepted
+ */
+static uint32_t stream_write_framing(uint8_t const *data, uint32_t len)
+{
+    switch (g_dso_state.stream_interface) {
+    case STREAM_INTERFACE_BULK:
+        return protocol_write_bulk(data, len);
+    case STREAM_INTERFACE_ISO:
+        return protocol_write_iso(data, len);
+    case STREAM_INTERFACE_CDC:
+    default:
+        return protocol_write_raw(data, len);
+    }
+}
+
+/**
+ * @brief Check whether a stream sends its blocks on the bulk interface
+ */
+bool dso_stream_on_bulk(void)
+{
+    return g_dso_state.streaming &&
+           g_dso_state.stream_interface == STREAM_INTERFACE_BULK;
+}
+
+/**
+ * @brief Push pending stream data to the host
+ *
+ * Must be called periodically from the protocol task. The header and
+ * trailer of each block are copied into the selected interface's TX buffer,
+ * its data is handed to the USB layer in place. A lent block is returned to
+ * the DSO once the USB layer is done with it, before the next one is sent.
+ * A stopped record sends the blocks still queued, then its RecordStats.
+ */
+void dso_stream_task(void)
+{
+    if (!g_dso_state.streaming) {
+        return;
+    }
+
+    if (g_dso_state.stream_tx_offset >= g_dso_state.stream_tx_len) {
+        if (stream_data_pending()) {
+            return;
+        }
+        if (g_dso_state.stream_lent) {
+            DSO_release_block(g_dso_state.dso_handle, g_dso_state.stream_lent);
+            g_dso_state.stream_lent = nullptr;
+        }
+        if (!stream_latch_block() &&
+            !(g_dso_state.record_ending && record_latch_end())) {
+            return;
         }
     }
 
-    SCPI_ResultUInt32(context, status);
-    return SCPI_RES_OK;
-}
\ No newline at end of file
+    while (g_dso_state.stream_tx_offset < g_dso_state.stream_tx_len) {
+        uint32_t offset = g_dso_state.stream_tx_offset;
+        uint32_t const data_end =
+            g_dso_state.stream_header_len + g_dso_state.stream_data_len;
+
+        if (offset >= g_dso_state.stream_header_len && offset < data_end) {
+            // Sent after the header already in the TX buffer
+            if (!stream_write_data(
+                    g_dso_state.stream_data, g_dso_state.stream_data_len
+                )) {
+                // Another buffer is still being sent, retry later
+                return;
+            }
+            g_dso_state.stream_tx_offset = data_end;
+            continue;
+        }
+
+        uint8_t const *segment = nullptr;
+        uint32_t segment_len = 0;
+
+        if (offset < g_dso_state.stream_header_len) {
+            segment = (uint8_t const *)g_dso_state.stream_header + offset;
+            segment_len = g_dso_state.stream_header_len - offset;
+        } else {
+            if (!stream_trailer_ready()) {
+                // Retry once the CRC unit is done
+                return;
+            }
+            offset -= data_end;
+            segment = &g_dso_state.stream_trailer[offset];
+            segment_len = g_dso_state.stream_trailer_len - offset;
+        }
+
+        uint32_t const written = stream_write_framing(segment, segment_len);
+        if (written == 0) {
+            // TX buffer full, resume on the next task iteration
+            return;
+        }
+        g_dso_state.stream_tx_offset += written;
+    }
+}
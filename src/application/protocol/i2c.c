@@ -0,0 +1,416 @@
+/**
+ * @file i2c.c
+ * @brief I2C bus pass-through SCPI commands implementation
+ *
+ * This module implements the BUS:I2C command tree, which reads and writes
+ * bursts of registers of targets on the I2C bus. The bus is initialized by
+ * the first command that needs it and released by a reset.
+ *
+ * Writes are queued and the command returns at once, so a series of them
+ * goes out back to back. Their failures are reported by the next I2C
+ * command. A read is queued behind the writes and answers once it is done,
+ * so other commands wait for it.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lib/scpi/error.h"
+#include "lib/scpi/scpi.h"
+
+#include "system/bus/i2c.h"
+#include "system/system.h"
+#include "util/error.h"
+#include "util/logging.h"
+
+enum {
+    I2C_BURST_MAX = 32, // Bytes per read or write command
+    I2C_WRITE_SLOTS = 4, // Writes that can be in flight at once
+    I2C_REG_SIZE_DEFAULT = 1, // Bytes of register address
+    READ_TIMEOUT = 1000, // ms for the queue ahead of a read and the read
+};
+
+// Deferred query responses, implemented in common.c
+extern scpi_result_t
+protocol_defer(scpi_t *context, scpi_command_callback_t resume);
+
+/**
+ * @brief A queued write with its own copy of the data
+ */
+typedef struct {
+    I2C_Transaction transaction;
+    uint8_t data[I2C_BURST_MAX];
+} WriteSlot;
+
+// I2C state (internal to this module)
+static struct {
+    I2C_Handle *handle;
+    uint32_t speed; // Hz
+    uint8_t reg_size;
+    WriteSlot writes[I2C_WRITE_SLOTS];
+    I2C_Transaction read;
+    uint8_t read_data[I2C_BURST_MAX];
+    uint32_t read_start; // Tick the read was queued at
+    bool volatile write_failed; // Set from interrupt context
+} g_i2c_state = {
+    .handle = nullptr,
+    .speed = I2C_SPEED_DEFAULT,
+    .reg_size = I2C_REG_SIZE_DEFAULT,
+};
+
+/**
+ * @brief Release the bus, which cancels the queued transactions
+ */
+static void release_handle(void)
+{
+    if (g_i2c_state.handle) {
+        I2C_deinit(g_i2c_state.handle);
+        g_i2c_state.handle = nullptr;
+    }
+}
+
+/**
+ * @brief Reset I2C state to default values
+ */
+void i2c_reset_state(void)
+{
+    release_handle();
+    g_i2c_state.speed = I2C_SPEED_DEFAULT;
+    g_i2c_state.reg_size = I2C_REG_SIZE_DEFAULT;
+    g_i2c_state.write_failed = false;
+}
+
+/**
+ * @brief Note a failed write, for the next command to report
+ */
+static void write_complete(I2C_Transaction *transaction)
+{
+    if (transaction->status != I2C_STATUS_OK &&
+        transaction->status != I2C_STATUS_CANCELLED) {
+        g_i2c_state.write_failed = true;
+    }
+}
+
+/**
+ * @brief Report writes that failed since the previous command
+ */
+static void report_write_errors(scpi_t *context)
+{
+    if (g_i2c_state.write_failed) {
+        g_i2c_state.write_failed = false;
+        LOG_WARN("I2C write failed");
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+    }
+}
+
+/**
+ * @brief Initialize the bus on first use
+ */
+static bool acquire_handle(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+
+    if (g_i2c_state.handle) {
+        return true;
+    }
+
+    TRY
+    {
+        g_i2c_state.handle = I2C_init(0);
+        if (g_i2c_state.speed != I2C_SPEED_DEFAULT) {
+            I2C_set_speed(g_i2c_state.handle, g_i2c_state.speed);
+        }
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("I2C init error: 0x%08X", err);
+        release_handle();
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Read the target address and, if any, the register address
+ */
+static bool param_target(scpi_t *context, uint8_t *address, uint16_t *reg)
+{
+    uint32_t value = 0;
+
+    if (!SCPI_ParamUInt32(context, &value, true)) {
+        return false;
+    }
+    if (value > I2C_ADDRESS_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return false;
+    }
+    *address = (uint8_t)value;
+
+    *reg = 0;
+    if (g_i2c_state.reg_size == 0) {
+        return true;
+    }
+    if (!SCPI_ParamUInt32(context, &value, true)) {
+        return false;
+    }
+    if (value >> (8 * g_i2c_state.reg_size) != 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return false;
+    }
+    *reg = (uint16_t)value;
+    return true;
+}
+
+/**
+ * @brief End a command on an error thrown by I2C_submit
+ */
+static scpi_result_t submit_error(scpi_t *context, Error err)
+{
+    LOG_ERROR("I2C submit error: 0x%08X", err);
+    SCPI_ErrorPush(
+        context,
+        err == ERROR_RESOURCE_BUSY ? SCPI_ERROR_EXECUTION_ERROR
+                                   : SCPI_ERROR_SYSTEM_ERROR
+    );
+    return SCPI_RES_ERR;
+}
+
+/**
+ * @brief BUS:I2C:FREQuency - Set the clock rate of the bus
+ *
+ * Syntax: BUS:I2C:FREQuency <Hz>
+ *
+ * Refused while transactions are queued.
+ */
+scpi_result_t scpi_cmd_bus_i2c_frequency(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    uint32_t speed = 0;
+
+    report_write_errors(context);
+    if (!SCPI_ParamUInt32(context, &speed, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (speed < I2C_SPEED_MIN || speed > I2C_SPEED_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    if (g_i2c_state.handle) {
+        TRY { I2C_set_speed(g_i2c_state.handle, speed); }
+        CATCH(err)
+        {
+            LOG_ERROR("I2C speed error: 0x%08X", err);
+            SCPI_ErrorPush(
+                context,
+                err == ERROR_RESOURCE_BUSY ? SCPI_ERROR_EXECUTION_ERROR
+                                           : SCPI_ERROR_SYSTEM_ERROR
+            );
+            return SCPI_RES_ERR;
+        }
+    }
+    g_i2c_state.speed = speed;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief BUS:I2C:FREQuency? - Query the clock rate in Hz
+ */
+scpi_result_t scpi_cmd_bus_i2c_frequency_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_i2c_state.speed);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief BUS:I2C:REGister:SIZE - Set the bytes of register address
+ *
+ * Syntax: BUS:I2C:REGister:SIZE <0|1|2>
+ *
+ * 1 suits most sensors and 2 larger EEPROMs. With 0 the commands take no
+ * register address and move the data alone.
+ */
+scpi_result_t scpi_cmd_bus_i2c_register_size(scpi_t *context)
+{
+    uint32_t size = 0;
+
+    if (!SCPI_ParamUInt32(context, &size, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (size > 2) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    g_i2c_state.reg_size = (uint8_t)size;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief BUS:I2C:REGister:SIZE? - Query the bytes of register address
+ */
+scpi_result_t scpi_cmd_bus_i2c_register_size_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_i2c_state.reg_size);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief BUS:I2C:WRITe - Queue a write of consecutive registers
+ *
+ * Syntax: BUS:I2C:WRITe <address>,<register>,<byte>{,<byte>}
+ *
+ * Returns before the write is done. Up to I2C_WRITE_SLOTS writes can be in
+ * flight; once they are, the command is refused until one completes.
+ */
+scpi_result_t scpi_cmd_bus_i2c_write(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    uint8_t address = 0;
+    uint16_t reg = 0;
+    uint8_t data[I2C_BURST_MAX];
+    uint32_t size = 0;
+    uint32_t value = 0;
+
+    report_write_errors(context);
+    if (!param_target(context, &address, &reg)) {
+        return SCPI_RES_ERR;
+    }
+    while (SCPI_ParamUInt32(context, &value, size == 0)) {
+        if (size == I2C_BURST_MAX || value > UINT8_MAX) {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        }
+        data[size] = (uint8_t)value;
+        size += 1;
+    }
+    // Missing or malformed bytes have been reported by the parser
+    if (size == 0 || SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    WriteSlot *slot = nullptr;
+    for (uint32_t i = 0; i < I2C_WRITE_SLOTS; i++) {
+        if (g_i2c_state.writes[i].transaction.status != I2C_STATUS_PENDING) {
+            slot = &g_i2c_state.writes[i];
+            break;
+        }
+    }
+    if (!slot) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    if (!acquire_handle(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    for (uint32_t i = 0; i < size; i++) {
+        slot->data[i] = data[i];
+    }
+    slot->transaction = (I2C_Transaction){
+        .address = address,
+        .read = false,
+        .reg = reg,
+        .reg_size = g_i2c_state.reg_size,
+        .data = slot->data,
+        .size = size,
+        .callback = write_complete,
+    };
+
+    TRY { I2C_submit(g_i2c_state.handle, &slot->transaction); }
+    CATCH(err) { return submit_error(context, err); }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Answer a read once it is done
+ */
+static scpi_result_t finish_read(scpi_t *context)
+{
+    // Ended by a reset
+    if (!g_i2c_state.handle) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    I2C_Status const status = g_i2c_state.read.status;
+    if (status == I2C_STATUS_PENDING) {
+        // The controller has no timeout of its own for a target that
+        // holds the clock low
+        if (SYSTEM_get_tick() - g_i2c_state.read_start > READ_TIMEOUT) {
+            LOG_ERROR("I2C read timeout");
+            release_handle();
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+        return protocol_defer(context, finish_read);
+    }
+
+    report_write_errors(context);
+    if (status != I2C_STATUS_OK) {
+        LOG_ERROR("I2C read failed: %d", (int)status);
+        SCPI_ErrorPush(
+            context,
+            status == I2C_STATUS_NACK ? SCPI_ERROR_EXECUTION_ERROR
+                                      : SCPI_ERROR_SYSTEM_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultArrayUInt8(
+        context,
+        g_i2c_state.read_data,
+        g_i2c_state.read.size,
+        SCPI_FORMAT_ASCII
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief BUS:I2C:READ? - Read consecutive registers
+ *
+ * Syntax: BUS:I2C:READ? <address>,<register>,<count>
+ *
+ * Runs after the writes queued before it, and answers the bytes read,
+ * separated by commas. A target that does not acknowledge gives an
+ * execution error.
+ */
+scpi_result_t scpi_cmd_bus_i2c_read_q(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    uint8_t address = 0;
+    uint16_t reg = 0;
+    uint32_t count = 0;
+
+    if (!param_target(context, &address, &reg) ||
+        !SCPI_ParamUInt32(context, &count, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (count == 0 || count > I2C_BURST_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    // A read whose query was dropped may still be on the bus
+    if (g_i2c_state.read.status == I2C_STATUS_PENDING) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    if (!acquire_handle(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    g_i2c_state.read = (I2C_Transaction){
+        .address = address,
+        .read = true,
+        .reg = reg,
+        .reg_size = g_i2c_state.reg_size,
+        .data = g_i2c_state.read_data,
+        .size = count,
+    };
+
+    TRY { I2C_submit(g_i2c_state.handle, &g_i2c_state.read); }
+    CATCH(err) { return submit_error(context, err); }
+
+    g_i2c_state.read_start = SYSTEM_get_tick();
+    return finish_read(context);
+}
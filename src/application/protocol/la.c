@@ -0,0 +1,468 @@
+/**
+ * @file la.c
+ * @brief Logic analyzer SCPI commands implementation
+ *
+ * This module implements the LA command tree, which mirrors the
+ * OSCilloscope tree for configuration, acquisition and data transfer. Each
+ * sample is one byte, bit n holding digital input n. Run-length captures
+ * are fetched as their LA_Run records, four bytes each.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lib/scpi/error.h"
+#include "lib/scpi/scpi.h"
+
+#include "system/instrument/la.h"
+#include "system/system.h"
+#include "util/error.h"
+#include "util/logging.h"
+#include "util/si_prefix.h"
+
+enum {
+    LA_BUFFER_SIZE = 32768, // Sample memory, bytes
+    POINTS_DEFAULT = 1024,
+    SAMPLE_RATE_DEFAULT = 1000000, // Hz
+    FETCH_TIMEOUT_MARGIN = 1000, // ms allowed beyond the capture duration
+};
+
+// Host output, deferred query responses and overlapped commands,
+// implemented in common.c
+extern void
+protocol_result_block(scpi_t *context, uint8_t const *data, uint32_t len);
+extern scpi_result_t
+protocol_defer(scpi_t *context, scpi_command_callback_t resume);
+extern bool protocol_is_resuming(void);
+extern void protocol_operation_pending(bool (*done)(void), uint32_t timeout);
+
+static uint8_t g_la_buffer[LA_BUFFER_SIZE] __attribute__((aligned(32)));
+
+/**
+ * @brief Settings the logic analyzer is initialized with
+ */
+typedef struct {
+    uint32_t sample_rate; // Requested until applied, then achieved
+    uint32_t points; // Samples, or runs, per capture
+    LA_Storage storage;
+    uint8_t trigger_mask;
+    uint8_t trigger_pattern;
+} Settings;
+
+#define SETTINGS_DEFAULT                                                       \
+    {                                                                          \
+        .sample_rate = SAMPLE_RATE_DEFAULT, .points = POINTS_DEFAULT,          \
+        .storage = LA_STORAGE_RAW, .trigger_mask = 0, .trigger_pattern = 0,    \
+    }
+
+// LA state (internal to this module)
+static struct {
+    LA_Handle *handle;
+    Settings settings;
+    bool volatile acquisition_complete;
+    bool started; // A capture was started since the last configuration
+    uint32_t fetch_start; // Tick when a fetch started waiting
+} g_la_state = {
+    .handle = nullptr,
+    .settings = SETTINGS_DEFAULT,
+};
+
+static void la_complete_callback(void)
+{
+    g_la_state.acquisition_complete = true;
+}
+
+/**
+ * @brief Release the logic analyzer, keeping its settings
+ */
+static void release_handle(void)
+{
+    if (g_la_state.handle) {
+        LA_deinit(g_la_state.handle);
+        g_la_state.handle = nullptr;
+    }
+    g_la_state.acquisition_complete = false;
+    g_la_state.started = false;
+}
+
+/**
+ * @brief Reset LA state to default values
+ */
+void la_reset_state(void)
+{
+    release_handle();
+    g_la_state.settings = (Settings)SETTINGS_DEFAULT;
+}
+
+/**
+ * @brief Largest capture, in samples or runs, the buffer holds
+ */
+static uint32_t points_max(LA_Storage storage)
+{
+    return storage == LA_STORAGE_RLE ? LA_BUFFER_SIZE / sizeof(LA_Run)
+                                     : LA_BUFFER_SIZE;
+}
+
+/**
+ * @brief (Re)initialize the logic analyzer with the given settings
+ *
+ * The previous settings are kept if the new ones cannot be applied.
+ */
+static scpi_result_t
+apply_config(scpi_t *context, Settings const *settings)
+{
+    Error err = ERROR_NONE;
+    LA_Handle *handle = nullptr;
+
+    if (g_la_state.handle && LA_is_running(g_la_state.handle)) {
+        // Can't change configuration while acquisition is in progress
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    release_handle();
+
+    LA_Config config = LA_CONFIG_DEFAULT;
+    config.sample_rate = settings->sample_rate;
+    config.buffer = g_la_buffer;
+    config.buffer_size = settings->points;
+    config.complete_callback = la_complete_callback;
+    config.storage = settings->storage;
+    config.trigger_mask = settings->trigger_mask;
+    config.trigger_pattern = settings->trigger_pattern;
+
+    TRY { handle = LA_init(&config); }
+    CATCH(err)
+    {
+        LOG_ERROR("LA init error: 0x%08X", err);
+        SCPI_ErrorPush(
+            context,
+            err == ERROR_INVALID_ARGUMENT ? SCPI_ERROR_ILLEGAL_PARAMETER_VALUE
+                                          : SCPI_ERROR_EXECUTION_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+
+    g_la_state.handle = handle;
+    g_la_state.settings = *settings;
+    g_la_state.settings.sample_rate = LA_get_config(handle).sample_rate;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LA:CONFigure:ACQuire:SRATe - Set the sample rate
+ *
+ * Syntax: LA:CONFigure:ACQuire:SRATe <Hz>
+ *
+ * The timer cannot reach most rates exactly; LA:CONF:ACQ:SRAT? returns the
+ * rate achieved. A trigger or run-length storage lowers the highest rate to
+ * LA_SAMPLE_RATE_MAX_PROCESSED.
+ */
+scpi_result_t scpi_cmd_configure_la_acquire_srate(scpi_t *context)
+{
+    uint32_t rate = 0;
+
+    if (!SCPI_ParamUInt32(context, &rate, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    if (rate == 0 || rate > LA_SAMPLE_RATE_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    Settings settings = g_la_state.settings;
+    settings.sample_rate = rate;
+    return apply_config(context, &settings);
+}
+
+/**
+ * @brief LA:CONFigure:ACQuire:SRATe? - Query the sample rate in Hz
+ */
+scpi_result_t scpi_cmd_configure_la_acquire_srate_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_la_state.settings.sample_rate);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LA:CONFigure:ACQuire:POINts - Set the samples per capture
+ *
+ * Syntax: LA:CONFigure:ACQuire:POINts <n>
+ *
+ * With run-length storage, the number of runs per capture.
+ */
+scpi_result_t scpi_cmd_configure_la_acquire_points(scpi_t *context)
+{
+    uint32_t points = 0;
+
+    if (!SCPI_ParamUInt32(context, &points, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    if (points == 0 || points > points_max(g_la_state.settings.storage)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    Settings settings = g_la_state.settings;
+    settings.points = points;
+    return apply_config(context, &settings);
+}
+
+/**
+ * @brief LA:CONFigure:ACQuire:POINts? - Query the samples per capture
+ */
+scpi_result_t scpi_cmd_configure_la_acquire_points_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_la_state.settings.points);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LA:CONFigure:ACQuire:POINts:MAXimum? - Query the largest capture
+ */
+scpi_result_t scpi_cmd_configure_la_acquire_points_max_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, points_max(g_la_state.settings.storage));
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LA:CONFigure:ACQuire:STORage - Set how captures are stored
+ *
+ * Syntax: LA:CONFigure:ACQuire:STORage <RAW|RLE>
+ *
+ * RAW stores one byte per sample. RLE stores a run of equal samples in
+ * four bytes, so that a capture of a mostly idle bus is much longer. The
+ * points are clamped to the largest capture of the new storage.
+ */
+scpi_result_t scpi_cmd_configure_la_acquire_storage(scpi_t *context)
+{
+    scpi_choice_def_t const storage_choices[] = {
+        { "RAW", LA_STORAGE_RAW },
+        { "RLE", LA_STORAGE_RLE },
+        SCPI_CHOICE_LIST_END
+    };
+
+    int32_t storage_choice = -1;
+
+    if (!SCPI_ParamChoice(context, storage_choices, &storage_choice, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    Settings settings = g_la_state.settings;
+    settings.storage = (LA_Storage)storage_choice;
+    if (settings.points > points_max(settings.storage)) {
+        settings.points = points_max(settings.storage);
+    }
+    return apply_config(context, &settings);
+}
+
+/**
+ * @brief LA:CONFigure:ACQuire:STORage? - Query how captures are stored
+ *
+ * Returns RAW or RLE.
+ */
+scpi_result_t scpi_cmd_configure_la_acquire_storage_q(scpi_t *context)
+{
+    SCPI_ResultMnemonic(
+        context, g_la_state.settings.storage == LA_STORAGE_RLE ? "RLE" : "RAW"
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LA:TRIGger:PATTern - Set the trigger pattern
+ *
+ * Syntax: LA:TRIGger:PATTern <mask>,<pattern>
+ *
+ * A capture starts at the first sample in which the inputs set in mask
+ * change to their levels in pattern; with one input in mask, that is an
+ * edge. A mask of 0 starts captures at once.
+ */
+scpi_result_t scpi_cmd_trigger_la_pattern(scpi_t *context)
+{
+    uint32_t mask = 0;
+    uint32_t pattern = 0;
+
+    if (!SCPI_ParamUInt32(context, &mask, true) ||
+        !SCPI_ParamUInt32(context, &pattern, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    if (mask > UINT8_MAX || (pattern & ~mask) != 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    Settings settings = g_la_state.settings;
+    settings.trigger_mask = (uint8_t)mask;
+    settings.trigger_pattern = (uint8_t)pattern;
+    return apply_config(context, &settings);
+}
+
+/**
+ * @brief LA:TRIGger:PATTern? - Query the trigger mask and pattern
+ */
+scpi_result_t scpi_cmd_trigger_la_pattern_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_la_state.settings.trigger_mask);
+    SCPI_ResultUInt32(context, g_la_state.settings.trigger_pattern);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Whether the capture of LA:INITiate is over
+ */
+static bool capture_done(void)
+{
+    return !g_la_state.handle || !LA_is_running(g_la_state.handle);
+}
+
+/**
+ * @brief Longest a fetch waits for the capture, in milliseconds
+ *
+ * For run-length captures, the shortest duration the runs can take.
+ */
+static uint32_t fetch_timeout(void)
+{
+    Settings const *const settings = &g_la_state.settings;
+    uint64_t const duration =
+        ((uint64_t)settings->points * SI_MILLI_DIV) / settings->sample_rate;
+    return (uint32_t)duration + FETCH_TIMEOUT_MARGIN;
+}
+
+/**
+ * @brief LA:INITiate - Start a capture
+ *
+ * Overlapped: *OPC, *OPC? and *WAI wait for the capture, for as long as
+ * FETCh would.
+ */
+scpi_result_t scpi_cmd_initiate_la(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+
+    if (!g_la_state.handle) {
+        scpi_result_t const result =
+            apply_config(context, &g_la_state.settings);
+        if (result != SCPI_RES_OK) {
+            return result;
+        }
+    }
+
+    g_la_state.acquisition_complete = false;
+    TRY { LA_start(g_la_state.handle); }
+    CATCH(err)
+    {
+        LOG_ERROR("LA start error: 0x%08X", err);
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+    g_la_state.started = true;
+
+    protocol_operation_pending(capture_done, fetch_timeout());
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LA:ABORt - Abort a capture and release the logic analyzer
+ */
+scpi_result_t scpi_cmd_abort_la(scpi_t *context)
+{
+    (void)context;
+
+    release_handle();
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Send the capture as an arbitrary block
+ */
+static void send_capture(scpi_t *context)
+{
+    // Sent in place, the TX buffer is much smaller than a capture
+    uint32_t const size =
+        g_la_state.settings.storage == LA_STORAGE_RLE
+            ? LA_get_runs(g_la_state.handle) * sizeof(LA_Run)
+            : LA_get_samples_acquired(g_la_state.handle);
+    protocol_result_block(context, g_la_buffer, size);
+}
+
+/**
+ * @brief LA:FETCh[:DATa]? - Fetch the captured samples
+ *
+ * Waits for a running capture to complete, then returns the samples as an
+ * arbitrary block of one byte per sample, or of the LA_Run records of a
+ * run-length capture. A run-length capture of a bus too idle to fill the
+ * buffer in time is stopped, and the runs stored so far are returned.
+ */
+scpi_result_t scpi_cmd_fetch_la_data_q(scpi_t *context)
+{
+    if (!g_la_state.handle || !g_la_state.started) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    // If acquisition is still in progress, answer once it completes
+    if (LA_is_running(g_la_state.handle)) {
+        uint32_t const now = SYSTEM_get_tick();
+
+        if (!protocol_is_resuming()) {
+            g_la_state.fetch_start = now;
+        } else if (now - g_la_state.fetch_start > fetch_timeout()) {
+            LA_stop(g_la_state.handle);
+            if (LA_get_runs(g_la_state.handle) > 0) {
+                send_capture(context);
+                return SCPI_RES_OK;
+            }
+            LOG_ERROR("LA acquisition timeout - stopping acquisition");
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+        return protocol_defer(context, scpi_cmd_fetch_la_data_q);
+    }
+
+    if (!g_la_state.acquisition_complete) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    send_capture(context);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief LA:READ? - Start a capture and fetch its samples
+ */
+scpi_result_t scpi_cmd_read_la_q(scpi_t *context)
+{
+    scpi_result_t const result = scpi_cmd_initiate_la(context);
+    if (result != SCPI_RES_OK) {
+        return result;
+    }
+    return scpi_cmd_fetch_la_data_q(context);
+}
+
+/**
+ * @brief LA:STATus:ACQuisition? - Query acquisition status
+ *
+ * Returns:
+ * 0 - No acquisition started
+ * 1 - Acquisition in progress, or waiting for the trigger
+ * 2 - Acquisition complete
+ */
+scpi_result_t scpi_cmd_status_la_acquisition_q(scpi_t *context)
+{
+    uint32_t status = 0;
+
+    if (g_la_state.handle && LA_is_running(g_la_state.handle)) {
+        status = 1;
+    } else if (g_la_state.acquisition_complete) {
+        status = 2;
+    }
+
+    SCPI_ResultUInt32(context, status);
+    return SCPI_RES_OK;
+}
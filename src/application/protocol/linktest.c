@@ -0,0 +1,326 @@
+/**
+ * @file linktest.c
+ * @brief USB link throughput self-test
+ *
+ * SYSTem:TEST:USB fills the TX buffer of the USB bulk data interface with a
+ * generated pattern on every pass of the protocol task, for as long as the
+ * test runs, so that the link is measured at the rate the bus layer sends
+ * and without any instrument in the way. Optionally, the device also sinks
+ * what the host sends on the bulk interface and checks it against the same
+ * pattern.
+ *
+ * The pattern is a sequence of 32-bit little-endian words:
+ * - COUNter: 0, 1, 2, ...
+ * - PRBS: the xorshift32 sequence x ^= x << 13, x ^= x >> 17, x ^= x << 5,
+ *   starting from 1; each word is the state after a step, so that the
+ *   first is 0x00042021
+ *
+ * Each word follows from the one before it, so the receiver resynchronizes
+ * on the word after a mismatch: a gap in the data counts as one error, a
+ * corrupted word as two, rather than one per word after them.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lib/scpi/error.h"
+#include "lib/scpi/scpi.h"
+
+#include "system/system.h"
+#include "util/si_prefix.h"
+
+enum {
+    WORD_SIZE = sizeof(uint32_t),
+    CHUNK_WORDS = 16, // Words generated per bulk write
+    DURATION_MAX = 3600, // Longest test, in seconds
+};
+
+typedef enum {
+    PATTERN_COUNTER,
+    PATTERN_PRBS,
+} Pattern;
+
+// Bulk interface access, implemented in common.c
+extern bool protocol_bulk_open(void);
+extern uint32_t protocol_read_bulk(uint8_t *data, uint32_t len);
+extern uint32_t protocol_write_bulk(uint8_t const *data, uint32_t len);
+extern uint32_t protocol_bulk_tx_free(void);
+extern void protocol_operation_pending(bool (*done)(void), uint32_t timeout);
+
+// Other users of the bulk interface
+extern bool dso_stream_on_bulk(void);
+extern bool binary_is_enabled(void);
+
+// Link test state (internal to this module)
+static struct {
+    bool running;
+    bool sink;
+    Pattern pattern;
+    uint32_t start; // Tick at which the test started
+    uint32_t duration; // In ms
+    uint32_t elapsed; // In ms, kept once the test is over
+    uint32_t tx_word; // Next word to send
+    uint32_t rx_word; // Next word expected from the host
+    uint64_t tx_bytes;
+    uint64_t rx_bytes;
+    uint32_t errors;
+    uint32_t rx_len; // Bytes of a partial word received so far
+    uint8_t rx[WORD_SIZE];
+} g_linktest = { .running = false };
+
+/**
+ * @brief Get the word that follows a word of the pattern
+ */
+static uint32_t next_word(Pattern pattern, uint32_t word)
+{
+    if (pattern == PATTERN_COUNTER) {
+        return word + 1;
+    }
+
+    word ^= word << 13;
+    word ^= word >> 17;
+    word ^= word << 5;
+    return word;
+}
+
+static uint32_t first_word(Pattern pattern)
+{
+    return pattern == PATTERN_COUNTER ? 0 : next_word(PATTERN_PRBS, 1);
+}
+
+static void stop(void)
+{
+    if (!g_linktest.running) {
+        return;
+    }
+    g_linktest.elapsed = SYSTEM_get_tick() - g_linktest.start;
+    g_linktest.running = false;
+}
+
+static bool test_done(void) { return !g_linktest.running; }
+
+/**
+ * @brief Reset link test state, the bulk interface is closed
+ */
+void linktest_reset_state(void)
+{
+    g_linktest.running = false;
+    g_linktest.elapsed = 0;
+    g_linktest.tx_bytes = 0;
+    g_linktest.rx_bytes = 0;
+    g_linktest.errors = 0;
+}
+
+/**
+ * @brief Check whether the link test holds the bulk interface
+ */
+bool linktest_running(void) { return g_linktest.running; }
+
+/**
+ * @brief Fill the bulk TX buffer with as many pattern words as fit
+ */
+static void send_pattern(void)
+{
+    uint32_t chunk[CHUNK_WORDS];
+    uint32_t free = protocol_bulk_tx_free() / WORD_SIZE;
+
+    while (free > 0) {
+        uint32_t const count = free < CHUNK_WORDS ? free : CHUNK_WORDS;
+        uint32_t word = g_linktest.tx_word;
+        for (uint32_t i = 0; i < count; ++i) {
+            chunk[i] = word; // The Cortex-M33 is little-endian
+            word = next_word(g_linktest.pattern, word);
+        }
+
+        uint32_t const written =
+            protocol_write_bulk((uint8_t const *)chunk, count * WORD_SIZE);
+        if (written != count * WORD_SIZE) {
+            // Checked free space first, so this is not expected
+            break;
+        }
+        g_linktest.tx_word = word;
+        g_linktest.tx_bytes += written;
+        free -= count;
+    }
+}
+
+/**
+ * @brief Check one word received from the host
+ */
+static void check_word(uint32_t word)
+{
+    if (word != g_linktest.rx_word) {
+        ++g_linktest.errors;
+    }
+    g_linktest.rx_word = next_word(g_linktest.pattern, word);
+}
+
+/**
+ * @brief Read what the host sent, checking it if the test sinks it
+ */
+static void receive_pattern(void)
+{
+    uint8_t buffer[CHUNK_WORDS * WORD_SIZE];
+    uint32_t len = 0;
+
+    while ((len = protocol_read_bulk(buffer, sizeof(buffer))) > 0) {
+        if (!g_linktest.sink) {
+            continue;
+        }
+        g_linktest.rx_bytes += len;
+        for (uint32_t i = 0; i < len; ++i) {
+            g_linktest.rx[g_linktest.rx_len++] = buffer[i];
+            if (g_linktest.rx_len < WORD_SIZE) {
+                continue;
+            }
+            g_linktest.rx_len = 0;
+            check_word(
+                (uint32_t)g_linktest.rx[0] | (uint32_t)g_linktest.rx[1] << 8 |
+                (uint32_t)g_linktest.rx[2] << 16 |
+                (uint32_t)g_linktest.rx[3] << 24
+            );
+        }
+    }
+}
+
+/**
+ * @brief Run the link test, called from protocol_task
+ */
+void linktest_task(void)
+{
+    if (!g_linktest.running) {
+        return;
+    }
+
+    // An oscilloscope stream started on the bulk interface takes it over
+    if (dso_stream_on_bulk() ||
+        SYSTEM_get_tick() - g_linktest.start >= g_linktest.duration) {
+        stop();
+        return;
+    }
+
+    receive_pattern();
+    send_pattern();
+}
+
+/**
+ * @brief SYSTem:TEST:USB - Start the USB link throughput test
+ *
+ * Parameters: COUNter|PRBS, the duration in seconds and, optionally,
+ * whether to sink and check the host data (OFF by default). Fails while
+ * the bulk interface carries an oscilloscope stream or the binary protocol.
+ */
+scpi_result_t scpi_cmd_system_test_usb(scpi_t *context)
+{
+    scpi_choice_def_t const pattern_choices[] = {
+        { "COUNter", PATTERN_COUNTER },
+        { "PRBS", PATTERN_PRBS },
+        SCPI_CHOICE_LIST_END
+    };
+
+    int32_t pattern = -1;
+    uint32_t duration = 0;
+    scpi_bool_t sink = false;
+
+    if (!SCPI_ParamChoice(context, pattern_choices, &pattern, true) ||
+        !SCPI_ParamUInt32(context, &duration, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    (void)SCPI_ParamBool(context, &sink, false);
+    if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (duration == 0 || duration > DURATION_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    if (g_linktest.running || dso_stream_on_bulk() || binary_is_enabled() ||
+        !protocol_bulk_open()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    // Drop host data left from whatever used the interface before
+    uint8_t stale[CHUNK_WORDS * WORD_SIZE];
+    while (protocol_read_bulk(stale, sizeof(stale)) > 0) {
+    }
+
+    g_linktest.pattern = (Pattern)pattern;
+    g_linktest.sink = sink;
+    g_linktest.duration = duration * SI_MILLI_DIV;
+    g_linktest.tx_word = first_word(g_linktest.pattern);
+    g_linktest.rx_word = first_word(g_linktest.pattern);
+    g_linktest.rx_len = 0;
+    g_linktest.tx_bytes = 0;
+    g_linktest.rx_bytes = 0;
+    g_linktest.errors = 0;
+    g_linktest.elapsed = 0;
+    g_linktest.start = SYSTEM_get_tick();
+    g_linktest.running = true;
+
+    // *OPC and *WAI see the test through, with a second to spare
+    protocol_operation_pending(test_done, g_linktest.duration + SI_MILLI_DIV);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SYSTem:TEST:USB:STOP - End the link test early
+ */
+scpi_result_t scpi_cmd_system_test_usb_stop(scpi_t *context)
+{
+    (void)context; // Unused parameter
+
+    stop();
+    return SCPI_RES_OK;
+}
+
+static uint64_t per_second(uint64_t bytes, uint32_t elapsed)
+{
+    return elapsed == 0 ? 0 : bytes * SI_MILLI_DIV / elapsed;
+}
+
+/**
+ * @brief Get the device to host rate of the last complete link test
+ *
+ * @return Bytes/s, 0 while a test runs or if none has run since the reset
+ */
+uint32_t linktest_tx_rate(void)
+{
+    if (g_linktest.running) {
+        return 0;
+    }
+    uint64_t const rate = per_second(g_linktest.tx_bytes, g_linktest.elapsed);
+    return rate > UINT32_MAX ? UINT32_MAX : (uint32_t)rate;
+}
+
+/**
+ * @brief SYSTem:TEST:USB? - Query the link test results
+ *
+ * Returns whether the test runs, the time it has run in ms, the bytes sent
+ * and their rate in bytes/s, the bytes received and their rate, and the
+ * number of errors in the received data. The figures of the last test stay
+ * until the next one starts.
+ */
+scpi_result_t scpi_cmd_system_test_usb_q(scpi_t *context)
+{
+    uint32_t const elapsed = g_linktest.running
+                                 ? SYSTEM_get_tick() - g_linktest.start
+                                 : g_linktest.elapsed;
+    uint64_t const values[] = {
+        g_linktest.running ? 1 : 0,
+        elapsed,
+        g_linktest.tx_bytes,
+        per_second(g_linktest.tx_bytes, elapsed),
+        g_linktest.rx_bytes,
+        per_second(g_linktest.rx_bytes, elapsed),
+        g_linktest.errors,
+    };
+
+    SCPI_ResultArrayUInt64(
+        context, values, sizeof(values) / sizeof(values[0]), SCPI_FORMAT_ASCII
+    );
+    return SCPI_RES_OK;
+}
@@ -0,0 +1,289 @@
+/**
+ * @file power.c
+ * @brief Power meter SCPI commands implementation
+ *
+ * This module implements the POWer command tree. The meter takes the
+ * ADC to itself from POWer:INITiate until POWer:ABORt, accumulating on the
+ * device, and POWer:FETCh? answers with the accumulated values only, so
+ * that a run of many hours costs the host one query whenever it wants an
+ * update.
+ *
+ * Results are integers in micro-units, which keep the resolution of long
+ * runs without floating-point formatting.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lib/scpi/error.h"
+#include "lib/scpi/scpi.h"
+
+#include "system/instrument/power.h"
+#include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/logging.h"
+#include "util/si_prefix.h"
+
+// Host output, in common.c
+extern void protocol_result_int32_ascii(
+    scpi_t *context,
+    int32_t const *values,
+    size_t count
+);
+
+// Power meter state (internal to this module)
+static struct {
+    POWER_Handle *handle;
+    POWER_Config config;
+} g_power_state = {
+    .handle = nullptr,
+    .config = POWER_CONFIG_DEFAULT,
+};
+
+static void release_handle(void)
+{
+    if (g_power_state.handle) {
+        POWER_deinit(g_power_state.handle);
+        g_power_state.handle = nullptr;
+    }
+}
+
+/**
+ * @brief Reset power meter state to default values
+ */
+void power_reset_state(void)
+{
+    release_handle();
+    g_power_state.config = (POWER_Config)POWER_CONFIG_DEFAULT;
+}
+
+/**
+ * @brief Refuse to change the configuration under a running meter
+ */
+static bool check_stopped(scpi_t *context)
+{
+    if (g_power_state.handle) {
+        SCPI_ErrorPush(context, SCPI_ERROR_SETTINGS_CONFLICT);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Millionths of a Q16.16 value, rounded to nearest
+ */
+static int32_t to_millionths(FIXED_Q1616 value)
+{
+    int64_t const scaled = (int64_t)value * (int64_t)SI_MICRO_DIV;
+    int64_t const half = FIXED_SCALE / 2;
+    return (int32_t)((scaled + (scaled >= 0 ? half : -half)) / FIXED_SCALE);
+}
+
+/**
+ * @brief POWer:CONFigure - Set the channels and the sample rate
+ *
+ * Syntax: POWer:CONFigure <voltage channel>,<current channel>[,<rate>]
+ *
+ * The voltage channel is converted on ADC1 and the current channel on
+ * ADC2 at the same instant, rate pairs per second (default: 10000).
+ */
+scpi_result_t scpi_cmd_power_configure(scpi_t *context)
+{
+    uint32_t voltage_channel = 0;
+    uint32_t current_channel = 0;
+    uint32_t rate = g_power_state.config.sample_rate;
+
+    if (!SCPI_ParamUInt32(context, &voltage_channel, true) ||
+        !SCPI_ParamUInt32(context, &current_channel, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (!SCPI_ParamUInt32(context, &rate, false) &&
+        SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+    if (!check_stopped(context)) {
+        return SCPI_RES_ERR;
+    }
+    if (voltage_channel > POWER_CHANNEL_MAX ||
+        current_channel > POWER_CHANNEL_MAX ||
+        voltage_channel == current_channel || rate < POWER_RATE_MIN ||
+        rate > POWER_RATE_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_power_state.config.voltage_channel = voltage_channel;
+    g_power_state.config.current_channel = current_channel;
+    g_power_state.config.sample_rate = rate;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief POWer:CONFigure? - Query the channels and the sample rate
+ */
+scpi_result_t scpi_cmd_power_configure_q(scpi_t *context)
+{
+    POWER_Config const *config = &g_power_state.config;
+
+    SCPI_ResultUInt32(context, config->voltage_channel);
+    SCPI_ResultUInt32(context, config->current_channel);
+    SCPI_ResultUInt32(context, config->sample_rate);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief POWer:SCALe - Set the scaling of the two inputs
+ *
+ * Syntax: POWer:SCALe <voltage gain>,<current gain>[,<current zero>]
+ *
+ * Takes the volts across the load per volt at the voltage input and the
+ * amperes through it per volt at the current input, both in parts per
+ * million, and the current input voltage at zero current in microvolts
+ * (default: 0).
+ */
+scpi_result_t scpi_cmd_power_scale(scpi_t *context)
+{
+    int32_t voltage_gain = 0;
+    int32_t current_gain = 0;
+    int32_t current_zero = 0;
+
+    if (!SCPI_ParamInt32(context, &voltage_gain, true) ||
+        !SCPI_ParamInt32(context, &current_gain, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (!SCPI_ParamInt32(context, &current_zero, false) &&
+        SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+    if (!check_stopped(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    FIXED_Q1616 const voltage =
+        FIXED_from_fraction(voltage_gain, (int32_t)SI_MICRO_DIV);
+    FIXED_Q1616 const current =
+        FIXED_from_fraction(current_gain, (int32_t)SI_MICRO_DIV);
+    FIXED_Q1616 const zero =
+        FIXED_from_fraction(current_zero, (int32_t)SI_MICRO_DIV);
+    if (voltage <= 0 || current <= 0 || zero < 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_power_state.config.voltage_gain = voltage;
+    g_power_state.config.current_gain = current;
+    g_power_state.config.current_zero = zero;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief POWer:SCALe? - Query the scaling of the two inputs
+ */
+scpi_result_t scpi_cmd_power_scale_q(scpi_t *context)
+{
+    POWER_Config const *config = &g_power_state.config;
+    int32_t const results[] = {
+        to_millionths(config->voltage_gain),
+        to_millionths(config->current_gain),
+        to_millionths(config->current_zero),
+    };
+    size_t const count = sizeof(results) / sizeof(results[0]);
+
+    protocol_result_int32_ascii(context, results, count);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief POWer:INITiate - Start accumulating afresh
+ *
+ * Restarts a running meter with the current configuration.
+ */
+scpi_result_t scpi_cmd_power_initiate(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+
+    release_handle();
+    TRY { g_power_state.handle = POWER_init(&g_power_state.config); }
+    CATCH(err)
+    {
+        LOG_ERROR("POWER init error: 0x%08X", err);
+        g_power_state.handle = nullptr;
+        // Another instrument holds the ADC
+        SCPI_ErrorPush(
+            context,
+            err == ERROR_RESOURCE_BUSY ? SCPI_ERROR_EXECUTION_ERROR
+                                       : SCPI_ERROR_SYSTEM_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief POWer:ABORt - Stop the meter and release the ADC
+ *
+ * The accumulated values are lost.
+ */
+scpi_result_t scpi_cmd_power_abort(scpi_t *context)
+{
+    (void)context; // Unused parameter
+
+    release_handle();
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief POWer:CLEar - Start accumulating afresh, without a gap
+ */
+scpi_result_t scpi_cmd_power_clear(scpi_t *context)
+{
+    if (!g_power_state.handle) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    POWER_clear(g_power_state.handle);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief POWer:STATe? - Query whether the meter is running
+ */
+scpi_result_t scpi_cmd_power_state_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_power_state.handle != nullptr);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief POWer:FETCh? - Query the values accumulated so far
+ *
+ * Returns the time accumulated in ms, the mean and RMS voltage in
+ * microvolts, the mean and RMS current in microamperes, the mean power in
+ * microwatts, the energy in microwatt-hours and the charge in
+ * microampere-hours.
+ */
+scpi_result_t scpi_cmd_power_fetch_q(scpi_t *context)
+{
+    POWER_Reading reading = { 0 };
+
+    if (!g_power_state.handle) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    POWER_read(g_power_state.handle, &reading);
+    uint64_t elapsed = 0; // ms
+    if (reading.sample_rate > 0) {
+        elapsed = reading.samples * SI_MILLI_DIV / reading.sample_rate;
+    }
+    SCPI_ResultUInt64(context, elapsed);
+    SCPI_ResultInt64(context, reading.voltage_mean);
+    SCPI_ResultInt64(context, reading.voltage_rms);
+    SCPI_ResultInt64(context, reading.current_mean);
+    SCPI_ResultInt64(context, reading.current_rms);
+    SCPI_ResultInt64(context, reading.power_mean);
+    SCPI_ResultInt64(context, reading.energy);
+    SCPI_ResultInt64(context, reading.charge);
+    return SCPI_RES_OK;
+}
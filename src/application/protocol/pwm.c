@@ -0,0 +1,327 @@
+/**
+ * @file pwm.c
+ * @brief PWM generator SCPI commands implementation
+ *
+ * This module implements the PWM command tree. The settings are kept while
+ * the output is off. While it is on, a new frequency reinitializes the
+ * generator, and a new pulse of one channel is loaded at the end of its
+ * period, without disturbing the other.
+ *
+ * Channels are numbered from 1. Duty cycles and phases are in parts per
+ * million of the period.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lib/scpi/error.h"
+#include "lib/scpi/scpi.h"
+
+#include "system/instrument/pwm.h"
+#include "util/error.h"
+#include "util/logging.h"
+
+// PWM state (internal to this module)
+static struct {
+    PWM_Handle *handle;
+    PWM_Config config; // Requested until applied, then achieved
+    bool output;
+} g_pwm_state = {
+    .handle = nullptr,
+    .config = PWM_CONFIG_DEFAULT,
+    .output = false,
+};
+
+/**
+ * @brief Release the generator, which stops the outputs
+ */
+static void release_handle(void)
+{
+    if (g_pwm_state.handle) {
+        PWM_deinit(g_pwm_state.handle);
+        g_pwm_state.handle = nullptr;
+    }
+}
+
+/**
+ * @brief Reset PWM state to default values
+ */
+void pwm_reset_state(void)
+{
+    release_handle();
+    g_pwm_state.config = (PWM_Config)PWM_CONFIG_DEFAULT;
+    g_pwm_state.output = false;
+}
+
+/**
+ * @brief Run the outputs with the given configuration, if on
+ *
+ * The previous configuration is kept if the new one cannot be applied, and
+ * the output is then off.
+ */
+static scpi_result_t
+apply_config(scpi_t *context, PWM_Config const *config, bool output)
+{
+    Error err = ERROR_NONE;
+    PWM_Handle *handle = nullptr;
+
+    release_handle();
+    g_pwm_state.output = false;
+    if (!output) {
+        g_pwm_state.config = *config;
+        return SCPI_RES_OK;
+    }
+
+    TRY { handle = PWM_init(config); }
+    CATCH(err)
+    {
+        LOG_ERROR("PWM init error: 0x%08X", err);
+        SCPI_ErrorPush(
+            context,
+            err == ERROR_INVALID_ARGUMENT ? SCPI_ERROR_ILLEGAL_PARAMETER_VALUE
+                                          : SCPI_ERROR_EXECUTION_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+    TRY { PWM_start(handle); }
+    CATCH(err)
+    {
+        LOG_ERROR("PWM start error: 0x%08X", err);
+        PWM_deinit(handle);
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_pwm_state.handle = handle;
+    g_pwm_state.config = PWM_get_config(handle);
+    g_pwm_state.output = true;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Read a channel number, from 1, into an index
+ */
+static bool param_channel(scpi_t *context, uint32_t *index)
+{
+    uint32_t channel = 0;
+
+    if (!SCPI_ParamUInt32(context, &channel, true)) {
+        return false;
+    }
+    if (channel == 0 || channel > PWM_CHANNEL_COUNT) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return false;
+    }
+    *index = channel - 1;
+    return true;
+}
+
+/**
+ * @brief Apply a new pulse to one channel
+ *
+ * While the output is on the running generator takes it at the end of the
+ * period.
+ */
+static scpi_result_t
+apply_channel(scpi_t *context, uint32_t index, PWM_Channel const *channel)
+{
+    Error err = ERROR_NONE;
+
+    if (!g_pwm_state.handle) {
+        g_pwm_state.config.channels[index] = *channel;
+        return SCPI_RES_OK;
+    }
+
+    TRY { PWM_set_channel(g_pwm_state.handle, index, channel); }
+    CATCH(err)
+    {
+        LOG_ERROR("PWM channel error: 0x%08X", err);
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    g_pwm_state.config.channels[index] = *channel;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief PWM:FREQuency - Set the frequency of all channels
+ *
+ * Syntax: PWM:FREQuency <Hz>
+ */
+scpi_result_t scpi_cmd_pwm_frequency(scpi_t *context)
+{
+    uint32_t frequency = 0;
+
+    if (!SCPI_ParamUInt32(context, &frequency, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (frequency < PWM_FREQUENCY_MIN || frequency > PWM_FREQUENCY_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    PWM_Config config = g_pwm_state.config;
+    config.frequency = frequency;
+    return apply_config(context, &config, g_pwm_state.output);
+}
+
+/**
+ * @brief PWM:FREQuency? - Query the frequency in Hz
+ *
+ * While the output is on, returns the frequency achieved.
+ */
+scpi_result_t scpi_cmd_pwm_frequency_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_pwm_state.config.frequency);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief PWM:DUTY - Set the duty cycle of a channel
+ *
+ * Syntax: PWM:DUTY <channel>,<ppm>
+ *
+ * 0 holds the channel low and 1000000 high.
+ */
+scpi_result_t scpi_cmd_pwm_duty(scpi_t *context)
+{
+    uint32_t index = 0;
+    uint32_t duty = 0;
+
+    if (!param_channel(context, &index) ||
+        !SCPI_ParamUInt32(context, &duty, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (duty > PWM_PPM_FULL) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    PWM_Channel channel = g_pwm_state.config.channels[index];
+    channel.duty = duty;
+    return apply_channel(context, index, &channel);
+}
+
+/**
+ * @brief PWM:DUTY? - Query the duty cycle of a channel in ppm
+ *
+ * Syntax: PWM:DUTY? <channel>
+ */
+scpi_result_t scpi_cmd_pwm_duty_q(scpi_t *context)
+{
+    uint32_t index = 0;
+
+    if (!param_channel(context, &index)) {
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32(context, g_pwm_state.config.channels[index].duty);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief PWM:PHASe - Set the delay of a channel's rising edge
+ *
+ * Syntax: PWM:PHASe <channel>,<ppm>
+ *
+ * The delay is from the start of the period all channels share, so two
+ * channels with phases 0 and 250000 are in quadrature.
+ */
+scpi_result_t scpi_cmd_pwm_phase(scpi_t *context)
+{
+    uint32_t index = 0;
+    uint32_t phase = 0;
+
+    if (!param_channel(context, &index) ||
+        !SCPI_ParamUInt32(context, &phase, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (phase >= PWM_PPM_FULL) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    PWM_Channel channel = g_pwm_state.config.channels[index];
+    channel.phase = phase;
+    return apply_channel(context, index, &channel);
+}
+
+/**
+ * @brief PWM:PHASe? - Query the phase of a channel in ppm
+ *
+ * Syntax: PWM:PHASe? <channel>
+ */
+scpi_result_t scpi_cmd_pwm_phase_q(scpi_t *context)
+{
+    uint32_t index = 0;
+
+    if (!param_channel(context, &index)) {
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt32(context, g_pwm_state.config.channels[index].phase);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief PWM:ENABle - Drive a channel or leave it undriven
+ *
+ * Syntax: PWM:ENABle <channel>,<ON|OFF|1|0>
+ */
+scpi_result_t scpi_cmd_pwm_enable(scpi_t *context)
+{
+    uint32_t index = 0;
+    scpi_bool_t enabled = false;
+
+    if (!param_channel(context, &index) ||
+        !SCPI_ParamBool(context, &enabled, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    PWM_Channel channel = g_pwm_state.config.channels[index];
+    channel.enabled = enabled;
+    return apply_channel(context, index, &channel);
+}
+
+/**
+ * @brief PWM:ENABle? - Query whether a channel is driven
+ *
+ * Syntax: PWM:ENABle? <channel>
+ */
+scpi_result_t scpi_cmd_pwm_enable_q(scpi_t *context)
+{
+    uint32_t index = 0;
+
+    if (!param_channel(context, &index)) {
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultBool(context, g_pwm_state.config.channels[index].enabled);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief PWM:OUTPut[:STATe] - Switch the outputs on or off
+ *
+ * Syntax: PWM:OUTPut[:STATe] <ON|OFF|1|0>
+ *
+ * Off, the timer is released and the pins float.
+ */
+scpi_result_t scpi_cmd_pwm_output(scpi_t *context)
+{
+    scpi_bool_t output = false;
+
+    if (!SCPI_ParamBool(context, &output, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    PWM_Config const config = g_pwm_state.config;
+    return apply_config(context, &config, output);
+}
+
+/**
+ * @brief PWM:OUTPut[:STATe]? - Query whether the outputs are on
+ */
+scpi_result_t scpi_cmd_pwm_output_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_pwm_state.output);
+    return SCPI_RES_OK;
+}
@@ -0,0 +1,515 @@
+/**
+ * @file sequence.c
+ * @brief Sequence engine SCPI commands implementation
+ *
+ * This module implements the SEQuence command tree, which runs a program
+ * of SCPI command lines on the instrument, without a host round trip per
+ * step, e.g. for the steps of a production test. A program is uploaded
+ * with SEQuence:DEFine and started with SEQuence:RUN; protocol_task then
+ * feeds it to the parser a line at a time, each once the line before has
+ * completed, deferred queries and *WAI included. SEQuence:WAIT and
+ * SEQuence:LIMit are steps of their own, for delays and for limit checks
+ * of the response before.
+ *
+ * The responses of the program go to a result table instead of the host,
+ * a row per line that answered, which SEQuence:RESult? sends once the
+ * program has ended. Host input waits while a line runs; in between, host
+ * commands run as usual, so that the state of the program may be polled.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lib/scpi/error.h"
+#include "lib/scpi/scpi.h"
+
+#include "system/system.h"
+#include "util/format.h"
+
+enum {
+    PROGRAM_MAX = 2048, // Bytes of program text
+    RESULTS_MAX = 2048, // Bytes of the result table
+    VERDICT_LENGTH = 4, // "NONE", "PASS" or "FAIL"
+    WAIT_MAX = 86400000, // ms, a day
+    LINES_PER_PASS = 16, // Lines run back to back in one protocol_task pass
+};
+
+// Program states, see SEQuence:STATe?
+typedef enum {
+    SEQUENCE_IDLE,
+    SEQUENCE_RUN,
+    SEQUENCE_DONE,
+    SEQUENCE_ERROR,
+    SEQUENCE_ABORTED,
+} SequenceState;
+
+// Parser access and host output, implemented in common.c
+extern void
+protocol_result_block(scpi_t *context, uint8_t const *data, uint32_t len);
+extern uint32_t protocol_block_streamed(void);
+extern void
+protocol_block_receive(void *destination, scpi_command_callback_t complete);
+extern bool protocol_input_idle(void);
+extern void protocol_run_line(char const *line, uint32_t len);
+
+// Mnemonics of SEQuence:STATe?, in SequenceState order
+static char const *const g_STATE_NAMES[] = {
+    "IDLE", "RUN", "DONE", "ERR", "ABOR",
+};
+
+// Sequence state (internal to this module)
+static struct {
+    SequenceState state;
+    char program[PROGRAM_MAX];
+    uint32_t length; // Bytes of the program
+    uint32_t streamed; // Bytes of the program being received
+    uint32_t next; // Offset of the next line in the program
+    uint32_t line; // Number of the line run last, from 1
+    uint32_t steps; // Lines run since SEQuence:RUN
+    bool stepping; // A line runs, and its responses go to the table
+    int32_t errors; // Error queue count before the line
+    bool overflow; // A response of the line did not fit the table
+    bool waiting; // SEQuence:WAIT delays the next line
+    uint32_t wait_start; // Tick the delay began at
+    uint32_t wait_ms;
+    // Held until the block has been sent, see protocol_result_block
+    char results[RESULTS_MAX];
+    uint32_t results_length;
+    uint32_t row; // Offset of the last row in the table
+    uint32_t verdict; // Offset of its verdict
+    uint32_t row_step; // Steps at which the last row was written, 0 if none
+    uint32_t failures; // Rows with a FAIL verdict
+} g_sequence = { .state = SEQUENCE_IDLE };
+
+/**
+ * @brief Clear the result table
+ */
+static void clear_results(void)
+{
+    g_sequence.results_length = 0;
+    g_sequence.row_step = 0;
+    g_sequence.failures = 0;
+}
+
+/**
+ * @brief Stop the program, keeping its results
+ */
+static void stop(SequenceState state)
+{
+    g_sequence.state = state;
+    g_sequence.waiting = false;
+}
+
+/**
+ * @brief Reset sequence state to default values
+ *
+ * A running program stops and its results are cleared; the program stays
+ * defined. A *RST line of the program itself leaves it running.
+ */
+void sequence_reset_state(void)
+{
+    if (g_sequence.stepping) {
+        return;
+    }
+    stop(SEQUENCE_IDLE);
+    clear_results();
+    g_sequence.line = 0;
+}
+
+/**
+ * @brief Check whether the responses of the parser go to the result table
+ */
+bool sequence_capturing(void) { return g_sequence.stepping; }
+
+/**
+ * @brief Check whether a program is running, or its last line has yet to end
+ */
+bool sequence_running(void)
+{
+    return g_sequence.state == SEQUENCE_RUN || g_sequence.stepping;
+}
+
+/**
+ * @brief Append response output of the running line to the result table
+ *
+ * The first output of a line starts its row, "<line>,NONE,", which the
+ * response then completes up to its line ending.
+ *
+ * @return Number of bytes taken, all of them unless the table is full
+ */
+size_t sequence_write(char const *data, size_t len)
+{
+    if (g_sequence.overflow) {
+        return 0;
+    }
+
+    if (g_sequence.row_step != g_sequence.steps) {
+        char prefix[FORMAT_UINT32_SIZE_MAX + VERDICT_LENGTH + 2];
+        size_t length = FORMAT_uint32(g_sequence.line, prefix);
+        memcpy(&prefix[length], ",NONE,", VERDICT_LENGTH + 2);
+        length += VERDICT_LENGTH + 2;
+        if (length + len > RESULTS_MAX - g_sequence.results_length) {
+            g_sequence.overflow = true;
+            return 0;
+        }
+        g_sequence.row = g_sequence.results_length;
+        g_sequence.verdict = g_sequence.row + (uint32_t)length -
+                             (VERDICT_LENGTH + 1);
+        g_sequence.row_step = g_sequence.steps;
+        memcpy(&g_sequence.results[g_sequence.results_length], prefix, length);
+        g_sequence.results_length += (uint32_t)length;
+    }
+
+    if (len > RESULTS_MAX - g_sequence.results_length) {
+        // Drop the partial row
+        g_sequence.results_length = g_sequence.row;
+        g_sequence.row_step = 0;
+        g_sequence.overflow = true;
+        return 0;
+    }
+    memcpy(&g_sequence.results[g_sequence.results_length], data, len);
+    g_sequence.results_length += (uint32_t)len;
+    return len;
+}
+
+/**
+ * @brief Find the next line of the program that is not blank
+ *
+ * @param[out] length Length of the line, without its line ending
+ * @return Start of the line, nullptr at the end of the program
+ */
+static char const *next_line(uint32_t *length)
+{
+    while (g_sequence.next < g_sequence.length) {
+        char const *const line = &g_sequence.program[g_sequence.next];
+        uint32_t const left = g_sequence.length - g_sequence.next;
+        char const *const end = memchr(line, '\n', left);
+        uint32_t len = end ? (uint32_t)(end - line) : left;
+
+        g_sequence.next += end ? len + 1 : len;
+        g_sequence.line++;
+        if (len > 0 && line[len - 1] == '\r') {
+            --len;
+        }
+        for (uint32_t i = 0; i < len; ++i) {
+            if (line[i] != ' ' && line[i] != '\t') {
+                *length = len;
+                return line;
+            }
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Finish the running line, stopping the program if it failed
+ */
+static void end_step(scpi_t *context)
+{
+    g_sequence.stepping = false;
+    if (g_sequence.overflow) {
+        g_sequence.overflow = false;
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+    }
+    if (SCPI_ErrorCount(context) > g_sequence.errors &&
+        g_sequence.state == SEQUENCE_RUN) {
+        stop(SEQUENCE_ERROR);
+    }
+}
+
+/**
+ * @brief Run the lines of a running program, from protocol_task
+ *
+ * A line starts once the parser is free of host input and the line before
+ * has completed, and its delay, if any, is over.
+ *
+ * @param context SCPI context, to count the errors of the lines
+ */
+void sequence_task(scpi_t *context)
+{
+    if (g_sequence.stepping) {
+        if (!protocol_input_idle()) {
+            return;
+        }
+        end_step(context);
+    }
+
+    for (uint32_t i = 0; i < LINES_PER_PASS; ++i) {
+        if (g_sequence.state != SEQUENCE_RUN) {
+            return;
+        }
+        if (g_sequence.waiting) {
+            uint32_t const waited = SYSTEM_get_tick() - g_sequence.wait_start;
+            if (waited < g_sequence.wait_ms) {
+                return;
+            }
+            g_sequence.waiting = false;
+        }
+        if (!protocol_input_idle()) {
+            return;
+        }
+
+        uint32_t length = 0;
+        char const *const line = next_line(&length);
+        if (!line) {
+            stop(SEQUENCE_DONE);
+            return;
+        }
+        g_sequence.steps++;
+        g_sequence.stepping = true;
+        g_sequence.errors = SCPI_ErrorCount(context);
+        protocol_run_line(line, length);
+        if (!protocol_input_idle()) {
+            return; // Ends in a later pass
+        }
+        end_step(context);
+    }
+}
+
+/**
+ * @brief Take the program received as a streamed block
+ */
+static scpi_result_t program_received(scpi_t *context)
+{
+    (void)context;
+
+    g_sequence.length = g_sequence.streamed;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SEQuence:DEFine - Upload the program
+ *
+ * The parameter is a definite length arbitrary block of command lines,
+ * separated by line feeds. A block too large for the SCPI input buffer is
+ * streamed into the program as it arrives.
+ */
+scpi_result_t scpi_cmd_sequence_define(scpi_t *context)
+{
+    char const *data = nullptr;
+    size_t size = 0;
+
+    if (!SCPI_ParamArbitraryBlock(context, &data, &size, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    if (g_sequence.state == SEQUENCE_RUN || g_sequence.stepping) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    uint32_t const streamed = protocol_block_streamed();
+    if (streamed > 0) {
+        size = streamed;
+    }
+    if (size > PROGRAM_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    sequence_reset_state();
+    g_sequence.length = 0;
+    if (streamed > 0) {
+        g_sequence.streamed = streamed;
+        protocol_block_receive(g_sequence.program, program_received);
+        return SCPI_RES_OK;
+    }
+    memcpy(g_sequence.program, data, size);
+    g_sequence.length = (uint32_t)size;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SEQuence:RUN - Run the program from its first line
+ */
+scpi_result_t scpi_cmd_sequence_run(scpi_t *context)
+{
+    if (g_sequence.state == SEQUENCE_RUN || g_sequence.stepping ||
+        g_sequence.length == 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    clear_results();
+    g_sequence.next = 0;
+    g_sequence.line = 0;
+    g_sequence.steps = 0;
+    g_sequence.waiting = false;
+    g_sequence.state = SEQUENCE_RUN;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SEQuence:ABORt - Stop the program, keeping its results
+ */
+scpi_result_t scpi_cmd_sequence_abort(scpi_t *context)
+{
+    (void)context;
+
+    if (g_sequence.state == SEQUENCE_RUN) {
+        stop(SEQUENCE_ABORTED);
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SEQuence:STATe? - Query the state of the program
+ */
+scpi_result_t scpi_cmd_sequence_state_q(scpi_t *context)
+{
+    SCPI_ResultMnemonic(context, g_STATE_NAMES[g_sequence.state]);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SEQuence:LINE? - Query the number of the line run last
+ *
+ * Points at the failed line once the state is ERR.
+ */
+scpi_result_t scpi_cmd_sequence_line_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_sequence.line);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SEQuence:WAIT - Delay the next line of the program
+ *
+ * Parameter is the delay in ms. Only runs as a line of a program.
+ */
+scpi_result_t scpi_cmd_sequence_wait(scpi_t *context)
+{
+    uint32_t wait_ms = 0;
+
+    if (!SCPI_ParamUInt32(context, &wait_ms, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    if (wait_ms > WAIT_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    if (!g_sequence.stepping) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_sequence.wait_start = SYSTEM_get_tick();
+    g_sequence.wait_ms = wait_ms;
+    g_sequence.waiting = true;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Read the integer a response in the table starts with
+ *
+ * @param offset Start of the response in the table
+ * @param[out] value Value, saturated to the int32_t range
+ * @return false if the response does not start with an integer
+ */
+static bool row_value(uint32_t offset, int32_t *value)
+{
+    char const *p = &g_sequence.results[offset];
+    char const *const end = &g_sequence.results[g_sequence.results_length];
+    bool negative = false;
+    int64_t magnitude = 0;
+
+    while (p < end && *p == ' ') {
+        ++p;
+    }
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p++ == '-';
+    }
+    char const *const digits = p;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        if (magnitude <= INT32_MAX) {
+            magnitude = (magnitude * 10) + (*p - '0');
+        }
+    }
+    if (p == digits ||
+        (p < end && *p != ',' && *p != ';' && *p != '\r' && *p != '\n')) {
+        return false;
+    }
+
+    int64_t const signed_value = negative ? -magnitude : magnitude;
+    *value = signed_value > INT32_MAX  ? INT32_MAX
+             : signed_value < INT32_MIN ? INT32_MIN
+                                        : (int32_t)signed_value;
+    return true;
+}
+
+/**
+ * @brief SEQuence:LIMit - Check the response of the line before
+ *
+ * Parameters are the lowest and highest value that pass. The row of the
+ * line before, or of this line, gets the verdict PASS if its response
+ * starts with an integer in the limits, FAIL otherwise. Only runs as a
+ * line of a program, after a query.
+ */
+scpi_result_t scpi_cmd_sequence_limit(scpi_t *context)
+{
+    int32_t low = 0;
+    int32_t high = 0;
+
+    if (!SCPI_ParamInt32(context, &low, true) ||
+        !SCPI_ParamInt32(context, &high, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    if (low > high) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    if (!g_sequence.stepping || g_sequence.row_step == 0 ||
+        g_sequence.row_step + 1 < g_sequence.steps) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    char *const verdict = &g_sequence.results[g_sequence.verdict];
+    int32_t value = 0;
+    bool const pass =
+        row_value(g_sequence.verdict + VERDICT_LENGTH + 1, &value) &&
+        value >= low && value <= high;
+
+    if (verdict[0] == 'F') {
+        g_sequence.failures--;
+    }
+    memcpy(verdict, pass ? "PASS" : "FAIL", VERDICT_LENGTH);
+    if (!pass) {
+        g_sequence.failures++;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SEQuence:RESult? - Query the result table
+ *
+ * Response is a definite length arbitrary block of rows
+ * "<line>,<verdict>,<response>" ending with the SCPI line ending, one per
+ * line of the program that answered.
+ */
+scpi_result_t scpi_cmd_sequence_result_q(scpi_t *context)
+{
+    if (g_sequence.stepping) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    protocol_result_block(
+        context,
+        (uint8_t const *)g_sequence.results,
+        g_sequence.results_length
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SEQuence:FAILures? - Query the number of rows that failed
+ */
+scpi_result_t scpi_cmd_sequence_failures_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_sequence.failures);
+    return SCPI_RES_OK;
+}
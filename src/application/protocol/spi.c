@@ -0,0 +1,339 @@
+/**
+ * @file spi.c
+ * @brief SPI bus pass-through SCPI commands implementation
+ *
+ * This module implements the BUS:SPI command tree, which exchanges blocks
+ * of bytes with a target on the SPI bus. The bus is initialized by the
+ * first command that needs it and released by a reset.
+ *
+ * A transfer sends a definite length arbitrary block and answers the bytes
+ * received meanwhile as another, once the DMA has moved them, so other
+ * commands wait for it. A transfer may keep the chip select low, so that
+ * a command longer than the SCPI input buffer, e.g. a flash page program,
+ * is sent as several transfers.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lib/scpi/error.h"
+#include "lib/scpi/scpi.h"
+
+#include "system/bus/spi.h"
+#include "system/system.h"
+#include "util/error.h"
+#include "util/logging.h"
+
+enum {
+    SPI_BLOCK_MAX = 512, // Bytes per transfer, the largest input buffer
+    TRANSFER_TIMEOUT = 100, // ms for a transfer, far longer than it takes
+};
+
+// Deferred query responses, implemented in common.c
+extern scpi_result_t
+protocol_defer(scpi_t *context, scpi_command_callback_t resume);
+
+static scpi_choice_def_t const g_ORDER_CHOICES[] = {
+    { "MSB", 0 },
+    { "LSB", 1 },
+    SCPI_CHOICE_LIST_END
+};
+
+// SPI state (internal to this module)
+static struct {
+    SPI_Handle *handle;
+    SPI_Config config; // Clock rate asked for until the bus is in use
+    SPI_Transaction transfer;
+    uint8_t data[SPI_BLOCK_MAX]; // Sent, then overwritten by the reply
+    uint32_t transfer_start; // Tick the transfer was queued at
+} g_spi_state = {
+    .handle = nullptr,
+    .config = {
+        .speed = SPI_SPEED_DEFAULT,
+        .mode = SPI_MODE_0,
+        .lsb_first = false,
+    },
+};
+
+/**
+ * @brief Release the bus, which cancels a transfer and the chip select
+ */
+static void release_handle(void)
+{
+    if (g_spi_state.handle) {
+        SPI_deinit(g_spi_state.handle);
+        g_spi_state.handle = nullptr;
+    }
+}
+
+/**
+ * @brief Reset SPI state to default values
+ */
+void spi_reset_state(void)
+{
+    release_handle();
+    g_spi_state.config = (SPI_Config){
+        .speed = SPI_SPEED_DEFAULT,
+        .mode = SPI_MODE_0,
+        .lsb_first = false,
+    };
+}
+
+/**
+ * @brief Initialize the bus on first use, with the settings made so far
+ */
+static bool acquire_handle(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    SPI_Config const config = g_spi_state.config;
+
+    if (g_spi_state.handle) {
+        return true;
+    }
+
+    TRY
+    {
+        g_spi_state.handle = SPI_init(0);
+        if (config.speed != SPI_SPEED_DEFAULT || config.mode != SPI_MODE_0 ||
+            config.lsb_first) {
+            SPI_configure(g_spi_state.handle, &config);
+        }
+        // With the clock rate reached
+        SPI_get_config(g_spi_state.handle, &g_spi_state.config);
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("SPI init error: 0x%08X", err);
+        release_handle();
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Apply new settings, at once if the bus is in use
+ *
+ * Refused while a transfer is pending or the chip select is held, since a
+ * new clock polarity would glitch the clock under a selected target.
+ */
+static scpi_result_t apply_config(scpi_t *context, SPI_Config const *config)
+{
+    Error err = ERROR_NONE;
+    SPI_Config applied = *config;
+
+    if (g_spi_state.handle) {
+        TRY { applied.speed = SPI_configure(g_spi_state.handle, config); }
+        CATCH(err)
+        {
+            LOG_ERROR("SPI config error: 0x%08X", err);
+            SCPI_ErrorPush(
+                context,
+                err == ERROR_RESOURCE_BUSY ? SCPI_ERROR_EXECUTION_ERROR
+                                           : SCPI_ERROR_SYSTEM_ERROR
+            );
+            return SCPI_RES_ERR;
+        }
+    }
+    g_spi_state.config = applied;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief BUS:SPI:FREQuency - Set the clock rate of the bus
+ *
+ * Syntax: BUS:SPI:FREQuency <Hz>
+ *
+ * The bus runs at the highest rate it reaches that does not exceed the
+ * one asked for.
+ */
+scpi_result_t scpi_cmd_bus_spi_frequency(scpi_t *context)
+{
+    uint32_t speed = 0;
+
+    if (!SCPI_ParamUInt32(context, &speed, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (speed < SPI_SPEED_MIN || speed > SPI_SPEED_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    SPI_Config config = g_spi_state.config;
+    config.speed = speed;
+    return apply_config(context, &config);
+}
+
+/**
+ * @brief BUS:SPI:FREQuency? - Query the clock rate in Hz
+ *
+ * Returns the rate reached once the bus is in use, and the one asked for
+ * before.
+ */
+scpi_result_t scpi_cmd_bus_spi_frequency_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_spi_state.config.speed);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief BUS:SPI:MODE - Set the clock polarity and phase
+ *
+ * Syntax: BUS:SPI:MODE <0|1|2|3>
+ */
+scpi_result_t scpi_cmd_bus_spi_mode(scpi_t *context)
+{
+    uint32_t mode = 0;
+
+    if (!SCPI_ParamUInt32(context, &mode, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (mode > SPI_MODE_3) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    SPI_Config config = g_spi_state.config;
+    config.mode = (SPI_Mode)mode;
+    return apply_config(context, &config);
+}
+
+/**
+ * @brief BUS:SPI:MODE? - Query the clock polarity and phase
+ */
+scpi_result_t scpi_cmd_bus_spi_mode_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, (uint32_t)g_spi_state.config.mode);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief BUS:SPI:ORDer - Set the bit order of each byte
+ *
+ * Syntax: BUS:SPI:ORDer <MSB|LSB>
+ */
+scpi_result_t scpi_cmd_bus_spi_order(scpi_t *context)
+{
+    int32_t order = -1;
+
+    if (!SCPI_ParamChoice(context, g_ORDER_CHOICES, &order, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    SPI_Config config = g_spi_state.config;
+    config.lsb_first = order == 1;
+    return apply_config(context, &config);
+}
+
+/**
+ * @brief BUS:SPI:ORDer? - Query the bit order of each byte
+ *
+ * Returns MSB or LSB.
+ */
+scpi_result_t scpi_cmd_bus_spi_order_q(scpi_t *context)
+{
+    SCPI_ResultMnemonic(context, g_spi_state.config.lsb_first ? "LSB" : "MSB");
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Answer a transfer once it is done
+ */
+static scpi_result_t finish_transfer(scpi_t *context)
+{
+    // Ended by a reset
+    if (!g_spi_state.handle) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    SPI_Status const status = g_spi_state.transfer.status;
+    if (status == SPI_STATUS_PENDING) {
+        if (SYSTEM_get_tick() - g_spi_state.transfer_start >
+            TRANSFER_TIMEOUT) {
+            LOG_ERROR("SPI transfer timeout");
+            release_handle();
+            SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+            return SCPI_RES_ERR;
+        }
+        return protocol_defer(context, finish_transfer);
+    }
+
+    if (status != SPI_STATUS_OK) {
+        LOG_ERROR("SPI transfer failed: %d", (int)status);
+        SCPI_ErrorPush(
+            context,
+            status == SPI_STATUS_CANCELLED ? SCPI_ERROR_EXECUTION_ERROR
+                                           : SCPI_ERROR_SYSTEM_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultArbitraryBlock(
+        context, (char const *)g_spi_state.data, g_spi_state.transfer.size
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief BUS:SPI:TRANsfer? - Exchange a block of bytes with the target
+ *
+ * Syntax: BUS:SPI:TRANsfer? <block>[,<hold>]
+ *
+ * Sends the bytes of a definite length arbitrary block, e.g.
+ * BUS:SPI:TRAN? #14<4 bytes>, and answers the bytes received meanwhile as
+ * a block of the same length. With hold ON the chip select stays low
+ * after the transfer, and the next one continues the same command; a
+ * failed transfer releases it, and the transfers that would have
+ * continued its command fail as well. The block must fit the SCPI input
+ * buffer along with the command.
+ */
+scpi_result_t scpi_cmd_bus_spi_transfer_q(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+    char const *data = nullptr;
+    size_t size = 0;
+    scpi_bool_t hold = false;
+
+    if (!SCPI_ParamArbitraryBlock(context, &data, &size, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    if (!SCPI_ParamBool(context, &hold, false) &&
+        SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+    if (size == 0 || size > SPI_BLOCK_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    // A transfer whose query was dropped may still be on the bus
+    if (g_spi_state.transfer.status == SPI_STATUS_PENDING) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    if (!acquire_handle(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    memcpy(g_spi_state.data, data, size);
+    g_spi_state.transfer = (SPI_Transaction){
+        .tx = g_spi_state.data,
+        .rx = g_spi_state.data,
+        .size = (uint32_t)size,
+        .hold_cs = hold,
+    };
+
+    TRY { SPI_submit(g_spi_state.handle, &g_spi_state.transfer); }
+    CATCH(err)
+    {
+        LOG_ERROR("SPI submit error: 0x%08X", err);
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_spi_state.transfer_start = SYSTEM_get_tick();
+    return finish_transfer(context);
+}
@@ -0,0 +1,385 @@
+/**
+ * @file sweep.c
+ * @brief Frequency response sweep SCPI commands implementation
+ *
+ * This module implements the SWEep command tree. The settings apply to
+ * the next SWEep:INITiate; the sweep then runs on the device, taking the
+ * waveform generator and the oscilloscope until it is done, and
+ * SWEep:DATA? answers with the table of points measured so far.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lib/scpi/error.h"
+#include "lib/scpi/scpi.h"
+
+#include "system/instrument/wavegen.h"
+#include "system/sweep.h"
+#include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/logging.h"
+#include "util/si_prefix.h"
+
+enum {
+    VOLTAGE_MAX = WAVEGEN_REFERENCE_MV, // mV, of amplitude and offset
+};
+
+// Host output and overlapped operations, implemented in common.c
+extern void
+protocol_result_block(scpi_t *context, uint8_t const *data, uint32_t len);
+extern void protocol_operation_pending(bool (*done)(void), uint32_t timeout);
+
+// SWEep:DATA? sends the points as they are stored
+static_assert(sizeof(SWEEP_Point) == 12, "SWEEP_Point must be 12 bytes");
+
+// Mnemonics of SWEep:STATe?, in SWEEP_State order
+static char const *const g_STATE_NAMES[] = {
+    "IDLE",
+    "RUN",
+    "DONE",
+    "ERR",
+};
+
+static scpi_choice_def_t const g_SPACING_CHOICES[] = {
+    { "LINear", 0 },
+    { "LOGarithmic", 1 },
+    SCPI_CHOICE_LIST_END
+};
+
+// Sweep settings (internal to this module)
+static struct {
+    SWEEP_Config config;
+    bool started; // A sweep was started since the last reset
+} g_sweep_state = {
+    .config = SWEEP_CONFIG_DEFAULT,
+    .started = false,
+};
+
+/**
+ * @brief Reset sweep state to default values
+ */
+void sweep_reset_state(void)
+{
+    if (g_sweep_state.started) {
+        SWEEP_stop();
+        g_sweep_state.started = false;
+    }
+    g_sweep_state.config = (SWEEP_Config)SWEEP_CONFIG_DEFAULT;
+}
+
+/**
+ * @brief Check whether the sweep has ended, for *OPC
+ */
+static bool sweep_done(void)
+{
+    SWEEP_Status status = { 0 };
+
+    SWEEP_get_status(&status);
+    return status.state != SWEEP_STATE_RUNNING;
+}
+
+/**
+ * @brief Millivolts of a Q16.16 voltage, rounded to nearest
+ */
+static int32_t to_millivolts(FIXED_Q1616 volts)
+{
+    int64_t const scaled = (int64_t)volts * (int64_t)SI_MILLI_DIV;
+    return (int32_t)((scaled + (FIXED_SCALE / 2)) / FIXED_SCALE);
+}
+
+/**
+ * @brief SWEep:FREQuency - Set the first and last frequency
+ *
+ * Syntax: SWEep:FREQuency <start>,<stop>
+ *
+ * In Hz, from 1 to 62500; the sweep runs downwards if stop is below
+ * start.
+ */
+scpi_result_t scpi_cmd_sweep_frequency(scpi_t *context)
+{
+    uint32_t start = 0;
+    uint32_t stop = 0;
+
+    if (!SCPI_ParamUInt32(context, &start, true) ||
+        !SCPI_ParamUInt32(context, &stop, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (start < SWEEP_FREQUENCY_MIN || start > SWEEP_FREQUENCY_MAX ||
+        stop < SWEEP_FREQUENCY_MIN || stop > SWEEP_FREQUENCY_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_sweep_state.config.start = start;
+    g_sweep_state.config.stop = stop;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:FREQuency? - Query the first and last frequency in Hz
+ */
+scpi_result_t scpi_cmd_sweep_frequency_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_sweep_state.config.start);
+    SCPI_ResultUInt32(context, g_sweep_state.config.stop);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:POINts - Set the number of points
+ *
+ * Syntax: SWEep:POINts <n>
+ *
+ * From 1 to 256; a single point is at the first frequency.
+ */
+scpi_result_t scpi_cmd_sweep_points(scpi_t *context)
+{
+    uint32_t points = 0;
+
+    if (!SCPI_ParamUInt32(context, &points, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (points == 0 || points > SWEEP_POINTS_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_sweep_state.config.points = points;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:POINts? - Query the number of points
+ */
+scpi_result_t scpi_cmd_sweep_points_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_sweep_state.config.points);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:SPACing - Set how the points are spaced
+ *
+ * Syntax: SWEep:SPACing <LINear|LOGarithmic>
+ */
+scpi_result_t scpi_cmd_sweep_spacing(scpi_t *context)
+{
+    int32_t spacing = -1;
+
+    if (!SCPI_ParamChoice(context, g_SPACING_CHOICES, &spacing, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    g_sweep_state.config.logarithmic = spacing != 0;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:SPACing? - Query how the points are spaced
+ *
+ * Returns LIN or LOG.
+ */
+scpi_result_t scpi_cmd_sweep_spacing_q(scpi_t *context)
+{
+    SCPI_ResultMnemonic(
+        context, g_sweep_state.config.logarithmic ? "LOG" : "LIN"
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:VOLTage - Set the stimulus's amplitude and offset
+ *
+ * Syntax: SWEep:VOLTage <amplitude>,<offset>
+ *
+ * In mV, from 0 to 3300, as by WAVegen:VOLTage:AMPLitude and
+ * WAVegen:VOLTage:OFFSet.
+ */
+scpi_result_t scpi_cmd_sweep_voltage(scpi_t *context)
+{
+    int32_t amplitude = 0;
+    int32_t offset = 0;
+
+    if (!SCPI_ParamInt32(context, &amplitude, true) ||
+        !SCPI_ParamInt32(context, &offset, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (amplitude < 0 || amplitude > VOLTAGE_MAX || offset < 0 ||
+        offset > VOLTAGE_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_sweep_state.config.amplitude =
+        FIXED_from_fraction(amplitude, (int32_t)SI_MILLI_DIV);
+    g_sweep_state.config.offset =
+        FIXED_from_fraction(offset, (int32_t)SI_MILLI_DIV);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:VOLTage? - Query the stimulus's amplitude and offset in mV
+ */
+scpi_result_t scpi_cmd_sweep_voltage_q(scpi_t *context)
+{
+    SCPI_ResultInt32(context, to_millivolts(g_sweep_state.config.amplitude));
+    SCPI_ResultInt32(context, to_millivolts(g_sweep_state.config.offset));
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:SETTle - Set the wait from each frequency to its capture
+ *
+ * Syntax: SWEep:SETTle <ms>
+ *
+ * From 0 to 10000, for the circuit's transient to die out.
+ */
+scpi_result_t scpi_cmd_sweep_settle(scpi_t *context)
+{
+    uint32_t settle = 0;
+
+    if (!SCPI_ParamUInt32(context, &settle, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (settle > SWEEP_SETTLE_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_sweep_state.config.settle = settle;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:SETTle? - Query the settling time in ms
+ */
+scpi_result_t scpi_cmd_sweep_settle_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_sweep_state.config.settle);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:CYCLes - Set the fewest periods captured per point
+ *
+ * Syntax: SWEep:CYCLes <n>
+ *
+ * From 1 to 64. More periods average out more noise, and take longer at
+ * low frequencies.
+ */
+scpi_result_t scpi_cmd_sweep_cycles(scpi_t *context)
+{
+    uint32_t cycles = 0;
+
+    if (!SCPI_ParamUInt32(context, &cycles, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (cycles == 0 || cycles > SWEEP_CYCLES_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    g_sweep_state.config.cycles = cycles;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:CYCLes? - Query the fewest periods captured per point
+ */
+scpi_result_t scpi_cmd_sweep_cycles_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_sweep_state.config.cycles);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:INITiate - Start a sweep
+ *
+ * The points of the previous sweep are dropped. *OPC waits for the sweep
+ * to end.
+ */
+scpi_result_t scpi_cmd_sweep_initiate(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+
+    TRY { SWEEP_start(&g_sweep_state.config); }
+    CATCH(err)
+    {
+        LOG_ERROR("SWEEP start error: 0x%08X", err);
+        // A sweep is running, or another instrument holds its own
+        SCPI_ErrorPush(
+            context,
+            err == ERROR_RESOURCE_BUSY ? SCPI_ERROR_EXECUTION_ERROR
+                                       : SCPI_ERROR_SYSTEM_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+    g_sweep_state.started = true;
+
+    // The sweep gives up by itself on a capture that does not complete
+    protocol_operation_pending(sweep_done, UINT32_MAX);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:ABORt - Stop a running sweep
+ *
+ * The points measured so far are kept.
+ */
+scpi_result_t scpi_cmd_sweep_abort(scpi_t *context)
+{
+    (void)context; // Unused parameter
+
+    SWEEP_stop();
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:STATe? - Query the sweep state
+ *
+ * Returns IDLE, RUN, DONE or ERR, the last if an instrument failed.
+ */
+scpi_result_t scpi_cmd_sweep_state_q(scpi_t *context)
+{
+    SWEEP_Status status = { 0 };
+
+    SWEEP_get_status(&status);
+    SCPI_ResultMnemonic(context, g_STATE_NAMES[status.state]);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:COUNt? - Query the points measured and the points in all
+ *
+ * Returns <measured>,<points>.
+ */
+scpi_result_t scpi_cmd_sweep_count_q(scpi_t *context)
+{
+    SWEEP_Status status = { 0 };
+
+    SWEEP_get_status(&status);
+    SCPI_ResultUInt32(context, status.completed);
+    SCPI_ResultUInt32(context, status.points);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief SWEep:DATA? - Query the points measured so far
+ *
+ * Answers a definite length arbitrary block of 12 bytes per point, in
+ * sweep order: the frequency in mHz as a uint32_t, the gain in 0.01 dB and
+ * the phase in 0.01 degree as int32_t, all little-endian.
+ */
+scpi_result_t scpi_cmd_sweep_data_q(scpi_t *context)
+{
+    uint32_t count = 0;
+    SWEEP_Point const *points = SWEEP_get_points(&count);
+
+    protocol_result_block(
+        context, (uint8_t const *)points, count * sizeof(SWEEP_Point)
+    );
+    return SCPI_RES_OK;
+}
@@ -0,0 +1,227 @@
+/**
+ * @file sync.c
+ * @brief Synchronized instrument start SCPI commands implementation
+ *
+ * This module implements the INITiate:ALL command tree. Once armed, the
+ * oscilloscope, logic analyzer, waveform generator and PWM generator are
+ * configured and started with their own commands, but wait; INITiate:ALL
+ * then starts them together. A reset drops the armed start.
+ *
+ * Boards sampling together are armed with INITiate:ALL:SOURce EXTernal;
+ * the board with INITiate:ALL:OUTPut ON then starts all of them with
+ * INITiate:ALL. With the OSCilloscope or MULTimeter source, INITiate:ALL
+ * hands the start to the oscilloscope trigger or the multimeter watch.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lib/scpi/error.h"
+#include "lib/scpi/scpi.h"
+
+#include "system/instrument/sync.h"
+#include "util/error.h"
+#include "util/logging.h"
+
+// Synchronized start state (internal to this module)
+static struct {
+    bool armed;
+    SYNC_Source source;
+    bool trigger_output;
+} g_sync_state = {
+    .armed = false,
+    .source = SYNC_SOURCE_IMMEDIATE,
+    .trigger_output = false,
+};
+
+// INITiate:ALL:SOURce? responses, by SYNC_Source
+static char const *const g_SOURCE_NAMES[] = {
+    [SYNC_SOURCE_IMMEDIATE] = "IMM",
+    [SYNC_SOURCE_EXTERNAL] = "EXT",
+    [SYNC_SOURCE_OSCILLOSCOPE] = "OSC",
+    [SYNC_SOURCE_MULTIMETER] = "MULT",
+};
+
+/**
+ * @brief Reset synchronized start state to default values
+ */
+void sync_reset_state(void)
+{
+    if (g_sync_state.armed) {
+        SYNC_cancel();
+        g_sync_state.armed = false;
+    }
+
+    Error err = ERROR_NONE;
+    TRY
+    {
+        if (g_sync_state.source != SYNC_SOURCE_IMMEDIATE) {
+            SYNC_set_source(SYNC_SOURCE_IMMEDIATE);
+            g_sync_state.source = SYNC_SOURCE_IMMEDIATE;
+        }
+        if (g_sync_state.trigger_output) {
+            SYNC_set_trigger_output(false);
+            g_sync_state.trigger_output = false;
+        }
+    }
+    CATCH(err) { LOG_ERROR("SYNC reset error: 0x%08X", err); }
+}
+
+/**
+ * @brief INITiate:ALL:ARM - Hold the starts of the instruments
+ *
+ * Syntax: INITiate:ALL:ARM [ON|OFF|1|0]
+ *
+ * OFF stops holding starts; instruments held so far wait until stopped or
+ * started again.
+ */
+scpi_result_t scpi_cmd_initiate_all_arm(scpi_t *context)
+{
+    scpi_bool_t arm = true;
+
+    if (!SCPI_ParamBool(context, &arm, false) &&
+        SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (arm) {
+        SYNC_arm();
+    } else {
+        SYNC_cancel();
+    }
+    g_sync_state.armed = arm;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief INITiate:ALL:ARM? - Query whether instrument starts are held
+ *
+ * With a source other than IMMediate, starts are held until its event,
+ * which may come from another board or instrument.
+ */
+scpi_result_t scpi_cmd_initiate_all_arm_q(scpi_t *context)
+{
+    if (g_sync_state.source != SYNC_SOURCE_IMMEDIATE) {
+        SCPI_ResultBool(context, SYNC_is_armed());
+    } else {
+        SCPI_ResultBool(context, g_sync_state.armed);
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief INITiate:ALL - Start the held instruments together
+ *
+ * Syntax: INITiate:ALL
+ *
+ * Their timers restart from zero within a few bus clocks of one another.
+ */
+scpi_result_t scpi_cmd_initiate_all(scpi_t *context)
+{
+    Error err = ERROR_NONE;
+
+    if (!g_sync_state.armed) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    // Any other start may still be waiting for its event, for *RST to drop
+    g_sync_state.armed = g_sync_state.source != SYNC_SOURCE_IMMEDIATE;
+    TRY { SYNC_start(); }
+    CATCH(err)
+    {
+        LOG_ERROR("SYNC start error: 0x%08X", err);
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief INITiate:ALL:SOURce - Set what starts the held instruments
+ *
+ * Syntax: INITiate:ALL:SOURce <IMMediate|EXTernal|OSCilloscope|MULTimeter>
+ *
+ * IMMediate starts them on INITiate:ALL. EXTernal starts them on a rising
+ * edge at the trigger input, so that boards sharing the edge start within
+ * the same few clocks. OSCilloscope and MULTimeter start them on the first
+ * oscilloscope trigger or multimeter watch crossing after INITiate:ALL.
+ * Not accepted while armed.
+ */
+scpi_result_t scpi_cmd_initiate_all_source(scpi_t *context)
+{
+    scpi_choice_def_t const source_choices[] = {
+        { "IMMediate", SYNC_SOURCE_IMMEDIATE },
+        { "EXTernal", SYNC_SOURCE_EXTERNAL },
+        { "OSCilloscope", SYNC_SOURCE_OSCILLOSCOPE },
+        { "MULTimeter", SYNC_SOURCE_MULTIMETER },
+        SCPI_CHOICE_LIST_END
+    };
+
+    int32_t source_choice = -1;
+    Error err = ERROR_NONE;
+
+    if (!SCPI_ParamChoice(context, source_choices, &source_choice, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    TRY { SYNC_set_source((SYNC_Source)source_choice); }
+    CATCH(err)
+    {
+        LOG_ERROR("SYNC source error: 0x%08X", err);
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    g_sync_state.source = (SYNC_Source)source_choice;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief INITiate:ALL:SOURce? - Query what starts the held instruments
+ *
+ * Returns IMM, EXT, OSC or MULT.
+ */
+scpi_result_t scpi_cmd_initiate_all_source_q(scpi_t *context)
+{
+    SCPI_ResultMnemonic(context, g_SOURCE_NAMES[g_sync_state.source]);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief INITiate:ALL:OUTPut - Drive the trigger output
+ *
+ * Syntax: INITiate:ALL:OUTPut <ON|OFF|1|0>
+ *
+ * The trigger output goes low on INITiate:ALL:ARM and high on
+ * INITiate:ALL. Not accepted while armed.
+ */
+scpi_result_t scpi_cmd_initiate_all_output(scpi_t *context)
+{
+    scpi_bool_t enable = false;
+    Error err = ERROR_NONE;
+
+    if (!SCPI_ParamBool(context, &enable, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    TRY { SYNC_set_trigger_output(enable); }
+    CATCH(err)
+    {
+        LOG_ERROR("SYNC trigger output error: 0x%08X", err);
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    g_sync_state.trigger_output = enable;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief INITiate:ALL:OUTPut? - Query whether the trigger output is driven
+ */
+scpi_result_t scpi_cmd_initiate_all_output_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_sync_state.trigger_output);
+    return SCPI_RES_OK;
+}
@@ -0,0 +1,544 @@
+/**
+ * @file wavegen.c
+ * @brief Waveform generator SCPI commands implementation
+ *
+ * This module implements the WAVegen command tree. The settings are kept
+ * while the output is off, and applied by reinitializing the generator
+ * whenever they change while it is on. Arbitrary waveforms are uploaded as
+ * DAC codes in parts, like firmware images, then take effect with
+ * WAVegen:DATA:POINts.
+ *
+ * The frequency is kept in millihertz, which DDS mode resolves; table mode
+ * rounds it to the Hz.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lib/scpi/error.h"
+#include "lib/scpi/scpi.h"
+
+#include "system/instrument/wavegen.h"
+#include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/logging.h"
+#include "util/si_prefix.h"
+
+enum {
+    FREQUENCY_DEFAULT = 1000 * SI_MILLI_DIV, // mHz
+    AMPLITUDE_DEFAULT = 1650, // mV
+    OFFSET_DEFAULT = 1650, // mV
+    VOLTAGE_MAX = WAVEGEN_REFERENCE_MV, // mV, of amplitude and offset
+};
+
+// Streamed arbitrary blocks, implemented in common.c
+extern uint32_t protocol_block_streamed(void);
+extern void protocol_block_receive(
+    void *destination,
+    scpi_command_callback_t complete
+);
+
+// Uploaded arbitrary waveform, copied by WAVEGEN_init
+static uint16_t g_wavegen_upload[WAVEGEN_SAMPLES_MAX];
+
+// Codes of the upload being streamed in, checked once received
+static struct {
+    uint32_t first;
+    uint32_t count;
+} g_wavegen_stream;
+
+/**
+ * @brief Settings the generator is initialized with
+ */
+typedef struct {
+    WAVEGEN_Mode mode;
+    WAVEGEN_Shape shape;
+    uint32_t frequency; // mHz, requested until applied, then achieved
+    int32_t amplitude; // mV, peak
+    int32_t offset; // mV
+    uint32_t points; // Uploaded codes of the arbitrary waveform
+    bool output;
+} Settings;
+
+#define SETTINGS_DEFAULT                                                       \
+    {                                                                          \
+        .mode = WAVEGEN_MODE_TABLE, .shape = WAVEGEN_SHAPE_SINE,               \
+        .frequency = FREQUENCY_DEFAULT,                                        \
+        .amplitude = AMPLITUDE_DEFAULT, .offset = OFFSET_DEFAULT,              \
+        .points = 0, .output = false,                                          \
+    }
+
+// Wavegen state (internal to this module)
+static struct {
+    WAVEGEN_Handle *handle;
+    Settings settings;
+} g_wavegen_state = {
+    .handle = nullptr,
+    .settings = SETTINGS_DEFAULT,
+};
+
+/**
+ * @brief Release the generator, which stops the output
+ */
+static void release_handle(void)
+{
+    if (g_wavegen_state.handle) {
+        WAVEGEN_deinit(g_wavegen_state.handle);
+        g_wavegen_state.handle = nullptr;
+    }
+}
+
+/**
+ * @brief Reset wavegen state to default values
+ */
+void wavegen_reset_state(void)
+{
+    release_handle();
+    g_wavegen_state.settings = (Settings)SETTINGS_DEFAULT;
+}
+
+/**
+ * @brief Play the output with the given settings, if it is on
+ *
+ * The previous settings are kept if the new ones cannot be applied, and the
+ * output is then off.
+ */
+static scpi_result_t
+apply_config(scpi_t *context, Settings const *settings)
+{
+    Error err = ERROR_NONE;
+    WAVEGEN_Handle *handle = nullptr;
+
+    release_handle();
+    g_wavegen_state.settings.output = false;
+    if (!settings->output) {
+        g_wavegen_state.settings = *settings;
+        return SCPI_RES_OK;
+    }
+
+    WAVEGEN_Config config = WAVEGEN_CONFIG_DEFAULT;
+    config.mode = settings->mode;
+    config.shape = settings->shape;
+    if (settings->mode == WAVEGEN_MODE_DDS) {
+        config.frequency = settings->frequency / SI_MILLI_DIV;
+        config.millihertz = settings->frequency % SI_MILLI_DIV;
+    } else {
+        config.frequency =
+            (settings->frequency + SI_MILLI_DIV / 2) / SI_MILLI_DIV;
+    }
+    config.amplitude =
+        FIXED_from_fraction(settings->amplitude, (int32_t)SI_MILLI_DIV);
+    config.offset =
+        FIXED_from_fraction(settings->offset, (int32_t)SI_MILLI_DIV);
+    config.samples = g_wavegen_upload;
+    config.sample_count = settings->points;
+
+    TRY { handle = WAVEGEN_init(&config); }
+    CATCH(err)
+    {
+        LOG_ERROR("WAVEGEN init error: 0x%08X", err);
+        SCPI_ErrorPush(
+            context,
+            err == ERROR_INVALID_ARGUMENT ? SCPI_ERROR_ILLEGAL_PARAMETER_VALUE
+                                          : SCPI_ERROR_EXECUTION_ERROR
+        );
+        return SCPI_RES_ERR;
+    }
+    TRY { WAVEGEN_start(handle); }
+    CATCH(err)
+    {
+        LOG_ERROR("WAVEGEN start error: 0x%08X", err);
+        WAVEGEN_deinit(handle);
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    g_wavegen_state.handle = handle;
+    g_wavegen_state.settings = *settings;
+    WAVEGEN_Config const achieved = WAVEGEN_get_config(handle);
+    g_wavegen_state.settings.frequency =
+        achieved.frequency * SI_MILLI_DIV + achieved.millihertz;
+    return SCPI_RES_OK;
+}
+
+static scpi_choice_def_t const g_MODE_CHOICES[] = {
+    { "TABLe", WAVEGEN_MODE_TABLE },
+    { "DDS", WAVEGEN_MODE_DDS },
+    SCPI_CHOICE_LIST_END
+};
+
+/**
+ * @brief WAVegen:MODE - Set how the waveform is generated
+ *
+ * Syntax: WAVegen:MODE <TABLe|DDS>
+ *
+ * TABLe repeats one computed period. DDS synthesizes standard shapes at
+ * a fixed rate with millihertz resolution.
+ */
+scpi_result_t scpi_cmd_wavegen_mode(scpi_t *context)
+{
+    int32_t mode = -1;
+
+    if (!SCPI_ParamChoice(context, g_MODE_CHOICES, &mode, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    Settings settings = g_wavegen_state.settings;
+    settings.mode = (WAVEGEN_Mode)mode;
+    return apply_config(context, &settings);
+}
+
+/**
+ * @brief WAVegen:MODE? - Query how the waveform is generated
+ *
+ * Returns TABL or DDS.
+ */
+scpi_result_t scpi_cmd_wavegen_mode_q(scpi_t *context)
+{
+    SCPI_ResultMnemonic(
+        context,
+        g_wavegen_state.settings.mode == WAVEGEN_MODE_DDS ? "DDS" : "TABL"
+    );
+    return SCPI_RES_OK;
+}
+
+static scpi_choice_def_t const g_SHAPE_CHOICES[] = {
+    { "SINusoid", WAVEGEN_SHAPE_SINE },
+    { "SQUare", WAVEGEN_SHAPE_SQUARE },
+    { "TRIangle", WAVEGEN_SHAPE_TRIANGLE },
+    { "RAMP", WAVEGEN_SHAPE_SAWTOOTH },
+    { "ARBitrary", WAVEGEN_SHAPE_ARBITRARY },
+    SCPI_CHOICE_LIST_END
+};
+
+/**
+ * @brief WAVegen:FUNCtion - Set the shape of the waveform
+ *
+ * Syntax: WAVegen:FUNCtion <SINusoid|SQUare|TRIangle|RAMP|ARBitrary>
+ *
+ * RAMP is a rising sawtooth. ARBitrary plays the uploaded codes.
+ */
+scpi_result_t scpi_cmd_wavegen_function(scpi_t *context)
+{
+    int32_t shape = -1;
+
+    if (!SCPI_ParamChoice(context, g_SHAPE_CHOICES, &shape, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    Settings settings = g_wavegen_state.settings;
+    settings.shape = (WAVEGEN_Shape)shape;
+    return apply_config(context, &settings);
+}
+
+/**
+ * @brief WAVegen:FUNCtion? - Query the shape of the waveform
+ *
+ * Returns SIN, SQU, TRI, RAMP or ARB.
+ */
+scpi_result_t scpi_cmd_wavegen_function_q(scpi_t *context)
+{
+    static char const *const shape_mnemonics[] = {
+        [WAVEGEN_SHAPE_SINE] = "SIN",
+        [WAVEGEN_SHAPE_SQUARE] = "SQU",
+        [WAVEGEN_SHAPE_TRIANGLE] = "TRI",
+        [WAVEGEN_SHAPE_SAWTOOTH] = "RAMP",
+        [WAVEGEN_SHAPE_ARBITRARY] = "ARB",
+    };
+
+    SCPI_ResultMnemonic(
+        context, shape_mnemonics[g_wavegen_state.settings.shape]
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief WAVegen:FREQuency - Set the frequency of the waveform
+ *
+ * Syntax: WAVegen:FREQuency <Hz>
+ *
+ * Standard shapes reach WAVEGEN_FREQUENCY_MAX. An arbitrary waveform
+ * reaches the frequency at which its codes are output at
+ * WAVEGEN_SAMPLE_RATE_MAX. WAV:FREQ? returns the frequency achieved while
+ * the output is on.
+ */
+scpi_result_t scpi_cmd_wavegen_frequency(scpi_t *context)
+{
+    uint32_t frequency = 0;
+
+    if (!SCPI_ParamUInt32(context, &frequency, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    if (frequency == 0 || frequency > WAVEGEN_SAMPLE_RATE_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    Settings settings = g_wavegen_state.settings;
+    settings.frequency = frequency * SI_MILLI_DIV;
+    return apply_config(context, &settings);
+}
+
+/**
+ * @brief WAVegen:FREQuency? - Query the frequency, rounded to the Hz
+ */
+scpi_result_t scpi_cmd_wavegen_frequency_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(
+        context,
+        (g_wavegen_state.settings.frequency + SI_MILLI_DIV / 2) / SI_MILLI_DIV
+    );
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief WAVegen:FREQuency:MILLihertz - Set the frequency in millihertz
+ *
+ * Syntax: WAVegen:FREQuency:MILLihertz <mHz>
+ *
+ * Resolved in DDS mode, and rounded to the Hz in table mode.
+ */
+scpi_result_t scpi_cmd_wavegen_frequency_millihertz(scpi_t *context)
+{
+    uint32_t frequency = 0;
+
+    if (!SCPI_ParamUInt32(context, &frequency, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    if (frequency == 0 ||
+        frequency > (uint32_t)WAVEGEN_SAMPLE_RATE_MAX * SI_MILLI_DIV) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    Settings settings = g_wavegen_state.settings;
+    settings.frequency = frequency;
+    return apply_config(context, &settings);
+}
+
+/**
+ * @brief WAVegen:FREQuency:MILLihertz? - Query the frequency in millihertz
+ */
+scpi_result_t scpi_cmd_wavegen_frequency_millihertz_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_wavegen_state.settings.frequency);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Parse a voltage setting in millivolts
+ */
+static bool param_millivolts(scpi_t *context, int32_t *millivolts)
+{
+    if (!SCPI_ParamInt32(context, millivolts, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return false;
+    }
+    if (*millivolts < 0 || *millivolts > VOLTAGE_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief WAVegen:VOLTage:AMPLitude - Set the peak voltage of the waveform
+ *
+ * Syntax: WAVegen:VOLTage:AMPLitude <mV>
+ *
+ * The waveform swings this far above and below the offset, clipped to
+ * the output range of 0 to 3.3 V. Arbitrary waveforms are played as
+ * uploaded.
+ */
+scpi_result_t scpi_cmd_wavegen_voltage_amplitude(scpi_t *context)
+{
+    int32_t amplitude = 0;
+
+    if (!param_millivolts(context, &amplitude)) {
+        return SCPI_RES_ERR;
+    }
+
+    Settings settings = g_wavegen_state.settings;
+    settings.amplitude = amplitude;
+    return apply_config(context, &settings);
+}
+
+/**
+ * @brief WAVegen:VOLTage:AMPLitude? - Query the peak voltage in mV
+ */
+scpi_result_t scpi_cmd_wavegen_voltage_amplitude_q(scpi_t *context)
+{
+    SCPI_ResultInt32(context, g_wavegen_state.settings.amplitude);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief WAVegen:VOLTage:OFFSet - Set the center voltage of the waveform
+ *
+ * Syntax: WAVegen:VOLTage:OFFSet <mV>
+ */
+scpi_result_t scpi_cmd_wavegen_voltage_offset(scpi_t *context)
+{
+    int32_t offset = 0;
+
+    if (!param_millivolts(context, &offset)) {
+        return SCPI_RES_ERR;
+    }
+
+    Settings settings = g_wavegen_state.settings;
+    settings.offset = offset;
+    return apply_config(context, &settings);
+}
+
+/**
+ * @brief WAVegen:VOLTage:OFFSet? - Query the center voltage in mV
+ */
+scpi_result_t scpi_cmd_wavegen_voltage_offset_q(scpi_t *context)
+{
+    SCPI_ResultInt32(context, g_wavegen_state.settings.offset);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Check the codes of a streamed upload once they are all in
+ *
+ * The codes were received in place, so out-of-range ones are cleared
+ * rather than kept.
+ */
+static scpi_result_t wavegen_data_received(scpi_t *context)
+{
+    uint16_t *const codes = &g_wavegen_upload[g_wavegen_stream.first];
+    bool valid = true;
+
+    for (uint32_t i = 0; i < g_wavegen_stream.count; ++i) {
+        if (codes[i] > WAVEGEN_CODE_MAX) {
+            codes[i] = 0;
+            valid = false;
+        }
+    }
+    if (!valid) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief WAVegen:DATA - Upload part of the arbitrary waveform
+ *
+ * Parameters are the index of the first code, and the codes as a definite
+ * length arbitrary block of 16-bit little-endian values from 0 to 4095,
+ * e.g. WAV:DATA 64,#3128<64 codes>. A block too large for the SCPI input
+ * buffer is streamed into the upload as it arrives, so the whole waveform
+ * may go in one part. The upload is played once WAV:DATA:POIN sets its
+ * length.
+ */
+scpi_result_t scpi_cmd_wavegen_data(scpi_t *context)
+{
+    uint32_t first = 0;
+    char const *data = nullptr;
+    size_t size = 0;
+
+    if (!SCPI_ParamUInt32(context, &first, true) ||
+        !SCPI_ParamArbitraryBlock(context, &data, &size, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    uint32_t const streamed = protocol_block_streamed();
+    if (streamed > 0) {
+        size = streamed;
+    }
+
+    uint32_t const count = (uint32_t)size / sizeof(uint16_t);
+    if (size % sizeof(uint16_t) != 0 || first > WAVEGEN_SAMPLES_MAX ||
+        count > WAVEGEN_SAMPLES_MAX - first) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    if (streamed > 0) {
+        // Little-endian codes land in the upload as they are
+        g_wavegen_stream.first = first;
+        g_wavegen_stream.count = count;
+        protocol_block_receive(&g_wavegen_upload[first], wavegen_data_received);
+        return SCPI_RES_OK;
+    }
+    uint8_t const *const bytes = (uint8_t const *)data;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint16_t const code =
+            (uint16_t)(bytes[2 * i] | ((uint16_t)bytes[2 * i + 1] << 8));
+        if (code > WAVEGEN_CODE_MAX) {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        }
+        g_wavegen_upload[first + i] = code;
+    }
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief WAVegen:DATA:POINts - Set the codes per period of the upload
+ *
+ * Syntax: WAVegen:DATA:POINts <n>
+ *
+ * Plays the first n uploaded codes when the function is ARBitrary.
+ */
+scpi_result_t scpi_cmd_wavegen_data_points(scpi_t *context)
+{
+    uint32_t points = 0;
+
+    if (!SCPI_ParamUInt32(context, &points, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+    if (points == 0 || points > WAVEGEN_SAMPLES_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    Settings settings = g_wavegen_state.settings;
+    settings.points = points;
+    return apply_config(context, &settings);
+}
+
+/**
+ * @brief WAVegen:DATA:POINts? - Query the codes per period of the upload
+ */
+scpi_result_t scpi_cmd_wavegen_data_points_q(scpi_t *context)
+{
+    SCPI_ResultUInt32(context, g_wavegen_state.settings.points);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief WAVegen:OUTPut[:STATe] - Switch the output on or off
+ *
+ * Syntax: WAVegen:OUTPut[:STATe] <ON|OFF|1|0>
+ *
+ * Off, the DAC is released and the output pin floats.
+ */
+scpi_result_t scpi_cmd_wavegen_output(scpi_t *context)
+{
+    scpi_bool_t output = false;
+
+    if (!SCPI_ParamBool(context, &output, true)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return SCPI_RES_ERR;
+    }
+
+    Settings settings = g_wavegen_state.settings;
+    settings.output = output;
+    return apply_config(context, &settings);
+}
+
+/**
+ * @brief WAVegen:OUTPut[:STATe]? - Query whether the output is on
+ */
+scpi_result_t scpi_cmd_wavegen_output_q(scpi_t *context)
+{
+    SCPI_ResultBool(context, g_wavegen_state.settings.output);
+    return SCPI_RES_OK;
+}
@@ -10,9 +10,15 @@
 #ifndef PSLAB_ADC_LL_H
 #define PSLAB_ADC_LL_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "util/error.h"
+
+#include "tim_ll.h"
+
 #define MAX_SIMULTANEOUS_CHANNELS 2
+#define ADC_LL_SEQUENCE_MAX 16 // Regular sequencer ranks on ADC1 and ADC2
 
 typedef enum {
     ADC_TRIGGER_TIMER1 = 1,
@@ -51,6 +57,60 @@ typedef enum {
     ADC_LL_MODE_INTERLEAVED // Interleaved sampling on ADC1 and ADC2
 } ADC_LL_Mode;
 
+/**
+ * @brief ADC conversion resolution
+ *
+ * Lower resolutions convert in fewer cycles and so allow higher sample
+ * rates. Samples stay right-aligned in 16-bit words; watchdog thresholds
+ * remain on the 12-bit scale.
+ */
+typedef enum {
+    ADC_LL_RESOLUTION_12BIT = 0, // 12.5 conversion cycles
+    ADC_LL_RESOLUTION_10BIT, // 10.5 conversion cycles
+    ADC_LL_RESOLUTION_8BIT, // 8.5 conversion cycles
+} ADC_LL_Resolution;
+
+/**
+ * @brief GPDMA channel priority for ADC transfers
+ */
+typedef enum {
+    ADC_LL_DMA_PRIORITY_DEFAULT = 0, // High in dual modes, low otherwise
+    ADC_LL_DMA_PRIORITY_LOW, // Low priority, low weight
+    ADC_LL_DMA_PRIORITY_MEDIUM, // Low priority, mid weight
+    ADC_LL_DMA_PRIORITY_ELEVATED, // Low priority, high weight
+    ADC_LL_DMA_PRIORITY_HIGH, // High priority, served before all others
+} ADC_LL_DmaPriority;
+
+/**
+ * @brief GPDMA master port allocation for ADC transfers
+ */
+typedef enum {
+    ADC_LL_DMA_PORTS_DEFAULT = 0, // Split in dual modes, shared otherwise
+    ADC_LL_DMA_PORTS_SHARED, // ADC reads and memory writes on port 0
+    ADC_LL_DMA_PORTS_SPLIT, // ADC reads on port 0, memory writes on port 1
+} ADC_LL_DmaPorts;
+
+enum {
+    ADC_LL_DMA_BURST_MAX = 4, // Longest memory-side burst in beats
+};
+
+/**
+ * @brief GPDMA quality of service for ADC transfers
+ *
+ * A zeroed structure selects the defaults, which favor the dual modes used
+ * for high-rate acquisition: high priority, 4-beat bursts into memory and
+ * separate ports for the ADC and memory sides. Single mode defaults to the
+ * lowest priority and single transfers.
+ *
+ * The ADC side always transfers single beats, one per conversion; bursts
+ * are assembled in the channel FIFO before being written to memory.
+ */
+typedef struct {
+    ADC_LL_DmaPriority priority; // Channel priority
+    uint32_t burst_length; // Memory-side beats per burst: 1, 2 or 4; 0 default
+    ADC_LL_DmaPorts ports; // Master port allocation
+} ADC_LL_DmaQos;
+
 /**
  * @brief ADC configuration structure
  */
@@ -62,8 +122,43 @@ typedef struct {
     uint32_t buffer_size; // Buffer size (number of samples per channel)
     uint32_t oversampling_ratio; // Oversampling ratio (1, 2, 4, 8, 16, 32, 64,
                                  // 128, 256)
+    // Right shift of oversampled sums, 0 to 8. log2(oversampling_ratio)
+    // averages back to the conversion resolution; smaller shifts keep extra
+    // bits, as long as results fit in 16 bits.
+    uint32_t oversampling_shift;
+    bool circular; // Continuous acquisition into a circular buffer
+    ADC_LL_Channel sequence[ADC_LL_SEQUENCE_MAX]; // Scan sequence
+    uint32_t sequence_length; // Channels in sequence; 0 or 1 disables scan
+    ADC_LL_DmaQos dma; // DMA priority, burst length and port allocation
+    ADC_LL_Resolution resolution; // Conversion resolution, 12 bits by default
+    // Conversions per second each ADC has to sustain, counting every rank
+    // and oversampled conversion. The longest sampling time that keeps up
+    // is chosen; 0 keeps the default of 92.5 cycles.
+    uint32_t conversion_rate;
 } ADC_LL_Config;
 
+/**
+ * @brief ADC clock of an acquisition mode
+ *
+ * The ADCs convert at PLATFORM_ADC_CLOCK_SOURCE_HZ / (kernel_divider *
+ * prescaler). The smallest divider gives the 75 MHz the ADCs are rated
+ * for, and the default of every mode; slower clocks lengthen the sampling
+ * and conversion times in proportion, for sources of high impedance.
+ */
+typedef struct {
+    // PLATFORM_ADC_CLOCK_DIVIDER_MIN to PLATFORM_ADC_CLOCK_DIVIDER_MAX
+    uint32_t kernel_divider;
+    uint32_t prescaler; // 1, 2, 4, 6, 8, 10, 12, 16, 32, 64, 128 or 256
+} ADC_LL_Clock;
+
+/**
+ * @brief Data integrity counters, accumulated since startup
+ */
+typedef struct {
+    uint32_t overruns; // Conversions lost because the DMA fell behind
+    uint32_t dma_errors; // DMA transfer errors
+} ADC_LL_ErrorCounters;
+
 /**
  * @brief Callback function type for ADC complete events.
  *
@@ -72,6 +167,11 @@ typedef struct {
  *
  * Data Format:
  * - Single mode: Buffer contains samples from one ADC channel
+ * - Scan (single mode with a sequence): Buffer contains the sequence channels
+ *   in rank order, one full sequence per trigger
+ *   [seq0_sample0, seq1_sample0, ..., seqN_sample0, seq0_sample1, ...]
+ * - Simultaneous scan: even sequence entries are ranks of ADC1 and odd ones
+ *   ranks of ADC2, so the buffer holds the sequence in the same order
  * - Simultaneous mode: Buffer contains simultaneous sample pairs from both
  *   ADCs / channels
  *   [ADC1_sample0, ADC2_sample0, ADC1_sample1, ADC2_sample1, ...]
@@ -81,6 +181,13 @@ typedef struct {
  *   [ADC1_sample0, ADC2_sample1, ADC1_sample2, ADC2_sample3, ...]
  *   Total buffer size is 2 * buffer_size samples
  *
+ * Circular Mode:
+ * - When ADC_LL_Config.circular is set, DMA wraps around the output buffer
+ *   and conversions continue until ADC_LL_stop is called. The half-complete
+ *   callback is invoked with the first half of the buffer once it is filled,
+ *   and the complete callback is invoked with the second half. Each half is
+ *   safe to read until the callback for the other half returns.
+ *
  * @param buffer Pointer to the output buffer
  * @param total_samples Total number of samples in the buffer
  */
@@ -89,6 +196,26 @@ typedef void (*ADC_LL_CompleteCallback)(
     uint32_t total_samples
 );
 
+/**
+ * @brief Callback function type for analog watchdog events.
+ *
+ * Called from interrupt context when a sample on the monitored channel falls
+ * outside the watchdog window. The watchdog disarms itself before the
+ * callback is invoked, so it fires at most once per ADC_LL_arm_watchdog call.
+ */
+typedef void (*ADC_LL_WatchdogCallback)(void);
+
+/**
+ * @brief Callback function type for injected conversion results.
+ *
+ * Called from interrupt context once an injected measurement started by
+ * ADC_LL_injected_start has completed.
+ *
+ * @param value Sum of the oversampled conversions, shifted right as set by
+ *              ADC_LL_injected_init
+ */
+typedef void (*ADC_LL_InjectedCallback)(uint16_t value);
+
 /**
  * @brief Initialize the ADC peripheral(s).
  *
@@ -98,20 +225,92 @@ typedef void (*ADC_LL_CompleteCallback)(
  *
  * Buffer Requirements:
  * - Single mode: Buffer accommodates buffer_size samples
+ * - Scan: buffer_size counts samples of all channels and must be a multiple
+ *   of sequence_length; the sequence replaces channels
+ * - Simultaneous scan: sequence_length must be even; ADC1 converts the even
+ *   entries and ADC2 the odd ones, pairwise, on each trigger
  * - Simultaneous mode: Buffer accommodates 2 * buffer_size samples
  * - Interleaved mode: Buffer accommodates 2 * buffer_size samples
+ * - Circular mode: buffer_size must be a multiple of 4 so that each half
+ *   holds whole DMA transfers
+ * - Buffers larger than one 64 KB DMA block are split over a linked list of
+ *   up to 8 blocks
+ *
+ * The calibration factors and the VDDA measurement are cached for a few
+ * minutes, so a re-init shortly after ADC_LL_deinit skips self-calibration
+ * and the VREFINT conversion.
  *
  * @param config Pointer to ADC configuration structure.
  */
 void ADC_LL_init(ADC_LL_Config const *config);
 
+/**
+ * @brief Check whether the ADC is owned by a regular-group user.
+ *
+ * @return true between a successful ADC_LL_init and ADC_LL_deinit.
+ */
+bool ADC_LL_is_initialized(void);
+
 /**
  * @brief Start ADC conversion(s).
  *
  * Starts timer-triggered conversions with DMA for the configured ADC(s).
+ *
+ * @throws ERROR_INVALID_ARGUMENT if the output buffer needs more DMA blocks
+ *         than the linked list holds
  */
 void ADC_LL_start(void);
 
+/**
+ * @brief Start ADC conversion(s), returning failures instead of throwing.
+ *
+ * Same as ADC_LL_start, for callers that restart conversions on the
+ * acquisition path and would otherwise need a TRY block per restart.
+ *
+ * @return ERROR_NONE, or the error ADC_LL_start would throw
+ */
+Error ADC_LL_try_start(void);
+
+/**
+ * @brief Restart ADC conversion(s) into a different output buffer.
+ *
+ * Stops the DMA, retargets it to @p buffer and starts it again with the
+ * current configuration. The trigger timer is left alone, so conversions
+ * resume on the next trigger. Intended for re-arming from the ADC callbacks;
+ * the buffer requirements of ADC_LL_init apply to @p buffer_size.
+ *
+ * @param buffer New output buffer.
+ * @param buffer_size New buffer size (number of samples per channel).
+ */
+void ADC_LL_restart(uint16_t *buffer, uint32_t buffer_size);
+
+/**
+ * @brief Restart ADC conversion(s), returning failures instead of throwing.
+ *
+ * Same as ADC_LL_restart, see ADC_LL_try_start.
+ *
+ * @param buffer New output buffer.
+ * @param buffer_size New buffer size (number of samples per channel).
+ * @return ERROR_NONE, or the error ADC_LL_restart would throw
+ */
+Error ADC_LL_try_restart(uint16_t *buffer, uint32_t buffer_size);
+
+/**
+ * @brief Change the output buffer used by the next ADC_LL_start.
+ *
+ * Lets the caller change the capture length without reinitializing the
+ * ADC. Must not be called while conversions are running; see
+ * ADC_LL_restart for that. The buffer requirements of ADC_LL_init apply to
+ * @p buffer_size.
+ *
+ * @param buffer New output buffer.
+ * @param buffer_size New buffer size (number of samples per channel).
+ *
+ * @throws ERROR_RESOURCE_UNAVAILABLE if the ADC is not initialized
+ * @throws ERROR_INVALID_ARGUMENT if the buffer is NULL or empty
+ */
+void ADC_LL_set_output_buffer(uint16_t *buffer, uint32_t buffer_size);
+
 /**
  * @brief Deinitialize the ADC peripheral(s).
  *
@@ -138,6 +337,143 @@ void ADC_LL_stop(void);
  */
 void ADC_LL_set_complete_callback(ADC_LL_CompleteCallback callback);
 
+/**
+ * @brief Set the callback for ADC half-complete events.
+ *
+ * This function sets a user-defined callback that will be called when
+ * the first half of the output buffer has been filled. It is only invoked
+ * in circular mode.
+ *
+ * @param callback Pointer to the callback function to be set.
+ */
+void ADC_LL_set_half_complete_callback(ADC_LL_CompleteCallback callback);
+
+/**
+ * @brief Set the callback for analog watchdog events.
+ *
+ * @param callback Pointer to the callback function to be set.
+ */
+void ADC_LL_set_watchdog_callback(ADC_LL_WatchdogCallback callback);
+
+/**
+ * @brief Arm the analog watchdog.
+ *
+ * The watchdog monitors the first configured channel on ADC1 and fires once
+ * a sample is below @p low or above @p high. Thresholds are raw 12-bit
+ * conversion values; bits below the configured resolution are dropped. May be
+ * called while conversions are running, including from the watchdog callback
+ * to re-arm with a new window.
+ *
+ * @note In interleaved mode only the ADC1 half of the samples is monitored.
+ *
+ * @param low Lower window threshold.
+ * @param high Upper window threshold.
+ */
+void ADC_LL_arm_watchdog(uint16_t low, uint16_t high);
+
+/**
+ * @brief Disarm the analog watchdog without invoking the callback.
+ */
+void ADC_LL_disarm_watchdog(void);
+
+/**
+ * @brief Configure an injected channel on ADC1.
+ *
+ * Lets a second, slow user share the ADC with the regular-group owner, e.g.
+ * a DC reading while the scope captures. Injected measurements are software
+ * triggered; each conversion pre-empts the regular group, which resumes
+ * once it is done. In dual modes this delays the scope samples around the
+ * injected conversion. The regular conversions are paused for a few ADC
+ * clock cycles while the channel is configured.
+ *
+ * The injected channel is released by ADC_LL_injected_deinit or together
+ * with the rest of the ADC by ADC_LL_deinit.
+ *
+ * @param channel ADC channel to measure.
+ * @param oversampling_ratio Number of conversions summed per measurement
+ *                           (1, 2, 4, ..., 256).
+ * @param oversampling_shift Right shift of the sum, as for
+ *                           ADC_LL_Config.oversampling_shift.
+ *
+ * @throws ERROR_RESOURCE_UNAVAILABLE if the ADC is not initialized
+ * @throws ERROR_RESOURCE_BUSY if the injected channel is already in use
+ * @throws ERROR_INVALID_ARGUMENT if the oversampling ratio or shift is
+ *         invalid
+ * @throws ERROR_HARDWARE_FAULT if the channel cannot be configured
+ */
+void ADC_LL_injected_init(
+    ADC_LL_Channel channel,
+    uint32_t oversampling_ratio,
+    uint32_t oversampling_shift
+);
+
+/**
+ * @brief Release the injected channel.
+ *
+ * Aborts a measurement in progress. Does nothing if the injected channel is
+ * not configured.
+ */
+void ADC_LL_injected_deinit(void);
+
+/**
+ * @brief Start one injected measurement.
+ *
+ * The result is delivered to the injected callback.
+ *
+ * @throws ERROR_RESOURCE_UNAVAILABLE if the injected channel is not
+ *         configured
+ * @throws ERROR_RESOURCE_BUSY if a measurement is already in progress
+ * @throws ERROR_HARDWARE_FAULT if the conversion cannot be started
+ */
+void ADC_LL_injected_start(void);
+
+/**
+ * @brief Start one injected measurement, returning failures instead of
+ * throwing.
+ *
+ * Same as ADC_LL_injected_start, see ADC_LL_try_start.
+ *
+ * @return ERROR_NONE, or the error ADC_LL_injected_start would throw
+ */
+Error ADC_LL_try_injected_start(void);
+
+/**
+ * @brief Set the callback for injected measurement results.
+ *
+ * @param callback Pointer to the callback function to be set.
+ */
+void ADC_LL_set_injected_callback(ADC_LL_InjectedCallback callback);
+
+/**
+ * @brief Measure the reference voltage in the background.
+ *
+ * To be called periodically from the main loop. Each call either starts a
+ * VREFINT conversion on the ADC1 injected group or reads the one started
+ * by the previous call, which is filtered into the reference voltage, so
+ * that it follows supply drift without ADC_LL_init. Does nothing while
+ * the injected channel is in use or the regular group is converting;
+ * starting either aborts a tracking conversion in flight.
+ */
+void ADC_LL_track_reference(void);
+
+/**
+ * @brief Get the current DMA write position.
+ *
+ * @return Index in the output buffer of the next sample the DMA will write,
+ *         in 16-bit samples, or 0 if the ADC is not initialized.
+ */
+uint32_t ADC_LL_get_dma_position(void);
+
+/**
+ * @brief Get the data integrity counters.
+ *
+ * The counters are kept across ADC_LL_deinit, so a caller can detect errors
+ * during an acquisition by comparing them before and after it.
+ *
+ * @return Overruns and DMA transfer errors since startup.
+ */
+ADC_LL_ErrorCounters ADC_LL_get_error_counters(void);
+
 /**
  * @brief Get the current ADC operation mode.
  *
@@ -162,27 +498,94 @@ ADC_LL_Mode ADC_LL_get_mode(void);
  */
 uint32_t ADC_LL_get_sample_rate(void);
 
+/**
+ * @brief Get the sampling time of the regular channels.
+ *
+ * @return Sampling time in ns, as chosen by ADC_LL_init for
+ *         ADC_LL_Config.conversion_rate, or 0 if the ADC is not initialized.
+ */
+uint32_t ADC_LL_get_sample_time_ns(void);
+
+/**
+ * @brief Get the sampling time ADC_LL_init would choose for a rate.
+ *
+ * Lets callers tell whether a new rate needs the ADC to be initialized
+ * again, and report the sampling time before it is.
+ *
+ * @param mode ADC operation mode, whose clock is used.
+ * @param resolution Conversion resolution.
+ * @param conversion_rate Conversions per second each ADC has to sustain, or
+ *                        0 for the default sampling time.
+ * @return Sampling time in ns, or 0 for an invalid mode.
+ */
+uint32_t ADC_LL_select_sample_time_ns(
+    ADC_LL_Mode mode,
+    ADC_LL_Resolution resolution,
+    uint32_t conversion_rate
+);
+
+/**
+ * @brief Get the trigger source for conversions paced by a timer
+ *
+ * @param tim Timer, typically one returned by TIM_LL_claim
+ * @return Trigger source for the timer's TRGO output
+ *
+ * @throws ERROR_INVALID_ARGUMENT if the timer cannot trigger the ADC
+ */
+ADC_LL_TriggerSource ADC_LL_get_timer_trigger(TIM_Num tim);
+
 /**
  * @brief Get the reference voltage reading.
  *
  * This function returns the reference voltage that was measured during ADC
- * initialization. The value is obtained by reading the internal VREFINT
- * channel and calculating the actual reference voltage using factory
- * calibration data.
+ * initialization, and kept up to date since by ADC_LL_track_reference. The
+ * value is obtained by reading the internal VREFINT channel and calculating
+ * the actual reference voltage using factory calibration data.
  *
  * @return Reference voltage in millivolts, or 0 if ADC is not initialized.
  */
 uint32_t ADC_LL_get_reference_voltage(void);
 
 /**
- * @brief Get the maximum sample rate for a given ADC mode.
+ * @brief Set the ADC clock an acquisition mode runs at.
+ *
+ * Takes effect on the next ADC_LL_init in that mode, which sets the kernel
+ * clock divider with PLATFORM_set_adc_clock_divider. The sampling times
+ * and rates reported for the mode follow from it.
+ *
+ * @param mode ADC operation mode.
+ * @param clock Kernel clock divider and prescaler.
+ *
+ * @throws ERROR_INVALID_ARGUMENT if mode is invalid, or the divider or the
+ *         prescaler is not supported
+ */
+void ADC_LL_set_clock(ADC_LL_Mode mode, ADC_LL_Clock const *clock);
+
+/**
+ * @brief Get the ADC clock of an acquisition mode.
+ *
+ * @param mode ADC operation mode.
+ * @return Clock set by ADC_LL_set_clock, 75 MHz undivided by default.
+ *
+ * @throws ERROR_INVALID_ARGUMENT if mode is invalid
+ */
+ADC_LL_Clock ADC_LL_get_clock(ADC_LL_Mode mode);
+
+/**
+ * @brief Get the maximum sample rate for a given ADC mode and resolution.
  *
  * This function returns the theoretical maximum sample rate for the specified
- * ADC mode based on the hardware capabilities.
+ * ADC mode based on the hardware capabilities and the clock of the mode. The
+ * rate is highest at the shortest sampling time, where the conversion time
+ * for the resolution dominates.
  *
  * @param mode ADC operation mode.
- * @return Maximum sample rate in Hz.
+ * @param resolution ADC conversion resolution.
+ * @return Maximum sample rate in Hz, or 0 for an invalid mode or resolution.
  */
-uint32_t ADC_LL_get_max_sample_rate(ADC_LL_Mode mode);
+uint32_t ADC_LL_get_max_sample_rate(
+    ADC_LL_Mode mode,
+    ADC_LL_Resolution resolution
+);
 
 #endif // ADC_LL_H
@@ -0,0 +1,73 @@
+/**
+ * @file copy_ll.h
+ * @brief Low-level memory copies by DMA
+ *
+ * A GPDMA channel copies a block of memory to another while the CPU goes
+ * on with other work. Large moves, such as sample records packed for a
+ * fetch or blocks copied into buffers on loan, then cost the CPU the setup
+ * and a transfer complete interrupt per 64 KB.
+ *
+ * The engine runs one copy at a time. The DMA channel is claimed when a
+ * copy starts and released when it ends, so that it is there for other
+ * drivers meanwhile (see dma_channel.h). The end of a copy is signalled by
+ * a callback from the channel interrupt, at IRQ_PRIORITY_COPY, once the
+ * engine has been freed. Copies are started from the main loop only, as
+ * channels are claimed there, so a callback just records the end.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_LL_COPY_H
+#define PSLAB_LL_COPY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Called once a copy has ended
+ *
+ * @param context Context given to COPY_LL_start
+ * @param ok false if the DMA hit a bus error, and the copy is incomplete
+ */
+typedef void (*COPY_LL_Callback)(void *context, bool ok);
+
+/**
+ * @brief Start copying a block of memory
+ *
+ * Both blocks must stay in place, and unused by the CPU, until the copy
+ * has ended or been aborted. They must not overlap. Copies between
+ * word-aligned blocks of a multiple of 4 bytes move a word per beat.
+ *
+ * @param dst Destination
+ * @param src Source
+ * @param size Number of bytes, 1 or more
+ * @param callback Called once the copy has ended, or nullptr
+ * @param context Passed to the callback
+ *
+ * @throws ERROR_INVALID_ARGUMENT if a block is NULL or size is 0
+ * @throws ERROR_RESOURCE_BUSY if another copy is running
+ * @throws ERROR_RESOURCE_UNAVAILABLE if no DMA channel is free
+ */
+void COPY_LL_start(
+    void *dst,
+    void const *src,
+    uint32_t size,
+    COPY_LL_Callback callback,
+    void *context
+);
+
+/**
+ * @brief Check whether a copy is running
+ */
+bool COPY_LL_busy(void);
+
+/**
+ * @brief Stop a running copy, without calling its callback
+ *
+ * Part of the destination may have been written. Does nothing if no copy
+ * is running.
+ */
+void COPY_LL_abort(void);
+
+#endif // PSLAB_LL_COPY_H
@@ -0,0 +1,94 @@
+/**
+ * @file counter_ll.h
+ * @brief Low-level interface to timestamping the edges of an input
+ *
+ * A free-running 32-bit timer captures its count on rising edges of the
+ * counter input, every one or every few of them, and a DMA moves each
+ * capture into a ring without the CPU. The timestamps are in periods of
+ * the timer clock, COUNTER_LL_get_clock, and wrap after 2^32 of them.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_COUNTER_LL_H
+#define PSLAB_COUNTER_LL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+enum {
+    COUNTER_LL_PRESCALER_MAX = 8, // Edges per capture
+    COUNTER_LL_CAPTURE_RATE_MAX = 2000000, // Hz, sustained by the DMA
+};
+
+/**
+ * @brief Captures since COUNTER_LL_start
+ */
+typedef struct {
+    uint32_t captures; // Captures taken, each of prescaler edges
+    uint32_t first; // Timestamp of the first capture
+    uint32_t last; // Timestamp of the latest capture
+    bool overrun; // An edge came before the previous capture was moved
+} COUNTER_LL_Span;
+
+/**
+ * @brief Configure the input, the timer and the DMA
+ *
+ * The timer starts counting, so timestamps can be read at once, but edges
+ * are only captured from COUNTER_LL_start.
+ *
+ * @param prescaler Edges per capture: 1, 2, 4 or COUNTER_LL_PRESCALER_MAX
+ *
+ * @throws ERROR_INVALID_ARGUMENT if prescaler is not one of these
+ * @throws ERROR_RESOURCE_BUSY if already initialized
+ * @throws ERROR_HARDWARE_FAULT if the timer or the DMA cannot be configured
+ */
+void COUNTER_LL_init(uint32_t prescaler);
+
+/**
+ * @brief Stop capturing and release the timer and the DMA channel
+ */
+void COUNTER_LL_deinit(void);
+
+/**
+ * @brief Start capturing edges, from an empty span
+ *
+ * @throws ERROR_DEVICE_NOT_READY if not initialized
+ * @throws ERROR_HARDWARE_FAULT if the DMA cannot be started
+ */
+void COUNTER_LL_start(void);
+
+/**
+ * @brief Stop capturing edges
+ *
+ * The span stays readable until the next COUNTER_LL_start.
+ */
+void COUNTER_LL_stop(void);
+
+/**
+ * @brief Frequency of the timer clock
+ *
+ * @return Timestamp periods per second, 0 if not initialized
+ */
+uint32_t COUNTER_LL_get_clock(void);
+
+/**
+ * @brief Current count of the timer
+ *
+ * @return Timestamp of the present instant
+ */
+uint32_t COUNTER_LL_get_time(void);
+
+/**
+ * @brief Read the captures taken since COUNTER_LL_start
+ *
+ * Only consistent once stopped: the DMA may move a capture while the span
+ * is read.
+ *
+ * @param span Filled with the captures; first and last are only valid with
+ *             at least one capture
+ */
+void COUNTER_LL_get_span(COUNTER_LL_Span *span);
+
+#endif // PSLAB_COUNTER_LL_H
@@ -0,0 +1,82 @@
+/**
+ * @file crc_ll.h
+ * @brief Low-level CRC unit, fed by DMA
+ *
+ * The CRC unit checksums bytes written to its data register. Here a GPDMA
+ * channel writes them, one byte per beat, from memory, so that the CPU only
+ * sets up a checksum and reads its result: in between it costs nothing but
+ * a transfer complete interrupt per 64 KB.
+ *
+ * The unit computes one checksum at a time. It is taken by CRC_LL_start and
+ * given back by CRC_LL_result or CRC_LL_abort, which callers must call from
+ * the main loop; the DMA channel is claimed and released with it, so that
+ * it is there for other drivers meanwhile (see dma_channel.h).
+ *
+ * The results are those of util/crc.h: the CRC-16/CCITT-FALSE of
+ * CRC16_update and the CRC-32/MPEG-2 of CRC32_update.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_LL_CRC_H
+#define PSLAB_LL_CRC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Checksums of the CRC unit
+ */
+typedef enum {
+    CRC_LL_CRC16, // CRC-16/CCITT-FALSE, polynomial 0x1021
+    CRC_LL_CRC32, // CRC-32/MPEG-2, polynomial 0x04C11DB7
+} CRC_LL_Polynomial;
+
+/**
+ * @brief Start a checksum over a block of memory
+ *
+ * The data must stay in place until the checksum is done or aborted.
+ *
+ * @param polynomial Checksum to compute
+ * @param crc Start value: CRC16_INIT or CRC32_INIT, or the result over the
+ *            data preceding this block
+ * @param data Input bytes
+ * @param size Number of bytes, 1 or more
+ *
+ * @throws ERROR_RESOURCE_BUSY if the unit holds another checksum
+ * @throws ERROR_RESOURCE_UNAVAILABLE if no DMA channel is free
+ */
+void CRC_LL_start(
+    CRC_LL_Polynomial polynomial,
+    uint32_t crc,
+    void const *data,
+    uint32_t size
+);
+
+/**
+ * @brief Check whether the unit holds a checksum, running or done
+ */
+bool CRC_LL_busy(void);
+
+/**
+ * @brief Check whether the checksum has gone through all its data
+ */
+bool CRC_LL_done(void);
+
+/**
+ * @brief Take the result of a checksum that is done, and free the unit
+ *
+ * @return CRC over the start value and the data; a CRC-16 in the low
+ *         16 bits
+ */
+uint32_t CRC_LL_result(void);
+
+/**
+ * @brief Stop a checksum, running or done, and free the unit
+ *
+ * Does nothing if the unit holds no checksum.
+ */
+void CRC_LL_abort(void);
+
+#endif // PSLAB_LL_CRC_H
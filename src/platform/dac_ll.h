@@ -0,0 +1,90 @@
+/**
+ * @file dac_ll.h
+ * @brief Low-level interface to timer-paced DAC output
+ *
+ * The DAC output is one buffered 12-bit channel. A timer's trigger output
+ * starts one conversion per update event, and a circular DMA loads the next
+ * code from a table before each one, so a waveform plays without the CPU.
+ * A streamed output instead plays the table as a ring whose halves are
+ * refilled from the DMA interrupt.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_DAC_LL_H
+#define PSLAB_DAC_LL_H
+
+#include <stdint.h>
+
+#include "tim_ll.h"
+
+enum {
+    DAC_LL_CODE_MAX = 4095, // 12-bit codes
+    DAC_LL_REFERENCE_MV = 3300, // VREF+, tied to VDDA
+    DAC_LL_SAMPLE_RATE_MAX = 1000000, // Hz, settling of the output buffer
+    DAC_LL_SAMPLES_MAX = 0xFFFF / 2, // Codes per table, one DMA block
+};
+
+/**
+ * @brief Callback for a half of a streamed output's ring, from interrupt
+ * context
+ *
+ * The half has been output and is to be refilled before the DMA, now
+ * outputting the other half, returns to it.
+ *
+ * @param block First code of the half
+ * @param count Codes in the half
+ */
+typedef void (*DAC_LL_BlockCallback)(uint16_t *block, uint32_t count);
+
+/**
+ * @brief Output settings
+ */
+typedef struct {
+    TIM_Num timer; // Initialized timer pacing the conversions
+    uint16_t *samples; // Code table, reachable by the DMA
+    uint32_t count; // Codes in the table, at most DAC_LL_SAMPLES_MAX
+    // Streams the output, the table being a ring of an even number of
+    // codes. May be nullptr.
+    DAC_LL_BlockCallback block_callback;
+} DAC_LL_Config;
+
+/**
+ * @brief Configure the output pin, the DAC and the DMA
+ *
+ * The output holds mid-scale until DAC_LL_start. The timer is not
+ * started.
+ *
+ * @param config Output settings
+ *
+ * @throws ERROR_INVALID_ARGUMENT if config or its table is NULL, the
+ *         number of codes is out of range or odd for a streamed output, or
+ *         the timer cannot trigger the DAC (TIM3)
+ * @throws ERROR_RESOURCE_BUSY if already initialized
+ * @throws ERROR_HARDWARE_FAULT if the DAC or the DMA cannot be configured
+ */
+void DAC_LL_init(DAC_LL_Config const *config);
+
+/**
+ * @brief Release the DAC and its DMA channel
+ */
+void DAC_LL_deinit(void);
+
+/**
+ * @brief Arm the DMA, so that each timer update outputs the next code
+ *
+ * The table repeats until DAC_LL_stop. The timer is started by the caller
+ * afterwards.
+ *
+ * @throws ERROR_DEVICE_NOT_READY if not initialized
+ * @throws ERROR_HARDWARE_FAULT if the DMA cannot be started
+ */
+void DAC_LL_start(void);
+
+/**
+ * @brief Stop the output, which holds the last code
+ */
+void DAC_LL_stop(void);
+
+#endif // PSLAB_DAC_LL_H
@@ -0,0 +1,155 @@
+/**
+ * @file flash_ll.h
+ * @brief Low-level interface to the persistent storage sector
+ *
+ * This header provides access to a flash sector reserved by the linker
+ * script for data that must survive a power cycle, such as calibration.
+ * Offsets are relative to the start of the sector. The sector must be
+ * erased before it is written, and writes are made in units of
+ * FLASH_LL_WRITE_ALIGN bytes.
+ *
+ * The key-value store (system/kvstore.h) has two sectors of its own, in
+ * front of the storage sector, which are erased one at a time.
+ *
+ * It also gives access to the update area: the range of the inactive flash
+ * bank that mirrors the running firmware. A new firmware image is written
+ * there while the running one carries on, and the bootloader swaps the
+ * banks on the next reset. Offsets into the update area are relative to
+ * its start, which corresponds to the firmware's vector table.
+ */
+
+#ifndef PSLAB_FLASH_LL_H
+#define PSLAB_FLASH_LL_H
+
+#include <stdint.h>
+
+enum {
+    FLASH_LL_STORAGE_SIZE = 8192, // Size of the storage sector in bytes
+    FLASH_LL_WRITE_ALIGN = 16, // Programming unit (one quad-word)
+    FLASH_LL_SECTOR_SIZE = 8192, // Erase unit of the update area
+    FLASH_LL_UPDATE_SIZE = 952 * 1024, // Size of the update area in bytes
+    FLASH_LL_KV_SIZE = 2 * FLASH_LL_SECTOR_SIZE, // Key-value store sectors
+};
+
+/**
+ * @brief Read from the storage sector
+ *
+ * Reading erased flash returns 0xFF bytes.
+ *
+ * @param offset Offset into the sector
+ * @param data Destination buffer
+ * @param size Number of bytes to read
+ *
+ * @throws ERROR_INVALID_ARGUMENT if data is NULL or the range exceeds the
+ *         sector
+ */
+void FLASH_LL_read(uint32_t offset, void *data, uint32_t size);
+
+/**
+ * @brief Erase the storage sector
+ *
+ * Blocks for the duration of the erase, typically a few milliseconds.
+ *
+ * @throws ERROR_HARDWARE_FAULT if the erase fails
+ */
+void FLASH_LL_erase(void);
+
+/**
+ * @brief Write to the erased storage sector
+ *
+ * @param offset Offset into the sector, a multiple of FLASH_LL_WRITE_ALIGN
+ * @param data Data to write, 4-byte aligned
+ * @param size Number of bytes, a multiple of FLASH_LL_WRITE_ALIGN
+ *
+ * @throws ERROR_INVALID_ARGUMENT if data is NULL, offset or size is not
+ *         aligned, or the range exceeds the sector
+ * @throws ERROR_HARDWARE_FAULT if programming fails
+ */
+void FLASH_LL_write(uint32_t offset, void const *data, uint32_t size);
+
+/**
+ * @brief Read from the key-value store sectors
+ *
+ * @param offset Offset into the sectors
+ * @param data Destination buffer
+ * @param size Number of bytes to read
+ *
+ * @throws ERROR_INVALID_ARGUMENT if data is NULL or the range exceeds the
+ *         sectors
+ */
+void FLASH_LL_kv_read(uint32_t offset, void *data, uint32_t size);
+
+/**
+ * @brief Erase one of the key-value store sectors
+ *
+ * Blocks for a few milliseconds.
+ *
+ * @param offset Offset of the sector, a multiple of FLASH_LL_SECTOR_SIZE
+ *
+ * @throws ERROR_INVALID_ARGUMENT if offset is not one of the sectors
+ * @throws ERROR_HARDWARE_FAULT if the erase fails
+ */
+void FLASH_LL_kv_erase(uint32_t offset);
+
+/**
+ * @brief Write to an erased part of the key-value store sectors
+ *
+ * @param offset Offset into the sectors, a multiple of FLASH_LL_WRITE_ALIGN
+ * @param data Data to write, 4-byte aligned
+ * @param size Number of bytes, a multiple of FLASH_LL_WRITE_ALIGN
+ *
+ * @throws ERROR_INVALID_ARGUMENT if data is NULL, offset or size is not
+ *         aligned, or the range exceeds the sectors
+ * @throws ERROR_HARDWARE_FAULT if programming fails
+ */
+void FLASH_LL_kv_write(uint32_t offset, void const *data, uint32_t size);
+
+/**
+ * @brief Read from the update area
+ *
+ * @param offset Offset into the update area
+ * @param data Destination buffer
+ * @param size Number of bytes to read
+ *
+ * @throws ERROR_INVALID_ARGUMENT if data is NULL or the range exceeds the
+ *         update area
+ */
+void FLASH_LL_update_read(uint32_t offset, void *data, uint32_t size);
+
+/**
+ * @brief Erase one sector of the update area
+ *
+ * Only the inactive bank is erased, so the running firmware carries on
+ * fetching from its own bank. Blocks for a few milliseconds.
+ *
+ * @param offset Offset of the sector, a multiple of FLASH_LL_SECTOR_SIZE
+ *
+ * @throws ERROR_INVALID_ARGUMENT if offset is not a sector in the update
+ *         area
+ * @throws ERROR_HARDWARE_FAULT if the erase fails
+ */
+void FLASH_LL_update_erase(uint32_t offset);
+
+/**
+ * @brief Write to an erased part of the update area
+ *
+ * @param offset Offset into the update area, a multiple of
+ *        FLASH_LL_WRITE_ALIGN
+ * @param data Data to write, 4-byte aligned
+ * @param size Number of bytes, a multiple of FLASH_LL_WRITE_ALIGN
+ *
+ * @throws ERROR_INVALID_ARGUMENT if data is NULL, offset or size is not
+ *         aligned, or the range exceeds the update area
+ * @throws ERROR_HARDWARE_FAULT if programming fails
+ */
+void FLASH_LL_update_write(uint32_t offset, void const *data, uint32_t size);
+
+/**
+ * @brief Ask the bootloader to swap the flash banks on the next reset
+ *
+ * The request is kept in RAM shared with the bootloader, which checks the
+ * image in the update area before swapping. The caller resets afterwards.
+ */
+void FLASH_LL_request_bank_swap(void);
+
+#endif // PSLAB_FLASH_LL_H
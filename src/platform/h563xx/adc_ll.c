@@ -12,18 +12,35 @@
  * @date 2025-07-02
  */
 
+#define LOG_MODULE LOG_MODULE_ADC_LL
+
 #include <stdint.h>
 
 #include "stm32h5xx_hal.h"
 
 #include "util/error.h"
 #include "util/logging.h"
+#include "util/ramfunc.h"
 #include "util/si_prefix.h"
 
 #include "adc_ll.h"
+#include "dma_channel.h"
+#include "irq_priority.h"
 #include "platform.h"
 
-enum { ADC_IRQ_PRIORITY = 1 }; // ADC interrupt priority
+enum {
+    ADC_THRESHOLD_BITS = 12, // Watchdog thresholds are on the 12-bit scale
+    // Age after which calibration and VDDA are measured again on init
+    ADC_CALIBRATION_VALIDITY_MS = 300000,
+    // Largest GPDMA block, the 16-bit byte count rounded down to whole words
+    ADC_DMA_BLOCK_BYTES_MAX = 0xFFFC,
+    // Linked-list nodes an output buffer can be split into
+    ADC_DMA_NODES_MAX = 8,
+    // Acquisition modes with a clock setting of their own
+    ADC_MODES = ADC_LL_MODE_INTERLEAVED + 1,
+    // Each tracking conversion moves the reference 1/N of the way
+    ADC_REFERENCE_FILTER = 4,
+};
 
 typedef struct {
     ADC_HandleTypeDef
@@ -34,10 +51,23 @@ typedef struct {
     uint16_t *buffer_data; // Pointer to ADC data buffer
     uint32_t buffer_size; // Size of the ADC data buffer (per channel)
     ADC_LL_CompleteCallback complete_callback; // Callback for ADC completion
+    ADC_LL_CompleteCallback
+        half_complete_callback; // Callback for first buffer half (circular)
+    ADC_LL_WatchdogCallback watchdog_callback; // Callback for watchdog events
     ADC_LL_Channel channels[MAX_SIMULTANEOUS_CHANNELS]; // ADC channels
+    ADC_LL_Channel sequence[ADC_LL_SEQUENCE_MAX]; // Scan sequence, both ADCs
+    uint32_t sequence_length; // Channels in the scan sequence
     ADC_LL_Mode mode; // Current ADC mode
     uint32_t oversampling_ratio; // Oversampling ratio
+    uint32_t oversampling_shift; // Right shift of oversampled sums
+    ADC_LL_Resolution resolution; // Conversion resolution
+    uint32_t sample_time; // HAL sampling time of the regular channels
+    uint32_t clock_prescaler; // HAL clock prescaler of the mode
     uint32_t vref_mv; // Reference voltage in millivolts
+    bool circular; // Circular (continuous) DMA acquisition
+    ADC_LL_DmaQos dma_qos; // DMA settings, defaults resolved
+    uint32_t dma_nodes; // DMA blocks the output buffer is split into
+    uint32_t volatile dma_node; // Block being written (circular mode)
     bool initialized; // Flag to indicate if the ADC is initialized
 } ADCInstance;
 
@@ -53,6 +83,21 @@ static DMA_HandleTypeDef g_hdma_adc = { nullptr };
 
 static DMA_HandleTypeDef g_hdma_adc1_dual = { nullptr };
 
+// GPDMA linked-list nodes, one per block of the output buffer
+static DMA_NodeTypeDef g_dma_adc_nodes[ADC_DMA_NODES_MAX] = { 0 };
+
+static DMA_QListTypeDef g_dma_adc_queue = { nullptr };
+
+// Errors reported by HAL_ADC_ErrorCallback since startup
+static ADC_LL_ErrorCounters volatile g_error_counters = { 0 };
+
+// Clock of each acquisition mode, set on ADC_LL_init
+static ADC_LL_Clock g_mode_clocks[ADC_MODES] = {
+    [ADC_LL_MODE_SINGLE] = { PLATFORM_ADC_CLOCK_DIVIDER_DEFAULT, 1 },
+    [ADC_LL_MODE_SIMULTANEOUS] = { PLATFORM_ADC_CLOCK_DIVIDER_DEFAULT, 1 },
+    [ADC_LL_MODE_INTERLEAVED] = { PLATFORM_ADC_CLOCK_DIVIDER_DEFAULT, 1 },
+};
+
 typedef struct {
     GPIO_TypeDef *gpio_port;
     uint16_t gpio_pin;
@@ -62,12 +107,73 @@ static ADCInstance g_adc_instance = {
     .adc_handles = { &g_hadc1, &g_hadc2 },
     .dma_handle = &g_hdma_adc,
     .channels = { ADC_LL_CHANNEL_0, ADC_LL_CHANNEL_1 },
+    .sequence_length = 1,
     .mode = ADC_LL_MODE_SINGLE,
     .oversampling_ratio = 1,
+    .oversampling_shift = 0,
+    .resolution = ADC_LL_RESOLUTION_12BIT,
+    .sample_time = ADC_SAMPLETIME_92CYCLES_5,
+    .clock_prescaler = ADC_CLOCK_ASYNC_DIV1,
     .vref_mv = 0,
+    .circular = false,
+    .dma_nodes = 0,
+    .dma_node = 0,
+    .initialized = false,
+};
+
+/**
+ * @brief Calibration results kept across ADC_LL_deinit / ADC_LL_init.
+ *
+ * Self-calibration and the VREFINT measurement dominate init time, while
+ * their results only drift slowly with temperature and supply. They are
+ * reused until ADC_CALIBRATION_VALIDITY_MS has passed.
+ */
+typedef struct {
+    uint32_t factors[MAX_SIMULTANEOUS_CHANNELS]; // Calibration factor per ADC
+    uint32_t factor_ticks[MAX_SIMULTANEOUS_CHANNELS]; // Time of calibration
+    bool factor_valid[MAX_SIMULTANEOUS_CHANNELS]; // Factor has been measured
+    uint32_t vdda_mv; // Last VDDA measurement
+    uint32_t vdda_tick; // Time of the VDDA measurement
+    bool vdda_valid; // VDDA has been measured
+} CalibrationCache;
+
+static CalibrationCache g_calibration = { 0 };
+
+/**
+ * @brief Injected-group measurement sharing ADC1 with the regular group.
+ */
+typedef struct {
+    ADC_LL_InjectedCallback callback; // Callback for finished measurements
+    uint32_t oversampling_ratio; // Conversions summed per measurement
+    uint32_t oversampling_shift; // Right shift of the sum
+    uint32_t volatile count; // Conversions accumulated so far
+    uint32_t volatile sum; // Sum of the accumulated conversions
+    bool volatile busy; // Measurement in progress
+    bool initialized; // Injected channel configured
+} InjectedMonitor;
+
+static InjectedMonitor g_injected = {
+    .callback = nullptr,
+    .oversampling_ratio = 1,
+    .oversampling_shift = 0,
+    .count = 0,
+    .sum = 0,
+    .busy = false,
     .initialized = false,
 };
 
+/**
+ * @brief Background VREFINT measurement on the ADC1 injected group.
+ *
+ * Uses the injected group while it is not configured for another channel,
+ * with polled conversions, so the ADC1 interrupt is left to the watchdog.
+ */
+typedef struct {
+    bool busy; // Conversion started, not yet read
+} ReferenceTracker;
+
+static ReferenceTracker g_reference = { .busy = false };
+
 /**
  * @brief Gets the GPIO pin configuration for a given ADC channel.
  *
@@ -289,23 +395,226 @@ static void ADC_DMA_ConvCpltCallback(DMA_HandleTypeDef *hdma)
 static void ADC_DMA_ErrorCallback(DMA_HandleTypeDef *hdma)
 {
     (void)hdma;
+    SET_BIT(g_hadc1.ErrorCode, HAL_ADC_ERROR_DMA);
     HAL_ADC_ErrorCallback(&g_hadc1);
 }
 
 /**
- * @brief Configures DMA handle with common settings for dual mode.
+ * @brief Channel interrupt of a circular capture, bypassing the HAL.
  *
- * @param hdma Pointer to DMA handle.
- * @param channel DMA channel instance.
- * @param request DMA request.
+ * The HAL path runs HAL_DMA_IRQHandler and the ADC HAL's DMA callbacks
+ * before reaching HAL_ADC_ConvCpltCallback; in circular mode their state
+ * bookkeeping does not apply, as the transfer never ends, so the flags are
+ * taken from the channel registers here and the block callbacks run
+ * directly. Errors go to the HAL handler as before, which reports them
+ * through the transfer error callback.
+ *
+ * @param hdma DMA handle of the capture.
+ */
+RAMFUNC static void adc_dma_fast_irq(DMA_HandleTypeDef *hdma)
+{
+    DMA_Channel_TypeDef *const channel = hdma->Instance;
+    uint32_t const flags = channel->CSR;
+    uint32_t const enabled = channel->CCR;
+
+    if ((flags & (DMA_CSR_DTEF | DMA_CSR_ULEF | DMA_CSR_USEF)) != 0) {
+        HAL_DMA_IRQHandler(hdma);
+        return;
+    }
+    // Same order as HAL_DMA_IRQHandler, so a late ISR sees the halves in turn
+    if ((flags & DMA_CSR_HTF) != 0 && (enabled & DMA_CCR_HTIE) != 0) {
+        channel->CFCR = DMA_CFCR_HTF;
+        HAL_ADC_ConvHalfCpltCallback(&g_hadc1);
+    }
+    if ((flags & DMA_CSR_TCF) != 0 && (enabled & DMA_CCR_TCIE) != 0) {
+        channel->CFCR = DMA_CFCR_TCF;
+        HAL_ADC_ConvCpltCallback(&g_hadc1);
+    }
+}
+
+/**
+ * @brief Initializes a DMA handle for linked-list operation.
+ *
+ * A single GPDMA block moves at most ADC_DMA_BLOCK_BYTES_MAX bytes, so the
+ * channel always runs a linked list, which build_dma_queue fills in on each
+ * start. GPDMA has no circular mode for plain transfers either; in circular
+ * mode the last node links back to the first.
+ *
+ * @param hdma Pointer to DMA handle with Init already populated.
+ */
+static void init_dma(DMA_HandleTypeDef *hdma)
+{
+    hdma->InitLinkedList.Priority = hdma->Init.Priority;
+    hdma->InitLinkedList.LinkStepMode = DMA_LSM_FULL_EXECUTION;
+    hdma->InitLinkedList.LinkAllocatedPort = DMA_LINK_ALLOCATED_PORT0;
+    hdma->InitLinkedList.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    hdma->InitLinkedList.LinkedListMode = g_adc_instance.circular
+                                              ? DMA_LINKEDLIST_CIRCULAR
+                                              : DMA_LINKEDLIST_NORMAL;
+
+    if (HAL_DMAEx_List_Init(hdma) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
+/**
+ * @brief Splits the output buffer over the linked-list DMA queue.
+ *
+ * Each node moves one block of at most ADC_DMA_BLOCK_BYTES_MAX bytes. In
+ * circular mode both halves of the buffer get the same number of nodes, so
+ * the first half completes on a block boundary, and every block raises a
+ * transfer complete event. Otherwise only the last block does.
+ *
+ * HAL_ADC_Start_DMA and HAL_ADCEx_MultiModeStart_DMA reprogram the head
+ * node with the same source, destination and length.
+ *
+ * @param hdma DMA handle linked to ADC1.
+ * @param source Address of the data register the DMA reads.
+ * @param first_block Set to the number of DMA transfers in the first node.
+ * @return ERROR_NONE, ERROR_INVALID_ARGUMENT if the buffer needs more nodes
+ *         than the queue holds, or ERROR_HARDWARE_FAULT if the HAL refuses
+ *         the queue.
  */
-static void configure_dual_mode_dma(
+static Error build_dma_queue(
     DMA_HandleTypeDef *hdma,
-    DMA_Channel_TypeDef *channel,
-    uint32_t request
+    uint32_t source,
+    uint32_t *first_block
 )
 {
-    hdma->Instance = channel;
+    ADCInstance *instance = &g_adc_instance;
+    uint32_t const width =
+        hdma->Init.SrcDataWidth == DMA_SRC_DATAWIDTH_WORD ? 4 : 2;
+    uint32_t const transfers =
+        (instance->buffer_size * sizeof(uint16_t)) / width;
+    uint32_t const block_max = ADC_DMA_BLOCK_BYTES_MAX / width;
+    uint32_t const spans = instance->circular && transfers > block_max ? 2 : 1;
+    uint32_t const span = transfers / spans;
+    uint32_t const per_span = (span + block_max - 1) / block_max;
+
+    if (spans * per_span > ADC_DMA_NODES_MAX) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    DMA_NodeConfTypeDef node_config = { 0 };
+    node_config.NodeType = DMA_GPDMA_LINEAR_NODE;
+    node_config.Init = hdma->Init;
+    node_config.Init.TransferEventMode = instance->circular
+                                             ? DMA_TCEM_BLOCK_TRANSFER
+                                             : DMA_TCEM_LAST_LL_ITEM_TRANSFER;
+    node_config.DataHandlingConfig.DataExchange = DMA_EXCHANGE_NONE;
+    node_config.DataHandlingConfig.DataAlignment =
+        DMA_DATA_RIGHTALIGN_ZEROPADDED;
+    node_config.TriggerConfig.TriggerPolarity = DMA_TRIG_POLARITY_MASKED;
+    node_config.SrcAddress = source;
+
+    if (hdma->LinkedListQueue != nullptr &&
+        HAL_DMAEx_List_UnLinkQ(hdma) != HAL_OK) {
+        return ERROR_HARDWARE_FAULT;
+    }
+    if (HAL_DMAEx_List_ResetQ(&g_dma_adc_queue) != HAL_OK) {
+        return ERROR_HARDWARE_FAULT;
+    }
+
+    uint8_t *const buffer = (uint8_t *)instance->buffer_data;
+    for (uint32_t i = 0; i < spans * per_span; ++i) {
+        uint32_t const base = (i / per_span) * span;
+        uint32_t const part = i % per_span;
+        uint32_t const first = base + ((part * span) / per_span);
+        uint32_t const last = base + (((part + 1) * span) / per_span);
+
+        node_config.DstAddress = (uint32_t)&buffer[first * width];
+        node_config.DataSize = (last - first) * width;
+        if (HAL_DMAEx_List_BuildNode(&node_config, &g_dma_adc_nodes[i]) !=
+                HAL_OK ||
+            HAL_DMAEx_List_InsertNode_Tail(
+                &g_dma_adc_queue, &g_dma_adc_nodes[i]
+            ) != HAL_OK) {
+            return ERROR_HARDWARE_FAULT;
+        }
+    }
+
+    if ((instance->circular &&
+         HAL_DMAEx_List_SetCircularMode(&g_dma_adc_queue) != HAL_OK) ||
+        HAL_DMAEx_List_LinkQ(hdma, &g_dma_adc_queue) != HAL_OK) {
+        return ERROR_HARDWARE_FAULT;
+    }
+
+    instance->dma_nodes = spans * per_span;
+    instance->dma_node = 0;
+    *first_block = span / per_span;
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Fills in the DMA settings left at their defaults.
+ *
+ * The dual modes run at up to twice the single-ADC rate, so they default to
+ * a high-priority channel that writes memory in bursts over its own port,
+ * keeping UART and USB traffic from delaying it into an ADC overrun.
+ *
+ * @param config ADC configuration being applied.
+ * @return Settings with every field resolved.
+ */
+static ADC_LL_DmaQos resolve_dma_qos(ADC_LL_Config const *config)
+{
+    bool const dual = config->mode == ADC_LL_MODE_SIMULTANEOUS ||
+                      config->mode == ADC_LL_MODE_INTERLEAVED;
+    ADC_LL_DmaQos qos = config->dma;
+
+    if (qos.priority == ADC_LL_DMA_PRIORITY_DEFAULT) {
+        qos.priority =
+            dual ? ADC_LL_DMA_PRIORITY_HIGH : ADC_LL_DMA_PRIORITY_LOW;
+    }
+    if (qos.burst_length == 0) {
+        qos.burst_length = dual ? ADC_LL_DMA_BURST_MAX : 1;
+    }
+    if (qos.ports == ADC_LL_DMA_PORTS_DEFAULT) {
+        qos.ports = dual ? ADC_LL_DMA_PORTS_SPLIT : ADC_LL_DMA_PORTS_SHARED;
+    }
+    return qos;
+}
+
+/**
+ * @brief Applies the resolved DMA settings to a DMA handle.
+ *
+ * @param hdma Pointer to DMA handle.
+ */
+static void apply_dma_qos(DMA_HandleTypeDef *hdma)
+{
+    ADC_LL_DmaQos const *qos = &g_adc_instance.dma_qos;
+
+    switch (qos->priority) {
+    case ADC_LL_DMA_PRIORITY_MEDIUM:
+        hdma->Init.Priority = DMA_LOW_PRIORITY_MID_WEIGHT;
+        break;
+    case ADC_LL_DMA_PRIORITY_ELEVATED:
+        hdma->Init.Priority = DMA_LOW_PRIORITY_HIGH_WEIGHT;
+        break;
+    case ADC_LL_DMA_PRIORITY_HIGH:
+        hdma->Init.Priority = DMA_HIGH_PRIORITY;
+        break;
+    default:
+        hdma->Init.Priority = DMA_LOW_PRIORITY_LOW_WEIGHT;
+        break;
+    }
+
+    // One beat per ADC request; the FIFO collects them into memory bursts
+    hdma->Init.SrcBurstLength = 1;
+    hdma->Init.DestBurstLength = qos->burst_length;
+    hdma->Init.TransferAllocatedPort =
+        qos->ports == ADC_LL_DMA_PORTS_SPLIT
+            ? (DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT1)
+            : (DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0);
+}
+
+/**
+ * @brief Configures DMA handle with common settings for dual mode.
+ *
+ * @param hdma Pointer to DMA handle, with a channel claimed.
+ * @param request DMA request.
+ */
+static void configure_dual_mode_dma(DMA_HandleTypeDef *hdma, uint32_t request)
+{
     hdma->Init.Request = request;
     hdma->Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
     hdma->Init.Direction = DMA_PERIPH_TO_MEMORY;
@@ -313,11 +622,7 @@ static void configure_dual_mode_dma(
     hdma->Init.DestInc = DMA_DINC_INCREMENTED;
     hdma->Init.SrcDataWidth = DMA_SRC_DATAWIDTH_WORD; // 32-bit for dual ADC
     hdma->Init.DestDataWidth = DMA_DEST_DATAWIDTH_WORD;
-    hdma->Init.Priority = DMA_LOW_PRIORITY_LOW_WEIGHT;
-    hdma->Init.SrcBurstLength = 1;
-    hdma->Init.DestBurstLength = 1;
-    hdma->Init.TransferAllocatedPort =
-        (DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0);
+    apply_dma_qos(hdma);
     hdma->Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
     hdma->Init.Mode = DMA_NORMAL;
 
@@ -327,26 +632,18 @@ static void configure_dual_mode_dma(
     hdma->XferCpltCallback = ADC_DMA_ConvCpltCallback;
     hdma->XferErrorCallback = ADC_DMA_ErrorCallback;
 
-    if (HAL_DMA_Init(hdma) != HAL_OK) {
-        THROW(ERROR_HARDWARE_FAULT);
-    }
+    init_dma(hdma);
     __HAL_LINKDMA(&g_hadc1, DMA_Handle, g_hdma_adc1_dual);
 }
 
 /**
  * @brief Configures DMA handle for single mode.
  *
- * @param hdma Pointer to DMA handle.
- * @param channel DMA channel instance.
+ * @param hdma Pointer to DMA handle, with a channel claimed.
  * @param request DMA request.
  */
-static void configure_single_mode_dma(
-    DMA_HandleTypeDef *hdma,
-    DMA_Channel_TypeDef *channel,
-    uint32_t request
-)
+static void configure_single_mode_dma(DMA_HandleTypeDef *hdma, uint32_t request)
 {
-    hdma->Instance = channel;
     hdma->Init.Request = request;
     hdma->Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
     hdma->Init.Direction = DMA_PERIPH_TO_MEMORY;
@@ -354,20 +651,48 @@ static void configure_single_mode_dma(
     hdma->Init.DestInc = DMA_DINC_INCREMENTED;
     hdma->Init.SrcDataWidth = DMA_SRC_DATAWIDTH_HALFWORD;
     hdma->Init.DestDataWidth = DMA_DEST_DATAWIDTH_HALFWORD;
-    hdma->Init.Priority = DMA_LOW_PRIORITY_LOW_WEIGHT;
-    hdma->Init.SrcBurstLength = 1;
-    hdma->Init.DestBurstLength = 1;
-    hdma->Init.TransferAllocatedPort =
-        (DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0);
+    apply_dma_qos(hdma);
     hdma->Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
     hdma->Init.Mode = DMA_NORMAL;
 
-    if (HAL_DMA_Init(hdma) != HAL_OK) {
-        THROW(ERROR_HARDWARE_FAULT);
-    }
+    init_dma(hdma);
     __HAL_LINKDMA(&g_hadc1, DMA_Handle, g_hdma_adc);
 }
 
+/**
+ * @brief Gets the number of regular ranks each ADC converts per trigger.
+ *
+ * @param instance Pointer to ADC instance structure.
+ * @return Sequence ranks per ADC, 1 when not scanning.
+ */
+static uint32_t sequence_ranks(ADCInstance const *instance)
+{
+    if (instance->mode == ADC_LL_MODE_SIMULTANEOUS) {
+        return instance->sequence_length / 2;
+    }
+    return instance->sequence_length;
+}
+
+/**
+ * @brief Gets the channel an ADC converts at a rank of the scan sequence.
+ *
+ * @param instance Pointer to ADC instance structure.
+ * @param adc ADC index, 0 for ADC1 and 1 for ADC2.
+ * @param rank Zero-based sequence rank.
+ * @return Channel at that rank.
+ */
+static ADC_LL_Channel sequence_channel(
+    ADCInstance const *instance,
+    uint32_t adc,
+    uint32_t rank
+)
+{
+    if (instance->mode == ADC_LL_MODE_SIMULTANEOUS) {
+        return instance->sequence[(rank * 2) + adc];
+    }
+    return instance->sequence[rank];
+}
+
 /**
  * @brief Initializes the ADC MSP (MCU Support Package).
  *
@@ -385,45 +710,48 @@ void HAL_ADC_MspInit(ADC_HandleTypeDef *hadc)
     __HAL_RCC_ADC_CLK_ENABLE();
 
     // Get pin configuration based on ADC instance
+    uint32_t adc = 0;
     if (hadc->Instance == ADC1) {
-        pin_config = get_pin_config(g_adc_instance.channels[0]);
+        adc = 0;
     } else if (hadc->Instance == ADC2) {
-        pin_config = get_pin_config(g_adc_instance.channels[1]);
+        adc = 1;
     } else {
         THROW(ERROR_INVALID_ARGUMENT);
     }
+    // Ranks after the first are only used when scanning
+    for (uint32_t i = 1; i < sequence_ranks(&g_adc_instance); ++i) {
+        pin_config = get_pin_config(sequence_channel(&g_adc_instance, adc, i));
+        configure_adc_gpio(&pin_config);
+    }
+    pin_config = get_pin_config(g_adc_instance.channels[adc]);
 
     // Configure GPIO pin for ADC input
     configure_adc_gpio(&pin_config);
 
-    // Enable DMA clock
-    __HAL_RCC_GPDMA1_CLK_ENABLE();
-
+    // Memory bursts of up to 4 words need the 32-byte FIFO
     if (g_adc_instance.mode == ADC_LL_MODE_SIMULTANEOUS ||
         g_adc_instance.mode == ADC_LL_MODE_INTERLEAVED) {
         // Dual mode configuration
         if (hadc->Instance == ADC1) {
             // Configure DMA for dual mode (both simultaneous and interleaved
             // use same settings)
-            configure_dual_mode_dma(
-                &g_hdma_adc1_dual, GPDMA1_Channel7, GPDMA1_REQUEST_ADC1
+            DMA_CHANNEL_claim(
+                &g_hdma_adc1_dual,
+                DMA_CHANNEL_CAP_LINKED_LIST | DMA_CHANNEL_CAP_FIFO_32,
+                IRQ_PRIORITY_ACQUISITION
             );
-
-            // Enable DMA interrupt
-            HAL_NVIC_SetPriority(GPDMA1_Channel7_IRQn, ADC_IRQ_PRIORITY, 1);
-            HAL_NVIC_EnableIRQ(GPDMA1_Channel7_IRQn);
+            configure_dual_mode_dma(&g_hdma_adc1_dual, GPDMA1_REQUEST_ADC1);
         }
         // Note: ADC2 in multimode is slave and doesn't need DMA or separate
         // interrupts
     } else {
         // Configure DMA for single mode
-        configure_single_mode_dma(
-            &g_hdma_adc, GPDMA1_Channel6, GPDMA1_REQUEST_ADC1
+        DMA_CHANNEL_claim(
+            &g_hdma_adc,
+            DMA_CHANNEL_CAP_LINKED_LIST | DMA_CHANNEL_CAP_FIFO_32,
+            IRQ_PRIORITY_ACQUISITION
         );
-
-        // Enable DMA interrupts
-        HAL_NVIC_SetPriority(GPDMA1_Channel6_IRQn, ADC_IRQ_PRIORITY, 1);
-        HAL_NVIC_EnableIRQ(GPDMA1_Channel6_IRQn);
+        configure_single_mode_dma(&g_hdma_adc, GPDMA1_REQUEST_ADC1);
     }
     LOG_FUNCTION_EXIT();
 }
@@ -442,6 +770,44 @@ static void validate_adc_config_structure(ADC_LL_Config const *config)
     if (config->output_buffer == nullptr) {
         THROW(ERROR_INVALID_ARGUMENT);
     }
+
+    // Each buffer half must hold a whole number of (32-bit) DMA transfers
+    if (config->circular && (config->buffer_size % 4) != 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    uint32_t const burst = config->dma.burst_length;
+    if (burst > ADC_LL_DMA_BURST_MAX || (burst & (burst - 1)) != 0 ||
+        config->dma.priority > ADC_LL_DMA_PRIORITY_HIGH ||
+        config->dma.ports > ADC_LL_DMA_PORTS_SPLIT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (config->mode > ADC_LL_MODE_INTERLEAVED ||
+        config->resolution > ADC_LL_RESOLUTION_8BIT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    // Scans fill whole sequences; simultaneous scans split them in pairs
+    if (config->sequence_length > 1 &&
+        (config->sequence_length > ADC_LL_SEQUENCE_MAX ||
+         config->mode == ADC_LL_MODE_INTERLEAVED ||
+         (config->mode == ADC_LL_MODE_SIMULTANEOUS &&
+          config->sequence_length % 2 != 0) ||
+         config->buffer_size % config->sequence_length != 0)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+/**
+ * @brief Bits of one conversion at a resolution.
+ *
+ * @param resolution Conversion resolution.
+ * @return 12, 10 or 8.
+ */
+static uint32_t resolution_bits(ADC_LL_Resolution resolution)
+{
+    return ADC_THRESHOLD_BITS - (2 * (uint32_t)resolution);
 }
 
 /**
@@ -457,6 +823,34 @@ static void validate_oversampling_ratio(uint32_t ratio)
     }
 }
 
+/**
+ * @brief Validates that oversampled results fit in 16 bits.
+ *
+ * The sum of ratio conversions has log2(ratio) more bits than one
+ * conversion; the data register keeps 16 of them after the shift.
+ *
+ * @param ratio Valid oversampling ratio.
+ * @param shift Right shift of the sum, 0 to 8.
+ * @param resolution Conversion resolution.
+ */
+static void validate_oversampling_shift(
+    uint32_t ratio,
+    uint32_t shift,
+    ADC_LL_Resolution resolution
+)
+{
+    uint32_t const max_bits = 16;
+    uint32_t const max_shift = 8;
+    uint32_t sum_bits = resolution_bits(resolution);
+
+    for (uint32_t r = ratio; r > 1; r >>= 1) {
+        ++sum_bits;
+    }
+    if (shift > max_shift || sum_bits > max_bits + shift) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
 /**
  * @brief Validates ADC configuration parameters.
  *
@@ -466,12 +860,25 @@ static void validate_adc_config(ADC_LL_Config const *config)
 {
     validate_adc_config_structure(config);
     validate_oversampling_ratio(config->oversampling_ratio);
+    validate_oversampling_shift(
+        config->oversampling_ratio,
+        config->oversampling_shift,
+        config->resolution
+    );
 
     if (g_adc_instance.initialized) {
         THROW(ERROR_RESOURCE_BUSY);
     }
 }
 
+static uint32_t select_sample_time(
+    ADC_LL_Mode mode,
+    ADC_LL_Resolution resolution,
+    uint32_t conversion_rate
+);
+
+static uint32_t get_hal_clock_prescaler(uint32_t prescaler);
+
 /**
  * @brief Initializes ADC instance with configuration data.
  *
@@ -485,13 +892,52 @@ static void initialize_adc_instance(ADC_LL_Config const *config)
     for (int i = 0; i < num_channels; i++) {
         instance->channels[i] = config->channels[i];
     }
+    instance->sequence_length = 1;
+    if (config->sequence_length > 1) {
+        for (uint32_t i = 0; i < config->sequence_length; ++i) {
+            instance->sequence[i] = config->sequence[i];
+        }
+        instance->sequence_length = config->sequence_length;
+        instance->channels[0] = config->sequence[0];
+        if (config->mode == ADC_LL_MODE_SIMULTANEOUS) {
+            instance->channels[1] = config->sequence[1];
+        }
+    }
     instance->buffer_data = config->output_buffer;
     instance->mode = config->mode;
     instance->buffer_size = config->buffer_size;
     instance->oversampling_ratio = config->oversampling_ratio;
+    instance->oversampling_shift = config->oversampling_shift;
+    instance->resolution = config->resolution;
+    instance->sample_time = select_sample_time(
+        config->mode, config->resolution, config->conversion_rate
+    );
+    instance->clock_prescaler =
+        get_hal_clock_prescaler(g_mode_clocks[config->mode].prescaler);
+    instance->circular = config->circular;
+    instance->dma_qos = resolve_dma_qos(config);
     instance->initialized = true; // Set before MSP init to configure mode
 }
 
+/**
+ * @brief Converts ADC_LL_Resolution to HAL resolution constant.
+ *
+ * @param resolution ADC_LL_Resolution enum value.
+ * @return Corresponding HAL resolution constant.
+ */
+static uint32_t get_hal_resolution(ADC_LL_Resolution resolution)
+{
+    switch (resolution) {
+    case ADC_LL_RESOLUTION_10BIT:
+        return ADC_RESOLUTION_10B;
+    case ADC_LL_RESOLUTION_8BIT:
+        return ADC_RESOLUTION_8B;
+    case ADC_LL_RESOLUTION_12BIT:
+    default:
+        return ADC_RESOLUTION_12B;
+    }
+}
+
 /**
  * @brief Converts numeric oversampling ratio to HAL constant.
  *
@@ -522,22 +968,42 @@ static uint32_t get_hal_oversampling_ratio(uint32_t ratio)
     }
 }
 
+/**
+ * @brief Converts a numeric oversampling right shift to HAL constant.
+ *
+ * @param shift Right shift, 0 to 8.
+ * @return Corresponding HAL right bit shift constant.
+ */
+static uint32_t get_hal_right_bit_shift(uint32_t shift)
+{
+    static uint32_t const shifts[] = {
+        ADC_RIGHTBITSHIFT_NONE, ADC_RIGHTBITSHIFT_1, ADC_RIGHTBITSHIFT_2,
+        ADC_RIGHTBITSHIFT_3,    ADC_RIGHTBITSHIFT_4, ADC_RIGHTBITSHIFT_5,
+        ADC_RIGHTBITSHIFT_6,    ADC_RIGHTBITSHIFT_7, ADC_RIGHTBITSHIFT_8,
+    };
+    return shift < sizeof(shifts) / sizeof(shifts[0]) ? shifts[shift]
+                                                      : ADC_RIGHTBITSHIFT_NONE;
+}
+
 /**
  * @brief Configures oversampling for an ADC handle.
  *
  * @param adc_handle ADC handle to configure.
  * @param oversampling_ratio Oversampling ratio to apply.
+ * @param oversampling_shift Right shift of the oversampled sum.
  */
 static void configure_adc_oversampling(
     ADC_HandleTypeDef *adc_handle,
-    uint32_t oversampling_ratio
+    uint32_t oversampling_ratio,
+    uint32_t oversampling_shift
 )
 {
     if (oversampling_ratio > 1) {
         adc_handle->Init.OversamplingMode = ENABLE;
         adc_handle->Init.Oversampling.Ratio =
             get_hal_oversampling_ratio(oversampling_ratio);
-        adc_handle->Init.Oversampling.RightBitShift = ADC_RIGHTBITSHIFT_4;
+        adc_handle->Init.Oversampling.RightBitShift =
+            get_hal_right_bit_shift(oversampling_shift);
         adc_handle->Init.Oversampling.TriggeredMode =
             ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
         adc_handle->Init.Oversampling.OversamplingStopReset =
@@ -554,17 +1020,24 @@ static void configure_adc_oversampling(
  */
 static void set_common_adc_init_params(ADC_HandleTypeDef *adc_handle)
 {
-    adc_handle->Init.ClockPrescaler = ADC_CLOCK_ASYNC_DIV1;
-    adc_handle->Init.Resolution = ADC_RESOLUTION_12B;
+    adc_handle->Init.ClockPrescaler = g_adc_instance.clock_prescaler;
+    adc_handle->Init.Resolution = get_hal_resolution(g_adc_instance.resolution);
     adc_handle->Init.DataAlign = ADC_DATAALIGN_RIGHT;
     adc_handle->Init.ScanConvMode = DISABLE;
     adc_handle->Init.EOCSelection = ADC_EOC_SINGLE_CONV;
     adc_handle->Init.LowPowerAutoWait = DISABLE;
     adc_handle->Init.ContinuousConvMode = DISABLE;
     adc_handle->Init.NbrOfConversion = 1;
+    if (sequence_ranks(&g_adc_instance) > 1) {
+        // One trigger converts the whole sequence
+        adc_handle->Init.ScanConvMode = ADC_SCAN_ENABLE;
+        adc_handle->Init.NbrOfConversion = sequence_ranks(&g_adc_instance);
+    }
     adc_handle->Init.DiscontinuousConvMode = DISABLE;
     adc_handle->Init.SamplingMode = ADC_SAMPLING_MODE_NORMAL;
-    adc_handle->Init.DMAContinuousRequests = DISABLE;
+    // Keep issuing DMA requests after the DMA wraps in circular mode
+    adc_handle->Init.DMAContinuousRequests =
+        g_adc_instance.circular ? ENABLE : DISABLE;
     adc_handle->Init.Overrun = ADC_OVR_DATA_PRESERVED;
 }
 
@@ -586,7 +1059,9 @@ static void configure_adc1_init(ADC_LL_Config const *config)
         ADC_EXTERNALTRIGCONVEDGE_RISING;
 
     configure_adc_oversampling(
-        instance->adc_handles[0], config->oversampling_ratio
+        instance->adc_handles[0],
+        config->oversampling_ratio,
+        config->oversampling_shift
     );
 }
 
@@ -616,7 +1091,9 @@ static void configure_adc2_init(ADC_LL_Config const *config)
     }
 
     configure_adc_oversampling(
-        instance->adc_handles[1], config->oversampling_ratio
+        instance->adc_handles[1],
+        config->oversampling_ratio,
+        config->oversampling_shift
     );
 }
 
@@ -626,17 +1103,19 @@ static void configure_adc2_init(ADC_LL_Config const *config)
  * @param adc_handle ADC handle to configure.
  * @param channel_config ADC channel configuration structure.
  * @param channel ADC channel to configure.
+ * @param rank Regular sequencer rank (ADC_REGULAR_RANK_x).
  */
 static void configure_adc_channel(
     ADC_HandleTypeDef *adc_handle,
     ADC_ChannelConfTypeDef *channel_config,
-    ADC_LL_Channel channel
+    ADC_LL_Channel channel,
+    uint32_t rank
 )
 {
     *channel_config = (ADC_ChannelConfTypeDef){ 0 };
     channel_config->Channel = get_hal_adc_channel(channel);
-    channel_config->Rank = ADC_REGULAR_RANK_1;
-    channel_config->SamplingTime = ADC_SAMPLETIME_92CYCLES_5;
+    channel_config->Rank = rank;
+    channel_config->SamplingTime = g_adc_instance.sample_time;
     channel_config->SingleDiff = ADC_SINGLE_ENDED;
     channel_config->OffsetNumber = ADC_OFFSET_NONE;
     channel_config->Offset = 0;
@@ -646,6 +1125,39 @@ static void configure_adc_channel(
     }
 }
 
+/**
+ * @brief Configures regular ranks 2 and up of a scan sequence.
+ *
+ * Rank 1 holds the first sequence channel of each ADC and is configured
+ * like any single-channel or simultaneous acquisition.
+ *
+ * @param instance Pointer to ADC instance structure.
+ */
+static void configure_sequence(ADCInstance const *instance)
+{
+    static uint32_t const ranks[ADC_LL_SEQUENCE_MAX] = {
+        ADC_REGULAR_RANK_1,  ADC_REGULAR_RANK_2,  ADC_REGULAR_RANK_3,
+        ADC_REGULAR_RANK_4,  ADC_REGULAR_RANK_5,  ADC_REGULAR_RANK_6,
+        ADC_REGULAR_RANK_7,  ADC_REGULAR_RANK_8,  ADC_REGULAR_RANK_9,
+        ADC_REGULAR_RANK_10, ADC_REGULAR_RANK_11, ADC_REGULAR_RANK_12,
+        ADC_REGULAR_RANK_13, ADC_REGULAR_RANK_14, ADC_REGULAR_RANK_15,
+        ADC_REGULAR_RANK_16,
+    };
+    ADC_ChannelConfTypeDef rank_config = { 0 };
+    uint32_t const adcs = instance->mode == ADC_LL_MODE_SIMULTANEOUS ? 2 : 1;
+
+    for (uint32_t adc = 0; adc < adcs; ++adc) {
+        for (uint32_t i = 1; i < sequence_ranks(instance); ++i) {
+            configure_adc_channel(
+                instance->adc_handles[adc],
+                &rank_config,
+                sequence_channel(instance, adc, i),
+                ranks[i]
+            );
+        }
+    }
+}
+
 /**
  * @brief Configures dual mode (simultaneous or interleaved) settings.
  *
@@ -668,6 +1180,36 @@ static void configure_dual_mode(ADC_LL_Config const *config)
     }
 }
 
+/**
+ * @brief Configures analog watchdog 1 to monitor a regular channel.
+ *
+ * The watchdog is left with a full-scale window and its interrupt disabled;
+ * ADC_LL_arm_watchdog sets the thresholds and enables it.
+ *
+ * @param channel ADC channel to monitor.
+ */
+static void configure_watchdog(ADC_LL_Channel channel)
+{
+    ADC_AnalogWDGConfTypeDef awd_config = { 0 };
+
+    awd_config.WatchdogNumber = ADC_ANALOGWATCHDOG_1;
+    awd_config.WatchdogMode = ADC_ANALOGWATCHDOG_SINGLE_REG;
+    awd_config.Channel = get_hal_adc_channel(channel);
+    awd_config.ITMode = DISABLE;
+    // The HAL shifts thresholds from the configured resolution to 12 bits
+    awd_config.HighThreshold =
+        (1U << resolution_bits(g_adc_instance.resolution)) - 1;
+    awd_config.LowThreshold = 0;
+    awd_config.FilteringConfig = ADC_AWD_FILTERING_NONE;
+
+    if (HAL_ADC_AnalogWDGConfig(&g_hadc1, &awd_config) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    HAL_NVIC_SetPriority(ADC1_IRQn, IRQ_PRIORITY_ACQUISITION, 0);
+    HAL_NVIC_EnableIRQ(ADC1_IRQn);
+}
+
 /**
  * @brief Calculates VDDA (analog supply voltage) using the internal VREFINT
  * channel.
@@ -750,9 +1292,11 @@ static void read_vdda_voltage(ADCInstance *instance)
 
     // Calculate VDDA (analog supply voltage) using the HAL macro
     // This macro calculates: VDDA = (VREFINT_CAL * 3300) / ADC_DATA
-    // where VREFINT_CAL is the factory calibration value when VDDA was 3.3V
-    uint32_t calculated_vdda =
-        __HAL_ADC_CALC_VREFANALOG_VOLTAGE(vref_adc_value, ADC_RESOLUTION_12B);
+    // where VREFINT_CAL is the factory calibration value when VDDA was 3.3V,
+    // with ADC_DATA scaled up to 12 bits from the configured resolution
+    uint32_t calculated_vdda = __HAL_ADC_CALC_VREFANALOG_VOLTAGE(
+        vref_adc_value, g_hadc1.Init.Resolution
+    );
     LOG_DEBUG("Calculated VDDA using HAL macro: %lu mV", calculated_vdda);
     LOG_DEBUG("VREFINT_CAL factory value: %lu", (uint32_t)(*VREFINT_CAL_ADDR));
 
@@ -761,6 +1305,56 @@ static void read_vdda_voltage(ADCInstance *instance)
     LOG_FUNCTION_EXIT();
 }
 
+/**
+ * @brief Checks whether a cached calibration result may still be used.
+ *
+ * @param valid Whether the result has been measured at all.
+ * @param tick Time of the measurement in milliseconds.
+ * @return true if the result is younger than the validity window.
+ */
+static bool calibration_is_fresh(bool valid, uint32_t tick)
+{
+    return valid &&
+           (PLATFORM_get_tick() - tick) < ADC_CALIBRATION_VALIDITY_MS;
+}
+
+/**
+ * @brief Calibrates one ADC, reusing a recent calibration factor.
+ *
+ * Writing the calibration factor requires an enabled ADC, but the dual
+ * mode configuration that follows requires both ADCs to be disabled, so
+ * the ADC is disabled again afterwards.
+ *
+ * @param hadc ADC handle to calibrate.
+ * @param index Index of the ADC in the calibration cache.
+ */
+static void calibrate_single_adc(ADC_HandleTypeDef *hadc, uint32_t index)
+{
+    CalibrationCache *cache = &g_calibration;
+
+    if (calibration_is_fresh(
+            cache->factor_valid[index], cache->factor_ticks[index]
+        )) {
+        if (ADC_Enable(hadc) != HAL_OK ||
+            HAL_ADCEx_Calibration_SetValue(
+                hadc, ADC_SINGLE_ENDED, cache->factors[index]
+            ) != HAL_OK ||
+            ADC_Disable(hadc) != HAL_OK) {
+            THROW(ERROR_HARDWARE_FAULT);
+        }
+        return;
+    }
+
+    if (HAL_ADCEx_Calibration_Start(hadc, ADC_SINGLE_ENDED) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    cache->factors[index] =
+        HAL_ADCEx_Calibration_GetValue(hadc, ADC_SINGLE_ENDED);
+    cache->factor_ticks[index] = PLATFORM_get_tick();
+    cache->factor_valid[index] = true;
+}
+
 /**
  * @brief Performs ADC calibration for configured ADCs.
  *
@@ -773,46 +1367,139 @@ static void calibrate_adc(ADC_LL_Config const *config)
 {
     LOG_FUNCTION_ENTRY();
 
-    if (HAL_ADCEx_Calibration_Start(&g_hadc1, ADC_SINGLE_ENDED) != HAL_OK) {
-        THROW(ERROR_HARDWARE_FAULT);
-    }
+    calibrate_single_adc(&g_hadc1, 0);
 
     if (config->mode == ADC_LL_MODE_SIMULTANEOUS ||
         config->mode == ADC_LL_MODE_INTERLEAVED) {
-        if (HAL_ADCEx_Calibration_Start(&g_hadc2, ADC_SINGLE_ENDED) != HAL_OK) {
-            THROW(ERROR_HARDWARE_FAULT);
-        }
+        calibrate_single_adc(&g_hadc2, 1);
     }
 
     LOG_FUNCTION_EXIT();
 }
 
 /**
- * @brief Initializes the ADC peripheral(s).
+ * @brief Determines VDDA, reusing a recent measurement.
  *
- * This function configures the ADC peripheral(s) with the specified settings.
- * For single-channel mode, only ADC1 is used. For dual-channel modes,
- * both ADC1 and ADC2 are configured.
- * The ADC uses timer-triggered conversions with DMA for all operations.
- * Oversampling is available for all configurations.
+ * @param instance Pointer to ADC instance structure.
  */
-void ADC_LL_init(ADC_LL_Config const *config)
+static void update_vdda_voltage(ADCInstance *instance)
 {
-    LOG_FUNCTION_ENTRY();
-
-    validate_adc_config(config);
-    initialize_adc_instance(config);
+    CalibrationCache *cache = &g_calibration;
 
-    ADCInstance *instance = &g_adc_instance;
+    if (calibration_is_fresh(cache->vdda_valid, cache->vdda_tick)) {
+        instance->vref_mv = cache->vdda_mv;
+        return;
+    }
 
-    // Set ADC instances first (required for calibration)
-    g_hadc1.Instance = ADC1;
-    g_hadc2.Instance = ADC2;
+    read_vdda_voltage(instance);
 
-    // Configure ADC1 parameters
-    configure_adc1_init(config);
+    cache->vdda_mv = instance->vref_mv;
+    cache->vdda_tick = PLATFORM_get_tick();
+    cache->vdda_valid = true;
+}
 
-    // Configure ADC2 parameters for dual modes
+/**
+ * @brief Configures VREFINT on rank 1 of the ADC1 injected group.
+ *
+ * Only called while no conversion is ongoing.
+ *
+ * @return true on success.
+ */
+static bool configure_reference_channel(void)
+{
+    ADC_InjectionConfTypeDef injected_config = { 0 };
+
+    injected_config.InjectedChannel = ADC_CHANNEL_VREFINT;
+    injected_config.InjectedRank = ADC_INJECTED_RANK_1;
+    // Longer sampling for internal channels
+    injected_config.InjectedSamplingTime = ADC_SAMPLETIME_247CYCLES_5;
+    injected_config.InjectedSingleDiff = ADC_SINGLE_ENDED;
+    injected_config.InjectedOffsetNumber = ADC_OFFSET_NONE;
+    injected_config.InjectedOffset = 0;
+    injected_config.InjectedNbrOfConversion = 1;
+    injected_config.InjectedDiscontinuousConvMode = DISABLE;
+    injected_config.AutoInjectedConv = DISABLE;
+    injected_config.QueueInjectedContext = DISABLE;
+    injected_config.ExternalTrigInjecConv = ADC_INJECTED_SOFTWARE_START;
+    injected_config.ExternalTrigInjecConvEdge =
+        ADC_EXTERNALTRIGINJECCONV_EDGE_NONE;
+    injected_config.InjecOversamplingMode = DISABLE;
+
+    return HAL_ADCEx_InjectedConfigChannel(&g_hadc1, &injected_config) ==
+           HAL_OK;
+}
+
+/**
+ * @brief Stops a tracking conversion in flight, discarding it.
+ *
+ * HAL_ADCEx_InjectedStop disables the ADC again, as the regular group is
+ * not converting while tracking.
+ */
+static void reference_abort(void)
+{
+    if (!g_reference.busy) {
+        return;
+    }
+
+    HAL_ADCEx_InjectedStop(&g_hadc1);
+    __HAL_ADC_CLEAR_FLAG(&g_hadc1, ADC_FLAG_JEOC | ADC_FLAG_JEOS);
+    g_reference.busy = false;
+}
+
+/**
+ * @brief Filters a VREFINT conversion into the reference voltage.
+ *
+ * The result also replaces the VDDA measurement kept for the next
+ * ADC_LL_init, which then need not measure it again.
+ *
+ * @param value VREFINT conversion at the configured resolution.
+ */
+static void reference_update(uint32_t value)
+{
+    ADCInstance *instance = &g_adc_instance;
+    CalibrationCache *cache = &g_calibration;
+
+    int32_t const measured_mv = (int32_t)__HAL_ADC_CALC_VREFANALOG_VOLTAGE(
+        value, g_hadc1.Init.Resolution
+    );
+    int32_t const previous_mv = (int32_t)instance->vref_mv;
+    int32_t const step = (measured_mv - previous_mv) / ADC_REFERENCE_FILTER;
+
+    instance->vref_mv =
+        (uint32_t)(previous_mv > 0 ? previous_mv + step : measured_mv);
+    cache->vdda_mv = instance->vref_mv;
+    cache->vdda_tick = PLATFORM_get_tick();
+    cache->vdda_valid = true;
+}
+
+/**
+ * @brief Initializes the ADC peripheral(s).
+ *
+ * This function configures the ADC peripheral(s) with the specified settings.
+ * For single-channel mode, only ADC1 is used. For dual-channel modes,
+ * both ADC1 and ADC2 are configured.
+ * The ADC uses timer-triggered conversions with DMA for all operations.
+ * Oversampling is available for all configurations.
+ */
+void ADC_LL_init(ADC_LL_Config const *config)
+{
+    LOG_FUNCTION_ENTRY();
+
+    validate_adc_config(config);
+    // The ADCs are disabled, so the kernel clock of the mode can be set
+    PLATFORM_set_adc_clock_divider(g_mode_clocks[config->mode].kernel_divider);
+    initialize_adc_instance(config);
+
+    ADCInstance *instance = &g_adc_instance;
+
+    // Set ADC instances first (required for calibration)
+    g_hadc1.Instance = ADC1;
+    g_hadc2.Instance = ADC2;
+
+    // Configure ADC1 parameters
+    configure_adc1_init(config);
+
+    // Configure ADC2 parameters for dual modes
     if (config->mode == ADC_LL_MODE_SIMULTANEOUS ||
         config->mode == ADC_LL_MODE_INTERLEAVED) {
         configure_adc2_init(config);
@@ -835,24 +1522,34 @@ void ADC_LL_init(ADC_LL_Config const *config)
     calibrate_adc(config);
 
     // Read VDDA voltage
-    read_vdda_voltage(instance);
+    update_vdda_voltage(instance);
 
     // Configure channels
     configure_adc_channel(
-        instance->adc_handles[0], &g_config, config->channels[0]
+        instance->adc_handles[0],
+        &g_config,
+        instance->channels[0],
+        ADC_REGULAR_RANK_1
     );
+    configure_sequence(instance);
+    configure_watchdog(instance->channels[0]);
 
     // Configure ADC2 channel and dual mode for dual modes
     if (config->mode == ADC_LL_MODE_SIMULTANEOUS ||
         config->mode == ADC_LL_MODE_INTERLEAVED) {
         configure_adc_channel(
-            instance->adc_handles[1], &g_config2, config->channels[1]
+            instance->adc_handles[1],
+            &g_config2,
+            instance->channels[1],
+            ADC_REGULAR_RANK_1
         );
 
         configure_dual_mode(config);
     }
 }
 
+bool ADC_LL_is_initialized(void) { return g_adc_instance.initialized; }
+
 /**
  * @brief Deinitializes the ADC peripheral(s).
  *
@@ -865,6 +1562,10 @@ void ADC_LL_deinit(void)
 
     ADCInstance *instance = &g_adc_instance;
 
+    // The injected channel cannot outlive the ADC it shares
+    reference_abort();
+    ADC_LL_injected_deinit();
+
     // Stop ADC conversions based on mode
     if (instance->mode == ADC_LL_MODE_SIMULTANEOUS ||
         instance->mode == ADC_LL_MODE_INTERLEAVED) {
@@ -880,9 +1581,15 @@ void ADC_LL_deinit(void)
     if (instance->mode == ADC_LL_MODE_SIMULTANEOUS ||
         instance->mode == ADC_LL_MODE_INTERLEAVED) {
         HAL_NVIC_DisableIRQ(ADC2_IRQn);
-        HAL_NVIC_DisableIRQ(GPDMA1_Channel7_IRQn);
+        DMA_CHANNEL_release(&g_hdma_adc1_dual);
     } else {
-        HAL_NVIC_DisableIRQ(GPDMA1_Channel6_IRQn);
+        DMA_CHANNEL_release(&g_hdma_adc);
+    }
+
+    if (g_hadc1.DMA_Handle != nullptr &&
+        g_hadc1.DMA_Handle->LinkedListQueue != nullptr) {
+        HAL_DMAEx_List_UnLinkQ(g_hadc1.DMA_Handle);
+        HAL_DMAEx_List_ResetQ(&g_dma_adc_queue);
     }
 
     // Deinitialize ADC peripherals
@@ -901,57 +1608,101 @@ void ADC_LL_deinit(void)
     for (int i = 0; i < MAX_SIMULTANEOUS_CHANNELS; i++) {
         instance->channels[i] = ADC_LL_CHANNEL_0;
     }
+    instance->sequence_length = 1;
     instance->buffer_size = 0;
     instance->complete_callback = nullptr;
+    instance->half_complete_callback = nullptr;
+    instance->watchdog_callback = nullptr;
     instance->mode = ADC_LL_MODE_SINGLE;
     instance->oversampling_ratio = 1;
+    instance->oversampling_shift = 0;
+    instance->resolution = ADC_LL_RESOLUTION_12BIT;
+    instance->sample_time = ADC_SAMPLETIME_92CYCLES_5;
     instance->vref_mv = 0;
+    instance->circular = false;
+    instance->dma_nodes = 0;
     instance->initialized = false;
 }
 
 /**
- * @brief Starts ADC conversion(s).
+ * @brief Starts ADC conversion(s), returning failures instead of throwing.
  *
  * Starts timer-triggered conversions with DMA.
  *
+ * @return ERROR_NONE, or the error ADC_LL_start would throw.
  */
-void ADC_LL_start(void)
+Error ADC_LL_try_start(void)
 {
     if (!g_adc_instance.initialized) {
-        THROW(ERROR_RESOURCE_UNAVAILABLE);
+        return ERROR_RESOURCE_UNAVAILABLE;
     }
 
+    // A tracking conversion would delay the first trigger
+    reference_abort();
+
     __HAL_ADC_CLEAR_FLAG(&g_hadc1, ADC_FLAG_EOC | ADC_FLAG_EOS | ADC_FLAG_OVR);
     __HAL_ADC_CLEAR_FLAG(&g_hadc2, ADC_FLAG_EOC | ADC_FLAG_EOS | ADC_FLAG_OVR);
     g_hadc1.State = HAL_ADC_STATE_READY;
     g_hadc2.State = HAL_ADC_STATE_READY;
 
+    // One-shot captures end the transfer, which the HAL has to track
+    DMA_CHANNEL_set_handler(
+        g_hadc1.DMA_Handle, g_adc_instance.circular ? adc_dma_fast_irq : nullptr
+    );
+
+    uint32_t first_block = 0;
+    Error error = ERROR_NONE;
     if (g_adc_instance.mode == ADC_LL_MODE_SIMULTANEOUS ||
         g_adc_instance.mode == ADC_LL_MODE_INTERLEAVED) {
-        // For dual mode DMA with 32-bit transfers, buffer_size should be in
-        // 32-bit words Each 32-bit word contains 2x 16-bit ADC samples (ADC1 +
-        // ADC2)
-        uint32_t dma_transfer_count = g_adc_instance.buffer_size / 2;
+        // For dual mode DMA with 32-bit transfers, the DMA moves 32-bit
+        // words from the common data register. Each 32-bit word contains
+        // 2x 16-bit ADC samples (ADC1 + ADC2)
+        error = build_dma_queue(
+            g_hadc1.DMA_Handle,
+            (uint32_t)&__LL_ADC_COMMON_INSTANCE(g_hadc1.Instance)->CDR,
+            &first_block
+        );
+        if (error != ERROR_NONE) {
+            return error;
+        }
 
         // Start multimode DMA conversion (both simultaneous and interleaved use
         // multimode)
         if (HAL_ADCEx_MultiModeStart_DMA(
-                &g_hadc1,
-                (uint32_t *)g_adc_instance.buffer_data,
-                dma_transfer_count
+                &g_hadc1, (uint32_t *)g_adc_instance.buffer_data, first_block
             ) != HAL_OK) {
-            THROW(ERROR_HARDWARE_FAULT);
+            return ERROR_HARDWARE_FAULT;
         }
     } else {
         // Single mode DMA conversion
+        error = build_dma_queue(
+            g_hadc1.DMA_Handle, (uint32_t)&g_hadc1.Instance->DR, &first_block
+        );
+        if (error != ERROR_NONE) {
+            return error;
+        }
+
         if (HAL_ADC_Start_DMA(
-                &g_hadc1,
-                (uint32_t *)g_adc_instance.buffer_data,
-                g_adc_instance.buffer_size
+                &g_hadc1, (uint32_t *)g_adc_instance.buffer_data, first_block
             ) != HAL_OK) {
-            THROW(ERROR_HARDWARE_FAULT);
+            return ERROR_HARDWARE_FAULT;
         }
     }
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Starts ADC conversion(s).
+ *
+ * Starts timer-triggered conversions with DMA.
+ *
+ */
+void ADC_LL_start(void)
+{
+    Error const error = ADC_LL_try_start();
+    if (error != ERROR_NONE) {
+        THROW(error);
+    }
 }
 
 /**
@@ -966,6 +1717,8 @@ void ADC_LL_stop(void)
         return;
     }
 
+    ADC_LL_disarm_watchdog();
+
     g_hadc1.State = HAL_ADC_STATE_RESET;
     g_hadc2.State = HAL_ADC_STATE_RESET;
 
@@ -979,6 +1732,73 @@ void ADC_LL_stop(void)
     }
 }
 
+/**
+ * @brief Restarts ADC conversion(s) into a different output buffer,
+ * returning failures instead of throwing.
+ *
+ * ADC_LL_try_start rebuilds the DMA queue for the new buffer, so the
+ * circular DMA wraps within it.
+ *
+ * @param buffer New output buffer.
+ * @param buffer_size New buffer size (number of samples per channel).
+ * @return ERROR_NONE, or the error ADC_LL_restart would throw.
+ */
+Error ADC_LL_try_restart(uint16_t *buffer, uint32_t buffer_size)
+{
+    if (!g_adc_instance.initialized) {
+        return ERROR_RESOURCE_UNAVAILABLE;
+    }
+    if (buffer == nullptr || buffer_size == 0 ||
+        (g_adc_instance.circular && (buffer_size % 4) != 0)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    ADC_LL_stop();
+    g_adc_instance.buffer_data = buffer;
+    g_adc_instance.buffer_size = buffer_size;
+    return ADC_LL_try_start();
+}
+
+/**
+ * @brief Restarts ADC conversion(s) into a different output buffer.
+ *
+ * @param buffer New output buffer.
+ * @param buffer_size New buffer size (number of samples per channel).
+ */
+void ADC_LL_restart(uint16_t *buffer, uint32_t buffer_size)
+{
+    Error const error = ADC_LL_try_restart(buffer, buffer_size);
+    if (error != ERROR_NONE) {
+        THROW(error);
+    }
+}
+
+/**
+ * @brief Changes the output buffer used by the next ADC_LL_start.
+ *
+ * The DMA is programmed with the buffer on every start, so only the
+ * instance needs updating.
+ *
+ * @param buffer New output buffer.
+ * @param buffer_size New buffer size (number of samples per channel).
+ */
+void ADC_LL_set_output_buffer(uint16_t *buffer, uint32_t buffer_size)
+{
+    if (!g_adc_instance.initialized) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+    if (buffer == nullptr || buffer_size == 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    // Each buffer half must hold a whole number of (32-bit) DMA transfers
+    if (g_adc_instance.circular && (buffer_size % 4) != 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    g_adc_instance.buffer_data = buffer;
+    g_adc_instance.buffer_size = buffer_size;
+}
+
 /**
  * @brief Sets the callback for ADC completion events.
  *
@@ -992,6 +1812,319 @@ void ADC_LL_set_complete_callback(ADC_LL_CompleteCallback callback)
     g_adc_instance.complete_callback = callback;
 }
 
+/**
+ * @brief Sets the callback for ADC half-complete events.
+ *
+ * Only invoked in circular mode, once the first half of the output buffer
+ * has been filled.
+ *
+ * @param callback Pointer to the callback function to be set.
+ */
+void ADC_LL_set_half_complete_callback(ADC_LL_CompleteCallback callback)
+{
+    g_adc_instance.half_complete_callback = callback;
+}
+
+/**
+ * @brief Sets the callback for analog watchdog events.
+ *
+ * @param callback Pointer to the callback function to be set.
+ */
+void ADC_LL_set_watchdog_callback(ADC_LL_WatchdogCallback callback)
+{
+    g_adc_instance.watchdog_callback = callback;
+}
+
+/**
+ * @brief Arms analog watchdog 1 with a new window.
+ *
+ * The thresholds may be updated while conversions are running. A stale
+ * event from a previous window is cleared before the interrupt is enabled.
+ *
+ * @param low Lower window threshold.
+ * @param high Upper window threshold.
+ */
+void ADC_LL_arm_watchdog(uint16_t low, uint16_t high)
+{
+    if (!g_adc_instance.initialized) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+
+    // The register takes 12-bit values whose bits below the configured
+    // resolution are kept clear, as the HAL leaves them in configure_watchdog
+    uint32_t const shift =
+        ADC_THRESHOLD_BITS - resolution_bits(g_adc_instance.resolution);
+    uint32_t const max =
+        ((1U << ADC_THRESHOLD_BITS) - 1) & ~((1U << shift) - 1);
+    uint32_t const high_code = (high > max ? max : high) & max;
+    uint32_t const low_code = (low > max ? max : low) & max;
+
+    __HAL_ADC_DISABLE_IT(&g_hadc1, ADC_IT_AWD1);
+    LL_ADC_ConfigAnalogWDThresholds(
+        g_hadc1.Instance, LL_ADC_AWD1, high_code, low_code
+    );
+    __HAL_ADC_CLEAR_FLAG(&g_hadc1, ADC_FLAG_AWD1);
+    __HAL_ADC_ENABLE_IT(&g_hadc1, ADC_IT_AWD1);
+}
+
+/**
+ * @brief Disarms analog watchdog 1.
+ */
+void ADC_LL_disarm_watchdog(void)
+{
+    if (!g_adc_instance.initialized) {
+        return;
+    }
+
+    __HAL_ADC_DISABLE_IT(&g_hadc1, ADC_IT_AWD1);
+    __HAL_ADC_CLEAR_FLAG(&g_hadc1, ADC_FLAG_AWD1);
+}
+
+/**
+ * @brief Configures rank 1 of the ADC1 injected group.
+ *
+ * Channel sampling times may only be written while no conversion is
+ * ongoing, so a running regular group is stopped around the update. The
+ * trigger timer keeps running and the DMA is left untouched; conversions
+ * resume on the next trigger.
+ *
+ * @param channel ADC channel to measure.
+ */
+static void configure_injected_channel(ADC_LL_Channel channel)
+{
+    ADC_InjectionConfTypeDef injected_config = { 0 };
+
+    injected_config.InjectedChannel = get_hal_adc_channel(channel);
+    injected_config.InjectedRank = ADC_INJECTED_RANK_1;
+    injected_config.InjectedSamplingTime = ADC_SAMPLETIME_92CYCLES_5;
+    injected_config.InjectedSingleDiff = ADC_SINGLE_ENDED;
+    injected_config.InjectedOffsetNumber = ADC_OFFSET_NONE;
+    injected_config.InjectedOffset = 0;
+    injected_config.InjectedNbrOfConversion = 1;
+    injected_config.InjectedDiscontinuousConvMode = DISABLE;
+    injected_config.AutoInjectedConv = DISABLE;
+    injected_config.QueueInjectedContext = DISABLE;
+    injected_config.ExternalTrigInjecConv = ADC_INJECTED_SOFTWARE_START;
+    injected_config.ExternalTrigInjecConvEdge =
+        ADC_EXTERNALTRIGINJECCONV_EDGE_NONE;
+    injected_config.InjecOversamplingMode = DISABLE;
+
+    bool const regular_running =
+        LL_ADC_REG_IsConversionOngoing(g_hadc1.Instance) != 0UL;
+    if (regular_running) {
+        LL_ADC_REG_StopConversion(g_hadc1.Instance);
+        while (LL_ADC_REG_IsStopConversionOngoing(g_hadc1.Instance) != 0UL) {
+        }
+    }
+
+    HAL_StatusTypeDef const status =
+        HAL_ADCEx_InjectedConfigChannel(&g_hadc1, &injected_config);
+
+    if (regular_running) {
+        LL_ADC_REG_StartConversion(g_hadc1.Instance);
+    }
+    if (status != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
+/**
+ * @brief Configures an injected channel on ADC1.
+ *
+ * Hardware oversampling is shared with the regular group, so injected
+ * measurements are summed and shifted in software from successive
+ * conversions, the way the hardware would.
+ *
+ * @param channel ADC channel to measure.
+ * @param oversampling_ratio Number of conversions summed per measurement.
+ * @param oversampling_shift Right shift of the sum.
+ */
+void ADC_LL_injected_init(
+    ADC_LL_Channel channel,
+    uint32_t oversampling_ratio,
+    uint32_t oversampling_shift
+)
+{
+    if (!g_adc_instance.initialized) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+    if (g_injected.initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+    validate_oversampling_ratio(oversampling_ratio);
+    validate_oversampling_shift(
+        oversampling_ratio, oversampling_shift, g_adc_instance.resolution
+    );
+
+    ADC_LL_PinConfig const pin_config = get_pin_config(channel);
+    configure_adc_gpio(&pin_config);
+    reference_abort();
+    configure_injected_channel(channel);
+
+    g_injected.oversampling_ratio = oversampling_ratio;
+    g_injected.oversampling_shift = oversampling_shift;
+    g_injected.count = 0;
+    g_injected.sum = 0;
+    g_injected.busy = false;
+    g_injected.initialized = true;
+
+    // Shares the ADC1 interrupt with the analog watchdog
+    HAL_NVIC_SetPriority(ADC1_IRQn, IRQ_PRIORITY_ACQUISITION, 0);
+    HAL_NVIC_EnableIRQ(ADC1_IRQn);
+}
+
+/**
+ * @brief Releases the injected channel.
+ */
+void ADC_LL_injected_deinit(void)
+{
+    if (!g_injected.initialized) {
+        return;
+    }
+
+    __HAL_ADC_DISABLE_IT(&g_hadc1, ADC_IT_JEOC | ADC_IT_JEOS);
+    if (LL_ADC_INJ_IsConversionOngoing(g_hadc1.Instance) != 0UL) {
+        LL_ADC_INJ_StopConversion(g_hadc1.Instance);
+        while (LL_ADC_INJ_IsStopConversionOngoing(g_hadc1.Instance) != 0UL) {
+        }
+    }
+    __HAL_ADC_CLEAR_FLAG(&g_hadc1, ADC_FLAG_JEOC | ADC_FLAG_JEOS);
+
+    g_injected.callback = nullptr;
+    g_injected.oversampling_ratio = 1;
+    g_injected.oversampling_shift = 0;
+    g_injected.busy = false;
+    g_injected.initialized = false;
+}
+
+/**
+ * @brief Starts one injected measurement, returning failures instead of
+ * throwing.
+ *
+ * @return ERROR_NONE, or the error ADC_LL_injected_start would throw.
+ */
+Error ADC_LL_try_injected_start(void)
+{
+    if (!g_injected.initialized) {
+        return ERROR_RESOURCE_UNAVAILABLE;
+    }
+    if (g_injected.busy) {
+        return ERROR_RESOURCE_BUSY;
+    }
+
+    g_injected.count = 0;
+    g_injected.sum = 0;
+    g_injected.busy = true;
+
+    // HAL enables the ADC if the regular group has not done so yet
+    if (HAL_ADCEx_InjectedStart_IT(&g_hadc1) != HAL_OK) {
+        g_injected.busy = false;
+        return ERROR_HARDWARE_FAULT;
+    }
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Starts one injected measurement.
+ */
+void ADC_LL_injected_start(void)
+{
+    Error const error = ADC_LL_try_injected_start();
+    if (error != ERROR_NONE) {
+        THROW(error);
+    }
+}
+
+/**
+ * @brief Sets the callback for injected measurement results.
+ *
+ * @param callback Pointer to the callback function to be set.
+ */
+void ADC_LL_set_injected_callback(ADC_LL_InjectedCallback callback)
+{
+    g_injected.callback = callback;
+}
+
+/**
+ * @brief Measures the reference voltage in the background.
+ *
+ * A conversion of VREFINT takes a few microseconds, so one started by a
+ * call has finished by the next. Conversions are only started while the
+ * regular group is stopped, so they never pause a capture.
+ */
+void ADC_LL_track_reference(void)
+{
+    if (!g_adc_instance.initialized || g_injected.initialized) {
+        return;
+    }
+
+    if (g_reference.busy) {
+        if (!__HAL_ADC_GET_FLAG(&g_hadc1, ADC_FLAG_JEOC)) {
+            return;
+        }
+        uint32_t const value =
+            HAL_ADCEx_InjectedGetValue(&g_hadc1, ADC_INJECTED_RANK_1);
+        reference_abort();
+        if (value != 0) {
+            reference_update(value);
+        }
+        return;
+    }
+
+    if (LL_ADC_REG_IsConversionOngoing(g_hadc1.Instance) != 0UL) {
+        return;
+    }
+    if (!configure_reference_channel()) {
+        LOG_ERROR("ADC: Failed to configure VREFINT tracking");
+        return;
+    }
+    // HAL enables the ADC, which the regular group has stopped
+    if (HAL_ADCEx_InjectedStart(&g_hadc1) != HAL_OK) {
+        LOG_ERROR("ADC: Failed to start VREFINT tracking");
+        return;
+    }
+    g_reference.busy = true;
+}
+
+/**
+ * @brief Gets the current DMA write position.
+ *
+ * Derived from the destination address of the running DMA block, which
+ * holds the next byte to be written in whichever node is active. Every
+ * written byte belongs to a 16-bit sample in both single and dual modes.
+ *
+ * @return Index of the next sample to be written.
+ */
+uint32_t ADC_LL_get_dma_position(void)
+{
+    DMA_HandleTypeDef const *hdma = g_hadc1.DMA_Handle;
+
+    if (!g_adc_instance.initialized || hdma == nullptr) {
+        return 0;
+    }
+
+    uint32_t const offset =
+        hdma->Instance->CDAR - (uint32_t)g_adc_instance.buffer_data;
+    uint32_t const position = offset / sizeof(uint16_t);
+    if (position >= g_adc_instance.buffer_size) {
+        return 0;
+    }
+    return position;
+}
+
+/**
+ * @brief Gets the data integrity counters.
+ *
+ * @return Overruns and DMA transfer errors since startup.
+ */
+ADC_LL_ErrorCounters ADC_LL_get_error_counters(void)
+{
+    return (ADC_LL_ErrorCounters){
+        .overruns = g_error_counters.overruns,
+        .dma_errors = g_error_counters.dma_errors,
+    };
+}
+
 /**
  * @brief Gets the current ADC operation mode.
  *
@@ -1037,6 +2170,25 @@ static uint32_t get_conversion_time_cycles_2x(uint32_t resolution)
     return 0;
 }
 
+/**
+ * @brief ADC sampling time settings, shortest first, in cycles * 2.
+ */
+static Lookup const g_sample_time_table[] = {
+    { ADC_SAMPLETIME_2CYCLES_5, 5 }, // 2.5 cycles * 2
+    { ADC_SAMPLETIME_6CYCLES_5, 13 }, // 6.5 cycles * 2
+    { ADC_SAMPLETIME_12CYCLES_5, 25 }, // 12.5 cycles * 2
+    { ADC_SAMPLETIME_24CYCLES_5, 49 }, // 24.5 cycles * 2
+    { ADC_SAMPLETIME_47CYCLES_5, 95 }, // 47.5 cycles * 2
+    { ADC_SAMPLETIME_92CYCLES_5, 185 }, // 92.5 cycles * 2
+    { ADC_SAMPLETIME_247CYCLES_5, 495 }, // 247.5 cycles * 2
+    { ADC_SAMPLETIME_640CYCLES_5, 1281 }, // 640.5 cycles * 2
+};
+
+enum {
+    ADC_SAMPLE_TIMES =
+        sizeof(g_sample_time_table) / sizeof(g_sample_time_table[0]),
+};
+
 /**
  * @brief Gets sample time cycles for ADC sampling time setting.
  *
@@ -1045,27 +2197,36 @@ static uint32_t get_conversion_time_cycles_2x(uint32_t resolution)
  */
 static uint32_t get_sample_time_cycles_2x(uint32_t sample_time)
 {
-    static Lookup const sample_time_table[] = {
-        { ADC_SAMPLETIME_2CYCLES_5, 5 }, // 2.5 cycles * 2
-        { ADC_SAMPLETIME_6CYCLES_5, 13 }, // 6.5 cycles * 2
-        { ADC_SAMPLETIME_12CYCLES_5, 25 }, // 12.5 cycles * 2
-        { ADC_SAMPLETIME_24CYCLES_5, 49 }, // 24.5 cycles * 2
-        { ADC_SAMPLETIME_47CYCLES_5, 95 }, // 47.5 cycles * 2
-        { ADC_SAMPLETIME_92CYCLES_5, 185 }, // 92.5 cycles * 2
-        { ADC_SAMPLETIME_247CYCLES_5, 495 }, // 247.5 cycles * 2
-        { ADC_SAMPLETIME_640CYCLES_5, 1281 }, // 640.5 cycles * 2
-    };
-
-    for (size_t i = 0;
-         i < sizeof(sample_time_table) / sizeof(sample_time_table[0]);
-         ++i) {
-        if (sample_time == sample_time_table[i].key) {
-            return sample_time_table[i].value;
+    for (size_t i = 0; i < ADC_SAMPLE_TIMES; ++i) {
+        if (sample_time == g_sample_time_table[i].key) {
+            return g_sample_time_table[i].value;
         }
     }
     return 0;
 }
 
+/**
+ * @brief ADC clock prescaler settings and their division factors.
+ *
+ * The asynchronous settings come first, so that a factor is looked up as
+ * a division of the kernel clock rather than of the bus clock.
+ */
+static Lookup const g_clock_prescaler_table[] = {
+    { ADC_CLOCK_ASYNC_DIV1, 1 },     { ADC_CLOCK_ASYNC_DIV2, 2 },
+    { ADC_CLOCK_ASYNC_DIV4, 4 },     { ADC_CLOCK_ASYNC_DIV6, 6 },
+    { ADC_CLOCK_ASYNC_DIV8, 8 },     { ADC_CLOCK_ASYNC_DIV10, 10 },
+    { ADC_CLOCK_ASYNC_DIV12, 12 },   { ADC_CLOCK_ASYNC_DIV16, 16 },
+    { ADC_CLOCK_ASYNC_DIV32, 32 },   { ADC_CLOCK_ASYNC_DIV64, 64 },
+    { ADC_CLOCK_ASYNC_DIV128, 128 }, { ADC_CLOCK_ASYNC_DIV256, 256 },
+    { ADC_CLOCK_SYNC_PCLK_DIV1, 1 }, { ADC_CLOCK_SYNC_PCLK_DIV2, 2 },
+    { ADC_CLOCK_SYNC_PCLK_DIV4, 4 },
+};
+
+enum {
+    ADC_CLOCK_PRESCALERS =
+        sizeof(g_clock_prescaler_table) / sizeof(g_clock_prescaler_table[0]),
+};
+
 /**
  * @brief Gets prescaler value for ADC clock prescaler setting.
  *
@@ -1074,24 +2235,103 @@ static uint32_t get_sample_time_cycles_2x(uint32_t sample_time)
  */
 static uint32_t get_clock_prescaler_value(uint32_t clock_prescaler)
 {
-    static Lookup const prescaler_table[] = {
-        { ADC_CLOCK_SYNC_PCLK_DIV1, 1 }, { ADC_CLOCK_SYNC_PCLK_DIV2, 2 },
-        { ADC_CLOCK_SYNC_PCLK_DIV4, 4 }, { ADC_CLOCK_ASYNC_DIV1, 1 },
-        { ADC_CLOCK_ASYNC_DIV2, 2 },     { ADC_CLOCK_ASYNC_DIV4, 4 },
-        { ADC_CLOCK_ASYNC_DIV8, 8 },     { ADC_CLOCK_ASYNC_DIV16, 16 },
-        { ADC_CLOCK_ASYNC_DIV32, 32 },   { ADC_CLOCK_ASYNC_DIV64, 64 },
-        { ADC_CLOCK_ASYNC_DIV128, 128 }, { ADC_CLOCK_ASYNC_DIV256, 256 },
-    };
-
-    for (size_t i = 0; i < sizeof(prescaler_table) / sizeof(prescaler_table[0]);
-         ++i) {
-        if (clock_prescaler == prescaler_table[i].key) {
-            return prescaler_table[i].value;
+    for (size_t i = 0; i < ADC_CLOCK_PRESCALERS; ++i) {
+        if (clock_prescaler == g_clock_prescaler_table[i].key) {
+            return g_clock_prescaler_table[i].value;
         }
     }
     return 0;
 }
 
+/**
+ * @brief Gets the asynchronous clock prescaler setting for a factor.
+ *
+ * @param prescaler Division of the kernel clock.
+ * @return HAL clock prescaler setting, or UINT32_MAX if unsupported.
+ */
+static uint32_t get_hal_clock_prescaler(uint32_t prescaler)
+{
+    for (size_t i = 0; i < ADC_CLOCK_PRESCALERS; ++i) {
+        if (prescaler == g_clock_prescaler_table[i].value) {
+            return g_clock_prescaler_table[i].key;
+        }
+    }
+    return UINT32_MAX;
+}
+
+/**
+ * @brief Gets the conversion clock a mode runs at.
+ *
+ * @param mode ADC operation mode.
+ * @return Kernel clock of the mode after its prescaler, in Hz.
+ */
+static uint32_t get_mode_clock_hz(ADC_LL_Mode mode)
+{
+    ADC_LL_Clock const *clock = &g_mode_clocks[mode];
+    return PLATFORM_ADC_CLOCK_SOURCE_HZ /
+           (clock->kernel_divider * clock->prescaler);
+}
+
+/**
+ * @brief Chooses the longest sampling time that keeps up with a rate.
+ *
+ * A longer sampling time lets the sampling capacitor settle closer to the
+ * input, so only the time the requested rate leaves after the conversion
+ * itself is spent on it. Without a rate, the default sampling time is
+ * kept; rates above the fastest setting get the shortest one.
+ *
+ * @param mode ADC operation mode, whose clock is used.
+ * @param resolution Conversion resolution.
+ * @param conversion_rate Conversions per second each ADC has to sustain,
+ *                        or 0.
+ * @return HAL sampling time setting.
+ */
+static uint32_t select_sample_time(
+    ADC_LL_Mode mode,
+    ADC_LL_Resolution resolution,
+    uint32_t conversion_rate
+)
+{
+    uint64_t const adc_clock_hz = get_mode_clock_hz(mode);
+    if (conversion_rate == 0 || adc_clock_hz == 0) {
+        return ADC_SAMPLETIME_92CYCLES_5;
+    }
+
+    uint32_t const conv_cycles_2x =
+        get_conversion_time_cycles_2x(get_hal_resolution(resolution));
+
+    for (size_t i = ADC_SAMPLE_TIMES; i > 1; --i) {
+        uint64_t const cycles_2x =
+            g_sample_time_table[i - 1].value + conv_cycles_2x;
+        if ((adc_clock_hz * 2) / cycles_2x >= conversion_rate) {
+            return g_sample_time_table[i - 1].key;
+        }
+    }
+    return g_sample_time_table[0].key;
+}
+
+ADC_LL_TriggerSource ADC_LL_get_timer_trigger(TIM_Num tim)
+{
+    switch (tim) {
+    case TIM_NUM_1:
+        return ADC_TRIGGER_TIMER1;
+    case TIM_NUM_2:
+        return ADC_TRIGGER_TIMER2;
+    case TIM_NUM_3:
+        return ADC_TRIGGER_TIMER3;
+    case TIM_NUM_4:
+        return ADC_TRIGGER_TIMER4;
+    case TIM_NUM_6:
+        return ADC_TRIGGER_TIMER6;
+    case TIM_NUM_8:
+        return ADC_TRIGGER_TIMER8;
+    case TIM_NUM_15:
+        return ADC_TRIGGER_TIMER15;
+    default:
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
 uint32_t ADC_LL_get_sample_rate(void)
 {
     if (!g_adc_instance.initialized) {
@@ -1131,6 +2371,69 @@ uint32_t ADC_LL_get_sample_rate(void)
     return adc_clock_hz / (total_cycles * prescaler);
 }
 
+/**
+ * @brief Converts a sampling time setting to nanoseconds.
+ *
+ * @param adc_clock_hz Conversion clock, after the prescaler.
+ * @param sample_time HAL sampling time setting.
+ * @return Sampling time in ns, or 0 if the ADC clock is unknown.
+ */
+static uint32_t sample_time_ns(uint64_t adc_clock_hz, uint32_t sample_time)
+{
+    if (adc_clock_hz == 0) {
+        return 0;
+    }
+    uint64_t const cycles_2x = get_sample_time_cycles_2x(sample_time);
+    return (uint32_t)((cycles_2x * SI_GIGA_INT) / (adc_clock_hz * 2));
+}
+
+uint32_t ADC_LL_get_sample_time_ns(void)
+{
+    if (!g_adc_instance.initialized) {
+        return 0;
+    }
+    uint32_t const prescaler =
+        get_clock_prescaler_value(g_adc_instance.clock_prescaler);
+    return sample_time_ns(
+        PLATFORM_get_peripheral_clock_speed(PLATFORM_CLOCK_ADC1) / prescaler,
+        g_adc_instance.sample_time
+    );
+}
+
+uint32_t ADC_LL_select_sample_time_ns(
+    ADC_LL_Mode mode,
+    ADC_LL_Resolution resolution,
+    uint32_t conversion_rate
+)
+{
+    if (mode > ADC_LL_MODE_INTERLEAVED) {
+        return 0;
+    }
+    return sample_time_ns(
+        get_mode_clock_hz(mode),
+        select_sample_time(mode, resolution, conversion_rate)
+    );
+}
+
+void ADC_LL_set_clock(ADC_LL_Mode mode, ADC_LL_Clock const *clock)
+{
+    if (mode > ADC_LL_MODE_INTERLEAVED || clock == nullptr ||
+        clock->kernel_divider < PLATFORM_ADC_CLOCK_DIVIDER_MIN ||
+        clock->kernel_divider > PLATFORM_ADC_CLOCK_DIVIDER_MAX ||
+        get_hal_clock_prescaler(clock->prescaler) == UINT32_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    g_mode_clocks[mode] = *clock;
+}
+
+ADC_LL_Clock ADC_LL_get_clock(ADC_LL_Mode mode)
+{
+    if (mode > ADC_LL_MODE_INTERLEAVED) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    return g_mode_clocks[mode];
+}
+
 uint32_t ADC_LL_get_reference_voltage(void)
 {
     if (g_adc_instance.initialized) {
@@ -1139,25 +2442,97 @@ uint32_t ADC_LL_get_reference_voltage(void)
     return 0;
 }
 
-uint32_t ADC_LL_get_max_sample_rate(ADC_LL_Mode mode)
+uint32_t ADC_LL_get_max_sample_rate(
+    ADC_LL_Mode mode,
+    ADC_LL_Resolution resolution
+)
 {
-    uint32_t const max_single_channel = 5000000; // 5 MHz
-    uint32_t const max_dual_channel = 10000000; // 10 MHz
+    uint32_t const max_single_channel = 5000000; // 5 MHz at 12 bits, 75 MHz
+    uint32_t const max_dual_channel = 10000000; // 10 MHz at 12 bits, 75 MHz
+    uint64_t max_rate = 0;
     switch (mode) {
     case ADC_LL_MODE_SINGLE:
     case ADC_LL_MODE_SIMULTANEOUS:
-        return max_single_channel;
+        max_rate = max_single_channel;
+        break;
     case ADC_LL_MODE_INTERLEAVED:
-        return max_dual_channel;
+        max_rate = max_dual_channel;
+        break;
     default:
         return 0;
     }
+
+    if (resolution > ADC_LL_RESOLUTION_8BIT) {
+        return 0;
+    }
+
+    // The rated figures hold at the fastest conversion clock
+    max_rate = (max_rate * get_mode_clock_hz(mode)) /
+               (PLATFORM_ADC_CLOCK_SOURCE_HZ / PLATFORM_ADC_CLOCK_DIVIDER_MIN);
+
+    // Scale by the total cycles per sample at the shortest sampling time
+    uint32_t const sample_cycles_2x =
+        get_sample_time_cycles_2x(ADC_SAMPLETIME_2CYCLES_5);
+    uint32_t const full_cycles_2x =
+        sample_cycles_2x + get_conversion_time_cycles_2x(ADC_RESOLUTION_12B);
+    uint32_t const cycles_2x =
+        sample_cycles_2x +
+        get_conversion_time_cycles_2x(get_hal_resolution(resolution));
+    return (uint32_t)((max_rate * full_cycles_2x) / cycles_2x);
+}
+
+/**
+ * @brief Reports the first half of the circular output buffer.
+ */
+RAMFUNC static void notify_half_complete(void)
+{
+    if (g_adc_instance.initialized && g_adc_instance.circular &&
+        g_adc_instance.half_complete_callback != nullptr) {
+        g_adc_instance.half_complete_callback(
+            g_adc_instance.buffer_data, g_adc_instance.buffer_size / 2
+        );
+    }
 }
 
-void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+RAMFUNC void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
 {
     (void)hadc;
 
+    // With several blocks the halves end on block boundaries instead
+    if (g_adc_instance.dma_nodes <= 1) {
+        notify_half_complete();
+    }
+}
+
+RAMFUNC void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    (void)hadc;
+
+    // In circular mode every block completes, find out which one did
+    if (g_adc_instance.circular && g_adc_instance.dma_nodes > 1) {
+        uint32_t const block = g_adc_instance.dma_node + 1;
+        uint32_t const blocks = g_adc_instance.dma_nodes;
+
+        g_adc_instance.dma_node = block < blocks ? block : 0;
+        if (block == blocks / 2) {
+            notify_half_complete();
+            return;
+        }
+        if (block < blocks) {
+            return;
+        }
+    }
+
+    if (g_adc_instance.initialized && g_adc_instance.circular &&
+        g_adc_instance.complete_callback != nullptr) {
+        // Second half of the buffer; DMA has already wrapped to the first
+        uint32_t half_samples = g_adc_instance.buffer_size / 2;
+        g_adc_instance.complete_callback(
+            g_adc_instance.buffer_data + half_samples, half_samples
+        );
+        return;
+    }
+
     if (g_adc_instance.initialized &&
         g_adc_instance.complete_callback != nullptr) {
         uint32_t total_samples = 0;
@@ -1178,22 +2553,73 @@ void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
     }
 }
 
-void GPDMA1_Channel6_IRQHandler(void)
+/**
+ * @brief ADC analog watchdog 1 callback.
+ *
+ * Disarms the watchdog so each arming produces a single event, then
+ * notifies the registered callback.
+ *
+ * @param hadc Pointer to the ADC handle structure.
+ */
+void HAL_ADC_LevelOutOfWindowCallback(ADC_HandleTypeDef *hadc)
+{
+    __HAL_ADC_DISABLE_IT(hadc, ADC_IT_AWD1);
+
+    if (g_adc_instance.initialized &&
+        g_adc_instance.watchdog_callback != nullptr) {
+        g_adc_instance.watchdog_callback();
+    }
+}
+
+/**
+ * @brief ADC injected conversion complete callback.
+ *
+ * Accumulates one conversion and starts the next until the oversampling
+ * ratio is reached, then reports the sum shifted right with rounding.
+ *
+ * @param hadc Pointer to the ADC handle structure.
+ */
+void HAL_ADCEx_InjectedConvCpltCallback(ADC_HandleTypeDef *hadc)
 {
-    HAL_DMA_IRQHandler(&g_hdma_adc); // Handle single mode DMA interrupts
+    InjectedMonitor *monitor = &g_injected;
+
+    if (!monitor->initialized || !monitor->busy) {
+        return;
+    }
+
+    monitor->sum += HAL_ADCEx_InjectedGetValue(hadc, ADC_INJECTED_RANK_1);
+    monitor->count += 1;
+
+    if (monitor->count < monitor->oversampling_ratio) {
+        if (HAL_ADCEx_InjectedStart_IT(hadc) != HAL_OK) {
+            LOG_ERROR("ADC: Failed to continue injected measurement");
+            monitor->busy = false;
+        }
+        return;
+    }
+
+    uint32_t const shift = monitor->oversampling_shift;
+    uint32_t const half = shift > 0 ? 1U << (shift - 1) : 0;
+    uint16_t const value = (uint16_t)((monitor->sum + half) >> shift);
+    monitor->busy = false;
+
+    if (monitor->callback != nullptr) {
+        monitor->callback(value);
+    }
 }
 
-void GPDMA1_Channel7_IRQHandler(void)
+void ADC1_IRQHandler(void)
 {
-    HAL_DMA_IRQHandler(&g_hdma_adc1_dual
-    ); // Handle ADC1 dual mode DMA interrupts
+    // Handle analog watchdog and injected conversion interrupts
+    HAL_ADC_IRQHandler(&g_hadc1);
 }
 
 /**
  * @brief ADC error callback.
  *
- * This function is called by the HAL when an ADC error occurs.
- * It simply logs the error code.
+ * This function is called by the HAL when an ADC error occurs. It counts
+ * and logs the error, then clears the error code so that the next call
+ * only reports new errors.
  *
  * @param hadc Pointer to the ADC handle structure.
  */
@@ -1204,5 +2630,12 @@ void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc)
         return;
     }
     uint32_t error_code = HAL_ADC_GetError(hadc);
+    if ((error_code & HAL_ADC_ERROR_OVR) != 0) {
+        g_error_counters.overruns += 1;
+    }
+    if ((error_code & HAL_ADC_ERROR_DMA) != 0) {
+        g_error_counters.dma_errors += 1;
+    }
+    hadc->ErrorCode = HAL_ADC_ERROR_NONE;
     LOG_ERROR("HAL_ADC_ErrorCallback: error code = 0x%08lX", error_code);
 }
@@ -0,0 +1,183 @@
+/**
+ * @file copy_ll.c
+ * @brief Memory copies by GPDMA for the STM32H563xx
+ *
+ * The DMA channel runs memory to memory on software requests, a word per
+ * beat when both blocks and the size allow it, a byte otherwise. A block
+ * holds at most 65535 bytes, so longer copies are made in blocks, each
+ * started from the transfer complete interrupt of the one before. The
+ * channel runs at low priority, so that acquisition DMA comes first on the
+ * bus.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stm32h5xx_hal.h"
+
+#include "util/error.h"
+
+#include "copy_ll.h"
+#include "dma_channel.h"
+#include "irq_priority.h"
+#include "platform.h"
+
+enum {
+    // Bytes per DMA block: BNDT is 16 bits wide, and a multiple of the beat
+    COPY_BLOCK_MAX = 0xFFFC,
+};
+
+static DMA_HandleTypeDef g_hdma_copy;
+
+static struct {
+    bool volatile busy;
+    uint8_t *dst; // Start of the next block
+    uint8_t const *src;
+    uint32_t remaining; // Bytes from src on
+    COPY_LL_Callback callback;
+    void *context;
+} g_copy = { .busy = false };
+
+/**
+ * @brief Stop the DMA and give back the channel
+ */
+static void release(void)
+{
+    g_copy.remaining = 0; // Chains no further block meanwhile
+    (void)HAL_DMA_Abort(&g_hdma_copy);
+    (void)HAL_DMA_DeInit(&g_hdma_copy);
+    DMA_CHANNEL_release(&g_hdma_copy);
+    g_copy.busy = false;
+}
+
+/**
+ * @brief Free the engine, then tell the owner of the copy
+ */
+static void finish(bool ok)
+{
+    COPY_LL_Callback const callback = g_copy.callback;
+    void *const context = g_copy.context;
+
+    release();
+    if (callback != nullptr) {
+        callback(context, ok);
+    }
+}
+
+/**
+ * @brief Queue the next block of the copy, from any context
+ */
+static void start_block(void)
+{
+    uint32_t const len =
+        g_copy.remaining < COPY_BLOCK_MAX ? g_copy.remaining : COPY_BLOCK_MAX;
+
+    uint8_t *const dst = g_copy.dst;
+    uint8_t const *const src = g_copy.src;
+    g_copy.dst += len;
+    g_copy.src += len;
+    g_copy.remaining -= len;
+    if (HAL_DMA_Start_IT(&g_hdma_copy, (uint32_t)src, (uint32_t)dst, len) !=
+        HAL_OK) {
+        finish(false);
+    }
+}
+
+static void copy_dma_complete(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+
+    if (g_copy.remaining > 0) {
+        start_block();
+        return;
+    }
+    finish(true);
+}
+
+static void copy_dma_error(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+
+    finish(false);
+}
+
+/**
+ * @brief Claim a channel and set up the transfer between the blocks
+ *
+ * @param width Bytes per beat, 1 or 4
+ *
+ * @throws ERROR_RESOURCE_UNAVAILABLE if no channel is free
+ * @throws ERROR_HARDWARE_FAULT if the HAL rejects the configuration
+ */
+static void init_dma(uint32_t width)
+{
+    DMA_HandleTypeDef *const hdma = &g_hdma_copy;
+    bool const words = width == sizeof(uint32_t);
+
+    DMA_CHANNEL_claim(hdma, 0, IRQ_PRIORITY_COPY);
+    hdma->Init.Request = DMA_REQUEST_SW;
+    hdma->Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
+    hdma->Init.Direction = DMA_MEMORY_TO_MEMORY;
+    hdma->Init.SrcInc = DMA_SINC_INCREMENTED;
+    hdma->Init.DestInc = DMA_DINC_INCREMENTED;
+    hdma->Init.SrcDataWidth =
+        words ? DMA_SRC_DATAWIDTH_WORD : DMA_SRC_DATAWIDTH_BYTE;
+    hdma->Init.DestDataWidth =
+        words ? DMA_DEST_DATAWIDTH_WORD : DMA_DEST_DATAWIDTH_BYTE;
+    hdma->Init.Priority = DMA_LOW_PRIORITY_LOW_WEIGHT;
+    hdma->Init.SrcBurstLength = 1;
+    hdma->Init.DestBurstLength = 1;
+    // Both blocks in SRAM, on port 1
+    hdma->Init.TransferAllocatedPort =
+        DMA_SRC_ALLOCATED_PORT1 | DMA_DEST_ALLOCATED_PORT1;
+    hdma->Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    hdma->Init.Mode = DMA_NORMAL;
+    if (HAL_DMA_Init(hdma) != HAL_OK) {
+        DMA_CHANNEL_release(hdma);
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    hdma->XferCpltCallback = copy_dma_complete;
+    hdma->XferErrorCallback = copy_dma_error;
+}
+
+void COPY_LL_start(
+    void *dst,
+    void const *src,
+    uint32_t size,
+    COPY_LL_Callback callback,
+    void *context
+)
+{
+    if (dst == nullptr || src == nullptr || size == 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_copy.busy) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    uint32_t const alignment = (uint32_t)dst | (uint32_t)src | size;
+    init_dma(alignment % sizeof(uint32_t) == 0 ? sizeof(uint32_t) : 1);
+
+    g_copy.dst = dst;
+    g_copy.src = src;
+    g_copy.remaining = size;
+    g_copy.callback = callback;
+    g_copy.context = context;
+    g_copy.busy = true;
+    start_block();
+}
+
+bool COPY_LL_busy(void) { return g_copy.busy; }
+
+void COPY_LL_abort(void)
+{
+    // The channel interrupt must not end the copy meanwhile
+    uint32_t const state = PLATFORM_disable_interrupts();
+    if (g_copy.busy) {
+        release();
+    }
+    PLATFORM_restore_interrupts(state);
+}
@@ -0,0 +1,318 @@
+/**
+ * @file counter_ll.c
+ * @brief Edge timestamps of PA0 with TIM5 input capture
+ *
+ * TIM5 is the one 32-bit timer outside the TIM_LL pool. It counts the
+ * timer clock freely over its full range, and channel 1, on PA0, captures
+ * the count on rising edges, divided by the input prescaler. Each capture
+ * requests a word transfer from CCR1 on a GPDMA channel into a ring of
+ * two nodes, as in la_ll.c, and the transfer complete interrupt of each
+ * node counts the ring's laps.
+ *
+ * PA0 is also ADC channel 0; the counter takes it over as a digital input
+ * while initialized, and returns it to analog mode.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stm32h5xx_hal.h"
+
+#include "util/error.h"
+
+#include "counter_ll.h"
+#include "dma_channel.h"
+#include "irq_priority.h"
+#include "platform.h"
+
+enum {
+    COUNTER_NODE_CAPTURES = 64, // Captures per node
+    COUNTER_DMA_NODES = 2, // Halves of the ring
+    COUNTER_RING_CAPTURES = COUNTER_NODE_CAPTURES * COUNTER_DMA_NODES,
+};
+
+typedef struct {
+    uint32_t volatile nodes_done; // Nodes filled since COUNTER_LL_start
+    uint32_t volatile first; // First capture, kept once the ring wraps
+    bool volatile dma_error;
+    bool armed; // The DMA waits for captures, or did until stopped
+    bool initialized;
+} CounterInstance;
+
+static TIM_HandleTypeDef g_htim_counter = { nullptr };
+static DMA_HandleTypeDef g_hdma_counter = { nullptr };
+static DMA_NodeTypeDef g_dma_counter_nodes[COUNTER_DMA_NODES] = { 0 };
+static DMA_QListTypeDef g_dma_counter_queue = { nullptr };
+static CounterInstance g_counter_instance = { 0 };
+
+// Timestamps moved by the DMA
+static uint32_t g_counter_ring[COUNTER_RING_CAPTURES];
+
+static void counter_dma_complete(DMA_HandleTypeDef *hdma)
+{
+    CounterInstance *const instance = &g_counter_instance;
+
+    (void)hdma;
+    if (instance->nodes_done++ == 0) {
+        instance->first = g_counter_ring[0];
+    }
+}
+
+static void counter_dma_error(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+    g_counter_instance.dma_error = true;
+}
+
+static uint32_t get_capture_prescaler(uint32_t prescaler)
+{
+    switch (prescaler) {
+    case 1:
+        return TIM_ICPSC_DIV1;
+    case 2:
+        return TIM_ICPSC_DIV2;
+    case 4:
+        return TIM_ICPSC_DIV4;
+    case COUNTER_LL_PRESCALER_MAX:
+        return TIM_ICPSC_DIV8;
+    default:
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+static void configure_input(void)
+{
+    GPIO_InitTypeDef gpio_init = { 0 };
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    gpio_init.Pin = GPIO_PIN_0;
+    gpio_init.Mode = GPIO_MODE_AF_PP;
+    gpio_init.Pull = GPIO_NOPULL;
+    gpio_init.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio_init.Alternate = GPIO_AF2_TIM5;
+    HAL_GPIO_Init(GPIOA, &gpio_init);
+}
+
+static void init_timer(uint32_t capture_prescaler)
+{
+    TIM_HandleTypeDef *const htim = &g_htim_counter;
+    TIM_IC_InitTypeDef ic_config = { 0 };
+
+    __HAL_RCC_TIM5_CLK_ENABLE();
+
+    htim->Instance = TIM5;
+    htim->Init.Prescaler = 0;
+    htim->Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim->Init.Period = UINT32_MAX;
+    htim->Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    htim->Init.RepetitionCounter = 0;
+    htim->Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    if (HAL_TIM_IC_Init(htim) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    ic_config.ICPolarity = TIM_ICPOLARITY_RISING;
+    ic_config.ICSelection = TIM_ICSELECTION_DIRECTTI;
+    ic_config.ICPrescaler = capture_prescaler;
+    ic_config.ICFilter = 0;
+    if (HAL_TIM_IC_ConfigChannel(htim, &ic_config, TIM_CHANNEL_1) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    __HAL_TIM_ENABLE(htim);
+}
+
+/**
+ * @brief Make the ring a circular queue of two nodes
+ */
+static void build_dma_queue(void)
+{
+    DMA_NodeConfTypeDef node_config = { 0 };
+
+    node_config.NodeType = DMA_GPDMA_LINEAR_NODE;
+    node_config.Init = g_hdma_counter.Init;
+    node_config.DataHandlingConfig.DataExchange = DMA_EXCHANGE_NONE;
+    node_config.DataHandlingConfig.DataAlignment =
+        DMA_DATA_RIGHTALIGN_ZEROPADDED;
+    node_config.TriggerConfig.TriggerPolarity = DMA_TRIG_POLARITY_MASKED;
+    node_config.SrcAddress = (uint32_t)&TIM5->CCR1;
+    node_config.DataSize = COUNTER_NODE_CAPTURES * sizeof(uint32_t);
+
+    if (HAL_DMAEx_List_ResetQ(&g_dma_counter_queue) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    for (uint32_t i = 0; i < COUNTER_DMA_NODES; ++i) {
+        node_config.DstAddress =
+            (uint32_t)&g_counter_ring[i * COUNTER_NODE_CAPTURES];
+        if (HAL_DMAEx_List_BuildNode(&node_config, &g_dma_counter_nodes[i]) !=
+                HAL_OK ||
+            HAL_DMAEx_List_InsertNode_Tail(
+                &g_dma_counter_queue, &g_dma_counter_nodes[i]
+            ) != HAL_OK) {
+            THROW(ERROR_HARDWARE_FAULT);
+        }
+    }
+    if (HAL_DMAEx_List_SetCircularMode(&g_dma_counter_queue) != HAL_OK ||
+        HAL_DMAEx_List_LinkQ(&g_hdma_counter, &g_dma_counter_queue) !=
+            HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
+static void init_dma(void)
+{
+    DMA_HandleTypeDef *const hdma = &g_hdma_counter;
+
+    DMA_CHANNEL_claim(
+        hdma,
+        DMA_CHANNEL_CAP_LINKED_LIST,
+        IRQ_PRIORITY_GENERATION
+    );
+    hdma->Init.Request = GPDMA2_REQUEST_TIM5_CH1;
+    hdma->Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
+    hdma->Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma->Init.SrcInc = DMA_SINC_FIXED;
+    hdma->Init.DestInc = DMA_DINC_INCREMENTED;
+    hdma->Init.SrcDataWidth = DMA_SRC_DATAWIDTH_WORD;
+    hdma->Init.DestDataWidth = DMA_DEST_DATAWIDTH_WORD;
+    hdma->Init.Priority = DMA_HIGH_PRIORITY;
+    hdma->Init.SrcBurstLength = 1;
+    hdma->Init.DestBurstLength = 1;
+    hdma->Init.TransferAllocatedPort =
+        DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT1;
+    hdma->Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    hdma->Init.Mode = DMA_NORMAL;
+
+    hdma->InitLinkedList.Priority = hdma->Init.Priority;
+    hdma->InitLinkedList.LinkStepMode = DMA_LSM_FULL_EXECUTION;
+    hdma->InitLinkedList.LinkAllocatedPort = DMA_LINK_ALLOCATED_PORT0;
+    hdma->InitLinkedList.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    hdma->InitLinkedList.LinkedListMode = DMA_LINKEDLIST_CIRCULAR;
+
+    if (HAL_DMAEx_List_Init(hdma) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    hdma->XferCpltCallback = counter_dma_complete;
+    hdma->XferErrorCallback = counter_dma_error;
+}
+
+/**
+ * @brief Abort the DMA of the previous span, if still armed
+ */
+static void disarm_dma(void)
+{
+    if (g_counter_instance.armed) {
+        (void)HAL_DMA_Abort(&g_hdma_counter);
+        g_counter_instance.armed = false;
+    }
+}
+
+void COUNTER_LL_init(uint32_t prescaler)
+{
+    uint32_t const capture_prescaler = get_capture_prescaler(prescaler);
+
+    if (g_counter_instance.initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    configure_input();
+    init_timer(capture_prescaler);
+    init_dma();
+    g_counter_instance.initialized = true;
+}
+
+void COUNTER_LL_deinit(void)
+{
+    if (!g_counter_instance.initialized) {
+        return;
+    }
+
+    COUNTER_LL_stop();
+    disarm_dma();
+    (void)HAL_DMAEx_List_UnLinkQ(&g_hdma_counter);
+    (void)HAL_DMAEx_List_DeInit(&g_hdma_counter);
+    DMA_CHANNEL_release(&g_hdma_counter);
+    (void)HAL_TIM_IC_DeInit(&g_htim_counter);
+    __HAL_RCC_TIM5_CLK_DISABLE();
+    // Back to analog, for the ADC
+    HAL_GPIO_DeInit(GPIOA, GPIO_PIN_0);
+    g_counter_instance.initialized = false;
+}
+
+void COUNTER_LL_start(void)
+{
+    CounterInstance *const instance = &g_counter_instance;
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    COUNTER_LL_stop();
+    disarm_dma();
+    if (g_hdma_counter.LinkedListQueue != nullptr &&
+        HAL_DMAEx_List_UnLinkQ(&g_hdma_counter) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    build_dma_queue();
+    instance->nodes_done = 0;
+    instance->dma_error = false;
+
+    if (HAL_DMAEx_List_Start_IT(&g_hdma_counter) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    instance->armed = true;
+
+    // A stale capture would be moved first, and flag an overrun
+    __HAL_TIM_CLEAR_FLAG(&g_htim_counter, TIM_FLAG_CC1 | TIM_FLAG_CC1OF);
+    __HAL_TIM_ENABLE_DMA(&g_htim_counter, TIM_DMA_CC1);
+    TIM_CCxChannelCmd(TIM5, TIM_CHANNEL_1, TIM_CCx_ENABLE);
+}
+
+void COUNTER_LL_stop(void)
+{
+    if (!g_counter_instance.initialized) {
+        return;
+    }
+
+    // The DMA stays armed, so that a capture in flight still completes
+    // its node and is counted
+    TIM_CCxChannelCmd(TIM5, TIM_CHANNEL_1, TIM_CCx_DISABLE);
+    __HAL_TIM_DISABLE_DMA(&g_htim_counter, TIM_DMA_CC1);
+}
+
+uint32_t COUNTER_LL_get_clock(void)
+{
+    if (!g_counter_instance.initialized) {
+        return 0;
+    }
+    return PLATFORM_get_peripheral_clock_speed(PLATFORM_CLOCK_TIMER5);
+}
+
+uint32_t COUNTER_LL_get_time(void) { return TIM5->CNT; }
+
+void COUNTER_LL_get_span(COUNTER_LL_Span *span)
+{
+    CounterInstance const *const instance = &g_counter_instance;
+
+    *span = (COUNTER_LL_Span){ 0 };
+    if (!instance->armed) {
+        return;
+    }
+
+    uint32_t const nodes_done = instance->nodes_done;
+    uint32_t const remaining =
+        __HAL_DMA_GET_COUNTER(&g_hdma_counter) / sizeof(uint32_t);
+
+    span->captures =
+        nodes_done * COUNTER_NODE_CAPTURES + COUNTER_NODE_CAPTURES - remaining;
+    if (span->captures > 0) {
+        span->first = nodes_done > 0 ? instance->first : g_counter_ring[0];
+        span->last =
+            g_counter_ring[(span->captures - 1) % COUNTER_RING_CAPTURES];
+    }
+    span->overrun =
+        instance->dma_error ||
+        __HAL_TIM_GET_FLAG(&g_htim_counter, TIM_FLAG_CC1OF) != RESET;
+}
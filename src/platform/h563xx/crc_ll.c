@@ -0,0 +1,182 @@
+/**
+ * @file crc_ll.c
+ * @brief CRC unit fed by GPDMA for the STM32H563xx
+ *
+ * The DMA channel runs memory to memory on software requests, from the
+ * data to the data register of the unit, which takes byte writes as 8-bit
+ * input. A block holds at most 65535 bytes, so longer data is checksummed
+ * in blocks, each started from the transfer complete interrupt of the one
+ * before. The channel runs at low priority, so that acquisition DMA comes
+ * first on the bus.
+ *
+ * A DMA error ends the checksum early, with a result that then matches no
+ * data: the receiver of the data sees it, which is what the checksum is
+ * for.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stm32h5xx_hal.h"
+
+#include "util/error.h"
+
+#include "crc_ll.h"
+#include "dma_channel.h"
+#include "irq_priority.h"
+
+enum {
+    CRC_BLOCK_MAX = 0xFFFF, // Bytes per DMA block, BNDT is 16 bits wide
+    CRC16_POLYNOMIAL = 0x1021,
+    CRC32_POLYNOMIAL = 0x04C11DB7,
+};
+
+typedef enum {
+    CRC_STATE_IDLE,
+    CRC_STATE_RUNNING,
+    CRC_STATE_DONE,
+} CrcState;
+
+static DMA_HandleTypeDef g_hdma_crc;
+
+static struct {
+    CrcState volatile state;
+    uint8_t const *next; // Start of the next block
+    uint32_t remaining; // Bytes from next on
+} g_crc = { .state = CRC_STATE_IDLE };
+
+/**
+ * @brief Queue the next block of the data, from any context
+ */
+static void start_block(void)
+{
+    uint32_t const len =
+        g_crc.remaining < CRC_BLOCK_MAX ? g_crc.remaining : CRC_BLOCK_MAX;
+
+    uint8_t const *const block = g_crc.next;
+    g_crc.next += len;
+    g_crc.remaining -= len;
+    if (HAL_DMA_Start_IT(
+            &g_hdma_crc, (uint32_t)block, (uint32_t)&CRC->DR, len
+        ) != HAL_OK) {
+        g_crc.state = CRC_STATE_DONE;
+    }
+}
+
+static void crc_dma_complete(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+
+    if (g_crc.remaining > 0) {
+        start_block();
+        return;
+    }
+    g_crc.state = CRC_STATE_DONE;
+}
+
+static void crc_dma_error(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+
+    g_crc.state = CRC_STATE_DONE;
+}
+
+/**
+ * @brief Claim a channel and set up the transfer into the data register
+ *
+ * @throws ERROR_RESOURCE_UNAVAILABLE if no channel is free
+ * @throws ERROR_HARDWARE_FAULT if the HAL rejects the configuration
+ */
+static void init_dma(void)
+{
+    DMA_HandleTypeDef *const hdma = &g_hdma_crc;
+
+    DMA_CHANNEL_claim(hdma, 0, IRQ_PRIORITY_CRC);
+    hdma->Init.Request = DMA_REQUEST_SW;
+    hdma->Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
+    hdma->Init.Direction = DMA_MEMORY_TO_MEMORY;
+    hdma->Init.SrcInc = DMA_SINC_INCREMENTED;
+    hdma->Init.DestInc = DMA_DINC_FIXED;
+    hdma->Init.SrcDataWidth = DMA_SRC_DATAWIDTH_BYTE;
+    hdma->Init.DestDataWidth = DMA_DEST_DATAWIDTH_BYTE;
+    hdma->Init.Priority = DMA_LOW_PRIORITY_LOW_WEIGHT;
+    hdma->Init.SrcBurstLength = 1;
+    hdma->Init.DestBurstLength = 1;
+    // Memory on port 1, the unit on the AHB peripheral port
+    hdma->Init.TransferAllocatedPort =
+        DMA_SRC_ALLOCATED_PORT1 | DMA_DEST_ALLOCATED_PORT0;
+    hdma->Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    hdma->Init.Mode = DMA_NORMAL;
+    if (HAL_DMA_Init(hdma) != HAL_OK) {
+        DMA_CHANNEL_release(hdma);
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    hdma->XferCpltCallback = crc_dma_complete;
+    hdma->XferErrorCallback = crc_dma_error;
+}
+
+/**
+ * @brief Stop the DMA and give back the channel and the unit
+ */
+static void release(void)
+{
+    g_crc.remaining = 0; // Chains no further block meanwhile
+    (void)HAL_DMA_Abort(&g_hdma_crc);
+    (void)HAL_DMA_DeInit(&g_hdma_crc);
+    DMA_CHANNEL_release(&g_hdma_crc);
+    __HAL_RCC_CRC_CLK_DISABLE();
+    g_crc.state = CRC_STATE_IDLE;
+}
+
+void CRC_LL_start(
+    CRC_LL_Polynomial polynomial,
+    uint32_t crc,
+    void const *data,
+    uint32_t size
+)
+{
+    if (g_crc.state != CRC_STATE_IDLE) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+    if (data == nullptr || size == 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    init_dma();
+
+    __HAL_RCC_CRC_CLK_ENABLE();
+    bool const crc16 = polynomial == CRC_LL_CRC16;
+    CRC->POL = crc16 ? CRC16_POLYNOMIAL : CRC32_POLYNOMIAL;
+    CRC->INIT = crc;
+    // No reversal; the reset loads INIT into the data register
+    CRC->CR = (crc16 ? CRC_CR_POLYSIZE_0 : 0) | CRC_CR_RESET;
+
+    g_crc.next = data;
+    g_crc.remaining = size;
+    g_crc.state = CRC_STATE_RUNNING;
+    start_block();
+}
+
+bool CRC_LL_busy(void) { return g_crc.state != CRC_STATE_IDLE; }
+
+bool CRC_LL_done(void) { return g_crc.state == CRC_STATE_DONE; }
+
+uint32_t CRC_LL_result(void)
+{
+    uint32_t const crc = CRC->DR;
+    bool const crc16 = (CRC->CR & CRC_CR_POLYSIZE) == CRC_CR_POLYSIZE_0;
+
+    release();
+    return crc16 ? crc & 0xFFFFU : crc;
+}
+
+void CRC_LL_abort(void)
+{
+    if (g_crc.state == CRC_STATE_IDLE) {
+        return;
+    }
+    release();
+}
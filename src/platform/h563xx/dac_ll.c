@@ -0,0 +1,274 @@
+/**
+ * @file dac_ll.c
+ * @brief Timer-paced output on DAC1 channel 1
+ *
+ * The output is PA4, buffered. The pacing timer's TRGO, the update event,
+ * triggers each conversion, and the DAC's own DMA request then fetches the
+ * next code into DHR12R1 over a GPDMA channel. The table is a single node of
+ * a circular linked list, so the DMA repeats it without interrupts. A
+ * streamed output splits the ring over two nodes, as la_ll.c does, and
+ * interrupts at the end of each to have it refilled.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stm32h5xx_hal.h"
+
+#include "util/error.h"
+
+#include "dac_ll.h"
+#include "dma_channel.h"
+#include "irq_priority.h"
+#include "tim_ll.h"
+
+enum {
+    DAC_CODE_MID = (DAC_LL_CODE_MAX + 1) / 2,
+    DAC_DMA_NODES_MAX = 2, // Halves of a streamed output's ring
+};
+
+typedef struct {
+    DAC_LL_Config config;
+    uint32_t nodes; // DMA blocks the table is split into
+    uint32_t volatile nodes_done; // Blocks output since DAC_LL_start
+    bool initialized;
+    bool running;
+} DACInstance;
+
+static DAC_HandleTypeDef g_hdac = { nullptr };
+static DMA_HandleTypeDef g_hdma_dac = { nullptr };
+static DMA_NodeTypeDef g_dma_dac_nodes[DAC_DMA_NODES_MAX] = { 0 };
+static DMA_QListTypeDef g_dma_dac_queue = { nullptr };
+static DACInstance g_dac_instance = { 0 };
+
+// DAC triggers of the timers' TRGO, in TIM_Num order; TIM3 has none
+static uint32_t const g_triggers[TIM_NUM_COUNT] = {
+    [TIM_NUM_6] = DAC_TRIGGER_T6_TRGO,
+    [TIM_NUM_7] = DAC_TRIGGER_T7_TRGO,
+    [TIM_NUM_1] = DAC_TRIGGER_T1_TRGO,
+    [TIM_NUM_2] = DAC_TRIGGER_T2_TRGO,
+    [TIM_NUM_4] = DAC_TRIGGER_T4_TRGO,
+    [TIM_NUM_8] = DAC_TRIGGER_T8_TRGO,
+    [TIM_NUM_15] = DAC_TRIGGER_T15_TRGO,
+};
+
+/**
+ * @brief First code of a DMA block
+ */
+static uint32_t node_start(uint32_t node)
+{
+    return (node * g_dac_instance.config.count) / g_dac_instance.nodes;
+}
+
+static void dac_dma_complete(DMA_HandleTypeDef *hdma)
+{
+    DACInstance *const instance = &g_dac_instance;
+
+    (void)hdma;
+    if (!instance->running || !instance->config.block_callback) {
+        return;
+    }
+    // Two nodes, so the count wraps at a node boundary
+    uint32_t const node = instance->nodes_done++ % instance->nodes;
+    uint32_t const first = node_start(node);
+    instance->config.block_callback(
+        &instance->config.samples[first], node_start(node + 1) - first
+    );
+}
+
+static void configure_output(void)
+{
+    GPIO_InitTypeDef gpio_init = { 0 };
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    gpio_init.Pin = GPIO_PIN_4;
+    gpio_init.Mode = GPIO_MODE_ANALOG;
+    gpio_init.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(GPIOA, &gpio_init);
+}
+
+static void init_dac(void)
+{
+    DAC_ChannelConfTypeDef channel = { 0 };
+
+    __HAL_RCC_DAC1_CLK_ENABLE();
+
+    g_hdac.Instance = DAC1;
+    if (HAL_DAC_Init(&g_hdac) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    channel.DAC_HighFrequency = DAC_HIGH_FREQUENCY_INTERFACE_MODE_AUTOMATIC;
+    channel.DAC_DMADoubleDataMode = DISABLE;
+    channel.DAC_SignedFormat = DISABLE;
+    channel.DAC_SampleAndHold = DAC_SAMPLEANDHOLD_DISABLE;
+    channel.DAC_Trigger = g_triggers[g_dac_instance.config.timer];
+    channel.DAC_OutputBuffer = DAC_OUTPUTBUFFER_ENABLE;
+    channel.DAC_ConnectOnChipPeripheral = DAC_CHIPCONNECT_EXTERNAL;
+    channel.DAC_UserTrimming = DAC_TRIMMING_FACTORY;
+    if (HAL_DAC_ConfigChannel(&g_hdac, &channel, DAC_CHANNEL_1) != HAL_OK ||
+        HAL_DAC_SetValue(
+            &g_hdac, DAC_CHANNEL_1, DAC_ALIGN_12B_R, DAC_CODE_MID
+        ) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
+/**
+ * @brief Make the table a circular queue, of one node or of two halves
+ */
+static void build_dma_queue(void)
+{
+    DACInstance *const instance = &g_dac_instance;
+    DMA_NodeConfTypeDef node_config = { 0 };
+
+    instance->nodes = instance->config.block_callback ? 2 : 1;
+
+    node_config.NodeType = DMA_GPDMA_LINEAR_NODE;
+    node_config.Init = g_hdma_dac.Init;
+    node_config.DataHandlingConfig.DataExchange = DMA_EXCHANGE_NONE;
+    node_config.DataHandlingConfig.DataAlignment =
+        DMA_DATA_RIGHTALIGN_ZEROPADDED;
+    node_config.TriggerConfig.TriggerPolarity = DMA_TRIG_POLARITY_MASKED;
+    node_config.DstAddress = (uint32_t)&DAC1->DHR12R1;
+
+    if (HAL_DMAEx_List_ResetQ(&g_dma_dac_queue) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    for (uint32_t i = 0; i < instance->nodes; ++i) {
+        uint32_t const first = node_start(i);
+
+        node_config.SrcAddress = (uint32_t)&instance->config.samples[first];
+        node_config.DataSize = (node_start(i + 1) - first) * sizeof(uint16_t);
+        if (HAL_DMAEx_List_BuildNode(&node_config, &g_dma_dac_nodes[i]) !=
+                HAL_OK ||
+            HAL_DMAEx_List_InsertNode_Tail(
+                &g_dma_dac_queue, &g_dma_dac_nodes[i]
+            ) != HAL_OK) {
+            THROW(ERROR_HARDWARE_FAULT);
+        }
+    }
+    if (HAL_DMAEx_List_SetCircularMode(&g_dma_dac_queue) != HAL_OK ||
+        HAL_DMAEx_List_LinkQ(&g_hdma_dac, &g_dma_dac_queue) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
+static void init_dma(void)
+{
+    DMA_HandleTypeDef *const hdma = &g_hdma_dac;
+
+    // Without block callbacks the DMA runs without interrupts
+    DMA_CHANNEL_claim(
+        hdma,
+        DMA_CHANNEL_CAP_LINKED_LIST,
+        IRQ_PRIORITY_GENERATION
+    );
+    hdma->Init.Request = GPDMA2_REQUEST_DAC1_CH1;
+    hdma->Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
+    hdma->Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma->Init.SrcInc = DMA_SINC_INCREMENTED;
+    hdma->Init.DestInc = DMA_DINC_FIXED;
+    hdma->Init.SrcDataWidth = DMA_SRC_DATAWIDTH_HALFWORD;
+    hdma->Init.DestDataWidth = DMA_DEST_DATAWIDTH_HALFWORD;
+    hdma->Init.Priority = DMA_HIGH_PRIORITY;
+    hdma->Init.SrcBurstLength = 1;
+    hdma->Init.DestBurstLength = 1;
+    hdma->Init.TransferAllocatedPort =
+        DMA_SRC_ALLOCATED_PORT1 | DMA_DEST_ALLOCATED_PORT0;
+    hdma->Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    hdma->Init.Mode = DMA_NORMAL;
+
+    hdma->InitLinkedList.Priority = hdma->Init.Priority;
+    hdma->InitLinkedList.LinkStepMode = DMA_LSM_FULL_EXECUTION;
+    hdma->InitLinkedList.LinkAllocatedPort = DMA_LINK_ALLOCATED_PORT0;
+    hdma->InitLinkedList.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    hdma->InitLinkedList.LinkedListMode = DMA_LINKEDLIST_CIRCULAR;
+
+    if (HAL_DMAEx_List_Init(hdma) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    hdma->XferCpltCallback = dac_dma_complete;
+}
+
+void DAC_LL_init(DAC_LL_Config const *config)
+{
+    if (!config || !config->samples || config->count == 0 ||
+        config->count > DAC_LL_SAMPLES_MAX ||
+        config->timer >= TIM_NUM_COUNT || g_triggers[config->timer] == 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (config->block_callback && config->count % 2 != 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_dac_instance.initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    g_dac_instance.config = *config;
+    configure_output();
+    init_dac();
+    init_dma();
+    g_dac_instance.initialized = true;
+}
+
+void DAC_LL_deinit(void)
+{
+    if (!g_dac_instance.initialized) {
+        return;
+    }
+
+    DAC_LL_stop();
+    (void)HAL_DAC_DeInit(&g_hdac);
+    (void)HAL_DMAEx_List_DeInit(&g_hdma_dac);
+    DMA_CHANNEL_release(&g_hdma_dac);
+    __HAL_RCC_DAC1_CLK_DISABLE();
+    g_dac_instance.initialized = false;
+}
+
+void DAC_LL_start(void)
+{
+    DACInstance *const instance = &g_dac_instance;
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+    if (instance->running) {
+        return;
+    }
+
+    if (g_hdma_dac.LinkedListQueue != nullptr &&
+        HAL_DMAEx_List_UnLinkQ(&g_hdma_dac) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    build_dma_queue();
+    instance->nodes_done = 0;
+    instance->running = true;
+
+    HAL_StatusTypeDef const status =
+        instance->config.block_callback ? HAL_DMAEx_List_Start_IT(&g_hdma_dac)
+                                        : HAL_DMAEx_List_Start(&g_hdma_dac);
+    if (status != HAL_OK) {
+        instance->running = false;
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    // Each trigger converts the held code and requests the next one
+    SET_BIT(DAC1->CR, DAC_CR_DMAEN1);
+    __HAL_DAC_ENABLE(&g_hdac, DAC_CHANNEL_1);
+}
+
+void DAC_LL_stop(void)
+{
+    DACInstance *const instance = &g_dac_instance;
+
+    if (!instance->initialized || !instance->running) {
+        return;
+    }
+
+    CLEAR_BIT(DAC1->CR, DAC_CR_DMAEN1);
+    (void)HAL_DMA_Abort(&g_hdma_dac);
+    instance->running = false;
+}
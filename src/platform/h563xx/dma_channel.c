@@ -0,0 +1,201 @@
+/**
+ * @file dma_channel.c
+ * @brief GPDMA channel allocator and channel interrupt dispatch
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "stm32h5xx_hal.h"
+
+#include "util/error.h"
+#include "util/ramfunc.h"
+
+#include "dma_channel.h"
+
+enum {
+    DMA_CHANNELS_PER_CONTROLLER = 8,
+    DMA_CONTROLLERS = 2,
+    DMA_CHANNEL_COUNT = DMA_CHANNELS_PER_CONTROLLER * DMA_CONTROLLERS,
+    DMA_CAPS_BASIC = DMA_CHANNEL_CAP_LINKED_LIST,
+    DMA_CAPS_LARGE = DMA_CHANNEL_CAP_LINKED_LIST | DMA_CHANNEL_CAP_2D |
+                     DMA_CHANNEL_CAP_FIFO_32,
+};
+
+/* Channels of GPDMA1, then those of GPDMA2 */
+static struct {
+    DMA_Channel_TypeDef *instance;
+    IRQn_Type irq;
+    uint32_t caps;
+} const g_CHANNELS[DMA_CHANNEL_COUNT] = {
+    { GPDMA1_Channel0, GPDMA1_Channel0_IRQn, DMA_CAPS_BASIC },
+    { GPDMA1_Channel1, GPDMA1_Channel1_IRQn, DMA_CAPS_BASIC },
+    { GPDMA1_Channel2, GPDMA1_Channel2_IRQn, DMA_CAPS_BASIC },
+    { GPDMA1_Channel3, GPDMA1_Channel3_IRQn, DMA_CAPS_BASIC },
+    { GPDMA1_Channel4, GPDMA1_Channel4_IRQn, DMA_CAPS_BASIC },
+    { GPDMA1_Channel5, GPDMA1_Channel5_IRQn, DMA_CAPS_BASIC },
+    { GPDMA1_Channel6, GPDMA1_Channel6_IRQn, DMA_CAPS_LARGE },
+    { GPDMA1_Channel7, GPDMA1_Channel7_IRQn, DMA_CAPS_LARGE },
+    { GPDMA2_Channel0, GPDMA2_Channel0_IRQn, DMA_CAPS_BASIC },
+    { GPDMA2_Channel1, GPDMA2_Channel1_IRQn, DMA_CAPS_BASIC },
+    { GPDMA2_Channel2, GPDMA2_Channel2_IRQn, DMA_CAPS_BASIC },
+    { GPDMA2_Channel3, GPDMA2_Channel3_IRQn, DMA_CAPS_BASIC },
+    { GPDMA2_Channel4, GPDMA2_Channel4_IRQn, DMA_CAPS_BASIC },
+    { GPDMA2_Channel5, GPDMA2_Channel5_IRQn, DMA_CAPS_BASIC },
+    { GPDMA2_Channel6, GPDMA2_Channel6_IRQn, DMA_CAPS_LARGE },
+    { GPDMA2_Channel7, GPDMA2_Channel7_IRQn, DMA_CAPS_LARGE },
+};
+
+/* Handle that claimed each channel, nullptr while free */
+static DMA_HandleTypeDef *g_owners[DMA_CHANNEL_COUNT] = { nullptr };
+
+/* Handler of each channel's interrupt, nullptr for HAL_DMA_IRQHandler */
+static DMA_CHANNEL_Handler g_handlers[DMA_CHANNEL_COUNT] = { nullptr };
+
+static uint32_t popcount(uint32_t value)
+{
+    return (uint32_t)__builtin_popcount(value);
+}
+
+static size_t find_owner(DMA_HandleTypeDef const *hdma)
+{
+    for (size_t i = 0; i < DMA_CHANNEL_COUNT; ++i) {
+        if (g_owners[i] == hdma) {
+            return i;
+        }
+    }
+    return DMA_CHANNEL_COUNT;
+}
+
+static uint32_t claimed_on_controller(size_t controller)
+{
+    uint32_t count = 0;
+    for (size_t i = 0; i < DMA_CHANNELS_PER_CONTROLLER; ++i) {
+        if (g_owners[(controller * DMA_CHANNELS_PER_CONTROLLER) + i]) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Pick the free channel for a claim
+ *
+ * @return Channel index, DMA_CHANNEL_COUNT if none is free
+ */
+static size_t pick_channel(uint32_t caps)
+{
+    size_t best = DMA_CHANNEL_COUNT;
+    uint32_t best_extra = UINT32_MAX;
+    uint32_t best_load = UINT32_MAX;
+
+    for (size_t i = 0; i < DMA_CHANNEL_COUNT; ++i) {
+        if (g_owners[i] != nullptr || (g_CHANNELS[i].caps & caps) != caps) {
+            continue;
+        }
+        uint32_t const extra = popcount(g_CHANNELS[i].caps & ~caps);
+        uint32_t const load =
+            claimed_on_controller(i / DMA_CHANNELS_PER_CONTROLLER);
+        if (extra < best_extra || (extra == best_extra && load < best_load)) {
+            best = i;
+            best_extra = extra;
+            best_load = load;
+        }
+    }
+    return best;
+}
+
+void DMA_CHANNEL_claim(
+    DMA_HandleTypeDef *hdma,
+    uint32_t caps,
+    uint32_t priority
+)
+{
+    if (hdma == nullptr) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    size_t channel = find_owner(hdma);
+    if (channel < DMA_CHANNEL_COUNT &&
+        (g_CHANNELS[channel].caps & caps) != caps) {
+        DMA_CHANNEL_release(hdma);
+        channel = DMA_CHANNEL_COUNT;
+    }
+    if (channel == DMA_CHANNEL_COUNT) {
+        channel = pick_channel(caps);
+        if (channel == DMA_CHANNEL_COUNT) {
+            THROW(ERROR_RESOURCE_UNAVAILABLE);
+        }
+    }
+
+    if (channel < DMA_CHANNELS_PER_CONTROLLER) {
+        __HAL_RCC_GPDMA1_CLK_ENABLE();
+    } else {
+        __HAL_RCC_GPDMA2_CLK_ENABLE();
+    }
+    hdma->Instance = g_CHANNELS[channel].instance;
+    g_owners[channel] = hdma;
+    g_handlers[channel] = nullptr;
+
+    HAL_NVIC_SetPriority(g_CHANNELS[channel].irq, priority, 0);
+    HAL_NVIC_EnableIRQ(g_CHANNELS[channel].irq);
+}
+
+void DMA_CHANNEL_release(DMA_HandleTypeDef *hdma)
+{
+    size_t const channel = find_owner(hdma);
+    if (channel == DMA_CHANNEL_COUNT) {
+        return;
+    }
+
+    HAL_NVIC_DisableIRQ(g_CHANNELS[channel].irq);
+    HAL_NVIC_ClearPendingIRQ(g_CHANNELS[channel].irq);
+    g_owners[channel] = nullptr;
+    g_handlers[channel] = nullptr;
+}
+
+void DMA_CHANNEL_set_handler(
+    DMA_HandleTypeDef *hdma,
+    DMA_CHANNEL_Handler handler
+)
+{
+    size_t const channel = find_owner(hdma);
+    if (channel == DMA_CHANNEL_COUNT) {
+        return;
+    }
+
+    g_handlers[channel] = handler;
+}
+
+RAMFUNC static void dispatch(size_t channel)
+{
+    DMA_HandleTypeDef *const hdma = g_owners[channel];
+    if (hdma == nullptr) {
+        return;
+    }
+    if (g_handlers[channel] != nullptr) {
+        g_handlers[channel](hdma);
+        return;
+    }
+    HAL_DMA_IRQHandler(hdma);
+}
+
+void GPDMA1_Channel0_IRQHandler(void) { dispatch(0); }
+void GPDMA1_Channel1_IRQHandler(void) { dispatch(1); }
+void GPDMA1_Channel2_IRQHandler(void) { dispatch(2); }
+void GPDMA1_Channel3_IRQHandler(void) { dispatch(3); }
+void GPDMA1_Channel4_IRQHandler(void) { dispatch(4); }
+void GPDMA1_Channel5_IRQHandler(void) { dispatch(5); }
+void GPDMA1_Channel6_IRQHandler(void) { dispatch(6); }
+void GPDMA1_Channel7_IRQHandler(void) { dispatch(7); }
+void GPDMA2_Channel0_IRQHandler(void) { dispatch(8); }
+void GPDMA2_Channel1_IRQHandler(void) { dispatch(9); }
+void GPDMA2_Channel2_IRQHandler(void) { dispatch(10); }
+void GPDMA2_Channel3_IRQHandler(void) { dispatch(11); }
+void GPDMA2_Channel4_IRQHandler(void) { dispatch(12); }
+void GPDMA2_Channel5_IRQHandler(void) { dispatch(13); }
+void GPDMA2_Channel6_IRQHandler(void) { dispatch(14); }
+void GPDMA2_Channel7_IRQHandler(void) { dispatch(15); }
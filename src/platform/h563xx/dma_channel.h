@@ -0,0 +1,98 @@
+/**
+ * @file dma_channel.h
+ * @brief GPDMA channels shared by all drivers (STM32H563xx)
+ *
+ * The two GPDMA controllers have eight channels each, and either serves
+ * every peripheral request, with the same request numbers. Rather than
+ * each driver hard-coding its channels, drivers claim them here when they
+ * set up their DMA and release them when they shut it down, so that no two
+ * drivers end up on one channel and a channel left free by one is there
+ * for the next.
+ *
+ * Channels are not all alike: only channels 6 and 7 of each controller
+ * have 2D addressing and a 32-byte FIFO, which memory bursts of more than
+ * 8 bytes need; channels 0 to 5 have an 8-byte FIFO. A claim names the
+ * capabilities it needs, and gets the least capable free channel that has
+ * them, on the controller with fewer channels claimed, so that the large
+ * channels stay free for those who need them and the load spreads over
+ * both controllers.
+ *
+ * The channel interrupt handlers live here too, and pass each interrupt on
+ * to the HAL handler of the DMA handle that claimed the channel, or to a
+ * handler of the driver's own where the HAL path is too slow.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_DMA_CHANNEL_H
+#define PSLAB_DMA_CHANNEL_H
+
+#include <stdint.h>
+
+#include "stm32h5xx_hal.h"
+
+/**
+ * @brief Channel capabilities, to be or'ed together
+ */
+enum {
+    DMA_CHANNEL_CAP_LINKED_LIST = 1U << 0, // Linked-list transfers, all
+    DMA_CHANNEL_CAP_2D = 1U << 1, // 2D addressing, channels 6 and 7
+    DMA_CHANNEL_CAP_FIFO_32 = 1U << 2, // 32-byte FIFO, channels 6 and 7
+};
+
+/**
+ * @brief Claim a channel for a DMA handle
+ *
+ * Sets hdma->Instance, so must be called before HAL_DMA_Init or
+ * HAL_DMAEx_List_Init. Enables the clock of the controller and the channel
+ * interrupt, which is passed on to HAL_DMA_IRQHandler(hdma). A handle that
+ * already holds a channel with the capabilities keeps it, so that drivers
+ * initialized again need not release it first.
+ *
+ * @param hdma DMA handle
+ * @param caps DMA_CHANNEL_CAP_* flags the channel must have
+ * @param priority NVIC preemption priority of the channel interrupt, see
+ *                 irq_priority.h
+ * @throws ERROR_RESOURCE_UNAVAILABLE if no free channel has the
+ *         capabilities
+ */
+void DMA_CHANNEL_claim(
+    DMA_HandleTypeDef *hdma,
+    uint32_t caps,
+    uint32_t priority
+);
+
+/**
+ * @brief Release the channel of a DMA handle
+ *
+ * Disables the channel interrupt. hdma->Instance is left as it is, so that
+ * HAL_DMA_DeInit may still be called on the handle. Does nothing if the
+ * handle holds no channel. The transfer must have been stopped.
+ *
+ * @param hdma DMA handle
+ */
+void DMA_CHANNEL_release(DMA_HandleTypeDef *hdma);
+
+/**
+ * @brief Channel interrupt handler, in place of HAL_DMA_IRQHandler
+ */
+typedef void (*DMA_CHANNEL_Handler)(DMA_HandleTypeDef *hdma);
+
+/**
+ * @brief Take over the interrupt of a claimed channel
+ *
+ * The handler gets the channel interrupts of the handle instead of
+ * HAL_DMA_IRQHandler, and must clear the flags it handles itself. It stays
+ * until replaced, or until the channel is claimed anew or released. Does
+ * nothing if the handle holds no channel.
+ *
+ * @param hdma DMA handle
+ * @param handler Interrupt handler; nullptr for HAL_DMA_IRQHandler
+ */
+void DMA_CHANNEL_set_handler(
+    DMA_HandleTypeDef *hdma,
+    DMA_CHANNEL_Handler handler
+);
+
+#endif // PSLAB_DMA_CHANNEL_H
@@ -0,0 +1,238 @@
+/**
+ * @file flash_ll.c
+ * @brief Persistent storage sector for the STM32H563xx
+ *
+ * The storage sector is the last sector of flash bank 2, reserved by the
+ * STORAGE region of the linker script so that it is never overwritten by
+ * firmware updates. The two sectors before it hold the key-value store,
+ * reserved by the KVSTORE region.
+ *
+ * The update area is the same range as the firmware, in bank 2. The
+ * bootloader (boot/openblt/ARMCM33_STM32H5/flash.c) swaps the banks when
+ * asked to, so logical bank 1 always holds the running firmware. Erases
+ * select the physical bank, which is the other one while the banks are
+ * swapped.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "stm32h5xx_hal.h"
+
+#include "util/error.h"
+#include "util/logging.h"
+
+#include "flash_ll.h"
+
+// Defined by the linker script
+extern uint8_t const _sstorage[];
+extern uint8_t const _estorage[];
+extern uint8_t const _skvstore[];
+extern uint8_t const _ekvstore[];
+extern uint8_t const _supdate[];
+extern uint8_t const _eupdate[];
+extern uint32_t volatile _sboot_shared[];
+
+enum {
+    // Word of the shared RAM holding a bank swap request (boot/blt_conf.h)
+    BOOT_SHARED_BANK_SWAP_WORD = 1,
+    BANK_SWAP_MAGIC = 0x53574150, // "SWAP"
+};
+
+/**
+ * @brief Check that a range lies within the storage sector
+ */
+static bool range_is_valid(uint32_t offset, uint32_t size)
+{
+    uint32_t const sector_size = (uint32_t)(_estorage - _sstorage);
+    return offset <= sector_size && size <= sector_size - offset;
+}
+
+/**
+ * @brief Check that a range lies within the key-value store sectors
+ */
+static bool kv_range_is_valid(uint32_t offset, uint32_t size)
+{
+    uint32_t const area_size = (uint32_t)(_ekvstore - _skvstore);
+    return offset <= area_size && size <= area_size - offset;
+}
+
+/**
+ * @brief Check that a range lies within the update area
+ */
+static bool update_range_is_valid(uint32_t offset, uint32_t size)
+{
+    uint32_t const area_size = (uint32_t)(_eupdate - _supdate);
+    return offset <= area_size && size <= area_size - offset;
+}
+
+/**
+ * @brief Physical bank holding a flash address
+ */
+static uint32_t physical_bank(uint32_t address)
+{
+    bool const upper = address >= FLASH_BASE + FLASH_BANK_SIZE;
+    bool const swapped =
+        READ_BIT(FLASH->OPTSR_CUR, FLASH_OPTSR_SWAP_BANK) != 0U;
+    return upper != swapped ? FLASH_BANK_2 : FLASH_BANK_1;
+}
+
+/**
+ * @brief Sector number of a flash address within its bank
+ */
+static uint32_t bank_sector(uint32_t address)
+{
+    return ((address - FLASH_BASE) % FLASH_BANK_SIZE) / FLASH_SECTOR_SIZE;
+}
+
+/**
+ * @brief Erase the sector holding a flash address
+ *
+ * @throws ERROR_HARDWARE_FAULT if the erase fails
+ */
+static void erase_sector(uint32_t address)
+{
+    FLASH_EraseInitTypeDef erase = {
+        .TypeErase = FLASH_TYPEERASE_SECTORS,
+        .Banks = physical_bank(address),
+        .Sector = bank_sector(address),
+        .NbSectors = 1,
+    };
+    uint32_t sector_error = 0;
+
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef const status = HAL_FLASHEx_Erase(&erase, &sector_error);
+    HAL_FLASH_Lock();
+
+    // Reads through the instruction cache could return the old contents
+    HAL_ICACHE_Invalidate();
+
+    if (status != HAL_OK) {
+        LOG_ERROR("FLASH: Erase failed (0x%08X)", HAL_FLASH_GetError());
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
+/**
+ * @brief Program erased flash, one quad-word at a time
+ *
+ * @throws ERROR_HARDWARE_FAULT if programming fails
+ */
+static void program(uint8_t const *dst, void const *data, uint32_t size)
+{
+    uint8_t const *src = data;
+    HAL_StatusTypeDef status = HAL_OK;
+
+    HAL_FLASH_Unlock();
+    for (uint32_t i = 0; i < size && status == HAL_OK;
+         i += FLASH_LL_WRITE_ALIGN) {
+        status = HAL_FLASH_Program(
+            FLASH_TYPEPROGRAM_QUADWORD, (uint32_t)&dst[i], (uint32_t)&src[i]
+        );
+    }
+    HAL_FLASH_Lock();
+
+    HAL_ICACHE_Invalidate();
+
+    if (status != HAL_OK) {
+        LOG_ERROR("FLASH: Program failed (0x%08X)", HAL_FLASH_GetError());
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
+/**
+ * @brief Check the alignment rules of a write
+ */
+static bool write_is_aligned(uint32_t offset, void const *data, uint32_t size)
+{
+    return data && ((uintptr_t)data % sizeof(uint32_t)) == 0 &&
+           (offset % FLASH_LL_WRITE_ALIGN) == 0 &&
+           (size % FLASH_LL_WRITE_ALIGN) == 0;
+}
+
+void FLASH_LL_read(uint32_t offset, void *data, uint32_t size)
+{
+    if (!data || !range_is_valid(offset, size)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    memcpy(data, &_sstorage[offset], size);
+}
+
+void FLASH_LL_erase(void)
+{
+    erase_sector((uint32_t)_sstorage);
+}
+
+void FLASH_LL_write(uint32_t offset, void const *data, uint32_t size)
+{
+    if (!write_is_aligned(offset, data, size) ||
+        !range_is_valid(offset, size)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    program(&_sstorage[offset], data, size);
+}
+
+void FLASH_LL_kv_read(uint32_t offset, void *data, uint32_t size)
+{
+    if (!data || !kv_range_is_valid(offset, size)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    memcpy(data, &_skvstore[offset], size);
+}
+
+void FLASH_LL_kv_erase(uint32_t offset)
+{
+    if ((offset % FLASH_LL_SECTOR_SIZE) != 0 ||
+        !kv_range_is_valid(offset, FLASH_LL_SECTOR_SIZE)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    erase_sector((uint32_t)&_skvstore[offset]);
+}
+
+void FLASH_LL_kv_write(uint32_t offset, void const *data, uint32_t size)
+{
+    if (!write_is_aligned(offset, data, size) ||
+        !kv_range_is_valid(offset, size)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    program(&_skvstore[offset], data, size);
+}
+
+void FLASH_LL_update_read(uint32_t offset, void *data, uint32_t size)
+{
+    if (!data || !update_range_is_valid(offset, size)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    memcpy(data, &_supdate[offset], size);
+}
+
+void FLASH_LL_update_erase(uint32_t offset)
+{
+    if ((offset % FLASH_LL_SECTOR_SIZE) != 0 ||
+        !update_range_is_valid(offset, FLASH_LL_SECTOR_SIZE)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    erase_sector((uint32_t)&_supdate[offset]);
+}
+
+void FLASH_LL_update_write(uint32_t offset, void const *data, uint32_t size)
+{
+    if (!write_is_aligned(offset, data, size) ||
+        !update_range_is_valid(offset, size)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    program(&_supdate[offset], data, size);
+}
+
+void FLASH_LL_request_bank_swap(void)
+{
+    _sboot_shared[BOOT_SHARED_BANK_SWAP_WORD] = BANK_SWAP_MAGIC;
+}
@@ -0,0 +1,504 @@
+/**
+ * @file i2c_ll.c
+ * @brief I2C hardware implementation for STM32H563xx
+ *
+ * This module handles initialization and operation of the I2C peripheral of
+ * the STM32H5 microcontroller as bus controller. It configures the hardware
+ * and dispatches I2C interrupts to the hardware-independent I2C
+ * implementation.
+ *
+ * Implementation Details:
+ * - I2C1 on PB8 (SCL) and PB9 (SDA), the Arduino header's I2C pins
+ * - Register reads and writes over DMA, on a TX and an RX channel claimed
+ *   from the GPDMA pool
+ * - Kernel clock from HSI, so that system clock scaling leaves the timing
+ *   alone
+ * - 10 kHz to 1 MHz, the timing computed for the mode each rate falls in
+ * - NVIC priority set to 3 for I2C interrupts, as for UART
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "stm32h5xx_hal.h"
+
+#include "util/error.h"
+
+#include "dma_channel.h"
+#include "i2c_ll.h"
+#include "irq_priority.h"
+
+enum {
+    // Prescaled clock counts per bus clock period, for which the data
+    // setup and hold delays fit in their 4-bit fields
+    I2C_PERIOD_COUNTS = 40,
+    I2C_PRESC_MAX = 15,
+    I2C_DEL_MAX = 15, // SCLDEL and SDADEL
+    I2C_SCL_COUNTS_MAX = 256, // SCLL and SCLH, plus one
+    I2C_SPEED_STANDARD_MAX = 100000,
+    I2C_SPEED_FAST_MAX = 400000,
+};
+
+/* Timing of one I2C mode */
+typedef struct {
+    uint32_t low_percent; // Share of the period SCL is low
+    uint32_t data_setup; // ns of SDA setup before SCL rises, plus rise time
+    uint32_t data_hold; // ns of SDA hold after SCL falls
+} I2CModeTiming;
+
+/* Standard-mode, Fast-mode and Fast-mode Plus, within the I2C spec limits */
+static I2CModeTiming const g_mode_timings[] = {
+    { .low_percent = 55, .data_setup = 1250, .data_hold = 300 },
+    { .low_percent = 70, .data_setup = 400, .data_hold = 300 },
+    { .low_percent = 70, .data_setup = 170, .data_hold = 0 },
+};
+
+/* I2C instance configuration */
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    DMA_HandleTypeDef *hdma_tx;
+    DMA_HandleTypeDef *hdma_rx;
+    uint32_t speed;
+    bool volatile busy;
+    I2C_LL_CompleteCallback complete_callback;
+    bool initialized;
+} I2CInstance;
+
+/* HAL I2C handles */
+static I2C_HandleTypeDef g_hi2c1 = { nullptr };
+
+/* DMA handles */
+static DMA_HandleTypeDef g_hdma_i2c1_tx = { nullptr };
+static DMA_HandleTypeDef g_hdma_i2c1_rx = { nullptr };
+
+/* Instance array */
+static I2CInstance g_i2c_instances[I2C_BUS_COUNT] = {
+    [I2C_BUS_0] = {
+        .hi2c = &g_hi2c1,
+        .hdma_tx = &g_hdma_i2c1_tx,
+        .hdma_rx = &g_hdma_i2c1_rx,
+    },
+};
+
+/**
+ * @brief Get I2C instance from HAL handle
+ */
+static I2C_Bus get_bus_from_handle(I2C_HandleTypeDef *hi2c)
+{
+    if (hi2c->Instance == I2C1) {
+        return I2C_BUS_0;
+    }
+    return I2C_BUS_COUNT; // Invalid
+}
+
+/**
+ * @brief Claim and configure a DMA channel for normal byte transfers
+ */
+static void init_dma(
+    DMA_HandleTypeDef *hdma,
+    uint32_t request,
+    bool to_peripheral
+)
+{
+    DMA_CHANNEL_claim(hdma, 0, IRQ_PRIORITY_BUS);
+    hdma->Init.Request = request;
+    hdma->Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
+    hdma->Init.Direction =
+        to_peripheral ? DMA_MEMORY_TO_PERIPH : DMA_PERIPH_TO_MEMORY;
+    hdma->Init.SrcInc = to_peripheral ? DMA_SINC_INCREMENTED : DMA_SINC_FIXED;
+    hdma->Init.DestInc =
+        to_peripheral ? DMA_DINC_FIXED : DMA_DINC_INCREMENTED;
+    hdma->Init.SrcDataWidth = DMA_SRC_DATAWIDTH_BYTE;
+    hdma->Init.DestDataWidth = DMA_DEST_DATAWIDTH_BYTE;
+    hdma->Init.Priority = DMA_LOW_PRIORITY_LOW_WEIGHT;
+    hdma->Init.SrcBurstLength = 1;
+    hdma->Init.DestBurstLength = 1;
+    hdma->Init.TransferAllocatedPort =
+        (DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0);
+    hdma->Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    hdma->Init.Mode = DMA_NORMAL;
+    if (HAL_DMA_Init(hdma) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
+/**
+ * @brief MSP initialization for I2C
+ *
+ * This function is called by HAL_I2C_Init() to configure the kernel clock,
+ * GPIO pins, DMA channels, and interrupts for the I2C interface.
+ *
+ * @param hi2c I2C handle
+ */
+void HAL_I2C_MspInit(I2C_HandleTypeDef *hi2c)
+{
+    GPIO_InitTypeDef gpio_init = { 0 };
+    RCC_PeriphCLKInitTypeDef clk_init = { 0 };
+
+    if (hi2c->Instance != I2C1) {
+        return;
+    }
+
+    clk_init.PeriphClockSelection = RCC_PERIPHCLK_I2C1;
+    clk_init.I2c1ClockSelection = RCC_I2C1CLKSOURCE_HSI;
+    if (HAL_RCCEx_PeriphCLKConfig(&clk_init) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    __HAL_RCC_I2C1_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+
+    /* I2C1 GPIO Configuration: PB8=SCL, PB9=SDA */
+    gpio_init.Pin = GPIO_PIN_8 | GPIO_PIN_9;
+    gpio_init.Mode = GPIO_MODE_AF_OD;
+    gpio_init.Pull = GPIO_PULLUP;
+    gpio_init.Speed = GPIO_SPEED_FREQ_HIGH;
+    gpio_init.Alternate = GPIO_AF4_I2C1;
+    HAL_GPIO_Init(GPIOB, &gpio_init);
+
+    init_dma(&g_hdma_i2c1_tx, GPDMA2_REQUEST_I2C1_TX, true);
+    __HAL_LINKDMA(hi2c, hdmatx, g_hdma_i2c1_tx);
+    init_dma(&g_hdma_i2c1_rx, GPDMA2_REQUEST_I2C1_RX, false);
+    __HAL_LINKDMA(hi2c, hdmarx, g_hdma_i2c1_rx);
+
+    /* I2C interrupt init */
+    HAL_NVIC_SetPriority(I2C1_EV_IRQn, IRQ_PRIORITY_BUS, 0);
+    HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+    HAL_NVIC_SetPriority(I2C1_ER_IRQn, IRQ_PRIORITY_BUS, 0);
+    HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
+}
+
+/**
+ * @brief MSP deinitialization for I2C
+ *
+ * @param hi2c I2C handle
+ */
+void HAL_I2C_MspDeInit(I2C_HandleTypeDef *hi2c)
+{
+    if (hi2c->Instance != I2C1) {
+        return;
+    }
+
+    HAL_NVIC_DisableIRQ(I2C1_EV_IRQn);
+    HAL_NVIC_DisableIRQ(I2C1_ER_IRQn);
+    HAL_DMA_DeInit(&g_hdma_i2c1_tx);
+    DMA_CHANNEL_release(&g_hdma_i2c1_tx);
+    HAL_DMA_DeInit(&g_hdma_i2c1_rx);
+    DMA_CHANNEL_release(&g_hdma_i2c1_rx);
+    HAL_GPIO_DeInit(GPIOB, GPIO_PIN_8 | GPIO_PIN_9);
+    __HAL_RCC_I2C1_CLK_DISABLE();
+}
+
+/**
+ * @brief Delay in prescaled clock counts, rounded up
+ */
+static uint32_t delay_counts(uint32_t ns, uint32_t clock)
+{
+    return (uint32_t)((((uint64_t)ns * clock) + 999999999ULL) / 1000000000ULL
+    );
+}
+
+/**
+ * @brief Get the timing of the I2C mode a clock rate falls in
+ */
+static I2CModeTiming const *mode_timing(uint32_t speed)
+{
+    if (speed <= I2C_SPEED_STANDARD_MAX) {
+        return &g_mode_timings[0];
+    }
+    if (speed <= I2C_SPEED_FAST_MAX) {
+        return &g_mode_timings[1];
+    }
+    return &g_mode_timings[2];
+}
+
+/**
+ * @brief Compute the TIMINGR value for a clock rate
+ *
+ * @param kernel Kernel clock frequency in Hz
+ * @param speed Bus clock rate in Hz
+ * @return TIMINGR value, or 0 if the rate cannot be generated
+ */
+static uint32_t compute_timing(uint32_t kernel, uint32_t speed)
+{
+    uint32_t presc = kernel / (speed * I2C_PERIOD_COUNTS);
+    presc = presc > 0 ? presc - 1 : 0;
+    if (presc > I2C_PRESC_MAX) {
+        presc = I2C_PRESC_MAX;
+    }
+
+    uint32_t const clock = kernel / (presc + 1);
+    uint32_t const counts = clock / speed;
+    I2CModeTiming const *const mode = mode_timing(speed);
+    uint32_t const low = (counts * mode->low_percent + 50) / 100;
+    uint32_t const high = counts - low;
+    // The setup delay is SCLDEL + 1 counts, the hold delay SDADEL counts
+    uint32_t const setup = delay_counts(mode->data_setup, clock);
+    uint32_t const scldel = setup > 0 ? setup - 1 : 0;
+    uint32_t const sdadel = delay_counts(mode->data_hold, clock);
+
+    if (low == 0 || high == 0 || low > I2C_SCL_COUNTS_MAX ||
+        high > I2C_SCL_COUNTS_MAX || scldel > I2C_DEL_MAX ||
+        sdadel > I2C_DEL_MAX) {
+        return 0;
+    }
+
+    return (presc << I2C_TIMINGR_PRESC_Pos) |
+           (scldel << I2C_TIMINGR_SCLDEL_Pos) |
+           (sdadel << I2C_TIMINGR_SDADEL_Pos) |
+           ((high - 1) << I2C_TIMINGR_SCLH_Pos) |
+           ((low - 1) << I2C_TIMINGR_SCLL_Pos);
+}
+
+/**
+ * @brief Program the clock rate of an instance into the peripheral
+ *
+ * HAL_I2C_Init only runs the MSP initialization the first time, so this
+ * also reconfigures an initialized peripheral.
+ */
+static void apply_speed(I2CInstance *instance, uint32_t speed)
+{
+    uint32_t const timing = compute_timing(
+        HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_I2C1), speed
+    );
+
+    if (timing == 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    instance->hi2c->Init.Timing = timing;
+    instance->hi2c->Init.OwnAddress1 = 0;
+    instance->hi2c->Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+    instance->hi2c->Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
+    instance->hi2c->Init.OwnAddress2 = 0;
+    instance->hi2c->Init.OwnAddress2Masks = I2C_OA2_NOMASK;
+    instance->hi2c->Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
+    instance->hi2c->Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
+
+    if (HAL_I2C_Init(instance->hi2c) != HAL_OK ||
+        HAL_I2CEx_ConfigAnalogFilter(
+            instance->hi2c, I2C_ANALOGFILTER_ENABLE
+        ) != HAL_OK ||
+        HAL_I2CEx_ConfigFastModePlus(
+            instance->hi2c,
+            speed > I2C_SPEED_FAST_MAX ? I2C_FASTMODEPLUS_ENABLE
+                                       : I2C_FASTMODEPLUS_DISABLE
+        ) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    instance->speed = speed;
+}
+
+void I2C_LL_init(I2C_Bus bus)
+{
+    if (bus >= I2C_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    I2CInstance *instance = &g_i2c_instances[bus];
+
+    if (instance->initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    instance->hi2c->Instance = I2C1;
+    apply_speed(instance, I2C_LL_SPEED_DEFAULT);
+
+    instance->busy = false;
+    instance->initialized = true;
+}
+
+void I2C_LL_deinit(I2C_Bus bus)
+{
+    if (bus >= I2C_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    I2CInstance *instance = &g_i2c_instances[bus];
+
+    if (!instance->initialized) {
+        return;
+    }
+
+    /* Stops the peripheral and its DMA without calling back */
+    if (HAL_I2C_DeInit(instance->hi2c) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    instance->busy = false;
+    instance->complete_callback = nullptr;
+    instance->speed = 0;
+    instance->initialized = false;
+}
+
+void I2C_LL_set_speed(I2C_Bus bus, uint32_t speed)
+{
+    if (bus >= I2C_BUS_COUNT || speed < I2C_LL_SPEED_MIN ||
+        speed > I2C_LL_SPEED_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    I2CInstance *instance = &g_i2c_instances[bus];
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (instance->busy) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    apply_speed(instance, speed);
+}
+
+void I2C_LL_start(I2C_Bus bus, I2C_LL_Transfer const *transfer)
+{
+    if (bus >= I2C_BUS_COUNT || !transfer || !transfer->data ||
+        transfer->size == 0 || transfer->size > I2C_LL_TRANSFER_MAX ||
+        transfer->address > I2C_LL_ADDRESS_MAX || transfer->reg_size > 2) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    I2CInstance *instance = &g_i2c_instances[bus];
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (instance->busy) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    I2C_HandleTypeDef *const hi2c = instance->hi2c;
+    // HAL takes the address in the upper seven bits
+    uint16_t const address = (uint16_t)(transfer->address << 1);
+    uint16_t const size = (uint16_t)transfer->size;
+    uint16_t const reg_size = transfer->reg_size == 2 ? I2C_MEMADD_SIZE_16BIT
+                                                      : I2C_MEMADD_SIZE_8BIT;
+    HAL_StatusTypeDef status;
+
+    instance->busy = true;
+    if (transfer->reg_size == 0) {
+        status = transfer->read ? HAL_I2C_Master_Receive_DMA(
+                                      hi2c, address, transfer->data, size
+                                  )
+                                : HAL_I2C_Master_Transmit_DMA(
+                                      hi2c, address, transfer->data, size
+                                  );
+    } else if (transfer->read) {
+        status = HAL_I2C_Mem_Read_DMA(
+            hi2c, address, transfer->reg, reg_size, transfer->data, size
+        );
+    } else {
+        status = HAL_I2C_Mem_Write_DMA(
+            hi2c, address, transfer->reg, reg_size, transfer->data, size
+        );
+    }
+
+    if (status != HAL_OK) {
+        instance->busy = false;
+        THROW(status == HAL_BUSY ? ERROR_RESOURCE_BUSY : ERROR_HARDWARE_FAULT);
+    }
+}
+
+bool I2C_LL_busy(I2C_Bus bus)
+{
+    if (bus >= I2C_BUS_COUNT || !g_i2c_instances[bus].initialized) {
+        return false;
+    }
+
+    return g_i2c_instances[bus].busy;
+}
+
+void I2C_LL_set_complete_callback(
+    I2C_Bus bus,
+    I2C_LL_CompleteCallback callback
+)
+{
+    if (bus >= I2C_BUS_COUNT) {
+        return;
+    }
+    g_i2c_instances[bus].complete_callback = callback;
+}
+
+/**
+ * @brief End a transfer and notify the hardware-independent layer
+ */
+static void complete(I2C_HandleTypeDef *hi2c, I2C_LL_Status status)
+{
+    I2C_Bus const bus = get_bus_from_handle(hi2c);
+    if (bus >= I2C_BUS_COUNT) {
+        return;
+    }
+
+    I2CInstance *instance = &g_i2c_instances[bus];
+    instance->busy = false;
+
+    if (instance->complete_callback != nullptr) {
+        instance->complete_callback(bus, status);
+    }
+}
+
+/**
+ * @brief I2C controller TX complete callback
+ */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    complete(hi2c, I2C_LL_STATUS_OK);
+}
+
+/**
+ * @brief I2C controller RX complete callback
+ */
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    complete(hi2c, I2C_LL_STATUS_OK);
+}
+
+/**
+ * @brief I2C register write complete callback
+ */
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    complete(hi2c, I2C_LL_STATUS_OK);
+}
+
+/**
+ * @brief I2C register read complete callback
+ */
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    complete(hi2c, I2C_LL_STATUS_OK);
+}
+
+/**
+ * @brief I2C error callback
+ *
+ * Called by HAL once the transfer has been stopped, with the bus released.
+ */
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    uint32_t const error = HAL_I2C_GetError(hi2c);
+    I2C_LL_Status status = I2C_LL_STATUS_BUS_ERROR;
+
+    if ((error & HAL_I2C_ERROR_AF) != 0) {
+        status = I2C_LL_STATUS_NACK;
+    } else if ((error & HAL_I2C_ERROR_DMA) != 0) {
+        status = I2C_LL_STATUS_DMA_ERROR;
+    }
+    complete(hi2c, status);
+}
+
+/**
+ * @brief I2C1 event interrupt handler
+ */
+void I2C1_EV_IRQHandler(void) { HAL_I2C_EV_IRQHandler(&g_hi2c1); }
+
+/**
+ * @brief I2C1 error interrupt handler
+ */
+void I2C1_ER_IRQHandler(void) { HAL_I2C_ER_IRQHandler(&g_hi2c1); }
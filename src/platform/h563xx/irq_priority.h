@@ -0,0 +1,51 @@
+/**
+ * @file irq_priority.h
+ * @brief NVIC priorities of the interrupts of all drivers (STM32H563xx)
+ *
+ * The priorities are planned here, in one place, rather than in each
+ * driver, so that what can preempt what is seen at a glance. HAL_Init
+ * selects 4 bits of preemption priority and no subpriority, so each level
+ * below preempts the levels after it, and interrupts of one level run in
+ * turn.
+ *
+ * From the top:
+ * - The synchronized start edge, so that boards start together
+ * - Acquisition DMA and the ADC: a half of a DMA ring serviced late is
+ *   overwritten by the next, and the logic analyzer stops its timer on
+ *   time only from here
+ * - Generation DMA and the frequency counter, each half of their rings
+ *   many samples long
+ * - USB, which only moves packets in its interrupt; its stack runs from
+ *   the service interrupt at the bottom
+ * - The I2C and SPI buses, whose transfers the main loop waits for
+ * - The UARTs, the log UART included, whose DMA rings take bursts
+ * - The CRC unit and memory copy DMA, which only chain the blocks of a
+ *   checksum or a copy
+ * - The deferred USB service and the SysTick, which reads of the time
+ *   take into account when it is pending
+ *
+ * SYSTem:IRQ? reports the priorities in effect, see PLATFORM_get_irq_info.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_IRQ_PRIORITY_H
+#define PSLAB_IRQ_PRIORITY_H
+
+#include "stm32h5xx_hal.h"
+
+enum {
+    IRQ_PRIORITY_SYNC_TRIGGER = 0, // EXTI2, see TIM_LL_sync_set_trigger_input
+    IRQ_PRIORITY_ACQUISITION = 1, // ADC, ADC DMA and logic analyzer DMA
+    IRQ_PRIORITY_GENERATION = 2, // DAC DMA and frequency counter DMA
+    IRQ_PRIORITY_USB = 4, // USB_DRD_FS
+    IRQ_PRIORITY_BUS = 6, // I2C and SPI, and their DMA
+    IRQ_PRIORITY_UART = 7, // USARTs and their DMA
+    IRQ_PRIORITY_CRC = 8, // CRC unit DMA, see crc_ll.c
+    IRQ_PRIORITY_COPY = 8, // Memory copy DMA, see copy_ll.c
+    IRQ_PRIORITY_USB_SERVICE = 15, // PendSV, the TinyUSB stack
+    IRQ_PRIORITY_TICK = TICK_INT_PRIORITY, // SysTick, set up by HAL_Init
+};
+
+#endif // PSLAB_IRQ_PRIORITY_H
@@ -0,0 +1,152 @@
+/**
+ * @file itm_ll.c
+ * @brief Low-level ITM stimulus port output over SWO (STM32H563xx)
+ *
+ * Hardware Implementation Details:
+ * - SWO is TRACESWO on PB3, alternate function 0
+ * - The TPIU sends NRZ frames with the formatter bypassed, so the pin
+ *   carries the ITM packets as they are
+ * - The TPIU prescaler divides HCLK, which PLATFORM_set_clock_speed scales;
+ *   writes reprogram it when HCLK has changed since the last one
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stm32h5xx_hal.h"
+
+#include "itm_ll.h"
+
+#define ITM_SWO_GPIO_GROUP GPIOB
+#define ITM_SWO_GPIO_PIN GPIO_PIN_3
+
+// Unlocks the ITM registers for writing
+static uint32_t const g_ITM_UNLOCK = 0xC5ACCE55;
+
+// ATB ID of the ITM in the trace stream, as set up by debuggers
+static uint32_t const g_ITM_BUS_ID = 1;
+
+// NRZ (UART) encoding in TPI_SPPR
+static uint32_t const g_TPI_TXMODE_NRZ = 2;
+
+static struct {
+    bool initialized;
+    uint32_t baudrate;
+    uint32_t hclk; // HCLK the prescaler is set for
+} g_itm = { false, 0, 0 };
+
+/**
+ * @brief Set the TPIU prescaler for the current HCLK
+ */
+static void update_prescaler(void)
+{
+    uint32_t const hclk = SystemCoreClock; // HCLK, kept up to date by the HAL
+    uint32_t prescaler = (hclk + (g_itm.baudrate / 2)) / g_itm.baudrate;
+
+    prescaler = prescaler < 1 ? 1 : prescaler;
+    prescaler = prescaler > TPI_ACPR_PRESCALER_Msk + 1
+                    ? TPI_ACPR_PRESCALER_Msk + 1
+                    : prescaler;
+    TPI->ACPR = prescaler - 1;
+    g_itm.hclk = hclk;
+}
+
+/**
+ * @brief Whether a port can take a write now
+ */
+static bool port_ready(uint32_t port)
+{
+    if (!ITM_LL_port_enabled(port)) {
+        return false;
+    }
+    // A debugger may have set up the ITM without ITM_LL_init
+    if (g_itm.initialized && SystemCoreClock != g_itm.hclk) {
+        update_prescaler();
+    }
+    return (ITM->PORT[port].u32 & ITM_STIM_FIFOREADY_Msk) != 0;
+}
+
+void ITM_LL_init(uint32_t baudrate, uint32_t port_mask)
+{
+    GPIO_InitTypeDef gpio_init = { 0 };
+
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    gpio_init.Pin = ITM_SWO_GPIO_PIN;
+    gpio_init.Mode = GPIO_MODE_AF_PP;
+    gpio_init.Pull = GPIO_NOPULL;
+    gpio_init.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio_init.Alternate = GPIO_AF0_TRACE;
+    HAL_GPIO_Init(ITM_SWO_GPIO_GROUP, &gpio_init);
+
+    // Trace port in asynchronous mode (TRACE_MODE 0), clocked and driven
+    DBGMCU->CR = (DBGMCU->CR & ~DBGMCU_CR_TRACE_MODE) | DBGMCU_CR_TRACE_IOEN |
+                 DBGMCU_CR_TRACE_CLKEN;
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+
+    g_itm.baudrate = baudrate > 0 ? baudrate : 1;
+    TPI->SPPR = g_TPI_TXMODE_NRZ;
+    TPI->FFCR = TPI_FFCR_TrigIn_Msk; // Formatter bypassed
+    update_prescaler();
+
+    ITM->LAR = g_ITM_UNLOCK;
+    ITM->TCR = 0;
+    while (ITM->TCR & ITM_TCR_BUSY_Msk) {
+    }
+    ITM->TPR = 0; // Ports writable without privilege
+    ITM->TCR = (g_ITM_BUS_ID << ITM_TCR_TRACEBUSID_Pos) | ITM_TCR_SWOENA_Msk |
+               ITM_TCR_SYNCENA_Msk | ITM_TCR_ITMENA_Msk;
+    ITM->TER = port_mask;
+    g_itm.initialized = true;
+}
+
+void ITM_LL_deinit(void)
+{
+    if (!g_itm.initialized) {
+        return;
+    }
+
+    ITM->TER = 0;
+    ITM->TCR = 0;
+    while (ITM->TCR & ITM_TCR_BUSY_Msk) {
+    }
+    DBGMCU->CR &= ~(DBGMCU_CR_TRACE_IOEN | DBGMCU_CR_TRACE_CLKEN);
+    HAL_GPIO_DeInit(ITM_SWO_GPIO_GROUP, ITM_SWO_GPIO_PIN);
+    g_itm.initialized = false;
+}
+
+bool ITM_LL_port_enabled(uint32_t port)
+{
+    return port < ITM_LL_PORT_COUNT && (ITM->TCR & ITM_TCR_ITMENA_Msk) &&
+           (ITM->TER & (1UL << port));
+}
+
+bool ITM_LL_write_word(uint32_t port, uint32_t word)
+{
+    if (!port_ready(port)) {
+        return false;
+    }
+    ITM->PORT[port].u32 = word;
+    return true;
+}
+
+uint32_t ITM_LL_write(uint32_t port, uint8_t const *data, uint32_t size)
+{
+    uint32_t done = 0;
+
+    while (done < size && port_ready(port)) {
+        if (size - done >= sizeof(uint32_t)) {
+            ITM->PORT[port].u32 = (uint32_t)data[done] |
+                                  ((uint32_t)data[done + 1] << 8) |
+                                  ((uint32_t)data[done + 2] << 16) |
+                                  ((uint32_t)data[done + 3] << 24);
+            done += sizeof(uint32_t);
+        } else {
+            ITM->PORT[port].u8 = data[done];
+            ++done;
+        }
+    }
+    return done;
+}
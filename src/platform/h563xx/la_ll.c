@@ -0,0 +1,293 @@
+/**
+ * @file la_ll.c
+ * @brief Timer-paced sampling of GPIO port E for the logic analyzer
+ *
+ * The inputs are PE0 to PE7. The update event of the pacing timer requests
+ * a byte transfer from GPIOE->IDR on a GPDMA channel with the large FIFO,
+ * see dma_channel.h, so that memory is written in bursts. A capture longer
+ * than one DMA block is split over a linked list, as in adc_ll.c. A
+ * continuous capture makes the list circular over two nodes, one per half
+ * of the ring.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stm32h5xx_hal.h"
+
+#include "util/error.h"
+
+#include "dma_channel.h"
+#include "irq_priority.h"
+#include "la_ll.h"
+#include "tim_ll.h"
+
+enum {
+    LA_DMA_BLOCK_MAX = 0xFFFF, // Largest GPDMA block in bytes
+    LA_DMA_NODES_MAX = LA_LL_SAMPLES_MAX / LA_DMA_BLOCK_MAX,
+    LA_DMA_BURST = 16, // Bytes per memory burst
+    LA_PINS = GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4 |
+              GPIO_PIN_5 | GPIO_PIN_6 | GPIO_PIN_7,
+};
+
+typedef struct {
+    LA_LL_Config config;
+    uint32_t nodes; // DMA blocks the buffer is split into
+    uint32_t volatile nodes_done; // Blocks completed since LA_LL_start
+    bool initialized;
+    bool volatile running;
+} LAInstance;
+
+static DMA_HandleTypeDef g_hdma_la = { nullptr };
+static DMA_NodeTypeDef g_dma_la_nodes[LA_DMA_NODES_MAX] = { 0 };
+static DMA_QListTypeDef g_dma_la_queue = { nullptr };
+static LAInstance g_la_instance = { 0 };
+
+// GPDMA2 requests of the update events, in TIM_Num order
+static uint32_t const g_update_requests[TIM_NUM_COUNT] = {
+    [TIM_NUM_6] = GPDMA2_REQUEST_TIM6_UP,
+    [TIM_NUM_7] = GPDMA2_REQUEST_TIM7_UP,
+    [TIM_NUM_1] = GPDMA2_REQUEST_TIM1_UP,
+    [TIM_NUM_2] = GPDMA2_REQUEST_TIM2_UP,
+    [TIM_NUM_3] = GPDMA2_REQUEST_TIM3_UP,
+    [TIM_NUM_4] = GPDMA2_REQUEST_TIM4_UP,
+    [TIM_NUM_8] = GPDMA2_REQUEST_TIM8_UP,
+    [TIM_NUM_15] = GPDMA2_REQUEST_TIM15_UP,
+};
+
+/**
+ * @brief First sample of a DMA block
+ */
+static uint32_t node_start(uint32_t node)
+{
+    return (node * g_la_instance.config.samples) / g_la_instance.nodes;
+}
+
+static void finish(uint32_t samples)
+{
+    LAInstance *const instance = &g_la_instance;
+
+    TIM_LL_set_update_dma(instance->config.timer, false);
+    instance->running = false;
+    if (instance->config.complete_callback) {
+        instance->config.complete_callback(samples);
+    }
+}
+
+static void la_dma_complete(DMA_HandleTypeDef *hdma)
+{
+    LAInstance *const instance = &g_la_instance;
+
+    (void)hdma;
+    if (instance->config.block_callback) {
+        // Two nodes, so the count wraps at a node boundary
+        uint32_t const node = instance->nodes_done++ % instance->nodes;
+        uint32_t const first = node_start(node);
+        instance->config.block_callback(
+            &instance->config.buffer[first], node_start(node + 1) - first
+        );
+        return;
+    }
+    if (++instance->nodes_done >= instance->nodes) {
+        finish(instance->config.samples);
+    }
+}
+
+static void la_dma_error(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+    finish(LA_LL_get_position());
+}
+
+static void configure_inputs(void)
+{
+    GPIO_InitTypeDef gpio_init = { 0 };
+
+    __HAL_RCC_GPIOE_CLK_ENABLE();
+    gpio_init.Pin = LA_PINS;
+    gpio_init.Mode = GPIO_MODE_INPUT;
+    gpio_init.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(GPIOE, &gpio_init);
+}
+
+/**
+ * @brief Split the buffer over the linked-list queue, one node per block
+ */
+static void build_dma_queue(void)
+{
+    LAInstance *const instance = &g_la_instance;
+    DMA_NodeConfTypeDef node_config = { 0 };
+
+    instance->nodes =
+        instance->config.block_callback
+            ? 2
+            : (instance->config.samples + LA_DMA_BLOCK_MAX - 1) /
+                  LA_DMA_BLOCK_MAX;
+
+    node_config.NodeType = DMA_GPDMA_LINEAR_NODE;
+    node_config.Init = g_hdma_la.Init;
+    node_config.DataHandlingConfig.DataExchange = DMA_EXCHANGE_NONE;
+    node_config.DataHandlingConfig.DataAlignment =
+        DMA_DATA_RIGHTALIGN_ZEROPADDED;
+    node_config.TriggerConfig.TriggerPolarity = DMA_TRIG_POLARITY_MASKED;
+    node_config.SrcAddress = (uint32_t)&GPIOE->IDR;
+
+    if (HAL_DMAEx_List_ResetQ(&g_dma_la_queue) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    for (uint32_t i = 0; i < instance->nodes; ++i) {
+        uint32_t const first = node_start(i);
+
+        node_config.DstAddress = (uint32_t)&instance->config.buffer[first];
+        node_config.DataSize = node_start(i + 1) - first;
+        if (HAL_DMAEx_List_BuildNode(&node_config, &g_dma_la_nodes[i]) !=
+                HAL_OK ||
+            HAL_DMAEx_List_InsertNode_Tail(
+                &g_dma_la_queue, &g_dma_la_nodes[i]
+            ) != HAL_OK) {
+            THROW(ERROR_HARDWARE_FAULT);
+        }
+    }
+    if (instance->config.block_callback &&
+        HAL_DMAEx_List_SetCircularMode(&g_dma_la_queue) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    if (HAL_DMAEx_List_LinkQ(&g_hdma_la, &g_dma_la_queue) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
+static void init_dma(void)
+{
+    DMA_HandleTypeDef *const hdma = &g_hdma_la;
+
+    // 16-byte memory bursts need the 32-byte FIFO
+    DMA_CHANNEL_claim(
+        hdma,
+        DMA_CHANNEL_CAP_LINKED_LIST | DMA_CHANNEL_CAP_FIFO_32,
+        IRQ_PRIORITY_ACQUISITION
+    );
+    hdma->Init.Request = g_update_requests[g_la_instance.config.timer];
+    hdma->Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
+    hdma->Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma->Init.SrcInc = DMA_SINC_FIXED;
+    hdma->Init.DestInc = DMA_DINC_INCREMENTED;
+    hdma->Init.SrcDataWidth = DMA_SRC_DATAWIDTH_BYTE;
+    hdma->Init.DestDataWidth = DMA_DEST_DATAWIDTH_BYTE;
+    hdma->Init.Priority = DMA_HIGH_PRIORITY;
+    // One byte per timer request; the FIFO collects them into bursts
+    hdma->Init.SrcBurstLength = 1;
+    hdma->Init.DestBurstLength = LA_DMA_BURST;
+    hdma->Init.TransferAllocatedPort =
+        DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT1;
+    // Every block raises an event, to track the position across blocks
+    hdma->Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    hdma->Init.Mode = DMA_NORMAL;
+
+    hdma->InitLinkedList.Priority = hdma->Init.Priority;
+    hdma->InitLinkedList.LinkStepMode = DMA_LSM_FULL_EXECUTION;
+    hdma->InitLinkedList.LinkAllocatedPort = DMA_LINK_ALLOCATED_PORT0;
+    hdma->InitLinkedList.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    hdma->InitLinkedList.LinkedListMode = g_la_instance.config.block_callback
+                                              ? DMA_LINKEDLIST_CIRCULAR
+                                              : DMA_LINKEDLIST_NORMAL;
+
+    if (HAL_DMAEx_List_Init(hdma) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    hdma->XferCpltCallback = la_dma_complete;
+    hdma->XferErrorCallback = la_dma_error;
+}
+
+void LA_LL_init(LA_LL_Config const *config)
+{
+    if (!config || !config->buffer || config->samples == 0 ||
+        config->samples > LA_LL_SAMPLES_MAX ||
+        config->timer >= TIM_NUM_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (config->block_callback &&
+        (config->samples % 2 != 0 || config->samples > LA_LL_RING_MAX)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_la_instance.initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    g_la_instance.config = *config;
+    configure_inputs();
+    init_dma();
+    g_la_instance.initialized = true;
+}
+
+void LA_LL_deinit(void)
+{
+    if (!g_la_instance.initialized) {
+        return;
+    }
+
+    LA_LL_stop();
+    (void)HAL_DMAEx_List_UnLinkQ(&g_hdma_la);
+    (void)HAL_DMAEx_List_DeInit(&g_hdma_la);
+    DMA_CHANNEL_release(&g_hdma_la);
+    g_la_instance.initialized = false;
+}
+
+void LA_LL_start(void)
+{
+    LAInstance *const instance = &g_la_instance;
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (g_hdma_la.LinkedListQueue != nullptr &&
+        HAL_DMAEx_List_UnLinkQ(&g_hdma_la) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    build_dma_queue();
+    instance->nodes_done = 0;
+    instance->running = true;
+
+    if (HAL_DMAEx_List_Start_IT(&g_hdma_la) != HAL_OK) {
+        instance->running = false;
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    // Requests wait for the timer to be started
+    TIM_LL_set_update_dma(instance->config.timer, true);
+}
+
+void LA_LL_stop(void)
+{
+    LAInstance *const instance = &g_la_instance;
+
+    if (!instance->initialized) {
+        return;
+    }
+
+    TIM_LL_set_update_dma(instance->config.timer, false);
+    if (instance->running) {
+        instance->running = false;
+        (void)HAL_DMA_Abort(&g_hdma_la);
+    }
+}
+
+uint32_t LA_LL_get_position(void)
+{
+    LAInstance const *const instance = &g_la_instance;
+
+    if (instance->nodes == 0) {
+        return 0;
+    }
+    uint32_t const node = instance->config.block_callback
+                              ? instance->nodes_done % instance->nodes
+                              : instance->nodes_done;
+    if (node >= instance->nodes) {
+        return instance->config.samples;
+    }
+    uint32_t const size = node_start(node + 1) - node_start(node);
+    return node_start(node) + size - __HAL_DMA_GET_COUNTER(&g_hdma_la);
+}
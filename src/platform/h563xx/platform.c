@@ -16,7 +16,8 @@
  * - AHB Clock: 250 MHz (no division)
  * - APB1/2/3 Clocks: 250 MHz (no division)
  * - ADC Clock: 75 MHz (from PLL2R)
- * - Flash Latency: 5 wait states for 250 MHz operation
+ * - USART Clocks: 150 MHz (from PLL2Q)
+ * - Flash Latency: 5 wait states for 250 MHz operation, hidden by the ICACHE
  *
  * @author PSLab Team
  * @date 2025
@@ -25,7 +26,9 @@
 
 #include "util/error.h"
 #include "util/logging.h"
+#include "util/si_prefix.h"
 
+#include "irq_priority.h"
 #include "platform.h"
 
 enum { SYSTEM_CLOCK_FREQ = 250000000U }; // 250 MHz
@@ -41,6 +44,35 @@ typedef enum {
     APB3_CLK,
 } CLKType;
 
+// Current PLL2R divider of the ADC kernel clock
+static uint32_t g_adc_clock_divider = PLATFORM_ADC_CLOCK_DIVIDER_DEFAULT;
+
+/**
+ * @brief PLL2 settings for an ADC kernel clock divider
+ *
+ * The VCO and the Q output for the USARTs are the same for every divider.
+ *
+ * @param adc_divider PLL2R divider
+ * @return PLL2 settings
+ */
+static RCC_PLL2InitTypeDef pll2_config(uint32_t adc_divider)
+{
+    return (RCC_PLL2InitTypeDef){
+        .PLL2Source = RCC_PLL2_SOURCE_HSE,
+        .PLL2M = 2, // 8 MHz / 2 = 4 MHz
+        // NOLINTNEXTLINE: readability-magic-numbers
+        .PLL2N = 75, // 4 MHz * 75 = 300 MHz VCO
+        .PLL2P = 2, // 300 MHz / 2 = 150 MHz
+        .PLL2Q = 2, // 300 MHz / 2 = 150 MHz (for USARTs)
+        .PLL2R = adc_divider, // 300 MHz / 4 = 75 MHz (for ADC) by default
+        .PLL2RGE = RCC_PLL2_VCIRANGE_1, // 2-4 MHz input range
+        .PLL2VCOSEL = RCC_PLL2_VCORANGE_MEDIUM, // 150-420 MHz VCO
+        .PLL2FRACN = 0,
+        // Enable PLL2R output for ADC and PLL2Q output for USARTs
+        .PLL2ClockOut = RCC_PLL2_DIVR | RCC_PLL2_DIVQ,
+    };
+}
+
 /**
  * @brief Configure the system clock to 250 MHz and ADC clock to 75 MHz
  *
@@ -58,6 +90,7 @@ typedef enum {
  * 5. PLL2 Input: 8 MHz ÷ 2 = 4 MHz
  * 6. PLL2 VCO: 4 MHz × 75 = 300 MHz
  * 7. ADC Clock: 300 MHz ÷ 4 = 75 MHz (from PLL2R)
+ *    USART Clocks: 300 MHz ÷ 2 = 150 MHz (from PLL2Q)
  * 8. HSI48: 48 MHz (for USB peripheral)
  *
  * Bus Clocks:
@@ -68,6 +101,7 @@ typedef enum {
  *
  * Dedicated Peripheral Clocks:
  * - ADC1/ADC2: 75 MHz (from PLL2R)
+ * - USART1/USART2/USART3: 150 MHz (from PLL2Q)
  *
  * Power and Performance:
  * - Voltage scaling: Scale 0 (highest performance)
@@ -137,25 +171,19 @@ static void system_clock_config(void)
 
     /* Configure peripheral clocks - Set ADC clock source to PLL2R (75 MHz) */
     RCC_PeriphCLKInitTypeDef periph_clk_init = { 0 };
-    periph_clk_init.PeriphClockSelection = RCC_PERIPHCLK_ADCDAC;
+    periph_clk_init.PeriphClockSelection =
+        RCC_PERIPHCLK_ADCDAC | RCC_PERIPHCLK_USART1 | RCC_PERIPHCLK_USART2 |
+        RCC_PERIPHCLK_USART3;
     periph_clk_init.AdcDacClockSelection = RCC_ADCDACCLKSOURCE_PLL2R;
+    // Baud rates must not follow the core clock when it is scaled down
+    periph_clk_init.Usart1ClockSelection = RCC_USART1CLKSOURCE_PLL2Q;
+    periph_clk_init.Usart2ClockSelection = RCC_USART2CLKSOURCE_PLL2Q;
+    periph_clk_init.Usart3ClockSelection = RCC_USART3CLKSOURCE_PLL2Q;
 
     // Configure PLL2 structure to match our desired configuration
     // This is required because HAL_RCCEx_PeriphCLKConfig calls
     // RCCEx_PLL2_Config internally
-    periph_clk_init.PLL2.PLL2Source = RCC_PLL2_SOURCE_HSE;
-    periph_clk_init.PLL2.PLL2M = 2; // 8 MHz / 2 = 4 MHz
-    // NOLINTNEXTLINE: readability-magic-numbers
-    periph_clk_init.PLL2.PLL2N = 75; // 4 MHz * 75 = 300 MHz VCO
-    periph_clk_init.PLL2.PLL2P = 2; // 300 MHz / 2 = 150 MHz
-    periph_clk_init.PLL2.PLL2Q = 2; // 300 MHz / 2 = 150 MHz
-    periph_clk_init.PLL2.PLL2R = 4; // 300 MHz / 4 = 75 MHz (for ADC)
-    periph_clk_init.PLL2.PLL2RGE = RCC_PLL2_VCIRANGE_1; // 2-4 MHz input range
-    periph_clk_init.PLL2.PLL2VCOSEL =
-        RCC_PLL2_VCORANGE_MEDIUM; // 150-420 MHz VCO
-    periph_clk_init.PLL2.PLL2FRACN = 0;
-    periph_clk_init.PLL2.PLL2ClockOut =
-        RCC_PLL2_DIVR; // Enable PLL2R output for ADC
+    periph_clk_init.PLL2 = pll2_config(PLATFORM_ADC_CLOCK_DIVIDER_DEFAULT);
 
     if (HAL_RCCEx_PeriphCLKConfig(&periph_clk_init) != HAL_OK) {
         /* ADC clock configuration failed */
@@ -163,6 +191,34 @@ static void system_clock_config(void)
     }
 }
 
+/**
+ * @brief Configure the instruction cache and the flash prefetch buffer
+ *
+ * The ICACHE serves code fetched from flash over the C-AHB bus, so at 250 MHz
+ * most instructions are fetched without the five flash wait states. It is
+ * used in its default 2-way set associative mode, which misses less than the
+ * direct mapped mode on the interleaved interrupt and main loop code. The
+ * prefetch buffer reads the next flash line ahead for the remaining misses.
+ *
+ * Code on the data paths of the interrupts runs from RAM instead, see
+ * ramfunc.h. DCACHE1 only caches the external memory interfaces (FMC and
+ * OCTOSPI), which this board does not use; it is left disabled, and its HAL
+ * module with it.
+ *
+ * A bootloader may have left the ICACHE running, and the associativity can
+ * only be changed while it is disabled.
+ */
+static void cache_config(void)
+{
+    __HAL_FLASH_PREFETCH_BUFFER_ENABLE();
+
+    if (HAL_ICACHE_Disable() != HAL_OK ||
+        HAL_ICACHE_ConfigAssociativityMode(ICACHE_2WAYS) != HAL_OK ||
+        HAL_ICACHE_Enable() != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
 /**
  * @brief Initialize the platform hardware
  *
@@ -181,6 +237,10 @@ static void system_clock_config(void)
  *    - Configure all peripheral clocks
  *    - Enable HSI48 for USB operations
  *
+ * 3. cache_config(): Enable the instruction cache and flash prefetch
+ *
+ * 4. Start the DWT cycle counter for PLATFORM_get_cycles
+ *
  * After this function completes successfully, the system will be running at
  * 250 MHz with all essential hardware initialized and ready for application
  * use.
@@ -197,6 +257,11 @@ void PLATFORM_init(void)
     }
 
     system_clock_config();
+    cache_config();
+
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 
     LOG_INFO("Platform hardware initialized");
 }
@@ -233,6 +298,43 @@ void SysTick_Handler(void)
 
 uint32_t PLATFORM_get_tick(void) { return HAL_GetTick(); }
 
+uint64_t PLATFORM_get_time_us64(void)
+{
+    uint32_t const load = SysTick->LOAD + 1;
+    uint32_t ms = 0;
+    uint32_t count = 0;
+    bool wrapped = false;
+
+    do {
+        ms = HAL_GetTick();
+        wrapped = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+        count = SysTick->VAL;
+        if (!wrapped && (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)) {
+            // Wrapped between the reads; sample the reloaded counter
+            wrapped = true;
+            count = SysTick->VAL;
+        }
+    } while (ms != HAL_GetTick());
+
+    // The counter wrapped but the tick interrupt has not run yet
+    if (wrapped) {
+        ms++;
+    }
+
+    // SysTick counts down from LOAD once per millisecond
+    return ((uint64_t)ms * SI_KILO_INT) +
+           (((load - 1 - count) * SI_KILO_INT) / load);
+}
+
+uint32_t PLATFORM_get_time_us(void)
+{
+    return (uint32_t)PLATFORM_get_time_us64();
+}
+
+uint32_t PLATFORM_get_cycles(void) { return DWT->CYCCNT; }
+
+uint32_t PLATFORM_get_cycle_frequency(void) { return HAL_RCC_GetHCLKFreq(); }
+
 /**
  * @brief Get the clock speed for a specific clock type
  *
@@ -280,13 +382,148 @@ uint32_t PLATFORM_get_peripheral_clock_speed(PLATFORM_PeripheralClock clock)
         return get_clock_speed(APB1_CLK);
     }
     if (clock == PLATFORM_CLOCK_TIMER1 || clock == PLATFORM_CLOCK_TIMER8 ||
-        clock == PLATFORM_CLOCK_TIMER16 || clock == PLATFORM_CLOCK_TIMER17) {
+        clock == PLATFORM_CLOCK_TIMER15 || clock == PLATFORM_CLOCK_TIMER16 ||
+        clock == PLATFORM_CLOCK_TIMER17) {
         return get_clock_speed(APB2_CLK);
     }
 
     return 0; // Unknown clock
 }
 
+void PLATFORM_set_adc_clock_divider(uint32_t divider)
+{
+    if (divider < PLATFORM_ADC_CLOCK_DIVIDER_MIN ||
+        divider > PLATFORM_ADC_CLOCK_DIVIDER_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (divider == g_adc_clock_divider) {
+        return;
+    }
+
+    // RCCEx_PLL2_Config stops PLL2, sets the new divider and relocks it
+    RCC_PeriphCLKInitTypeDef periph_clk_init = {
+        .PeriphClockSelection = RCC_PERIPHCLK_ADCDAC,
+        .AdcDacClockSelection = RCC_ADCDACCLKSOURCE_PLL2R,
+        .PLL2 = pll2_config(divider),
+    };
+    if (HAL_RCCEx_PeriphCLKConfig(&periph_clk_init) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    g_adc_clock_divider = divider;
+}
+
+uint32_t PLATFORM_get_adc_clock_divider(void) { return g_adc_clock_divider; }
+
+// Current core and bus clock speed
+static PLATFORM_ClockSpeed g_clock_speed = PLATFORM_CLOCK_SPEED_FULL;
+
+void PLATFORM_set_clock_speed(PLATFORM_ClockSpeed speed)
+{
+    RCC_ClkInitTypeDef clk_init = { 0 };
+    uint32_t latency = 0;
+
+    switch (speed) {
+    case PLATFORM_CLOCK_SPEED_FULL:
+        clk_init.AHBCLKDivider = RCC_SYSCLK_DIV1; // 250 MHz
+        latency = FLASH_LATENCY_5;
+        break;
+    case PLATFORM_CLOCK_SPEED_LOW:
+        clk_init.AHBCLKDivider = RCC_SYSCLK_DIV8; // 31.25 MHz
+        latency = FLASH_LATENCY_0; // Up to 42 MHz in voltage scale 0
+        break;
+    default:
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (speed == g_clock_speed) {
+        return;
+    }
+
+    // The SysTick restarts from zero, so switch right after a tick to keep
+    // PLATFORM_get_time_us from going backwards. Reading clears the flag.
+    (void)SysTick->CTRL;
+    while (!(SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk)) {
+    }
+
+    // The APB prescalers stay at 1, the buses follow HCLK. The latency is
+    // raised before and lowered after the prescaler change.
+    clk_init.ClockType = RCC_CLOCKTYPE_HCLK;
+    if (HAL_RCC_ClockConfig(&clk_init, latency) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    g_clock_speed = speed;
+}
+
+PLATFORM_ClockSpeed PLATFORM_get_clock_speed(void) { return g_clock_speed; }
+
+/*
+ * Interrupts set up by the drivers, for PLATFORM_get_irq_info, in the
+ * order of their places in irq_priority.h, but for the DMA channels
+ */
+static struct {
+    IRQn_Type irq;
+    char const *name;
+} const g_IRQS[] = {
+    { EXTI2_IRQn, "EXTI2" },
+    { ADC1_IRQn, "ADC1" },
+    { USB_DRD_FS_IRQn, "USB_DRD_FS" },
+    { I2C1_EV_IRQn, "I2C1_EV" },
+    { I2C1_ER_IRQn, "I2C1_ER" },
+    { SPI3_IRQn, "SPI3" },
+    { USART1_IRQn, "USART1" },
+    { USART2_IRQn, "USART2" },
+    { USART3_IRQn, "USART3" },
+    // Claimed by the drivers at run time, see dma_channel.h
+    { GPDMA1_Channel0_IRQn, "GPDMA1_Channel0" },
+    { GPDMA1_Channel1_IRQn, "GPDMA1_Channel1" },
+    { GPDMA1_Channel2_IRQn, "GPDMA1_Channel2" },
+    { GPDMA1_Channel3_IRQn, "GPDMA1_Channel3" },
+    { GPDMA1_Channel4_IRQn, "GPDMA1_Channel4" },
+    { GPDMA1_Channel5_IRQn, "GPDMA1_Channel5" },
+    { GPDMA1_Channel6_IRQn, "GPDMA1_Channel6" },
+    { GPDMA1_Channel7_IRQn, "GPDMA1_Channel7" },
+    { GPDMA2_Channel0_IRQn, "GPDMA2_Channel0" },
+    { GPDMA2_Channel1_IRQn, "GPDMA2_Channel1" },
+    { GPDMA2_Channel2_IRQn, "GPDMA2_Channel2" },
+    { GPDMA2_Channel3_IRQn, "GPDMA2_Channel3" },
+    { GPDMA2_Channel4_IRQn, "GPDMA2_Channel4" },
+    { GPDMA2_Channel5_IRQn, "GPDMA2_Channel5" },
+    { GPDMA2_Channel6_IRQn, "GPDMA2_Channel6" },
+    { GPDMA2_Channel7_IRQn, "GPDMA2_Channel7" },
+    { PendSV_IRQn, "PendSV" }, // USB service
+    { SysTick_IRQn, "SysTick" },
+};
+
+size_t PLATFORM_get_irq_info(PLATFORM_IrqInfo *info, size_t max)
+{
+    size_t count = 0;
+
+    for (; count < max && count < sizeof(g_IRQS) / sizeof(g_IRQS[0]);
+         ++count) {
+        IRQn_Type const irq = g_IRQS[count].irq;
+
+        info[count].name = g_IRQS[count].name;
+        info[count].priority = (uint8_t)NVIC_GetPriority(irq);
+        info[count].enabled = irq < 0 || NVIC_GetEnableIRQ(irq) != 0U;
+    }
+    return count;
+}
+
+uint32_t PLATFORM_disable_interrupts(void)
+{
+    uint32_t const state = __get_PRIMASK();
+    __disable_irq();
+    return state;
+}
+
+void PLATFORM_restore_interrupts(uint32_t state) { __set_PRIMASK(state); }
+
+void PLATFORM_wait_for_interrupt(void)
+{
+    __DSB(); // Complete outstanding memory accesses before sleeping
+    __WFI();
+}
+
 /**
  * @brief Reset the platform/system
  *
@@ -0,0 +1,466 @@
+/**
+ * @file spi_ll.c
+ * @brief SPI hardware implementation for STM32H563xx
+ *
+ * This module handles initialization and operation of the SPI peripheral of
+ * the STM32H5 microcontroller as bus controller. It configures the hardware,
+ * drives the chip select around transfers and dispatches SPI interrupts to
+ * the hardware-independent SPI implementation.
+ *
+ * Implementation Details:
+ * - SPI3 on PC10 (SCK), PC11 (MISO) and PC12 (MOSI), with the chip select
+ *   on PA15, driven as a GPIO so that it can frame several transfers
+ * - Full-duplex transfers over DMA, on a TX and an RX channel claimed from
+ *   the GPDMA pool
+ * - Kernel clock from PLL1Q at 250 MHz, which system clock scaling leaves
+ *   alone, divided by 4 to 256 for 62.5 MHz down to 977 kHz
+ * - The pins keep their idle levels between transfers
+ * - NVIC priority set to 3 for SPI interrupts, as for UART
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "stm32h5xx_hal.h"
+
+#include "util/error.h"
+
+#include "dma_channel.h"
+#include "irq_priority.h"
+#include "spi_ll.h"
+
+enum {
+    SPI_PRESCALER_STEPS = 8, // Kernel clock divided by 2 to 256
+    SPI_FILL_BYTE = 0xFF, // Sent when a transfer has no TX data
+};
+
+#define SPI_CS_PORT GPIOA
+#define SPI_CS_PIN GPIO_PIN_15
+
+/* SPI instance configuration */
+typedef struct {
+    SPI_HandleTypeDef *hspi;
+    DMA_HandleTypeDef *hdma_tx;
+    DMA_HandleTypeDef *hdma_rx;
+    bool volatile busy;
+    bool volatile hold_cs; // Keep the chip select low after the transfer
+    SPI_LL_CompleteCallback complete_callback;
+    bool initialized;
+} SPIInstance;
+
+/* HAL SPI handles */
+static SPI_HandleTypeDef g_hspi3 = { nullptr };
+
+/* DMA handles */
+static DMA_HandleTypeDef g_hdma_spi3_tx = { nullptr };
+static DMA_HandleTypeDef g_hdma_spi3_rx = { nullptr };
+
+/* Instance array */
+static SPIInstance g_spi_instances[SPI_BUS_COUNT] = {
+    [SPI_BUS_0] = {
+        .hspi = &g_hspi3,
+        .hdma_tx = &g_hdma_spi3_tx,
+        .hdma_rx = &g_hdma_spi3_rx,
+    },
+};
+
+/**
+ * @brief Get SPI instance from HAL handle
+ */
+static SPI_Bus get_bus_from_handle(SPI_HandleTypeDef *hspi)
+{
+    if (hspi->Instance == SPI3) {
+        return SPI_BUS_0;
+    }
+    return SPI_BUS_COUNT; // Invalid
+}
+
+/**
+ * @brief Drive the chip select, low to select the target
+ */
+static void set_cs(bool selected)
+{
+    HAL_GPIO_WritePin(
+        SPI_CS_PORT, SPI_CS_PIN, selected ? GPIO_PIN_RESET : GPIO_PIN_SET
+    );
+}
+
+/**
+ * @brief Claim and configure a DMA channel for normal byte transfers
+ */
+static void init_dma(
+    DMA_HandleTypeDef *hdma,
+    uint32_t request,
+    bool to_peripheral
+)
+{
+    DMA_CHANNEL_claim(hdma, 0, IRQ_PRIORITY_BUS);
+    hdma->Init.Request = request;
+    hdma->Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
+    hdma->Init.Direction =
+        to_peripheral ? DMA_MEMORY_TO_PERIPH : DMA_PERIPH_TO_MEMORY;
+    hdma->Init.SrcInc = to_peripheral ? DMA_SINC_INCREMENTED : DMA_SINC_FIXED;
+    hdma->Init.DestInc =
+        to_peripheral ? DMA_DINC_FIXED : DMA_DINC_INCREMENTED;
+    hdma->Init.SrcDataWidth = DMA_SRC_DATAWIDTH_BYTE;
+    hdma->Init.DestDataWidth = DMA_DEST_DATAWIDTH_BYTE;
+    // Reception first, an unread RX FIFO stalls the transfer
+    hdma->Init.Priority =
+        to_peripheral ? DMA_LOW_PRIORITY_HIGH_WEIGHT : DMA_HIGH_PRIORITY;
+    hdma->Init.SrcBurstLength = 1;
+    hdma->Init.DestBurstLength = 1;
+    hdma->Init.TransferAllocatedPort =
+        (DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0);
+    hdma->Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    hdma->Init.Mode = DMA_NORMAL;
+    if (HAL_DMA_Init(hdma) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
+/**
+ * @brief MSP initialization for SPI
+ *
+ * This function is called by HAL_SPI_Init() to configure the kernel clock,
+ * GPIO pins, DMA channels, and interrupts for the SPI interface.
+ *
+ * @param hspi SPI handle
+ */
+void HAL_SPI_MspInit(SPI_HandleTypeDef *hspi)
+{
+    GPIO_InitTypeDef gpio_init = { 0 };
+    RCC_PeriphCLKInitTypeDef clk_init = { 0 };
+
+    if (hspi->Instance != SPI3) {
+        return;
+    }
+
+    clk_init.PeriphClockSelection = RCC_PERIPHCLK_SPI3;
+    clk_init.Spi3ClockSelection = RCC_SPI3CLKSOURCE_PLL1Q;
+    if (HAL_RCCEx_PeriphCLKConfig(&clk_init) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    __HAL_RCC_SPI3_CLK_ENABLE();
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_GPIOC_CLK_ENABLE();
+
+    /* SPI3 GPIO Configuration: PC10=SCK, PC11=MISO, PC12=MOSI */
+    gpio_init.Pin = GPIO_PIN_10 | GPIO_PIN_11 | GPIO_PIN_12;
+    gpio_init.Mode = GPIO_MODE_AF_PP;
+    gpio_init.Pull = GPIO_NOPULL;
+    gpio_init.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio_init.Alternate = GPIO_AF6_SPI3;
+    HAL_GPIO_Init(GPIOC, &gpio_init);
+
+    /* Chip select: PA15, high while idle */
+    set_cs(false);
+    gpio_init.Pin = SPI_CS_PIN;
+    gpio_init.Mode = GPIO_MODE_OUTPUT_PP;
+    gpio_init.Pull = GPIO_NOPULL;
+    gpio_init.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio_init.Alternate = 0;
+    HAL_GPIO_Init(SPI_CS_PORT, &gpio_init);
+
+    init_dma(&g_hdma_spi3_tx, GPDMA2_REQUEST_SPI3_TX, true);
+    __HAL_LINKDMA(hspi, hdmatx, g_hdma_spi3_tx);
+    init_dma(&g_hdma_spi3_rx, GPDMA2_REQUEST_SPI3_RX, false);
+    __HAL_LINKDMA(hspi, hdmarx, g_hdma_spi3_rx);
+
+    /* SPI interrupt init, for the end of transfer */
+    HAL_NVIC_SetPriority(SPI3_IRQn, IRQ_PRIORITY_BUS, 0);
+    HAL_NVIC_EnableIRQ(SPI3_IRQn);
+}
+
+/**
+ * @brief MSP deinitialization for SPI
+ *
+ * @param hspi SPI handle
+ */
+void HAL_SPI_MspDeInit(SPI_HandleTypeDef *hspi)
+{
+    if (hspi->Instance != SPI3) {
+        return;
+    }
+
+    HAL_NVIC_DisableIRQ(SPI3_IRQn);
+    HAL_DMA_DeInit(&g_hdma_spi3_tx);
+    DMA_CHANNEL_release(&g_hdma_spi3_tx);
+    HAL_DMA_DeInit(&g_hdma_spi3_rx);
+    DMA_CHANNEL_release(&g_hdma_spi3_rx);
+    HAL_GPIO_DeInit(GPIOC, GPIO_PIN_10 | GPIO_PIN_11 | GPIO_PIN_12);
+    HAL_GPIO_DeInit(SPI_CS_PORT, SPI_CS_PIN);
+    __HAL_RCC_SPI3_CLK_DISABLE();
+}
+
+/**
+ * @brief Program the settings of an instance into the peripheral
+ *
+ * HAL_SPI_Init only runs the MSP initialization the first time, so this
+ * also reconfigures an initialized peripheral.
+ *
+ * @return Clock rate reached, in Hz
+ */
+static uint32_t apply_config(SPIInstance *instance, SPI_LL_Config const *config)
+{
+    uint32_t const kernel = HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_SPI3);
+    uint32_t step = 0;
+
+    // The fastest rate that does not exceed the one wanted
+    for (; step < SPI_PRESCALER_STEPS; step++) {
+        if ((kernel >> (step + 1)) <= config->speed) {
+            break;
+        }
+    }
+    if (step == SPI_PRESCALER_STEPS) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    SPI_InitTypeDef *const init = &instance->hspi->Init;
+    init->Mode = SPI_MODE_MASTER;
+    init->Direction = SPI_DIRECTION_2LINES;
+    init->DataSize = SPI_DATASIZE_8BIT;
+    init->CLKPolarity = config->mode >= SPI_LL_MODE_2 ? SPI_POLARITY_HIGH
+                                                      : SPI_POLARITY_LOW;
+    init->CLKPhase = config->mode == SPI_LL_MODE_1 ||
+                             config->mode == SPI_LL_MODE_3
+                         ? SPI_PHASE_2EDGE
+                         : SPI_PHASE_1EDGE;
+    init->NSS = SPI_NSS_SOFT;
+    init->BaudRatePrescaler = step << SPI_CFG1_MBR_Pos;
+    init->FirstBit = config->lsb_first ? SPI_FIRSTBIT_LSB : SPI_FIRSTBIT_MSB;
+    init->TIMode = SPI_TIMODE_DISABLE;
+    init->CRCCalculation = SPI_CRCCALCULATION_DISABLE;
+    init->CRCPolynomial = 0x7;
+    init->NSSPMode = SPI_NSS_PULSE_DISABLE;
+    init->NSSPolarity = SPI_NSS_POLARITY_LOW;
+    init->FifoThreshold = SPI_FIFO_THRESHOLD_01DATA;
+    init->MasterSSIdleness = SPI_MASTER_SS_IDLENESS_00CYCLE;
+    init->MasterInterDataIdleness = SPI_MASTER_INTERDATA_IDLENESS_00CYCLE;
+    init->MasterReceiverAutoSusp = SPI_MASTER_RX_AUTOSUSP_DISABLE;
+    // Hold SCK at its idle level between transfers
+    init->MasterKeepIOState = SPI_MASTER_KEEP_IO_STATE_ENABLE;
+    init->IOSwap = SPI_IO_SWAP_DISABLE;
+    init->ReadyMasterManagement = SPI_RDY_MASTER_MANAGEMENT_INTERNALLY;
+    init->ReadyPolarity = SPI_RDY_POLARITY_HIGH;
+
+    if (HAL_SPI_Init(instance->hspi) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    return kernel >> (step + 1);
+}
+
+void SPI_LL_init(SPI_Bus bus)
+{
+    if (bus >= SPI_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    SPIInstance *instance = &g_spi_instances[bus];
+
+    if (instance->initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    SPI_LL_Config const config = {
+        .speed = SPI_LL_SPEED_DEFAULT,
+        .mode = SPI_LL_MODE_0,
+        .lsb_first = false,
+    };
+
+    instance->hspi->Instance = SPI3;
+    apply_config(instance, &config);
+
+    instance->busy = false;
+    instance->hold_cs = false;
+    instance->initialized = true;
+}
+
+void SPI_LL_deinit(SPI_Bus bus)
+{
+    if (bus >= SPI_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    SPIInstance *instance = &g_spi_instances[bus];
+
+    if (!instance->initialized) {
+        return;
+    }
+
+    /* Stops the peripheral and its DMA without calling back */
+    set_cs(false);
+    if (HAL_SPI_DeInit(instance->hspi) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    instance->busy = false;
+    instance->hold_cs = false;
+    instance->complete_callback = nullptr;
+    instance->initialized = false;
+}
+
+uint32_t SPI_LL_configure(SPI_Bus bus, SPI_LL_Config const *config)
+{
+    if (bus >= SPI_BUS_COUNT || !config || config->mode > SPI_LL_MODE_3 ||
+        config->speed < SPI_LL_SPEED_MIN || config->speed > SPI_LL_SPEED_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    SPIInstance *instance = &g_spi_instances[bus];
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    // A new clock polarity would glitch SCK under a selected target
+    if (instance->busy || instance->hold_cs) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    return apply_config(instance, config);
+}
+
+void SPI_LL_start(SPI_Bus bus, SPI_LL_Transfer const *transfer)
+{
+    if (bus >= SPI_BUS_COUNT || !transfer ||
+        (!transfer->tx && !transfer->rx) || transfer->size == 0 ||
+        transfer->size > SPI_LL_TRANSFER_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    SPIInstance *instance = &g_spi_instances[bus];
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (instance->busy) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    SPI_HandleTypeDef *const hspi = instance->hspi;
+    uint16_t const size = (uint16_t)transfer->size;
+    HAL_StatusTypeDef status;
+
+    instance->busy = true;
+    instance->hold_cs = transfer->hold_cs;
+    set_cs(true);
+    if (!transfer->rx) {
+        status = HAL_SPI_Transmit_DMA(hspi, transfer->tx, size);
+    } else if (!transfer->tx) {
+        // Sent from the buffer in place; each byte goes out before the
+        // one received overwrites it
+        memset(transfer->rx, SPI_FILL_BYTE, size);
+        status =
+            HAL_SPI_TransmitReceive_DMA(hspi, transfer->rx, transfer->rx, size);
+    } else {
+        status =
+            HAL_SPI_TransmitReceive_DMA(hspi, transfer->tx, transfer->rx, size);
+    }
+
+    if (status != HAL_OK) {
+        set_cs(false);
+        instance->busy = false;
+        instance->hold_cs = false;
+        THROW(status == HAL_BUSY ? ERROR_RESOURCE_BUSY : ERROR_HARDWARE_FAULT);
+    }
+}
+
+void SPI_LL_release_cs(SPI_Bus bus)
+{
+    if (bus >= SPI_BUS_COUNT || !g_spi_instances[bus].initialized ||
+        g_spi_instances[bus].busy) {
+        return;
+    }
+
+    g_spi_instances[bus].hold_cs = false;
+    set_cs(false);
+}
+
+bool SPI_LL_busy(SPI_Bus bus)
+{
+    if (bus >= SPI_BUS_COUNT || !g_spi_instances[bus].initialized) {
+        return false;
+    }
+
+    return g_spi_instances[bus].busy;
+}
+
+void SPI_LL_set_complete_callback(
+    SPI_Bus bus,
+    SPI_LL_CompleteCallback callback
+)
+{
+    if (bus >= SPI_BUS_COUNT) {
+        return;
+    }
+    g_spi_instances[bus].complete_callback = callback;
+}
+
+/**
+ * @brief End a transfer and notify the hardware-independent layer
+ *
+ * A failed transfer always releases the chip select, which ends the
+ * target's command.
+ */
+static void complete(SPI_HandleTypeDef *hspi, SPI_LL_Status status)
+{
+    SPI_Bus const bus = get_bus_from_handle(hspi);
+    if (bus >= SPI_BUS_COUNT) {
+        return;
+    }
+
+    SPIInstance *instance = &g_spi_instances[bus];
+    if (!instance->hold_cs || status != SPI_LL_STATUS_OK) {
+        instance->hold_cs = false;
+        set_cs(false);
+    }
+    instance->busy = false;
+
+    if (instance->complete_callback != nullptr) {
+        instance->complete_callback(bus, status);
+    }
+}
+
+/**
+ * @brief SPI transmit complete callback, for transfers without RX data
+ */
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    complete(hspi, SPI_LL_STATUS_OK);
+}
+
+/**
+ * @brief SPI full-duplex complete callback
+ */
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    complete(hspi, SPI_LL_STATUS_OK);
+}
+
+/**
+ * @brief SPI error callback
+ *
+ * Called by HAL once the transfer has been stopped.
+ */
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    uint32_t const error = HAL_SPI_GetError(hspi);
+
+    complete(
+        hspi,
+        (error & HAL_SPI_ERROR_DMA) != 0 ? SPI_LL_STATUS_DMA_ERROR
+                                         : SPI_LL_STATUS_BUS_ERROR
+    );
+}
+
+/**
+ * @brief SPI3 global interrupt handler
+ */
+void SPI3_IRQHandler(void) { HAL_SPI_IRQHandler(&g_hspi3); }
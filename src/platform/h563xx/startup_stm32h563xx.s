@@ -92,6 +92,17 @@ LoopFillZerobss:
   cmp r2, r4
   bcc FillZerobss
 
+/* Paint the stacks, so that their use can be measured */
+  bl stack_paint
+
+/* Run the application on the process stack (PSP), below the interrupt
+   stack, and leave the main stack pointer (MSP) to the exception handlers */
+  ldr r0, =_sirq_stack
+  msr psp, r0
+  movs r0, #2
+  msr control, r0
+  isb
+
 /* Call static constructors */
   bl __libc_init_array
 /* Call the application's entry point.*/
@@ -45,12 +45,14 @@ extern "C" {
 #define HAL_CORTEX_MODULE_ENABLED
 // #define HAL_CRC_MODULE_ENABLED
 // #define HAL_CRYP_MODULE_ENABLED
-// #define HAL_DAC_MODULE_ENABLED
+#define HAL_DAC_MODULE_ENABLED
 // #define HAL_DCACHE_MODULE_ENABLED
 // #define HAL_DCMI_MODULE_ENABLED
 #define HAL_DMA_MODULE_ENABLED
 // #define HAL_DTS_MODULE_ENABLED
 #define HAL_EXTI_MODULE_ENABLED
+// No PHY on the board; the RMII pins PA1, PA2, PA7, PC1, PC4 and PC5 are
+// ADC inputs
 // #define HAL_ETH_MODULE_ENABLED
 // #define HAL_FDCAN_MODULE_ENABLED
 #define HAL_FLASH_MODULE_ENABLED
@@ -59,7 +61,7 @@ extern "C" {
 // #define HAL_GTZC_MODULE_ENABLED
 // #define HAL_HASH_MODULE_ENABLED
 // #define HAL_HCD_MODULE_ENABLED
-// #define HAL_I2C_MODULE_ENABLED
+#define HAL_I2C_MODULE_ENABLED
 // #define HAL_I2S_MODULE_ENABLED
 // #define HAL_I3C_MODULE_ENABLED
 #define HAL_ICACHE_MODULE_ENABLED
@@ -85,7 +87,7 @@ extern "C" {
 // #define HAL_SDRAM_MODULE_ENABLED
 // #define HAL_SMARTCARD_MODULE_ENABLED
 // #define HAL_SMBUS_MODULE_ENABLED
-// #define HAL_SPI_MODULE_ENABLED
+#define HAL_SPI_MODULE_ENABLED
 // #define HAL_SRAM_MODULE_ENABLED
 #define HAL_TIM_MODULE_ENABLED
 #define HAL_UART_MODULE_ENABLED
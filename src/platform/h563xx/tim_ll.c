@@ -16,33 +16,101 @@
 #include "util/error.h"
 #include "util/logging.h"
 
+#include "irq_priority.h"
 #include "platform.h"
 #include "tim_ll.h"
 
-enum { TIMER_DEFAULT_PRESCALER = 0 }; // Default prescaler value
-// 0 prescaler divides the timer clock by 1
+enum {
+    // Prescaler and auto-reload division limit. TIM2 and TIM5 have 32-bit
+    // auto-reload registers, but 16 bits are used uniformly.
+    TIMER_DIVIDER_MAX = 0x10000,
+};
+
+/*
+ * Pins of the synchronized start across boards, on port G, clear of the
+ * other peripherals: a rising edge on the trigger input starts the held
+ * timers, and the trigger output rises as they start. The trigger input
+ * is EXTI line 2.
+ */
+#define SYNC_TRIGGER_GPIO_GROUP GPIOG
+#define SYNC_TRIGGER_IN_PIN GPIO_PIN_2
+#define SYNC_TRIGGER_OUT_PIN GPIO_PIN_3
 
 /*Timer Instance Structure with parameters for any give Instance*/
 typedef struct {
     TIM_HandleTypeDef *htim;
+    TIM_TypeDef *regs;
     uint32_t frequency;
+    uint32_t prescaler;
     uint32_t period;
     bool initialized;
+    bool claimed; // Handed out by TIM_LL_claim
+    uint8_t pwm_outputs; // Bit per channel set up by TIM_LL_pwm_init
 } TimerInstance;
 
+/*Pin of a PWM output*/
+typedef struct {
+    GPIO_TypeDef *port; // nullptr if the channel has no output pin
+    uint16_t pin;
+    uint8_t alternate;
+} PwmPin;
+
 /*TImer Handle initialization*/
+static TIM_HandleTypeDef g_htim1 = { nullptr };
+static TIM_HandleTypeDef g_htim2 = { nullptr };
+static TIM_HandleTypeDef g_htim3 = { nullptr };
+static TIM_HandleTypeDef g_htim4 = { nullptr };
 static TIM_HandleTypeDef g_htim6 = { nullptr };
 static TIM_HandleTypeDef g_htim7 = { nullptr };
+static TIM_HandleTypeDef g_htim8 = { nullptr };
+static TIM_HandleTypeDef g_htim15 = { nullptr };
 
 /*Array of Timer Instances*/
 static TimerInstance g_timer_instances[TIM_NUM_COUNT] = {
-    [TIM_NUM_6] = {
-        .htim = &g_htim6,
-        .initialized = false,
-    },
-    [TIM_NUM_7] = {
-        .htim = &g_htim7,
-        .initialized = false,
+    [TIM_NUM_6] = { .htim = &g_htim6, .regs = TIM6 },
+    [TIM_NUM_7] = { .htim = &g_htim7, .regs = TIM7 },
+    [TIM_NUM_1] = { .htim = &g_htim1, .regs = TIM1 },
+    [TIM_NUM_2] = { .htim = &g_htim2, .regs = TIM2 },
+    [TIM_NUM_3] = { .htim = &g_htim3, .regs = TIM3 },
+    [TIM_NUM_4] = { .htim = &g_htim4, .regs = TIM4 },
+    [TIM_NUM_8] = { .htim = &g_htim8, .regs = TIM8 },
+    [TIM_NUM_15] = { .htim = &g_htim15, .regs = TIM15 },
+};
+
+/*
+ * Order in which TIM_LL_claim hands out timers: the basic timer first, then
+ * the general-purpose timers, keeping the advanced timers for last, and
+ * TIM4, which has the PWM outputs, after them. TIM7 cannot trigger the ADC
+ * and is not handed out.
+ */
+static TIM_Num const g_claim_order[] = {
+    TIM_NUM_6, TIM_NUM_3, TIM_NUM_2, TIM_NUM_15,
+    TIM_NUM_8, TIM_NUM_1, TIM_NUM_4,
+};
+
+/*Starts held since TIM_LL_sync_arm, for TIM_LL_sync_start*/
+static struct {
+    bool volatile armed; // Also read by the trigger input interrupt
+    uint32_t volatile timers; // Bit per held TIM_Num
+    bool trigger_input; // Held timers start on the trigger input
+    bool trigger_output; // Trigger output rises as they start
+} g_sync = {
+    .armed = false,
+    .timers = 0,
+    .trigger_input = false,
+    .trigger_output = false,
+};
+
+/*HAL channels, in TIM_LL_Channel order*/
+static uint32_t const g_hal_channels[TIM_LL_CHANNEL_COUNT] = {
+    TIM_CHANNEL_1, TIM_CHANNEL_2, TIM_CHANNEL_3, TIM_CHANNEL_4,
+};
+
+/*PWM output pins, on port D, clear of the other peripherals*/
+static PwmPin const g_pwm_pins[TIM_NUM_COUNT][TIM_LL_CHANNEL_COUNT] = {
+    [TIM_NUM_4] = {
+        [TIM_LL_CHANNEL_1] = { GPIOD, GPIO_PIN_12, GPIO_AF2_TIM4 },
+        [TIM_LL_CHANNEL_3] = { GPIOD, GPIO_PIN_14, GPIO_AF2_TIM4 },
     },
 };
 
@@ -90,6 +158,9 @@ static uint32_t get_timer_clock_frequency(TIM_Num tim)
     if (instance->htim->Instance == TIM16) {
         clock_type = PLATFORM_CLOCK_TIMER16;
     }
+    if (instance->htim->Instance == TIM15) {
+        clock_type = PLATFORM_CLOCK_TIMER15;
+    }
     if (instance->htim->Instance == TIM17) {
         clock_type = PLATFORM_CLOCK_TIMER17;
     }
@@ -99,15 +170,19 @@ static uint32_t get_timer_clock_frequency(TIM_Num tim)
 }
 
 /**
- * @brief Calculate timer values based on the specified period.
+ * @brief Calculate timer values based on the specified frequency.
  *
- * This function calculates the timer values required to achieve a specific
- * period for the timer. It uses the timer clock frequency to determine the
- * appropriate prescaler and auto-reload values.
+ * The update rate is tim_clock / (psc * arr) for a prescaler division psc
+ * and a reload division arr, each between 1 and TIMER_DIVIDER_MAX. Every
+ * prescaler from the smallest one that fits up to the square root of the
+ * total division is tried with the nearest reload value, which covers all
+ * factorizations, and the pair with the smallest frequency error wins.
+ * The search ends early on an exact match.
  *
  * @param tim The timer count of the timer
+ * @return The achieved frequency in Hz, rounded to nearest
  */
-static void calculate_timer_values(TIM_Num tim)
+static uint32_t calculate_timer_values(TIM_Num tim)
 {
     TimerInstance *instance = &g_timer_instances[tim];
     if (instance->frequency == 0) {
@@ -122,7 +197,107 @@ static void calculate_timer_values(TIM_Num tim)
         THROW(ERROR_INVALID_ARGUMENT);
     }
 
-    instance->period = (tim_clock / instance->frequency) - 1;
+    uint64_t const freq = instance->frequency;
+    uint64_t const divider = (tim_clock + (freq / 2)) / freq;
+
+    if (divider == 0 ||
+        divider > (uint64_t)TIMER_DIVIDER_MAX * TIMER_DIVIDER_MAX) {
+        // Frequency out of range for this timer
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    uint32_t const psc_min =
+        (uint32_t)((divider + TIMER_DIVIDER_MAX - 1) / TIMER_DIVIDER_MAX);
+    uint32_t best_psc = psc_min;
+    uint32_t best_arr = TIMER_DIVIDER_MAX;
+    uint64_t best_error = UINT64_MAX;
+    uint64_t best_total = 1;
+
+    for (uint32_t psc = psc_min; psc <= TIMER_DIVIDER_MAX; ++psc) {
+        uint64_t const step = freq * psc;
+        uint64_t arr = (tim_clock + (step / 2)) / step;
+
+        if (arr == 0) {
+            arr = 1;
+        } else if (arr > TIMER_DIVIDER_MAX) {
+            arr = TIMER_DIVIDER_MAX;
+        }
+
+        // Compare |tim_clock / total - freq| = error / total across pairs
+        uint64_t const total = psc * arr;
+        uint64_t const achieved = freq * total;
+        uint64_t const error =
+            achieved > tim_clock ? achieved - tim_clock : tim_clock - achieved;
+
+        if (best_error == UINT64_MAX ||
+            error * best_total < best_error * total) {
+            best_psc = psc;
+            best_arr = (uint32_t)arr;
+            best_error = error;
+            best_total = total;
+        }
+
+        if (error == 0 || (uint64_t)psc * psc >= divider) {
+            break;
+        }
+    }
+
+    instance->prescaler = best_psc - 1;
+    instance->period = best_arr - 1;
+
+    return (uint32_t)((tim_clock + (best_total / 2)) / best_total);
+}
+
+/**
+ * @brief Check that a channel is the output of a combined pair
+ */
+static void check_pwm_channel(TIM_Num tim, TIM_LL_Channel channel)
+{
+    if (tim >= TIM_NUM_COUNT ||
+        (channel != TIM_LL_CHANNEL_1 && channel != TIM_LL_CHANNEL_3)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+/**
+ * @brief Set the modes of a pair's output and second channels
+ *
+ * Channels 3 and 4 have the layout of channels 1 and 2 in CCMR2.
+ */
+static void set_pwm_modes(
+    TIM_TypeDef *regs,
+    TIM_LL_Channel channel,
+    uint32_t output_mode,
+    uint32_t second_mode
+)
+{
+    uint32_t volatile *const ccmr =
+        channel == TIM_LL_CHANNEL_1 ? &regs->CCMR1 : &regs->CCMR2;
+
+    MODIFY_REG(
+        *ccmr,
+        TIM_CCMR1_OC1M | TIM_CCMR1_OC2M,
+        output_mode | (second_mode << 8U)
+    );
+}
+
+/**
+ * @brief Disable the PWM outputs of a timer and return their pins
+ */
+static void release_pwm_outputs(TIM_Num tim)
+{
+    TimerInstance *instance = &g_timer_instances[tim];
+
+    for (uint32_t channel = 0; channel < TIM_LL_CHANNEL_COUNT; ++channel) {
+        if (instance->pwm_outputs & (1U << channel)) {
+            PwmPin const *const pin = &g_pwm_pins[tim][channel];
+            HAL_GPIO_DeInit(pin->port, pin->pin);
+        }
+    }
+    instance->regs->CCER = 0;
+    instance->regs->CCMR1 = 0;
+    instance->regs->CCMR2 = 0;
+    instance->pwm_outputs = 0;
 }
 
 /**
@@ -137,6 +312,22 @@ static void calculate_timer_values(TIM_Num tim)
  */
 void HAL_TIM_Base_MspInit(TIM_HandleTypeDef *htim)
 {
+    if (htim->Instance == TIM1) {
+        __HAL_RCC_TIM1_CLK_ENABLE();
+    }
+
+    if (htim->Instance == TIM2) {
+        __HAL_RCC_TIM2_CLK_ENABLE();
+    }
+
+    if (htim->Instance == TIM3) {
+        __HAL_RCC_TIM3_CLK_ENABLE();
+    }
+
+    if (htim->Instance == TIM4) {
+        __HAL_RCC_TIM4_CLK_ENABLE();
+    }
+
     if (htim->Instance == TIM6) {
         /* Enable TIM6 clock */
         __HAL_RCC_TIM6_CLK_ENABLE();
@@ -146,6 +337,14 @@ void HAL_TIM_Base_MspInit(TIM_HandleTypeDef *htim)
         /* Enable TIM7 clock */
         __HAL_RCC_TIM7_CLK_ENABLE();
     }
+
+    if (htim->Instance == TIM8) {
+        __HAL_RCC_TIM8_CLK_ENABLE();
+    }
+
+    if (htim->Instance == TIM15) {
+        __HAL_RCC_TIM15_CLK_ENABLE();
+    }
 }
 
 /**
@@ -153,8 +352,9 @@ void HAL_TIM_Base_MspInit(TIM_HandleTypeDef *htim)
  *
  * @param tim Timer instance
  * @param freq Frequency for the timer
+ * @return Achieved frequency in Hz
  */
-void TIM_LL_init(TIM_Num tim, uint32_t freq)
+uint32_t TIM_LL_init(TIM_Num tim, uint32_t freq)
 {
     if (tim >= TIM_NUM_COUNT) {
         THROW(ERROR_INVALID_ARGUMENT);
@@ -167,21 +367,16 @@ void TIM_LL_init(TIM_Num tim, uint32_t freq)
     TimerInstance *instance = &g_timer_instances[tim];
 
     instance->frequency = freq;
+    instance->htim->Instance = instance->regs;
+    instance->htim->Channel = TIM_CHANNEL_1;
 
-    if (tim == TIM_NUM_6) {
-        instance->htim->Instance = TIM6;
-        instance->htim->Channel = TIM_CHANNEL_1;
-    } else if (tim == TIM_NUM_7) {
-        instance->htim->Instance = TIM7;
-        instance->htim->Channel = TIM_CHANNEL_1;
-    }
+    uint32_t const achieved = calculate_timer_values(tim);
 
-    calculate_timer_values(tim);
-
-    instance->htim->Init.Prescaler = TIMER_DEFAULT_PRESCALER;
+    instance->htim->Init.Prescaler = instance->prescaler;
     instance->htim->Init.CounterMode = TIM_COUNTERMODE_UP;
     instance->htim->Init.Period = instance->period;
     instance->htim->Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    instance->htim->Init.RepetitionCounter = 0;
     instance->htim->Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
 
     if (HAL_TIM_Base_Init(instance->htim) != HAL_OK) {
@@ -200,6 +395,49 @@ void TIM_LL_init(TIM_Num tim, uint32_t freq)
     }
 
     instance->initialized = true;
+    return achieved;
+}
+
+/**
+ * @brief Change the frequency of an initialized timer
+ *
+ * @param tim Timer instance
+ * @param freq New frequency for the timer
+ * @return Achieved frequency in Hz
+ */
+uint32_t TIM_LL_set_frequency(TIM_Num tim, uint32_t freq)
+{
+    if (tim >= TIM_NUM_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!g_timer_instances[tim].initialized) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+
+    TimerInstance *instance = &g_timer_instances[tim];
+    uint32_t const previous = instance->frequency;
+    uint32_t achieved = 0;
+
+    instance->frequency = freq;
+
+    Error error = ERROR_NONE;
+    TRY { achieved = calculate_timer_values(tim); }
+    CATCH(error)
+    {
+        instance->frequency = previous;
+        THROW(error);
+    }
+
+    instance->htim->Init.Prescaler = instance->prescaler;
+    instance->htim->Init.Period = instance->period;
+    __HAL_TIM_SET_PRESCALER(instance->htim, instance->prescaler);
+    __HAL_TIM_SET_AUTORELOAD(instance->htim, instance->period);
+
+    // The prescaler is buffered; load it now rather than at the next update
+    instance->regs->EGR = TIM_EGR_UG;
+
+    return achieved;
 }
 
 /**
@@ -219,24 +457,56 @@ void TIM_LL_deinit(TIM_Num tim)
 
     TimerInstance *instance = &g_timer_instances[tim];
 
+    g_sync.timers &= ~(1U << tim);
+    if (instance->pwm_outputs != 0) {
+        release_pwm_outputs(tim);
+    }
     HAL_TIM_Base_DeInit(instance->htim);
 
     instance->frequency = 0;
+    instance->prescaler = 0;
     instance->period = 0;
     instance->initialized = false;
 }
 
 /**
- * @brief Start the Timer Module
+ * @brief Start the Timer Module, returning failures instead of throwing
+ *
+ * While a synchronized start is armed the timer is held for it instead.
  *
  * @param tim TIM instance instance
- * @param freq Frequency for the timer
+ * @return ERROR_NONE, or the error TIM_LL_start would throw
  */
-void TIM_LL_start(TIM_Num tim)
+Error TIM_LL_try_start(TIM_Num tim)
 {
+    if (tim >= TIM_NUM_COUNT) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
     TimerInstance *instance = &g_timer_instances[tim];
+    if (g_sync.armed) {
+        if (!instance->initialized) {
+            return ERROR_RESOURCE_UNAVAILABLE;
+        }
+        g_sync.timers |= 1U << tim;
+        return ERROR_NONE;
+    }
     if (HAL_TIM_Base_Start(instance->htim) != HAL_OK) {
-        THROW(ERROR_HARDWARE_FAULT);
+        return ERROR_HARDWARE_FAULT;
+    }
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Start the Timer Module
+ *
+ * @param tim TIM instance instance
+ */
+void TIM_LL_start(TIM_Num tim)
+{
+    Error const error = TIM_LL_try_start(tim);
+    if (error != ERROR_NONE) {
+        THROW(error);
     }
 }
 
@@ -247,8 +517,443 @@ void TIM_LL_start(TIM_Num tim)
  */
 void TIM_LL_stop(TIM_Num tim)
 {
+    if (tim >= TIM_NUM_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
     TimerInstance *instance = &g_timer_instances[tim];
+    g_sync.timers &= ~(1U << tim);
     if (HAL_TIM_Base_Stop(instance->htim) != HAL_OK) {
         THROW(ERROR_HARDWARE_FAULT);
     }
 }
+
+/**
+ * @brief Hold the starts of the timers for a synchronized start
+ *
+ * Lowers the trigger output, so that the start gives a rising edge.
+ */
+void TIM_LL_sync_arm(void)
+{
+    if (g_sync.trigger_output) {
+        SYNC_TRIGGER_GPIO_GROUP->BSRR = (uint32_t)SYNC_TRIGGER_OUT_PIN << 16U;
+    }
+    g_sync.armed = true;
+}
+
+/**
+ * @brief Number of timers held for the synchronized start
+ */
+static uint32_t count_held(void)
+{
+    return (uint32_t)__builtin_popcount(g_sync.timers);
+}
+
+/**
+ * @brief Start the held timers together, with interrupts masked
+ *
+ * The counters and prescalers are first reset with update events disabled,
+ * so that no trigger output fires, then the counters are enabled back to
+ * back. Their first update events are then apart by no more than the few
+ * bus writes between them. The trigger output rises just before.
+ *
+ * @return Number of timers started
+ */
+static uint32_t start_held(void)
+{
+    uint32_t const timers = g_sync.timers;
+    uint32_t count = 0;
+
+    g_sync.armed = false;
+    g_sync.timers = 0;
+
+    for (size_t tim = 0; tim < TIM_NUM_COUNT; ++tim) {
+        if ((timers & (1U << tim)) != 0) {
+            TimerInstance *instance = &g_timer_instances[tim];
+            TIM_TypeDef *const regs = instance->regs;
+
+            instance->htim->State = HAL_TIM_STATE_BUSY;
+            SET_BIT(regs->CR1, TIM_CR1_UDIS);
+            regs->EGR = TIM_EGR_UG;
+            CLEAR_BIT(regs->CR1, TIM_CR1_UDIS);
+            ++count;
+        }
+    }
+    if (g_sync.trigger_output) {
+        SYNC_TRIGGER_GPIO_GROUP->BSRR = SYNC_TRIGGER_OUT_PIN;
+    }
+    for (size_t tim = 0; tim < TIM_NUM_COUNT; ++tim) {
+        if ((timers & (1U << tim)) != 0) {
+            SET_BIT(g_timer_instances[tim].regs->CR1, TIM_CR1_CEN);
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Start the held timers together
+ *
+ * With the trigger input enabled, only the trigger output rises; the
+ * timers start on the edge at the input, like those of the other boards.
+ *
+ * @return Number of timers started, or held for the trigger input
+ */
+uint32_t TIM_LL_sync_start(void)
+{
+    if (!g_sync.armed) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+
+    uint32_t count = 0;
+    uint32_t const state = PLATFORM_disable_interrupts();
+    if (g_sync.trigger_input) {
+        count = count_held();
+        if (g_sync.trigger_output) {
+            SYNC_TRIGGER_GPIO_GROUP->BSRR = SYNC_TRIGGER_OUT_PIN;
+        }
+    } else {
+        count = start_held();
+    }
+    PLATFORM_restore_interrupts(state);
+
+    return count;
+}
+
+/**
+ * @brief Start the held timers at once, from interrupt context
+ *
+ * Masks interrupts like TIM_LL_sync_start, so that a higher priority one
+ * cannot come between the timers.
+ *
+ * @return Number of timers started, 0 if not armed
+ */
+uint32_t TIM_LL_sync_fire(void)
+{
+    uint32_t count = 0;
+    uint32_t const state = PLATFORM_disable_interrupts();
+    if (g_sync.armed) {
+        count = start_held();
+    }
+    PLATFORM_restore_interrupts(state);
+
+    return count;
+}
+
+uint32_t TIM_LL_sync_held(void) { return count_held(); }
+
+/**
+ * @brief Drop a synchronized start, leaving the held timers stopped
+ */
+void TIM_LL_sync_cancel(void)
+{
+    g_sync.armed = false;
+    g_sync.timers = 0;
+}
+
+/**
+ * @brief Start the held timers on a rising edge at the trigger input
+ *
+ * The input is a GPIO interrupt rather than a timer's slave mode input, as
+ * the basic timers have no slave mode controller.
+ *
+ * @param enable Whether the trigger input starts the held timers
+ */
+void TIM_LL_sync_set_trigger_input(bool enable)
+{
+    if (enable == g_sync.trigger_input) {
+        return;
+    }
+
+    if (enable) {
+        GPIO_InitTypeDef gpio_init = { 0 };
+
+        __HAL_RCC_GPIOG_CLK_ENABLE();
+        gpio_init.Pin = SYNC_TRIGGER_IN_PIN;
+        gpio_init.Mode = GPIO_MODE_IT_RISING;
+        gpio_init.Pull = GPIO_PULLDOWN; // No start from an open input
+        HAL_GPIO_Init(SYNC_TRIGGER_GPIO_GROUP, &gpio_init);
+        __HAL_GPIO_EXTI_CLEAR_RISING_IT(SYNC_TRIGGER_IN_PIN);
+
+        HAL_NVIC_SetPriority(EXTI2_IRQn, IRQ_PRIORITY_SYNC_TRIGGER, 0);
+        HAL_NVIC_EnableIRQ(EXTI2_IRQn);
+    } else {
+        HAL_NVIC_DisableIRQ(EXTI2_IRQn);
+        HAL_GPIO_DeInit(SYNC_TRIGGER_GPIO_GROUP, SYNC_TRIGGER_IN_PIN);
+    }
+    g_sync.trigger_input = enable;
+}
+
+/**
+ * @brief Drive the trigger output, low while armed and rising at start
+ *
+ * @param enable Whether the trigger output is driven
+ */
+void TIM_LL_sync_set_trigger_output(bool enable)
+{
+    if (enable == g_sync.trigger_output) {
+        return;
+    }
+
+    if (enable) {
+        GPIO_InitTypeDef gpio_init = { 0 };
+
+        __HAL_RCC_GPIOG_CLK_ENABLE();
+        HAL_GPIO_WritePin(
+            SYNC_TRIGGER_GPIO_GROUP,
+            SYNC_TRIGGER_OUT_PIN,
+            GPIO_PIN_RESET
+        );
+        gpio_init.Pin = SYNC_TRIGGER_OUT_PIN;
+        gpio_init.Mode = GPIO_MODE_OUTPUT_PP;
+        gpio_init.Pull = GPIO_NOPULL;
+        gpio_init.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+        HAL_GPIO_Init(SYNC_TRIGGER_GPIO_GROUP, &gpio_init);
+    } else {
+        HAL_GPIO_DeInit(SYNC_TRIGGER_GPIO_GROUP, SYNC_TRIGGER_OUT_PIN);
+    }
+    g_sync.trigger_output = enable;
+}
+
+/**
+ * @brief Trigger input interrupt
+ *
+ * Handled here rather than through the HAL, which would add its dispatch
+ * to the latency of the start.
+ */
+void EXTI2_IRQHandler(void)
+{
+    if (__HAL_GPIO_EXTI_GET_RISING_IT(SYNC_TRIGGER_IN_PIN) == 0U) {
+        return;
+    }
+    __HAL_GPIO_EXTI_CLEAR_RISING_IT(SYNC_TRIGGER_IN_PIN);
+
+    if (g_sync.armed && g_sync.trigger_input) {
+        (void)start_held();
+    }
+}
+
+/**
+ * @brief Check if timer starts are held for a synchronized start
+ *
+ * @return true between TIM_LL_sync_arm and TIM_LL_sync_start or
+ *         TIM_LL_sync_cancel
+ */
+bool TIM_LL_sync_is_armed(void) { return g_sync.armed; }
+
+/**
+ * @brief Request a DMA transfer on each update event of the timer
+ *
+ * @param tim Initialized timer
+ * @param enable Whether update events request DMA transfers
+ */
+void TIM_LL_set_update_dma(TIM_Num tim, bool enable)
+{
+    if (tim >= TIM_NUM_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    TimerInstance *instance = &g_timer_instances[tim];
+    if (enable) {
+        __HAL_TIM_ENABLE_DMA(instance->htim, TIM_DMA_UPDATE);
+    } else {
+        __HAL_TIM_DISABLE_DMA(instance->htim, TIM_DMA_UPDATE);
+    }
+}
+
+/**
+ * @brief Counts of the timer per period
+ *
+ * @param tim Timer instance
+ * @return Auto-reload value plus one, 0 if not initialized
+ */
+uint32_t TIM_LL_get_period(TIM_Num tim)
+{
+    if (tim >= TIM_NUM_COUNT || !g_timer_instances[tim].initialized) {
+        return 0;
+    }
+    return g_timer_instances[tim].period + 1;
+}
+
+/**
+ * @brief Set up a PWM output on a pair of channels
+ *
+ * The output channel starts in combined PWM mode 2 and the second in PWM
+ * mode 1, both compared with 0, which keeps the output low.
+ *
+ * @param tim Initialized timer with four channels
+ * @param channel TIM_LL_CHANNEL_1 or TIM_LL_CHANNEL_3
+ */
+void TIM_LL_pwm_init(TIM_Num tim, TIM_LL_Channel channel)
+{
+    check_pwm_channel(tim, channel);
+
+    PwmPin const *const pin = &g_pwm_pins[tim][channel];
+    if (pin->port == nullptr) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    TimerInstance *instance = &g_timer_instances[tim];
+    if (!instance->initialized) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+
+    TIM_OC_InitTypeDef oc_config = { 0 };
+
+    oc_config.OCMode = TIM_OCMODE_COMBINED_PWM2;
+    oc_config.Pulse = 0;
+    oc_config.OCPolarity = TIM_OCPOLARITY_HIGH;
+    oc_config.OCNPolarity = TIM_OCNPOLARITY_HIGH;
+    oc_config.OCFastMode = TIM_OCFAST_DISABLE;
+    oc_config.OCIdleState = TIM_OCIDLESTATE_RESET;
+    oc_config.OCNIdleState = TIM_OCNIDLESTATE_RESET;
+
+    if (HAL_TIM_PWM_ConfigChannel(
+            instance->htim, &oc_config, g_hal_channels[channel]
+        ) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    oc_config.OCMode = TIM_OCMODE_PWM1;
+    if (HAL_TIM_PWM_ConfigChannel(
+            instance->htim, &oc_config, g_hal_channels[channel + 1]
+        ) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    GPIO_InitTypeDef gpio_init = { 0 };
+
+    __HAL_RCC_GPIOD_CLK_ENABLE();
+    gpio_init.Pin = pin->pin;
+    gpio_init.Mode = GPIO_MODE_AF_PP;
+    gpio_init.Pull = GPIO_NOPULL;
+    gpio_init.Speed = GPIO_SPEED_FREQ_HIGH;
+    gpio_init.Alternate = pin->alternate;
+    HAL_GPIO_Init(pin->port, &gpio_init);
+
+    instance->pwm_outputs |= 1U << channel;
+}
+
+/**
+ * @brief Set the pulse of a PWM output
+ *
+ * A pulse within the period is high while start <= CNT < start + width:
+ * the output channel in combined PWM mode 2 (CNT >= CCR) ANDs with the
+ * second in PWM mode 1 (CNT < CCR). A pulse wrapping into the next period
+ * is high while CNT < start + width - period or CNT >= start: combined
+ * PWM mode 1 (CNT < CCR) ORs with PWM mode 2 (CNT >= CCR).
+ *
+ * @param tim Timer instance
+ * @param channel Output set up by TIM_LL_pwm_init
+ * @param start Count the pulse rises at
+ * @param width Counts the pulse lasts
+ */
+void TIM_LL_pwm_set_pulse(
+    TIM_Num tim,
+    TIM_LL_Channel channel,
+    uint32_t start,
+    uint32_t width
+)
+{
+    check_pwm_channel(tim, channel);
+
+    TimerInstance *instance = &g_timer_instances[tim];
+    TIM_TypeDef *const regs = instance->regs;
+    uint32_t const period = instance->period + 1;
+
+    if (!instance->initialized || start >= period) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    uint32_t output_compare = start;
+    uint32_t second_compare = start;
+
+    if (width >= period) {
+        // CNT < start or CNT >= start, always
+        set_pwm_modes(
+            regs, channel, TIM_OCMODE_COMBINED_PWM1, TIM_OCMODE_PWM2
+        );
+    } else if (width <= period - start) {
+        // An end of period, CCR above ARR, keeps mode 1 high
+        second_compare = start + width;
+        set_pwm_modes(
+            regs, channel, TIM_OCMODE_COMBINED_PWM2, TIM_OCMODE_PWM1
+        );
+    } else {
+        output_compare = start + width - period;
+        set_pwm_modes(
+            regs, channel, TIM_OCMODE_COMBINED_PWM1, TIM_OCMODE_PWM2
+        );
+    }
+
+    if (channel == TIM_LL_CHANNEL_1) {
+        regs->CCR1 = output_compare;
+        regs->CCR2 = second_compare;
+    } else {
+        regs->CCR3 = output_compare;
+        regs->CCR4 = second_compare;
+    }
+
+    // The compare values are preloaded; load them now while stopped
+    if ((regs->CR1 & TIM_CR1_CEN) == 0) {
+        regs->EGR = TIM_EGR_UG;
+    }
+}
+
+/**
+ * @brief Drive the pin of a PWM output, or leave it undriven
+ *
+ * Advanced timers also need their main output enabled.
+ *
+ * @param tim Timer instance
+ * @param channel Output set up by TIM_LL_pwm_init
+ * @param enable Whether the pin is driven
+ */
+void TIM_LL_pwm_enable(TIM_Num tim, TIM_LL_Channel channel, bool enable)
+{
+    check_pwm_channel(tim, channel);
+
+    TimerInstance *instance = &g_timer_instances[tim];
+
+    TIM_CCxChannelCmd(
+        instance->regs,
+        g_hal_channels[channel],
+        enable ? TIM_CCx_ENABLE : TIM_CCx_DISABLE
+    );
+    if (enable && IS_TIM_BREAK_INSTANCE(instance->regs)) {
+        __HAL_TIM_MOE_ENABLE(instance->htim);
+    }
+}
+
+/**
+ * @brief Claim a free timer for triggering ADC conversions
+ *
+ * @return The claimed timer
+ */
+TIM_Num TIM_LL_claim(void)
+{
+    for (size_t i = 0; i < sizeof(g_claim_order) / sizeof(g_claim_order[0]);
+         ++i) {
+        TimerInstance *instance = &g_timer_instances[g_claim_order[i]];
+
+        if (!instance->claimed && !instance->initialized) {
+            instance->claimed = true;
+            return g_claim_order[i];
+        }
+    }
+
+    THROW(ERROR_RESOURCE_UNAVAILABLE);
+}
+
+/**
+ * @brief Return a claimed timer to the pool
+ *
+ * @param tim Timer returned by TIM_LL_claim
+ */
+void TIM_LL_release(TIM_Num tim)
+{
+    if (tim >= TIM_NUM_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    g_timer_instances[tim].claimed = false;
+}
@@ -8,15 +8,20 @@
  *
  * Implementation Details:
  * - Supports multiple UART instances (USART1, USART2, USART3)
- * - Configured for 115200 baud, 8N1 format
- * - DMA-based reception with idle line detection
- * - DMA-based transmission for optimal performance
+ * - 115200 baud, 8N1 by default; baudrate, parity and stop bits configurable
+ * - Circular DMA reception with half-buffer, full-buffer and idle events
+ * - Optional hardware receiver timeout
+ * - Optional RTS/CTS flow control on USART2 and USART3
+ * - DMA-based transmission; data that wraps around the end of a ring goes
+ *   out as a two-node DMA linked list, back to back
  * - NVIC priority set to 3 for UART interrupts
  *
  * @author Alexander Bessman
  * @date 2025-06-28
  */
 
+#define LOG_MODULE LOG_MODULE_UART
+
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -25,10 +30,15 @@
 #include "stm32h5xx_hal.h"
 
 #include "util/error.h"
+#include "util/ramfunc.h"
 
+#include "dma_channel.h"
+#include "irq_priority.h"
 #include "uart_ll.h"
 
-enum { UART_IRQ_PRIO = 3 }; // NVIC priority for UART interrupts
+
+// Valid range of the BRR clock divider (RM0481)
+enum { UART_DIV_MIN = 0x10, UART_DIV_MAX = 0xFFFF };
 
 /* UART instance configuration */
 typedef struct {
@@ -42,6 +52,9 @@ typedef struct {
     UART_LL_TxCompleteCallback tx_complete_callback;
     UART_LL_RxCompleteCallback rx_complete_callback;
     UART_LL_IdleCallback idle_callback;
+    UART_LL_IdleCallback rx_timeout_callback;
+    UART_LL_LineConfig line_config;
+    bool loopback; // Half-duplex, the receiver listens to the TX pin
     bool initialized;
 } UARTInstance;
 
@@ -58,6 +71,35 @@ static DMA_HandleTypeDef g_hdma_usart2_rx = { nullptr };
 static DMA_HandleTypeDef g_hdma_usart3_tx = { nullptr };
 static DMA_HandleTypeDef g_hdma_usart3_rx = { nullptr };
 
+/* Circular RX DMA linked lists, one node covering the whole RX buffer */
+static DMA_NodeTypeDef g_rx_dma_nodes[UART_BUS_COUNT] = { 0 };
+static DMA_QListTypeDef g_rx_dma_queues[UART_BUS_COUNT] = { 0 };
+
+/* TX DMA linked lists, one node per span of a wrapped transmission */
+enum { UART_TX_DMA_NODES = 2 };
+static DMA_NodeTypeDef g_tx_dma_nodes[UART_BUS_COUNT][UART_TX_DMA_NODES] = {
+    0
+};
+static DMA_QListTypeDef g_tx_dma_queues[UART_BUS_COUNT] = { 0 };
+// Link from the first TX node to the second, as built
+static uint32_t g_tx_dma_links[UART_BUS_COUNT] = { 0 };
+
+/* RTS/CTS pins of a USART */
+typedef struct {
+    GPIO_TypeDef *port; // nullptr if the USART has no flow control pins
+    uint16_t pins; // CTS and RTS
+    uint8_t alternate;
+} FlowPins;
+
+static FlowPins const g_FLOW_PINS[UART_BUS_COUNT] = {
+    // USART1 has CTS and RTS on PA11 and PA12 only, which carry USB
+    [UART_BUS_0] = { nullptr, 0, 0 },
+    // PD3=CTS, PD4=RTS
+    [UART_BUS_1] = { GPIOD, GPIO_PIN_3 | GPIO_PIN_4, GPIO_AF7_USART2 },
+    // PB13=CTS, PB14=RTS
+    [UART_BUS_2] = { GPIOB, GPIO_PIN_13 | GPIO_PIN_14, GPIO_AF7_USART3 },
+};
+
 /* Instance array */
 static UARTInstance g_uart_instances[UART_BUS_COUNT] = {
     [UART_BUS_0] = {
@@ -80,7 +122,7 @@ static UARTInstance g_uart_instances[UART_BUS_COUNT] = {
 /**
  * @brief Get UART instance from HAL handle
  */
-static UART_Bus get_bus_from_handle(UART_HandleTypeDef *huart)
+RAMFUNC static UART_Bus get_bus_from_handle(UART_HandleTypeDef *huart)
 {
     if (huart->Instance == USART1) {
         return UART_BUS_0;
@@ -94,6 +136,119 @@ static UART_Bus get_bus_from_handle(UART_HandleTypeDef *huart)
     return UART_BUS_COUNT; // Invalid
 }
 
+/**
+ * @brief Initialize an RX DMA channel for circular reception
+ *
+ * GPDMA has no circular mode for plain transfers, so the channel runs a
+ * linked list whose single node links back to itself. The DMA then keeps
+ * writing the RX buffer around without a restart, raising events at the
+ * half and at the end of the buffer. HAL_UART_Receive_DMA reprograms the
+ * node with the RX buffer address and length.
+ *
+ * @param huart UART handle
+ * @param hdma RX DMA handle with Init already populated
+ */
+static void init_rx_dma(UART_HandleTypeDef *huart, DMA_HandleTypeDef *hdma)
+{
+    UART_Bus const bus = get_bus_from_handle(huart);
+    DMA_QListTypeDef *const queue = &g_rx_dma_queues[bus];
+    DMA_NodeTypeDef *const node = &g_rx_dma_nodes[bus];
+
+    hdma->InitLinkedList.Priority = hdma->Init.Priority;
+    hdma->InitLinkedList.LinkStepMode = DMA_LSM_FULL_EXECUTION;
+    hdma->InitLinkedList.LinkAllocatedPort = DMA_LINK_ALLOCATED_PORT0;
+    hdma->InitLinkedList.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    hdma->InitLinkedList.LinkedListMode = DMA_LINKEDLIST_CIRCULAR;
+    if (HAL_DMAEx_List_Init(hdma) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    DMA_NodeConfTypeDef node_config = { 0 };
+    node_config.NodeType = DMA_GPDMA_LINEAR_NODE;
+    node_config.Init = hdma->Init;
+    node_config.DataHandlingConfig.DataExchange = DMA_EXCHANGE_NONE;
+    node_config.DataHandlingConfig.DataAlignment =
+        DMA_DATA_RIGHTALIGN_ZEROPADDED;
+    node_config.TriggerConfig.TriggerPolarity = DMA_TRIG_POLARITY_MASKED;
+    node_config.SrcAddress = (uint32_t)&huart->Instance->RDR;
+    node_config.DstAddress = (uint32_t)g_uart_instances[bus].rx_buffer_data;
+    node_config.DataSize = g_uart_instances[bus].rx_buffer_size;
+
+    // The queue is still built if the UART was initialized before
+    if (hdma->LinkedListQueue != nullptr &&
+        HAL_DMAEx_List_UnLinkQ(hdma) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    if (HAL_DMAEx_List_ResetQ(queue) != HAL_OK ||
+        HAL_DMAEx_List_BuildNode(&node_config, node) != HAL_OK ||
+        HAL_DMAEx_List_InsertNode_Tail(queue, node) != HAL_OK ||
+        HAL_DMAEx_List_SetCircularMode(queue) != HAL_OK ||
+        HAL_DMAEx_List_LinkQ(hdma, queue) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    __HAL_LINKDMA(huart, hdmarx, *hdma);
+}
+
+/**
+ * @brief Initialize a TX DMA channel for one- or two-span transmissions
+ *
+ * The channel runs a linked list of two nodes, which raises its transfer
+ * complete event only after the last one. HAL_UART_Transmit_DMA programs
+ * the first node with the first span; UART_LL_start_dma_tx_wrapped links
+ * in the second node for the rest, and UART_LL_start_dma_tx ends the list
+ * at the first.
+ *
+ * @param huart UART handle
+ * @param hdma TX DMA handle with Init already populated
+ */
+static void init_tx_dma(UART_HandleTypeDef *huart, DMA_HandleTypeDef *hdma)
+{
+    UART_Bus const bus = get_bus_from_handle(huart);
+    DMA_QListTypeDef *const queue = &g_tx_dma_queues[bus];
+    DMA_NodeTypeDef *const nodes = g_tx_dma_nodes[bus];
+
+    hdma->InitLinkedList.Priority = hdma->Init.Priority;
+    hdma->InitLinkedList.LinkStepMode = DMA_LSM_FULL_EXECUTION;
+    hdma->InitLinkedList.LinkAllocatedPort = DMA_LINK_ALLOCATED_PORT0;
+    hdma->InitLinkedList.TransferEventMode = DMA_TCEM_LAST_LL_ITEM_TRANSFER;
+    hdma->InitLinkedList.LinkedListMode = DMA_LINKEDLIST_NORMAL;
+    if (HAL_DMAEx_List_Init(hdma) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    DMA_NodeConfTypeDef node_config = { 0 };
+    node_config.NodeType = DMA_GPDMA_LINEAR_NODE;
+    node_config.Init = hdma->Init;
+    node_config.Init.TransferEventMode = DMA_TCEM_LAST_LL_ITEM_TRANSFER;
+    node_config.DataHandlingConfig.DataExchange = DMA_EXCHANGE_NONE;
+    node_config.DataHandlingConfig.DataAlignment =
+        DMA_DATA_RIGHTALIGN_ZEROPADDED;
+    node_config.TriggerConfig.TriggerPolarity = DMA_TRIG_POLARITY_MASKED;
+    node_config.DstAddress = (uint32_t)&huart->Instance->TDR;
+    node_config.DataSize = 1; // Set for each transmission
+
+    // The queue is still built if the UART was initialized before
+    if (hdma->LinkedListQueue != nullptr &&
+        HAL_DMAEx_List_UnLinkQ(hdma) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    if (HAL_DMAEx_List_ResetQ(queue) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    for (uint32_t i = 0; i < UART_TX_DMA_NODES; ++i) {
+        if (HAL_DMAEx_List_BuildNode(&node_config, &nodes[i]) != HAL_OK ||
+            HAL_DMAEx_List_InsertNode_Tail(queue, &nodes[i]) != HAL_OK) {
+            THROW(ERROR_HARDWARE_FAULT);
+        }
+    }
+    if (HAL_DMAEx_List_LinkQ(hdma, queue) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    g_tx_dma_links[bus] =
+        nodes[0].LinkRegisters[NODE_CLLR_LINEAR_DEFAULT_OFFSET];
+    __HAL_LINKDMA(huart, hdmatx, *hdma);
+}
+
 /**
  * @brief MSP initialization for UART
  *
@@ -110,7 +265,6 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart)
         /* USART1 clock enable */
         __HAL_RCC_USART1_CLK_ENABLE();
         __HAL_RCC_GPIOA_CLK_ENABLE();
-        __HAL_RCC_GPDMA1_CLK_ENABLE();
 
         /* USART1 GPIO Configuration: PA9=TX, PA10=RX */
         gpio_init.Pin = GPIO_PIN_9 | GPIO_PIN_10;
@@ -121,7 +275,11 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart)
         HAL_GPIO_Init(GPIOA, &gpio_init);
 
         /* Configure DMA for TX */
-        g_hdma_usart1_tx.Instance = GPDMA1_Channel0;
+        DMA_CHANNEL_claim(
+            &g_hdma_usart1_tx,
+            DMA_CHANNEL_CAP_LINKED_LIST,
+            IRQ_PRIORITY_UART
+        );
         g_hdma_usart1_tx.Init.Request = GPDMA1_REQUEST_USART1_TX;
         g_hdma_usart1_tx.Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
         g_hdma_usart1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
@@ -136,11 +294,14 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart)
             (DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0);
         g_hdma_usart1_tx.Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
         g_hdma_usart1_tx.Init.Mode = DMA_NORMAL;
-        HAL_DMA_Init(&g_hdma_usart1_tx);
-        __HAL_LINKDMA(huart, hdmatx, g_hdma_usart1_tx);
+        init_tx_dma(huart, &g_hdma_usart1_tx);
 
         /* Configure DMA for RX */
-        g_hdma_usart1_rx.Instance = GPDMA1_Channel1;
+        DMA_CHANNEL_claim(
+            &g_hdma_usart1_rx,
+            DMA_CHANNEL_CAP_LINKED_LIST,
+            IRQ_PRIORITY_UART
+        );
         g_hdma_usart1_rx.Init.Request = GPDMA1_REQUEST_USART1_RX;
         g_hdma_usart1_rx.Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
         g_hdma_usart1_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
@@ -155,23 +316,15 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart)
             (DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0);
         g_hdma_usart1_rx.Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
         g_hdma_usart1_rx.Init.Mode = DMA_NORMAL;
-        HAL_DMA_Init(&g_hdma_usart1_rx);
-        __HAL_LINKDMA(huart, hdmarx, g_hdma_usart1_rx);
+        init_rx_dma(huart, &g_hdma_usart1_rx);
 
         /* UART interrupt init */
-        HAL_NVIC_SetPriority(USART1_IRQn, UART_IRQ_PRIO, 0);
+        HAL_NVIC_SetPriority(USART1_IRQn, IRQ_PRIORITY_UART, 0);
         HAL_NVIC_EnableIRQ(USART1_IRQn);
-
-        /* DMA interrupt init */
-        HAL_NVIC_SetPriority(GPDMA1_Channel0_IRQn, UART_IRQ_PRIO, 1);
-        HAL_NVIC_EnableIRQ(GPDMA1_Channel0_IRQn);
-        HAL_NVIC_SetPriority(GPDMA1_Channel1_IRQn, UART_IRQ_PRIO, 1);
-        HAL_NVIC_EnableIRQ(GPDMA1_Channel1_IRQn);
     } else if (huart->Instance == USART2) {
         /* USART2 clock enable */
         __HAL_RCC_USART2_CLK_ENABLE();
         __HAL_RCC_GPIOA_CLK_ENABLE();
-        __HAL_RCC_GPDMA1_CLK_ENABLE();
 
         /* USART2 GPIO Configuration: PA2=TX, PA3=RX */
         gpio_init.Pin = GPIO_PIN_2 | GPIO_PIN_3;
@@ -182,7 +335,11 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart)
         HAL_GPIO_Init(GPIOA, &gpio_init);
 
         /* Configure DMA for TX */
-        g_hdma_usart2_tx.Instance = GPDMA1_Channel2;
+        DMA_CHANNEL_claim(
+            &g_hdma_usart2_tx,
+            DMA_CHANNEL_CAP_LINKED_LIST,
+            IRQ_PRIORITY_UART
+        );
         g_hdma_usart2_tx.Init.Request = GPDMA1_REQUEST_USART2_TX;
         g_hdma_usart2_tx.Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
         g_hdma_usart2_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
@@ -197,11 +354,14 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart)
             (DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0);
         g_hdma_usart2_tx.Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
         g_hdma_usart2_tx.Init.Mode = DMA_NORMAL;
-        HAL_DMA_Init(&g_hdma_usart2_tx);
-        __HAL_LINKDMA(huart, hdmatx, g_hdma_usart2_tx);
+        init_tx_dma(huart, &g_hdma_usart2_tx);
 
         /* Configure DMA for RX */
-        g_hdma_usart2_rx.Instance = GPDMA1_Channel3;
+        DMA_CHANNEL_claim(
+            &g_hdma_usart2_rx,
+            DMA_CHANNEL_CAP_LINKED_LIST,
+            IRQ_PRIORITY_UART
+        );
         g_hdma_usart2_rx.Init.Request = GPDMA1_REQUEST_USART2_RX;
         g_hdma_usart2_rx.Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
         g_hdma_usart2_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
@@ -216,23 +376,15 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart)
             (DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0);
         g_hdma_usart2_rx.Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
         g_hdma_usart2_rx.Init.Mode = DMA_NORMAL;
-        HAL_DMA_Init(&g_hdma_usart2_rx);
-        __HAL_LINKDMA(huart, hdmarx, g_hdma_usart2_rx);
+        init_rx_dma(huart, &g_hdma_usart2_rx);
 
         /* UART interrupt init */
-        HAL_NVIC_SetPriority(USART2_IRQn, UART_IRQ_PRIO, 0);
+        HAL_NVIC_SetPriority(USART2_IRQn, IRQ_PRIORITY_UART, 0);
         HAL_NVIC_EnableIRQ(USART2_IRQn);
-
-        /* DMA interrupt init */
-        HAL_NVIC_SetPriority(GPDMA1_Channel2_IRQn, UART_IRQ_PRIO, 1);
-        HAL_NVIC_EnableIRQ(GPDMA1_Channel2_IRQn);
-        HAL_NVIC_SetPriority(GPDMA1_Channel3_IRQn, UART_IRQ_PRIO, 1);
-        HAL_NVIC_EnableIRQ(GPDMA1_Channel3_IRQn);
     } else if (huart->Instance == USART3) {
         /* USART3 clock enable */
         __HAL_RCC_USART3_CLK_ENABLE();
         __HAL_RCC_GPIOD_CLK_ENABLE();
-        __HAL_RCC_GPDMA1_CLK_ENABLE();
 
         /* UART GPIO Configuration */
         gpio_init.Pin = GPIO_PIN_8 | GPIO_PIN_9;
@@ -243,7 +395,11 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart)
         HAL_GPIO_Init(GPIOD, &gpio_init);
 
         /* Configure DMA for TX */
-        g_hdma_usart3_tx.Instance = GPDMA1_Channel4;
+        DMA_CHANNEL_claim(
+            &g_hdma_usart3_tx,
+            DMA_CHANNEL_CAP_LINKED_LIST,
+            IRQ_PRIORITY_UART
+        );
         g_hdma_usart3_tx.Init.Request = GPDMA1_REQUEST_USART3_TX;
         g_hdma_usart3_tx.Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
         g_hdma_usart3_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
@@ -258,11 +414,14 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart)
             (DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0);
         g_hdma_usart3_tx.Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
         g_hdma_usart3_tx.Init.Mode = DMA_NORMAL;
-        HAL_DMA_Init(&g_hdma_usart3_tx);
-        __HAL_LINKDMA(huart, hdmatx, g_hdma_usart3_tx);
+        init_tx_dma(huart, &g_hdma_usart3_tx);
 
         /* Configure DMA for RX */
-        g_hdma_usart3_rx.Instance = GPDMA1_Channel5;
+        DMA_CHANNEL_claim(
+            &g_hdma_usart3_rx,
+            DMA_CHANNEL_CAP_LINKED_LIST,
+            IRQ_PRIORITY_UART
+        );
         g_hdma_usart3_rx.Init.Request = GPDMA1_REQUEST_USART3_RX;
         g_hdma_usart3_rx.Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
         g_hdma_usart3_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
@@ -277,19 +436,133 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart)
             (DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0);
         g_hdma_usart3_rx.Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
         g_hdma_usart3_rx.Init.Mode = DMA_NORMAL;
-        HAL_DMA_Init(&g_hdma_usart3_rx);
-        __HAL_LINKDMA(huart, hdmarx, g_hdma_usart3_rx);
+        init_rx_dma(huart, &g_hdma_usart3_rx);
 
         /* UART interrupt init */
-        HAL_NVIC_SetPriority(USART3_IRQn, UART_IRQ_PRIO, 0);
+        HAL_NVIC_SetPriority(USART3_IRQn, IRQ_PRIORITY_UART, 0);
         HAL_NVIC_EnableIRQ(USART3_IRQn);
+    }
+}
 
-        /* DMA interrupt init */
-        HAL_NVIC_SetPriority(GPDMA1_Channel4_IRQn, UART_IRQ_PRIO, 1);
-        HAL_NVIC_EnableIRQ(GPDMA1_Channel4_IRQn);
-        HAL_NVIC_SetPriority(GPDMA1_Channel5_IRQn, UART_IRQ_PRIO, 1);
-        HAL_NVIC_EnableIRQ(GPDMA1_Channel5_IRQn);
+/**
+ * @brief Get the kernel clock frequency of a UART
+ */
+static uint32_t kernel_clock(UART_Bus bus)
+{
+    static uint64_t const periph_clocks[UART_BUS_COUNT] = {
+        [UART_BUS_0] = RCC_PERIPHCLK_USART1,
+        [UART_BUS_1] = RCC_PERIPHCLK_USART2,
+        [UART_BUS_2] = RCC_PERIPHCLK_USART3,
+    };
+
+    return HAL_RCCEx_GetPeriphCLKFreq(periph_clocks[bus]);
+}
+
+/**
+ * @brief Check that the baudrate can be generated from the UART clock
+ */
+static bool baudrate_valid(UART_Bus bus, UART_LL_LineConfig const *config)
+{
+    if (config->baudrate == 0) {
+        return false;
     }
+
+    // With 8x oversampling, BRR holds twice the clock divider
+    uint64_t const clock =
+        (uint64_t)kernel_clock(bus) * (config->oversampling_8 ? 2 : 1);
+    uint64_t const div = (clock + (config->baudrate / 2)) / config->baudrate;
+    return div >= UART_DIV_MIN && div <= UART_DIV_MAX;
+}
+
+/**
+ * @brief Route the RTS and CTS pins of a USART, or return them to analog
+ */
+static void apply_flow_pins(UART_Bus bus, bool enable)
+{
+    FlowPins const *flow = &g_FLOW_PINS[bus];
+    if (flow->port == nullptr) {
+        return;
+    }
+
+    if (!enable) {
+        HAL_GPIO_DeInit(flow->port, flow->pins);
+        return;
+    }
+
+    if (flow->port == GPIOB) {
+        __HAL_RCC_GPIOB_CLK_ENABLE();
+    } else {
+        __HAL_RCC_GPIOD_CLK_ENABLE();
+    }
+
+    GPIO_InitTypeDef gpio_init = { 0 };
+    gpio_init.Pin = flow->pins;
+    gpio_init.Mode = GPIO_MODE_AF_PP;
+    gpio_init.Pull = GPIO_NOPULL;
+    gpio_init.Speed = GPIO_SPEED_FREQ_HIGH;
+    gpio_init.Alternate = flow->alternate;
+    HAL_GPIO_Init(flow->port, &gpio_init);
+}
+
+/**
+ * @brief Program the line settings of an instance into the peripheral
+ */
+static void apply_line_config(UARTInstance *instance)
+{
+    UART_LL_LineConfig const *config = &instance->line_config;
+    static uint32_t const parities[] = {
+        [UART_LL_PARITY_NONE] = UART_PARITY_NONE,
+        [UART_LL_PARITY_EVEN] = UART_PARITY_EVEN,
+        [UART_LL_PARITY_ODD] = UART_PARITY_ODD,
+    };
+
+    instance->huart->Init.BaudRate = config->baudrate;
+    // The parity bit takes the place of the ninth data bit
+    instance->huart->Init.WordLength = config->parity == UART_LL_PARITY_NONE
+                                           ? UART_WORDLENGTH_8B
+                                           : UART_WORDLENGTH_9B;
+    instance->huart->Init.StopBits = config->stop_bits == UART_LL_STOP_BITS_2
+                                         ? UART_STOPBITS_2
+                                         : UART_STOPBITS_1;
+    instance->huart->Init.Parity = parities[config->parity];
+    instance->huart->Init.Mode = UART_MODE_TX_RX;
+    // CTS would hold up a looped-back transmitter with nothing on the
+    // other side of the line
+    bool const flow_control = config->flow_control && !instance->loopback;
+    instance->huart->Init.HwFlowCtl =
+        flow_control ? UART_HWCONTROL_RTS_CTS : UART_HWCONTROL_NONE;
+    instance->huart->Init.OverSampling = config->oversampling_8
+                                             ? UART_OVERSAMPLING_8
+                                             : UART_OVERSAMPLING_16;
+    instance->huart->Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
+    instance->huart->Init.ClockPrescaler = UART_PRESCALER_DIV1;
+
+    // HAL_UART_Init clears HDSEL, HAL_HalfDuplex_Init sets it
+    HAL_StatusTypeDef const status = instance->loopback
+                                         ? HAL_HalfDuplex_Init(instance->huart)
+                                         : HAL_UART_Init(instance->huart);
+    if (status != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
+/**
+ * @brief Start DMA reception at the beginning of the RX buffer
+ */
+static void start_reception(UARTInstance *instance)
+{
+    if (HAL_UART_Receive_DMA(
+            instance->huart, instance->rx_buffer_data, instance->rx_buffer_size
+        ) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    /* Enable UART idle line interrupt for packet detection */
+    __HAL_UART_ENABLE_IT(instance->huart, UART_IT_IDLE);
+
+    /* Clear any pending flags */
+    __HAL_UART_CLEAR_FLAG(instance->huart, UART_FLAG_IDLE);
+    __HAL_UART_CLEAR_FLAG(instance->huart, UART_FLAG_ORE);
 }
 
 /**
@@ -320,40 +593,129 @@ void UART_LL_init(UART_Bus bus, uint8_t *rx_buf, uint32_t sz)
     };
 
     instance->huart->Instance = uart_instance[bus];
-
-    instance->huart->Init.BaudRate = UART_DEFAULT_BAUDRATE;
-    instance->huart->Init.WordLength = UART_WORDLENGTH_8B;
-    instance->huart->Init.StopBits = UART_STOPBITS_1;
-    instance->huart->Init.Parity = UART_PARITY_NONE;
-    instance->huart->Init.Mode = UART_MODE_TX_RX;
-    instance->huart->Init.HwFlowCtl = UART_HWCONTROL_NONE;
-    instance->huart->Init.OverSampling = UART_OVERSAMPLING_16;
-    instance->huart->Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
-    instance->huart->Init.ClockPrescaler = UART_PRESCALER_DIV1;
-
-    if (HAL_UART_Init(instance->huart) != HAL_OK) {
-        THROW(ERROR_HARDWARE_FAULT);
-    }
-
+    instance->line_config = (UART_LL_LineConfig){
+        .baudrate = UART_DEFAULT_BAUDRATE,
+        .parity = UART_LL_PARITY_NONE,
+        .stop_bits = UART_LL_STOP_BITS_1,
+        .oversampling_8 = false,
+        .flow_control = false,
+    };
+    instance->loopback = false;
+    // Needed by the RX DMA setup in HAL_UART_MspInit
     instance->rx_buffer_data = rx_buf;
     instance->rx_buffer_size = sz;
+    apply_line_config(instance);
+
     instance->tx_in_progress = false;
     instance->tx_dma_size = 0;
     instance->initialized = true;
 
-    /* Start DMA reception */
-    if (HAL_UART_Receive_DMA(
-            instance->huart, instance->rx_buffer_data, instance->rx_buffer_size
-        ) != HAL_OK) {
+    start_reception(instance);
+}
+
+void UART_LL_configure(UART_Bus bus, UART_LL_LineConfig const *config)
+{
+    if (bus >= UART_BUS_COUNT || !config ||
+        config->parity > UART_LL_PARITY_ODD ||
+        config->stop_bits > UART_LL_STOP_BITS_2) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    UARTInstance *instance = &g_uart_instances[bus];
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (!baudrate_valid(bus, config) ||
+        (config->flow_control && g_FLOW_PINS[bus].port == nullptr)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    // Changing the line settings mid-frame would garble the frame
+    if (instance->tx_in_progress) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    if (HAL_UART_AbortReceive(instance->huart) != HAL_OK) {
         THROW(ERROR_HARDWARE_FAULT);
     }
 
-    /* Enable UART idle line interrupt for packet detection */
-    __HAL_UART_ENABLE_IT(instance->huart, UART_IT_IDLE);
+    UART_LL_LineConfig const previous = instance->line_config;
+    Error error = ERROR_NONE;
+    TRY
+    {
+        if (config->flow_control != previous.flow_control) {
+            apply_flow_pins(bus, config->flow_control);
+        }
+        instance->line_config = *config;
+        apply_line_config(instance);
+        start_reception(instance);
+    }
+    CATCH(error)
+    {
+        // Reception was aborted above; bring the old line settings back up
+        if (config->flow_control != previous.flow_control) {
+            apply_flow_pins(bus, previous.flow_control);
+        }
+        instance->line_config = previous;
+        apply_line_config(instance);
+        start_reception(instance);
+        THROW(error);
+    }
+}
 
-    /* Clear any pending flags */
-    __HAL_UART_CLEAR_FLAG(instance->huart, UART_FLAG_IDLE);
-    __HAL_UART_CLEAR_FLAG(instance->huart, UART_FLAG_ORE);
+void UART_LL_set_loopback(UART_Bus bus, bool enable)
+{
+    if (bus >= UART_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    UARTInstance *instance = &g_uart_instances[bus];
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (instance->tx_in_progress) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    if (HAL_UART_AbortReceive(instance->huart) != HAL_OK) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    // With TE and RE both set, the half-duplex receiver gets every frame
+    // the transmitter sends
+    instance->loopback = enable;
+    apply_line_config(instance);
+    start_reception(instance);
+}
+
+RAMFUNC void UART_LL_set_rx_paused(UART_Bus bus, bool paused)
+{
+    if (bus >= UART_BUS_COUNT || !g_uart_instances[bus].initialized) {
+        return;
+    }
+
+    // Only the DMA requests stop; the channel stays armed at its position
+    USART_TypeDef *const usart = g_uart_instances[bus].huart->Instance;
+    if (paused) {
+        ATOMIC_CLEAR_BIT(usart->CR3, USART_CR3_DMAR);
+    } else {
+        ATOMIC_SET_BIT(usart->CR3, USART_CR3_DMAR);
+    }
+}
+
+uint32_t UART_LL_get_max_baudrate(UART_Bus bus, bool oversampling_8)
+{
+    if (bus >= UART_BUS_COUNT) {
+        return 0;
+    }
+
+    // The smallest divider gives clock / 16, or clock / 8 with 8x oversampling
+    uint32_t const div = oversampling_8 ? UART_DIV_MIN / 2 : UART_DIV_MIN;
+    return kernel_clock(bus) / div;
 }
 
 /**
@@ -382,10 +744,19 @@ void UART_LL_deinit(UART_Bus bus)
         HAL_NVIC_DisableIRQ(USART3_IRQn);
     }
 
+    /* Stop the DMA, whose channels go back to the pool */
+    (void)HAL_UART_Abort(instance->huart);
+    DMA_CHANNEL_release(instance->huart->hdmatx);
+    DMA_CHANNEL_release(instance->huart->hdmarx);
+
     /* Deinitialize UART */
     if (HAL_UART_DeInit(instance->huart) != HAL_OK) {
         THROW(ERROR_HARDWARE_FAULT);
     }
+    if (instance->line_config.flow_control) {
+        apply_flow_pins(bus, false);
+        instance->line_config.flow_control = false;
+    }
 
     /* Clear instance data */
     instance->rx_buffer_data = nullptr;
@@ -395,6 +766,7 @@ void UART_LL_deinit(UART_Bus bus)
     instance->tx_complete_callback = nullptr;
     instance->rx_complete_callback = nullptr;
     instance->idle_callback = nullptr;
+    instance->rx_timeout_callback = nullptr;
     instance->initialized = false;
 }
 
@@ -405,13 +777,37 @@ void UART_LL_deinit(UART_Bus bus)
  * @param buffer Pointer to data to transmit
  * @param size Number of bytes to transmit
  */
-void UART_LL_start_dma_tx(UART_Bus bus, uint8_t *buffer, uint32_t size)
+void UART_LL_start_dma_tx(
+    UART_Bus bus,
+    uint8_t const *buffer,
+    uint32_t size
+)
+{
+    UART_LL_start_dma_tx_wrapped(bus, buffer, size, nullptr, 0);
+}
+
+/**
+ * @brief Start UART DMA transmission of two spans, back to back
+ *
+ * @param bus UART bus instance
+ * @param first Pointer to data to transmit first
+ * @param first_size Number of bytes at first
+ * @param second Pointer to data to transmit after it, or nullptr
+ * @param second_size Number of bytes at second, or 0 for first only
+ */
+void UART_LL_start_dma_tx_wrapped(
+    UART_Bus bus,
+    uint8_t const *first,
+    uint32_t first_size,
+    uint8_t const *second,
+    uint32_t second_size
+)
 {
     if (bus >= UART_BUS_COUNT) {
         THROW(ERROR_INVALID_ARGUMENT);
     }
 
-    if (!buffer || size == 0) {
+    if (!first || first_size == 0 || (!second && second_size > 0)) {
         THROW(ERROR_INVALID_ARGUMENT);
     }
 
@@ -420,10 +816,24 @@ void UART_LL_start_dma_tx(UART_Bus bus, uint8_t *buffer, uint32_t size)
     }
 
     UARTInstance *instance = &g_uart_instances[bus];
+    uint32_t *const head = g_tx_dma_nodes[bus][0].LinkRegisters;
+    uint32_t *const tail = g_tx_dma_nodes[bus][1].LinkRegisters;
+
+    /* The DMA is idle, so the nodes may change; end the list at the first
+     * node unless there is a second span */
+    if (second_size > 0) {
+        tail[NODE_CSAR_DEFAULT_OFFSET] = (uint32_t)second;
+        tail[NODE_CBR1_DEFAULT_OFFSET] = second_size;
+        head[NODE_CLLR_LINEAR_DEFAULT_OFFSET] = g_tx_dma_links[bus];
+    } else {
+        head[NODE_CLLR_LINEAR_DEFAULT_OFFSET] = 0;
+    }
+
     instance->tx_in_progress = true;
-    instance->tx_dma_size = size;
+    instance->tx_dma_size = first_size + second_size;
 
-    if (HAL_UART_Transmit_DMA(instance->huart, buffer, size) != HAL_OK) {
+    if (HAL_UART_Transmit_DMA(instance->huart, first, first_size) !=
+        HAL_OK) {
         instance->tx_in_progress = false;
         instance->tx_dma_size = 0;
         THROW(ERROR_HARDWARE_FAULT);
@@ -493,6 +903,41 @@ void UART_LL_set_rx_complete_callback(
     g_uart_instances[bus].rx_complete_callback = callback;
 }
 
+void UART_LL_set_rx_timeout(
+    UART_Bus bus,
+    uint32_t bit_times,
+    UART_LL_IdleCallback callback
+)
+{
+    if (bus >= UART_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    UARTInstance *instance = &g_uart_instances[bus];
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    USART_TypeDef *const usart = instance->huart->Instance;
+    if (bit_times == 0 || callback == nullptr) {
+        __HAL_UART_DISABLE_IT(instance->huart, UART_IT_RTO);
+        CLEAR_BIT(usart->CR2, USART_CR2_RTOEN);
+        instance->rx_timeout_callback = nullptr;
+        return;
+    }
+
+    // The counter restarts with every received character
+    MODIFY_REG(
+        usart->RTOR,
+        USART_RTOR_RTO,
+        bit_times < USART_RTOR_RTO ? bit_times : USART_RTOR_RTO
+    );
+    instance->rx_timeout_callback = callback;
+    SET_BIT(usart->CR2, USART_CR2_RTOEN);
+    __HAL_UART_CLEAR_FLAG(instance->huart, UART_CLEAR_RTOF);
+    __HAL_UART_ENABLE_IT(instance->huart, UART_IT_RTO);
+}
+
 /**
  * @brief Set the idle line callback function
  * @param bus UART bus instance
@@ -511,7 +956,7 @@ void UART_LL_set_idle_callback(UART_Bus bus, UART_LL_IdleCallback callback)
  *
  * Called by HAL when TX DMA transfer is complete.
  */
-void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+RAMFUNC void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
     UART_Bus bus = get_bus_from_handle(huart);
     if (bus >= UART_BUS_COUNT) {
@@ -530,9 +975,9 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 /**
  * @brief UART RX complete callback
  *
- * Called by HAL when RX DMA buffer is full.
+ * Called by HAL when RX DMA has filled the buffer.
  */
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+RAMFUNC void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
     UART_Bus bus = get_bus_from_handle(huart);
     if (bus >= UART_BUS_COUNT) {
@@ -541,12 +986,27 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 
     UARTInstance *instance = &g_uart_instances[bus];
 
-    /* Restart DMA reception */
-    HAL_UART_Receive_DMA(
-        huart, instance->rx_buffer_data, instance->rx_buffer_size
-    );
+    /* DMA wraps around to the start of the buffer by itself */
+    if (instance->rx_complete_callback != nullptr) {
+        instance->rx_complete_callback(bus);
+    }
+}
+
+/**
+ * @brief UART RX half complete callback
+ *
+ * Called by HAL when RX DMA has filled the first half of the buffer. Gives
+ * the hardware-independent layer a chance to catch up before the DMA wraps.
+ */
+RAMFUNC void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart)
+{
+    UART_Bus bus = get_bus_from_handle(huart);
+    if (bus >= UART_BUS_COUNT) {
+        return;
+    }
+
+    UARTInstance *instance = &g_uart_instances[bus];
 
-    /* Notify the hardware-independent layer */
     if (instance->rx_complete_callback != nullptr) {
         instance->rx_complete_callback(bus);
     }
@@ -556,7 +1016,7 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
  * @brief Common UART interrupt handler
  * @param huart UART handle
  */
-static void uart_irq_handler(UART_HandleTypeDef *huart)
+RAMFUNC static void uart_irq_handler(UART_HandleTypeDef *huart)
 {
     UART_Bus bus = get_bus_from_handle(huart);
     if (bus >= UART_BUS_COUNT) {
@@ -578,6 +1038,16 @@ static void uart_irq_handler(UART_HandleTypeDef *huart)
         }
     }
 
+    /* Handled here: HAL would treat a receiver timeout as an error and
+     * abort the DMA reception */
+    if (__HAL_UART_GET_FLAG(huart, UART_FLAG_RTOF) != RESET) {
+        __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_RTOF);
+
+        if (instance->rx_timeout_callback != nullptr) {
+            instance->rx_timeout_callback(bus, UART_LL_get_dma_position(bus));
+        }
+    }
+
     /* Handle other UART interrupts */
     HAL_UART_IRQHandler(huart);
 }
@@ -596,33 +1066,3 @@ void USART2_IRQHandler(void) { uart_irq_handler(&g_huart2); }
  * @brief USART3 interrupt handler
  */
 void USART3_IRQHandler(void) { uart_irq_handler(&g_huart3); }
-
-/**
- * @brief GPDMA1 Channel0 interrupt handler (USART1 TX)
- */
-void GPDMA1_Channel0_IRQHandler(void) { HAL_DMA_IRQHandler(&g_hdma_usart1_tx); }
-
-/**
- * @brief GPDMA1 Channel1 interrupt handler (USART1 RX)
- */
-void GPDMA1_Channel1_IRQHandler(void) { HAL_DMA_IRQHandler(&g_hdma_usart1_rx); }
-
-/**
- * @brief GPDMA1 Channel2 interrupt handler (USART2 TX)
- */
-void GPDMA1_Channel2_IRQHandler(void) { HAL_DMA_IRQHandler(&g_hdma_usart2_tx); }
-
-/**
- * @brief GPDMA1 Channel3 interrupt handler (USART2 RX)
- */
-void GPDMA1_Channel3_IRQHandler(void) { HAL_DMA_IRQHandler(&g_hdma_usart2_rx); }
-
-/**
- * @brief GPDMA1 Channel4 interrupt handler (USART3 TX)
- */
-void GPDMA1_Channel4_IRQHandler(void) { HAL_DMA_IRQHandler(&g_hdma_usart3_tx); }
-
-/**
- * @brief GPDMA1 Channel5 interrupt handler (USART3 RX)
- */
-void GPDMA1_Channel5_IRQHandler(void) { HAL_DMA_IRQHandler(&g_hdma_usart3_rx); }
@@ -45,17 +45,65 @@ tusb_desc_device_t const g_DESC_DEVICE = {
     .bNumConfigurations = 0x01
 };
 
-// Configuration + CDC
+// Interface numbers
+enum {
+    ITF_NUM_CDC,
+    ITF_NUM_CDC_DATA,
+    ITF_NUM_VENDOR,
+    ITF_NUM_CDC_LOG,
+    ITF_NUM_CDC_LOG_DATA,
+#if PSLAB_USB_ISO
+    ITF_NUM_ISO,
+#else
+    ITF_NUM_CDC_BRIDGE,
+    ITF_NUM_CDC_BRIDGE_DATA,
+#endif
+    ITF_NUM_TOTAL
+};
+
+// Isochronous sample interface: alternate setting 0 without endpoints,
+// alternate setting 1 with one asynchronous IN endpoint polled every frame
+#define TUD_ISO_STREAM_DESC_LEN (9 + 9 + 7)
+#define TUD_ISO_STREAM_DESCRIPTOR(_itfnum, _stridx, _epin, _epsize)            \
+    9, TUSB_DESC_INTERFACE, _itfnum, 0, 0, TUSB_CLASS_VENDOR_SPECIFIC,         \
+        USB_LL_ISO_SUBCLASS, 0x00, _stridx, 9, TUSB_DESC_INTERFACE, _itfnum,   \
+        1, 1, TUSB_CLASS_VENDOR_SPECIFIC, USB_LL_ISO_SUBCLASS, 0x00, _stridx,  \
+        7, TUSB_DESC_ENDPOINT, _epin,                                          \
+        (TUSB_XFER_ISOCHRONOUS | TUSB_ISO_EP_ATT_ASYNCHRONOUS),                \
+        U16_TO_U8S_LE(_epsize), 1
+
+#if PSLAB_USB_ISO
+#define LAST_ITF_DESC_LEN TUD_ISO_STREAM_DESC_LEN
+#else
+#define LAST_ITF_DESC_LEN TUD_CDC_DESC_LEN
+#endif
+
+// Configuration + CDC (SCPI) + vendor bulk (sample data) + CDC (log) +
+// CDC (UART bridge) or isochronous sample data.
+//
+// The controller has eight hardware endpoints; each serves one endpoint
+// number in both directions if the two have the same type. Every bulk pair
+// therefore shares a number, and each notification endpoint takes one of
+// its own, which uses all eight. A double buffered endpoint (see
+// tusb_config.h) serves one direction only.
 uint8_t const g_DESC_CONFIGURATION[] = {
     TUD_CONFIG_DESCRIPTOR(
         1,
-        2,
+        ITF_NUM_TOTAL,
         0,
-        TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN,
+        TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_VENDOR_DESC_LEN +
+            TUD_CDC_DESC_LEN + LAST_ITF_DESC_LEN,
         0x00,
         100
     ),
-    TUD_CDC_DESCRIPTOR(0, 4, 0x81, 8, 0x01, 0x82, 64)
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 4, 0x81, 8, 0x02, 0x82, 64),
+    TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 0, 0x03, 0x83, 64),
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_LOG, 0, 0x84, 8, 0x05, 0x85, 64),
+#if PSLAB_USB_ISO
+    TUD_ISO_STREAM_DESCRIPTOR(ITF_NUM_ISO, 0, 0x86, USB_LL_ISO_PACKET_SIZE)
+#else
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_BRIDGE, 0, 0x86, 8, 0x07, 0x87, 64)
+#endif
 };
 
 // String descriptors
@@ -4,20 +4,29 @@
  *
  * This module handles initialization and operation of the USB peripheral of
  * the STM32H5 microcontroller. It configures the hardware and dispatches USB
- * interrupts to the TinyUSB stack. The implementation supports multiple bus
- * instances (though current hardware has only one USB controller).
+ * interrupts to the TinyUSB stack. The single USB controller exposes four bus
+ * instances: three CDC serial ports and a vendor-class bulk data interface.
+ * Builds with PSLAB_USB_ISO replace the third serial port with an
+ * isochronous sample interface, served by a class driver of its own below.
  */
 
+#define LOG_MODULE LOG_MODULE_USB
+
+#include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #include "lib/tinyusb/src/tusb.h"
 #include "lib/tinyusb/src/tusb_config.h"
+#include "lib/tinyusb/src/device/usbd_pvt.h"
 #include "stm32h5xx_hal.h"
 
+#include "irq_priority.h"
+#include "platform.h"
 #include "usb_ll.h"
 #include "util/error.h"
+#include "util/util.h"
 
 // USB clock, 48 MHz
 enum { USB_CRS_FRQ_TARGET = 48000000 };
@@ -29,17 +38,53 @@ enum { USB_CRS_TRIM_STEP = 14 };
 // the clock frequency. This value will be modified by CRS at runtime.
 enum { USB_CRS_TRIM_DEFAULT = 32 };
 
-enum { USB_IRQ_PRIO = 5 }; // USB DRD FS IRQ priority
+
+// TinyUSB vendor interface index backing USB_BUS_1, the bulk data channel
+enum { BULK_VENDOR_ITF = 0 };
+
+// TinyUSB CDC interface indices backing USB_BUS_0 (SCPI), USB_BUS_2 (log)
+// and USB_BUS_3 (UART bridge)
+enum { SCPI_CDC_ITF = 0, LOG_CDC_ITF = 1, BRIDGE_CDC_ITF = 2 };
+
+// Data waiting for the isochronous endpoint, about four frames of it
+enum { ISO_FIFO_SIZE = 2048 };
+static_assert(
+    CIRCULAR_BUFFER_SIZE_VALID(ISO_FIFO_SIZE),
+    "ISO_FIFO_SIZE must be a power of 2"
+);
 
 /* USB instance state tracking */
 typedef struct {
     bool initialized;
     USB_LL_LineStateCallback line_state_callback;
+    USB_LL_LineCodingCallback line_coding_callback;
+    USB_LL_EventCallback volatile event_callback;
 } USBInstance;
 
 /* Instance array for future multi-controller support */
 static USBInstance g_usb_instances[USB_BUS_COUNT] = { 0 };
 
+/* Latest start-of-frame, written by the USB interrupt */
+static struct {
+    uint32_t frame; // Extended frame count, low bits from FNR
+    uint32_t time_us;
+    bool valid; // A frame has started since hardware_init
+} volatile g_sof = { 0 };
+
+#if PSLAB_USB_ISO
+/* Isochronous interface state, owned by the TinyUSB task */
+static struct {
+    CircularBuffer fifo;
+    uint8_t fifo_data[ISO_FIFO_SIZE];
+    tusb_desc_endpoint_t const *desc_ep; // Of alternate setting 1
+    uint8_t endpoint; // IN endpoint address, 0 until opened
+    bool streaming; // Host selected alternate setting 1
+} g_iso;
+
+// Packet being sent, filled from the FIFO once per frame
+CFG_TUD_MEM_ALIGN static uint8_t g_iso_packet[USB_LL_ISO_PACKET_SIZE];
+#endif
+
 /**
  * @brief Enable USB clock recovery system
  *
@@ -65,16 +110,26 @@ static void crs_enable(void)
     HAL_RCCEx_CRSConfig(&crs_init);
 }
 
-void USB_LL_init(USB_Bus bus)
+/**
+ * @brief Check whether any USB bus instance is initialized
+ *
+ * @return true if at least one instance is in use
+ */
+static bool any_instance_initialized(void)
 {
-    if (bus >= USB_BUS_COUNT) {
-        THROW(ERROR_INVALID_ARGUMENT);
-    }
-
-    if (g_usb_instances[bus].initialized) {
-        THROW(ERROR_RESOURCE_BUSY);
+    for (size_t i = 0; i < USB_BUS_COUNT; ++i) {
+        if (g_usb_instances[i].initialized) {
+            return true;
+        }
     }
+    return false;
+}
 
+/**
+ * @brief Bring up the USB controller and the TinyUSB stack
+ */
+static void hardware_init(void)
+{
     HAL_PWREx_EnableVddUSB();
 
     // Initialize USB clock.
@@ -101,7 +156,8 @@ void USB_LL_init(USB_Bus bus)
     gpio_init.Alternate = GPIO_AF10_USB;
     HAL_GPIO_Init(GPIOA, &gpio_init);
 
-    HAL_NVIC_SetPriority(USB_DRD_FS_IRQn, USB_IRQ_PRIO, 0);
+    HAL_NVIC_SetPriority(USB_DRD_FS_IRQn, IRQ_PRIORITY_USB, 0);
+    HAL_NVIC_SetPriority(PendSV_IRQn, IRQ_PRIORITY_USB_SERVICE, 0);
 
     // TinyUSB owns the pins and ISR from this point.
     // Because AI reviewers keep commenting on it:
@@ -110,25 +166,21 @@ void USB_LL_init(USB_Bus bus)
     if (!tusb_init()) {
         THROW(ERROR_HARDWARE_FAULT);
     }
+    // Start-of-frame interrupts stamp the frames for USB_LL_get_frame_stamp,
+    // and give event-driven users a 1 ms heartbeat, e.g. for timed TX flushes
+    g_sof.valid = false;
+    tud_sof_cb_enable(true);
 
     if (__HAL_RCC_GET_USB_SOURCE() == RCC_USBCLKSOURCE_HSI48) {
         crs_enable();
     }
-
-    g_usb_instances[bus].initialized = true;
 }
 
 /**
- * @brief Deinitialize the USB peripheral
- *
- * @param bus USB bus instance to deinitialize
+ * @brief Shut down the USB controller
  */
-void USB_LL_deinit(USB_Bus bus)
+static void hardware_deinit(void)
 {
-    if (bus >= USB_BUS_COUNT || !g_usb_instances[bus].initialized) {
-        return;
-    }
-
     // Disable USB interrupt
     HAL_NVIC_DisableIRQ(USB_DRD_FS_IRQn);
 
@@ -140,8 +192,257 @@ void USB_LL_deinit(USB_Bus bus)
 
     // Disable USB power
     HAL_PWREx_DisableVddUSB();
+}
+
+void USB_LL_init(USB_Bus bus)
+{
+    if (bus >= USB_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (g_usb_instances[bus].initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    // The isochronous interface takes the place of the bridge port
+    if (bus == (PSLAB_USB_ISO ? USB_BUS_3 : USB_BUS_4)) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+
+    // All interfaces belong to the same device; only the first one to be
+    // initialized starts the controller.
+    if (!any_instance_initialized()) {
+        hardware_init();
+    }
+
+    g_usb_instances[bus].initialized = true;
+}
+
+/**
+ * @brief Map a CDC bus to its TinyUSB CDC interface index
+ */
+static uint8_t cdc_itf(USB_Bus bus)
+{
+    switch (bus) {
+    case USB_BUS_2:
+        return LOG_CDC_ITF;
+    case USB_BUS_3:
+        return BRIDGE_CDC_ITF;
+    default:
+        return SCPI_CDC_ITF;
+    }
+}
+
+/**
+ * @brief Map a TinyUSB CDC interface index to its bus
+ */
+static USB_Bus cdc_bus(uint8_t itf)
+{
+    switch (itf) {
+    case LOG_CDC_ITF:
+        return USB_BUS_2;
+    case BRIDGE_CDC_ITF:
+        return USB_BUS_3;
+    default:
+        return USB_BUS_0;
+    }
+}
+
+#if PSLAB_USB_ISO
+/**
+ * @brief Queue the next isochronous packet from the FIFO
+ *
+ * Only one packet is queued at a time, and the endpoint sends at most one
+ * per frame, so the FIFO drains at the rate the host reserved. Called from
+ * writers in thread mode and from the transfer completion in the USB task,
+ * so the FIFO's read side is taken with interrupts disabled.
+ *
+ * @return Number of bytes queued
+ */
+static uint32_t iso_queue_packet(void)
+{
+    uint8_t const rhport = 0;
+    uint32_t len = 0;
+    uint32_t const state = PLATFORM_disable_interrupts();
+
+    if (g_iso.streaming && usbd_edpt_claim(rhport, g_iso.endpoint)) {
+        len = circular_buffer_read(
+            &g_iso.fifo, g_iso_packet, USB_LL_ISO_PACKET_SIZE
+        );
+        if (len == 0 || !usbd_edpt_xfer(
+                            rhport, g_iso.endpoint, g_iso_packet, (uint16_t)len
+                        )) {
+            usbd_edpt_release(rhport, g_iso.endpoint);
+            len = 0;
+        }
+    }
+
+    PLATFORM_restore_interrupts(state);
+    return len;
+}
+
+static void iso_driver_init(void)
+{
+    circular_buffer_init(&g_iso.fifo, g_iso.fifo_data, ISO_FIFO_SIZE);
+    g_iso.desc_ep = nullptr;
+    g_iso.endpoint = 0;
+    g_iso.streaming = false;
+}
+
+static bool iso_driver_deinit(void) { return true; }
+
+static void iso_driver_reset(uint8_t rhport)
+{
+    (void)rhport;
+    iso_driver_init();
+}
+
+/**
+ * @brief Claim the isochronous interface and reserve its endpoint
+ *
+ * Other vendor interfaces are left to the vendor class driver.
+ *
+ * @return Length of the interface's descriptors, or 0 if not ours
+ */
+static uint16_t iso_driver_open(
+    uint8_t rhport,
+    tusb_desc_interface_t const *desc_itf,
+    uint16_t max_len
+)
+{
+    TU_VERIFY(
+        desc_itf->bInterfaceClass == TUSB_CLASS_VENDOR_SPECIFIC &&
+            desc_itf->bInterfaceSubClass == USB_LL_ISO_SUBCLASS,
+        0
+    );
+
+    uint8_t const itf = desc_itf->bInterfaceNumber;
+    uint8_t const *desc = (uint8_t const *)desc_itf;
+    uint8_t const *const end = desc + max_len;
+
+    // Alternate settings follow the first one
+    desc = tu_desc_next(desc);
+    while (desc < end) {
+        if (tu_desc_type(desc) == TUSB_DESC_INTERFACE &&
+            ((tusb_desc_interface_t const *)desc)->bInterfaceNumber != itf) {
+            break;
+        }
+        if (tu_desc_type(desc) == TUSB_DESC_ENDPOINT) {
+            g_iso.desc_ep = (tusb_desc_endpoint_t const *)desc;
+            g_iso.endpoint = g_iso.desc_ep->bEndpointAddress;
+            TU_ASSERT(
+                usbd_edpt_iso_alloc(
+                    rhport, g_iso.endpoint, tu_edpt_packet_size(g_iso.desc_ep)
+                ),
+                0
+            );
+        }
+        desc = tu_desc_next(desc);
+    }
+
+    return (uint16_t)(desc - (uint8_t const *)desc_itf);
+}
+
+/**
+ * @brief Switch the isochronous endpoint on and off with the alternate
+ * setting
+ */
+static bool iso_driver_control_xfer(
+    uint8_t rhport,
+    uint8_t stage,
+    tusb_control_request_t const *request
+)
+{
+    if (request->bmRequestType_bit.type != TUSB_REQ_TYPE_STANDARD) {
+        return false;
+    }
+
+    if (request->bRequest == TUSB_REQ_GET_INTERFACE) {
+        if (stage == CONTROL_STAGE_SETUP) {
+            static uint8_t alternate;
+            alternate = g_iso.streaming ? 1 : 0;
+            return tud_control_xfer(rhport, request, &alternate, 1);
+        }
+        return true;
+    }
+
+    if (request->bRequest != TUSB_REQ_SET_INTERFACE) {
+        return false;
+    }
+
+    if (stage == CONTROL_STAGE_SETUP) {
+        uint8_t const alternate = tu_u16_low(request->wValue);
+        TU_VERIFY(alternate <= 1 && g_iso.desc_ep != nullptr);
+
+        // Stale data would arrive late; start each stream from scratch
+        circular_buffer_reset(&g_iso.fifo);
+        g_iso.streaming = false;
+        if (alternate == 1) {
+            TU_ASSERT(usbd_edpt_iso_activate(rhport, g_iso.desc_ep));
+            g_iso.streaming = true;
+        }
+        return tud_control_status(rhport, request);
+    }
+    return true;
+}
+
+static bool iso_driver_xfer(
+    uint8_t rhport,
+    uint8_t ep_addr,
+    xfer_result_t result,
+    uint32_t xferred_bytes
+)
+{
+    (void)rhport;
+    (void)result;
+    (void)xferred_bytes;
+
+    if (ep_addr == g_iso.endpoint) {
+        iso_queue_packet();
+    }
+    return true;
+}
+
+static usbd_class_driver_t const g_iso_driver = {
+    .name = "ISO",
+    .init = iso_driver_init,
+    .deinit = iso_driver_deinit,
+    .reset = iso_driver_reset,
+    .open = iso_driver_open,
+    .control_xfer_cb = iso_driver_control_xfer,
+    .xfer_cb = iso_driver_xfer,
+    .sof = nullptr,
+};
+
+/**
+ * @brief TinyUSB hook adding the isochronous interface's class driver
+ */
+usbd_class_driver_t const *usbd_app_driver_get_cb(uint8_t *driver_count)
+{
+    *driver_count = 1;
+    return &g_iso_driver;
+}
+#endif
+
+/**
+ * @brief Deinitialize the USB peripheral
+ *
+ * The controller is shut down once no bus instance remains initialized.
+ *
+ * @param bus USB bus instance to deinitialize
+ */
+void USB_LL_deinit(USB_Bus bus)
+{
+    if (bus >= USB_BUS_COUNT || !g_usb_instances[bus].initialized) {
+        return;
+    }
 
     g_usb_instances[bus].initialized = false;
+    g_usb_instances[bus].event_callback = nullptr;
+
+    if (!any_instance_initialized()) {
+        hardware_deinit();
+    }
 }
 
 static size_t get_unique_id(uint8_t id[])
@@ -186,21 +487,78 @@ size_t USB_LL_get_serial(uint16_t desc_str1[], size_t const max_chars)
  * Dispatches the USB DRD FS interrupt to the TinyUSB device controller
  * driver. Called by the NVIC when USB_DRD_FS_IRQn is triggered.
  */
-void USB_DRD_FS_IRQHandler(void) { tud_int_handler(0); }
+void USB_DRD_FS_IRQHandler(void)
+{
+    // Stamp the frame first, before the stack adds to the latency
+    if ((USB_DRD_FS->ISTR & USB_ISTR_SOF) != 0U) {
+        uint32_t const time_us = PLATFORM_get_time_us();
+        uint32_t const number = USB_DRD_FS->FNR & USB_FNR_FN;
+
+        g_sof.frame += (number - g_sof.frame) & USB_FNR_FN;
+        g_sof.time_us = time_us;
+        g_sof.valid = true;
+    }
+    tud_int_handler(0);
+    // Let the service interrupt act on whatever the stack just queued
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+/**
+ * @brief Deferred USB service handler.
+ *
+ * Runs at the lowest interrupt priority, so TinyUSB events are processed as
+ * soon as no other interrupt is active, regardless of what the main loop is
+ * doing.
+ */
+void PendSV_Handler(void)
+{
+    for (size_t i = 0; i < USB_BUS_COUNT; ++i) {
+        USB_LL_EventCallback const callback =
+            g_usb_instances[i].event_callback;
+        if (g_usb_instances[i].initialized && callback) {
+            callback((USB_Bus)i);
+        }
+    }
+}
 
 uint32_t USB_LL_rx_available(USB_Bus const interface_id)
 {
-    return tud_cdc_n_available(interface_id);
+#if PSLAB_USB_ISO
+    if (interface_id == USB_BUS_4) {
+        return 0;
+    }
+#endif
+    if (interface_id == USB_BUS_1) {
+        return tud_vendor_n_available(BULK_VENDOR_ITF);
+    }
+    return tud_cdc_n_available(cdc_itf(interface_id));
 }
 
 uint32_t USB_LL_tx_available(USB_Bus const interface_id)
 {
-    return tud_cdc_n_write_available(interface_id);
+#if PSLAB_USB_ISO
+    if (interface_id == USB_BUS_4) {
+        // Data written without a stream would be stale once it starts
+        return g_iso.streaming ? circular_buffer_free_space(&g_iso.fifo) : 0;
+    }
+#endif
+    if (interface_id == USB_BUS_1) {
+        return tud_vendor_n_write_available(BULK_VENDOR_ITF);
+    }
+    return tud_cdc_n_write_available(cdc_itf(interface_id));
 }
 
 uint32_t USB_LL_read(USB_Bus const interface_id, uint8_t *buf, uint32_t bufsize)
 {
-    return tud_cdc_n_read(interface_id, buf, bufsize);
+#if PSLAB_USB_ISO
+    if (interface_id == USB_BUS_4) {
+        return 0;
+    }
+#endif
+    if (interface_id == USB_BUS_1) {
+        return tud_vendor_n_read(BULK_VENDOR_ITF, buf, bufsize);
+    }
+    return tud_cdc_n_read(cdc_itf(interface_id), buf, bufsize);
 }
 
 uint32_t USB_LL_write(
@@ -209,18 +567,53 @@ uint32_t USB_LL_write(
     uint32_t bufsize
 )
 {
-    return tud_cdc_n_write(interface_id, buf, bufsize);
+#if PSLAB_USB_ISO
+    if (interface_id == USB_BUS_4) {
+        if (!g_iso.streaming) {
+            return 0;
+        }
+        uint32_t const written =
+            circular_buffer_write(&g_iso.fifo, buf, bufsize);
+        iso_queue_packet();
+        return written;
+    }
+#endif
+    if (interface_id == USB_BUS_1) {
+        return tud_vendor_n_write(BULK_VENDOR_ITF, buf, bufsize);
+    }
+    return tud_cdc_n_write(cdc_itf(interface_id), buf, bufsize);
 }
 
 uint32_t USB_LL_tx_bufsize(USB_Bus const interface_id)
 {
-    (void)interface_id;
+    if (interface_id == USB_BUS_4) {
+        return ISO_FIFO_SIZE;
+    }
+    if (interface_id == USB_BUS_1) {
+        return CFG_TUD_VENDOR_TX_BUFSIZE;
+    }
     return CFG_TUD_CDC_TX_BUFSIZE;
 }
 
 uint32_t USB_LL_tx_flush(USB_Bus const interface_id)
 {
-    return tud_cdc_n_write_flush(interface_id);
+#if PSLAB_USB_ISO
+    if (interface_id == USB_BUS_4) {
+        return iso_queue_packet();
+    }
+#endif
+    if (interface_id == USB_BUS_1) {
+        return tud_vendor_n_write_flush(BULK_VENDOR_ITF);
+    }
+    return tud_cdc_n_write_flush(cdc_itf(interface_id));
+}
+
+bool USB_LL_notify(USB_Bus const interface_id, uint16_t const state)
+{
+    if (interface_id == USB_BUS_1 || interface_id >= USB_BUS_4) {
+        return false;
+    }
+    return tud_cdc_n_notify_serial_state(cdc_itf(interface_id), state);
 }
 
 void USB_LL_task(USB_Bus const interface_id)
@@ -231,7 +624,15 @@ void USB_LL_task(USB_Bus const interface_id)
 
 bool USB_LL_connected(USB_Bus const interface_id)
 {
-    return tud_cdc_n_connected(interface_id);
+#if PSLAB_USB_ISO
+    if (interface_id == USB_BUS_4) {
+        return tud_mounted() && g_iso.streaming;
+    }
+#endif
+    if (interface_id == USB_BUS_1) {
+        return tud_vendor_n_mounted(BULK_VENDOR_ITF);
+    }
+    return tud_cdc_n_connected(cdc_itf(interface_id));
 }
 
 void USB_LL_set_line_state_callback(
@@ -256,15 +657,86 @@ void USB_LL_set_line_state_callback(
  */
 void tud_cdc_line_state_cb(uint8_t itf, bool dtr, bool rts)
 {
-    if (itf < USB_BUS_COUNT) {
-        USBInstance instance = g_usb_instances[itf];
+    USB_Bus const bus = cdc_bus(itf);
+    USBInstance instance = g_usb_instances[bus];
 
-        if (!instance.initialized) {
-            return;
-        }
+    if (!instance.initialized) {
+        return;
+    }
 
-        if (instance.line_state_callback) {
-            instance.line_state_callback(itf, dtr, rts);
-        }
+    if (instance.line_state_callback) {
+        instance.line_state_callback(bus, dtr, rts);
     }
 }
+
+void USB_LL_set_line_coding_callback(
+    USB_Bus const interface_id,
+    USB_LL_LineCodingCallback callback
+)
+{
+    if (interface_id < USB_BUS_COUNT) {
+        g_usb_instances[interface_id].line_coding_callback = callback;
+    }
+}
+
+/**
+ * @brief TinyUSB CDC line coding change callback
+ *
+ * This function is called by the TinyUSB stack when the host sends a CDC
+ * SET_LINE_CODING request.
+ *
+ * @param itf USB interface number
+ * @param p_line_coding New line coding
+ */
+void tud_cdc_line_coding_cb(uint8_t itf, cdc_line_coding_t const *p_line_coding)
+{
+    USB_Bus const bus = cdc_bus(itf);
+    USBInstance instance = g_usb_instances[bus];
+
+    if (!instance.initialized || !instance.line_coding_callback) {
+        return;
+    }
+
+    USB_LL_LineCoding const coding = {
+        .baudrate = p_line_coding->bit_rate,
+        .parity = (USB_LL_Parity)p_line_coding->parity,
+        .stop_bits = (USB_LL_StopBits)p_line_coding->stop_bits,
+        .data_bits = p_line_coding->data_bits,
+    };
+    instance.line_coding_callback(bus, &coding);
+}
+
+void USB_LL_set_event_callback(
+    USB_Bus const interface_id,
+    USB_LL_EventCallback callback
+)
+{
+    if (interface_id >= USB_BUS_COUNT) {
+        return;
+    }
+
+    g_usb_instances[interface_id].event_callback = callback;
+}
+
+bool USB_LL_get_frame_stamp(uint32_t *frame, uint32_t *time_us)
+{
+    uint32_t const state = PLATFORM_disable_interrupts();
+    bool const valid = g_sof.valid;
+    uint32_t const stamp_frame = g_sof.frame;
+    uint32_t const stamp_us = g_sof.time_us;
+    PLATFORM_restore_interrupts(state);
+
+    if (!valid ||
+        PLATFORM_get_time_us() - stamp_us > USB_LL_FRAME_STALE_US) {
+        return false;
+    }
+    *frame = stamp_frame;
+    *time_us = stamp_us;
+    return true;
+}
+
+void USB_LL_request_service(USB_Bus const interface_id)
+{
+    (void)interface_id;
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file i2c_ll.h
+ * @brief Low-level I2C hardware interface
+ *
+ * This header provides the low-level hardware interface to the I2C bus. It
+ * defines the API for initializing the I2C peripheral as a bus controller,
+ * starting DMA-based register reads and writes, and registering a callback
+ * for their completion. A transfer runs without the CPU from its start to
+ * the completion callback, which is called from interrupt context.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_I2C_LL_H
+#define PSLAB_I2C_LL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief I2C bus instance enumeration
+ */
+typedef enum { I2C_BUS_0 = 0, I2C_BUS_COUNT = 1 } I2C_Bus;
+
+enum {
+    /** @brief Clock rate set by I2C_LL_init, in Hz */
+    I2C_LL_SPEED_DEFAULT = 100000,
+    /** @brief Lowest clock rate, in Hz */
+    I2C_LL_SPEED_MIN = 10000,
+    /** @brief Highest clock rate, Fast-mode Plus, in Hz */
+    I2C_LL_SPEED_MAX = 1000000,
+    /** @brief Most bytes moved by one transfer */
+    I2C_LL_TRANSFER_MAX = 0xFFFF,
+    /** @brief Highest 7-bit target address */
+    I2C_LL_ADDRESS_MAX = 0x7F,
+};
+
+/**
+ * @brief Outcome of a transfer
+ */
+typedef enum {
+    I2C_LL_STATUS_OK = 0,
+    I2C_LL_STATUS_NACK, // The target did not acknowledge
+    I2C_LL_STATUS_BUS_ERROR, // Misplaced start or stop, or arbitration lost
+    I2C_LL_STATUS_DMA_ERROR,
+} I2C_LL_Status;
+
+/**
+ * @brief A register read or write
+ *
+ * With reg_size 0 the data is read or written without a register address,
+ * otherwise the register address is written first, most significant byte
+ * first, and a read follows it with a repeated start.
+ */
+typedef struct {
+    uint8_t address; // 7-bit target address
+    bool read; // Read into data, else write from it
+    uint16_t reg; // Register address
+    uint8_t reg_size; // Bytes of register address, 0 to 2
+    uint8_t *data; // Must stay valid until the completion callback
+    uint32_t size; // Bytes of data, 1 to I2C_LL_TRANSFER_MAX
+} I2C_LL_Transfer;
+
+/**
+ * @brief Callback function type for completed transfers
+ *
+ * @param bus I2C bus instance
+ * @param status Outcome of the transfer
+ */
+typedef void (*I2C_LL_CompleteCallback)(I2C_Bus bus, I2C_LL_Status status);
+
+/**
+ * @brief Initialize the I2C peripheral as bus controller
+ *
+ * The pins are open-drain with the internal pull-ups; buses longer than a
+ * few centimetres or faster than 100 kHz need external ones.
+ *
+ * @param bus I2C bus instance to initialize
+ *
+ * @throws ERROR_INVALID_ARGUMENT if bus is invalid
+ * @throws ERROR_RESOURCE_BUSY if the bus is already initialized
+ * @throws ERROR_HARDWARE_FAULT if the peripheral cannot be configured
+ */
+void I2C_LL_init(I2C_Bus bus);
+
+/**
+ * @brief Deinitialize the I2C peripheral
+ *
+ * A transfer in progress is aborted without a completion callback.
+ *
+ * @param bus I2C bus instance to deinitialize
+ */
+void I2C_LL_deinit(I2C_Bus bus);
+
+/**
+ * @brief Change the clock rate of an idle bus
+ *
+ * The timing is derived from a kernel clock that system clock scaling
+ * leaves alone. The rate reached is somewhat below the one set, by the
+ * rise time of the bus.
+ *
+ * @param bus I2C bus instance
+ * @param speed Clock rate in Hz, I2C_LL_SPEED_MIN to I2C_LL_SPEED_MAX
+ *
+ * @throws ERROR_INVALID_ARGUMENT if bus or speed is invalid
+ * @throws ERROR_DEVICE_NOT_READY if the bus is not initialized
+ * @throws ERROR_RESOURCE_BUSY if a transfer is in progress
+ * @throws ERROR_HARDWARE_FAULT if the peripheral cannot be reconfigured
+ */
+void I2C_LL_set_speed(I2C_Bus bus, uint32_t speed);
+
+/**
+ * @brief Start a DMA transfer
+ *
+ * Returns at once; the completion callback reports the outcome.
+ *
+ * @param bus I2C bus instance
+ * @param transfer Transfer to run; copied, but not its data
+ *
+ * @throws ERROR_INVALID_ARGUMENT if bus or transfer is invalid
+ * @throws ERROR_DEVICE_NOT_READY if the bus is not initialized
+ * @throws ERROR_RESOURCE_BUSY if a transfer is in progress
+ * @throws ERROR_HARDWARE_FAULT if the transfer cannot be started
+ */
+void I2C_LL_start(I2C_Bus bus, I2C_LL_Transfer const *transfer);
+
+/**
+ * @brief Check if a transfer is in progress
+ *
+ * @param bus I2C bus instance
+ * @return true from I2C_LL_start until the completion callback
+ */
+bool I2C_LL_busy(I2C_Bus bus);
+
+/**
+ * @brief Set the transfer complete callback function
+ *
+ * @param bus I2C bus instance
+ * @param callback Callback function, called at the end of each transfer
+ */
+void I2C_LL_set_complete_callback(
+    I2C_Bus bus,
+    I2C_LL_CompleteCallback callback
+);
+
+#endif /* PSLAB_I2C_LL_H */
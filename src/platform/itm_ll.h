@@ -0,0 +1,80 @@
+/**
+ * @file itm_ll.h
+ * @brief Low-level ITM stimulus port output over SWO
+ *
+ * The ITM (Instrumentation Trace Macrocell) of the core sends words
+ * written to its stimulus ports out of the SWO pin, framed as ITM software
+ * source packets: a header byte of (port << 3) | size code, with size code
+ * 1, 2 or 3 for 1, 2 or 4 payload bytes, followed by the payload, least
+ * significant byte first. A debug probe or a UART receiver on the pin
+ * reads them. Each write is a store to a stimulus port register, a few
+ * cycles, and needs no DMA, interrupt or peripheral clock.
+ *
+ * Writes never wait: a port whose FIFO is full takes nothing, so callers
+ * decide whether to retry or to drop the data.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_LL_ITM_H
+#define PSLAB_LL_ITM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+enum {
+    ITM_LL_PORT_COUNT = 32, // Stimulus ports of the ITM
+};
+
+/**
+ * @brief Set up the SWO pin and the ITM
+ *
+ * Outputs NRZ (UART) frames at baudrate, derived from the core clock. The
+ * prescaler follows changes of the core clock, see
+ * PLATFORM_set_clock_speed, so choose a baudrate that divides both core
+ * clock speeds. Enables the ports in port_mask; a debugger may enable or
+ * disable ports on its own. Calling it again applies the new settings.
+ *
+ * @param baudrate SWO bit rate in bits per second
+ * @param port_mask Ports to enable, bit n for port n
+ */
+void ITM_LL_init(uint32_t baudrate, uint32_t port_mask);
+
+/**
+ * @brief Stop the ITM and release the SWO pin
+ */
+void ITM_LL_deinit(void);
+
+/**
+ * @brief Whether writes to a port are sent
+ *
+ * @param port Stimulus port number
+ * @return true if the ITM runs and the port is enabled
+ */
+bool ITM_LL_port_enabled(uint32_t port);
+
+/**
+ * @brief Write one word to a stimulus port
+ *
+ * @param port Stimulus port number
+ * @param word Payload, sent as a 4-byte packet
+ * @return true if the word was taken, false if the port FIFO is full or
+ *         the port is not enabled
+ */
+bool ITM_LL_write_word(uint32_t port, uint32_t word);
+
+/**
+ * @brief Write bytes to a stimulus port
+ *
+ * Sends whole words as 4-byte packets and the remainder as single bytes,
+ * until the port FIFO is full.
+ *
+ * @param port Stimulus port number
+ * @param data Bytes to send
+ * @param size Number of bytes
+ * @return Bytes taken, from the start of data
+ */
+uint32_t ITM_LL_write(uint32_t port, uint8_t const *data, uint32_t size);
+
+#endif // PSLAB_LL_ITM_H
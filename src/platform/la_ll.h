@@ -0,0 +1,112 @@
+/**
+ * @file la_ll.h
+ * @brief Low-level interface to timer-paced sampling of a GPIO port
+ *
+ * The logic analyzer inputs are eight pins of one GPIO port. A timer's
+ * update event requests one DMA transfer from the port's input data
+ * register per sample, so the pins are sampled at the timer rate without
+ * the CPU. Each sample is one byte, bit n holding input n.
+ *
+ * A continuous capture loops over the buffer as a ring of two halves, and
+ * hands each half to a callback as soon as it is written, for the caller
+ * to scan or encode while the DMA fills the other half.
+ *
+ * The DMA serves one request at a time. A request that arrives before the
+ * previous one is served is merged with it, so other DMA traffic at the
+ * highest rates shows as jitter rather than lost bytes.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_LA_LL_H
+#define PSLAB_LA_LL_H
+
+#include <stdint.h>
+
+#include "tim_ll.h"
+
+enum {
+    LA_LL_CHANNELS = 8, // Inputs per sample
+    LA_LL_SAMPLE_RATE_MAX = 20000000, // Hz, sustained by the DMA
+    LA_LL_SAMPLES_MAX = 4 * 0xFFFF, // Bytes per capture, four DMA blocks
+    LA_LL_RING_MAX = 2 * 0xFFFF, // Bytes of a continuous capture's ring
+};
+
+/**
+ * @brief Callback invoked from interrupt context when the capture ends
+ *
+ * @param samples Samples captured, fewer than requested after a DMA error
+ */
+typedef void (*LA_LL_CompleteCallback)(uint32_t samples);
+
+/**
+ * @brief Callback invoked from interrupt context with each written half of
+ * a continuous capture's ring
+ *
+ * The half is overwritten once the DMA has filled the other one.
+ *
+ * @param block First sample of the half
+ * @param samples Samples in the half
+ */
+typedef void (*LA_LL_BlockCallback)(uint8_t const *block, uint32_t samples);
+
+/**
+ * @brief Capture settings
+ */
+typedef struct {
+    TIM_Num timer; // Initialized timer pacing the samples
+    uint8_t *buffer; // Sample buffer, reachable by the DMA
+    uint32_t samples; // Samples to capture, at most LA_LL_SAMPLES_MAX
+    LA_LL_CompleteCallback complete_callback; // May be nullptr
+    // Makes the capture continuous, the buffer being a ring of an even
+    // number of samples, at most LA_LL_RING_MAX; complete_callback is then
+    // not used. May be nullptr.
+    LA_LL_BlockCallback block_callback;
+} LA_LL_Config;
+
+/**
+ * @brief Configure the inputs and the DMA for a capture
+ *
+ * The inputs are configured as floating inputs. The timer is not started.
+ *
+ * @param config Capture settings
+ *
+ * @throws ERROR_INVALID_ARGUMENT if config or its buffer is NULL, or the
+ *         number of samples is out of range or odd for a continuous capture
+ * @throws ERROR_RESOURCE_BUSY if already initialized
+ * @throws ERROR_HARDWARE_FAULT if the DMA cannot be configured
+ */
+void LA_LL_init(LA_LL_Config const *config);
+
+/**
+ * @brief Release the DMA channel and stop the timer's DMA requests
+ */
+void LA_LL_deinit(void);
+
+/**
+ * @brief Arm the DMA, so that each timer update takes a sample
+ *
+ * The timer is started by the caller afterwards.
+ *
+ * @throws ERROR_DEVICE_NOT_READY if not initialized
+ * @throws ERROR_HARDWARE_FAULT if the DMA cannot be started
+ */
+void LA_LL_start(void);
+
+/**
+ * @brief Abort a capture, or end a continuous one
+ *
+ * The complete callback is not invoked.
+ */
+void LA_LL_stop(void);
+
+/**
+ * @brief Samples captured so far
+ *
+ * @return Samples written to the buffer since LA_LL_start, or to the
+ *         current half of a continuous capture's ring
+ */
+uint32_t LA_LL_get_position(void);
+
+#endif // PSLAB_LA_LL_H
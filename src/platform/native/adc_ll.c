@@ -0,0 +1,894 @@
+/**
+ * @file adc_ll.c
+ * @brief Native ADC, converting a synthetic signal on timer triggers
+ *
+ * Every update event of the trigger timer converts the configured channels
+ * once, the way the timer triggers the ADCs on the target, and the results
+ * land in the output buffer in the target's layout: one sample per rank in
+ * single mode, ADC1 and ADC2 pairs in the dual modes. The handler does the
+ * conversions of the updates that have passed since its last run, so the
+ * buffer fills at the real sample rate, in bursts.
+ *
+ * Channel n carries a sine wave of (n + 1) kHz with an amplitude of a
+ * quarter of full scale around mid-scale, so that captures have a known
+ * content whatever the channels.
+ *
+ * If the handler falls behind by more than a buffer of conversions, the
+ * excess is dropped and counted as overruns.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/si_prefix.h"
+
+#include "adc_ll.h"
+#include "native.h"
+#include "platform.h"
+
+enum {
+    ADC_THRESHOLD_MAX = 0xFFF, // Largest 12-bit watchdog threshold
+    ADC_VREF_MV = 3300, // Nominal reference voltage
+    SIGNAL_MID = 2048, // Mid-scale, in 12-bit codes
+    SIGNAL_AMPLITUDE = 1024, // In 12-bit codes
+    SIGNAL_BASE_HZ = 1000, // Frequency of channel 0, and step per channel
+    SAMPLE_TIME_DEFAULT_2X = 185, // 92.5 cycles * 2
+    ADC_MODES = ADC_LL_MODE_INTERLEAVED + 1,
+};
+
+typedef struct {
+    uint16_t *buffer_data;
+    uint32_t buffer_size; // In uint16 samples, as the DMA counts them
+    ADC_LL_CompleteCallback complete_callback;
+    ADC_LL_CompleteCallback half_complete_callback;
+    ADC_LL_WatchdogCallback watchdog_callback;
+    ADC_LL_Channel channels[MAX_SIMULTANEOUS_CHANNELS];
+    ADC_LL_Channel sequence[ADC_LL_SEQUENCE_MAX];
+    uint32_t sequence_length;
+    ADC_LL_Mode mode;
+    TIM_Num trigger; // Timer whose updates trigger the conversions
+    uint32_t oversampling_ratio;
+    uint32_t oversampling_shift;
+    ADC_LL_Resolution resolution;
+    uint32_t sample_time_2x; // Sampling time in ADC cycles * 2
+    uint32_t prescaler; // Of the kernel clock, for the mode
+    bool circular;
+    bool initialized;
+    bool running;
+    uint64_t updates; // Trigger updates converted so far
+    uint32_t position; // Next sample to write
+    bool watchdog_armed;
+    uint16_t watchdog_low;
+    uint16_t watchdog_high;
+} ADCInstance;
+
+typedef struct {
+    ADC_LL_InjectedCallback callback;
+    ADC_LL_Channel channel;
+    uint32_t oversampling_ratio;
+    uint32_t oversampling_shift;
+    bool busy;
+    bool initialized;
+} InjectedMonitor;
+
+static ADCInstance g_adc_instance = {
+    .sequence_length = 1,
+    .mode = ADC_LL_MODE_SINGLE,
+    .oversampling_ratio = 1,
+    .resolution = ADC_LL_RESOLUTION_12BIT,
+    .sample_time_2x = SAMPLE_TIME_DEFAULT_2X,
+    .prescaler = 1,
+};
+
+static InjectedMonitor g_injected = { .oversampling_ratio = 1 };
+
+static ADC_LL_ErrorCounters g_error_counters = { 0 };
+
+// Sampling times, shortest first, in cycles * 2
+static uint32_t const g_sample_times_2x[] = {
+    5, 13, 25, 49, 95, 185, 495, 1281,
+};
+
+enum {
+    ADC_SAMPLE_TIMES = sizeof(g_sample_times_2x) / sizeof(g_sample_times_2x[0]),
+};
+
+// Clock of each acquisition mode, set on ADC_LL_init
+static ADC_LL_Clock g_mode_clocks[ADC_MODES] = {
+    [ADC_LL_MODE_SINGLE] = { PLATFORM_ADC_CLOCK_DIVIDER_DEFAULT, 1 },
+    [ADC_LL_MODE_SIMULTANEOUS] = { PLATFORM_ADC_CLOCK_DIVIDER_DEFAULT, 1 },
+    [ADC_LL_MODE_INTERLEAVED] = { PLATFORM_ADC_CLOCK_DIVIDER_DEFAULT, 1 },
+};
+
+// Prescalers of the kernel clock the target ADCs support
+static uint32_t const g_prescalers[] = {
+    1, 2, 4, 6, 8, 10, 12, 16, 32, 64, 128, 256,
+};
+
+/**
+ * @brief Conversion clock of a mode, its kernel clock after the prescaler
+ */
+static uint32_t mode_clock_hz(ADC_LL_Mode mode)
+{
+    ADC_LL_Clock const *clock = &g_mode_clocks[mode];
+    return PLATFORM_ADC_CLOCK_SOURCE_HZ /
+           (clock->kernel_divider * clock->prescaler);
+}
+
+/**
+ * @brief Conversion time at a resolution, in cycles * 2
+ */
+static uint32_t conversion_time_2x(ADC_LL_Resolution resolution)
+{
+    // 12.5, 10.5 and 8.5 cycles
+    return 25 - (4 * (uint32_t)resolution);
+}
+
+static void validate_oversampling_ratio(uint32_t ratio)
+{
+    if (ratio == 0 || ratio > 256 || (ratio & (ratio - 1)) != 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+static void validate_oversampling_shift(
+    uint32_t ratio,
+    uint32_t shift,
+    ADC_LL_Resolution resolution
+)
+{
+    uint32_t const max_bits = 16;
+    uint32_t const max_shift = 8;
+    uint32_t sum_bits = 12 - (2 * (uint32_t)resolution);
+
+    for (uint32_t r = ratio; r > 1; r >>= 1) {
+        ++sum_bits;
+    }
+    if (shift > max_shift || sum_bits > max_bits + shift) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+/**
+ * @brief Timer behind a trigger source
+ */
+static TIM_Num trigger_timer(ADC_LL_TriggerSource trigger)
+{
+    switch (trigger) {
+    case ADC_TRIGGER_TIMER1:
+    case ADC_TRIGGER_TIMER1_TRGO2:
+        return TIM_NUM_1;
+    case ADC_TRIGGER_TIMER2:
+        return TIM_NUM_2;
+    case ADC_TRIGGER_TIMER3:
+        return TIM_NUM_3;
+    case ADC_TRIGGER_TIMER4:
+        return TIM_NUM_4;
+    case ADC_TRIGGER_TIMER6:
+        return TIM_NUM_6;
+    case ADC_TRIGGER_TIMER8:
+    case ADC_TRIGGER_TIMER8_TRGO2:
+        return TIM_NUM_8;
+    case ADC_TRIGGER_TIMER15:
+        return TIM_NUM_15;
+    default:
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+static void validate_adc_config(ADC_LL_Config const *config)
+{
+    if (config == nullptr || config->buffer_size == 0 ||
+        config->output_buffer == nullptr) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (config->circular && (config->buffer_size % 4) != 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    uint32_t const burst = config->dma.burst_length;
+    if (burst > ADC_LL_DMA_BURST_MAX || (burst & (burst - 1)) != 0 ||
+        config->dma.priority > ADC_LL_DMA_PRIORITY_HIGH ||
+        config->dma.ports > ADC_LL_DMA_PORTS_SPLIT ||
+        config->resolution > ADC_LL_RESOLUTION_8BIT ||
+        config->mode > ADC_LL_MODE_INTERLEAVED) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (config->sequence_length > 1 &&
+        (config->sequence_length > ADC_LL_SEQUENCE_MAX ||
+         config->mode == ADC_LL_MODE_INTERLEAVED ||
+         (config->mode == ADC_LL_MODE_SIMULTANEOUS &&
+          config->sequence_length % 2 != 0) ||
+         config->buffer_size % config->sequence_length != 0)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    validate_oversampling_ratio(config->oversampling_ratio);
+    validate_oversampling_shift(
+        config->oversampling_ratio,
+        config->oversampling_shift,
+        config->resolution
+    );
+    (void)trigger_timer(config->trigger_source);
+
+    if (g_adc_instance.initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+}
+
+/**
+ * @brief Longest sampling time that keeps up with a conversion rate
+ *
+ * @return Sampling time in cycles * 2
+ */
+static uint32_t select_sample_time(
+    ADC_LL_Mode mode,
+    ADC_LL_Resolution resolution,
+    uint32_t conversion_rate
+)
+{
+    uint64_t const adc_clock_hz = mode_clock_hz(mode);
+    if (conversion_rate == 0 || adc_clock_hz == 0) {
+        return SAMPLE_TIME_DEFAULT_2X;
+    }
+
+    for (size_t i = ADC_SAMPLE_TIMES; i > 1; --i) {
+        uint64_t const cycles_2x =
+            g_sample_times_2x[i - 1] + conversion_time_2x(resolution);
+        if ((adc_clock_hz * 2) / cycles_2x >= conversion_rate) {
+            return g_sample_times_2x[i - 1];
+        }
+    }
+    return g_sample_times_2x[0];
+}
+
+/**
+ * @brief Synthetic input of a channel
+ *
+ * @param channel ADC channel
+ * @param time Time of the conversion, in trigger periods
+ * @param half Whether the conversion is half a period late, as ADC2's are
+ *             in interleaved mode
+ * @return Input in 12-bit codes
+ */
+static uint32_t signal_code(ADC_LL_Channel channel, uint64_t time, bool half)
+{
+    uint32_t const rate = NATIVE_tim_get_frequency(g_adc_instance.trigger);
+    if (rate == 0) {
+        return SIGNAL_MID;
+    }
+
+    // Phase in turns of 2^-32, from half trigger periods
+    uint64_t const frequency = (uint64_t)SIGNAL_BASE_HZ * (channel + 1);
+    unsigned __int128 const half_periods = (time * 2) + (half ? 1 : 0);
+    uint32_t const phase =
+        (uint32_t)((half_periods * frequency << 32) / (2 * (uint64_t)rate));
+
+    return (uint32_t)(SIGNAL_MID +
+                      ((FIXED_sin(phase) * SIGNAL_AMPLITUDE) >> 16));
+}
+
+/**
+ * @brief Result of an oversampled conversion, as the data register reads
+ */
+static uint16_t convert(
+    uint32_t code,
+    ADC_LL_Resolution resolution,
+    uint32_t ratio,
+    uint32_t shift
+)
+{
+    uint32_t const sum = (code >> (2 * (uint32_t)resolution)) * ratio;
+    uint32_t const half = shift > 0 ? 1U << (shift - 1) : 0;
+    return (uint16_t)((sum + half) >> shift);
+}
+
+/**
+ * @brief Conversion of a rank on one trigger
+ */
+static uint16_t sample(ADC_LL_Channel channel, uint64_t time, bool half)
+{
+    ADCInstance const *instance = &g_adc_instance;
+    return convert(
+        signal_code(channel, time, half),
+        instance->resolution,
+        instance->oversampling_ratio,
+        instance->oversampling_shift
+    );
+}
+
+/**
+ * @brief Samples written per trigger
+ */
+static uint32_t samples_per_trigger(void)
+{
+    ADCInstance const *instance = &g_adc_instance;
+    if (instance->sequence_length > 1) {
+        return instance->sequence_length;
+    }
+    return instance->mode == ADC_LL_MODE_SINGLE ? 1 : 2;
+}
+
+/**
+ * @brief Write the conversions of one trigger at the DMA position
+ */
+static void convert_trigger(uint64_t time)
+{
+    ADCInstance *instance = &g_adc_instance;
+    uint16_t out[ADC_LL_SEQUENCE_MAX];
+
+    if (instance->sequence_length > 1) {
+        // Simultaneous scans pair up ranks 2k and 2k + 1, like single scans
+        for (uint32_t i = 0; i < instance->sequence_length; ++i) {
+            out[i] = sample(instance->sequence[i], time, false);
+        }
+    } else if (instance->mode == ADC_LL_MODE_SINGLE) {
+        out[0] = sample(instance->channels[0], time, false);
+    } else if (instance->mode == ADC_LL_MODE_SIMULTANEOUS) {
+        out[0] = sample(instance->channels[0], time, false);
+        out[1] = sample(instance->channels[1], time, false);
+    } else {
+        out[0] = sample(instance->channels[0], time, false);
+        out[1] = sample(instance->channels[0], time, true);
+    }
+
+    if (instance->watchdog_armed &&
+        (out[0] < instance->watchdog_low || out[0] > instance->watchdog_high)) {
+        // Each arming produces a single event
+        instance->watchdog_armed = false;
+        if (instance->watchdog_callback != nullptr) {
+            instance->watchdog_callback();
+        }
+    }
+
+    // The DMA stops at the end of the buffer, even within a pair
+    uint32_t count = samples_per_trigger();
+    if (count > instance->buffer_size - instance->position) {
+        count = instance->buffer_size - instance->position;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        instance->buffer_data[instance->position + i] = out[i];
+    }
+    instance->position += count;
+}
+
+/**
+ * @brief Report a filled buffer half or a finished buffer
+ *
+ * @return false if conversions have stopped
+ */
+static bool notify_progress(uint32_t previous)
+{
+    ADCInstance *instance = &g_adc_instance;
+    uint32_t const half = instance->buffer_size / 2;
+
+    if (instance->circular && previous < half && instance->position >= half &&
+        instance->half_complete_callback != nullptr) {
+        instance->half_complete_callback(instance->buffer_data, half);
+    }
+    if (instance->position < instance->buffer_size) {
+        return true;
+    }
+
+    if (instance->circular) {
+        instance->position = 0;
+        if (instance->complete_callback != nullptr) {
+            instance->complete_callback(instance->buffer_data + half, half);
+        }
+        return true;
+    }
+
+    instance->running = false;
+    if (instance->complete_callback != nullptr) {
+        uint32_t const total_samples = instance->mode == ADC_LL_MODE_SINGLE
+                                           ? instance->buffer_size
+                                           : instance->buffer_size * 2;
+        instance->complete_callback(instance->buffer_data, total_samples);
+    }
+    return false;
+}
+
+/**
+ * @brief Finish a pending injected measurement
+ */
+static void convert_injected(void)
+{
+    InjectedMonitor *monitor = &g_injected;
+    if (!monitor->busy) {
+        return;
+    }
+
+    // Converted at the time it was started, from the trigger's point of view
+    uint16_t const value = convert(
+        signal_code(
+            monitor->channel,
+            NATIVE_tim_get_updates(g_adc_instance.trigger),
+            false
+        ),
+        g_adc_instance.resolution,
+        monitor->oversampling_ratio,
+        monitor->oversampling_shift
+    );
+    monitor->busy = false;
+    if (monitor->callback != nullptr) {
+        monitor->callback(value);
+    }
+}
+
+/**
+ * @brief Schedule a handler pass for the next buffer callback
+ */
+static void schedule_next_callback(uint64_t now_us)
+{
+    ADCInstance const *instance = &g_adc_instance;
+    uint32_t const rate = NATIVE_tim_get_frequency(instance->trigger);
+    if (rate == 0) {
+        return;
+    }
+
+    uint32_t const half = instance->buffer_size / 2;
+    uint32_t const boundary = instance->circular && instance->position < half
+                                  ? half
+                                  : instance->buffer_size;
+    uint32_t const per_trigger = samples_per_trigger();
+    uint64_t const triggers =
+        (boundary - instance->position + per_trigger - 1) / per_trigger;
+    NATIVE_schedule(now_us + ((triggers * SI_MEGA_INT) / rate));
+}
+
+/**
+ * @brief Emulated DMA and ADC interrupts
+ */
+static void adc_handler(uint64_t now_us)
+{
+    ADCInstance *instance = &g_adc_instance;
+
+    convert_injected();
+    if (!instance->running) {
+        return;
+    }
+
+    uint64_t const updates = NATIVE_tim_get_updates(instance->trigger);
+    uint64_t const triggers = instance->buffer_size / samples_per_trigger();
+    if (updates - instance->updates > triggers) {
+        // Fell behind by more than a buffer, which the target does not do
+        uint64_t const lost = updates - instance->updates - triggers;
+        g_error_counters.overruns += (uint32_t)lost;
+        instance->updates += lost;
+    }
+
+    while (instance->running && instance->updates < updates) {
+        uint32_t const previous = instance->position;
+        convert_trigger(instance->updates);
+        instance->updates += 1;
+        if (!notify_progress(previous)) {
+            break;
+        }
+        if (!NATIVE_tim_is_running(instance->trigger)) {
+            // Stopped from a callback, at a time the triggers still to be
+            // caught up on had not come yet; on the target they never do
+            instance->updates = updates;
+            break;
+        }
+    }
+
+    if (instance->running) {
+        schedule_next_callback(now_us);
+    }
+}
+
+void ADC_LL_init(ADC_LL_Config const *config)
+{
+    validate_adc_config(config);
+
+    ADCInstance *instance = &g_adc_instance;
+    instance->channels[0] = config->channels[0];
+    instance->channels[1] = config->mode == ADC_LL_MODE_SIMULTANEOUS
+                                ? config->channels[1]
+                                : ADC_LL_CHANNEL_1;
+    instance->sequence_length = 1;
+    if (config->sequence_length > 1) {
+        for (uint32_t i = 0; i < config->sequence_length; ++i) {
+            instance->sequence[i] = config->sequence[i];
+        }
+        instance->sequence_length = config->sequence_length;
+        instance->channels[0] = config->sequence[0];
+    }
+    instance->buffer_data = config->output_buffer;
+    instance->buffer_size = config->buffer_size;
+    instance->mode = config->mode;
+    instance->trigger = trigger_timer(config->trigger_source);
+    instance->oversampling_ratio = config->oversampling_ratio;
+    instance->oversampling_shift = config->oversampling_shift;
+    instance->resolution = config->resolution;
+    PLATFORM_set_adc_clock_divider(g_mode_clocks[config->mode].kernel_divider);
+    instance->sample_time_2x = select_sample_time(
+        config->mode, config->resolution, config->conversion_rate
+    );
+    instance->prescaler = g_mode_clocks[config->mode].prescaler;
+    instance->circular = config->circular;
+    instance->running = false;
+    instance->position = 0;
+
+    NATIVE_add_handler(adc_handler);
+    instance->initialized = true;
+}
+
+bool ADC_LL_is_initialized(void) { return g_adc_instance.initialized; }
+
+void ADC_LL_deinit(void)
+{
+    if (!g_adc_instance.initialized) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+
+    ADC_LL_injected_deinit();
+    NATIVE_remove_handler(adc_handler);
+
+    ADCInstance *instance = &g_adc_instance;
+    instance->buffer_data = nullptr;
+    instance->buffer_size = 0;
+    instance->channels[0] = ADC_LL_CHANNEL_0;
+    instance->channels[1] = ADC_LL_CHANNEL_0;
+    instance->sequence_length = 1;
+    instance->complete_callback = nullptr;
+    instance->half_complete_callback = nullptr;
+    instance->watchdog_callback = nullptr;
+    instance->mode = ADC_LL_MODE_SINGLE;
+    instance->oversampling_ratio = 1;
+    instance->oversampling_shift = 0;
+    instance->resolution = ADC_LL_RESOLUTION_12BIT;
+    instance->sample_time_2x = SAMPLE_TIME_DEFAULT_2X;
+    instance->prescaler = 1;
+    instance->circular = false;
+    instance->running = false;
+    instance->watchdog_armed = false;
+    instance->initialized = false;
+}
+
+Error ADC_LL_try_start(void)
+{
+    ADCInstance *instance = &g_adc_instance;
+    if (!instance->initialized) {
+        return ERROR_RESOURCE_UNAVAILABLE;
+    }
+
+    // Conversions start with the next trigger
+    instance->updates = NATIVE_tim_get_updates(instance->trigger);
+    instance->position = 0;
+    instance->running = true;
+    return ERROR_NONE;
+}
+
+void ADC_LL_start(void)
+{
+    Error const error = ADC_LL_try_start();
+    if (error != ERROR_NONE) {
+        THROW(error);
+    }
+}
+
+void ADC_LL_stop(void)
+{
+    if (!g_adc_instance.initialized) {
+        return;
+    }
+
+    ADC_LL_disarm_watchdog();
+    g_adc_instance.running = false;
+}
+
+Error ADC_LL_try_restart(uint16_t *buffer, uint32_t buffer_size)
+{
+    if (!g_adc_instance.initialized) {
+        return ERROR_RESOURCE_UNAVAILABLE;
+    }
+    if (buffer == nullptr || buffer_size == 0 ||
+        (g_adc_instance.circular && (buffer_size % 4) != 0)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    ADC_LL_stop();
+    g_adc_instance.buffer_data = buffer;
+    g_adc_instance.buffer_size = buffer_size;
+    return ADC_LL_try_start();
+}
+
+void ADC_LL_restart(uint16_t *buffer, uint32_t buffer_size)
+{
+    Error const error = ADC_LL_try_restart(buffer, buffer_size);
+    if (error != ERROR_NONE) {
+        THROW(error);
+    }
+}
+
+void ADC_LL_set_output_buffer(uint16_t *buffer, uint32_t buffer_size)
+{
+    if (!g_adc_instance.initialized) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+    if (buffer == nullptr || buffer_size == 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    // Each buffer half must hold a whole number of (32-bit) DMA transfers
+    if (g_adc_instance.circular && (buffer_size % 4) != 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    g_adc_instance.buffer_data = buffer;
+    g_adc_instance.buffer_size = buffer_size;
+}
+
+void ADC_LL_set_complete_callback(ADC_LL_CompleteCallback callback)
+{
+    g_adc_instance.complete_callback = callback;
+}
+
+void ADC_LL_set_half_complete_callback(ADC_LL_CompleteCallback callback)
+{
+    g_adc_instance.half_complete_callback = callback;
+}
+
+void ADC_LL_set_watchdog_callback(ADC_LL_WatchdogCallback callback)
+{
+    g_adc_instance.watchdog_callback = callback;
+}
+
+void ADC_LL_arm_watchdog(uint16_t low, uint16_t high)
+{
+    if (!g_adc_instance.initialized) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+
+    g_adc_instance.watchdog_low = low > ADC_THRESHOLD_MAX ? ADC_THRESHOLD_MAX
+                                                          : low;
+    g_adc_instance.watchdog_high = high > ADC_THRESHOLD_MAX ? ADC_THRESHOLD_MAX
+                                                            : high;
+    g_adc_instance.watchdog_armed = true;
+}
+
+void ADC_LL_disarm_watchdog(void) { g_adc_instance.watchdog_armed = false; }
+
+void ADC_LL_injected_init(
+    ADC_LL_Channel channel,
+    uint32_t oversampling_ratio,
+    uint32_t oversampling_shift
+)
+{
+    if (!g_adc_instance.initialized) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+    if (g_injected.initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+    if (channel > ADC_LL_CHANNEL_15) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    validate_oversampling_ratio(oversampling_ratio);
+    validate_oversampling_shift(
+        oversampling_ratio, oversampling_shift, g_adc_instance.resolution
+    );
+
+    g_injected.channel = channel;
+    g_injected.oversampling_ratio = oversampling_ratio;
+    g_injected.oversampling_shift = oversampling_shift;
+    g_injected.busy = false;
+    g_injected.initialized = true;
+}
+
+void ADC_LL_injected_deinit(void)
+{
+    if (!g_injected.initialized) {
+        return;
+    }
+
+    g_injected.callback = nullptr;
+    g_injected.oversampling_ratio = 1;
+    g_injected.oversampling_shift = 0;
+    g_injected.busy = false;
+    g_injected.initialized = false;
+}
+
+Error ADC_LL_try_injected_start(void)
+{
+    if (!g_injected.initialized) {
+        return ERROR_RESOURCE_UNAVAILABLE;
+    }
+    if (g_injected.busy) {
+        return ERROR_RESOURCE_BUSY;
+    }
+
+    // The result is reported from the next handler pass
+    g_injected.busy = true;
+    NATIVE_request_service();
+    return ERROR_NONE;
+}
+
+void ADC_LL_injected_start(void)
+{
+    Error const error = ADC_LL_try_injected_start();
+    if (error != ERROR_NONE) {
+        THROW(error);
+    }
+}
+
+void ADC_LL_set_injected_callback(ADC_LL_InjectedCallback callback)
+{
+    g_injected.callback = callback;
+}
+
+void ADC_LL_track_reference(void)
+{
+    // The simulated reference does not drift
+}
+
+uint32_t ADC_LL_get_dma_position(void)
+{
+    if (!g_adc_instance.initialized ||
+        g_adc_instance.position >= g_adc_instance.buffer_size) {
+        return 0;
+    }
+    return g_adc_instance.position;
+}
+
+ADC_LL_ErrorCounters ADC_LL_get_error_counters(void)
+{
+    return g_error_counters;
+}
+
+ADC_LL_Mode ADC_LL_get_mode(void)
+{
+    if (g_adc_instance.initialized) {
+        return g_adc_instance.mode;
+    }
+    return ADC_LL_MODE_SINGLE;
+}
+
+ADC_LL_TriggerSource ADC_LL_get_timer_trigger(TIM_Num tim)
+{
+    switch (tim) {
+    case TIM_NUM_1:
+        return ADC_TRIGGER_TIMER1;
+    case TIM_NUM_2:
+        return ADC_TRIGGER_TIMER2;
+    case TIM_NUM_3:
+        return ADC_TRIGGER_TIMER3;
+    case TIM_NUM_4:
+        return ADC_TRIGGER_TIMER4;
+    case TIM_NUM_6:
+        return ADC_TRIGGER_TIMER6;
+    case TIM_NUM_8:
+        return ADC_TRIGGER_TIMER8;
+    case TIM_NUM_15:
+        return ADC_TRIGGER_TIMER15;
+    default:
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+uint32_t ADC_LL_get_sample_rate(void)
+{
+    if (!g_adc_instance.initialized) {
+        return 0;
+    }
+
+    uint32_t const adc_clock_hz =
+        PLATFORM_get_peripheral_clock_speed(PLATFORM_CLOCK_ADC1) /
+        g_adc_instance.prescaler;
+    uint32_t const total_cycles =
+        (g_adc_instance.sample_time_2x +
+         conversion_time_2x(g_adc_instance.resolution)) /
+        2;
+    return adc_clock_hz / total_cycles;
+}
+
+/**
+ * @brief Sampling time in nanoseconds
+ */
+static uint32_t sample_time_ns(uint64_t adc_clock_hz, uint32_t sample_time_2x)
+{
+    if (adc_clock_hz == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)sample_time_2x * SI_GIGA_INT) /
+                      (adc_clock_hz * 2));
+}
+
+uint32_t ADC_LL_get_sample_time_ns(void)
+{
+    if (!g_adc_instance.initialized) {
+        return 0;
+    }
+    return sample_time_ns(
+        PLATFORM_get_peripheral_clock_speed(PLATFORM_CLOCK_ADC1) /
+            g_adc_instance.prescaler,
+        g_adc_instance.sample_time_2x
+    );
+}
+
+uint32_t ADC_LL_select_sample_time_ns(
+    ADC_LL_Mode mode,
+    ADC_LL_Resolution resolution,
+    uint32_t conversion_rate
+)
+{
+    if (mode > ADC_LL_MODE_INTERLEAVED) {
+        return 0;
+    }
+    return sample_time_ns(
+        mode_clock_hz(mode),
+        select_sample_time(mode, resolution, conversion_rate)
+    );
+}
+
+void ADC_LL_set_clock(ADC_LL_Mode mode, ADC_LL_Clock const *clock)
+{
+    if (mode > ADC_LL_MODE_INTERLEAVED || clock == nullptr ||
+        clock->kernel_divider < PLATFORM_ADC_CLOCK_DIVIDER_MIN ||
+        clock->kernel_divider > PLATFORM_ADC_CLOCK_DIVIDER_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    for (size_t i = 0; i < sizeof(g_prescalers) / sizeof(g_prescalers[0]);
+         ++i) {
+        if (clock->prescaler == g_prescalers[i]) {
+            g_mode_clocks[mode] = *clock;
+            return;
+        }
+    }
+    THROW(ERROR_INVALID_ARGUMENT);
+}
+
+ADC_LL_Clock ADC_LL_get_clock(ADC_LL_Mode mode)
+{
+    if (mode > ADC_LL_MODE_INTERLEAVED) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    return g_mode_clocks[mode];
+}
+
+uint32_t ADC_LL_get_reference_voltage(void)
+{
+    return g_adc_instance.initialized ? ADC_VREF_MV : 0;
+}
+
+uint32_t ADC_LL_get_max_sample_rate(
+    ADC_LL_Mode mode,
+    ADC_LL_Resolution resolution
+)
+{
+    uint32_t const max_single_channel = 5000000; // 5 MHz at 12 bits, 75 MHz
+    uint32_t const max_dual_channel = 10000000; // 10 MHz at 12 bits, 75 MHz
+    uint64_t max_rate = 0;
+    switch (mode) {
+    case ADC_LL_MODE_SINGLE:
+    case ADC_LL_MODE_SIMULTANEOUS:
+        max_rate = max_single_channel;
+        break;
+    case ADC_LL_MODE_INTERLEAVED:
+        max_rate = max_dual_channel;
+        break;
+    default:
+        return 0;
+    }
+
+    if (resolution > ADC_LL_RESOLUTION_8BIT) {
+        return 0;
+    }
+
+    // The rated figures hold at the fastest conversion clock
+    max_rate = (max_rate * mode_clock_hz(mode)) /
+               (PLATFORM_ADC_CLOCK_SOURCE_HZ / PLATFORM_ADC_CLOCK_DIVIDER_MIN);
+
+    uint32_t const full_cycles_2x =
+        g_sample_times_2x[0] + conversion_time_2x(ADC_LL_RESOLUTION_12BIT);
+    uint32_t const cycles_2x =
+        g_sample_times_2x[0] + conversion_time_2x(resolution);
+    return (uint32_t)((max_rate * full_cycles_2x) / cycles_2x);
+}
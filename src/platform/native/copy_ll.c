@@ -0,0 +1,40 @@
+/**
+ * @file copy_ll.c
+ * @brief Native memory copies
+ *
+ * Copies are made all at once when started, and their callback is called
+ * before COPY_LL_start returns, so the engine is never seen busy.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "util/error.h"
+
+#include "copy_ll.h"
+
+void COPY_LL_start(
+    void *dst,
+    void const *src,
+    uint32_t size,
+    COPY_LL_Callback callback,
+    void *context
+)
+{
+    if (dst == nullptr || src == nullptr || size == 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    memcpy(dst, src, size);
+    if (callback != nullptr) {
+        callback(context, true);
+    }
+}
+
+bool COPY_LL_busy(void) { return false; }
+
+void COPY_LL_abort(void) {}
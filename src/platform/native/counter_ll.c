@@ -0,0 +1,143 @@
+/**
+ * @file counter_ll.c
+ * @brief Native input capture for the frequency counter
+ *
+ * The input is a 1 kHz square wave, counted in ticks of the TIM5 clock as
+ * on the target, so that the counter always has a signal to measure.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/error.h"
+#include "util/si_prefix.h"
+
+#include "counter_ll.h"
+#include "native.h"
+#include "platform.h"
+
+enum {
+    COUNTER_SIGNAL_FREQUENCY = SI_KILO_INT, // Hz, of the emulated input
+};
+
+typedef struct {
+    uint32_t prescaler; // Edges per capture
+    uint64_t start; // Ticks at COUNTER_LL_start
+    uint64_t end; // Ticks at COUNTER_LL_stop
+    bool running;
+    bool armed; // Started since COUNTER_LL_init, else the span is empty
+    bool initialized;
+} CounterInstance;
+
+static CounterInstance g_counter_instance = { 0 };
+
+/**
+ * @brief TIM5 ticks since PLATFORM_init
+ */
+static uint64_t get_ticks(void)
+{
+    uint32_t const clock =
+        PLATFORM_get_peripheral_clock_speed(PLATFORM_CLOCK_TIMER5);
+    return (uint64_t)(((unsigned __int128)NATIVE_get_time_us() * clock) /
+                      SI_MEGA_INT);
+}
+
+/**
+ * @brief TIM5 ticks between rising edges of the input
+ */
+static uint64_t get_edge_period(void)
+{
+    return PLATFORM_get_peripheral_clock_speed(PLATFORM_CLOCK_TIMER5) /
+           COUNTER_SIGNAL_FREQUENCY;
+}
+
+void COUNTER_LL_init(uint32_t prescaler)
+{
+    if (prescaler != 1 && prescaler != 2 && prescaler != 4 &&
+        prescaler != COUNTER_LL_PRESCALER_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_counter_instance.initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    g_counter_instance.prescaler = prescaler;
+    g_counter_instance.running = false;
+    g_counter_instance.armed = false;
+    g_counter_instance.initialized = true;
+}
+
+void COUNTER_LL_deinit(void)
+{
+    if (!g_counter_instance.initialized) {
+        return;
+    }
+
+    COUNTER_LL_stop();
+    g_counter_instance.armed = false;
+    g_counter_instance.initialized = false;
+}
+
+void COUNTER_LL_start(void)
+{
+    CounterInstance *const instance = &g_counter_instance;
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    instance->start = get_ticks();
+    instance->armed = true;
+    instance->running = true;
+}
+
+void COUNTER_LL_stop(void)
+{
+    CounterInstance *const instance = &g_counter_instance;
+
+    if (!instance->initialized || !instance->running) {
+        return;
+    }
+
+    instance->end = get_ticks();
+    instance->running = false;
+}
+
+uint32_t COUNTER_LL_get_clock(void)
+{
+    if (!g_counter_instance.initialized) {
+        return 0;
+    }
+    return PLATFORM_get_peripheral_clock_speed(PLATFORM_CLOCK_TIMER5);
+}
+
+uint32_t COUNTER_LL_get_time(void) { return (uint32_t)get_ticks(); }
+
+void COUNTER_LL_get_span(COUNTER_LL_Span *span)
+{
+    CounterInstance const *const instance = &g_counter_instance;
+
+    *span = (COUNTER_LL_Span){ 0 };
+    if (!instance->armed) {
+        return;
+    }
+
+    // Edges fall on whole periods of the input
+    uint64_t const period = get_edge_period();
+    uint64_t const end = instance->running ? get_ticks() : instance->end;
+    uint64_t const first_edge = instance->start / period + 1;
+    uint64_t const edges = end / period - instance->start / period;
+    uint64_t const captures = edges / instance->prescaler;
+
+    span->captures = (uint32_t)captures;
+    if (captures > 0) {
+        span->first =
+            (uint32_t)((first_edge + instance->prescaler - 1) * period);
+        span->last = (uint32_t)((first_edge +
+                                 (captures * instance->prescaler) - 1) *
+                                period);
+    }
+}
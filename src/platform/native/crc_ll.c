@@ -0,0 +1,55 @@
+/**
+ * @file crc_ll.c
+ * @brief Native CRC unit
+ *
+ * Checksums are computed in software, all at once when started, so they
+ * are done by the time CRC_LL_done is first asked.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/crc.h"
+#include "util/error.h"
+
+#include "crc_ll.h"
+
+static struct {
+    bool busy;
+    uint32_t result;
+} g_crc = { .busy = false };
+
+void CRC_LL_start(
+    CRC_LL_Polynomial polynomial,
+    uint32_t crc,
+    void const *data,
+    uint32_t size
+)
+{
+    if (g_crc.busy) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+    if (data == nullptr || size == 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    g_crc.result = polynomial == CRC_LL_CRC16
+                       ? CRC16_update((uint16_t)crc, data, size)
+                       : CRC32_update(crc, data, size);
+    g_crc.busy = true;
+}
+
+bool CRC_LL_busy(void) { return g_crc.busy; }
+
+bool CRC_LL_done(void) { return g_crc.busy; }
+
+uint32_t CRC_LL_result(void)
+{
+    g_crc.busy = false;
+    return g_crc.result;
+}
+
+void CRC_LL_abort(void) { g_crc.busy = false; }
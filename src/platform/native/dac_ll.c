@@ -0,0 +1,133 @@
+/**
+ * @file dac_ll.c
+ * @brief Native timer-paced output
+ *
+ * The codes go nowhere. The emulated DMA moves one code per update of the
+ * pacing timer, so a streamed output is asked for its blocks at the rate of
+ * the target.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/error.h"
+#include "util/si_prefix.h"
+
+#include "dac_ll.h"
+#include "native.h"
+#include "tim_ll.h"
+
+typedef struct {
+    DAC_LL_Config config;
+    uint64_t updates; // Timer updates played so far
+    uint32_t position; // Next code of the table
+    bool initialized;
+    bool running;
+} DACInstance;
+
+static DACInstance g_dac_instance = { 0 };
+
+// Timers with a DAC trigger, in TIM_Num order; TIM3 has none
+static bool const g_triggers[TIM_NUM_COUNT] = {
+    [TIM_NUM_6] = true,  [TIM_NUM_7] = true, [TIM_NUM_1] = true,
+    [TIM_NUM_2] = true,  [TIM_NUM_4] = true, [TIM_NUM_8] = true,
+    [TIM_NUM_15] = true,
+};
+
+/**
+ * @brief Emulated DMA interrupt, at the end of each half of the ring
+ */
+static void dac_handler(uint64_t now_us)
+{
+    DACInstance *const instance = &g_dac_instance;
+    DAC_LL_Config const *const config = &instance->config;
+
+    if (!instance->running || !config->block_callback) {
+        return;
+    }
+
+    uint32_t const half = config->count / 2;
+    uint64_t const updates = NATIVE_tim_get_updates(config->timer);
+    while (instance->running && instance->updates < updates) {
+        uint64_t const step = updates - instance->updates;
+        uint32_t const boundary =
+            instance->position < half ? half : config->count;
+        if (step < boundary - instance->position) {
+            instance->position += (uint32_t)step;
+            instance->updates = updates;
+            break;
+        }
+
+        instance->updates += boundary - instance->position;
+        uint32_t const first = boundary - half;
+        instance->position = boundary % config->count;
+        config->block_callback(&config->samples[first], half);
+    }
+
+    uint32_t const rate = NATIVE_tim_get_frequency(config->timer);
+    if (instance->running && rate != 0) {
+        uint32_t const boundary =
+            instance->position < half ? half : config->count;
+        uint64_t const left = boundary - instance->position;
+        NATIVE_schedule(now_us + ((left * SI_MEGA_INT) / rate));
+    }
+}
+
+void DAC_LL_init(DAC_LL_Config const *config)
+{
+    if (!config || !config->samples || config->count == 0 ||
+        config->count > DAC_LL_SAMPLES_MAX ||
+        config->timer >= TIM_NUM_COUNT || !g_triggers[config->timer]) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (config->block_callback && config->count % 2 != 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_dac_instance.initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    NATIVE_add_handler(dac_handler);
+    g_dac_instance.config = *config;
+    g_dac_instance.initialized = true;
+}
+
+void DAC_LL_deinit(void)
+{
+    if (!g_dac_instance.initialized) {
+        return;
+    }
+
+    DAC_LL_stop();
+    NATIVE_remove_handler(dac_handler);
+    g_dac_instance.initialized = false;
+}
+
+void DAC_LL_start(void)
+{
+    DACInstance *const instance = &g_dac_instance;
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+    if (instance->running) {
+        return;
+    }
+
+    instance->updates = NATIVE_tim_get_updates(instance->config.timer);
+    instance->position = 0;
+    instance->running = true;
+    NATIVE_request_service();
+}
+
+void DAC_LL_stop(void)
+{
+    if (!g_dac_instance.initialized) {
+        return;
+    }
+
+    g_dac_instance.running = false;
+}
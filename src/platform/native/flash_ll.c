@@ -0,0 +1,223 @@
+/**
+ * @file flash_ll.c
+ * @brief Native storage sector and update area
+ *
+ * Both live in memory, erased to 0xFF like flash. With the
+ * PSLAB_NATIVE_FLASH environment variable set to a file name, the storage
+ * sector and the key-value store sectors are kept in that file, so that
+ * stored settings survive restarts and PLATFORM_reset, which starts a new
+ * process.
+ *
+ * Programming enforces the rules of the target: whole quad-words, into
+ * erased flash only.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/error.h"
+
+#include "flash_ll.h"
+
+enum { FLASH_ERASED = 0xFF };
+
+static struct {
+    bool loaded;
+    uint8_t storage[FLASH_LL_STORAGE_SIZE];
+    uint8_t kv[FLASH_LL_KV_SIZE];
+    uint8_t update[FLASH_LL_UPDATE_SIZE];
+} g_flash = { .loaded = false };
+
+/**
+ * @brief File holding the storage and key-value sectors, or nullptr to keep
+ *        them in memory
+ */
+static char const *storage_path(void)
+{
+    char const *const path = getenv("PSLAB_NATIVE_FLASH");
+    return path != nullptr && path[0] != '\0' ? path : nullptr;
+}
+
+/**
+ * @brief Erase all areas, then read the persistent ones from their file
+ */
+static void load(void)
+{
+    if (g_flash.loaded) {
+        return;
+    }
+    g_flash.loaded = true;
+    memset(g_flash.storage, FLASH_ERASED, sizeof(g_flash.storage));
+    memset(g_flash.kv, FLASH_ERASED, sizeof(g_flash.kv));
+    memset(g_flash.update, FLASH_ERASED, sizeof(g_flash.update));
+
+    char const *const path = storage_path();
+    FILE *const file = path != nullptr ? fopen(path, "rb") : nullptr;
+    if (file != nullptr) {
+        // A short file leaves the rest erased
+        if (fread(g_flash.storage, 1, sizeof(g_flash.storage), file) ==
+            sizeof(g_flash.storage)) {
+            (void)fread(g_flash.kv, 1, sizeof(g_flash.kv), file);
+        }
+        fclose(file);
+    }
+}
+
+/**
+ * @brief Write the storage and key-value sectors back to their file
+ *
+ * @throws ERROR_HARDWARE_FAULT if the file cannot be written
+ */
+static void save(void)
+{
+    char const *const path = storage_path();
+    if (path == nullptr) {
+        return;
+    }
+
+    FILE *const file = fopen(path, "wb");
+    if (file == nullptr) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    size_t written =
+        fwrite(g_flash.storage, 1, sizeof(g_flash.storage), file);
+    written += fwrite(g_flash.kv, 1, sizeof(g_flash.kv), file);
+    if (fclose(file) != 0 ||
+        written != sizeof(g_flash.storage) + sizeof(g_flash.kv)) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
+static bool range_is_valid(uint32_t offset, uint32_t size, uint32_t area_size)
+{
+    return offset <= area_size && size <= area_size - offset;
+}
+
+static bool write_is_aligned(uint32_t offset, void const *data, uint32_t size)
+{
+    return data && ((uintptr_t)data % sizeof(uint32_t)) == 0 &&
+           (offset % FLASH_LL_WRITE_ALIGN) == 0 &&
+           (size % FLASH_LL_WRITE_ALIGN) == 0;
+}
+
+/**
+ * @brief Program erased flash
+ *
+ * @throws ERROR_HARDWARE_FAULT if the range is not erased
+ */
+static void program(uint8_t *dst, void const *data, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; ++i) {
+        if (dst[i] != FLASH_ERASED) {
+            THROW(ERROR_HARDWARE_FAULT);
+        }
+    }
+    memcpy(dst, data, size);
+}
+
+void FLASH_LL_read(uint32_t offset, void *data, uint32_t size)
+{
+    if (!data || !range_is_valid(offset, size, FLASH_LL_STORAGE_SIZE)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    load();
+    memcpy(data, &g_flash.storage[offset], size);
+}
+
+void FLASH_LL_erase(void)
+{
+    load();
+    memset(g_flash.storage, FLASH_ERASED, sizeof(g_flash.storage));
+    save();
+}
+
+void FLASH_LL_write(uint32_t offset, void const *data, uint32_t size)
+{
+    if (!write_is_aligned(offset, data, size) ||
+        !range_is_valid(offset, size, FLASH_LL_STORAGE_SIZE)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    load();
+    program(&g_flash.storage[offset], data, size);
+    save();
+}
+
+void FLASH_LL_kv_read(uint32_t offset, void *data, uint32_t size)
+{
+    if (!data || !range_is_valid(offset, size, FLASH_LL_KV_SIZE)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    load();
+    memcpy(data, &g_flash.kv[offset], size);
+}
+
+void FLASH_LL_kv_erase(uint32_t offset)
+{
+    if ((offset % FLASH_LL_SECTOR_SIZE) != 0 ||
+        !range_is_valid(offset, FLASH_LL_SECTOR_SIZE, FLASH_LL_KV_SIZE)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    load();
+    memset(&g_flash.kv[offset], FLASH_ERASED, FLASH_LL_SECTOR_SIZE);
+    save();
+}
+
+void FLASH_LL_kv_write(uint32_t offset, void const *data, uint32_t size)
+{
+    if (!write_is_aligned(offset, data, size) ||
+        !range_is_valid(offset, size, FLASH_LL_KV_SIZE)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    load();
+    program(&g_flash.kv[offset], data, size);
+    save();
+}
+
+void FLASH_LL_update_read(uint32_t offset, void *data, uint32_t size)
+{
+    if (!data || !range_is_valid(offset, size, FLASH_LL_UPDATE_SIZE)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    load();
+    memcpy(data, &g_flash.update[offset], size);
+}
+
+void FLASH_LL_update_erase(uint32_t offset)
+{
+    if ((offset % FLASH_LL_SECTOR_SIZE) != 0 ||
+        !range_is_valid(offset, FLASH_LL_SECTOR_SIZE, FLASH_LL_UPDATE_SIZE)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    load();
+    memset(&g_flash.update[offset], FLASH_ERASED, FLASH_LL_SECTOR_SIZE);
+}
+
+void FLASH_LL_update_write(uint32_t offset, void const *data, uint32_t size)
+{
+    if (!write_is_aligned(offset, data, size) ||
+        !range_is_valid(offset, size, FLASH_LL_UPDATE_SIZE)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    load();
+    program(&g_flash.update[offset], data, size);
+}
+
+void FLASH_LL_request_bank_swap(void)
+{
+    // There is no second bank to boot; the running image stays
+    fprintf(stderr, "flash: bank swap requested, ignored\n");
+}
@@ -0,0 +1,161 @@
+/**
+ * @file i2c_ll.c
+ * @brief Native I2C bus, with no targets on it
+ *
+ * Every transfer ends with a NACK of the address, after the time the
+ * start condition and the address byte take on the bus, as on a board
+ * with nothing connected.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/error.h"
+#include "util/si_prefix.h"
+
+#include "i2c_ll.h"
+#include "native.h"
+
+enum {
+    ADDRESS_PHASE_BITS = 1 + 9 + 1, // Start, address with ACK bit, stop
+};
+
+typedef struct {
+    bool initialized;
+    bool busy;
+    uint32_t speed;
+    uint64_t done_us; // End of the transfer in progress
+    I2C_LL_CompleteCallback complete_callback;
+} I2CInstance;
+
+static I2CInstance g_i2c_instances[I2C_BUS_COUNT] = { 0 };
+
+/**
+ * @brief Emulated I2C event interrupt
+ */
+static void i2c_handler(uint64_t now_us)
+{
+    for (size_t i = 0; i < I2C_BUS_COUNT; ++i) {
+        I2CInstance *instance = &g_i2c_instances[i];
+        if (!instance->busy) {
+            continue;
+        }
+        if (now_us < instance->done_us) {
+            NATIVE_schedule(instance->done_us);
+            continue;
+        }
+
+        instance->busy = false;
+        if (instance->complete_callback != nullptr) {
+            instance->complete_callback((I2C_Bus)i, I2C_LL_STATUS_NACK);
+        }
+    }
+}
+
+void I2C_LL_init(I2C_Bus bus)
+{
+    if (bus >= I2C_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    I2CInstance *instance = &g_i2c_instances[bus];
+
+    if (instance->initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    NATIVE_add_handler(i2c_handler);
+    instance->speed = I2C_LL_SPEED_DEFAULT;
+    instance->busy = false;
+    instance->initialized = true;
+}
+
+void I2C_LL_deinit(I2C_Bus bus)
+{
+    if (bus >= I2C_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    I2CInstance *instance = &g_i2c_instances[bus];
+
+    if (!instance->initialized) {
+        return;
+    }
+
+    // Stops without calling back
+    NATIVE_remove_handler(i2c_handler);
+    instance->busy = false;
+    instance->complete_callback = nullptr;
+    instance->speed = 0;
+    instance->initialized = false;
+}
+
+void I2C_LL_set_speed(I2C_Bus bus, uint32_t speed)
+{
+    if (bus >= I2C_BUS_COUNT || speed < I2C_LL_SPEED_MIN ||
+        speed > I2C_LL_SPEED_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    I2CInstance *instance = &g_i2c_instances[bus];
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (instance->busy) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    instance->speed = speed;
+}
+
+void I2C_LL_start(I2C_Bus bus, I2C_LL_Transfer const *transfer)
+{
+    if (bus >= I2C_BUS_COUNT || !transfer || !transfer->data ||
+        transfer->size == 0 || transfer->size > I2C_LL_TRANSFER_MAX ||
+        transfer->address > I2C_LL_ADDRESS_MAX || transfer->reg_size > 2) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    I2CInstance *instance = &g_i2c_instances[bus];
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (instance->busy) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    instance->busy = true;
+    instance->done_us =
+        NATIVE_get_time_us() +
+        ((ADDRESS_PHASE_BITS * SI_MEGA_INT) + instance->speed - 1) /
+            instance->speed;
+    NATIVE_schedule(instance->done_us);
+}
+
+bool I2C_LL_busy(I2C_Bus bus)
+{
+    if (bus >= I2C_BUS_COUNT || !g_i2c_instances[bus].initialized) {
+        return false;
+    }
+
+    return g_i2c_instances[bus].busy;
+}
+
+void I2C_LL_set_complete_callback(
+    I2C_Bus bus,
+    I2C_LL_CompleteCallback callback
+)
+{
+    if (bus >= I2C_BUS_COUNT) {
+        return;
+    }
+    g_i2c_instances[bus].complete_callback = callback;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file itm_ll.c
+ * @brief Native ITM stimulus ports
+ *
+ * With the PSLAB_NATIVE_SWO environment variable set to a file name, the
+ * packets the SWO pin would carry are appended to that file, so that the
+ * host tools that decode SWO captures also read native runs. Otherwise
+ * writes are taken and dropped. The FIFO never fills.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+// O_CLOEXEC
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "itm_ll.h"
+
+enum {
+    ITM_CHUNK_BYTES = 1024, // Packets built per write to the file
+    ITM_PACKET_MAX = 5, // Header and a word
+    ITM_HEADER_SIZE_1 = 1, // Size codes of the packet header
+    ITM_HEADER_SIZE_4 = 3,
+};
+
+static struct {
+    uint32_t port_mask;
+    int fd; // SWO capture file, -1 if none
+} g_itm = { .port_mask = 0, .fd = -1 };
+
+static void emit(uint8_t const *packets, uint32_t size)
+{
+    uint32_t done = 0;
+    while (g_itm.fd >= 0 && done < size) {
+        ssize_t const count = write(g_itm.fd, &packets[done], size - done);
+        if (count <= 0) {
+            // Drop the capture rather than stall the firmware
+            close(g_itm.fd);
+            g_itm.fd = -1;
+            return;
+        }
+        done += (uint32_t)count;
+    }
+}
+
+void ITM_LL_init(uint32_t baudrate, uint32_t port_mask)
+{
+    (void)baudrate;
+
+    g_itm.port_mask = port_mask;
+    if (g_itm.fd >= 0) {
+        return;
+    }
+    char const *const path = getenv("PSLAB_NATIVE_SWO");
+    if (path != nullptr && path[0] != '\0') {
+        g_itm.fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    }
+}
+
+void ITM_LL_deinit(void)
+{
+    g_itm.port_mask = 0;
+    if (g_itm.fd >= 0) {
+        close(g_itm.fd);
+        g_itm.fd = -1;
+    }
+}
+
+bool ITM_LL_port_enabled(uint32_t port)
+{
+    return port < ITM_LL_PORT_COUNT && (g_itm.port_mask & (1U << port));
+}
+
+bool ITM_LL_write_word(uint32_t port, uint32_t word)
+{
+    if (!ITM_LL_port_enabled(port)) {
+        return false;
+    }
+
+    uint8_t const packet[] = {
+        (uint8_t)((port << 3) | ITM_HEADER_SIZE_4),
+        (uint8_t)word,
+        (uint8_t)(word >> 8),
+        (uint8_t)(word >> 16),
+        (uint8_t)(word >> 24),
+    };
+    emit(packet, sizeof(packet));
+    return true;
+}
+
+uint32_t ITM_LL_write(uint32_t port, uint8_t const *data, uint32_t size)
+{
+    if (!ITM_LL_port_enabled(port)) {
+        return 0;
+    }
+
+    // As on the target: whole words, then the remainder byte by byte
+    uint8_t packets[ITM_CHUNK_BYTES];
+    uint32_t length = 0;
+    uint32_t done = 0;
+    while (done < size) {
+        if (length + ITM_PACKET_MAX > sizeof(packets)) {
+            emit(packets, length);
+            length = 0;
+        }
+        if (size - done >= sizeof(uint32_t)) {
+            packets[length++] = (uint8_t)((port << 3) | ITM_HEADER_SIZE_4);
+            for (uint32_t i = 0; i < sizeof(uint32_t); ++i) {
+                packets[length++] = data[done++];
+            }
+        } else {
+            packets[length++] = (uint8_t)((port << 3) | ITM_HEADER_SIZE_1);
+            packets[length++] = data[done++];
+        }
+    }
+    emit(packets, length);
+    return done;
+}
@@ -0,0 +1,169 @@
+/**
+ * @file la_ll.c
+ * @brief Native timer-paced sampling for the logic analyzer
+ *
+ * The inputs count the updates of the pacing timer: input k toggles every
+ * 2^k updates, so each capture shows eight square waves, each at half the
+ * rate of the one before. The emulated DMA takes one sample per update.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/error.h"
+#include "util/si_prefix.h"
+
+#include "la_ll.h"
+#include "native.h"
+#include "tim_ll.h"
+
+typedef struct {
+    LA_LL_Config config;
+    uint64_t updates; // Timer updates sampled so far
+    uint32_t position; // Next sample of the buffer
+    bool initialized;
+    bool running;
+    bool armed; // Started since LA_LL_init, else the position is 0
+} LAInstance;
+
+static LAInstance g_la_instance = { 0 };
+
+static void finish(uint32_t samples)
+{
+    LAInstance *const instance = &g_la_instance;
+
+    instance->running = false;
+    if (instance->config.complete_callback) {
+        instance->config.complete_callback(samples);
+    }
+}
+
+/**
+ * @brief Next sample at which the emulated DMA interrupts
+ */
+static uint32_t next_boundary(void)
+{
+    LAInstance const *const instance = &g_la_instance;
+    uint32_t const samples = instance->config.samples;
+
+    if (instance->config.block_callback && instance->position < samples / 2) {
+        return samples / 2;
+    }
+    return samples;
+}
+
+/**
+ * @brief Emulated DMA interrupt
+ */
+static void la_handler(uint64_t now_us)
+{
+    LAInstance *const instance = &g_la_instance;
+    LA_LL_Config const *const config = &instance->config;
+
+    if (!instance->running) {
+        return;
+    }
+
+    uint64_t const updates = NATIVE_tim_get_updates(config->timer);
+    while (instance->running && instance->updates < updates) {
+        uint32_t const boundary = next_boundary();
+        uint64_t const step = updates - instance->updates;
+        uint32_t const count = step < boundary - instance->position
+                                   ? (uint32_t)step
+                                   : boundary - instance->position;
+
+        for (uint32_t i = 0; i < count; ++i) {
+            config->buffer[instance->position + i] =
+                (uint8_t)(instance->updates + i);
+        }
+        instance->updates += count;
+        instance->position += count;
+        if (instance->position < boundary) {
+            break;
+        }
+
+        if (!config->block_callback) {
+            finish(config->samples);
+            break;
+        }
+        uint32_t const half = config->samples / 2;
+        instance->position %= config->samples;
+        config->block_callback(&config->buffer[boundary - half], half);
+    }
+
+    uint32_t const rate = NATIVE_tim_get_frequency(config->timer);
+    if (instance->running && rate != 0) {
+        uint64_t const left = next_boundary() - instance->position;
+        NATIVE_schedule(now_us + ((left * SI_MEGA_INT) / rate));
+    }
+}
+
+void LA_LL_init(LA_LL_Config const *config)
+{
+    if (!config || !config->buffer || config->samples == 0 ||
+        config->samples > LA_LL_SAMPLES_MAX ||
+        config->timer >= TIM_NUM_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (config->block_callback &&
+        (config->samples % 2 != 0 || config->samples > LA_LL_RING_MAX)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_la_instance.initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    NATIVE_add_handler(la_handler);
+    g_la_instance.config = *config;
+    g_la_instance.armed = false;
+    g_la_instance.initialized = true;
+}
+
+void LA_LL_deinit(void)
+{
+    if (!g_la_instance.initialized) {
+        return;
+    }
+
+    LA_LL_stop();
+    NATIVE_remove_handler(la_handler);
+    g_la_instance.initialized = false;
+}
+
+void LA_LL_start(void)
+{
+    LAInstance *const instance = &g_la_instance;
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    // Samples wait for the timer to be started
+    instance->updates = NATIVE_tim_get_updates(instance->config.timer);
+    instance->position = 0;
+    instance->armed = true;
+    instance->running = true;
+    NATIVE_request_service();
+}
+
+void LA_LL_stop(void)
+{
+    if (!g_la_instance.initialized) {
+        return;
+    }
+
+    g_la_instance.running = false;
+}
+
+uint32_t LA_LL_get_position(void)
+{
+    LAInstance const *const instance = &g_la_instance;
+
+    if (!instance->initialized || !instance->armed) {
+        return 0;
+    }
+    return instance->position;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file led_ll.c
+ * @brief Native LEDs
+ *
+ * The LEDs only keep their state; there is nothing to light.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+
+#include "led_ll.h"
+
+static bool g_led_states[LED_LL_COUNT] = { false };
+
+void LED_LL_init(void)
+{
+    for (int i = 0; i < LED_LL_COUNT; ++i) {
+        g_led_states[i] = false;
+    }
+}
+
+void LED_LL_on(LED_LL_ID led_id)
+{
+    if (led_id < LED_LL_COUNT) {
+        g_led_states[led_id] = true;
+    }
+}
+
+void LED_LL_off(LED_LL_ID led_id)
+{
+    if (led_id < LED_LL_COUNT) {
+        g_led_states[led_id] = false;
+    }
+}
+
+void LED_LL_toggle(LED_LL_ID led_id)
+{
+    if (led_id < LED_LL_COUNT) {
+        g_led_states[led_id] = !g_led_states[led_id];
+    }
+}
@@ -0,0 +1,175 @@
+/**
+ * @file native.h
+ * @brief Emulated interrupts and timers of the native platform
+ *
+ * The native platform runs the firmware as a single-threaded Linux process.
+ * Peripherals are emulated by interrupt handlers that the firmware's own
+ * calls into the platform layer take at the points where hardware could
+ * have raised them: when the tick or the time is read, when interrupts are
+ * unmasked and when the core waits for an interrupt. Handlers are not taken
+ * while interrupts are masked or from within another handler, so their
+ * callbacks run with the same guarantees as on the target.
+ *
+ * Timers have no interrupts of their own. A peripheral paced by a timer
+ * counts the timer's update events, see NATIVE_tim_get_updates, and does
+ * the work of the updates that have passed whenever its handler runs.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_NATIVE_H
+#define PSLAB_NATIVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "tim_ll.h"
+
+enum {
+    NATIVE_HANDLERS_MAX = 16, // Interrupt handlers registered at once
+    NATIVE_WATCHES_MAX = 16, // File descriptors watched at once
+    // Longest interval between handler passes while the firmware keeps
+    // reading the time, in us
+    NATIVE_SERVICE_INTERVAL_US = 100,
+};
+
+/**
+ * @brief Emulated interrupt handler
+ *
+ * @param now_us Time of the pass, see NATIVE_get_time_us
+ */
+typedef void (*NATIVE_Handler)(uint64_t now_us);
+
+/**
+ * @brief Register an interrupt handler
+ *
+ * Registering a handler again has no effect.
+ *
+ * @param handler Handler to run on every pass
+ *
+ * @throws ERROR_OUT_OF_MEMORY if NATIVE_HANDLERS_MAX handlers are registered
+ */
+void NATIVE_add_handler(NATIVE_Handler handler);
+
+/**
+ * @brief Unregister an interrupt handler
+ *
+ * @param handler Handler passed to NATIVE_add_handler
+ */
+void NATIVE_remove_handler(NATIVE_Handler handler);
+
+/**
+ * @brief Wake PLATFORM_wait_for_interrupt on input
+ *
+ * A pseudo-terminal without a program on the other side reports a hang-up
+ * at once, so a port is watched only while it is open. Watching a file
+ * descriptor again has no effect.
+ *
+ * @param fd File descriptor whose input pends the handlers
+ *
+ * @throws ERROR_OUT_OF_MEMORY if NATIVE_WATCHES_MAX are watched
+ */
+void NATIVE_watch(int fd);
+
+/**
+ * @brief Stop watching a file descriptor
+ *
+ * @param fd File descriptor passed to NATIVE_watch
+ */
+void NATIVE_unwatch(int fd);
+
+/**
+ * @brief Run the interrupt handlers, unless interrupts are masked
+ *
+ * Handlers run at most once per NATIVE_SERVICE_INTERVAL_US, unless a pass
+ * has been requested with NATIVE_request_service.
+ */
+void NATIVE_service(void);
+
+/**
+ * @brief Request a pass of the interrupt handlers at the next opportunity
+ *
+ * Pends an interrupt; also wakes PLATFORM_wait_for_interrupt.
+ */
+void NATIVE_request_service(void);
+
+/**
+ * @brief Request a pass of the interrupt handlers at a time
+ *
+ * For peripherals whose next event is due before the next millisecond
+ * tick. Requests are cleared by each pass, so handlers schedule their next
+ * event on every pass.
+ *
+ * @param at_us Time of the event, see NATIVE_get_time_us
+ */
+void NATIVE_schedule(uint64_t at_us);
+
+/**
+ * @brief Monotonic time since PLATFORM_init
+ *
+ * @return Time in microseconds
+ */
+uint64_t NATIVE_get_time_us(void);
+
+/**
+ * @brief Count of update events of a timer
+ *
+ * The count only grows, across stops, restarts and frequency changes, so a
+ * peripheral paced by the timer takes a snapshot when it is armed and does
+ * the work of the difference on each pass of its handler.
+ *
+ * @param tim Timer instance
+ * @return Update events since startup
+ */
+uint64_t NATIVE_tim_get_updates(TIM_Num tim);
+
+/**
+ * @brief Frequency of a timer
+ *
+ * @param tim Timer instance
+ * @return Update events per second, 0 if not initialized
+ */
+uint32_t NATIVE_tim_get_frequency(TIM_Num tim);
+
+/**
+ * @brief Whether a timer is counting
+ *
+ * @param tim Timer instance
+ * @return true between TIM_LL_start and TIM_LL_stop
+ */
+bool NATIVE_tim_is_running(TIM_Num tim);
+
+/**
+ * @brief Announce the device file of an emulated port
+ *
+ * Prints the path on stderr. With the PSLAB_NATIVE_DIR environment variable
+ * set, also links it as <PSLAB_NATIVE_DIR>/<name>, so that scripts find
+ * the ports under fixed names.
+ *
+ * @param name Name of the port, e.g. "usb0"
+ * @param path Path of its device file
+ */
+void NATIVE_announce_port(char const *name, char const *path);
+
+/**
+ * @brief Open a pseudo-terminal for an emulated port
+ *
+ * The terminal is raw, so bytes pass unchanged, and the master side is
+ * non-blocking.
+ *
+ * @param name Name of the port, for NATIVE_announce_port
+ * @return Master file descriptor
+ *
+ * @throws ERROR_HARDWARE_FAULT if no pseudo-terminal can be opened
+ */
+int NATIVE_open_port(char const *name);
+
+/**
+ * @brief Whether a program has the other side of a port open
+ *
+ * @param fd Master file descriptor returned by NATIVE_open_port
+ */
+bool NATIVE_port_is_open(int fd);
+
+#endif // PSLAB_NATIVE_H
@@ -0,0 +1,386 @@
+/**
+ * @file platform.c
+ * @brief Native platform initialization, time and emulated interrupts
+ *
+ * Time is the monotonic clock of the host, counted from PLATFORM_init. The
+ * cycle counter runs at the 250 MHz of the target's core clock, so that
+ * profiling reports are in the units they have on the target; they measure
+ * host time, though, not target cycles.
+ *
+ * See native.h for how interrupts are emulated.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "util/error.h"
+#include "util/si_prefix.h"
+
+#include "native.h"
+#include "platform.h"
+
+enum {
+    CORE_CLOCK_HZ = 250000000, // Full speed core and bus clocks
+    CORE_CLOCK_LOW_DIVIDER = 8, // AHB prescaler at low speed
+};
+
+static struct {
+    struct timespec start; // Host time of PLATFORM_init
+    bool masked; // Interrupts masked by PLATFORM_disable_interrupts
+    bool in_handler; // A handler pass is running
+    bool pending; // A pass was requested by NATIVE_request_service
+    uint64_t last_pass_us;
+    uint64_t deadline_us; // Earliest pass scheduled with NATIVE_schedule
+    NATIVE_Handler handlers[NATIVE_HANDLERS_MAX];
+    uint32_t handler_count;
+    int watches[NATIVE_WATCHES_MAX]; // Wake PLATFORM_wait_for_interrupt
+    uint32_t watch_count;
+    PLATFORM_ClockSpeed clock_speed;
+    uint32_t adc_clock_divider; // ADC kernel clock, unaffected by scaling
+} g_platform = {
+    .deadline_us = UINT64_MAX,
+    .clock_speed = PLATFORM_CLOCK_SPEED_FULL,
+    .adc_clock_divider = PLATFORM_ADC_CLOCK_DIVIDER_DEFAULT,
+};
+
+// Command line of the process, for PLATFORM_reset
+static char **g_argv = nullptr;
+
+/**
+ * @brief Keep the command line, run by the C library before main
+ *
+ * glibc passes the arguments of main to the constructors as well.
+ */
+__attribute__((constructor)) static void save_arguments(int argc, char **argv)
+{
+    (void)argc;
+    g_argv = argv;
+}
+
+/**
+ * @brief Host time elapsed since PLATFORM_init, in nanoseconds
+ */
+static uint64_t elapsed_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    int64_t const seconds = now.tv_sec - g_platform.start.tv_sec;
+    int64_t const nanoseconds = now.tv_nsec - g_platform.start.tv_nsec;
+    return (uint64_t)((seconds * SI_GIGA_INT) + nanoseconds);
+}
+
+void PLATFORM_init(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &g_platform.start);
+    g_platform.masked = false;
+    g_platform.clock_speed = PLATFORM_CLOCK_SPEED_FULL;
+    g_platform.adc_clock_divider = PLATFORM_ADC_CLOCK_DIVIDER_DEFAULT;
+}
+
+uint64_t NATIVE_get_time_us(void) { return elapsed_ns() / SI_KILO_INT; }
+
+void NATIVE_add_handler(NATIVE_Handler handler)
+{
+    for (uint32_t i = 0; i < g_platform.handler_count; ++i) {
+        if (g_platform.handlers[i] == handler) {
+            return;
+        }
+    }
+    if (g_platform.handler_count == NATIVE_HANDLERS_MAX) {
+        THROW(ERROR_OUT_OF_MEMORY);
+    }
+    g_platform.handlers[g_platform.handler_count++] = handler;
+}
+
+void NATIVE_remove_handler(NATIVE_Handler handler)
+{
+    for (uint32_t i = 0; i < g_platform.handler_count; ++i) {
+        if (g_platform.handlers[i] == handler) {
+            g_platform.handler_count -= 1;
+            g_platform.handlers[i] =
+                g_platform.handlers[g_platform.handler_count];
+            return;
+        }
+    }
+}
+
+void NATIVE_watch(int fd)
+{
+    for (uint32_t i = 0; i < g_platform.watch_count; ++i) {
+        if (g_platform.watches[i] == fd) {
+            return;
+        }
+    }
+    if (g_platform.watch_count == NATIVE_WATCHES_MAX) {
+        THROW(ERROR_OUT_OF_MEMORY);
+    }
+    g_platform.watches[g_platform.watch_count++] = fd;
+}
+
+void NATIVE_unwatch(int fd)
+{
+    for (uint32_t i = 0; i < g_platform.watch_count; ++i) {
+        if (g_platform.watches[i] == fd) {
+            g_platform.watch_count -= 1;
+            g_platform.watches[i] = g_platform.watches[g_platform.watch_count];
+            return;
+        }
+    }
+}
+
+void NATIVE_request_service(void) { g_platform.pending = true; }
+
+void NATIVE_schedule(uint64_t at_us)
+{
+    if (at_us < g_platform.deadline_us) {
+        g_platform.deadline_us = at_us;
+    }
+}
+
+void NATIVE_service(void)
+{
+    if (g_platform.masked || g_platform.in_handler) {
+        return;
+    }
+
+    uint64_t const now = NATIVE_get_time_us();
+    if (!g_platform.pending && now < g_platform.deadline_us &&
+        now - g_platform.last_pass_us < NATIVE_SERVICE_INTERVAL_US) {
+        return;
+    }
+
+    g_platform.in_handler = true;
+    g_platform.pending = false;
+    g_platform.deadline_us = UINT64_MAX;
+    g_platform.last_pass_us = now;
+    // A handler may unregister itself, which moves the last one into its
+    // place; that one then waits for the next pass
+    for (uint32_t i = 0; i < g_platform.handler_count; ++i) {
+        g_platform.handlers[i](now);
+    }
+    g_platform.in_handler = false;
+}
+
+uint32_t PLATFORM_get_tick(void)
+{
+    NATIVE_service();
+    return (uint32_t)(NATIVE_get_time_us() / SI_KILO_INT);
+}
+
+uint64_t PLATFORM_get_time_us64(void)
+{
+    NATIVE_service();
+    return NATIVE_get_time_us();
+}
+
+uint32_t PLATFORM_get_time_us(void)
+{
+    return (uint32_t)PLATFORM_get_time_us64();
+}
+
+uint32_t PLATFORM_get_cycles(void)
+{
+    // Reading the time would run the handlers inside profiled code
+    return (uint32_t)((elapsed_ns() * PLATFORM_get_cycle_frequency()) /
+                      SI_GIGA_INT);
+}
+
+uint32_t PLATFORM_get_cycle_frequency(void)
+{
+    if (g_platform.clock_speed == PLATFORM_CLOCK_SPEED_LOW) {
+        return CORE_CLOCK_HZ / CORE_CLOCK_LOW_DIVIDER;
+    }
+    return CORE_CLOCK_HZ;
+}
+
+uint32_t PLATFORM_get_peripheral_clock_speed(PLATFORM_PeripheralClock clock)
+{
+    switch (clock) {
+    case PLATFORM_CLOCK_ADC1:
+    case PLATFORM_CLOCK_ADC2:
+        return PLATFORM_ADC_CLOCK_SOURCE_HZ / g_platform.adc_clock_divider;
+    case PLATFORM_CLOCK_TIMER1:
+    case PLATFORM_CLOCK_TIMER2:
+    case PLATFORM_CLOCK_TIMER3:
+    case PLATFORM_CLOCK_TIMER4:
+    case PLATFORM_CLOCK_TIMER5:
+    case PLATFORM_CLOCK_TIMER6:
+    case PLATFORM_CLOCK_TIMER7:
+    case PLATFORM_CLOCK_TIMER8:
+    case PLATFORM_CLOCK_TIMER16:
+    case PLATFORM_CLOCK_TIMER17:
+    case PLATFORM_CLOCK_TIMER15:
+        // The APB buses follow the core clock
+        return PLATFORM_get_cycle_frequency();
+    default:
+        return 0;
+    }
+}
+
+void PLATFORM_set_clock_speed(PLATFORM_ClockSpeed speed)
+{
+    if (speed != PLATFORM_CLOCK_SPEED_FULL &&
+        speed != PLATFORM_CLOCK_SPEED_LOW) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    g_platform.clock_speed = speed;
+}
+
+PLATFORM_ClockSpeed PLATFORM_get_clock_speed(void)
+{
+    return g_platform.clock_speed;
+}
+
+void PLATFORM_set_adc_clock_divider(uint32_t divider)
+{
+    if (divider < PLATFORM_ADC_CLOCK_DIVIDER_MIN ||
+        divider > PLATFORM_ADC_CLOCK_DIVIDER_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    g_platform.adc_clock_divider = divider;
+}
+
+uint32_t PLATFORM_get_adc_clock_divider(void)
+{
+    return g_platform.adc_clock_divider;
+}
+
+uint32_t PLATFORM_disable_interrupts(void)
+{
+    uint32_t const state = g_platform.masked ? 1 : 0;
+    g_platform.masked = true;
+    return state;
+}
+
+size_t PLATFORM_get_irq_info(PLATFORM_IrqInfo *info, size_t max)
+{
+    // Handlers run from the service loop, without priorities
+    (void)info;
+    (void)max;
+    return 0;
+}
+
+void PLATFORM_restore_interrupts(uint32_t state)
+{
+    g_platform.masked = state != 0;
+    // Interrupts that became pending while masked are taken now
+    NATIVE_service();
+}
+
+void PLATFORM_wait_for_interrupt(void)
+{
+    if (g_platform.pending) {
+        return;
+    }
+
+    // The next millisecond tick is the latest interrupt to wake up for
+    uint64_t const now = NATIVE_get_time_us();
+    uint64_t wake_us = now + SI_KILO_INT - (now % SI_KILO_INT);
+    if (g_platform.deadline_us < wake_us) {
+        if (g_platform.deadline_us <= now) {
+            return;
+        }
+        wake_us = g_platform.deadline_us;
+    }
+    struct timespec const timeout = {
+        .tv_sec = 0,
+        .tv_nsec = (long)((wake_us - now) * SI_KILO_INT),
+    };
+
+    struct pollfd fds[NATIVE_WATCHES_MAX];
+    for (uint32_t i = 0; i < g_platform.watch_count; ++i) {
+        fds[i] = (struct pollfd){
+            .fd = g_platform.watches[i],
+            .events = POLLIN,
+        };
+    }
+
+    // Input pends the handlers, like an interrupt request
+    if (ppoll(fds, g_platform.watch_count, &timeout, nullptr) > 0) {
+        g_platform.pending = true;
+    }
+}
+
+void NATIVE_announce_port(char const *name, char const *path)
+{
+    fprintf(stderr, "%s: %s\n", name, path);
+
+    char const *const dir = getenv("PSLAB_NATIVE_DIR");
+    if (dir == nullptr || dir[0] == '\0') {
+        return;
+    }
+
+    char link[256];
+    snprintf(link, sizeof(link), "%s/%s", dir, name);
+    (void)unlink(link);
+    if (symlink(path, link) != 0) {
+        fprintf(
+            stderr, "%s: cannot link %s: %s\n", name, link, strerror(errno)
+        );
+    }
+}
+
+int NATIVE_open_port(char const *name)
+{
+    int const fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    char const *const path = ptsname(fd);
+    if (path == nullptr) {
+        close(fd);
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    // Raw mode on the terminal side, so that no byte is translated; the
+    // settings stay with the terminal while the master is open
+    int const slave = open(path, O_RDWR | O_NOCTTY);
+    if (slave >= 0) {
+        struct termios settings;
+        if (tcgetattr(slave, &settings) == 0) {
+            cfmakeraw(&settings);
+            (void)tcsetattr(slave, TCSANOW, &settings);
+        }
+        close(slave);
+    }
+
+    // Not inherited by the new process image of PLATFORM_reset
+    (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+    (void)fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    NATIVE_announce_port(name, path);
+    return fd;
+}
+
+bool NATIVE_port_is_open(int fd)
+{
+    // The master hangs up while no program has the terminal open
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    return poll(&pfd, 1, 0) >= 0 && (pfd.revents & POLLHUP) == 0;
+}
+
+__attribute__((noreturn)) void PLATFORM_reset(void)
+{
+    fflush(stdout);
+    fflush(stderr);
+
+    // Start the firmware over in a fresh process image
+    if (g_argv != nullptr) {
+        execv("/proc/self/exe", g_argv);
+    }
+    fprintf(stderr, "reset: cannot restart: %s\n", strerror(errno));
+    _exit(EXIT_FAILURE);
+}
@@ -0,0 +1,214 @@
+/**
+ * @file spi_ll.c
+ * @brief Native SPI bus, with MISO looped back to MOSI
+ *
+ * Each transfer receives the bytes it sends, and completes after the time
+ * its bytes take on the bus at the configured clock rate.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "util/error.h"
+#include "util/si_prefix.h"
+
+#include "native.h"
+#include "spi_ll.h"
+
+enum {
+    SPI_KERNEL_CLOCK = 250 * SI_MEGA_INT, // Hz, as on the target
+    SPI_PRESCALER_STEPS = 8, // Kernel clock divided by 2 to 256
+    SPI_FILL_BYTE = 0xFF, // Sent when a transfer has no TX data
+};
+
+typedef struct {
+    bool initialized;
+    bool busy;
+    bool hold_cs;
+    uint32_t speed; // Clock rate reached, in Hz
+    uint64_t done_us; // End of the transfer in progress
+    SPI_LL_CompleteCallback complete_callback;
+} SPIInstance;
+
+static SPIInstance g_spi_instances[SPI_BUS_COUNT] = { 0 };
+
+/**
+ * @brief Emulated SPI and DMA interrupts
+ */
+static void spi_handler(uint64_t now_us)
+{
+    for (size_t i = 0; i < SPI_BUS_COUNT; ++i) {
+        SPIInstance *instance = &g_spi_instances[i];
+        if (!instance->busy) {
+            continue;
+        }
+        if (now_us < instance->done_us) {
+            NATIVE_schedule(instance->done_us);
+            continue;
+        }
+
+        instance->busy = false;
+        if (instance->complete_callback != nullptr) {
+            instance->complete_callback((SPI_Bus)i, SPI_LL_STATUS_OK);
+        }
+    }
+}
+
+/**
+ * @brief Clock rate the prescaler reaches for a configuration
+ *
+ * @return Clock rate reached, in Hz
+ */
+static uint32_t apply_config(SPIInstance *instance, SPI_LL_Config const *config)
+{
+    uint32_t const kernel = SPI_KERNEL_CLOCK;
+    uint32_t step = 0;
+
+    // The fastest rate that does not exceed the one wanted
+    for (; step < SPI_PRESCALER_STEPS; step++) {
+        if ((kernel >> (step + 1)) <= config->speed) {
+            break;
+        }
+    }
+    if (step == SPI_PRESCALER_STEPS) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    instance->speed = kernel >> (step + 1);
+    return instance->speed;
+}
+
+void SPI_LL_init(SPI_Bus bus)
+{
+    if (bus >= SPI_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    SPIInstance *instance = &g_spi_instances[bus];
+
+    if (instance->initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    SPI_LL_Config const config = {
+        .speed = SPI_LL_SPEED_DEFAULT,
+        .mode = SPI_LL_MODE_0,
+        .lsb_first = false,
+    };
+
+    NATIVE_add_handler(spi_handler);
+    apply_config(instance, &config);
+
+    instance->busy = false;
+    instance->hold_cs = false;
+    instance->initialized = true;
+}
+
+void SPI_LL_deinit(SPI_Bus bus)
+{
+    if (bus >= SPI_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    SPIInstance *instance = &g_spi_instances[bus];
+
+    if (!instance->initialized) {
+        return;
+    }
+
+    // Stops without calling back
+    NATIVE_remove_handler(spi_handler);
+    instance->busy = false;
+    instance->hold_cs = false;
+    instance->complete_callback = nullptr;
+    instance->initialized = false;
+}
+
+uint32_t SPI_LL_configure(SPI_Bus bus, SPI_LL_Config const *config)
+{
+    if (bus >= SPI_BUS_COUNT || !config || config->mode > SPI_LL_MODE_3 ||
+        config->speed < SPI_LL_SPEED_MIN || config->speed > SPI_LL_SPEED_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    SPIInstance *instance = &g_spi_instances[bus];
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    // A new clock polarity would glitch SCK under a selected target
+    if (instance->busy || instance->hold_cs) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    return apply_config(instance, config);
+}
+
+void SPI_LL_start(SPI_Bus bus, SPI_LL_Transfer const *transfer)
+{
+    if (bus >= SPI_BUS_COUNT || !transfer ||
+        (!transfer->tx && !transfer->rx) || transfer->size == 0 ||
+        transfer->size > SPI_LL_TRANSFER_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    SPIInstance *instance = &g_spi_instances[bus];
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (instance->busy) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    if (transfer->rx && transfer->tx) {
+        memmove(transfer->rx, transfer->tx, transfer->size);
+    } else if (transfer->rx) {
+        memset(transfer->rx, SPI_FILL_BYTE, transfer->size);
+    }
+
+    uint64_t const bits = (uint64_t)transfer->size * 8;
+    instance->busy = true;
+    instance->hold_cs = transfer->hold_cs;
+    instance->done_us =
+        NATIVE_get_time_us() +
+        (bits * SI_MEGA_INT + instance->speed - 1) / instance->speed;
+    NATIVE_schedule(instance->done_us);
+}
+
+void SPI_LL_release_cs(SPI_Bus bus)
+{
+    if (bus >= SPI_BUS_COUNT || !g_spi_instances[bus].initialized ||
+        g_spi_instances[bus].busy) {
+        return;
+    }
+
+    g_spi_instances[bus].hold_cs = false;
+}
+
+bool SPI_LL_busy(SPI_Bus bus)
+{
+    if (bus >= SPI_BUS_COUNT || !g_spi_instances[bus].initialized) {
+        return false;
+    }
+
+    return g_spi_instances[bus].busy;
+}
+
+void SPI_LL_set_complete_callback(
+    SPI_Bus bus,
+    SPI_LL_CompleteCallback callback
+)
+{
+    if (bus >= SPI_BUS_COUNT) {
+        return;
+    }
+    g_spi_instances[bus].complete_callback = callback;
+}
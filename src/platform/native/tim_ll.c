@@ -0,0 +1,445 @@
+/**
+ * @file tim_ll.c
+ * @brief Native timers, counted in host time
+ *
+ * A running timer counts update events from the host time since it was
+ * started, at the rate its prescaler and reload division give, so the
+ * achieved frequencies and periods are those of the target. Peripherals
+ * paced by a timer read the count, see NATIVE_tim_get_updates.
+ *
+ * PWM outputs have no pins to drive; their settings are only checked.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/error.h"
+#include "util/si_prefix.h"
+
+#include "native.h"
+#include "platform.h"
+#include "tim_ll.h"
+
+enum {
+    // Prescaler and auto-reload division limit, as on the target
+    TIMER_DIVIDER_MAX = 0x10000,
+};
+
+typedef struct {
+    uint32_t frequency; // Requested frequency
+    uint32_t clock; // Timer clock at initialization
+    uint32_t prescaler;
+    uint32_t period;
+    bool initialized;
+    bool claimed; // Handed out by TIM_LL_claim
+    bool running;
+    uint64_t start_us; // Time of the last start or frequency change
+    uint64_t updates; // Update events before start_us
+    uint8_t pwm_outputs; // Bit per channel set up by TIM_LL_pwm_init
+} TimerInstance;
+
+static TimerInstance g_timer_instances[TIM_NUM_COUNT] = { 0 };
+
+// Timer clocks, in TIM_Num order
+static PLATFORM_PeripheralClock const g_clocks[TIM_NUM_COUNT] = {
+    [TIM_NUM_6] = PLATFORM_CLOCK_TIMER6,  [TIM_NUM_7] = PLATFORM_CLOCK_TIMER7,
+    [TIM_NUM_1] = PLATFORM_CLOCK_TIMER1,  [TIM_NUM_2] = PLATFORM_CLOCK_TIMER2,
+    [TIM_NUM_3] = PLATFORM_CLOCK_TIMER3,  [TIM_NUM_4] = PLATFORM_CLOCK_TIMER4,
+    [TIM_NUM_8] = PLATFORM_CLOCK_TIMER8,  [TIM_NUM_15] = PLATFORM_CLOCK_TIMER15,
+};
+
+// Order in which TIM_LL_claim hands out timers, the same as on the target
+static TIM_Num const g_claim_order[] = {
+    TIM_NUM_6, TIM_NUM_3, TIM_NUM_2, TIM_NUM_15,
+    TIM_NUM_8, TIM_NUM_1, TIM_NUM_4,
+};
+
+/*
+ * Starts held since TIM_LL_sync_arm, for TIM_LL_sync_start. There are no
+ * trigger pins natively; the output is looped back to the input, as when
+ * a single board is wired to itself.
+ */
+static struct {
+    bool armed;
+    uint32_t timers; // Bit per held TIM_Num
+    bool trigger_input;
+    bool trigger_output;
+} g_sync = {
+    .armed = false,
+    .timers = 0,
+    .trigger_input = false,
+    .trigger_output = false,
+};
+
+/**
+ * @brief Timer clock cycles per update event
+ */
+static uint64_t cycles_per_update(TimerInstance const *instance)
+{
+    return (uint64_t)(instance->prescaler + 1) * (instance->period + 1);
+}
+
+/**
+ * @brief Update events since the timer was last started
+ */
+static uint64_t updates_since_start(TimerInstance const *instance)
+{
+    if (!instance->running) {
+        return 0;
+    }
+
+    // 128 bits, so that the product does not wrap in a long run
+    unsigned __int128 const cycles =
+        (unsigned __int128)(NATIVE_get_time_us() - instance->start_us) *
+        instance->clock;
+    return (uint64_t)(cycles / ((unsigned __int128)SI_MEGA_INT *
+                                cycles_per_update(instance)));
+}
+
+/**
+ * @brief Move the update events so far into the base count
+ */
+static void rebase(TimerInstance *instance)
+{
+    instance->updates += updates_since_start(instance);
+    instance->start_us = NATIVE_get_time_us();
+}
+
+/**
+ * @brief Calculate the prescaler and the reload value for the frequency
+ *
+ * The same search as on the target: every prescaler from the smallest one
+ * that fits up to the square root of the division, with the nearest reload
+ * value, and the pair with the smallest frequency error wins.
+ *
+ * @param tim Timer instance
+ * @param freq Requested frequency
+ * @return The achieved frequency in Hz, rounded to nearest
+ */
+static uint32_t calculate_timer_values(TIM_Num tim, uint32_t freq)
+{
+    TimerInstance *instance = &g_timer_instances[tim];
+    if (freq == 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    uint32_t const tim_clock =
+        PLATFORM_get_peripheral_clock_speed(g_clocks[tim]);
+    uint64_t const divider = (tim_clock + (freq / 2)) / freq;
+
+    if (divider == 0 ||
+        divider > (uint64_t)TIMER_DIVIDER_MAX * TIMER_DIVIDER_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    uint32_t const psc_min =
+        (uint32_t)((divider + TIMER_DIVIDER_MAX - 1) / TIMER_DIVIDER_MAX);
+    uint32_t best_psc = psc_min;
+    uint32_t best_arr = TIMER_DIVIDER_MAX;
+    uint64_t best_error = UINT64_MAX;
+    uint64_t best_total = 1;
+
+    for (uint32_t psc = psc_min; psc <= TIMER_DIVIDER_MAX; ++psc) {
+        uint64_t const step = (uint64_t)freq * psc;
+        uint64_t arr = (tim_clock + (step / 2)) / step;
+
+        if (arr == 0) {
+            arr = 1;
+        } else if (arr > TIMER_DIVIDER_MAX) {
+            arr = TIMER_DIVIDER_MAX;
+        }
+
+        uint64_t const total = psc * arr;
+        uint64_t const achieved = freq * total;
+        uint64_t const error =
+            achieved > tim_clock ? achieved - tim_clock : tim_clock - achieved;
+
+        if (best_error == UINT64_MAX ||
+            error * best_total < best_error * total) {
+            best_psc = psc;
+            best_arr = (uint32_t)arr;
+            best_error = error;
+            best_total = total;
+        }
+
+        if (error == 0 || (uint64_t)psc * psc >= divider) {
+            break;
+        }
+    }
+
+    // Count the updates at the old rate up to now
+    rebase(instance);
+    instance->frequency = freq;
+    instance->clock = tim_clock;
+    instance->prescaler = best_psc - 1;
+    instance->period = best_arr - 1;
+
+    return (uint32_t)((tim_clock + (best_total / 2)) / best_total);
+}
+
+static void check_pwm_channel(TIM_Num tim, TIM_LL_Channel channel)
+{
+    // The target has PWM pins on TIM4 only
+    if (tim != TIM_NUM_4 ||
+        (channel != TIM_LL_CHANNEL_1 && channel != TIM_LL_CHANNEL_3)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+uint32_t TIM_LL_init(TIM_Num tim, uint32_t freq)
+{
+    if (tim >= TIM_NUM_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (g_timer_instances[tim].initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    uint32_t const achieved = calculate_timer_values(tim, freq);
+    g_timer_instances[tim].initialized = true;
+    return achieved;
+}
+
+uint32_t TIM_LL_set_frequency(TIM_Num tim, uint32_t freq)
+{
+    if (tim >= TIM_NUM_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!g_timer_instances[tim].initialized) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+
+    return calculate_timer_values(tim, freq);
+}
+
+void TIM_LL_deinit(TIM_Num tim)
+{
+    if (tim >= TIM_NUM_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    TimerInstance *instance = &g_timer_instances[tim];
+    if (!instance->initialized) {
+        return;
+    }
+
+    g_sync.timers &= ~(1U << tim);
+    rebase(instance);
+    instance->running = false;
+    instance->pwm_outputs = 0;
+    instance->frequency = 0;
+    instance->prescaler = 0;
+    instance->period = 0;
+    instance->initialized = false;
+}
+
+Error TIM_LL_try_start(TIM_Num tim)
+{
+    if (tim >= TIM_NUM_COUNT) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    TimerInstance *instance = &g_timer_instances[tim];
+    if (!instance->initialized) {
+        return g_sync.armed ? ERROR_RESOURCE_UNAVAILABLE
+                            : ERROR_HARDWARE_FAULT;
+    }
+    if (g_sync.armed) {
+        g_sync.timers |= 1U << tim;
+        return ERROR_NONE;
+    }
+    if (!instance->running) {
+        instance->start_us = NATIVE_get_time_us();
+        instance->running = true;
+    }
+    return ERROR_NONE;
+}
+
+void TIM_LL_start(TIM_Num tim)
+{
+    Error const error = TIM_LL_try_start(tim);
+    if (error != ERROR_NONE) {
+        THROW(error);
+    }
+}
+
+void TIM_LL_stop(TIM_Num tim)
+{
+    if (tim >= TIM_NUM_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    TimerInstance *instance = &g_timer_instances[tim];
+    g_sync.timers &= ~(1U << tim);
+    rebase(instance);
+    instance->running = false;
+}
+
+void TIM_LL_sync_arm(void) { g_sync.armed = true; }
+
+static uint32_t start_held(void)
+{
+    uint32_t const timers = g_sync.timers;
+    uint32_t count = 0;
+
+    g_sync.armed = false;
+    g_sync.timers = 0;
+
+    // One time for all, so that the counts stay in step
+    uint64_t const now = NATIVE_get_time_us();
+    for (size_t tim = 0; tim < TIM_NUM_COUNT; ++tim) {
+        if ((timers & (1U << tim)) != 0) {
+            TimerInstance *instance = &g_timer_instances[tim];
+
+            rebase(instance);
+            instance->start_us = now;
+            instance->running = true;
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+uint32_t TIM_LL_sync_start(void)
+{
+    if (!g_sync.armed) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+
+    if (g_sync.trigger_input && !g_sync.trigger_output) {
+        // Left for an edge that never comes
+        return (uint32_t)__builtin_popcount(g_sync.timers);
+    }
+    return start_held();
+}
+
+uint32_t TIM_LL_sync_fire(void) { return g_sync.armed ? start_held() : 0; }
+
+uint32_t TIM_LL_sync_held(void)
+{
+    return (uint32_t)__builtin_popcount(g_sync.timers);
+}
+
+void TIM_LL_sync_cancel(void)
+{
+    g_sync.armed = false;
+    g_sync.timers = 0;
+}
+
+bool TIM_LL_sync_is_armed(void) { return g_sync.armed; }
+
+void TIM_LL_sync_set_trigger_input(bool enable)
+{
+    g_sync.trigger_input = enable;
+}
+
+void TIM_LL_sync_set_trigger_output(bool enable)
+{
+    g_sync.trigger_output = enable;
+}
+
+void TIM_LL_set_update_dma(TIM_Num tim, bool enable)
+{
+    if (tim >= TIM_NUM_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    // Peripherals count the updates themselves
+    (void)enable;
+}
+
+uint32_t TIM_LL_get_period(TIM_Num tim)
+{
+    if (tim >= TIM_NUM_COUNT || !g_timer_instances[tim].initialized) {
+        return 0;
+    }
+    return g_timer_instances[tim].period + 1;
+}
+
+void TIM_LL_pwm_init(TIM_Num tim, TIM_LL_Channel channel)
+{
+    check_pwm_channel(tim, channel);
+
+    TimerInstance *instance = &g_timer_instances[tim];
+    if (!instance->initialized) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+    instance->pwm_outputs |= 1U << channel;
+}
+
+void TIM_LL_pwm_set_pulse(
+    TIM_Num tim,
+    TIM_LL_Channel channel,
+    uint32_t start,
+    uint32_t width
+)
+{
+    check_pwm_channel(tim, channel);
+
+    TimerInstance const *instance = &g_timer_instances[tim];
+    if (!instance->initialized || start >= instance->period + 1) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    (void)width;
+}
+
+void TIM_LL_pwm_enable(TIM_Num tim, TIM_LL_Channel channel, bool enable)
+{
+    check_pwm_channel(tim, channel);
+    (void)enable;
+}
+
+TIM_Num TIM_LL_claim(void)
+{
+    for (size_t i = 0; i < sizeof(g_claim_order) / sizeof(g_claim_order[0]);
+         ++i) {
+        TimerInstance *instance = &g_timer_instances[g_claim_order[i]];
+
+        if (!instance->claimed && !instance->initialized) {
+            instance->claimed = true;
+            return g_claim_order[i];
+        }
+    }
+
+    THROW(ERROR_RESOURCE_UNAVAILABLE);
+}
+
+void TIM_LL_release(TIM_Num tim)
+{
+    if (tim >= TIM_NUM_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    g_timer_instances[tim].claimed = false;
+}
+
+uint64_t NATIVE_tim_get_updates(TIM_Num tim)
+{
+    if (tim >= TIM_NUM_COUNT) {
+        return 0;
+    }
+
+    TimerInstance const *instance = &g_timer_instances[tim];
+    return instance->updates + updates_since_start(instance);
+}
+
+bool NATIVE_tim_is_running(TIM_Num tim)
+{
+    return tim < TIM_NUM_COUNT && g_timer_instances[tim].running;
+}
+
+uint32_t NATIVE_tim_get_frequency(TIM_Num tim)
+{
+    if (tim >= TIM_NUM_COUNT || !g_timer_instances[tim].initialized) {
+        return 0;
+    }
+
+    TimerInstance const *instance = &g_timer_instances[tim];
+    uint64_t const total = cycles_per_update(instance);
+    return (uint32_t)((instance->clock + (total / 2)) / total);
+}
@@ -0,0 +1,560 @@
+/**
+ * @file uart_ll.c
+ * @brief Native UARTs, as pseudo-terminals
+ *
+ * UART_BUS_0 and UART_BUS_1 are pseudo-terminals, announced as uart0 and
+ * uart1. The log UART, UART_BUS_2, writes to stderr and receives nothing.
+ *
+ * Transmissions complete after the time the frame takes on the line at
+ * the configured baudrate, so that the layers above see the throughput
+ * of the target. Received bytes go into the circular RX buffer as the DMA
+ * would put them there, with the half-complete and complete callbacks at
+ * its middle and end; the idle callback follows a burst once no more bytes
+ * have arrived, and the receiver timeout after its bit times of silence.
+ * In loopback, transmitted bytes are received instead of written to the
+ * terminal, once they have left the line. A paused receiver leaves input
+ * in the terminal, as a USART with RTS deasserted holds off the sender;
+ * as on the target, UART_BUS_0 has no flow control.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "util/error.h"
+#include "util/si_prefix.h"
+
+#include "native.h"
+#include "platform.h"
+#include "uart_ll.h"
+
+enum { UART_DIV_MIN = 0x10, UART_DIV_MAX = 0xFFFF };
+
+typedef struct {
+    int fd; // Pseudo-terminal master, or stderr for the log UART
+    bool receives; // The fd is a terminal to receive from
+    uint8_t *rx_buffer_data;
+    uint32_t rx_buffer_size;
+    uint32_t rx_position; // Next byte the DMA writes
+    bool rx_idle_pending; // Bytes arrived since the last idle event
+    bool rx_timeout_pending; // Bytes arrived since the last timeout
+    bool open; // A program has the terminal open
+    bool watched; // Input wakes up the handlers
+    bool rx_paused; // Input stays in the terminal
+    uint64_t rx_last_us; // Time of the last received byte
+    uint32_t rx_timeout_bits; // Receiver timeout, 0 if disabled
+    bool tx_in_progress;
+    uint32_t tx_dma_size;
+    struct iovec tx_spans[2]; // Data of the transfer, kept for loopback
+    bool loopback;
+    uint64_t tx_done_us; // Time the last byte leaves the line
+    UART_LL_TxCompleteCallback tx_complete_callback;
+    UART_LL_RxCompleteCallback rx_complete_callback;
+    UART_LL_IdleCallback idle_callback;
+    UART_LL_IdleCallback rx_timeout_callback;
+    UART_LL_LineConfig line_config;
+    bool initialized;
+} UARTInstance;
+
+static UARTInstance g_uart_instances[UART_BUS_COUNT] = { 0 };
+
+/**
+ * @brief Kernel clock of the UARTs, the bus clock of the target
+ */
+static uint32_t kernel_clock(void) { return PLATFORM_get_cycle_frequency(); }
+
+static bool baudrate_valid(UART_LL_LineConfig const *config)
+{
+    if (config->baudrate == 0) {
+        return false;
+    }
+
+    uint64_t const clock =
+        (uint64_t)kernel_clock() * (config->oversampling_8 ? 2 : 1);
+    uint64_t const div = (clock + (config->baudrate / 2)) / config->baudrate;
+    return div >= UART_DIV_MIN && div <= UART_DIV_MAX;
+}
+
+/**
+ * @brief Time on the line of a number of bit times, in us
+ */
+static uint64_t line_time_us(UARTInstance const *instance, uint64_t bits)
+{
+    return ((bits * SI_MEGA_INT) + instance->line_config.baudrate - 1) /
+           instance->line_config.baudrate;
+}
+
+/**
+ * @brief Bit times per character: start, 8 data, parity and stop bits
+ */
+static uint32_t frame_bits(UARTInstance const *instance)
+{
+    UART_LL_LineConfig const *config = &instance->line_config;
+    return 1 + 8 + (config->parity == UART_LL_PARITY_NONE ? 0 : 1) +
+           (config->stop_bits == UART_LL_STOP_BITS_2 ? 2 : 1);
+}
+
+/**
+ * @brief Move received bytes into the RX buffer, as the DMA would
+ */
+static void receive(UART_Bus bus, uint64_t now_us)
+{
+    UARTInstance *instance = &g_uart_instances[bus];
+    uint32_t const half = instance->rx_buffer_size / 2;
+
+    // A callback may pause reception
+    while (!instance->rx_paused) {
+        uint32_t const position = instance->rx_position;
+        // Up to the next callback, so that each one comes in order
+        uint32_t const end = position < half ? half : instance->rx_buffer_size;
+        ssize_t const len = read(
+            instance->fd, &instance->rx_buffer_data[position], end - position
+        );
+        if (len <= 0) {
+            return;
+        }
+
+        instance->rx_idle_pending = true;
+        instance->rx_timeout_pending = true;
+        instance->rx_last_us = now_us;
+        instance->rx_position += (uint32_t)len;
+        if (instance->rx_position == instance->rx_buffer_size) {
+            instance->rx_position = 0;
+        }
+        if (instance->rx_position == half || instance->rx_position == 0) {
+            if (instance->rx_complete_callback != nullptr) {
+                instance->rx_complete_callback(bus);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Receive the bytes of a transmission, as the DMA would
+ */
+static void loop_back(UART_Bus bus, uint8_t const *data, uint32_t len)
+{
+    UARTInstance *instance = &g_uart_instances[bus];
+    uint32_t const half = instance->rx_buffer_size / 2;
+
+    while (len > 0) {
+        uint32_t const position = instance->rx_position;
+        uint32_t const end = position < half ? half : instance->rx_buffer_size;
+        uint32_t const count = len < end - position ? len : end - position;
+        memcpy(&instance->rx_buffer_data[position], data, count);
+        data += count;
+        len -= count;
+
+        instance->rx_position += count;
+        if (instance->rx_position == instance->rx_buffer_size) {
+            instance->rx_position = 0;
+        }
+        if (instance->rx_position == half || instance->rx_position == 0) {
+            if (instance->rx_complete_callback != nullptr) {
+                instance->rx_complete_callback(bus);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Report the end of a burst of received bytes
+ */
+static void detect_idle(UART_Bus bus, uint64_t now_us)
+{
+    UARTInstance *instance = &g_uart_instances[bus];
+
+    // Idle after a character time of silence; the receiver timeout counts
+    // from the last stop bit as well
+    if (instance->rx_idle_pending) {
+        uint64_t const idle_us =
+            instance->rx_last_us + line_time_us(instance, frame_bits(instance));
+        if (now_us < idle_us) {
+            NATIVE_schedule(idle_us);
+        } else {
+            instance->rx_idle_pending = false;
+            if (instance->idle_callback != nullptr) {
+                instance->idle_callback(bus, instance->rx_position);
+            }
+        }
+    }
+
+    if (instance->rx_timeout_pending && instance->rx_timeout_bits != 0) {
+        uint64_t const timeout_us =
+            instance->rx_last_us +
+            line_time_us(instance, instance->rx_timeout_bits);
+        if (now_us < timeout_us) {
+            NATIVE_schedule(timeout_us);
+        } else {
+            instance->rx_timeout_pending = false;
+            if (instance->rx_timeout_callback != nullptr) {
+                instance->rx_timeout_callback(bus, instance->rx_position);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Watch the terminal for input while a program has it open and
+ * reception is not paused
+ */
+static void update_watch(UARTInstance *instance)
+{
+    instance->open = NATIVE_port_is_open(instance->fd);
+
+    bool const watch = instance->open && !instance->rx_paused;
+    if (watch == instance->watched) {
+        return;
+    }
+
+    instance->watched = watch;
+    if (watch) {
+        NATIVE_watch(instance->fd);
+    } else {
+        NATIVE_unwatch(instance->fd);
+    }
+}
+
+/**
+ * @brief Emulated UART and DMA interrupts
+ */
+static void uart_handler(uint64_t now_us)
+{
+    for (size_t i = 0; i < UART_BUS_COUNT; ++i) {
+        UARTInstance *instance = &g_uart_instances[i];
+        if (!instance->initialized) {
+            continue;
+        }
+
+        if (instance->tx_in_progress) {
+            if (now_us >= instance->tx_done_us) {
+                instance->tx_in_progress = false;
+                if (instance->loopback) {
+                    for (size_t span = 0; span < 2; ++span) {
+                        loop_back(
+                            (UART_Bus)i,
+                            instance->tx_spans[span].iov_base,
+                            (uint32_t)instance->tx_spans[span].iov_len
+                        );
+                    }
+                    instance->rx_idle_pending = true;
+                    instance->rx_timeout_pending = true;
+                    instance->rx_last_us = instance->tx_done_us;
+                }
+                if (instance->tx_complete_callback != nullptr) {
+                    instance->tx_complete_callback(
+                        (UART_Bus)i, instance->tx_dma_size
+                    );
+                }
+            } else {
+                NATIVE_schedule(instance->tx_done_us);
+            }
+        }
+
+        if (instance->receives) {
+            update_watch(instance);
+            receive((UART_Bus)i, now_us);
+            detect_idle((UART_Bus)i, now_us);
+        }
+    }
+}
+
+static bool any_instance_initialized(void)
+{
+    for (size_t i = 0; i < UART_BUS_COUNT; ++i) {
+        if (g_uart_instances[i].initialized) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void UART_LL_init(UART_Bus bus, uint8_t *rx_buf, uint32_t sz)
+{
+    if (bus >= UART_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!rx_buf || sz == 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (g_uart_instances[bus].initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    UARTInstance *instance = &g_uart_instances[bus];
+    if (bus == UART_BUS_2) {
+        instance->fd = STDERR_FILENO;
+        instance->receives = false;
+    } else {
+        char name[8];
+        snprintf(name, sizeof(name), "uart%u", (unsigned)bus);
+        instance->fd = NATIVE_open_port(name);
+        instance->receives = true;
+    }
+
+    instance->line_config = (UART_LL_LineConfig){
+        .baudrate = UART_DEFAULT_BAUDRATE,
+        .parity = UART_LL_PARITY_NONE,
+        .stop_bits = UART_LL_STOP_BITS_1,
+        .oversampling_8 = false,
+        .flow_control = false,
+    };
+    instance->rx_buffer_data = rx_buf;
+    instance->rx_buffer_size = sz;
+    instance->rx_position = 0;
+    instance->rx_idle_pending = false;
+    instance->rx_timeout_pending = false;
+    instance->rx_timeout_bits = 0;
+    instance->open = false;
+    instance->watched = false;
+    instance->rx_paused = false;
+    instance->tx_in_progress = false;
+    instance->tx_dma_size = 0;
+    instance->loopback = false;
+
+    NATIVE_add_handler(uart_handler);
+    instance->initialized = true;
+}
+
+void UART_LL_configure(UART_Bus bus, UART_LL_LineConfig const *config)
+{
+    if (bus >= UART_BUS_COUNT || !config ||
+        config->parity > UART_LL_PARITY_ODD ||
+        config->stop_bits > UART_LL_STOP_BITS_2) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    UARTInstance *instance = &g_uart_instances[bus];
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (!baudrate_valid(config) ||
+        (config->flow_control && bus == UART_BUS_0)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (instance->tx_in_progress) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    // Reception restarts at the beginning of the buffer
+    instance->line_config = *config;
+    instance->rx_position = 0;
+    instance->rx_idle_pending = false;
+    instance->rx_timeout_pending = false;
+    instance->rx_paused = false;
+}
+
+void UART_LL_set_loopback(UART_Bus bus, bool enable)
+{
+    if (bus >= UART_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    UARTInstance *instance = &g_uart_instances[bus];
+
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (instance->tx_in_progress) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    instance->loopback = enable;
+    instance->rx_position = 0;
+    instance->rx_idle_pending = false;
+    instance->rx_timeout_pending = false;
+    instance->rx_paused = false;
+}
+
+void UART_LL_set_rx_paused(UART_Bus bus, bool paused)
+{
+    if (bus >= UART_BUS_COUNT || !g_uart_instances[bus].initialized) {
+        return;
+    }
+
+    UARTInstance *instance = &g_uart_instances[bus];
+    instance->rx_paused = paused;
+    // Pick up the input that waited meanwhile
+    if (!paused && instance->receives) {
+        NATIVE_schedule(NATIVE_get_time_us());
+    }
+}
+
+uint32_t UART_LL_get_max_baudrate(UART_Bus bus, bool oversampling_8)
+{
+    if (bus >= UART_BUS_COUNT) {
+        return 0;
+    }
+
+    uint32_t const div = oversampling_8 ? UART_DIV_MIN / 2 : UART_DIV_MIN;
+    return kernel_clock() / div;
+}
+
+void UART_LL_deinit(UART_Bus bus)
+{
+    if (bus >= UART_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!g_uart_instances[bus].initialized) {
+        return;
+    }
+
+    UARTInstance *instance = &g_uart_instances[bus];
+    if (instance->receives) {
+        if (instance->watched) {
+            NATIVE_unwatch(instance->fd);
+        }
+        close(instance->fd);
+    }
+    instance->fd = -1;
+    instance->rx_buffer_data = nullptr;
+    instance->rx_buffer_size = 0;
+    instance->tx_in_progress = false;
+    instance->tx_dma_size = 0;
+    instance->tx_complete_callback = nullptr;
+    instance->rx_complete_callback = nullptr;
+    instance->idle_callback = nullptr;
+    instance->rx_timeout_callback = nullptr;
+    instance->initialized = false;
+
+    if (!any_instance_initialized()) {
+        NATIVE_remove_handler(uart_handler);
+    }
+}
+
+void UART_LL_start_dma_tx(
+    UART_Bus bus,
+    uint8_t const *buffer,
+    uint32_t size
+)
+{
+    UART_LL_start_dma_tx_wrapped(bus, buffer, size, nullptr, 0);
+}
+
+void UART_LL_start_dma_tx_wrapped(
+    UART_Bus bus,
+    uint8_t const *first,
+    uint32_t first_size,
+    uint8_t const *second,
+    uint32_t second_size
+)
+{
+    if (bus >= UART_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!first || first_size == 0 || (!second && second_size > 0)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!g_uart_instances[bus].initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    UARTInstance *instance = &g_uart_instances[bus];
+    uint32_t const size = first_size + second_size;
+
+    // Without a program on the other side the bytes are lost, as on a line
+    // nobody listens to
+    instance->tx_spans[0] =
+        (struct iovec){ .iov_base = (void *)first, .iov_len = first_size };
+    instance->tx_spans[1] =
+        (struct iovec){ .iov_base = (void *)second, .iov_len = second_size };
+    if (!instance->loopback) {
+        (void)writev(instance->fd, instance->tx_spans, second_size > 0 ? 2 : 1);
+    }
+
+    instance->tx_in_progress = true;
+    instance->tx_dma_size = size;
+    instance->tx_done_us =
+        NATIVE_get_time_us() +
+        line_time_us(instance, (uint64_t)size * frame_bits(instance));
+    NATIVE_schedule(instance->tx_done_us);
+}
+
+uint32_t UART_LL_get_dma_position(UART_Bus bus)
+{
+    if (bus >= UART_BUS_COUNT || !g_uart_instances[bus].initialized) {
+        return 0;
+    }
+
+    return g_uart_instances[bus].rx_position;
+}
+
+bool UART_LL_tx_busy(UART_Bus bus)
+{
+    if (bus >= UART_BUS_COUNT || !g_uart_instances[bus].initialized) {
+        return false;
+    }
+
+    return g_uart_instances[bus].tx_in_progress;
+}
+
+void UART_LL_set_tx_complete_callback(
+    UART_Bus bus,
+    UART_LL_TxCompleteCallback callback
+)
+{
+    if (bus >= UART_BUS_COUNT) {
+        return;
+    }
+    g_uart_instances[bus].tx_complete_callback = callback;
+}
+
+void UART_LL_set_rx_complete_callback(
+    UART_Bus bus,
+    UART_LL_RxCompleteCallback callback
+)
+{
+    if (bus >= UART_BUS_COUNT) {
+        return;
+    }
+    g_uart_instances[bus].rx_complete_callback = callback;
+}
+
+void UART_LL_set_rx_timeout(
+    UART_Bus bus,
+    uint32_t bit_times,
+    UART_LL_IdleCallback callback
+)
+{
+    if (bus >= UART_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    UARTInstance *instance = &g_uart_instances[bus];
+    if (!instance->initialized) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (bit_times == 0 || callback == nullptr) {
+        instance->rx_timeout_bits = 0;
+        instance->rx_timeout_callback = nullptr;
+        return;
+    }
+
+    instance->rx_timeout_bits = bit_times;
+    instance->rx_timeout_callback = callback;
+}
+
+void UART_LL_set_idle_callback(UART_Bus bus, UART_LL_IdleCallback callback)
+{
+    if (bus >= UART_BUS_COUNT) {
+        return;
+    }
+    g_uart_instances[bus].idle_callback = callback;
+}
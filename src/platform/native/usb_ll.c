@@ -0,0 +1,531 @@
+/**
+ * @file usb_ll.c
+ * @brief Native USB interfaces, as pseudo-terminals
+ *
+ * Each interface is a pseudo-terminal, announced as usb<bus>, so that host
+ * software opens it like the CDC port of a real device. A program with the
+ * terminal open stands for a host with the port open: the interface is
+ * connected, with DTR and RTS set, and the line coding follows the speed
+ * and framing the program sets.
+ *
+ * Data passes through FIFOs of the sizes the device stack has on the
+ * target. Unlike the target, data left in the TX FIFO when the program
+ * closes the terminal is dropped, so that writers never wait on a port
+ * nobody reads.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "util/error.h"
+#include "util/si_prefix.h"
+#include "util/util.h"
+
+#include "native.h"
+#include "platform.h"
+#include "usb_ll.h"
+
+enum {
+    CDC_RX_FIFO_SIZE = 64, // As CFG_TUD_CDC_RX_BUFSIZE
+    CDC_TX_FIFO_SIZE = 64, // As CFG_TUD_CDC_TX_BUFSIZE
+    VENDOR_TX_FIFO_SIZE = 512, // As CFG_TUD_VENDOR_TX_BUFSIZE
+    ISO_FIFO_SIZE = 2048, // As on the target
+    TX_FIFO_SIZE_MAX = ISO_FIFO_SIZE,
+};
+
+static_assert(
+    CIRCULAR_BUFFER_SIZE_VALID(CDC_RX_FIFO_SIZE),
+    "CDC_RX_FIFO_SIZE must be a power of 2"
+);
+static_assert(
+    CIRCULAR_BUFFER_SIZE_VALID(TX_FIFO_SIZE_MAX),
+    "TX_FIFO_SIZE_MAX must be a power of 2"
+);
+
+typedef struct {
+    bool initialized;
+    bool connected; // A program has the terminal open
+    int fd; // Master side of the terminal
+    CircularBuffer rx;
+    CircularBuffer tx;
+    uint8_t rx_data[CDC_RX_FIFO_SIZE];
+    uint8_t tx_data[TX_FIFO_SIZE_MAX];
+    speed_t speed; // Line coding last reported
+    tcflag_t cflag;
+    USB_LL_LineStateCallback line_state_callback;
+    USB_LL_LineCodingCallback line_coding_callback;
+    USB_LL_EventCallback event_callback;
+} USBInstance;
+
+static USBInstance g_usb_instances[USB_BUS_COUNT] = { 0 };
+
+// Events for the event callbacks, as the USB interrupt would pend them
+static struct {
+    bool pending;
+    uint64_t last_event_ms; // Of the 1 ms heartbeat
+} g_events = { 0 };
+
+// Terminal speeds, for the line coding
+static struct {
+    speed_t speed;
+    uint32_t baudrate;
+} const g_speeds[] = {
+    { B1200, 1200 },       { B2400, 2400 },       { B4800, 4800 },
+    { B9600, 9600 },       { B19200, 19200 },     { B38400, 38400 },
+    { B57600, 57600 },     { B115200, 115200 },   { B230400, 230400 },
+    { B460800, 460800 },   { B500000, 500000 },   { B576000, 576000 },
+    { B921600, 921600 },   { B1000000, 1000000 }, { B1500000, 1500000 },
+    { B2000000, 2000000 }, { B3000000, 3000000 }, { B4000000, 4000000 },
+};
+
+static bool any_instance_initialized(void)
+{
+    for (size_t i = 0; i < USB_BUS_COUNT; ++i) {
+        if (g_usb_instances[i].initialized) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t USB_LL_tx_bufsize(USB_Bus const interface_id)
+{
+    if (interface_id == USB_BUS_4) {
+        return ISO_FIFO_SIZE;
+    }
+    if (interface_id == USB_BUS_1) {
+        return VENDOR_TX_FIFO_SIZE;
+    }
+    return CDC_TX_FIFO_SIZE;
+}
+
+/**
+ * @brief Report the speed and framing the program set on the terminal
+ */
+static void update_line_coding(USB_Bus bus)
+{
+    USBInstance *instance = &g_usb_instances[bus];
+    struct termios settings;
+
+    if (tcgetattr(instance->fd, &settings) != 0) {
+        return;
+    }
+
+    speed_t const speed = cfgetospeed(&settings);
+    tcflag_t const cflag =
+        settings.c_cflag & (CSIZE | CSTOPB | PARENB | PARODD);
+    if (speed == instance->speed && cflag == instance->cflag) {
+        return;
+    }
+    instance->speed = speed;
+    instance->cflag = cflag;
+
+    uint32_t baudrate = 0;
+    for (size_t i = 0; i < sizeof(g_speeds) / sizeof(g_speeds[0]); ++i) {
+        if (g_speeds[i].speed == speed) {
+            baudrate = g_speeds[i].baudrate;
+        }
+    }
+
+    static uint8_t const data_bits[] = { 5, 6, 7, 8 };
+    USB_LL_Parity parity = USB_LL_PARITY_NONE;
+    if ((cflag & PARENB) != 0) {
+        parity = (cflag & PARODD) != 0 ? USB_LL_PARITY_ODD
+                                       : USB_LL_PARITY_EVEN;
+    }
+    USB_LL_LineCoding const coding = {
+        .baudrate = baudrate,
+        .parity = parity,
+        .stop_bits = (cflag & CSTOPB) != 0 ? USB_LL_STOP_BITS_2
+                                           : USB_LL_STOP_BITS_1,
+        .data_bits = data_bits[(cflag & CSIZE) >> 4],
+    };
+    if (instance->line_coding_callback != nullptr) {
+        instance->line_coding_callback(bus, &coding);
+    }
+}
+
+/**
+ * @brief Track the program on the other side of the terminal
+ */
+static void set_connected(USB_Bus bus, bool connected)
+{
+    USBInstance *instance = &g_usb_instances[bus];
+    if (connected == instance->connected) {
+        return;
+    }
+
+    instance->connected = connected;
+    if (connected) {
+        NATIVE_watch(instance->fd);
+        // Report the line coding of the new program, even if unchanged
+        instance->speed = 0;
+        update_line_coding(bus);
+    } else {
+        NATIVE_unwatch(instance->fd);
+        circular_buffer_reset(&instance->tx);
+    }
+    if (instance->line_state_callback != nullptr) {
+        instance->line_state_callback(bus, connected, connected);
+    }
+    g_events.pending = true;
+}
+
+/**
+ * @brief Move received bytes into the RX FIFO
+ */
+static void receive(USB_Bus bus)
+{
+    USBInstance *instance = &g_usb_instances[bus];
+    uint8_t buf[CDC_RX_FIFO_SIZE];
+    uint32_t const space = circular_buffer_free_space(&instance->rx);
+
+    if (space == 0) {
+        return;
+    }
+
+    ssize_t const len = read(instance->fd, buf, space);
+    if (len > 0) {
+        circular_buffer_write(&instance->rx, buf, (uint32_t)len);
+        g_events.pending = true;
+    }
+}
+
+/**
+ * @brief Send what the TX FIFO holds, as far as the terminal takes it
+ *
+ * @return Bytes sent
+ */
+static uint32_t transmit(USB_Bus bus)
+{
+    USBInstance *instance = &g_usb_instances[bus];
+    uint32_t sent = 0;
+
+    if (!instance->connected) {
+        return 0;
+    }
+
+    for (;;) {
+        uint8_t const *data = nullptr;
+        uint32_t const len =
+            circular_buffer_peek_contiguous(&instance->tx, &data);
+        if (len == 0) {
+            break;
+        }
+
+        ssize_t const written = write(instance->fd, data, len);
+        if (written <= 0) {
+            break;
+        }
+        circular_buffer_commit_read(&instance->tx, (uint32_t)written);
+        sent += (uint32_t)written;
+    }
+    if (sent > 0) {
+        g_events.pending = true;
+    }
+    return sent;
+}
+
+/**
+ * @brief Poll the terminals of all interfaces, the way the device stack
+ * serves the bus
+ */
+static void poll_ports(void)
+{
+    struct pollfd fds[USB_BUS_COUNT];
+    USB_Bus buses[USB_BUS_COUNT];
+    nfds_t count = 0;
+
+    for (size_t i = 0; i < USB_BUS_COUNT; ++i) {
+        if (g_usb_instances[i].initialized) {
+            fds[count] = (struct pollfd){
+                .fd = g_usb_instances[i].fd,
+                .events = POLLIN,
+            };
+            buses[count++] = (USB_Bus)i;
+        }
+    }
+
+    if (count == 0 || poll(fds, count, 0) < 0) {
+        return;
+    }
+
+    for (nfds_t i = 0; i < count; ++i) {
+        USB_Bus const bus = buses[i];
+        set_connected(bus, (fds[i].revents & POLLHUP) == 0);
+        if (!g_usb_instances[bus].connected) {
+            continue;
+        }
+        if ((fds[i].revents & POLLIN) != 0) {
+            receive(bus);
+        }
+        transmit(bus);
+    }
+}
+
+/**
+ * @brief Emulated USB interrupt and deferred service
+ */
+static void usb_handler(uint64_t now_us)
+{
+    poll_ports();
+
+    uint64_t const now_ms = now_us / SI_KILO_INT;
+    bool heartbeat = false;
+    if (now_ms != g_events.last_event_ms) {
+        g_events.last_event_ms = now_ms;
+        heartbeat = true;
+        // Line coding changes come without input
+        for (size_t i = 0; i < USB_BUS_COUNT; ++i) {
+            if (g_usb_instances[i].connected) {
+                update_line_coding((USB_Bus)i);
+            }
+        }
+    }
+
+    if (!g_events.pending && !heartbeat) {
+        return;
+    }
+    g_events.pending = false;
+
+    for (size_t i = 0; i < USB_BUS_COUNT; ++i) {
+        USB_LL_EventCallback const callback =
+            g_usb_instances[i].event_callback;
+        if (g_usb_instances[i].initialized && callback) {
+            callback((USB_Bus)i);
+        }
+    }
+}
+
+void USB_LL_init(USB_Bus bus)
+{
+    if (bus >= USB_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (g_usb_instances[bus].initialized) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    // The isochronous interface takes the place of the bridge port
+    if (bus == (PSLAB_USB_ISO ? USB_BUS_3 : USB_BUS_4)) {
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+
+    char name[8];
+    snprintf(name, sizeof(name), "usb%u", (unsigned)bus);
+
+    USBInstance *instance = &g_usb_instances[bus];
+    instance->fd = NATIVE_open_port(name);
+    instance->connected = false;
+    circular_buffer_init(&instance->rx, instance->rx_data, CDC_RX_FIFO_SIZE);
+    circular_buffer_init(
+        &instance->tx, instance->tx_data, USB_LL_tx_bufsize(bus)
+    );
+    NATIVE_add_handler(usb_handler);
+    instance->initialized = true;
+}
+
+void USB_LL_deinit(USB_Bus bus)
+{
+    if (bus >= USB_BUS_COUNT || !g_usb_instances[bus].initialized) {
+        return;
+    }
+
+    USBInstance *instance = &g_usb_instances[bus];
+    if (instance->connected) {
+        NATIVE_unwatch(instance->fd);
+    }
+    close(instance->fd);
+    instance->fd = -1;
+    instance->connected = false;
+    instance->event_callback = nullptr;
+    instance->initialized = false;
+
+    if (!any_instance_initialized()) {
+        NATIVE_remove_handler(usb_handler);
+    }
+}
+
+size_t USB_LL_get_serial(uint16_t desc_str1[], size_t const max_chars)
+{
+    // The host ID stands in for the unique ID of the MCU
+    uint32_t const id = (uint32_t)gethostid();
+    uint8_t uid[USB_UUID_LEN] = { 'P', 'S', 'L', 'A', 'B', '-', 'N', 'A' };
+
+    uid[8] = (uint8_t)id;
+    uid[9] = (uint8_t)(id >> 8);
+    uid[10] = (uint8_t)(id >> 16);
+    uid[11] = (uint8_t)(id >> 24);
+
+    size_t uid_len = USB_UUID_LEN;
+    uid_len = uid_len > max_chars / 2 ? max_chars / 2 : uid_len;
+
+    static char const nibble_to_hex[16] = {
+        '0', '1', '2', '3', '4', '5', '6', '7',
+        '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+    };
+
+    for (size_t i = 0; i < uid_len; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            uint8_t const nibble = (uid[i] >> (j * 4)) & 0xf;
+            desc_str1[(i * 2) + (1 - j)] = nibble_to_hex[nibble]; // UTF-16-LE
+        }
+    }
+
+    return 2 * uid_len;
+}
+
+uint32_t USB_LL_rx_available(USB_Bus const interface_id)
+{
+    if (interface_id >= USB_BUS_COUNT) {
+        return 0;
+    }
+    return circular_buffer_available(&g_usb_instances[interface_id].rx);
+}
+
+uint32_t USB_LL_tx_available(USB_Bus const interface_id)
+{
+    if (interface_id >= USB_BUS_COUNT ||
+        !g_usb_instances[interface_id].initialized) {
+        return 0;
+    }
+    // Data written without a stream would be stale once it starts
+    if (interface_id == USB_BUS_4 && !g_usb_instances[interface_id].connected) {
+        return 0;
+    }
+    return circular_buffer_free_space(&g_usb_instances[interface_id].tx);
+}
+
+uint32_t USB_LL_read(USB_Bus const interface_id, uint8_t *buf, uint32_t bufsize)
+{
+    if (interface_id >= USB_BUS_COUNT) {
+        return 0;
+    }
+
+    USBInstance *instance = &g_usb_instances[interface_id];
+    uint32_t const len = circular_buffer_read(&instance->rx, buf, bufsize);
+
+    // Room in the FIFO lets the next packet in
+    if (len > 0 && instance->connected) {
+        receive(interface_id);
+    }
+    return len;
+}
+
+uint32_t USB_LL_write(
+    USB_Bus const interface_id,
+    uint8_t const *buf,
+    uint32_t bufsize
+)
+{
+    if (USB_LL_tx_available(interface_id) == 0) {
+        return 0;
+    }
+
+    USBInstance *instance = &g_usb_instances[interface_id];
+    uint32_t const written = circular_buffer_write(&instance->tx, buf, bufsize);
+
+    // The stack sends full packets without waiting for a flush
+    if (circular_buffer_available(&instance->tx) >= CDC_TX_FIFO_SIZE) {
+        transmit(interface_id);
+    }
+    return written;
+}
+
+uint32_t USB_LL_tx_flush(USB_Bus const interface_id)
+{
+    if (interface_id >= USB_BUS_COUNT ||
+        !g_usb_instances[interface_id].initialized) {
+        return 0;
+    }
+    return transmit(interface_id);
+}
+
+bool USB_LL_notify(USB_Bus const interface_id, uint16_t const state)
+{
+    (void)state;
+    if (interface_id == USB_BUS_1 || interface_id >= USB_BUS_4) {
+        return false;
+    }
+    // A terminal has no serial state notifications to carry them
+    return g_usb_instances[interface_id].connected;
+}
+
+void USB_LL_task(USB_Bus const interface_id)
+{
+    (void)interface_id;
+    uint32_t const state = PLATFORM_disable_interrupts();
+    poll_ports();
+    PLATFORM_restore_interrupts(state);
+}
+
+bool USB_LL_connected(USB_Bus const interface_id)
+{
+    if (interface_id >= USB_BUS_COUNT) {
+        return false;
+    }
+    return g_usb_instances[interface_id].connected;
+}
+
+void USB_LL_set_line_state_callback(
+    USB_Bus const interface_id,
+    USB_LL_LineStateCallback callback
+)
+{
+    if (interface_id < USB_BUS_COUNT) {
+        g_usb_instances[interface_id].line_state_callback = callback;
+    }
+}
+
+void USB_LL_set_line_coding_callback(
+    USB_Bus const interface_id,
+    USB_LL_LineCodingCallback callback
+)
+{
+    if (interface_id < USB_BUS_COUNT) {
+        g_usb_instances[interface_id].line_coding_callback = callback;
+    }
+}
+
+void USB_LL_set_event_callback(
+    USB_Bus const interface_id,
+    USB_LL_EventCallback callback
+)
+{
+    if (interface_id < USB_BUS_COUNT) {
+        g_usb_instances[interface_id].event_callback = callback;
+    }
+}
+
+bool USB_LL_get_frame_stamp(uint32_t *frame, uint32_t *time_us)
+{
+    if (!any_instance_initialized()) {
+        return false;
+    }
+
+    // Frames start on the milliseconds of the native clock
+    uint64_t const frame_count = NATIVE_get_time_us() / 1000U;
+    *frame = (uint32_t)frame_count;
+    *time_us = (uint32_t)(frame_count * 1000U);
+    return true;
+}
+
+void USB_LL_request_service(USB_Bus const interface_id)
+{
+    (void)interface_id;
+    g_events.pending = true;
+    NATIVE_request_service();
+}
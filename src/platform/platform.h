@@ -19,6 +19,8 @@
 #ifndef PSLAB_LL_PLATFORM_H
 #define PSLAB_LL_PLATFORM_H
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -47,6 +49,43 @@ void PLATFORM_init(void);
  */
 uint32_t PLATFORM_get_tick(void);
 
+/**
+ * @brief Get a microsecond timestamp
+ *
+ * Combines the millisecond tick with the SysTick counter, so it is safe to
+ * call from interrupt context. Wraps around after about 71 minutes.
+ *
+ * @return The time since startup in microseconds
+ */
+uint32_t PLATFORM_get_time_us(void);
+
+/**
+ * @brief Get a 64-bit microsecond timestamp
+ *
+ * Like PLATFORM_get_time_us, but only wraps around with the millisecond
+ * tick, after about 49 days.
+ *
+ * @return The time since startup in microseconds
+ */
+uint64_t PLATFORM_get_time_us64(void);
+
+/**
+ * @brief Get the CPU cycle counter
+ *
+ * Counts core clock cycles since PLATFORM_init and wraps around, after
+ * about 17 s at 250 MHz. Safe to call from interrupt context.
+ *
+ * @return The current cycle count
+ */
+uint32_t PLATFORM_get_cycles(void);
+
+/**
+ * @brief Get the rate of the CPU cycle counter
+ *
+ * @return The core clock frequency in Hz
+ */
+uint32_t PLATFORM_get_cycle_frequency(void);
+
 typedef enum {
     PLATFORM_CLOCK_ADC1 = 0,
     PLATFORM_CLOCK_ADC2 = 1,
@@ -60,6 +99,7 @@ typedef enum {
     PLATFORM_CLOCK_TIMER8 = 9,
     PLATFORM_CLOCK_TIMER16 = 10,
     PLATFORM_CLOCK_TIMER17 = 11,
+    PLATFORM_CLOCK_TIMER15 = 12,
     PLATFORM_CLOCK_INVALID = 0xFFFF
 } PLATFORM_PeripheralClock;
 
@@ -77,6 +117,126 @@ typedef enum {
  */
 uint32_t PLATFORM_get_peripheral_clock_speed(PLATFORM_PeripheralClock clock);
 
+/**
+ * @brief Core and bus clock speeds
+ */
+typedef enum {
+    PLATFORM_CLOCK_SPEED_FULL = 0, // 250 MHz core, AHB and APB clocks
+    PLATFORM_CLOCK_SPEED_LOW, // 31.25 MHz, for idle periods
+} PLATFORM_ClockSpeed;
+
+/**
+ * @brief Scale the core and bus clocks
+ *
+ * Only the AHB prescaler changes, PLL1 keeps running, so switching takes a
+ * few cycles once the current millisecond tick has passed, after which the
+ * SysTick is reloaded for the new clock. Timers clocked from the APB buses
+ * change speed with it and must be configured, through
+ * PLATFORM_get_peripheral_clock_speed, at the speed they are run at. USB,
+ * the UARTs and the ADCs have kernel clocks of their own and keep their
+ * rates.
+ *
+ * Not to be called from interrupt context.
+ *
+ * @param speed Clock speed to switch to
+ *
+ * @throws ERROR_INVALID_ARGUMENT if speed is not a PLATFORM_ClockSpeed value
+ * @throws ERROR_HARDWARE_FAULT if the clock configuration fails
+ */
+void PLATFORM_set_clock_speed(PLATFORM_ClockSpeed speed);
+
+/**
+ * @brief Get the current core and bus clock speed
+ *
+ * @return Speed set by PLATFORM_set_clock_speed, full after PLATFORM_init
+ */
+PLATFORM_ClockSpeed PLATFORM_get_clock_speed(void);
+
+enum {
+    PLATFORM_ADC_CLOCK_SOURCE_HZ = 300000000, // PLL2 VCO, divided by PLL2R
+    PLATFORM_ADC_CLOCK_DIVIDER_MIN = 4, // 75 MHz, the ADC kernel clock limit
+    PLATFORM_ADC_CLOCK_DIVIDER_MAX = 128, // 2.34 MHz
+    PLATFORM_ADC_CLOCK_DIVIDER_DEFAULT = 4, // Set by PLATFORM_init
+};
+
+/**
+ * @brief Set the ADC kernel clock divider
+ *
+ * The ADC kernel clock is PLATFORM_ADC_CLOCK_SOURCE_HZ divided by the PLL2R
+ * divider. PLL2 has to be stopped to change it; it is restarted with its VCO
+ * and Q output unchanged, so the UART kernel clocks pause for the lock time,
+ * some tens of microseconds, and keep their rates. Setting the current
+ * divider again changes nothing.
+ *
+ * Only to be called while the ADCs are disabled, not from interrupt context.
+ *
+ * @param divider PLL2R divider, PLATFORM_ADC_CLOCK_DIVIDER_MIN to
+ *                PLATFORM_ADC_CLOCK_DIVIDER_MAX
+ *
+ * @throws ERROR_INVALID_ARGUMENT if divider is out of range
+ * @throws ERROR_HARDWARE_FAULT if PLL2 fails to lock
+ */
+void PLATFORM_set_adc_clock_divider(uint32_t divider);
+
+/**
+ * @brief Get the ADC kernel clock divider
+ *
+ * @return Divider set by PLATFORM_set_adc_clock_divider, the default after
+ *         PLATFORM_init
+ */
+uint32_t PLATFORM_get_adc_clock_divider(void);
+
+/**
+ * @brief Mask all maskable interrupts
+ *
+ * Interrupts stay pending while masked and are taken once the previous state
+ * is restored. Calls nest; each must be paired with
+ * PLATFORM_restore_interrupts.
+ *
+ * @return Previous interrupt mask state
+ */
+uint32_t PLATFORM_disable_interrupts(void);
+
+/**
+ * @brief Restore the interrupt mask state
+ *
+ * @param state Value returned by the matching PLATFORM_disable_interrupts
+ */
+void PLATFORM_restore_interrupts(uint32_t state);
+
+/**
+ * @brief Priority in effect of an interrupt used by the firmware
+ */
+typedef struct {
+    char const *name; // Handler name without the _IRQHandler suffix
+    uint8_t priority; // Preemption priority, 0 the highest
+    bool enabled; // Enabled in the NVIC; always true for system handlers
+} PLATFORM_IrqInfo;
+
+/**
+ * @brief Read back the NVIC configuration of the firmware's interrupts
+ *
+ * Lists every interrupt a driver sets up, from the highest planned
+ * priority to the lowest, with the priority the NVIC holds now rather
+ * than the planned one, so that a driver that strays from the plan shows.
+ * Drivers set up their interrupts when first initialized; until then they
+ * read as disabled, at priority 0.
+ *
+ * @param[out] info Array for the entries
+ * @param max Capacity of info
+ * @return Number of entries written, at most max
+ */
+size_t PLATFORM_get_irq_info(PLATFORM_IrqInfo *info, size_t max);
+
+/**
+ * @brief Sleep the core until an interrupt is pending
+ *
+ * Wakes up on pending interrupts even while they are masked, so a caller can
+ * check for work with interrupts disabled and sleep without missing an
+ * interrupt that arrives in between.
+ */
+void PLATFORM_wait_for_interrupt(void);
+
 /**
  * @brief Reset the platform/system
  *
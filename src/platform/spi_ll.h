@@ -0,0 +1,172 @@
+/**
+ * @file spi_ll.h
+ * @brief Low-level SPI hardware interface
+ *
+ * This header provides the low-level hardware interface to the SPI bus. It
+ * defines the API for initializing the SPI peripheral as bus controller,
+ * starting full-duplex DMA transfers framed by the chip select, and
+ * registering a callback for their completion. A transfer runs without the
+ * CPU from its start to the completion callback, which is called from
+ * interrupt context.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_SPI_LL_H
+#define PSLAB_SPI_LL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief SPI bus instance enumeration
+ */
+typedef enum { SPI_BUS_0 = 0, SPI_BUS_COUNT = 1 } SPI_Bus;
+
+enum {
+    /** @brief Clock rate set by SPI_LL_init, in Hz */
+    SPI_LL_SPEED_DEFAULT = 1000000,
+    /** @brief Lowest clock rate, the kernel clock divided by 256, in Hz */
+    SPI_LL_SPEED_MIN = 976562,
+    /** @brief Highest clock rate, in Hz */
+    SPI_LL_SPEED_MAX = 62500000,
+    /** @brief Most bytes moved by one transfer */
+    SPI_LL_TRANSFER_MAX = 0xFFFF,
+};
+
+/**
+ * @brief Clock polarity and phase, in the usual mode numbering
+ */
+typedef enum {
+    SPI_LL_MODE_0 = 0, // Clock idles low, data sampled on the rising edge
+    SPI_LL_MODE_1, // Clock idles low, data sampled on the falling edge
+    SPI_LL_MODE_2, // Clock idles high, data sampled on the falling edge
+    SPI_LL_MODE_3, // Clock idles high, data sampled on the rising edge
+} SPI_LL_Mode;
+
+/**
+ * @brief Bus settings
+ */
+typedef struct {
+    uint32_t speed; // Highest clock rate wanted, in Hz
+    SPI_LL_Mode mode;
+    bool lsb_first; // Least significant bit first, else most
+} SPI_LL_Config;
+
+/**
+ * @brief Outcome of a transfer
+ */
+typedef enum {
+    SPI_LL_STATUS_OK = 0,
+    SPI_LL_STATUS_BUS_ERROR, // Overrun or mode fault
+    SPI_LL_STATUS_DMA_ERROR,
+} SPI_LL_Status;
+
+/**
+ * @brief A full-duplex transfer
+ *
+ * The chip select is driven low before the first byte. It goes high after
+ * the last one unless hold_cs is set, so that the next transfer continues
+ * the same command, e.g. a flash page after its program command.
+ */
+typedef struct {
+    uint8_t const *tx; // Bytes to send, or nullptr to send 0xFF
+    uint8_t *rx; // Bytes received, or nullptr to discard them
+    uint32_t size; // Bytes in each direction, 1 to SPI_LL_TRANSFER_MAX
+    bool hold_cs; // Keep the chip select low after the transfer
+} SPI_LL_Transfer;
+
+/**
+ * @brief Callback function type for completed transfers
+ *
+ * @param bus SPI bus instance
+ * @param status Outcome of the transfer
+ */
+typedef void (*SPI_LL_CompleteCallback)(SPI_Bus bus, SPI_LL_Status status);
+
+/**
+ * @brief Initialize the SPI peripheral as bus controller
+ *
+ * Starts in mode 0, most significant bit first, at SPI_LL_SPEED_DEFAULT,
+ * with the chip select high.
+ *
+ * @param bus SPI bus instance to initialize
+ *
+ * @throws ERROR_INVALID_ARGUMENT if bus is invalid
+ * @throws ERROR_RESOURCE_BUSY if the bus is already initialized
+ * @throws ERROR_HARDWARE_FAULT if the peripheral cannot be configured
+ */
+void SPI_LL_init(SPI_Bus bus);
+
+/**
+ * @brief Deinitialize the SPI peripheral
+ *
+ * A transfer in progress is aborted without a completion callback, and the
+ * chip select is released.
+ *
+ * @param bus SPI bus instance to deinitialize
+ */
+void SPI_LL_deinit(SPI_Bus bus);
+
+/**
+ * @brief Change the settings of an idle bus
+ *
+ * The clock rate is the kernel clock divided by a power of two, the
+ * highest that does not exceed the one wanted.
+ *
+ * @param bus SPI bus instance
+ * @param config Settings, with speed from SPI_LL_SPEED_MIN to
+ *               SPI_LL_SPEED_MAX
+ * @return Clock rate reached, in Hz
+ *
+ * @throws ERROR_INVALID_ARGUMENT if bus or config is invalid
+ * @throws ERROR_DEVICE_NOT_READY if the bus is not initialized
+ * @throws ERROR_RESOURCE_BUSY if a transfer is in progress, or the chip
+ *         select is held
+ * @throws ERROR_HARDWARE_FAULT if the peripheral cannot be reconfigured
+ */
+uint32_t SPI_LL_configure(SPI_Bus bus, SPI_LL_Config const *config);
+
+/**
+ * @brief Start a DMA transfer
+ *
+ * Returns at once; the completion callback reports the outcome.
+ *
+ * @param bus SPI bus instance
+ * @param transfer Transfer to run; copied, but not its data
+ *
+ * @throws ERROR_INVALID_ARGUMENT if bus or transfer is invalid
+ * @throws ERROR_DEVICE_NOT_READY if the bus is not initialized
+ * @throws ERROR_RESOURCE_BUSY if a transfer is in progress
+ * @throws ERROR_HARDWARE_FAULT if the transfer cannot be started
+ */
+void SPI_LL_start(SPI_Bus bus, SPI_LL_Transfer const *transfer);
+
+/**
+ * @brief Release a chip select held by the last transfer
+ *
+ * @param bus SPI bus instance
+ */
+void SPI_LL_release_cs(SPI_Bus bus);
+
+/**
+ * @brief Check if a transfer is in progress
+ *
+ * @param bus SPI bus instance
+ * @return true from SPI_LL_start until the completion callback
+ */
+bool SPI_LL_busy(SPI_Bus bus);
+
+/**
+ * @brief Set the transfer complete callback function
+ *
+ * @param bus SPI bus instance
+ * @param callback Callback function, called at the end of each transfer
+ */
+void SPI_LL_set_complete_callback(
+    SPI_Bus bus,
+    SPI_LL_CompleteCallback callback
+);
+
+#endif /* PSLAB_SPI_LL_H */
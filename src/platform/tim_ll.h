@@ -14,20 +14,68 @@
 #ifndef PSLAB_TIM_LL_H
 #define PSLAB_TIM_LL_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "util/error.h"
+
 /*
  * @brief TIM instance enumeration
  */
-typedef enum { TIM_NUM_6 = 0, TIM_NUM_7 = 1, TIM_NUM_COUNT = 2 } TIM_Num;
+typedef enum {
+    TIM_NUM_6 = 0,
+    TIM_NUM_7 = 1,
+    TIM_NUM_1 = 2,
+    TIM_NUM_2 = 3,
+    TIM_NUM_3 = 4,
+    TIM_NUM_4 = 5,
+    TIM_NUM_8 = 6,
+    TIM_NUM_15 = 7,
+    TIM_NUM_COUNT = 8
+} TIM_Num;
+
+/**
+ * @brief Capture/compare channel of a timer
+ */
+typedef enum {
+    TIM_LL_CHANNEL_1 = 0,
+    TIM_LL_CHANNEL_2 = 1,
+    TIM_LL_CHANNEL_3 = 2,
+    TIM_LL_CHANNEL_4 = 3,
+    TIM_LL_CHANNEL_COUNT = 4
+} TIM_LL_Channel;
 
 /**
  * @brief Initialize the Timer Module
  *
+ * The prescaler and auto-reload values are chosen to minimise the error
+ * from the requested frequency. Most frequencies cannot be hit exactly, so
+ * callers that depend on the exact rate should use the returned value.
+ *
  * @param tim Timer instance
  * @param freq Frequency for the timer
+ * @return Achieved frequency in Hz, rounded to nearest
+ *
+ * @throws ERROR_INVALID_ARGUMENT if the frequency is zero or out of range
+ */
+uint32_t TIM_LL_init(TIM_Num tim, uint32_t freq);
+
+/**
+ * @brief Change the frequency of an initialized timer
+ *
+ * Recomputes the prescaler and auto-reload values like TIM_LL_init and
+ * loads them immediately, without reinitializing the peripheral. Loading the
+ * prescaler generates an update event, and with it a trigger output, so the
+ * triggered peripheral should not be armed.
+ *
+ * @param tim Timer instance
+ * @param freq New frequency for the timer
+ * @return Achieved frequency in Hz, rounded to nearest
+ *
+ * @throws ERROR_INVALID_ARGUMENT if the frequency is zero or out of range
+ * @throws ERROR_RESOURCE_UNAVAILABLE if the timer is not initialized
  */
-void TIM_LL_init(TIM_Num tim, uint32_t freq);
+uint32_t TIM_LL_set_frequency(TIM_Num tim, uint32_t freq);
 
 /**
  * @brief Deinitialize the Timer Module
@@ -39,10 +87,26 @@ void TIM_LL_deinit(TIM_Num tim);
 /**
  * @brief Start the Timer Module
  *
+ * While a synchronized start is armed, see TIM_LL_sync_arm, the timer is
+ * held for it instead.
+ *
  * @param tim TIM instance instance
+ *
+ * @throws ERROR_RESOURCE_UNAVAILABLE if held while not initialized
+ * @throws ERROR_HARDWARE_FAULT if the timer cannot be started
  */
 void TIM_LL_start(TIM_Num tim);
 
+/**
+ * @brief Start the Timer Module, returning failures instead of throwing
+ *
+ * Same as TIM_LL_start, for callers on the acquisition path.
+ *
+ * @param tim TIM instance instance
+ * @return ERROR_NONE, or the error TIM_LL_start would throw
+ */
+Error TIM_LL_try_start(TIM_Num tim);
+
 /**
  * @brief Stop the Timer Module
  *
@@ -50,4 +114,178 @@ void TIM_LL_start(TIM_Num tim);
  */
 void TIM_LL_stop(TIM_Num tim);
 
+/**
+ * @brief Hold the starts of the timers for a synchronized start
+ *
+ * Until TIM_LL_sync_start or TIM_LL_sync_cancel, TIM_LL_start only marks
+ * the timer to be started, so instruments can be set up and started one
+ * after another as usual and begin together. TIM_LL_stop and
+ * TIM_LL_deinit unmark it.
+ *
+ * Basic timers have no slave mode controller, and trigger outputs already
+ * pace the ADC and DAC, so the timers cannot be chained to a master timer.
+ */
+void TIM_LL_sync_arm(void);
+
+/**
+ * @brief Start the timers held since TIM_LL_sync_arm together
+ *
+ * The counters restart from zero and run within a few bus clocks of one
+ * another; a timer's triggered peripheral sees no event before its first
+ * period ends.
+ *
+ * With the trigger input enabled, the timers are left held and start on
+ * its next rising edge instead, see TIM_LL_sync_set_trigger_input; the
+ * trigger output still rises.
+ *
+ * @return Number of timers started, or held for the trigger input
+ *
+ * @throws ERROR_RESOURCE_UNAVAILABLE if no synchronized start is armed
+ */
+uint32_t TIM_LL_sync_start(void);
+
+/**
+ * @brief Start the held timers at once, from interrupt context
+ *
+ * For a start on an event another peripheral's interrupt has seen. Like a
+ * start on the trigger input edge, it ignores the trigger input setting
+ * and raises the trigger output just before the timers.
+ *
+ * @return Number of timers started, 0 if no synchronized start is armed
+ */
+uint32_t TIM_LL_sync_fire(void);
+
+/**
+ * @brief Number of timers held for the synchronized start
+ */
+uint32_t TIM_LL_sync_held(void);
+
+/**
+ * @brief Drop an armed synchronized start
+ *
+ * The held timers stay stopped, and TIM_LL_start starts timers again.
+ */
+void TIM_LL_sync_cancel(void);
+
+/**
+ * @brief Check if timer starts are held for a synchronized start
+ *
+ * @return true between TIM_LL_sync_arm and TIM_LL_sync_start or
+ *         TIM_LL_sync_cancel
+ */
+bool TIM_LL_sync_is_armed(void);
+
+/**
+ * @brief Start held timers on a rising edge at the trigger input pin
+ *
+ * For boards sampling together: the trigger output of one board drives
+ * the trigger input of all, itself included, and each starts its timers
+ * on the same edge. The start is then over once the edge is seen, whether
+ * or not TIM_LL_sync_start was called. Edges while not armed are ignored.
+ *
+ * @param enable Whether the trigger input starts the held timers
+ */
+void TIM_LL_sync_set_trigger_input(bool enable);
+
+/**
+ * @brief Drive the trigger output pin
+ *
+ * The output goes low on TIM_LL_sync_arm and high on TIM_LL_sync_start,
+ * just before the timers start. Released when disabled.
+ *
+ * @param enable Whether the trigger output is driven
+ */
+void TIM_LL_sync_set_trigger_output(bool enable);
+
+/**
+ * @brief Request a DMA transfer on each update event of the timer
+ *
+ * Lets a timer pace DMA transfers directly, without an ADC in between.
+ *
+ * @param tim Initialized timer
+ * @param enable Whether update events request DMA transfers
+ */
+void TIM_LL_set_update_dma(TIM_Num tim, bool enable);
+
+/**
+ * @brief Counts of the timer per period
+ *
+ * Compare values of PWM pulses are in these counts.
+ *
+ * @param tim Timer instance
+ * @return Auto-reload value plus one, 0 if not initialized
+ */
+uint32_t TIM_LL_get_period(TIM_Num tim);
+
+/**
+ * @brief Set up a PWM output on a pair of channels
+ *
+ * The output is channel 1 or 3, in combined PWM mode with channel 2 or 4,
+ * so that a pulse may start anywhere in the period. Its pin is taken over
+ * with the output disabled; TIM_LL_deinit returns it.
+ *
+ * @param tim Initialized timer with four channels
+ * @param channel TIM_LL_CHANNEL_1 or TIM_LL_CHANNEL_3
+ *
+ * @throws ERROR_INVALID_ARGUMENT if the channel is not an output of a pair
+ *         or has no output pin
+ * @throws ERROR_RESOURCE_UNAVAILABLE if the timer is not initialized
+ * @throws ERROR_HARDWARE_FAULT if the channel cannot be configured
+ */
+void TIM_LL_pwm_init(TIM_Num tim, TIM_LL_Channel channel);
+
+/**
+ * @brief Set the pulse of a PWM output
+ *
+ * The output is high from count start for width counts, wrapping into the
+ * next period. The compare values are preloaded, so a running output
+ * changes at the next period without a glitch, unless the pulse starts or
+ * stops wrapping, and a stopped one at once.
+ *
+ * @param tim Timer instance
+ * @param channel Output set up by TIM_LL_pwm_init
+ * @param start Count the pulse rises at, below TIM_LL_get_period
+ * @param width Counts the pulse lasts; a period or more is always high
+ *
+ * @throws ERROR_INVALID_ARGUMENT if the channel is not an output of a pair
+ *         or start is out of the period
+ */
+void TIM_LL_pwm_set_pulse(
+    TIM_Num tim,
+    TIM_LL_Channel channel,
+    uint32_t start,
+    uint32_t width
+);
+
+/**
+ * @brief Drive the pin of a PWM output, or leave it undriven
+ *
+ * @param tim Timer instance
+ * @param channel Output set up by TIM_LL_pwm_init
+ * @param enable Whether the pin is driven
+ */
+void TIM_LL_pwm_enable(TIM_Num tim, TIM_LL_Channel channel, bool enable);
+
+/**
+ * @brief Claim a free timer for triggering ADC conversions
+ *
+ * Lets instruments that run at the same time each own a timer. A timer is
+ * free if it is neither claimed nor initialized. Every timer except TIM7
+ * can trigger the ADC; see ADC_LL_get_timer_trigger.
+ *
+ * @return The claimed timer
+ *
+ * @throws ERROR_RESOURCE_UNAVAILABLE if all timers are in use
+ */
+TIM_Num TIM_LL_claim(void);
+
+/**
+ * @brief Return a claimed timer to the pool
+ *
+ * The timer should be deinitialized first.
+ *
+ * @param tim Timer returned by TIM_LL_claim
+ */
+void TIM_LL_release(TIM_Num tim);
+
 #endif // PSLAB_TIM_LL_H
\ No newline at end of file
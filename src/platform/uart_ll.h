@@ -25,10 +25,42 @@ typedef enum {
 } UART_Bus;
 
 /**
- * @brief Default (and currently only supported) UART baudrate
+ * @brief Baudrate set by UART_LL_init
  */
 enum { UART_DEFAULT_BAUDRATE = 115200 };
 
+/**
+ * @brief UART parity
+ *
+ * Frames always carry 8 data bits; the parity bit comes in addition.
+ */
+typedef enum {
+    UART_LL_PARITY_NONE = 0,
+    UART_LL_PARITY_EVEN,
+    UART_LL_PARITY_ODD,
+} UART_LL_Parity;
+
+/**
+ * @brief UART stop bits
+ */
+typedef enum {
+    UART_LL_STOP_BITS_1 = 0,
+    UART_LL_STOP_BITS_2,
+} UART_LL_StopBits;
+
+/**
+ * @brief UART line settings
+ */
+typedef struct {
+    uint32_t baudrate; // Bits per second
+    UART_LL_Parity parity;
+    UART_LL_StopBits stop_bits;
+    bool oversampling_8; // Sample bits 8 times instead of 16; doubles the
+                         // highest baudrate at the cost of noise tolerance
+    bool flow_control; // RTS/CTS handshake; not on UART_BUS_0, whose
+                       // flow control pins carry USB
+} UART_LL_LineConfig;
+
 /**
  * @brief Initialize the UART peripheral and start DMA-based reception.
  *
@@ -38,6 +70,67 @@ enum { UART_DEFAULT_BAUDRATE = 115200 };
  */
 void UART_LL_init(UART_Bus bus, uint8_t *rx_buf, uint32_t sz);
 
+/**
+ * @brief Change the line settings of an initialized UART.
+ *
+ * Reception restarts at the beginning of the RX buffer; bytes received but
+ * not yet read are lost.
+ *
+ * @param bus UART bus instance
+ * @param config Line settings
+ *
+ * @throws ERROR_INVALID_ARGUMENT if bus or config is invalid, if the
+ *         baudrate cannot be generated from the UART clock, or if the bus
+ *         has no flow control pins
+ * @throws ERROR_DEVICE_NOT_READY if the bus is not initialized
+ * @throws ERROR_RESOURCE_BUSY if a transmission is in progress
+ * @throws ERROR_HARDWARE_FAULT if the peripheral cannot be reconfigured
+ */
+void UART_LL_configure(UART_Bus bus, UART_LL_LineConfig const *config);
+
+/**
+ * @brief Connect the transmitter of a UART to its own receiver.
+ *
+ * For self-tests. The receiver listens to the transmitter inside the
+ * USART, in single-wire half-duplex mode: the TX pin still carries the
+ * data, and the RX pin is not used. Reception restarts at the beginning of
+ * the RX buffer, as with UART_LL_configure; the setting is kept across
+ * UART_LL_configure, and UART_LL_init clears it. Flow control is off while
+ * looped back.
+ *
+ * @param bus UART bus instance
+ * @param enable true to loop back, false for normal operation
+ *
+ * @throws ERROR_INVALID_ARGUMENT if bus is invalid
+ * @throws ERROR_DEVICE_NOT_READY if the bus is not initialized
+ * @throws ERROR_RESOURCE_BUSY if a transmission is in progress
+ * @throws ERROR_HARDWARE_FAULT if the peripheral cannot be reconfigured
+ */
+void UART_LL_set_loopback(UART_Bus bus, bool enable);
+
+/**
+ * @brief Pause or resume moving received bytes into the RX buffer.
+ *
+ * While paused, the DMA keeps its position and received bytes wait in the
+ * USART; with flow control, the USART deasserts RTS once it holds a byte
+ * nobody takes, so the sender stops. UART_LL_configure and
+ * UART_LL_set_loopback resume. Safe to call from interrupt context; does
+ * nothing for an invalid or uninitialized bus.
+ *
+ * @param bus UART bus instance
+ * @param paused true to pause, false to resume
+ */
+void UART_LL_set_rx_paused(UART_Bus bus, bool paused);
+
+/**
+ * @brief Get the highest baudrate a UART can generate.
+ *
+ * @param bus UART bus instance
+ * @param oversampling_8 true for 8x oversampling, false for 16x
+ * @return Highest baudrate, or 0 for an invalid bus
+ */
+uint32_t UART_LL_get_max_baudrate(UART_Bus bus, bool oversampling_8);
+
 /**
  * @brief Deinitialize the UART peripheral.
  *
@@ -68,7 +161,32 @@ bool UART_LL_tx_busy(UART_Bus bus);
  * @param buffer Pointer to the data to transmit
  * @param size Number of bytes to transmit
  */
-void UART_LL_start_dma_tx(UART_Bus bus, uint8_t *buffer, uint32_t size);
+void UART_LL_start_dma_tx(
+    UART_Bus bus,
+    uint8_t const *buffer,
+    uint32_t size
+);
+
+/**
+ * @brief Start a UART DMA transmission of two spans, back to back
+ *
+ * Sends data that wraps around the end of a ring buffer in one transfer,
+ * without a gap on the line or a completion in between. The TX complete
+ * callback is called once, with the size of both spans.
+ *
+ * @param bus UART bus instance
+ * @param first Pointer to the data to transmit first
+ * @param first_size Number of bytes at first
+ * @param second Pointer to the data to transmit after it
+ * @param second_size Number of bytes at second
+ */
+void UART_LL_start_dma_tx_wrapped(
+    UART_Bus bus,
+    uint8_t const *first,
+    uint32_t first_size,
+    uint8_t const *second,
+    uint32_t second_size
+);
 
 /**
  * @brief Callback function type for completed transmissions
@@ -105,14 +223,40 @@ void UART_LL_set_tx_complete_callback(
 
 /**
  * @brief Set the RX complete callback function
+ *
+ * Reception is circular: the DMA wraps around to the start of the buffer
+ * by itself, and the callback is called each time it has filled half and
+ * all of the buffer. Read UART_LL_get_dma_position to find the new data.
+ *
  * @param bus UART bus instance
- * @param callback Callback function to call when RX buffer is full
+ * @param callback Callback function to call at half and full buffer
  */
 void UART_LL_set_rx_complete_callback(
     UART_Bus bus,
     UART_LL_RxCompleteCallback callback
 );
 
+/**
+ * @brief Enable or disable the hardware receiver timeout
+ *
+ * After the line has been quiet for the given number of bit times since the
+ * last received character, the callback is called from the UART interrupt.
+ * It is called once per quiet period. Reinitializing the UART disables the
+ * timeout.
+ *
+ * @param bus UART bus instance
+ * @param bit_times Quiet time in bit times, at most 0xFFFFFF; 0 disables
+ * @param callback Callback function, or nullptr to disable
+ *
+ * @throws ERROR_INVALID_ARGUMENT if bus is invalid
+ * @throws ERROR_DEVICE_NOT_READY if the bus is not initialized
+ */
+void UART_LL_set_rx_timeout(
+    UART_Bus bus,
+    uint32_t bit_times,
+    UART_LL_IdleCallback callback
+);
+
 /**
  * @brief Set the idle line callback function
  * @param bus UART bus instance
@@ -9,7 +9,13 @@
  * derived from the MCU's unique ID registers.
  *
  * The USB driver is built on top of the TinyUSB stack and supports multiple
- * interface instances.
+ * interface instances. The hardware is brought up when the first instance is
+ * initialized and shut down when the last one is deinitialized.
+ *
+ * Builds with PSLAB_USB_ISO set to 1 add an isochronous sample interface.
+ * The controller has eight endpoint pairs, one short of the four other
+ * interfaces plus an isochronous endpoint, so these builds leave out the
+ * UART bridge serial port.
  */
 
 #ifndef PSLAB_USB_LL_H
@@ -21,10 +27,75 @@
 
 #define USB_UUID_LEN 12 /* 96 bits */
 
+#ifndef PSLAB_USB_ISO
+#define PSLAB_USB_ISO 0
+#endif
+
+enum {
+    // Bytes sent per 1 ms frame at most on the isochronous interface
+    USB_LL_ISO_PACKET_SIZE = 512,
+    // Vendor subclass of the isochronous interface, to tell it apart from
+    // the bulk interface
+    USB_LL_ISO_SUBCLASS = 0x01,
+    // Age beyond which the last start-of-frame stamp is not reported
+    USB_LL_FRAME_STALE_US = 3000,
+};
+
 /**
  * @brief USB bus instance enumeration
+ *
+ * All instances are interfaces of the same USB device and share the single
+ * controller. USB_BUS_0 is the CDC serial port carrying SCPI traffic;
+ * USB_BUS_1 is a vendor-class bulk interface reserved for binary sample data;
+ * USB_BUS_2 is a second CDC serial port carrying log output; USB_BUS_3 is a
+ * third CDC serial port that can be bridged to a UART. USB_BUS_4 is an
+ * isochronous IN interface for sample data: in builds with PSLAB_USB_ISO it
+ * replaces USB_BUS_3, otherwise it cannot be initialized.
+ *
+ * The isochronous interface has no bandwidth in alternate setting 0 and
+ * one IN endpoint of USB_LL_ISO_PACKET_SIZE bytes in alternate setting 1.
+ * It is connected while the host has selected alternate setting 1; data
+ * written to it then goes out in at most one packet per frame, in the
+ * bandwidth the host reserved when it selected the setting.
+ */
+typedef enum {
+    USB_BUS_0 = 0,
+    USB_BUS_1 = 1,
+    USB_BUS_2 = 2,
+    USB_BUS_3 = 3,
+    USB_BUS_4 = 4,
+    USB_BUS_COUNT = 5
+} USB_Bus;
+
+/**
+ * @brief CDC parity, with the values of the CDC SET_LINE_CODING request
+ */
+typedef enum {
+    USB_LL_PARITY_NONE = 0,
+    USB_LL_PARITY_ODD = 1,
+    USB_LL_PARITY_EVEN = 2,
+    USB_LL_PARITY_MARK = 3,
+    USB_LL_PARITY_SPACE = 4
+} USB_LL_Parity;
+
+/**
+ * @brief CDC stop bits, with the values of the CDC SET_LINE_CODING request
+ */
+typedef enum {
+    USB_LL_STOP_BITS_1 = 0,
+    USB_LL_STOP_BITS_1_5 = 1,
+    USB_LL_STOP_BITS_2 = 2
+} USB_LL_StopBits;
+
+/**
+ * @brief Serial line settings requested by the host for a CDC interface
  */
-typedef enum { USB_BUS_0 = 0, USB_BUS_COUNT = 1 } USB_Bus;
+typedef struct {
+    uint32_t baudrate;
+    USB_LL_Parity parity;
+    USB_LL_StopBits stop_bits;
+    uint8_t data_bits; /**< 5, 6, 7, 8 or 16 */
+} USB_LL_LineCoding;
 
 /**
  * @brief USB line state change callback
@@ -41,6 +112,31 @@ typedef void (*USB_LL_LineStateCallback)(
     bool rts
 );
 
+/**
+ * @brief USB line coding change callback
+ *
+ * Called when the host changes the serial line settings of a CDC interface,
+ * e.g. when a terminal opens the port.
+ *
+ * @param interface_id USB bus instance
+ * @param coding New line settings
+ */
+typedef void (*USB_LL_LineCodingCallback)(
+    USB_Bus interface_id,
+    USB_LL_LineCoding const *coding
+);
+
+/**
+ * @brief USB service callback
+ *
+ * Called from the low-priority USB service interrupt after USB activity, or
+ * after USB_LL_request_service. It is safe to step the TinyUSB stack from
+ * this callback.
+ *
+ * @param interface_id USB bus instance
+ */
+typedef void (*USB_LL_EventCallback)(USB_Bus interface_id);
+
 /**
  * @brief Initialize the USB hardware and TinyUSB stack
  *
@@ -48,6 +144,10 @@ typedef void (*USB_LL_LineStateCallback)(
  * operation.
  *
  * @param bus USB bus instance to initialize
+ *
+ * @throws ERROR_INVALID_ARGUMENT if bus is out of range
+ * @throws ERROR_RESOURCE_BUSY if bus is already initialized
+ * @throws ERROR_RESOURCE_UNAVAILABLE if the build leaves the bus out
  */
 void USB_LL_init(USB_Bus bus);
 
@@ -71,25 +171,25 @@ void USB_LL_deinit(USB_Bus bus);
 size_t USB_LL_get_serial(uint16_t desc_str1[], size_t max_chars);
 
 /**
- * @brief Get number of bytes available for reading from USB CDC interface
+ * @brief Get number of bytes available for reading from USB interface
  *
- * @param interface_id USB CDC interface instance
+ * @param interface_id USB bus instance
  * @return Number of bytes available in the RX buffer
  */
 uint32_t USB_LL_rx_available(USB_Bus interface_id);
 
 /**
- * @brief Get number of bytes available for writing to USB CDC interface
+ * @brief Get number of bytes available for writing to USB interface
  *
- * @param interface_id USB CDC interface instance
+ * @param interface_id USB bus instance
  * @return Number of bytes that can be written to the TX buffer
  */
 uint32_t USB_LL_tx_available(USB_Bus interface_id);
 
 /**
- * @brief Read data from USB CDC interface
+ * @brief Read data from USB interface
  *
- * @param interface_id USB CDC interface instance
+ * @param interface_id USB bus instance
  * @param buf Buffer to store the read data
  * @param bufsize Maximum number of bytes to read
  * @return Number of bytes actually read
@@ -97,9 +197,9 @@ uint32_t USB_LL_tx_available(USB_Bus interface_id);
 uint32_t USB_LL_read(USB_Bus interface_id, uint8_t *buf, uint32_t bufsize);
 
 /**
- * @brief Write data to USB CDC interface
+ * @brief Write data to USB interface
  *
- * @param interface_id USB CDC interface instance
+ * @param interface_id USB bus instance
  * @param buf Buffer containing data to write
  * @param bufsize Number of bytes to write
  * @return Number of bytes actually written
@@ -111,9 +211,9 @@ uint32_t USB_LL_write(
 );
 
 /**
- * @brief Get the size of the USB CDC transmit buffer
+ * @brief Get the size of the USB transmit buffer
  *
- * @param interface_id USB CDC interface instance
+ * @param interface_id USB bus instance
  * @return Size of the TX buffer in bytes
  */
 uint32_t USB_LL_tx_bufsize(USB_Bus interface_id);
@@ -124,28 +224,46 @@ uint32_t USB_LL_tx_bufsize(USB_Bus interface_id);
  * This function should be called periodically to handle USB operations
  * and maintain communication with the host.
  *
- * @param interface_id USB CDC interface instance
+ * @param interface_id USB bus instance
  */
 void USB_LL_task(USB_Bus interface_id);
 
 /**
- * @brief Check if USB CDC interface is connected to host
+ * @brief Check if USB interface is connected to host
  *
- * @param interface_id USB CDC interface instance
+ * The CDC interface is connected while the host asserts DTR. The bulk
+ * interface has no line state and is connected once the device is configured.
+ *
+ * @param interface_id USB bus instance
  * @return true if connected to host, false otherwise
  */
 bool USB_LL_connected(USB_Bus interface_id);
 
 /**
- * @brief Flush the USB CDC transmit buffer
+ * @brief Flush the USB transmit buffer
  *
  * Forces any buffered transmit data to be sent to the host immediately.
  *
- * @param interface_id USB CDC interface instance
+ * @param interface_id USB bus instance
  * @return Number of bytes flushed
  */
 uint32_t USB_LL_tx_flush(USB_Bus interface_id);
 
+/**
+ * @brief Send a serial state notification on the interrupt endpoint
+ *
+ * Sends a CDC SERIAL_STATE notification with the given UART state bitmap
+ * on the notification endpoint of a CDC interface. Other interfaces have
+ * no notification endpoint.
+ *
+ * @param interface_id USB bus instance
+ * @param state UART state bitmap of the CDC PSTN specification
+ * @return true if sent, false if the interface has no notification
+ *         endpoint, is not configured, or the previous notification has
+ *         not been collected by the host yet
+ */
+bool USB_LL_notify(USB_Bus interface_id, uint16_t state);
+
 /**
  * @brief Set the USB line state change callback
  *
@@ -160,4 +278,60 @@ void USB_LL_set_line_state_callback(
     USB_LL_LineStateCallback callback
 );
 
+/**
+ * @brief Set the USB line coding change callback
+ *
+ * @param interface_id USB bus instance
+ * @param callback Callback function, or nullptr to disable
+ */
+void USB_LL_set_line_coding_callback(
+    USB_Bus interface_id,
+    USB_LL_LineCodingCallback callback
+);
+
+/**
+ * @brief Set the USB service callback
+ *
+ * Registers a callback that is run from a low-priority interrupt whenever
+ * the USB controller raises an interrupt. The service interrupt cannot
+ * preempt the USB interrupt itself, but preempts thread-mode code, so the
+ * callback runs even while the main loop is blocked. While any callback is
+ * registered, start-of-frame interrupts keep it running at least once per
+ * millisecond.
+ *
+ * @param interface_id USB bus instance
+ * @param callback Callback function, or nullptr to disable
+ */
+void USB_LL_set_event_callback(
+    USB_Bus interface_id,
+    USB_LL_EventCallback callback
+);
+
+/**
+ * @brief Get the local time of the latest USB start-of-frame
+ *
+ * The host starts a frame every 1 ms by its own clock and numbers it with
+ * an 11-bit frame number. The local time of each start-of-frame is taken
+ * as the interrupt is entered, so that the host can map local timestamps
+ * onto its clock by the frame numbers. The stamp is at most a few
+ * microseconds late, more when a higher priority interrupt runs first.
+ *
+ * @param[out] frame Frames since the controller started, modulo 2^32; the
+ *                   low 11 bits are the host's frame number
+ * @param[out] time_us PLATFORM_get_time_us at the start of the frame
+ * @return false if no frame has started in the last USB_LL_FRAME_STALE_US,
+ *         e.g. while unplugged or suspended
+ */
+bool USB_LL_get_frame_stamp(uint32_t *frame, uint32_t *time_us);
+
+/**
+ * @brief Request a pass of the USB service callback
+ *
+ * Pends the service interrupt, e.g. after new data has been queued for
+ * transmission. Safe to call from any context.
+ *
+ * @param interface_id USB bus instance
+ */
+void USB_LL_request_service(USB_Bus interface_id);
+
 #endif /* PSLAB_USB_LL_H */
@@ -0,0 +1,325 @@
+/**
+ * @file bridge.c
+ * @brief USB-UART bridge
+ *
+ * Both directions move contiguous spans, with no intermediate buffer of the
+ * bridge's own:
+ * - UART to USB: spans of the UART RX buffer, where RX DMA writes, are
+ *   handed to the USB driver in place with USB_write_buffer, and released
+ *   once they have reached the USB FIFO.
+ * - USB to UART: USB data is read straight into free spans of the UART TX
+ *   buffer, from which TX DMA sends it.
+ *
+ * The work is done from the USB service interrupt, through an RX callback
+ * with a threshold of zero, which the USB driver calls on every service
+ * pass. UART RX events request such a pass, so data from the UART does not
+ * wait for the next USB frame.
+ */
+
+#define LOG_MODULE LOG_MODULE_UART
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/error.h"
+#include "util/logging.h"
+#include "util/util.h"
+
+#include "bridge.h"
+#include "clock.h"
+#include "uart.h"
+#include "usb.h"
+
+enum {
+    // DUT output waits here while USB sends the previous span
+    BRIDGE_UART_RX_BUFFER_SIZE = 2048,
+    BRIDGE_UART_TX_BUFFER_SIZE = 1024,
+    BRIDGE_USB_RX_BUFFER_SIZE = 256,
+    // Unused, UART data is sent in place
+    BRIDGE_USB_TX_BUFFER_SIZE = 2,
+};
+
+static uint8_t g_uart_rx_data[BRIDGE_UART_RX_BUFFER_SIZE];
+static uint8_t g_uart_tx_data[BRIDGE_UART_TX_BUFFER_SIZE];
+static uint8_t g_usb_rx_data[BRIDGE_USB_RX_BUFFER_SIZE];
+static uint8_t g_usb_tx_data[BRIDGE_USB_TX_BUFFER_SIZE];
+static CircularBuffer g_uart_rx_buffer;
+static CircularBuffer g_uart_tx_buffer;
+static CircularBuffer g_usb_rx_buffer;
+static CircularBuffer g_usb_tx_buffer;
+
+static UART_Handle *g_uart = nullptr;
+static USB_Handle *g_usb = nullptr;
+static size_t g_uart_bus = 0;
+
+// Length of the UART RX span queued with USB_write_buffer
+static uint32_t g_usb_tx_span = 0;
+
+// A terminal has the bridge port open
+static bool volatile g_dtr = false;
+
+/**
+ * @brief Move data from the USB bridge port to the UART
+ */
+static void forward_usb_to_uart(uint32_t available)
+{
+    while (available > 0) {
+        uint8_t *span = nullptr;
+        uint32_t const len = UART_tx_reserve(g_uart, &span);
+        if (len == 0) {
+            // USB holds the rest until the UART has sent some
+            return;
+        }
+
+        uint32_t const got =
+            USB_read(g_usb, span, available < len ? available : len);
+        if (got == 0) {
+            return;
+        }
+        UART_tx_commit(g_uart, got);
+        available -= got;
+    }
+}
+
+/**
+ * @brief Hand the next span of UART data to the USB bridge port
+ */
+static void forward_uart_to_usb(void)
+{
+    if (USB_tx_buffer_pending(g_usb)) {
+        return;
+    }
+
+    // The previous span has reached the USB FIFO
+    UART_rx_consume(g_uart, g_usb_tx_span);
+    g_usb_tx_span = 0;
+
+    uint8_t const *span = nullptr;
+    uint32_t const len = UART_rx_peek(g_uart, &span);
+    if (len > 0 && USB_write_buffer(g_usb, span, len)) {
+        g_usb_tx_span = len;
+    }
+}
+
+/**
+ * @brief Drop buffered UART data that no terminal was waiting for
+ */
+static void discard_uart_rx(void)
+{
+    // The USB driver dropped the queued span when DTR was de-asserted
+    g_usb_tx_span = 0;
+
+    uint8_t const *span = nullptr;
+    uint32_t len = 0;
+    while ((len = UART_rx_peek(g_uart, &span)) > 0) {
+        UART_rx_consume(g_uart, len);
+    }
+}
+
+/**
+ * @brief Service pass of the USB bridge port
+ *
+ * Called by the USB driver on every service pass, while a terminal has the
+ * port open.
+ *
+ * @param handle USB bridge port
+ * @param bytes_available Bytes received from the host
+ */
+static void usb_service_callback(USB_Handle *handle, uint32_t bytes_available)
+{
+    (void)handle;
+
+    forward_usb_to_uart(bytes_available);
+    forward_uart_to_usb();
+}
+
+/**
+ * @brief UART RX event: pass the data on without waiting for the next frame
+ *
+ * @param handle Bridged UART
+ * @param bytes_available Bytes waiting in the UART RX buffer
+ */
+static void uart_rx_callback(UART_Handle *handle, uint32_t bytes_available)
+{
+    (void)handle;
+    (void)bytes_available;
+
+    // The USB side is not serviced while the port is closed; stale data is
+    // dropped when it is opened again
+    if (g_dtr) {
+        USB_task(g_usb);
+    }
+}
+
+/**
+ * @brief Follow the host opening and closing the bridge port
+ *
+ * @param handle USB bridge port
+ * @param dtr Data Terminal Ready
+ * @param rts Request To Send; the UART has no line to drive with it
+ */
+static void line_state_callback(USB_Handle *handle, bool dtr, bool rts)
+{
+    (void)handle;
+    (void)rts;
+
+    if (dtr && !g_dtr) {
+        discard_uart_rx();
+    }
+    g_dtr = dtr;
+}
+
+/**
+ * @brief Apply the host's serial settings to the UART
+ *
+ * Settings the USART cannot do are refused with a warning, and the UART
+ * keeps its previous settings.
+ *
+ * @param handle USB bridge port
+ * @param coding Line settings requested by the host
+ */
+static void line_coding_callback(
+    USB_Handle *handle,
+    USB_LineCoding const *coding
+)
+{
+    (void)handle;
+
+    UART_LineConfig config = UART_get_config(g_uart);
+    config.baudrate = coding->baudrate;
+    config.oversampling = UART_LINE_OVERSAMPLING_AUTO;
+
+    bool supported = coding->data_bits == 8;
+    switch (coding->parity) {
+    case USB_PARITY_NONE:
+        config.parity = UART_LINE_PARITY_NONE;
+        break;
+    case USB_PARITY_EVEN:
+        config.parity = UART_LINE_PARITY_EVEN;
+        break;
+    case USB_PARITY_ODD:
+        config.parity = UART_LINE_PARITY_ODD;
+        break;
+    default:
+        supported = false;
+        break;
+    }
+    switch (coding->stop_bits) {
+    case USB_STOP_BITS_1:
+        config.stop_bits = UART_LINE_STOP_BITS_1;
+        break;
+    case USB_STOP_BITS_2:
+        config.stop_bits = UART_LINE_STOP_BITS_2;
+        break;
+    default:
+        supported = false;
+        break;
+    }
+
+    if (!supported) {
+        LOG_WARN(
+            "Bridge: unsupported line coding %u data bits, parity %u, "
+            "stop bits %u",
+            (unsigned)coding->data_bits,
+            (unsigned)coding->parity,
+            (unsigned)coding->stop_bits
+        );
+        return;
+    }
+
+    Error err = ERROR_NONE;
+    TRY
+    {
+        UART_configure(g_uart, &config);
+        // The UART RX buffer was reset, the queued span is stale
+        g_usb_tx_span = 0;
+    }
+    CATCH(err)
+    {
+        LOG_WARN(
+            "Bridge: cannot set %u baud (error %d)",
+            (unsigned)config.baudrate,
+            (int)err
+        );
+    }
+}
+
+void BRIDGE_start(size_t uart_bus)
+{
+    if (g_uart || g_usb) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    circular_buffer_init(
+        &g_uart_rx_buffer, g_uart_rx_data, sizeof(g_uart_rx_data)
+    );
+    circular_buffer_init(
+        &g_uart_tx_buffer, g_uart_tx_data, sizeof(g_uart_tx_data)
+    );
+    circular_buffer_init(
+        &g_usb_rx_buffer, g_usb_rx_data, sizeof(g_usb_rx_data)
+    );
+    circular_buffer_init(
+        &g_usb_tx_buffer, g_usb_tx_data, sizeof(g_usb_tx_data)
+    );
+    g_usb_tx_span = 0;
+    g_dtr = false;
+
+    g_uart = UART_init(uart_bus, &g_uart_rx_buffer, &g_uart_tx_buffer);
+
+    Error err = ERROR_NONE;
+    TRY
+    {
+        g_usb = USB_init(
+            USB_INTERFACE_BRIDGE, &g_usb_rx_buffer, &g_usb_tx_buffer
+        );
+    }
+    CATCH(err)
+    {
+        UART_deinit(g_uart);
+        g_uart = nullptr;
+        THROW(err);
+    }
+    g_uart_bus = uart_bus;
+
+    USB_set_line_state_callback(g_usb, line_state_callback);
+    USB_set_line_coding_callback(g_usb, line_coding_callback);
+    // Partial packets go out as soon as the span has been handed over
+    USB_set_flush_policy(g_usb, USB_FLUSH_IMMEDIATE, 0);
+    USB_set_rx_callback(g_usb, usb_service_callback, 0);
+    USB_set_event_driven(g_usb, true);
+    // Only once USB_task merely requests a service pass
+    UART_set_rx_callback(g_uart, uart_rx_callback, 1);
+    // Forwarding from the interrupts keeps up with fast UARTs at full speed
+    CLOCK_request();
+
+    LOG_INFO("Bridge: USB serial port to UART %u", (unsigned)uart_bus);
+}
+
+void BRIDGE_stop(void)
+{
+    if (!g_uart || !g_usb) {
+        return;
+    }
+
+    // USB first, it stops servicing from interrupt before the UART goes
+    USB_deinit(g_usb);
+    g_usb = nullptr;
+    UART_deinit(g_uart);
+    g_uart = nullptr;
+    g_usb_tx_span = 0;
+    g_dtr = false;
+    CLOCK_release();
+}
+
+bool BRIDGE_active(size_t *uart_bus)
+{
+    if (!g_uart || !g_usb) {
+        return false;
+    }
+    if (uart_bus) {
+        *uart_bus = g_uart_bus;
+    }
+    return true;
+}
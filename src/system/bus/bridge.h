@@ -0,0 +1,67 @@
+/**
+ * @file bridge.h
+ * @brief USB-UART bridge
+ *
+ * Turns the board into a USB-serial adapter: while the bridge runs, the
+ * USB_INTERFACE_BRIDGE serial port and a UART forward data to each other.
+ * The SCPI port keeps working meanwhile, because the bridge is serviced
+ * from interrupts rather than from the main loop.
+ *
+ * The host's serial settings follow the bridged UART: baudrate, parity and
+ * stop bits requested by a terminal are applied to the USART. The UART has
+ * no modem control lines, so DTR stands for an open port: UART data that
+ * arrives while no terminal has the port open is dropped when the next one
+ * opens it. RTS is not used.
+ *
+ * @code
+ * BRIDGE_start(0);  // Host terminal on the bridge port talks to UART 0
+ * // ...
+ * BRIDGE_stop();
+ * @endcode
+ */
+
+#ifndef PSLAB_BRIDGE_H
+#define PSLAB_BRIDGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start bridging the USB bridge port to a UART
+ *
+ * The UART starts with the default line settings until the host sends its
+ * own.
+ *
+ * @param uart_bus UART bus to bridge; must not be in use
+ *
+ * @throws ERROR_RESOURCE_BUSY if the bridge is running already
+ * @throws Errors raised by UART_init and USB_init, e.g. ERROR_RESOURCE_BUSY
+ *         for the UART carrying log output
+ */
+void BRIDGE_start(size_t uart_bus);
+
+/**
+ * @brief Stop the bridge and release the UART and the USB port
+ *
+ * Data that has not been forwarded yet is dropped. Does nothing if the
+ * bridge is not running.
+ */
+void BRIDGE_stop(void);
+
+/**
+ * @brief Check whether the bridge is running
+ *
+ * @param uart_bus Set to the bridged UART bus if running; may be nullptr
+ * @return true if the bridge is running
+ */
+bool BRIDGE_active(size_t *uart_bus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_BRIDGE_H
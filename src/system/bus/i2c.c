@@ -0,0 +1,235 @@
+/**
+ * @file i2c.c
+ * @brief Hardware-independent I2C bus controller implementation
+ *
+ * This module provides the hardware-independent layer of the I2C driver.
+ * It keeps a ring of pending transactions per bus. The one at the head is
+ * on the bus; its completion, reported by the hardware layer from
+ * interrupt context, pops it and starts the next, so a queue drains
+ * without the main loop.
+ *
+ * The queue is filled from the main loop and drained from the interrupt,
+ * so submission masks interrupts while it adds to the ring.
+ *
+ * This implementation relies on hardware-specific functions defined in
+ * src/platform/h563xx/i2c_ll.c (or equivalent for other platforms).
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "platform/i2c_ll.h"
+#include "platform/platform.h"
+#include "util/error.h"
+
+#include "i2c.h"
+
+// Outcomes and limits are handed to and from the hardware layer unchanged
+static_assert(
+    (int)I2C_STATUS_OK == (int)I2C_LL_STATUS_OK &&
+        (int)I2C_STATUS_NACK == (int)I2C_LL_STATUS_NACK &&
+        (int)I2C_STATUS_BUS_ERROR == (int)I2C_LL_STATUS_BUS_ERROR &&
+        (int)I2C_STATUS_DMA_ERROR == (int)I2C_LL_STATUS_DMA_ERROR,
+    "I2C statuses must match the hardware layer"
+);
+static_assert(
+    (int)I2C_SPEED_DEFAULT == (int)I2C_LL_SPEED_DEFAULT &&
+        (int)I2C_SPEED_MIN == (int)I2C_LL_SPEED_MIN &&
+        (int)I2C_SPEED_MAX == (int)I2C_LL_SPEED_MAX &&
+        (int)I2C_ADDRESS_MAX == (int)I2C_LL_ADDRESS_MAX &&
+        (int)I2C_TRANSFER_MAX == (int)I2C_LL_TRANSFER_MAX,
+    "I2C limits must match the hardware layer"
+);
+
+/**
+ * @brief I2C bus handle structure
+ */
+struct I2C_Handle {
+    I2C_Bus bus_id;
+    I2C_Transaction *queue[I2C_QUEUE_SIZE];
+    uint32_t volatile head; // Index of the oldest pending transaction
+    uint32_t volatile count; // Pending transactions
+    bool volatile running; // The head transaction is on the bus
+    uint32_t speed;
+    bool initialized;
+};
+
+/* Statically allocated handle storage, one per bus */
+static I2C_Handle g_handle_storage[I2C_BUS_COUNT];
+
+/* Global array to keep track of active I2C handles */
+static I2C_Handle *g_active_handles[I2C_BUS_COUNT] = { nullptr };
+
+size_t I2C_get_bus_count(void) { return I2C_BUS_COUNT; }
+
+/**
+ * @brief Remove the head transaction and report its outcome
+ */
+static void finish_head(I2C_Handle *handle, I2C_Status status)
+{
+    I2C_Transaction *const transaction = handle->queue[handle->head];
+
+    handle->head = (handle->head + 1) % I2C_QUEUE_SIZE;
+    handle->count -= 1;
+    transaction->status = status;
+    if (transaction->callback) {
+        transaction->callback(transaction);
+    }
+}
+
+/**
+ * @brief Put the head transaction on the bus
+ *
+ * Called with interrupts masked, or from the completion interrupt. A
+ * transaction the hardware refuses completes with a bus error, and the
+ * next one is tried.
+ */
+static void start_head(I2C_Handle *handle)
+{
+    while (handle->count > 0 && !handle->running) {
+        I2C_Transaction const *const transaction =
+            handle->queue[handle->head];
+        I2C_LL_Transfer const transfer = {
+            .address = transaction->address,
+            .read = transaction->read,
+            .reg = transaction->reg,
+            .reg_size = transaction->reg_size,
+            .data = transaction->data,
+            .size = transaction->size,
+        };
+        Error err = ERROR_NONE;
+
+        TRY
+        {
+            I2C_LL_start(handle->bus_id, &transfer);
+            handle->running = true;
+        }
+        CATCH(err) { finish_head(handle, I2C_STATUS_BUS_ERROR); }
+    }
+}
+
+/**
+ * @brief Transfer complete callback from the hardware layer
+ */
+static void complete_callback(I2C_Bus bus, I2C_LL_Status status)
+{
+    I2C_Handle *const handle = g_active_handles[bus];
+
+    if (!handle || !handle->running || handle->count == 0) {
+        return;
+    }
+    handle->running = false;
+    finish_head(handle, (I2C_Status)status);
+    start_head(handle);
+}
+
+I2C_Handle *I2C_init(size_t bus)
+{
+    if (bus >= I2C_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    I2C_Bus const bus_id = (I2C_Bus)bus;
+
+    if (g_active_handles[bus_id] != nullptr) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    I2C_Handle *const handle = &g_handle_storage[bus_id];
+    handle->bus_id = bus_id;
+    handle->head = 0;
+    handle->count = 0;
+    handle->running = false;
+    handle->speed = I2C_SPEED_DEFAULT;
+    handle->initialized = false;
+
+    I2C_LL_init(bus_id);
+    I2C_LL_set_complete_callback(bus_id, complete_callback);
+
+    handle->initialized = true;
+    g_active_handles[bus_id] = handle;
+
+    return handle;
+}
+
+void I2C_deinit(I2C_Handle *handle)
+{
+    if (!handle || !handle->initialized || handle->bus_id >= I2C_BUS_COUNT) {
+        return;
+    }
+
+    // Aborts the transfer in progress without a completion callback
+    I2C_LL_deinit(handle->bus_id);
+    I2C_LL_set_complete_callback(handle->bus_id, nullptr);
+
+    g_active_handles[handle->bus_id] = nullptr;
+    handle->initialized = false;
+    handle->running = false;
+
+    while (handle->count > 0) {
+        finish_head(handle, I2C_STATUS_CANCELLED);
+    }
+}
+
+void I2C_set_speed(I2C_Handle *handle, uint32_t speed)
+{
+    if (!handle || !handle->initialized || speed < I2C_SPEED_MIN ||
+        speed > I2C_SPEED_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (handle->count > 0) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    I2C_LL_set_speed(handle->bus_id, speed);
+    handle->speed = speed;
+}
+
+uint32_t I2C_get_speed(I2C_Handle const *handle)
+{
+    if (!handle || !handle->initialized) {
+        return 0;
+    }
+    return handle->speed;
+}
+
+void I2C_submit(I2C_Handle *handle, I2C_Transaction *transaction)
+{
+    if (!handle || !handle->initialized || !transaction ||
+        !transaction->data || transaction->size == 0 ||
+        transaction->size > I2C_TRANSFER_MAX ||
+        transaction->address > I2C_ADDRESS_MAX ||
+        transaction->reg_size > 2) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    bool accepted = false;
+    uint32_t const state = PLATFORM_disable_interrupts();
+    if (transaction->status != I2C_STATUS_PENDING &&
+        handle->count < I2C_QUEUE_SIZE) {
+        uint32_t const tail = (handle->head + handle->count) % I2C_QUEUE_SIZE;
+        transaction->status = I2C_STATUS_PENDING;
+        handle->queue[tail] = transaction;
+        handle->count += 1;
+        start_head(handle);
+        accepted = true;
+    }
+    PLATFORM_restore_interrupts(state);
+
+    if (!accepted) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+}
+
+uint32_t I2C_pending(I2C_Handle const *handle)
+{
+    if (!handle || !handle->initialized) {
+        return 0;
+    }
+    return handle->count;
+}
@@ -0,0 +1,195 @@
+/**
+ * @file i2c.h
+ * @brief I2C (Inter-Integrated Circuit) bus controller interface
+ *
+ * This module provides a non-blocking I2C driver for talking to sensors
+ * and other targets on the bus. Transactions are register reads or writes
+ * moved by DMA. They are queued and run one after another in the order
+ * they were submitted, and each one's completion callback reports its
+ * outcome, so a caller can queue a burst of writes and a read and go on
+ * with other work meanwhile.
+ *
+ * Features:
+ * - Fire-and-forget submission into a fixed-size transaction queue
+ * - Register addresses of 0, 1 or 2 bytes, the read after a repeated start
+ * - Completion callbacks from interrupt context, or a status to poll
+ * - Runtime clock rate up to Fast-mode Plus
+ *
+ * Basic Usage:
+ * @code
+ * static uint8_t id;
+ * static I2C_Transaction read_id = {
+ *     .address = 0x68,
+ *     .read = true,
+ *     .reg = 0x75,
+ *     .reg_size = 1,
+ *     .data = &id,
+ *     .size = 1,
+ * };
+ *
+ * I2C_Handle *i2c = I2C_init(0);
+ * I2C_submit(i2c, &read_id);
+ *
+ * // Later, e.g. in the main loop
+ * if (read_id.status == I2C_STATUS_OK) {
+ *     // id holds the register value
+ * }
+ *
+ * I2C_deinit(i2c);
+ * @endcode
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_I2C_H
+#define PSLAB_I2C_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    /** @brief Transactions that can wait in the queue of one bus */
+    I2C_QUEUE_SIZE = 8,
+    /** @brief Clock rate a bus starts with, in Hz */
+    I2C_SPEED_DEFAULT = 100000,
+    /** @brief Lowest clock rate, in Hz */
+    I2C_SPEED_MIN = 10000,
+    /** @brief Highest clock rate, in Hz */
+    I2C_SPEED_MAX = 1000000,
+    /** @brief Highest 7-bit target address */
+    I2C_ADDRESS_MAX = 0x7F,
+    /** @brief Most bytes of data moved by one transaction */
+    I2C_TRANSFER_MAX = 0xFFFF,
+};
+
+/**
+ * @brief I2C bus handle structure
+ */
+typedef struct I2C_Handle I2C_Handle;
+
+/**
+ * @brief Outcome of a transaction
+ */
+typedef enum {
+    I2C_STATUS_OK = 0,
+    I2C_STATUS_NACK, // The target did not acknowledge
+    I2C_STATUS_BUS_ERROR, // Misplaced start or stop, or arbitration lost
+    I2C_STATUS_DMA_ERROR,
+    I2C_STATUS_CANCELLED, // The bus was deinitialized before it ran
+    I2C_STATUS_PENDING, // Queued or in progress
+} I2C_Status;
+
+typedef struct I2C_Transaction I2C_Transaction;
+
+/**
+ * @brief Callback function type for completed transactions
+ *
+ * Called from interrupt context, or from I2C_deinit for cancelled ones.
+ * A transaction that was not cancelled may be submitted again from the
+ * callback.
+ *
+ * @param transaction The transaction, with its final status
+ */
+typedef void (*I2C_CompleteCallback)(I2C_Transaction *transaction);
+
+/**
+ * @brief A register read or write
+ *
+ * The transaction is owned by the driver from I2C_submit until its status
+ * is no longer I2C_STATUS_PENDING, and must stay valid meanwhile, as must
+ * its data.
+ */
+struct I2C_Transaction {
+    uint8_t address; // 7-bit target address
+    bool read; // Read into data, else write from it
+    uint16_t reg; // Register address, sent most significant byte first
+    uint8_t reg_size; // Bytes of register address, 0 to 2
+    uint8_t *data;
+    uint32_t size; // Bytes of data, 1 to I2C_TRANSFER_MAX
+    I2C_CompleteCallback callback; // Optional
+    void *context; // For the callback's use
+    I2C_Status volatile status; // Set by the driver
+};
+
+/**
+ * @brief Get the number of available I2C bus instances.
+ *
+ * @return Number of I2C buses supported by this platform
+ */
+size_t I2C_get_bus_count(void);
+
+/**
+ * @brief Initialize an I2C bus as controller, at I2C_SPEED_DEFAULT
+ *
+ * @param bus I2C bus instance to initialize (0-based index)
+ * @return Pointer to I2C handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if bus is invalid
+ * @throws ERROR_RESOURCE_BUSY if the bus is already initialized
+ * @throws ERROR_HARDWARE_FAULT if the peripheral cannot be configured
+ */
+I2C_Handle *I2C_init(size_t bus);
+
+/**
+ * @brief Deinitialize an I2C bus
+ *
+ * A transaction in progress is aborted, and it and the queued ones complete
+ * with I2C_STATUS_CANCELLED.
+ *
+ * @param handle Pointer to I2C handle structure
+ */
+void I2C_deinit(I2C_Handle *handle);
+
+/**
+ * @brief Change the clock rate of an idle bus
+ *
+ * @param handle Pointer to I2C handle structure
+ * @param speed Clock rate in Hz, I2C_SPEED_MIN to I2C_SPEED_MAX
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or speed is invalid
+ * @throws ERROR_RESOURCE_BUSY if transactions are pending
+ */
+void I2C_set_speed(I2C_Handle *handle, uint32_t speed);
+
+/**
+ * @brief Get the clock rate of a bus
+ *
+ * @param handle Pointer to I2C handle structure
+ * @return Clock rate last set, in Hz, or 0 for an invalid handle
+ */
+uint32_t I2C_get_speed(I2C_Handle const *handle);
+
+/**
+ * @brief Queue a transaction
+ *
+ * Returns at once. The transaction starts when the ones before it have
+ * completed; its status is I2C_STATUS_PENDING until then.
+ *
+ * @param handle Pointer to I2C handle structure
+ * @param transaction Transaction to run
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or transaction is invalid
+ * @throws ERROR_RESOURCE_BUSY if the queue is full, or the transaction is
+ *         already pending
+ */
+void I2C_submit(I2C_Handle *handle, I2C_Transaction *transaction);
+
+/**
+ * @brief Get the number of transactions not yet completed
+ *
+ * @param handle Pointer to I2C handle structure
+ * @return Transactions queued or in progress, 0 for an invalid handle
+ */
+uint32_t I2C_pending(I2C_Handle const *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PSLAB_I2C_H */
@@ -0,0 +1,298 @@
+/**
+ * @file loopback.c
+ * @brief UART loopback throughput and latency self-test
+ *
+ * The byte sent n-th has the value n modulo 256, the latency probes
+ * included. Each byte received is checked against the one before it, so
+ * that after a lost or corrupted byte the check picks up the sequence
+ * again rather than failing every byte after it.
+ *
+ * Everything but the start and the release of the UART runs in the RX
+ * callback, from the UART and DMA interrupts, which do not preempt each
+ * other: it reads what has arrived, then sends the next probe or tops up
+ * the TX buffer. RX DMA events come at the middle and the end of the RX
+ * buffer, so the TX buffer, twice as large, does not run dry meanwhile.
+ */
+
+#define LOG_MODULE LOG_MODULE_UART
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "platform/platform.h"
+#include "util/error.h"
+#include "util/logging.h"
+#include "util/si_prefix.h"
+#include "util/util.h"
+
+#include "clock.h"
+#include "loopback.h"
+#include "uart.h"
+
+enum {
+    LOOPBACK_RX_BUFFER_SIZE = 512,
+    LOOPBACK_TX_BUFFER_SIZE = 1024,
+    LOOPBACK_PROBES = 16, // Single bytes timed for the latency
+    LOOPBACK_READ_SIZE = 64, // Bytes read from the RX buffer at once
+    LOOPBACK_FRAME_BITS = 10, // Start, 8 data and stop bit
+    LOOPBACK_MARGIN_US = 100000, // Added to the time allowed for a test
+};
+
+typedef enum {
+    PHASE_LATENCY,
+    PHASE_THROUGHPUT,
+    PHASE_DONE,
+} Phase;
+
+static uint8_t g_rx_data[LOOPBACK_RX_BUFFER_SIZE];
+static uint8_t g_tx_data[LOOPBACK_TX_BUFFER_SIZE];
+static CircularBuffer g_rx_buffer;
+static CircularBuffer g_tx_buffer;
+
+static UART_Handle *g_uart = nullptr;
+
+// Test state, shared with the RX callback
+static struct {
+    Phase volatile phase;
+    uint32_t baudrate;
+    uint32_t target; // Bytes to receive, the probes included
+    uint32_t sent;
+    uint32_t volatile received;
+    uint8_t expected; // Next byte value
+    uint32_t volatile errors;
+    uint32_t overruns; // Of the UART, once released
+    uint32_t probe_us; // When the last probe was written
+    uint32_t latency_min_us;
+    uint32_t latency_max_us;
+    uint32_t latency_sum_us;
+    uint32_t throughput_start_us;
+    uint32_t throughput_us; // Duration of the throughput phase once over
+    uint64_t deadline_us;
+} g_test = { .phase = PHASE_DONE };
+
+/**
+ * @brief Queue the next bytes of the sequence, up to the given count
+ */
+static void send(uint32_t count)
+{
+    while (count > 0) {
+        uint8_t *span = nullptr;
+        uint32_t len = UART_tx_reserve(g_uart, &span);
+        if (len == 0) {
+            return;
+        }
+        len = len < count ? len : count;
+        for (uint32_t i = 0; i < len; ++i) {
+            span[i] = (uint8_t)(g_test.sent + i);
+        }
+        g_test.sent += len;
+        count -= len;
+        UART_tx_commit(g_uart, len);
+    }
+}
+
+/**
+ * @brief Check received bytes against the sequence
+ */
+static void check(uint8_t const *data, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; ++i) {
+        if (data[i] != g_test.expected) {
+            ++g_test.errors;
+        }
+        g_test.expected = (uint8_t)(data[i] + 1);
+    }
+    g_test.received += len;
+}
+
+static void record_latency(uint32_t latency_us)
+{
+    if (latency_us < g_test.latency_min_us) {
+        g_test.latency_min_us = latency_us;
+    }
+    if (latency_us > g_test.latency_max_us) {
+        g_test.latency_max_us = latency_us;
+    }
+    g_test.latency_sum_us += latency_us;
+}
+
+/**
+ * @brief Take in what has come back, then send what comes next
+ */
+static void rx_callback(UART_Handle *handle, uint32_t bytes_available)
+{
+    (void)bytes_available; // Read until empty instead
+
+    uint32_t const now = PLATFORM_get_time_us();
+    uint8_t chunk[LOOPBACK_READ_SIZE];
+    uint32_t len = 0;
+    while ((len = UART_read(handle, chunk, sizeof(chunk))) > 0) {
+        check(chunk, len);
+    }
+
+    switch (g_test.phase) {
+    case PHASE_LATENCY:
+        record_latency(now - g_test.probe_us);
+        if (g_test.received < LOOPBACK_PROBES) {
+            g_test.probe_us = PLATFORM_get_time_us();
+            send(1);
+            return;
+        }
+        g_test.phase = PHASE_THROUGHPUT;
+        g_test.throughput_start_us = PLATFORM_get_time_us();
+        send(g_test.target - g_test.sent);
+        return;
+    case PHASE_THROUGHPUT:
+        if (g_test.received >= g_test.target) {
+            g_test.throughput_us = now - g_test.throughput_start_us;
+            g_test.phase = PHASE_DONE;
+            return;
+        }
+        send(g_test.target - g_test.sent);
+        return;
+    case PHASE_DONE:
+    default:
+        return;
+    }
+}
+
+/**
+ * @brief Stop the interrupts, release the UART and the clock
+ */
+static void release(void)
+{
+    if (!g_uart) {
+        return;
+    }
+
+    UART_set_rx_callback(g_uart, nullptr, 0);
+    g_test.overruns = UART_get_rx_overruns(g_uart);
+    UART_deinit(g_uart);
+    g_uart = nullptr;
+    CLOCK_release();
+}
+
+void LOOPBACK_start(
+    size_t uart_bus,
+    uint32_t baudrate,
+    uint32_t bytes,
+    bool external
+)
+{
+    if (LOOPBACK_running()) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+    if (bytes == 0 || bytes > LOOPBACK_BYTES_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    // The baudrate is set up, and the bytes come back, at the full clock
+    CLOCK_request();
+
+    circular_buffer_init(&g_rx_buffer, g_rx_data, sizeof(g_rx_data));
+    circular_buffer_init(&g_tx_buffer, g_tx_data, sizeof(g_tx_data));
+
+    Error err = ERROR_NONE;
+    TRY
+    {
+        g_uart = UART_init(uart_bus, &g_rx_buffer, &g_tx_buffer);
+        UART_LineConfig config = UART_LINE_CONFIG_DEFAULT;
+        config.baudrate = baudrate;
+        UART_configure(g_uart, &config);
+        if (!external) {
+            UART_set_loopback(g_uart, true);
+        }
+    }
+    CATCH(err)
+    {
+        UART_deinit(g_uart);
+        g_uart = nullptr;
+        CLOCK_release();
+        THROW(err);
+    }
+
+    // Twice the line time of all bytes, a probe taking two with its idle
+    uint64_t const frames = (2ULL * LOOPBACK_PROBES) + bytes;
+    uint64_t const line_us =
+        frames * LOOPBACK_FRAME_BITS * SI_MEGA_INT / baudrate;
+
+    g_test.phase = PHASE_LATENCY;
+    g_test.baudrate = baudrate;
+    g_test.target = LOOPBACK_PROBES + bytes;
+    g_test.sent = 0;
+    g_test.received = 0;
+    g_test.expected = 0;
+    g_test.errors = 0;
+    g_test.overruns = 0;
+    g_test.latency_min_us = UINT32_MAX;
+    g_test.latency_max_us = 0;
+    g_test.latency_sum_us = 0;
+    g_test.throughput_us = 0;
+    g_test.deadline_us =
+        PLATFORM_get_time_us64() + (2 * line_us) + LOOPBACK_MARGIN_US;
+
+    UART_set_rx_callback(g_uart, rx_callback, 1);
+    g_test.probe_us = PLATFORM_get_time_us();
+    send(1);
+
+    LOG_INFO(
+        "Loopback: UART %u at %u baud",
+        (unsigned)uart_bus,
+        (unsigned)baudrate
+    );
+}
+
+void LOOPBACK_stop(void)
+{
+    uint32_t const state = PLATFORM_disable_interrupts();
+    g_test.phase = PHASE_DONE;
+    PLATFORM_restore_interrupts(state);
+    release();
+}
+
+bool LOOPBACK_running(void)
+{
+    if (g_test.phase != PHASE_DONE &&
+        PLATFORM_get_time_us64() >= g_test.deadline_us) {
+        LOOPBACK_stop();
+    }
+    if (g_test.phase == PHASE_DONE) {
+        release();
+        return false;
+    }
+    return true;
+}
+
+LOOPBACK_Result LOOPBACK_get_result(void)
+{
+    bool const running = LOOPBACK_running();
+
+    uint32_t const state = PLATFORM_disable_interrupts();
+    uint32_t const received = g_test.received;
+    uint32_t const probes =
+        received < LOOPBACK_PROBES ? received : LOOPBACK_PROBES;
+    uint32_t const bytes = received - probes;
+    LOOPBACK_Result result = {
+        .running = running,
+        .baudrate = g_test.baudrate,
+        .bytes = bytes,
+        .bytes_per_second =
+            g_test.throughput_us == 0
+                ? 0
+                : (uint32_t)(((uint64_t)bytes * SI_MEGA_INT) /
+                             g_test.throughput_us),
+        .errors = g_test.errors,
+        .overruns = g_uart ? UART_get_rx_overruns(g_uart) : g_test.overruns,
+        .latency_min_us = probes == 0 ? 0 : g_test.latency_min_us,
+        .latency_mean_us = probes == 0 ? 0 : g_test.latency_sum_us / probes,
+        .latency_max_us = g_test.latency_max_us,
+    };
+    PLATFORM_restore_interrupts(state);
+
+    // Bytes that never came back count as errors once the test is over
+    if (!running && received < g_test.target) {
+        result.errors += g_test.target - received;
+    }
+    return result;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file loopback.h
+ * @brief UART loopback throughput and latency self-test
+ *
+ * Sends a byte counter through a UART whose transmitter is looped back to
+ * its receiver, either inside the USART or by a strap between the TX and
+ * RX pins, and checks what comes back. The bytes take the whole path of
+ * UART users: UART_write, TX DMA, the line, RX DMA, the idle and DMA
+ * events, the RX callback and UART_read. A test has two phases:
+ *
+ * - Latency: single bytes, each sent once the one before has come back,
+ *   timed from the write to the read in the RX callback. With the line
+ *   quiet, a byte reaches the callback through the idle line event, a
+ *   character time after it arrived.
+ * - Throughput: as many bytes as asked for, with the TX buffer kept full,
+ *   timed from the first write to the last read.
+ *
+ * The test runs from the UART interrupts; only its start, its end and the
+ * release of the UART take the main loop.
+ *
+ * @code
+ * LOOPBACK_start(1, 2000000, 16384, false);
+ * while (LOOPBACK_running()) {
+ * }
+ * LOOPBACK_Result const result = LOOPBACK_get_result();
+ * @endcode
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_LOOPBACK_H
+#define PSLAB_LOOPBACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Bytes of the throughput phase
+ */
+enum {
+    LOOPBACK_BYTES_DEFAULT = 16384, // Enough to reach a steady rate
+    LOOPBACK_BYTES_MAX = 1U << 20,
+};
+
+/**
+ * @brief Results of the running or the last test
+ */
+typedef struct {
+    bool running;
+    uint32_t baudrate;
+    uint32_t bytes; // Bytes received in the throughput phase
+    uint32_t bytes_per_second; // Throughput, 0 until the phase is over
+    uint32_t errors; // Bytes out of sequence, and bytes never received
+    uint32_t overruns; // Times the reader fell a whole RX buffer behind
+    uint32_t latency_min_us;
+    uint32_t latency_mean_us;
+    uint32_t latency_max_us;
+} LOOPBACK_Result;
+
+/**
+ * @brief Start a test on a UART at a baudrate, 8N1
+ *
+ * The results of the previous test are cleared.
+ *
+ * @param uart_bus UART bus to test; must not be in use
+ * @param baudrate Baudrate
+ * @param bytes Bytes of the throughput phase, 1 to LOOPBACK_BYTES_MAX
+ * @param external true if the TX and RX pins are strapped together, false
+ *                 to loop back inside the USART
+ *
+ * @throws ERROR_RESOURCE_BUSY if a test is running
+ * @throws ERROR_INVALID_ARGUMENT if bytes is out of range
+ * @throws Errors raised by UART_init and UART_configure, e.g.
+ *         ERROR_RESOURCE_BUSY for the UART carrying log output and
+ *         ERROR_INVALID_ARGUMENT for a baudrate the UART cannot generate
+ */
+void LOOPBACK_start(
+    size_t uart_bus,
+    uint32_t baudrate,
+    uint32_t bytes,
+    bool external
+);
+
+/**
+ * @brief Stop a running test and release its UART
+ *
+ * The results so far are kept. Does nothing if no test is running.
+ */
+void LOOPBACK_stop(void);
+
+/**
+ * @brief Check whether a test is running
+ *
+ * A test that has received all its bytes, or has waited for them twice
+ * the time they take on the line and 100 ms more, is over; this is where
+ * its UART is released, so call it from the main loop.
+ *
+ * @return true if the test is running
+ */
+bool LOOPBACK_running(void);
+
+/**
+ * @brief Get the results of the running or the last test
+ */
+LOOPBACK_Result LOOPBACK_get_result(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_LOOPBACK_H
@@ -0,0 +1,278 @@
+/**
+ * @file spi.c
+ * @brief Hardware-independent SPI bus controller implementation
+ *
+ * This module provides the hardware-independent layer of the SPI driver.
+ * It keeps a ring of pending transactions per bus. The one at the head is
+ * on the bus; its completion, reported by the hardware layer from
+ * interrupt context, pops it and starts the next, so a queue drains
+ * without the main loop and back-to-back transactions follow each other
+ * within an interrupt's latency.
+ *
+ * The queue is filled from the main loop and drained from the interrupt,
+ * so submission masks interrupts while it adds to the ring.
+ *
+ * This implementation relies on hardware-specific functions defined in
+ * src/platform/h563xx/spi_ll.c (or equivalent for other platforms).
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "platform/platform.h"
+#include "platform/spi_ll.h"
+#include "util/error.h"
+
+#include "clock.h"
+#include "spi.h"
+
+// Settings, outcomes and limits are handed to and from the hardware layer
+// unchanged
+static_assert(
+    (int)SPI_STATUS_OK == (int)SPI_LL_STATUS_OK &&
+        (int)SPI_STATUS_BUS_ERROR == (int)SPI_LL_STATUS_BUS_ERROR &&
+        (int)SPI_STATUS_DMA_ERROR == (int)SPI_LL_STATUS_DMA_ERROR,
+    "SPI statuses must match the hardware layer"
+);
+static_assert(
+    (int)SPI_MODE_0 == (int)SPI_LL_MODE_0 &&
+        (int)SPI_MODE_1 == (int)SPI_LL_MODE_1 &&
+        (int)SPI_MODE_2 == (int)SPI_LL_MODE_2 &&
+        (int)SPI_MODE_3 == (int)SPI_LL_MODE_3,
+    "SPI modes must match the hardware layer"
+);
+static_assert(
+    (int)SPI_SPEED_DEFAULT == (int)SPI_LL_SPEED_DEFAULT &&
+        (int)SPI_SPEED_MIN == (int)SPI_LL_SPEED_MIN &&
+        (int)SPI_SPEED_MAX == (int)SPI_LL_SPEED_MAX &&
+        (int)SPI_TRANSFER_MAX == (int)SPI_LL_TRANSFER_MAX,
+    "SPI limits must match the hardware layer"
+);
+
+/**
+ * @brief SPI bus handle structure
+ */
+struct SPI_Handle {
+    SPI_Bus bus_id;
+    SPI_Transaction *queue[SPI_QUEUE_SIZE];
+    uint32_t volatile head; // Index of the oldest pending transaction
+    uint32_t volatile count; // Pending transactions
+    bool volatile running; // The head transaction is on the bus
+    bool volatile abort_command; // Cancel up to the end of a failed command
+    SPI_Config config;
+    bool initialized;
+};
+
+/* Statically allocated handle storage, one per bus */
+static SPI_Handle g_handle_storage[SPI_BUS_COUNT];
+
+/* Global array to keep track of active SPI handles */
+static SPI_Handle *g_active_handles[SPI_BUS_COUNT] = { nullptr };
+
+size_t SPI_get_bus_count(void) { return SPI_BUS_COUNT; }
+
+/**
+ * @brief Remove the head transaction and report its outcome
+ */
+static void finish_head(SPI_Handle *handle, SPI_Status status)
+{
+    SPI_Transaction *const transaction = handle->queue[handle->head];
+
+    handle->head = (handle->head + 1) % SPI_QUEUE_SIZE;
+    handle->count -= 1;
+    // The chip select was released, so what continued the command would
+    // reach the target as a new one
+    handle->abort_command = status != SPI_STATUS_OK && transaction->hold_cs;
+    transaction->status = status;
+    if (transaction->callback) {
+        transaction->callback(transaction);
+    }
+}
+
+/**
+ * @brief Put the head transaction on the bus
+ *
+ * Called with interrupts masked, or from the completion interrupt. A
+ * transaction the hardware refuses completes with a bus error, and the
+ * next one is tried.
+ */
+static void start_head(SPI_Handle *handle)
+{
+    while (handle->count > 0 && !handle->running) {
+        if (handle->abort_command) {
+            finish_head(handle, SPI_STATUS_CANCELLED);
+            continue;
+        }
+
+        SPI_Transaction const *const transaction = handle->queue[handle->head];
+        SPI_LL_Transfer const transfer = {
+            .tx = transaction->tx,
+            .rx = transaction->rx,
+            .size = transaction->size,
+            .hold_cs = transaction->hold_cs,
+        };
+        Error err = ERROR_NONE;
+
+        TRY
+        {
+            SPI_LL_start(handle->bus_id, &transfer);
+            handle->running = true;
+        }
+        CATCH(err) { finish_head(handle, SPI_STATUS_BUS_ERROR); }
+    }
+}
+
+/**
+ * @brief Transfer complete callback from the hardware layer
+ */
+static void complete_callback(SPI_Bus bus, SPI_LL_Status status)
+{
+    SPI_Handle *const handle = g_active_handles[bus];
+
+    if (!handle || !handle->running || handle->count == 0) {
+        return;
+    }
+    handle->running = false;
+    finish_head(handle, (SPI_Status)status);
+    start_head(handle);
+}
+
+SPI_Handle *SPI_init(size_t bus)
+{
+    if (bus >= SPI_BUS_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    SPI_Bus const bus_id = (SPI_Bus)bus;
+
+    if (g_active_handles[bus_id] != nullptr) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    SPI_Handle *const handle = &g_handle_storage[bus_id];
+    handle->bus_id = bus_id;
+    handle->head = 0;
+    handle->count = 0;
+    handle->running = false;
+    handle->abort_command = false;
+    handle->config = (SPI_Config){
+        .speed = SPI_SPEED_DEFAULT,
+        .mode = SPI_MODE_0,
+        .lsb_first = false,
+    };
+    handle->initialized = false;
+
+    SPI_LL_init(bus_id);
+    SPI_LL_set_complete_callback(bus_id, complete_callback);
+    CLOCK_request();
+
+    // For the clock rate reached, which the default only approximates
+    SPI_LL_Config const ll_config = {
+        .speed = SPI_SPEED_DEFAULT,
+        .mode = SPI_LL_MODE_0,
+        .lsb_first = false,
+    };
+    Error err = ERROR_NONE;
+    TRY { handle->config.speed = SPI_LL_configure(bus_id, &ll_config); }
+    CATCH(err)
+    {
+        CLOCK_release();
+        SPI_LL_deinit(bus_id);
+        THROW(err);
+    }
+
+    handle->initialized = true;
+    g_active_handles[bus_id] = handle;
+
+    return handle;
+}
+
+void SPI_deinit(SPI_Handle *handle)
+{
+    if (!handle || !handle->initialized || handle->bus_id >= SPI_BUS_COUNT) {
+        return;
+    }
+
+    // Aborts the transfer in progress without a completion callback
+    SPI_LL_deinit(handle->bus_id);
+    SPI_LL_set_complete_callback(handle->bus_id, nullptr);
+    CLOCK_release();
+
+    g_active_handles[handle->bus_id] = nullptr;
+    handle->initialized = false;
+    handle->running = false;
+
+    while (handle->count > 0) {
+        finish_head(handle, SPI_STATUS_CANCELLED);
+    }
+}
+
+uint32_t SPI_configure(SPI_Handle *handle, SPI_Config const *config)
+{
+    if (!handle || !handle->initialized || !config ||
+        config->mode > SPI_MODE_3 || config->speed < SPI_SPEED_MIN ||
+        config->speed > SPI_SPEED_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (handle->count > 0) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    SPI_LL_Config const ll_config = {
+        .speed = config->speed,
+        .mode = (SPI_LL_Mode)config->mode,
+        .lsb_first = config->lsb_first,
+    };
+    uint32_t const speed = SPI_LL_configure(handle->bus_id, &ll_config);
+
+    handle->config = *config;
+    handle->config.speed = speed;
+    return speed;
+}
+
+void SPI_get_config(SPI_Handle const *handle, SPI_Config *config)
+{
+    if (!handle || !handle->initialized || !config) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    *config = handle->config;
+}
+
+void SPI_submit(SPI_Handle *handle, SPI_Transaction *transaction)
+{
+    if (!handle || !handle->initialized || !transaction ||
+        (!transaction->tx && !transaction->rx) || transaction->size == 0 ||
+        transaction->size > SPI_TRANSFER_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    bool accepted = false;
+    uint32_t const state = PLATFORM_disable_interrupts();
+    if (transaction->status != SPI_STATUS_PENDING &&
+        handle->count < SPI_QUEUE_SIZE) {
+        uint32_t const tail = (handle->head + handle->count) % SPI_QUEUE_SIZE;
+        transaction->status = SPI_STATUS_PENDING;
+        handle->queue[tail] = transaction;
+        handle->count += 1;
+        start_head(handle);
+        accepted = true;
+    }
+    PLATFORM_restore_interrupts(state);
+
+    if (!accepted) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+}
+
+uint32_t SPI_pending(SPI_Handle const *handle)
+{
+    if (!handle || !handle->initialized) {
+        return 0;
+    }
+    return handle->count;
+}
@@ -0,0 +1,230 @@
+/**
+ * @file spi.h
+ * @brief SPI (Serial Peripheral Interface) bus controller interface
+ *
+ * This module provides a non-blocking SPI driver for flash memories,
+ * displays and converters on the bus. Transactions are full-duplex
+ * exchanges moved by DMA between the chip select edges. They are queued
+ * and run one after another in the order they were submitted, and each
+ * one's completion callback reports its outcome.
+ *
+ * A transaction may hold the chip select low, so that the next one
+ * continues the same command: a flash page program is the command and
+ * address in one transaction and the page in the next, without copying
+ * them into one buffer.
+ *
+ * Features:
+ * - Fire-and-forget submission into a fixed-size transaction queue
+ * - Full-duplex, transmit-only or receive-only transactions
+ * - Chip select held across transactions for long commands
+ * - Completion callbacks from interrupt context, or a status to poll
+ * - Runtime clock rate up to SPI_SPEED_MAX, mode and bit order
+ *
+ * Basic Usage:
+ * @code
+ * static uint8_t const read_id[4] = { 0x9F };
+ * static uint8_t id[4];
+ * static SPI_Transaction jedec_id = {
+ *     .tx = read_id,
+ *     .rx = id,
+ *     .size = sizeof(id),
+ * };
+ *
+ * SPI_Handle *spi = SPI_init(0);
+ * SPI_submit(spi, &jedec_id);
+ *
+ * // Later, e.g. in the main loop
+ * if (jedec_id.status == SPI_STATUS_OK) {
+ *     // id[1] to id[3] hold the manufacturer and device ID
+ * }
+ *
+ * SPI_deinit(spi);
+ * @endcode
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_SPI_H
+#define PSLAB_SPI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    /** @brief Transactions that can wait in the queue of one bus */
+    SPI_QUEUE_SIZE = 8,
+    /** @brief Clock rate a bus starts with, in Hz */
+    SPI_SPEED_DEFAULT = 1000000,
+    /** @brief Lowest clock rate, in Hz */
+    SPI_SPEED_MIN = 976562,
+    /** @brief Highest clock rate, in Hz */
+    SPI_SPEED_MAX = 62500000,
+    /** @brief Most bytes moved by one transaction */
+    SPI_TRANSFER_MAX = 0xFFFF,
+};
+
+/**
+ * @brief SPI bus handle structure
+ */
+typedef struct SPI_Handle SPI_Handle;
+
+/**
+ * @brief Clock polarity and phase, in the usual mode numbering
+ */
+typedef enum {
+    SPI_MODE_0 = 0, // Clock idles low, data sampled on the rising edge
+    SPI_MODE_1, // Clock idles low, data sampled on the falling edge
+    SPI_MODE_2, // Clock idles high, data sampled on the falling edge
+    SPI_MODE_3, // Clock idles high, data sampled on the rising edge
+} SPI_Mode;
+
+/**
+ * @brief Bus settings
+ */
+typedef struct {
+    uint32_t speed; // Clock rate in Hz, SPI_SPEED_MIN to SPI_SPEED_MAX
+    SPI_Mode mode;
+    bool lsb_first; // Least significant bit first, else most
+} SPI_Config;
+
+/**
+ * @brief Outcome of a transaction
+ */
+typedef enum {
+    SPI_STATUS_OK = 0,
+    SPI_STATUS_BUS_ERROR, // Overrun or mode fault
+    SPI_STATUS_DMA_ERROR,
+    SPI_STATUS_CANCELLED, // The bus was deinitialized, or the command that
+                          // held the chip select for it failed
+    SPI_STATUS_PENDING, // Queued or in progress
+} SPI_Status;
+
+typedef struct SPI_Transaction SPI_Transaction;
+
+/**
+ * @brief Callback function type for completed transactions
+ *
+ * Called from interrupt context, or from SPI_deinit for cancelled ones.
+ * A transaction that was not cancelled may be submitted again from the
+ * callback.
+ *
+ * @param transaction The transaction, with its final status
+ */
+typedef void (*SPI_CompleteCallback)(SPI_Transaction *transaction);
+
+/**
+ * @brief A full-duplex exchange
+ *
+ * The transaction is owned by the driver from SPI_submit until its status
+ * is no longer SPI_STATUS_PENDING, and must stay valid meanwhile, as must
+ * its buffers. The two buffers may be the same one.
+ *
+ * If hold_cs is set, the chip select stays low for the next transaction.
+ * Should this one fail, the chip select is released, and the queued ones
+ * that continued its command complete with SPI_STATUS_CANCELLED up to and
+ * including the first that does not hold it.
+ */
+struct SPI_Transaction {
+    uint8_t const *tx; // Bytes to send, or nullptr to send 0xFF
+    uint8_t *rx; // Bytes received, or nullptr to discard them
+    uint32_t size; // Bytes in each direction, 1 to SPI_TRANSFER_MAX
+    bool hold_cs; // Keep the chip select low after the transaction
+    SPI_CompleteCallback callback; // Optional
+    void *context; // For the callback's use
+    SPI_Status volatile status; // Set by the driver
+};
+
+/**
+ * @brief Get the number of available SPI bus instances.
+ *
+ * @return Number of SPI buses supported by this platform
+ */
+size_t SPI_get_bus_count(void);
+
+/**
+ * @brief Initialize an SPI bus as controller
+ *
+ * Starts in mode 0, most significant bit first, at the highest clock rate
+ * not above SPI_SPEED_DEFAULT. The system clock is kept at full speed while
+ * the bus is initialized, so that the DMA keeps up with the fastest clock
+ * rates.
+ *
+ * @param bus SPI bus instance to initialize (0-based index)
+ * @return Pointer to SPI handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if bus is invalid
+ * @throws ERROR_RESOURCE_BUSY if the bus is already initialized
+ * @throws ERROR_HARDWARE_FAULT if the peripheral cannot be configured
+ */
+SPI_Handle *SPI_init(size_t bus);
+
+/**
+ * @brief Deinitialize an SPI bus
+ *
+ * A transaction in progress is aborted, and it and the queued ones complete
+ * with SPI_STATUS_CANCELLED. The chip select is released.
+ *
+ * @param handle Pointer to SPI handle structure
+ */
+void SPI_deinit(SPI_Handle *handle);
+
+/**
+ * @brief Change the settings of an idle bus
+ *
+ * The clock rate is the highest the hardware reaches that does not exceed
+ * the one asked for.
+ *
+ * @param handle Pointer to SPI handle structure
+ * @param config Settings to apply
+ * @return Clock rate reached, in Hz
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or config is invalid
+ * @throws ERROR_RESOURCE_BUSY if transactions are pending, or the chip
+ *         select is held
+ */
+uint32_t SPI_configure(SPI_Handle *handle, SPI_Config const *config);
+
+/**
+ * @brief Get the settings of a bus
+ *
+ * @param handle Pointer to SPI handle structure
+ * @param[out] config Settings last applied, with the clock rate reached
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or config is invalid
+ */
+void SPI_get_config(SPI_Handle const *handle, SPI_Config *config);
+
+/**
+ * @brief Queue a transaction
+ *
+ * Returns at once. The transaction starts when the ones before it have
+ * completed; its status is SPI_STATUS_PENDING until then.
+ *
+ * @param handle Pointer to SPI handle structure
+ * @param transaction Transaction to run
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or transaction is invalid
+ * @throws ERROR_RESOURCE_BUSY if the queue is full, or the transaction is
+ *         already pending
+ */
+void SPI_submit(SPI_Handle *handle, SPI_Transaction *transaction);
+
+/**
+ * @brief Get the number of transactions not yet completed
+ *
+ * @param handle Pointer to SPI handle structure
+ * @return Transactions queued or in progress, 0 for an invalid handle
+ */
+uint32_t SPI_pending(SPI_Handle const *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PSLAB_SPI_H */
@@ -10,9 +10,13 @@
  * Features:
  * - Support for multiple UART bus instances
  * - Non-blocking read/write operations with circular buffers
- * - Configurable RX callback for protocol implementations
+ * - Configurable RX callback for protocol implementations, with a byte
+ *   threshold and an optional timeout
  * - Buffer status inquiry functions
  * - Circular buffer implementation with automatic wrap-around
+ * - Zero-copy reads from the DMA-written RX buffer, with overrun detection
+ * - Runtime line settings
+ * - RTS/CTS flow control, pausing reception while the RX buffer is full
  *
  * This implementation relies on hardware-specific functions defined in
  * src/system/h563xx/uart_ll.c (or equivalent for other platforms).
@@ -21,19 +25,36 @@
  * @date 2025-06-28
  */
 
+#define LOG_MODULE LOG_MODULE_UART
+
+#include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include "platform/platform.h"
 #include "platform/uart_ll.h"
 #include "util/error.h"
+#include "util/si_prefix.h"
 #include "util/util.h"
 
+#include "trace.h"
 #include "uart.h"
 
+// Line settings are handed to the hardware layer by value
+static_assert(
+    (int)UART_LINE_PARITY_EVEN == (int)UART_LL_PARITY_EVEN &&
+        (int)UART_LINE_PARITY_ODD == (int)UART_LL_PARITY_ODD &&
+        (int)UART_LINE_STOP_BITS_2 == (int)UART_LL_STOP_BITS_2,
+    "UART line settings must match the hardware layer"
+);
+
+enum {
+    // Width of the hardware receiver timeout counter
+    UART_RX_TIMEOUT_BIT_TIMES_MAX = 0xFFFFFF,
+};
+
 /**
  * @brief UART bus handle structure
  */
@@ -43,12 +64,23 @@ struct UART_Handle {
     CircularBuffer *tx_buffer;
     CircularBuffer *original_tx_buffer; /* Stored during passthrough */
     uint32_t volatile rx_dma_head;
+    uint32_t volatile rx_overruns; /* Times the DMA lapped the reader */
+    bool volatile rx_overrun_pending; /* Unread data was overwritten */
+    bool volatile rx_paused; /* Flow control holds off the sender */
     UART_RxCallback rx_callback;
     uint32_t rx_threshold;
+    uint32_t rx_timeout_us; /* 0: wait for the threshold only */
+    uint32_t rx_first_us; /* When data below the threshold was first seen */
+    bool rx_waiting; /* rx_first_us is valid */
+    UART_LineConfig line_config;
+    bool loopback;
     bool initialized;
     UART_Handle *passthrough_target;
 };
 
+/* Statically allocated handle storage, one per bus */
+static UART_Handle g_handle_storage[UART_BUS_COUNT];
+
 /* Global array to keep track of active UART handles */
 static UART_Handle *g_active_handles[UART_BUS_COUNT] = { nullptr };
 
@@ -73,6 +105,50 @@ static UART_Handle *get_handle_from_bus(UART_Bus bus)
     return g_active_handles[bus];
 }
 
+/**
+ * @brief Move the RX buffer head to the DMA write position
+ *
+ * The head is shared between the DMA interrupts and the reader, so it is
+ * advanced with compare-and-swap. DMA events come at least twice per lap,
+ * so the DMA never moves a full buffer between two updates, and more new
+ * bytes than there was free space means the reader was lapped.
+ *
+ * @param handle UART handle
+ * @param dma_pos DMA write position, from 0 to the buffer size
+ *
+ * @return false if the head was moved meanwhile and dma_pos may be stale
+ */
+static bool advance_rx_head(UART_Handle *handle, uint32_t dma_pos)
+{
+    CircularBuffer *const cb = handle->rx_buffer;
+    uint32_t const new_head = dma_pos & cb->mask;
+    uint32_t old_head = __atomic_load_n(&cb->head, __ATOMIC_ACQUIRE);
+
+    if (new_head == old_head) {
+        return true;
+    }
+    if (!__atomic_compare_exchange_n(
+            &cb->head,
+            &old_head,
+            new_head,
+            false,
+            __ATOMIC_ACQ_REL,
+            __ATOMIC_ACQUIRE
+        )) {
+        return false;
+    }
+    handle->rx_dma_head = new_head;
+
+    uint32_t const received = (new_head - old_head) & cb->mask;
+    uint32_t const tail = __atomic_load_n(&cb->tail, __ATOMIC_ACQUIRE);
+    uint32_t const used = (old_head - tail) & cb->mask;
+    if (received > cb->size - 1 - used) {
+        __atomic_fetch_add(&handle->rx_overruns, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&handle->rx_overrun_pending, true, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
 /**
  * @brief Get number of bytes available in RX buffer.
  */
@@ -82,20 +158,60 @@ static uint32_t rx_buffer_available(UART_Handle *handle)
         return 0;
     }
 
-    /* Get current DMA write position */
-    uint32_t dma_pos = UART_LL_get_dma_position(handle->bus_id);
-    uint32_t dma_head = dma_pos;
-
-    /* Update our cached head position */
-    handle->rx_dma_head = dma_head;
-
-    /* Update the circular buffer's head position based on DMA */
-    handle->rx_buffer->head = dma_head;
+    /* Sample the DMA write position again if an interrupt moved the head */
+    uint32_t dma_pos = 0;
+    do {
+        dma_pos = UART_LL_get_dma_position(handle->bus_id);
+    } while (!advance_rx_head(handle, dma_pos));
 
     /* Calculate available bytes using common function */
     return circular_buffer_available(handle->rx_buffer);
 }
 
+/**
+ * @brief Pause reception while the RX buffer is half full, with flow
+ * control, and resume once the reader has caught up
+ *
+ * The head is only seen to move at the half, end and idle events, up to
+ * half a buffer apart, so at each of them there must be room for half a
+ * buffer more. Called from the RX events and after reads.
+ */
+static void update_rx_flow(UART_Handle *handle)
+{
+    if (!handle->line_config.flow_control || handle->loopback) {
+        return;
+    }
+
+    // Reads and RX events both decide, on the same head and tail
+    uint32_t const irq_state = PLATFORM_disable_interrupts();
+    bool const pause =
+        rx_buffer_available(handle) >= handle->rx_buffer->size / 2;
+    if (pause != handle->rx_paused) {
+        handle->rx_paused = pause;
+        UART_LL_set_rx_paused(handle->bus_id, pause);
+    }
+    PLATFORM_restore_interrupts(irq_state);
+}
+
+/**
+ * @brief Discard the RX buffer contents after an overrun
+ *
+ * Which of the buffered bytes were overwritten is unknown, so the reader
+ * restarts from the newest DMA position.
+ */
+static void rx_resync(UART_Handle *handle)
+{
+    if (__atomic_exchange_n(
+            &handle->rx_overrun_pending, false, __ATOMIC_ACQ_REL
+        )) {
+        __atomic_store_n(
+            &handle->rx_buffer->tail,
+            __atomic_load_n(&handle->rx_buffer->head, __ATOMIC_ACQUIRE),
+            __ATOMIC_RELEASE
+        );
+    }
+}
+
 /**
  * @brief Check if RX callback condition is met and call if needed
  *
@@ -111,14 +227,80 @@ static bool check_rx_callback(UART_Handle *handle)
         return false;
     }
 
-    if (rx_buffer_available(handle) < handle->rx_threshold) {
-        return false;
+    uint32_t const available = rx_buffer_available(handle);
+    if (available < handle->rx_threshold) {
+        if (!handle->rx_timeout_us || available == 0) {
+            handle->rx_waiting = false;
+            return false;
+        }
+
+        uint32_t const now = PLATFORM_get_time_us();
+        if (!handle->rx_waiting) {
+            handle->rx_waiting = true;
+            handle->rx_first_us = now;
+            return false;
+        }
+        if (now - handle->rx_first_us < handle->rx_timeout_us) {
+            return false;
+        }
     }
 
+    handle->rx_waiting = false;
     handle->rx_callback(handle, rx_buffer_available(handle));
     return true;
 }
 
+/**
+ * @brief Callback invoked by hardware layer when the line has been quiet
+ * for the RX timeout
+ *
+ * Hands data below the threshold to the RX callback, rather than leaving it
+ * until more data arrives.
+ *
+ * @param bus UART bus instance
+ * @param dma_pos Current DMA position
+ */
+static void rx_timeout_callback(UART_Bus bus, uint32_t dma_pos)
+{
+    TRACE_record(TRACE_EVENT_UART_RX_TIMEOUT, (uint16_t)bus);
+
+    UART_Handle *handle = get_handle_from_bus(bus);
+    if (!handle || !handle->initialized || !handle->rx_callback) {
+        return;
+    }
+
+    advance_rx_head(handle, dma_pos);
+
+    uint32_t const available = rx_buffer_available(handle);
+    if (available == 0) {
+        return;
+    }
+    handle->rx_waiting = false;
+    handle->rx_callback(handle, available);
+}
+
+/**
+ * @brief Program the hardware receiver timeout for the current baudrate
+ *
+ * @param handle UART handle
+ */
+static void apply_rx_timeout(UART_Handle *handle)
+{
+    // Round up, a bit time more is better than firing early
+    uint64_t const bit_times =
+        ((uint64_t)handle->rx_timeout_us * handle->line_config.baudrate +
+         SI_MEGA_INT - 1) /
+        SI_MEGA_INT;
+
+    UART_LL_set_rx_timeout(
+        handle->bus_id,
+        bit_times < UART_RX_TIMEOUT_BIT_TIMES_MAX
+            ? (uint32_t)bit_times
+            : UART_RX_TIMEOUT_BIT_TIMES_MAX,
+        handle->rx_timeout_us ? rx_timeout_callback : nullptr
+    );
+}
+
 /**
  * @brief Callback invoked by hardware layer on UART idle line detection
  *
@@ -127,38 +309,44 @@ static bool check_rx_callback(UART_Handle *handle)
  */
 static void idle_callback(UART_Bus bus, uint32_t dma_pos)
 {
+    TRACE_record(TRACE_EVENT_UART_RX_IDLE, (uint16_t)bus);
+
     UART_Handle *handle = get_handle_from_bus(bus);
     if (!handle || !handle->initialized) {
         return;
     }
 
-    /* Update our cached DMA position */
-    handle->rx_dma_head = dma_pos;
-    handle->rx_buffer->head = dma_pos;
+    /* Interrupts do not preempt each other, so dma_pos is current */
+    advance_rx_head(handle, dma_pos);
 
     /* Check for callbacks */
     check_rx_callback(handle);
+    update_rx_flow(handle);
 }
 
 /**
- * @brief Callback invoked by hardware layer when RX DMA reaches end of buffer
+ * @brief Callback invoked by hardware layer at half and end of RX buffer
+ *
+ * The DMA wraps around the buffer by itself; these events make sure the
+ * head is updated at least twice per lap even when the line never idles.
  *
  * @param bus UART bus instance
  */
 static void rx_complete_callback(UART_Bus bus)
 {
+    TRACE_record(TRACE_EVENT_UART_RX_COMPLETE, (uint16_t)bus);
+
     UART_Handle *handle = get_handle_from_bus(bus);
     if (!handle || !handle->initialized) {
         return;
     }
 
-    /* Hardware layer restarts DMA */
-    /* Reset DMA position */
-    handle->rx_dma_head = 0;
-    handle->rx_buffer->head = 0;
+    /* Advance the head even when nothing below does, to detect laps */
+    (void)rx_buffer_available(handle);
 
     /* Check if we should run application RX callback now */
     check_rx_callback(handle);
+    update_rx_flow(handle);
 }
 
 /**
@@ -183,45 +371,56 @@ static void start_transmission(UART_Handle *handle)
         return;
     }
 
-    /* Calculate how many contiguous bytes we can send */
-    uint32_t available = tx_buffer_available(handle);
+    uint8_t const *data = nullptr;
+    uint8_t const *wrapped = nullptr;
     uint32_t contiguous_bytes = 0;
+    uint32_t const pending = circular_buffer_peek_spans(
+        handle->tx_buffer,
+        &data,
+        &contiguous_bytes,
+        &wrapped
+    );
 
-    if (handle->tx_buffer->tail <= handle->tx_buffer->head) {
-        contiguous_bytes = handle->tx_buffer->head - handle->tx_buffer->tail;
+    /* Start hardware TX DMA, covering the wrap in the same transfer so that
+     * the bytes go out back to back */
+    if (pending > contiguous_bytes) {
+        UART_LL_start_dma_tx_wrapped(
+            handle->bus_id,
+            data,
+            contiguous_bytes,
+            wrapped,
+            pending - contiguous_bytes
+        );
     } else {
-        contiguous_bytes = handle->tx_buffer->size - handle->tx_buffer->tail;
-    }
-
-    /* Limit DMA transfer size to available bytes */
-    if (contiguous_bytes > available) {
-        contiguous_bytes = available;
+        UART_LL_start_dma_tx(handle->bus_id, data, contiguous_bytes);
     }
-
-    /* Start hardware TX DMA */
-    UART_LL_start_dma_tx(
-        handle->bus_id,
-        &handle->tx_buffer->buffer[handle->tx_buffer->tail],
-        contiguous_bytes
-    );
 }
 
 /**
- * @brief Callback invoked by hardware layer when TX DMA reaches end of buffer
+ * @brief Callback invoked by hardware layer when a TX DMA transfer is done
  *
  * @param bus UART bus instance
  * @param bytes_transferred Number of bytes transferred
  */
 static void tx_complete_callback(UART_Bus bus, uint32_t bytes_transferred)
 {
+    TRACE_record(TRACE_EVENT_UART_TX_COMPLETE, (uint16_t)bus);
+
     UART_Handle *handle = get_handle_from_bus(bus);
     if (!handle || !handle->initialized) {
         return;
     }
 
     /* Update TX buffer tail with the number of bytes that were sent */
-    handle->tx_buffer->tail =
-        (handle->tx_buffer->tail + bytes_transferred) % handle->tx_buffer->size;
+    circular_buffer_commit_read(handle->tx_buffer, bytes_transferred);
+
+    /* In passthrough, TX DMA sends straight from the other bus's RX DMA
+     * buffer; pick up what arrived during the transfer so that the chain
+     * does not wait for the next RX event */
+    if (handle->passthrough_target) {
+        rx_buffer_available(handle->passthrough_target);
+        update_rx_flow(handle->passthrough_target);
+    }
 
     /* Try to start another transmission if there's more data */
     start_transmission(handle);
@@ -252,11 +451,8 @@ UART_Handle *UART_init(
         THROW(ERROR_RESOURCE_BUSY);
     }
 
-    /* Allocate handle */
-    UART_Handle *handle = malloc(sizeof(UART_Handle));
-    if (!handle) {
-        THROW(ERROR_OUT_OF_MEMORY);
-    }
+    /* Take the bus's statically allocated handle */
+    UART_Handle *handle = &g_handle_storage[bus_id];
 
     /* Initialize handle */
     handle->bus_id = bus_id;
@@ -264,8 +460,15 @@ UART_Handle *UART_init(
     handle->tx_buffer = tx_buffer;
     handle->original_tx_buffer = nullptr;
     handle->rx_dma_head = 0;
+    handle->rx_overruns = 0;
+    handle->rx_overrun_pending = false;
+    handle->rx_paused = false;
     handle->rx_callback = nullptr;
     handle->rx_threshold = 0;
+    handle->rx_timeout_us = 0;
+    handle->rx_waiting = false;
+    handle->line_config = UART_LINE_CONFIG_DEFAULT;
+    handle->loopback = false;
     handle->initialized = false;
     handle->passthrough_target = nullptr;
 
@@ -309,11 +512,99 @@ void UART_deinit(UART_Handle *handle)
     /* Remove from active handles */
     g_active_handles[handle->bus_id] = nullptr;
 
-    /* Mark as uninitialized */
+    /* Mark as uninitialized, the storage is reused by the next UART_init */
     handle->initialized = false;
+}
+
+/**
+ * @brief Follow the hardware layer, which restarts DMA at the beginning of
+ * the RX buffer, unpaused
+ */
+static void restart_rx(UART_Handle *handle)
+{
+    handle->rx_dma_head = 0;
+    handle->rx_overrun_pending = false;
+    handle->rx_paused = false;
+    circular_buffer_reset(handle->rx_buffer);
+    handle->rx_waiting = false;
+}
+
+void UART_configure(UART_Handle *handle, UART_LineConfig const *config)
+{
+    if (!handle || !handle->initialized || !config ||
+        config->parity > UART_LINE_PARITY_ODD ||
+        config->stop_bits > UART_LINE_STOP_BITS_2 ||
+        config->oversampling > UART_LINE_OVERSAMPLING_8) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (handle->passthrough_target) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    bool oversampling_8 = config->oversampling == UART_LINE_OVERSAMPLING_8;
+    if (config->oversampling == UART_LINE_OVERSAMPLING_AUTO) {
+        oversampling_8 = config->baudrate >
+                         UART_LL_get_max_baudrate(handle->bus_id, false);
+    }
+
+    UART_LL_configure(
+        handle->bus_id,
+        &(UART_LL_LineConfig){
+            .baudrate = config->baudrate,
+            .parity = (UART_LL_Parity)config->parity,
+            .stop_bits = (UART_LL_StopBits)config->stop_bits,
+            .oversampling_8 = oversampling_8,
+            .flow_control = config->flow_control,
+        }
+    );
+
+    restart_rx(handle);
+    handle->line_config = *config;
+
+    /* The timeout is counted in bit times */
+    if (handle->rx_timeout_us) {
+        apply_rx_timeout(handle);
+    }
+
+    /* Send whatever was queued meanwhile */
+    start_transmission(handle);
+}
+
+void UART_set_loopback(UART_Handle *handle, bool enable)
+{
+    if (!handle || !handle->initialized) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (handle->passthrough_target) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    UART_LL_set_loopback(handle->bus_id, enable);
+    handle->loopback = enable;
+    restart_rx(handle);
+}
 
-    /* Free the handle */
-    free(handle);
+UART_LineConfig UART_get_config(UART_Handle *handle)
+{
+    if (!handle || !handle->initialized) {
+        return UART_LINE_CONFIG_DEFAULT;
+    }
+    return handle->line_config;
+}
+
+uint32_t UART_get_max_baudrate(
+    UART_Handle *handle,
+    UART_LineOversampling oversampling
+)
+{
+    if (!handle || !handle->initialized) {
+        return 0;
+    }
+    return UART_LL_get_max_baudrate(
+        handle->bus_id, oversampling != UART_LINE_OVERSAMPLING_16
+    );
 }
 
 /**
@@ -348,6 +639,28 @@ uint32_t UART_write(
     return bytes_written;
 }
 
+uint32_t UART_tx_reserve(UART_Handle *handle, uint8_t **data)
+{
+    if (data != nullptr) {
+        *data = nullptr;
+    }
+    if (!handle || !handle->initialized || data == nullptr ||
+        circular_buffer_free_space(handle->tx_buffer) == 0) {
+        return 0;
+    }
+    return circular_buffer_reserve_contiguous(handle->tx_buffer, data);
+}
+
+void UART_tx_commit(UART_Handle *handle, uint32_t len)
+{
+    if (!handle || !handle->initialized || len == 0) {
+        return;
+    }
+
+    circular_buffer_commit_write(handle->tx_buffer, len);
+    start_transmission(handle);
+}
+
 /**
  * @brief Read data from the UART interface.
  *
@@ -366,11 +679,48 @@ uint32_t UART_read(UART_Handle *handle, uint8_t *const rxbuf, uint32_t const sz)
         return 0;
     }
 
+    rx_resync(handle);
     uint32_t available = rx_buffer_available(handle);
     uint32_t to_read = sz > available ? available : sz;
 
     /* Read from circular buffer using common function */
-    return circular_buffer_read(handle->rx_buffer, rxbuf, to_read);
+    uint32_t const count =
+        circular_buffer_read(handle->rx_buffer, rxbuf, to_read);
+    update_rx_flow(handle);
+    return count;
+}
+
+uint32_t UART_rx_peek(UART_Handle *handle, uint8_t const **data)
+{
+    if (data != nullptr) {
+        *data = nullptr;
+    }
+    if (!handle || !handle->initialized || data == nullptr) {
+        return 0;
+    }
+
+    rx_resync(handle);
+    if (rx_buffer_available(handle) == 0) {
+        return 0;
+    }
+    return circular_buffer_peek_contiguous(handle->rx_buffer, data);
+}
+
+void UART_rx_consume(UART_Handle *handle, uint32_t len)
+{
+    if (!handle || !handle->initialized) {
+        return;
+    }
+    circular_buffer_commit_read(handle->rx_buffer, len);
+    update_rx_flow(handle);
+}
+
+uint32_t UART_get_rx_overruns(UART_Handle *handle)
+{
+    if (!handle || !handle->initialized) {
+        return 0;
+    }
+    return handle->rx_overruns;
 }
 
 bool UART_flush(UART_Handle *handle, uint32_t timeout)
@@ -380,11 +730,14 @@ bool UART_flush(UART_Handle *handle, uint32_t timeout)
     }
 
     start_transmission(handle);
-    uint32_t start_time = PLATFORM_get_tick();
+    // Time in microseconds, so the wait is not rounded up to the next tick,
+    // from the 64-bit clock, as the 32-bit one wraps before long timeouts
+    uint64_t const timeout_us = (uint64_t)timeout * SI_KILO_INT;
+    uint64_t const start_time = PLATFORM_get_time_us64();
     while (!circular_buffer_is_empty(handle->tx_buffer)) {
         /* Wait for transmission to complete */
         if (timeout) {
-            if ((PLATFORM_get_tick() - start_time) > timeout) {
+            if (PLATFORM_get_time_us64() - start_time >= timeout_us) {
                 return false;
             }
         }
@@ -480,6 +833,17 @@ void UART_set_rx_callback(
     }
 }
 
+void UART_set_rx_timeout(UART_Handle *handle, uint32_t timeout_us)
+{
+    if (!handle || !handle->initialized) {
+        return;
+    }
+
+    handle->rx_timeout_us = timeout_us;
+    handle->rx_waiting = false;
+    apply_rx_timeout(handle);
+}
+
 /**
  * @brief Passthrough callback function.
  *
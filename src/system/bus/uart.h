@@ -8,8 +8,15 @@
  *
  * Features:
  * - Non-blocking read/write operations
- * - Configurable RX callback for protocol implementations
+ * - Configurable RX callback for protocol implementations, triggered by a
+ *   byte count or a timeout, whichever comes first
  * - Buffer status inquiry functions
+ * - Zero-copy reads straight from the DMA-written RX buffer
+ * - DMA-to-DMA passthrough between two buses
+ * - RX overrun detection
+ * - Runtime line settings: baudrate, parity, stop bits and oversampling
+ * - Optional RTS/CTS flow control, holding off the sender while the RX
+ *   buffer fills up
  *
  * Basic Usage:
  * @code
@@ -74,6 +81,63 @@ typedef struct UART_Handle UART_Handle;
  */
 typedef void (*UART_RxCallback)(UART_Handle *handle, uint32_t bytes_available);
 
+/**
+ * @brief UART parity; frames carry 8 data bits plus the parity bit
+ */
+typedef enum {
+    UART_LINE_PARITY_NONE = 0,
+    UART_LINE_PARITY_EVEN,
+    UART_LINE_PARITY_ODD,
+} UART_LineParity;
+
+/**
+ * @brief UART stop bits
+ */
+typedef enum {
+    UART_LINE_STOP_BITS_1 = 0,
+    UART_LINE_STOP_BITS_2,
+} UART_LineStopBits;
+
+/**
+ * @brief UART oversampling
+ *
+ * 8x oversampling doubles the highest baudrate, but tolerates less clock
+ * mismatch and noise than 16x.
+ */
+typedef enum {
+    UART_LINE_OVERSAMPLING_AUTO = 0, // 16x if the baudrate allows it, else 8x
+    UART_LINE_OVERSAMPLING_16,
+    UART_LINE_OVERSAMPLING_8,
+} UART_LineOversampling;
+
+/**
+ * @brief UART line settings
+ *
+ * With flow control, reception pauses while half the RX buffer or more is
+ * unread; the UART then deasserts RTS, and holds off its own transmission
+ * while CTS is deasserted. RX thresholds above half the buffer may only be
+ * reached through the RX timeout. UART bus 0 has no flow control pins.
+ */
+typedef struct {
+    uint32_t baudrate; /**< Bits per second */
+    UART_LineParity parity;
+    UART_LineStopBits stop_bits;
+    UART_LineOversampling oversampling;
+    bool flow_control; /**< RTS/CTS handshake */
+} UART_LineConfig;
+
+/**
+ * @brief Line settings a UART starts with: 115200 baud, 8N1
+ */
+#define UART_LINE_CONFIG_DEFAULT                                               \
+    ((UART_LineConfig){                                                        \
+        .baudrate = 115200,                                                    \
+        .parity = UART_LINE_PARITY_NONE,                                       \
+        .stop_bits = UART_LINE_STOP_BITS_1,                                    \
+        .oversampling = UART_LINE_OVERSAMPLING_AUTO,                           \
+        .flow_control = false,                                                 \
+    })
+
 /**
  * @brief Get the number of available UART bus instances.
  *
@@ -108,6 +172,62 @@ UART_Handle *UART_init(
  */
 void UART_deinit(UART_Handle *handle);
 
+/**
+ * @brief Change the line settings of a UART.
+ *
+ * Bytes received but not yet read are discarded. Bytes queued for
+ * transmission are sent with the new settings; flush the UART first to send
+ * them with the old ones.
+ *
+ * @param handle Pointer to UART handle structure
+ * @param config Line settings
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or config is invalid, if the
+ *         baudrate is out of range, see UART_get_max_baudrate, or if flow
+ *         control is asked of a bus without it
+ * @throws ERROR_RESOURCE_BUSY if passthrough mode is active or a
+ *         transmission is in progress
+ */
+void UART_configure(UART_Handle *handle, UART_LineConfig const *config);
+
+/**
+ * @brief Get the line settings of a UART.
+ *
+ * @param handle Pointer to UART handle structure
+ * @return Settings last passed to UART_configure, or the defaults
+ */
+UART_LineConfig UART_get_config(UART_Handle *handle);
+
+/**
+ * @brief Loop the transmitter of a UART back to its own receiver.
+ *
+ * For self-tests, without a strap between the TX and RX pins; the TX pin
+ * still carries the data. Unread received bytes are dropped, as with
+ * UART_configure, and the loopback is kept across UART_configure until
+ * disabled or the UART is deinitialized.
+ *
+ * @param handle Pointer to UART handle structure
+ * @param enable true to loop back, false for normal operation
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is invalid
+ * @throws ERROR_RESOURCE_BUSY if passthrough mode is active or a
+ *         transmission is in progress
+ */
+void UART_set_loopback(UART_Handle *handle, bool enable);
+
+/**
+ * @brief Get the highest baudrate a UART supports.
+ *
+ * @param handle Pointer to UART handle structure
+ * @param oversampling UART_LINE_OVERSAMPLING_16, or UART_LINE_OVERSAMPLING_8
+ *                     or UART_LINE_OVERSAMPLING_AUTO for the absolute highest
+ * @return Highest baudrate, or 0 for an invalid handle
+ */
+uint32_t UART_get_max_baudrate(
+    UART_Handle *handle,
+    UART_LineOversampling oversampling
+);
+
 /**
  * @brief Transmit data over UART.
  *
@@ -118,6 +238,30 @@ void UART_deinit(UART_Handle *handle);
  */
 uint32_t UART_write(UART_Handle *handle, uint8_t const *txbuf, uint32_t sz);
 
+/**
+ * @brief Get free TX buffer space to fill in place
+ *
+ * Returns the contiguous free span at the end of the queued TX data. Fill
+ * it, e.g. straight from another driver's read function, and queue it with
+ * UART_tx_commit. When the free space wraps around the end of the buffer,
+ * commit and reserve again for the rest.
+ *
+ * @param handle Pointer to UART handle structure
+ * @param data Set to the start of the span, or nullptr if the buffer is full
+ * @return Number of bytes writable at *data
+ */
+uint32_t UART_tx_reserve(UART_Handle *handle, uint8_t **data);
+
+/**
+ * @brief Queue bytes written into a span from UART_tx_reserve
+ *
+ * Starts transmission if none is in progress.
+ *
+ * @param handle Pointer to UART handle structure
+ * @param len Number of bytes written, at most the length of the span
+ */
+void UART_tx_commit(UART_Handle *handle, uint32_t len);
+
 /**
  * @brief Receive data from UART.
  *
@@ -138,7 +282,9 @@ uint32_t UART_read(UART_Handle *handle, uint8_t *rxbuf, uint32_t sz);
  *       to be flushed.
  *
  * @param handle Pointer to UART handle structure
- * @param timeout Timeout period in milliseconds, 0 for infinite
+ * @param timeout Timeout period in milliseconds, 0 for infinite; timed with
+ *                the microsecond clock, so it is not rounded up to a whole
+ *                tick
  * @return true if the buffer was flushed successfully, false on timeout
  */
 bool UART_flush(UART_Handle *handle, uint32_t timeout);
@@ -162,6 +308,42 @@ bool UART_rx_ready(UART_Handle *handle);
  */
 uint32_t UART_rx_available(UART_Handle *handle);
 
+/**
+ * @brief Get received data in place, without copying it
+ *
+ * Returns the contiguous span at the start of the unread data, inside the
+ * buffer that RX DMA writes to. When the data wraps around the end of the
+ * buffer, consume the span and peek again for the rest. If an overrun was
+ * detected since the last read, the unread data is discarded first.
+ *
+ * @param handle Pointer to UART handle structure
+ * @param data Set to the start of the span, or nullptr if nothing is unread
+ * @return Number of bytes readable at *data
+ */
+uint32_t UART_rx_peek(UART_Handle *handle, uint8_t const **data);
+
+/**
+ * @brief Release bytes obtained with UART_rx_peek
+ *
+ * The DMA may overwrite the bytes as soon as they are consumed.
+ *
+ * @param handle Pointer to UART handle structure
+ * @param len Number of bytes to release, at most the length of the span
+ */
+void UART_rx_consume(UART_Handle *handle, uint32_t len);
+
+/**
+ * @brief Get the number of RX overruns since initialization
+ *
+ * An overrun means the DMA wrote a full lap of the RX buffer past the
+ * reader, overwriting unread data. Reading faster, or a larger RX buffer,
+ * avoids them.
+ *
+ * @param handle Pointer to UART handle structure
+ * @return Number of overruns detected
+ */
+uint32_t UART_get_rx_overruns(UART_Handle *handle);
+
 /**
  * @brief Set RX callback to be triggered when threshold bytes are available.
  *
@@ -176,6 +358,24 @@ void UART_set_rx_callback(
     uint32_t threshold
 );
 
+/**
+ * @brief Also trigger the RX callback when data waits below the threshold
+ *
+ * With a timeout set, the RX callback is also called once data has waited
+ * for timeout_us since it arrived without reaching the threshold, or once
+ * the line has been quiet for timeout_us. Small, slow messages are then
+ * handled promptly while a large threshold still coalesces bursts into few
+ * callbacks.
+ *
+ * The quiet time is measured by the USART itself, in bit times, and is
+ * limited to 2^24 bit times. The time since arrival is checked on RX events.
+ * The timeout follows baudrate changes made with UART_configure.
+ *
+ * @param handle Pointer to UART handle structure
+ * @param timeout_us Timeout in microseconds; 0 disables it
+ */
+void UART_set_rx_timeout(UART_Handle *handle, uint32_t timeout_us);
+
 /**
  * @brief Get TX buffer free space.
  *
@@ -198,6 +398,12 @@ bool UART_tx_busy(UART_Handle *handle);
  * This function enables passthrough mode for the specified UART buses,
  * forwarding data received on one bus to the other bus.
  *
+ * The data is not copied: each bus's TX DMA sends straight from the buffer
+ * that the other bus's RX DMA writes to, and the CPU only moves the buffer
+ * indices on DMA events. Either direction therefore runs at the line rate,
+ * limited by the RX buffer size; data that arrives faster than the other
+ * bus can send it counts as an RX overrun.
+ *
  * @warning Do not call UART operations on either handle while passthrough is
  *          active.
  *
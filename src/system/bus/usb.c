@@ -2,40 +2,65 @@
  * @file usb.c
  * @brief Hardware-independent USB interface implementation for TinyUSB
  *
- * This module provides a handle-based CDC USB API on top of the TinyUSB stack,
+ * This module provides a handle-based USB API on top of the TinyUSB stack,
  * mirroring the UART API functionality to provide a consistent interface
- * for different communication methods. While the current hardware only supports
- * a single USB interface, the handle-based design keeps the API consistent
- * with UART and makes it future-proof for potential multi-interface support.
+ * for different communication methods. Interface 0 is the CDC serial port
+ * used for SCPI; interface 1 is a vendor-class bulk channel for binary
+ * sample data; interfaces 2 and 3 are CDC serial ports for log output and
+ * the USB-UART bridge; interface 4 is the isochronous sample channel of
+ * PSLAB_USB_ISO builds. Each interface gets its own handle and buffers.
  *
  * Features:
  * - Handle-based API for consistency with UART driver
  * - Non-blocking read/write operations
- * - Configurable RX callback for protocol implementations
+ * - Configurable RX callback for protocol implementations, with a byte
+ *   threshold and an optional timeout
  * - Buffer status inquiry functions
  * - Circular buffers for reliable USB data reception and transmission
+ * - Zero-copy transmission of large caller-owned buffers
+ * - Optional event-driven servicing from the USB interrupt
+ * - Line state and line coding notifications for the serial ports
  *
  * @author Alexander Bessman
  * @date 2025-07-02
  */
 
+#define LOG_MODULE LOG_MODULE_USB
+
+#include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
-#include <stdlib.h>
 #include <string.h>
 
+#include "platform/platform.h"
 #include "platform/usb_ll.h"
 #include "util/error.h"
+#include "util/ramfunc.h"
 #include "util/util.h"
 
+#include "profile.h"
+#include "scheduler.h"
+#include "trace.h"
 #include "usb.h"
 
+// Line coding is handed up from the hardware layer by value
+static_assert(
+    (int)USB_PARITY_SPACE == (int)USB_LL_PARITY_SPACE &&
+        (int)USB_STOP_BITS_2 == (int)USB_LL_STOP_BITS_2,
+    "USB line coding must match the hardware layer"
+);
+static_assert(
+    (int)USB_INTERFACE_ISO == (int)USB_BUS_4 &&
+        (int)USB_ISO_PACKET_SIZE == (int)USB_LL_ISO_PACKET_SIZE,
+    "USB isochronous interface must match the hardware layer"
+);
+
 /* Maximum number of USB interfaces */
 #define USB_INTERFACE_COUNT USB_BUS_COUNT
 
-/* Timeout for flushing TX buffer (roughly 100 calls to USB_task) */
-enum { USB_TX_FLUSH_TIMEOUT = 100 };
+/* Default time a partial TX packet may wait for more data, in ms */
+enum { USB_TX_COALESCE_DEFAULT_MS = 1 };
 
 /**
  * @brief USB interface handle structure
@@ -44,12 +69,32 @@ struct USB_Handle {
     uint8_t interface_id;
     CircularBuffer *rx_buffer;
     CircularBuffer *tx_buffer;
+    // Caller-owned buffer queued by USB_write_buffer, sent once the
+    // tx_ring_ahead bytes of the TX buffer that precede it have been sent
+    uint8_t const *volatile tx_source;
+    uint32_t volatile tx_source_len;
+    uint32_t volatile tx_ring_ahead;
     USB_RxCallback rx_callback;
     uint32_t rx_threshold;
-    uint32_t tx_timeout_counter;
+    uint32_t rx_timeout_us; /* 0: wait for the threshold only */
+    uint32_t rx_first_us; /* When data below the threshold was first seen */
+    bool rx_waiting; /* rx_first_us is valid */
+    USB_LineStateCallback line_state_callback;
+    USB_LineCodingCallback line_coding_callback;
+    USB_FlushMode flush_mode;
+    uint32_t coalesce_ms;
+    uint32_t tx_pending_since;
+    bool tx_pending;
+    bool volatile flush_requested;
+    uint16_t volatile notify_state; // Latest state given to USB_notify
+    bool volatile notify_requested; // notify_state has not been sent yet
+    bool event_driven;
     bool initialized;
 };
 
+/* Statically allocated handle storage, one per interface */
+static USB_Handle g_handle_storage[USB_INTERFACE_COUNT];
+
 /* Global array to keep track of active USB handles */
 static USB_Handle *g_active_handles[USB_INTERFACE_COUNT] = { nullptr };
 
@@ -77,26 +122,39 @@ static USB_Handle *get_handle_from_interface(uint8_t interface_id)
 /**
  * @brief Move data from TinyUSB CDC RX buffer to our circular buffer
  *
+ * Data is read straight into the free span of the RX buffer, so a transfer
+ * costs at most two USB_LL_read calls (one per side of the wrap point).
+ *
  * @param handle Pointer to USB handle structure
  *
  * @return Number of bytes transferred
  */
-static uint32_t transfer_rx(USB_Handle *handle)
+RAMFUNC static uint32_t transfer_rx(USB_Handle *handle)
 {
     if (!handle || !handle->initialized) {
         return 0;
     }
 
-    uint32_t available = USB_LL_rx_available(handle->interface_id);
     uint32_t transferred = 0;
-    uint8_t temp = 0;
 
-    while (available > 0 && !circular_buffer_is_full(handle->rx_buffer)) {
-        if (USB_LL_read(handle->interface_id, &temp, 1) == 1) {
-            circular_buffer_put(handle->rx_buffer, temp);
-            transferred++;
-            available--;
-        } else {
+    for (;;) {
+        uint8_t *span = nullptr;
+        uint32_t len =
+            circular_buffer_reserve_contiguous(handle->rx_buffer, &span);
+        uint32_t const available = USB_LL_rx_available(handle->interface_id);
+
+        if (available < len) {
+            len = available;
+        }
+        if (len == 0) {
+            break;
+        }
+
+        uint32_t const got = USB_LL_read(handle->interface_id, span, len);
+        circular_buffer_commit_write(handle->rx_buffer, got);
+        transferred += got;
+
+        if (got < len) {
             break;
         }
     }
@@ -104,29 +162,76 @@ static uint32_t transfer_rx(USB_Handle *handle)
     return transferred;
 }
 
+/**
+ * @brief Check whether any TX data is queued above the USB hardware
+ *
+ * @param handle Pointer to USB handle structure
+ */
+RAMFUNC static bool tx_queued(USB_Handle const *handle)
+{
+    return !circular_buffer_is_empty(handle->tx_buffer) ||
+           handle->tx_source != nullptr;
+}
+
 /**
  * @brief Move data from TX circular buffer to USB TX endpoint
  *
+ * Contiguous spans of the TX buffer are handed to USB_LL_write directly,
+ * limited by the free space in the endpoint FIFO. A buffer queued with
+ * USB_write_buffer is handed over in place once the TX buffer data written
+ * before it has gone out.
+ *
  * @param handle Pointer to USB handle structure
  *
  * @return Number of bytes transferred
  */
-static uint32_t transfer_tx(USB_Handle *handle)
+RAMFUNC static uint32_t transfer_tx(USB_Handle *handle)
 {
     if (!handle || !handle->initialized) {
         return 0;
     }
 
-    uint32_t to_send = circular_buffer_available(handle->tx_buffer);
     uint32_t transferred = 0;
 
-    while (to_send > 0 && USB_LL_tx_available(handle->interface_id)) {
-        uint8_t temp = 0;
-        circular_buffer_get(handle->tx_buffer, &temp);
-        if (USB_LL_write(handle->interface_id, &temp, 1) == 1) {
-            transferred++;
-            to_send--;
+    for (;;) {
+        uint8_t const *span = nullptr;
+        uint32_t len = 0;
+        bool const from_source =
+            handle->tx_source != nullptr && handle->tx_ring_ahead == 0;
+
+        if (from_source) {
+            span = handle->tx_source;
+            len = handle->tx_source_len;
         } else {
+            len = circular_buffer_peek_contiguous(handle->tx_buffer, &span);
+            // Data written after the queued buffer has to wait for it
+            if (handle->tx_source != nullptr && len > handle->tx_ring_ahead) {
+                len = handle->tx_ring_ahead;
+            }
+        }
+
+        uint32_t const space = USB_LL_tx_available(handle->interface_id);
+        if (space < len) {
+            len = space;
+        }
+        if (len == 0) {
+            break;
+        }
+
+        uint32_t const sent = USB_LL_write(handle->interface_id, span, len);
+        if (from_source) {
+            handle->tx_source_len -= sent;
+            handle->tx_source =
+                handle->tx_source_len > 0 ? span + sent : nullptr;
+        } else {
+            circular_buffer_commit_read(handle->tx_buffer, sent);
+            if (handle->tx_source != nullptr) {
+                handle->tx_ring_ahead -= sent;
+            }
+        }
+        transferred += sent;
+
+        if (sent < len) {
             break;
         }
     }
@@ -150,11 +255,28 @@ static bool check_rx_callback(USB_Handle *handle)
         return false;
     }
 
-    if (circular_buffer_available(handle->rx_buffer) < handle->rx_threshold) {
-        return false;
+    uint32_t const available = circular_buffer_available(handle->rx_buffer);
+    if (available < handle->rx_threshold) {
+        if (!handle->rx_timeout_us || available == 0) {
+            handle->rx_waiting = false;
+            return false;
+        }
+
+        // Checked on every service pass, at least once per USB frame
+        uint32_t const now = PLATFORM_get_time_us();
+        if (!handle->rx_waiting) {
+            handle->rx_waiting = true;
+            handle->rx_first_us = now;
+            return false;
+        }
+        if (now - handle->rx_first_us < handle->rx_timeout_us) {
+            return false;
+        }
     }
 
+    handle->rx_waiting = false;
     handle->rx_callback(handle, circular_buffer_available(handle->rx_buffer));
+    SCHEDULER_post(SCHEDULER_EVENT_USB_RX);
     return true;
 }
 
@@ -172,8 +294,6 @@ static bool check_rx_callback(USB_Handle *handle)
  */
 static void line_state_callback(USB_Bus itf, bool dtr, bool rts)
 {
-    (void)rts; // We're only concerned with DTR
-
     USB_Handle *handle = get_handle_from_interface(itf);
     if (!handle || !handle->initialized) {
         return;
@@ -184,12 +304,41 @@ static void line_state_callback(USB_Bus itf, bool dtr, bool rts)
         // Reset the circular buffers to clear any pending data
         circular_buffer_reset(handle->rx_buffer);
         circular_buffer_reset(handle->tx_buffer);
+        handle->tx_source = nullptr;
+        handle->tx_source_len = 0;
 
-        // Reset the TX timeout counter
-        handle->tx_timeout_counter = 0;
+        // Nothing left to flush
+        handle->tx_pending = false;
+        handle->flush_requested = false;
+    }
+
+    if (handle->line_state_callback) {
+        handle->line_state_callback(handle, dtr, rts);
     }
 }
 
+/**
+ * @brief Pass a CDC line coding change on to the handle's owner
+ *
+ * @param itf USB interface number
+ * @param coding Line coding requested by the host
+ */
+static void line_coding_callback(USB_Bus itf, USB_LL_LineCoding const *coding)
+{
+    USB_Handle *handle = get_handle_from_interface(itf);
+    if (!handle || !handle->initialized || !handle->line_coding_callback) {
+        return;
+    }
+
+    USB_LineCoding const line_coding = {
+        .baudrate = coding->baudrate,
+        .parity = (USB_Parity)coding->parity,
+        .stop_bits = (USB_StopBits)coding->stop_bits,
+        .data_bits = coding->data_bits,
+    };
+    handle->line_coding_callback(handle, &line_coding);
+}
+
 /**
  * @brief Initialize USB hardware and TinyUSB driver
  *
@@ -218,26 +367,42 @@ USB_Handle *USB_init(
         THROW(ERROR_RESOURCE_BUSY);
     }
 
-    /* Allocate handle */
-    USB_Handle *handle = malloc(sizeof(USB_Handle));
-    if (!handle) {
-        THROW(ERROR_OUT_OF_MEMORY);
-    }
+    /* Throws if the build has no such interface, before any state changes */
+    USB_LL_init((USB_Bus)interface_id);
+
+    /* Take the interface's statically allocated handle */
+    USB_Handle *handle = &g_handle_storage[interface_id];
 
     /* Initialize handle */
     handle->interface_id = interface_id;
     handle->rx_buffer = rx_buffer;
     handle->tx_buffer = tx_buffer;
+    handle->tx_source = nullptr;
+    handle->tx_source_len = 0;
+    handle->tx_ring_ahead = 0;
     handle->rx_callback = nullptr;
     handle->rx_threshold = 0;
-    handle->tx_timeout_counter = 0;
+    handle->rx_timeout_us = 0;
+    handle->rx_waiting = false;
+    handle->line_state_callback = nullptr;
+    handle->line_coding_callback = nullptr;
+    handle->flush_mode = USB_FLUSH_COALESCE;
+    handle->coalesce_ms = USB_TX_COALESCE_DEFAULT_MS;
+    handle->tx_pending_since = 0;
+    handle->tx_pending = false;
+    handle->flush_requested = false;
+    handle->notify_state = 0;
+    handle->notify_requested = false;
+    handle->event_driven = false;
     handle->initialized = true;
 
     /* Store handle in global array */
     g_active_handles[interface_id] = handle;
 
-    USB_LL_init((USB_Bus)interface_id);
     USB_LL_set_line_state_callback((USB_Bus)interface_id, line_state_callback);
+    USB_LL_set_line_coding_callback(
+        (USB_Bus)interface_id, line_coding_callback
+    );
 
     return handle;
 }
@@ -253,38 +418,101 @@ void USB_deinit(USB_Handle *handle)
         return;
     }
 
-    /* Deinitialize USB hardware if this is interface 0 */
-    if (handle->interface_id == 0) {
-        USB_LL_deinit((USB_Bus)handle->interface_id);
-    }
+    /* Stop servicing from interrupt before the handle goes away */
+    USB_LL_set_event_callback((USB_Bus)handle->interface_id, nullptr);
+
+    /* The hardware is shut down once the last interface is released */
+    USB_LL_deinit((USB_Bus)handle->interface_id);
 
     /* Clear from global array */
     if (handle->interface_id < USB_INTERFACE_COUNT) {
         g_active_handles[handle->interface_id] = nullptr;
     }
 
-    /* Mark as uninitialized */
+    /* Mark as uninitialized, the storage is reused by the next USB_init */
     handle->initialized = false;
+}
+
+/**
+ * @brief Send a partial TX packet if the flush policy says so
+ *
+ * Full packets are sent by the stack on its own; only data that does not
+ * fill a packet waits here.
+ *
+ * @param handle Pointer to USB handle structure
+ */
+static void update_tx_flush(USB_Handle *handle)
+{
+    bool const drained = !tx_queued(handle);
+
+    if (USB_LL_tx_available(handle->interface_id) >=
+        USB_LL_tx_bufsize(handle->interface_id)) {
+        // Hardware buffer empty; an explicit flush is done once ours is too
+        if (drained) {
+            handle->tx_pending = false;
+            handle->flush_requested = false;
+        }
+        return;
+    }
+
+    uint32_t const now = PLATFORM_get_tick();
+    if (!handle->tx_pending) {
+        handle->tx_pending = true;
+        handle->tx_pending_since = now;
+    }
+
+    bool flush = handle->flush_requested && drained;
+    switch (handle->flush_mode) {
+    case USB_FLUSH_IMMEDIATE:
+        flush = flush || drained;
+        break;
+    case USB_FLUSH_COALESCE:
+        flush = flush || now - handle->tx_pending_since >= handle->coalesce_ms;
+        break;
+    case USB_FLUSH_FULL_PACKETS:
+    default:
+        break;
+    }
 
-    /* Free handle */
-    free(handle);
+    // A flush that finds the endpoint busy is retried on the next pass
+    if (flush && USB_LL_tx_flush(handle->interface_id) > 0) {
+        handle->tx_pending = false;
+        if (drained) {
+            handle->flush_requested = false;
+        }
+    }
 }
 
 /**
- * @brief Step the TinyUSB state machine
+ * @brief Send the UART state given to USB_notify, if there is a new one
  *
- * Must be called periodically (at least once per 1 ms) to handle USB events.
+ * A notification that finds the endpoint busy is retried on the next pass.
  *
  * @param handle Pointer to USB handle structure
  */
-void USB_task(USB_Handle *handle)
+static void update_notify(USB_Handle *handle)
 {
-    if (!handle || !handle->initialized) {
+    if (!handle->notify_requested) {
         return;
     }
 
-    USB_LL_task(handle->interface_id);
+    // Clear the request first, so that a state set meanwhile is not lost
+    handle->notify_requested = false;
+    if (!USB_LL_notify((USB_Bus)handle->interface_id, handle->notify_state)) {
+        handle->notify_requested = true;
+    }
+}
 
+/**
+ * @brief Move data between the TinyUSB FIFOs and the circular buffers
+ *
+ * Runs from USB_task in polled mode and from the USB service interrupt in
+ * event-driven mode.
+ *
+ * @param handle Pointer to USB handle structure
+ */
+RAMFUNC static void service(USB_Handle *handle)
+{
     // Nothing to do if not connected
     if (!USB_LL_connected(handle->interface_id)) {
         return;
@@ -299,23 +527,107 @@ void USB_task(USB_Handle *handle)
     check_rx_callback(handle);
 
     // Transfer data from our TX buffer to the USB hardware
-    if (!circular_buffer_is_empty(handle->tx_buffer)) {
+    if (tx_queued(handle)) {
         transfer_tx(handle);
     }
 
-    // Check if there's data in the hardware TX buffer and flush if timeout
-    if (USB_LL_tx_available(handle->interface_id) <
-        USB_LL_tx_bufsize(handle->interface_id)) {
-        handle->tx_timeout_counter++;
-        if (handle->tx_timeout_counter >= USB_TX_FLUSH_TIMEOUT) {
-            USB_LL_tx_flush(handle->interface_id);
-            handle->tx_timeout_counter = 0;
-        }
-    } else {
-        // No data in hardware buffer, reset counter if our buffer is also empty
-        if (circular_buffer_is_empty(handle->tx_buffer)) {
-            handle->tx_timeout_counter = 0;
-        }
+    update_tx_flush(handle);
+    update_notify(handle);
+}
+
+/**
+ * @brief USB service interrupt callback for event-driven handles
+ *
+ * @param itf USB interface number
+ */
+static void event_callback(USB_Bus itf)
+{
+    USB_Handle *handle = get_handle_from_interface(itf);
+    if (!handle || !handle->initialized || !handle->event_driven) {
+        return;
+    }
+
+    PROFILE_BEGIN(PROFILE_ZONE_USB_ISR);
+    TRACE_record(TRACE_EVENT_USB_ISR_BEGIN, (uint16_t)itf);
+    USB_LL_task(handle->interface_id);
+    service(handle);
+    TRACE_record(TRACE_EVENT_USB_ISR_END, (uint16_t)itf);
+    PROFILE_END(PROFILE_ZONE_USB_ISR);
+}
+
+/**
+ * @brief Make received data available in the RX circular buffer
+ *
+ * @param handle Pointer to USB handle structure
+ */
+static void pull_rx(USB_Handle *handle)
+{
+    if (handle->event_driven) {
+        USB_LL_request_service(handle->interface_id);
+    } else if (USB_LL_rx_available(handle->interface_id) > 0) {
+        transfer_rx(handle);
+    }
+}
+
+/**
+ * @brief Start moving queued TX data to the USB hardware
+ *
+ * @param handle Pointer to USB handle structure
+ */
+static void push_tx(USB_Handle *handle)
+{
+    if (handle->event_driven) {
+        USB_LL_request_service(handle->interface_id);
+    } else if (tx_queued(handle)) {
+        transfer_tx(handle);
+    }
+}
+
+/**
+ * @brief Step the TinyUSB state machine
+ *
+ * Must be called periodically (at least once per 1 ms) to handle USB events.
+ * In event-driven mode this only requests a service pass, which then runs
+ * from the USB service interrupt.
+ *
+ * @param handle Pointer to USB handle structure
+ */
+void USB_task(USB_Handle *handle)
+{
+    if (!handle || !handle->initialized) {
+        return;
+    }
+
+    if (handle->event_driven) {
+        USB_LL_request_service(handle->interface_id);
+        return;
+    }
+
+    PROFILE_BEGIN(PROFILE_ZONE_USB);
+    USB_LL_task(handle->interface_id);
+    service(handle);
+    PROFILE_END(PROFILE_ZONE_USB);
+}
+
+/**
+ * @brief Enable or disable event-driven servicing
+ *
+ * @param handle Pointer to USB handle structure
+ * @param enable true to service the interface from the USB interrupt
+ */
+void USB_set_event_driven(USB_Handle *handle, bool enable)
+{
+    if (!handle || !handle->initialized) {
+        return;
+    }
+
+    handle->event_driven = enable;
+    USB_LL_set_event_callback(
+        (USB_Bus)handle->interface_id, enable ? event_callback : nullptr
+    );
+
+    if (enable) {
+        USB_LL_request_service(handle->interface_id);
     }
 }
 
@@ -347,9 +659,7 @@ uint32_t USB_rx_available(USB_Handle *handle)
     }
 
     // Make sure we've transferred any available data to our buffer
-    if (USB_LL_rx_available(handle->interface_id) > 0) {
-        transfer_rx(handle);
-    }
+    pull_rx(handle);
 
     return circular_buffer_available(handle->rx_buffer);
 }
@@ -369,9 +679,7 @@ uint32_t USB_read(USB_Handle *handle, uint8_t *buf, uint32_t sz)
     }
 
     // Make sure we've transferred any available data to our buffer
-    if (USB_LL_rx_available(handle->interface_id) > 0) {
-        transfer_rx(handle);
-    }
+    pull_rx(handle);
 
     // Read from our circular buffer using the common function
     return circular_buffer_read(handle->rx_buffer, buf, sz);
@@ -394,13 +702,87 @@ uint32_t USB_write(USB_Handle *handle, uint8_t const *buf, uint32_t sz)
     uint32_t const written = circular_buffer_write(handle->tx_buffer, buf, sz);
 
     // Move as much data as possible to the USB hardware
-    if (!circular_buffer_is_empty(handle->tx_buffer)) {
-        transfer_tx(handle);
-    }
+    push_tx(handle);
 
     return written;
 }
 
+/**
+ * @brief Queue a caller-owned buffer for transmission without copying it
+ *
+ * @param handle Pointer to USB handle structure
+ * @param buf Data to send; must stay valid and unchanged until
+ *            USB_tx_buffer_pending returns false
+ * @param sz Number of bytes to send
+ * @return true if the buffer was queued
+ */
+bool USB_write_buffer(USB_Handle *handle, uint8_t const *buf, uint32_t sz)
+{
+    if (!handle || !handle->initialized || buf == nullptr || sz == 0 ||
+        handle->tx_source != nullptr) {
+        return false;
+    }
+
+    // The service interrupt must not see the buffer before the count of
+    // TX buffer bytes ahead of it is right
+    uint32_t const state = PLATFORM_disable_interrupts();
+    handle->tx_ring_ahead = circular_buffer_available(handle->tx_buffer);
+    handle->tx_source_len = sz;
+    handle->tx_source = buf;
+    PLATFORM_restore_interrupts(state);
+
+    push_tx(handle);
+    return true;
+}
+
+/**
+ * @brief Check if a buffer queued with USB_write_buffer is still being sent
+ *
+ * @param handle Pointer to USB handle structure
+ * @return true until the whole buffer has reached the USB hardware
+ */
+bool USB_tx_buffer_pending(USB_Handle *handle)
+{
+    if (!handle || !handle->initialized) {
+        return false;
+    }
+    return handle->tx_source != nullptr;
+}
+
+/**
+ * @brief Set the CDC line state callback
+ *
+ * @param handle Pointer to USB handle structure
+ * @param callback Function to call on line state changes, or nullptr
+ */
+void USB_set_line_state_callback(
+    USB_Handle *handle,
+    USB_LineStateCallback callback
+)
+{
+    if (!handle || !handle->initialized) {
+        return;
+    }
+    handle->line_state_callback = callback;
+}
+
+/**
+ * @brief Set the CDC line coding callback
+ *
+ * @param handle Pointer to USB handle structure
+ * @param callback Function to call on line coding changes, or nullptr
+ */
+void USB_set_line_coding_callback(
+    USB_Handle *handle,
+    USB_LineCodingCallback callback
+)
+{
+    if (!handle || !handle->initialized) {
+        return;
+    }
+    handle->line_coding_callback = callback;
+}
+
 /**
  * @brief Set RX callback to be triggered when threshold bytes are available.
  *
@@ -426,6 +808,16 @@ void USB_set_rx_callback(
     check_rx_callback(handle);
 }
 
+void USB_set_rx_timeout(USB_Handle *handle, uint32_t timeout_us)
+{
+    if (!handle || !handle->initialized) {
+        return;
+    }
+
+    handle->rx_timeout_us = timeout_us;
+    handle->rx_waiting = false;
+}
+
 /**
  * @brief Get TX buffer free space.
  *
@@ -439,9 +831,7 @@ uint32_t USB_tx_free_space(USB_Handle *handle)
     }
 
     // Move as much data as possible to the USB hardware
-    if (!circular_buffer_is_empty(handle->tx_buffer)) {
-        transfer_tx(handle);
-    }
+    push_tx(handle);
 
     return circular_buffer_free_space(handle->tx_buffer);
 }
@@ -457,8 +847,92 @@ bool USB_tx_busy(USB_Handle *handle)
     if (!handle || !handle->initialized) {
         return false;
     }
-    // Check if either our TX buffer or the hardware TX buffer has data
-    return !circular_buffer_is_empty(handle->tx_buffer) ||
+    // Check if either our TX queue or the hardware TX buffer has data
+    return tx_queued(handle) ||
            (USB_LL_tx_available(handle->interface_id) <
             USB_LL_tx_bufsize(handle->interface_id));
 }
+
+/**
+ * @brief Set the TX flush policy.
+ *
+ * @param handle Pointer to USB handle structure
+ * @param mode When partially filled packets are sent
+ * @param coalesce_ms Maximum time a partial packet waits in
+ *                    USB_FLUSH_COALESCE mode, in ms
+ */
+void USB_set_flush_policy(
+    USB_Handle *handle,
+    USB_FlushMode mode,
+    uint32_t coalesce_ms
+)
+{
+    if (!handle || !handle->initialized) {
+        return;
+    }
+
+    handle->flush_mode = mode;
+    handle->coalesce_ms = coalesce_ms;
+}
+
+/**
+ * @brief Send all queued TX data without waiting for the flush policy.
+ *
+ * @param handle Pointer to USB handle structure
+ */
+void USB_flush(USB_Handle *handle)
+{
+    if (!handle || !handle->initialized) {
+        return;
+    }
+
+    handle->flush_requested = true;
+
+    if (handle->event_driven) {
+        USB_LL_request_service(handle->interface_id);
+        return;
+    }
+
+    push_tx(handle);
+    update_tx_flush(handle);
+}
+
+/**
+ * @brief Report a UART state to the host
+ *
+ * @param handle Pointer to USB handle structure
+ * @param state UART state, a combination of USB_SERIAL_STATE_* bits
+ */
+void USB_notify(USB_Handle *handle, uint16_t state)
+{
+    if (!handle || !handle->initialized) {
+        return;
+    }
+
+    handle->notify_state = state;
+    handle->notify_requested = true;
+
+    if (handle->event_driven) {
+        USB_LL_request_service(handle->interface_id);
+        return;
+    }
+
+    if (USB_LL_connected(handle->interface_id)) {
+        update_notify(handle);
+    }
+}
+
+/**
+ * @brief Get the local time of the latest USB start-of-frame
+ *
+ * @param[out] frame Frame count; the low 11 bits are the host's number
+ * @param[out] time_us Local time at the start of the frame
+ * @return false if frames are not coming in, or an argument is NULL
+ */
+bool USB_get_frame_stamp(uint32_t *frame, uint32_t *time_us)
+{
+    if (!frame || !time_us) {
+        return false;
+    }
+    return USB_LL_get_frame_stamp(frame, time_us);
+}
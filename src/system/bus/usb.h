@@ -2,16 +2,27 @@
  * @file usb.h
  * @brief USB interface
  *
- * This module exposes a handle-based, CDC‐based USB API on top of the
- * TinyUSB stack. It provides a consistent interface with the UART driver
- * and allows for future expansion to support multiple USB interfaces.
+ * This module exposes a handle-based USB API on top of the TinyUSB stack.
+ * It provides a consistent interface with the UART driver. Four interfaces
+ * are available: USB_INTERFACE_CDC, the serial port used for SCPI,
+ * USB_INTERFACE_BULK, a vendor-class bulk channel for binary sample data,
+ * USB_INTERFACE_LOG, a second serial port carrying log output, and
+ * USB_INTERFACE_BRIDGE, a third serial port for the USB-UART bridge.
+ * Builds with PSLAB_USB_ISO replace the bridge with USB_INTERFACE_ISO, an
+ * isochronous channel that sends one packet of sample data per frame while
+ * the host has selected its streaming alternate setting. It is write-only,
+ * reports itself connected only while streaming, and drops no data: bytes
+ * wait in its buffers until a frame takes them.
  *
  * Features:
  * - Handle-based API for consistency with UART driver
  * - Non-blocking read/write operations
- * - Configurable RX callback for protocol implementations
+ * - Configurable RX callback for protocol implementations, triggered by a
+ *   byte count or a timeout, whichever comes first
  * - Buffer status inquiry functions
  * - Circular buffers for reliable USB data reception and transmission
+ * - Optional event-driven servicing from the USB interrupt
+ * - Line state and line coding notifications for the serial ports
  *
  * Basic Usage:
  * @code
@@ -58,6 +69,51 @@
 extern "C" {
 #endif
 
+/**
+ * @brief USB interface numbers accepted by USB_init
+ */
+enum {
+    USB_INTERFACE_CDC = 0,
+    USB_INTERFACE_BULK = 1,
+    USB_INTERFACE_LOG = 2,
+    USB_INTERFACE_BRIDGE = 3,
+    USB_INTERFACE_ISO = 4
+};
+
+/**
+ * @brief Largest packet of USB_INTERFACE_ISO, sent once per 1 ms frame
+ */
+enum { USB_ISO_PACKET_SIZE = 512 };
+
+/**
+ * @brief Bits of the UART state sent by USB_notify
+ *
+ * The bits of the CDC SERIAL_STATE notification; hosts report them as
+ * modem status lines. Bits 7 to 15 are reserved by the CDC specification
+ * and ignored by the standard drivers.
+ */
+enum {
+    USB_SERIAL_STATE_DCD = 1U << 0, // Carrier detect
+    USB_SERIAL_STATE_DSR = 1U << 1, // Data set ready
+    USB_SERIAL_STATE_BREAK = 1U << 2,
+    USB_SERIAL_STATE_RING = 1U << 3, // Ring indicator
+    USB_SERIAL_STATE_FRAMING = 1U << 4,
+    USB_SERIAL_STATE_PARITY = 1U << 5,
+    USB_SERIAL_STATE_OVERRUN = 1U << 6,
+};
+
+/**
+ * @brief TX flush policy
+ *
+ * Selects when a partially filled USB packet is sent. Full packets are
+ * always sent as soon as possible.
+ */
+typedef enum {
+    USB_FLUSH_COALESCE = 0, // Wait up to the coalescing time for more data
+    USB_FLUSH_IMMEDIATE, // Send as soon as the TX buffer has drained
+    USB_FLUSH_FULL_PACKETS, // Only send partial packets on USB_flush
+} USB_FlushMode;
+
 /**
  * @brief USB handle structure
  */
@@ -71,10 +127,63 @@ typedef struct USB_Handle USB_Handle;
  */
 typedef void (*USB_RxCallback)(USB_Handle *handle, uint32_t bytes_available);
 
+/**
+ * @brief Serial parity requested by the host
+ */
+typedef enum {
+    USB_PARITY_NONE = 0,
+    USB_PARITY_ODD,
+    USB_PARITY_EVEN,
+    USB_PARITY_MARK,
+    USB_PARITY_SPACE,
+} USB_Parity;
+
+/**
+ * @brief Serial stop bits requested by the host
+ */
+typedef enum {
+    USB_STOP_BITS_1 = 0,
+    USB_STOP_BITS_1_5,
+    USB_STOP_BITS_2,
+} USB_StopBits;
+
+/**
+ * @brief Serial line settings requested by the host for a CDC interface
+ *
+ * The device does not use them itself; they are for bridges to real serial
+ * lines.
+ */
+typedef struct {
+    uint32_t baudrate;
+    USB_Parity parity;
+    USB_StopBits stop_bits;
+    uint8_t data_bits;
+} USB_LineCoding;
+
+/**
+ * @brief Callback function type for CDC line state changes.
+ *
+ * @param handle Pointer to USB handle structure
+ * @param dtr Data Terminal Ready, asserted while the host has the port open
+ * @param rts Request To Send
+ */
+typedef void (*USB_LineStateCallback)(USB_Handle *handle, bool dtr, bool rts);
+
+/**
+ * @brief Callback function type for CDC line coding changes.
+ *
+ * @param handle Pointer to USB handle structure
+ * @param coding Line settings requested by the host
+ */
+typedef void (*USB_LineCodingCallback)(
+    USB_Handle *handle,
+    USB_LineCoding const *coding
+);
+
 /**
  * @brief Get the number of available USB interfaces.
  *
- * @return Number of USB interfaces supported by this platform (currently 1)
+ * @return Number of USB interfaces supported by this platform (currently 5)
  */
 size_t USB_get_interface_count(void);
 
@@ -84,8 +193,9 @@ size_t USB_get_interface_count(void);
  * Configures the USB hardware and initializes the TinyUSB stack for device
  * operation. Allocates and returns a new USB handle.
  *
- * @param interface USB interface to initialize (0-based index, currently only 0
- * is supported)
+ * @param interface USB interface to initialize (USB_INTERFACE_CDC,
+ * USB_INTERFACE_BULK, USB_INTERFACE_LOG, USB_INTERFACE_BRIDGE or
+ * USB_INTERFACE_ISO; one of the last two, depending on PSLAB_USB_ISO)
  * @param rx_buffer Pointer to pre-allocated RX circular buffer
  * @param tx_buffer Pointer to pre-allocated TX circular buffer
  * @return Pointer to USB handle on success, nullptr on failure (including
@@ -108,11 +218,68 @@ void USB_deinit(USB_Handle *handle);
  * @brief Step the TinyUSB state machine
  *
  * Must be called periodically (at least once per 1 ms) to handle USB events.
+ * In event-driven mode this only requests a service pass.
  *
  * @param handle Pointer to USB handle structure
  */
 void USB_task(USB_Handle *handle);
 
+/**
+ * @brief Enable or disable event-driven servicing
+ *
+ * In event-driven mode the interface is serviced from a low-priority
+ * interrupt triggered by USB activity and by USB_read/USB_write, so RX and
+ * TX data move even while the main loop is blocked, and partial packets are
+ * flushed as soon as the TX buffer drains. The RX callback is then invoked
+ * from interrupt context.
+ *
+ * @param handle Pointer to USB handle structure
+ * @param enable true to enable event-driven mode, false for polling
+ */
+void USB_set_event_driven(USB_Handle *handle, bool enable);
+
+/**
+ * @brief Set the TX flush policy.
+ *
+ * The coalescing time is measured with the system tick, so it has 1 ms
+ * resolution. Handles start in USB_FLUSH_COALESCE mode with a 1 ms limit.
+ *
+ * @param handle Pointer to USB handle structure
+ * @param mode When partially filled packets are sent
+ * @param coalesce_ms Maximum time a partial packet waits in
+ *                    USB_FLUSH_COALESCE mode, in ms
+ */
+void USB_set_flush_policy(
+    USB_Handle *handle,
+    USB_FlushMode mode,
+    uint32_t coalesce_ms
+);
+
+/**
+ * @brief Send all queued TX data without waiting for the flush policy.
+ *
+ * The final partial packet is sent once everything written so far has
+ * reached the endpoint, e.g. at the end of a protocol response.
+ *
+ * @param handle Pointer to USB handle structure
+ */
+void USB_flush(USB_Handle *handle);
+
+/**
+ * @brief Report a UART state to the host
+ *
+ * Sends a SERIAL_STATE notification on the interrupt endpoint of a CDC
+ * interface. Only the latest state is kept: a state set while the previous
+ * notification is still pending replaces the one waiting to be sent. The
+ * notification goes out from USB_task, or from the USB service interrupt
+ * for event-driven handles, once the host is connected. Other interfaces
+ * ignore the state.
+ *
+ * @param handle Pointer to USB handle structure
+ * @param state UART state, a combination of USB_SERIAL_STATE_* bits
+ */
+void USB_notify(USB_Handle *handle, uint16_t state);
+
 /**
  * @brief Check if USB RX data is available
  *
@@ -149,6 +316,59 @@ uint32_t USB_read(USB_Handle *handle, uint8_t *buf, uint32_t sz);
  */
 uint32_t USB_write(USB_Handle *handle, uint8_t const *buf, uint32_t sz);
 
+/**
+ * @brief Queue a caller-owned buffer for transmission without copying it
+ *
+ * The buffer is sent after the data already written and before data
+ * written later, straight from caller memory as the endpoint frees up, so
+ * a block larger than the TX buffer needs no copy. Only one buffer can be
+ * queued at a time. It is dropped, like the TX buffer, when the host
+ * disconnects.
+ *
+ * @param handle Pointer to USB handle structure
+ * @param buf Data to send; must stay valid and unchanged until
+ *            USB_tx_buffer_pending returns false
+ * @param sz Number of bytes to send
+ * @return true if the buffer was queued, false if another one still is
+ */
+bool USB_write_buffer(USB_Handle *handle, uint8_t const *buf, uint32_t sz);
+
+/**
+ * @brief Check if a buffer queued with USB_write_buffer is still being sent
+ *
+ * @param handle Pointer to USB handle structure
+ * @return true until the whole buffer has reached the USB hardware
+ */
+bool USB_tx_buffer_pending(USB_Handle *handle);
+
+/**
+ * @brief Set the CDC line state callback
+ *
+ * Called after the driver has handled a line state change itself; when DTR
+ * is de-asserted, the RX and TX buffers have been cleared already. Runs from
+ * the context that steps the USB stack.
+ *
+ * @param handle Pointer to USB handle structure
+ * @param callback Function to call, or nullptr to disable
+ */
+void USB_set_line_state_callback(
+    USB_Handle *handle,
+    USB_LineStateCallback callback
+);
+
+/**
+ * @brief Set the CDC line coding callback
+ *
+ * Runs from the context that steps the USB stack.
+ *
+ * @param handle Pointer to USB handle structure
+ * @param callback Function to call, or nullptr to disable
+ */
+void USB_set_line_coding_callback(
+    USB_Handle *handle,
+    USB_LineCodingCallback callback
+);
+
 /**
  * @brief Set RX callback to be triggered when threshold bytes are available.
  *
@@ -163,6 +383,19 @@ void USB_set_rx_callback(
     uint32_t threshold
 );
 
+/**
+ * @brief Also trigger the RX callback when data waits below the threshold
+ *
+ * With a timeout set, the RX callback is also called once received data has
+ * waited for timeout_us without reaching the threshold. The wait is checked
+ * on every service pass: once per USB frame in event-driven mode, and on
+ * every USB_task call otherwise.
+ *
+ * @param handle Pointer to USB handle structure
+ * @param timeout_us Timeout in microseconds; 0 disables it
+ */
+void USB_set_rx_timeout(USB_Handle *handle, uint32_t timeout_us);
+
 /**
  * @brief Get TX buffer free space.
  *
@@ -179,6 +412,21 @@ uint32_t USB_tx_free_space(USB_Handle *handle);
  */
 bool USB_tx_busy(USB_Handle *handle);
 
+/**
+ * @brief Get the local time of the latest USB start-of-frame
+ *
+ * The host numbers its 1 ms frames with an 11-bit frame number by its own
+ * clock. Pairs of a frame and its local time let the host place local
+ * timestamps, e.g. SYSTEM_get_time_us at the start of a capture, on its
+ * clock, and so align data from several boards without a trigger wire.
+ *
+ * @param[out] frame Frame count, modulo 2^32; the low 11 bits are the
+ *                   host's frame number
+ * @param[out] time_us SYSTEM_get_time_us at the start of the frame
+ * @return false if frames are not coming in, e.g. while suspended
+ */
+bool USB_get_frame_stamp(uint32_t *frame, uint32_t *time_us);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,89 @@
+/**
+ * @file checksum.c
+ * @brief Checksums of large blocks, computed in the background
+ *
+ * See checksum.h for how jobs are started and polled.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform/crc_ll.h"
+#include "util/crc.h"
+#include "util/error.h"
+
+#include "checksum.h"
+
+enum {
+    // Shorter blocks take less time in software than the DMA setup
+    CHECKSUM_OFFLOAD_MIN = 256,
+};
+
+static uint32_t software_crc(
+    CHECKSUM_Kind kind,
+    uint32_t crc,
+    void const *data,
+    uint32_t size
+)
+{
+    if (kind == CHECKSUM_CRC16) {
+        return CRC16_update((uint16_t)crc, data, size);
+    }
+    return CRC32_update(crc, data, size);
+}
+
+void CHECKSUM_start(
+    CHECKSUM_Job *job,
+    CHECKSUM_Kind kind,
+    uint32_t crc,
+    void const *data,
+    uint32_t size
+)
+{
+    job->offloaded = false;
+
+    if (size >= CHECKSUM_OFFLOAD_MIN && !CRC_LL_busy()) {
+        Error err = ERROR_NONE;
+        TRY
+        {
+            CRC_LL_start(
+                kind == CHECKSUM_CRC16 ? CRC_LL_CRC16 : CRC_LL_CRC32,
+                crc,
+                data,
+                size
+            );
+            job->offloaded = true;
+        }
+        CATCH(err)
+        {
+            // No DMA channel free; fall back to software
+            (void)err;
+        }
+        if (job->offloaded) {
+            return;
+        }
+    }
+
+    job->crc = software_crc(kind, crc, data, size);
+}
+
+bool CHECKSUM_result(CHECKSUM_Job *job, uint32_t *crc)
+{
+    if (job->offloaded) {
+        if (!CRC_LL_done()) {
+            return false;
+        }
+        job->crc = CRC_LL_result();
+        job->offloaded = false;
+    }
+    *crc = job->crc;
+    return true;
+}
+
+void CHECKSUM_cancel(CHECKSUM_Job *job)
+{
+    if (job->offloaded) {
+        CRC_LL_abort();
+        job->offloaded = false;
+    }
+}
@@ -0,0 +1,91 @@
+/**
+ * @file checksum.h
+ * @brief Checksums of large blocks, computed in the background
+ *
+ * Blocks of sample data are checksummed by the CRC unit, fed by DMA, while
+ * the CPU goes on with acquisition and USB; the caller polls for the
+ * result:
+ *
+ *     CHECKSUM_Job job;
+ *     CHECKSUM_start(&job, CHECKSUM_CRC32, CRC32_INIT, data, size);
+ *     ...
+ *     uint32_t crc = 0;
+ *     if (CHECKSUM_result(&job, &crc)) {
+ *         ... send crc ...
+ *     }
+ *
+ * The unit takes one block at a time. A job started while it is taken, or
+ * too short to be worth the DMA setup, is computed in software on the spot,
+ * so a job never fails. Either way the results are those of util/crc.h.
+ */
+
+#ifndef SYSTEM_CHECKSUM_H
+#define SYSTEM_CHECKSUM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Checksums, see util/crc.h
+ */
+typedef enum {
+    CHECKSUM_CRC16, // CRC-16/CCITT-FALSE, as CRC16_update
+    CHECKSUM_CRC32, // CRC-32/MPEG-2, as CRC32_update
+} CHECKSUM_Kind;
+
+/**
+ * @brief A checksum being computed, to be kept by the caller
+ */
+typedef struct {
+    bool offloaded; // Held by the CRC unit until its result is taken
+    uint32_t crc; // Result, if computed in software
+} CHECKSUM_Job;
+
+/**
+ * @brief Start a checksum over a block
+ *
+ * The data must stay in place until the result has been taken or the job
+ * cancelled.
+ *
+ * @param job Job to start; must not hold a checksum
+ * @param kind Checksum to compute
+ * @param crc CRC16_INIT or CRC32_INIT, or the result over the data
+ *            preceding this block
+ * @param data Input bytes
+ * @param size Number of bytes
+ */
+void CHECKSUM_start(
+    CHECKSUM_Job *job,
+    CHECKSUM_Kind kind,
+    uint32_t crc,
+    void const *data,
+    uint32_t size
+);
+
+/**
+ * @brief Take the result of a job once it is done
+ *
+ * @param job Started job
+ * @param crc Receives the CRC; a CRC-16 in the low 16 bits
+ * @return false while the CRC unit is still at it
+ */
+bool CHECKSUM_result(CHECKSUM_Job *job, uint32_t *crc);
+
+/**
+ * @brief Drop a job, so that its data may be released
+ *
+ * Does nothing for a job whose result has been taken.
+ *
+ * @param job Started job
+ */
+void CHECKSUM_cancel(CHECKSUM_Job *job);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_CHECKSUM_H
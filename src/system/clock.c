@@ -0,0 +1,54 @@
+/**
+ * @file clock.c
+ * @brief Core clock scaling between idle and active periods
+ *
+ * See clock.h for how the full clock is requested.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform/platform.h"
+
+#include "clock.h"
+
+// Outstanding CLOCK_request calls, released from interrupts as well
+static uint32_t volatile g_requests = 0;
+
+void CLOCK_request(void)
+{
+    if (PLATFORM_get_clock_speed() != PLATFORM_CLOCK_SPEED_FULL) {
+        PLATFORM_set_clock_speed(PLATFORM_CLOCK_SPEED_FULL);
+    }
+    __atomic_fetch_add(&g_requests, 1, __ATOMIC_ACQ_REL);
+}
+
+void CLOCK_release(void)
+{
+    uint32_t requests = __atomic_load_n(&g_requests, __ATOMIC_ACQUIRE);
+
+    while (requests > 0 &&
+           !__atomic_compare_exchange_n(
+               &g_requests,
+               &requests,
+               requests - 1,
+               false,
+               __ATOMIC_ACQ_REL,
+               __ATOMIC_ACQUIRE
+           )) {
+    }
+}
+
+void CLOCK_idle(void)
+{
+    // Requests are only made from the main loop, this one cannot race them
+    if (__atomic_load_n(&g_requests, __ATOMIC_ACQUIRE) == 0 &&
+        PLATFORM_get_clock_speed() != PLATFORM_CLOCK_SPEED_LOW) {
+        PLATFORM_set_clock_speed(PLATFORM_CLOCK_SPEED_LOW);
+    }
+}
+
+uint32_t CLOCK_get_requests(void)
+{
+    return __atomic_load_n(&g_requests, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,69 @@
+/**
+ * @file clock.h
+ * @brief Core clock scaling between idle and active periods
+ *
+ * While no instrument is running, the core and buses run from a low clock,
+ * which cuts the power drawn while the device waits for commands. Code that
+ * needs the full clock requests it for as long as it runs:
+ *
+ *     CLOCK_request();
+ *     ... configure timers, acquire ...
+ *     CLOCK_release();
+ *
+ * Requests nest. A request restores the full clock straight away, while
+ * the low clock only comes back once all requests are released and the
+ * scheduler finds nothing to do, so short gaps between requests do not
+ * switch back and forth. Timer rates are only correct at the clock speed
+ * they were configured at, so timers are both configured and run under a
+ * request.
+ */
+
+#ifndef SYSTEM_CLOCK_H
+#define SYSTEM_CLOCK_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Request the full clock
+ *
+ * Returns once the clock is at full speed. Not to be called from interrupt
+ * context.
+ *
+ * @throws ERROR_HARDWARE_FAULT if the clock cannot be switched
+ */
+void CLOCK_request(void);
+
+/**
+ * @brief Release a request made with CLOCK_request
+ *
+ * Safe to call from interrupt context, so that an acquisition can release
+ * its request when it completes. Releases without a matching request are
+ * ignored.
+ */
+void CLOCK_release(void);
+
+/**
+ * @brief Drop to the low clock if nothing requests the full one
+ *
+ * Called by the scheduler before it sleeps.
+ *
+ * @throws ERROR_HARDWARE_FAULT if the clock cannot be switched
+ */
+void CLOCK_idle(void);
+
+/**
+ * @brief Get the number of outstanding requests
+ *
+ * @return Requests not released yet; the clock is low when zero
+ */
+uint32_t CLOCK_get_requests(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_CLOCK_H
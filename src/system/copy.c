@@ -0,0 +1,63 @@
+/**
+ * @file copy.c
+ * @brief Memory copies in the background
+ *
+ * See copy.h for how copies are started and their end signalled.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform/copy_ll.h"
+#include "util/error.h"
+
+#include "copy.h"
+
+enum {
+    // Shorter blocks take less time on the CPU than the DMA setup
+    COPY_OFFLOAD_MIN = 1024,
+};
+
+void COPY_start(
+    void *dst,
+    void const *src,
+    uint32_t size,
+    COPY_Callback callback,
+    void *context
+)
+{
+    if (dst == nullptr || src == nullptr) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (size >= COPY_OFFLOAD_MIN && !COPY_LL_busy()) {
+        bool volatile offloaded = false;
+        Error err = ERROR_NONE;
+        TRY
+        {
+            COPY_LL_start(dst, src, size, callback, context);
+            offloaded = true;
+        }
+        CATCH(err)
+        {
+            // No DMA channel free; fall back to the CPU
+            (void)err;
+        }
+        if (offloaded) {
+            return;
+        }
+    }
+
+    memcpy(dst, src, size);
+    if (callback != nullptr) {
+        callback(context, true);
+    }
+}
+
+bool COPY_busy(void) { return COPY_LL_busy(); }
+
+void COPY_cancel(void) { COPY_LL_abort(); }
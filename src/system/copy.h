@@ -0,0 +1,80 @@
+/**
+ * @file copy.h
+ * @brief Memory copies in the background
+ *
+ * Large moves between buffers, such as sample records packed for a fetch,
+ * are made by a DMA channel while the CPU goes on with acquisition and
+ * USB; the caller learns of the end of the copy from a callback:
+ *
+ *     static void copied(void *context, bool ok) { ... }
+ *     ...
+ *     COPY_start(dst, src, size, copied, context);
+ *
+ * The DMA engine takes one copy at a time. A copy started while it is
+ * taken, or too short to be worth the DMA setup, is made by the CPU on the
+ * spot, and its callback is called before COPY_start returns. Otherwise
+ * the callback is called from the DMA channel interrupt, so it must be
+ * short and safe in interrupt context, and must not start another copy.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef SYSTEM_COPY_H
+#define SYSTEM_COPY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Called once a copy has ended
+ *
+ * @param context Context given to COPY_start
+ * @param ok false if the DMA hit a bus error, and the copy is incomplete
+ */
+typedef void (*COPY_Callback)(void *context, bool ok);
+
+/**
+ * @brief Copy a block of memory, in the background if worth it
+ *
+ * Both blocks must stay in place, and be left alone by the caller, until
+ * the callback has been called. They must not overlap.
+ *
+ * @param dst Destination
+ * @param src Source
+ * @param size Number of bytes
+ * @param callback Called once the copy has ended, or nullptr
+ * @param context Passed to the callback
+ *
+ * @throws ERROR_INVALID_ARGUMENT if a block is NULL
+ */
+void COPY_start(
+    void *dst,
+    void const *src,
+    uint32_t size,
+    COPY_Callback callback,
+    void *context
+);
+
+/**
+ * @brief Check whether a copy is running in the background
+ */
+bool COPY_busy(void);
+
+/**
+ * @brief Stop the copy running in the background, without its callback
+ *
+ * Part of the destination may have been written. Does nothing if no copy
+ * is running.
+ */
+void COPY_cancel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_COPY_H
@@ -0,0 +1,614 @@
+/**
+ * @file datalog.c
+ * @brief Unattended data logger on external SPI flash
+ *
+ * The flash is driven with the common JEDEC command set with 3-byte
+ * addresses: read identification, read, page program, 4 KiB sector erase,
+ * and the status register for the end of each program or erase. Every
+ * operation is a few transactions queued on the SPI bus; DATALOG_task
+ * checks their outcome and polls the busy bit once per run, so the main
+ * loop never waits for the flash.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform/platform.h"
+#include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/logging.h"
+
+#include "bus/spi.h"
+#include "datalog.h"
+#include "instrument/dmm.h"
+
+enum {
+    CMD_PAGE_PROGRAM = 0x02,
+    CMD_READ_DATA = 0x03,
+    CMD_READ_STATUS = 0x05,
+    CMD_WRITE_ENABLE = 0x06,
+    CMD_SECTOR_ERASE = 0x20,
+    CMD_READ_ID = 0x9F,
+    STATUS_BUSY = 0x01, // Write in progress
+    COMMAND_SIZE = 4, // Command and 3-byte address
+    ID_SIZE = 4, // Command, manufacturer, memory type and density
+    DENSITY_MIN = 16, // log2 of the smallest flash, 64 KiB
+    PAGE_HEADER_SIZE = 8,
+    RECORD_HEADER_SIZE = 6,
+    RECORD_END = 0xFF, // Erased flash
+    SPI_SPEED = 31250000, // Hz, within the read command's limit
+};
+
+/**
+ * @brief Flash operation in progress
+ */
+typedef enum {
+    STEP_IDLE,
+    STEP_COMMAND, // Erase or program queued on the bus
+    STEP_POLL, // Reading the status register until the busy bit clears
+} Step;
+
+// Logger state (internal to this module)
+static struct {
+    DATALOG_State state;
+    SPI_Handle *spi;
+    DMM_Handle *dmm;
+    uint32_t interval;
+    uint32_t next_sample; // Tick the next record is due
+    uint32_t capacity;
+    uint16_t session;
+    uint32_t records;
+    uint32_t dropped;
+    uint32_t address; // Next page to program
+    uint32_t erased_end; // End of the sectors erased for this log
+    Step step;
+    bool programming; // The operation in flight programs a page
+    // Page buffers, filled alternately and programmed oldest first
+    uint8_t pages[2][DATALOG_PAGE_SIZE];
+    bool full[2];
+    uint32_t fill; // Page being filled
+    uint32_t used; // Bytes of it used
+    uint32_t next_write; // Oldest full page
+    uint32_t page_index; // Of the page being filled, within the session
+    // Flash transactions and their bytes
+    SPI_Transaction write_enable;
+    SPI_Transaction command;
+    SPI_Transaction data;
+    SPI_Transaction poll;
+    SPI_Transaction read_command;
+    SPI_Transaction read_data;
+    uint8_t write_enable_byte;
+    uint8_t command_bytes[COMMAND_SIZE];
+    uint8_t read_command_bytes[COMMAND_SIZE];
+    uint8_t poll_tx[2];
+    uint8_t poll_rx[2];
+    uint8_t id[ID_SIZE];
+    uint8_t found_header[PAGE_HEADER_SIZE]; // Of the log already on flash
+} g_datalog = {
+    .state = DATALOG_STATE_OFF,
+    .spi = nullptr,
+    .dmm = nullptr,
+};
+
+static void put_u16(uint8_t *bytes, uint16_t value)
+{
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t *bytes, uint32_t value)
+{
+    put_u16(bytes, (uint16_t)value);
+    put_u16(bytes + 2, (uint16_t)(value >> 16));
+}
+
+static uint16_t get_u16(uint8_t const *bytes)
+{
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+/**
+ * @brief Fill in a command with its address, most significant byte first
+ */
+static void set_command(uint8_t *bytes, uint8_t command, uint32_t address)
+{
+    bytes[0] = command;
+    bytes[1] = (uint8_t)(address >> 16);
+    bytes[2] = (uint8_t)(address >> 8);
+    bytes[3] = (uint8_t)address;
+}
+
+static void release_dmm(void)
+{
+    if (g_datalog.dmm) {
+        DMM_deinit(g_datalog.dmm);
+        g_datalog.dmm = nullptr;
+    }
+}
+
+/**
+ * @brief Give up on the flash until the logger is initialized again
+ */
+static void fail(char const *what)
+{
+    LOG_ERROR("DATALOG: %s failed", what);
+    release_dmm();
+    g_datalog.step = STEP_IDLE;
+    g_datalog.state = DATALOG_STATE_ERROR;
+}
+
+/**
+ * @brief Queue a transaction, failing the logger if the bus refuses it
+ */
+static bool submit(SPI_Transaction *transaction)
+{
+    Error err = ERROR_NONE;
+
+    TRY { SPI_submit(g_datalog.spi, transaction); }
+    CATCH(err)
+    {
+        LOG_ERROR("DATALOG: SPI submit error: 0x%08X", err);
+        fail("Flash access");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Queue a read of the flash into data
+ */
+static bool submit_read(uint32_t address, uint8_t *data, uint32_t size)
+{
+    set_command(g_datalog.read_command_bytes, CMD_READ_DATA, address);
+    g_datalog.read_command = (SPI_Transaction){
+        .tx = g_datalog.read_command_bytes,
+        .size = COMMAND_SIZE,
+        .hold_cs = true,
+    };
+    g_datalog.read_data = (SPI_Transaction){
+        .rx = data,
+        .size = size,
+    };
+    return submit(&g_datalog.read_command) && submit(&g_datalog.read_data);
+}
+
+static bool submit_write_enable(void)
+{
+    g_datalog.write_enable_byte = CMD_WRITE_ENABLE;
+    g_datalog.write_enable = (SPI_Transaction){
+        .tx = &g_datalog.write_enable_byte,
+        .size = 1,
+    };
+    return submit(&g_datalog.write_enable);
+}
+
+static bool submit_poll(void)
+{
+    g_datalog.poll_tx[0] = CMD_READ_STATUS;
+    g_datalog.poll_tx[1] = 0xFF;
+    g_datalog.poll = (SPI_Transaction){
+        .tx = g_datalog.poll_tx,
+        .rx = g_datalog.poll_rx,
+        .size = sizeof(g_datalog.poll_tx),
+    };
+    return submit(&g_datalog.poll);
+}
+
+/**
+ * @brief Start the page being filled, with its header
+ */
+static void open_page(void)
+{
+    uint8_t *const page = g_datalog.pages[g_datalog.fill];
+
+    put_u16(page, DATALOG_PAGE_MAGIC);
+    put_u16(page + 2, g_datalog.session);
+    put_u32(page + 4, g_datalog.page_index);
+    g_datalog.used = PAGE_HEADER_SIZE;
+}
+
+/**
+ * @brief Hand the page being filled over to be programmed
+ *
+ * @return false if the other page is still waiting to be programmed
+ */
+static bool close_page(void)
+{
+    uint32_t const other = g_datalog.fill ^ 1;
+
+    if (g_datalog.full[other]) {
+        return false;
+    }
+
+    uint8_t *const page = g_datalog.pages[g_datalog.fill];
+    memset(
+        page + g_datalog.used, RECORD_END, DATALOG_PAGE_SIZE - g_datalog.used
+    );
+    g_datalog.full[g_datalog.fill] = true;
+    g_datalog.fill = other;
+    g_datalog.page_index += 1;
+    open_page();
+    return true;
+}
+
+/**
+ * @brief Add a record to the page being filled
+ */
+static void append(uint32_t tick, FIXED_Q1616 const *values, uint32_t count)
+{
+    uint32_t const size = RECORD_HEADER_SIZE + count * sizeof(int32_t);
+
+    if (g_datalog.used + size > DATALOG_PAGE_SIZE && !close_page()) {
+        g_datalog.dropped += 1;
+        return;
+    }
+
+    uint8_t *record = g_datalog.pages[g_datalog.fill] + g_datalog.used;
+    record[0] = DATALOG_RECORD_DMM_SCAN;
+    record[1] = (uint8_t)count;
+    put_u32(record + 2, tick);
+    record += RECORD_HEADER_SIZE;
+    for (uint32_t i = 0; i < count; i++) {
+        put_u32(record + i * sizeof(int32_t), (uint32_t)values[i]);
+    }
+    g_datalog.used += size;
+}
+
+/**
+ * @brief Take a record once it is due and the DMM has converted
+ */
+static void sample(void)
+{
+    uint32_t const now = PLATFORM_get_tick();
+
+    if (g_datalog.state != DATALOG_STATE_RUNNING ||
+        (int32_t)(now - g_datalog.next_sample) < 0) {
+        return;
+    }
+
+    FIXED_Q1616 values[DMM_SCAN_CHANNELS_MAX];
+    uint32_t count = 0;
+    Error err = ERROR_NONE;
+
+    TRY { count = DMM_read_scan(g_datalog.dmm, values, DMM_SCAN_CHANNELS_MAX); }
+    CATCH(err)
+    {
+        LOG_ERROR("DATALOG: DMM error: 0x%08X", err);
+        fail("DMM read");
+        return;
+    }
+    // Not converted yet, tried again on the next run
+    if (count == 0) {
+        return;
+    }
+
+    // Keep the cadence, unless so far behind that records would bunch up
+    g_datalog.next_sample += g_datalog.interval;
+    if ((int32_t)(now - g_datalog.next_sample) >= 0) {
+        g_datalog.next_sample = now + g_datalog.interval;
+    }
+    g_datalog.records += 1;
+    append(now, values, count);
+}
+
+/**
+ * @brief Take the outcome of the identification and of the log header
+ */
+static void finish_detect(void)
+{
+    if (SPI_pending(g_datalog.spi) > 0) {
+        return;
+    }
+    if (g_datalog.command.status != SPI_STATUS_OK ||
+        g_datalog.read_data.status != SPI_STATUS_OK) {
+        fail("Flash identification");
+        return;
+    }
+
+    uint8_t const manufacturer = g_datalog.id[1];
+    uint8_t const density = g_datalog.id[3];
+    if (manufacturer == 0x00 || manufacturer == 0xFF ||
+        density < DENSITY_MIN || density == 0xFF) {
+        LOG_ERROR("DATALOG: No flash, ID %02X %02X", manufacturer, density);
+        fail("Flash identification");
+        return;
+    }
+
+    g_datalog.capacity = density >= 24 ? DATALOG_CAPACITY_MAX : 1U << density;
+    g_datalog.session =
+        get_u16(g_datalog.found_header) == DATALOG_PAGE_MAGIC
+            ? get_u16(g_datalog.found_header + 2)
+            : 0;
+    g_datalog.state = DATALOG_STATE_READY;
+    LOG_INFO(
+        "DATALOG: Flash %02X, %u KiB, session %u",
+        manufacturer,
+        g_datalog.capacity / 1024,
+        g_datalog.session
+    );
+}
+
+/**
+ * @brief Queue the erase of the next sector or the program of a page
+ */
+static void start_operation(void)
+{
+    bool const flushing = g_datalog.state == DATALOG_STATE_FLUSHING;
+
+    if (flushing && !g_datalog.full[g_datalog.fill] &&
+        g_datalog.used > PAGE_HEADER_SIZE) {
+        close_page();
+    }
+    if (!g_datalog.full[g_datalog.next_write]) {
+        if (flushing) {
+            g_datalog.state = DATALOG_STATE_READY;
+            LOG_INFO("DATALOG: Stopped, %u bytes", g_datalog.address);
+        }
+        return;
+    }
+
+    if (g_datalog.address >= g_datalog.erased_end) {
+        set_command(
+            g_datalog.command_bytes, CMD_SECTOR_ERASE, g_datalog.address
+        );
+        g_datalog.command = (SPI_Transaction){
+            .tx = g_datalog.command_bytes,
+            .size = COMMAND_SIZE,
+        };
+        g_datalog.erased_end = g_datalog.address + DATALOG_SECTOR_SIZE;
+        g_datalog.programming = false;
+        g_datalog.step = STEP_COMMAND;
+        if (submit_write_enable()) {
+            submit(&g_datalog.command);
+        }
+        return;
+    }
+
+    set_command(g_datalog.command_bytes, CMD_PAGE_PROGRAM, g_datalog.address);
+    g_datalog.command = (SPI_Transaction){
+        .tx = g_datalog.command_bytes,
+        .size = COMMAND_SIZE,
+        .hold_cs = true,
+    };
+    g_datalog.data = (SPI_Transaction){
+        .tx = g_datalog.pages[g_datalog.next_write],
+        .size = DATALOG_PAGE_SIZE,
+    };
+    g_datalog.programming = true;
+    g_datalog.step = STEP_COMMAND;
+    if (submit_write_enable() && submit(&g_datalog.command)) {
+        submit(&g_datalog.data);
+    }
+}
+
+/**
+ * @brief The page being programmed is done
+ */
+static void finish_program(void)
+{
+    g_datalog.full[g_datalog.next_write] = false;
+    g_datalog.next_write ^= 1;
+    g_datalog.address += DATALOG_PAGE_SIZE;
+
+    if (g_datalog.address >= g_datalog.capacity) {
+        // The page still buffered, if any, is lost
+        release_dmm();
+        g_datalog.full[0] = false;
+        g_datalog.full[1] = false;
+        g_datalog.state = DATALOG_STATE_FULL;
+        LOG_WARN("DATALOG: Flash full");
+    }
+}
+
+/**
+ * @brief Check on the flash operation in flight, and start the next one
+ */
+static void advance_flash(void)
+{
+    switch (g_datalog.step) {
+    case STEP_COMMAND:
+        if (SPI_pending(g_datalog.spi) > 0) {
+            return;
+        }
+        if (g_datalog.write_enable.status != SPI_STATUS_OK ||
+            g_datalog.command.status != SPI_STATUS_OK ||
+            (g_datalog.programming &&
+             g_datalog.data.status != SPI_STATUS_OK)) {
+            fail(g_datalog.programming ? "Page program" : "Sector erase");
+            return;
+        }
+        g_datalog.step = STEP_POLL;
+        submit_poll();
+        return;
+
+    case STEP_POLL:
+        if (g_datalog.poll.status == SPI_STATUS_PENDING) {
+            return;
+        }
+        if (g_datalog.poll.status != SPI_STATUS_OK) {
+            fail("Status read");
+            return;
+        }
+        if (g_datalog.poll_rx[1] & STATUS_BUSY) {
+            submit_poll();
+            return;
+        }
+        g_datalog.step = STEP_IDLE;
+        if (g_datalog.programming) {
+            g_datalog.programming = false;
+            finish_program();
+        }
+        break;
+
+    case STEP_IDLE:
+        break;
+    }
+
+    if (g_datalog.state == DATALOG_STATE_RUNNING ||
+        g_datalog.state == DATALOG_STATE_FLUSHING) {
+        start_operation();
+    }
+}
+
+void DATALOG_init(void)
+{
+    if (g_datalog.state != DATALOG_STATE_OFF) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    g_datalog.spi = SPI_init(0);
+
+    Error err = ERROR_NONE;
+    TRY
+    {
+        SPI_Config const config = {
+            .speed = SPI_SPEED,
+            .mode = SPI_MODE_0,
+            .lsb_first = false,
+        };
+        SPI_configure(g_datalog.spi, &config);
+    }
+    CATCH(err)
+    {
+        SPI_deinit(g_datalog.spi);
+        g_datalog.spi = nullptr;
+        THROW(err);
+    }
+
+    g_datalog.state = DATALOG_STATE_DETECTING;
+    g_datalog.step = STEP_IDLE;
+    g_datalog.capacity = 0;
+    g_datalog.session = 0;
+    g_datalog.records = 0;
+    g_datalog.dropped = 0;
+    g_datalog.address = 0;
+
+    memset(g_datalog.id, 0, sizeof(g_datalog.id));
+    g_datalog.id[0] = CMD_READ_ID;
+    g_datalog.command = (SPI_Transaction){
+        .tx = g_datalog.id,
+        .rx = g_datalog.id,
+        .size = ID_SIZE,
+    };
+    if (submit(&g_datalog.command)) {
+        submit_read(
+            0, g_datalog.found_header, sizeof(g_datalog.found_header)
+        );
+    }
+}
+
+void DATALOG_deinit(void)
+{
+    if (g_datalog.state == DATALOG_STATE_OFF) {
+        return;
+    }
+
+    release_dmm();
+    // Cancels the operation in flight and releases the chip select
+    SPI_deinit(g_datalog.spi);
+    g_datalog.spi = nullptr;
+    g_datalog.step = STEP_IDLE;
+    g_datalog.state = DATALOG_STATE_OFF;
+}
+
+void DATALOG_start(DATALOG_Config const *config)
+{
+    if (!config || config->interval < DATALOG_INTERVAL_MIN ||
+        config->dmm.burst_samples > 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_datalog.state != DATALOG_STATE_READY &&
+        g_datalog.state != DATALOG_STATE_FULL) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+    if (g_datalog.read_data.status == SPI_STATUS_PENDING) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    g_datalog.dmm = DMM_init(&config->dmm);
+    if (!g_datalog.dmm) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+
+    g_datalog.interval = config->interval;
+    g_datalog.next_sample = PLATFORM_get_tick();
+    g_datalog.session += 1;
+    g_datalog.records = 0;
+    g_datalog.dropped = 0;
+    g_datalog.address = 0;
+    g_datalog.erased_end = 0;
+    g_datalog.full[0] = false;
+    g_datalog.full[1] = false;
+    g_datalog.fill = 0;
+    g_datalog.next_write = 0;
+    g_datalog.page_index = 0;
+    open_page();
+    g_datalog.state = DATALOG_STATE_RUNNING;
+    LOG_INFO("DATALOG: Session %u started", g_datalog.session);
+}
+
+void DATALOG_stop(void)
+{
+    if (g_datalog.state != DATALOG_STATE_RUNNING) {
+        return;
+    }
+    release_dmm();
+    g_datalog.state = DATALOG_STATE_FLUSHING;
+}
+
+void DATALOG_task(void)
+{
+    switch (g_datalog.state) {
+    case DATALOG_STATE_DETECTING:
+        finish_detect();
+        break;
+    case DATALOG_STATE_RUNNING:
+    case DATALOG_STATE_FLUSHING:
+        sample();
+        advance_flash();
+        break;
+    default:
+        break;
+    }
+}
+
+void DATALOG_get_status(DATALOG_Status *status)
+{
+    if (!status) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    *status = (DATALOG_Status){
+        .state = g_datalog.state,
+        .capacity = g_datalog.capacity,
+        .session = g_datalog.session,
+        .records = g_datalog.records,
+        .dropped = g_datalog.dropped,
+        .size = g_datalog.address,
+    };
+}
+
+void DATALOG_read(uint32_t address, uint8_t *data, uint32_t size)
+{
+    if (g_datalog.state != DATALOG_STATE_READY &&
+        g_datalog.state != DATALOG_STATE_FULL) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+    if (!data || size == 0 || size > SPI_TRANSFER_MAX ||
+        address >= g_datalog.capacity ||
+        size > g_datalog.capacity - address) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_datalog.read_data.status == SPI_STATUS_PENDING) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    if (!submit_read(address, data, size)) {
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+}
+
+SPI_Status DATALOG_read_status(void) { return g_datalog.read_data.status; }
@@ -0,0 +1,196 @@
+/**
+ * @file datalog.h
+ * @brief Unattended data logger on external SPI flash
+ *
+ * The logger takes a DMM scan at a fixed interval and records it on a
+ * JEDEC serial NOR flash on SPI bus 0, so that a measurement can run for
+ * days without a host and the log be read back afterwards, also after a
+ * power cycle.
+ *
+ * Records are packed into page buffers in RAM, and a whole page is
+ * programmed at once when it fills, erasing each 4 KiB sector just before
+ * its first page. Two page buffers let sampling go on while one is being
+ * programmed; a record that finds both full is dropped and counted.
+ *
+ * Log format, all fields little-endian:
+ *
+ * Each page of DATALOG_PAGE_SIZE bytes starts with a header
+ *
+ *     uint16_t magic;    DATALOG_PAGE_MAGIC
+ *     uint16_t session;  Incremented by each DATALOG_start
+ *     uint32_t index;    Page number within the session, from 0
+ *
+ * followed by records, each
+ *
+ *     uint8_t kind;      DATALOG_RECORD_DMM_SCAN
+ *     uint8_t count;     Values that follow
+ *     uint32_t tick;     Milliseconds since boot when it was taken
+ *     int32_t value[count];  Q16.16 volts, in scan order
+ *
+ * A kind of 0xFF ends the records of a page; the rest of it is erased.
+ * The log of a session is its run of pages from address 0 with the magic
+ * and session of the first one.
+ *
+ * Basic usage:
+ * @code
+ * DATALOG_init();
+ * // DATALOG_task runs from the main loop
+ * DATALOG_start(&(DATALOG_Config){
+ *     .interval = 1000,
+ *     .dmm = DMM_CONFIG_DEFAULT,
+ * });
+ * // Days later
+ * DATALOG_stop();
+ * // Once DATALOG_get_status reports DATALOG_STATE_READY
+ * DATALOG_read(0, page, sizeof(page));
+ * @endcode
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_DATALOG_H
+#define PSLAB_DATALOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bus/spi.h"
+#include "instrument/dmm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    /** @brief Bytes programmed at once, the flash page size */
+    DATALOG_PAGE_SIZE = 256,
+    /** @brief Bytes erased at once, the flash sector size */
+    DATALOG_SECTOR_SIZE = 4096,
+    /** @brief First two bytes of each page of a log */
+    DATALOG_PAGE_MAGIC = 0x4C44,
+    /** @brief Record kind of a DMM scan */
+    DATALOG_RECORD_DMM_SCAN = 1,
+    /** @brief Shortest interval between records, in ms */
+    DATALOG_INTERVAL_MIN = 10,
+    /** @brief Largest flash used, the reach of 3-byte addresses */
+    DATALOG_CAPACITY_MAX = 1 << 24,
+};
+
+/**
+ * @brief Logger states
+ */
+typedef enum {
+    DATALOG_STATE_OFF = 0, // Not initialized
+    DATALOG_STATE_DETECTING, // Identifying the flash
+    DATALOG_STATE_READY, // Idle, the log can be read
+    DATALOG_STATE_RUNNING, // Recording
+    DATALOG_STATE_FLUSHING, // Stopped, programming the last pages
+    DATALOG_STATE_FULL, // Stopped at the end of the flash
+    DATALOG_STATE_ERROR, // No flash found, or it failed
+} DATALOG_State;
+
+/**
+ * @brief Recording settings
+ */
+typedef struct {
+    uint32_t interval; // ms between records, at least DATALOG_INTERVAL_MIN
+    DMM_Config dmm; // Channels to scan; bursts are refused
+} DATALOG_Config;
+
+/**
+ * @brief Logger status
+ */
+typedef struct {
+    DATALOG_State state;
+    uint32_t capacity; // Bytes of flash used for the log
+    uint16_t session; // Session of the last log started or found
+    uint32_t records; // Records taken since the start
+    uint32_t dropped; // Records lost as the flash fell behind
+    uint32_t size; // Bytes of the log programmed, whole pages
+} DATALOG_Status;
+
+/**
+ * @brief Take the SPI bus and identify the flash
+ *
+ * Returns at once; DATALOG_task finishes the identification, and the
+ * state becomes DATALOG_STATE_READY, or DATALOG_STATE_ERROR if no flash
+ * answers.
+ *
+ * @throws ERROR_RESOURCE_BUSY if the logger or the SPI bus is in use
+ * @throws ERROR_HARDWARE_FAULT if the SPI bus cannot be configured
+ */
+void DATALOG_init(void);
+
+/**
+ * @brief Stop recording and release the DMM and the SPI bus
+ *
+ * Records not yet programmed are lost.
+ */
+void DATALOG_deinit(void);
+
+/**
+ * @brief Start a new log at the start of the flash
+ *
+ * @param config Recording settings
+ *
+ * @throws ERROR_INVALID_ARGUMENT if config is invalid
+ * @throws ERROR_DEVICE_NOT_READY if the state is not DATALOG_STATE_READY
+ *         or DATALOG_STATE_FULL
+ * @throws ERROR_RESOURCE_BUSY if the DMM or its ADC is in use
+ */
+void DATALOG_start(DATALOG_Config const *config);
+
+/**
+ * @brief Stop recording
+ *
+ * The DMM is released at once; the state is DATALOG_STATE_FLUSHING until
+ * the records taken so far are programmed, then DATALOG_STATE_READY.
+ */
+void DATALOG_stop(void);
+
+/**
+ * @brief Advance sampling and the flash operations
+ *
+ * Called from the main loop, about every millisecond. Returns at once when
+ * the logger is not initialized.
+ */
+void DATALOG_task(void);
+
+/**
+ * @brief Get the logger status
+ *
+ * @param[out] status Current status
+ *
+ * @throws ERROR_INVALID_ARGUMENT if status is null
+ */
+void DATALOG_get_status(DATALOG_Status *status);
+
+/**
+ * @brief Start reading the flash
+ *
+ * Returns at once; DATALOG_read_status reports the outcome.
+ *
+ * @param address First byte to read
+ * @param data Buffer, left alone until the read completes
+ * @param size Bytes to read, 1 to SPI_TRANSFER_MAX
+ *
+ * @throws ERROR_INVALID_ARGUMENT if the bytes are not all within capacity
+ * @throws ERROR_DEVICE_NOT_READY if the state is not DATALOG_STATE_READY
+ *         or DATALOG_STATE_FULL
+ * @throws ERROR_RESOURCE_BUSY if a read is in progress
+ */
+void DATALOG_read(uint32_t address, uint8_t *data, uint32_t size);
+
+/**
+ * @brief Get the outcome of the last read
+ *
+ * @return SPI_STATUS_PENDING until the read completes, then its status
+ */
+SPI_Status DATALOG_read_status(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PSLAB_DATALOG_H */
@@ -0,0 +1,79 @@
+/**
+ * @file heap.c
+ * @brief Heap growth for newlib, with usage tracking
+ *
+ * Replaces the _sbrk from libnosys, which grows the heap until it meets the
+ * stack pointer. This one stops at the stack reserve set by the linker
+ * script (_Min_Stack_Size below the main stack), so that a heap overrun
+ * fails the allocation instead of corrupting the stack, and records how far
+ * the heap has grown.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <errno.h>
+#include <malloc.h>
+#include <reent.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "system.h"
+
+// Linker script symbols; only their addresses are meaningful
+extern uint8_t _end[];
+extern uint8_t _sirq_stack[];
+extern uint8_t _Min_Stack_Size[];
+
+// Current end of the heap, nullptr until the first allocation
+static uint8_t *g_heap_break = nullptr;
+// Furthest end of the heap so far
+static uint8_t *g_heap_peak = nullptr;
+
+static uint8_t *heap_limit(void)
+{
+    return _sirq_stack - (uintptr_t)_Min_Stack_Size;
+}
+
+/**
+ * @brief Grow or shrink the heap, for malloc
+ *
+ * @param r Reentrancy structure, receives the error number
+ * @param increment Bytes to add to the heap, or to remove if negative
+ * @return Previous end of the heap, or (void *)-1 with ENOMEM if the heap
+ *         would reach into the stack reserve
+ */
+void *_sbrk_r(struct _reent *r, ptrdiff_t increment)
+{
+    if (!g_heap_break) {
+        g_heap_break = _end;
+        g_heap_peak = _end;
+    }
+
+    uint8_t *const previous = g_heap_break;
+
+    if (increment > heap_limit() - previous || increment < _end - previous) {
+        r->_errno = ENOMEM;
+        return (void *)-1;
+    }
+
+    g_heap_break += increment;
+    if (g_heap_break > g_heap_peak) {
+        g_heap_peak = g_heap_break;
+    }
+    return previous;
+}
+
+SYSTEM_HeapStats SYSTEM_get_heap_stats(void)
+{
+    uint8_t *const brk = g_heap_break ? g_heap_break : _end;
+    uint8_t *const peak = g_heap_peak ? g_heap_peak : _end;
+    struct mallinfo const info = mallinfo();
+
+    return (SYSTEM_HeapStats){
+        .size = (uint32_t)(heap_limit() - _end),
+        .used = (uint32_t)info.uordblks,
+        .peak = (uint32_t)(peak - _end),
+        .headroom = (uint32_t)(heap_limit() - brk),
+    };
+}
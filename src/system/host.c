@@ -0,0 +1,169 @@
+/**
+ * @file host.c
+ * @brief System calls and memory statistics of the native platform
+ *
+ * Replaces syscalls.c, heap.c, stack.c and stubs.c, which serve newlib on
+ * the target. On a Linux host the C library has its own system calls:
+ * stdout and stderr are those of the process, and the log UART only has
+ * to be flushed. The heap and the stack are the process's, so their
+ * statistics come from the C library and the kernel.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <malloc.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/resource.h>
+
+#include "util/error.h"
+
+#include "syscalls.h"
+#include "system.h"
+#include "system/bus/uart.h"
+
+// Log UART, flushed before a reset
+static UART_Handle *g_uart_handle = nullptr;
+
+// Furthest the heap has grown, as seen by SYSTEM_get_heap_stats
+static uint32_t g_heap_peak = 0;
+
+/**
+ * @brief Clamp a host size to the 32 bits of the statistics
+ */
+static uint32_t clamp_size(uint64_t size)
+{
+    return size > UINT32_MAX ? UINT32_MAX : (uint32_t)size;
+}
+
+/**
+ * @brief Initialize syscalls with a UART handle
+ *
+ * @param handle Pointer to an initialized UART handle
+ * @throws ERROR_RESOURCE_BUSY if syscalls is already initialized
+ */
+void syscalls_init(UART_Handle *handle)
+{
+    if (g_uart_handle != nullptr) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+    g_uart_handle = handle;
+}
+
+/**
+ * @brief Deinitialize syscalls
+ *
+ * @param handle Pointer to the UART handle that was used to initialize syscalls
+ * @throws ERROR_INVALID_ARGUMENT if handle doesn't match the initialized handle
+ */
+void syscalls_deinit(UART_Handle *handle)
+{
+    if (g_uart_handle != handle) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    g_uart_handle = nullptr;
+}
+
+void syscalls_set_buffering(SYSCALLS_Buffering mode)
+{
+    int vbuf_mode = _IONBF;
+    switch (mode) {
+    case SYSCALLS_BUFFER_NONE:
+        vbuf_mode = _IONBF;
+        break;
+    case SYSCALLS_BUFFER_LINE:
+        vbuf_mode = _IOLBF;
+        break;
+    case SYSCALLS_BUFFER_FULL:
+        vbuf_mode = _IOFBF;
+        break;
+    default:
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    // The C library allocates the buffer
+    (void)fflush(stdout);
+    (void)setvbuf(stdout, nullptr, vbuf_mode, BUFSIZ);
+}
+
+void syscalls_set_overflow(SYSCALLS_Overflow policy)
+{
+    // stdout is the process's, which never drops output
+    if (policy != SYSCALLS_OVERFLOW_KEEP && policy != SYSCALLS_OVERFLOW_DROP) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+uint32_t syscalls_get_dropped(void) { return 0; }
+
+void syscalls_task(void) { (void)fflush(stdout); }
+
+bool syscalls_uart_flush(uint32_t timeout)
+{
+    (void)fflush(stdout);
+    if (g_uart_handle == nullptr) {
+        return false;
+    }
+    return UART_flush(g_uart_handle, timeout);
+}
+
+SYSTEM_HeapStats SYSTEM_get_heap_stats(void)
+{
+    // The main arena, which grows as the target's heap does; large blocks
+    // are mapped on their own and count as used only
+    struct mallinfo2 const info = mallinfo2();
+    uint32_t const size = clamp_size(info.arena);
+
+    if (size > g_heap_peak) {
+        g_heap_peak = size;
+    }
+    return (SYSTEM_HeapStats){
+        .size = size,
+        .used = clamp_size(info.uordblks + info.hblkhd),
+        .peak = g_heap_peak,
+        .headroom = clamp_size(info.fordblks),
+    };
+}
+
+/**
+ * @brief Size the kernel has grown the stack mapping to
+ *
+ * The mapping never shrinks, so this is the deepest use of the stack,
+ * rounded up to pages.
+ */
+static uint32_t stack_mapping_size(void)
+{
+    FILE *const status = fopen("/proc/self/status", "r");
+    if (status == nullptr) {
+        return 0;
+    }
+
+    char line[128];
+    unsigned long kib = 0;
+    while (fgets(line, sizeof(line), status) != nullptr) {
+        if (sscanf(line, "VmStk: %lu kB", &kib) == 1) {
+            break;
+        }
+    }
+    fclose(status);
+    return clamp_size((uint64_t)kib * 1024);
+}
+
+SYSTEM_StackStats SYSTEM_get_stack_stats(void)
+{
+    struct rlimit limit = { 0 };
+    uint32_t size = UINT32_MAX;
+
+    if (getrlimit(RLIMIT_STACK, &limit) == 0 &&
+        limit.rlim_cur != RLIM_INFINITY) {
+        size = clamp_size(limit.rlim_cur);
+    }
+
+    // Emulated interrupts run on the main stack, so the interrupt stack is
+    // empty
+    return (SYSTEM_StackStats){
+        .main = { .size = size, .peak = stack_mapping_size() },
+        .interrupt = { .size = 0, .peak = 0 },
+    };
+}
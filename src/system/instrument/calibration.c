@@ -0,0 +1,204 @@
+/**
+ * @file calibration.c
+ * @brief Per-channel gain and offset calibration for PSLab instruments
+ *
+ * The table is stored at the start of the persistent storage sector as a
+ * small image with a magic number, a format version and a CRC-32, so that
+ * an erased sector, a torn write or a table from an incompatible firmware
+ * is rejected instead of being applied.
+ *
+ * @author PSLab Team
+ * @date 2025-09-02
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform/flash_ll.h"
+#include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/logging.h"
+
+#include "calibration.h"
+
+enum {
+    CALIBRATION_MAGIC = 0x4C414350, // "PCAL"
+    CALIBRATION_VERSION = 1,
+    CALIBRATION_ENTRY_COUNT =
+        CALIBRATION_MODE_COUNT * CALIBRATION_CHANNEL_COUNT,
+};
+
+/**
+ * @brief Layout of the table in the storage sector
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_count;
+    CALIBRATION_Entry entries[CALIBRATION_MODE_COUNT]
+                             [CALIBRATION_CHANNEL_COUNT];
+    uint32_t crc; // CRC-32 of all preceding fields
+} CalibrationImage;
+
+enum {
+    // Image size rounded up to whole flash programming units
+    CALIBRATION_IMAGE_SIZE =
+        (sizeof(CalibrationImage) + FLASH_LL_WRITE_ALIGN - 1) /
+        FLASH_LL_WRITE_ALIGN * FLASH_LL_WRITE_ALIGN,
+};
+
+static_assert(
+    (uint32_t)CALIBRATION_IMAGE_SIZE <= (uint32_t)FLASH_LL_STORAGE_SIZE,
+    "Calibration table must fit in the storage sector"
+);
+
+// Table in use, identity until a stored table has been loaded
+static CALIBRATION_Entry g_calibration[CALIBRATION_MODE_COUNT]
+                                      [CALIBRATION_CHANNEL_COUNT];
+static bool g_calibration_valid = false;
+
+/**
+ * @brief CRC-32 (IEEE 802.3) of a buffer
+ *
+ * Bitwise, as the table is only checked at boot and when saved.
+ */
+static uint32_t crc32(uint8_t const *data, uint32_t size)
+{
+    uint32_t crc = UINT32_MAX;
+
+    for (uint32_t i = 0; i < size; ++i) {
+        crc ^= data[i];
+        for (uint32_t bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1U) ? 0xEDB88320U : 0U);
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Check that an entry is within the accepted correction range
+ */
+static bool entry_is_valid(CALIBRATION_Entry const *entry)
+{
+    return entry->gain > 0 && entry->gain <= CALIBRATION_GAIN_MAX &&
+           entry->offset >= -CALIBRATION_OFFSET_MAX &&
+           entry->offset <= CALIBRATION_OFFSET_MAX;
+}
+
+/**
+ * @brief CRC over the image fields that it protects
+ */
+static uint32_t image_crc(CalibrationImage const *image)
+{
+    return crc32(
+        (uint8_t const *)image, (uint32_t)offsetof(CalibrationImage, crc)
+    );
+}
+
+/**
+ * @brief Check the header, CRC and entries of a stored image
+ */
+static bool image_is_valid(CalibrationImage const *image)
+{
+    if (image->magic != CALIBRATION_MAGIC ||
+        image->version != CALIBRATION_VERSION ||
+        image->entry_count != CALIBRATION_ENTRY_COUNT ||
+        image->crc != image_crc(image)) {
+        return false;
+    }
+
+    for (uint32_t mode = 0; mode < CALIBRATION_MODE_COUNT; ++mode) {
+        for (uint32_t ch = 0; ch < CALIBRATION_CHANNEL_COUNT; ++ch) {
+            if (!entry_is_valid(&image->entries[mode][ch])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool CALIBRATION_load(void)
+{
+    CalibrationImage image;
+
+    FLASH_LL_read(0, &image, sizeof(image));
+
+    if (!image_is_valid(&image)) {
+        LOG_INFO("CAL: No stored calibration, using identity");
+        CALIBRATION_clear();
+        return false;
+    }
+
+    memcpy(g_calibration, image.entries, sizeof(g_calibration));
+    g_calibration_valid = true;
+    LOG_INFO("CAL: Loaded calibration table");
+    return true;
+}
+
+void CALIBRATION_save(void)
+{
+    // Padding is written as erased flash
+    union {
+        CalibrationImage image;
+        uint8_t bytes[CALIBRATION_IMAGE_SIZE];
+    } buffer;
+
+    if (!g_calibration_valid) {
+        CALIBRATION_clear();
+    }
+
+    memset(buffer.bytes, 0xFF, sizeof(buffer.bytes));
+    buffer.image.magic = CALIBRATION_MAGIC;
+    buffer.image.version = CALIBRATION_VERSION;
+    buffer.image.entry_count = CALIBRATION_ENTRY_COUNT;
+    memcpy(buffer.image.entries, g_calibration, sizeof(g_calibration));
+    buffer.image.crc = image_crc(&buffer.image);
+
+    FLASH_LL_erase();
+    FLASH_LL_write(0, buffer.bytes, sizeof(buffer.bytes));
+    LOG_INFO("CAL: Saved calibration table");
+}
+
+void CALIBRATION_clear(void)
+{
+    for (uint32_t mode = 0; mode < CALIBRATION_MODE_COUNT; ++mode) {
+        for (uint32_t ch = 0; ch < CALIBRATION_CHANNEL_COUNT; ++ch) {
+            g_calibration[mode][ch] =
+                (CALIBRATION_Entry)CALIBRATION_ENTRY_IDENTITY;
+        }
+    }
+    g_calibration_valid = true;
+}
+
+CALIBRATION_Entry CALIBRATION_get(CALIBRATION_Mode mode, uint32_t channel)
+{
+    if ((uint32_t)mode >= CALIBRATION_MODE_COUNT ||
+        channel >= CALIBRATION_CHANNEL_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!g_calibration_valid) {
+        return (CALIBRATION_Entry)CALIBRATION_ENTRY_IDENTITY;
+    }
+    return g_calibration[mode][channel];
+}
+
+void CALIBRATION_set(
+    CALIBRATION_Mode mode,
+    uint32_t channel,
+    CALIBRATION_Entry const *entry
+)
+{
+    if (!entry || (uint32_t)mode >= CALIBRATION_MODE_COUNT ||
+        channel >= CALIBRATION_CHANNEL_COUNT || !entry_is_valid(entry)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!g_calibration_valid) {
+        CALIBRATION_clear();
+    }
+    g_calibration[mode][channel] = *entry;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file calibration.h
+ * @brief Per-channel gain and offset calibration for PSLab instruments
+ *
+ * The calibration table holds a gain and an offset for each ADC channel and
+ * measurement mode. It lives in RAM and is loaded at boot from the
+ * persistent storage sector, falling back to the identity correction when
+ * the sector holds no valid table. Changes take effect immediately and are
+ * kept across power cycles once saved.
+ *
+ * A corrected value is value * gain + offset, in the unit of the mode.
+ *
+ * @author PSLab Team
+ * @date 2025-09-02
+ */
+
+#ifndef PSLAB_CALIBRATION_H
+#define PSLAB_CALIBRATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Measurement modes with separate calibration
+ */
+typedef enum {
+    CALIBRATION_MODE_DMM = 0, // DMM DC voltage, offsets in volts
+    CALIBRATION_MODE_COUNT = 1
+} CALIBRATION_Mode;
+
+enum {
+    CALIBRATION_CHANNEL_COUNT = 16, // One entry per ADC channel
+    CALIBRATION_GAIN_MAX = FIXED_FROM_INT(2), // Largest accepted gain
+    CALIBRATION_OFFSET_MAX = FIXED_ONE, // Largest accepted offset magnitude
+};
+
+/**
+ * @brief Correction for one channel in one mode
+ */
+typedef struct {
+    FIXED_Q1616 gain; // Multiplier, FIXED_ONE for no correction
+    FIXED_Q1616 offset; // Added after the gain, in the unit of the mode
+} CALIBRATION_Entry;
+
+/**
+ * @brief Entry that leaves values unchanged
+ */
+#define CALIBRATION_ENTRY_IDENTITY                                             \
+    {                                                                          \
+        .gain = FIXED_ONE, .offset = 0,                                        \
+    }
+
+/**
+ * @brief Load the calibration table from persistent storage
+ *
+ * Called once at boot. If the storage sector is erased or holds a corrupt
+ * or incompatible table, every entry is reset to the identity.
+ *
+ * @return true if a stored table was loaded
+ */
+bool CALIBRATION_load(void);
+
+/**
+ * @brief Write the calibration table to persistent storage
+ *
+ * Erases the storage sector first, so it blocks for several milliseconds.
+ *
+ * @throws ERROR_HARDWARE_FAULT if the flash cannot be erased or programmed
+ */
+void CALIBRATION_save(void);
+
+/**
+ * @brief Reset every entry to the identity, without saving
+ */
+void CALIBRATION_clear(void);
+
+/**
+ * @brief Get the correction for a channel
+ *
+ * @param mode Measurement mode
+ * @param channel ADC channel number
+ * @return Correction to apply to values from the channel
+ *
+ * @throws ERROR_INVALID_ARGUMENT if mode or channel is out of range
+ */
+CALIBRATION_Entry CALIBRATION_get(CALIBRATION_Mode mode, uint32_t channel);
+
+/**
+ * @brief Set the correction for a channel, without saving
+ *
+ * @param mode Measurement mode
+ * @param channel ADC channel number
+ * @param entry New correction
+ *
+ * @throws ERROR_INVALID_ARGUMENT if entry is NULL, mode or channel is out of
+ *         range, the gain is not in (0, CALIBRATION_GAIN_MAX] or the offset
+ *         is larger than CALIBRATION_OFFSET_MAX
+ */
+void CALIBRATION_set(
+    CALIBRATION_Mode mode,
+    uint32_t channel,
+    CALIBRATION_Entry const *entry
+);
+
+/**
+ * @brief Apply a correction to a value
+ *
+ * @param entry Correction from CALIBRATION_get
+ * @param value Uncorrected value
+ * @return value * gain + offset, saturated
+ */
+static inline FIXED_Q1616 CALIBRATION_apply(
+    CALIBRATION_Entry const *entry,
+    FIXED_Q1616 value
+)
+{
+    return FIXED_add(FIXED_mul(value, entry->gain), entry->offset);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_CALIBRATION_H
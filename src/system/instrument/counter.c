@@ -0,0 +1,256 @@
+/**
+ * @file counter.c
+ * @brief Reciprocal frequency counter implementation for PSLab firmware
+ *
+ * A measurement starts capturing with COUNTER_LL_start and ends once the
+ * timer has counted a gate time. The span from the first to the last
+ * timestamp then holds (captures - 1) * prescaler periods of the input.
+ * The timer is clocked from the bus, so the full clock is held for as long
+ * as a measurement runs.
+ *
+ * Quotients are taken by long division, digit by digit, so that neither
+ * microhertz nor picoseconds overflow 64 bits.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform/counter_ll.h"
+#include "util/error.h"
+#include "util/logging.h"
+#include "util/si_prefix.h"
+
+#include "clock.h"
+#include "counter.h"
+
+enum {
+    MICRO_DIGITS = 6, // Decimals of a frequency in microhertz
+    PICO_DIGITS = 12, // Decimals of a period in picoseconds
+};
+
+/**
+ * @brief Counter handle structure
+ */
+struct COUNTER_Handle {
+    COUNTER_Config config;
+    uint32_t prescaler; // Edges per capture
+    uint32_t clock; // Timer clock of the measurement in Hz
+    uint32_t start_time; // Timestamp the gate opened at
+    bool running;
+};
+
+// Storage for the only counter instance
+static COUNTER_Handle g_counter_storage;
+
+// Static instance for handle checks
+static COUNTER_Handle *g_counter_handle = nullptr;
+
+static void check_handle(COUNTER_Handle const *handle)
+{
+    if (handle == nullptr || handle != g_counter_handle) {
+        LOG_ERROR("COUNTER: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+/**
+ * @brief Rounded num * 10^digits / den, for den below 2^63 / 10
+ */
+static uint64_t divide_scaled(uint64_t num, uint64_t den, uint32_t digits)
+{
+    uint64_t quotient = num / den;
+    uint64_t remainder = num % den;
+
+    for (uint32_t i = 0; i < digits; ++i) {
+        remainder *= 10;
+        quotient = quotient * 10 + remainder / den;
+        remainder %= den;
+    }
+    return remainder >= den - remainder ? quotient + 1 : quotient;
+}
+
+/**
+ * @brief Smallest prescaler whose captures the DMA sustains at a frequency
+ */
+static uint32_t prescaler_for(uint64_t microhertz)
+{
+    uint32_t prescaler = 1;
+
+    while (prescaler < COUNTER_LL_PRESCALER_MAX &&
+           microhertz > (uint64_t)prescaler * COUNTER_LL_CAPTURE_RATE_MAX *
+                            SI_MICRO_DIV) {
+        prescaler *= 2;
+    }
+    return prescaler;
+}
+
+static void set_prescaler(COUNTER_Handle *handle, uint32_t prescaler)
+{
+    if (prescaler == handle->prescaler) {
+        return;
+    }
+    COUNTER_LL_deinit();
+    handle->prescaler = 0; // None, should the init fail
+    COUNTER_LL_init(prescaler);
+    handle->prescaler = prescaler;
+}
+
+/**
+ * @brief Open the gate, under the clock request of the measurement
+ */
+static void open_gate(COUNTER_Handle *handle)
+{
+    handle->clock = COUNTER_LL_get_clock();
+    handle->start_time = COUNTER_LL_get_time();
+    COUNTER_LL_start();
+}
+
+/**
+ * @brief End the measurement and drop its clock request
+ */
+static void finish(COUNTER_Handle *handle)
+{
+    COUNTER_LL_stop();
+    if (handle->running) {
+        handle->running = false;
+        CLOCK_release();
+    }
+}
+
+static void compute_result(
+    COUNTER_Handle const *handle,
+    COUNTER_LL_Span const *span,
+    COUNTER_Result *result
+)
+{
+    *result = (COUNTER_Result){ .clock = handle->clock };
+    if (span->captures < 2 || span->last == span->first) {
+        return;
+    }
+
+    result->edges = (span->captures - 1) * handle->prescaler;
+    result->ticks = span->last - span->first;
+
+    uint64_t const cycles = (uint64_t)result->edges * handle->clock;
+    result->frequency = divide_scaled(cycles, result->ticks, MICRO_DIGITS);
+    result->period = divide_scaled(result->ticks, cycles, PICO_DIGITS);
+}
+
+COUNTER_Handle *COUNTER_init(COUNTER_Config const *config)
+{
+    if (!config || config->gate_time < COUNTER_GATE_TIME_MIN ||
+        config->gate_time > COUNTER_GATE_TIME_MAX) {
+        LOG_ERROR("COUNTER: Invalid configuration");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_counter_handle != nullptr) {
+        LOG_ERROR("COUNTER: Already initialized");
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    COUNTER_Handle *const handle = &g_counter_storage;
+
+    COUNTER_LL_init(1);
+    handle->config = *config;
+    handle->prescaler = 1;
+    handle->clock = 0;
+    handle->start_time = 0;
+    handle->running = false;
+
+    g_counter_handle = handle;
+    LOG_INFO("COUNTER: Init with a %u ms gate", config->gate_time);
+    return handle;
+}
+
+void COUNTER_deinit(COUNTER_Handle *handle)
+{
+    if (handle == nullptr) {
+        return;
+    }
+    check_handle(handle);
+
+    Error error = ERROR_NONE;
+    TRY
+    {
+        finish(handle);
+        COUNTER_LL_deinit();
+    }
+    CATCH(error)
+    {
+        LOG_ERROR("COUNTER: Deinitialization failed, error %d", error);
+        // Don't throw, continue with handle cleanup
+    }
+
+    g_counter_handle = nullptr;
+}
+
+void COUNTER_start(COUNTER_Handle *handle)
+{
+    check_handle(handle);
+
+    if (!handle->running) {
+        CLOCK_request();
+        handle->running = true;
+    }
+
+    Error error = ERROR_NONE;
+    TRY { open_gate(handle); }
+    CATCH(error)
+    {
+        LOG_ERROR("COUNTER: Failed to start, error %d", error);
+        finish(handle);
+        THROW(error);
+    }
+}
+
+bool COUNTER_read(COUNTER_Handle *handle, COUNTER_Result *result)
+{
+    check_handle(handle);
+    if (result == nullptr) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (!handle->running) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    uint32_t const gate_ticks =
+        (uint32_t)((uint64_t)handle->clock * handle->config.gate_time /
+                   SI_MILLI_DIV);
+    if (COUNTER_LL_get_time() - handle->start_time < gate_ticks) {
+        return false;
+    }
+
+    COUNTER_LL_Span span = { 0 };
+    COUNTER_LL_stop();
+    COUNTER_LL_get_span(&span);
+
+    if (span.overrun) {
+        if (handle->prescaler == COUNTER_LL_PRESCALER_MAX) {
+            finish(handle);
+            LOG_ERROR("COUNTER: Edges lost at every eighth");
+            THROW(ERROR_RESOURCE_UNAVAILABLE);
+        }
+        Error error = ERROR_NONE;
+        TRY
+        {
+            set_prescaler(handle, COUNTER_LL_PRESCALER_MAX);
+            open_gate(handle);
+        }
+        CATCH(error)
+        {
+            finish(handle);
+            THROW(error);
+        }
+        return false;
+    }
+
+    compute_result(handle, &span, result);
+    finish(handle);
+
+    // Capture as many edges as the DMA keeps up with next time
+    set_prescaler(handle, prescaler_for(result->frequency));
+    return true;
+}
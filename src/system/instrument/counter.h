@@ -0,0 +1,128 @@
+/**
+ * @file counter.h
+ * @brief Reciprocal frequency counter interface for PSLab firmware
+ *
+ * This header provides a frequency and period counter on a digital input,
+ * using the COUNTER_LL API. Rather than counting edges over a fixed gate,
+ * which resolves a frequency only to 1 / gate, the counter timestamps the
+ * edges with the timer clock and divides the edges between the first and
+ * the last of the gate by the time between them. The relative resolution is
+ * one clock period over the gate, whatever the input frequency, e.g. 4e-8
+ * with a 100 ms gate at 250 MHz.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_COUNTER_H
+#define PSLAB_COUNTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Counter handle structure (opaque)
+ */
+typedef struct COUNTER_Handle COUNTER_Handle;
+
+enum {
+    /** @brief Shortest gate time in ms */
+    COUNTER_GATE_TIME_MIN = 1,
+    /** @brief Longest gate time in ms, within a wrap of the timestamps */
+    COUNTER_GATE_TIME_MAX = 10000,
+    /** @brief Highest input frequency in Hz */
+    COUNTER_FREQUENCY_MAX = 16000000,
+};
+
+/**
+ * @brief Counter configuration structure
+ */
+typedef struct {
+    uint32_t gate_time; /**< Time each measurement spans, in ms */
+} COUNTER_Config;
+
+/**
+ * @brief Default counter configuration: a 100 ms gate
+ */
+#define COUNTER_CONFIG_DEFAULT                                                 \
+    {                                                                          \
+        .gate_time = 100,                                                      \
+    }
+
+/**
+ * @brief Result of a measurement
+ *
+ * Without two captured edges in the gate, e.g. below a few edges per gate
+ * or without a signal, the frequency and the period are 0.
+ */
+typedef struct {
+    uint64_t frequency; /**< Frequency in microhertz */
+    uint64_t period; /**< Period in picoseconds */
+    uint32_t edges; /**< Rising edges spanned, a whole number of periods */
+    uint32_t ticks; /**< Timer clock periods they span */
+    uint32_t clock; /**< Timer clock in Hz */
+} COUNTER_Result;
+
+/**
+ * @brief Initialize the frequency counter
+ *
+ * @param config Pointer to counter configuration structure
+ * @return Pointer to counter handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if config is NULL or the gate time is out
+ *         of range
+ * @throws ERROR_RESOURCE_BUSY if the counter is already initialized
+ * @throws ERROR_HARDWARE_FAULT if the timer or the DMA cannot be configured
+ */
+COUNTER_Handle *COUNTER_init(COUNTER_Config const *config);
+
+/**
+ * @brief Deinitialize the frequency counter
+ *
+ * Stops a measurement and releases the input. The handle becomes invalid.
+ *
+ * @param handle Pointer to counter handle, or NULL to do nothing
+ */
+void COUNTER_deinit(COUNTER_Handle *handle);
+
+/**
+ * @brief Start a measurement over one gate time
+ *
+ * Restarts a measurement in progress.
+ *
+ * @param handle Pointer to counter handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ * @throws ERROR_HARDWARE_FAULT if the DMA cannot be started
+ */
+void COUNTER_start(COUNTER_Handle *handle);
+
+/**
+ * @brief Read the measurement once its gate time has passed
+ *
+ * Edges can come faster than the DMA moves their timestamps. The counter
+ * then captures every second, fourth or eighth edge and measures again,
+ * and keeps the rate for the following measurements; this read then
+ * returns false for one more gate time.
+ *
+ * @param handle Pointer to counter handle
+ * @param result Filled with the measurement when ready
+ * @return true if the measurement is done, false while it runs
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or result is NULL, or handle is
+ *         invalid
+ * @throws ERROR_DEVICE_NOT_READY if no measurement was started
+ * @throws ERROR_RESOURCE_UNAVAILABLE if edges are lost at every eighth
+ * @throws ERROR_HARDWARE_FAULT if the DMA cannot be restarted
+ */
+bool COUNTER_read(COUNTER_Handle *handle, COUNTER_Result *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_COUNTER_H
@@ -6,33 +6,106 @@
  * in single sample mode. It provides voltage measurement functionality with
  * proper error handling and logging.
  *
+ * If another instrument already owns the ADC, e.g. the oscilloscope, the DMM
+ * shares it by measuring through the ADC1 injected group instead of taking
+ * over the regular group and a timer.
+ *
+ * In averaging mode the DMM converts continuously into a circular ring.
+ * Each DMA half-transfer callback summarizes the half of the ring that has
+ * just been filled, and readings merge the two half summaries, so a
+ * reading costs a few arithmetic operations instead of a conversion.
+ * Free-running mode uses the same ring without the summaries, publishing
+ * only the newest sample of each half.
+ *
+ * A differential reading runs ADC1 and ADC2 in simultaneous mode, one leg
+ * each, so that the DMA stores both legs of a trigger side by side.
+ *
+ * A watch compares every conversion of a free-running or averaging DMM
+ * with a window in the ADC analog watchdog, so that the CPU only hears of
+ * the conversions outside of it. Counting moves the window between the two
+ * sides of a level from the watchdog interrupt, once per crossing.
+ *
  * @author PSLab Team
  * @date 2025-07-18
  */
 
+#define LOG_MODULE LOG_MODULE_DMM
+
+#include <assert.h>
 #include <stdbool.h>
 #include <stdint.h>
-#include <stdlib.h>
 
 #include "platform/adc_ll.h"
+#include "platform/platform.h"
 #include "platform/tim_ll.h"
+#include "util/arena.h"
 #include "util/error.h"
 #include "util/fixed_point.h"
 #include "util/logging.h"
+#include "util/ring.h"
 #include "util/si_prefix.h"
+#include "util/stats.h"
 
+#include "calibration.h"
+#include "clock.h"
 #include "dmm.h"
+#include "sync.h"
 
 /**
  * @brief DMM handle structure
  */
 struct DMM_Handle {
     DMM_Config config;
-    uint16_t adc_value; // Single value buffer for single sample mode
+    uint16_t adc_values[DMM_SCAN_CHANNELS_MAX]; // One sample per channel
     bool volatile conversion_complete;
     bool initialized;
+    bool shared; // Measuring via injected conversions on a shared ADC
+    TIM_Num timer; // Claimed timer pacing the conversions (exclusive only)
+    // Volts per code from FIXED_code_scale, cached for scale_reference_mv
+    int32_t volts_per_code;
+    uint32_t scale_reference_mv;
+    // Summaries of the two ring halves, guarded by stats_sequence which is
+    // odd while a callback is updating them
+    STATS_Summary volatile halves[2];
+    uint32_t volatile stats_sequence;
+    // Newest published sample and conversions since init (free running)
+    uint16_t volatile latest;
+    uint32_t volatile conversions;
+    // Window of a watch in 12-bit codes, see DMM_watch_start
+    bool watching;
+    uint16_t watch_low;
+    uint16_t watch_high;
+    bool volatile watch_crossed; // Latched until DMM_watch_event
+    DMM_WatchCallback watch_callback;
+    // Level crossings in 12-bit codes, see DMM_count_start
+    bool counting;
+    bool count_timestamps; // Keep the time of each crossing
+    uint16_t count_level; // A crossing is a conversion above it
+    uint16_t count_rearm; // Armed again by a conversion below it
+    bool volatile count_above; // Crossed, waiting to fall below count_rearm
+    uint32_t volatile count_events;
+    uint32_t count_start_us;
+    RingU32 count_ring; // Crossing times since count_start_us
+    uint32_t count_storage[DMM_COUNT_TIMESTAMPS_MAX + 1];
+    // Circular DMA target (free running only), dmm_ring_size samples used,
+    // or the conversions of a timed burst
+    uint16_t ring[DMM_AVERAGE_WINDOW_MAX];
+};
+
+enum {
+    DMM_CONVERSION_BITS = 12, // Bits of one conversion
+    DMM_CODE_BITS_MAX = 15, // Widest code FIXED_scale_u16_array takes
 };
 
+// A burst is taken into the ring
+static_assert(
+    DMM_BURST_SAMPLES_MAX <= DMM_AVERAGE_WINDOW_MAX,
+    "DMM burst must fit the ring"
+);
+
+// Storage for the only DMM instance, in DMA memory for adc_values and ring
+static DMM_Handle g_dmm_storage ARENA_DMA_MEMORY;
+
 // Static instance for callback context
 static DMM_Handle *g_dmm_handle = nullptr;
 
@@ -81,24 +154,210 @@ static ADC_LL_Channel dmm_channel_to_adc_ll(DMM_Channel channel)
     }
 }
 
+/**
+ * @brief Number of channels converted per measurement
+ */
+static uint32_t dmm_channel_count(DMM_Config const *config)
+{
+    return config->scan_count > 0 ? config->scan_count : 1;
+}
+
+/**
+ * @brief Channel at a position in the scan order
+ */
+static DMM_Channel dmm_scan_channel(DMM_Config const *config, uint32_t index)
+{
+    return config->scan_count > 0 ? config->scan_channels[index]
+                                  : config->channel;
+}
+
+/**
+ * @brief Length of the circular DMA ring, 0 for one conversion per reading
+ */
+static uint32_t dmm_ring_size(DMM_Config const *config)
+{
+    if (config->average_window > 0) {
+        return config->average_window;
+    }
+    return config->free_running ? DMM_FREE_RUNNING_RING : 0;
+}
+
+/**
+ * @brief Samples per power-line cycle of an aperture in cycles
+ *
+ * As many as the window holds for nplc cycles, and as the ADC converts at
+ * its fastest with the oversampling ratio, in whole ring quarters.
+ *
+ * @return Samples per cycle, less than 4 if the aperture cannot be taken
+ */
+static uint32_t dmm_aperture_samples_per_cycle(DMM_Config const *config)
+{
+    uint32_t const max_rate = ADC_LL_get_max_sample_rate(
+        ADC_LL_MODE_SINGLE, ADC_LL_RESOLUTION_12BIT
+    );
+    uint32_t const line_rate =
+        config->line_frequency * config->oversampling_ratio;
+    uint32_t samples = DMM_AVERAGE_WINDOW_MAX / config->nplc;
+
+    if (max_rate / line_rate < samples) {
+        samples = max_rate / line_rate;
+    }
+    return samples & ~3U;
+}
+
+/**
+ * @brief Timer rate of an aperture in power-line cycles, 0 for none
+ */
+static uint32_t dmm_aperture_rate(DMM_Config const *config)
+{
+    if (config->nplc == 0) {
+        return 0;
+    }
+    return config->line_frequency * (config->average_window / config->nplc);
+}
+
+/**
+ * @brief Bits of each code after oversampling
+ *
+ * The sum of ratio conversions carries log2(ratio) bits more than one
+ * conversion. By default they are averaged away; with high_resolution as
+ * many are kept as the conversions to volts take.
+ */
+static uint32_t dmm_code_bits(DMM_Config const *config)
+{
+    uint32_t bits = DMM_CONVERSION_BITS;
+
+    if (config->high_resolution) {
+        for (uint32_t ratio = config->oversampling_ratio;
+             ratio > 1 && bits < DMM_CODE_BITS_MAX;
+             ratio >>= 1) {
+            ++bits;
+        }
+    }
+    return bits;
+}
+
+/**
+ * @brief Right shift of the oversampled sums down to dmm_code_bits
+ */
+static uint32_t dmm_oversampling_shift(DMM_Config const *config)
+{
+    uint32_t sum_bits = DMM_CONVERSION_BITS;
+
+    for (uint32_t ratio = config->oversampling_ratio; ratio > 1; ratio >>= 1) {
+        ++sum_bits;
+    }
+    return sum_bits - dmm_code_bits(config);
+}
+
+/**
+ * @brief Code of a full-scale input after oversampling
+ */
+static uint16_t dmm_max_code(DMM_Config const *config)
+{
+    uint32_t const max_conversion = (1U << DMM_CONVERSION_BITS) - 1;
+    uint32_t const max_sum = max_conversion * config->oversampling_ratio;
+    return (uint16_t)(max_sum >> dmm_oversampling_shift(config));
+}
+
 /**
  * @brief ADC completion callback.
  *
- * Called when an ADC conversion is complete.
+ * Called when an ADC conversion is complete. When free running, it is
+ * called for each half of the ring as it fills instead.
  */
 // NOLINTNEXTLINE(readability-non-const-parameter)
 void dmm_adc_complete_callback(uint16_t *buffer, uint32_t total_samples)
 {
-    (void)buffer;
-    (void)total_samples;
+    DMM_Handle *handle = g_dmm_handle;
+
+    if (handle == nullptr) {
+        return;
+    }
 
+    if (handle->config.average_window > 0 && buffer != nullptr) {
+        uint32_t const half = buffer == handle->ring ? 0 : 1;
+        STATS_Summary summary = STATS_SUMMARY_EMPTY;
+
+        STATS_summarize(buffer, total_samples, &summary);
+        handle->stats_sequence += 1;
+        handle->halves[half] = summary;
+        handle->stats_sequence += 1;
+    }
+    if (dmm_ring_size(&handle->config) > 0 && total_samples > 0) {
+        // Readers detect a torn update by the count changing under them
+        handle->latest = buffer[total_samples - 1];
+        handle->conversions += total_samples;
+    }
+    handle->conversion_complete = true;
+}
+
+/**
+ * @brief ADC injected measurement callback.
+ *
+ * Called when an injected measurement on a shared ADC is complete.
+ */
+void dmm_adc_injected_callback(uint16_t value)
+{
     if (g_dmm_handle != nullptr) {
+        g_dmm_handle->adc_values[0] = value;
         g_dmm_handle->conversion_complete = true;
     }
 }
 
 /**
- * @brief Allocate and initialize DMM handle
+ * @brief Count a crossing, or arm the count again, from the watchdog
+ *
+ * Re-arms the watchdog for the other side of the level.
+ */
+static void dmm_count_crossing(DMM_Handle *handle)
+{
+    if (handle->count_above) {
+        handle->count_above = false;
+        ADC_LL_arm_watchdog(0, handle->count_level);
+        return;
+    }
+
+    handle->count_events = handle->count_events + 1;
+    if (handle->count_timestamps) {
+        // A full ring drops the time, never the count
+        (void)ring_u32_put(
+            &handle->count_ring,
+            PLATFORM_get_time_us() - handle->count_start_us
+        );
+    }
+    handle->count_above = true;
+    ADC_LL_arm_watchdog(handle->count_rearm, (1U << DMM_CONVERSION_BITS) - 1);
+}
+
+/**
+ * @brief ADC analog watchdog callback.
+ *
+ * Called when a conversion falls outside the window of a watch or of a
+ * count. The watchdog has disarmed itself, so the crossing of a watch
+ * stays latched until DMM_watch_event re-arms it.
+ */
+void dmm_adc_watchdog_callback(void)
+{
+    DMM_Handle *handle = g_dmm_handle;
+
+    if (handle != nullptr && handle->counting) {
+        dmm_count_crossing(handle);
+        return;
+    }
+    if (handle == nullptr || !handle->watching) {
+        return;
+    }
+
+    handle->watch_crossed = true;
+    SYNC_signal(SYNC_SOURCE_MULTIMETER);
+    if (handle->watch_callback != nullptr) {
+        handle->watch_callback();
+    }
+}
+
+/**
+ * @brief Initialize the DMM handle in its static storage
  */
 static DMM_Handle *dmm_create_handle(DMM_Config const *config)
 {
@@ -108,44 +367,145 @@ static DMM_Handle *dmm_create_handle(DMM_Config const *config)
         THROW(ERROR_RESOURCE_BUSY);
     }
 
-    // Allocate handle
-    DMM_Handle *handle = (DMM_Handle *)malloc(sizeof(DMM_Handle));
-    if (handle == nullptr) {
-        LOG_ERROR("DMM: Memory allocation failed");
-        THROW(ERROR_OUT_OF_MEMORY);
-    }
-
-    LOG_DEBUG("DMM: Allocated handle at %p", (void *)handle);
+    DMM_Handle *handle = &g_dmm_storage;
 
     // Initialize handle
     handle->config = *config;
-    handle->adc_value = 0;
+    for (uint32_t i = 0; i < DMM_SCAN_CHANNELS_MAX; ++i) {
+        handle->adc_values[i] = 0;
+    }
     handle->conversion_complete = false;
     handle->initialized = true;
+    handle->shared = false;
+    handle->halves[0] = (STATS_Summary)STATS_SUMMARY_EMPTY;
+    handle->halves[1] = (STATS_Summary)STATS_SUMMARY_EMPTY;
+    handle->stats_sequence = 0;
+    handle->latest = 0;
+    handle->conversions = 0;
+    handle->volts_per_code = 0;
+    handle->scale_reference_mv = 0;
+    handle->watching = false;
+    handle->watch_crossed = false;
+    handle->watch_callback = nullptr;
+    handle->counting = false;
+    handle->count_events = 0;
     g_dmm_handle = handle;
 
     LOG_INFO(
-        "DMM: Init channel %d, oversampling %u",
+        "DMM: Init channel %d, oversampling %u, %u-bit codes",
         config->channel,
-        config->oversampling_ratio
+        config->oversampling_ratio,
+        dmm_code_bits(config)
     );
 
     return handle;
 }
 
+/**
+ * @brief Claim a timer to pace conversions on an exclusively owned ADC
+ */
+static void dmm_claim_timer(DMM_Handle *handle)
+{
+    // Claim a timer of our own so that other instruments can run alongside
+    Error error = ERROR_NONE;
+    TRY { handle->timer = TIM_LL_claim(); }
+    CATCH(error)
+    {
+        LOG_ERROR("DMM: No timer available");
+        g_dmm_handle = nullptr;
+        THROW(error);
+    }
+}
+
+/**
+ * @brief Measure through the injected group of an ADC owned by another user
+ */
+static void dmm_init_shared(DMM_Handle *handle)
+{
+    LOG_FUNCTION_ENTRY();
+
+    Error error = ERROR_NONE;
+    TRY
+    {
+        ADC_LL_injected_init(
+            dmm_channel_to_adc_ll(dmm_scan_channel(&handle->config, 0)),
+            handle->config.oversampling_ratio,
+            dmm_oversampling_shift(&handle->config)
+        );
+        ADC_LL_set_injected_callback(dmm_adc_injected_callback);
+        ADC_LL_injected_start();
+    }
+    CATCH(error)
+    {
+        LOG_ERROR("DMM: Shared ADC init failed, error %d", error);
+        ADC_LL_injected_deinit();
+        g_dmm_handle = nullptr;
+        THROW(error);
+    }
+    handle->shared = true;
+
+    LOG_FUNCTION_EXIT();
+}
+
 /**
  * @brief Create ADC configuration for DMM
  */
 static ADC_LL_Config dmm_create_adc_config(DMM_Handle *handle)
 {
+    uint32_t const count = dmm_channel_count(&handle->config);
+    ADC_LL_Channel const first =
+        dmm_channel_to_adc_ll(dmm_scan_channel(&handle->config, 0));
     ADC_LL_Config adc_config = {
-        .channels = { dmm_channel_to_adc_ll(handle->config.channel) },
+        .channels = { first },
         .mode = ADC_LL_MODE_SINGLE,
-        .trigger_source = ADC_TRIGGER_TIMER6,
-        .output_buffer = &handle->adc_value,
-        .buffer_size = 1, // Single sample
-        .oversampling_ratio = handle->config.oversampling_ratio
+        .trigger_source = ADC_LL_get_timer_trigger(handle->timer),
+        .output_buffer = handle->adc_values,
+        .buffer_size = count, // Single sample per channel
+        .oversampling_ratio = handle->config.oversampling_ratio,
+        .oversampling_shift = dmm_oversampling_shift(&handle->config),
     };
+
+    // ADC2 converts the negative leg alongside, into adc_values[1]
+    if (handle->config.differential) {
+        adc_config.mode = ADC_LL_MODE_SIMULTANEOUS;
+        adc_config.channels[1] =
+            dmm_channel_to_adc_ll(handle->config.negative_channel);
+        adc_config.buffer_size = 2; // One pair, as the DMA counts samples
+    }
+
+    // Convert continuously into the ring, one half at a time
+    uint32_t const ring_size = dmm_ring_size(&handle->config);
+    if (ring_size > 0) {
+        adc_config.circular = true;
+        adc_config.output_buffer = handle->ring;
+        adc_config.buffer_size = ring_size;
+    }
+
+    // A burst fills the ring once, the DMA stops at its end. Its conversions
+    // and those of an aperture sample for as long as their rate leaves time
+    // for; other readings keep the default sampling time and run as fast as
+    // it allows.
+    uint32_t paced_rate = dmm_aperture_rate(&handle->config);
+    if (handle->config.burst_samples > 0) {
+        adc_config.output_buffer = handle->ring;
+        adc_config.buffer_size = handle->config.burst_samples;
+        paced_rate = handle->config.burst_rate;
+    }
+    if (paced_rate > 0) {
+        uint64_t const rate =
+            (uint64_t)paced_rate * handle->config.oversampling_ratio;
+        adc_config.conversion_rate =
+            rate > UINT32_MAX ? UINT32_MAX : (uint32_t)rate;
+    }
+
+    // The regular sequencer converts the scan list on every trigger
+    if (count > 1) {
+        for (uint32_t i = 0; i < count; ++i) {
+            adc_config.sequence[i] =
+                dmm_channel_to_adc_ll(handle->config.scan_channels[i]);
+        }
+        adc_config.sequence_length = count;
+    }
     return adc_config;
 }
 
@@ -166,18 +526,24 @@ static void dmm_init_adc(DMM_Handle *handle)
     {
         LOG_DEBUG("DMM: ADC_LL_init called");
         ADC_LL_init(&adc_config);
-        LOG_DEBUG("DMM: ADC initialized");
+        LOG_DEBUG(
+            "DMM: ADC initialized, sampling time %u ns",
+            ADC_LL_get_sample_time_ns()
+        );
     }
     CATCH(error)
     {
         LOG_ERROR("DMM: ADC init failed, error %d", error);
         g_dmm_handle = nullptr;
-        free(handle);
+        TIM_LL_release(handle->timer);
         THROW(error);
     }
 
     // Set up ADC callback
     ADC_LL_set_complete_callback(dmm_adc_complete_callback);
+    if (dmm_ring_size(&handle->config) > 0) {
+        ADC_LL_set_half_complete_callback(dmm_adc_complete_callback);
+    }
 
     LOG_FUNCTION_EXIT();
 }
@@ -189,14 +555,34 @@ static void dmm_init_timer(DMM_Handle *handle)
 {
     LOG_FUNCTION_ENTRY();
 
+    // A trigger converts every channel of a scan back to back
+    uint32_t const count = dmm_channel_count(&handle->config);
+    uint32_t const paced_rate = handle->config.burst_samples > 0
+                                    ? handle->config.burst_rate
+                                    : dmm_aperture_rate(&handle->config);
+
     Error error = ERROR_NONE;
-    TRY { TIM_LL_init(TIM_NUM_6, ADC_LL_get_sample_rate()); }
+    TRY
+    {
+        uint32_t freq = ADC_LL_get_sample_rate() / count;
+        if (paced_rate > 0) {
+            // Each trigger runs all oversampled conversions of one sample
+            uint64_t const adc_rate =
+                (uint64_t)paced_rate * handle->config.oversampling_ratio;
+            if (adc_rate > freq) {
+                LOG_ERROR("DMM: Paced rate %u Hz is too high", paced_rate);
+                THROW(ERROR_INVALID_ARGUMENT);
+            }
+            freq = paced_rate;
+        }
+        TIM_LL_init(handle->timer, freq);
+    }
     CATCH(error)
     {
         LOG_ERROR("DMM: Timer init failed, error %d", error);
         ADC_LL_deinit();
         g_dmm_handle = nullptr;
-        free(handle);
+        TIM_LL_release(handle->timer);
         THROW(error);
     }
     LOG_DEBUG("DMM: Timer init, freq %u Hz", ADC_LL_get_sample_rate());
@@ -211,17 +597,17 @@ static void dmm_start_conversion(DMM_Handle *handle)
     Error error = ERROR_NONE;
     TRY
     {
-        TIM_LL_start(TIM_NUM_6); // Start timer for ADC triggering
+        TIM_LL_start(handle->timer); // Start timer for ADC triggering
         ADC_LL_start();
     }
     CATCH(error)
     {
         LOG_ERROR("DMM: Failed to start conversion, error %d", error);
-        TIM_LL_stop(TIM_NUM_6);
+        TIM_LL_stop(handle->timer);
         ADC_LL_deinit();
-        TIM_LL_deinit(TIM_NUM_6);
+        TIM_LL_deinit(handle->timer);
         g_dmm_handle = nullptr;
-        free(handle);
+        TIM_LL_release(handle->timer);
         THROW(error);
     }
 }
@@ -242,6 +628,66 @@ static bool dmm_validate_config(DMM_Config const *config)
         return false;
     }
 
+    // Validate scan list
+    if (config->scan_count > DMM_SCAN_CHANNELS_MAX) {
+        LOG_ERROR("DMM: Too many scan channels: %u", config->scan_count);
+        return false;
+    }
+    for (uint32_t i = 0; i < config->scan_count; ++i) {
+        DMM_Channel const channel = config->scan_channels[i];
+        if (channel < DMM_CHANNEL_0 || channel > DMM_CHANNEL_15) {
+            LOG_ERROR("DMM: Invalid scan channel: %d", channel);
+            return false;
+        }
+    }
+
+    // Validate averaging window (whole ring quarters, single channel only)
+    uint32_t const window = config->average_window;
+    if (window > DMM_AVERAGE_WINDOW_MAX || window % 4 != 0) {
+        LOG_ERROR("DMM: Invalid averaging window: %u", window);
+        return false;
+    }
+    if (dmm_ring_size(config) > 0 && config->scan_count > 1) {
+        LOG_ERROR("DMM: Free running supports a single channel only");
+        return false;
+    }
+
+    // Validate burst (ring-sized, paced, single channel, one shot)
+    if (config->burst_samples > DMM_BURST_SAMPLES_MAX) {
+        LOG_ERROR("DMM: Burst too long: %u", config->burst_samples);
+        return false;
+    }
+    if (config->burst_samples > 0 &&
+        (config->burst_rate == 0 || config->scan_count > 1 ||
+         dmm_ring_size(config) > 0)) {
+        LOG_ERROR("DMM: Invalid burst configuration");
+        return false;
+    }
+
+    // Validate aperture (whole mains cycles, window chosen here, averaging)
+    if (config->nplc > DMM_NPLC_MAX) {
+        LOG_ERROR("DMM: Aperture too long: %u cycles", config->nplc);
+        return false;
+    }
+    if (config->nplc > 0 &&
+        ((config->line_frequency != 50 && config->line_frequency != 60) ||
+         config->average_window > 0 || config->burst_samples > 0 ||
+         config->scan_count > 1)) {
+        LOG_ERROR("DMM: Invalid aperture configuration");
+        return false;
+    }
+
+    // Validate differential legs (two channels, one conversion per reading)
+    if (config->differential &&
+        (config->negative_channel < DMM_CHANNEL_0 ||
+         config->negative_channel > DMM_CHANNEL_15 ||
+         config->negative_channel == config->channel ||
+         config->scan_count > 0 || dmm_ring_size(config) > 0 ||
+         config->burst_samples > 0 || config->nplc > 0)) {
+        LOG_ERROR("DMM: Invalid differential configuration");
+        return false;
+    }
+
     // Validate oversampling ratio (must be power of 2, 1-256)
     uint32_t ratio = config->oversampling_ratio;
     if (ratio == 0 || ratio > 256 || (ratio & (ratio - 1)) != 0) {
@@ -252,6 +698,33 @@ static bool dmm_validate_config(DMM_Config const *config)
     return true;
 }
 
+/**
+ * @brief Set up the ADC, and the timer unless the ADC is shared
+ */
+static void dmm_init_hardware(DMM_Handle *handle, DMM_Config const *config)
+{
+    if (ADC_LL_is_initialized()) {
+        if (dmm_channel_count(config) > 1 || dmm_ring_size(config) > 0 ||
+            config->burst_samples > 0 || config->differential) {
+            // The injected group of a shared ADC cannot hold a scan list,
+            // convert continuously, be paced by a timer of ours or take
+            // ADC2 along
+            LOG_ERROR(
+                "DMM: Scanning, free running, bursts and differential "
+                "readings need an exclusive ADC"
+            );
+            g_dmm_handle = nullptr;
+            THROW(ERROR_RESOURCE_BUSY);
+        }
+        dmm_init_shared(handle);
+    } else {
+        dmm_claim_timer(handle);
+        dmm_init_adc(handle);
+        dmm_init_timer(handle);
+        dmm_start_conversion(handle);
+    }
+}
+
 DMM_Handle *DMM_init(DMM_Config const *config)
 {
     LOG_FUNCTION_ENTRY();
@@ -261,12 +734,39 @@ DMM_Handle *DMM_init(DMM_Config const *config)
         THROW(ERROR_INVALID_ARGUMENT);
     }
 
-    DMM_Handle *handle = dmm_create_handle(config);
-    dmm_init_adc(handle);
-    dmm_init_timer(handle);
-    dmm_start_conversion(handle);
+    // An aperture averages over a window of whole power-line cycles
+    DMM_Config effective = *config;
+    if (config->nplc > 0) {
+        uint32_t const samples = dmm_aperture_samples_per_cycle(config);
+        if (samples < 4) {
+            LOG_ERROR("DMM: Aperture of %u cycles too long", config->nplc);
+            THROW(ERROR_INVALID_ARGUMENT);
+        }
+        effective.average_window = config->nplc * samples;
+        LOG_INFO(
+            "DMM: Aperture %u cycles of %u Hz, %u samples per cycle",
+            config->nplc,
+            config->line_frequency,
+            samples
+        );
+    }
+
+    DMM_Handle *handle = dmm_create_handle(&effective);
 
-    LOG_INFO("DMM: Ready, conversion started");
+    // The timer rate is derived for, and conversions run at, the full clock
+    CLOCK_request();
+    Error error = ERROR_NONE;
+    TRY { dmm_init_hardware(handle, &effective); }
+    CATCH(error)
+    {
+        CLOCK_release();
+        THROW(error);
+    }
+
+    LOG_INFO(
+        "DMM: Ready, conversion started (%s ADC)",
+        handle->shared ? "shared" : "exclusive"
+    );
     LOG_FUNCTION_EXIT();
 
     return handle;
@@ -288,34 +788,203 @@ void DMM_deinit(DMM_Handle *handle)
 
     LOG_INFO("DMM: Deinitializing");
 
-    // Stop ADC and timer
-    ADC_LL_stop();
-    TIM_LL_stop(TIM_NUM_6);
+    DMM_watch_stop(handle);
+    DMM_count_stop(handle);
+    if (handle->shared) {
+        // Leave the regular group to its owner
+        ADC_LL_injected_deinit();
+    } else {
+        // Stop ADC and timer
+        ADC_LL_stop();
+        TIM_LL_stop(handle->timer);
 
-    // Deinitialize peripherals
-    ADC_LL_deinit();
-    TIM_LL_deinit(TIM_NUM_6);
+        // Deinitialize peripherals
+        ADC_LL_deinit();
+        TIM_LL_deinit(handle->timer);
+        TIM_LL_release(handle->timer);
+    }
 
     // Clear global handle
     g_dmm_handle = nullptr;
 
-    // Mark as deinitialized and free memory
+    // Mark as deinitialized, the storage is reused by the next DMM_init
     handle->initialized = false;
-    free(handle);
+    CLOCK_release();
 
     LOG_INFO("DMM: Deinitialized successfully");
     LOG_FUNCTION_EXIT();
 }
 
-bool DMM_read_voltage(DMM_Handle *handle, FIXED_Q1616 *voltage_out)
+/**
+ * @brief Calibration of the channel at a position in the scan order
+ */
+static CALIBRATION_Entry dmm_calibration(
+    DMM_Handle const *handle,
+    uint32_t index
+)
+{
+    return CALIBRATION_get(
+        CALIBRATION_MODE_DMM, (uint32_t)dmm_scan_channel(&handle->config, index)
+    );
+}
+
+/**
+ * @brief Root mean square of calibrated samples
+ *
+ * The mean square of gain * v + offset is (gain * rms)^2 +
+ * 2 * gain * mean * offset + offset^2, computed in Q32.32 so that the
+ * root is Q16.16. The calibration limits keep every term far from
+ * overflow.
+ */
+static FIXED_Q1616 dmm_calibrated_rms(
+    CALIBRATION_Entry const *entry,
+    FIXED_Q1616 mean,
+    FIXED_Q1616 rms
+)
+{
+    int64_t const scaled_rms = FIXED_mul(rms, entry->gain);
+    int64_t const scaled_mean = FIXED_mul(mean, entry->gain);
+    int64_t const offset = entry->offset;
+    int64_t const mean_square = scaled_rms * scaled_rms +
+                                2 * scaled_mean * offset + offset * offset;
+
+    if (mean_square <= 0) {
+        return FIXED_ZERO;
+    }
+    uint64_t const root = FIXED_isqrt64((uint64_t)mean_square);
+    return root > (uint64_t)FIXED_MAX ? FIXED_MAX : (FIXED_Q1616)root;
+}
+
+/**
+ * @brief Volts per ADC code for the current reference voltage
+ *
+ * The reference only changes when the ADC driver re-measures VDDA, so the
+ * division in FIXED_code_scale runs once per change rather than once per
+ * reading.
+ */
+static int32_t dmm_volts_per_code(DMM_Handle *handle)
+{
+    uint32_t const ref_voltage_mv = ADC_LL_get_reference_voltage();
+
+    if (ref_voltage_mv != handle->scale_reference_mv) {
+        FIXED_Q1616 const reference_voltage =
+            FIXED_from_fraction((int32_t)ref_voltage_mv, SI_MILLI_DIV);
+        handle->volts_per_code = FIXED_code_scale(
+            reference_voltage, dmm_max_code(&handle->config)
+        );
+        handle->scale_reference_mv = ref_voltage_mv;
+        LOG_DEBUG("DMM: Reference %u mV", ref_voltage_mv);
+    }
+    return handle->volts_per_code;
+}
+
+/**
+ * @brief Merge the ring half summaries without tearing
+ */
+static void dmm_window_summary(DMM_Handle const *handle, STATS_Summary *out)
+{
+    uint32_t sequence = 0;
+    STATS_Summary second = STATS_SUMMARY_EMPTY;
+
+    // The callbacks pre-empt this loop, never the other way round, so a
+    // stable even sequence means both copies come from the same update
+    do {
+        sequence = handle->stats_sequence;
+        *out = handle->halves[0];
+        second = handle->halves[1];
+    } while ((sequence & 1U) != 0 || sequence != handle->stats_sequence);
+
+    STATS_merge(out, &second);
+}
+
+bool DMM_read_latest(
+    DMM_Handle *handle,
+    FIXED_Q1616 *voltage_out,
+    uint32_t *sequence_out
+)
+{
+    LOG_FUNCTION_ENTRY();
+
+    if (handle == nullptr || voltage_out == nullptr ||
+        sequence_out == nullptr) {
+        LOG_ERROR("DMM: Invalid arguments to read latest");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!handle->initialized) {
+        LOG_ERROR("DMM: Handle not initialized");
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (dmm_ring_size(&handle->config) == 0) {
+        LOG_ERROR("DMM: Not free running");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    // Retry if a callback published a new sample while we were reading
+    uint32_t conversions = 0;
+    uint16_t latest = 0;
+    do {
+        conversions = handle->conversions;
+        latest = handle->latest;
+    } while (conversions != handle->conversions);
+
+    *sequence_out = conversions;
+    if (conversions == 0) {
+        *voltage_out = FIXED_ZERO;
+        LOG_FUNCTION_EXIT();
+        return false;
+    }
+
+    CALIBRATION_Entry const calibration = dmm_calibration(handle, 0);
+    *voltage_out = CALIBRATION_apply(
+        &calibration,
+        FIXED_scale_code(FIXED_FROM_INT(latest), dmm_volts_per_code(handle))
+    );
+
+    LOG_FUNCTION_EXIT();
+    return true;
+}
+
+/**
+ * @brief Calibrated statistics of a summary of first-channel codes
+ */
+static void dmm_statistics(
+    DMM_Handle *handle,
+    STATS_Summary const *summary,
+    DMM_Statistics *statistics_out
+)
+{
+    int32_t const scale = dmm_volts_per_code(handle);
+    FIXED_Q1616 const mean = FIXED_scale_code(STATS_mean(summary), scale);
+    FIXED_Q1616 const rms = FIXED_scale_code(STATS_rms(summary), scale);
+    FIXED_Q1616 const ac_rms =
+        FIXED_scale_code(STATS_ac_rms(summary), scale);
+    FIXED_Q1616 const min =
+        FIXED_scale_code(FIXED_FROM_INT(summary->min), scale);
+    FIXED_Q1616 const max =
+        FIXED_scale_code(FIXED_FROM_INT(summary->max), scale);
+
+    // The gain is positive, so the corrected extremes stay in order, and
+    // the offset only moves the mean
+    CALIBRATION_Entry const calibration = dmm_calibration(handle, 0);
+    statistics_out->mean = CALIBRATION_apply(&calibration, mean);
+    statistics_out->rms = dmm_calibrated_rms(&calibration, mean, rms);
+    statistics_out->ac_rms = FIXED_mul(ac_rms, calibration.gain);
+    statistics_out->min = CALIBRATION_apply(&calibration, min);
+    statistics_out->max = CALIBRATION_apply(&calibration, max);
+    statistics_out->samples = summary->count;
+}
+
+bool DMM_read_statistics(DMM_Handle *handle, DMM_Statistics *statistics_out)
 {
     LOG_FUNCTION_ENTRY();
 
-    if (handle == nullptr || voltage_out == nullptr) {
+    if (handle == nullptr || statistics_out == nullptr) {
         LOG_ERROR(
-            "DMM: Invalid arguments (handle=%p, voltage_out=%p)",
+            "DMM: Invalid arguments (handle=%p, statistics_out=%p)",
             handle,
-            voltage_out
+            statistics_out
         );
         THROW(ERROR_INVALID_ARGUMENT);
     }
@@ -325,56 +994,510 @@ bool DMM_read_voltage(DMM_Handle *handle, FIXED_Q1616 *voltage_out)
         THROW(ERROR_DEVICE_NOT_READY);
     }
 
-    // Check if conversion is complete
-    bool conversion_ready = handle->conversion_complete;
+    if (handle->config.average_window == 0) {
+        LOG_ERROR("DMM: Not averaging");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
 
-    if (conversion_ready) {
-        // Get reference voltage from ADC driver
-        uint32_t ref_voltage_mv = ADC_LL_get_reference_voltage();
-        FIXED_Q1616 reference_voltage =
-            FIXED_from_fraction((int32_t)ref_voltage_mv, SI_MILLI_DIV);
+    STATS_Summary summary = STATS_SUMMARY_EMPTY;
+    dmm_window_summary(handle, &summary);
+    if (summary.count == 0) {
+        LOG_DEBUG("DMM: Averaging window still empty");
+        LOG_FUNCTION_EXIT();
+        return false;
+    }
+    if (handle->config.nplc > 0 &&
+        summary.count < handle->config.average_window) {
+        LOG_DEBUG("DMM: Aperture not yet filled");
+        LOG_FUNCTION_EXIT();
+        return false;
+    }
 
-        // Convert raw ADC value to voltage using fixed-point arithmetic
-        // ADC is 12-bit with oversampling and 4-bit right shift,
-        // so max value is back to 12-bit range (4095)
-        uint32_t max_value = 4095U;
+    dmm_statistics(handle, &summary, statistics_out);
 
-        // voltage = (raw_value * reference_voltage) / max_value
-        *voltage_out = FIXED_div(
-            FIXED_mul(handle->adc_value, reference_voltage), (int32_t)max_value
+    LOG_FUNCTION_EXIT();
+    return true;
+}
+
+bool DMM_read_burst_statistics(
+    DMM_Handle *handle,
+    DMM_Statistics *statistics_out
+)
+{
+    LOG_FUNCTION_ENTRY();
+
+    if (handle == nullptr || statistics_out == nullptr) {
+        LOG_ERROR(
+            "DMM: Invalid arguments (handle=%p, statistics_out=%p)",
+            handle,
+            statistics_out
         );
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
 
-        LOG_DEBUG(
-            "DMM: Channel %d voltage = %d.%04d V (raw = %u, ref = %u mV, max = "
-            "%u)",
-            handle->config.channel,
-            FIXED_get_integer_part(*voltage_out),
-            (FIXED_get_fractional_part(*voltage_out) * 10000) >> 16,
-            handle->adc_value,
-            ref_voltage_mv,
-            max_value
+    if (!handle->initialized) {
+        LOG_ERROR("DMM: Handle not initialized");
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (handle->config.burst_samples == 0) {
+        LOG_ERROR("DMM: Not taking a burst");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!handle->conversion_complete) {
+        LOG_FUNCTION_EXIT();
+        return false;
+    }
+
+    STATS_Summary summary = STATS_SUMMARY_EMPTY;
+    STATS_summarize(handle->ring, handle->config.burst_samples, &summary);
+    dmm_statistics(handle, &summary, statistics_out);
+
+    LOG_FUNCTION_EXIT();
+    return true;
+}
+
+/**
+ * @brief Start the next one-shot conversion after a reading
+ */
+static void dmm_rearm(DMM_Handle *handle)
+{
+    // Timer remains running continuously
+    handle->conversion_complete = false;
+
+    Error const error = handle->shared
+                            ? ADC_LL_try_injected_start() // Next injected
+                            : ADC_LL_try_start(); // Restart ADC/DMA
+    if (error != ERROR_NONE) {
+        LOG_ERROR("DMM: Failed to restart ADC, error %d", error);
+        // Not an error of the read - return the valid measurement
+    }
+}
+
+/**
+ * @brief Calibrated legs of the completed differential conversion
+ */
+static void dmm_differential(DMM_Handle *handle, DMM_Differential *reading)
+{
+    FIXED_Q1616 legs[2] = { 0 };
+    CALIBRATION_Entry const positive = dmm_calibration(handle, 0);
+    CALIBRATION_Entry const negative = CALIBRATION_get(
+        CALIBRATION_MODE_DMM, (uint32_t)handle->config.negative_channel
+    );
+
+    // ADC1 stores the positive leg, ADC2 the negative one
+    FIXED_scale_u16_array(
+        handle->adc_values, 2, dmm_volts_per_code(handle), legs
+    );
+    reading->positive = CALIBRATION_apply(&positive, legs[0]);
+    reading->negative = CALIBRATION_apply(&negative, legs[1]);
+    reading->difference = reading->positive - reading->negative;
+}
+
+/**
+ * @brief Read the voltages of all scanned channels
+ *
+ * Body of DMM_read_scan, returning failures instead of throwing.
+ *
+ * @param count_out Set to the number of voltages written, or 0 if no
+ *        measurement is ready
+ * @return ERROR_NONE, or the error DMM_read_scan throws
+ */
+static Error dmm_read_scan(
+    DMM_Handle *handle,
+    FIXED_Q1616 *voltages_out,
+    uint32_t max_count,
+    uint32_t *count_out
+)
+{
+    LOG_FUNCTION_ENTRY();
+
+    *count_out = 0;
+
+    if (handle == nullptr || voltages_out == nullptr) {
+        LOG_ERROR(
+            "DMM: Invalid arguments (handle=%p, voltages_out=%p)",
+            handle,
+            voltages_out
         );
+        return ERROR_INVALID_ARGUMENT;
+    }
 
-        // Reset flag and restart ADC for next conversion
-        // Timer remains running continuously
-        handle->conversion_complete = false;
+    if (!handle->initialized) {
+        LOG_ERROR("DMM: Handle not initialized");
+        return ERROR_DEVICE_NOT_READY;
+    }
 
-        Error error = ERROR_NONE;
-        TRY
-        {
-            ADC_LL_start(); // Restart ADC/DMA for next conversion
+    uint32_t const count = dmm_channel_count(&handle->config);
+    if (max_count < count) {
+        LOG_ERROR("DMM: Room for %u of %u voltages", max_count, count);
+        return ERROR_INVALID_ARGUMENT;
+    }
+    if (handle->config.burst_samples > 0) {
+        LOG_ERROR("DMM: Bursts are read with DMM_read_burst");
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    // The background window is always current, no restart needed
+    if (handle->config.average_window > 0) {
+        DMM_Statistics statistics = { 0 };
+        if (!DMM_read_statistics(handle, &statistics)) {
+            voltages_out[0] = FIXED_ZERO;
+            LOG_FUNCTION_EXIT();
+            return ERROR_NONE;
         }
-        CATCH(error)
-        {
-            LOG_ERROR("DMM: Failed to restart ADC, error %d", error);
-            // Don't throw here - return the valid measurement but log the error
+        voltages_out[0] = statistics.mean;
+        *count_out = 1;
+        LOG_FUNCTION_EXIT();
+        return ERROR_NONE;
+    }
+    if (handle->config.free_running) {
+        uint32_t sequence = 0;
+        bool const valid = DMM_read_latest(handle, voltages_out, &sequence);
+        *count_out = valid ? 1 : 0;
+        LOG_FUNCTION_EXIT();
+        return ERROR_NONE;
+    }
+
+    // Check if conversion is complete
+    if (!handle->conversion_complete) {
+        // No new conversion available, set voltages to 0
+        for (uint32_t i = 0; i < count; ++i) {
+            voltages_out[i] = FIXED_ZERO;
         }
-    } else {
-        // No new conversion available, set voltage to 0
-        *voltage_out = FIXED_ZERO;
         LOG_DEBUG("DMM: No new conversion available");
+        LOG_FUNCTION_EXIT();
+        return ERROR_NONE;
+    }
+
+    if (handle->config.differential) {
+        DMM_Differential reading = { 0 };
+        dmm_differential(handle, &reading);
+        voltages_out[0] = reading.difference;
+        dmm_rearm(handle);
+        *count_out = 1;
+        LOG_FUNCTION_EXIT();
+        return ERROR_NONE;
+    }
+
+    // Convert raw ADC values to voltages using fixed-point arithmetic:
+    // voltage = raw_value * volts_per_code, for the whole scan at once
+    int32_t const scale = dmm_volts_per_code(handle);
+    FIXED_scale_u16_array(handle->adc_values, count, scale, voltages_out);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        CALIBRATION_Entry const calibration = dmm_calibration(handle, i);
+        voltages_out[i] = CALIBRATION_apply(&calibration, voltages_out[i]);
+        LOG_DEBUG(
+            "DMM: Channel %d voltage = %d.%04d V (raw = %u, ref = %u mV)",
+            dmm_scan_channel(&handle->config, i),
+            FIXED_get_integer_part(voltages_out[i]),
+            (FIXED_get_fractional_part(voltages_out[i]) * 10000) >> 16,
+            handle->adc_values[i],
+            handle->scale_reference_mv
+        );
+    }
+
+    // Reset flag and restart ADC for next conversion
+    dmm_rearm(handle);
+
+    *count_out = count;
+    LOG_FUNCTION_EXIT();
+    return ERROR_NONE;
+}
+
+
+bool DMM_read_voltage(DMM_Handle *handle, FIXED_Q1616 *voltage_out)
+{
+    return DMM_read_scan(handle, voltage_out, 1) > 0;
+}
+
+Error DMM_try_read_voltage(
+    DMM_Handle *handle,
+    FIXED_Q1616 *voltage_out,
+    bool *ready
+)
+{
+    uint32_t count = 0;
+    Error const error = dmm_read_scan(handle, voltage_out, 1, &count);
+    *ready = count > 0;
+    return error;
+}
+
+uint32_t DMM_read_scan(
+    DMM_Handle *handle,
+    FIXED_Q1616 *voltages_out,
+    uint32_t max_count
+)
+{
+    uint32_t count = 0;
+    Error const error = dmm_read_scan(handle, voltages_out, max_count, &count);
+    if (error != ERROR_NONE) {
+        THROW(error);
+    }
+    return count;
+}
+
+bool DMM_read_differential(DMM_Handle *handle, DMM_Differential *reading_out)
+{
+    LOG_FUNCTION_ENTRY();
+
+    if (handle == nullptr || reading_out == nullptr) {
+        LOG_ERROR(
+            "DMM: Invalid arguments (handle=%p, reading_out=%p)",
+            handle,
+            reading_out
+        );
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!handle->initialized) {
+        LOG_ERROR("DMM: Handle not initialized");
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    if (!handle->config.differential) {
+        LOG_ERROR("DMM: Not differential");
+        THROW(ERROR_INVALID_ARGUMENT);
     }
 
+    if (!handle->conversion_complete) {
+        LOG_FUNCTION_EXIT();
+        return false;
+    }
+
+    dmm_differential(handle, reading_out);
+    dmm_rearm(handle);
+
     LOG_FUNCTION_EXIT();
-    return conversion_ready;
+    return true;
+}
+
+uint32_t DMM_read_burst(
+    DMM_Handle *handle,
+    FIXED_Q1616 *voltages_out,
+    uint32_t offset,
+    uint32_t max_count
+)
+{
+    if (handle == nullptr || voltages_out == nullptr) {
+        LOG_ERROR(
+            "DMM: Invalid arguments (handle=%p, voltages_out=%p)",
+            handle,
+            voltages_out
+        );
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!handle->initialized) {
+        LOG_ERROR("DMM: Handle not initialized");
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    uint32_t const samples = handle->config.burst_samples;
+    if (samples == 0) {
+        LOG_ERROR("DMM: Not taking a burst");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!handle->conversion_complete || offset >= samples) {
+        return 0;
+    }
+
+    uint32_t const count =
+        samples - offset < max_count ? samples - offset : max_count;
+    CALIBRATION_Entry const calibration = dmm_calibration(handle, 0);
+
+    FIXED_scale_u16_array(
+        &handle->ring[offset], count, dmm_volts_per_code(handle), voltages_out
+    );
+    for (uint32_t i = 0; i < count; ++i) {
+        voltages_out[i] = CALIBRATION_apply(&calibration, voltages_out[i]);
+    }
+    return count;
+}
+
+/**
+ * @brief 12-bit watchdog threshold of a calibrated voltage
+ *
+ * Inverts the calibration and the code scale of the first channel. A lower
+ * threshold rounds up and an upper one down, so that exactly the
+ * conversions beyond the voltage fall outside the window.
+ */
+static uint16_t dmm_watch_threshold(
+    DMM_Handle const *handle,
+    FIXED_Q1616 voltage,
+    bool round_up
+)
+{
+    CALIBRATION_Entry const calibration = dmm_calibration(handle, 0);
+    int64_t const max_code = (1 << DMM_CONVERSION_BITS) - 1;
+    int64_t const raw =
+        FIXED_div(FIXED_sub(voltage, calibration.offset), calibration.gain);
+
+    if (raw <= 0) {
+        return 0;
+    }
+    int64_t const numerator = raw * max_code * (int64_t)SI_MILLI_DIV;
+    int64_t const denominator =
+        (int64_t)ADC_LL_get_reference_voltage() * FIXED_SCALE;
+    if (denominator <= 0) {
+        return (uint16_t)max_code;
+    }
+    int64_t const code = round_up ? (numerator + denominator - 1) / denominator
+                                  : numerator / denominator;
+    return (uint16_t)(code > max_code ? max_code : code);
+}
+
+void DMM_watch_start(
+    DMM_Handle *handle,
+    FIXED_Q1616 low,
+    FIXED_Q1616 high,
+    DMM_WatchCallback callback
+)
+{
+    if (handle == nullptr || low > high) {
+        LOG_ERROR("DMM: Invalid arguments to watch");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!handle->initialized) {
+        LOG_ERROR("DMM: Handle not initialized");
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    // The watchdog needs the regular group converting continuously
+    if (handle->shared || dmm_ring_size(&handle->config) == 0) {
+        LOG_ERROR("DMM: Not free running");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    DMM_watch_stop(handle);
+    DMM_count_stop(handle);
+    handle->watch_low = dmm_watch_threshold(handle, low, true);
+    handle->watch_high = dmm_watch_threshold(handle, high, false);
+    handle->watch_callback = callback;
+    handle->watch_crossed = false;
+    handle->watching = true;
+    ADC_LL_set_watchdog_callback(dmm_adc_watchdog_callback);
+    ADC_LL_arm_watchdog(handle->watch_low, handle->watch_high);
+    LOG_INFO(
+        "DMM: Watching codes %u to %u", handle->watch_low, handle->watch_high
+    );
+}
+
+bool DMM_watch_event(DMM_Handle *handle)
+{
+    if (handle == nullptr || !handle->initialized || !handle->watching ||
+        !handle->watch_crossed) {
+        return false;
+    }
+
+    // Disarmed since the crossing, so no other can latch meanwhile
+    handle->watch_crossed = false;
+    ADC_LL_arm_watchdog(handle->watch_low, handle->watch_high);
+    return true;
+}
+
+void DMM_watch_stop(DMM_Handle *handle)
+{
+    if (handle == nullptr || !handle->watching) {
+        return;
+    }
+
+    ADC_LL_disarm_watchdog();
+    ADC_LL_set_watchdog_callback(nullptr);
+    handle->watching = false;
+    handle->watch_crossed = false;
+}
+
+void DMM_count_start(
+    DMM_Handle *handle,
+    FIXED_Q1616 level,
+    FIXED_Q1616 hysteresis,
+    bool timestamps
+)
+{
+    if (handle == nullptr || hysteresis < 0) {
+        LOG_ERROR("DMM: Invalid arguments to count");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!handle->initialized) {
+        LOG_ERROR("DMM: Handle not initialized");
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    // The watchdog needs the regular group converting continuously
+    if (handle->shared || dmm_ring_size(&handle->config) == 0) {
+        LOG_ERROR("DMM: Not free running");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    // A window that no conversion can leave would never fire
+    uint16_t const max_code = (1U << DMM_CONVERSION_BITS) - 1;
+    uint16_t const level_code = dmm_watch_threshold(handle, level, false);
+    uint16_t const rearm_code =
+        dmm_watch_threshold(handle, FIXED_sub(level, hysteresis), true);
+    if (level_code >= max_code || rearm_code == 0) {
+        LOG_ERROR("DMM: Count level outside the ADC range");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    DMM_watch_stop(handle);
+    DMM_count_stop(handle);
+    handle->count_level = level_code;
+    handle->count_rearm = rearm_code;
+    handle->count_timestamps = timestamps;
+    handle->count_events = 0;
+    ring_u32_init(
+        &handle->count_ring,
+        handle->count_storage,
+        DMM_COUNT_TIMESTAMPS_MAX + 1
+    );
+    handle->count_start_us = PLATFORM_get_time_us();
+
+    // Starts by waiting below the level, so a high signal is not counted
+    handle->count_above = true;
+    handle->counting = true;
+    ADC_LL_set_watchdog_callback(dmm_adc_watchdog_callback);
+    ADC_LL_arm_watchdog(rearm_code, max_code);
+    LOG_INFO(
+        "DMM: Counting above code %u, re-armed below %u",
+        level_code,
+        rearm_code
+    );
+}
+
+uint32_t DMM_count_events(DMM_Handle const *handle)
+{
+    if (handle == nullptr || !handle->counting) {
+        return 0;
+    }
+    return handle->count_events;
+}
+
+uint32_t DMM_count_take_timestamps(
+    DMM_Handle *handle,
+    uint32_t *timestamps_us,
+    uint32_t max
+)
+{
+    if (handle == nullptr || !handle->counting || timestamps_us == nullptr) {
+        return 0;
+    }
+    return ring_u32_read(&handle->count_ring, timestamps_us, max);
+}
+
+void DMM_count_stop(DMM_Handle *handle)
+{
+    if (handle == nullptr || !handle->counting) {
+        return;
+    }
+
+    // Cleared first, so that a crossing meanwhile does not re-arm
+    handle->counting = false;
+    ADC_LL_disarm_watchdog();
+    ADC_LL_set_watchdog_callback(nullptr);
 }
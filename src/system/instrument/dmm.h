@@ -15,6 +15,7 @@
 
 #include <stdint.h>
 
+#include "util/error.h"
 #include "util/fixed_point.h"
 
 #ifdef __cplusplus
@@ -51,21 +52,109 @@ typedef enum {
     DMM_CHANNEL_15 = 15
 } DMM_Channel;
 
+enum {
+    DMM_SCAN_CHANNELS_MAX = 16, // Longest scan list
+    DMM_AVERAGE_WINDOW_MAX = 1024, // Longest averaging window in samples
+    DMM_FREE_RUNNING_RING = 16, // Ring length in free-running mode
+    DMM_BURST_SAMPLES_MAX = 1024, // Longest timed burst in samples
+    DMM_NPLC_MAX = 100, // Longest aperture in power-line cycles
+    DMM_COUNT_TIMESTAMPS_MAX = 31, // Crossing times kept until taken
+};
+
 /**
  * @brief DMM configuration structure
+ *
+ * With scan_count > 0, one trigger converts every channel in scan_channels
+ * and channel is ignored. Scanning more than one channel needs the ADC to
+ * itself.
+ *
+ * With average_window > 0, the DMM converts continuously into a ring of
+ * that many samples and readings return statistics over the ring instead
+ * of a single conversion. The window must be a multiple of 4, and
+ * averaging needs the ADC to itself and a single channel.
+ *
+ * With free_running set, the DMM also converts continuously, into a short
+ * ring, and readings return the latest conversion without waiting or
+ * re-arming the ADC. It has the same restrictions as averaging, which
+ * implies free running.
+ *
+ * With burst_samples > 0, the DMM instead takes that many conversions of a
+ * single channel, one every 1 / burst_rate seconds, and then stops; see
+ * DMM_read_burst. A burst needs the ADC to itself and cannot be combined
+ * with scanning, averaging or free running. burst_rate times the
+ * oversampling ratio must not exceed the ADC sample rate.
+ *
+ * With nplc > 0, the DMM averages in the background over an aperture of
+ * that many cycles of the line_frequency mains instead: the conversions
+ * are paced by the timer at a whole number of samples per cycle and the
+ * window holds exactly nplc cycles of them, so that hum and its harmonics
+ * average out. The DMM picks the window itself, so average_window must be
+ * 0; the samples per cycle shrink as nplc and the oversampling ratio grow,
+ * down to 4.
+ *
+ * Oversampling averages the conversions back to 12 bits by default. With
+ * high_resolution, the hardware keeps one more bit per doubling of the
+ * ratio instead, up to 15 bits from a ratio of 8, which resolves steps
+ * below one 12-bit code without averaging on the host.
+ *
+ * With differential set, ADC1 converts channel and ADC2 negative_channel
+ * on the same trigger, and readings return the difference of the two
+ * legs, see DMM_read_differential. A differential reading needs the ADC to
+ * itself, two different channels and one conversion per reading: it cannot
+ * be combined with scanning, averaging, free running, bursts or an
+ * aperture.
  */
 typedef struct {
     DMM_Channel channel; // ADC channel to use for measurements
     uint32_t oversampling_ratio; // Oversampling ratio (1, 2, 4, 8, 16, 32, 64,
                                  // 128, 256)
+    uint32_t scan_count; // Channels in scan_channels, 0 for single channel
+    DMM_Channel scan_channels[DMM_SCAN_CHANNELS_MAX]; // Channels to scan
+    uint32_t average_window; // Samples averaged in the background, 0 for
+                             // one conversion per reading
+    bool free_running; // Convert continuously, readings return the latest
+    uint32_t burst_samples; // Conversions per timed burst, 0 for none
+    uint32_t burst_rate; // Burst conversions per second
+    bool high_resolution; // Keep the extra bits of oversampling, up to 15
+    uint32_t nplc; // Aperture in power-line cycles, 0 for none
+    uint32_t line_frequency; // Power-line frequency in Hz, 50 or 60
+    bool differential; // Sample channel and negative_channel simultaneously
+    DMM_Channel negative_channel; // Leg subtracted from channel, on ADC2
 } DMM_Config;
 
+/**
+ * @brief Statistics over the averaging window
+ */
+typedef struct {
+    FIXED_Q1616 mean; // Mean voltage (in volts)
+    FIXED_Q1616 rms; // Root mean square voltage (in volts)
+    FIXED_Q1616 ac_rms; // RMS about the mean, true RMS of the AC part
+    FIXED_Q1616 min; // Smallest voltage (in volts)
+    FIXED_Q1616 max; // Largest voltage (in volts)
+    uint32_t samples; // Number of samples the statistics cover
+} DMM_Statistics;
+
+/**
+ * @brief Legs of a differential reading, sampled at the same instant
+ */
+typedef struct {
+    FIXED_Q1616 difference; // positive - negative (in volts)
+    FIXED_Q1616 positive; // Voltage on channel (in volts)
+    FIXED_Q1616 negative; // Voltage on negative_channel (in volts)
+} DMM_Differential;
+
+/**
+ * @brief Called from interrupt context when a watch sees a crossing
+ */
+typedef void (*DMM_WatchCallback)(void);
+
 /**
  * @brief Default DMM configuration
  */
 #define DMM_CONFIG_DEFAULT                                                     \
     {                                                                          \
         .channel = DMM_CHANNEL_0, .oversampling_ratio = 16,                    \
+        .line_frequency = 50,                                                  \
     }
 
 /**
@@ -75,11 +164,18 @@ typedef struct {
  * It sets up the ADC in single sample mode for continuous voltage measurements
  * and starts the first conversion.
  *
+ * If the ADC is already owned by another instrument, such as a configured
+ * oscilloscope, the DMM shares it through software-triggered injected
+ * conversions instead. Each reading then briefly pre-empts the owner's
+ * conversions, and readings stop when the owner releases the ADC.
+ *
  * @param config Pointer to DMM configuration structure
  * @return Pointer to DMM handle on success, NULL on failure
  *
  * @throws ERROR_INVALID_ARGUMENT if config is NULL or contains invalid values
- * @throws ERROR_OUT_OF_MEMORY if memory allocation fails
+ * @throws ERROR_RESOURCE_BUSY if the DMM or the ADC injected channel is
+ *         already in use, or a scan, averaging, free running or a
+ *         differential reading is requested on a shared ADC
  * @throws ERROR_HARDWARE_FAULT if ADC initialization fails
  */
 DMM_Handle *DMM_init(DMM_Config const *config);
@@ -88,7 +184,8 @@ DMM_Handle *DMM_init(DMM_Config const *config);
  * @brief Deinitialize the Digital Multimeter
  *
  * This function deinitializes the DMM subsystem, releases hardware resources,
- * and frees the handle memory. The handle becomes invalid after this call.
+ * and releases the statically allocated handle. The handle becomes invalid
+ * after this call.
  *
  * @param handle Pointer to DMM handle to deinitialize
  */
@@ -101,16 +198,283 @@ void DMM_deinit(DMM_Handle *handle);
  * whether the value is valid. If a valid measurement is available, it
  * starts the next conversion automatically for continuous operation.
  *
+ * When averaging, it returns the mean over the averaging window without
+ * waiting. The value is valid as soon as the first half of the window has
+ * been filled. When free running without averaging, it returns the latest
+ * conversion, as DMM_read_latest does. When differential, it returns the
+ * difference of the two legs.
+ *
  * @param handle Pointer to DMM handle
  * @param voltage_out Pointer to store the measured voltage (in volts,
  * fixed-point)
  * @return true if voltage_out contains a valid measurement, false otherwise
  *
- * @throws ERROR_INVALID_ARGUMENT if handle or voltage_out is NULL
+ * @throws ERROR_INVALID_ARGUMENT if handle or voltage_out is NULL, or the
+ *         DMM is scanning several channels or taking a burst
  * @throws ERROR_DEVICE_NOT_READY if DMM is not initialized
  */
 bool DMM_read_voltage(DMM_Handle *handle, FIXED_Q1616 *voltage_out);
 
+/**
+ * @brief Read voltage, returning failures instead of throwing
+ *
+ * Same as DMM_read_voltage, for callers that poll for a measurement and
+ * would otherwise need a TRY block around the polling loop.
+ *
+ * @param handle Pointer to DMM handle
+ * @param voltage_out Pointer to store the measured voltage
+ * @param ready Set to true if voltage_out contains a valid measurement
+ * @return ERROR_NONE, or the error DMM_read_voltage would throw
+ */
+Error DMM_try_read_voltage(
+    DMM_Handle *handle,
+    FIXED_Q1616 *voltage_out,
+    bool *ready
+);
+
+/**
+ * @brief Read the voltages of all scanned channels
+ *
+ * Like DMM_read_voltage, but returns one voltage per channel in scan order.
+ * A single-channel DMM counts as a scan of one channel.
+ *
+ * @param handle Pointer to DMM handle
+ * @param voltages_out Array to store the measured voltages
+ * @param max_count Number of elements in voltages_out
+ * @return Number of voltages written, or 0 if no measurement is ready
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or voltages_out is NULL,
+ *         max_count is smaller than the number of scanned channels, or the
+ *         DMM is taking a burst
+ * @throws ERROR_DEVICE_NOT_READY if DMM is not initialized
+ */
+uint32_t DMM_read_scan(
+    DMM_Handle *handle,
+    FIXED_Q1616 *voltages_out,
+    uint32_t max_count
+);
+
+/**
+ * @brief Read both legs of a differential reading and their difference
+ *
+ * Like DMM_read_voltage, but returns the calibrated voltage of each leg
+ * as well. The legs are converted by ADC1 and ADC2 on the same trigger, so
+ * a common-mode signal cancels in the difference even while it changes.
+ *
+ * @param handle Pointer to DMM handle
+ * @param reading_out Pointer to store the reading
+ * @return true if reading_out contains a valid reading, false otherwise
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or reading_out is NULL, or the
+ *         DMM is not differential
+ * @throws ERROR_DEVICE_NOT_READY if DMM is not initialized
+ */
+bool DMM_read_differential(DMM_Handle *handle, DMM_Differential *reading_out);
+
+/**
+ * @brief Read the latest conversion of a free-running DMM
+ *
+ * Conversions are published in batches of DMM_FREE_RUNNING_RING / 2 (or
+ * half the averaging window), so the value is at most that many
+ * conversions old. The sequence number counts conversions since
+ * initialization; a reading with an unchanged sequence number repeats the
+ * previous value.
+ *
+ * @param handle Pointer to DMM handle
+ * @param voltage_out Pointer to store the latest voltage (in volts)
+ * @param sequence_out Pointer to store the sequence number of the reading
+ * @return true if a conversion has been published, false otherwise
+ *
+ * @throws ERROR_INVALID_ARGUMENT if any pointer is NULL, or the DMM is
+ *         neither free running nor averaging
+ * @throws ERROR_DEVICE_NOT_READY if DMM is not initialized
+ */
+bool DMM_read_latest(
+    DMM_Handle *handle,
+    FIXED_Q1616 *voltage_out,
+    uint32_t *sequence_out
+);
+
+/**
+ * @brief Read statistics over the averaging window
+ *
+ * The window is updated in the background each time half of it has been
+ * filled, so the statistics cover the most recent average_window samples,
+ * or half of them shortly after initialization. With an aperture in
+ * power-line cycles there are no statistics until the whole aperture has
+ * been filled, so that they always cover whole cycles.
+ *
+ * @param handle Pointer to DMM handle
+ * @param statistics_out Pointer to store the statistics
+ * @return true if statistics_out contains valid statistics, false if no
+ *         samples have been collected yet
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or statistics_out is NULL, or
+ *         the DMM is not averaging
+ * @throws ERROR_DEVICE_NOT_READY if DMM is not initialized
+ */
+bool DMM_read_statistics(DMM_Handle *handle, DMM_Statistics *statistics_out);
+
+/**
+ * @brief Read the conversions of a completed timed burst
+ *
+ * The burst starts with DMM_init and is read in place, so it can be read
+ * in pieces of any size, and as often as needed, until DMM_deinit. A new
+ * burst needs a new DMM_init.
+ *
+ * @param handle Pointer to DMM handle
+ * @param voltages_out Array to store the voltages, in conversion order
+ * @param offset Index of the first conversion to read
+ * @param max_count Number of elements in voltages_out
+ * @return Number of voltages written: up to max_count, fewer at the end of
+ *         the burst, 0 while the burst is still running
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or voltages_out is NULL, or the
+ *         DMM is not taking a burst
+ * @throws ERROR_DEVICE_NOT_READY if DMM is not initialized
+ */
+uint32_t DMM_read_burst(
+    DMM_Handle *handle,
+    FIXED_Q1616 *voltages_out,
+    uint32_t offset,
+    uint32_t max_count
+);
+
+/**
+ * @brief Read statistics over the conversions of a completed timed burst
+ *
+ * Same statistics as DMM_read_statistics, over all conversions of the
+ * burst. With the burst spanning a whole number of cycles of a periodic
+ * signal, ac_rms is its true RMS AC voltage.
+ *
+ * @param handle Pointer to DMM handle
+ * @param statistics_out Pointer to store the statistics
+ * @return true if statistics_out contains valid statistics, false while
+ *         the burst is still running
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or statistics_out is NULL, or
+ *         the DMM is not taking a burst
+ * @throws ERROR_DEVICE_NOT_READY if DMM is not initialized
+ */
+bool DMM_read_burst_statistics(
+    DMM_Handle *handle,
+    DMM_Statistics *statistics_out
+);
+
+/**
+ * @brief Watch the voltage for crossings of a window
+ *
+ * The ADC analog watchdog compares every conversion with the window, with
+ * no CPU time spent on the conversions inside it, so that excursions as
+ * short as one conversion are caught without polling. The first
+ * conversion outside the window latches a crossing and calls callback;
+ * further crossings go unseen until DMM_watch_event takes the latched one.
+ * Oversampled conversions are compared after averaging. A new window
+ * replaces the last; the watch ends with DMM_watch_stop or DMM_deinit.
+ *
+ * @param handle Pointer to DMM handle
+ * @param low Lowest voltage inside the window (in volts, calibrated)
+ * @param high Highest voltage inside the window (in volts, calibrated)
+ * @param callback Called from interrupt context on a crossing, or nullptr
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL, low is above high, or
+ *         the DMM is neither free running nor averaging on its own ADC
+ * @throws ERROR_DEVICE_NOT_READY if DMM is not initialized
+ */
+void DMM_watch_start(
+    DMM_Handle *handle,
+    FIXED_Q1616 low,
+    FIXED_Q1616 high,
+    DMM_WatchCallback callback
+);
+
+/**
+ * @brief Take the crossing latched by a watch, and watch for the next
+ *
+ * @param handle Pointer to DMM handle
+ * @return true if a conversion has fallen outside the window since the
+ *         watch started or the last call that returned true
+ */
+bool DMM_watch_event(DMM_Handle *handle);
+
+/**
+ * @brief End a watch
+ *
+ * Does nothing if the DMM is not watching.
+ *
+ * @param handle Pointer to DMM handle
+ */
+void DMM_watch_stop(DMM_Handle *handle);
+
+/**
+ * @brief Count the rising crossings of a level
+ *
+ * The analog watchdog alternates between two windows: the first fires on
+ * the first conversion above level, which counts a crossing, and the
+ * second on the next conversion below level - hysteresis, which arms the
+ * first again. The CPU only hears of the two conversions of each pulse,
+ * and no samples are stored, so pulses and glitches can be counted for
+ * hours. A signal starting above the level is not counted until it has
+ * fallen below level - hysteresis.
+ *
+ * With timestamps, the time of each crossing is also kept, until taken by
+ * DMM_count_take_timestamps; crossings that find DMM_COUNT_TIMESTAMPS_MAX
+ * times waiting are counted without one.
+ *
+ * Counting uses the watchdog of a watch, so it ends a watch, and a watch
+ * ends it; it also ends with DMM_count_stop or DMM_deinit.
+ *
+ * @param handle Pointer to DMM handle
+ * @param level Voltage a crossing rises above (in volts, calibrated)
+ * @param hysteresis Fall below level that re-arms the count (in volts)
+ * @param timestamps Whether to keep the time of each crossing
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL, hysteresis is negative,
+ *         a threshold is outside the ADC range, or the DMM is neither free
+ *         running nor averaging on its own ADC
+ * @throws ERROR_DEVICE_NOT_READY if DMM is not initialized
+ */
+void DMM_count_start(
+    DMM_Handle *handle,
+    FIXED_Q1616 level,
+    FIXED_Q1616 hysteresis,
+    bool timestamps
+);
+
+/**
+ * @brief Get the number of crossings counted
+ *
+ * @param handle Pointer to DMM handle
+ * @return Crossings since DMM_count_start, wrapping after 2^32, or 0 if
+ *         the DMM is not counting
+ */
+uint32_t DMM_count_events(DMM_Handle const *handle);
+
+/**
+ * @brief Take the times of the crossings kept since the last call
+ *
+ * @param handle Pointer to DMM handle
+ * @param[out] timestamps_us Times of the crossings in microseconds since
+ *             DMM_count_start, oldest first, wrapping after about 71
+ *             minutes
+ * @param max Capacity of timestamps_us
+ * @return Number of times written, at most max
+ */
+uint32_t DMM_count_take_timestamps(
+    DMM_Handle *handle,
+    uint32_t *timestamps_us,
+    uint32_t max
+);
+
+/**
+ * @brief End counting
+ *
+ * Does nothing if the DMM is not counting.
+ *
+ * @param handle Pointer to DMM handle
+ */
+void DMM_count_stop(DMM_Handle *handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,23 +3,63 @@
  * @brief Digital Storage Oscilloscope implementation for PSLab firmware
  *
  * This file implements a digital storage oscilloscope using the ADC_LL API
- * in continuous sampling mode, supporting both single-channel and dual-channel
- * modes for high-speed data acquisition.
+ * in continuous sampling mode, supporting single-channel, dual-channel and
+ * four-channel modes for high-speed data acquisition.
  *
  * @author PSLab Team
  * @date 2025-09-29
  */
 
+#define LOG_MODULE LOG_MODULE_DSO
+
 #include <stdbool.h>
 #include <stdint.h>
-#include <stdlib.h>
+#include <string.h>
 
 #include "platform/adc_ll.h"
+#include "platform/platform.h"
 #include "platform/tim_ll.h"
+#include "util/arena.h"
+#include "util/decimate.h"
+#include "util/equivalent_time.h"
 #include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/interleave.h"
 #include "util/logging.h"
+#include "util/si_prefix.h"
+#include "util/spectrum.h"
 
+#include "clock.h"
 #include "dso.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "sync.h"
+#include "trace.h"
+#include "waveform.h"
+
+enum {
+    // Target size of each half of the decimation DMA buffer, in samples
+    DECIMATION_HALF_SAMPLES = 512,
+    // Largest decimation DMA buffer: two halves of two groups of
+    // (min, max) pairs on two channels at the highest factor, or on four
+    // channels at half of it
+    DECIMATION_RAW_MAX = 2 * 2 * 4 * DSO_DECIMATION_FACTOR_MAX,
+    // Conversions summed per sample in high resolution; the smallest sum
+    // already has the 15 bits of DSO_SAMPLE_MAX_HIGH
+    OVERSAMPLING_MIN = 8,
+    OVERSAMPLING_MAX = 256,
+};
+
+/**
+ * @brief Progress of a triggered capture
+ */
+typedef enum {
+    TRIGGER_FILLING, // Recording pretrigger history, watchdog disarmed
+    TRIGGER_WAIT_PRE, // Edge trigger: waiting for the far side of the level
+    TRIGGER_WAIT_EDGE, // Waiting for the trigger condition
+    TRIGGER_FIRED, // Recording post-trigger samples
+    TRIGGER_DONE, // Capture complete, buffer rotated
+} TriggerState;
 
 /**
  * @brief DSO handle structure
@@ -27,11 +67,63 @@
 struct DSO_Handle {
     DSO_Config config;
     bool running;
+    bool prepared; // Staged by DSO_try_prepare, waiting for the timer
+    TIM_Num timer; // Claimed timer pacing the conversions
+    // Triggered capture state, updated from interrupt context
+    TriggerState volatile trigger_state;
+    uint32_t trigger_recorded; // Samples recorded while filling
+    int32_t trigger_post; // Post-trigger samples as of the last half boundary
+    uint32_t trigger_position; // DMA position when the trigger fired
+    uint32_t trigger_time_us; // Time when the trigger fired
+    uint32_t start_time_us; // Time when acquisition started
+    uint32_t errors_at_start; // ADC errors counted before the acquisition
+    uint32_t volatile segments_acquired; // Completed trigger segments
+    DSO_Segment segment_info[DSO_SEGMENTS_MAX];
+    // Averaged capture state; shifts are the leading samples each capture
+    // lost to the half boundary stop
+    uint32_t volatile averages_acquired;
+    uint32_t average_shift[DSO_AVERAGES_MAX];
+    // Decimated capture state
+    uint16_t *raw_buffer; // Circular DMA buffer at the full ADC rate
+    uint32_t raw_size;
+    uint32_t decimated; // Samples stored in the output buffer
+    DECIMATE_Filter filter; // Anti-aliasing filter state when filtering
+    // ADC1/ADC2 mismatch correction on the capture's scale, single-channel
+    // mode only
+    INTERLEAVE_Correction interleave;
+    bool interleave_active;
+    // Continuous acquisition blocks lent to the block callback, one per
+    // buffer half, updated from interrupt context
+    uint16_t const *volatile leased[2];
+    bool volatile paused; // Timer stopped until the half below is released
+    uint32_t paused_half;
+    uint32_t volatile stream_pauses; // Pauses since the acquisition started
+    // Continuous acquisition without a block callback overwrites the buffer
+    // in a ring, see DSO_get_samples_written
+    uint32_t volatile wraps; // Times the DMA returned to the buffer start
+    uint32_t written_seen; // Last count returned
 };
 
+// Storage for the only DSO instance and its decimation DMA buffer
+static DSO_Handle g_dso_storage;
+static uint16_t g_dso_raw_buffer[DECIMATION_RAW_MAX] ARENA_DMA_MEMORY;
+
 // Static instance for callback context
 static DSO_Handle *g_dso_handle = nullptr;
 
+// ADC1/ADC2 mismatch of single-channel mode on the 12-bit scale, kept
+// across handles, see DSO_calibrate_interleave
+static INTERLEAVE_Correction g_interleave = INTERLEAVE_CORRECTION_IDENTITY;
+
+/**
+ * @brief Total of the ADC error counters
+ */
+static uint32_t dso_adc_errors(void)
+{
+    ADC_LL_ErrorCounters const counters = ADC_LL_get_error_counters();
+    return counters.overruns + counters.dma_errors;
+}
+
 /**
  * @brief Convert DSO channel to ADC_LL channel
  */
@@ -43,6 +135,10 @@ static ADC_LL_Channel dso_channel_to_adc_ll(DSO_Channel channel)
         return ADC_LL_CHANNEL_0;
     case DSO_CHANNEL_1:
         return ADC_LL_CHANNEL_1;
+    case DSO_CHANNEL_2:
+        return ADC_LL_CHANNEL_2;
+    case DSO_CHANNEL_3:
+        return ADC_LL_CHANNEL_3;
     default:
         // This should never happen due to validation, but satisfies linter
         return ADC_LL_CHANNEL_0;
@@ -61,6 +157,7 @@ static ADC_LL_Mode dso_mode_to_adc_ll(DSO_Mode mode)
     case DSO_MODE_SINGLE_CHANNEL:
         return ADC_LL_MODE_INTERLEAVED;
     case DSO_MODE_DUAL_CHANNEL:
+    case DSO_MODE_QUAD_CHANNEL:
         return ADC_LL_MODE_SIMULTANEOUS;
     default:
         return ADC_LL_MODE_INTERLEAVED;
@@ -68,229 +165,1735 @@ static ADC_LL_Mode dso_mode_to_adc_ll(DSO_Mode mode)
 }
 
 /**
- * @brief ADC completion callback for DSO
+ * @brief Convert DSO resolution to ADC_LL_Resolution
  *
- * Called when ADC data acquisition is complete.
+ * @param resolution DSO resolution.
+ * @return Corresponding ADC_LL_Resolution.
  */
-// NOLINTNEXTLINE(readability-non-const-parameter)
-static void dso_adc_complete_callback(uint16_t *buffer, uint32_t total_samples)
+static ADC_LL_Resolution dso_resolution_to_adc_ll(DSO_Resolution resolution)
 {
-    (void)buffer;
-    (void)total_samples;
+    switch (resolution) {
+    case DSO_RESOLUTION_10BIT:
+        return ADC_LL_RESOLUTION_10BIT;
+    case DSO_RESOLUTION_8BIT:
+        return ADC_LL_RESOLUTION_8BIT;
+    case DSO_RESOLUTION_12BIT:
+    case DSO_RESOLUTION_HIGH:
+    default:
+        return ADC_LL_RESOLUTION_12BIT;
+    }
+}
 
-    if (g_dso_handle != nullptr &&
-        g_dso_handle->config.complete_callback != nullptr) {
-        g_dso_handle->running = false;
-        TIM_LL_stop(TIM_NUM_6);
-        g_dso_handle->config.complete_callback();
+/**
+ * @brief Bits dropped from the 12-bit scale at a resolution
+ *
+ * High resolution captures cannot be triggered, so trigger levels are only
+ * ever dropped to the lower resolutions.
+ */
+static uint32_t dso_resolution_shift(DSO_Resolution resolution)
+{
+    switch (resolution) {
+    case DSO_RESOLUTION_10BIT:
+        return 2;
+    case DSO_RESOLUTION_8BIT:
+        return 4;
+    case DSO_RESOLUTION_12BIT:
+    case DSO_RESOLUTION_HIGH:
+    default:
+        return 0;
     }
 }
 
 /**
- * @brief Validate DSO configuration
+ * @brief Largest sample value at a resolution
  */
-static bool dso_validate_config(DSO_Config const *config)
+static uint16_t dso_sample_max(DSO_Resolution resolution)
 {
-    if (config == nullptr) {
-        LOG_ERROR("DSO: Configuration is NULL");
-        return false;
+    switch (resolution) {
+    case DSO_RESOLUTION_10BIT:
+        return DSO_SAMPLE_MAX >> 2;
+    case DSO_RESOLUTION_8BIT:
+        return DSO_SAMPLE_MAX >> 4;
+    case DSO_RESOLUTION_HIGH:
+        return DSO_SAMPLE_MAX_HIGH;
+    case DSO_RESOLUTION_12BIT:
+    default:
+        return DSO_SAMPLE_MAX;
     }
+}
 
-    // Validate buffer
-    if (config->buffer == nullptr) {
-        LOG_ERROR("DSO: Buffer is NULL");
-        return false;
+/**
+ * @brief Convert an interleave correction between sample scales
+ *
+ * The gain applies on any scale; the offset, in sample codes, scales with
+ * the full-scale value.
+ */
+static INTERLEAVE_Correction dso_scale_interleave(
+    INTERLEAVE_Correction const *correction,
+    DSO_Resolution from,
+    DSO_Resolution to
+)
+{
+    int64_t const offset = (int64_t)correction->offset *
+                           ((int64_t)dso_sample_max(to) + 1) /
+                           ((int64_t)dso_sample_max(from) + 1);
+
+    return (INTERLEAVE_Correction){
+        .gain = correction->gain,
+        .offset = (FIXED_Q1616)offset,
+    };
+}
+
+/**
+ * @brief Maximum ADC trigger rate for a mode and resolution
+ *
+ * In four-channel mode each trigger converts two channels per ADC in turn.
+ */
+static uint32_t dso_adc_max_sample_rate(
+    DSO_Mode mode,
+    DSO_Resolution resolution
+)
+{
+    uint32_t rate = ADC_LL_get_max_sample_rate(
+        dso_mode_to_adc_ll(mode), dso_resolution_to_adc_ll(resolution)
+    );
+    if (resolution == DSO_RESOLUTION_HIGH) {
+        rate /= OVERSAMPLING_MIN;
     }
+    return mode == DSO_MODE_QUAD_CHANNEL ? rate / 2 : rate;
+}
 
-    if (config->buffer_size == 0) {
-        LOG_ERROR("DSO: Buffer size is zero");
-        return false;
+/**
+ * @brief Conversions summed per sample
+ *
+ * High resolution sums as many conversions as the ADC has time for at the
+ * sample rate, up to OVERSAMPLING_MAX; the others convert once.
+ */
+static uint32_t dso_oversampling_ratio(DSO_Config const *config)
+{
+    if (config->resolution != DSO_RESOLUTION_HIGH) {
+        return 1;
     }
 
-    // Validate mode and channels
-    if (config->mode != DSO_MODE_SINGLE_CHANNEL &&
-        config->mode != DSO_MODE_DUAL_CHANNEL) {
-        LOG_ERROR("DSO: Invalid mode: %d", config->mode);
-        return false;
+    uint64_t const max_rate =
+        (uint64_t)dso_adc_max_sample_rate(config->mode, DSO_RESOLUTION_12BIT);
+    uint32_t ratio = OVERSAMPLING_MAX;
+    while (ratio > OVERSAMPLING_MIN &&
+           (uint64_t)config->sample_rate * ratio > max_rate) {
+        ratio /= 2;
     }
+    return ratio;
+}
 
-    // Validate channel for single-channel mode
-    if (config->mode == DSO_MODE_SINGLE_CHANNEL) {
-        if (config->channel != DSO_CHANNEL_0 &&
-            config->channel != DSO_CHANNEL_1) {
-            LOG_ERROR("DSO: Invalid channel: %d", config->channel);
-            return false;
+/**
+ * @brief Right shift of the oversampled sums down to 15 bits
+ */
+static uint32_t dso_oversampling_shift(DSO_Config const *config)
+{
+    uint32_t shift = 0;
+    for (uint32_t ratio = dso_oversampling_ratio(config);
+         ratio > OVERSAMPLING_MIN;
+         ratio /= 2) {
+        ++shift;
+    }
+    return shift;
+}
+
+/**
+ * @brief Whether ADC samples are reduced before being stored
+ */
+static bool dso_decimating(DSO_Config const *config)
+{
+    return config->decimation != DSO_DECIMATION_NONE &&
+           config->decimation_factor > 1;
+}
+
+/**
+ * @brief Whether the ADC fills its buffer circularly for a configuration
+ */
+static bool dso_adc_circular(DSO_Config const *config)
+{
+    return config->continuous || config->trigger_mode != DSO_TRIGGER_NONE ||
+           dso_decimating(config);
+}
+
+/**
+ * @brief Number of samples per frame in the sample buffer
+ */
+static uint32_t dso_channels(DSO_Config const *config)
+{
+    switch (config->mode) {
+    case DSO_MODE_DUAL_CHANNEL:
+        return 2;
+    case DSO_MODE_QUAD_CHANNEL:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Rate at which the timer triggers ADC conversions
+ */
+static uint32_t dso_adc_sample_rate(DSO_Config const *config)
+{
+    if (dso_decimating(config)) {
+        return config->sample_rate * config->decimation_factor;
+    }
+    return config->sample_rate;
+}
+
+/**
+ * @brief Rate at which each ADC converts
+ *
+ * In single channel mode the two ADCs take turns, and in quad channel mode
+ * each ADC converts two channels per trigger, each of them ratio times in
+ * high resolution.
+ */
+static uint32_t dso_adc_conversion_rate(DSO_Config const *config)
+{
+    uint32_t const rate =
+        dso_adc_sample_rate(config) * dso_oversampling_ratio(config);
+    switch (config->mode) {
+    case DSO_MODE_SINGLE_CHANNEL:
+        return (rate + 1) / 2;
+    case DSO_MODE_QUAD_CHANNEL:
+        return rate * 2;
+    default:
+        return rate;
+    }
+}
+
+/**
+ * @brief Number of samples stored per decimation group
+ */
+static uint32_t decimation_output(DSO_Config const *config)
+{
+    uint32_t const frames = config->decimation == DSO_DECIMATION_PEAK ? 2 : 1;
+    return frames * dso_channels(config);
+}
+
+/**
+ * @brief Size of the circular DMA buffer used while decimating
+ *
+ * Each half holds a whole, even number of decimation groups, which keeps
+ * the buffer size a multiple of 4 as circular DMA requires.
+ */
+static uint32_t decimation_raw_size(DSO_Config const *config)
+{
+    uint32_t const group =
+        decimation_output(config) * config->decimation_factor;
+    uint32_t groups = DECIMATION_HALF_SAMPLES / group;
+
+    groups = groups < 2 ? 2 : groups & ~1U;
+    return 2 * group * groups;
+}
+
+/**
+ * @brief Number of trigger segments the buffer is split into
+ */
+static uint32_t segment_count(DSO_Config const *config)
+{
+    return config->segments > 1 ? config->segments : 1;
+}
+
+/**
+ * @brief Number of samples in each trigger segment
+ */
+static uint32_t segment_size(DSO_Handle const *handle)
+{
+    return handle->config.buffer_size / segment_count(&handle->config);
+}
+
+/**
+ * @brief Arm the analog watchdog for the current trigger stage
+ *
+ * The watchdog fires when a sample leaves its window, so waiting for the
+ * signal to be above the level uses the window [0, level] and waiting for
+ * it to be below uses [level, max]. The first stage of an edge trigger waits
+ * for the opposite side.
+ */
+static void trigger_arm(DSO_Handle *handle)
+{
+    DSO_TriggerMode const mode = handle->config.trigger_mode;
+    bool above = mode == DSO_TRIGGER_RISING || mode == DSO_TRIGGER_ABOVE;
+
+    if (handle->trigger_state == TRIGGER_WAIT_PRE) {
+        above = !above;
+    }
+
+    if (above) {
+        ADC_LL_arm_watchdog(0, handle->config.trigger_level);
+    } else {
+        ADC_LL_arm_watchdog(
+            handle->config.trigger_level, DSO_TRIGGER_LEVEL_MAX
+        );
+    }
+}
+
+/**
+ * @brief Start looking for the trigger condition
+ */
+static void trigger_begin(DSO_Handle *handle)
+{
+    DSO_TriggerMode const mode = handle->config.trigger_mode;
+    bool const edge = mode == DSO_TRIGGER_RISING || mode == DSO_TRIGGER_FALLING;
+
+    handle->trigger_state = edge ? TRIGGER_WAIT_PRE : TRIGGER_WAIT_EDGE;
+    trigger_arm(handle);
+}
+
+/**
+ * @brief Mark the acquisition stopped and release its clock request
+ *
+ * Called from the ADC interrupts when an acquisition completes, and from
+ * DSO_stop, which also drops a staged acquisition.
+ */
+static void dso_mark_stopped(DSO_Handle *handle)
+{
+    if (handle->running || handle->prepared) {
+        handle->running = false;
+        handle->prepared = false;
+        CLOCK_release();
+    }
+}
+
+/**
+ * @brief Add a ring of samples, oldest first, to the accumulator
+ *
+ * @param sums First sum to add to
+ * @param buffer Ring of size samples
+ * @param oldest Index of the oldest sample in the ring
+ * @param count Number of samples to add
+ */
+static void average_add(
+    uint32_t *sums,
+    uint16_t const *buffer,
+    uint32_t size,
+    uint32_t oldest,
+    uint32_t count
+)
+{
+    uint32_t const first = count < size - oldest ? count : size - oldest;
+
+    for (uint32_t i = 0; i < first; ++i) {
+        sums[i] += buffer[oldest + i];
+    }
+    for (uint32_t i = first; i < count; ++i) {
+        sums[i] += buffer[i - first];
+    }
+}
+
+/**
+ * @brief Write the rounded mean of the accumulated captures to the buffer
+ *
+ * Sample a holds the sum of the captures that lost at most a leading
+ * samples, so the shifts are sorted to count them in one pass.
+ */
+static void average_finish(DSO_Handle *handle)
+{
+    uint32_t const captures = handle->averages_acquired;
+    uint32_t *const shifts = handle->average_shift;
+    uint32_t const size = handle->config.buffer_size;
+    uint16_t *const buffer = handle->config.buffer;
+    uint32_t const *const sums = handle->config.accumulator;
+
+    for (uint32_t i = 1; i < captures; ++i) {
+        uint32_t const shift = shifts[i];
+        uint32_t j = i;
+        for (; j > 0 && shifts[j - 1] > shift; --j) {
+            shifts[j] = shifts[j - 1];
         }
+        shifts[j] = shift;
     }
 
-    // Validate sample rate (basic range check)
-    uint32_t max_sample_rate =
-        ADC_LL_get_max_sample_rate(dso_mode_to_adc_ll(config->mode));
-    if (config->sample_rate == 0 || config->sample_rate > max_sample_rate) {
-        LOG_ERROR("DSO: Invalid sample rate: %u", config->sample_rate);
-        return false;
+    uint32_t covered = 0;
+    for (uint32_t a = shifts[0]; a < size; ++a) {
+        while (covered < captures && shifts[covered] <= a) {
+            ++covered;
+        }
+        buffer[a] = (uint16_t)((sums[a] + (covered / 2)) / covered);
     }
 
-    return true;
+    // Samples that no capture reached repeat the first one that one did
+    for (uint32_t a = 0; a < shifts[0]; ++a) {
+        buffer[a] = buffer[shifts[0]];
+    }
 }
 
 /**
- * @brief Create ADC configuration for DSO based on mode
+ * @brief Finish one capture of an averaged record
+ *
+ * The timer is paused while the capture is added to the accumulator, with
+ * its trigger at index pretrigger. Until all captures are in, the DMA is
+ * then moved back to the start of the buffer and the trigger re-armed;
+ * after the last one, the buffer receives the mean.
+ *
+ * @param position Index of the oldest sample, where the DMA stopped
  */
-static ADC_LL_Config dso_create_adc_config(DSO_Handle *handle)
+static void average_complete(DSO_Handle *handle, uint32_t position)
 {
-    ADC_LL_Config adc_config = { .trigger_source = ADC_TRIGGER_TIMER6 };
+    uint32_t const size = handle->config.buffer_size;
+    uint32_t const capture = handle->averages_acquired;
+    // Post-trigger samples beyond those requested pushed out as many of
+    // the oldest ones
+    uint32_t const shift = (uint32_t)handle->trigger_post -
+                           (size - handle->config.pretrigger);
+
+    // New conversions would overwrite samples still to be added
+    TIM_LL_stop(handle->timer);
+
+    average_add(
+        handle->config.accumulator + shift,
+        handle->config.buffer,
+        size,
+        position,
+        size - shift
+    );
+    handle->average_shift[capture] = shift;
+    handle->averages_acquired = capture + 1;
+    if (capture == 0) {
+        handle->segment_info[0] = (DSO_Segment){
+            .trigger_index = handle->config.pretrigger,
+            .timestamp_us = handle->trigger_time_us - handle->start_time_us,
+        };
+    }
 
-    switch (handle->config.mode) {
-    case DSO_MODE_SINGLE_CHANNEL:
-        adc_config.channels[0] = dso_channel_to_adc_ll(handle->config.channel);
-        adc_config.channels[1] = dso_channel_to_adc_ll(handle->config.channel);
-        adc_config.mode =
-            ADC_LL_MODE_INTERLEAVED; // Use interleaved for higher sample rate
+    bool last = capture + 1 >= handle->config.averages;
+    if (!last &&
+        ADC_LL_try_restart(handle->config.buffer, size) != ERROR_NONE) {
+        last = true;
+    }
+
+    if (!last) {
+        handle->trigger_state = TRIGGER_FILLING;
+        handle->trigger_recorded = 0;
+        handle->trigger_post = 0;
+        if (handle->config.pretrigger == 0) {
+            trigger_begin(handle);
+        }
+        TIM_LL_start(handle->timer);
+        return;
+    }
+
+    ADC_LL_stop();
+    dso_mark_stopped(handle);
+    average_finish(handle);
+    handle->segments_acquired = 1;
+    handle->trigger_state = TRIGGER_DONE;
+
+    if (handle->config.complete_callback != nullptr) {
+        handle->config.complete_callback();
+    }
+}
+
+/**
+ * @brief Finish a triggered segment
+ *
+ * Stops acquisition into the segment at a half boundary and rotates it so
+ * that the oldest sample, which sits at the stop position, comes first. If
+ * more segments remain, the DMA is moved on to the next one first and the
+ * trigger re-armed; otherwise acquisition stops.
+ *
+ * @param position Segment index the DMA wraps to next (0 or half segment)
+ */
+static void trigger_complete(DSO_Handle *handle, uint32_t position)
+{
+    if (handle->config.averages > 1) {
+        average_complete(handle, position);
+        return;
+    }
+
+    uint32_t const size = segment_size(handle);
+    uint32_t const segment = handle->segments_acquired;
+    uint16_t *const buffer = handle->config.buffer + (segment * size);
+    bool last = segment + 1 >= segment_count(&handle->config);
+
+    // The timer keeps running; conversions go to the next segment. If the
+    // DMA cannot be moved on, the capture ends with this segment.
+    if (!last && ADC_LL_try_restart(buffer + size, size) != ERROR_NONE) {
+        last = true;
+    }
+    if (last) {
+        TIM_LL_stop(handle->timer);
+        ADC_LL_stop();
+        dso_mark_stopped(handle);
+    }
+
+    if (position != 0) {
+        // Stopping at the middle: swap the halves
+        for (uint32_t i = 0; i < position; ++i) {
+            uint16_t const sample = buffer[i];
+            buffer[i] = buffer[i + position];
+            buffer[i + position] = sample;
+        }
+    }
+
+    handle->segment_info[segment] = (DSO_Segment){
+        .trigger_index = (handle->trigger_position + size - position) % size,
+        .timestamp_us = handle->trigger_time_us - handle->start_time_us,
+    };
+    handle->segments_acquired = segment + 1;
+
+    if (!last) {
+        handle->trigger_state = TRIGGER_FILLING;
+        handle->trigger_recorded = 0;
+        handle->trigger_post = 0;
+        if (handle->config.pretrigger == 0) {
+            trigger_begin(handle);
+        }
+        return;
+    }
+
+    handle->trigger_state = TRIGGER_DONE;
+
+    if (handle->config.complete_callback != nullptr) {
+        handle->config.complete_callback();
+    }
+}
+
+/**
+ * @brief Advance a triggered capture at a segment half boundary
+ *
+ * @param position Segment index the DMA wraps to next (0 or half segment)
+ */
+static void trigger_boundary(DSO_Handle *handle, uint32_t position)
+{
+    uint32_t const half = segment_size(handle) / 2;
+    uint32_t const post = segment_size(handle) - handle->config.pretrigger;
+
+    switch (handle->trigger_state) {
+    case TRIGGER_FILLING:
+        handle->trigger_recorded += half;
+        if (handle->trigger_recorded >= handle->config.pretrigger) {
+            trigger_begin(handle);
+        }
+        break;
+    case TRIGGER_FIRED:
+        handle->trigger_post += (int32_t)half;
+        if (handle->trigger_post >= (int32_t)post) {
+            trigger_complete(handle, position);
+        }
+        break;
+    default:
         break;
+    }
+}
+
+/**
+ * @brief ADC analog watchdog callback for triggered DSO acquisition
+ *
+ * Called from interrupt context when the armed trigger stage fires.
+ */
+static void dso_adc_watchdog_callback(void)
+{
+    DSO_Handle *const handle = g_dso_handle;
+
+    if (handle == nullptr || !handle->running) {
+        return;
+    }
+
+    if (handle->trigger_state == TRIGGER_WAIT_PRE) {
+        handle->trigger_state = TRIGGER_WAIT_EDGE;
+        trigger_arm(handle);
+        return;
+    }
+
+    if (handle->trigger_state != TRIGGER_WAIT_EDGE) {
+        return;
+    }
+
+    uint32_t const half = segment_size(handle) / 2;
+    handle->trigger_position = ADC_LL_get_dma_position();
+    handle->trigger_time_us = PLATFORM_get_time_us();
+    // Counted up at each half boundary; the first one is partial
+    handle->trigger_post = -(int32_t)(handle->trigger_position % half);
+    handle->trigger_state = TRIGGER_FIRED;
+    SYNC_signal(SYNC_SOURCE_OSCILLOSCOPE);
+}
+
+/**
+ * @brief Correct the ADC2 samples of a completed block of a single-channel
+ * capture
+ *
+ * Every block passes here once, before it is reduced, lent or rotated.
+ */
+static void interleave_block(
+    DSO_Handle *handle,
+    uint16_t *block,
+    uint32_t samples
+)
+{
+    if (handle->interleave_active) {
+        INTERLEAVE_correct(
+            &handle->interleave,
+            block,
+            samples,
+            dso_sample_max(handle->config.resolution)
+        );
+    }
+}
+
+/**
+ * @brief Reduce a completed DMA half into the sample buffer
+ *
+ * Stops acquisition once the sample buffer is full.
+ */
+static void decimate_block(
+    DSO_Handle *handle,
+    uint16_t const *block,
+    uint32_t samples
+)
+{
+    DSO_Config const *const config = &handle->config;
+    uint32_t const factor = config->decimation_factor;
+    uint32_t const channels = dso_channels(config);
+    uint16_t *const out = config->buffer + handle->decimated;
+    uint32_t const limit = (config->buffer_size - handle->decimated) * factor;
+
+    if (!handle->running) {
+        return;
+    }
+
+    if (config->decimation == DSO_DECIMATION_FILTER) {
+        // The filter holds back its first outputs while it settles, so it
+        // is bounded by the room left rather than by the input
+        handle->decimated += DECIMATE_filter(
+            &handle->filter,
+            block,
+            samples,
+            out,
+            config->buffer_size - handle->decimated
+        );
+    } else {
+        if (samples > limit) {
+            samples = limit;
+        }
+        if (config->decimation == DSO_DECIMATION_PEAK) {
+            handle->decimated +=
+                DECIMATE_peak(block, samples, channels, factor, out);
+        } else {
+            handle->decimated +=
+                DECIMATE_average(block, samples, channels, factor, out);
+        }
+    }
+
+    if (handle->decimated < config->buffer_size) {
+        return;
+    }
+
+    TIM_LL_stop(handle->timer);
+    ADC_LL_stop();
+    dso_mark_stopped(handle);
+
+    if (config->complete_callback != nullptr) {
+        config->complete_callback();
+    }
+}
+
+/**
+ * @brief Lend a completed half of the continuous buffer to the consumer
+ *
+ * The half stays with the block callback's consumer until it is returned
+ * with DSO_release_block. If the half the DMA has just moved into is still
+ * lent, the timer is stopped so that it is not overwritten, and restarted
+ * when that half is returned. Conversions that completed while this
+ * interrupt was pending are already in that half, so at high sample rates
+ * its first samples may still change.
+ *
+ * @param handle Active DSO handle
+ * @param half Index of the completed half, 0 or 1
+ * @param block First sample of the completed half
+ * @param samples Number of samples in the half
+ */
+static void lend_block(
+    DSO_Handle *handle,
+    uint32_t half,
+    uint16_t const *block,
+    uint32_t samples
+)
+{
+    if (handle->config.block_callback == nullptr) {
+        return;
+    }
+
+    handle->leased[half] = block;
+    if (handle->leased[half ^ 1U] != nullptr) {
+        TIM_LL_stop(handle->timer);
+        handle->paused_half = half ^ 1U;
+        handle->paused = true;
+        handle->stream_pauses++;
+    }
+    handle->config.block_callback(block, samples);
+}
+
+/**
+ * @brief ADC completion callback for DSO
+ *
+ * Called when ADC data acquisition is complete.
+ */
+// NOLINTNEXTLINE(readability-non-const-parameter)
+static void adc_complete(uint16_t *buffer, uint32_t total_samples)
+{
+    if (g_dso_handle != nullptr) {
+        // A one-shot capture completes as a whole, of the configured size
+        interleave_block(
+            g_dso_handle,
+            buffer,
+            dso_adc_circular(&g_dso_handle->config)
+                ? total_samples
+                : g_dso_handle->config.buffer_size
+        );
+    }
+
+    if (g_dso_handle != nullptr && dso_decimating(&g_dso_handle->config)) {
+        // Second half is ready; the ADC keeps running into the first half
+        decimate_block(g_dso_handle, buffer, total_samples);
+        return;
+    }
+
+    if (g_dso_handle != nullptr && g_dso_handle->config.continuous) {
+        // Second half is ready; the ADC keeps running into the first half
+        g_dso_handle->wraps++;
+        lend_block(g_dso_handle, 1, buffer, total_samples);
+        return;
+    }
+
+    if (g_dso_handle != nullptr &&
+        g_dso_handle->config.trigger_mode != DSO_TRIGGER_NONE) {
+        // End of buffer; the ADC keeps running into the first half
+        trigger_boundary(g_dso_handle, 0);
+        return;
+    }
+
+    if (g_dso_handle != nullptr &&
+        g_dso_handle->config.complete_callback != nullptr) {
+        dso_mark_stopped(g_dso_handle);
+        TIM_LL_stop(g_dso_handle->timer);
+        g_dso_handle->config.complete_callback();
+    }
+}
+
+/**
+ * @brief ADC half-complete callback for continuous DSO acquisition
+ *
+ * Called when the first half of the buffer has been filled.
+ */
+// NOLINTNEXTLINE(readability-non-const-parameter)
+static void adc_half_complete(uint16_t *buffer, uint32_t samples)
+{
+    if (g_dso_handle != nullptr) {
+        interleave_block(g_dso_handle, buffer, samples);
+    }
+
+    if (g_dso_handle != nullptr && dso_decimating(&g_dso_handle->config)) {
+        decimate_block(g_dso_handle, buffer, samples);
+        return;
+    }
+
+    if (g_dso_handle != nullptr &&
+        g_dso_handle->config.trigger_mode != DSO_TRIGGER_NONE) {
+        trigger_boundary(g_dso_handle, samples);
+        return;
+    }
+
+    if (g_dso_handle != nullptr && g_dso_handle->config.continuous) {
+        lend_block(g_dso_handle, 0, buffer, samples);
+        return;
+    }
+
+    if (g_dso_handle != nullptr &&
+        g_dso_handle->config.block_callback != nullptr) {
+        g_dso_handle->config.block_callback(buffer, samples);
+    }
+}
+
+/**
+ * @brief Record a DMA interrupt in the trace, with its sample count
+ */
+static void trace_dma(TRACE_Event event, uint32_t samples)
+{
+    TRACE_record(event, samples > UINT16_MAX ? UINT16_MAX : (uint16_t)samples);
+}
+
+/**
+ * @brief ADC DMA complete interrupt callback, profiled and traced
+ */
+// NOLINTNEXTLINE(readability-non-const-parameter)
+static void dso_adc_complete_callback(uint16_t *buffer, uint32_t total_samples)
+{
+    PROFILE_BEGIN(PROFILE_ZONE_DSO_ISR);
+    trace_dma(TRACE_EVENT_DSO_DMA_COMPLETE, total_samples);
+    adc_complete(buffer, total_samples);
+    SCHEDULER_post(SCHEDULER_EVENT_DSO);
+    PROFILE_END(PROFILE_ZONE_DSO_ISR);
+}
+
+/**
+ * @brief ADC DMA half-complete interrupt callback, profiled and traced
+ */
+// NOLINTNEXTLINE(readability-non-const-parameter)
+static void dso_adc_half_complete_callback(uint16_t *buffer, uint32_t samples)
+{
+    PROFILE_BEGIN(PROFILE_ZONE_DSO_ISR);
+    trace_dma(TRACE_EVENT_DSO_DMA_HALF, samples);
+    adc_half_complete(buffer, samples);
+    SCHEDULER_post(SCHEDULER_EVENT_DSO);
+    PROFILE_END(PROFILE_ZONE_DSO_ISR);
+}
+
+/**
+ * @brief Validate DSO configuration
+ */
+static bool dso_validate_config(DSO_Config const *config)
+{
+    if (config == nullptr) {
+        LOG_ERROR("DSO: Configuration is NULL");
+        return false;
+    }
+
+    // Validate buffer
+    if (config->buffer == nullptr) {
+        LOG_ERROR("DSO: Buffer is NULL");
+        return false;
+    }
+
+    if (config->buffer_size == 0) {
+        LOG_ERROR("DSO: Buffer size is zero");
+        return false;
+    }
+
+    // Validate double-buffer requirements for continuous mode
+    if (config->continuous) {
+        if (config->buffer_size % 4 != 0) {
+            LOG_ERROR(
+                "DSO: Buffer size %u not a multiple of 4", config->buffer_size
+            );
+            return false;
+        }
+    }
+
+    // Validate trigger; triggered captures use a circular buffer as well
+    if (config->trigger_mode != DSO_TRIGGER_NONE) {
+        if (config->trigger_mode > DSO_TRIGGER_BELOW) {
+            LOG_ERROR("DSO: Invalid trigger mode: %d", config->trigger_mode);
+            return false;
+        }
+        if (config->continuous) {
+            LOG_ERROR("DSO: Trigger not supported in continuous mode");
+            return false;
+        }
+        if (config->buffer_size % 4 != 0) {
+            LOG_ERROR(
+                "DSO: Buffer size %u not a multiple of 4", config->buffer_size
+            );
+            return false;
+        }
+        if (config->trigger_level > DSO_TRIGGER_LEVEL_MAX) {
+            LOG_ERROR("DSO: Invalid trigger level: %u", config->trigger_level);
+            return false;
+        }
+        if (config->pretrigger >= config->buffer_size / segment_count(config)) {
+            LOG_ERROR("DSO: Pretrigger %u too large", config->pretrigger);
+            return false;
+        }
+    }
+
+    // Validate segments; each one is a circular trigger buffer of its own
+    if (segment_count(config) > 1) {
+        if (config->trigger_mode == DSO_TRIGGER_NONE) {
+            LOG_ERROR("DSO: Segmented capture requires a trigger");
+            return false;
+        }
+        if (config->segments > DSO_SEGMENTS_MAX) {
+            LOG_ERROR("DSO: Too many segments: %u", config->segments);
+            return false;
+        }
+        if (config->buffer_size % (4 * config->segments) != 0) {
+            LOG_ERROR(
+                "DSO: Buffer size %u not a multiple of 4 * %u segments",
+                config->buffer_size,
+                config->segments
+            );
+            return false;
+        }
+    }
+
+    // Validate averaging; captures are aligned on their triggers
+    if (config->averages != 1) {
+        if (config->averages == 0 || config->averages > DSO_AVERAGES_MAX) {
+            LOG_ERROR("DSO: Invalid average count: %u", config->averages);
+            return false;
+        }
+        if (config->trigger_mode == DSO_TRIGGER_NONE ||
+            segment_count(config) > 1) {
+            LOG_ERROR("DSO: Averaging requires a trigger and one segment");
+            return false;
+        }
+        if (config->accumulator == nullptr) {
+            LOG_ERROR("DSO: Averaging requires an accumulator");
+            return false;
+        }
+    }
+
+    // Validate decimation; the ADC runs circularly at a multiple of the rate
+    if (config->decimation != DSO_DECIMATION_NONE) {
+        if (config->decimation > DSO_DECIMATION_FILTER) {
+            LOG_ERROR("DSO: Invalid decimation: %d", config->decimation);
+            return false;
+        }
+        if (config->continuous || config->trigger_mode != DSO_TRIGGER_NONE) {
+            LOG_ERROR("DSO: Decimation requires an untriggered single shot");
+            return false;
+        }
+        if (config->decimation_factor > DSO_DECIMATION_FACTOR_MAX) {
+            LOG_ERROR(
+                "DSO: Invalid decimation factor: %u", config->decimation_factor
+            );
+            return false;
+        }
+        if (config->buffer_size % decimation_output(config) != 0) {
+            LOG_ERROR(
+                "DSO: Buffer size %u not a multiple of %u",
+                config->buffer_size,
+                decimation_output(config)
+            );
+            return false;
+        }
+        if (config->decimation == DSO_DECIMATION_FILTER &&
+            (config->decimation_factor < DECIMATE_FILTER_FACTOR_MIN ||
+             config->decimation_factor > DECIMATE_FILTER_FACTOR_MAX ||
+             config->decimation_factor % 2 != 0)) {
+            LOG_ERROR(
+                "DSO: Invalid filter decimation factor: %u",
+                config->decimation_factor
+            );
+            return false;
+        }
+        if (decimation_raw_size(config) > DECIMATION_RAW_MAX) {
+            LOG_ERROR(
+                "DSO: Decimation factor %u too large for mode %d",
+                config->decimation_factor,
+                config->mode
+            );
+            return false;
+        }
+    }
+
+    // Validate mode and channels
+    if (config->mode != DSO_MODE_SINGLE_CHANNEL &&
+        config->mode != DSO_MODE_DUAL_CHANNEL &&
+        config->mode != DSO_MODE_QUAD_CHANNEL) {
+        LOG_ERROR("DSO: Invalid mode: %d", config->mode);
+        return false;
+    }
+
+    // Validate channel for single-channel mode
+    if (config->mode == DSO_MODE_SINGLE_CHANNEL) {
+        if (config->channel != DSO_CHANNEL_0 &&
+            config->channel != DSO_CHANNEL_1) {
+            LOG_ERROR("DSO: Invalid channel: %d", config->channel);
+            return false;
+        }
+    }
+
+    // Each circular buffer half must hold whole four-channel frames
+    if (config->mode == DSO_MODE_QUAD_CHANNEL) {
+        bool const circular = config->continuous ||
+                              config->trigger_mode != DSO_TRIGGER_NONE;
+        uint32_t const frames = circular ? 2 : 1;
+        uint32_t const size = config->buffer_size / segment_count(config);
+        if (config->buffer_size % segment_count(config) != 0 ||
+            size % (frames * dso_channels(config)) != 0) {
+            LOG_ERROR(
+                "DSO: Buffer size %u not whole four-channel frames",
+                config->buffer_size
+            );
+            return false;
+        }
+    }
+
+    if (config->resolution != DSO_RESOLUTION_12BIT &&
+        config->resolution != DSO_RESOLUTION_10BIT &&
+        config->resolution != DSO_RESOLUTION_8BIT &&
+        config->resolution != DSO_RESOLUTION_HIGH) {
+        LOG_ERROR("DSO: Invalid resolution: %d", config->resolution);
+        return false;
+    }
+
+    // Trigger levels and decimation work on single conversions
+    if (config->resolution == DSO_RESOLUTION_HIGH &&
+        (config->trigger_mode != DSO_TRIGGER_NONE ||
+         config->decimation != DSO_DECIMATION_NONE)) {
+        LOG_ERROR("DSO: High resolution requires an untriggered capture");
+        return false;
+    }
+
+    // Validate sample rate (basic range check)
+    uint32_t max_sample_rate =
+        dso_adc_max_sample_rate(config->mode, config->resolution);
+    if (dso_decimating(config)) {
+        max_sample_rate /= config->decimation_factor;
+    }
+    if (config->sample_rate == 0 || config->sample_rate > max_sample_rate) {
+        LOG_ERROR("DSO: Invalid sample rate: %u", config->sample_rate);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Create ADC configuration for DSO based on mode
+ */
+static ADC_LL_Config dso_create_adc_config(DSO_Handle *handle)
+{
+    ADC_LL_Config adc_config = { 0 };
+
+    switch (handle->config.mode) {
+    case DSO_MODE_SINGLE_CHANNEL:
+        adc_config.channels[0] = dso_channel_to_adc_ll(handle->config.channel);
+        adc_config.channels[1] = dso_channel_to_adc_ll(handle->config.channel);
+        adc_config.mode =
+            ADC_LL_MODE_INTERLEAVED; // Use interleaved for higher sample rate
+        break;
+
+    case DSO_MODE_DUAL_CHANNEL:
+        adc_config.channels[0] = dso_channel_to_adc_ll(DSO_CHANNEL_0);
+        adc_config.channels[1] = dso_channel_to_adc_ll(DSO_CHANNEL_1);
+        adc_config.mode =
+            ADC_LL_MODE_SIMULTANEOUS; // Simultaneous for dual channel
+        break;
+
+    case DSO_MODE_QUAD_CHANNEL:
+        // Each ADC scans two channels; the DMA stores them in channel order
+        for (uint32_t i = 0; i < 4; ++i) {
+            adc_config.sequence[i] = dso_channel_to_adc_ll((DSO_Channel)i);
+        }
+        adc_config.sequence_length = 4;
+        adc_config.channels[0] = adc_config.sequence[0];
+        adc_config.channels[1] = adc_config.sequence[1];
+        adc_config.mode = ADC_LL_MODE_SIMULTANEOUS;
+        break;
+
+    default:
+        // This should not happen due to validation
+        adc_config.channels[0] = ADC_LL_CHANNEL_0;
+        adc_config.mode = ADC_LL_MODE_SINGLE;
+        break;
+    }
+
+    adc_config.trigger_source = ADC_LL_get_timer_trigger(handle->timer);
+    adc_config.output_buffer = handle->config.buffer;
+    adc_config.buffer_size = segment_size(handle);
+    adc_config.oversampling_ratio = dso_oversampling_ratio(&handle->config);
+    adc_config.oversampling_shift = dso_oversampling_shift(&handle->config);
+    adc_config.circular = dso_adc_circular(&handle->config);
+    adc_config.resolution = dso_resolution_to_adc_ll(handle->config.resolution);
+    adc_config.conversion_rate = dso_adc_conversion_rate(&handle->config);
+
+    if (dso_decimating(&handle->config)) {
+        adc_config.output_buffer = handle->raw_buffer;
+        adc_config.buffer_size = handle->raw_size;
+    }
+
+    return adc_config;
+}
+
+/**
+ * @brief Check whether a new configuration can keep the initialized ADC
+ *
+ * Everything ADC_LL_init applies must match, including the sampling time
+ * it chooses for the rate; only the output buffer and the timer rate may
+ * change.
+ */
+static bool dso_adc_compatible(
+    DSO_Config const *current,
+    DSO_Config const *next
+)
+{
+    if (current->mode != next->mode ||
+        current->resolution != next->resolution ||
+        dso_adc_circular(current) != dso_adc_circular(next) ||
+        dso_decimating(current) != dso_decimating(next)) {
+        return false;
+    }
+    if (current->mode == DSO_MODE_SINGLE_CHANNEL &&
+        current->channel != next->channel) {
+        return false;
+    }
+    if (dso_oversampling_ratio(current) != dso_oversampling_ratio(next) ||
+        DSO_get_sample_time_ns(current) != DSO_get_sample_time_ns(next)) {
+        return false;
+    }
+    // The decimation buffer was sized for the current configuration
+    return !dso_decimating(next) ||
+           decimation_raw_size(current) == decimation_raw_size(next);
+}
+
+/**
+ * @brief Initialize the DSO handle in its static storage
+ */
+static DSO_Handle *dso_create_handle(DSO_Config const *config)
+{
+    // Check if already initialized
+    if (g_dso_handle != nullptr) {
+        LOG_ERROR("DSO: Already initialized");
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    DSO_Handle *handle = &g_dso_storage;
+
+    // Claim a timer of our own so that other instruments can run alongside
+    Error error = ERROR_NONE;
+    TRY { handle->timer = TIM_LL_claim(); }
+    CATCH(error)
+    {
+        LOG_ERROR("DSO: No timer available");
+        THROW(error);
+    }
+
+    // Initialize handle
+    handle->config = *config;
+    handle->running = false;
+    handle->prepared = false;
+    handle->trigger_state = TRIGGER_FILLING;
+    handle->segments_acquired = 0;
+    handle->averages_acquired = 0;
+    handle->start_time_us = 0;
+    handle->interleave_active = false;
+    handle->written_seen = 0;
+    handle->errors_at_start = dso_adc_errors();
+    handle->raw_buffer = nullptr;
+    handle->raw_size = 0;
+    g_dso_handle = handle;
+
+    LOG_INFO(
+        "DSO: Init mode %d, sample_rate %u, buffer_size %u",
+        config->mode,
+        config->sample_rate,
+        config->buffer_size
+    );
+
+    return handle;
+}
+
+/**
+ * @brief Initialize ADC for DSO operation
+ */
+static void dso_init_adc(DSO_Handle *handle)
+{
+    LOG_FUNCTION_ENTRY();
+
+    // Set up ADC callback
+    ADC_LL_set_complete_callback(dso_adc_complete_callback);
+    ADC_LL_set_half_complete_callback(dso_adc_half_complete_callback);
+    ADC_LL_set_watchdog_callback(dso_adc_watchdog_callback);
+
+    // Decimation samples into a buffer of its own at the full ADC rate
+    handle->raw_buffer = nullptr;
+    handle->raw_size = 0;
+    if (dso_decimating(&handle->config)) {
+        handle->raw_buffer = g_dso_raw_buffer;
+        handle->raw_size = decimation_raw_size(&handle->config);
+    }
+
+    LOG_DEBUG("DSO: Configuring ADC");
+    ADC_LL_Config adc_config = dso_create_adc_config(handle);
+
+    LOG_DEBUG("DSO: Initializing ADC");
+    Error error = ERROR_NONE;
+    TRY
+    {
+        LOG_DEBUG("DSO: ADC_LL_init called");
+        ADC_LL_init(&adc_config);
+        LOG_DEBUG(
+            "DSO: ADC initialized, sampling time %u ns, oversampling %u",
+            ADC_LL_get_sample_time_ns(),
+            adc_config.oversampling_ratio
+        );
+    }
+    CATCH(error)
+    {
+        LOG_ERROR("DSO: ADC init failed, error %d", error);
+        g_dso_handle = nullptr;
+        TIM_LL_release(handle->timer);
+        THROW(error);
+    }
+    LOG_FUNCTION_EXIT();
+}
+
+/**
+ * @brief Store the sample rate the timer actually achieved
+ */
+static void dso_store_sample_rate(DSO_Handle *handle, uint32_t timer_rate)
+{
+    if (dso_decimating(&handle->config)) {
+        uint32_t const factor = handle->config.decimation_factor;
+        timer_rate = (timer_rate + (factor / 2)) / factor;
+    }
+    handle->config.sample_rate = timer_rate;
+}
+
+/**
+ * @brief Initialize timer for ADC triggering
+ */
+static void dso_init_timer(DSO_Handle *handle)
+{
+    LOG_FUNCTION_ENTRY();
+
+    uint32_t const rate = dso_adc_sample_rate(&handle->config);
+    uint32_t achieved = 0;
+
+    // The timer counts at the clock it was configured for, and acquisitions
+    // request the full clock, so configure it at that too
+    CLOCK_request();
+    Error error = ERROR_NONE;
+    TRY { achieved = TIM_LL_init(handle->timer, rate); }
+    CATCH(error)
+    {
+        CLOCK_release();
+        LOG_ERROR("DSO: Timer init failed, error %d", error);
+        ADC_LL_deinit();
+        g_dso_handle = nullptr;
+        TIM_LL_release(handle->timer);
+        THROW(error);
+    }
+    CLOCK_release();
+    LOG_DEBUG("DSO: Timer init, freq %u Hz (%u requested)", achieved, rate);
+
+    dso_store_sample_rate(handle, achieved);
+    LOG_FUNCTION_EXIT();
+}
+
+/**
+ * @brief Apply a compatible configuration to the initialized hardware
+ *
+ * Only retargets the ADC output buffer and retunes the timer, which takes
+ * microseconds instead of the full ADC init with its calibration. The old
+ * configuration, including its output buffer, is restored if the new buffer
+ * or rate cannot be set.
+ */
+static void dso_reconfigure(DSO_Handle *handle, DSO_Config const *config)
+{
+    DSO_Config const previous = handle->config;
+    handle->config = *config;
+
+    ADC_LL_Config const adc_config = dso_create_adc_config(handle);
+    uint32_t const rate = dso_adc_sample_rate(&handle->config);
+    uint32_t achieved = 0;
+
+    // At the full clock, like dso_init_timer
+    CLOCK_request();
+    Error error = ERROR_NONE;
+    TRY
+    {
+        ADC_LL_set_output_buffer(
+            adc_config.output_buffer, adc_config.buffer_size
+        );
+        achieved = TIM_LL_set_frequency(handle->timer, rate);
+    }
+    CATCH(error)
+    {
+        CLOCK_release();
+        LOG_ERROR("DSO: Reconfiguration failed, error %d", error);
+        handle->config = previous;
+        ADC_LL_Config const restored = dso_create_adc_config(handle);
+        ADC_LL_set_output_buffer(restored.output_buffer, restored.buffer_size);
+        THROW(error);
+    }
+    CLOCK_release();
+    LOG_DEBUG("DSO: Timer update, freq %u Hz (%u requested)", achieved, rate);
+
+    dso_store_sample_rate(handle, achieved);
+}
+
+// Public API Functions
+
+DSO_Handle *DSO_init(DSO_Config const *config)
+{
+    LOG_FUNCTION_ENTRY();
+
+    // Validate configuration
+    if (!dso_validate_config(config)) {
+        LOG_ERROR("DSO: Invalid configuration");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    // Create and initialize handle
+    DSO_Handle *handle = dso_create_handle(config);
+
+    // Initialize ADC
+    dso_init_adc(handle);
+
+    // Initialize timer
+    dso_init_timer(handle);
+
+    LOG_INFO("DSO: Successfully initialized");
+    LOG_FUNCTION_EXIT();
+    return handle;
+}
+
+void DSO_deinit(DSO_Handle *handle)
+{
+    LOG_FUNCTION_ENTRY();
+
+    if (handle == nullptr) {
+        LOG_WARN("DSO: Attempted to deinitialize NULL handle");
+        return;
+    }
+
+    if (handle != g_dso_handle) {
+        LOG_ERROR("DSO: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    Error error = ERROR_NONE;
+
+    TRY
+    {
+        // Stop if running or staged
+        if (handle->running || handle->prepared) {
+            DSO_stop(handle);
+        }
+
+        // Deinitialize hardware
+        LOG_DEBUG("DSO: Deinitializing ADC");
+        ADC_LL_deinit();
+
+        LOG_DEBUG("DSO: Deinitializing Timer");
+        TIM_LL_deinit(handle->timer);
+    }
+    CATCH(error)
+    {
+        LOG_ERROR("DSO: Deinitialization failed, error %d", error);
+        // Don't throw, continue with handle cleanup
+    }
+
+    // Release the timer, the handle storage is reused by the next DSO_init
+    TIM_LL_release(handle->timer);
+    handle->raw_buffer = nullptr;
+
+    // Clear global handle reference
+    g_dso_handle = nullptr;
+
+    LOG_FUNCTION_EXIT();
+}
+
+/**
+ * @brief Check a handle passed to the public API
+ *
+ * @return ERROR_NONE, or ERROR_INVALID_ARGUMENT
+ */
+static Error dso_check_handle(DSO_Handle const *handle)
+{
+    if (handle == nullptr) {
+        LOG_ERROR("DSO: Handle is NULL");
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    if (handle != g_dso_handle) {
+        LOG_ERROR("DSO: Invalid handle");
+        return ERROR_INVALID_ARGUMENT;
+    }
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Set up an acquisition up to the start of the timer
+ *
+ * Resets the capture state, and starts the ADC and its DMA, which then
+ * wait for the timer to trigger the first conversion.
+ *
+ * @return ERROR_NONE, or the error the ADC returned; nothing is left
+ *         started then
+ */
+static Error dso_stage(DSO_Handle *handle)
+{
+    handle->trigger_state = TRIGGER_FILLING;
+    handle->trigger_recorded = 0;
+    handle->trigger_post = 0;
+    handle->segments_acquired = 0;
+    handle->averages_acquired = 0;
+    if (handle->config.averages > 1) {
+        memset(
+            handle->config.accumulator,
+            0,
+            handle->config.buffer_size * sizeof(uint32_t)
+        );
+    }
+    handle->decimated = 0;
+    if (handle->config.decimation == DSO_DECIMATION_FILTER) {
+        DECIMATE_filter_init(
+            &handle->filter,
+            dso_channels(&handle->config),
+            handle->config.decimation_factor,
+            dso_sample_max(handle->config.resolution)
+        );
+    }
+    handle->interleave = dso_scale_interleave(
+        &g_interleave, DSO_RESOLUTION_12BIT, handle->config.resolution
+    );
+    // In a ring, samples can be read before their half is corrected
+    bool const ring =
+        handle->config.continuous && handle->config.block_callback == nullptr;
+    handle->interleave_active =
+        handle->config.mode == DSO_MODE_SINGLE_CHANNEL && !ring &&
+        (handle->interleave.gain != FIXED_ONE ||
+         handle->interleave.offset != 0);
+    handle->leased[0] = nullptr;
+    handle->leased[1] = nullptr;
+    handle->paused = false;
+    handle->stream_pauses = 0;
+    handle->wraps = 0;
+    handle->written_seen = 0;
+
+    // The timer was configured for the full clock, see dso_init_timer
+    CLOCK_request();
+
+    // Start ADC conversion first (DMA ready but not triggered)
+    LOG_DEBUG("DSO: Starting ADC...");
+    Error error = ERROR_NONE;
+    if (segment_count(&handle->config) > 1) {
+        // The previous capture left the DMA on the last segment
+        error = ADC_LL_try_restart(handle->config.buffer, segment_size(handle));
+    } else {
+        error = ADC_LL_try_start();
+    }
+    if (error != ERROR_NONE) {
+        ADC_LL_stop();
+        CLOCK_release();
+        return error;
+    }
+    LOG_DEBUG("DSO: ADC started successfully");
+
+    // Without pretrigger history the trigger can be armed right away
+    if (handle->config.trigger_mode != DSO_TRIGGER_NONE &&
+        handle->config.pretrigger == 0) {
+        trigger_begin(handle);
+    }
+
+    handle->prepared = true;
+    return ERROR_NONE;
+}
+
+Error DSO_try_prepare(DSO_Handle *handle)
+{
+    Error error = dso_check_handle(handle);
+    if (error != ERROR_NONE) {
+        return error;
+    }
+
+    if (handle->running) {
+        LOG_ERROR("DSO: Cannot prepare while running");
+        return ERROR_RESOURCE_BUSY;
+    }
+    if (handle->prepared) {
+        return ERROR_NONE;
+    }
+
+    error = dso_stage(handle);
+    if (error != ERROR_NONE) {
+        LOG_ERROR("DSO: Failed to prepare, error %d", error);
+    }
+    return error;
+}
+
+void DSO_prepare(DSO_Handle *handle)
+{
+    Error const error = DSO_try_prepare(handle);
+    if (error != ERROR_NONE) {
+        THROW(error);
+    }
+}
+
+Error DSO_try_start(DSO_Handle *handle)
+{
+    LOG_FUNCTION_ENTRY();
+
+    Error error = dso_check_handle(handle);
+    if (error != ERROR_NONE) {
+        return error;
+    }
+
+    if (handle->running) {
+        LOG_WARN("DSO: Already running");
+        return ERROR_NONE;
+    }
+
+    LOG_DEBUG("DSO: Starting data acquisition");
+
+    if (!handle->prepared) {
+        error = dso_stage(handle);
+        if (error != ERROR_NONE) {
+            LOG_ERROR("DSO: Failed to start, error %d", error);
+            return error;
+        }
+    }
+
+    // Times and error counts run from the start, not from the staging
+    handle->start_time_us = PLATFORM_get_time_us();
+    handle->errors_at_start = dso_adc_errors();
+
+    // Start timer to trigger ADC (must be after ADC is ready)
+    LOG_DEBUG("DSO: Starting Timer...");
+    error = TIM_LL_try_start(handle->timer);
+    if (error != ERROR_NONE) {
+        LOG_ERROR("DSO: Failed to start, error %d", error);
+        // Clean up partial state
+        TIM_LL_stop(handle->timer);
+        ADC_LL_stop();
+        dso_mark_stopped(handle);
+        return error;
+    }
+
+    LOG_DEBUG("DSO: Timer started successfully");
+    handle->prepared = false;
+    handle->running = true;
+    LOG_INFO("DSO: Data acquisition started");
+
+    LOG_FUNCTION_EXIT();
+    return ERROR_NONE;
+}
+
+void DSO_start(DSO_Handle *handle)
+{
+    Error const error = DSO_try_start(handle);
+    if (error != ERROR_NONE) {
+        THROW(error);
+    }
+}
+
+void DSO_stop(DSO_Handle *handle)
+{
+    LOG_FUNCTION_ENTRY();
+
+    if (handle == nullptr) {
+        LOG_ERROR("DSO: Handle is NULL");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (handle != g_dso_handle) {
+        LOG_ERROR("DSO: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (!handle->running && !handle->prepared) {
+        LOG_WARN("DSO: Already stopped");
+    }
 
-    case DSO_MODE_DUAL_CHANNEL:
-        adc_config.channels[0] = dso_channel_to_adc_ll(DSO_CHANNEL_0);
-        adc_config.channels[1] = dso_channel_to_adc_ll(DSO_CHANNEL_1);
-        adc_config.mode =
-            ADC_LL_MODE_SIMULTANEOUS; // Simultaneous for dual channel
-        break;
+    LOG_DEBUG("DSO: Stopping data acquisition");
 
-    default:
-        // This should not happen due to validation
-        adc_config.channels[0] = ADC_LL_CHANNEL_0;
-        adc_config.mode = ADC_LL_MODE_SINGLE;
-        break;
+    // Keep the final count of a ring for DSO_get_samples_written
+    if (handle->running && handle->config.continuous) {
+        (void)DSO_get_samples_written(handle);
     }
 
-    adc_config.trigger_source = ADC_TRIGGER_TIMER6;
-    adc_config.output_buffer = handle->config.buffer;
-    adc_config.buffer_size = handle->config.buffer_size;
-    adc_config.oversampling_ratio = 1; // No oversampling for oscilloscope
+    // Stop ADC and timer
+    ADC_LL_stop();
+    TIM_LL_stop(handle->timer);
+    handle->paused = false;
 
-    return adc_config;
+    dso_mark_stopped(handle);
+
+    LOG_INFO("DSO: Data acquisition stopped");
+    LOG_FUNCTION_EXIT();
 }
 
-/**
- * @brief Allocate and initialize DSO handle
- */
-static DSO_Handle *dso_create_handle(DSO_Config const *config)
+void DSO_release_block(DSO_Handle *handle, uint16_t const *block)
 {
-    // Check if already initialized
-    if (g_dso_handle != nullptr) {
-        LOG_ERROR("DSO: Already initialized");
-        THROW(ERROR_RESOURCE_BUSY);
+    if (handle == nullptr || handle != g_dso_handle) {
+        LOG_ERROR("DSO: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
     }
 
-    // Allocate handle
-    DSO_Handle *handle = (DSO_Handle *)malloc(sizeof(DSO_Handle));
-    if (handle == nullptr) {
-        LOG_ERROR("DSO: Memory allocation failed");
-        THROW(ERROR_OUT_OF_MEMORY);
+    uint32_t half = 0;
+    if (block != nullptr && block == handle->leased[1]) {
+        half = 1;
+    } else if (block == nullptr || block != handle->leased[0]) {
+        LOG_ERROR("DSO: Block is not lent");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    // The interrupts decide whether to pause from both leases
+    uint32_t const state = PLATFORM_disable_interrupts();
+    handle->leased[half] = nullptr;
+    bool const resume = handle->paused && handle->paused_half == half;
+    if (resume) {
+        handle->paused = false;
     }
+    PLATFORM_restore_interrupts(state);
 
-    LOG_DEBUG("DSO: Allocated handle at %p", (void *)handle);
+    if (resume) {
+        // Nothing converts while paused, so no interrupt can race this
+        TIM_LL_start(handle->timer);
+    }
+}
 
-    // Initialize handle
-    handle->config = *config;
-    handle->running = false;
-    g_dso_handle = handle;
+uint32_t DSO_get_samples_written(DSO_Handle *handle)
+{
+    if (handle == nullptr || handle != g_dso_handle) {
+        LOG_ERROR("DSO: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
 
-    LOG_INFO(
-        "DSO: Init mode %d, sample_rate %u, buffer_size %u",
-        config->mode,
-        config->sample_rate,
-        config->buffer_size
-    );
+    if (!handle->running || !handle->config.continuous) {
+        return handle->written_seen;
+    }
 
-    return handle;
+    // Retry if the DMA wrapped between reading the two
+    uint32_t wraps = 0;
+    uint32_t position = 0;
+    do {
+        wraps = handle->wraps;
+        position = ADC_LL_get_dma_position();
+    } while (wraps != handle->wraps);
+
+    uint32_t written = (wraps * handle->config.buffer_size) + position;
+    // The DMA may be past the end of the buffer before its interrupt has
+    // counted the wrap, which would make the count go back
+    if ((int32_t)(written - handle->written_seen) < 0) {
+        written += handle->config.buffer_size;
+    }
+    handle->written_seen = written;
+    return written;
 }
 
-/**
- * @brief Initialize ADC for DSO operation
- */
-static void dso_init_adc(DSO_Handle *handle)
+uint32_t DSO_get_trigger_index(DSO_Handle *handle)
 {
-    LOG_FUNCTION_ENTRY();
+    if (handle == nullptr) {
+        LOG_ERROR("DSO: Handle is NULL");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
 
-    // Set up ADC callback
-    ADC_LL_set_complete_callback(dso_adc_complete_callback);
+    if (handle != g_dso_handle) {
+        LOG_ERROR("DSO: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
 
-    LOG_DEBUG("DSO: Configuring ADC");
-    ADC_LL_Config adc_config = dso_create_adc_config(handle);
+    if (handle->trigger_state != TRIGGER_DONE) {
+        return 0;
+    }
+    return handle->segment_info[0].trigger_index;
+}
 
-    LOG_DEBUG("DSO: Initializing ADC");
-    Error error = ERROR_NONE;
-    TRY
-    {
-        LOG_DEBUG("DSO: ADC_LL_init called");
-        ADC_LL_init(&adc_config);
-        LOG_DEBUG("DSO: ADC initialized");
+uint32_t DSO_get_start_time_us(DSO_Handle *handle)
+{
+    if (handle == nullptr) {
+        LOG_ERROR("DSO: Handle is NULL");
+        THROW(ERROR_INVALID_ARGUMENT);
     }
-    CATCH(error)
-    {
-        LOG_ERROR("DSO: ADC init failed, error %d", error);
-        g_dso_handle = nullptr;
-        free(handle);
-        THROW(error);
+
+    if (handle != g_dso_handle) {
+        LOG_ERROR("DSO: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
     }
-    LOG_FUNCTION_EXIT();
+
+    return handle->start_time_us;
 }
 
-/**
- * @brief Initialize timer for ADC triggering
- */
-static void dso_init_timer(DSO_Handle *handle)
+uint32_t DSO_get_segments_acquired(DSO_Handle *handle)
 {
-    LOG_FUNCTION_ENTRY();
+    if (handle == nullptr) {
+        LOG_ERROR("DSO: Handle is NULL");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
 
-    Error error = ERROR_NONE;
-    TRY { TIM_LL_init(TIM_NUM_6, handle->config.sample_rate); }
-    CATCH(error)
-    {
-        LOG_ERROR("DSO: Timer init failed, error %d", error);
-        ADC_LL_deinit();
-        g_dso_handle = nullptr;
-        free(handle);
-        THROW(error);
+    if (handle != g_dso_handle) {
+        LOG_ERROR("DSO: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
     }
-    LOG_DEBUG("DSO: Timer init, freq %u Hz", handle->config.sample_rate);
-    LOG_FUNCTION_EXIT();
+
+    return handle->segments_acquired;
 }
 
-// Public API Functions
+uint32_t DSO_get_averages_acquired(DSO_Handle *handle)
+{
+    if (handle == nullptr || handle != g_dso_handle) {
+        LOG_ERROR("DSO: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
 
-DSO_Handle *DSO_init(DSO_Config const *config)
+    return handle->averages_acquired;
+}
+
+DSO_Segment DSO_get_segment(DSO_Handle *handle, uint32_t segment)
 {
-    LOG_FUNCTION_ENTRY();
+    if (segment >= DSO_get_segments_acquired(handle)) {
+        LOG_ERROR("DSO: Segment %u not acquired", segment);
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
 
-    // Validate configuration
-    if (!dso_validate_config(config)) {
-        LOG_ERROR("DSO: Invalid configuration");
+    return handle->segment_info[segment];
+}
+
+uint32_t DSO_get_equivalent_time(
+    DSO_Handle *handle,
+    uint32_t steps,
+    uint16_t *record,
+    uint32_t size
+)
+{
+    uint32_t const acquired = DSO_get_segments_acquired(handle);
+    DSO_Config const *config = &handle->config;
+
+    if (record == nullptr || size == 0) {
+        LOG_ERROR("DSO: Invalid equivalent-time record");
         THROW(ERROR_INVALID_ARGUMENT);
     }
 
-    // Create and initialize handle
-    DSO_Handle *handle = dso_create_handle(config);
+    if (steps < 2 || steps > DSO_ETS_STEPS_MAX) {
+        LOG_ERROR("DSO: Invalid equivalent-time steps: %u", steps);
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
 
-    // Initialize ADC
-    dso_init_adc(handle);
+    bool const edge = config->trigger_mode == DSO_TRIGGER_RISING ||
+                      config->trigger_mode == DSO_TRIGGER_FALLING;
+    if (config->mode != DSO_MODE_SINGLE_CHANNEL || !edge ||
+        dso_decimating(config) || handle->trigger_state != TRIGGER_DONE) {
+        LOG_ERROR("DSO: No edge-triggered single-channel capture");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
 
-    // Initialize timer
-    dso_init_timer(handle);
+    uint32_t const length = segment_size(handle);
+    // Trigger levels are on the 12-bit scale, samples on the capture's
+    uint16_t const level =
+        config->trigger_level >> dso_resolution_shift(config->resolution);
+    uint32_t const origin =
+        (uint32_t)(((uint64_t)config->pretrigger * size) / length);
+    uint32_t used = 0;
+
+    ETS_clear(record, size);
+    for (uint32_t s = 0; s < acquired; ++s) {
+        uint16_t const *samples = config->buffer + (s * length);
+        ETS_Crossing crossing;
+
+        // The watchdog fires after the crossing sample has been stored
+        if (!ETS_find_crossing(
+                samples,
+                length,
+                handle->segment_info[s].trigger_index,
+                level,
+                config->trigger_mode == DSO_TRIGGER_RISING,
+                steps,
+                &crossing
+            )) {
+            continue;
+        }
+        ETS_insert(samples, length, &crossing, steps, origin, record, size);
+        ++used;
+    }
+    ETS_fill_gaps(record, size);
 
-    LOG_INFO("DSO: Successfully initialized");
-    LOG_FUNCTION_EXIT();
-    return handle;
+    LOG_DEBUG("DSO: Equivalent-time record from %u segments", used);
+    return used;
 }
 
-void DSO_deinit(DSO_Handle *handle)
+void DSO_calibrate_interleave(DSO_Handle *handle)
 {
-    LOG_FUNCTION_ENTRY();
-
     if (handle == nullptr) {
-        LOG_WARN("DSO: Attempted to deinitialize NULL handle");
-        return;
+        LOG_ERROR("DSO: Handle is NULL");
+        THROW(ERROR_INVALID_ARGUMENT);
     }
 
     if (handle != g_dso_handle) {
@@ -298,44 +1901,66 @@ void DSO_deinit(DSO_Handle *handle)
         THROW(ERROR_INVALID_ARGUMENT);
     }
 
-    Error error = ERROR_NONE;
-
-    TRY
-    {
-        // Stop if running
-        if (handle->running) {
-            DSO_stop(handle);
-        }
-
-        // Deinitialize hardware
-        LOG_DEBUG("DSO: Deinitializing ADC");
-        ADC_LL_deinit();
-
-        LOG_DEBUG("DSO: Deinitializing Timer");
-        TIM_LL_deinit(TIM_NUM_6);
+    DSO_Config const *config = &handle->config;
+    if (config->mode != DSO_MODE_SINGLE_CHANNEL || dso_adc_circular(config) ||
+        segment_count(config) > 1 || handle->running) {
+        LOG_ERROR("DSO: No one-shot single-channel capture");
+        THROW(ERROR_INVALID_ARGUMENT);
     }
-    CATCH(error)
-    {
-        LOG_ERROR("DSO: Deinitialization failed, error %d", error);
-        // Don't throw, continue with handle cleanup
+
+    // The capture went through the correction in use, so what is left is
+    // the error of that correction
+    INTERLEAVE_Correction residual;
+    if (!INTERLEAVE_estimate(config->buffer, config->buffer_size, &residual)) {
+        LOG_ERROR("DSO: Interleave mismatch estimate failed");
+        THROW(ERROR_CALIBRATION_FAILED);
     }
 
-    // Free memory
-    LOG_DEBUG("DSO: Freeing handle at %p", (void *)handle);
-    free(handle);
+    INTERLEAVE_Correction const applied =
+        handle->interleave_active
+            ? handle->interleave
+            : (INTERLEAVE_Correction)INTERLEAVE_CORRECTION_IDENTITY;
+    INTERLEAVE_Correction const combined =
+        INTERLEAVE_combine(&applied, &residual);
+    g_interleave = dso_scale_interleave(
+        &combined, config->resolution, DSO_RESOLUTION_12BIT
+    );
+    LOG_INFO(
+        "DSO: Interleave gain %d, offset %d (Q16.16)",
+        g_interleave.gain,
+        g_interleave.offset
+    );
+}
 
-    // Clear global handle reference
-    g_dso_handle = nullptr;
+INTERLEAVE_Correction DSO_get_interleave(void) { return g_interleave; }
 
-    LOG_FUNCTION_EXIT();
+void DSO_reset_interleave(void)
+{
+    g_interleave = (INTERLEAVE_Correction)INTERLEAVE_CORRECTION_IDENTITY;
 }
 
-void DSO_start(DSO_Handle *handle)
+/**
+ * @brief Convert a measured time to a physical unit, saturating
+ *
+ * @param time Time in waveform units (fractions of a sample period)
+ * @param unit Divisions of a second in the result, e.g. SI_NANO_DIV
+ */
+static uint32_t dso_waveform_time(
+    DSO_Config const *config,
+    uint32_t time,
+    uint64_t unit
+)
 {
-    LOG_FUNCTION_ENTRY();
+    uint64_t const ticks = (uint64_t)config->sample_rate
+                           << WAVEFORM_TIME_FRAC_BITS;
+    uint64_t const result = ((time * unit) + (ticks / 2)) / ticks;
+    return result > UINT32_MAX ? UINT32_MAX : (uint32_t)result;
+}
 
-    if (handle == nullptr) {
-        LOG_ERROR("DSO: Handle is NULL");
+void DSO_measure(DSO_Handle *handle, uint32_t channel, DSO_Measurements *out)
+{
+    if (handle == nullptr || out == nullptr) {
+        LOG_ERROR("DSO: Handle or output is NULL");
         THROW(ERROR_INVALID_ARGUMENT);
     }
 
@@ -344,47 +1969,72 @@ void DSO_start(DSO_Handle *handle)
         THROW(ERROR_INVALID_ARGUMENT);
     }
 
+    DSO_Config const *config = &handle->config;
+    uint32_t const channels = dso_channels(config);
+    if (channel >= channels) {
+        LOG_ERROR("DSO: Channel %u not captured", channel);
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
     if (handle->running) {
-        LOG_WARN("DSO: Already running");
-        return;
+        LOG_ERROR("DSO: Cannot measure while running");
+        THROW(ERROR_RESOURCE_BUSY);
     }
 
-    LOG_DEBUG("DSO: Starting data acquisition");
+    // Alternating minimum and maximum frames are not one waveform
+    if (dso_decimating(config) && config->decimation == DSO_DECIMATION_PEAK) {
+        LOG_ERROR("DSO: Cannot measure a peak-detect capture");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
 
-    Error error = ERROR_NONE;
-    TRY
-    {
-        // Start ADC conversion first (DMA ready but not triggered)
-        LOG_DEBUG("DSO: Starting ADC...");
-        ADC_LL_start();
-        LOG_DEBUG("DSO: ADC started successfully");
+    uint32_t count = segment_size(handle) / channels;
+    if (count > WAVEFORM_SAMPLES_MAX) {
+        count = WAVEFORM_SAMPLES_MAX;
+    }
 
-        // Start timer to trigger ADC (must be after ADC is ready)
-        LOG_DEBUG("DSO: Starting Timer...");
-        TIM_LL_start(TIM_NUM_6);
-        LOG_DEBUG("DSO: Timer started successfully");
+    WAVEFORM_Measurements result;
+    WAVEFORM_measure(config->buffer + channel, count, channels, &result);
 
-        handle->running = true;
-        LOG_INFO("DSO: Data acquisition started");
-    }
-    CATCH(error)
-    {
-        LOG_ERROR("DSO: Failed to start, error %d", error);
-        // Clean up partial state
-        TIM_LL_stop(TIM_NUM_6);
-        ADC_LL_stop();
-        THROW(error);
+    uint16_t const max_code = dso_sample_max(config->resolution);
+    int32_t const scale = FIXED_code_scale(
+        (int32_t)ADC_LL_get_reference_voltage(), max_code
+    );
+    FIXED_Q1616 const swing = FIXED_from_int(result.max - result.min);
+
+    *out = (DSO_Measurements){
+        .peak_to_peak_mv = (uint32_t)FIXED_scale_code(swing, scale),
+        .mean_mv = (uint32_t)FIXED_scale_code(result.mean, scale),
+        .rms_mv = (uint32_t)FIXED_scale_code(result.rms, scale),
+        .rise_time_ns =
+            dso_waveform_time(config, result.rise_time, SI_NANO_DIV),
+    };
+
+    if (result.period > 0) {
+        uint64_t const cycles_mhz =
+            ((uint64_t)config->sample_rate * SI_MILLI_DIV)
+            << WAVEFORM_TIME_FRAC_BITS;
+        uint64_t const frequency =
+            (cycles_mhz + (result.period / 2)) / result.period;
+        out->frequency_mhz =
+            frequency > UINT32_MAX ? UINT32_MAX : (uint32_t)frequency;
+        out->period_ns = dso_waveform_time(config, result.period, SI_NANO_DIV);
+        out->duty_cycle_permille = (uint32_t)(
+            (((int64_t)result.duty_cycle * SI_KILO_INT) + (FIXED_SCALE / 2)) /
+            FIXED_SCALE
+        );
     }
-
-    LOG_FUNCTION_EXIT();
 }
 
-void DSO_stop(DSO_Handle *handle)
+void DSO_get_spectrum(
+    DSO_Handle *handle,
+    uint32_t channel,
+    uint32_t size,
+    int32_t *work,
+    FIXED_Q1616 *bins
+)
 {
-    LOG_FUNCTION_ENTRY();
-
-    if (handle == nullptr) {
-        LOG_ERROR("DSO: Handle is NULL");
+    if (handle == nullptr || work == nullptr || bins == nullptr) {
+        LOG_ERROR("DSO: Handle or buffer is NULL");
         THROW(ERROR_INVALID_ARGUMENT);
     }
 
@@ -393,20 +2043,25 @@ void DSO_stop(DSO_Handle *handle)
         THROW(ERROR_INVALID_ARGUMENT);
     }
 
-    if (!handle->running) {
-        LOG_WARN("DSO: Already stopped");
+    DSO_Config const *config = &handle->config;
+    uint32_t const channels = dso_channels(config);
+    if (channel >= channels) {
+        LOG_ERROR("DSO: Channel %u not captured", channel);
+        THROW(ERROR_INVALID_ARGUMENT);
     }
 
-    LOG_DEBUG("DSO: Stopping data acquisition");
-
-    // Stop ADC and timer
-    ADC_LL_stop();
-    TIM_LL_stop(TIM_NUM_6);
-
-    handle->running = false;
+    if (handle->running) {
+        LOG_ERROR("DSO: Cannot transform while running");
+        THROW(ERROR_RESOURCE_BUSY);
+    }
 
-    LOG_INFO("DSO: Data acquisition stopped");
-    LOG_FUNCTION_EXIT();
+    if (size > segment_size(handle) / channels ||
+        !SPECTRUM_compute(
+            config->buffer + channel, size, channels, work, bins
+        )) {
+        LOG_ERROR("DSO: Invalid FFT size %u", size);
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
 }
 
 DSO_Config DSO_get_config(DSO_Handle *handle)
@@ -453,15 +2108,28 @@ void DSO_set_config(DSO_Handle *handle, DSO_Config const *config)
         THROW(ERROR_INVALID_ARGUMENT);
     }
 
+    // A staged acquisition was set up for the old configuration
+    if (handle->prepared) {
+        DSO_stop(handle);
+    }
+
     LOG_DEBUG("DSO: Updating configuration");
 
+    // Timebase and record length changes keep the ADC as initialized
+    if (dso_adc_compatible(&handle->config, config)) {
+        dso_reconfigure(handle, config);
+        LOG_INFO("DSO: Configuration updated without ADC reinit");
+        LOG_FUNCTION_EXIT();
+        return;
+    }
+
     Error error = ERROR_NONE;
     TRY
     {
         // Deinitialize current hardware configuration
         LOG_DEBUG("DSO: Deinitializing current hardware");
         ADC_LL_deinit();
-        TIM_LL_deinit(TIM_NUM_6);
+        TIM_LL_deinit(handle->timer);
 
         // Update configuration
         handle->config = *config;
@@ -482,12 +2150,11 @@ void DSO_set_config(DSO_Handle *handle, DSO_Config const *config)
     LOG_FUNCTION_EXIT();
 }
 
-uint32_t DSO_get_max_sample_rate(DSO_Mode mode)
+uint32_t DSO_get_max_sample_rate(DSO_Mode mode, DSO_Resolution resolution)
 {
     LOG_FUNCTION_ENTRY();
 
-    ADC_LL_Mode adc_mode = dso_mode_to_adc_ll(mode);
-    uint32_t max_rate = ADC_LL_get_max_sample_rate(adc_mode);
+    uint32_t max_rate = dso_adc_max_sample_rate(mode, resolution);
 
     LOG_DEBUG("DSO: Max sample rate for mode %d: %u Hz", mode, max_rate);
     LOG_FUNCTION_EXIT();
@@ -495,6 +2162,25 @@ uint32_t DSO_get_max_sample_rate(DSO_Mode mode)
     return max_rate;
 }
 
+uint32_t DSO_get_sample_time_ns(DSO_Config const *config)
+{
+    if (config == nullptr) {
+        LOG_ERROR("DSO: Config is NULL");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    return ADC_LL_select_sample_time_ns(
+        dso_mode_to_adc_ll(config->mode),
+        dso_resolution_to_adc_ll(config->resolution),
+        dso_adc_conversion_rate(config)
+    );
+}
+
+uint32_t DSO_get_reference_voltage(void)
+{
+    return ADC_LL_get_reference_voltage();
+}
+
 bool DSO_is_acquisition_in_progress(DSO_Handle *handle)
 {
     if (handle == nullptr) {
@@ -509,3 +2195,28 @@ bool DSO_is_acquisition_in_progress(DSO_Handle *handle)
 
     return handle->running;
 }
+
+DSO_Diagnostics DSO_get_diagnostics(DSO_Handle *handle)
+{
+    if (handle != nullptr && handle != g_dso_handle) {
+        LOG_ERROR("DSO: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    ADC_LL_ErrorCounters const counters = ADC_LL_get_error_counters();
+    DSO_Diagnostics diagnostics = {
+        .adc_overruns = counters.overruns,
+        .dma_errors = counters.dma_errors,
+        .stream_pauses = 0,
+        .capture_affected = false,
+    };
+
+    // The ADC only converts for the DSO while a capture runs, so any error
+    // since the start belongs to the current or last capture
+    if (handle != nullptr) {
+        diagnostics.capture_affected =
+            counters.overruns + counters.dma_errors != handle->errors_at_start;
+        diagnostics.stream_pauses = handle->stream_pauses;
+    }
+    return diagnostics;
+}
@@ -3,8 +3,8 @@
  * @brief Digital Storage Oscilloscope interface for PSLab firmware
  *
  * This header provides a simple digital storage oscilloscope implementation
- * using the ADC_LL API in continuous sampling mode, in either dual-channel or
- * interleaved mode.
+ * using the ADC_LL API in continuous sampling mode, in interleaved,
+ * dual-channel or four-channel mode.
  *
  * @author PSLab Team
  * @date 2025-09-29
@@ -15,6 +15,10 @@
 
 #include <stdint.h>
 
+#include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/interleave.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -31,18 +35,141 @@ typedef struct DSO_Handle DSO_Handle;
  * hiding the low-level ADC_LL_Channel implementation details.
  *
  * Since the oscilloscope functionality is tightly tied to the analog
- * front-end present on specific pins, only two channels are available.
+ * front-end present on specific pins, only four channels are available.
+ * Channels 2 and 3 can only be captured in four-channel mode.
  */
 typedef enum {
     DSO_CHANNEL_0 = 0,
     DSO_CHANNEL_1 = 1,
+    DSO_CHANNEL_2 = 2,
+    DSO_CHANNEL_3 = 3,
 } DSO_Channel;
 
+/**
+ * @brief DSO acquisition mode
+ *
+ * Single-channel mode interleaves ADC1 and ADC2 on one channel. Dual-channel
+ * mode samples channels 0 and 1 simultaneously. Four-channel mode scans two
+ * channels on each ADC, ADC1 converting channels 0 and 2 while ADC2
+ * converts channels 1 and 3, which halves the maximum sample rate. Samples
+ * are stored in frames of one sample per channel, in channel order.
+ *
+ * In four-channel mode each buffer half (or segment half) must hold whole
+ * frames, and the decimation factor is limited to half of
+ * DSO_DECIMATION_FACTOR_MAX.
+ */
 typedef enum {
     DSO_MODE_SINGLE_CHANNEL,
     DSO_MODE_DUAL_CHANNEL,
+    DSO_MODE_QUAD_CHANNEL,
 } DSO_Mode;
 
+/**
+ * @brief DSO trigger condition
+ *
+ * Edge triggers fire when the signal crosses the trigger level in the given
+ * direction; it must first be seen on the other side of the level. Level
+ * triggers fire as soon as the signal is above or below the trigger level.
+ */
+typedef enum {
+    DSO_TRIGGER_NONE, /**< Free-running: capture starts immediately */
+    DSO_TRIGGER_RISING, /**< Signal rises above the level */
+    DSO_TRIGGER_FALLING, /**< Signal falls below the level */
+    DSO_TRIGGER_ABOVE, /**< Signal is above the level */
+    DSO_TRIGGER_BELOW, /**< Signal is below the level */
+} DSO_TriggerMode;
+
+/**
+ * @brief DSO decimation method
+ *
+ * When decimating, the ADC runs at sample_rate * decimation_factor and each
+ * DMA half is reduced into the sample buffer as it completes. See
+ * util/decimate.h for the output layout.
+ *
+ * Filtering low-passes the ADC samples below half of sample_rate before
+ * decimating, so that content above it does not alias into the record; it
+ * takes an even decimation_factor from DECIMATE_FILTER_FACTOR_MIN to
+ * DECIMATE_FILTER_FACTOR_MAX. The record starts about 25 samples after
+ * the acquisition, once the filter has settled.
+ */
+typedef enum {
+    DSO_DECIMATION_NONE, /**< Store every sample */
+    DSO_DECIMATION_PEAK, /**< Store (min, max) pairs for glitch capture */
+    DSO_DECIMATION_AVERAGE, /**< Store box-car averages */
+    DSO_DECIMATION_FILTER, /**< Store anti-aliased CIC and FIR output */
+} DSO_Decimation;
+
+/**
+ * @brief DSO sample resolution
+ *
+ * Lower resolutions raise the maximum sample rate. Samples keep their raw
+ * scale, so an 8-bit sample ranges from 0 to 255; trigger levels stay on
+ * the 12-bit scale.
+ *
+ * High resolution sums 8 to 256 12-bit conversions per sample in the ADC,
+ * as many as the sample rate leaves time for, into 15-bit samples from 0
+ * to DSO_SAMPLE_MAX_HIGH. It reduces noise at no CPU cost, but lowers the
+ * maximum sample rate eightfold and cannot be combined with a trigger or
+ * decimation.
+ */
+typedef enum {
+    DSO_RESOLUTION_12BIT, /**< 12-bit samples (default) */
+    DSO_RESOLUTION_10BIT, /**< 10-bit samples */
+    DSO_RESOLUTION_8BIT, /**< 8-bit samples */
+    DSO_RESOLUTION_HIGH, /**< 15-bit oversampled samples */
+} DSO_Resolution;
+
+enum {
+    /** @brief Largest sample value (12-bit ADC full scale) */
+    DSO_SAMPLE_MAX = 4095,
+    /** @brief Largest sample value in high resolution (8 full-scale sums) */
+    DSO_SAMPLE_MAX_HIGH = 8 * DSO_SAMPLE_MAX,
+    /** @brief Largest trigger level (12-bit ADC full scale) */
+    DSO_TRIGGER_LEVEL_MAX = 4095,
+    /** @brief Largest number of segments in a segmented capture */
+    DSO_SEGMENTS_MAX = 64,
+    /** @brief Largest number of captures averaged into one record */
+    DSO_AVERAGES_MAX = 256,
+    /** @brief Largest number of ADC samples reduced to one stored sample */
+    DSO_DECIMATION_FACTOR_MAX = 256,
+    /** @brief Largest equivalent-time points per sample period */
+    DSO_ETS_STEPS_MAX = 64,
+};
+
+/**
+ * @brief Trigger record of one segment of a capture
+ */
+typedef struct {
+    uint32_t trigger_index; /**< Trigger position within the segment */
+    uint32_t timestamp_us; /**< Trigger time since DSO_start in µs */
+} DSO_Segment;
+
+/**
+ * @brief Data integrity of DSO acquisitions
+ */
+typedef struct {
+    uint32_t adc_overruns; /**< ADC overruns since startup */
+    uint32_t dma_errors; /**< ADC DMA transfer errors since startup */
+    uint32_t stream_pauses; /**< Continuous mode pauses of the capture */
+    bool capture_affected; /**< An error hit the current or last capture */
+} DSO_Diagnostics;
+
+/**
+ * @brief Scalar measurements of one channel of a capture
+ *
+ * Timing results are 0 when the capture holds no complete cycle of the
+ * signal. See waveform.h for how edges are found.
+ */
+typedef struct {
+    uint32_t peak_to_peak_mv; /**< Maximum minus minimum */
+    uint32_t mean_mv; /**< Mean voltage */
+    uint32_t rms_mv; /**< Root mean square voltage */
+    uint32_t frequency_mhz; /**< Signal frequency in mHz */
+    uint32_t period_ns; /**< Signal period */
+    uint32_t rise_time_ns; /**< Mean 10% to 90% rise time */
+    uint32_t duty_cycle_permille; /**< Share of each cycle spent high */
+} DSO_Measurements;
+
 /**
  * @brief DSO completion callback type
  *
@@ -50,17 +177,45 @@ typedef enum {
  */
 typedef void (*DSO_CompleteCallback)(void);
 
+/**
+ * @brief DSO block callback type
+ *
+ * In continuous mode, this callback is invoked from interrupt context each
+ * time one half of the sample buffer has been filled. The block is lent to
+ * the consumer, which can send it in place and must return it with
+ * DSO_release_block. If the DMA reaches a half that is still lent,
+ * acquisition pauses until it is returned, leaving a gap in the samples
+ * that is counted in DSO_Diagnostics::stream_pauses.
+ *
+ * @param block Pointer to the first sample of the completed half
+ * @param samples Number of samples in the block
+ */
+typedef void (*DSO_BlockCallback)(uint16_t const *block, uint32_t samples);
+
 /**
  * @brief DSO configuration structure
  */
 typedef struct {
-    DSO_Mode mode; /**< Dual-channel or interleaved mode */
+    DSO_Mode mode; /**< Interleaved, dual-channel or four-channel mode */
     DSO_Channel channel; /**< Input channel for interleaved mode */
-    uint32_t sample_rate; /**< Sample rate in Hz */
+    uint32_t sample_rate; /**< Stored sample rate in Hz */
     uint16_t *buffer; /**< Pointer to the buffer for storing samples */
     uint32_t buffer_size; /**< Size of the buffer */
     DSO_CompleteCallback
         complete_callback; /**< Callback invoked on completion */
+    bool continuous; /**< Acquire continuously into a double buffer */
+    /** Callback invoked per half (continuous mode); without one, the
+     *  buffer is overwritten in a ring, see DSO_get_samples_written */
+    DSO_BlockCallback block_callback;
+    DSO_TriggerMode trigger_mode; /**< Trigger condition (one-shot mode) */
+    uint16_t trigger_level; /**< Trigger level in raw ADC counts */
+    uint32_t pretrigger; /**< Samples to keep from before each trigger */
+    uint32_t segments; /**< Equal buffer segments, one per trigger */
+    uint32_t averages; /**< Triggered captures averaged into the record */
+    uint32_t *accumulator; /**< buffer_size sums, if averaging */
+    DSO_Decimation decimation; /**< Reduction of ADC samples (one-shot) */
+    uint32_t decimation_factor; /**< ADC samples per stored sample */
+    DSO_Resolution resolution; /**< ADC conversion resolution */
 } DSO_Config;
 
 /**
@@ -70,7 +225,11 @@ typedef struct {
     {                                                                          \
         .mode = DSO_MODE_SINGLE_CHANNEL, .channel = DSO_CHANNEL_0,             \
         .sample_rate = 1000000, .buffer = nullptr, .buffer_size = 256,         \
-        .complete_callback = nullptr,                                          \
+        .complete_callback = nullptr, .continuous = false,                     \
+        .block_callback = nullptr, .trigger_mode = DSO_TRIGGER_NONE,           \
+        .trigger_level = 0, .pretrigger = 0, .segments = 1, .averages = 1,     \
+        .accumulator = nullptr, .decimation = DSO_DECIMATION_NONE,             \
+        .decimation_factor = 1, .resolution = DSO_RESOLUTION_12BIT,            \
     }
 
 /**
@@ -84,7 +243,7 @@ typedef struct {
  * @return Pointer to DSO handle on success, NULL on failure
  *
  * @throws ERROR_INVALID_ARGUMENT if config is NULL or contains invalid values
- * @throws ERROR_OUT_OF_MEMORY if memory allocation fails
+ * @throws ERROR_RESOURCE_BUSY if the ADC is owned by another instrument
  * @throws ERROR_HARDWARE_FAULT if ADC initialization fails
  */
 DSO_Handle *DSO_init(DSO_Config const *config);
@@ -93,8 +252,9 @@ DSO_Handle *DSO_init(DSO_Config const *config);
  * @brief Deinitialize the Oscilloscope
  *
  * This function deinitializes the DSO subsystem, releases hardware resources,
- * and frees the handle memory. The handle becomes invalid after this call;
- * reusing it without reinitialization causes undefined behavior.
+ * and releases the statically allocated handle. The handle becomes invalid
+ * after this call; reusing it without reinitialization causes undefined
+ * behavior.
  *
  * @param handle Pointer to DSO handle to deinitialize
  */
@@ -105,7 +265,37 @@ void DSO_deinit(DSO_Handle *handle);
  *
  * This function starts the DSO data acquisition process. It starts the timer
  * with the configured sample rate, triggering the ADC to capture data until
- * the buffer is full.
+ * the buffer is full. In continuous mode, the buffer is used as a double
+ * buffer and acquisition runs until DSO_stop is called.
+ *
+ * With a trigger configured, the buffer is filled circularly and the analog
+ * watchdog is armed once the pretrigger history has been recorded. After the
+ * trigger fires, acquisition stops at the next buffer half boundary that
+ * leaves at least buffer_size - pretrigger samples after the trigger. The
+ * buffer is then rotated so that it starts with the oldest sample, and the
+ * completion callback is invoked. See DSO_get_trigger_index.
+ *
+ * With more than one segment, the buffer is split into equal segments that
+ * are each captured as above, with buffer_size / segments in place of the
+ * buffer size. When a segment completes, the DMA is retargeted to the next
+ * one and the trigger re-armed from interrupt context while the timer keeps
+ * running, so back-to-back events are captured without host involvement.
+ * The completion callback is invoked after the last segment. See
+ * DSO_get_segment.
+ *
+ * With more than one average, the triggered capture is repeated that many
+ * times and each capture added to the accumulator from interrupt context,
+ * aligned on its trigger, while the timer is paused. The buffer then holds
+ * the rounded mean, with the trigger at index pretrigger. Leading samples
+ * that a capture lost to the half boundary stop are averaged over the
+ * captures that have them; any that none has repeat the first sample that
+ * one has. Averaging needs a trigger and a single segment.
+ *
+ * With decimation, the ADC samples into an internal circular buffer at
+ * sample_rate * decimation_factor. Each half of it is reduced into the
+ * sample buffer from interrupt context, and acquisition stops once the
+ * sample buffer is full. Decimation cannot be combined with continuous
+ * mode or triggers.
  *
  * @param handle Pointer to DSO handle
  *
@@ -114,6 +304,46 @@ void DSO_deinit(DSO_Handle *handle);
  */
 void DSO_start(DSO_Handle *handle);
 
+/**
+ * @brief Start the Oscilloscope, returning failures instead of throwing
+ *
+ * Same as DSO_start, for callers that start a capture per command and
+ * would otherwise need a TRY block for it.
+ *
+ * @param handle Pointer to DSO handle
+ * @return ERROR_NONE, or the error DSO_start would throw
+ */
+Error DSO_try_start(DSO_Handle *handle);
+
+/**
+ * @brief Stage the next acquisition, so that starting it is quick
+ *
+ * Does all of DSO_start but the start of the timer: the capture state is
+ * reset and the ADC and its DMA are started, waiting for the first timer
+ * trigger. DSO_start then only has to start the timer, a few register
+ * writes, instead of going through the HAL start of the ADC and its DMA.
+ * Meant for single-shot captures repeated on events, staged while waiting
+ * for the next one.
+ *
+ * A staged acquisition holds the full clock, like a running one. DSO_stop
+ * and DSO_deinit drop it, and DSO_set_config drops it before applying the
+ * new configuration. Staging a staged acquisition does nothing.
+ *
+ * @param handle Pointer to DSO handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL
+ * @throws ERROR_RESOURCE_BUSY if the acquisition is running
+ */
+void DSO_prepare(DSO_Handle *handle);
+
+/**
+ * @brief Stage the next acquisition, returning failures instead of throwing
+ *
+ * @param handle Pointer to DSO handle
+ * @return ERROR_NONE, or the error DSO_prepare would throw
+ */
+Error DSO_try_prepare(DSO_Handle *handle);
+
 /**
  * @brief Stop the Oscilloscope
  *
@@ -127,10 +357,238 @@ void DSO_start(DSO_Handle *handle);
  */
 void DSO_stop(DSO_Handle *handle);
 
+/**
+ * @brief Return a block lent by the block callback
+ *
+ * Hands a completed half of the continuous buffer back to the DSO once its
+ * samples have been consumed, and resumes acquisition if it was paused
+ * waiting for that half.
+ *
+ * @param handle Pointer to DSO handle
+ * @param block Block pointer passed to the block callback
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is not the active DSO handle or
+ *         block is not lent
+ */
+void DSO_release_block(DSO_Handle *handle, uint16_t const *block);
+
+/**
+ * @brief Count the samples written in continuous mode
+ *
+ * Without a block callback, continuous acquisition keeps overwriting the
+ * buffer in a ring, starting at index 0. The difference between two counts
+ * is the number of samples written in between, by which the write index
+ * has advanced around the ring; a sample stays in place until buffer_size
+ * more have been written. The count wraps at 2^32, so only differences are
+ * meaningful.
+ *
+ * The ADC1/ADC2 mismatch correction is not applied in this mode, since
+ * samples can be read before their buffer half completes.
+ *
+ * @param handle Pointer to DSO handle
+ * @return Samples written since acquisition started, frames of all
+ *         channels counted sample by sample
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is not the active DSO handle
+ */
+uint32_t DSO_get_samples_written(DSO_Handle *handle);
+
+/**
+ * @brief Get the position of the trigger in the last capture
+ *
+ * Because acquisition stops on a buffer half boundary, up to half a buffer
+ * more post-trigger samples than requested may be recorded, which leaves
+ * correspondingly fewer pretrigger samples.
+ *
+ * @param handle Pointer to DSO handle
+ * @return Index in the buffer of the first sample after the trigger fired,
+ *         or 0 if no trigger is configured or the capture is incomplete. For
+ *         segmented captures this is the index within the first segment.
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL
+ * @throws ERROR_DEVICE_NOT_READY if DSO is not initialized
+ */
+uint32_t DSO_get_trigger_index(DSO_Handle *handle);
+
+/**
+ * @brief Get the time at which the last capture started
+ *
+ * Segment timestamps are relative to this time.
+ *
+ * @param handle Pointer to DSO handle
+ * @return PLATFORM_get_time_us() at the last DSO_start, or 0 if the DSO has
+ *         not been started
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL
+ */
+uint32_t DSO_get_start_time_us(DSO_Handle *handle);
+
+/**
+ * @brief Get the number of segments captured since DSO_start
+ *
+ * May be polled while a segmented capture is running to track progress.
+ *
+ * @param handle Pointer to DSO handle
+ * @return Number of completed segments
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL
+ * @throws ERROR_DEVICE_NOT_READY if DSO is not initialized
+ */
+uint32_t DSO_get_segments_acquired(DSO_Handle *handle);
+
+/**
+ * @brief Get the number of captures averaged since DSO_start
+ *
+ * May be polled while an averaged capture is running to track progress.
+ *
+ * @param handle Pointer to DSO handle
+ * @return Number of captures added to the accumulator
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is not the active DSO handle
+ */
+uint32_t DSO_get_averages_acquired(DSO_Handle *handle);
+
+/**
+ * @brief Get the trigger record of a captured segment
+ *
+ * @param handle Pointer to DSO handle
+ * @param segment Segment number, less than DSO_get_segments_acquired()
+ * @return Trigger position and timestamp of the segment
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or the segment has not
+ * been captured
+ * @throws ERROR_DEVICE_NOT_READY if DSO is not initialized
+ */
+DSO_Segment DSO_get_segment(DSO_Handle *handle, uint32_t segment);
+
+/**
+ * @brief Reconstruct an equivalent-time record from a segmented capture
+ *
+ * For repetitive signals, which are asynchronous to the sample clock, each
+ * segment of a capture is sampled at a different phase relative to its
+ * trigger. The phase is measured by interpolating the trigger crossing and
+ * the segments are interleaved into a record of @p steps points per sample
+ * period, i.e. at @p steps times the sample rate. See util/equivalent_time.h.
+ *
+ * The record covers @p size / @p steps sample periods, with the trigger at
+ * the same relative position as the pretrigger in a segment. Points no
+ * segment reached are interpolated, so enough segments should be captured
+ * to cover every phase: at least @p steps, and several times that for a
+ * complete record. Samples are on the capture's resolution scale.
+ *
+ * @param handle Pointer to DSO handle
+ * @param steps Equivalent-time points per sample period
+ * @param record Output buffer, must not overlap the capture buffer
+ * @param size Number of points in the record
+ * @return Number of segments in which the trigger crossing was found
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or record is NULL, steps is not
+ * between 2 and DSO_ETS_STEPS_MAX, or the capture is not a completed
+ * single-channel edge-triggered capture without decimation
+ */
+uint32_t DSO_get_equivalent_time(
+    DSO_Handle *handle,
+    uint32_t steps,
+    uint16_t *record,
+    uint32_t size
+);
+
+/**
+ * @brief Estimate the ADC1/ADC2 mismatch of single-channel mode
+ *
+ * Single-channel mode interleaves two ADCs, whose offset and gain differ
+ * slightly; the difference puts spurs at half the sample rate. The
+ * mismatch is estimated from the last capture, which must be a completed
+ * one-shot capture of a slow signal, such as a sine wave spanning many
+ * cycles well below a tenth of the sample rate, and is corrected in all
+ * later single-channel captures. See util/interleave.h.
+ *
+ * The estimate refines the correction in use, so repeating it converges on
+ * any residual mismatch. The correction is kept across DSO handles until
+ * DSO_reset_interleave, but not across power cycles.
+ *
+ * @param handle Pointer to DSO handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or the last capture is
+ *         not a stopped one-shot single-channel capture without trigger,
+ *         segments or decimation
+ * @throws ERROR_CALIBRATION_FAILED if the signal does not vary enough or
+ *         the mismatch is implausibly large
+ */
+void DSO_calibrate_interleave(DSO_Handle *handle);
+
+/**
+ * @brief Get the ADC1/ADC2 mismatch correction
+ *
+ * @return Correction applied to the ADC2 samples of single-channel
+ *         captures, with the offset on the 12-bit scale
+ */
+INTERLEAVE_Correction DSO_get_interleave(void);
+
+/**
+ * @brief Drop the ADC1/ADC2 mismatch correction
+ *
+ * Takes effect from the next DSO_start.
+ */
+void DSO_reset_interleave(void);
+
+/**
+ * @brief Measure one channel of the last capture
+ *
+ * Computes amplitude and timing measurements on the capture buffer in
+ * place, so only a few numbers need to leave the device. Voltages are
+ * scaled with the measured ADC reference and times with the stored sample
+ * rate; results that do not fit saturate at UINT32_MAX. Segmented
+ * captures are measured on their first segment, and at most
+ * WAVEFORM_SAMPLES_MAX samples of the channel are used.
+ *
+ * @param handle Pointer to DSO handle
+ * @param channel Channel to measure, counted from the first channel of the
+ *                mode
+ * @param out Measurements
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or out is NULL, the channel
+ * is not captured in the current mode, or the capture is peak-detect
+ * decimated
+ * @throws ERROR_RESOURCE_BUSY if data acquisition is currently running
+ */
+void DSO_measure(DSO_Handle *handle, uint32_t channel, DSO_Measurements *out);
+
+/**
+ * @brief Amplitude spectrum of one channel of the last capture
+ *
+ * Transforms the first size samples of the channel in the first segment;
+ * see spectrum.h for the window and the scaling of the bins. Bin k is at
+ * k * sample_rate / size.
+ *
+ * @param handle Pointer to DSO handle
+ * @param channel Channel to transform, counted from the first channel of
+ *                the mode
+ * @param size FFT size, a power of two from SPECTRUM_SIZE_MIN to
+ *             SPECTRUM_SIZE_MAX and at most the samples of the channel in
+ *             a segment
+ * @param work FFT work buffer of 2 * size values
+ * @param bins Output, size / 2 amplitudes in Q16.16 ADC codes
+ *
+ * @throws ERROR_INVALID_ARGUMENT if a pointer is NULL, the channel is not
+ * captured in the current mode, or size is not supported
+ * @throws ERROR_RESOURCE_BUSY if data acquisition is currently running
+ */
+void DSO_get_spectrum(
+    DSO_Handle *handle,
+    uint32_t channel,
+    uint32_t size,
+    int32_t *work,
+    FIXED_Q1616 *bins
+);
+
 /**
  * @brief Get current DSO configuration
  *
  * This function returns the currently applied configuration of the DSO.
+ * The sample rate is the one the timer achieved, which differs from the
+ * requested rate when the timer clock cannot be divided down to it
+ * exactly.
  *
  * @param handle Pointer to DSO handle
  * @return Copy of the current DSO configuration
@@ -146,6 +604,11 @@ DSO_Config DSO_get_config(DSO_Handle *handle);
  * This function updates the DSO configuration. The configuration update
  * is not allowed if data acquisition is currently ongoing.
  *
+ * If the mode, channel and acquisition type stay the same, e.g. when only
+ * the sample rate or buffer change, the ADC is kept as initialized and only
+ * its output buffer and the timer are updated. Other changes reinitialize
+ * the ADC and timer.
+ *
  * @param handle Pointer to DSO handle
  * @param config Pointer to new DSO configuration
  *
@@ -157,15 +620,40 @@ DSO_Config DSO_get_config(DSO_Handle *handle);
 void DSO_set_config(DSO_Handle *handle, DSO_Config const *config);
 
 /**
- * @brief Get maximum sample rate for a given DSO mode
+ * @brief Get maximum sample rate for a given DSO mode and resolution
  *
  * This function returns the maximum achievable sample rate for the specified
- * DSO mode, which depends on the underlying ADC capabilities.
+ * DSO mode, which depends on the underlying ADC capabilities. Lower
+ * resolutions convert faster and so allow higher rates.
  *
  * @param mode DSO mode (single or dual channel)
+ * @param resolution Sample resolution
  * @return Maximum sample rate in Hz for the specified mode
  */
-uint32_t DSO_get_max_sample_rate(DSO_Mode mode);
+uint32_t DSO_get_max_sample_rate(DSO_Mode mode, DSO_Resolution resolution);
+
+/**
+ * @brief Get the ADC sampling time used for a configuration
+ *
+ * The longest sampling time that still keeps up with the sample rate is
+ * used, so slow captures sample each input for longer and settle more
+ * accurately, while fast ones get the shortest sampling time they need.
+ *
+ * @param config DSO configuration
+ * @return Sampling time in ns, or 0 if the ADC clock is unknown
+ * @throws ERROR_INVALID_ARGUMENT if config is NULL
+ */
+uint32_t DSO_get_sample_time_ns(DSO_Config const *config);
+
+/**
+ * @brief Get the voltage corresponding to DSO_SAMPLE_MAX
+ *
+ * Samples scale linearly from 0 V at code 0 to this voltage, the measured
+ * ADC reference, at DSO_SAMPLE_MAX.
+ *
+ * @return Reference voltage in millivolts, or 0 if no DSO is configured
+ */
+uint32_t DSO_get_reference_voltage(void);
 
 /**
  * @brief Check if DSO acquisition is in progress
@@ -180,6 +668,20 @@ uint32_t DSO_get_max_sample_rate(DSO_Mode mode);
  */
 bool DSO_is_acquisition_in_progress(DSO_Handle *handle);
 
+/**
+ * @brief Get the data integrity counters
+ *
+ * The counters cover every ADC acquisition since startup. A capture is
+ * affected if an overrun or DMA error was counted after it was started, so
+ * its samples contain gaps.
+ *
+ * @param handle Pointer to DSO handle, or NULL for the counters only
+ * @return Error counters and whether the latest capture was affected
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is not the active DSO handle
+ */
+DSO_Diagnostics DSO_get_diagnostics(DSO_Handle *handle);
+
 #ifdef __cplusplus
 }
 #endif
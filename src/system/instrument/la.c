@@ -0,0 +1,409 @@
+/**
+ * @file la.c
+ * @brief Logic analyzer implementation for PSLab firmware
+ *
+ * A claimed timer paces the LA_LL sampling DMA. Captures run at the full
+ * system clock, which the timer was configured for, like the DSO's.
+ *
+ * Raw captures without a trigger are written by the DMA straight into the
+ * caller's buffer. Triggered and run-length captures sample continuously
+ * into a ring, whose halves are scanned for the trigger and then copied or
+ * encoded into the buffer from the DMA interrupt.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform/la_ll.h"
+#include "platform/tim_ll.h"
+#include "util/error.h"
+#include "util/logging.h"
+
+#include "clock.h"
+#include "la.h"
+
+// The limits are repeated in la.h, which does not expose the platform layer
+static_assert((uint32_t)LA_SAMPLES_MAX == LA_LL_SAMPLES_MAX, "LA samples");
+static_assert((uint32_t)LA_SAMPLE_RATE_MAX == LA_LL_SAMPLE_RATE_MAX, "LA rate");
+
+enum {
+    LA_RING_SIZE = 2048, // Samples of the continuous capture ring
+};
+
+/**
+ * @brief LA handle structure
+ */
+struct LA_Handle {
+    LA_Config config;
+    TIM_Num timer; // Claimed timer pacing the samples
+    bool processed; // Samples pass through the ring
+    bool volatile running;
+    uint32_t volatile acquired; // Samples of the last completed capture
+    // Processed captures, updated from the DMA interrupt
+    bool volatile triggered;
+    bool last_match; // Trigger pattern matched at the previous sample
+    uint32_t volatile samples; // Stored, or covered by stored runs
+    uint32_t volatile runs; // Runs stored
+    uint8_t run_value; // Sample of the open run
+    uint32_t run_length; // Samples of the open run, 0 if none
+};
+
+// Storage for the only LA instance
+static LA_Handle g_la_storage;
+
+// Ring of a processed capture
+static uint8_t g_la_ring[LA_RING_SIZE] __attribute__((aligned(32)));
+
+// Static instance for callback context
+static LA_Handle *g_la_handle = nullptr;
+
+static void check_handle(LA_Handle const *handle)
+{
+    if (handle == nullptr || handle != g_la_handle) {
+        LOG_ERROR("LA: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+/**
+ * @brief Mark the capture stopped and release its clock request
+ */
+static void la_mark_stopped(LA_Handle *handle)
+{
+    if (handle->running) {
+        handle->running = false;
+        CLOCK_release();
+    }
+}
+
+/**
+ * @brief Stop the timer and report the end of the capture
+ */
+static void la_finish(LA_Handle *handle)
+{
+    TIM_LL_stop(handle->timer);
+    la_mark_stopped(handle);
+    if (handle->config.complete_callback) {
+        handle->config.complete_callback();
+    }
+}
+
+/**
+ * @brief Capture end, from the DMA interrupt
+ */
+static void la_complete_callback(uint32_t samples)
+{
+    LA_Handle *const handle = g_la_handle;
+
+    if (!handle) {
+        return;
+    }
+    handle->acquired = samples;
+    la_finish(handle);
+}
+
+/**
+ * @brief Find the sample in which the masked inputs change to the pattern
+ *
+ * @return Index of the trigger sample, or samples if there is none
+ */
+static uint32_t
+la_find_trigger(LA_Handle *handle, uint8_t const *block, uint32_t samples)
+{
+    uint8_t const mask = handle->config.trigger_mask;
+    uint8_t const pattern = handle->config.trigger_pattern;
+    bool last_match = handle->last_match;
+
+    for (uint32_t i = 0; i < samples; ++i) {
+        bool const match = (block[i] & mask) == pattern;
+        if (match && !last_match) {
+            return i;
+        }
+        last_match = match;
+    }
+    handle->last_match = last_match;
+    return samples;
+}
+
+/**
+ * @brief Copy samples into the buffer
+ *
+ * @return true if the buffer is full
+ */
+static bool
+la_store_samples(LA_Handle *handle, uint8_t const *block, uint32_t samples)
+{
+    uint32_t const room = handle->config.buffer_size - handle->samples;
+    uint32_t const count = samples < room ? samples : room;
+
+    memcpy(&handle->config.buffer[handle->samples], block, count);
+    handle->samples += count;
+    return handle->samples == handle->config.buffer_size;
+}
+
+/**
+ * @brief Store the open run
+ *
+ * @return true if the buffer is full
+ */
+static bool la_close_run(LA_Handle *handle)
+{
+    LA_Run *const runs = (LA_Run *)(void *)handle->config.buffer;
+
+    runs[handle->runs] =
+        (LA_Run)handle->run_value | ((LA_Run)handle->run_length << 8);
+    handle->runs += 1;
+    handle->samples += handle->run_length;
+    handle->run_length = 0;
+    return handle->runs == handle->config.buffer_size;
+}
+
+/**
+ * @brief Encode samples into runs
+ *
+ * The last run stays open, to be extended by the next block.
+ *
+ * @return true if the buffer is full
+ */
+static bool
+la_store_runs(LA_Handle *handle, uint8_t const *block, uint32_t samples)
+{
+    for (uint32_t i = 0; i < samples; ++i) {
+        uint8_t const sample = block[i];
+
+        if (handle->run_length > 0 && sample == handle->run_value &&
+            handle->run_length < LA_RUN_LENGTH_MAX) {
+            handle->run_length += 1;
+            continue;
+        }
+        if (handle->run_length > 0 && la_close_run(handle)) {
+            return true;
+        }
+        handle->run_value = sample;
+        handle->run_length = 1;
+    }
+    return false;
+}
+
+/**
+ * @brief Written half of the ring, from the DMA interrupt
+ */
+static void la_block_callback(uint8_t const *block, uint32_t samples)
+{
+    LA_Handle *const handle = g_la_handle;
+    uint32_t first = 0;
+
+    if (!handle || !handle->running) {
+        return;
+    }
+    if (!handle->triggered) {
+        first = la_find_trigger(handle, block, samples);
+        if (first == samples) {
+            return;
+        }
+        handle->triggered = true;
+    }
+
+    bool const full =
+        handle->config.storage == LA_STORAGE_RLE
+            ? la_store_runs(handle, &block[first], samples - first)
+            : la_store_samples(handle, &block[first], samples - first);
+    if (full) {
+        LA_LL_stop();
+        la_finish(handle);
+    }
+}
+
+static bool la_is_processed(LA_Config const *config)
+{
+    return config->storage == LA_STORAGE_RLE || config->trigger_mask != 0;
+}
+
+static bool la_validate_config(LA_Config const *config)
+{
+    if (!config || !config->buffer || config->buffer_size == 0 ||
+        config->buffer_size > LA_SAMPLES_MAX || config->sample_rate == 0 ||
+        config->sample_rate > LA_SAMPLE_RATE_MAX ||
+        (config->trigger_pattern & ~config->trigger_mask) != 0) {
+        return false;
+    }
+    if (config->storage == LA_STORAGE_RLE &&
+        (uintptr_t)config->buffer % sizeof(LA_Run) != 0) {
+        return false;
+    }
+    return config->storage <= LA_STORAGE_RLE &&
+           (!la_is_processed(config) ||
+            config->sample_rate <= LA_SAMPLE_RATE_MAX_PROCESSED);
+}
+
+LA_Handle *LA_init(LA_Config const *config)
+{
+    if (!la_validate_config(config)) {
+        LOG_ERROR("LA: Invalid configuration");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_la_handle != nullptr) {
+        LOG_ERROR("LA: Already initialized");
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    LA_Handle *const handle = &g_la_storage;
+    handle->config = *config;
+    handle->processed = la_is_processed(config);
+    handle->running = false;
+    handle->acquired = 0;
+    handle->samples = 0;
+    handle->runs = 0;
+    handle->timer = TIM_LL_claim();
+
+    // The timer counts at the clock it was configured for, and captures
+    // request the full clock, so configure it at that too
+    CLOCK_request();
+    Error error = ERROR_NONE;
+    TRY
+    {
+        handle->config.sample_rate =
+            TIM_LL_init(handle->timer, config->sample_rate);
+        if (handle->processed) {
+            LA_LL_init(&(LA_LL_Config){
+                .timer = handle->timer,
+                .buffer = g_la_ring,
+                .samples = LA_RING_SIZE,
+                .block_callback = la_block_callback,
+            });
+        } else {
+            LA_LL_init(&(LA_LL_Config){
+                .timer = handle->timer,
+                .buffer = config->buffer,
+                .samples = config->buffer_size,
+                .complete_callback = la_complete_callback,
+            });
+        }
+    }
+    CATCH(error)
+    {
+        CLOCK_release();
+        LOG_ERROR("LA: Init failed, error %d", error);
+        TIM_LL_deinit(handle->timer);
+        TIM_LL_release(handle->timer);
+        THROW(error);
+    }
+    CLOCK_release();
+
+    g_la_handle = handle;
+    LOG_INFO(
+        "LA: Init %u samples at %u Hz (%u requested)",
+        handle->config.buffer_size,
+        handle->config.sample_rate,
+        config->sample_rate
+    );
+    return handle;
+}
+
+void LA_deinit(LA_Handle *handle)
+{
+    if (handle == nullptr) {
+        return;
+    }
+    check_handle(handle);
+
+    Error error = ERROR_NONE;
+    TRY
+    {
+        LA_stop(handle);
+        LA_LL_deinit();
+        TIM_LL_deinit(handle->timer);
+    }
+    CATCH(error)
+    {
+        LOG_ERROR("LA: Deinitialization failed, error %d", error);
+        // Don't throw, continue with handle cleanup
+    }
+
+    TIM_LL_release(handle->timer);
+    g_la_handle = nullptr;
+}
+
+void LA_start(LA_Handle *handle)
+{
+    check_handle(handle);
+
+    if (handle->running) {
+        LOG_WARN("LA: Already running");
+        return;
+    }
+
+    handle->acquired = 0;
+    handle->samples = 0;
+    handle->runs = 0;
+    handle->run_length = 0;
+    handle->triggered = handle->config.trigger_mask == 0;
+    handle->last_match = true;
+    CLOCK_request();
+    handle->running = true;
+
+    Error error = ERROR_NONE;
+    TRY
+    {
+        // The DMA waits for the first update event
+        LA_LL_start();
+        TIM_LL_start(handle->timer);
+    }
+    CATCH(error)
+    {
+        LOG_ERROR("LA: Failed to start, error %d", error);
+        LA_LL_stop();
+        TIM_LL_stop(handle->timer);
+        la_mark_stopped(handle);
+        THROW(error);
+    }
+}
+
+void LA_stop(LA_Handle *handle)
+{
+    check_handle(handle);
+
+    TIM_LL_stop(handle->timer);
+    LA_LL_stop();
+    if (handle->running && handle->processed) {
+        if (handle->run_length > 0 &&
+            handle->runs < handle->config.buffer_size) {
+            (void)la_close_run(handle);
+        }
+    } else if (handle->running) {
+        handle->acquired = LA_LL_get_position();
+    }
+    la_mark_stopped(handle);
+}
+
+bool LA_is_running(LA_Handle const *handle)
+{
+    check_handle(handle);
+    return handle->running;
+}
+
+uint32_t LA_get_samples_acquired(LA_Handle const *handle)
+{
+    check_handle(handle);
+    if (handle->processed) {
+        return handle->samples;
+    }
+    return handle->running ? LA_LL_get_position() : handle->acquired;
+}
+
+uint32_t LA_get_runs(LA_Handle const *handle)
+{
+    check_handle(handle);
+    return handle->runs;
+}
+
+LA_Config LA_get_config(LA_Handle const *handle)
+{
+    check_handle(handle);
+    return handle->config;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file la.h
+ * @brief Logic analyzer interface for PSLab firmware
+ *
+ * This header provides a logic analyzer that samples eight digital inputs
+ * at a fixed rate into a buffer, using the LA_LL API. A timer paces DMA
+ * transfers from the input port, so rates of tens of MS/s are reached
+ * without the CPU. Each sample is one byte, bit n holding input n.
+ *
+ * A capture can wait for a trigger pattern on the inputs, and can store
+ * runs of equal samples instead of the samples themselves, which makes a
+ * capture of a mostly idle bus many times longer. Either way the samples
+ * pass through the CPU, which limits the rate to LA_SAMPLE_RATE_MAX_PROCESSED.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_LA_H
+#define PSLAB_LA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief LA handle structure (opaque)
+ */
+typedef struct LA_Handle LA_Handle;
+
+enum {
+    /** @brief Digital inputs, one bit of each sample */
+    LA_CHANNELS = 8,
+    /** @brief Highest sample rate in Hz */
+    LA_SAMPLE_RATE_MAX = 20000000,
+    /** @brief Largest number of samples per capture */
+    LA_SAMPLES_MAX = 4 * 0xFFFF,
+    /** @brief Highest sample rate with a trigger or run-length storage */
+    LA_SAMPLE_RATE_MAX_PROCESSED = 5000000,
+    /** @brief Longest run of equal samples one LA_Run holds */
+    LA_RUN_LENGTH_MAX = 0xFFFFFF,
+};
+
+/**
+ * @brief How a capture is stored
+ */
+typedef enum {
+    LA_STORAGE_RAW, /**< One byte per sample */
+    LA_STORAGE_RLE, /**< One LA_Run per run of equal samples */
+} LA_Storage;
+
+/**
+ * @brief A run of equal samples: the sample in bits 0-7 and the number of
+ * samples in bits 8-31
+ *
+ * A run longer than LA_RUN_LENGTH_MAX is split. The runs of a capture add
+ * up to the samples captured, which gives the time of every transition.
+ */
+typedef uint32_t LA_Run;
+
+/**
+ * @brief LA completion callback type
+ *
+ * Invoked from interrupt context when the buffer is full.
+ */
+typedef void (*LA_CompleteCallback)(void);
+
+/**
+ * @brief LA configuration structure
+ */
+typedef struct {
+    uint32_t sample_rate; /**< Sample rate in Hz */
+    uint8_t *buffer; /**< One byte per sample, or 4-byte aligned LA_Runs */
+    uint32_t buffer_size; /**< Samples, or runs, per capture */
+    LA_CompleteCallback complete_callback; /**< Invoked on completion */
+    LA_Storage storage; /**< How the capture is stored */
+    uint8_t trigger_mask; /**< Inputs compared to the pattern, 0 for none */
+    uint8_t trigger_pattern; /**< Levels of the masked inputs to trigger on */
+} LA_Config;
+
+/**
+ * @brief Default LA configuration
+ */
+#define LA_CONFIG_DEFAULT                                                      \
+    {                                                                          \
+        .sample_rate = 1000000, .buffer = nullptr, .buffer_size = 1024,        \
+        .complete_callback = nullptr, .storage = LA_STORAGE_RAW,               \
+        .trigger_mask = 0, .trigger_pattern = 0,                               \
+    }
+
+/**
+ * @brief Initialize the logic analyzer
+ *
+ * Claims a timer and configures it for the sample rate, and configures the
+ * inputs and the DMA.
+ *
+ * @param config Pointer to LA configuration structure
+ * @return Pointer to LA handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if config is NULL or contains invalid values
+ * @throws ERROR_RESOURCE_BUSY if the logic analyzer is already initialized
+ * @throws ERROR_RESOURCE_UNAVAILABLE if no timer is free
+ * @throws ERROR_HARDWARE_FAULT if the DMA cannot be configured
+ */
+LA_Handle *LA_init(LA_Config const *config);
+
+/**
+ * @brief Deinitialize the logic analyzer
+ *
+ * Stops any capture and releases the timer and the DMA channel. The handle
+ * becomes invalid.
+ *
+ * @param handle Pointer to LA handle, or NULL to do nothing
+ */
+void LA_deinit(LA_Handle *handle);
+
+/**
+ * @brief Start a capture
+ *
+ * Fills the buffer once, then stops and invokes the completion callback.
+ * With a trigger mask, the buffer starts at the first sample in which the
+ * masked inputs change to the pattern; with one input masked, that is an
+ * edge. A pattern present when the capture starts must go away first.
+ *
+ * @param handle Pointer to LA handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ * @throws ERROR_HARDWARE_FAULT if the DMA cannot be started
+ */
+void LA_start(LA_Handle *handle);
+
+/**
+ * @brief Abort a capture
+ *
+ * The completion callback is not invoked. A run-length capture keeps its
+ * last run if the buffer has room for it.
+ *
+ * @param handle Pointer to LA handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ */
+void LA_stop(LA_Handle *handle);
+
+/**
+ * @brief Check if a capture is running
+ *
+ * @param handle Pointer to LA handle
+ * @return true between LA_start and the end of the capture
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ */
+bool LA_is_running(LA_Handle const *handle);
+
+/**
+ * @brief Get the number of samples captured since LA_start
+ *
+ * May be polled while a capture is running to track progress. Samples of a
+ * triggered capture are counted from the trigger.
+ *
+ * @param handle Pointer to LA handle
+ * @return Samples in the buffer, or covered by its runs
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ */
+uint32_t LA_get_samples_acquired(LA_Handle const *handle);
+
+/**
+ * @brief Get the number of runs a run-length capture stored
+ *
+ * @param handle Pointer to LA handle
+ * @return LA_Runs in the buffer, 0 for LA_STORAGE_RAW
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ */
+uint32_t LA_get_runs(LA_Handle const *handle);
+
+/**
+ * @brief Get current LA configuration
+ *
+ * The sample rate is the one the timer achieved, which differs from the
+ * requested rate when the timer clock cannot be divided down to it
+ * exactly.
+ *
+ * @param handle Pointer to LA handle
+ * @return Copy of the current LA configuration
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ */
+LA_Config LA_get_config(LA_Handle const *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_LA_H
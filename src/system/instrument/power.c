@@ -0,0 +1,456 @@
+/**
+ * @file power.c
+ * @brief Power and energy meter implementation for PSLab firmware
+ *
+ * The timer triggers ADC1 and ADC2 together, and the DMA stores each pair
+ * side by side in a circular ring. Each half-transfer callback adds the
+ * half of the ring that has just been filled to the running sums of the
+ * voltage and current codes, of their squares and of their products, the
+ * instantaneous power. The cost is a few integer operations per pair, and
+ * the sums never leave the device.
+ *
+ * Readings copy the sums under a sequence count and turn them into
+ * micro-units with the reference voltage and the gains of the
+ * configuration, dividing before each multiplication that could overflow.
+ * Clearing keeps a copy of the sums as a baseline that readings subtract,
+ * so that the callbacks stay the only writer of the sums.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform/adc_ll.h"
+#include "platform/tim_ll.h"
+#include "util/arena.h"
+#include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/logging.h"
+#include "util/si_prefix.h"
+
+#include "clock.h"
+#include "power.h"
+
+enum {
+    POWER_RING_SIZE = 512, // Codes in the ring, two per sample pair
+    POWER_MAX_CODE = 4095, // Full-scale 12-bit code
+    SECONDS_PER_HOUR = 3600,
+};
+
+/**
+ * @brief Running sums over the accumulated sample pairs
+ *
+ * Current codes are taken relative to the code of current_zero.
+ */
+typedef struct {
+    uint64_t count; // Sample pairs
+    uint64_t voltage; // Sum of the voltage codes
+    int64_t current; // Sum of the current codes
+    uint64_t voltage_squares;
+    uint64_t current_squares;
+    int64_t products; // Sum of voltage code * current code
+} PowerSums;
+
+/**
+ * @brief Power meter handle structure
+ */
+struct POWER_Handle {
+    POWER_Config config;
+    bool initialized;
+    TIM_Num timer; // Claimed timer triggering the pairs
+    uint32_t rate; // Achieved pairs per second
+    uint32_t reference_mv; // ADC reference voltage at init
+    int32_t current_zero_code; // Code of current_zero
+    // Written by the callbacks only, guarded by sequence which is odd
+    // while a callback is updating them
+    PowerSums volatile sums;
+    uint32_t volatile sequence;
+    PowerSums baseline; // Sums at the last POWER_clear
+    // Circular DMA target, voltage and current codes interleaved
+    uint16_t ring[POWER_RING_SIZE];
+};
+
+// Storage for the only power meter instance, in DMA memory for the ring
+static POWER_Handle g_power_storage ARENA_DMA_MEMORY;
+
+// Static instance for callback context
+static POWER_Handle *g_power_handle = nullptr;
+
+// ADC_LL channel of each channel number, without casting to the enum
+static ADC_LL_Channel const g_adc_channels[POWER_CHANNEL_MAX + 1] = {
+    ADC_LL_CHANNEL_0,  ADC_LL_CHANNEL_1,  ADC_LL_CHANNEL_2,  ADC_LL_CHANNEL_3,
+    ADC_LL_CHANNEL_4,  ADC_LL_CHANNEL_5,  ADC_LL_CHANNEL_6,  ADC_LL_CHANNEL_7,
+    ADC_LL_CHANNEL_8,  ADC_LL_CHANNEL_9,  ADC_LL_CHANNEL_10, ADC_LL_CHANNEL_11,
+    ADC_LL_CHANNEL_12, ADC_LL_CHANNEL_13, ADC_LL_CHANNEL_14, ADC_LL_CHANNEL_15,
+};
+
+/**
+ * @brief ADC half-transfer and transfer complete callback.
+ *
+ * Adds the sample pairs of the half of the ring that has just been filled
+ * to the sums.
+ */
+// NOLINTNEXTLINE(readability-non-const-parameter)
+void power_adc_complete_callback(uint16_t *buffer, uint32_t total_samples)
+{
+    POWER_Handle *handle = g_power_handle;
+
+    if (handle == nullptr || buffer == nullptr) {
+        return;
+    }
+
+    int32_t const zero = handle->current_zero_code;
+    PowerSums block = { .count = total_samples / 2 };
+    for (uint32_t k = 0; k + 1 < total_samples; k += 2) {
+        int32_t const voltage = buffer[k];
+        int32_t const current = (int32_t)buffer[k + 1] - zero;
+
+        block.voltage += (uint32_t)voltage;
+        block.current += current;
+        block.voltage_squares += (uint32_t)(voltage * voltage);
+        block.current_squares += (uint32_t)(current * current);
+        block.products += voltage * current;
+    }
+
+    handle->sequence += 1;
+    handle->sums.count += block.count;
+    handle->sums.voltage += block.voltage;
+    handle->sums.current += block.current;
+    handle->sums.voltage_squares += block.voltage_squares;
+    handle->sums.current_squares += block.current_squares;
+    handle->sums.products += block.products;
+    handle->sequence += 1;
+}
+
+/**
+ * @brief Consistent copy of the sums
+ */
+static PowerSums power_sums(POWER_Handle const *handle)
+{
+    uint32_t sequence = 0;
+    PowerSums sums = { 0 };
+
+    // The callbacks pre-empt this loop, never the other way round, so a
+    // stable even sequence means the copy comes from a single update
+    do {
+        sequence = handle->sequence;
+        sums = handle->sums;
+    } while ((sequence & 1U) != 0 || sequence != handle->sequence);
+    return sums;
+}
+
+/**
+ * @brief x * num / den, truncated, for |num * den| below 2^63
+ *
+ * Divides first, so that x may take the full range as long as the result
+ * fits.
+ */
+static int64_t scale(int64_t x, int64_t num, int64_t den)
+{
+    return x / den * num + x % den * num / den;
+}
+
+/**
+ * @brief num / den with bits fraction bits, truncated
+ *
+ * Long division one bit at a time, so that the fraction never needs more
+ * than 64 bits whatever num and den, for den below 2^63.
+ */
+static uint64_t fraction(uint64_t num, uint64_t den, uint32_t bits)
+{
+    uint64_t quotient = num / den;
+    uint64_t remainder = num % den;
+
+    for (uint32_t i = 0; i < bits; ++i) {
+        remainder <<= 1;
+        quotient <<= 1;
+        if (remainder >= den) {
+            remainder -= den;
+            quotient |= 1;
+        }
+    }
+    return quotient;
+}
+
+/**
+ * @brief Mean of a signed sum of codes in Q16.16 codes
+ */
+static int64_t mean_code(int64_t sum, uint64_t count)
+{
+    uint64_t const magnitude = sum < 0 ? (uint64_t)-sum : (uint64_t)sum;
+    int64_t const mean = (int64_t)fraction(magnitude, count, FIXED_FRAC_BITS);
+    return sum < 0 ? -mean : mean;
+}
+
+/**
+ * @brief RMS of a sum of squared codes in Q16.16 codes
+ */
+static int64_t rms_code(uint64_t sum_squares, uint64_t count)
+{
+    // The root of the Q32.32 mean square is Q16.16
+    return (int64_t)FIXED_isqrt64(
+        fraction(sum_squares, count, 2 * FIXED_FRAC_BITS)
+    );
+}
+
+/**
+ * @brief Micro-units of a Q16.16 code through the input and a gain
+ */
+static int64_t
+power_micro(POWER_Handle const *handle, int64_t code, FIXED_Q1616 gain)
+{
+    int64_t const microvolts_full_scale =
+        (int64_t)handle->reference_mv * SI_MILLI_DIV;
+    int64_t const at_input = scale(code, microvolts_full_scale, POWER_MAX_CODE);
+    return scale(at_input, gain, FIXED_SCALE) / FIXED_SCALE;
+}
+
+/**
+ * @brief Millivolts at the inputs of the codes in a sum
+ */
+static int64_t power_millivolts(POWER_Handle const *handle, int64_t sum)
+{
+    return scale(sum, handle->reference_mv, POWER_MAX_CODE);
+}
+
+/**
+ * @brief Check the configuration against the limits of the ADC
+ */
+static bool power_validate_config(POWER_Config const *config)
+{
+    if (config == nullptr) {
+        LOG_ERROR("POWER: Configuration is NULL");
+        return false;
+    }
+
+    if (config->voltage_channel > POWER_CHANNEL_MAX ||
+        config->current_channel > POWER_CHANNEL_MAX ||
+        config->voltage_channel == config->current_channel) {
+        LOG_ERROR("POWER: Invalid channels");
+        return false;
+    }
+
+    uint32_t const max_rate = ADC_LL_get_max_sample_rate(
+        ADC_LL_MODE_SIMULTANEOUS, ADC_LL_RESOLUTION_12BIT
+    );
+    if (config->sample_rate < POWER_RATE_MIN ||
+        config->sample_rate > POWER_RATE_MAX ||
+        config->sample_rate > max_rate) {
+        LOG_ERROR("POWER: Invalid sample rate: %u", config->sample_rate);
+        return false;
+    }
+
+    if (config->voltage_gain <= 0 || config->current_gain <= 0 ||
+        config->current_zero < 0) {
+        LOG_ERROR("POWER: Invalid scaling");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Initialize the ADC, and the code of current_zero once its
+ *        reference is known
+ */
+static void power_init_adc(POWER_Handle *handle)
+{
+    ADC_LL_Config const adc_config = {
+        .channels = { g_adc_channels[handle->config.voltage_channel],
+                      g_adc_channels[handle->config.current_channel] },
+        .mode = ADC_LL_MODE_SIMULTANEOUS,
+        .trigger_source = ADC_LL_get_timer_trigger(handle->timer),
+        .output_buffer = handle->ring,
+        .buffer_size = POWER_RING_SIZE,
+        .oversampling_ratio = 1,
+        .circular = true,
+        // Sample for as long as the rate leaves time for, as the inputs
+        // may come from a divider or an amplifier of high impedance
+        .conversion_rate = handle->config.sample_rate,
+    };
+
+    ADC_LL_init(&adc_config);
+    ADC_LL_set_complete_callback(power_adc_complete_callback);
+    ADC_LL_set_half_complete_callback(power_adc_complete_callback);
+
+    handle->reference_mv = ADC_LL_get_reference_voltage();
+    if (handle->reference_mv > 0) {
+        int64_t const zero = scale(
+            (int64_t)handle->config.current_zero * SI_MILLI_DIV,
+            POWER_MAX_CODE,
+            (int64_t)handle->reference_mv * FIXED_SCALE
+        );
+        handle->current_zero_code = (int32_t)zero;
+    }
+}
+
+/**
+ * @brief Bring up the hardware of a new handle, unwinding on failure
+ */
+static void power_init_hardware(POWER_Handle *handle)
+{
+    Error error = ERROR_NONE;
+    bool volatile adc_ready = false;
+    bool volatile timer_ready = false;
+
+    handle->timer = TIM_LL_claim();
+    TRY
+    {
+        power_init_adc(handle);
+        adc_ready = true;
+        handle->rate = TIM_LL_init(handle->timer, handle->config.sample_rate);
+        timer_ready = true;
+        TIM_LL_start(handle->timer);
+        ADC_LL_start();
+    }
+    CATCH(error)
+    {
+        LOG_ERROR("POWER: Hardware init failed, error %d", error);
+        if (timer_ready) {
+            TIM_LL_stop(handle->timer);
+            TIM_LL_deinit(handle->timer);
+        }
+        if (adc_ready) {
+            ADC_LL_deinit();
+        }
+        TIM_LL_release(handle->timer);
+        THROW(error);
+    }
+}
+
+POWER_Handle *POWER_init(POWER_Config const *config)
+{
+    if (!power_validate_config(config)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (g_power_handle != nullptr || ADC_LL_is_initialized()) {
+        LOG_ERROR("POWER: ADC in use");
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    POWER_Handle *handle = &g_power_storage;
+    handle->config = *config;
+    handle->rate = 0;
+    handle->reference_mv = 0;
+    handle->current_zero_code = 0;
+    handle->sums = (PowerSums){ 0 };
+    handle->sequence = 0;
+    handle->baseline = (PowerSums){ 0 };
+    g_power_handle = handle;
+
+    // The timer rate is derived for, and conversions run at, the full clock
+    CLOCK_request();
+    Error error = ERROR_NONE;
+    TRY { power_init_hardware(handle); }
+    CATCH(error)
+    {
+        g_power_handle = nullptr;
+        CLOCK_release();
+        THROW(error);
+    }
+    handle->initialized = true;
+
+    LOG_INFO(
+        "POWER: Channels %u and %u at %u Hz",
+        config->voltage_channel,
+        config->current_channel,
+        handle->rate
+    );
+    return handle;
+}
+
+void POWER_deinit(POWER_Handle *handle)
+{
+    if (handle == nullptr || handle != g_power_handle) {
+        return;
+    }
+
+    ADC_LL_stop();
+    TIM_LL_stop(handle->timer);
+    ADC_LL_deinit();
+    TIM_LL_deinit(handle->timer);
+    TIM_LL_release(handle->timer);
+
+    g_power_handle = nullptr;
+    handle->initialized = false;
+    CLOCK_release();
+    LOG_INFO("POWER: Deinitialized");
+}
+
+void POWER_read(POWER_Handle *handle, POWER_Reading *reading)
+{
+    if (handle == nullptr || reading == nullptr ||
+        handle != g_power_handle || !handle->initialized) {
+        LOG_ERROR("POWER: Invalid arguments to read");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    PowerSums const total = power_sums(handle);
+    PowerSums const *base = &handle->baseline;
+    uint64_t const count = total.count - base->count;
+
+    *reading = (POWER_Reading){ .sample_rate = handle->rate };
+    if (count == 0) {
+        return;
+    }
+
+    POWER_Config const *config = &handle->config;
+    int64_t const voltage = (int64_t)(total.voltage - base->voltage);
+    int64_t const current = total.current - base->current;
+    int64_t const products = total.products - base->products;
+
+    reading->samples = count;
+    reading->voltage_mean =
+        power_micro(handle, mean_code(voltage, count), config->voltage_gain);
+    reading->voltage_rms = power_micro(
+        handle,
+        rms_code(total.voltage_squares - base->voltage_squares, count),
+        config->voltage_gain
+    );
+    reading->current_mean =
+        power_micro(handle, mean_code(current, count), config->current_gain);
+    reading->current_rms = power_micro(
+        handle,
+        rms_code(total.current_squares - base->current_squares, count),
+        config->current_gain
+    );
+
+    // Square millivolts at the inputs times the gains are microwatts; the
+    // sums are taken to seconds before the gains can grow them
+    int64_t const input_products =
+        power_millivolts(handle, power_millivolts(handle, products));
+    int64_t const input_power = input_products / (int64_t)count;
+    int64_t const input_energy = input_products / handle->rate; // uW s
+    reading->power_mean = scale(
+        scale(input_power, config->voltage_gain, FIXED_SCALE),
+        config->current_gain,
+        FIXED_SCALE
+    );
+    int64_t const energy = scale(
+        scale(input_energy, config->voltage_gain, FIXED_SCALE),
+        config->current_gain,
+        FIXED_SCALE
+    );
+    reading->energy = energy / SECONDS_PER_HOUR;
+
+    // Microvolt seconds at the input times the gain are microcoulombs
+    int64_t const microvolts_full_scale =
+        (int64_t)handle->reference_mv * SI_MILLI_DIV;
+    int64_t const input_charge =
+        scale(current, microvolts_full_scale, POWER_MAX_CODE) / handle->rate;
+    reading->charge = scale(input_charge, config->current_gain, FIXED_SCALE) /
+                      SECONDS_PER_HOUR;
+}
+
+void POWER_clear(POWER_Handle *handle)
+{
+    if (handle == nullptr || handle != g_power_handle ||
+        !handle->initialized) {
+        LOG_ERROR("POWER: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    handle->baseline = power_sums(handle);
+}
@@ -0,0 +1,143 @@
+/**
+ * @file power.h
+ * @brief Power and energy meter interface for PSLab firmware
+ *
+ * This header provides a power meter that samples the voltage across a
+ * load and the output of a current shunt amplifier at the same instant,
+ * on ADC1 and ADC2 in simultaneous mode. Every pair of samples is
+ * accumulated on the device as it arrives, so that hours of battery
+ * discharge are summarized without streaming a sample to the host: a
+ * reading returns the mean and RMS voltage and current, the mean power
+ * and the energy and charge since the meter started or was last cleared.
+ *
+ * Sums are kept in integer ADC codes, and scaled to micro-units only when
+ * read, so that no rounding accumulates over a long run. They are exact
+ * for 2^39 sample pairs, over 60 days at the highest rate.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_POWER_H
+#define PSLAB_POWER_H
+
+#include <stdint.h>
+
+#include "util/fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Power meter handle structure (opaque)
+ */
+typedef struct POWER_Handle POWER_Handle;
+
+enum {
+    /** @brief Highest ADC channel number */
+    POWER_CHANNEL_MAX = 15,
+    /** @brief Lowest sample rate in pairs per second */
+    POWER_RATE_MIN = 100,
+    /** @brief Highest sample rate in pairs per second */
+    POWER_RATE_MAX = 100000,
+};
+
+/**
+ * @brief Power meter configuration structure
+ *
+ * The gains turn the voltages at the two ADC inputs into the voltage
+ * across the load and the current through it, e.g. a voltage_gain of 2
+ * behind a 1:1 divider and a current_gain of 10 for a 0.1 ohm shunt
+ * without amplification. current_zero is the input voltage at zero
+ * current, the mid-rail bias of a bidirectional shunt amplifier; currents
+ * below it come out negative.
+ */
+typedef struct {
+    uint32_t voltage_channel; // ADC1 input for the load voltage
+    uint32_t current_channel; // ADC2 input from the shunt amplifier
+    uint32_t sample_rate; // Sample pairs per second
+    FIXED_Q1616 voltage_gain; // Volts across the load per volt at the input
+    FIXED_Q1616 current_gain; // Amperes through the load per volt at the input
+    FIXED_Q1616 current_zero; // Input voltage at zero current (in volts)
+} POWER_Config;
+
+/**
+ * @brief Default power meter configuration
+ */
+#define POWER_CONFIG_DEFAULT                                                   \
+    {                                                                          \
+        .voltage_channel = 0, .current_channel = 1, .sample_rate = 10000,      \
+        .voltage_gain = FIXED_ONE, .current_gain = FIXED_ONE,                  \
+        .current_zero = 0,                                                     \
+    }
+
+/**
+ * @brief Values accumulated since the meter started or was last cleared
+ *
+ * All values are 0 before the first samples have been accumulated.
+ */
+typedef struct {
+    uint64_t samples; // Sample pairs accumulated
+    uint32_t sample_rate; // Sample pairs per second, as achieved
+    int64_t voltage_mean; // Mean voltage in microvolts
+    int64_t voltage_rms; // RMS voltage in microvolts
+    int64_t current_mean; // Mean current in microamperes
+    int64_t current_rms; // RMS current in microamperes
+    int64_t power_mean; // Mean of the instantaneous power in microwatts
+    int64_t energy; // Energy in microwatt-hours
+    int64_t charge; // Charge in microampere-hours
+} POWER_Reading;
+
+/**
+ * @brief Initialize the power meter and start accumulating
+ *
+ * @param config Pointer to power meter configuration structure
+ * @return Pointer to power meter handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if config is NULL or contains invalid
+ *         values, e.g. the same channel twice or a rate the ADC cannot
+ *         sustain
+ * @throws ERROR_RESOURCE_BUSY if the power meter or the ADC is in use
+ * @throws ERROR_RESOURCE_UNAVAILABLE if no timer is free
+ * @throws ERROR_HARDWARE_FAULT if ADC initialization fails
+ */
+POWER_Handle *POWER_init(POWER_Config const *config);
+
+/**
+ * @brief Stop the power meter and release the ADC
+ *
+ * The handle becomes invalid.
+ *
+ * @param handle Pointer to power meter handle, or NULL to do nothing
+ */
+void POWER_deinit(POWER_Handle *handle);
+
+/**
+ * @brief Read the values accumulated so far
+ *
+ * Accumulation goes on meanwhile; the values cover every pair up to the
+ * last half of the sample ring to be filled.
+ *
+ * @param handle Pointer to power meter handle
+ * @param reading Filled with the accumulated values
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle or reading is NULL, or handle
+ *         is invalid
+ */
+void POWER_read(POWER_Handle *handle, POWER_Reading *reading);
+
+/**
+ * @brief Start accumulating afresh, without stopping the conversions
+ *
+ * @param handle Pointer to power meter handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ */
+void POWER_clear(POWER_Handle *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_POWER_H
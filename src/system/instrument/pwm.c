@@ -0,0 +1,258 @@
+/**
+ * @file pwm.c
+ * @brief PWM generator implementation for PSLab firmware
+ *
+ * TIM4 drives the outputs from channel pairs 1-2 and 3-4, each in combined
+ * PWM mode, which lets a pulse start anywhere in the period. TIM_LL_claim
+ * hands TIM4 out last, so the generator can usually run alongside the
+ * acquisitions. Like the instruments' timers it is configured and run at
+ * the full system clock.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform/tim_ll.h"
+#include "util/error.h"
+#include "util/logging.h"
+
+#include "clock.h"
+#include "pwm.h"
+
+// Timer driving the outputs
+static TIM_Num const g_pwm_timer = TIM_NUM_4;
+
+// Timer channel of each output
+static TIM_LL_Channel const g_pwm_channels[PWM_CHANNEL_COUNT] = {
+    TIM_LL_CHANNEL_1,
+    TIM_LL_CHANNEL_3,
+};
+
+/**
+ * @brief PWM handle structure
+ */
+struct PWM_Handle {
+    PWM_Config config;
+    uint32_t period; // Timer counts per period
+    bool running;
+};
+
+// Storage for the only PWM instance
+static PWM_Handle g_pwm_storage;
+
+// Static instance for handle checks
+static PWM_Handle *g_pwm_handle = nullptr;
+
+static void check_handle(PWM_Handle const *handle)
+{
+    if (handle == nullptr || handle != g_pwm_handle) {
+        LOG_ERROR("PWM: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+static bool validate_channel(PWM_Channel const *channel)
+{
+    return channel->duty <= PWM_PPM_FULL && channel->phase < PWM_PPM_FULL;
+}
+
+static bool validate_config(PWM_Config const *config)
+{
+    if (!config || config->frequency < PWM_FREQUENCY_MIN ||
+        config->frequency > PWM_FREQUENCY_MAX) {
+        return false;
+    }
+    for (uint32_t i = 0; i < PWM_CHANNEL_COUNT; ++i) {
+        if (!validate_channel(&config->channels[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Timer counts of a fraction of the period, rounded
+ */
+static uint32_t to_counts(PWM_Handle const *handle, uint32_t ppm)
+{
+    return (uint32_t)(((uint64_t)ppm * handle->period + PWM_PPM_FULL / 2) /
+                      PWM_PPM_FULL);
+}
+
+/**
+ * @brief Load the pulse of an output into its compare channels
+ */
+static void apply_pulse(PWM_Handle const *handle, uint32_t index)
+{
+    PWM_Channel const *const channel = &handle->config.channels[index];
+
+    // A phase rounded up to a whole period starts the period
+    uint32_t const start = to_counts(handle, channel->phase) % handle->period;
+    TIM_LL_pwm_set_pulse(
+        g_pwm_timer,
+        g_pwm_channels[index],
+        start,
+        to_counts(handle, channel->duty)
+    );
+}
+
+static void set_outputs(PWM_Handle const *handle, bool enable)
+{
+    for (uint32_t i = 0; i < PWM_CHANNEL_COUNT; ++i) {
+        TIM_LL_pwm_enable(
+            g_pwm_timer,
+            g_pwm_channels[i],
+            enable && handle->config.channels[i].enabled
+        );
+    }
+}
+
+PWM_Handle *PWM_init(PWM_Config const *config)
+{
+    if (!validate_config(config)) {
+        LOG_ERROR("PWM: Invalid configuration");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_pwm_handle != nullptr) {
+        LOG_ERROR("PWM: Already initialized");
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    PWM_Handle *const handle = &g_pwm_storage;
+
+    handle->config = *config;
+    handle->running = false;
+
+    CLOCK_request();
+    Error error = ERROR_NONE;
+    TRY
+    {
+        handle->config.frequency =
+            TIM_LL_init(g_pwm_timer, config->frequency);
+        handle->period = TIM_LL_get_period(g_pwm_timer);
+        for (uint32_t i = 0; i < PWM_CHANNEL_COUNT; ++i) {
+            TIM_LL_pwm_init(g_pwm_timer, g_pwm_channels[i]);
+            apply_pulse(handle, i);
+        }
+    }
+    CATCH(error)
+    {
+        CLOCK_release();
+        LOG_ERROR("PWM: Init failed, error %d", error);
+        // The timer may be an acquisition's, which would leave it busy
+        if (error != ERROR_RESOURCE_BUSY) {
+            TIM_LL_deinit(g_pwm_timer);
+        }
+        THROW(error);
+    }
+    CLOCK_release();
+
+    g_pwm_handle = handle;
+    LOG_INFO(
+        "PWM: Init at %u Hz (%u requested), %u counts per period",
+        handle->config.frequency,
+        config->frequency,
+        handle->period
+    );
+    return handle;
+}
+
+void PWM_deinit(PWM_Handle *handle)
+{
+    if (handle == nullptr) {
+        return;
+    }
+    check_handle(handle);
+
+    Error error = ERROR_NONE;
+    TRY
+    {
+        PWM_stop(handle);
+        TIM_LL_deinit(g_pwm_timer);
+    }
+    CATCH(error)
+    {
+        LOG_ERROR("PWM: Deinitialization failed, error %d", error);
+        // Don't throw, continue with handle cleanup
+    }
+
+    g_pwm_handle = nullptr;
+}
+
+void PWM_start(PWM_Handle *handle)
+{
+    check_handle(handle);
+
+    if (handle->running) {
+        return;
+    }
+
+    CLOCK_request();
+    Error error = ERROR_NONE;
+    TRY
+    {
+        // Loading the pulses while stopped restarts the period
+        for (uint32_t i = 0; i < PWM_CHANNEL_COUNT; ++i) {
+            apply_pulse(handle, i);
+        }
+        set_outputs(handle, true);
+        TIM_LL_start(g_pwm_timer);
+    }
+    CATCH(error)
+    {
+        LOG_ERROR("PWM: Failed to start, error %d", error);
+        set_outputs(handle, false);
+        CLOCK_release();
+        THROW(error);
+    }
+    handle->running = true;
+}
+
+void PWM_stop(PWM_Handle *handle)
+{
+    check_handle(handle);
+
+    // The counter keeps running while any output is enabled
+    set_outputs(handle, false);
+    TIM_LL_stop(g_pwm_timer);
+    if (handle->running) {
+        handle->running = false;
+        CLOCK_release();
+    }
+}
+
+void PWM_set_channel(
+    PWM_Handle *handle,
+    uint32_t index,
+    PWM_Channel const *channel
+)
+{
+    check_handle(handle);
+    if (index >= PWM_CHANNEL_COUNT || !channel ||
+        !validate_channel(channel)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    handle->config.channels[index] = *channel;
+    apply_pulse(handle, index);
+    TIM_LL_pwm_enable(
+        g_pwm_timer,
+        g_pwm_channels[index],
+        handle->running && channel->enabled
+    );
+}
+
+bool PWM_is_running(PWM_Handle const *handle)
+{
+    check_handle(handle);
+    return handle->running;
+}
+
+PWM_Config PWM_get_config(PWM_Handle const *handle)
+{
+    check_handle(handle);
+    return handle->config;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file pwm.h
+ * @brief PWM generator interface for PSLab firmware
+ *
+ * This header provides rectangular outputs from a timer's compare
+ * channels, using the TIM_LL API. The outputs share the timer's counter,
+ * so they run at one frequency, locked to one another, and each pulse is
+ * placed in the period by its own duty cycle and phase. The hardware
+ * produces them without any CPU work.
+ *
+ * Duty cycles and phases are in parts per million of the period, and are
+ * resolved to the timer counts in a period, e.g. 62500 at 1 kHz.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_PWM_H
+#define PSLAB_PWM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief PWM handle structure (opaque)
+ */
+typedef struct PWM_Handle PWM_Handle;
+
+enum {
+    /** @brief Number of outputs, PD12 and PD14 */
+    PWM_CHANNEL_COUNT = 2,
+    /** @brief A whole period, in parts per million */
+    PWM_PPM_FULL = 1000000,
+    /** @brief Lowest frequency in Hz */
+    PWM_FREQUENCY_MIN = 1,
+    /** @brief Highest frequency in Hz, at 25 counts per period */
+    PWM_FREQUENCY_MAX = 10000000,
+};
+
+/**
+ * @brief Pulse of one output
+ */
+typedef struct {
+    bool enabled; /**< Whether the pin is driven; undriven otherwise */
+    uint32_t duty; /**< High time in ppm of the period, up to PWM_PPM_FULL */
+    uint32_t phase; /**< Delay of the rising edge in ppm of the period */
+} PWM_Channel;
+
+/**
+ * @brief PWM configuration structure
+ */
+typedef struct {
+    uint32_t frequency; /**< Frequency of all outputs in Hz */
+    PWM_Channel channels[PWM_CHANNEL_COUNT]; /**< Pulses of the outputs */
+} PWM_Config;
+
+/**
+ * @brief Default PWM configuration: both outputs at 1 kHz, 50 %, in phase
+ */
+#define PWM_CONFIG_DEFAULT                                                     \
+    {                                                                          \
+        .frequency = 1000,                                                     \
+        .channels = {                                                          \
+            { .enabled = true, .duty = PWM_PPM_FULL / 2, .phase = 0 },         \
+            { .enabled = true, .duty = PWM_PPM_FULL / 2, .phase = 0 },         \
+        },                                                                     \
+    }
+
+/**
+ * @brief Initialize the PWM generator
+ *
+ * Configures the timer and the outputs, which stay undriven until
+ * PWM_start.
+ *
+ * @param config Pointer to PWM configuration structure
+ * @return Pointer to PWM handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if config is NULL or contains invalid
+ *         values
+ * @throws ERROR_RESOURCE_BUSY if the generator is already initialized, or
+ *         its timer is in use by an acquisition
+ * @throws ERROR_HARDWARE_FAULT if the timer cannot be configured
+ */
+PWM_Handle *PWM_init(PWM_Config const *config);
+
+/**
+ * @brief Deinitialize the PWM generator
+ *
+ * Stops the outputs and releases the timer and the pins. The handle
+ * becomes invalid.
+ *
+ * @param handle Pointer to PWM handle, or NULL to do nothing
+ */
+void PWM_deinit(PWM_Handle *handle);
+
+/**
+ * @brief Start the outputs, from the beginning of a period
+ *
+ * @param handle Pointer to PWM handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ * @throws ERROR_HARDWARE_FAULT if the timer cannot be started
+ */
+void PWM_start(PWM_Handle *handle);
+
+/**
+ * @brief Stop the outputs, which are left undriven
+ *
+ * @param handle Pointer to PWM handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ */
+void PWM_stop(PWM_Handle *handle);
+
+/**
+ * @brief Change the pulse of one output
+ *
+ * A running output changes at the end of its period, keeping the other
+ * outputs' timing.
+ *
+ * @param handle Pointer to PWM handle
+ * @param index Output, below PWM_CHANNEL_COUNT
+ * @param channel New pulse of the output
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid, or the
+ *         index or the pulse is out of range
+ */
+void PWM_set_channel(
+    PWM_Handle *handle,
+    uint32_t index,
+    PWM_Channel const *channel
+);
+
+/**
+ * @brief Check if the outputs are running
+ *
+ * @param handle Pointer to PWM handle
+ * @return true between PWM_start and PWM_stop
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ */
+bool PWM_is_running(PWM_Handle const *handle);
+
+/**
+ * @brief Get current PWM configuration
+ *
+ * The frequency is the one achieved by the timer, rounded to nearest.
+ *
+ * @param handle Pointer to PWM handle
+ * @return Copy of the current PWM configuration
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ */
+PWM_Config PWM_get_config(PWM_Handle const *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_PWM_H
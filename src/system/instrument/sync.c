@@ -0,0 +1,118 @@
+/**
+ * @file sync.c
+ * @brief Synchronized start of the instruments for PSLab firmware
+ *
+ * The instruments' timers cannot be slaved to a master timer: the basic
+ * timers have no slave mode controller, and the trigger outputs are taken
+ * by the ADC and DAC. The timers instead hold their starts and restart
+ * together, see TIM_LL_sync_arm. For the same reason an instrument event is
+ * routed to the held timers by the interrupt that sees it, not through a
+ * timer's trigger input.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform/tim_ll.h"
+#include "util/error.h"
+#include "util/logging.h"
+
+#include "sync.h"
+
+static struct {
+    SYNC_Source source;
+    bool trigger_output;
+    bool volatile waiting; // Started, held for an instrument event
+} g_sync = {
+    .source = SYNC_SOURCE_IMMEDIATE,
+    .trigger_output = false,
+    .waiting = false,
+};
+
+/**
+ * @brief Check if the source is an event of another instrument
+ */
+static bool is_instrument_source(SYNC_Source source)
+{
+    return source == SYNC_SOURCE_OSCILLOSCOPE ||
+           source == SYNC_SOURCE_MULTIMETER;
+}
+
+void SYNC_arm(void)
+{
+    TIM_LL_sync_arm();
+    LOG_DEBUG("SYNC: Armed");
+}
+
+uint32_t SYNC_start(void)
+{
+    if (!TIM_LL_sync_is_armed()) {
+        LOG_ERROR("SYNC: Not armed");
+        THROW(ERROR_RESOURCE_UNAVAILABLE);
+    }
+
+    if (is_instrument_source(g_sync.source)) {
+        uint32_t const count = TIM_LL_sync_held();
+        g_sync.waiting = true;
+        LOG_INFO("SYNC: %u timers wait for the event", count);
+        return count;
+    }
+
+    uint32_t const count = TIM_LL_sync_start();
+    LOG_INFO("SYNC: Started %u timers", count);
+    return count;
+}
+
+void SYNC_signal(SYNC_Source source)
+{
+    if (!g_sync.waiting || source != g_sync.source) {
+        return;
+    }
+
+    g_sync.waiting = false;
+    (void)TIM_LL_sync_fire();
+}
+
+void SYNC_cancel(void)
+{
+    if (TIM_LL_sync_is_armed()) {
+        LOG_DEBUG("SYNC: Cancelled");
+    }
+    g_sync.waiting = false;
+    TIM_LL_sync_cancel();
+}
+
+bool SYNC_is_armed(void) { return TIM_LL_sync_is_armed(); }
+
+void SYNC_set_source(SYNC_Source source)
+{
+    if (source != SYNC_SOURCE_IMMEDIATE && source != SYNC_SOURCE_EXTERNAL &&
+        !is_instrument_source(source)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (TIM_LL_sync_is_armed()) {
+        LOG_ERROR("SYNC: Source set while armed");
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    TIM_LL_sync_set_trigger_input(source == SYNC_SOURCE_EXTERNAL);
+    g_sync.source = source;
+}
+
+SYNC_Source SYNC_get_source(void) { return g_sync.source; }
+
+void SYNC_set_trigger_output(bool enable)
+{
+    if (TIM_LL_sync_is_armed()) {
+        LOG_ERROR("SYNC: Trigger output set while armed");
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    TIM_LL_sync_set_trigger_output(enable);
+    g_sync.trigger_output = enable;
+}
+
+bool SYNC_get_trigger_output(void) { return g_sync.trigger_output; }
@@ -0,0 +1,132 @@
+/**
+ * @file sync.h
+ * @brief Synchronized start of the instruments for PSLab firmware
+ *
+ * This header lets the oscilloscope, logic analyzer, waveform generator and
+ * PWM generator begin together, using the TIM_LL API. While armed, the
+ * instruments are set up and started as usual, but their timers are held;
+ * SYNC_start then starts all of them at once, so that a captured signal
+ * and a generated one share a time origin.
+ *
+ * Instruments paced by their own timer only are covered; the frequency
+ * counter's gate is not.
+ *
+ * Several boards start together through their trigger pins: one board's
+ * trigger output drives the trigger input of all boards, itself included,
+ * and each board set to SYNC_SOURCE_EXTERNAL starts on the edge.
+ *
+ * An event of one instrument can also start the others: with the
+ * oscilloscope trigger or a multimeter watch crossing as the source, the
+ * instrument reports the event with SYNC_signal from its interrupt, which
+ * starts the held timers there and then. The start follows the event by
+ * the latency of that interrupt, rather than by a pass of the main loop.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_SYNC_H
+#define PSLAB_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief What starts the held instruments
+ */
+typedef enum {
+    SYNC_SOURCE_IMMEDIATE, // SYNC_start
+    SYNC_SOURCE_EXTERNAL, // Rising edge at the trigger input
+    SYNC_SOURCE_OSCILLOSCOPE, // Oscilloscope trigger firing
+    SYNC_SOURCE_MULTIMETER, // Multimeter watch seeing a crossing
+} SYNC_Source;
+
+/**
+ * @brief Hold the starts of the instruments
+ *
+ * Arming again keeps the instruments already held.
+ */
+void SYNC_arm(void);
+
+/**
+ * @brief Start the held instruments together
+ *
+ * With SYNC_SOURCE_EXTERNAL, the instruments stay held until the edge at
+ * the trigger input, which this board may drive itself, see
+ * SYNC_set_trigger_output. With an instrument event as the source, they
+ * stay held until the first event signalled after this call.
+ *
+ * @return Number of instrument timers started, or held for the edge
+ *
+ * @throws ERROR_RESOURCE_UNAVAILABLE if not armed
+ */
+uint32_t SYNC_start(void);
+
+/**
+ * @brief Report an instrument event that may start the held instruments
+ *
+ * Called from interrupt context by the instrument the event comes from.
+ * Starts the held timers if the event is the source and SYNC_start has
+ * been called since SYNC_arm; does nothing otherwise.
+ *
+ * @param source Event that occurred
+ */
+void SYNC_signal(SYNC_Source source);
+
+/**
+ * @brief Stop holding starts
+ *
+ * Instruments held so far are left waiting; they should be stopped or
+ * started again.
+ */
+void SYNC_cancel(void);
+
+/**
+ * @brief Check if instrument starts are held
+ *
+ * @return true between SYNC_arm and SYNC_start or SYNC_cancel
+ */
+bool SYNC_is_armed(void);
+
+/**
+ * @brief Set what starts the held instruments
+ *
+ * SYNC_SOURCE_IMMEDIATE at startup.
+ *
+ * @param source Start source
+ *
+ * @throws ERROR_INVALID_ARGUMENT if source is not a SYNC_Source value
+ * @throws ERROR_RESOURCE_BUSY if armed
+ */
+void SYNC_set_source(SYNC_Source source);
+
+/**
+ * @brief Get what starts the held instruments
+ */
+SYNC_Source SYNC_get_source(void);
+
+/**
+ * @brief Drive the trigger output, low while armed and high once started
+ *
+ * Off at startup, leaving the pin free.
+ *
+ * @param enable Whether to drive the trigger output
+ *
+ * @throws ERROR_RESOURCE_BUSY if armed
+ */
+void SYNC_set_trigger_output(bool enable);
+
+/**
+ * @brief Check if the trigger output is driven
+ */
+bool SYNC_get_trigger_output(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_SYNC_H
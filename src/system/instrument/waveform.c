@@ -0,0 +1,226 @@
+/**
+ * @file waveform.c
+ * @brief Scalar measurements over a captured waveform
+ *
+ * See waveform.h for how edges are detected.
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/logging.h"
+#include "util/stats.h"
+
+#include "waveform.h"
+
+/**
+ * @brief Which side of the hysteresis band the signal was last seen on
+ */
+typedef enum {
+    SIDE_UNKNOWN,
+    SIDE_LOW,
+    SIDE_HIGH,
+} Side;
+
+/**
+ * @brief Edge and cycle bookkeeping of the timing pass
+ */
+typedef struct {
+    Side side;
+    uint32_t last_up; // Latest upward midpoint crossing
+    uint32_t last_down; // Latest downward midpoint crossing
+    uint32_t rises; // Rising edges seen
+    uint32_t first_rise;
+    uint32_t last_rise;
+    bool high_pending; // A falling edge followed the last rising edge
+    uint32_t high_time; // Time from the last rising to that falling edge
+    uint32_t high_sum; // High time of the cycles completed so far
+    uint32_t cycle_sum; // Length of the cycles contributing to high_sum
+    bool rise_armed; // Crossed the 10% level since the last rise time
+    uint32_t rise_start; // Latest upward 10% crossing
+    uint32_t rise_sum;
+    uint32_t rise_count;
+} Timing;
+
+/**
+ * @brief Time at which the signal crossed a level between two samples
+ *
+ * @param index Index of the second sample
+ * @param before Sample before the crossing, on the other side of level
+ * @param after Sample after the crossing, at or past the level
+ */
+static uint32_t crossing_time(
+    uint32_t index,
+    uint32_t before,
+    uint32_t after,
+    uint32_t level
+)
+{
+    uint32_t const span = before < after ? after - before : before - after;
+    uint32_t const covered = before < level ? level - before : before - level;
+    uint32_t const fraction =
+        ((covered << WAVEFORM_TIME_FRAC_BITS) + (span / 2)) / span;
+
+    return ((index - 1) << WAVEFORM_TIME_FRAC_BITS) + fraction;
+}
+
+/**
+ * @brief Record a rising edge at the midpoint
+ */
+static void timing_rise(Timing *timing, uint32_t time)
+{
+    if (timing->rises == 0) {
+        timing->first_rise = time;
+    } else if (timing->high_pending) {
+        timing->high_sum += timing->high_time;
+        timing->cycle_sum += time - timing->last_rise;
+    }
+    timing->high_pending = false;
+    timing->last_rise = time;
+    timing->rises++;
+}
+
+/**
+ * @brief Record a falling edge at the midpoint
+ */
+static void timing_fall(Timing *timing, uint32_t time)
+{
+    if (timing->rises > 0) {
+        timing->high_time = time - timing->last_rise;
+        timing->high_pending = true;
+    }
+}
+
+/**
+ * @brief Find edges, cycles and rise times
+ */
+static void measure_timing(
+    uint16_t const *samples,
+    uint32_t count,
+    uint32_t stride,
+    WAVEFORM_Measurements *out
+)
+{
+    uint32_t const swing = out->max - out->min;
+    uint32_t const mid = out->min + (swing / 2);
+    uint32_t const hysteresis = swing / 10;
+    uint32_t const low = out->min + hysteresis; // 10% level
+    uint32_t const high = out->max - hysteresis; // 90% level
+    Timing timing = { .side = SIDE_UNKNOWN };
+    uint32_t previous = samples[0];
+
+    if (previous > mid + hysteresis) {
+        timing.side = SIDE_HIGH;
+    } else if (previous < mid - hysteresis) {
+        timing.side = SIDE_LOW;
+    }
+
+    for (uint32_t i = 1; i < count; ++i) {
+        uint32_t const sample = samples[i * stride];
+
+        if (previous < mid && sample >= mid) {
+            timing.last_up = crossing_time(i, previous, sample, mid);
+        } else if (previous > mid && sample <= mid) {
+            timing.last_down = crossing_time(i, previous, sample, mid);
+        }
+
+        if (previous < low && sample >= low) {
+            timing.rise_start = crossing_time(i, previous, sample, low);
+            timing.rise_armed = true;
+        }
+        if (timing.rise_armed && previous < high && sample >= high) {
+            timing.rise_sum +=
+                crossing_time(i, previous, sample, high) - timing.rise_start;
+            timing.rise_count++;
+            timing.rise_armed = false;
+        }
+
+        // Count an edge once the signal has cleared the hysteresis band
+        if (timing.side != SIDE_HIGH && sample > mid + hysteresis) {
+            if (timing.side == SIDE_LOW) {
+                timing_rise(&timing, timing.last_up);
+            }
+            timing.side = SIDE_HIGH;
+        } else if (timing.side != SIDE_LOW && sample < mid - hysteresis) {
+            if (timing.side == SIDE_HIGH) {
+                timing_fall(&timing, timing.last_down);
+            }
+            timing.side = SIDE_LOW;
+        }
+
+        previous = sample;
+    }
+
+    if (timing.rise_count > 0) {
+        out->rise_time =
+            (timing.rise_sum + (timing.rise_count / 2)) / timing.rise_count;
+    }
+
+    if (timing.rises < 2) {
+        return;
+    }
+
+    out->cycles = timing.rises - 1;
+    out->period = (timing.last_rise - timing.first_rise + (out->cycles / 2)) /
+                  out->cycles;
+    if (timing.cycle_sum > 0) {
+        uint64_t const scaled = (uint64_t)timing.high_sum * FIXED_SCALE;
+        out->duty_cycle = (FIXED_Q1616)(
+            (scaled + (timing.cycle_sum / 2)) / timing.cycle_sum
+        );
+    }
+}
+
+void WAVEFORM_measure(
+    uint16_t const *samples,
+    uint32_t count,
+    uint32_t stride,
+    WAVEFORM_Measurements *out
+)
+{
+    if (samples == nullptr || out == nullptr) {
+        LOG_ERROR("WAVEFORM: Buffer is NULL");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    if (count == 0 || count > WAVEFORM_SAMPLES_MAX || stride == 0) {
+        LOG_ERROR("WAVEFORM: Invalid sample count %u", count);
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    // A contiguous channel goes through the sample kernels of STATS
+    STATS_Summary summary = STATS_SUMMARY_EMPTY;
+    if (stride == 1) {
+        STATS_summarize(samples, count, &summary);
+    } else {
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t const sample = samples[i * stride];
+
+            summary.sum += sample;
+            summary.sum_squares += (uint64_t)sample * sample;
+            if (sample < summary.min) {
+                summary.min = (uint16_t)sample;
+            }
+            if (sample > summary.max) {
+                summary.max = (uint16_t)sample;
+            }
+        }
+        summary.count = count;
+    }
+
+    *out = (WAVEFORM_Measurements){
+        .min = summary.min,
+        .max = summary.max,
+        .mean = STATS_mean(&summary),
+        .rms = STATS_rms(&summary),
+    };
+
+    if (summary.max - summary.min >= WAVEFORM_SWING_MIN) {
+        measure_timing(samples, count, stride, out);
+    }
+}
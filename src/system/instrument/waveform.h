@@ -0,0 +1,83 @@
+/**
+ * @file waveform.h
+ * @brief Scalar measurements over a captured waveform
+ *
+ * Measures one channel of a sample buffer without copying it: amplitude
+ * statistics, and for periodic signals the period, 10-90% rise time and
+ * duty cycle. Amplitudes are in ADC codes and times in sample periods, so
+ * the caller scales them with its reference voltage and sample rate.
+ *
+ * Edges are found where the signal crosses the midpoint between its
+ * minimum and maximum, with a hysteresis of a tenth of the peak-to-peak
+ * swing so that noise on a slow edge counts once. Each crossing time is
+ * interpolated between the samples either side of the level. Timing is
+ * only measured over complete cycles, from the first to the last rising
+ * edge.
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#ifndef PSLAB_WAVEFORM_H
+#define PSLAB_WAVEFORM_H
+
+#include <stdint.h>
+
+#include "util/fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    /** @brief Fraction bits of times, in sample periods */
+    WAVEFORM_TIME_FRAC_BITS = 8,
+    /** @brief Smallest peak-to-peak swing, in codes, for timing results */
+    WAVEFORM_SWING_MIN = 10,
+    /** @brief Largest number of samples measured at once */
+    WAVEFORM_SAMPLES_MAX = 65536,
+};
+
+/**
+ * @brief Measurements of one channel
+ *
+ * Times are in units of 2^-WAVEFORM_TIME_FRAC_BITS sample periods. Timing
+ * results are 0 when the waveform has no complete cycle, or swings less
+ * than WAVEFORM_SWING_MIN codes.
+ */
+typedef struct {
+    uint16_t min; // Smallest sample
+    uint16_t max; // Largest sample
+    FIXED_Q1616 mean; // Mean in codes
+    FIXED_Q1616 rms; // Root mean square in codes
+    uint32_t cycles; // Complete cycles between the first and last rising edge
+    uint32_t period; // Mean period
+    uint32_t rise_time; // Mean 10% to 90% rise time, 0 without a rising edge
+    FIXED_Q1616 duty_cycle; // Fraction of each cycle above the midpoint
+} WAVEFORM_Measurements;
+
+/**
+ * @brief Measure one channel of a sample buffer
+ *
+ * @param samples First sample of the channel
+ * @param count Number of samples of the channel, at most
+ *              WAVEFORM_SAMPLES_MAX
+ * @param stride Distance between consecutive samples of the channel, e.g.
+ *               the number of interleaved channels
+ * @param out Measurements
+ *
+ * @throws ERROR_INVALID_ARGUMENT if samples or out is NULL, count is 0 or
+ * above WAVEFORM_SAMPLES_MAX, or stride is 0
+ */
+void WAVEFORM_measure(
+    uint16_t const *samples,
+    uint32_t count,
+    uint32_t stride,
+    WAVEFORM_Measurements *out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_WAVEFORM_H
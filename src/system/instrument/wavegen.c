@@ -0,0 +1,399 @@
+/**
+ * @file wavegen.c
+ * @brief Waveform generator implementation for PSLab firmware
+ *
+ * TIM7 paces the DAC_LL output. It is the one timer that cannot trigger
+ * the ADC, so TIM_LL_claim never hands it out, and the generator can play
+ * alongside any acquisition. Like the instruments' timers it is configured
+ * and run at the full system clock.
+ *
+ * Samples are computed once per configuration: a phase in 2^-32 turns per
+ * table entry, a shape from -1 to 1 in Q16.16, then volts and a DAC code.
+ *
+ * In DDS mode the same codes, at FIXED_DDS_TABLE_SIZE phases, make the
+ * interpolation table of FIXED_dds_fill, and the ring the DMA plays is
+ * refilled from its transfer complete interrupt, half by half. Both stay in
+ * SRAM, and the fill runs from RAM, so a refill takes a few cycles per
+ * code even while the ADC's DMA streams.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform/dac_ll.h"
+#include "platform/tim_ll.h"
+#include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/logging.h"
+#include "util/ramfunc.h"
+
+#include "clock.h"
+#include "wavegen.h"
+
+// The limits are repeated in wavegen.h, which does not expose the platform
+// layer
+static_assert((uint32_t)WAVEGEN_CODE_MAX == DAC_LL_CODE_MAX, "WG codes");
+static_assert(
+    (uint32_t)WAVEGEN_REFERENCE_MV == DAC_LL_REFERENCE_MV, "WG reference"
+);
+static_assert(
+    (uint32_t)WAVEGEN_SAMPLE_RATE_MAX == DAC_LL_SAMPLE_RATE_MAX, "WG rate"
+);
+static_assert(
+    (uint32_t)WAVEGEN_SAMPLES_MAX <= DAC_LL_SAMPLES_MAX, "WG samples"
+);
+
+// Timer pacing the output
+static TIM_Num const g_wavegen_timer = TIM_NUM_7;
+
+enum {
+    // Codes in the DDS ring; a half plays for 256 us
+    DDS_RING_SIZE = 512,
+};
+static_assert((uint32_t)DDS_RING_SIZE <= WAVEGEN_SAMPLES_MAX, "DDS ring");
+
+/**
+ * @brief Wavegen handle structure
+ */
+struct WAVEGEN_Handle {
+    WAVEGEN_Config config; // Samples point to the table
+    uint32_t phase; // DDS phase of the next code to compute
+    uint32_t step; // DDS phase increment per code
+    bool running;
+};
+
+// Storage for the only wavegen instance
+static WAVEGEN_Handle g_wavegen_storage;
+
+// One period of codes, read by the DMA
+static uint16_t g_wavegen_table[WAVEGEN_SAMPLES_MAX]
+    __attribute__((aligned(32)));
+
+// One period at FIXED_DDS_TABLE_SIZE phases, interpolated in DDS mode
+static uint32_t g_wavegen_dds_table[FIXED_DDS_TABLE_SIZE];
+
+// Static instance for handle checks
+static WAVEGEN_Handle *g_wavegen_handle = nullptr;
+
+static void check_handle(WAVEGEN_Handle const *handle)
+{
+    if (handle == nullptr || handle != g_wavegen_handle) {
+        LOG_ERROR("WAVEGEN: Invalid handle");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+/**
+ * @brief Value of a standard shape at a phase
+ *
+ * @return -1 to 1 in Q16.16
+ */
+static FIXED_Q1616 shape_value(WAVEGEN_Shape shape, uint32_t phase)
+{
+    switch (shape) {
+    case WAVEGEN_SHAPE_SQUARE:
+        return phase < (UINT32_C(1) << 31) ? FIXED_ONE : -FIXED_ONE;
+    case WAVEGEN_SHAPE_TRIANGLE: {
+        // Four units per turn; rising over the first two
+        FIXED_Q1616 const quarters = (FIXED_Q1616)(phase >> 14);
+        return quarters < 2 * FIXED_ONE ? quarters - FIXED_ONE
+                                        : 3 * FIXED_ONE - quarters;
+    }
+    case WAVEGEN_SHAPE_SAWTOOTH:
+        return (FIXED_Q1616)(phase >> 15) - FIXED_ONE;
+    case WAVEGEN_SHAPE_SINE:
+    default:
+        return FIXED_sin(phase);
+    }
+}
+
+/**
+ * @brief DAC code of a voltage, rounded and clipped to the output range
+ */
+static uint16_t volts_to_code(FIXED_Q1616 volts)
+{
+    int64_t const den = (int64_t)WAVEGEN_REFERENCE_MV * FIXED_SCALE;
+    int64_t const num = (int64_t)volts * WAVEGEN_CODE_MAX * 1000;
+
+    if (num <= 0) {
+        return 0;
+    }
+    int64_t const code = (num + den / 2) / den;
+    return code > WAVEGEN_CODE_MAX ? WAVEGEN_CODE_MAX : (uint16_t)code;
+}
+
+/**
+ * @brief Compute one period of a standard shape into the table
+ */
+static void build_table(WAVEGEN_Config const *config, uint32_t samples)
+{
+    for (uint32_t i = 0; i < samples; ++i) {
+        uint32_t const phase = (uint32_t)(((uint64_t)i << 32) / samples);
+        FIXED_Q1616 const value = shape_value(config->shape, phase);
+
+        g_wavegen_table[i] = volts_to_code(
+            FIXED_add(config->offset, FIXED_mul(config->amplitude, value))
+        );
+    }
+}
+
+/**
+ * @brief Compute one period of a standard shape into the DDS table
+ *
+ * The codes are computed into the ring first, which is filled from the
+ * DDS table only once the generator starts.
+ */
+static void build_dds_table(WAVEGEN_Config const *config)
+{
+    static_assert(
+        (uint32_t)FIXED_DDS_TABLE_SIZE <= WAVEGEN_SAMPLES_MAX, "DDS table"
+    );
+    build_table(config, FIXED_DDS_TABLE_SIZE);
+    for (uint32_t i = 0; i < FIXED_DDS_TABLE_SIZE; ++i) {
+        uint32_t const next = (i + 1) % FIXED_DDS_TABLE_SIZE;
+        g_wavegen_dds_table[i] =
+            FIXED_dds_entry(g_wavegen_table[i], g_wavegen_table[next]);
+    }
+}
+
+/**
+ * @brief Compute the next half of the DDS ring, on the DMA interrupt
+ */
+RAMFUNC static void dds_refill(uint16_t *block, uint32_t count)
+{
+    WAVEGEN_Handle *const handle = &g_wavegen_storage;
+
+    handle->phase = FIXED_dds_fill(
+        g_wavegen_dds_table, handle->phase, handle->step, block, count
+    );
+}
+
+static bool validate_codes(uint16_t const *samples, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        if (samples[i] > WAVEGEN_CODE_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool validate_config(WAVEGEN_Config const *config)
+{
+    if (!config || config->mode > WAVEGEN_MODE_DDS ||
+        config->shape > WAVEGEN_SHAPE_ARBITRARY ||
+        config->millihertz >= 1000) {
+        return false;
+    }
+    if (config->mode == WAVEGEN_MODE_DDS) {
+        uint64_t const millihertz =
+            (uint64_t)config->frequency * 1000 + config->millihertz;
+        return config->shape != WAVEGEN_SHAPE_ARBITRARY && millihertz > 0 &&
+               millihertz <= (uint64_t)WAVEGEN_FREQUENCY_MAX * 1000 &&
+               config->amplitude >= 0;
+    }
+    if (config->frequency == 0) {
+        return false;
+    }
+    if (config->shape != WAVEGEN_SHAPE_ARBITRARY) {
+        return config->frequency <= WAVEGEN_FREQUENCY_MAX &&
+               config->amplitude >= 0;
+    }
+    return config->samples && config->sample_count > 0 &&
+           config->sample_count <= WAVEGEN_SAMPLES_MAX &&
+           (uint64_t)config->frequency * config->sample_count <=
+               WAVEGEN_SAMPLE_RATE_MAX &&
+           validate_codes(config->samples, config->sample_count);
+}
+
+/**
+ * @brief Codes per period: the uploaded ones, or as many as the rate allows
+ */
+static uint32_t samples_per_period(WAVEGEN_Config const *config)
+{
+    if (config->mode == WAVEGEN_MODE_DDS) {
+        return DDS_RING_SIZE;
+    }
+    if (config->shape == WAVEGEN_SHAPE_ARBITRARY) {
+        return config->sample_count;
+    }
+    uint32_t const samples = WAVEGEN_SAMPLE_RATE_MAX / config->frequency;
+    return samples < WAVEGEN_SAMPLES_MAX ? samples : WAVEGEN_SAMPLES_MAX;
+}
+
+/**
+ * @brief Set the DDS step nearest the requested frequency
+ *
+ * @param rate Achieved code rate in Hz
+ * @return Achieved frequency in millihertz
+ */
+static uint64_t set_dds_step(
+    WAVEGEN_Handle *handle,
+    WAVEGEN_Config const *config,
+    uint32_t rate
+)
+{
+    uint64_t const millihertz =
+        (uint64_t)config->frequency * 1000 + config->millihertz;
+    uint64_t const den = (uint64_t)rate * 1000;
+
+    handle->step = (uint32_t)(((millihertz << 32) + den / 2) / den);
+    return ((uint64_t)handle->step * den + (UINT64_C(1) << 31)) >> 32;
+}
+
+WAVEGEN_Handle *WAVEGEN_init(WAVEGEN_Config const *config)
+{
+    if (!validate_config(config)) {
+        LOG_ERROR("WAVEGEN: Invalid configuration");
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_wavegen_handle != nullptr) {
+        LOG_ERROR("WAVEGEN: Already initialized");
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    WAVEGEN_Handle *const handle = &g_wavegen_storage;
+    uint32_t const samples = samples_per_period(config);
+
+    handle->config = *config;
+    handle->config.millihertz = 0;
+    handle->phase = 0;
+    handle->step = 0;
+    handle->running = false;
+    if (config->mode == WAVEGEN_MODE_DDS) {
+        build_dds_table(config);
+    } else if (config->shape == WAVEGEN_SHAPE_ARBITRARY) {
+        memcpy(g_wavegen_table, config->samples, samples * sizeof(uint16_t));
+    } else {
+        build_table(config, samples);
+    }
+    handle->config.samples = g_wavegen_table;
+    handle->config.sample_count = samples;
+
+    CLOCK_request();
+    Error error = ERROR_NONE;
+    TRY
+    {
+        bool const dds = config->mode == WAVEGEN_MODE_DDS;
+        uint32_t const rate = TIM_LL_init(
+            g_wavegen_timer,
+            dds ? WAVEGEN_DDS_SAMPLE_RATE : config->frequency * samples
+        );
+        if (dds) {
+            uint64_t const millihertz = set_dds_step(handle, config, rate);
+            handle->config.frequency = (uint32_t)(millihertz / 1000);
+            handle->config.millihertz = (uint32_t)(millihertz % 1000);
+        } else {
+            handle->config.frequency = (rate + samples / 2) / samples;
+        }
+        DAC_LL_init(&(DAC_LL_Config){
+            .timer = g_wavegen_timer,
+            .samples = g_wavegen_table,
+            .count = samples,
+            .block_callback = dds ? dds_refill : nullptr,
+        });
+    }
+    CATCH(error)
+    {
+        CLOCK_release();
+        LOG_ERROR("WAVEGEN: Init failed, error %d", error);
+        TIM_LL_deinit(g_wavegen_timer);
+        THROW(error);
+    }
+    CLOCK_release();
+
+    g_wavegen_handle = handle;
+    LOG_INFO(
+        "WAVEGEN: Init %u samples at %u.%03u Hz (%u.%03u requested)",
+        samples,
+        handle->config.frequency,
+        handle->config.millihertz,
+        config->frequency,
+        config->millihertz
+    );
+    return handle;
+}
+
+void WAVEGEN_deinit(WAVEGEN_Handle *handle)
+{
+    if (handle == nullptr) {
+        return;
+    }
+    check_handle(handle);
+
+    Error error = ERROR_NONE;
+    TRY
+    {
+        WAVEGEN_stop(handle);
+        DAC_LL_deinit();
+        TIM_LL_deinit(g_wavegen_timer);
+    }
+    CATCH(error)
+    {
+        LOG_ERROR("WAVEGEN: Deinitialization failed, error %d", error);
+        // Don't throw, continue with handle cleanup
+    }
+
+    g_wavegen_handle = nullptr;
+}
+
+void WAVEGEN_start(WAVEGEN_Handle *handle)
+{
+    check_handle(handle);
+
+    if (handle->running) {
+        return;
+    }
+
+    if (handle->config.mode == WAVEGEN_MODE_DDS) {
+        // Both halves are ready before the first refill is due
+        handle->phase = 0;
+        dds_refill(g_wavegen_table, DDS_RING_SIZE);
+    }
+
+    CLOCK_request();
+    Error error = ERROR_NONE;
+    TRY
+    {
+        // The DAC converts on the first update event
+        DAC_LL_start();
+        TIM_LL_start(g_wavegen_timer);
+    }
+    CATCH(error)
+    {
+        LOG_ERROR("WAVEGEN: Failed to start, error %d", error);
+        DAC_LL_stop();
+        CLOCK_release();
+        THROW(error);
+    }
+    handle->running = true;
+}
+
+void WAVEGEN_stop(WAVEGEN_Handle *handle)
+{
+    check_handle(handle);
+
+    TIM_LL_stop(g_wavegen_timer);
+    DAC_LL_stop();
+    if (handle->running) {
+        handle->running = false;
+        CLOCK_release();
+    }
+}
+
+bool WAVEGEN_is_running(WAVEGEN_Handle const *handle)
+{
+    check_handle(handle);
+    return handle->running;
+}
+
+WAVEGEN_Config WAVEGEN_get_config(WAVEGEN_Handle const *handle)
+{
+    check_handle(handle);
+    return handle->config;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file wavegen.h
+ * @brief Waveform generator interface for PSLab firmware
+ *
+ * This header provides a generator that plays a periodic waveform on the
+ * DAC output, using the DAC_LL API. One period is computed into a table of
+ * codes, and a timer paces a circular DMA from the table to the DAC, so the
+ * CPU does no work per sample while the waveform plays.
+ *
+ * Standard shapes are computed in fixed point from an amplitude and an
+ * offset in volts. An arbitrary shape plays DAC codes uploaded by the
+ * caller.
+ *
+ * The table's frequency is the rate divided by a whole number of codes, so
+ * standard shapes may instead be synthesized directly (DDS): a 32-bit
+ * phase accumulator steps through an interpolated period at a fixed rate,
+ * with millihertz resolution at any frequency. The codes are computed on
+ * the fly into two halves of a ring, each refilled while the DMA plays the
+ * other.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_WAVEGEN_H
+#define PSLAB_WAVEGEN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Wavegen handle structure (opaque)
+ */
+typedef struct WAVEGEN_Handle WAVEGEN_Handle;
+
+enum {
+    /** @brief Highest DAC code */
+    WAVEGEN_CODE_MAX = 4095,
+    /** @brief Output voltage of WAVEGEN_CODE_MAX in millivolts */
+    WAVEGEN_REFERENCE_MV = 3300,
+    /** @brief Highest rate at which codes are output, in Hz */
+    WAVEGEN_SAMPLE_RATE_MAX = 1000000,
+    /** @brief Largest number of codes per period */
+    WAVEGEN_SAMPLES_MAX = 4096,
+    /** @brief Smallest number of codes per period of a standard shape */
+    WAVEGEN_SAMPLES_MIN = 16,
+    /** @brief Highest frequency of a standard shape in Hz */
+    WAVEGEN_FREQUENCY_MAX = WAVEGEN_SAMPLE_RATE_MAX / WAVEGEN_SAMPLES_MIN,
+    /** @brief Rate at which DDS codes are output, in Hz */
+    WAVEGEN_DDS_SAMPLE_RATE = WAVEGEN_SAMPLE_RATE_MAX,
+};
+
+/**
+ * @brief How the waveform is generated
+ */
+typedef enum {
+    WAVEGEN_MODE_TABLE, /**< One period computed once and repeated */
+    WAVEGEN_MODE_DDS, /**< Phase accumulator, standard shapes only */
+} WAVEGEN_Mode;
+
+/**
+ * @brief Shape of the waveform
+ */
+typedef enum {
+    WAVEGEN_SHAPE_SINE,
+    WAVEGEN_SHAPE_SQUARE, /**< 50 % duty cycle, high first */
+    WAVEGEN_SHAPE_TRIANGLE, /**< Rising from the minimum first */
+    WAVEGEN_SHAPE_SAWTOOTH, /**< Rising from the minimum */
+    WAVEGEN_SHAPE_ARBITRARY, /**< Codes uploaded by the caller */
+} WAVEGEN_Shape;
+
+/**
+ * @brief Wavegen configuration structure
+ */
+typedef struct {
+    WAVEGEN_Mode mode; /**< How the waveform is generated */
+    WAVEGEN_Shape shape; /**< Shape of the waveform */
+    uint32_t frequency; /**< Frequency of the waveform in Hz */
+    uint32_t millihertz; /**< Fraction of the frequency, 0 to 999, DDS */
+    FIXED_Q1616 amplitude; /**< Peak voltage above the offset, standard */
+    FIXED_Q1616 offset; /**< Voltage of the waveform's center, standard */
+    uint16_t const *samples; /**< One period of codes, arbitrary shape */
+    uint32_t sample_count; /**< Codes in samples, arbitrary shape */
+} WAVEGEN_Config;
+
+/**
+ * @brief Default wavegen configuration: a 1 kHz sine over the full range
+ */
+#define WAVEGEN_CONFIG_DEFAULT                                                 \
+    {                                                                          \
+        .mode = WAVEGEN_MODE_TABLE, .shape = WAVEGEN_SHAPE_SINE,               \
+        .frequency = 1000, .millihertz = 0,                                    \
+        .amplitude = FIXED_FROM_FLOAT(1.65), .offset = FIXED_FROM_FLOAT(1.65), \
+        .samples = nullptr, .sample_count = 0,                                 \
+    }
+
+/**
+ * @brief Initialize the waveform generator
+ *
+ * Computes, or copies, one period into the table and configures the timer
+ * and the DAC. A standard shape gets as many codes per period as the
+ * sample rate allows, up to WAVEGEN_SAMPLES_MAX. In DDS mode one period
+ * is computed into the interpolation table instead. Voltages outside the
+ * output range are clipped.
+ *
+ * @param config Pointer to wavegen configuration structure
+ * @return Pointer to wavegen handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if config is NULL or contains invalid
+ *         values, e.g. an arbitrary shape whose codes at the frequency would
+ *         exceed WAVEGEN_SAMPLE_RATE_MAX, or in DDS mode
+ * @throws ERROR_RESOURCE_BUSY if the generator is already initialized
+ * @throws ERROR_HARDWARE_FAULT if the DAC or the DMA cannot be configured
+ */
+WAVEGEN_Handle *WAVEGEN_init(WAVEGEN_Config const *config);
+
+/**
+ * @brief Deinitialize the waveform generator
+ *
+ * Stops the output and releases the timer and the DAC. The handle becomes
+ * invalid.
+ *
+ * @param handle Pointer to wavegen handle, or NULL to do nothing
+ */
+void WAVEGEN_deinit(WAVEGEN_Handle *handle);
+
+/**
+ * @brief Start playing the waveform
+ *
+ * The table repeats, or the DDS phase runs from 0, until WAVEGEN_stop.
+ *
+ * @param handle Pointer to wavegen handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ * @throws ERROR_HARDWARE_FAULT if the DMA cannot be started
+ */
+void WAVEGEN_start(WAVEGEN_Handle *handle);
+
+/**
+ * @brief Stop the waveform, which holds the last output voltage
+ *
+ * @param handle Pointer to wavegen handle
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ */
+void WAVEGEN_stop(WAVEGEN_Handle *handle);
+
+/**
+ * @brief Check if the waveform is playing
+ *
+ * @param handle Pointer to wavegen handle
+ * @return true between WAVEGEN_start and WAVEGEN_stop
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ */
+bool WAVEGEN_is_running(WAVEGEN_Handle const *handle);
+
+/**
+ * @brief Get current wavegen configuration
+ *
+ * The frequency is the one achieved, rounded to nearest, to the Hz in
+ * table mode and to the millihertz in DDS mode. The samples of a standard
+ * shape point to its computed table; in DDS mode they point to the ring.
+ *
+ * @param handle Pointer to wavegen handle
+ * @return Copy of the current wavegen configuration
+ *
+ * @throws ERROR_INVALID_ARGUMENT if handle is NULL or invalid
+ */
+WAVEGEN_Config WAVEGEN_get_config(WAVEGEN_Handle const *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_WAVEGEN_H
@@ -0,0 +1,398 @@
+/**
+ * @file kvstore.c
+ * @brief Wear-levelled key-value store in flash
+ *
+ * Each sector starts with a header holding a magic word and a sequence
+ * number; the sector with the highest sequence number is the active one.
+ * It is followed by records, each a 16-byte record header and the value,
+ * padded to the programming unit of the flash:
+ *
+ *     | key (16) | size (16) | CRC-32 (32) | reserved (64) | value ... |
+ *
+ * The CRC covers the key, the size and the value. A record of size zero
+ * drops the key. Records are appended until the first erased record
+ * header, which marks the end of the log.
+ *
+ * When the active sector is full, the other one is erased and the last
+ * record of each key is copied over. Its header is programmed last, so
+ * that a compaction cut short by a reset leaves the active sector as it
+ * was.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform/flash_ll.h"
+#include "util/crc.h"
+#include "util/error.h"
+#include "util/logging.h"
+
+#include "kvstore.h"
+
+enum {
+    KV_MAGIC = 0x4B565354, // "KVST"
+    KV_SECTOR_SIZE = FLASH_LL_SECTOR_SIZE,
+    KV_SECTOR_COUNT = FLASH_LL_KV_SIZE / FLASH_LL_SECTOR_SIZE,
+    KV_HEADER_SIZE = FLASH_LL_WRITE_ALIGN,
+    KV_ERASED_KEY = 0xFFFF,
+    KV_RECORD_MAX = KV_HEADER_SIZE + KVSTORE_VALUE_MAX,
+};
+
+static_assert(KV_SECTOR_COUNT == 2, "The store alternates two sectors");
+static_assert(
+    KVSTORE_VALUE_MAX % FLASH_LL_WRITE_ALIGN == 0,
+    "Largest record must fill whole flash words"
+);
+
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t reserved[2];
+} SectorHeader;
+
+typedef struct {
+    uint16_t key;
+    uint16_t size;
+    uint32_t crc;
+    uint32_t reserved[2];
+} RecordHeader;
+
+static_assert(sizeof(SectorHeader) == KV_HEADER_SIZE, "Sector header size");
+static_assert(sizeof(RecordHeader) == KV_HEADER_SIZE, "Record header size");
+
+static struct {
+    bool ready;
+    uint32_t base; // Offset of the active sector
+    uint32_t sequence; // Sequence number of the active sector
+    uint32_t end; // Offset of the end of the log in the active sector
+    // Offset of the last record of each key in the active sector, 0 if none
+    uint16_t index[KVSTORE_KEY_COUNT];
+} g_kv = { .ready = false };
+
+// A record on its way to or from the flash, aligned as the flash needs
+static union {
+    uint32_t words[KV_RECORD_MAX / sizeof(uint32_t)];
+    uint8_t bytes[KV_RECORD_MAX];
+    RecordHeader header;
+} g_staging;
+
+/**
+ * @brief Bytes taken by a record with a value of the given size
+ */
+static uint32_t record_span(uint32_t size)
+{
+    return KV_HEADER_SIZE +
+           ((size + FLASH_LL_WRITE_ALIGN - 1) & ~(FLASH_LL_WRITE_ALIGN - 1U));
+}
+
+static uint32_t record_crc(RecordHeader const *header, void const *value)
+{
+    uint32_t crc =
+        CRC32_update(CRC32_INIT, &header->key, sizeof(header->key));
+    crc = CRC32_update(crc, &header->size, sizeof(header->size));
+    return CRC32_update(crc, value, header->size);
+}
+
+/**
+ * @brief Check that a sector holds a store, and take its sequence number
+ */
+static bool sector_is_valid(uint32_t base, uint32_t *sequence)
+{
+    SectorHeader header;
+
+    FLASH_LL_kv_read(base, &header, sizeof(header));
+    *sequence = header.sequence;
+    return header.magic == KV_MAGIC;
+}
+
+/**
+ * @brief Read the record at an offset of the active sector into staging
+ *
+ * @return false if the record was cut short, or its header is corrupt
+ */
+static bool load_record(uint32_t offset)
+{
+    RecordHeader *const header = &g_staging.header;
+
+    FLASH_LL_kv_read(g_kv.base + offset, header, sizeof(*header));
+    if (header->size > KVSTORE_VALUE_MAX) {
+        return false;
+    }
+    // With the padding, so that the record can be copied as it is
+    FLASH_LL_kv_read(
+        g_kv.base + offset + KV_HEADER_SIZE,
+        &g_staging.bytes[KV_HEADER_SIZE],
+        record_span(header->size) - KV_HEADER_SIZE
+    );
+    return header->crc == record_crc(header, &g_staging.bytes[KV_HEADER_SIZE]);
+}
+
+/**
+ * @brief Replay the log of the active sector into the index
+ */
+static void build_index(void)
+{
+    memset(g_kv.index, 0, sizeof(g_kv.index));
+
+    uint32_t offset = KV_HEADER_SIZE;
+    while (offset + KV_HEADER_SIZE <= KV_SECTOR_SIZE) {
+        RecordHeader header;
+        FLASH_LL_kv_read(g_kv.base + offset, &header, sizeof(header));
+        if (header.key == KV_ERASED_KEY) {
+            break;
+        }
+        uint32_t const span = record_span(header.size);
+        if (header.size > KVSTORE_VALUE_MAX ||
+            span > KV_SECTOR_SIZE - offset) {
+            // The rest of the sector cannot be trusted; compact on next write
+            LOG_ERROR("KV: Corrupt record at 0x%04lX", (unsigned long)offset);
+            offset = KV_SECTOR_SIZE;
+            break;
+        }
+        // Records whose CRC does not match were cut short; skipped
+        if (header.key < KVSTORE_KEY_COUNT && load_record(offset)) {
+            g_kv.index[header.key] = header.size > 0 ? (uint16_t)offset : 0;
+        }
+        offset += span;
+    }
+    g_kv.end = offset;
+}
+
+/**
+ * @brief Program a record from staging at the end of the log
+ */
+static void append(uint32_t key, void const *value, uint32_t size)
+{
+    RecordHeader *const header = &g_staging.header;
+    uint32_t const span = record_span(size);
+
+    memset(g_staging.bytes, 0xFF, span);
+    header->key = (uint16_t)key;
+    header->size = (uint16_t)size;
+    if (size > 0) {
+        memcpy(&g_staging.bytes[KV_HEADER_SIZE], value, size);
+    }
+    header->crc = record_crc(header, &g_staging.bytes[KV_HEADER_SIZE]);
+
+    FLASH_LL_kv_write(g_kv.base + g_kv.end, g_staging.words, span);
+    g_kv.index[key] = size > 0 ? (uint16_t)g_kv.end : 0;
+    g_kv.end += span;
+}
+
+/**
+ * @brief Erase a sector and start an empty store in it
+ */
+static void format(uint32_t base, uint32_t sequence)
+{
+    SectorHeader const header = {
+        .magic = KV_MAGIC,
+        .sequence = sequence,
+        .reserved = { UINT32_MAX, UINT32_MAX },
+    };
+
+    FLASH_LL_kv_erase(base);
+    FLASH_LL_kv_write(base, &header, sizeof(header));
+    g_kv.base = base;
+    g_kv.sequence = sequence;
+    g_kv.end = KV_HEADER_SIZE;
+    memset(g_kv.index, 0, sizeof(g_kv.index));
+}
+
+/**
+ * @brief Copy the values in use to the other sector, and make it active
+ */
+static void compact(void)
+{
+    uint32_t const base = g_kv.base == 0 ? KV_SECTOR_SIZE : 0;
+    uint16_t index[KVSTORE_KEY_COUNT] = { 0 };
+    uint32_t end = KV_HEADER_SIZE;
+
+    FLASH_LL_kv_erase(base);
+    for (uint32_t key = 0; key < KVSTORE_KEY_COUNT; ++key) {
+        if (g_kv.index[key] == 0) {
+            continue;
+        }
+        // Checked when the index was built
+        (void)load_record(g_kv.index[key]);
+        uint32_t const span = record_span(g_staging.header.size);
+        FLASH_LL_kv_write(base + end, g_staging.words, span);
+        index[key] = (uint16_t)end;
+        end += span;
+    }
+
+    SectorHeader const header = {
+        .magic = KV_MAGIC,
+        .sequence = g_kv.sequence + 1,
+        .reserved = { UINT32_MAX, UINT32_MAX },
+    };
+    FLASH_LL_kv_write(base, &header, sizeof(header));
+
+    g_kv.base = base;
+    g_kv.sequence = header.sequence;
+    g_kv.end = end;
+    memcpy(g_kv.index, index, sizeof(index));
+    LOG_INFO("KV: Compacted, %lu bytes in use", (unsigned long)end);
+}
+
+/**
+ * @brief Bytes taken by the records in use, after the sector header
+ */
+static uint32_t live_size(void)
+{
+    uint32_t size = 0;
+
+    for (uint32_t key = 0; key < KVSTORE_KEY_COUNT; ++key) {
+        if (g_kv.index[key] != 0) {
+            RecordHeader header;
+            FLASH_LL_kv_read(
+                g_kv.base + g_kv.index[key], &header, sizeof(header)
+            );
+            size += record_span(header.size);
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Make room at the end of the log for a record of a key
+ *
+ * When the active sector is full, it is compacted without the value of the
+ * key, which the record replaces.
+ *
+ * @return true if the sector was compacted
+ *
+ * @throws ERROR_OUT_OF_MEMORY if the other values leave no room
+ * @throws ERROR_HARDWARE_FAULT if the flash cannot be erased or written
+ */
+static bool make_room(uint32_t key, uint32_t span)
+{
+    if (span <= KV_SECTOR_SIZE - g_kv.end) {
+        return false;
+    }
+
+    uint16_t const previous = g_kv.index[key];
+    g_kv.index[key] = 0;
+    if (span > KV_SECTOR_SIZE - KV_HEADER_SIZE - live_size()) {
+        g_kv.index[key] = previous;
+        THROW(ERROR_OUT_OF_MEMORY);
+    }
+
+    Error error = ERROR_NONE;
+    TRY { compact(); }
+    CATCH(error)
+    {
+        g_kv.index[key] = previous;
+        THROW(error);
+    }
+    return true;
+}
+
+/**
+ * @brief Check that a call may write to the store
+ *
+ * @throws ERROR_INVALID_ARGUMENT if the key is invalid
+ * @throws ERROR_DEVICE_NOT_READY if the store could not be initialized
+ */
+static void check_writable(uint32_t key)
+{
+    if (key >= KVSTORE_KEY_COUNT) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (!g_kv.ready) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+}
+
+void KVSTORE_init(void)
+{
+    uint32_t sequences[KV_SECTOR_COUNT] = { 0 };
+    bool valid[KV_SECTOR_COUNT] = { false };
+    Error err = ERROR_NONE;
+
+    g_kv.ready = false;
+    TRY
+    {
+        for (uint32_t i = 0; i < KV_SECTOR_COUNT; ++i) {
+            valid[i] = sector_is_valid(i * KV_SECTOR_SIZE, &sequences[i]);
+        }
+
+        if (!valid[0] && !valid[1]) {
+            LOG_INFO("KV: No store found, formatting");
+            format(0, 1);
+        } else {
+            // The later of two valid sectors, allowing for wraparound
+            bool const second =
+                !valid[0] ||
+                (valid[1] && (int32_t)(sequences[1] - sequences[0]) > 0);
+            g_kv.base = second ? KV_SECTOR_SIZE : 0;
+            g_kv.sequence = sequences[second ? 1 : 0];
+            build_index();
+        }
+        g_kv.ready = true;
+    }
+    CATCH(err)
+    {
+        LOG_ERROR("KV: Store unavailable (%d)", err);
+    }
+}
+
+uint32_t KVSTORE_size(uint32_t key)
+{
+    if (!g_kv.ready || key >= KVSTORE_KEY_COUNT || g_kv.index[key] == 0) {
+        return 0;
+    }
+
+    RecordHeader header;
+    FLASH_LL_kv_read(g_kv.base + g_kv.index[key], &header, sizeof(header));
+    return header.size;
+}
+
+bool KVSTORE_get(uint32_t key, void *data, uint32_t size)
+{
+    if (!data || size == 0 || KVSTORE_size(key) != size) {
+        return false;
+    }
+
+    FLASH_LL_kv_read(
+        g_kv.base + g_kv.index[key] + KV_HEADER_SIZE, data, size
+    );
+    return true;
+}
+
+void KVSTORE_set(uint32_t key, void const *data, uint32_t size)
+{
+    check_writable(key);
+    if (!data || size == 0 || size > KVSTORE_VALUE_MAX) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    // Rewriting an unchanged value would only wear the flash
+    if (KVSTORE_size(key) == size) {
+        (void)load_record(g_kv.index[key]);
+        if (memcmp(&g_staging.bytes[KV_HEADER_SIZE], data, size) == 0) {
+            return;
+        }
+    }
+
+    (void)make_room(key, record_span(size));
+    append(key, data, size);
+}
+
+void KVSTORE_remove(uint32_t key)
+{
+    check_writable(key);
+    if (g_kv.index[key] == 0) {
+        return;
+    }
+
+    // A compaction leaves the key out, without a record to drop it
+    if (make_room(key, record_span(0))) {
+        return;
+    }
+    append(key, nullptr, 0);
+}
@@ -0,0 +1,112 @@
+/**
+ * @file kvstore.h
+ * @brief Wear-levelled key-value store in flash
+ *
+ * Small values that must survive a power cycle, such as saved instrument
+ * states and stream settings, are kept under numeric keys in two flash
+ * sectors of their own, so that they are in place from boot on instead of
+ * being sent by the host after each power cycle:
+ *
+ *     KVSTORE_init(); // once at boot
+ *     ...
+ *     if (!KVSTORE_get(KVSTORE_KEY_..., &settings, sizeof(settings))) {
+ *         ... use the defaults ...
+ *     }
+ *     ...
+ *     KVSTORE_set(KVSTORE_KEY_..., &settings, sizeof(settings));
+ *
+ * Writes are appended to the active sector, so that a value is written
+ * anew without erasing. When the sector is full, the values still in use
+ * are copied to the other sector, which then becomes the active one; the
+ * sectors take turns at being erased. A write cut short by a reset is
+ * detected by its CRC and ignored, which leaves the previous value. An
+ * index built at boot holds the location of each key, so lookups take no
+ * scan of the flash.
+ *
+ * Keys are allotted by the modules using the store, below KVSTORE_KEY_COUNT.
+ * A value is taken back only with the size it was stored with, so that a
+ * module changing the layout of its value falls back to its defaults
+ * instead of reading the old layout.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef SYSTEM_KVSTORE_H
+#define SYSTEM_KVSTORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    KVSTORE_KEY_COUNT = 64, // Keys are 0 to KVSTORE_KEY_COUNT - 1
+    KVSTORE_VALUE_MAX = 496, // Largest value in bytes
+};
+
+/**
+ * @brief Find the active sector and build the index
+ *
+ * Called once at boot. Erased or foreign sectors are formatted as an empty
+ * store. Until this has succeeded, no key is found and KVSTORE_set throws.
+ */
+void KVSTORE_init(void);
+
+/**
+ * @brief Size of the value stored under a key
+ *
+ * @param key Key, below KVSTORE_KEY_COUNT
+ * @return Size in bytes, or 0 if the key holds no value
+ */
+uint32_t KVSTORE_size(uint32_t key);
+
+/**
+ * @brief Read the value stored under a key
+ *
+ * @param key Key, below KVSTORE_KEY_COUNT
+ * @param data Destination buffer
+ * @param size Size of the value expected
+ * @return false if the key holds no value, or one of another size; @p data
+ *         is then left as it was
+ */
+bool KVSTORE_get(uint32_t key, void *data, uint32_t size);
+
+/**
+ * @brief Store a value under a key, replacing the previous one
+ *
+ * A value equal to the stored one is not written again. May block for
+ * the erase of a sector, a few milliseconds, when the active sector is
+ * full.
+ *
+ * @param key Key, below KVSTORE_KEY_COUNT
+ * @param data Value to store
+ * @param size Size in bytes, 1 to KVSTORE_VALUE_MAX
+ *
+ * @throws ERROR_INVALID_ARGUMENT if the key, data or size are invalid
+ * @throws ERROR_DEVICE_NOT_READY if the store could not be initialized
+ * @throws ERROR_OUT_OF_MEMORY if the values in use leave no room for it
+ * @throws ERROR_HARDWARE_FAULT if the flash cannot be erased or written
+ */
+void KVSTORE_set(uint32_t key, void const *data, uint32_t size);
+
+/**
+ * @brief Drop the value stored under a key
+ *
+ * Does nothing if the key holds no value.
+ *
+ * @param key Key, below KVSTORE_KEY_COUNT
+ *
+ * @throws ERROR_INVALID_ARGUMENT if the key is invalid
+ * @throws ERROR_DEVICE_NOT_READY if the store could not be initialized
+ * @throws ERROR_HARDWARE_FAULT if the flash cannot be erased or written
+ */
+void KVSTORE_remove(uint32_t key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_KVSTORE_H
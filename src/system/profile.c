@@ -0,0 +1,101 @@
+/**
+ * @file profile.c
+ * @brief Cycle-accurate profiling of code zones
+ *
+ * See profile.h for how zones are used.
+ */
+
+#include <stdint.h>
+
+#include "platform/platform.h"
+
+#include "profile.h"
+
+// Updated from the zone's context; count is written last so that readers
+// in other contexts can detect a concurrent update
+static PROFILE_Stats volatile g_zones[PROFILE_ZONE_COUNT];
+
+// Completion times of the boot stages in microseconds, 0 until marked
+static uint32_t g_boot_times[PROFILE_BOOT_COUNT];
+
+uint32_t PROFILE_begin(void) { return PLATFORM_get_cycles(); }
+
+/**
+ * @brief Add a run to a set of durations, the count last
+ */
+static void add_run(PROFILE_Stats volatile *stats, uint32_t cycles)
+{
+    uint32_t const count = stats->count;
+    if (count == 0 || cycles < stats->min) {
+        stats->min = cycles;
+    }
+    if (cycles > stats->max) {
+        stats->max = cycles;
+    }
+    stats->total += cycles;
+    stats->count = count + 1;
+}
+
+void PROFILE_end(PROFILE_Zone zone, uint32_t start)
+{
+    uint32_t const cycles = PLATFORM_get_cycles() - start;
+
+    if ((uint32_t)zone >= PROFILE_ZONE_COUNT) {
+        return;
+    }
+    add_run(&g_zones[zone], cycles);
+}
+
+void PROFILE_record(PROFILE_Stats *stats, uint32_t start)
+{
+    add_run(stats, PLATFORM_get_cycles() - start);
+}
+
+PROFILE_Stats PROFILE_get(PROFILE_Zone zone)
+{
+    PROFILE_Stats snapshot = { 0 };
+
+    if ((uint32_t)zone >= PROFILE_ZONE_COUNT) {
+        return snapshot;
+    }
+
+    PROFILE_Stats volatile const *const stats = &g_zones[zone];
+    uint32_t count = 0;
+    do {
+        count = stats->count;
+        snapshot.min = stats->min;
+        snapshot.max = stats->max;
+        snapshot.total = stats->total;
+    } while (count != stats->count);
+    snapshot.count = count;
+
+    return snapshot;
+}
+
+void PROFILE_clear(void)
+{
+    for (uint32_t i = 0; i < PROFILE_ZONE_COUNT; ++i) {
+        g_zones[i] = (PROFILE_Stats){ 0 };
+    }
+}
+
+uint32_t PROFILE_get_frequency(void) { return PLATFORM_get_cycle_frequency(); }
+
+void PROFILE_boot_mark(PROFILE_BootStage stage)
+{
+    if ((uint32_t)stage >= PROFILE_BOOT_COUNT || g_boot_times[stage] != 0) {
+        return;
+    }
+
+    uint32_t const now = PLATFORM_get_time_us();
+    // Zero means not marked
+    g_boot_times[stage] = now != 0 ? now : 1;
+}
+
+uint32_t PROFILE_get_boot_time(PROFILE_BootStage stage)
+{
+    if ((uint32_t)stage >= PROFILE_BOOT_COUNT) {
+        return 0;
+    }
+    return g_boot_times[stage];
+}
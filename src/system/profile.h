@@ -0,0 +1,160 @@
+/**
+ * @file profile.h
+ * @brief Cycle-accurate profiling of code zones
+ *
+ * A zone is a section of code, such as a task or an interrupt handler,
+ * whose duration is measured with the CPU cycle counter each time it runs.
+ * Per zone, the number of runs and the shortest, longest and total
+ * duration are kept:
+ *
+ *     PROFILE_BEGIN(PROFILE_ZONE_LOG);
+ *     LOG_task(0xF);
+ *     PROFILE_END(PROFILE_ZONE_LOG);
+ *
+ * Each zone must only be entered from one context, either the main loop or
+ * one interrupt, and must not be nested within itself. A run costs two
+ * cycle counter reads and a few compares, so zones can stay in place in
+ * release builds.
+ *
+ * The boot sequence is timed separately: each stage is marked once, with
+ * the microsecond time it completed at.
+ */
+
+#ifndef SYSTEM_PROFILE_H
+#define SYSTEM_PROFILE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Profiled zones
+ */
+typedef enum {
+    PROFILE_ZONE_PROTOCOL, /**< protocol_task, including USB_task */
+    PROFILE_ZONE_USB, /**< USB_task in polled mode */
+    PROFILE_ZONE_LOG, /**< LOG_task */
+    PROFILE_ZONE_USB_ISR, /**< USB service interrupt */
+    PROFILE_ZONE_DSO_ISR, /**< DSO ADC DMA interrupts */
+    PROFILE_ZONE_COUNT,
+} PROFILE_Zone;
+
+/**
+ * @brief Boot stages, in the order they complete
+ */
+typedef enum {
+    PROFILE_BOOT_PLATFORM, /**< Clocks and HAL up, after PLATFORM_init */
+    PROFILE_BOOT_USB, /**< USB attached, the host may enumerate */
+    PROFILE_BOOT_SYSTEM, /**< Log UART, LEDs, calibration and store up */
+    PROFILE_BOOT_READY, /**< Main loop entered */
+    PROFILE_BOOT_FIRST_RESPONSE, /**< First SCPI response sent to USB */
+    PROFILE_BOOT_COUNT,
+} PROFILE_BootStage;
+
+/**
+ * @brief Durations of one zone in CPU cycles
+ */
+typedef struct {
+    uint32_t count; /**< Completed runs */
+    uint32_t min; /**< Shortest run, or 0 without runs */
+    uint32_t max; /**< Longest run */
+    uint64_t total; /**< Sum of all runs */
+} PROFILE_Stats;
+
+/**
+ * @brief Start timing a zone in the current scope
+ *
+ * @param zone PROFILE_Zone constant to time
+ */
+#define PROFILE_BEGIN(zone)                                                    \
+    uint32_t const profile_start_##zone = PROFILE_begin()
+
+/**
+ * @brief Stop timing a zone started with PROFILE_BEGIN in the same scope
+ *
+ * @param zone PROFILE_Zone constant passed to PROFILE_BEGIN
+ */
+#define PROFILE_END(zone) PROFILE_end((zone), profile_start_##zone)
+
+/**
+ * @brief Read the cycle counter at the start of a zone
+ *
+ * @return Start time for PROFILE_end
+ */
+uint32_t PROFILE_begin(void);
+
+/**
+ * @brief Record a run of a zone
+ *
+ * Runs that wrap the cycle counter more than once are recorded modulo
+ * 2^32 cycles. Out-of-range zones are ignored.
+ *
+ * @param zone Zone that ran
+ * @param start Value returned by PROFILE_begin at the start of the run
+ */
+void PROFILE_end(PROFILE_Zone zone, uint32_t start);
+
+/**
+ * @brief Record a run in durations kept by the caller
+ *
+ * For code timed per item rather than per zone, such as each SCPI command.
+ * The rules of zones apply: the durations are only updated from one
+ * context, and the run is recorded modulo 2^32 cycles.
+ *
+ * @param stats Durations to update
+ * @param start Value returned by PROFILE_begin at the start of the run
+ */
+void PROFILE_record(PROFILE_Stats *stats, uint32_t start);
+
+/**
+ * @brief Get the durations of a zone
+ *
+ * Safe to call while the zone runs in an interrupt; the result is a
+ * consistent snapshot.
+ *
+ * @param zone Zone to query
+ * @return Durations of the zone, all zero if zone is out of range
+ */
+PROFILE_Stats PROFILE_get(PROFILE_Zone zone);
+
+/**
+ * @brief Discard the durations of all zones
+ */
+void PROFILE_clear(void);
+
+/**
+ * @brief Record that a boot stage has completed
+ *
+ * Only the first mark of a stage is kept. Out-of-range stages are ignored.
+ * Not to be called from interrupt context.
+ *
+ * @param stage Stage that completed
+ */
+void PROFILE_boot_mark(PROFILE_BootStage stage);
+
+/**
+ * @brief Get the time a boot stage completed at
+ *
+ * Times count from HAL_Init in PLATFORM_init, the earliest point the
+ * microsecond clock runs. They are not affected by PROFILE_clear.
+ *
+ * @param stage Stage to query
+ * @return Completion time in microseconds, or 0 if the stage has not
+ *         completed or is out of range
+ */
+uint32_t PROFILE_get_boot_time(PROFILE_BootStage stage);
+
+/**
+ * @brief Get the rate of the cycle counter
+ *
+ * @return CPU cycles per second
+ */
+uint32_t PROFILE_get_frequency(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_PROFILE_H
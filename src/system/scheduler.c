@@ -0,0 +1,144 @@
+/**
+ * @file scheduler.c
+ * @brief Cooperative task scheduler for the main loop
+ *
+ * See scheduler.h for how tasks are registered and chosen.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform/platform.h"
+#include "util/error.h"
+
+#include "clock.h"
+#include "scheduler.h"
+
+typedef struct {
+    SCHEDULER_Task task;
+    uint32_t next_run; // Tick at which a periodic task is due
+    uint32_t pending; // Events posted since the task last ran
+} Entry;
+
+static Entry g_tasks[SCHEDULER_TASKS_MAX];
+static uint32_t g_task_count = 0;
+
+// Posted from interrupt handlers, collected by the main loop
+static uint32_t volatile g_events = 0;
+
+/**
+ * @brief Check whether a periodic task's deadline has passed
+ */
+static bool is_due(Entry const *entry, uint32_t now)
+{
+    // Signed difference so that the tick may wrap around
+    return entry->task.period != 0 && (int32_t)(now - entry->next_run) >= 0;
+}
+
+/**
+ * @brief Hand posted events to the tasks waiting for them
+ */
+static void collect_events(void)
+{
+    uint32_t const events = __atomic_exchange_n(&g_events, 0, __ATOMIC_ACQ_REL);
+
+    if (events == 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < g_task_count; ++i) {
+        g_tasks[i].pending |= events & g_tasks[i].task.events;
+    }
+}
+
+/**
+ * @brief Find the highest priority ready task
+ *
+ * @return Task entry, or nullptr if no task is ready
+ */
+static Entry *find_ready(uint32_t now)
+{
+    Entry *next = nullptr;
+
+    for (uint32_t i = 0; i < g_task_count; ++i) {
+        Entry *const entry = &g_tasks[i];
+        if (entry->pending == 0 && !is_due(entry, now)) {
+            continue;
+        }
+        if (next == nullptr || entry->task.priority < next->task.priority) {
+            next = entry;
+        }
+    }
+    return next;
+}
+
+void SCHEDULER_init(void)
+{
+    g_task_count = 0;
+    __atomic_store_n(&g_events, 0, __ATOMIC_RELEASE);
+}
+
+void SCHEDULER_add(SCHEDULER_Task const *task)
+{
+    if (task == nullptr || task->function == nullptr ||
+        (task->period == 0 && task->events == 0)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_task_count >= SCHEDULER_TASKS_MAX) {
+        THROW(ERROR_OUT_OF_MEMORY);
+    }
+
+    g_tasks[g_task_count] = (Entry){
+        .task = *task,
+        .next_run = PLATFORM_get_tick(),
+        .pending = 0,
+    };
+    ++g_task_count;
+}
+
+void SCHEDULER_post(uint32_t events)
+{
+    __atomic_fetch_or(&g_events, events, __ATOMIC_RELEASE);
+}
+
+bool SCHEDULER_step(void)
+{
+    collect_events();
+
+    uint32_t const now = PLATFORM_get_tick();
+    Entry *const entry = find_ready(now);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    entry->pending = 0;
+    if (is_due(entry, now)) {
+        entry->next_run += entry->task.period;
+        // Skip runs missed while other tasks were busy instead of catching up
+        if (is_due(entry, now)) {
+            entry->next_run = now + entry->task.period;
+        }
+    }
+
+    entry->task.function();
+    return true;
+}
+
+__attribute__((noreturn)) void SCHEDULER_run(void)
+{
+    while (1) {
+        if (SCHEDULER_step()) {
+            continue;
+        }
+
+        // Nothing to do; sleep at the low clock unless an instrument runs
+        CLOCK_idle();
+
+        // Check again with interrupts masked: an event posted after the
+        // check stays pending and ends the sleep straight away
+        uint32_t const state = PLATFORM_disable_interrupts();
+        if (g_events == 0 && find_ready(PLATFORM_get_tick()) == nullptr) {
+            PLATFORM_wait_for_interrupt();
+        }
+        PLATFORM_restore_interrupts(state);
+    }
+}
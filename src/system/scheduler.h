@@ -0,0 +1,102 @@
+/**
+ * @file scheduler.h
+ * @brief Cooperative task scheduler for the main loop
+ *
+ * Tasks are functions that run to completion on the main loop. A task
+ * becomes ready when its period has elapsed or when one of the events it
+ * waits for has been posted, typically from an interrupt handler:
+ *
+ *     SCHEDULER_add(&(SCHEDULER_Task){
+ *         .function = protocol_task,
+ *         .period = 1,
+ *         .events = SCHEDULER_EVENT_USB_RX,
+ *         .priority = 0,
+ *     });
+ *     SCHEDULER_run();
+ *
+ * Of the ready tasks, the one with the highest priority runs first, then
+ * the one registered first. A task that delays is not preempted, so tasks
+ * must return quickly and split long work across runs. When no task is
+ * ready, the core sleeps until the next interrupt; the millisecond tick
+ * wakes it up for periodic tasks. Before sleeping it drops to the low clock
+ * unless the full clock has been requested, see clock.h.
+ */
+
+#ifndef SYSTEM_SCHEDULER_H
+#define SYSTEM_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    /** @brief Maximum number of registered tasks */
+    SCHEDULER_TASKS_MAX = 8,
+};
+
+/**
+ * @brief Events that make tasks ready, as bit flags
+ */
+enum {
+    SCHEDULER_EVENT_USB_RX = 1U << 0, /**< USB data waiting to be processed */
+    SCHEDULER_EVENT_DSO = 1U << 1, /**< DSO acquisition buffer filled */
+};
+
+/**
+ * @brief Task registration
+ */
+typedef struct {
+    void (*function)(void); /**< Called each time the task is ready */
+    uint32_t period; /**< Milliseconds between runs, or 0 for events only */
+    uint32_t events; /**< SCHEDULER_EVENT_* flags that make the task ready */
+    uint32_t priority; /**< 0 is the highest priority */
+} SCHEDULER_Task;
+
+/**
+ * @brief Remove all tasks and pending events
+ */
+void SCHEDULER_init(void);
+
+/**
+ * @brief Register a task
+ *
+ * Periodic tasks first run on the next scheduler step.
+ *
+ * @param task Task to add; copied, so it may be a temporary
+ *
+ * @throws ERROR_INVALID_ARGUMENT if task or its function is null, or if it
+ *         has neither a period nor events
+ * @throws ERROR_OUT_OF_MEMORY if SCHEDULER_TASKS_MAX tasks are registered
+ */
+void SCHEDULER_add(SCHEDULER_Task const *task);
+
+/**
+ * @brief Post events and wake up the tasks waiting for them
+ *
+ * Safe to call from interrupt handlers. An event posted several times
+ * before a task runs makes it ready once.
+ *
+ * @param events SCHEDULER_EVENT_* flags
+ */
+void SCHEDULER_post(uint32_t events);
+
+/**
+ * @brief Run the highest priority ready task, if any
+ *
+ * @return true if a task ran
+ */
+bool SCHEDULER_step(void);
+
+/**
+ * @brief Run tasks forever, sleeping while none is ready
+ */
+__attribute__((noreturn)) void SCHEDULER_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_SCHEDULER_H
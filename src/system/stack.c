@@ -0,0 +1,84 @@
+/**
+ * @file stack.c
+ * @brief Stack painting and high-water marks
+ *
+ * The startup code calls stack_paint before switching the main loop to the
+ * process stack. Both stacks are then filled with a pattern, below the
+ * frame of the reset handler, and the deepest use of a stack is the lowest
+ * word that no longer holds the pattern.
+ *
+ * The stacks are laid out by the linker script, from the top of RAM down:
+ * the interrupt stack (_Irq_Stack_Size below _estack), then the main stack
+ * (_Min_Stack_Size below _sirq_stack). The main stack may grow further into
+ * the free heap space; it is only measured down to its reserve.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+
+#include "system.h"
+
+enum {
+    STACK_PAINT = 0xA5A5A5A5U, // Pattern of stack words never used
+};
+
+// Linker script symbols; only their addresses are meaningful
+extern uint32_t _estack[];
+extern uint32_t _sirq_stack[];
+extern uint8_t _Min_Stack_Size[];
+
+/**
+ * @brief Bottom of the main stack reserve
+ */
+static uint32_t *main_stack_limit(void)
+{
+    return (uint32_t *)((uint8_t *)_sirq_stack - (uintptr_t)_Min_Stack_Size);
+}
+
+/**
+ * @brief Fill the unused part of both stacks with the paint pattern
+ *
+ * Called once from the reset handler, with interrupts not yet enabled and
+ * the main stack not yet in use.
+ */
+void stack_paint(void)
+{
+    uint32_t *sp = nullptr;
+    __asm volatile("mov %0, sp" : "=r"(sp));
+
+    // The main stack lies right below the interrupt stack, so one sweep
+    // paints both, up to the frame of this call
+    for (uint32_t *word = main_stack_limit(); word < sp; ++word) {
+        *word = STACK_PAINT;
+    }
+}
+
+/**
+ * @brief Deepest use of a painted stack
+ *
+ * @param bottom Lowest word of the stack
+ * @param top Word above the highest word of the stack
+ */
+static SYSTEM_StackUsage
+stack_usage(uint32_t const *bottom, uint32_t const *top)
+{
+    uint32_t const *word = bottom;
+
+    while (word < top && *word == STACK_PAINT) {
+        ++word;
+    }
+    return (SYSTEM_StackUsage){
+        .size = (uint32_t)((top - bottom) * sizeof(uint32_t)),
+        .peak = (uint32_t)((top - word) * sizeof(uint32_t)),
+    };
+}
+
+SYSTEM_StackStats SYSTEM_get_stack_stats(void)
+{
+    return (SYSTEM_StackStats){
+        .main = stack_usage(main_stack_limit(), _sirq_stack),
+        .interrupt = stack_usage(_sirq_stack, _estack),
+    };
+}
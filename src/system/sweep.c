@@ -0,0 +1,326 @@
+/**
+ * @file sweep.c
+ * @brief Frequency response sweep for PSLab firmware
+ *
+ * The oscilloscope is initialized once for the sweep, and only its sample
+ * rate is changed from point to point. The generator is initialized anew
+ * for each point, since its frequency is fixed at init. SWEEP_task moves a
+ * point from settling to capture to analysis, so the main loop never
+ * waits for either instrument.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform/platform.h"
+#include "util/arena.h"
+#include "util/error.h"
+#include "util/fixed_point.h"
+#include "util/logging.h"
+#include "util/si_prefix.h"
+#include "util/spectrum.h"
+
+#include "instrument/dso.h"
+#include "instrument/wavegen.h"
+#include "sweep.h"
+
+enum {
+    CHANNELS = 2, // Stimulus and response, captured together
+    CAPTURE_MARGIN = 100, // ms past twice the capture time before giving up
+};
+
+/**
+ * @brief Stage of the point being measured
+ */
+typedef enum {
+    STEP_SETTLE, // Stimulus playing, waiting for the circuit to settle
+    STEP_CAPTURE, // Capture running
+} Step;
+
+// Capture of the point being measured, frames of stimulus and response
+static uint16_t g_sweep_buffer[SWEEP_FRAMES * CHANNELS] ARENA_DMA_MEMORY;
+
+// Sweep state (internal to this module)
+static struct {
+    SWEEP_State state;
+    SWEEP_Config config;
+    DSO_Handle *dso;
+    WAVEGEN_Handle *wavegen;
+    Step step;
+    bool volatile captured; // Set by the DSO when the capture completes
+    uint32_t deadline; // Tick the current step ends or times out at
+    uint32_t frequency; // mHz played at the current point
+    uint32_t phase_step; // Of the frequency per sample, in 2^-32 turns
+    uint32_t completed;
+    SWEEP_Point points[SWEEP_POINTS_MAX];
+} g_sweep = {
+    .state = SWEEP_STATE_IDLE,
+    .dso = nullptr,
+    .wavegen = nullptr,
+    .completed = 0,
+};
+
+static void capture_complete(void) { g_sweep.captured = true; }
+
+static bool validate_config(SWEEP_Config const *config)
+{
+    return config && config->start >= SWEEP_FREQUENCY_MIN &&
+           config->start <= SWEEP_FREQUENCY_MAX &&
+           config->stop >= SWEEP_FREQUENCY_MIN &&
+           config->stop <= SWEEP_FREQUENCY_MAX && config->points > 0 &&
+           config->points <= SWEEP_POINTS_MAX && config->amplitude >= 0 &&
+           config->settle <= SWEEP_SETTLE_MAX && config->cycles > 0 &&
+           config->cycles <= SWEEP_CYCLES_MAX;
+}
+
+static void release_wavegen(void)
+{
+    if (g_sweep.wavegen) {
+        WAVEGEN_deinit(g_sweep.wavegen);
+        g_sweep.wavegen = nullptr;
+    }
+}
+
+static void release_instruments(void)
+{
+    release_wavegen();
+    if (g_sweep.dso) {
+        DSO_deinit(g_sweep.dso);
+        g_sweep.dso = nullptr;
+    }
+}
+
+/**
+ * @brief Frequency of a point as planned, in millihertz
+ */
+static uint64_t planned_frequency(uint32_t point)
+{
+    SWEEP_Config const *config = &g_sweep.config;
+    int64_t const start = (int64_t)config->start * SI_MILLI_DIV;
+    int64_t const stop = (int64_t)config->stop * SI_MILLI_DIV;
+    int64_t const last = (int64_t)config->points - 1;
+
+    if (point == 0 || last == 0) {
+        return (uint64_t)start;
+    }
+    if (point == last) {
+        return (uint64_t)stop;
+    }
+    if (!config->logarithmic) {
+        return (uint64_t)(start + ((stop - start) * point / last));
+    }
+    int64_t const log_start = FIXED_log2((uint64_t)start);
+    int64_t const log_stop = FIXED_log2((uint64_t)stop);
+    int64_t const exponent =
+        log_start + ((log_stop - log_start) * point / last);
+    return FIXED_exp2((FIXED_Q1616)exponent);
+}
+
+/**
+ * @brief Set the capture rate and the stimulus of the next point
+ *
+ * The capture spans the configured number of periods, or more where the
+ * ADC is too slow for that, and the stimulus is then tuned to a whole
+ * number of periods at the rate achieved.
+ */
+static void begin_point(void)
+{
+    uint64_t const planned = planned_frequency(g_sweep.completed);
+    uint64_t const rate_max = DSO_get_max_sample_rate(
+        DSO_MODE_DUAL_CHANNEL, DSO_RESOLUTION_12BIT
+    );
+    uint64_t cycles = g_sweep.config.cycles;
+    if (planned * SWEEP_FRAMES > rate_max * cycles * SI_MILLI_DIV) {
+        uint64_t const fastest = rate_max * SI_MILLI_DIV;
+        cycles = ((planned * SWEEP_FRAMES) + fastest - 1) / fastest;
+    }
+    uint64_t rate = ((planned * SWEEP_FRAMES) + (cycles * SI_MILLI_DIV / 2)) /
+                    (cycles * SI_MILLI_DIV);
+    rate = rate > 0 ? rate : 1;
+
+    DSO_Config dso_config = DSO_get_config(g_sweep.dso);
+    dso_config.sample_rate = (uint32_t)rate;
+    DSO_set_config(g_sweep.dso, &dso_config);
+    uint64_t const achieved = DSO_get_config(g_sweep.dso).sample_rate;
+
+    uint64_t frequency =
+        ((cycles * achieved * SI_MILLI_DIV) + (SWEEP_FRAMES / 2)) /
+        SWEEP_FRAMES;
+    frequency = frequency < (uint64_t)SWEEP_FREQUENCY_MAX * SI_MILLI_DIV
+                    ? frequency
+                    : (uint64_t)SWEEP_FREQUENCY_MAX * SI_MILLI_DIV;
+    frequency = frequency > 0 ? frequency : 1;
+
+    WAVEGEN_Config const wavegen_config = {
+        .mode = WAVEGEN_MODE_DDS,
+        .shape = WAVEGEN_SHAPE_SINE,
+        .frequency = (uint32_t)(frequency / SI_MILLI_DIV),
+        .millihertz = (uint32_t)(frequency % SI_MILLI_DIV),
+        .amplitude = g_sweep.config.amplitude,
+        .offset = g_sweep.config.offset,
+        .samples = nullptr,
+        .sample_count = 0,
+    };
+    g_sweep.wavegen = WAVEGEN_init(&wavegen_config);
+    WAVEGEN_Config const played = WAVEGEN_get_config(g_sweep.wavegen);
+    g_sweep.frequency =
+        (uint32_t)((uint64_t)played.frequency * SI_MILLI_DIV +
+                   played.millihertz);
+    g_sweep.phase_step = (uint32_t)((((uint64_t)g_sweep.frequency << 32) +
+                                     (achieved * SI_MILLI_DIV / 2)) /
+                                    (achieved * SI_MILLI_DIV));
+    WAVEGEN_start(g_sweep.wavegen);
+
+    g_sweep.step = STEP_SETTLE;
+    g_sweep.deadline = PLATFORM_get_tick() + g_sweep.config.settle;
+}
+
+/**
+ * @brief Correlate the capture with the stimulus and record the point
+ */
+static void analyze_point(void)
+{
+    SPECTRUM_Phasor stimulus = { 0 };
+    SPECTRUM_Phasor response = { 0 };
+    SPECTRUM_Response result = { 0 };
+
+    (void)SPECTRUM_phasor(
+        g_sweep_buffer, SWEEP_FRAMES, CHANNELS, g_sweep.phase_step, &stimulus
+    );
+    (void)SPECTRUM_phasor(
+        &g_sweep_buffer[1],
+        SWEEP_FRAMES,
+        CHANNELS,
+        g_sweep.phase_step,
+        &response
+    );
+    SPECTRUM_response(&stimulus, &response, &result);
+
+    g_sweep.points[g_sweep.completed] = (SWEEP_Point){
+        .frequency = g_sweep.frequency,
+        .gain_cdb = result.gain_cdb,
+        .phase_cdeg = result.phase_cdeg,
+    };
+    ++g_sweep.completed;
+}
+
+/**
+ * @brief Move the current point on, once its step is over
+ */
+static void advance(void)
+{
+    uint32_t const now = PLATFORM_get_tick();
+
+    if (g_sweep.step == STEP_SETTLE) {
+        if ((int32_t)(now - g_sweep.deadline) < 0) {
+            return;
+        }
+        uint32_t const rate = DSO_get_config(g_sweep.dso).sample_rate;
+        uint32_t const capture =
+            (uint32_t)(((uint64_t)SWEEP_FRAMES * SI_MILLI_DIV) / rate) + 1;
+        g_sweep.captured = false;
+        DSO_start(g_sweep.dso);
+        g_sweep.step = STEP_CAPTURE;
+        g_sweep.deadline = now + (2 * capture) + CAPTURE_MARGIN;
+        return;
+    }
+
+    if (!g_sweep.captured) {
+        if ((int32_t)(now - g_sweep.deadline) >= 0) {
+            THROW(ERROR_TIMEOUT);
+        }
+        return;
+    }
+
+    analyze_point();
+    release_wavegen();
+    if (g_sweep.completed == g_sweep.config.points) {
+        release_instruments();
+        g_sweep.state = SWEEP_STATE_DONE;
+        LOG_INFO("SWEEP: %u points done", g_sweep.completed);
+        return;
+    }
+    begin_point();
+}
+
+void SWEEP_start(SWEEP_Config const *config)
+{
+    if (!validate_config(config)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    if (g_sweep.state == SWEEP_STATE_RUNNING) {
+        THROW(ERROR_RESOURCE_BUSY);
+    }
+
+    g_sweep.config = *config;
+    g_sweep.completed = 0;
+    g_sweep.state = SWEEP_STATE_IDLE;
+
+    DSO_Config dso_config = DSO_CONFIG_DEFAULT;
+    dso_config.mode = DSO_MODE_DUAL_CHANNEL;
+    dso_config.buffer = g_sweep_buffer;
+    dso_config.buffer_size = SWEEP_FRAMES * CHANNELS;
+    dso_config.complete_callback = capture_complete;
+    g_sweep.dso = DSO_init(&dso_config);
+
+    Error error = ERROR_NONE;
+    TRY { begin_point(); }
+    CATCH(error)
+    {
+        release_instruments();
+        THROW(error);
+    }
+    g_sweep.state = SWEEP_STATE_RUNNING;
+    LOG_INFO("SWEEP: Started, %u points", g_sweep.config.points);
+}
+
+void SWEEP_stop(void)
+{
+    if (g_sweep.state != SWEEP_STATE_RUNNING) {
+        return;
+    }
+    release_instruments();
+    g_sweep.state = SWEEP_STATE_IDLE;
+}
+
+void SWEEP_task(void)
+{
+    if (g_sweep.state != SWEEP_STATE_RUNNING) {
+        return;
+    }
+
+    Error error = ERROR_NONE;
+    TRY { advance(); }
+    CATCH(error)
+    {
+        LOG_ERROR(
+            "SWEEP: Point %u failed, error %d", g_sweep.completed, error
+        );
+        release_instruments();
+        g_sweep.state = SWEEP_STATE_ERROR;
+    }
+}
+
+void SWEEP_get_status(SWEEP_Status *status)
+{
+    if (!status) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    *status = (SWEEP_Status){
+        .state = g_sweep.state,
+        .points = g_sweep.config.points,
+        .completed = g_sweep.completed,
+    };
+}
+
+SWEEP_Point const *SWEEP_get_points(uint32_t *count)
+{
+    if (!count) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    *count = g_sweep.completed;
+    return g_sweep.points;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file sweep.h
+ * @brief Frequency response sweep for PSLab firmware
+ *
+ * The sweep measures the gain and phase of a circuit over a range of
+ * frequencies without the host: for each point the waveform generator
+ * plays a sine, the oscilloscope captures the stimulus and the response
+ * together, and the two are correlated with the sine's frequency on the
+ * device. Only the table of (frequency, gain, phase) goes to the host,
+ * instead of two full records per point.
+ *
+ * Wiring: the generator output drives the circuit's input and
+ * oscilloscope channel 0, and the circuit's output goes to channel 1. The
+ * gain and phase are those of channel 1 relative to channel 0, so the
+ * generator's own amplitude and delay drop out.
+ *
+ * Each capture holds a whole number of periods: the sample rate is chosen
+ * for at least the configured number of them, and the generator is then
+ * tuned, in DDS mode, to exactly that many periods at the sample rate the
+ * timer achieved. The frequency of each point is the one played.
+ *
+ * Basic usage:
+ * @code
+ * SWEEP_start(&(SWEEP_Config)SWEEP_CONFIG_DEFAULT);
+ * // SWEEP_task runs from the main loop
+ * // Once SWEEP_get_status reports SWEEP_STATE_DONE
+ * uint32_t count = 0;
+ * SWEEP_Point const *points = SWEEP_get_points(&count);
+ * @endcode
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_SWEEP_H
+#define PSLAB_SWEEP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "instrument/wavegen.h"
+#include "util/fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    /** @brief Largest number of points of a sweep */
+    SWEEP_POINTS_MAX = 256,
+    /** @brief Lowest frequency in Hz */
+    SWEEP_FREQUENCY_MIN = 1,
+    /** @brief Highest frequency in Hz, that of the DDS */
+    SWEEP_FREQUENCY_MAX = WAVEGEN_FREQUENCY_MAX,
+    /** @brief Largest number of periods per capture */
+    SWEEP_CYCLES_MAX = 64,
+    /** @brief Longest settling time per point, in ms */
+    SWEEP_SETTLE_MAX = 10000,
+    /** @brief Samples per channel and capture */
+    SWEEP_FRAMES = 1024,
+};
+
+/**
+ * @brief Sweep states
+ */
+typedef enum {
+    SWEEP_STATE_IDLE = 0, // Not started, or stopped
+    SWEEP_STATE_RUNNING, // Measuring
+    SWEEP_STATE_DONE, // All points measured
+    SWEEP_STATE_ERROR, // Stopped by a failure of the instruments
+} SWEEP_State;
+
+/**
+ * @brief Sweep settings
+ *
+ * The points run from start to stop, which may be the higher one, spaced
+ * evenly in frequency or in its logarithm. A single point is at start.
+ */
+typedef struct {
+    uint32_t start; // First frequency in Hz
+    uint32_t stop; // Last frequency in Hz
+    uint32_t points; // Number of points, 1 to SWEEP_POINTS_MAX
+    bool logarithmic; // Space the points evenly in log(frequency)
+    FIXED_Q1616 amplitude; // Peak voltage of the stimulus above its offset
+    FIXED_Q1616 offset; // Voltage of the stimulus's center
+    uint32_t settle; // ms from each frequency change to its capture
+    uint32_t cycles; // Fewest periods per capture, 1 to SWEEP_CYCLES_MAX
+} SWEEP_Config;
+
+/**
+ * @brief Default sweep: 100 Hz to 10 kHz, 10 points per decade
+ */
+#define SWEEP_CONFIG_DEFAULT                                                   \
+    {                                                                          \
+        .start = 100, .stop = 10000, .points = 21, .logarithmic = true,        \
+        .amplitude = FIXED_FROM_FLOAT(1.0), .offset = FIXED_FROM_FLOAT(1.65),  \
+        .settle = 10, .cycles = 4,                                             \
+    }
+
+/**
+ * @brief Result of one point
+ */
+typedef struct {
+    uint32_t frequency; // Frequency played, in millihertz
+    int32_t gain_cdb; // Gain from channel 0 to channel 1, in 0.01 dB
+    int32_t phase_cdeg; // Phase of channel 1 less that of channel 0, in
+                        // 0.01 degree from -18000 to 18000
+} SWEEP_Point;
+
+/**
+ * @brief Sweep status
+ */
+typedef struct {
+    SWEEP_State state;
+    uint32_t points; // Points of the sweep
+    uint32_t completed; // Points measured so far
+} SWEEP_Status;
+
+/**
+ * @brief Take the generator and the oscilloscope and start a sweep
+ *
+ * Returns once the first point is playing; SWEEP_task measures the
+ * points. The points of the previous sweep are dropped.
+ *
+ * @param config Sweep settings
+ *
+ * @throws ERROR_INVALID_ARGUMENT if config is NULL or invalid
+ * @throws ERROR_RESOURCE_BUSY if a sweep is running, or the generator or
+ *         the ADC is in use
+ * @throws ERROR_HARDWARE_FAULT if an instrument cannot be configured
+ */
+void SWEEP_start(SWEEP_Config const *config);
+
+/**
+ * @brief Stop a running sweep and release the instruments
+ *
+ * The points measured so far are kept.
+ */
+void SWEEP_stop(void);
+
+/**
+ * @brief Advance the sweep
+ *
+ * Called from the main loop, about every millisecond. Returns at once
+ * unless a sweep is running.
+ */
+void SWEEP_task(void);
+
+/**
+ * @brief Get the sweep status
+ *
+ * @param[out] status Current status
+ *
+ * @throws ERROR_INVALID_ARGUMENT if status is NULL
+ */
+void SWEEP_get_status(SWEEP_Status *status);
+
+/**
+ * @brief Get the points measured so far, in sweep order
+ *
+ * The table stays valid until the next SWEEP_start.
+ *
+ * @param[out] count Number of points in the table
+ * @return First point
+ *
+ * @throws ERROR_INVALID_ARGUMENT if count is NULL
+ */
+SWEEP_Point const *SWEEP_get_points(uint32_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PSLAB_SWEEP_H */
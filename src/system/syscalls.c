@@ -17,7 +17,9 @@
  * Usage:
  * Call syscalls_init() with an initialized UART_Handle pointer to enable
  * stdout/stderr output. Until syscalls_init() is called, _write_r will
- * return EBADF.
+ * return EBADF. stdout buffering and the policy for a full TX ring are set
+ * with syscalls_set_buffering() and syscalls_set_overflow(), see
+ * syscalls.h.
  *
  * Note: RX functionality is not implemented as this is designed for
  * write-only logging and debugging output. Reads will always return ENOSYS.
@@ -25,6 +27,7 @@
 
 #include <errno.h>
 #include <reent.h>
+#include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -35,9 +38,24 @@
 // Include UART headers for handle type
 #include "system/bus/uart.h"
 
+#include "syscalls.h"
+
+#ifndef PSLAB_STDOUT_BUFFER_SIZE
+// Large enough that a full buffer goes out as one long DMA transfer
+#define PSLAB_STDOUT_BUFFER_SIZE 512
+#endif
+
 // Static handle for UART I/O
 static UART_Handle *g_uart_handle = nullptr;
 
+// stdout buffer of the buffered modes, instead of one from malloc
+static char g_stdout_buffer[PSLAB_STDOUT_BUFFER_SIZE];
+
+static SYSCALLS_Overflow g_overflow = SYSCALLS_OVERFLOW_KEEP;
+
+// Bytes dropped by SYSCALLS_OVERFLOW_DROP
+static uint32_t g_dropped = 0;
+
 static int check_args(struct _reent *r, void const *buf, size_t cnt)
 {
     if (buf == nullptr) {
@@ -53,12 +71,6 @@ static int check_args(struct _reent *r, void const *buf, size_t cnt)
     return 1;
 }
 
-/**
- * @brief Initialize syscalls with a UART handle
- *
- * @param handle Pointer to an initialized UART handle to use for stdout/stderr
- * @throws ERROR_RESOURCE_BUSY if syscalls is already initialized
- */
 void syscalls_init(UART_Handle *handle)
 {
     if (g_uart_handle != nullptr) {
@@ -67,14 +79,6 @@ void syscalls_init(UART_Handle *handle)
     g_uart_handle = handle;
 }
 
-/**
- * @brief Deinitialize syscalls
- *
- * Clears the UART handle, disabling stdout/stderr output.
- *
- * @param handle Pointer to the UART handle that was used to initialize syscalls
- * @throws ERROR_INVALID_ARGUMENT if handle doesn't match the initialized handle
- */
 void syscalls_deinit(UART_Handle *handle)
 {
     if (g_uart_handle != handle) {
@@ -83,11 +87,57 @@ void syscalls_deinit(UART_Handle *handle)
     g_uart_handle = nullptr;
 }
 
+void syscalls_set_buffering(SYSCALLS_Buffering mode)
+{
+    int vbuf_mode = _IONBF;
+    switch (mode) {
+    case SYSCALLS_BUFFER_NONE:
+        vbuf_mode = _IONBF;
+        break;
+    case SYSCALLS_BUFFER_LINE:
+        vbuf_mode = _IOLBF;
+        break;
+    case SYSCALLS_BUFFER_FULL:
+        vbuf_mode = _IOFBF;
+        break;
+    default:
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    (void)fflush(stdout);
+    if (setvbuf(
+            stdout,
+            vbuf_mode == _IONBF ? nullptr : g_stdout_buffer,
+            vbuf_mode,
+            sizeof(g_stdout_buffer)
+        ) != 0) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+}
+
+void syscalls_set_overflow(SYSCALLS_Overflow policy)
+{
+    if (policy != SYSCALLS_OVERFLOW_KEEP && policy != SYSCALLS_OVERFLOW_DROP) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    g_overflow = policy;
+}
+
+uint32_t syscalls_get_dropped(void) { return g_dropped; }
+
+void syscalls_task(void)
+{
+    if (g_uart_handle != nullptr) {
+        (void)fflush(stdout);
+    }
+}
+
 bool syscalls_uart_flush(uint32_t timeout)
 {
     if (g_uart_handle == nullptr) {
         return false;
     }
+    (void)fflush(stdout);
 
     // Wait for the UART transmit buffer to be empty
     return UART_flush(g_uart_handle, timeout);
@@ -143,6 +193,12 @@ _ssize_t _write_r(struct _reent *r, int fd, void const *buf, size_t cnt)
         uint32_t bytes_written =
             UART_write(g_uart_handle, (uint8_t const *)buf, cnt);
 
+        // Claim the rest as written, so that stdio does not retry it
+        if (g_overflow == SYSCALLS_OVERFLOW_DROP) {
+            g_dropped += (uint32_t)(cnt - bytes_written);
+            return (_ssize_t)cnt;
+        }
+
         // If no bytes were written, it likely means the buffer is full
         if (bytes_written == 0 && cnt > 0) {
             r->_errno = EAGAIN;
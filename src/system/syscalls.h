@@ -0,0 +1,111 @@
+/**
+ * @file syscalls.h
+ * @brief stdout and stderr of the C library, on the log UART
+ *
+ * printf and friends write through newlib's stdio buffer to the TX ring of
+ * the log UART, which sends it with DMA. How often stdio hands its buffer
+ * to the UART is set with syscalls_set_buffering: fully buffered stdout
+ * fills a static buffer and goes out in large chunks, when it is full or
+ * when syscalls_task runs. What happens when the TX ring is full is set
+ * with syscalls_set_overflow; neither setting ever waits for the UART.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef SYSTEM_SYSCALLS_H
+#define SYSTEM_SYSCALLS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bus/uart.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief How stdout buffers output before writing it to the UART
+ */
+typedef enum {
+    SYSCALLS_BUFFER_NONE, // Each stdio call writes to the UART
+    SYSCALLS_BUFFER_LINE, // Written at each newline, the C library default
+    SYSCALLS_BUFFER_FULL, // Written when full, or by syscalls_task
+} SYSCALLS_Buffering;
+
+/**
+ * @brief What writes do with bytes that do not fit the UART TX ring
+ */
+typedef enum {
+    // Fail with EAGAIN, so that stdio keeps the bytes for its next write
+    SYSCALLS_OVERFLOW_KEEP,
+    // Take the bytes and drop them, so that stdio never backs up
+    SYSCALLS_OVERFLOW_DROP,
+} SYSCALLS_Overflow;
+
+/**
+ * @brief Initialize syscalls with a UART handle
+ *
+ * @param handle Pointer to an initialized UART handle to use for stdout/stderr
+ * @throws ERROR_RESOURCE_BUSY if syscalls is already initialized
+ */
+void syscalls_init(UART_Handle *handle);
+
+/**
+ * @brief Deinitialize syscalls
+ *
+ * Clears the UART handle, disabling stdout/stderr output.
+ *
+ * @param handle Pointer to the UART handle that was used to initialize syscalls
+ * @throws ERROR_INVALID_ARGUMENT if handle doesn't match the initialized handle
+ */
+void syscalls_deinit(UART_Handle *handle);
+
+/**
+ * @brief Set how stdout buffers its output
+ *
+ * Buffered modes use a static buffer of PSLAB_STDOUT_BUFFER_SIZE bytes.
+ * Output buffered so far is written first.
+ *
+ * @param mode Buffering mode
+ * @throws ERROR_INVALID_ARGUMENT if mode is not a SYSCALLS_Buffering value
+ */
+void syscalls_set_buffering(SYSCALLS_Buffering mode);
+
+/**
+ * @brief Set what stdout and stderr writes do when the TX ring is full
+ *
+ * SYSCALLS_OVERFLOW_KEEP at startup.
+ *
+ * @param policy Overflow policy
+ * @throws ERROR_INVALID_ARGUMENT if policy is not a SYSCALLS_Overflow value
+ */
+void syscalls_set_overflow(SYSCALLS_Overflow policy);
+
+/**
+ * @brief Get the number of bytes dropped by SYSCALLS_OVERFLOW_DROP
+ */
+uint32_t syscalls_get_dropped(void);
+
+/**
+ * @brief Write out what stdout has buffered
+ *
+ * For periodic calls from the main loop, so that fully buffered output
+ * does not linger. Costs little when nothing is buffered.
+ */
+void syscalls_task(void);
+
+/**
+ * @brief Write out stdout and wait for the UART to send it
+ *
+ * @param timeout Time to wait, in ms
+ * @return true if everything was sent in time
+ */
+bool syscalls_uart_flush(uint32_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_SYSCALLS_H
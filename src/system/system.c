@@ -2,71 +2,346 @@
  * @file system.c
  * @brief Hardware system initialization routines for the PSLab Mini firmware.
  *
- * This module provides the SYSTEM_init() function, which initializes all core
- * hardware peripherals and must be called immediately after reset, before any
- * other hardware access.
+ * This module provides the SYSTEM_init() function, which initializes the
+ * platform and must be called immediately after reset, before any other
+ * hardware access, and SYSTEM_init_deferred(), which brings up the rest once
+ * USB is attached.
  */
 
+#include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
 
+#include "platform/adc_ll.h"
+#include "platform/itm_ll.h"
 #include "platform/platform.h"
-#include "platform/uart_ll.h"
 #include "util/error.h"
 #include "util/logging.h"
 #include "util/si_prefix.h"
 #include "util/util.h"
 
 #include "bus/uart.h"
+#include "bus/usb.h"
+#include "instrument/calibration.h"
+#include "kvstore.h"
 #include "led.h"
+#include "profile.h"
+#include "syscalls.h"
 #include "system.h"
+#include "trace.h"
+
+// UART log output buffer, set by the PSLAB_PROFILE build option
+#ifndef PSLAB_LOG_UART_BUFFER_SIZE
+#define PSLAB_LOG_UART_BUFFER_SIZE 1024
+#endif
+
+// SWO bit rate: 250 MHz / 128, which the 31.25 MHz low clock divides too
+#ifndef PSLAB_SWO_BAUDRATE
+#define PSLAB_SWO_BAUDRATE 1953125
+#endif
+
+// Log and trace on SWO from startup instead of the log UART, set by the
+// PSLAB_LOG_ITM build option
+#ifndef PSLAB_LOG_ITM
+#define PSLAB_LOG_ITM 0
+#endif
+
+// Fully buffered stdout instead of line buffered, set by the
+// PSLAB_STDOUT_FULL_BUFFERING build option
+#ifndef PSLAB_STDOUT_FULL_BUFFERING
+#define PSLAB_STDOUT_FULL_BUFFERING 0
+#endif
+
+static_assert(
+    CIRCULAR_BUFFER_SIZE_VALID(PSLAB_LOG_UART_BUFFER_SIZE),
+    "PSLAB_LOG_UART_BUFFER_SIZE must be a power of 2"
+);
 
 // Global variables for logging
 static UART_Handle *g_logging_uart_handle = nullptr;
-static uint8_t g_log_buf[1024];
+static uint8_t g_log_buf[PSLAB_LOG_UART_BUFFER_SIZE];
 static uint8_t g_log_rx_buf[1];
 static CircularBuffer g_log_cb;
 static CircularBuffer g_log_rx_cb;
 
+// USB log interface, opened when logs are first routed to it
+enum { LOG_USB_RX_BUFFER_SIZE = 64, LOG_USB_TX_BUFFER_SIZE = 1024 };
+static USB_Handle *g_log_usb_handle = nullptr;
+static uint8_t g_log_usb_rx_buf[LOG_USB_RX_BUFFER_SIZE];
+static uint8_t g_log_usb_tx_buf[LOG_USB_TX_BUFFER_SIZE];
+static CircularBuffer g_log_usb_rx_cb;
+static CircularBuffer g_log_usb_tx_cb;
+
+static SYSTEM_LogSink g_log_sink = SYSTEM_LOG_SINK_UART;
+
+enum {
+    ITM_PORT_LOG = 0, // Conventional port of text output
+    // Longest wait for the ITM FIFO per batch of log output, in us
+    ITM_LOG_BUDGET_US = 500,
+};
+
+static bool g_itm_open = false;
+static bool g_trace_itm = false;
+
+/**
+ * @brief Queue LOG_task output on the log UART, one transfer per batch
+ */
+static uint32_t log_uart_output(uint8_t const *data, uint32_t size)
+{
+    return UART_write(g_logging_uart_handle, data, size);
+}
+
+/**
+ * @brief Time to allow for the log UART TX buffer to empty, in ms
+ */
+static uint32_t log_uart_flush_timeout(void)
+{
+    unsigned const bits_per_uart_byte = 12; // Start, 8 data, parity, 2 stop
+    size_t const buffer_size_bits = sizeof(g_log_buf) * bits_per_uart_byte;
+    uint32_t const baudrate = UART_get_config(g_logging_uart_handle).baudrate;
+    // Twice the time to send a full buffer, for safety
+    uint32_t timeout = (buffer_size_bits * SI_MILLI_DIV * 2) / baudrate;
+
+    // 1 ms <= timeout <= 1000 ms
+    timeout = timeout < 1 ? 1 : timeout;
+    return timeout > SI_MILLI_DIV ? SI_MILLI_DIV : timeout;
+}
+
+/**
+ * @brief Queue LOG_task output on the USB log interface
+ */
+static uint32_t log_usb_output(uint8_t const *data, uint32_t size)
+{
+    return USB_write(g_log_usb_handle, data, size);
+}
+
+/**
+ * @brief Open the ITM stimulus ports of the log and the trace
+ */
+static void itm_open(void)
+{
+    if (g_itm_open) {
+        return;
+    }
+
+    ITM_LL_init(
+        PSLAB_SWO_BAUDRATE,
+        (1U << ITM_PORT_LOG) | (1U << TRACE_ITM_PORT_EVENT) |
+            (1U << TRACE_ITM_PORT_CYCLES)
+    );
+    g_itm_open = true;
+}
+
+/**
+ * @brief Send LOG_task output out of the SWO pin
+ *
+ * The ITM FIFO takes a word at a time and empties at the SWO bit rate.
+ * Waiting for it is capped, so that a large batch does not hold up the main
+ * loop; the rest is sent on the next LOG_task run.
+ */
+static uint32_t log_itm_output(uint8_t const *data, uint32_t size)
+{
+    uint32_t const start = PLATFORM_get_time_us();
+    uint32_t done = 0;
+
+    do {
+        done += ITM_LL_write(ITM_PORT_LOG, &data[done], size - done);
+    } while (done < size && ITM_LL_port_enabled(ITM_PORT_LOG) &&
+             PLATFORM_get_time_us() - start < ITM_LOG_BUDGET_US);
+    return done;
+}
+
+/**
+ * @brief Stream a trace record out of the SWO pin
+ *
+ * A record that finds the FIFO full is dropped whole. Once the event word
+ * is in, the cycles word waits for the FIFO, at most one word time, so that
+ * the two stay paired.
+ */
+static void trace_itm_output(TRACE_Record const *record)
+{
+    uint32_t const word = record->event | ((uint32_t)record->arg << 16);
+
+    if (!ITM_LL_write_word(TRACE_ITM_PORT_EVENT, word)) {
+        return;
+    }
+    while (!ITM_LL_write_word(TRACE_ITM_PORT_CYCLES, record->cycles) &&
+           ITM_LL_port_enabled(TRACE_ITM_PORT_CYCLES)) {
+    }
+}
+
+/**
+ * @brief Keep LOG_task output for LOG_read_lines
+ *
+ * Accepting nothing leaves the lines staged and the rest of the entries in
+ * the log buffer.
+ */
+static uint32_t log_query_output(uint8_t const *data, uint32_t size)
+{
+    (void)data;
+    (void)size;
+    return 0;
+}
+
+/**
+ * @brief Open the USB log interface
+ *
+ * @throws Errors raised by USB_init
+ */
+static void log_usb_open(void)
+{
+    if (g_log_usb_handle) {
+        return;
+    }
+
+    circular_buffer_init(
+        &g_log_usb_rx_cb, g_log_usb_rx_buf, sizeof(g_log_usb_rx_buf)
+    );
+    circular_buffer_init(
+        &g_log_usb_tx_cb, g_log_usb_tx_buf, sizeof(g_log_usb_tx_buf)
+    );
+    g_log_usb_handle =
+        USB_init(USB_INTERFACE_LOG, &g_log_usb_rx_cb, &g_log_usb_tx_cb);
+    // Serviced from the USB interrupt, so the log port needs no polling
+    USB_set_event_driven(g_log_usb_handle, true);
+}
+
 void SYSTEM_init(void)
 {
     // Initialize logging early to capture any log messages during startup
     LOG_init();
     PLATFORM_init();
+    LOG_set_timestamp_source(SYSTEM_get_time_us);
+    TRACE_init();
+    PROFILE_boot_mark(PROFILE_BOOT_PLATFORM);
+}
 
+void SYSTEM_init_deferred(void)
+{
     // Set up log output
     circular_buffer_init(&g_log_cb, g_log_buf, sizeof(g_log_buf));
     circular_buffer_init(&g_log_rx_cb, g_log_rx_buf, sizeof(g_log_rx_buf));
     uint8_t log_bus = 2;
     g_logging_uart_handle = UART_init(log_bus, &g_log_rx_cb, &g_log_cb);
-    extern void syscalls_init(UART_Handle * handle);
     syscalls_init(g_logging_uart_handle);
+    // printf never waits for the UART; what does not fit is dropped
+    syscalls_set_overflow(SYSCALLS_OVERFLOW_DROP);
+    syscalls_set_buffering(
+        PSLAB_STDOUT_FULL_BUFFERING ? SYSCALLS_BUFFER_FULL
+                                    : SYSCALLS_BUFFER_LINE
+    );
+#if PSLAB_LOG_ITM
+    // Keeps the log UART free for other traffic, e.g. the UART bridge
+    SYSTEM_set_log_sink(SYSTEM_LOG_SINK_ITM);
+    SYSTEM_set_trace_itm(true);
+#else
+    LOG_set_output(log_uart_output);
+#endif
     // Buffered log messages can now be output with LOG_task
     LOG_task(0xFF);
 
     LED_init();
+
+    // Instruments apply the stored calibration from their first reading
+    CALIBRATION_load();
+    // Stored settings are looked up from here on without a flash scan
+    KVSTORE_init();
+    PROFILE_boot_mark(PROFILE_BOOT_SYSTEM);
+}
+
+void SYSTEM_set_log_sink(SYSTEM_LogSink sink)
+{
+    switch (sink) {
+    case SYSTEM_LOG_SINK_UART:
+        LOG_set_output(log_uart_output);
+        break;
+    case SYSTEM_LOG_SINK_USB:
+        log_usb_open();
+        LOG_set_output(log_usb_output);
+        break;
+    case SYSTEM_LOG_SINK_QUERY:
+        LOG_set_output(log_query_output);
+        break;
+    case SYSTEM_LOG_SINK_ITM:
+        itm_open();
+        LOG_set_output(log_itm_output);
+        break;
+    default:
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    g_log_sink = sink;
+}
+
+SYSTEM_LogSink SYSTEM_get_log_sink(void) { return g_log_sink; }
+
+void SYSTEM_set_trace_itm(bool enabled)
+{
+    if (enabled) {
+        itm_open();
+    }
+    TRACE_set_sink(enabled ? trace_itm_output : nullptr);
+    g_trace_itm = enabled;
+}
+
+bool SYSTEM_get_trace_itm(void) { return g_trace_itm; }
+
+void SYSTEM_configure_uart(UART_LineConfig const *config)
+{
+    // Send pending log output with the settings the receiver expects
+    (void)UART_flush(g_logging_uart_handle, log_uart_flush_timeout());
+    UART_configure(g_logging_uart_handle, config);
+}
+
+UART_LineConfig SYSTEM_get_uart_config(void)
+{
+    return UART_get_config(g_logging_uart_handle);
 }
 
 uint32_t SYSTEM_get_tick(void) { return PLATFORM_get_tick(); }
 
+uint32_t SYSTEM_get_time_us(void) { return PLATFORM_get_time_us(); }
+
+uint64_t SYSTEM_get_time_us64(void) { return PLATFORM_get_time_us64(); }
+
+uint32_t SYSTEM_elapsed_us(uint32_t since)
+{
+    return PLATFORM_get_time_us() - since;
+}
+
+size_t SYSTEM_get_irq_info(SYSTEM_IrqInfo *info, size_t max)
+{
+    PLATFORM_IrqInfo entries[SYSTEM_IRQ_INFO_MAX];
+    size_t const count = PLATFORM_get_irq_info(
+        entries,
+        max < SYSTEM_IRQ_INFO_MAX ? max : SYSTEM_IRQ_INFO_MAX
+    );
+
+    for (size_t i = 0; i < count; ++i) {
+        info[i] = (SYSTEM_IrqInfo){
+            .name = entries[i].name,
+            .priority = entries[i].priority,
+            .enabled = entries[i].enabled,
+        };
+    }
+    return count;
+}
+
+void SYSTEM_delay_us(uint32_t us)
+{
+    uint32_t const start = PLATFORM_get_time_us();
+    while (PLATFORM_get_time_us() - start < us) {
+    }
+}
+
+void SYSTEM_track_reference(void) { ADC_LL_track_reference(); }
+
 __attribute__((noreturn)) void SYSTEM_reset(void)
 {
     LOG_INFO("Resetting...");
 
     // Flush any pending log messages
     LOG_task(UINT32_MAX);
-    unsigned const bits_per_uart_byte = 10;
-    size_t const buffer_size_bits = sizeof(g_log_buf) * bits_per_uart_byte;
-    // Timeout to wait for TX buffer to empty (2x time for safety)
-    uint32_t timeout =
-        ((buffer_size_bits * SI_MILLI_DIV * 2) / UART_DEFAULT_BAUDRATE);
-
-    // 1 ms <= timeout <= 1000 ms
-    timeout = timeout < 1 ? 1 : timeout;
-    timeout = timeout > SI_MILLI_DIV ? SI_MILLI_DIV : timeout;
-
-    extern bool syscalls_uart_flush(uint32_t timeout);
-    syscalls_uart_flush(timeout);
+    syscalls_uart_flush(log_uart_flush_timeout());
     PLATFORM_reset();
 }
 
@@ -3,26 +3,107 @@
  * @brief Hardware system initialization interface for the PSLab Mini firmware.
  *
  * This module declares the SYSTEM_init() function, which must be called
- * immediately after reset to initialize all core hardware peripherals before
- * any other hardware access.
+ * immediately after reset before any other hardware access, and
+ * SYSTEM_init_deferred(), which completes the initialization once USB is
+ * attached.
  */
 
 #ifndef SYSTEM_H
 #define SYSTEM_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bus/uart.h"
 #include "util/fixed_point.h"
 
 #define SYSTEM_VDD (FIXED_FROM_FLOAT(3.3F)) // NOLINT(readability-magic-numbers)
 
 /**
- * @brief Initialize all core hardware peripherals.
+ * @brief Initialize the platform.
  *
  * This function must be called immediately after reset, before any other
- * hardware access is performed. It initializes the platform, LED, UART, and USB
- * subsystems.
+ * hardware access is performed. It brings up the clocks and the log buffer,
+ * which is enough to attach USB; everything else is left to
+ * SYSTEM_init_deferred, so that the host can start enumerating first.
  */
 void SYSTEM_init(void);
 
+/**
+ * @brief Initialize the log UART, LEDs and stored calibration.
+ *
+ * Must be called after SYSTEM_init and before the main loop. Log messages
+ * from before are buffered and sent once the log UART is up.
+ */
+void SYSTEM_init_deferred(void);
+
+/**
+ * @brief Destinations of the log output
+ */
+typedef enum {
+    SYSTEM_LOG_SINK_UART = 0, // Log UART, the default
+    SYSTEM_LOG_SINK_USB, // Second USB CDC serial port
+    SYSTEM_LOG_SINK_QUERY, // Kept until read with LOG_read_lines
+    SYSTEM_LOG_SINK_ITM, // ITM stimulus port 0, out of the SWO pin
+} SYSTEM_LogSink;
+
+/**
+ * @brief Select where LOG_task sends log messages
+ *
+ * The USB log interface is initialized the first time it is selected.
+ * Lines that the previous sink had not accepted yet go to the new one.
+ *
+ * @param sink Log destination
+ *
+ * @throws ERROR_INVALID_ARGUMENT if sink is not a SYSTEM_LogSink value
+ * @throws Errors raised by USB_init when selecting SYSTEM_LOG_SINK_USB
+ */
+void SYSTEM_set_log_sink(SYSTEM_LogSink sink);
+
+/**
+ * @brief Get the log destination
+ *
+ * @return Sink selected by SYSTEM_set_log_sink
+ */
+SYSTEM_LogSink SYSTEM_get_log_sink(void);
+
+/**
+ * @brief Stream event trace records out of the SWO pin as they are taken
+ *
+ * Each record is sent as two ITM words: the event with its argument in the
+ * upper half on TRACE_ITM_PORT_EVENT, then the cycle counter on
+ * TRACE_ITM_PORT_CYCLES. Records that find the ITM FIFO full are not sent,
+ * but are kept in the trace ring all the same.
+ *
+ * @param enabled true to stream records
+ */
+void SYSTEM_set_trace_itm(bool enabled);
+
+/**
+ * @brief Whether event trace records are streamed out of the SWO pin
+ */
+bool SYSTEM_get_trace_itm(void);
+
+/**
+ * @brief Change the line settings of the system UART
+ *
+ * The system UART carries log output unless it is sent elsewhere with
+ * SYSTEM_set_log_sink. Pending output is sent with the old settings first.
+ *
+ * @param config Line settings
+ *
+ * @throws Errors raised by UART_configure
+ */
+void SYSTEM_configure_uart(UART_LineConfig const *config);
+
+/**
+ * @brief Get the line settings of the system UART
+ *
+ * @return Settings last set by SYSTEM_configure_uart, or the defaults
+ */
+UART_LineConfig SYSTEM_get_uart_config(void);
+
 /**
  * @brief Get the current system tick count
  *
@@ -30,6 +111,130 @@ void SYSTEM_init(void);
  */
 uint32_t SYSTEM_get_tick(void);
 
+/**
+ * @brief Get the time since startup in microseconds
+ *
+ * Safe to call from interrupt context. Wraps around after about 71
+ * minutes; compare timestamps with SYSTEM_elapsed_us.
+ *
+ * @return The current time in microseconds
+ */
+uint32_t SYSTEM_get_time_us(void);
+
+/**
+ * @brief Get the time since startup in microseconds, 64-bit
+ *
+ * Wraps around with the millisecond tick, after about 49 days, so it
+ * suits timestamps that must stay ordered over a long session.
+ *
+ * @return The current time in microseconds
+ */
+uint64_t SYSTEM_get_time_us64(void);
+
+/**
+ * @brief Microseconds since a timestamp from SYSTEM_get_time_us
+ *
+ * Correct across one wrap of the clock.
+ *
+ * @param since Earlier timestamp
+ * @return Time elapsed since the timestamp in microseconds
+ */
+uint32_t SYSTEM_elapsed_us(uint32_t since);
+
+/**
+ * @brief Busy-wait for a number of microseconds
+ *
+ * @param us Time to wait, at most about 71 minutes
+ */
+void SYSTEM_delay_us(uint32_t us);
+
+/**
+ * @brief Keep the ADC reference voltage up to date
+ *
+ * To be called periodically from the main loop, so that the DMM and
+ * calibrated DSO conversions follow drift of the analog supply without
+ * reinitializing the ADC. Each call takes a few microseconds; the
+ * measurement is skipped while the ADC is capturing.
+ */
+void SYSTEM_track_reference(void);
+
+/**
+ * @brief Heap usage, in bytes
+ *
+ * The heap grows from the end of static RAM up to the stack reserve set by
+ * the linker script. Only the C library allocates from it; the firmware's
+ * own buffers live in arenas.
+ */
+typedef struct {
+    uint32_t size; // Bytes between the end of static RAM and the stack
+    uint32_t used; // Bytes allocated and not yet freed
+    uint32_t peak; // Furthest the heap has grown since startup
+    uint32_t headroom; // Bytes the heap can still grow by, contiguous
+} SYSTEM_HeapStats;
+
+/**
+ * @brief Get the heap usage
+ *
+ * @return Heap usage since startup
+ */
+SYSTEM_HeapStats SYSTEM_get_heap_stats(void);
+
+/**
+ * @brief Use of one stack, in bytes
+ */
+typedef struct {
+    uint32_t size; // Bytes reserved for the stack
+    uint32_t peak; // Deepest use since startup, size if it may have overflowed
+} SYSTEM_StackUsage;
+
+/**
+ * @brief Use of the stacks
+ *
+ * The main loop runs on the process stack (PSP), the exception handlers on
+ * the main stack pointer (MSP), so that each stack has a size of its own.
+ */
+typedef struct {
+    SYSTEM_StackUsage main; // Main loop and everything it calls
+    SYSTEM_StackUsage interrupt; // Exception handlers, nested ones included
+} SYSTEM_StackStats;
+
+/**
+ * @brief Get the deepest use of the stacks
+ *
+ * The stacks are painted with a pattern at reset; the deepest use is where
+ * the pattern was last overwritten. Takes a few microseconds to scan them.
+ *
+ * @return Stack use since startup
+ */
+SYSTEM_StackStats SYSTEM_get_stack_stats(void);
+
+/**
+ * @brief Largest number of interrupts SYSTEM_get_irq_info reports
+ */
+enum { SYSTEM_IRQ_INFO_MAX = 32 };
+
+/**
+ * @brief Priority in effect of an interrupt
+ */
+typedef struct {
+    char const *name; // Handler name without the _IRQHandler suffix
+    uint8_t priority; // Preemption priority, 0 the highest
+    bool enabled;
+} SYSTEM_IrqInfo;
+
+/**
+ * @brief Get the interrupt priorities in effect
+ *
+ * Lists the interrupts the drivers use, from the highest planned priority
+ * to the lowest, as the interrupt controller holds them now. Empty on
+ * platforms without interrupt priorities.
+ *
+ * @param[out] info Array for the entries
+ * @param max Capacity of info
+ * @return Number of entries written, at most max and SYSTEM_IRQ_INFO_MAX
+ */
+size_t SYSTEM_get_irq_info(SYSTEM_IrqInfo *info, size_t max);
+
 /**
  * @brief Reset system
  *
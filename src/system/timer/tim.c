@@ -10,7 +10,6 @@
  */
 
 #include <stddef.h>
-#include <stdlib.h>
 
 #include "platform/tim_ll.h"
 #include "util/error.h"
@@ -27,6 +26,9 @@ struct TIM_Handle {
     bool initialised;
 };
 
+// Statically allocated handle storage, one per timer
+static TIM_Handle g_handle_storage[TIM_NUM_COUNT];
+
 // Array to keep track of active timers
 static TIM_Handle *g_active_timers[TIM_NUM_COUNT] = { nullptr };
 
@@ -52,10 +54,7 @@ TIM_Handle *TIM_init(size_t tim, uint32_t freq)
         THROW(ERROR_RESOURCE_BUSY);
     }
 
-    TIM_Handle *handle = malloc(sizeof(TIM_Handle));
-    if (handle == nullptr) {
-        THROW(ERROR_OUT_OF_MEMORY);
-    }
+    TIM_Handle *handle = &g_handle_storage[tim];
 
     handle->tim_id = tim;
     handle->freq = freq;
@@ -63,7 +62,7 @@ TIM_Handle *TIM_init(size_t tim, uint32_t freq)
 
     g_active_timers[tim] = handle;
 
-    TIM_LL_init((TIM_Num)tim, freq);
+    handle->freq = TIM_LL_init((TIM_Num)tim, freq);
     return handle;
 }
 
@@ -109,6 +108,5 @@ void TIM_stop(size_t tim)
     TIM_LL_stop((TIM_Num)tim);
     g_active_timers[tim]->initialised = false;
     g_active_timers[tim]->freq = 0;
-    free(g_active_timers[tim]);
     g_active_timers[tim] = nullptr;
 }
\ No newline at end of file
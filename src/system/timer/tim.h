@@ -54,7 +54,7 @@ void TIM_start(size_t tim);
  * @brief Stop the Timer Module
  *
  * This function stops the specified TIM instance and deinitializes it.
- * It frees the allocated handle for the timer.
+ * Its statically allocated handle becomes free for the next TIM_init.
  *
  * @param handle Pointer to the TIM handle structure
  */
@@ -0,0 +1,145 @@
+/**
+ * @file trace.c
+ * @brief Binary event trace of interrupts and tasks
+ *
+ * See trace.h for how events are recorded and read.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform/platform.h"
+
+#include "trace.h"
+
+static_assert(
+    (TRACE_CAPACITY & (TRACE_CAPACITY - 1)) == 0,
+    "TRACE_CAPACITY must be a power of 2"
+);
+
+// Marks an intact ring, at both ends so that a partly clobbered one fails
+static uint32_t const g_TRACE_MAGIC = 0x54524331; // "TRC1"
+
+// Not initialized at startup, so that the ring survives a reset; see the
+// .noinit section of the linker script
+static struct {
+    uint32_t magic;
+    uint32_t boots; // TRACE_init calls since the ring was set up
+    uint32_t head; // Sequence number of the next record
+    uint32_t tail; // Sequence number of the oldest record not cleared
+    TRACE_Record records[TRACE_CAPACITY];
+    uint32_t magic_end;
+} volatile g_trace __attribute__((section(".noinit")));
+
+static bool g_enabled = true;
+static TRACE_Sink g_sink = nullptr;
+
+/**
+ * @brief Sequence number of the oldest record kept
+ */
+static uint32_t oldest(uint32_t head)
+{
+    uint32_t const tail = g_trace.tail;
+    return head - tail > TRACE_CAPACITY ? head - TRACE_CAPACITY : tail;
+}
+
+void TRACE_init(void)
+{
+    if (g_trace.magic != g_TRACE_MAGIC ||
+        g_trace.magic_end != g_TRACE_MAGIC) {
+        g_trace.boots = 0;
+        g_trace.head = 0;
+        g_trace.tail = 0;
+        g_trace.magic = g_TRACE_MAGIC;
+        g_trace.magic_end = g_TRACE_MAGIC;
+    }
+
+    g_trace.boots = g_trace.boots + 1;
+    TRACE_record(TRACE_EVENT_BOOT, (uint16_t)g_trace.boots);
+}
+
+void TRACE_record(TRACE_Event event, uint16_t arg)
+{
+    if (!g_enabled) {
+        return;
+    }
+
+    uint32_t const state = PLATFORM_disable_interrupts();
+    uint32_t const head = g_trace.head;
+    TRACE_Record const entry = {
+        .cycles = PLATFORM_get_cycles(),
+        .event = (uint16_t)event,
+        .arg = arg,
+    };
+    TRACE_Record volatile *const record =
+        &g_trace.records[head & (TRACE_CAPACITY - 1)];
+    record->cycles = entry.cycles;
+    record->event = entry.event;
+    record->arg = entry.arg;
+    // Published last, so that readers only see complete records
+    g_trace.head = head + 1;
+    if (g_sink) {
+        g_sink(&entry);
+    }
+    PLATFORM_restore_interrupts(state);
+}
+
+void TRACE_set_enabled(bool enabled) { g_enabled = enabled; }
+
+bool TRACE_is_enabled(void) { return g_enabled; }
+
+void TRACE_set_sink(TRACE_Sink sink) { g_sink = sink; }
+
+void TRACE_clear(void)
+{
+    uint32_t const state = PLATFORM_disable_interrupts();
+    g_trace.tail = g_trace.head;
+    PLATFORM_restore_interrupts(state);
+}
+
+uint32_t TRACE_get_sequence(void) { return g_trace.head; }
+
+uint32_t TRACE_read(uint32_t *sequence, TRACE_Record *records, uint32_t max)
+{
+    uint32_t const head = g_trace.head;
+    uint32_t first = *sequence;
+
+    // Also catches a sequence number ahead of the ring
+    uint32_t const start = oldest(head);
+    if (head - first > head - start) {
+        first = start;
+    }
+    uint32_t count = head - first;
+    if (count > max) {
+        count = max;
+    }
+
+    // Copied without masking interrupts; records that interrupts wrote
+    // over in the meantime are dropped instead
+    for (uint32_t i = 0; i < count; ++i) {
+        TRACE_Record volatile const *const record =
+            &g_trace.records[(first + i) & (TRACE_CAPACITY - 1)];
+        records[i] = (TRACE_Record){
+            .cycles = record->cycles,
+            .event = record->event,
+            .arg = record->arg,
+        };
+    }
+
+    uint32_t const overwritten = g_trace.head - TRACE_CAPACITY - first;
+    if ((int32_t)overwritten > 0) {
+        uint32_t const skip = overwritten < count ? overwritten : count;
+        for (uint32_t i = skip; i < count; ++i) {
+            records[i - skip] = records[i];
+        }
+        first += skip;
+        count -= skip;
+    }
+
+    *sequence = first;
+    return count;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file trace.h
+ * @brief Binary event trace of interrupts and tasks
+ *
+ * The trace is a ring of compact records, each an event ID, the CPU cycle
+ * counter at the time it was recorded and a 16-bit argument. Interrupt
+ * handlers and tasks record events at their entry and exit points, so that
+ * a host can lay them out on a timeline:
+ *
+ *     TRACE_record(TRACE_EVENT_LOG_BEGIN, 0);
+ *     LOG_task(0xF);
+ *     TRACE_record(TRACE_EVENT_LOG_END, 0);
+ *
+ * Each record is numbered with a free-running sequence number, which lets
+ * a reader tell which records it has already seen and how many it has
+ * missed because the ring wrapped.
+ *
+ * The ring sits in RAM that is not initialized at startup, so the records
+ * leading up to a reset can be read out after it: TRACE_init keeps a ring
+ * that is still intact and records TRACE_EVENT_BOOT to mark the reset.
+ * The cycle counter restarts at each boot.
+ */
+
+#ifndef SYSTEM_TRACE_H
+#define SYSTEM_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    TRACE_CAPACITY = 512, // Records kept, a power of 2
+    // ITM stimulus ports of records streamed out of SWO, see
+    // SYSTEM_set_trace_itm: the event and argument word, then the cycles
+    TRACE_ITM_PORT_EVENT = 1,
+    TRACE_ITM_PORT_CYCLES = 2,
+};
+
+/**
+ * @brief Traced events
+ *
+ * The numbering is part of the SYSTem:TRACe? format; new events are added
+ * at the end.
+ */
+typedef enum {
+    TRACE_EVENT_BOOT, /**< TRACE_init; arg: boot count, modulo 2^16 */
+    TRACE_EVENT_PROTOCOL_BEGIN, /**< protocol_task starts */
+    TRACE_EVENT_PROTOCOL_END, /**< protocol_task returns */
+    TRACE_EVENT_LOG_BEGIN, /**< LOG_task starts */
+    TRACE_EVENT_LOG_END, /**< LOG_task returns */
+    TRACE_EVENT_USB_ISR_BEGIN, /**< USB service interrupt; arg: interface */
+    TRACE_EVENT_USB_ISR_END, /**< USB service interrupt returns */
+    TRACE_EVENT_DSO_DMA_HALF, /**< DSO DMA half transfer; arg: samples */
+    TRACE_EVENT_DSO_DMA_COMPLETE, /**< DSO DMA transfer; arg: samples */
+    TRACE_EVENT_UART_TX_COMPLETE, /**< UART transmission done; arg: bus */
+    TRACE_EVENT_UART_RX_COMPLETE, /**< UART RX DMA wrapped; arg: bus */
+    TRACE_EVENT_UART_RX_IDLE, /**< UART RX line went idle; arg: bus */
+    TRACE_EVENT_UART_RX_TIMEOUT, /**< UART RX below threshold; arg: bus */
+    TRACE_EVENT_COUNT,
+} TRACE_Event;
+
+/**
+ * @brief One traced event, 8 bytes
+ */
+typedef struct {
+    uint32_t cycles; /**< CPU cycle counter when recorded */
+    uint16_t event; /**< TRACE_Event */
+    uint16_t arg; /**< Event argument, see TRACE_Event */
+} TRACE_Record;
+
+/**
+ * @brief Callback receiving each record as it is recorded
+ *
+ * Runs in the context of TRACE_record with interrupts masked, so it must
+ * be short and must not record events itself.
+ *
+ * @param record Record just stored in the ring
+ */
+typedef void (*TRACE_Sink)(TRACE_Record const *record);
+
+/**
+ * @brief Set up the ring after a reset
+ *
+ * Keeps the records of an intact ring and discards the contents of one
+ * that is not, as after power-up. Then records TRACE_EVENT_BOOT. Must be
+ * called after PLATFORM_init, which starts the cycle counter.
+ */
+void TRACE_init(void);
+
+/**
+ * @brief Record an event
+ *
+ * Safe to call from any context, including interrupt handlers. Costs a
+ * cycle counter read and a store with interrupts masked. Does nothing
+ * while tracing is disabled.
+ *
+ * @param event Event that occurred
+ * @param arg Event argument, see TRACE_Event
+ */
+void TRACE_record(TRACE_Event event, uint16_t arg);
+
+/**
+ * @brief Enable or disable recording
+ *
+ * Tracing is enabled at startup.
+ *
+ * @param enabled true to record events
+ */
+void TRACE_set_enabled(bool enabled);
+
+/**
+ * @brief Whether events are recorded
+ */
+bool TRACE_is_enabled(void);
+
+/**
+ * @brief Pass each record to a sink as well, e.g. to stream it out
+ *
+ * @param sink Callback, or nullptr to only keep records in the ring
+ */
+void TRACE_set_sink(TRACE_Sink sink);
+
+/**
+ * @brief Discard all records
+ *
+ * Sequence numbers are not reset, so that a reader keeps its place.
+ */
+void TRACE_clear(void);
+
+/**
+ * @brief Get the sequence number the next record will get
+ */
+uint32_t TRACE_get_sequence(void);
+
+/**
+ * @brief Copy records out of the ring, oldest first
+ *
+ * Not to be called from interrupt context. Records that are recorded while
+ * copying are left for the next call. If the ring has dropped records
+ * since the requested one, the copy starts at the oldest record kept.
+ *
+ * @param[in,out] sequence Sequence number of the first record wanted; set
+ *                         to that of the first record copied
+ * @param records Buffer for the records
+ * @param max Capacity of records
+ * @return Records copied, numbered *sequence onwards
+ */
+uint32_t TRACE_read(uint32_t *sequence, TRACE_Record *records, uint32_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_TRACE_H
@@ -0,0 +1,216 @@
+/**
+ * @file update.c
+ * @brief A/B firmware updates in the background
+ *
+ * The first block of the image is kept in RAM until the image is sealed,
+ * as the bootloader's flash driver does, so that the words it checks are
+ * programmed last. They follow the vector table, at the offsets set in
+ * boot/blt_conf.h and reserved by the linker script:
+ * - the checksum, the two's complement of the sum of the first seven
+ *   vectors,
+ * - the size of the image in bytes,
+ * - the CRC-32 of the image, without the size and CRC words, as the STM32
+ *   CRC unit computes it.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform/flash_ll.h"
+#include "util/crc.h"
+#include "util/error.h"
+#include "util/logging.h"
+
+#include "update.h"
+
+enum {
+    // RAM copy of the start of the image, programmed when it is sealed
+    BOOT_BLOCK_SIZE = 1024,
+    BOOT_BLOCK_WORDS = BOOT_BLOCK_SIZE / sizeof(uint32_t),
+    // Words checked by the bootloader, after the vector table
+    CHECKSUM_OFFSET = 0x24C,
+    IMAGE_SIZE_OFFSET = CHECKSUM_OFFSET + 4,
+    IMAGE_CRC_OFFSET = CHECKSUM_OFFSET + 8,
+    IMAGE_MIN_SIZE = IMAGE_CRC_OFFSET + 4,
+    // Vectors covered by the checksum
+    CHECKSUM_VECTORS = 7,
+    SECTOR_COUNT = FLASH_LL_UPDATE_SIZE / FLASH_LL_SECTOR_SIZE,
+    // Unit of the other writes, and of the reads for the CRC
+    STAGING_SIZE = 256,
+};
+
+static UPDATE_State g_state = UPDATE_STATE_IDLE;
+static uint32_t g_boot_block[BOOT_BLOCK_WORDS];
+static uint32_t g_staging[STAGING_SIZE / sizeof(uint32_t)];
+// One bit per sector of the update area erased since UPDATE_begin
+static uint32_t g_erased[(SECTOR_COUNT + 31) / 32];
+// End of the furthest part written
+static uint32_t g_image_end = 0;
+
+/**
+ * @brief Erase the sector holding an offset, unless already done
+ */
+static void ensure_erased(uint32_t offset)
+{
+    uint32_t const sector = offset / FLASH_LL_SECTOR_SIZE;
+    uint32_t const bit = 1U << (sector % 32);
+
+    if (g_erased[sector / 32] & bit) {
+        return;
+    }
+    FLASH_LL_update_erase(sector * FLASH_LL_SECTOR_SIZE);
+    g_erased[sector / 32] |= bit;
+}
+
+/**
+ * @brief Program part of the image after the first block
+ *
+ * The part must not span sectors, nor exceed the staging buffer.
+ */
+static void program_part(uint32_t offset, uint8_t const *data, uint32_t size)
+{
+    uint32_t const padded =
+        (size + FLASH_LL_WRITE_ALIGN - 1) & ~(FLASH_LL_WRITE_ALIGN - 1U);
+
+    // Copied for the alignment the flash needs, and padded as erased flash
+    memset(g_staging, 0xFF, padded);
+    memcpy(g_staging, data, size);
+
+    ensure_erased(offset);
+    FLASH_LL_update_write(offset, g_staging, padded);
+}
+
+/**
+ * @brief CRC-32 of the image, as checked by the bootloader
+ *
+ * The first block comes from RAM, the rest is read back from flash.
+ */
+static uint32_t image_crc(uint32_t size)
+{
+    uint32_t const words = size / sizeof(uint32_t);
+    uint32_t const boot_words =
+        words < BOOT_BLOCK_WORDS ? words : BOOT_BLOCK_WORDS;
+    uint32_t crc = CRC32_INIT;
+
+    // The size and CRC words are left out
+    crc = CRC32_update_words(crc, g_boot_block, IMAGE_SIZE_OFFSET / 4);
+    crc = CRC32_update_words(
+        crc,
+        &g_boot_block[IMAGE_MIN_SIZE / 4],
+        boot_words - IMAGE_MIN_SIZE / 4
+    );
+
+    for (uint32_t offset = BOOT_BLOCK_SIZE; offset < size;
+         offset += STAGING_SIZE) {
+        uint32_t const left = size - offset;
+        uint32_t const chunk = left < STAGING_SIZE ? left : STAGING_SIZE;
+        FLASH_LL_update_read(offset, g_staging, chunk);
+        crc = CRC32_update_words(crc, g_staging, chunk / sizeof(uint32_t));
+    }
+    return crc;
+}
+
+void UPDATE_begin(void)
+{
+    g_state = UPDATE_STATE_IDLE;
+    memset(g_boot_block, 0xFF, sizeof(g_boot_block));
+    memset(g_erased, 0, sizeof(g_erased));
+    g_image_end = 0;
+
+    // Invalidates the previous image, whose checked words are in sector 0
+    ensure_erased(0);
+    g_state = UPDATE_STATE_RECEIVING;
+    LOG_INFO("Update: started");
+}
+
+void UPDATE_write(uint32_t offset, void const *data, uint32_t size)
+{
+    if (g_state != UPDATE_STATE_RECEIVING) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+    if (!data || (offset % FLASH_LL_WRITE_ALIGN) != 0 ||
+        offset > FLASH_LL_UPDATE_SIZE || size > FLASH_LL_UPDATE_SIZE - offset) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    uint8_t const *bytes = data;
+    uint32_t const end = offset + size;
+
+    while (offset < end) {
+        uint32_t chunk = end - offset;
+
+        if (offset < BOOT_BLOCK_SIZE) {
+            if (chunk > BOOT_BLOCK_SIZE - offset) {
+                chunk = BOOT_BLOCK_SIZE - offset;
+            }
+            memcpy((uint8_t *)g_boot_block + offset, bytes, chunk);
+        } else {
+            uint32_t const sector_left =
+                FLASH_LL_SECTOR_SIZE - offset % FLASH_LL_SECTOR_SIZE;
+            if (chunk > STAGING_SIZE) {
+                chunk = STAGING_SIZE;
+            }
+            if (chunk > sector_left) {
+                chunk = sector_left;
+            }
+            program_part(offset, bytes, chunk);
+        }
+        offset += chunk;
+        bytes += chunk;
+    }
+
+    if (end > g_image_end) {
+        g_image_end = end;
+    }
+}
+
+void UPDATE_finish(void)
+{
+    if (g_state != UPDATE_STATE_RECEIVING) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+    if (g_image_end < CHECKSUM_OFFSET) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    uint32_t checksum = 0;
+    for (uint32_t i = 0; i < CHECKSUM_VECTORS; ++i) {
+        checksum += g_boot_block[i];
+    }
+    g_boot_block[CHECKSUM_OFFSET / 4] = ~checksum + 1U;
+
+    uint32_t size = g_image_end < IMAGE_MIN_SIZE ? IMAGE_MIN_SIZE : g_image_end;
+    size = (size + 3U) & ~3U;
+    g_boot_block[IMAGE_SIZE_OFFSET / 4] = size;
+
+    // Sectors no part reached still hold the previous image, which the CRC
+    // read back from flash would seal as part of this one
+    for (uint32_t offset = 0; offset < size; offset += FLASH_LL_SECTOR_SIZE) {
+        ensure_erased(offset);
+    }
+    g_boot_block[IMAGE_CRC_OFFSET / 4] = image_crc(size);
+
+    FLASH_LL_update_write(0, g_boot_block, BOOT_BLOCK_SIZE);
+    g_state = UPDATE_STATE_READY;
+    LOG_INFO(
+        "Update: %u byte image ready, CRC 0x%08X",
+        (unsigned)size,
+        (unsigned)g_boot_block[IMAGE_CRC_OFFSET / 4]
+    );
+}
+
+void UPDATE_apply(void)
+{
+    if (g_state != UPDATE_STATE_READY) {
+        THROW(ERROR_DEVICE_NOT_READY);
+    }
+
+    FLASH_LL_request_bank_swap();
+    LOG_INFO("Update: bank swap requested");
+}
+
+UPDATE_State UPDATE_get_state(void) { return g_state; }
@@ -0,0 +1,107 @@
+/**
+ * @file update.h
+ * @brief A/B firmware updates in the background
+ *
+ * A new firmware image is written to the inactive flash bank while the
+ * running firmware carries on serving requests. Once complete, the image is
+ * sealed with the checksum, size and CRC-32 that the bootloader checks, and
+ * the bootloader is asked to swap the banks on the next reset. The downtime
+ * of an update is then a single reboot. The previous firmware stays in the
+ * other bank.
+ *
+ *     UPDATE_begin();
+ *     UPDATE_write(0, chunk, sizeof(chunk)); // ...until the whole image
+ *     UPDATE_finish();
+ *     UPDATE_apply();
+ *     SYSTEM_reset();
+ *
+ * Offsets are relative to the start of the image, its vector table, which
+ * runs at 0x0800C000. The image is the raw binary of the firmware, without
+ * the bootloader.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef SYSTEM_UPDATE_H
+#define SYSTEM_UPDATE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Progress of an update
+ */
+typedef enum {
+    UPDATE_STATE_IDLE = 0, // No update started
+    UPDATE_STATE_RECEIVING, // Image being written
+    UPDATE_STATE_READY, // Image sealed, can be applied
+} UPDATE_State;
+
+/**
+ * @brief Start writing a new image, dropping any previous one
+ *
+ * Erases the first sector of the inactive bank, so that a partly written
+ * image is never taken for a valid one. Blocks for a few milliseconds.
+ *
+ * @throws ERROR_HARDWARE_FAULT if the flash cannot be erased
+ */
+void UPDATE_begin(void);
+
+/**
+ * @brief Write part of the image
+ *
+ * Parts are written once each, in any order. Sectors of the inactive bank
+ * are erased as parts reach them, so a call may block for a few
+ * milliseconds. A part that does not end on a multiple of 16 bytes is
+ * padded with 0xFF, so only the last part of the image may do so.
+ *
+ * @param offset Offset into the image, a multiple of 16
+ * @param data Image bytes
+ * @param size Number of bytes
+ *
+ * @throws ERROR_DEVICE_NOT_READY if no update was started, or the image is
+ *         already sealed
+ * @throws ERROR_INVALID_ARGUMENT if data is NULL, offset is not aligned or
+ *         the part does not fit the inactive bank
+ * @throws ERROR_HARDWARE_FAULT if the flash cannot be erased or programmed
+ */
+void UPDATE_write(uint32_t offset, void const *data, uint32_t size);
+
+/**
+ * @brief Seal the image
+ *
+ * Computes the checksum, size and CRC-32 that the bootloader checks before
+ * starting the image, and programs the first block of the image, which
+ * holds them.
+ *
+ * @throws ERROR_DEVICE_NOT_READY if no update is being received
+ * @throws ERROR_INVALID_ARGUMENT if the image is shorter than its vector
+ *         table
+ * @throws ERROR_HARDWARE_FAULT if the flash cannot be programmed
+ */
+void UPDATE_finish(void);
+
+/**
+ * @brief Ask the bootloader to start the sealed image on the next reset
+ *
+ * The bootloader checks the image again, swaps the banks and starts it.
+ * The caller resets afterwards, e.g. with SYSTEM_reset.
+ *
+ * @throws ERROR_DEVICE_NOT_READY if no image was sealed
+ */
+void UPDATE_apply(void);
+
+/**
+ * @brief Get the progress of the update
+ */
+UPDATE_State UPDATE_get_state(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_UPDATE_H
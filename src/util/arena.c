@@ -0,0 +1,57 @@
+/**
+ * @file arena.c
+ * @brief Bump allocator over a caller-provided block of static memory
+ *
+ * See arena.h for the allocation order rules.
+ */
+#include <stdint.h>
+
+#include "arena.h"
+
+void ARENA_init(Arena *arena, void *memory, uint32_t size)
+{
+    uintptr_t const start = (uintptr_t)memory;
+    uintptr_t const aligned =
+        (start + (ARENA_ALIGN - 1)) & ~(uintptr_t)(ARENA_ALIGN - 1);
+    uint32_t const skipped = (uint32_t)(aligned - start);
+
+    arena->base = (uint8_t *)aligned;
+    arena->size = size > skipped ? size - skipped : 0;
+    arena->used = 0;
+    arena->peak = 0;
+}
+
+void *ARENA_alloc(Arena *arena, uint32_t size)
+{
+    if (size == 0 || size > ARENA_available(arena)) {
+        return nullptr;
+    }
+
+    uint8_t *const block = &arena->base[arena->used];
+    uint32_t const rounded = (size + (ARENA_ALIGN - 1)) & ~(ARENA_ALIGN - 1U);
+
+    // The free space is a multiple of ARENA_ALIGN, so this cannot overrun
+    arena->used += rounded;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+    return block;
+}
+
+void ARENA_release(Arena *arena, void const *block)
+{
+    uint8_t const *const start = block;
+
+    if (!start || start < arena->base ||
+        start >= &arena->base[arena->used]) {
+        return;
+    }
+    arena->used = (uint32_t)(start - arena->base);
+}
+
+void ARENA_reset(Arena *arena) { arena->used = 0; }
+
+uint32_t ARENA_available(Arena const *arena)
+{
+    return (arena->size - arena->used) & ~(ARENA_ALIGN - 1U);
+}
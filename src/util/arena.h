@@ -0,0 +1,98 @@
+/**
+ * @file arena.h
+ * @brief Bump allocator over a caller-provided block of static memory
+ *
+ * An arena hands out aligned blocks from the front of its memory and frees
+ * them in reverse order, so allocation and release take constant time and
+ * cannot fragment. It replaces the heap for buffers whose size changes at
+ * run time, such as sample buffers that follow the configured number of
+ * points.
+ *
+ * Memory shared with DMA should be placed with ARENA_DMA_MEMORY, which
+ * collects it in a dedicated, aligned RAM section that is not initialized
+ * at startup.
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#ifndef PSLAB_ARENA_H
+#define PSLAB_ARENA_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    ARENA_ALIGN = 32, // Alignment of every block, one DMA burst
+};
+
+/**
+ * @brief Place a static buffer in the DMA buffer section
+ *
+ * The section is not zeroed at startup, so buffers in it must be written
+ * before they are read.
+ */
+#define ARENA_DMA_MEMORY                                                       \
+    __attribute__((section(".dma_buffers"), aligned(ARENA_ALIGN)))
+
+/**
+ * @brief Arena state
+ */
+typedef struct {
+    uint8_t *base; // Start of the managed memory, ARENA_ALIGN aligned
+    uint32_t size; // Usable bytes from base
+    uint32_t used; // Bytes handed out
+    uint32_t peak; // Most bytes handed out at once since ARENA_init
+} Arena;
+
+/**
+ * @brief Initialize an empty arena
+ *
+ * Bytes before the first ARENA_ALIGN boundary of the memory are not used.
+ *
+ * @param arena Arena to initialize
+ * @param memory Memory to allocate from
+ * @param size Size of memory in bytes
+ */
+void ARENA_init(Arena *arena, void *memory, uint32_t size);
+
+/**
+ * @brief Allocate a block
+ *
+ * @param arena Arena to allocate from
+ * @param size Size of the block in bytes
+ * @return ARENA_ALIGN aligned block, or nullptr if it does not fit
+ */
+void *ARENA_alloc(Arena *arena, uint32_t size);
+
+/**
+ * @brief Release a block and every block allocated after it
+ *
+ * @param arena Arena the block was allocated from
+ * @param block Block returned by ARENA_alloc, or nullptr to do nothing
+ */
+void ARENA_release(Arena *arena, void const *block);
+
+/**
+ * @brief Release every block
+ *
+ * @param arena Arena to empty
+ */
+void ARENA_reset(Arena *arena);
+
+/**
+ * @brief Size of the largest block that can still be allocated
+ *
+ * @param arena Arena to query
+ * @return Free bytes, rounded down to a multiple of ARENA_ALIGN
+ */
+uint32_t ARENA_available(Arena const *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_ARENA_H
@@ -0,0 +1,75 @@
+/**
+ * @file channel_math.c
+ * @brief Math channel computed from the two channels of a dual capture
+ *
+ * See channel_math.h for the functions and the output layout.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed_point.h"
+
+#include "channel_math.h"
+
+/**
+ * @brief Narrow a Q30 product sum to Q15, rounded to nearest and saturated
+ */
+static FIXED_Q15 q30_to_q15(int32_t x)
+{
+    int32_t const rounded =
+        (x + (1 << (FIXED_Q15_FRAC_BITS - 1))) >> FIXED_Q15_FRAC_BITS;
+
+    if (rounded > INT16_MAX) {
+        return FIXED_Q15_MAX;
+    }
+    if (rounded < INT16_MIN) {
+        return FIXED_Q15_MIN;
+    }
+    return (FIXED_Q15)rounded;
+}
+
+/**
+ * @brief Math channel of one frame, both samples in Q15 of full scale
+ */
+static FIXED_Q15
+compute(CHANNEL_MATH_Config const *config, int32_t a, int32_t b)
+{
+    switch (config->function) {
+    case CHANNEL_MATH_PRODUCT:
+        return q30_to_q15(a * b);
+    case CHANNEL_MATH_SUM:
+        // Both terms are below 2^30 in magnitude, so their sum fits
+        return q30_to_q15(config->gains[0] * a + config->gains[1] * b);
+    case CHANNEL_MATH_DIFFERENCE:
+    default:
+        // Samples are not negative, so the difference stays in range
+        return (FIXED_Q15)(a - b);
+    }
+}
+
+uint32_t CHANNEL_MATH_apply(
+    CHANNEL_MATH_Config const *config,
+    uint16_t const *in,
+    uint32_t const count,
+    uint16_t *out
+)
+{
+    uint32_t const shift = FIXED_Q15_FRAC_BITS - config->sample_bits;
+    uint32_t written = 0;
+
+    for (uint32_t i = 0; i + 1 < count; i += 2) {
+        uint16_t const a = in[i];
+        uint16_t const b = in[i + 1];
+        FIXED_Q15 const math =
+            compute(config, (int32_t)a << shift, (int32_t)b << shift);
+
+        // With math_only, out[written] is at most in[i], already read
+        if (!config->math_only) {
+            out[written++] = a;
+            out[written++] = b;
+        }
+        out[written++] = (uint16_t)math;
+    }
+
+    return written;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file channel_math.h
+ * @brief Math channel computed from the two channels of a dual capture
+ *
+ * Input is a record of frames of two samples, one per channel, as a
+ * dual-channel capture stores them. Each frame gains a third sample, the
+ * math channel, computed from the two in Q15:
+ *
+ * - difference: a - b
+ * - product: a * b, e.g. the power of a voltage and a current
+ * - sum: gain_a * a + gain_b * b, saturated
+ *
+ * where a and b are the samples as fractions of full scale, so that the
+ * result is independent of the sample resolution. Results are FIXED_Q15
+ * values in 16-bit words. With math_only, the output holds just the math
+ * channel, one sample per frame, which halves the record.
+ *
+ * The kernel is allocation free and safe to call from interrupt context.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_CHANNEL_MATH_H
+#define PSLAB_CHANNEL_MATH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Function computed from the two channels
+ */
+typedef enum {
+    CHANNEL_MATH_DIFFERENCE, /**< a - b */
+    CHANNEL_MATH_PRODUCT, /**< a * b */
+    CHANNEL_MATH_SUM, /**< gain_a * a + gain_b * b */
+} CHANNEL_MATH_Function;
+
+/**
+ * @brief Math channel settings
+ */
+typedef struct {
+    CHANNEL_MATH_Function function;
+    FIXED_Q15 gains[2]; /**< Gains of a and b, for CHANNEL_MATH_SUM */
+    uint32_t sample_bits; /**< Bits of the input samples, 1 to 15 */
+    bool math_only; /**< Output the math channel without a and b */
+} CHANNEL_MATH_Config;
+
+/**
+ * @brief Samples per output frame
+ */
+static inline uint32_t
+CHANNEL_MATH_frame_size(CHANNEL_MATH_Config const *config)
+{
+    return config->math_only ? 1 : 3;
+}
+
+/**
+ * @brief Compute the math channel of a block of frames
+ *
+ * @param config Math channel settings
+ * @param in Input samples, frames of two
+ * @param count Number of input samples; a trailing odd sample is ignored
+ * @param out Output buffer with room for count / 2 frames of
+ *            CHANNEL_MATH_frame_size samples; may be @p in with math_only
+ *
+ * @return Number of samples written to @p out
+ */
+uint32_t CHANNEL_MATH_apply(
+    CHANNEL_MATH_Config const *config,
+    uint16_t const *in,
+    uint32_t count,
+    uint16_t *out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_CHANNEL_MATH_H
@@ -4,14 +4,92 @@
  *
  * This module provides a circular buffer implementation for the PSLab firmware,
  * allowing for efficient data storage and retrieval in a fixed-size buffer.
+ *
+ * Each index has a single writer, see the contract in util.h. A side reads
+ * the other side's index with acquire ordering, so that it sees the bytes
+ * published with it, and publishes its own with release ordering, after the
+ * bytes it covers have been written or read out. On the Cortex-M33 these are
+ * a DMB after the load and before the store; its own index needs neither.
+ *
+ * In overwrite mode the producer drops the oldest bytes by advancing tail
+ * with compare-and-swap, and the consumer publishes tail the same way once
+ * it has copied its bytes out. A failed swap tells the consumer that the
+ * producer dropped bytes meanwhile, which it may then have read half
+ * overwritten, so it copies again from the new tail. The producer swaps
+ * before it stores into the storage, so any store into bytes that the
+ * consumer is copying out makes the consumer's swap fail.
+ *
+ * Only circular_buffer_init checks its arguments in every build. The other
+ * functions run per byte or per span on the data path and check theirs with
+ * CHECK_ARGUMENT, which release builds leave out.
  */
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "error.h"
+#include "ramfunc.h"
 #include "util.h"
 
+/**
+ * @brief Read the index written by the other side
+ */
+static inline uint32_t load_acquire(uint32_t volatile const *index)
+{
+    return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Publish an index to the other side
+ */
+static inline void store_release(uint32_t volatile *index, uint32_t value)
+{
+    __atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Advance tail from an expected value, as either side in overwrite mode
+ *
+ * @param cb Pointer to circular buffer structure
+ * @param tail Expected tail; updated to the current one if it is not
+ * @param next New tail
+ * @return true if tail was advanced
+ */
+static inline bool compare_exchange_tail(
+    CircularBuffer *cb,
+    uint32_t *tail,
+    uint32_t next
+)
+{
+    return __atomic_compare_exchange_n(
+        &cb->tail, tail, next, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE
+    );
+}
+
+/**
+ * @brief Drop the oldest bytes, until there is room for len more
+ *
+ * Producer side, in overwrite mode; len must not exceed size - 1.
+ */
+static void drop_oldest(CircularBuffer *cb, uint32_t head, uint32_t len)
+{
+    uint32_t tail = load_acquire(&cb->tail);
+    for (;;) {
+        uint32_t const free_space =
+            (cb->size - 1) - ((head - tail) & cb->mask);
+        if (len <= free_space) {
+            return;
+        }
+        uint32_t const drop = len - free_space;
+        if (compare_exchange_tail(cb, &tail, (tail + drop) & cb->mask)) {
+            cb->overwritten += drop;
+            return;
+        }
+        // The consumer took bytes meanwhile; tail is the new one
+    }
+}
+
 /**
  * @brief Initialize a circular buffer
  *
@@ -34,6 +112,32 @@ void circular_buffer_init(CircularBuffer *cb, uint8_t *buffer, uint32_t size)
     cb->tail = 0;
     cb->size = size;
     cb->mask = size - 1; // Mask for bitwise operations
+    cb->overwrite = false;
+    cb->overwritten = 0;
+}
+
+/**
+ * @brief Keep the most recent bytes when full, instead of rejecting new ones
+ *
+ * @param cb Pointer to circular buffer structure
+ * @param overwrite true to drop the oldest bytes when full
+ */
+void circular_buffer_set_overwrite(CircularBuffer *cb, bool overwrite)
+{
+    CHECK_ARGUMENT(cb);
+    cb->overwrite = overwrite;
+}
+
+/**
+ * @brief Get the number of bytes dropped in overwrite mode
+ *
+ * @param cb Pointer to circular buffer structure
+ * @return Number of bytes dropped
+ */
+uint32_t circular_buffer_overwritten(CircularBuffer *cb)
+{
+    CHECK_ARGUMENT(cb);
+    return cb->overwritten;
 }
 
 /**
@@ -42,12 +146,10 @@ void circular_buffer_init(CircularBuffer *cb, uint8_t *buffer, uint32_t size)
  * @param cb Pointer to circular buffer structure
  * @return true if buffer is empty, false otherwise
  */
-bool circular_buffer_is_empty(CircularBuffer *cb)
+RAMFUNC bool circular_buffer_is_empty(CircularBuffer *cb)
 {
-    if (!cb) {
-        THROW(ERROR_INVALID_ARGUMENT);
-    }
-    return cb->head == cb->tail;
+    CHECK_ARGUMENT(cb);
+    return load_acquire(&cb->head) == load_acquire(&cb->tail);
 }
 
 /**
@@ -56,12 +158,11 @@ bool circular_buffer_is_empty(CircularBuffer *cb)
  * @param cb Pointer to circular buffer structure
  * @return true if buffer is full, false otherwise
  */
-bool circular_buffer_is_full(CircularBuffer *cb)
+RAMFUNC bool circular_buffer_is_full(CircularBuffer *cb)
 {
-    if (!cb) {
-        THROW(ERROR_INVALID_ARGUMENT);
-    }
-    return ((cb->head + 1) & cb->mask) == cb->tail;
+    CHECK_ARGUMENT(cb);
+    return ((load_acquire(&cb->head) + 1) & cb->mask) ==
+           load_acquire(&cb->tail);
 }
 
 /**
@@ -70,12 +171,10 @@ bool circular_buffer_is_full(CircularBuffer *cb)
  * @param cb Pointer to circular buffer structure
  * @return Number of bytes available
  */
-uint32_t circular_buffer_available(CircularBuffer *cb)
+RAMFUNC uint32_t circular_buffer_available(CircularBuffer *cb)
 {
-    if (!cb) {
-        THROW(ERROR_INVALID_ARGUMENT);
-    }
-    return (cb->head - cb->tail) & cb->mask;
+    CHECK_ARGUMENT(cb);
+    return (load_acquire(&cb->head) - load_acquire(&cb->tail)) & cb->mask;
 }
 
 /**
@@ -85,18 +184,21 @@ uint32_t circular_buffer_available(CircularBuffer *cb)
  * @param data Byte to put into buffer
  * @return true if successful, false if buffer is full
  */
-bool circular_buffer_put(CircularBuffer *cb, uint8_t data)
+RAMFUNC bool circular_buffer_put(CircularBuffer *cb, uint8_t data)
 {
-    if (!cb) {
-        THROW(ERROR_INVALID_ARGUMENT);
-    }
+    CHECK_ARGUMENT(cb);
 
-    if (circular_buffer_is_full(cb)) {
-        return false;
+    uint32_t const head = cb->head;
+    uint32_t const next = (head + 1) & cb->mask;
+    if (next == load_acquire(&cb->tail)) {
+        if (!cb->overwrite) {
+            return false;
+        }
+        drop_oldest(cb, head, 1);
     }
 
-    cb->buffer[cb->head] = data;
-    cb->head = (cb->head + 1) & cb->mask;
+    cb->buffer[head] = data;
+    store_release(&cb->head, next);
     return true;
 }
 
@@ -107,90 +209,134 @@ bool circular_buffer_put(CircularBuffer *cb, uint8_t data)
  * @param data Pointer to store the read byte
  * @return true if successful, false if buffer is empty
  */
-bool circular_buffer_get(CircularBuffer *cb, uint8_t *data)
+RAMFUNC bool circular_buffer_get(CircularBuffer *cb, uint8_t *data)
 {
-    if (!cb || !data) {
-        THROW(ERROR_INVALID_ARGUMENT);
+    CHECK_ARGUMENT(cb && data);
+
+    if (cb->overwrite) {
+        uint32_t tail = load_acquire(&cb->tail);
+        do {
+            if (tail == load_acquire(&cb->head)) {
+                return false;
+            }
+            *data = cb->buffer[tail];
+        } while (!compare_exchange_tail(cb, &tail, (tail + 1) & cb->mask));
+        return true;
     }
 
-    if (circular_buffer_is_empty(cb)) {
+    uint32_t const tail = cb->tail;
+    if (tail == load_acquire(&cb->head)) {
         return false;
     }
 
-    *data = cb->buffer[cb->tail];
-    cb->tail = (cb->tail + 1) & cb->mask;
+    *data = cb->buffer[tail];
+    store_release(&cb->tail, (tail + 1) & cb->mask);
     return true;
 }
 
 /**
  * @brief Reset (empty) a circular buffer
  *
+ * Neither side may be using the buffer meanwhile.
+ *
  * @param cb Pointer to circular buffer structure
  */
 void circular_buffer_reset(CircularBuffer *cb)
 {
-    if (!cb) {
-        THROW(ERROR_INVALID_ARGUMENT);
-    }
+    CHECK_ARGUMENT(cb);
     cb->head = cb->tail = 0;
+    cb->overwritten = 0;
 }
 
 /**
  * @brief Write multiple bytes to circular buffer
  *
+ * Head and tail are sampled once and the data is copied in at most two
+ * contiguous spans. The head index is published only after the copy, so a
+ * concurrent reader never sees partially written data.
+ *
  * @param cb Pointer to circular buffer structure
  * @param data Pointer to data to write
  * @param len Number of bytes to write
  * @return Number of bytes actually written
  */
-uint32_t circular_buffer_write(
+RAMFUNC uint32_t circular_buffer_write(
     CircularBuffer *cb,
     uint8_t const *data,
     uint32_t len
 )
 {
-    if (!cb || !data) {
-        THROW(ERROR_INVALID_ARGUMENT);
-    }
-
-    uint32_t bytes_written = 0;
+    CHECK_ARGUMENT(cb && data);
 
-    while (bytes_written < len && !circular_buffer_is_full(cb)) {
-        if (circular_buffer_put(cb, data[bytes_written])) {
-            bytes_written++;
-        } else {
-            break;
+    uint32_t const head = cb->head;
+    uint32_t count;
+    if (cb->overwrite) {
+        // Only the last bytes that fit are kept, room made for all of them
+        uint32_t const capacity = cb->size - 1;
+        if (len > capacity) {
+            cb->overwritten += len - capacity;
+            data += len - capacity;
+            len = capacity;
         }
+        drop_oldest(cb, head, len);
+        count = len;
+    } else {
+        uint32_t const tail = load_acquire(&cb->tail);
+        uint32_t const free_space =
+            (cb->size - 1) - ((head - tail) & cb->mask);
+        count = len < free_space ? len : free_space;
     }
 
-    return bytes_written;
+    // First span runs from head to the end of the storage, second wraps
+    uint32_t const first = count < (cb->size - head) ? count : cb->size - head;
+    memcpy(&cb->buffer[head], data, first);
+    memcpy(cb->buffer, &data[first], count - first);
+
+    store_release(&cb->head, (head + count) & cb->mask);
+    return count;
 }
 
 /**
  * @brief Read multiple bytes from circular buffer
  *
+ * Counterpart of circular_buffer_write: at most two contiguous copies, with
+ * the tail index published after the data has been read out.
+ *
  * @param cb Pointer to circular buffer structure
  * @param data Pointer to buffer for read data
  * @param len Maximum number of bytes to read
  * @return Number of bytes actually read
  */
-uint32_t circular_buffer_read(CircularBuffer *cb, uint8_t *data, uint32_t len)
+RAMFUNC uint32_t circular_buffer_read(
+    CircularBuffer *cb,
+    uint8_t *data,
+    uint32_t len
+)
 {
-    if (!cb || !data) {
-        THROW(ERROR_INVALID_ARGUMENT);
-    }
+    CHECK_ARGUMENT(cb && data);
+
+    uint32_t tail = cb->overwrite ? load_acquire(&cb->tail) : cb->tail;
+    for (;;) {
+        uint32_t const head = load_acquire(&cb->head);
+        uint32_t const used = (head - tail) & cb->mask;
+        uint32_t const count = len < used ? len : used;
 
-    uint32_t bytes_read = 0;
+        // First span runs from tail to the end of the storage, second wraps
+        uint32_t const first =
+            count < (cb->size - tail) ? count : cb->size - tail;
+        memcpy(data, &cb->buffer[tail], first);
+        memcpy(&data[first], cb->buffer, count - first);
 
-    while (bytes_read < len && !circular_buffer_is_empty(cb)) {
-        if (circular_buffer_get(cb, &data[bytes_read])) {
-            bytes_read++;
-        } else {
-            break;
+        uint32_t const next = (tail + count) & cb->mask;
+        if (!cb->overwrite) {
+            store_release(&cb->tail, next);
+            return count;
         }
+        if (compare_exchange_tail(cb, &tail, next)) {
+            return count;
+        }
+        // The producer dropped bytes meanwhile; copy again from the new tail
     }
-
-    return bytes_read;
 }
 
 /**
@@ -199,10 +345,111 @@ uint32_t circular_buffer_read(CircularBuffer *cb, uint8_t *data, uint32_t len)
  * @param cb Pointer to circular buffer structure
  * @return Number of bytes free in the buffer
  */
-uint32_t circular_buffer_free_space(CircularBuffer *cb)
+RAMFUNC uint32_t circular_buffer_free_space(CircularBuffer *cb)
 {
-    if (!cb) {
-        THROW(ERROR_INVALID_ARGUMENT);
-    }
-    return (cb->size - 1) - ((cb->head - cb->tail) & cb->mask);
+    CHECK_ARGUMENT(cb);
+    return (cb->size - 1) -
+           ((load_acquire(&cb->head) - load_acquire(&cb->tail)) & cb->mask);
+}
+
+/**
+ * @brief Get the contiguous span of readable data at the tail
+ *
+ * @param cb Pointer to circular buffer structure
+ * @param data Set to the start of the readable span
+ * @return Number of contiguous bytes readable at *data
+ */
+RAMFUNC uint32_t circular_buffer_peek_contiguous(
+    CircularBuffer *cb,
+    uint8_t const **data
+)
+{
+    CHECK_ARGUMENT(cb && data && !cb->overwrite);
+
+    uint32_t const head = load_acquire(&cb->head);
+    uint32_t const tail = cb->tail;
+    uint32_t const used = (head - tail) & cb->mask;
+    uint32_t const to_end = cb->size - tail;
+
+    *data = &cb->buffer[tail];
+    return used < to_end ? used : to_end;
+}
+
+/**
+ * @brief Get all readable data at the tail as two contiguous spans
+ *
+ * @param cb Pointer to circular buffer structure
+ * @param first Set to the start of the readable span at the tail
+ * @param first_len Set to the number of bytes readable at *first
+ * @param second Set to the start of the storage, where the data continues
+ * @return Number of bytes readable in total
+ */
+RAMFUNC uint32_t circular_buffer_peek_spans(
+    CircularBuffer *cb,
+    uint8_t const **first,
+    uint32_t *first_len,
+    uint8_t const **second
+)
+{
+    CHECK_ARGUMENT(cb && first && first_len && second && !cb->overwrite);
+
+    uint32_t const head = load_acquire(&cb->head);
+    uint32_t const tail = cb->tail;
+    uint32_t const used = (head - tail) & cb->mask;
+    uint32_t const to_end = cb->size - tail;
+
+    *first = &cb->buffer[tail];
+    *first_len = used < to_end ? used : to_end;
+    *second = cb->buffer;
+    return used;
+}
+
+/**
+ * @brief Release bytes previously obtained with circular_buffer_peek_contiguous
+ *
+ * @param cb Pointer to circular buffer structure
+ * @param len Number of bytes consumed
+ */
+RAMFUNC void circular_buffer_commit_read(CircularBuffer *cb, uint32_t len)
+{
+    CHECK_ARGUMENT(
+        cb && !cb->overwrite && len <= circular_buffer_available(cb)
+    );
+    store_release(&cb->tail, (cb->tail + len) & cb->mask);
+}
+
+/**
+ * @brief Get the contiguous span of free storage at the head
+ *
+ * @param cb Pointer to circular buffer structure
+ * @param data Set to the start of the writable span
+ * @return Number of contiguous bytes writable at *data
+ */
+RAMFUNC uint32_t circular_buffer_reserve_contiguous(
+    CircularBuffer *cb,
+    uint8_t **data
+)
+{
+    CHECK_ARGUMENT(cb && data);
+
+    uint32_t const head = cb->head;
+    uint32_t const tail = load_acquire(&cb->tail);
+    uint32_t const free_space = (cb->size - 1) - ((head - tail) & cb->mask);
+    uint32_t const to_end = cb->size - head;
+
+    *data = &cb->buffer[head];
+    return free_space < to_end ? free_space : to_end;
+}
+
+/**
+ * @brief Publish bytes written into a span from
+ * circular_buffer_reserve_contiguous
+ *
+ * @param cb Pointer to circular buffer structure
+ * @param len Number of bytes written
+ */
+RAMFUNC void circular_buffer_commit_write(CircularBuffer *cb, uint32_t len)
+{
+    CHECK_ARGUMENT(cb && len <= circular_buffer_free_space(cb));
+    store_release(&cb->head, (cb->head + len) & cb->mask);
 }
@@ -0,0 +1,76 @@
+/**
+ * @file crc.h
+ * @brief CRC-16/CCITT-FALSE and CRC-32/MPEG-2 checksums
+ *
+ * CRC-16: polynomial 0x1021, initial value 0xFFFF, no reflection and no
+ * final XOR, the check value of "123456789" being 0x29B1.
+ *
+ * CRC-32: polynomial 0x04C11DB7, initial value 0xFFFFFFFF, no reflection
+ * and no final XOR, the check value of "123456789" being 0x0376E6E7. This is
+ * what the STM32 CRC unit computes with its default settings, fed either
+ * one byte at a time or one 32-bit word at a time, as the bootloader does
+ * over the firmware image.
+ *
+ * Both checksums can be computed in pieces, passing the result of one call
+ * as the start value of the next, so a frame does not need to be contiguous
+ * in memory.
+ *
+ * @author PSLab Team
+ * @date 2025-10-20
+ */
+
+#ifndef PSLAB_CRC_H
+#define PSLAB_CRC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum { CRC16_INIT = 0xFFFF }; // Start value of a new checksum
+
+#define CRC32_INIT UINT32_C(0xFFFFFFFF) // Start value of a new checksum
+
+/**
+ * @brief Continue a CRC-16 over more data
+ *
+ * @param crc CRC16_INIT, or the result over the preceding data
+ * @param data Input bytes
+ * @param size Number of bytes
+ * @return CRC over the preceding data and this block
+ */
+uint16_t CRC16_update(uint16_t crc, void const *data, uint32_t size);
+
+/**
+ * @brief Continue a CRC-32 over more data
+ *
+ * @param crc CRC32_INIT, or the result over the preceding data
+ * @param data Input bytes
+ * @param size Number of bytes
+ * @return CRC over the preceding data and this block
+ */
+uint32_t CRC32_update(uint32_t crc, void const *data, uint32_t size);
+
+/**
+ * @brief Continue a CRC-32 over more 32-bit words
+ *
+ * Each word is taken most significant byte first, like the STM32 CRC unit
+ * does with words written to its data register.
+ *
+ * @param crc CRC32_INIT, or the result over the preceding words
+ * @param words Input words
+ * @param count Number of words
+ * @return CRC over the preceding words and these
+ */
+uint32_t CRC32_update_words(
+    uint32_t crc,
+    uint32_t const *words,
+    uint32_t count
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_CRC_H
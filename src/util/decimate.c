@@ -0,0 +1,234 @@
+/**
+ * @file decimate.c
+ * @brief Sample decimation kernels for peak-detect and averaging capture
+ *
+ * See decimate.h for a description of the output layout.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fixed_point.h"
+
+#include "decimate.h"
+
+enum {
+    // Fraction bits of the FIR input, which keep the CIC's extra precision
+    FIR_INPUT_FRAC_BITS = 3,
+    // Rounding and scale of the FIR output: Q15 taps on the FIR input
+    FIR_OUTPUT_SHIFT = FIXED_Q15_FRAC_BITS + FIR_INPUT_FRAC_BITS,
+};
+
+// FIR taps in Q15, summing to 1: a least-squares fit of 1 / sinc(f)^4
+// from 0 to 0.2 of the CIC output rate and of 0 from 0.3 to 0.5, with the
+// stopband weighted 30 times. Symmetric, so the delay is 23 CIC outputs.
+static FIXED_Q15 const g_FIR_TAPS[DECIMATE_FIR_TAPS] = {
+    -2,    5,     14,    -14,  -41,   29,    97,    -50,   -196, 75,
+    358,   -102,  -611,  123,  998,   -123,  -1599, 67,    2607, 164,
+    -4654, -1286, 11222, 18606, 11222, -1286, -4654, 164,   2607, 67,
+    -1599, -123,  998,   123,  -611,  -102,  358,   75,    -196, -50,
+    97,    29,    -41,   -14,  14,    5,     -2,
+};
+
+uint32_t DECIMATE_peak(
+    uint16_t const *in,
+    uint32_t const count,
+    uint32_t const channels,
+    uint32_t const factor,
+    uint16_t *out
+)
+{
+    uint32_t const group = 2 * factor * channels;
+    uint32_t written = 0;
+
+    if (group == 0) {
+        return 0;
+    }
+
+    for (uint32_t base = 0; count - base >= group; base += group) {
+        for (uint32_t channel = 0; channel < channels; ++channel) {
+            uint16_t low = UINT16_MAX;
+            uint16_t high = 0;
+
+            for (uint32_t i = base + channel; i < base + group; i += channels) {
+                if (in[i] < low) {
+                    low = in[i];
+                }
+                if (in[i] > high) {
+                    high = in[i];
+                }
+            }
+
+            out[written + channel] = low;
+            out[written + channels + channel] = high;
+        }
+        written += 2 * channels;
+    }
+
+    return written;
+}
+
+uint32_t DECIMATE_average(
+    uint16_t const *in,
+    uint32_t const count,
+    uint32_t const channels,
+    uint32_t const factor,
+    uint16_t *out
+)
+{
+    uint32_t const group = factor * channels;
+    uint32_t written = 0;
+
+    if (group == 0) {
+        return 0;
+    }
+
+    for (uint32_t base = 0; count - base >= group; base += group) {
+        for (uint32_t channel = 0; channel < channels; ++channel) {
+            uint32_t sum = factor / 2;
+
+            for (uint32_t i = base + channel; i < base + group; i += channels) {
+                sum += in[i];
+            }
+
+            out[written++] = (uint16_t)(sum / factor);
+        }
+    }
+
+    return written;
+}
+
+bool DECIMATE_filter_init(
+    DECIMATE_Filter *filter,
+    uint32_t const channels,
+    uint32_t const factor,
+    uint16_t const sample_max
+)
+{
+    if (channels == 0 || channels > DECIMATE_CHANNELS_MAX ||
+        factor < DECIMATE_FILTER_FACTOR_MIN ||
+        factor > DECIMATE_FILTER_FACTOR_MAX || factor % 2 != 0 ||
+        sample_max > DECIMATE_FILTER_SAMPLE_MAX) {
+        return false;
+    }
+
+    uint32_t const ratio = factor / 2;
+    uint64_t cic_gain = 1;
+    for (uint32_t stage = 0; stage < DECIMATE_CIC_ORDER; ++stage) {
+        cic_gain *= ratio;
+    }
+
+    memset(filter, 0, sizeof(*filter));
+    filter->channels = channels;
+    filter->ratio = ratio;
+    filter->gain = (uint32_t)(
+        ((UINT64_C(1) << (32 + FIR_INPUT_FRAC_BITS)) + (cic_gain / 2)) /
+        cic_gain
+    );
+    filter->sample_max = sample_max;
+    filter->settle = DECIMATE_CIC_ORDER + DECIMATE_FIR_TAPS;
+    return true;
+}
+
+/**
+ * @brief Comb a channel's integrators and add the result to its FIR input
+ */
+static void cic_output(
+    DECIMATE_Filter const *filter,
+    DECIMATE_FilterChannel *state,
+    uint32_t const integrated
+)
+{
+    uint32_t value = integrated;
+    for (uint32_t stage = 0; stage < DECIMATE_CIC_ORDER; ++stage) {
+        uint32_t const previous = state->combs[stage];
+        state->combs[stage] = value;
+        value -= previous;
+    }
+
+    // The CIC output is an average, so it stays below 2^15 in Q15
+    FIXED_Q15 const sample =
+        (FIXED_Q15)(((uint64_t)value * filter->gain + (UINT32_C(1) << 31)) >>
+                    32);
+    state->history[state->position] = sample;
+    state->history[state->position + DECIMATE_FIR_TAPS] = sample;
+    state->position = (state->position + 1) % DECIMATE_FIR_TAPS;
+}
+
+/**
+ * @brief Output of a channel's FIR over its latest inputs
+ */
+static uint16_t fir_output(
+    DECIMATE_Filter const *filter,
+    DECIMATE_FilterChannel const *state
+)
+{
+    int64_t const sum = FIXED_q15_dot(
+        g_FIR_TAPS, &state->history[state->position], DECIMATE_FIR_TAPS
+    );
+
+    // Ringing on steps may reach past the input range
+    if (sum <= 0) {
+        return 0;
+    }
+    uint64_t const sample =
+        ((uint64_t)sum + (UINT64_C(1) << (FIR_OUTPUT_SHIFT - 1))) >>
+        FIR_OUTPUT_SHIFT;
+    return sample > filter->sample_max ? filter->sample_max : (uint16_t)sample;
+}
+
+uint32_t DECIMATE_filter(
+    DECIMATE_Filter *filter,
+    uint16_t const *in,
+    uint32_t const count,
+    uint16_t *out,
+    uint32_t const room
+)
+{
+    uint32_t const channels = filter->channels;
+    uint32_t written = 0;
+
+    for (uint32_t base = 0; count - base >= channels; base += channels) {
+        if (room - written < channels) {
+            break;
+        }
+
+        for (uint32_t channel = 0; channel < channels; ++channel) {
+            uint32_t *const integrators =
+                filter->channel[channel].integrators;
+            uint32_t value = in[base + channel];
+            for (uint32_t stage = 0; stage < DECIMATE_CIC_ORDER; ++stage) {
+                integrators[stage] += value;
+                value = integrators[stage];
+            }
+        }
+
+        if (++filter->phase < filter->ratio) {
+            continue;
+        }
+        filter->phase = 0;
+
+        for (uint32_t channel = 0; channel < channels; ++channel) {
+            DECIMATE_FilterChannel *const state = &filter->channel[channel];
+            cic_output(
+                filter, state, state->integrators[DECIMATE_CIC_ORDER - 1]
+            );
+        }
+
+        if (filter->settle > 0) {
+            filter->settle--;
+            continue;
+        }
+
+        filter->odd = !filter->odd;
+        if (filter->odd) {
+            continue;
+        }
+
+        for (uint32_t channel = 0; channel < channels; ++channel) {
+            out[written++] = fir_output(filter, &filter->channel[channel]);
+        }
+    }
+
+    return written;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file decimate.h
+ * @brief Sample decimation kernels for peak-detect, averaging and filtered
+ *        capture
+ *
+ * Input is a record of interleaved frames, one sample per channel in each
+ * frame. The kernels reduce @p factor input frames to one output frame per
+ * channel, so the output is again an interleaved record at 1 / factor of
+ * the input rate:
+ *
+ * - peak: every 2 * factor input frames become a frame of per-channel
+ *   minima followed by a frame of per-channel maxima, so glitches shorter
+ *   than an output sample period remain visible
+ * - average: every factor input frames become their per-channel mean,
+ *   rounded to nearest, which lowers noise by up to sqrt(factor)
+ * - filter: an anti-aliasing low-pass, a CIC decimator followed by a FIR
+ *   that compensates its droop and decimates by the final 2
+ *
+ * Only whole groups are reduced by peak and average; trailing input that
+ * does not fill a group is ignored. The filter keeps its state between
+ * calls, so a record may be passed in blocks of any number of frames. The
+ * kernels are allocation free and safe to call from interrupt context.
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#ifndef PSLAB_DECIMATE_H
+#define PSLAB_DECIMATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Reduce samples to per-channel (min, max) frame pairs
+ *
+ * @param in Input samples, interleaved by channel
+ * @param count Number of input samples (all channels)
+ * @param channels Samples per frame
+ * @param factor Input frames per output frame
+ * @param out Output buffer with room for count / factor samples
+ *
+ * @return Number of samples written to @p out
+ */
+uint32_t DECIMATE_peak(
+    uint16_t const *in,
+    uint32_t count,
+    uint32_t channels,
+    uint32_t factor,
+    uint16_t *out
+);
+
+/**
+ * @brief Reduce samples to per-channel averages
+ *
+ * @param in Input samples, interleaved by channel
+ * @param count Number of input samples (all channels)
+ * @param channels Samples per frame
+ * @param factor Input frames per output frame
+ * @param out Output buffer with room for count / factor samples
+ *
+ * @return Number of samples written to @p out
+ */
+uint32_t DECIMATE_average(
+    uint16_t const *in,
+    uint32_t count,
+    uint32_t channels,
+    uint32_t factor,
+    uint16_t *out
+);
+
+enum {
+    /** @brief Most channels a filter decimates */
+    DECIMATE_CHANNELS_MAX = 4,
+    /** @brief Integrator and comb stages of the CIC decimator */
+    DECIMATE_CIC_ORDER = 4,
+    /** @brief Taps of the compensating FIR */
+    DECIMATE_FIR_TAPS = 47,
+    /** @brief Smallest filter factor; the FIR assumes a CIC of 4 or more */
+    DECIMATE_FILTER_FACTOR_MIN = 8,
+    /** @brief Largest filter factor; the CIC registers have 32 bits */
+    DECIMATE_FILTER_FACTOR_MAX = 64,
+    /** @brief Largest input sample of the filter, 12 bits */
+    DECIMATE_FILTER_SAMPLE_MAX = 4095,
+};
+
+/**
+ * @brief Filter state of one channel
+ */
+typedef struct {
+    uint32_t integrators[DECIMATE_CIC_ORDER];
+    uint32_t combs[DECIMATE_CIC_ORDER]; // Previous input of each comb
+    // FIR input twice over, so the latest taps are always contiguous
+    FIXED_Q15 history[2 * DECIMATE_FIR_TAPS];
+    uint32_t position; // Next history entry written
+} DECIMATE_FilterChannel;
+
+/**
+ * @brief Decimating low-pass filter state
+ *
+ * The CIC decimates by factor / 2 with wrapping 32-bit integrators and
+ * combs, which is exact as long as its gain (factor / 2)^4 times the
+ * largest sample fits in 32 bits. Its output is normalized to Q15 with
+ * three fraction bits on the sample and reduced by the 47-tap FIR, which
+ * flattens the CIC's droop to within 0.5% up to 0.4 times the output rate
+ * (from a factor of 16; 1.6% at 8) and attenuates from 0.6 times the
+ * output rate on by 78 dB. Images the CIC folds into the passband are at
+ * least 48 dB down. After DECIMATE_filter_init, the first outputs are
+ * held back until the filter has settled, about 25 output samples.
+ */
+typedef struct {
+    DECIMATE_FilterChannel channel[DECIMATE_CHANNELS_MAX];
+    uint32_t channels;
+    uint32_t ratio; // CIC decimation, factor / 2
+    uint32_t gain; // CIC output to Q15, in units of 2^-32
+    uint16_t sample_max; // Outputs are clamped to 0 to sample_max
+    uint32_t phase; // Input frames since the last CIC output
+    bool odd; // A CIC output is pending for the FIR's decimation by 2
+    uint32_t settle; // CIC outputs left before output starts
+} DECIMATE_Filter;
+
+/**
+ * @brief Prepare a filter for a record
+ *
+ * @param filter Filter state
+ * @param channels Samples per frame, 1 to DECIMATE_CHANNELS_MAX
+ * @param factor Input frames per output frame, even, from
+ *               DECIMATE_FILTER_FACTOR_MIN to DECIMATE_FILTER_FACTOR_MAX
+ * @param sample_max Largest input sample, at most DECIMATE_FILTER_SAMPLE_MAX
+ *
+ * @return false if an argument is out of range
+ */
+bool DECIMATE_filter_init(
+    DECIMATE_Filter *filter,
+    uint32_t channels,
+    uint32_t factor,
+    uint16_t sample_max
+);
+
+/**
+ * @brief Low-pass filter and decimate a block of samples
+ *
+ * @param filter Filter state from DECIMATE_filter_init
+ * @param in Input samples, interleaved by channel, whole frames
+ * @param count Number of input samples (all channels)
+ * @param out Output buffer
+ * @param room Samples @p out has room for, whole frames; input past the
+ *             frame that fills it is not consumed
+ *
+ * @return Number of samples written to @p out
+ */
+uint32_t DECIMATE_filter(
+    DECIMATE_Filter *filter,
+    uint16_t const *in,
+    uint32_t count,
+    uint16_t *out,
+    uint32_t room
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_DECIMATE_H
@@ -0,0 +1,160 @@
+/**
+ * @file delta_codec.c
+ * @brief Lossless delta/run-length codec for sample streams
+ *
+ * See delta_codec.h for a description of the encoded format.
+ */
+#include <stdint.h>
+
+#include "delta_codec.h"
+#include "error.h"
+
+enum {
+    TAG_SAMPLE = 0,
+    TAG_RUN = 1,
+    // Keep run tokens within 32 bits
+    RUN_MAX = UINT32_MAX >> 1,
+};
+
+static uint32_t put_varint(uint32_t value, uint8_t *out)
+{
+    uint32_t len = 0;
+
+    while (value >= 0x80) {
+        if (out) {
+            out[len] = (uint8_t)(value | 0x80);
+        }
+        value >>= 7;
+        ++len;
+    }
+
+    if (out) {
+        out[len] = (uint8_t)value;
+    }
+    return len + 1;
+}
+
+static uint32_t put_run(DELTA_Encoder *const encoder, uint8_t *const out)
+{
+    if (encoder->run == 0) {
+        return 0;
+    }
+
+    uint32_t const token = ((encoder->run - 1) << 1) | TAG_RUN;
+    encoder->run = 0;
+    return put_varint(token, out);
+}
+
+void DELTA_encoder_init(DELTA_Encoder *const encoder)
+{
+    if (!encoder) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    encoder->previous = 0;
+    encoder->run = 0;
+}
+
+uint32_t DELTA_encode(
+    DELTA_Encoder *const encoder,
+    uint16_t const *const samples,
+    uint32_t const count,
+    uint8_t *const out
+)
+{
+    if (!encoder || (!samples && count)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    uint32_t len = 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        int16_t const delta = (int16_t)(samples[i] - encoder->previous);
+
+        if (delta == 0) {
+            if (++encoder->run == RUN_MAX) {
+                len += put_run(encoder, out ? out + len : nullptr);
+            }
+            continue;
+        }
+
+        len += put_run(encoder, out ? out + len : nullptr);
+
+        // Zigzag: 0, -1, 1, -2, 2, ... -> 0, 1, 2, 3, 4, ...
+        uint32_t const zigzag =
+            ((uint32_t)(uint16_t)delta << 1) ^ (delta < 0 ? 0x1FFFFU : 0);
+        uint32_t const token = (zigzag << 1) | TAG_SAMPLE;
+        len += put_varint(token, out ? out + len : nullptr);
+        encoder->previous = samples[i];
+    }
+
+    return len;
+}
+
+uint32_t DELTA_encode_finish(DELTA_Encoder *const encoder, uint8_t *const out)
+{
+    if (!encoder) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+    return put_run(encoder, out);
+}
+
+uint32_t DELTA_encoded_size(uint16_t const *const samples, uint32_t const count)
+{
+    DELTA_Encoder encoder;
+    DELTA_encoder_init(&encoder);
+    uint32_t const len = DELTA_encode(&encoder, samples, count, nullptr);
+    return len + DELTA_encode_finish(&encoder, nullptr);
+}
+
+uint32_t DELTA_decode(
+    uint8_t const *const data,
+    uint32_t const len,
+    uint16_t *const samples,
+    uint32_t const max_samples
+)
+{
+    if ((!data && len) || (!samples && max_samples)) {
+        THROW(ERROR_INVALID_ARGUMENT);
+    }
+
+    uint16_t previous = 0;
+    uint32_t count = 0;
+    uint32_t pos = 0;
+
+    while (pos < len) {
+        uint32_t token = 0;
+        uint32_t shift = 0;
+        uint8_t byte = 0;
+
+        do {
+            if (pos >= len || shift > 28) {
+                THROW(ERROR_INVALID_ARGUMENT);
+            }
+            byte = data[pos++];
+            token |= (uint32_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+
+        if ((token & 1) == TAG_RUN) {
+            uint32_t const run = (token >> 1) + 1;
+            if (run > max_samples - count) {
+                THROW(ERROR_INVALID_ARGUMENT);
+            }
+            for (uint32_t i = 0; i < run; ++i) {
+                samples[count++] = previous;
+            }
+            continue;
+        }
+
+        uint32_t const zigzag = token >> 1;
+        if (zigzag > UINT16_MAX || count >= max_samples) {
+            THROW(ERROR_INVALID_ARGUMENT);
+        }
+        uint16_t const delta = (zigzag & 1) ? (uint16_t)~(zigzag >> 1)
+                                            : (uint16_t)(zigzag >> 1);
+        previous = (uint16_t)(previous + delta);
+        samples[count++] = previous;
+    }
+
+    return count;
+}
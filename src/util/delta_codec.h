@@ -0,0 +1,132 @@
+/**
+ * @file delta_codec.h
+ * @brief Lossless delta/run-length codec for sample streams
+ *
+ * Samples are encoded as the difference to the previous sample, zigzag
+ * mapped to an unsigned value and written as a little-endian base-128
+ * variable-length integer (LEB128). Runs of unchanged samples are collapsed
+ * into a single run token. Each token carries a tag in its least significant
+ * bit:
+ *
+ * - tag 0: one sample, payload is the zigzag encoded delta
+ * - tag 1: payload + 1 repetitions of the previous sample
+ *
+ * Deltas are computed modulo 2^16, so any uint16_t sequence round-trips.
+ * The first sample is encoded relative to zero. For 12-bit ADC data a
+ * sample never takes more than two bytes, and slow or flat signals shrink
+ * to close to one byte per sample or far less.
+ *
+ * The encoder keeps its state between calls, so a block may be encoded in
+ * arbitrary chunks and the output is identical to encoding it in one go.
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#ifndef PSLAB_DELTA_CODEC_H
+#define PSLAB_DELTA_CODEC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    /** @brief Maximum encoded size of a single sample token */
+    DELTA_MAX_SAMPLE_BYTES = 3,
+    /** @brief Maximum encoded size of a single run token */
+    DELTA_MAX_RUN_BYTES = 5,
+};
+
+/**
+ * @brief Upper bound on bytes produced by DELTA_encode for @p count samples
+ *
+ * Also covers the bytes produced by a subsequent DELTA_encode_finish call.
+ */
+#define DELTA_ENCODE_BOUND(count)                                              \
+    ((count) * DELTA_MAX_SAMPLE_BYTES + DELTA_MAX_RUN_BYTES)
+
+/**
+ * @brief Encoder state
+ */
+typedef struct {
+    uint16_t previous;
+    uint32_t run;
+} DELTA_Encoder;
+
+/**
+ * @brief Reset encoder state for a new block
+ *
+ * @param encoder Encoder to reset
+ */
+void DELTA_encoder_init(DELTA_Encoder *encoder);
+
+/**
+ * @brief Encode samples
+ *
+ * A pending run of repeated samples is held back until a differing sample
+ * arrives or DELTA_encode_finish is called.
+ *
+ * @param encoder Encoder state
+ * @param samples Samples to encode
+ * @param count Number of samples
+ * @param out Output buffer with room for DELTA_ENCODE_BOUND(count) bytes,
+ *            or nullptr to only compute the encoded size
+ *
+ * @return Number of bytes produced
+ */
+uint32_t DELTA_encode(
+    DELTA_Encoder *encoder,
+    uint16_t const *samples,
+    uint32_t count,
+    uint8_t *out
+);
+
+/**
+ * @brief Flush a pending run at the end of a block
+ *
+ * @param encoder Encoder state
+ * @param out Output buffer with room for DELTA_MAX_RUN_BYTES bytes, or
+ *            nullptr to only compute the encoded size
+ *
+ * @return Number of bytes produced
+ */
+uint32_t DELTA_encode_finish(DELTA_Encoder *encoder, uint8_t *out);
+
+/**
+ * @brief Encoded size of a complete block
+ *
+ * @param samples Samples to encode
+ * @param count Number of samples
+ *
+ * @return Number of bytes DELTA_encode plus DELTA_encode_finish will produce
+ *         for the block
+ */
+uint32_t DELTA_encoded_size(uint16_t const *samples, uint32_t count);
+
+/**
+ * @brief Decode a complete block
+ *
+ * @param data Encoded data
+ * @param len Length of encoded data in bytes
+ * @param samples Output sample buffer
+ * @param max_samples Capacity of the output buffer in samples
+ *
+ * @return Number of samples decoded
+ *
+ * @throws ERROR_INVALID_ARGUMENT if the data is truncated, malformed or
+ *         decodes to more than @p max_samples samples
+ */
+uint32_t DELTA_decode(
+    uint8_t const *data,
+    uint32_t len,
+    uint16_t *samples,
+    uint32_t max_samples
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_DELTA_CODEC_H
@@ -0,0 +1,131 @@
+/**
+ * @file equivalent_time.c
+ * @brief Equivalent-time reconstruction of repetitive waveforms
+ *
+ * See equivalent_time.h for how captures are aligned.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "equivalent_time.h"
+
+void ETS_clear(uint16_t *record, uint32_t const size)
+{
+    for (uint32_t i = 0; i < size; ++i) {
+        record[i] = ETS_EMPTY;
+    }
+}
+
+bool ETS_find_crossing(
+    uint16_t const *samples,
+    uint32_t const count,
+    uint32_t const hint,
+    uint16_t const level,
+    bool const rising,
+    uint32_t const steps,
+    ETS_Crossing *crossing
+)
+{
+    if (count < 2) {
+        return false;
+    }
+
+    for (uint32_t i = hint < count ? hint : count - 1; i >= 1; --i) {
+        int32_t const before = samples[i - 1];
+        int32_t const after = samples[i];
+        int32_t past = 0; // Distance of the second sample past the level
+        int32_t span = 0; // Distance between the two samples
+
+        if (rising && before < level && after >= level) {
+            past = after - level;
+            span = after - before;
+        } else if (!rising && before > level && after <= level) {
+            past = level - after;
+            span = before - after;
+        } else {
+            continue;
+        }
+
+        crossing->index = i;
+        crossing->phase =
+            (((uint32_t)past * steps) + ((uint32_t)span / 2)) / (uint32_t)span;
+        return true;
+    }
+
+    return false;
+}
+
+void ETS_insert(
+    uint16_t const *samples,
+    uint32_t const count,
+    ETS_Crossing const *crossing,
+    uint32_t const steps,
+    uint32_t const origin,
+    uint16_t *record,
+    uint32_t const size
+)
+{
+    int64_t point = (int64_t)origin + crossing->phase -
+                    ((int64_t)crossing->index * steps);
+
+    for (uint32_t i = 0; i < count; ++i, point += steps) {
+        if (point < 0) {
+            continue;
+        }
+        if (point >= size) {
+            break;
+        }
+        uint16_t *const target = &record[point];
+        *target = *target == ETS_EMPTY
+                      ? samples[i]
+                      : (uint16_t)((*target + samples[i] + 1U) / 2U);
+    }
+}
+
+uint32_t ETS_fill_gaps(uint16_t *record, uint32_t const size)
+{
+    uint32_t first = 0;
+    while (first < size && record[first] == ETS_EMPTY) {
+        ++first;
+    }
+
+    if (first == size) {
+        for (uint32_t i = 0; i < size; ++i) {
+            record[i] = 0;
+        }
+        return size;
+    }
+
+    uint32_t empty = first;
+    for (uint32_t i = 0; i < first; ++i) {
+        record[i] = record[first];
+    }
+
+    uint32_t last = first; // Most recent point holding a sample
+    for (uint32_t i = first + 1; i < size; ++i) {
+        if (record[i] == ETS_EMPTY) {
+            continue;
+        }
+
+        int32_t const start = record[last];
+        int32_t const delta = (int32_t)record[i] - start;
+        int32_t const length = (int32_t)(i - last);
+        for (uint32_t k = last + 1; k < i; ++k) {
+            int32_t const offset = delta * (int32_t)(k - last);
+            // Round to nearest, away from zero at halves
+            int32_t const rounded = offset >= 0
+                                        ? (offset + (length / 2)) / length
+                                        : (offset - (length / 2)) / length;
+            record[k] = (uint16_t)(start + rounded);
+        }
+        empty += i - last - 1;
+        last = i;
+    }
+
+    for (uint32_t i = last + 1; i < size; ++i) {
+        record[i] = record[last];
+    }
+    empty += size - last - 1;
+
+    return empty;
+}
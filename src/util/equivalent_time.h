@@ -0,0 +1,124 @@
+/**
+ * @file equivalent_time.h
+ * @brief Equivalent-time reconstruction of repetitive waveforms
+ *
+ * A repetitive signal captured many times with an asynchronous sample clock
+ * is sampled at a different phase on each capture. Measuring where the
+ * signal crossed the trigger level between two samples gives that phase,
+ * and placing each capture's samples on a grid @p steps times finer than
+ * the sample period, aligned to the crossing, builds up a record at
+ * @p steps times the real-time sample rate.
+ *
+ * The crossing is found by linear interpolation between the samples either
+ * side of the trigger level, so the trigger edge must span at least two
+ * samples; faster features elsewhere in the waveform are resolved.
+ *
+ * Records hold ETS_EMPTY in points no capture has reached yet. Points hit
+ * more than once keep the running mean of the two latest values.
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#ifndef PSLAB_EQUIVALENT_TIME_H
+#define PSLAB_EQUIVALENT_TIME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    /** @brief Marker for record points without a sample */
+    ETS_EMPTY = UINT16_MAX,
+};
+
+/**
+ * @brief Trigger crossing of one capture
+ */
+typedef struct {
+    uint32_t index; /**< First sample past the trigger level */
+    uint32_t phase; /**< Crossing time before that sample, in 1 / steps */
+} ETS_Crossing;
+
+/**
+ * @brief Mark every point of a record as empty
+ *
+ * @param record Equivalent-time record
+ * @param size Number of points in the record
+ */
+void ETS_clear(uint16_t *record, uint32_t size);
+
+/**
+ * @brief Locate the trigger crossing in a capture
+ *
+ * Searches backwards from @p hint, typically the position at which the
+ * trigger was detected, for the nearest pair of samples straddling the
+ * level in the trigger direction.
+ *
+ * @param samples Samples of one capture
+ * @param count Number of samples
+ * @param hint Sample index to start searching from
+ * @param level Trigger level in sample units
+ * @param rising Look for a rising (true) or falling (false) crossing
+ * @param steps Equivalent-time points per sample period
+ * @param crossing Output, written if a crossing was found
+ *
+ * @return true if a crossing was found
+ */
+bool ETS_find_crossing(
+    uint16_t const *samples,
+    uint32_t count,
+    uint32_t hint,
+    uint16_t level,
+    bool rising,
+    uint32_t steps,
+    ETS_Crossing *crossing
+);
+
+/**
+ * @brief Place the samples of one capture into a record
+ *
+ * Sample i lands at record point
+ * origin + (i - crossing->index) * steps + crossing->phase, so the crossing
+ * itself falls on @p origin. Samples outside the record are dropped.
+ *
+ * @param samples Samples of one capture
+ * @param count Number of samples
+ * @param crossing Trigger crossing of the capture
+ * @param steps Equivalent-time points per sample period
+ * @param origin Record point of the trigger crossing
+ * @param record Equivalent-time record
+ * @param size Number of points in the record
+ */
+void ETS_insert(
+    uint16_t const *samples,
+    uint32_t count,
+    ETS_Crossing const *crossing,
+    uint32_t steps,
+    uint32_t origin,
+    uint16_t *record,
+    uint32_t size
+);
+
+/**
+ * @brief Fill the empty points of a record
+ *
+ * Empty points between two samples are linearly interpolated; leading and
+ * trailing ones repeat the nearest sample. A record without any sample is
+ * set to zero.
+ *
+ * @param record Equivalent-time record
+ * @param size Number of points in the record
+ *
+ * @return Number of points that were empty
+ */
+uint32_t ETS_fill_gaps(uint16_t *record, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_EQUIVALENT_TIME_H
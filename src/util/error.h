@@ -39,6 +39,33 @@
         __builtin_unreachable();                                               \
     } while (0)
 
+/*
+ * Argument checks of hot paths
+ *
+ * Functions called per byte or per sample, on objects that were validated
+ * when they were set up, check their arguments with CHECK_ARGUMENT. Debug
+ * and test builds throw ERROR_INVALID_ARGUMENT when a check fails; builds
+ * with PSLAB_CHECK_ARGUMENTS set to 0 leave the checks out. Checks at API
+ * boundaries, such as init functions, use THROW directly and are always
+ * built.
+ */
+#ifndef PSLAB_CHECK_ARGUMENTS
+#define PSLAB_CHECK_ARGUMENTS 1
+#endif
+
+#if PSLAB_CHECK_ARGUMENTS
+#define CHECK_ARGUMENT(condition)                                              \
+    do {                                                                       \
+        if (!(condition)) {                                                    \
+            THROW(ERROR_INVALID_ARGUMENT);                                     \
+        }                                                                      \
+    } while (0)
+#else
+#define CHECK_ARGUMENT(condition)                                              \
+    do {                                                                       \
+    } while (0)
+#endif
+
 /**
  * @brief PSLab-specific error codes
  *
@@ -5,12 +5,121 @@
  * This file implements fixed-point arithmetic functions unsuited for inlining
  * in fixed_point.h.
  */
-#include <inttypes.h>
 #include <stdint.h>
-#include <stdio.h>
 #include <string.h>
 
 #include "fixed_point.h"
+#include "format.h"
+#include "ramfunc.h"
+
+// SMULWB / SMULWT, SMLAWT, the halfword multiplies, SMLALD, the parallel
+// adds and the saturating adds are in the Armv8-M DSP extension; other
+// targets, such as the host test build, use plain C
+#if defined(__ARM_FEATURE_DSP) && defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#define FIXED_USE_DSP 1
+#else
+#define FIXED_USE_DSP 0
+#endif
+
+enum {
+    SINE_TABLE_BITS = 8, // Segments per quarter turn, log2
+    SINE_TABLE_SIZE = (1 << SINE_TABLE_BITS) + 1,
+    CORDIC_STEPS = 30, // Steps until atan(2^-i) rounds below 2^-32 turns
+    CORDIC_NORMAL_BITS = 59, // Vectors are shifted up to this magnitude
+    EXP2_FRAC_BITS = 30, // Fraction bits of the exp2 mantissa
+};
+
+// atan(2^-i) in units of 2^-32 turns, for the CORDIC steps
+static uint32_t const g_cordic_angles[CORDIC_STEPS] = {
+    536870912, 316933406, 167458907, 85004756, 42667331, 21354465,
+    10679838, 5340245, 2670163, 1335087, 667544, 333772,
+    166886, 83443, 41722, 20861, 10430, 5215,
+    2608, 1304, 652, 326, 163, 81,
+    41, 20, 10, 5, 3, 1,
+};
+
+// 2^(2^-k) in Q2.30 for k = 1 to FIXED_FRAC_BITS, one per exponent bit
+static uint32_t const g_exp2_factors[FIXED_FRAC_BITS] = {
+    1518500250, 1276901417, 1170923762, 1121280436, 1097253708, 1085434106,
+    1079572136, 1076653033, 1075196443, 1074468888, 1074105294, 1073923544,
+    1073832680, 1073787251, 1073764537, 1073753181,
+};
+
+// sin(x) in Q16.16 for x = 0 to pi/2 in SINE_TABLE_SIZE - 1 steps
+static int32_t const g_sine_quarter[SINE_TABLE_SIZE] = {
+    0, 402, 804, 1206, 1608, 2010, 2412, 2814,
+    3216, 3617, 4019, 4420, 4821, 5222, 5623, 6023,
+    6424, 6824, 7224, 7623, 8022, 8421, 8820, 9218,
+    9616, 10014, 10411, 10808, 11204, 11600, 11996, 12391,
+    12785, 13180, 13573, 13966, 14359, 14751, 15143, 15534,
+    15924, 16314, 16703, 17091, 17479, 17867, 18253, 18639,
+    19024, 19409, 19792, 20175, 20557, 20939, 21320, 21699,
+    22078, 22457, 22834, 23210, 23586, 23961, 24335, 24708,
+    25080, 25451, 25821, 26190, 26558, 26925, 27291, 27656,
+    28020, 28383, 28745, 29106, 29466, 29824, 30182, 30538,
+    30893, 31248, 31600, 31952, 32303, 32652, 33000, 33347,
+    33692, 34037, 34380, 34721, 35062, 35401, 35738, 36075,
+    36410, 36744, 37076, 37407, 37736, 38064, 38391, 38716,
+    39040, 39362, 39683, 40002, 40320, 40636, 40951, 41264,
+    41576, 41886, 42194, 42501, 42806, 43110, 43412, 43713,
+    44011, 44308, 44604, 44898, 45190, 45480, 45769, 46056,
+    46341, 46624, 46906, 47186, 47464, 47741, 48015, 48288,
+    48559, 48828, 49095, 49361, 49624, 49886, 50146, 50404,
+    50660, 50914, 51166, 51417, 51665, 51911, 52156, 52398,
+    52639, 52878, 53114, 53349, 53581, 53812, 54040, 54267,
+    54491, 54714, 54934, 55152, 55368, 55582, 55794, 56004,
+    56212, 56418, 56621, 56823, 57022, 57219, 57414, 57607,
+    57798, 57986, 58172, 58356, 58538, 58718, 58896, 59071,
+    59244, 59415, 59583, 59750, 59914, 60075, 60235, 60392,
+    60547, 60700, 60851, 60999, 61145, 61288, 61429, 61568,
+    61705, 61839, 61971, 62101, 62228, 62353, 62476, 62596,
+    62714, 62830, 62943, 63054, 63162, 63268, 63372, 63473,
+    63572, 63668, 63763, 63854, 63944, 64031, 64115, 64197,
+    64277, 64354, 64429, 64501, 64571, 64639, 64704, 64766,
+    64827, 64884, 64940, 64993, 65043, 65091, 65137, 65180,
+    65220, 65259, 65294, 65328, 65358, 65387, 65413, 65436,
+    65457, 65476, 65492, 65505, 65516, 65525, 65531, 65535,
+    65536,
+};
+
+/**
+ * @brief Multiply by the low halfword of a code pair, keep bits 16 to 47
+ */
+static inline int32_t multiply_bottom(int32_t const scale, uint32_t const pair)
+{
+#if FIXED_USE_DSP
+    return __smulwb(scale, (int32_t)pair);
+#else
+    return (int32_t)(((int64_t)scale * (pair & UINT16_MAX)) >> 16);
+#endif
+}
+
+/**
+ * @brief Multiply by the high halfword of a code pair, keep bits 16 to 47
+ */
+static inline int32_t multiply_top(int32_t const scale, uint32_t const pair)
+{
+#if FIXED_USE_DSP
+    return __smulwt(scale, (int32_t)pair);
+#else
+    return (int32_t)(((int64_t)scale * (pair >> 16)) >> 16);
+#endif
+}
+
+/**
+ * @brief Halve both halfwords of a pair, rounding up
+ */
+static inline uint32_t halve_pair(uint32_t const pair)
+{
+#if FIXED_USE_DSP
+    return __uhadd16(pair, 0x00010001U);
+#else
+    uint32_t const low = ((pair & UINT16_MAX) + 1) >> 1;
+    uint32_t const high = ((pair >> 16) + 1) >> 1;
+    return low | (high << 16);
+#endif
+}
 
 char *FIXED_to_string(
     FIXED_Q1616 const x,
@@ -20,44 +129,436 @@ char *FIXED_to_string(
 {
     // Worst case: 1 minus sign, 5 integer digits, 1 decimal point,
     // 5 fractional digits, 1 null terminator == 13
-    unsigned const buffer_min_size = 13;
-    if (buffer == nullptr || buffer_size < buffer_min_size) {
+    if (buffer == nullptr || buffer_size < FORMAT_Q1616_SIZE_MAX + 1) {
         return nullptr;
     }
 
-    // Get integer and fractional parts
-    int16_t const integer_part = FIXED_get_integer_part(x);
-    uint16_t const frac_part = FIXED_get_fractional_part(x);
+    buffer[FORMAT_q1616(x, buffer)] = '\0';
+    return buffer;
+}
+
+uint64_t FIXED_isqrt64(uint64_t const value)
+{
+    uint64_t root = 0;
+    uint64_t remainder = value;
+    uint64_t bit = 1ULL << 62;
 
-    // Convert fractional part to decimal with five decimal places
-    uint32_t const places = 100000;
-    // Use 64-bit arithmetic to avoid overflow
-    uint32_t decimal_frac =
-        (((uint64_t)frac_part * places + FIXED_HALF) / FIXED_SCALE);
+    while (bit > remainder) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (remainder >= root + bit) {
+            remainder -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
 
-    // Format the string with all five decimal places first
-    int result = snprintf(
-        buffer, buffer_size, "%d.%05" PRIu32, integer_part, decimal_frac
-    );
+int32_t FIXED_code_scale(int32_t const full_scale, uint16_t const max_code)
+{
+    if (full_scale <= 0 || max_code == 0) {
+        return 0;
+    }
 
-    if (result < 0 || (size_t)result >= buffer_size) {
-        return nullptr;
+    uint64_t const scale =
+        (((uint64_t)full_scale * FIXED_SCALE) + (max_code / 2)) / max_code;
+    return scale > FIXED_CODE_SCALE_MAX ? FIXED_CODE_SCALE_MAX
+                                        : (int32_t)scale;
+}
+
+// The kernels below multiply by twice the scale, which yields one extra
+// result bit, and halve with rounding: floor((floor(2x) + 1) / 2) equals x
+// rounded to nearest.
+
+void FIXED_scale_u16_array(
+    uint16_t const *codes,
+    uint32_t const count,
+    int32_t const scale,
+    FIXED_Q1616 *out
+)
+{
+    int32_t const scale2 = scale * 2;
+    uint32_t i = 0;
+
+    for (; i + 1 < count; i += 2) {
+        uint32_t pair = 0;
+        memcpy(&pair, &codes[i], sizeof(pair));
+        out[i] = (multiply_bottom(scale2, pair) + 1) >> 1;
+        out[i + 1] = (multiply_top(scale2, pair) + 1) >> 1;
+    }
+    if (i < count) {
+        out[i] = (multiply_bottom(scale2, codes[i]) + 1) >> 1;
     }
+}
 
-    // Find the decimal point and truncate trailing zeros
-    char *decimal_point = strchr(buffer, '.');
-    if (decimal_point != nullptr) {
-        char *end = buffer + result - 1;
+void FIXED_scale_u16_array_to_i16(
+    uint16_t const *codes,
+    uint32_t const count,
+    int32_t const scale,
+    int16_t *out
+)
+{
+    int32_t const scale2 = scale * 2;
+    uint32_t i = 0;
 
-        // Remove trailing zeros, but keep at least one decimal place
-        while (end > decimal_point + 1 && *end == '0') {
-            *end = '\0';
-            end--;
+    for (; i + 1 < count; i += 2) {
+        uint32_t pair = 0;
+        memcpy(&pair, &codes[i], sizeof(pair));
+        uint32_t const low = (uint32_t)multiply_bottom(scale2, pair);
+        uint32_t const high = (uint32_t)multiply_top(scale2, pair);
+        uint32_t const results = halve_pair((low & UINT16_MAX) | (high << 16));
+        memcpy(&out[i], &results, sizeof(results));
+    }
+    if (i < count) {
+        out[i] = (int16_t)((multiply_bottom(scale2, codes[i]) + 1) >> 1);
+    }
+}
+
+FIXED_Q1616 FIXED_sin(uint32_t const phase)
+{
+    uint32_t const quarter_turn = UINT32_C(1) << 30;
+    uint32_t const quarter = phase >> 30;
+    uint32_t offset = phase & (quarter_turn - 1);
+
+    // Odd quarters run the table backwards, the second half is negated
+    if (quarter & 1U) {
+        offset = quarter_turn - offset;
+    }
+    uint32_t const index = offset >> (30 - SINE_TABLE_BITS);
+    uint32_t const frac =
+        (offset >> (30 - SINE_TABLE_BITS - FIXED_FRAC_BITS)) & 0xFFFFU;
+
+    int32_t value = g_sine_quarter[index];
+    if (index + 1 < SINE_TABLE_SIZE) {
+        int32_t const step = g_sine_quarter[index + 1] - value;
+        value += (int32_t)(((int64_t)step * frac + FIXED_HALF) >> 16);
+    }
+    return quarter & 2U ? -value : value;
+}
+
+uint32_t FIXED_atan2(int64_t y, int64_t x)
+{
+    int64_t const normal = INT64_C(1) << CORDIC_NORMAL_BITS;
+    uint32_t angle = 0;
+
+    if (x == 0 && y == 0) {
+        return 0;
+    }
+    // Shift small vectors up, so that the truncating steps keep precision
+    while (x < normal && x > -normal && y < normal && y > -normal) {
+        x *= 2;
+        y *= 2;
+    }
+    // Rotate into the right half plane by a quarter turn
+    if (x < 0) {
+        int64_t const previous = x;
+        if (y >= 0) {
+            x = y;
+            y = -previous;
+            angle = UINT32_C(1) << 30;
+        } else {
+            x = -y;
+            y = previous;
+            angle = UINT32_C(3) << 30;
         }
+    }
 
-        return buffer;
+    // Each step rotates towards the x axis by atan(2^-i); dividing keeps
+    // clear of implementation-defined right shifts of negative numbers
+    for (uint32_t i = 0; i < CORDIC_STEPS; ++i) {
+        int64_t const divisor = INT64_C(1) << i;
+        int64_t const dx = y / divisor;
+        int64_t const dy = x / divisor;
+        if (y > 0) {
+            x += dx;
+            y -= dy;
+            angle += g_cordic_angles[i];
+        } else {
+            x -= dx;
+            y += dy;
+            angle -= g_cordic_angles[i];
+        }
     }
+    return angle;
+}
 
-    // Should be unreachable
-    return nullptr;
+FIXED_Q1616 FIXED_log2(uint64_t const value)
+{
+    uint64_t const x = value > 0 ? value : 1;
+    uint32_t bits = 0; // Position of the top bit
+    while ((x >> bits) > 1) {
+        ++bits;
+    }
+
+    // Normalize to [1, 2) in Q1.30 and square out the fraction bits
+    uint64_t mantissa = bits >= 30 ? x >> (bits - 30) : x << (30 - bits);
+    int32_t result = (int32_t)(bits << FIXED_FRAC_BITS);
+
+    for (int32_t bit = 1 << (FIXED_FRAC_BITS - 1); bit > 0; bit >>= 1) {
+        mantissa = (mantissa * mantissa) >> 30;
+        if (mantissa >= (UINT64_C(2) << 30)) {
+            mantissa >>= 1;
+            result += bit;
+        }
+    }
+    return result;
+}
+
+uint64_t FIXED_exp2(FIXED_Q1616 const exponent)
+{
+    if (exponent <= 0) {
+        return 1;
+    }
+
+    uint32_t const integer = (uint32_t)exponent >> FIXED_FRAC_BITS;
+    uint32_t const fraction = (uint32_t)exponent & (FIXED_SCALE - 1);
+    uint64_t const half = UINT64_C(1) << (EXP2_FRAC_BITS - 1);
+    uint64_t mantissa = UINT64_C(1) << EXP2_FRAC_BITS;
+
+    // 2^fraction as the product of the factors of its set bits
+    for (uint32_t k = 0; k < FIXED_FRAC_BITS; ++k) {
+        if (fraction & (UINT32_C(1) << (FIXED_FRAC_BITS - 1 - k))) {
+            mantissa = (mantissa * g_exp2_factors[k] + half) >> EXP2_FRAC_BITS;
+        }
+    }
+    if (integer >= EXP2_FRAC_BITS) {
+        return mantissa << (integer - EXP2_FRAC_BITS);
+    }
+    uint32_t const shift = EXP2_FRAC_BITS - integer;
+    return (mantissa + (UINT64_C(1) << (shift - 1))) >> shift;
+}
+
+RAMFUNC uint32_t FIXED_dds_fill(
+    uint32_t const *const table,
+    uint32_t phase,
+    uint32_t const step,
+    uint16_t *const out,
+    uint32_t const count
+)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t const entry = table[phase >> (32 - FIXED_DDS_TABLE_BITS)];
+        int32_t const frac = (int32_t)(
+            (phase >> (32 - FIXED_DDS_TABLE_BITS - FIXED_FRAC_BITS)) &
+            UINT16_MAX
+        );
+#if FIXED_USE_DSP
+        out[i] = (uint16_t)__smlawt(
+            frac, (int32_t)entry, (int32_t)(entry & UINT16_MAX)
+        );
+#else
+        // The interpolated code is not negative, so wrapping unsigned
+        // arithmetic gives the floor that SMLAWT's arithmetic shift does
+        int32_t const delta = (int16_t)(entry >> 16);
+        uint32_t const sum =
+            ((entry & UINT16_MAX) << 16) + (uint32_t)(delta * frac);
+        out[i] = (uint16_t)(sum >> 16);
+#endif
+        phase += step;
+    }
+    return phase;
+}
+
+/**
+ * @brief Saturate a sum or product to the Q15 range
+ */
+static inline FIXED_Q15 saturate_q15(int32_t const value)
+{
+#if FIXED_USE_DSP
+    return (FIXED_Q15)__ssat(value, 16);
+#else
+    if (value > INT16_MAX) {
+        return FIXED_Q15_MAX;
+    }
+    if (value < INT16_MIN) {
+        return FIXED_Q15_MIN;
+    }
+    return (FIXED_Q15)value;
+#endif
+}
+
+/**
+ * @brief Saturate a sum to the Q31 range
+ */
+static inline FIXED_Q31 saturate_q31(int64_t const value)
+{
+    if (value > INT32_MAX) {
+        return FIXED_Q31_MAX;
+    }
+    if (value < INT32_MIN) {
+        return FIXED_Q31_MIN;
+    }
+    return (FIXED_Q31)value;
+}
+
+/**
+ * @brief Add two Q31 values, saturating
+ */
+static inline FIXED_Q31 add_q31(FIXED_Q31 const a, FIXED_Q31 const b)
+{
+#if FIXED_USE_DSP
+    return __qadd(a, b);
+#else
+    return saturate_q31((int64_t)a + b);
+#endif
+}
+
+/**
+ * @brief Add twice a Q30 product to a Q31 value, saturating both steps
+ */
+static inline FIXED_Q31 add_doubled_q31(
+    FIXED_Q31 const acc,
+    int32_t const product
+)
+{
+#if FIXED_USE_DSP
+    return __qdadd(acc, product);
+#else
+    return saturate_q31((int64_t)acc + saturate_q31((int64_t)product * 2));
+#endif
+}
+
+/**
+ * @brief Product of a Q15 gain and a Q15 value, rounded back to Q15
+ */
+static inline FIXED_Q15 scale_q15(int32_t const product)
+{
+    return saturate_q15((product + (1 << 14)) >> 15);
+}
+
+/**
+ * @brief Load two Q15 values as one word, the first in the low halfword
+ */
+static inline int32_t load_pair(FIXED_Q15 const *values)
+{
+    int32_t pair = 0;
+    memcpy(&pair, values, sizeof(pair));
+    return pair;
+}
+
+/**
+ * @brief Store two Q15 values with one word write
+ */
+static inline void store_pair(
+    FIXED_Q15 *const values,
+    FIXED_Q15 const low,
+    FIXED_Q15 const high
+)
+{
+    uint32_t const pair = (uint16_t)low | ((uint32_t)(uint16_t)high << 16);
+    memcpy(values, &pair, sizeof(pair));
+}
+
+void FIXED_q15_add_array(
+    FIXED_Q15 const *a,
+    FIXED_Q15 const *b,
+    FIXED_Q15 *out,
+    uint32_t const count
+)
+{
+    uint32_t i = 0;
+
+#if FIXED_USE_DSP
+    for (; i + 1 < count; i += 2) {
+        int32_t const sums = __qadd16(load_pair(&a[i]), load_pair(&b[i]));
+        memcpy(&out[i], &sums, sizeof(sums));
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = saturate_q15((int32_t)a[i] + b[i]);
+    }
+}
+
+void FIXED_q15_scale_array(
+    FIXED_Q15 const *in,
+    FIXED_Q15 const gain,
+    FIXED_Q15 *out,
+    uint32_t const count
+)
+{
+    uint32_t i = 0;
+
+#if FIXED_USE_DSP
+    for (; i + 1 < count; i += 2) {
+        int32_t const pair = load_pair(&in[i]);
+        store_pair(
+            &out[i],
+            scale_q15(__smulbb(pair, gain)),
+            scale_q15(__smultb(pair, gain))
+        );
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = scale_q15((int32_t)in[i] * gain);
+    }
+}
+
+void FIXED_q15_mac_array(
+    FIXED_Q15 const *in,
+    FIXED_Q15 const coefficient,
+    FIXED_Q31 *acc,
+    uint32_t const count
+)
+{
+    uint32_t i = 0;
+
+#if FIXED_USE_DSP
+    for (; i + 1 < count; i += 2) {
+        int32_t const pair = load_pair(&in[i]);
+        acc[i] = add_doubled_q31(acc[i], __smulbb(pair, coefficient));
+        acc[i + 1] = add_doubled_q31(acc[i + 1], __smultb(pair, coefficient));
+    }
+#endif
+    for (; i < count; ++i) {
+        acc[i] = add_doubled_q31(acc[i], (int32_t)in[i] * coefficient);
+    }
+}
+
+int64_t FIXED_q15_dot(
+    FIXED_Q15 const *a,
+    FIXED_Q15 const *b,
+    uint32_t const count
+)
+{
+    int64_t sum = 0;
+    uint32_t i = 0;
+
+#if FIXED_USE_DSP
+    for (; i + 1 < count; i += 2) {
+        sum = __smlald(load_pair(&a[i]), load_pair(&b[i]), sum);
+    }
+#endif
+    for (; i < count; ++i) {
+        sum += (int32_t)a[i] * b[i];
+    }
+    return sum;
+}
+
+void FIXED_q31_add_array(
+    FIXED_Q31 const *a,
+    FIXED_Q31 const *b,
+    FIXED_Q31 *out,
+    uint32_t const count
+)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        out[i] = add_q31(a[i], b[i]);
+    }
+}
+
+void FIXED_q31_scale_array(
+    FIXED_Q31 const *in,
+    FIXED_Q31 const gain,
+    FIXED_Q31 *out,
+    uint32_t const count
+)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        int64_t const product = (int64_t)in[i] * gain;
+        out[i] = saturate_q31((product + (INT64_C(1) << 30)) >> 31);
+    }
 }
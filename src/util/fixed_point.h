@@ -274,6 +274,337 @@ static inline uint16_t FIXED_get_fractional_part(FIXED_Q1616 x)
  */
 char *FIXED_to_string(FIXED_Q1616 x, char *buffer, size_t buffer_size);
 
+/**
+ * @brief Largest factor accepted by the batch code conversions
+ */
+enum { FIXED_CODE_SCALE_MAX = INT32_MAX / 2 };
+
+/**
+ * @brief Per-code factor for the batch code conversions
+ *
+ * The factor maps max_code to full_scale, in the unit of full_scale: pass
+ * a Q16.16 full scale for Q16.16 results, or an integer one (such as
+ * millivolts) for integer results.
+ *
+ * @param full_scale Result for max_code
+ * @param max_code Largest code, e.g. 4095 for a 12-bit ADC
+ * @return Factor in units of 2^-16 of the result per code, rounded to
+ *         nearest and saturated at FIXED_CODE_SCALE_MAX, or 0 if
+ *         full_scale is not positive or max_code is 0
+ */
+int32_t FIXED_code_scale(int32_t full_scale, uint16_t max_code);
+
+/**
+ * @brief Integer square root, rounded down
+ *
+ * The root of a Q32.32 value, e.g. a product of two Q16.16 values held in
+ * 64 bits, is its Q16.16 root.
+ *
+ * @param value Radicand
+ * @return floor(sqrt(value))
+ */
+uint64_t FIXED_isqrt64(uint64_t value);
+
+/**
+ * @brief Sine of a phase in fractions of a turn
+ *
+ * Interpolates linearly in a quarter-wave table of 257 entries, which keeps
+ * the error within about one Q16.16 step. A full turn is 2^32, so that
+ * phases accumulated in a uint32_t wrap around by themselves.
+ *
+ * @param phase Phase in units of 2^-32 turns
+ * @return sin(2 pi phase / 2^32) in Q16.16
+ */
+FIXED_Q1616 FIXED_sin(uint32_t phase);
+
+/**
+ * @brief Phase of a vector in fractions of a turn, the inverse of FIXED_sin
+ *
+ * Rotates the vector onto the positive x axis by CORDIC, e.g. to read the
+ * phase of a DFT bin. Components up to 2^61 in magnitude are exact to a
+ * few units of 2^-32 turns.
+ *
+ * @param y Component along sin
+ * @param x Component along cos
+ * @return atan2(y, x) in units of 2^-32 turns, 0 for the zero vector
+ */
+uint32_t FIXED_atan2(int64_t y, int64_t x);
+
+/**
+ * @brief Base-2 logarithm of a positive integer
+ *
+ * @param value Positive integer, 0 counts as 1
+ * @return log2(value) in Q16.16, rounded down
+ */
+FIXED_Q1616 FIXED_log2(uint64_t value);
+
+/**
+ * @brief Power of two of a Q16.16 exponent, the inverse of FIXED_log2
+ *
+ * @param exponent Exponent from 0 to below 48
+ * @return 2^exponent, rounded to nearest, relative error within 2^-30 plus
+ *         that of the exponent; 1 for negative exponents
+ */
+uint64_t FIXED_exp2(FIXED_Q1616 exponent);
+
+enum {
+    /** @brief Entries of a DDS table, log2 */
+    FIXED_DDS_TABLE_BITS = 10,
+    /** @brief Entries of a DDS table, one per step of a period */
+    FIXED_DDS_TABLE_SIZE = 1 << FIXED_DDS_TABLE_BITS,
+};
+
+/**
+ * @brief Pack an entry of a DDS table
+ *
+ * An entry holds its code in the low halfword and the step to the next
+ * entry's code in the high one, so that interpolating costs one
+ * multiply-accumulate.
+ *
+ * @param code Code at the entry's phase
+ * @param next Code of the next entry, the first for the last entry
+ * @return Packed entry
+ */
+static inline uint32_t FIXED_dds_entry(uint16_t code, uint16_t next)
+{
+    return code | ((uint32_t)(uint16_t)(next - code) << 16);
+}
+
+/**
+ * @brief Fill a buffer from a DDS table with a phase accumulator
+ *
+ * Advances a 32-bit phase by step per code and interpolates linearly
+ * between the table's entries, whose period is a full turn of the phase.
+ * On cores with the DSP extension the interpolation is one SMLAWT.
+ *
+ * @param table FIXED_DDS_TABLE_SIZE entries from FIXED_dds_entry
+ * @param phase Phase of the first code, in units of 2^-32 periods
+ * @param step Phase increment per code
+ * @param out Output buffer with room for count codes
+ * @param count Number of codes
+ * @return Phase of the code after the last
+ */
+uint32_t FIXED_dds_fill(
+    uint32_t const *table,
+    uint32_t phase,
+    uint32_t step,
+    uint16_t *out,
+    uint32_t count
+);
+
+/**
+ * @brief Scale a Q16.16 code by a factor from FIXED_code_scale
+ *
+ * Multiplies by a precomputed reciprocal instead of dividing by the full
+ * scale code, so that converting a code costs one multiply. For an
+ * integer code c, FIXED_scale_code(FIXED_from_int(c), scale) matches the
+ * batch conversions.
+ *
+ * @param code Code in Q16.16, may have a fractional part, e.g. an average
+ * @param scale Factor from FIXED_code_scale
+ * @return Scaled code in the unit of the full scale, rounded to nearest
+ */
+static inline FIXED_Q1616 FIXED_scale_code(FIXED_Q1616 code, int32_t scale)
+{
+    int64_t const unit = (int64_t)FIXED_SCALE * FIXED_SCALE;
+    int64_t prod = (int64_t)code * scale;
+    // Don't rely on implementation-defined right-shift of negative numbers
+    prod = prod + (prod >= 0 ? unit / 2 : -unit / 2);
+    // |code * scale| <= 2^62, so the quotient always fits in 32 bits
+    return (FIXED_Q1616)(prod / unit);
+}
+
+/**
+ * @brief Convert a buffer of codes to Q16.16
+ *
+ * Computes out[i] = codes[i] * scale / 2^16, rounded to nearest. On cores
+ * with the DSP extension, pairs of codes are converted with the
+ * SMULWB / SMULWT halfword multiplies.
+ *
+ * @param codes Input codes, at most INT16_MAX
+ * @param count Number of codes
+ * @param scale Factor from FIXED_code_scale
+ * @param out Output buffer with room for count values
+ */
+void FIXED_scale_u16_array(
+    uint16_t const *codes,
+    uint32_t count,
+    int32_t scale,
+    FIXED_Q1616 *out
+);
+
+/**
+ * @brief Convert a buffer of codes to 16-bit integers
+ *
+ * Like FIXED_scale_u16_array, but with integer results, e.g. millivolts.
+ * On cores with the DSP extension, results are rounded and packed two at a
+ * time with a parallel halving add. Results must fit in an int16_t.
+ *
+ * @param codes Input codes, at most INT16_MAX
+ * @param count Number of codes
+ * @param scale Factor from FIXED_code_scale
+ * @param out Output buffer with room for count values; may alias codes
+ */
+void FIXED_scale_u16_array_to_i16(
+    uint16_t const *codes,
+    uint32_t count,
+    int32_t scale,
+    int16_t *out
+);
+
+/**
+ * @brief Sample data types (Q15 and Q31 formats)
+ *
+ * Fractions in [-1, 1) for sample processing, kept in the width of the
+ * samples rather than widened to Q16.16:
+ * - FIXED_Q15: 16-bit, 15 fractional bits, resolution ~0.00003
+ * - FIXED_Q31: 32-bit, 31 fractional bits, e.g. accumulators of Q15
+ *   products
+ *
+ * The array kernels below saturate like the Q16.16 helpers. On cores with
+ * the DSP extension Q15 data is processed two samples per word with the
+ * halfword and dual multiply-accumulate instructions, and saturation is
+ * done by QADD16, QADD, QDADD and SSAT.
+ */
+typedef int16_t FIXED_Q15;
+typedef int32_t FIXED_Q31;
+
+enum {
+    FIXED_Q15_FRAC_BITS = 15,
+    FIXED_Q31_FRAC_BITS = 31,
+};
+
+/**
+ * @brief Q15 and Q31 limits, just below 1 and -1
+ */
+#define FIXED_Q15_MAX (FIXED_Q15) INT16_MAX
+#define FIXED_Q15_MIN (FIXED_Q15) INT16_MIN
+#define FIXED_Q31_MAX (FIXED_Q31) INT32_MAX
+#define FIXED_Q31_MIN (FIXED_Q31) INT32_MIN
+
+/**
+ * @brief Convert float to Q15 (for constants and initialization)
+ *
+ * @note Input must be within [-1, 1)
+ */
+#define FIXED_Q15_FROM_FLOAT(f) ((FIXED_Q15)((f) * (1 << FIXED_Q15_FRAC_BITS)))
+
+/**
+ * @brief Widen a Q15 value to Q31
+ */
+static inline FIXED_Q31 FIXED_q15_to_q31(FIXED_Q15 x)
+{
+    return (FIXED_Q31)x * (1 << 16);
+}
+
+/**
+ * @brief Narrow a Q31 value to Q15, rounded to nearest and saturated
+ */
+static inline FIXED_Q15 FIXED_q31_to_q15(FIXED_Q31 x)
+{
+    int32_t const rounded = (int32_t)(((int64_t)x + (1 << 15)) >> 16);
+    return rounded > INT16_MAX ? FIXED_Q15_MAX : (FIXED_Q15)rounded;
+}
+
+/**
+ * @brief Add two Q15 arrays element by element, saturating
+ *
+ * @param a First terms
+ * @param b Second terms
+ * @param out Sums, count values; may alias a or b
+ * @param count Number of values
+ */
+void FIXED_q15_add_array(
+    FIXED_Q15 const *a,
+    FIXED_Q15 const *b,
+    FIXED_Q15 *out,
+    uint32_t count
+);
+
+/**
+ * @brief Multiply a Q15 array by a Q15 gain
+ *
+ * Computes out[i] = in[i] * gain, rounded to nearest. Only -1 * -1
+ * saturates.
+ *
+ * @param in Input values
+ * @param gain Gain in Q15
+ * @param out Products, count values; may alias in
+ * @param count Number of values
+ */
+void FIXED_q15_scale_array(
+    FIXED_Q15 const *in,
+    FIXED_Q15 gain,
+    FIXED_Q15 *out,
+    uint32_t count
+);
+
+/**
+ * @brief Multiply a Q15 array by a coefficient and accumulate in Q31
+ *
+ * Computes acc[i] += in[i] * coefficient, saturating. The products are
+ * exact in Q31, so a filter can sum its taps one array at a time and
+ * round once at the end with FIXED_q31_to_q15.
+ *
+ * @param in Input values
+ * @param coefficient Coefficient in Q15
+ * @param acc Accumulators, count values, updated in place
+ * @param count Number of values
+ */
+void FIXED_q15_mac_array(
+    FIXED_Q15 const *in,
+    FIXED_Q15 coefficient,
+    FIXED_Q31 *acc,
+    uint32_t count
+);
+
+/**
+ * @brief Dot product of two Q15 arrays
+ *
+ * The sum is exact, in units of 2^-30 (Q34.30 in 64 bits), so it neither
+ * saturates nor rounds for any count below 2^32. The dot product of
+ * 16-bit integers with each other is their integer sum of products.
+ *
+ * @param a First array
+ * @param b Second array
+ * @param count Number of values
+ * @return Sum of a[i] * b[i]
+ */
+int64_t FIXED_q15_dot(FIXED_Q15 const *a, FIXED_Q15 const *b, uint32_t count);
+
+/**
+ * @brief Add two Q31 arrays element by element, saturating
+ *
+ * @param a First terms
+ * @param b Second terms
+ * @param out Sums, count values; may alias a or b
+ * @param count Number of values
+ */
+void FIXED_q31_add_array(
+    FIXED_Q31 const *a,
+    FIXED_Q31 const *b,
+    FIXED_Q31 *out,
+    uint32_t count
+);
+
+/**
+ * @brief Multiply a Q31 array by a Q31 gain
+ *
+ * Computes out[i] = in[i] * gain, rounded to nearest, with one long
+ * multiply per value. Only -1 * -1 saturates.
+ *
+ * @param in Input values
+ * @param gain Gain in Q31
+ * @param out Products, count values; may alias in
+ * @param count Number of values
+ */
+void FIXED_q31_scale_array(
+    FIXED_Q31 const *in,
+    FIXED_Q31 gain,
+    FIXED_Q31 *out,
+    uint32_t count
+);
+
 #ifdef __cplusplus
 }
 #endif
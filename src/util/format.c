@@ -0,0 +1,120 @@
+/**
+ * @file format.c
+ * @brief Decimal formatting of integers and Q16.16 values
+ *
+ * The digit count is found up front from the bit length, so the digits can
+ * be written backwards from the end, two per step from g_DIGIT_PAIRS.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fixed_point.h"
+#include "format.h"
+
+// Decimal digits of 0 to 99, two characters each
+static char const g_DIGIT_PAIRS[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static uint32_t const g_POWERS_OF_TEN[10] = {
+    1U,       10U,       100U,       1000U,      10000U,
+    100000U,  1000000U,  10000000U,  100000000U, 1000000000U,
+};
+
+/**
+ * @brief Number of decimal digits of a value
+ *
+ * 1233 / 4096 approximates log10(2), which puts the count within one of
+ * the answer; a comparison with the next power of ten settles it.
+ */
+static inline size_t decimal_digits(uint32_t const value)
+{
+    uint32_t const bits = 32U - (uint32_t)__builtin_clz(value | 1U);
+    uint32_t const estimate = (bits * 1233U) >> 12U;
+    size_t const digits = estimate + 1U - (value < g_POWERS_OF_TEN[estimate]);
+    return digits > 0 ? digits : 1;
+}
+
+/**
+ * @brief Write the two digits of a value below 100
+ */
+static inline void write_pair(char *const out, uint32_t const pair)
+{
+    memcpy(out, &g_DIGIT_PAIRS[2U * pair], 2);
+}
+
+size_t FORMAT_uint32(uint32_t value, char *const buffer)
+{
+    size_t const length = decimal_digits(value);
+    char *end = buffer + length;
+
+    while (value >= 100U) {
+        uint32_t const quotient = value / 100U;
+        end -= 2;
+        write_pair(end, value - quotient * 100U);
+        value = quotient;
+    }
+
+    if (value >= 10U) {
+        write_pair(end - 2, value);
+    } else {
+        end[-1] = (char)('0' + value);
+    }
+
+    return length;
+}
+
+size_t FORMAT_int32(int32_t const value, char *const buffer)
+{
+    if (value >= 0) {
+        return FORMAT_uint32((uint32_t)value, buffer);
+    }
+
+    buffer[0] = '-';
+    return 1 + FORMAT_uint32(0U - (uint32_t)value, &buffer[1]);
+}
+
+size_t FORMAT_q1616(FIXED_Q1616 const value, char *const buffer)
+{
+    uint32_t magnitude = (uint32_t)value;
+    size_t length = 0;
+
+    if (value < 0) {
+        buffer[length++] = '-';
+        magnitude = 0U - magnitude;
+    }
+
+    length += FORMAT_uint32(magnitude >> 16U, &buffer[length]);
+    buffer[length++] = '.';
+
+    // Fraction in units of 1e-5, rounded: 100000 / 65536 is 3125 / 2048.
+    // The largest fraction rounds to 99998, so nothing carries over.
+    uint32_t const fraction =
+        ((magnitude & UINT16_MAX) * 3125U + 1024U) >> 11U;
+
+    // Five digits with leading zeros: two pairs and a last digit
+    char digits[5];
+    uint32_t const high = fraction / 1000U;
+    uint32_t const low = fraction - high * 1000U;
+    uint32_t const middle = low / 10U;
+    write_pair(&digits[0], high);
+    write_pair(&digits[2], middle);
+    digits[4] = (char)('0' + (low - middle * 10U));
+
+    size_t places = sizeof(digits);
+    while (places > 1 && digits[places - 1] == '0') {
+        places--;
+    }
+    memcpy(&buffer[length], digits, places);
+
+    return length + places;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file format.h
+ * @brief Decimal formatting of integers and Q16.16 values
+ *
+ * ASCII responses are formatted one number at a time, often at high rate,
+ * so these formatters avoid snprintf and the digit-by-digit division loop
+ * of the SCPI parser: digits are produced two at a time from a table of
+ * digit pairs, with divisions by constants that compile to multiplies.
+ *
+ * The functions write to a caller-provided buffer of at least the
+ * FORMAT_*_SIZE_MAX bytes that apply, without a null terminator, and
+ * return the number of characters written. They do not allocate.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_FORMAT_H
+#define PSLAB_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Longest output of each formatter, in characters
+ */
+enum {
+    FORMAT_UINT32_SIZE_MAX = 10, // "4294967295"
+    FORMAT_INT32_SIZE_MAX = 11, // "-2147483648"
+    FORMAT_Q1616_SIZE_MAX = 12, // "-32767.99998"
+};
+
+/**
+ * @brief Format an unsigned integer in decimal
+ *
+ * @param value Value to format
+ * @param buffer Output of at least FORMAT_UINT32_SIZE_MAX characters
+ * @return Number of characters written
+ */
+size_t FORMAT_uint32(uint32_t value, char *buffer);
+
+/**
+ * @brief Format a signed integer in decimal
+ *
+ * @param value Value to format
+ * @param buffer Output of at least FORMAT_INT32_SIZE_MAX characters
+ * @return Number of characters written
+ */
+size_t FORMAT_int32(int32_t value, char *buffer);
+
+/**
+ * @brief Format a Q16.16 value in decimal
+ *
+ * The fraction is rounded to five decimal places, which tell all Q16.16
+ * values apart, and trailing zeros are dropped down to one, e.g. "-1.0",
+ * "0.5" or "32767.99998".
+ *
+ * @param value Value to format
+ * @param buffer Output of at least FORMAT_Q1616_SIZE_MAX characters
+ * @return Number of characters written
+ */
+size_t FORMAT_q1616(FIXED_Q1616 value, char *buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PSLAB_FORMAT_H */
@@ -0,0 +1,77 @@
+/**
+ * @file histogram.c
+ * @brief Amplitude histogram of ADC codes
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "histogram.h"
+
+bool HISTOGRAM_init(
+    HISTOGRAM_State *histogram,
+    uint32_t *bins,
+    uint16_t low,
+    uint16_t high,
+    uint32_t stride,
+    uint32_t offset
+)
+{
+    if (histogram == nullptr || bins == nullptr || high < low ||
+        (uint32_t)(high - low) >= HISTOGRAM_BINS_MAX || stride == 0 ||
+        offset >= stride) {
+        return false;
+    }
+
+    uint32_t const bin_count = (uint32_t)(high - low) + 1;
+    memset(bins, 0, bin_count * sizeof(*bins));
+
+    *histogram = (HISTOGRAM_State){
+        .bins = bins,
+        .bin_count = bin_count,
+        .low = low,
+        .stride = stride,
+        .skip = offset,
+        .counted = 0,
+        .below = 0,
+        .above = 0,
+    };
+    return true;
+}
+
+void HISTOGRAM_add(
+    HISTOGRAM_State *histogram,
+    uint16_t const *samples,
+    uint32_t count
+)
+{
+    uint32_t *const bins = histogram->bins;
+    uint32_t const bin_count = histogram->bin_count;
+    uint32_t const low = histogram->low;
+    uint32_t const stride = histogram->stride;
+    uint32_t counted = 0;
+    uint32_t below = 0;
+    uint32_t above = 0;
+    uint32_t i = histogram->skip;
+
+    for (; i < count; i += stride) {
+        // Codes under low wrap around to bins past the end
+        uint32_t const bin = (uint32_t)samples[i] - low;
+
+        if (bin < bin_count) {
+            if (bins[bin] != UINT32_MAX) {
+                bins[bin]++;
+            }
+            counted++;
+        } else if (samples[i] < low) {
+            below++;
+        } else {
+            above++;
+        }
+    }
+
+    histogram->skip = i - count;
+    histogram->counted += counted;
+    histogram->below += below;
+    histogram->above += above;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file histogram.h
+ * @brief Amplitude histogram of ADC codes
+ *
+ * Counts how often each code in a range occurs in a stream of samples, one
+ * bin per code. Samples outside the range are counted separately, so the
+ * histogram stays a fixed size however many samples are added. Blocks may
+ * end anywhere within a frame of interleaved channels; the histogram keeps
+ * its place in the frame between calls.
+ *
+ * Bins saturate at UINT32_MAX instead of wrapping. The functions are
+ * allocation free and safe to call from interrupt context.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_HISTOGRAM_H
+#define PSLAB_HISTOGRAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    HISTOGRAM_BINS_MAX = 4096, // One bin per code of a 12-bit ADC
+};
+
+/**
+ * @brief Histogram state
+ */
+typedef struct {
+    uint32_t *bins; // bin_count counters, bins[0] counts code low
+    uint32_t bin_count;
+    uint16_t low;
+    uint32_t stride; // Samples per frame
+    uint32_t skip; // Samples to skip before the next one counted
+    uint64_t counted; // Samples within the range
+    uint64_t below; // Samples under low
+    uint64_t above; // Samples over the last bin
+} HISTOGRAM_State;
+
+/**
+ * @brief Prepare an empty histogram
+ *
+ * @param histogram Histogram state
+ * @param bins Storage for high - low + 1 counters
+ * @param low Code counted in the first bin
+ * @param high Code counted in the last bin
+ * @param stride Samples per frame, 1 for a single channel
+ * @param offset Position of the counted channel within a frame
+ *
+ * @return false if the range is empty or wider than HISTOGRAM_BINS_MAX, or
+ *         offset is not within a frame
+ */
+bool HISTOGRAM_init(
+    HISTOGRAM_State *histogram,
+    uint32_t *bins,
+    uint16_t low,
+    uint16_t high,
+    uint32_t stride,
+    uint32_t offset
+);
+
+/**
+ * @brief Count a block of samples
+ *
+ * @param histogram Histogram from HISTOGRAM_init
+ * @param samples Samples, continuing where the previous block ended
+ * @param count Number of samples (all channels)
+ */
+void HISTOGRAM_add(
+    HISTOGRAM_State *histogram,
+    uint16_t const *samples,
+    uint32_t count
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_HISTOGRAM_H
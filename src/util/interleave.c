@@ -0,0 +1,142 @@
+/**
+ * @file interleave.c
+ * @brief Offset and gain mismatch correction of interleaved ADC samples
+ *
+ * See interleave.h for the estimation method.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed_point.h"
+
+#include "interleave.h"
+
+/**
+ * @brief Sum of every second sample
+ */
+static uint64_t sum(uint16_t const *samples, uint32_t count)
+{
+    uint64_t total = 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        total += samples[2 * i];
+    }
+    return total;
+}
+
+/**
+ * @brief Mean of a sum of samples, in Q16.16 sample codes
+ */
+static FIXED_Q1616 mean(uint64_t total, uint32_t count)
+{
+    return (FIXED_Q1616)(((total << FIXED_FRAC_BITS) + count / 2) / count);
+}
+
+/**
+ * @brief Sum of the absolute deviations of every second sample from their
+ * mean, in Q16.16 sample codes
+ */
+static uint64_t deviation(uint16_t const *samples, uint32_t count)
+{
+    FIXED_Q1616 const centre = mean(sum(samples, count), count);
+    uint64_t total = 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        int32_t const value = FIXED_FROM_INT(samples[2 * i]) - centre;
+        total += (uint32_t)(value < 0 ? -value : value);
+    }
+    return total;
+}
+
+bool INTERLEAVE_estimate(
+    uint16_t const *samples,
+    uint32_t count,
+    INTERLEAVE_Correction *correction
+)
+{
+    if (samples == nullptr || correction == nullptr ||
+        count < INTERLEAVE_ESTIMATE_MIN) {
+        return false;
+    }
+
+    // Odd sample i is compared with the even samples either side of it
+    uint32_t const pairs = (count - 1) / 2;
+
+    // The gain follows from the spread of each ADC's samples, which a
+    // shift by one sample hardly changes
+    uint64_t deviation_even = deviation(samples, pairs);
+    uint64_t deviation_odd = deviation(samples + 1, pairs);
+
+    // The ratio is taken in Q16.16, which needs 16 bits of headroom
+    while (deviation_even > (UINT64_MAX >> (FIXED_FRAC_BITS + 1))) {
+        deviation_even >>= 1;
+        deviation_odd >>= 1;
+    }
+    if (deviation_odd == 0) {
+        return false;
+    }
+
+    uint64_t const gain =
+        ((deviation_even << FIXED_FRAC_BITS) + deviation_odd / 2) /
+        deviation_odd;
+    if (gain < INTERLEAVE_GAIN_MIN || gain > INTERLEAVE_GAIN_MAX) {
+        return false;
+    }
+
+    // The offset compares the odd samples with the mean of their even
+    // neighbours, which sample the signal at the same mean time. Means of
+    // the two ADCs alone differ whenever the capture ends in a partial
+    // cycle.
+    uint64_t const even_sum =
+        2 * sum(samples, pairs + 1) - samples[0] - samples[2 * pairs];
+    FIXED_Q1616 const mean_even = mean(even_sum, 2 * pairs);
+    FIXED_Q1616 const mean_odd = mean(sum(samples + 1, pairs), pairs);
+    FIXED_Q1616 const offset =
+        FIXED_sub(mean_even, FIXED_mul((FIXED_Q1616)gain, mean_odd));
+    if (offset < -INTERLEAVE_OFFSET_MAX || offset > INTERLEAVE_OFFSET_MAX) {
+        return false;
+    }
+
+    correction->gain = (FIXED_Q1616)gain;
+    correction->offset = offset;
+    return true;
+}
+
+INTERLEAVE_Correction INTERLEAVE_combine(
+    INTERLEAVE_Correction const *first,
+    INTERLEAVE_Correction const *second
+)
+{
+    // second(first(x)) = second.gain * first.gain * x
+    //                  + second.gain * first.offset + second.offset
+    return (INTERLEAVE_Correction){
+        .gain = FIXED_mul(second->gain, first->gain),
+        .offset =
+            FIXED_add(FIXED_mul(second->gain, first->offset), second->offset),
+    };
+}
+
+void INTERLEAVE_correct(
+    INTERLEAVE_Correction const *correction,
+    uint16_t *samples,
+    uint32_t count,
+    uint16_t sample_max
+)
+{
+    int64_t const gain = correction->gain;
+    int64_t const offset = (int64_t)correction->offset + FIXED_HALF;
+    uint32_t const pairs = count / 2;
+
+    for (uint32_t i = 0; i < pairs; ++i) {
+        uint16_t *const odd = &samples[(2 * i) + 1];
+        int64_t const value = (gain * *odd) + offset;
+
+        if (value < 0) {
+            *odd = 0;
+        } else if (value >= ((int64_t)sample_max << FIXED_FRAC_BITS)) {
+            *odd = sample_max;
+        } else {
+            *odd = (uint16_t)((uint64_t)value >> FIXED_FRAC_BITS);
+        }
+    }
+}
@@ -0,0 +1,110 @@
+/**
+ * @file interleave.h
+ * @brief Offset and gain mismatch correction of interleaved ADC samples
+ *
+ * In interleaved capture, even samples come from one ADC and odd samples
+ * from the other. Any difference in their offset or gain modulates the
+ * signal at half the sample rate, which shows up as a spur at fs/2 - f for
+ * every input frequency f, and a fixed spur at fs/2 for the offset.
+ *
+ * The mismatch is estimated from a capture of a slow signal spanning many
+ * cycles, such as a sine wave well below a tenth of the sample rate. The
+ * samples of both ADCs then have the same mean absolute deviation, and the
+ * odd samples the same mean as their even neighbours, so any difference is
+ * the mismatch. The correction maps the odd samples onto the even ones,
+ * odd * gain + offset, in Q16.16 so that sub-LSB offsets are kept.
+ *
+ * Timing skew between the ADCs is not corrected.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_INTERLEAVE_H
+#define PSLAB_INTERLEAVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    INTERLEAVE_ESTIMATE_MIN = 256, // Fewest samples to estimate from
+    // Accepted mismatch; larger estimates point at a bad test signal
+    INTERLEAVE_GAIN_MIN = FIXED_ONE - FIXED_ONE / 8,
+    INTERLEAVE_GAIN_MAX = FIXED_ONE + FIXED_ONE / 8,
+    INTERLEAVE_OFFSET_MAX = FIXED_FROM_INT(256), // In sample codes
+};
+
+/**
+ * @brief Correction applied to the odd samples
+ */
+typedef struct {
+    FIXED_Q1616 gain; // Multiplier, FIXED_ONE for no correction
+    FIXED_Q1616 offset; // Added after the gain, in sample codes
+} INTERLEAVE_Correction;
+
+/**
+ * @brief Correction that leaves samples unchanged
+ */
+#define INTERLEAVE_CORRECTION_IDENTITY                                         \
+    {                                                                          \
+        .gain = FIXED_ONE, .offset = 0,                                        \
+    }
+
+/**
+ * @brief Estimate the mismatch of an interleaved capture
+ *
+ * @param samples Interleaved samples, starting with an even one
+ * @param count Number of samples, at least INTERLEAVE_ESTIMATE_MIN
+ * @param correction Output, written if the estimate succeeded
+ *
+ * @return false if count is too small, the signal does not vary or the
+ *         mismatch is outside the accepted range
+ */
+bool INTERLEAVE_estimate(
+    uint16_t const *samples,
+    uint32_t count,
+    INTERLEAVE_Correction *correction
+);
+
+/**
+ * @brief Combine two corrections into one
+ *
+ * @param first Correction applied first
+ * @param second Correction applied to the output of the first
+ * @return Correction with the effect of both, saturated
+ */
+INTERLEAVE_Correction INTERLEAVE_combine(
+    INTERLEAVE_Correction const *first,
+    INTERLEAVE_Correction const *second
+);
+
+/**
+ * @brief Correct the odd samples of a block in place
+ *
+ * Corrected samples are rounded and clamped to 0..sample_max. Run from
+ * the ADC interrupts on every block, at one multiply-accumulate per sample
+ * pair.
+ *
+ * @param correction Correction to apply
+ * @param samples Interleaved samples, starting with an even one
+ * @param count Number of samples; an odd last sample is left unchanged
+ * @param sample_max Largest sample value
+ */
+void INTERLEAVE_correct(
+    INTERLEAVE_Correction const *correction,
+    uint16_t *samples,
+    uint32_t count,
+    uint16_t sample_max
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_INTERLEAVE_H
@@ -7,11 +7,13 @@
  */
 
 #include <assert.h>
+#include <inttypes.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "logging.h"
+#include "si_prefix.h"
 #include "util.h"
 
 /**
@@ -21,13 +23,64 @@ struct LOG_Handle {
     CircularBuffer buffer;
     uint8_t buffer_data[LOG_BUFFER_SIZE];
     bool initialized;
+    bool deferred;
+    LOG_TimestampSource timestamp_source;
+    uint32_t reserve; // End of the reserved space, ahead of buffer.head
+    uint32_t writers; // LOG_write calls between reserving and publishing
+    LOG_Stats stats;
+    LOG_Output output;
+    uint8_t staging[LOG_DRAIN_BUFFER_SIZE]; // Lines formatted by LOG_task
+    uint32_t staged; // Bytes formatted into staging
+    uint32_t staged_sent; // Bytes of staging accepted by output
+};
+
+/*
+ * Each record in the buffer is a level, a timestamp, a length and a payload.
+ * The payload of a formatted record is the message and its terminator,
+ * length + 1 bytes.
+ * A deferred record is marked in the level and its payload is the format
+ * string pointer followed by one slot per argument, length bytes in total.
+ */
+enum {
+    DEFERRED_RECORD = 0x80, // Level flag of deferred records
+    DEFERRED_SPEC_MAX = 16, // Longest conversion specification, with '%'
 };
 
+/**
+ * @brief How a conversion specification reads its argument
+ */
+typedef enum {
+    ARG_NONE, // "%%", no argument
+    ARG_INT,
+    ARG_LONG,
+    ARG_SIZE,
+    ARG_PTRDIFF,
+    ARG_POINTER,
+    ARG_DOUBLE, // Stored as float bits to fit a slot
+} ArgClass;
+
+/**
+ * @brief Payload of a deferred record
+ */
+typedef struct {
+    char const *format;
+    uintptr_t args[LOG_DEFERRED_MAX_ARGS];
+} DeferredPayload;
+
+// Records hold the used part of the payload, so the slots must follow the
+// format pointer without padding
+static_assert(
+    offsetof(DeferredPayload, args) == sizeof(char const *),
+    "DeferredPayload must not be padded"
+);
+
 /**
  * @brief Global logging state
  */
 static struct LOG_Handle g_log_handle = { .initialized = false };
 
+uint8_t g_log_levels[LOG_MODULE_COUNT];
+
 /**
  * @brief Level names for formatted output
  */
@@ -39,13 +92,17 @@ static char const *const g_LEVEL_NAMES[] = { "ERROR",
 LOG_Handle *LOG_init(void)
 {
     static_assert(
-        LOG_BUFFER_SIZE > 0 && (LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1)) == 0,
+        CIRCULAR_BUFFER_SIZE_VALID(LOG_BUFFER_SIZE),
         "LOG_BUFFER_SIZE must be a power of 2"
     );
     static_assert(
         LOG_MAX_MESSAGE_SIZE > 0 && LOG_MAX_MESSAGE_SIZE < 512,
         "LOG_MAX_MESSAGE_SIZE must be reasonable (1-511)"
     );
+    static_assert(
+        LOG_DRAIN_BUFFER_SIZE >= LOG_LINE_SIZE_MAX,
+        "LOG_DRAIN_BUFFER_SIZE must hold a full line"
+    );
 
     if (g_log_handle.initialized) {
         return &g_log_handle; // Already initialized
@@ -54,6 +111,17 @@ LOG_Handle *LOG_init(void)
     circular_buffer_init(
         &g_log_handle.buffer, g_log_handle.buffer_data, LOG_BUFFER_SIZE
     );
+    g_log_handle.deferred = LOG_DEFERRED;
+    g_log_handle.timestamp_source = nullptr;
+    g_log_handle.reserve = 0;
+    g_log_handle.writers = 0;
+    g_log_handle.output = nullptr;
+    g_log_handle.staged = 0;
+    g_log_handle.staged_sent = 0;
+    for (uint32_t i = 0; i < LOG_MODULE_COUNT; ++i) {
+        g_log_levels[i] = LOG_RUNTIME_LEVEL;
+    }
+    LOG_clear_stats();
     g_log_handle.initialized = true;
 
     return &g_log_handle;
@@ -66,9 +134,437 @@ void LOG_deinit(LOG_Handle *handle)
     }
 
     circular_buffer_reset(&g_log_handle.buffer);
+    g_log_handle.reserve = 0;
+    g_log_handle.staged = 0;
+    g_log_handle.staged_sent = 0;
     g_log_handle.initialized = false;
 }
 
+bool LOG_set_level(LOG_Module module, LOG_Level level)
+{
+    if (module < 0 || module >= LOG_MODULE_COUNT || level < LOG_LEVEL_ERROR ||
+        level > LOG_LEVEL_DEBUG) {
+        return false;
+    }
+    g_log_levels[module] = (uint8_t)level;
+    return true;
+}
+
+LOG_Level LOG_get_level(LOG_Module module)
+{
+    if (module < 0 || module >= LOG_MODULE_COUNT) {
+        return LOG_LEVEL_ERROR;
+    }
+    return (LOG_Level)g_log_levels[module];
+}
+
+LOG_Stats LOG_get_stats(void)
+{
+    LOG_Stats const *const stats = &g_log_handle.stats;
+
+    return (LOG_Stats){
+        .written = __atomic_load_n(&stats->written, __ATOMIC_RELAXED),
+        .dropped = __atomic_load_n(&stats->dropped, __ATOMIC_RELAXED),
+        .drained = stats->drained,
+        .high_water = __atomic_load_n(&stats->high_water, __ATOMIC_RELAXED),
+        .capacity = LOG_BUFFER_SIZE - 1,
+    };
+}
+
+void LOG_clear_stats(void)
+{
+    LOG_Stats *const stats = &g_log_handle.stats;
+
+    __atomic_store_n(&stats->written, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->dropped, 0, __ATOMIC_RELAXED);
+    stats->drained = 0;
+    // Restart from what the buffer holds now
+    __atomic_store_n(
+        &stats->high_water,
+        circular_buffer_available(&g_log_handle.buffer),
+        __ATOMIC_RELAXED
+    );
+}
+
+void LOG_set_output(LOG_Output output)
+{
+    // Staged lines go to the new output, or to stdout
+    if (output == nullptr && g_log_handle.staged_sent < g_log_handle.staged) {
+        (void)fwrite(
+            &g_log_handle.staging[g_log_handle.staged_sent],
+            1,
+            g_log_handle.staged - g_log_handle.staged_sent,
+            stdout
+        );
+        (void)fflush(stdout);
+        g_log_handle.staged = 0;
+        g_log_handle.staged_sent = 0;
+    }
+    g_log_handle.output = output;
+}
+
+void LOG_set_deferred(bool deferred) { g_log_handle.deferred = deferred; }
+
+void LOG_set_timestamp_source(LOG_TimestampSource source)
+{
+    g_log_handle.timestamp_source = source;
+}
+
+/**
+ * @brief Parse a conversion specification
+ *
+ * @param spec Format string position of the '%'
+ * @param arg Set to how the conversion reads its argument
+ *
+ * @return Length of the specification, or 0 if deferred mode cannot store
+ *         its argument
+ */
+static size_t parse_spec(char const *spec, ArgClass *arg)
+{
+    if (spec[1] == '%') {
+        *arg = ARG_NONE;
+        return 2;
+    }
+
+    size_t i = 1;
+    while (spec[i] != '\0' && strchr("-+ #0", spec[i])) {
+        ++i;
+    }
+    while (spec[i] >= '0' && spec[i] <= '9') {
+        ++i;
+    }
+    if (spec[i] == '.') {
+        ++i;
+        while (spec[i] >= '0' && spec[i] <= '9') {
+            ++i;
+        }
+    }
+
+    // "ll" and "j" need two slots on 32-bit targets and are not stored
+    ArgClass length = ARG_INT;
+    if (spec[i] == 'h') {
+        i += spec[i + 1] == 'h' ? 2 : 1;
+    } else if (spec[i] == 'l' || spec[i] == 'z' || spec[i] == 't') {
+        length = spec[i] == 'l'   ? ARG_LONG
+                 : spec[i] == 'z' ? ARG_SIZE
+                                  : ARG_PTRDIFF;
+        ++i;
+    }
+
+    char const conversion = spec[i];
+    if (conversion == '\0' || i + 1 > DEFERRED_SPEC_MAX) {
+        return 0;
+    }
+    if (strchr("diouxXc", conversion)) {
+        *arg = length;
+    } else if (conversion == 'p' && length == ARG_INT) {
+        *arg = ARG_POINTER;
+    } else if (strchr("fFeEgGaA", conversion) &&
+               (length == ARG_INT || length == ARG_LONG)) {
+        *arg = ARG_DOUBLE;
+    } else {
+        return 0; // "%s" and "%n" among others
+    }
+    return i + 1;
+}
+
+/**
+ * @brief Store the arguments of a message in a deferred payload
+ *
+ * @return Number of arguments stored, or -1 if the message must be
+ *         formatted straight away
+ */
+static int capture_args(DeferredPayload *payload, va_list args)
+{
+    int count = 0;
+
+    for (char const *p = payload->format; *p != '\0'; ++p) {
+        if (*p != '%') {
+            continue;
+        }
+
+        ArgClass arg = ARG_NONE;
+        size_t const length = parse_spec(p, &arg);
+        if (length == 0) {
+            return -1;
+        }
+        p += length - 1;
+        if (arg == ARG_NONE) {
+            continue;
+        }
+        if (count >= LOG_DEFERRED_MAX_ARGS) {
+            return -1;
+        }
+
+        uintptr_t *const slot = &payload->args[count++];
+        switch (arg) {
+        case ARG_INT:
+            *slot = (uintptr_t)(intptr_t)va_arg(args, int);
+            break;
+        case ARG_LONG:
+            *slot = (uintptr_t)(intptr_t)va_arg(args, long);
+            break;
+        case ARG_SIZE:
+            *slot = (uintptr_t)va_arg(args, size_t);
+            break;
+        case ARG_PTRDIFF:
+            *slot = (uintptr_t)(intptr_t)va_arg(args, ptrdiff_t);
+            break;
+        case ARG_POINTER:
+            *slot = (uintptr_t)va_arg(args, void *);
+            break;
+        case ARG_DOUBLE: {
+            float const value = (float)va_arg(args, double);
+            uint32_t bits = 0;
+            memcpy(&bits, &value, sizeof(bits));
+            *slot = bits;
+            break;
+        }
+        default:
+            return -1;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Format a deferred payload into a message
+ *
+ * @return Length of the message, truncated to fit the buffer
+ */
+static size_t render_deferred(
+    DeferredPayload const *payload,
+    size_t count,
+    char *message,
+    size_t size
+)
+{
+    size_t pos = 0;
+    size_t next = 0;
+
+    for (char const *p = payload->format; *p != '\0' && pos + 1 < size; ++p) {
+        ArgClass arg = ARG_NONE;
+        size_t const length = *p == '%' ? parse_spec(p, &arg) : 0;
+        if (length == 0 || arg == ARG_NONE) {
+            message[pos++] = *p;
+            p += length == 0 ? 0 : length - 1;
+            continue;
+        }
+        if (next >= count) {
+            break; // Record does not match its format string
+        }
+
+        char spec[DEFERRED_SPEC_MAX + 1];
+        memcpy(spec, p, length);
+        spec[length] = '\0';
+        p += length - 1;
+
+        uintptr_t const slot = payload->args[next++];
+        char *const out = &message[pos];
+        size_t const room = size - pos;
+        int n = 0;
+        switch (arg) {
+        case ARG_INT:
+            n = snprintf(out, room, spec, (int)(intptr_t)slot);
+            break;
+        case ARG_LONG:
+            n = snprintf(out, room, spec, (long)(intptr_t)slot);
+            break;
+        case ARG_SIZE:
+            n = snprintf(out, room, spec, (size_t)slot);
+            break;
+        case ARG_PTRDIFF:
+            n = snprintf(out, room, spec, (ptrdiff_t)(intptr_t)slot);
+            break;
+        case ARG_POINTER:
+            n = snprintf(out, room, spec, (void *)slot);
+            break;
+        case ARG_DOUBLE: {
+            uint32_t const bits = (uint32_t)slot;
+            float value = 0.0F;
+            memcpy(&value, &bits, sizeof(value));
+            n = snprintf(out, room, spec, (double)value);
+            break;
+        }
+        default:
+            break;
+        }
+        if (n > 0) {
+            pos += (size_t)n < room ? (size_t)n : room - 1;
+        }
+    }
+
+    message[pos] = '\0';
+    return pos;
+}
+
+#ifdef LOG_RESERVED_HOOK
+// Called by unit tests between reserving a record and publishing it
+void LOG_RESERVED_HOOK(void);
+#endif
+
+/*
+ * Records are written without locking, so that messages may be logged from
+ * interrupt handlers. A writer first reserves space by advancing reserve
+ * with compare-and-swap, then fills it in. Writers that interrupt it reserve
+ * the space after it, and finish before it resumes. The outermost writer
+ * publishes all records by moving the buffer head up to reserve, so the
+ * reader never sees a partly written record. This relies on writers running
+ * on a single core, and on the reader not interrupting writers.
+ */
+
+/**
+ * @brief Reserve space for a record
+ *
+ * @param size Record size in bytes
+ * @param start Set to the start of the reserved space
+ *
+ * @return true if reserved, false if the buffer is full
+ */
+static bool reserve_record(size_t size, uint32_t *start)
+{
+    CircularBuffer const *const cb = &g_log_handle.buffer;
+    uint32_t pos = __atomic_load_n(&g_log_handle.reserve, __ATOMIC_ACQUIRE);
+    uint32_t end = 0;
+
+    do {
+        uint32_t const used = (pos - cb->tail) & cb->mask;
+        if ((cb->size - 1) - used < size) {
+            return false;
+        }
+        end = (pos + size) & cb->mask;
+    } while (!__atomic_compare_exchange_n(
+        &g_log_handle.reserve,
+        &pos,
+        end,
+        false,
+        __ATOMIC_ACQ_REL,
+        __ATOMIC_ACQUIRE
+    ));
+
+    // Track the fullest the buffer has been, counting unpublished records
+    uint32_t const used = (end - cb->tail) & cb->mask;
+    uint32_t seen =
+        __atomic_load_n(&g_log_handle.stats.high_water, __ATOMIC_RELAXED);
+    while (used > seen && !__atomic_compare_exchange_n(
+                              &g_log_handle.stats.high_water,
+                              &seen,
+                              used,
+                              false,
+                              __ATOMIC_RELAXED,
+                              __ATOMIC_RELAXED
+                          )) {
+    }
+
+    *start = pos;
+    return true;
+}
+
+/**
+ * @brief Copy data into reserved space
+ *
+ * @return Position following the data
+ */
+static uint32_t fill_record(uint32_t pos, void const *data, size_t size)
+{
+    CircularBuffer *const cb = &g_log_handle.buffer;
+
+    // First span runs from pos to the end of the storage, second wraps
+    size_t const first = size < cb->size - pos ? size : cb->size - pos;
+    memcpy(&cb->buffer[pos], data, first);
+    memcpy(cb->buffer, (uint8_t const *)data + first, size - first);
+    return (pos + size) & cb->mask;
+}
+
+/**
+ * @brief Finish writing, publishing records if no other write is ongoing
+ */
+static void publish_records(void)
+{
+    if (__atomic_sub_fetch(&g_log_handle.writers, 1, __ATOMIC_ACQ_REL) != 0) {
+        return; // The interrupted writer publishes this record with its own
+    }
+
+    // A writer interrupting the store may publish a later end first, in
+    // which case the head is moved up again
+    uint32_t end = 0;
+    do {
+        end = __atomic_load_n(&g_log_handle.reserve, __ATOMIC_ACQUIRE);
+        __atomic_store_n(&g_log_handle.buffer.head, end, __ATOMIC_RELEASE);
+    } while (__atomic_load_n(&g_log_handle.reserve, __ATOMIC_ACQUIRE) != end);
+}
+
+/**
+ * @brief Write a record header and payload to the buffer
+ *
+ * @param length Length field of the record
+ * @param size Payload size in bytes
+ *
+ * @return Number of bytes written to buffer, or -1 if the buffer is full
+ */
+static int write_record(
+    LOG_Level level,
+    uint32_t timestamp,
+    uint16_t length,
+    void const *payload,
+    size_t size
+)
+{
+    size_t const entry_size =
+        sizeof(level) + sizeof(timestamp) + sizeof(length) + size;
+
+    __atomic_add_fetch(&g_log_handle.writers, 1, __ATOMIC_ACQ_REL);
+
+    uint32_t pos = 0;
+    if (!reserve_record(entry_size, &pos)) {
+        publish_records();
+        __atomic_add_fetch(&g_log_handle.stats.dropped, 1, __ATOMIC_RELAXED);
+        return -1; /* Buffer full - message dropped (acceptable for logging) */
+    }
+#ifdef LOG_RESERVED_HOOK
+    LOG_RESERVED_HOOK();
+#endif
+
+    pos = fill_record(pos, &level, sizeof(level));
+    pos = fill_record(pos, &timestamp, sizeof(timestamp));
+    pos = fill_record(pos, &length, sizeof(length));
+    (void)fill_record(pos, payload, size);
+
+    publish_records();
+    __atomic_add_fetch(&g_log_handle.stats.written, 1, __ATOMIC_RELAXED);
+    return (int)entry_size;
+}
+
+/**
+ * @brief Write a record of the format string and raw arguments
+ *
+ * @return Number of bytes written to buffer, -1 if the buffer is full, or
+ *         -2 if the message must be formatted straight away
+ */
+static int write_deferred(
+    LOG_Level level,
+    uint32_t timestamp,
+    char const *format,
+    va_list args
+)
+{
+    DeferredPayload payload = { .format = format };
+    int const count = capture_args(&payload, args);
+    if (count < 0) {
+        return -2;
+    }
+
+    uint16_t const length =
+        (uint16_t)(sizeof(payload.format) + (count * sizeof(uintptr_t)));
+    return write_record(
+        (LOG_Level)(level | DEFERRED_RECORD),
+        timestamp,
+        length,
+        &payload,
+        length
+    );
+}
+
 int LOG_write(LOG_Level level, char const *format, ...)
 {
     if (!g_log_handle.initialized) {
@@ -83,13 +579,29 @@ int LOG_write(LOG_Level level, char const *format, ...)
         return -1; /* Invalid format string */
     }
 
+    /* Take the time first so that formatting does not delay it */
+    LOG_TimestampSource const source = g_log_handle.timestamp_source;
+    uint32_t const timestamp = source ? source() : 0;
+
+    va_list args;
+    va_start(args, format);
+
+    if (g_log_handle.deferred) {
+        va_list captured;
+        va_copy(captured, args);
+        int const written =
+            write_deferred(level, timestamp, format, captured);
+        va_end(captured);
+        if (written != -2) {
+            va_end(args);
+            return written;
+        }
+    }
+
     /* Prepare log entry */
     LOG_Entry entry;
-    entry.level = level;
 
     /* Format message with variadic arguments */
-    va_list args;
-    va_start(args, format);
     int content_len =
         vsnprintf(entry.message, sizeof(entry.message), format, args);
     // clang-tidy spits out a false positive here
@@ -105,37 +617,14 @@ int LOG_write(LOG_Level level, char const *format, ...)
         content_len = sizeof(entry.message) - 1;
     }
     entry.message[content_len] = '\0';
-    entry.length = (uint16_t)content_len;
 
-    /* Calculate total entry size for buffer */
-    size_t entry_size =
-        sizeof(entry.level) + sizeof(entry.length) + entry.length + 1;
-
-    /* Check if we have enough space */
-    if (circular_buffer_free_space(&g_log_handle.buffer) >= entry_size) {
-        /* Write entry to buffer */
-        uint32_t written = 0;
-        written += circular_buffer_write(
-            &g_log_handle.buffer,
-            (uint8_t const *)&entry.level,
-            sizeof(entry.level)
-        );
-        written += circular_buffer_write(
-            &g_log_handle.buffer,
-            (uint8_t const *)&entry.length,
-            sizeof(entry.length)
-        );
-        written += circular_buffer_write(
-            &g_log_handle.buffer,
-            (uint8_t const *)entry.message,
-            entry.length + 1
-        );
-
-        return (int)written;
-    }
-
-    /* Buffer full - message dropped (acceptable for logging) */
-    return -1;
+    return write_record(
+        level,
+        timestamp,
+        (uint16_t)content_len,
+        entry.message,
+        (size_t)content_len + 1
+    );
 }
 
 size_t LOG_available(void)
@@ -146,6 +635,32 @@ size_t LOG_available(void)
     return circular_buffer_available(&g_log_handle.buffer);
 }
 
+/**
+ * @brief Read the payload of a deferred record and format its message
+ *
+ * @param entry Entry whose level and length have been read
+ */
+static bool read_deferred(LOG_Entry *entry)
+{
+    DeferredPayload payload;
+    size_t const length = entry->length;
+
+    if (length < sizeof(payload.format) || length > sizeof(payload) ||
+        circular_buffer_available(&g_log_handle.buffer) < length ||
+        circular_buffer_read(
+            &g_log_handle.buffer, (uint8_t *)&payload, length
+        ) != length) {
+        return false;
+    }
+
+    size_t const count = (length - sizeof(payload.format)) / sizeof(uintptr_t);
+    entry->level = (LOG_Level)(entry->level & ~DEFERRED_RECORD);
+    entry->length = (uint16_t)render_deferred(
+        &payload, count, entry->message, sizeof(entry->message)
+    );
+    return true;
+}
+
 bool LOG_read_entry(LOG_Entry *entry)
 {
     if (!entry || !g_log_handle.initialized) {
@@ -154,14 +669,20 @@ bool LOG_read_entry(LOG_Entry *entry)
 
     /* Check if we have enough data for header */
     if (circular_buffer_available(&g_log_handle.buffer) <
-        sizeof(entry->level) + sizeof(entry->length)) {
+        sizeof(entry->level) + sizeof(entry->timestamp) +
+            sizeof(entry->length)) {
         return false;
     }
 
-    /* Read level and length */
+    /* Read level, timestamp and length */
     if (circular_buffer_read(
             &g_log_handle.buffer, (uint8_t *)&entry->level, sizeof(entry->level)
         ) != sizeof(entry->level) ||
+        circular_buffer_read(
+            &g_log_handle.buffer,
+            (uint8_t *)&entry->timestamp,
+            sizeof(entry->timestamp)
+        ) != sizeof(entry->timestamp) ||
         circular_buffer_read(
             &g_log_handle.buffer,
             (uint8_t *)&entry->length,
@@ -170,6 +691,10 @@ bool LOG_read_entry(LOG_Entry *entry)
         return false;
     }
 
+    if (entry->level & DEFERRED_RECORD) {
+        return read_deferred(entry);
+    }
+
     /* Check if we have enough data for the message */
     if (circular_buffer_available(&g_log_handle.buffer) < entry->length + 1) {
         return false;
@@ -185,12 +710,104 @@ bool LOG_read_entry(LOG_Entry *entry)
     return true;
 }
 
+/**
+ * @brief Format an entry as an output line
+ *
+ * @return Length of the line, truncated to fit the buffer
+ */
+static uint32_t format_line(LOG_Entry const *entry, char *line, size_t size)
+{
+    int length = 0;
+
+    if (g_log_handle.timestamp_source) {
+        length = snprintf(
+            line,
+            size,
+            "[%5" PRIu32 ".%06" PRIu32 "] [%s] %s\r\n",
+            (uint32_t)(entry->timestamp / SI_MICRO_DIV),
+            (uint32_t)(entry->timestamp % SI_MICRO_DIV),
+            g_LEVEL_NAMES[entry->level],
+            entry->message
+        );
+    } else {
+        length = snprintf(
+            line,
+            size,
+            "[%s] %s\r\n",
+            g_LEVEL_NAMES[entry->level],
+            entry->message
+        );
+    }
+
+    if (length < 0) {
+        return 0;
+    }
+    return (size_t)length < size ? (uint32_t)length : (uint32_t)size - 1;
+}
+
+/**
+ * @brief Pass staged lines to the output
+ *
+ * @return true if all staged lines were accepted
+ */
+static bool flush_staging(void)
+{
+    struct LOG_Handle *const h = &g_log_handle;
+
+    while (h->staged_sent < h->staged) {
+        uint32_t const accepted =
+            h->output(&h->staging[h->staged_sent], h->staged - h->staged_sent);
+        if (accepted == 0) {
+            return false; // Output full, retry on the next call
+        }
+        h->staged_sent += accepted;
+    }
+
+    h->staged = 0;
+    h->staged_sent = 0;
+    return true;
+}
+
+/**
+ * @brief Format a batch of entries into staging and output it at once
+ */
+static int drain_to_output(uint32_t max_entries)
+{
+    struct LOG_Handle *const h = &g_log_handle;
+    LOG_Entry entry;
+    int processed = 0;
+
+    if (!flush_staging()) {
+        return 0;
+    }
+
+    while (processed < max_entries &&
+           sizeof(h->staging) - h->staged >= LOG_LINE_SIZE_MAX &&
+           LOG_read_entry(&entry)) {
+        h->staged += format_line(
+            &entry,
+            (char *)&h->staging[h->staged],
+            sizeof(h->staging) - h->staged
+        );
+        processed++;
+    }
+
+    (void)flush_staging();
+    return processed;
+}
+
 int LOG_task(uint32_t max_entries)
 {
     if (!g_log_handle.initialized) {
         return 0;
     }
 
+    if (g_log_handle.output) {
+        int const processed = drain_to_output(max_entries);
+        g_log_handle.stats.drained += processed;
+        return processed;
+    }
+
     /* Limit the number of entries processed per call to avoid blocking */
     LOG_Entry entry;
     int processed = 0;
@@ -198,10 +815,14 @@ int LOG_task(uint32_t max_entries)
     /* Process available log entries */
     while (processed < max_entries && LOG_read_entry(&entry)) {
         /* Format and output the message to stdout */
-        printf("[%s] %s\r\n", g_LEVEL_NAMES[entry.level], entry.message);
+        char line[LOG_LINE_SIZE_MAX];
+        (void)format_line(&entry, line, sizeof(line));
+        (void)fputs(line, stdout);
         processed++;
     }
 
+    g_log_handle.stats.drained += processed;
+
     /* Flush stdout to ensure messages appear immediately */
     if (processed > 0) {
         (void)fflush(stdout);
@@ -209,3 +830,30 @@ int LOG_task(uint32_t max_entries)
 
     return processed;
 }
+
+uint32_t LOG_read_lines(uint8_t *buf, uint32_t size)
+{
+    struct LOG_Handle *const h = &g_log_handle;
+
+    if (!h->initialized || buf == nullptr) {
+        return 0;
+    }
+
+    // Lines already staged for an output come first to keep the order
+    uint32_t length = h->staged - h->staged_sent;
+    length = length < size ? length : size;
+    memcpy(buf, &h->staging[h->staged_sent], length);
+    h->staged_sent += length;
+    if (h->staged_sent < h->staged) {
+        return length;
+    }
+    h->staged = 0;
+    h->staged_sent = 0;
+
+    LOG_Entry entry;
+    while (size - length >= LOG_LINE_SIZE_MAX && LOG_read_entry(&entry)) {
+        length += format_line(&entry, (char *)&buf[length], size - length);
+        h->stats.drained++;
+    }
+    return length;
+}
@@ -5,13 +5,21 @@
  * This logging system provides a unified interface for all firmware layers
  * using a circular buffer for message storage. It supports:
  * - Multiple log levels (ERROR, WARN, INFO, DEBUG)
- * - Printf-style formatting
+ * - Printf-style formatting, either straight away or deferred
  * - Configurable buffer size
  *
  * The logging system uses a circular buffer to store log messages, which can
  * be read back by the application using the `LOG_read_entry` function, or
  * written to stdout by the `LOG_task` function.
  *
+ * In deferred mode, `LOG_write` stores the format string pointer and the
+ * raw arguments instead of formatting the message, which takes most of the
+ * cost out of logging on hot paths. The message is formatted when it is
+ * read back. Format strings must therefore outlive the log entry, as string
+ * literals do. Arguments for `%s`, as well as conversions that deferred mode
+ * does not support (such as `%lld` or `*` widths), are formatted straight
+ * away instead.
+ *
  * @author PSLab Team
  * @date 2025-07-14
  */
@@ -50,10 +58,58 @@ typedef enum {
 #define LOG_MAX_MESSAGE_SIZE 128 /* Maximum size per log message */
 #endif
 
+#ifndef LOG_DEFERRED_MAX_ARGS
+#define LOG_DEFERRED_MAX_ARGS 8 /* Maximum arguments of a deferred message */
+#endif
+
+#ifndef LOG_DEFERRED
+#define LOG_DEFERRED false /* Whether LOG_init enables deferred mode */
+#endif
+
+#ifndef LOG_DRAIN_BUFFER_SIZE
+#define LOG_DRAIN_BUFFER_SIZE 512 /* Lines LOG_task passes to an output */
+#endif
+
+/* Longest formatted line: timestamp, level, message and CRLF */
+#define LOG_LINE_SIZE_MAX                                                      \
+    (sizeof("[4294.967295] [DEBUG] \r\n") + LOG_MAX_MESSAGE_SIZE)
+
 #ifndef LOG_COMPILE_TIME_LEVEL
 #define LOG_COMPILE_TIME_LEVEL LOG_LEVEL_ERROR
 #endif
 
+#ifndef LOG_RUNTIME_LEVEL
+#define LOG_RUNTIME_LEVEL LOG_COMPILE_TIME_LEVEL /* Initial module levels */
+#endif
+
+/**
+ * @brief Modules whose log level is set at runtime
+ *
+ * A source file logs under a module by defining LOG_MODULE before its first
+ * include, e.g. `#define LOG_MODULE LOG_MODULE_DSO`. Other files log under
+ * LOG_MODULE_DEFAULT.
+ */
+typedef enum {
+    LOG_MODULE_DEFAULT = 0,
+    LOG_MODULE_DSO,
+    LOG_MODULE_DMM,
+    LOG_MODULE_USB,
+    LOG_MODULE_UART,
+    LOG_MODULE_ADC_LL,
+    LOG_MODULE_COUNT
+} LOG_Module;
+
+#ifndef LOG_MODULE
+#define LOG_MODULE LOG_MODULE_DEFAULT
+#endif
+
+/**
+ * @brief Most verbose level written per module, read by the LOG_* macros
+ *
+ * Use LOG_set_level and LOG_get_level rather than accessing it directly.
+ */
+extern uint8_t g_log_levels[LOG_MODULE_COUNT];
+
 /**
  * @brief Log handle structure (opaque)
  */
@@ -64,10 +120,37 @@ typedef struct LOG_Handle LOG_Handle;
  */
 typedef struct {
     LOG_Level level;
+    uint32_t timestamp; /* From the timestamp source when written, or 0 */
     uint16_t length;
     char message[LOG_MAX_MESSAGE_SIZE];
 } LOG_Entry;
 
+/**
+ * @brief Logging statistics since startup or LOG_clear_stats
+ */
+typedef struct {
+    uint32_t written; /* Messages stored in the buffer */
+    uint32_t dropped; /* Messages lost because the buffer was full */
+    uint32_t drained; /* Messages output by LOG_task */
+    uint32_t high_water; /* Most bytes the buffer has held */
+    uint32_t capacity; /* Bytes the buffer can hold */
+} LOG_Stats;
+
+/**
+ * @brief Sink for LOG_task output, such as a UART write
+ *
+ * @param data Formatted lines
+ * @param size Number of bytes
+ *
+ * @return Number of bytes accepted; the rest is offered again later
+ */
+typedef uint32_t (*LOG_Output)(uint8_t const *data, uint32_t size);
+
+/**
+ * @brief Clock read by LOG_write to timestamp messages
+ */
+typedef uint32_t (*LOG_TimestampSource)(void);
+
 /**
  * @brief Initialize the logging system
  *
@@ -91,6 +174,10 @@ void LOG_deinit(LOG_Handle *handle);
 /**
  * @brief Write a log message
  *
+ * Safe to call from interrupt handlers: records are reserved and filled in
+ * without locks, and a message logged by an interrupt while another one is
+ * being written is stored intact ahead of it.
+ *
  * @param level Log level for this message
  * @param format Printf-style format string
  * @param ... Variable arguments
@@ -99,6 +186,74 @@ void LOG_deinit(LOG_Handle *handle);
  */
 int LOG_write(LOG_Level level, char const *format, ...);
 
+/**
+ * @brief Set the most verbose level logged by a module
+ *
+ * Levels above LOG_COMPILE_TIME_LEVEL are compiled out and stay disabled.
+ *
+ * @param module Module to configure
+ * @param level Most verbose level to write
+ *
+ * @return true if set, false if module or level is invalid
+ */
+bool LOG_set_level(LOG_Module module, LOG_Level level);
+
+/**
+ * @brief Get the most verbose level logged by a module
+ *
+ * @param module Module to query
+ *
+ * @return Level of the module, or LOG_LEVEL_ERROR if module is invalid
+ */
+LOG_Level LOG_get_level(LOG_Module module);
+
+/**
+ * @brief Get the logging statistics
+ *
+ * Compare the number of drained messages between two calls to measure how
+ * fast LOG_task outputs them.
+ *
+ * @return Statistics since startup or the last LOG_clear_stats
+ */
+LOG_Stats LOG_get_stats(void);
+
+/**
+ * @brief Restart the logging statistics
+ *
+ * The high-water mark restarts from the bytes held in the buffer.
+ */
+void LOG_clear_stats(void);
+
+/**
+ * @brief Send LOG_task output to a sink instead of stdout
+ *
+ * LOG_task then formats as many entries as fit in a staging buffer of
+ * LOG_DRAIN_BUFFER_SIZE bytes and passes them to the output in one call,
+ * so that a UART starts one DMA transfer per batch instead of one per line.
+ *
+ * @param output Output to use, or nullptr for stdout
+ */
+void LOG_set_output(LOG_Output output);
+
+/**
+ * @brief Select whether messages are formatted when read instead of written
+ *
+ * @param deferred true to store format strings and arguments, false to
+ *                 format messages in LOG_write
+ */
+void LOG_set_deferred(bool deferred);
+
+/**
+ * @brief Timestamp messages with a clock
+ *
+ * The source is read on every LOG_write, so it must be cheap and safe to
+ * call wherever messages are logged. LOG_task prints timestamps as seconds
+ * and microseconds, so the source should count microseconds.
+ *
+ * @param source Clock to read, or nullptr to stop timestamping
+ */
+void LOG_set_timestamp_source(LOG_TimestampSource source);
+
 /**
  * @brief Check if log messages are available for reading
  *
@@ -122,7 +277,8 @@ bool LOG_read_entry(LOG_Entry *entry);
  * timer interrupt to ensure log messages are displayed in a timely manner.
  *
  * The function processes up to a limited number of entries per call to avoid
- * blocking for too long in interrupt contexts.
+ * blocking for too long in interrupt contexts. With an output set by
+ * LOG_set_output, entries go there in batches instead.
  *
  * @param max_entries Maximum number of entries to process in this call
  *
@@ -130,6 +286,22 @@ bool LOG_read_entry(LOG_Entry *entry);
  */
 int LOG_task(uint32_t max_entries);
 
+/**
+ * @brief Read formatted log lines into a buffer
+ *
+ * Lets the application pull lines in batches, e.g. to answer a query,
+ * instead of having LOG_task push them to an output. Lines staged for the
+ * output but not yet accepted by it are read first. Whole lines are read
+ * while at least LOG_LINE_SIZE_MAX bytes of the buffer are free. The lines
+ * are not null-terminated.
+ *
+ * @param buf Buffer to fill
+ * @param size Size of the buffer in bytes
+ *
+ * @return Number of bytes read
+ */
+uint32_t LOG_read_lines(uint8_t *buf, uint32_t size);
+
 // The preprocessor can't see the enum values
 #define LOG_LEVEL_ERROR 0
 #define LOG_LEVEL_WARN 1
@@ -137,28 +309,40 @@ int LOG_task(uint32_t max_entries);
 #define LOG_LEVEL_DEBUG 3
 
 /**
- * @brief Core logging macros with compile-time filtering
+ * @brief Write a message if its module's runtime level allows it
+ *
+ * The level is checked before the arguments are evaluated.
+ */
+#define LOG_MODULE_WRITE(level, fmt, ...)                                      \
+    ((level) <= g_log_levels[LOG_MODULE]                                       \
+         ? LOG_write(level, fmt, ##__VA_ARGS__)                                \
+         : 0)
+
+/**
+ * @brief Core logging macros with compile-time and runtime filtering
  */
 #if LOG_COMPILE_TIME_LEVEL >= LOG_LEVEL_ERROR
-#define LOG_ERROR(fmt, ...) LOG_write(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...)                                                    \
+    LOG_MODULE_WRITE(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
 #else
 #define LOG_ERROR(fmt, ...) ((void)0)
 #endif
 
 #if LOG_COMPILE_TIME_LEVEL >= LOG_LEVEL_WARN
-#define LOG_WARN(fmt, ...) LOG_write(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...) LOG_MODULE_WRITE(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
 #else
 #define LOG_WARN(fmt, ...) ((void)0)
 #endif
 
 #if LOG_COMPILE_TIME_LEVEL >= LOG_LEVEL_INFO
-#define LOG_INFO(fmt, ...) LOG_write(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...) LOG_MODULE_WRITE(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
 #else
 #define LOG_INFO(fmt, ...) ((void)0)
 #endif
 
 #if LOG_COMPILE_TIME_LEVEL >= LOG_LEVEL_DEBUG
-#define LOG_DEBUG(fmt, ...) LOG_write(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(fmt, ...)                                                    \
+    LOG_MODULE_WRITE(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
 #else
 #define LOG_DEBUG(fmt, ...) ((void)0)
 #endif
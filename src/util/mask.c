@@ -0,0 +1,32 @@
+/**
+ * @file mask.c
+ * @brief Mask test of a capture against a limit envelope
+ */
+#include <stdint.h>
+
+#include "mask.h"
+
+void MASK_test(
+    MASK_Limit const *limits,
+    uint16_t const *samples,
+    uint32_t count,
+    MASK_Result *result
+)
+{
+    uint32_t violations = 0;
+    uint32_t first = MASK_NO_FAILURE;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint16_t const sample = samples[i];
+
+        if (sample < limits[i].lower || sample > limits[i].upper) {
+            if (violations == 0) {
+                first = i;
+            }
+            violations++;
+        }
+    }
+
+    result->violations = violations;
+    result->first = first;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file mask.h
+ * @brief Mask test of a capture against a limit envelope
+ *
+ * A mask holds a lower and an upper limit for every sample of a record.
+ * A sample outside its limits is a violation; the test counts them and
+ * notes where the first one was. The test is allocation free and safe to
+ * call from interrupt context.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_MASK_H
+#define PSLAB_MASK_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    MASK_NO_FAILURE = UINT32_MAX, // First failure of a record that passed
+};
+
+/**
+ * @brief Limits of one sample, both inclusive
+ */
+typedef struct {
+    uint16_t lower;
+    uint16_t upper;
+} MASK_Limit;
+
+/**
+ * @brief Limit that every sample passes
+ */
+#define MASK_LIMIT_OPEN { .lower = 0, .upper = UINT16_MAX }
+
+/**
+ * @brief Outcome of a mask test
+ */
+typedef struct {
+    uint32_t violations; // Samples outside their limits
+    uint32_t first; // Index of the first of them, or MASK_NO_FAILURE
+} MASK_Result;
+
+/**
+ * @brief Test a record against a mask
+ *
+ * @param limits One limit per sample
+ * @param samples Record to test
+ * @param count Number of samples
+ * @param result Output
+ */
+void MASK_test(
+    MASK_Limit const *limits,
+    uint16_t const *samples,
+    uint32_t count,
+    MASK_Result *result
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_MASK_H
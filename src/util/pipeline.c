@@ -0,0 +1,125 @@
+/**
+ * @file pipeline.c
+ * @brief Block pipeline from a DMA producer through stages to a sink
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pipeline.h"
+
+bool PIPELINE_init(PIPELINE_State *pipeline, PIPELINE_Config const *config)
+{
+    if (pipeline == nullptr || config == nullptr ||
+        config->storage == nullptr || config->size < 2 ||
+        (config->size & (config->size - 1)) != 0 ||
+        config->sink.function == nullptr ||
+        config->stage_count > PIPELINE_STAGES_MAX ||
+        (config->stage_count > 0 && config->stages == nullptr)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < config->stage_count; ++i) {
+        if (config->stages[i].function == nullptr) {
+            return false;
+        }
+    }
+
+    *pipeline = (PIPELINE_State){
+        .stage_count = config->stage_count,
+        .sink = config->sink,
+        .release = config->release,
+        .release_context = config->release_context,
+        .has_pending = false,
+        .pushed = 0,
+        .overruns = 0,
+        .dropped = 0,
+        .consumed = 0,
+    };
+    for (uint32_t i = 0; i < config->stage_count; ++i) {
+        pipeline->stages[i] = config->stages[i];
+    }
+    pipeline_block_ring_init(&pipeline->queue, config->storage, config->size);
+    return true;
+}
+
+bool PIPELINE_push(PIPELINE_State *pipeline, void const *data, uint32_t count)
+{
+    PIPELINE_Block const block = {
+        .data = data,
+        .count = count,
+        .sequence = pipeline->pushed,
+        .pushed = data,
+    };
+
+    if (!pipeline_block_ring_put(&pipeline->queue, block)) {
+        pipeline->overruns++;
+        return false;
+    }
+    pipeline->pushed++;
+    return true;
+}
+
+/**
+ * @brief Hand a block back to the producer
+ */
+static void release_block(PIPELINE_State *pipeline, PIPELINE_Block const *block)
+{
+    if (pipeline->release != nullptr) {
+        pipeline->release(pipeline->release_context, block->pushed);
+    }
+}
+
+/**
+ * @brief Run a block through the stages
+ *
+ * @return false if a stage dropped it
+ */
+static bool process_block(PIPELINE_State *pipeline, PIPELINE_Block *block)
+{
+    for (uint32_t i = 0; i < pipeline->stage_count; ++i) {
+        PIPELINE_Stage const *const stage = &pipeline->stages[i];
+        if (!stage->function(stage->context, block)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t PIPELINE_run(PIPELINE_State *pipeline)
+{
+    uint32_t queued = pipeline_block_ring_available(&pipeline->queue);
+    uint32_t done = 0;
+
+    for (;;) {
+        if (!pipeline->has_pending) {
+            PIPELINE_Block *const block = &pipeline->pending;
+            if (queued == 0 ||
+                !pipeline_block_ring_get(&pipeline->queue, block)) {
+                break;
+            }
+            queued--;
+            if (!process_block(pipeline, block)) {
+                pipeline->dropped++;
+                release_block(pipeline, block);
+                done++;
+                continue;
+            }
+            pipeline->has_pending = true;
+        }
+
+        PIPELINE_Sink const *const sink = &pipeline->sink;
+        if (!sink->function(sink->context, &pipeline->pending)) {
+            break;
+        }
+        pipeline->has_pending = false;
+        pipeline->consumed++;
+        release_block(pipeline, &pipeline->pending);
+        done++;
+    }
+    return done;
+}
+
+bool PIPELINE_is_busy(PIPELINE_State const *pipeline)
+{
+    return pipeline->has_pending ||
+           !pipeline_block_ring_is_empty(&pipeline->queue);
+}
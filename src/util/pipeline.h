@@ -0,0 +1,183 @@
+/**
+ * @file pipeline.h
+ * @brief Block pipeline from a DMA producer through stages to a sink
+ *
+ * Instruments that acquire in DMA blocks all do the same three things with
+ * them: the interrupt handler hands over a completed block, the main loop
+ * processes it, and the result goes somewhere. A pipeline does this once
+ * for all of them:
+ *
+ * - the producer pushes a descriptor of each completed block into a
+ *   single producer, single consumer queue, typically from the DMA
+ *   interrupt;
+ * - PIPELINE_run, called from a scheduler task, takes the blocks in order
+ *   through the stages, each of which may inspect, reduce or drop a block;
+ * - the sink consumes each block that passed the stages, or refuses it
+ *   while it is busy, in which case the block is offered again on the next
+ *   run without passing the stages again;
+ * - the release function hands each pushed block back to the producer
+ *   once it has been dropped or consumed.
+ *
+ * @code
+ * static bool bin_block(void *context, PIPELINE_Block const *block)
+ * {
+ *     HISTOGRAM_add(context, block->data, block->count);
+ *     return true;
+ * }
+ *
+ * PIPELINE_init(&g_pipeline, &(PIPELINE_Config){
+ *     .storage = g_blocks,
+ *     .size = 4,
+ *     .sink = { .function = bin_block, .context = &g_histogram },
+ *     .release = release_to_dso,
+ * });
+ * @endcode
+ *
+ * A stage that reduces a block into a buffer of its own points the block
+ * at that buffer; the producer's block is still released as pushed. The
+ * functions are allocation free. PIPELINE_push is safe to call from
+ * interrupt context, the others are to be called from one main loop task.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_PIPELINE_H
+#define PSLAB_PIPELINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    PIPELINE_STAGES_MAX = 4,
+};
+
+/**
+ * @brief Descriptor of a block moving through a pipeline
+ */
+typedef struct {
+    void const *data; // Elements of the block, as set by the last stage
+    uint32_t count; // Elements, in units the stages and the sink agree on
+    uint32_t sequence; // Blocks pushed before this one since PIPELINE_init
+    void const *pushed; // Data as pushed, handed to the release function
+} PIPELINE_Block;
+
+RING_DEFINE(PipelineBlockRing, pipeline_block_ring, PIPELINE_Block)
+
+/**
+ * @brief Processing stage
+ *
+ * The function may change the data and count of the block. It returns
+ * false to drop the block, which is then released without reaching the
+ * later stages or the sink.
+ */
+typedef struct {
+    bool (*function)(void *context, PIPELINE_Block *block);
+    void *context;
+} PIPELINE_Stage;
+
+/**
+ * @brief Consumer at the end of a pipeline
+ *
+ * The function returns false if it cannot take the block yet; the block
+ * then stays at the head of the pipeline.
+ */
+typedef struct {
+    bool (*function)(void *context, PIPELINE_Block const *block);
+    void *context;
+} PIPELINE_Sink;
+
+/**
+ * @brief Pipeline configuration
+ */
+typedef struct {
+    PIPELINE_Block *storage; // Queue storage
+    uint32_t size; // Elements of storage, a power of two; size - 1 queue
+    PIPELINE_Stage const *stages; // Run in order, may be nullptr if none
+    uint32_t stage_count; // At most PIPELINE_STAGES_MAX
+    PIPELINE_Sink sink;
+    // Hands a block back to the producer, may be nullptr
+    void (*release)(void *context, void const *data);
+    void *release_context;
+} PIPELINE_Config;
+
+/**
+ * @brief Pipeline state
+ */
+typedef struct {
+    PipelineBlockRing queue; // Pushed blocks not yet taken by a run
+    PIPELINE_Stage stages[PIPELINE_STAGES_MAX];
+    uint32_t stage_count;
+    PIPELINE_Sink sink;
+    void (*release)(void *context, void const *data);
+    void *release_context;
+    PIPELINE_Block pending; // Processed block refused by the sink
+    bool has_pending;
+    uint32_t volatile pushed; // Blocks queued since PIPELINE_init
+    uint32_t volatile overruns; // Blocks refused because the queue was full
+    uint32_t dropped; // Blocks dropped by a stage
+    uint32_t consumed; // Blocks taken by the sink
+} PIPELINE_State;
+
+/**
+ * @brief Prepare an empty pipeline
+ *
+ * The stages are copied, so the configuration may be a temporary. Blocks
+ * queued before are forgotten without being released.
+ *
+ * @param pipeline Pipeline state
+ * @param config Pipeline configuration
+ *
+ * @return false if an argument is null, the sink has no function, a stage
+ *         has none, there are more than PIPELINE_STAGES_MAX stages, or size
+ *         is not a power of two of at least 2
+ */
+bool PIPELINE_init(PIPELINE_State *pipeline, PIPELINE_Config const *config);
+
+/**
+ * @brief Queue a completed block
+ *
+ * Safe to call from interrupt context, from one producer. A block that is
+ * refused is counted as an overrun and stays with the producer.
+ *
+ * @param pipeline Pipeline state
+ * @param data Elements of the block
+ * @param count Elements in the block
+ *
+ * @return false if the queue is full
+ */
+bool PIPELINE_push(PIPELINE_State *pipeline, void const *data, uint32_t count);
+
+/**
+ * @brief Take the queued blocks through the stages to the sink
+ *
+ * Stops when the sink refuses a block or once the blocks queued when it
+ * was called have been taken, so that a producer that keeps pushing does
+ * not hold up the calling task.
+ *
+ * @param pipeline Pipeline state
+ *
+ * @return Number of blocks dropped or consumed
+ */
+uint32_t PIPELINE_run(PIPELINE_State *pipeline);
+
+/**
+ * @brief Check for blocks not yet consumed or dropped
+ *
+ * @param pipeline Pipeline state
+ *
+ * @return true if a block is queued or waits for the sink
+ */
+bool PIPELINE_is_busy(PIPELINE_State const *pipeline);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PSLAB_PIPELINE_H */
@@ -0,0 +1,30 @@
+/**
+ * @file ramfunc.h
+ * @brief Placement of hot code in RAM
+ *
+ * Flash runs with five wait states at 250 MHz. The instruction cache hides
+ * them for code that stays resident, but an interrupt arriving after a long
+ * stretch of other code often misses, and every miss stalls the fetch. Code
+ * on the interrupt paths that move sample and transfer data is therefore
+ * placed in RAM, where it is fetched without wait states.
+ *
+ * The startup code copies the section from flash together with the
+ * initialized data. Calls between flash and RAM go through veneers inserted
+ * by the linker.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_RAMFUNC_H
+#define PSLAB_RAMFUNC_H
+
+/**
+ * @brief Place a function in the RAM code section
+ *
+ * Reserved for short, frequently run code on interrupt paths; RAM spent on
+ * code is not available for buffers.
+ */
+#define RAMFUNC __attribute__((section(".RamFunc")))
+
+#endif // PSLAB_RAMFUNC_H
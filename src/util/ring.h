@@ -0,0 +1,243 @@
+/**
+ * @file ring.h
+ * @brief Typed ring buffers generated at compile time
+ *
+ * CircularBuffer in util.h stores bytes, so multi-byte samples or fixed-size
+ * descriptors have to be framed into it byte by byte. RING_DEFINE generates
+ * a ring type and its functions for one element type instead: elements are
+ * stored, copied and counted whole, with the same power-of-two index masking
+ * and the same single producer, single consumer contract as CircularBuffer,
+ * including the acquire and release ordering of the indexes.
+ *
+ * The functions are static inline, so each ring compiles to code for its
+ * own element size, with the copies sized at compile time. Rings of
+ * uint16_t and uint32_t are defined here; others are defined where they
+ * are used:
+ * @code
+ * typedef struct {
+ *     uint32_t tick;
+ *     uint16_t count;
+ * } Descriptor;
+ *
+ * RING_DEFINE(DescriptorRing, descriptor_ring, Descriptor)
+ *
+ * static Descriptor g_storage[16];
+ * static DescriptorRing g_descriptors;
+ *
+ * descriptor_ring_init(&g_descriptors, g_storage, 16);
+ * descriptor_ring_put(&g_descriptors, (Descriptor){ .tick = 1 });
+ * @endcode
+ *
+ * As with CircularBuffer, a ring of size elements holds size - 1 of them.
+ * prefix_init throws ERROR_INVALID_ARGUMENT for invalid arguments, and in
+ * builds with argument checks, prefix_commit_read and prefix_commit_write
+ * for more elements than there are (see CHECK_ARGUMENT). The other
+ * functions take a ring initialized by prefix_init and do not check their
+ * arguments, as they sit on sample paths.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_RING_H
+#define PSLAB_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "util/error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Define a ring type of elements and its functions
+ *
+ * Defines the type Type and, for a ring r of it:
+ * - prefix_init(r, storage, size): use storage of size elements, a power
+ *   of two
+ * - prefix_reset(r): empty the ring
+ * - prefix_is_empty(r), prefix_is_full(r)
+ * - prefix_available(r): elements stored
+ * - prefix_free_space(r): elements that can be added
+ * - prefix_put(r, element) and prefix_get(r, &element): one element,
+ *   false if the ring is full or empty
+ * - prefix_write(r, data, count) and prefix_read(r, data, count): up to
+ *   count elements in at most two copies, returning the number moved
+ * - prefix_peek_contiguous(r, &data) and prefix_commit_read(r, count):
+ *   consume elements in place
+ * - prefix_reserve_contiguous(r, &data) and prefix_commit_write(r, count):
+ *   produce elements in place
+ *
+ * @param Type Name of the ring type
+ * @param prefix Prefix of the function names
+ * @param Element Element type
+ */
+#define RING_DEFINE(Type, prefix, Element)                                     \
+    typedef struct {                                                           \
+        Element *buffer;                                                       \
+        uint32_t volatile head; /* Next element written */                     \
+        uint32_t volatile tail; /* Next element read */                        \
+        uint32_t size; /* In elements */                                       \
+        uint32_t mask; /* size - 1 */                                          \
+    } Type;                                                                    \
+                                                                               \
+    static inline void prefix##_init(                                          \
+        Type *ring,                                                            \
+        Element *storage,                                                      \
+        uint32_t size                                                          \
+    )                                                                          \
+    {                                                                          \
+        if (!ring || !storage || size < 2 || (size & (size - 1)) != 0) {       \
+            THROW(ERROR_INVALID_ARGUMENT);                                     \
+        }                                                                      \
+        ring->buffer = storage;                                                \
+        ring->head = 0;                                                        \
+        ring->tail = 0;                                                        \
+        ring->size = size;                                                     \
+        ring->mask = size - 1;                                                 \
+    }                                                                          \
+                                                                               \
+    static inline void prefix##_reset(Type *ring)                              \
+    {                                                                          \
+        ring->head = 0;                                                        \
+        ring->tail = 0;                                                        \
+    }                                                                          \
+                                                                               \
+    static inline uint32_t prefix##_available(Type const *ring)                \
+    {                                                                          \
+        uint32_t const head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);  \
+        uint32_t const tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);  \
+        return (head - tail) & ring->mask;                                     \
+    }                                                                          \
+                                                                               \
+    static inline uint32_t prefix##_free_space(Type const *ring)               \
+    {                                                                          \
+        return ring->mask - prefix##_available(ring);                          \
+    }                                                                          \
+                                                                               \
+    static inline bool prefix##_is_empty(Type const *ring)                     \
+    {                                                                          \
+        return prefix##_available(ring) == 0;                                  \
+    }                                                                          \
+                                                                               \
+    static inline bool prefix##_is_full(Type const *ring)                      \
+    {                                                                          \
+        return prefix##_free_space(ring) == 0;                                 \
+    }                                                                          \
+                                                                               \
+    static inline bool prefix##_put(Type *ring, Element element)               \
+    {                                                                          \
+        uint32_t const head = ring->head;                                      \
+        uint32_t const next = (head + 1) & ring->mask;                         \
+        if (next == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) {          \
+            return false;                                                      \
+        }                                                                      \
+        ring->buffer[head] = element;                                          \
+        __atomic_store_n(&ring->head, next, __ATOMIC_RELEASE);                 \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline bool prefix##_get(Type *ring, Element *element)              \
+    {                                                                          \
+        uint32_t const tail = ring->tail;                                      \
+        if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {          \
+            return false;                                                      \
+        }                                                                      \
+        *element = ring->buffer[tail];                                         \
+        uint32_t const next = (tail + 1) & ring->mask;                         \
+        __atomic_store_n(&ring->tail, next, __ATOMIC_RELEASE);                 \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline uint32_t prefix##_write(                                     \
+        Type *ring,                                                            \
+        Element const *data,                                                   \
+        uint32_t count                                                         \
+    )                                                                          \
+    {                                                                          \
+        uint32_t const head = ring->head;                                      \
+        uint32_t const tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);  \
+        uint32_t const free_space = ring->mask - ((head - tail) & ring->mask); \
+        uint32_t const n = count < free_space ? count : free_space;            \
+        uint32_t const to_end = ring->size - head;                             \
+        uint32_t const first = n < to_end ? n : to_end;                        \
+        memcpy(&ring->buffer[head], data, first * sizeof(Element));            \
+        memcpy(ring->buffer, &data[first], (n - first) * sizeof(Element));     \
+        uint32_t const next = (head + n) & ring->mask;                         \
+        __atomic_store_n(&ring->head, next, __ATOMIC_RELEASE);                 \
+        return n;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline uint32_t prefix##_read(                                      \
+        Type *ring,                                                            \
+        Element *data,                                                         \
+        uint32_t count                                                         \
+    )                                                                          \
+    {                                                                          \
+        uint32_t const head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);  \
+        uint32_t const tail = ring->tail;                                      \
+        uint32_t const used = (head - tail) & ring->mask;                      \
+        uint32_t const n = count < used ? count : used;                        \
+        uint32_t const to_end = ring->size - tail;                             \
+        uint32_t const first = n < to_end ? n : to_end;                        \
+        memcpy(data, &ring->buffer[tail], first * sizeof(Element));            \
+        memcpy(&data[first], ring->buffer, (n - first) * sizeof(Element));     \
+        uint32_t const next = (tail + n) & ring->mask;                         \
+        __atomic_store_n(&ring->tail, next, __ATOMIC_RELEASE);                 \
+        return n;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline uint32_t prefix##_peek_contiguous(                           \
+        Type *ring,                                                            \
+        Element const **data                                                   \
+    )                                                                          \
+    {                                                                          \
+        uint32_t const head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);  \
+        uint32_t const tail = ring->tail;                                      \
+        uint32_t const used = (head - tail) & ring->mask;                      \
+        uint32_t const to_end = ring->size - tail;                             \
+        *data = &ring->buffer[tail];                                           \
+        return used < to_end ? used : to_end;                                  \
+    }                                                                          \
+                                                                               \
+    static inline void prefix##_commit_read(Type *ring, uint32_t count)        \
+    {                                                                          \
+        CHECK_ARGUMENT(count <= prefix##_available(ring));                     \
+        uint32_t const tail = (ring->tail + count) & ring->mask;               \
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);                 \
+    }                                                                          \
+                                                                               \
+    static inline uint32_t prefix##_reserve_contiguous(                        \
+        Type *ring,                                                            \
+        Element **data                                                         \
+    )                                                                          \
+    {                                                                          \
+        uint32_t const head = ring->head;                                      \
+        uint32_t const tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);  \
+        uint32_t const free_space = ring->mask - ((head - tail) & ring->mask); \
+        uint32_t const to_end = ring->size - head;                             \
+        *data = &ring->buffer[head];                                           \
+        return free_space < to_end ? free_space : to_end;                      \
+    }                                                                          \
+                                                                               \
+    static inline void prefix##_commit_write(Type *ring, uint32_t count)       \
+    {                                                                          \
+        CHECK_ARGUMENT(count <= prefix##_free_space(ring));                    \
+        uint32_t const head = (ring->head + count) & ring->mask;               \
+        __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);                 \
+    }
+
+/** @brief Ring of 16-bit elements, e.g. ADC samples */
+RING_DEFINE(RingU16, ring_u16, uint16_t)
+
+/** @brief Ring of 32-bit elements, e.g. timestamps or Q16.16 values */
+RING_DEFINE(RingU32, ring_u32, uint32_t)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PSLAB_RING_H */
@@ -0,0 +1,515 @@
+/**
+ * @file spectrum.c
+ * @brief Fixed-point amplitude spectrum of unsigned 16-bit samples
+ *
+ * See spectrum.h for the scaling of the results.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed_point.h"
+
+#include "spectrum.h"
+
+enum {
+    // Twiddle factors are Q2.30
+    TWIDDLE_FRAC_BITS = 30,
+    // Values stay below this before each stage, so that a butterfly, which
+    // grows them by at most 1 + sqrt(2), cannot overflow
+    STAGE_LIMIT_BITS = 29,
+    // Powers are squared Q16.16 amplitudes with 16 fraction bits dropped
+    POWER_DROP_BITS = 16,
+    // Frequency-domain taps of the 4-term Blackman-Harris window,
+    // normalized to unit gain in Q16.16: a_j / (2 * a_0) with
+    // a = { 0.35875, 0.48829, 0.14128, 0.01168 } and alternating signs
+    WINDOW_TAP_1 = -44600,
+    WINDOW_TAP_2 = 12904,
+    WINDOW_TAP_3 = -1067,
+    // Equivalent noise bandwidth of the window in bins, Q16.16
+    WINDOW_ENBW_Q16 = 131357,
+    // log10(2) in Q16.16
+    LOG10_2_Q16 = 19728,
+    // Result unit of ratio_cdb: 0.01 dB per 10 * log10
+    CDB_PER_DECADE = 1000,
+    // Result unit of SPECTRUM_response phases
+    CDEG_PER_TURN = 36000,
+};
+
+/**
+ * @brief Signed division rounded to nearest, by a positive divisor
+ */
+static int64_t divide_rounded(int64_t dividend, int64_t divisor)
+{
+    int64_t const half = divisor / 2;
+    return (dividend + (dividend >= 0 ? half : -half)) / divisor;
+}
+
+/**
+ * @brief Number of significant bits of a value
+ */
+static uint32_t bit_length(uint64_t value)
+{
+    uint32_t bits = 0;
+    while (value != 0) {
+        ++bits;
+        value >>= 1;
+    }
+    return bits;
+}
+
+/**
+ * @brief Rounded (a * b + c * d) / 2^TWIDDLE_FRAC_BITS
+ *
+ * Each product must fit in 62 bits.
+ */
+static int64_t rotate(int64_t a, int64_t b, int64_t c, int64_t d)
+{
+    int64_t const one = INT64_C(1) << TWIDDLE_FRAC_BITS;
+    int64_t const sum = (a * b) + (c * d);
+    // Don't rely on implementation-defined right-shift of negative numbers
+    return (sum + (sum >= 0 ? one / 2 : -one / 2)) / one;
+}
+
+/**
+ * @brief Divide every value by a power of two so all stay below a limit
+ *
+ * @return Power of two divided by
+ */
+static uint32_t headroom(int32_t *work, uint32_t values, uint32_t limit_bits)
+{
+    uint32_t peak = 0;
+    for (uint32_t i = 0; i < values; ++i) {
+        uint32_t const magnitude =
+            work[i] < 0 ? 0U - (uint32_t)work[i] : (uint32_t)work[i];
+        if (magnitude > peak) {
+            peak = magnitude;
+        }
+    }
+
+    uint32_t const bits = bit_length(peak);
+    if (bits <= limit_bits) {
+        return 0;
+    }
+
+    // The work values are Q31 with a shared exponent; a Q31 gain of
+    // 2^-shift halves them with one long multiply each, rounding to nearest
+    uint32_t const shift = bits - limit_bits;
+    FIXED_Q31 const gain = (FIXED_Q31)(UINT32_C(1) << (31 - shift));
+    FIXED_q31_scale_array(work, gain, work, values);
+    return shift;
+}
+
+/**
+ * @brief Reorder complex values into bit-reversed index order
+ */
+static void bit_reverse(int32_t *work, uint32_t size)
+{
+    uint32_t j = 0;
+    for (uint32_t i = 1; i < size; ++i) {
+        uint32_t bit = size >> 1;
+        for (; (j & bit) != 0; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+
+        if (i < j) {
+            int32_t const re = work[2 * i];
+            int32_t const im = work[(2 * i) + 1];
+            work[2 * i] = work[2 * j];
+            work[(2 * i) + 1] = work[(2 * j) + 1];
+            work[2 * j] = re;
+            work[(2 * j) + 1] = im;
+        }
+    }
+}
+
+/**
+ * @brief In-place radix-2 decimation-in-time FFT
+ *
+ * @return Power of two by which the result was scaled down
+ */
+static uint32_t transform(int32_t *work, uint32_t size)
+{
+    int64_t const one = INT64_C(1) << TWIDDLE_FRAC_BITS;
+    // exp(-2 pi i / length) = cos_step - i * sin_step
+    int64_t cos_step = -one;
+    int64_t sin_step = 0;
+    uint32_t exponent = 0;
+
+    bit_reverse(work, size);
+
+    for (uint32_t length = 2; length <= size; length <<= 1) {
+        uint32_t const half = length / 2;
+
+        if (length == 4) {
+            cos_step = 0;
+            sin_step = one;
+        } else if (length > 4) {
+            // Half-angle formulas; the cosine is positive from here on
+            uint64_t const square = (uint64_t)(one + cos_step) / 2;
+            cos_step = (int64_t)FIXED_isqrt64(square << TWIDDLE_FRAC_BITS);
+            sin_step = (sin_step * one) / (2 * cos_step);
+        }
+
+        exponent += headroom(work, 2 * size, STAGE_LIMIT_BITS);
+
+        int64_t cos_j = one;
+        int64_t sin_j = 0;
+        for (uint32_t j = 0; j < half; ++j) {
+            for (uint32_t k = j; k < size; k += length) {
+                int32_t *const a = &work[2 * k];
+                int32_t *const b = &work[2 * (k + half)];
+                int32_t const re =
+                    (int32_t)rotate(cos_j, b[0], sin_j, b[1]);
+                int32_t const im =
+                    (int32_t)rotate(cos_j, b[1], -sin_j, b[0]);
+
+                b[0] = a[0] - re;
+                b[1] = a[1] - im;
+                a[0] += re;
+                a[1] += im;
+            }
+
+            int64_t const next_cos =
+                rotate(cos_j, cos_step, -sin_j, sin_step);
+            sin_j = rotate(cos_j, sin_step, sin_j, cos_step);
+            cos_j = next_cos;
+        }
+    }
+
+    return exponent;
+}
+
+/**
+ * @brief Apply the window to one bin of the transform
+ *
+ * Bins below zero wrap around to the top of the transform, which holds
+ * the negative frequencies.
+ */
+static void window_bin(
+    int32_t const *work,
+    uint32_t size,
+    uint32_t k,
+    int64_t *re,
+    int64_t *im
+)
+{
+    static int32_t const taps[] = { WINDOW_TAP_1, WINDOW_TAP_2, WINDOW_TAP_3 };
+    int64_t sum_re = (int64_t)work[2 * k] * FIXED_SCALE;
+    int64_t sum_im = (int64_t)work[(2 * k) + 1] * FIXED_SCALE;
+
+    for (uint32_t j = 1; j <= sizeof(taps) / sizeof(taps[0]); ++j) {
+        uint32_t const below = (k + size - j) % size;
+        uint32_t const above = (k + j) % size;
+        int64_t const tap = taps[j - 1];
+        sum_re += tap * ((int64_t)work[2 * below] + work[2 * above]);
+        sum_im +=
+            tap * ((int64_t)work[(2 * below) + 1] + work[(2 * above) + 1]);
+    }
+
+    *re = sum_re / FIXED_SCALE;
+    *im = sum_im / FIXED_SCALE;
+}
+
+/**
+ * @brief Scale an amplitude by a power of two into a saturated Q16.16
+ */
+static FIXED_Q1616 scale_amplitude(uint64_t amplitude, int32_t scale_bits)
+{
+    if (scale_bits < 0) {
+        uint32_t const drop = (uint32_t)-scale_bits;
+        if (drop >= 64) {
+            return 0;
+        }
+        amplitude = (amplitude + (UINT64_C(1) << (drop - 1))) >> drop;
+    } else if (scale_bits > 0) {
+        uint32_t const raise = (uint32_t)scale_bits;
+        if (raise >= 32 || amplitude > ((uint64_t)FIXED_MAX >> raise)) {
+            return FIXED_MAX;
+        }
+        amplitude <<= raise;
+    }
+    return amplitude > (uint64_t)FIXED_MAX ? FIXED_MAX
+                                           : (FIXED_Q1616)amplitude;
+}
+
+bool SPECTRUM_compute(
+    uint16_t const *samples,
+    uint32_t const size,
+    uint32_t const stride,
+    int32_t *work,
+    FIXED_Q1616 *bins
+)
+{
+    uint32_t const size_bits = bit_length(size) - 1;
+    if (size < SPECTRUM_SIZE_MIN || size > SPECTRUM_SIZE_MAX ||
+        (size & (size - 1)) != 0 || stride == 0) {
+        return false;
+    }
+
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        sum += samples[i * stride];
+    }
+    int32_t const mean = (int32_t)((sum + (size / 2)) / size);
+
+    uint32_t peak = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        int32_t const value = (int32_t)samples[i * stride] - mean;
+        uint32_t const magnitude = (uint32_t)(value < 0 ? -value : value);
+        if (magnitude > peak) {
+            peak = magnitude;
+        }
+    }
+
+    if (peak == 0) {
+        for (uint32_t k = 0; k < size / 2; ++k) {
+            bins[k] = 0;
+        }
+        return true;
+    }
+
+    // Scale the input up to the stage limit for precision
+    uint32_t const shift = STAGE_LIMIT_BITS - bit_length(peak);
+    for (uint32_t i = 0; i < size; ++i) {
+        int32_t const value = (int32_t)samples[i * stride] - mean;
+        work[2 * i] = value * (int32_t)(1U << shift);
+        work[(2 * i) + 1] = 0;
+    }
+
+    uint32_t exponent = transform(work, size);
+    // Leave room for the window sum below
+    exponent += headroom(work, 2 * size, STAGE_LIMIT_BITS);
+
+    // Amplitude = 2 * |windowed bin| / size with the window normalized to
+    // unit gain. Undo the input shift and add 16 fraction bits.
+    int32_t const scale_bits = (int32_t)exponent + 17 - (int32_t)shift -
+                               (int32_t)size_bits;
+
+    for (uint32_t k = 0; k < size / 2; ++k) {
+        int64_t re = 0;
+        int64_t im = 0;
+        window_bin(work, size, k, &re, &im);
+        uint64_t const amplitude = FIXED_isqrt64(
+            (uint64_t)(re * re) + (uint64_t)(im * im)
+        );
+        bins[k] = scale_amplitude(amplitude, scale_bits);
+    }
+
+    return true;
+}
+
+uint32_t SPECTRUM_find_peaks(
+    FIXED_Q1616 const *bins,
+    uint32_t const count,
+    uint32_t *peaks,
+    uint32_t const max_peaks
+)
+{
+    uint32_t found = 0;
+
+    for (uint32_t k = 1; k + 1 < count; ++k) {
+        if (bins[k] <= bins[k - 1] || bins[k] < bins[k + 1]) {
+            continue;
+        }
+
+        // Insert into the list sorted by decreasing amplitude
+        uint32_t position = found;
+        while (position > 0 && bins[peaks[position - 1]] < bins[k]) {
+            --position;
+        }
+        if (position >= max_peaks) {
+            continue;
+        }
+        uint32_t const last = found < max_peaks ? found : max_peaks - 1;
+        for (uint32_t i = last; i > position; --i) {
+            peaks[i] = peaks[i - 1];
+        }
+        peaks[position] = k;
+        if (found < max_peaks) {
+            ++found;
+        }
+    }
+
+    return found;
+}
+
+/**
+ * @brief Power of one bin
+ */
+static uint64_t bin_power(FIXED_Q1616 const amplitude)
+{
+    uint64_t const value = (uint64_t)amplitude;
+    return (value * value) >> POWER_DROP_BITS;
+}
+
+/**
+ * @brief Power of a tone, over its bin and its neighbours
+ */
+static uint64_t tone_power(
+    FIXED_Q1616 const *bins,
+    uint32_t count,
+    uint32_t center
+)
+{
+    uint32_t const first =
+        center > SPECTRUM_TONE_BINS ? center - SPECTRUM_TONE_BINS : 0;
+    uint32_t const end = center + SPECTRUM_TONE_BINS + 1;
+    uint64_t power = 0;
+
+    for (uint32_t k = first; k < end && k < count; ++k) {
+        power += bin_power(bins[k]);
+    }
+    return power;
+}
+
+/**
+ * @brief Power ratio in 0.01 dB, zero powers counting as the smallest unit
+ */
+static int32_t ratio_cdb(uint64_t numerator, uint64_t denominator)
+{
+    int64_t const log2_ratio =
+        (int64_t)FIXED_log2(numerator) - FIXED_log2(denominator);
+    int64_t const scaled = log2_ratio * LOG10_2_Q16 * CDB_PER_DECADE;
+    int64_t const unit = (int64_t)FIXED_SCALE * FIXED_SCALE;
+    return (int32_t)((scaled + (scaled >= 0 ? unit / 2 : -unit / 2)) / unit);
+}
+
+void SPECTRUM_distortion(
+    FIXED_Q1616 const *bins,
+    uint32_t const count,
+    uint32_t const harmonics,
+    SPECTRUM_Distortion *out
+)
+{
+    // Skip the DC band, which the window spreads over its neighbours
+    uint32_t const first = SPECTRUM_TONE_BINS + 1;
+    uint32_t fundamental = first;
+    uint64_t total = 0;
+
+    for (uint32_t k = first; k < count; ++k) {
+        if (bins[k] > bins[fundamental]) {
+            fundamental = k;
+        }
+        total += bin_power(bins[k]);
+    }
+
+    uint64_t const signal = tone_power(bins, count, fundamental);
+
+    // Power-weighted centre of the tone
+    int64_t moment = 0;
+    for (int32_t offset = -SPECTRUM_TONE_BINS; offset <= SPECTRUM_TONE_BINS;
+         ++offset) {
+        uint32_t const k = fundamental + (uint32_t)offset;
+        if (k < count) {
+            moment += offset * (int64_t)bin_power(bins[k]);
+        }
+    }
+    FIXED_Q1616 const center =
+        (FIXED_Q1616)((int64_t)(fundamental << 16) +
+                      (signal > 0 ? (moment * FIXED_SCALE) / (int64_t)signal
+                                  : 0));
+
+    uint64_t distortion = 0;
+    uint32_t included = 0;
+    for (uint32_t h = 2; h <= harmonics; ++h) {
+        uint32_t const bin =
+            (uint32_t)(((uint64_t)h * (uint32_t)center + (FIXED_SCALE / 2)) >>
+                       16);
+        if (bin + SPECTRUM_TONE_BINS >= count) {
+            break;
+        }
+        distortion += tone_power(bins, count, bin);
+        ++included;
+    }
+
+    uint64_t const tones = signal + distortion;
+    uint64_t const noise = total > tones ? total - tones : 0;
+
+    // The window spreads a tone's power over its noise bandwidth
+    uint64_t const peak_power =
+        ((signal << POWER_DROP_BITS) / WINDOW_ENBW_Q16) << POWER_DROP_BITS;
+    *out = (SPECTRUM_Distortion){
+        .fundamental = center,
+        .amplitude = (FIXED_Q1616)FIXED_isqrt64(peak_power),
+        .harmonics = included,
+        .thd_cdb = ratio_cdb(distortion, signal),
+        .snr_cdb = ratio_cdb(signal, noise),
+    };
+}
+
+bool SPECTRUM_phasor(
+    uint16_t const *samples,
+    uint32_t const count,
+    uint32_t const stride,
+    uint32_t const step,
+    SPECTRUM_Phasor *out
+)
+{
+    if (count < 2 || count > SPECTRUM_SIZE_MAX || stride == 0) {
+        return false;
+    }
+
+    uint32_t const quarter_turn = UINT32_C(1) << 30;
+    uint32_t phase = 0;
+    int64_t sum = 0;
+    int64_t sum_cos = 0;
+    int64_t sum_sin = 0;
+    int64_t cross_cos = 0;
+    int64_t cross_sin = 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        int64_t const x = samples[(size_t)i * stride];
+        int64_t const c = FIXED_sin(phase + quarter_turn);
+        int64_t const s = FIXED_sin(phase);
+        sum += x;
+        sum_cos += c;
+        sum_sin += s;
+        cross_cos += x * c;
+        cross_sin += x * s;
+        phase += step;
+    }
+
+    // n sum(x cos) - sum(x) sum(cos) is n times the correlation with the
+    // mean removed, and a tone of amplitude A correlates to A n / 2
+    int64_t const n = count;
+    int64_t const real = (n * cross_cos) - (sum * sum_cos);
+    int64_t const imag = (sum * sum_sin) - (n * cross_sin);
+    *out = (SPECTRUM_Phasor){
+        .real = (FIXED_Q1616)divide_rounded(2 * real, n * n),
+        .imag = (FIXED_Q1616)divide_rounded(2 * imag, n * n),
+    };
+    return true;
+}
+
+/**
+ * @brief Squared amplitude of a phasor, in Q32.32
+ */
+static uint64_t phasor_power(SPECTRUM_Phasor const *phasor)
+{
+    int64_t const real = phasor->real;
+    int64_t const imag = phasor->imag;
+    return (uint64_t)(real * real) + (uint64_t)(imag * imag);
+}
+
+void SPECTRUM_response(
+    SPECTRUM_Phasor const *reference,
+    SPECTRUM_Phasor const *response,
+    SPECTRUM_Response *out
+)
+{
+    uint32_t const phase = FIXED_atan2(response->imag, response->real) -
+                           FIXED_atan2(reference->imag, reference->real);
+    // As a signed fraction of a turn, -1/2 to 1/2
+    int64_t const turns = phase >= (UINT32_C(1) << 31)
+                              ? (int64_t)phase - (INT64_C(1) << 32)
+                              : (int64_t)phase;
+
+    *out = (SPECTRUM_Response){
+        .gain_cdb =
+            ratio_cdb(phasor_power(response), phasor_power(reference)),
+        .phase_cdeg = (int32_t)divide_rounded(
+            turns * CDEG_PER_TURN, INT64_C(1) << 32
+        ),
+    };
+}
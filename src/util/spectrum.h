@@ -0,0 +1,188 @@
+/**
+ * @file spectrum.h
+ * @brief Fixed-point amplitude spectrum of unsigned 16-bit samples
+ *
+ * The spectrum is a radix-2 FFT over a power-of-two number of samples
+ * with the mean removed and a 4-term Blackman-Harris window applied. The
+ * window's sidelobes stay below -92 dB, under the noise floor of a 12-bit
+ * ADC, so the distortion and noise of a tone can be read off the spectrum.
+ * The FFT runs on 32-bit integers with block floating point: each stage
+ * halves the data only when it could otherwise overflow, so weak
+ * components keep their precision. Twiddle factors come from a recurrence
+ * seeded by half-angle formulas, so no sine table is needed. The window is
+ * a sum of cosines and is applied in the frequency domain as a weighted sum
+ * of each bin and its three neighbours either side.
+ *
+ * Bin amplitudes are in Q16.16 in the unit of the samples and corrected
+ * for the window gain, so a sine of amplitude A centred on bin k reads A
+ * in bin k and 0.68 A, 0.20 A and 0.02 A in the neighbours either side.
+ * Bin k is at k * sample rate / size.
+ *
+ * A single bin at any frequency is also available as a phasor, without
+ * the window, for the classic single-bin DFT: over a record of whole
+ * periods of a tone, e.g. a stimulus and its response sampled together,
+ * the ratio of two phasors is the gain and phase from one to the other.
+ *
+ * The functions are allocation free; the caller provides the FFT work
+ * buffer.
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#ifndef PSLAB_SPECTRUM_H
+#define PSLAB_SPECTRUM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    /** @brief Smallest FFT size */
+    SPECTRUM_SIZE_MIN = 16,
+    /** @brief Largest FFT size */
+    SPECTRUM_SIZE_MAX = 4096,
+    /** @brief Bins either side of a tone counted as part of it */
+    SPECTRUM_TONE_BINS = 4,
+};
+
+/**
+ * @brief Fundamental and distortion of a spectrum
+ */
+typedef struct {
+    FIXED_Q1616 fundamental; // Bin of the strongest tone, interpolated
+    FIXED_Q1616 amplitude; // Amplitude of the strongest tone
+    uint32_t harmonics; // Harmonics below the top bin included in thd
+    int32_t thd_cdb; // Harmonic to fundamental power, in 0.01 dB
+    int32_t snr_cdb; // Fundamental to noise power, in 0.01 dB
+} SPECTRUM_Distortion;
+
+/**
+ * @brief Amplitude and phase of one frequency, in the unit of the samples
+ *
+ * A tone A cos(2 pi f t + phi) reads real = A cos(phi) and
+ * imag = A sin(phi), with t = 0 at the first sample.
+ */
+typedef struct {
+    FIXED_Q1616 real;
+    FIXED_Q1616 imag;
+} SPECTRUM_Phasor;
+
+/**
+ * @brief Gain and phase shift from one phasor to another
+ */
+typedef struct {
+    int32_t gain_cdb; // Amplitude ratio, in 0.01 dB
+    int32_t phase_cdeg; // Phase difference, -18000 to 18000 in 0.01 degree
+} SPECTRUM_Response;
+
+/**
+ * @brief Compute the amplitude spectrum of a block of samples
+ *
+ * @param samples First sample
+ * @param size Number of samples, a power of two from SPECTRUM_SIZE_MIN to
+ *             SPECTRUM_SIZE_MAX
+ * @param stride Distance between consecutive samples, e.g. the number of
+ *               interleaved channels
+ * @param work FFT work buffer of 2 * size values
+ * @param bins Output, size / 2 amplitudes from DC up to below half the
+ *             sample rate; must not overlap work
+ *
+ * @return false if size is not a supported power of two or stride is 0
+ */
+bool SPECTRUM_compute(
+    uint16_t const *samples,
+    uint32_t size,
+    uint32_t stride,
+    int32_t *work,
+    FIXED_Q1616 *bins
+);
+
+/**
+ * @brief Find the strongest peaks of a spectrum
+ *
+ * A peak is a bin above its lower neighbour and not below its upper one.
+ *
+ * @param bins Amplitude spectrum
+ * @param count Number of bins
+ * @param peaks Output, bin indices by decreasing amplitude
+ * @param max_peaks Room in peaks
+ *
+ * @return Number of peaks found, at most max_peaks
+ */
+uint32_t SPECTRUM_find_peaks(
+    FIXED_Q1616 const *bins,
+    uint32_t count,
+    uint32_t *peaks,
+    uint32_t max_peaks
+);
+
+/**
+ * @brief Measure the harmonic distortion and noise of the strongest tone
+ *
+ * Each tone is taken as the power in its bin and SPECTRUM_TONE_BINS bins
+ * either side, which covers the main lobe of the window wherever the tone
+ * falls between bins. Noise is the power in all other bins above the DC
+ * band. Harmonics above the top bin are left out rather than folded back.
+ *
+ * @param bins Amplitude spectrum
+ * @param count Number of bins, above 2 * SPECTRUM_TONE_BINS + 1
+ * @param harmonics Highest harmonic to include, e.g. 5 for the 2nd to 5th
+ * @param out Distortion measurements
+ */
+void SPECTRUM_distortion(
+    FIXED_Q1616 const *bins,
+    uint32_t count,
+    uint32_t harmonics,
+    SPECTRUM_Distortion *out
+);
+
+/**
+ * @brief Correlate a block of samples with one frequency
+ *
+ * The single-bin DFT of the samples with their mean removed, so that the
+ * DC level does not leak into the bin. The frequency may fall between
+ * bins; over whole periods of the tone the other components cancel.
+ *
+ * @param samples First sample
+ * @param count Number of samples, 2 to SPECTRUM_SIZE_MAX
+ * @param stride Distance between consecutive samples
+ * @param step Frequency over the sample rate, in units of 2^-32 turns per
+ *             sample
+ * @param out Phasor of the frequency
+ *
+ * @return false if count is out of range or stride is 0
+ */
+bool SPECTRUM_phasor(
+    uint16_t const *samples,
+    uint32_t count,
+    uint32_t stride,
+    uint32_t step,
+    SPECTRUM_Phasor *out
+);
+
+/**
+ * @brief Gain and phase of a response relative to its stimulus
+ *
+ * A zero phasor counts as the smallest amplitude, and its phase as 0.
+ *
+ * @param reference Phasor of the stimulus
+ * @param response Phasor of the response at the same frequency
+ * @param out Gain and phase of the response
+ */
+void SPECTRUM_response(
+    SPECTRUM_Phasor const *reference,
+    SPECTRUM_Phasor const *response,
+    SPECTRUM_Response *out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_SPECTRUM_H
@@ -0,0 +1,117 @@
+/**
+ * @file stats.c
+ * @brief Summary statistics over blocks of unsigned 16-bit samples
+ *
+ * See stats.h for the supported range.
+ */
+#include <stdint.h>
+
+#include "fixed_point.h"
+
+#include "stats.h"
+
+/**
+ * @brief Saturate a non-negative Q16.16 intermediate to the result type
+ */
+static FIXED_Q1616 saturate(uint64_t const value)
+{
+    return value > (uint64_t)FIXED_MAX ? FIXED_MAX : (FIXED_Q1616)value;
+}
+
+void STATS_summarize(
+    uint16_t const *samples,
+    uint32_t const count,
+    STATS_Summary *out
+)
+{
+    STATS_Summary summary = STATS_SUMMARY_EMPTY;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t const sample = samples[i];
+
+        summary.sum += sample;
+        if (samples[i] < summary.min) {
+            summary.min = samples[i];
+        }
+        if (samples[i] > summary.max) {
+            summary.max = samples[i];
+        }
+    }
+    summary.count = count;
+
+    // ADC codes fit in 15 bits, where the samples read as Q15 are the same
+    // integers and their dot product with themselves is the sum of squares,
+    // two samples per dual multiply-accumulate
+    if (summary.max <= INT16_MAX) {
+        FIXED_Q15 const *const values = (FIXED_Q15 const *)samples;
+        summary.sum_squares = (uint64_t)FIXED_q15_dot(values, values, count);
+    } else {
+        for (uint32_t i = 0; i < count; ++i) {
+            summary.sum_squares += (uint64_t)samples[i] * samples[i];
+        }
+    }
+    *out = summary;
+}
+
+void STATS_merge(STATS_Summary *into, STATS_Summary const *other)
+{
+    into->count += other->count;
+    into->sum += other->sum;
+    into->sum_squares += other->sum_squares;
+    if (other->min < into->min) {
+        into->min = other->min;
+    }
+    if (other->max > into->max) {
+        into->max = other->max;
+    }
+}
+
+FIXED_Q1616 STATS_mean(STATS_Summary const *summary)
+{
+    if (summary->count == 0) {
+        return FIXED_ZERO;
+    }
+
+    uint64_t const scaled = (uint64_t)summary->sum * FIXED_SCALE;
+    return saturate((scaled + summary->count / 2) / summary->count);
+}
+
+FIXED_Q1616 STATS_rms(STATS_Summary const *summary)
+{
+    if (summary->count == 0) {
+        return FIXED_ZERO;
+    }
+
+    // The mean square needs 32 fraction bits for a Q16.16 root. Split it so
+    // that the shift cannot overflow: the quotient of 16-bit squares fits
+    // in 32 bits and the remainder is below the 32-bit count.
+    uint64_t const quotient = summary->sum_squares / summary->count;
+    uint64_t const remainder = summary->sum_squares % summary->count;
+    uint64_t const mean_square =
+        (quotient << 32) + (remainder << 32) / summary->count;
+
+    return saturate(FIXED_isqrt64(mean_square));
+}
+
+FIXED_Q1616 STATS_ac_rms(STATS_Summary const *summary)
+{
+    if (summary->count == 0) {
+        return FIXED_ZERO;
+    }
+
+    // count^2 * variance = count * sum_squares - sum^2, in integers so
+    // that a small AC part on a large mean keeps its precision
+    uint64_t const count = summary->count;
+    uint64_t const product = count * summary->sum_squares;
+    uint64_t const square = (uint64_t)summary->sum * summary->sum;
+    uint64_t const scaled = product > square ? product - square : 0;
+
+    // Variance in Q32.32, split as in STATS_rms: count^2 is at most 2^32
+    uint64_t const count_squared = count * count;
+    uint64_t const quotient = scaled / count_squared;
+    uint64_t const remainder = scaled % count_squared;
+    uint64_t const variance =
+        (quotient << 32) + (remainder << 32) / count_squared;
+
+    return saturate(FIXED_isqrt64(variance));
+}
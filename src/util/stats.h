@@ -0,0 +1,103 @@
+/**
+ * @file stats.h
+ * @brief Summary statistics over blocks of unsigned 16-bit samples
+ *
+ * A summary keeps the sample count, sum, sum of squares, minimum and
+ * maximum of a block. Summaries of neighbouring blocks can be merged, so a
+ * producer can summarize each block as it arrives and a consumer can
+ * combine the latest blocks into statistics over a longer window.
+ *
+ * Mean and RMS are returned in Q16.16 fixed point in the unit of the
+ * samples, so fractional codes survive until the caller scales them.
+ * Summaries are exact for up to 65536 samples. The functions are
+ * allocation free and safe to call from interrupt context.
+ *
+ * @author PSLab Team
+ * @date 2025-10-15
+ */
+
+#ifndef PSLAB_STATS_H
+#define PSLAB_STATS_H
+
+#include <stdint.h>
+
+#include "util/fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Summary of a block of samples
+ */
+typedef struct {
+    uint32_t count; // Number of samples summarized
+    uint32_t sum; // Sum of the samples
+    uint64_t sum_squares; // Sum of the squared samples
+    uint16_t min; // Smallest sample, UINT16_MAX if count is 0
+    uint16_t max; // Largest sample, 0 if count is 0
+} STATS_Summary;
+
+/**
+ * @brief Initial value of an empty summary
+ */
+#define STATS_SUMMARY_EMPTY                                                    \
+    { .count = 0, .sum = 0, .sum_squares = 0, .min = UINT16_MAX, .max = 0 }
+
+/**
+ * @brief Summarize a block of samples
+ *
+ * @param samples Input samples
+ * @param count Number of samples
+ * @param out Summary of the block
+ */
+void STATS_summarize(
+    uint16_t const *samples,
+    uint32_t count,
+    STATS_Summary *out
+);
+
+/**
+ * @brief Add the samples of one summary to another
+ *
+ * @param into Summary to extend
+ * @param other Summary to add
+ */
+void STATS_merge(STATS_Summary *into, STATS_Summary const *other);
+
+/**
+ * @brief Arithmetic mean of the summarized samples
+ *
+ * @param summary Summary to evaluate
+ *
+ * @return Mean in Q16.16, rounded to nearest, or 0 if the summary is empty
+ */
+FIXED_Q1616 STATS_mean(STATS_Summary const *summary);
+
+/**
+ * @brief Root mean square of the summarized samples
+ *
+ * @param summary Summary to evaluate
+ *
+ * @return RMS in Q16.16, rounded down, saturated at FIXED_MAX, or 0 if the
+ *         summary is empty
+ */
+FIXED_Q1616 STATS_rms(STATS_Summary const *summary);
+
+/**
+ * @brief Root mean square of the summarized samples about their mean
+ *
+ * The AC part of the signal's RMS, which is its standard deviation. Exact
+ * for up to 65536 samples of 15 bits.
+ *
+ * @param summary Summary to evaluate
+ *
+ * @return AC RMS in Q16.16, rounded down, or 0 if the summary is empty
+ */
+FIXED_Q1616 STATS_ac_rms(STATS_Summary const *summary);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSLAB_STATS_H
@@ -20,6 +20,40 @@ extern "C" {
  *
  * This structure manages a circular buffer with head and tail pointers.
  * Used throughout the codebase for buffering data in UART, USB, and logging.
+ *
+ * A buffer is shared by one producer and one consumer, either of which may
+ * run in an interrupt handler or be a DMA stream that an interrupt handler
+ * accounts for:
+ * - Only the producer writes head, with circular_buffer_put,
+ *   circular_buffer_write and circular_buffer_commit_write
+ * - Only the consumer writes tail, with circular_buffer_get,
+ *   circular_buffer_read and circular_buffer_commit_read
+ * - circular_buffer_reserve_contiguous belongs to the producer, and
+ *   circular_buffer_peek_contiguous and circular_buffer_peek_spans to the
+ *   consumer
+ * - The queries may be called from either side; the other side can only
+ *   change their result in the caller's favour meanwhile
+ * - circular_buffer_init and circular_buffer_reset run while neither side
+ *   uses the buffer
+ *
+ * Each side publishes its index with release ordering after the bytes it
+ * covers, and reads the other's with acquire ordering, so a side never sees
+ * an index before the bytes behind it. Several producers or consumers need
+ * their own serialization, as LOG_write has.
+ *
+ * circular_buffer_init always validates its arguments. The other functions
+ * take a buffer it has set up; they check for null pointers and commits
+ * beyond the bytes there are with CHECK_ARGUMENT, so only builds with
+ * argument checks throw ERROR_INVALID_ARGUMENT for them.
+ *
+ * In overwrite mode (circular_buffer_set_overwrite), a producer that finds
+ * the buffer full drops the oldest bytes instead, so that the buffer keeps
+ * the most recent ones. The producer then advances tail too: both sides
+ * move it with compare-and-swap, and a consumer whose bytes were dropped
+ * while it copied them out starts over at the new tail. The zero-copy
+ * consumer functions, circular_buffer_peek_contiguous,
+ * circular_buffer_peek_spans and circular_buffer_commit_read, cannot tell
+ * that their bytes were dropped and are not for buffers in this mode.
  */
 typedef struct {
     uint8_t *buffer;
@@ -27,6 +61,8 @@ typedef struct {
     uint32_t volatile tail;
     uint32_t size;
     uint32_t mask; // mask for power-of-two optimization
+    bool overwrite; // Drop the oldest bytes when full
+    uint32_t volatile overwritten; // Bytes dropped, written by the producer
 } CircularBuffer;
 
 /**
@@ -38,6 +74,14 @@ typedef struct {
  */
 void circular_buffer_init(CircularBuffer *cb, uint8_t *buffer, uint32_t size);
 
+/**
+ * @brief Check at compile time that a size suits circular_buffer_init
+ *
+ *     static_assert(CIRCULAR_BUFFER_SIZE_VALID(N), "N must be a power of 2");
+ */
+#define CIRCULAR_BUFFER_SIZE_VALID(size)                                       \
+    ((size) > 0 && ((size) & ((size) - 1)) == 0)
+
 /**
  * @brief Check if circular buffer is empty
  *
@@ -67,7 +111,8 @@ uint32_t circular_buffer_available(CircularBuffer *cb);
  *
  * @param cb Pointer to circular buffer structure
  * @param data Byte to put into buffer
- * @return true if successful, false if buffer is full
+ * @return true if successful, false if buffer is full; always true in
+ *         overwrite mode
  */
 bool circular_buffer_put(CircularBuffer *cb, uint8_t data);
 
@@ -80,6 +125,28 @@ bool circular_buffer_put(CircularBuffer *cb, uint8_t data);
  */
 bool circular_buffer_get(CircularBuffer *cb, uint8_t *data);
 
+/**
+ * @brief Keep the most recent bytes when full, instead of rejecting new ones
+ *
+ * Neither side may be using the buffer meanwhile.
+ *
+ * @param cb Pointer to circular buffer structure
+ * @param overwrite true to drop the oldest bytes when full
+ */
+void circular_buffer_set_overwrite(CircularBuffer *cb, bool overwrite);
+
+/**
+ * @brief Get the number of bytes dropped in overwrite mode
+ *
+ * Counts the oldest bytes dropped to make room, and the leading bytes of a
+ * circular_buffer_write longer than the buffer holds, since the last
+ * circular_buffer_init or circular_buffer_reset.
+ *
+ * @param cb Pointer to circular buffer structure
+ * @return Number of bytes dropped
+ */
+uint32_t circular_buffer_overwritten(CircularBuffer *cb);
+
 /**
  * @brief Reset (empty) a circular buffer
  *
@@ -93,7 +160,8 @@ void circular_buffer_reset(CircularBuffer *cb);
  * @param cb Pointer to circular buffer structure
  * @param data Pointer to data to write
  * @param len Number of bytes to write
- * @return Number of bytes actually written
+ * @return Number of bytes actually written; in overwrite mode, all but
+ *         those beyond the capacity of the buffer, of which the last are kept
  */
 uint32_t circular_buffer_write(
     CircularBuffer *cb,
@@ -119,6 +187,75 @@ uint32_t circular_buffer_read(CircularBuffer *cb, uint8_t *data, uint32_t len);
  */
 uint32_t circular_buffer_free_space(CircularBuffer *cb);
 
+/**
+ * @brief Get the contiguous span of readable data at the tail
+ *
+ * The span stays valid until it is released with circular_buffer_commit_read.
+ * When the stored data wraps around the end of the storage, only the part up
+ * to the end is returned; commit it and peek again for the rest.
+ *
+ * @param cb Pointer to circular buffer structure
+ * @param data Set to the start of the readable span
+ * @return Number of contiguous bytes readable at *data
+ */
+uint32_t circular_buffer_peek_contiguous(
+    CircularBuffer *cb,
+    uint8_t const **data
+);
+
+/**
+ * @brief Get all readable data at the tail as two contiguous spans
+ *
+ * Like circular_buffer_peek_contiguous, but also returns the part that
+ * wraps around to the start of the storage, taken from the same head, so
+ * that both spans can be consumed in one operation such as a DMA transfer.
+ *
+ * @param cb Pointer to circular buffer structure
+ * @param first Set to the start of the readable span at the tail
+ * @param first_len Set to the number of bytes readable at *first
+ * @param second Set to the start of the storage, where the data continues
+ * @return Number of bytes readable in total; beyond *first_len, they
+ *         continue at *second
+ */
+uint32_t circular_buffer_peek_spans(
+    CircularBuffer *cb,
+    uint8_t const **first,
+    uint32_t *first_len,
+    uint8_t const **second
+);
+
+/**
+ * @brief Release bytes previously obtained with circular_buffer_peek_contiguous
+ *
+ * @param cb Pointer to circular buffer structure
+ * @param len Number of bytes consumed (must not exceed available data)
+ */
+void circular_buffer_commit_read(CircularBuffer *cb, uint32_t len);
+
+/**
+ * @brief Get the contiguous span of free storage at the head
+ *
+ * The caller may fill the span in place and publish it with
+ * circular_buffer_commit_write.
+ *
+ * @param cb Pointer to circular buffer structure
+ * @param data Set to the start of the writable span
+ * @return Number of contiguous bytes writable at *data
+ */
+uint32_t circular_buffer_reserve_contiguous(
+    CircularBuffer *cb,
+    uint8_t **data
+);
+
+/**
+ * @brief Publish bytes written into a span from
+ * circular_buffer_reserve_contiguous
+ *
+ * @param cb Pointer to circular buffer structure
+ * @param len Number of bytes written (must not exceed free space)
+ */
+void circular_buffer_commit_write(CircularBuffer *cb, uint32_t len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,123 @@
+/**
+ * @file bench.c
+ * @brief Minimal host benchmark harness
+ */
+
+// clock_gettime
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+
+static FILE *g_csv = nullptr;
+
+static bool g_once = false;
+
+static uint32_t volatile g_sink = 0;
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_double(void const *a, void const *b)
+{
+    double const x = *(double const *)a;
+    double const y = *(double const *)b;
+    return (x > y) - (x < y);
+}
+
+void BENCH_init(int argc, char **argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--once") == 0) {
+            g_once = true;
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            g_csv = fopen(argv[i + 1], "w");
+            if (!g_csv) {
+                perror(argv[i + 1]);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(g_csv, "benchmark,iterations,min_ns,median_ns,max_ns\n");
+        }
+    }
+
+    if (g_once) {
+        printf("%-36s %10s\n", "benchmark", "iterations");
+        return;
+    }
+    printf(
+        "%-36s %10s %10s %10s %10s\n",
+        "benchmark",
+        "iterations",
+        "min ns",
+        "median ns",
+        "max ns"
+    );
+}
+
+void BENCH_run(
+    char const *name,
+    BENCH_Function function,
+    void *context,
+    uint32_t iterations
+)
+{
+    double per_op[BENCH_SAMPLES];
+
+    if (g_once) {
+        function(context, iterations);
+        printf("%-36s %10u\n", name, (unsigned)iterations);
+        fflush(stdout);
+        return;
+    }
+
+    // Warm up caches and branch predictors
+    function(context, iterations);
+
+    for (uint32_t i = 0; i < BENCH_SAMPLES; ++i) {
+        uint64_t const start = now_ns();
+        function(context, iterations);
+        uint64_t const elapsed = now_ns() - start;
+        per_op[i] = (double)elapsed / (double)iterations;
+    }
+    qsort(per_op, BENCH_SAMPLES, sizeof(per_op[0]), compare_double);
+
+    double const min = per_op[0];
+    double const median = per_op[BENCH_SAMPLES / 2];
+    double const max = per_op[BENCH_SAMPLES - 1];
+    printf(
+        "%-36s %10u %10.2f %10.2f %10.2f\n",
+        name,
+        (unsigned)iterations,
+        min,
+        median,
+        max
+    );
+    fflush(stdout);
+    if (g_csv) {
+        fprintf(
+            g_csv,
+            "%s,%u,%.2f,%.2f,%.2f\n",
+            name,
+            (unsigned)iterations,
+            min,
+            median,
+            max
+        );
+        fflush(g_csv);
+    }
+}
+
+void BENCH_consume(uint32_t value) { g_sink = g_sink + value; }
@@ -0,0 +1,84 @@
+/**
+ * @file bench.h
+ * @brief Minimal host benchmark harness
+ *
+ * Each benchmark is a function that performs an operation a given number of
+ * times. BENCH_run calls it once to warm up, then times BENCH_SAMPLES runs
+ * with a monotonic clock and reports the minimum, median and maximum time
+ * per operation. The median is the figure to track: it is stable across
+ * runs on an otherwise idle machine, while the maximum shows scheduling
+ * noise.
+ *
+ * Results are printed as a table. Started with --csv <file>, a benchmark
+ * also writes them to a CSV file, for collecting numbers across commits.
+ * Started with --once, BENCH_run calls each function a single time and
+ * times nothing, so that a run under an instruction counter does a fixed
+ * amount of work.
+ *
+ * @code
+ * static void bench_put(void *context, uint32_t iterations)
+ * {
+ *     for (uint32_t i = 0; i < iterations; ++i) {
+ *         ...
+ *     }
+ * }
+ *
+ * int main(int argc, char **argv)
+ * {
+ *     BENCH_init(argc, argv);
+ *     BENCH_run("put", bench_put, nullptr, 100000);
+ *     return 0;
+ * }
+ * @endcode
+ */
+
+#ifndef PSLAB_BENCH_H
+#define PSLAB_BENCH_H
+
+#include <stdint.h>
+
+enum {
+    BENCH_SAMPLES = 11, // Timed runs per benchmark
+};
+
+/**
+ * @brief Operation under test
+ *
+ * @param context Benchmark state passed to BENCH_run
+ * @param iterations Number of times to perform the operation
+ */
+typedef void (*BENCH_Function)(void *context, uint32_t iterations);
+
+/**
+ * @brief Open the CSV file named on the command line and print a header
+ *
+ * @param argc Argument count from main
+ * @param argv Arguments from main; --csv <file> writes results to file,
+ *             --once runs each benchmark once without timing it
+ */
+void BENCH_init(int argc, char **argv);
+
+/**
+ * @brief Time a benchmark and print its statistics
+ *
+ * @param name Benchmark name, without commas
+ * @param function Operation under test
+ * @param context Passed to function
+ * @param iterations Operations per timed run
+ */
+void BENCH_run(
+    char const *name,
+    BENCH_Function function,
+    void *context,
+    uint32_t iterations
+);
+
+/**
+ * @brief Keep a result alive, so that the compiler cannot drop its
+ *        computation
+ *
+ * @param value Result of the operation under test
+ */
+void BENCH_consume(uint32_t value);
+
+#endif // PSLAB_BENCH_H
@@ -0,0 +1,248 @@
+/**
+ * @file bench_protocol.c
+ * @brief Benchmarks of SCPI command dispatch and DSO fetch formatting
+ *
+ * Commands run through protocol_task as they would from USB, with the USB
+ * and instrument drivers replaced by their mocks. The mocks are only used
+ * in stub and ignore mode, which costs nothing per call, and each
+ * benchmark runs as a Unity test so that an unexpected driver call stops
+ * it with a message instead of crashing the harness.
+ *
+ * Response data is discarded by the fake USB port, so the figures cover
+ * parsing, dispatch and formatting but not the USB driver.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_dso.h"
+#include "mock_system.h"
+#include "mock_profile.h"
+#include "mock_usb.h"
+
+#include "application/protocol.h"
+
+#include "bench.h"
+
+enum {
+    FETCH_POINTS = 4096, // Samples per DSO fetch
+};
+
+// The DSO completion callback, implemented in dso.c
+extern void dso_complete_callback(void);
+
+static USB_Handle *const g_usb_handle = (USB_Handle *)0x12345678;
+static DSO_Handle *const g_dso_handle = (DSO_Handle *)0x13579BDF;
+static DSO_Config g_dso_config;
+
+// Command fed to the protocol, from the start on every iteration
+static char const *g_input = nullptr;
+static uint32_t g_input_len = 0;
+static uint32_t g_input_pos = 0;
+
+static uint32_t g_output_len = 0;
+
+static bool fake_rx_ready(USB_Handle *handle, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    return g_input_pos < g_input_len;
+}
+
+static uint32_t fake_read(
+    USB_Handle *handle,
+    uint8_t *buffer,
+    uint32_t max_len,
+    int cmock_num_calls
+)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    uint32_t const remaining = g_input_len - g_input_pos;
+    uint32_t const len = remaining < max_len ? remaining : max_len;
+    memcpy(buffer, &g_input[g_input_pos], len);
+    g_input_pos += len;
+    return len;
+}
+
+static uint32_t fake_write(
+    USB_Handle *handle,
+    uint8_t const *data,
+    uint32_t len,
+    int cmock_num_calls
+)
+{
+    (void)handle;
+    (void)data;
+    (void)cmock_num_calls;
+    g_output_len += len;
+    return len;
+}
+
+static bool fake_write_buffer(
+    USB_Handle *handle,
+    uint8_t const *buf,
+    uint32_t sz,
+    int cmock_num_calls
+)
+{
+    (void)handle;
+    (void)buf;
+    (void)cmock_num_calls;
+    g_output_len += sz;
+    return true;
+}
+
+static DSO_Handle *fake_dso_init(DSO_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    g_dso_config = *config;
+    return g_dso_handle;
+}
+
+static DSO_Config fake_dso_get_config(DSO_Handle *handle, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    return g_dso_config;
+}
+
+/**
+ * @brief Run one command line through the protocol
+ */
+static void run_command(char const *command)
+{
+    g_input = command;
+    g_input_len = (uint32_t)strlen(command);
+    g_input_pos = 0;
+    protocol_task();
+}
+
+void setUp(void)
+{
+    mock_usb_Init();
+    mock_dso_Init();
+    mock_system_Init();
+
+    USB_init_IgnoreAndReturn(g_usb_handle);
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_task_Ignore();
+    USB_flush_Ignore();
+    USB_rx_ready_StubWithCallback(fake_rx_ready);
+    USB_read_StubWithCallback(fake_read);
+    USB_write_StubWithCallback(fake_write);
+    USB_write_buffer_StubWithCallback(fake_write_buffer);
+    USB_tx_buffer_pending_IgnoreAndReturn(false);
+    PROFILE_boot_mark_Ignore();
+    SYSTEM_get_tick_IgnoreAndReturn(0);
+
+    protocol_init();
+}
+
+void tearDown(void)
+{
+    USB_deinit_Ignore();
+    DSO_stop_Ignore();
+    DSO_deinit_Ignore();
+    protocol_deinit();
+
+    mock_usb_Destroy();
+    mock_dso_Destroy();
+    mock_system_Destroy();
+}
+
+static void bench_command(void *context, uint32_t iterations)
+{
+    char const *const command = context;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        run_command(command);
+    }
+    BENCH_consume(g_output_len);
+}
+
+void bench_scpi_dispatch(void)
+{
+    BENCH_run("scpi_idn", bench_command, (void *)"*IDN?\n", 100000);
+    BENCH_run(
+        "scpi_dmm_average_query",
+        bench_command,
+        (void *)"DMM:CONF:AVER?\n",
+        100000
+    );
+    BENCH_run(
+        "scpi_error_query", bench_command, (void *)"SYST:ERR?\n", 100000
+    );
+    BENCH_run(
+        "scpi_burst_4",
+        bench_command,
+        (void *)"*IDN?\nDMM:CONF:AVER?\nSYST:ERR?\n*OPC?\n",
+        25000
+    );
+}
+
+/**
+ * @brief Complete a capture of FETCH_POINTS samples with repeatable data
+ */
+static void acquire_samples(void)
+{
+    DSO_get_max_sample_rate_IgnoreAndReturn(2000000);
+    DSO_init_StubWithCallback(fake_dso_init);
+    DSO_get_config_StubWithCallback(fake_dso_get_config);
+    DSO_set_config_Ignore();
+    DSO_try_start_IgnoreAndReturn(ERROR_NONE);
+    DSO_stop_Ignore();
+    DSO_deinit_Ignore();
+    DSO_is_acquisition_in_progress_IgnoreAndReturn(false);
+    DSO_get_reference_voltage_IgnoreAndReturn(3300);
+
+    run_command("OSC:CONF:ACQ:POIN 4096\n");
+    run_command("OSC:INIT\n");
+    TEST_ASSERT_NOT_NULL(g_dso_config.buffer);
+    TEST_ASSERT_EQUAL_UINT32(FETCH_POINTS, g_dso_config.buffer_size);
+
+    // A slow ramp with noise, so that every format does realistic work
+    uint32_t state = 1;
+    for (uint32_t i = 0; i < FETCH_POINTS; ++i) {
+        state = (state * 1664525U) + 1013904223U;
+        g_dso_config.buffer[i] = (uint16_t)(((i * 4) + (state >> 29)) & 0xFFF);
+    }
+    dso_complete_callback();
+}
+
+void bench_dso_fetch(void)
+{
+    static char const *const formats[][2] = {
+        { "OSC:FORM INT16\n", "dso_fetch_4096_int16" },
+        { "OSC:FORM PACK\n", "dso_fetch_4096_packed" },
+        { "OSC:FORM INT8\n", "dso_fetch_4096_int8" },
+        { "OSC:FORM DELT\n", "dso_fetch_4096_delta" },
+        { "OSC:FORM MVOL\n", "dso_fetch_4096_mvolts" },
+    };
+
+    acquire_samples();
+
+    for (uint32_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i) {
+        run_command(formats[i][0]);
+        g_output_len = 0;
+        run_command("OSC:FETC?\n");
+        TEST_ASSERT_GREATER_THAN_UINT32(0, g_output_len);
+
+        BENCH_run(
+            formats[i][1], bench_command, (void *)"OSC:FETC?\n", 1000
+        );
+    }
+}
+
+int main(int argc, char **argv)
+{
+    BENCH_init(argc, argv);
+
+    UNITY_BEGIN();
+    RUN_TEST(bench_scpi_dispatch);
+    RUN_TEST(bench_dso_fetch);
+    return UNITY_END();
+}
@@ -0,0 +1,260 @@
+/**
+ * @file bench_util.c
+ * @brief Benchmarks of the util hot paths
+ *
+ * Covers the circular buffer, the typed rings, logging, fixed-point math,
+ * decimal formatting and the interleave correction. Inputs are generated
+ * from a fixed seed, so that every run does the same work.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/fixed_point.h"
+#include "util/format.h"
+#include "util/interleave.h"
+#include "util/logging.h"
+#include "util/ring.h"
+#include "util/util.h"
+
+#include "bench.h"
+
+enum {
+    RING_SIZE = 1024,
+    CHUNK_SIZE = 64, // Bytes moved per circular buffer write or read
+    SAMPLE_CHUNK = CHUNK_SIZE / sizeof(uint16_t), // Per typed ring operation
+    CODES = 1024, // ADC codes per batch conversion
+};
+
+static uint8_t g_ring_data[RING_SIZE];
+static CircularBuffer g_ring;
+static uint8_t g_chunk[CHUNK_SIZE];
+static uint16_t g_sample_ring_data[RING_SIZE];
+static RingU16 g_sample_ring;
+static uint16_t g_samples[SAMPLE_CHUNK];
+
+static uint16_t g_codes[CODES];
+static FIXED_Q1616 g_q16[CODES];
+static int16_t g_i16[CODES];
+static FIXED_Q1616 g_operands[CODES]; // Between 1 and 17
+
+/**
+ * @brief Linear congruential generator, for repeatable inputs
+ */
+static uint32_t next_random(uint32_t *state)
+{
+    *state = (*state * 1664525U) + 1013904223U;
+    return *state;
+}
+
+static void bench_circular_buffer_put_get(void *context, uint32_t iterations)
+{
+    (void)context;
+    uint8_t byte = 0;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        circular_buffer_put(&g_ring, (uint8_t)i);
+        circular_buffer_get(&g_ring, &byte);
+    }
+    BENCH_consume(byte);
+}
+
+static void bench_circular_buffer_write_read(void *context, uint32_t iterations)
+{
+    (void)context;
+    uint32_t moved = 0;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        moved += circular_buffer_write(&g_ring, g_chunk, CHUNK_SIZE);
+        moved += circular_buffer_read(&g_ring, g_chunk, CHUNK_SIZE);
+    }
+    BENCH_consume(moved);
+}
+
+static void bench_ring_u16_write_read(void *context, uint32_t iterations)
+{
+    (void)context;
+    uint32_t moved = 0;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        moved += ring_u16_write(&g_sample_ring, g_samples, SAMPLE_CHUNK);
+        moved += ring_u16_read(&g_sample_ring, g_samples, SAMPLE_CHUNK);
+    }
+    BENCH_consume(moved);
+}
+
+static uint32_t discard_output(uint8_t const *data, uint32_t size)
+{
+    (void)data;
+    return size;
+}
+
+static void bench_log_write(void *context, uint32_t iterations)
+{
+    (void)context;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        LOG_write(LOG_LEVEL_ERROR, "ADC overrun on channel %u", (unsigned)i);
+        // Drain as the main loop would, so the buffer never fills up
+        LOG_task(1);
+    }
+}
+
+static void bench_fixed_mul_div(void *context, uint32_t iterations)
+{
+    (void)context;
+    FIXED_Q1616 sum = 0;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        FIXED_Q1616 const a = g_operands[i % CODES];
+        FIXED_Q1616 const b = g_operands[(i + 1) % CODES];
+        sum += FIXED_div(FIXED_mul(a, b), b);
+    }
+    BENCH_consume((uint32_t)sum);
+}
+
+static void bench_fixed_to_string(void *context, uint32_t iterations)
+{
+    (void)context;
+    char text[16];
+    uint32_t state = 1;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        FIXED_Q1616 const value = (FIXED_Q1616)(next_random(&state) >> 8);
+        FIXED_to_string(value, text, sizeof(text));
+        BENCH_consume((uint8_t)text[0]);
+    }
+}
+
+static void bench_format_int32(void *context, uint32_t iterations)
+{
+    (void)context;
+    char text[FORMAT_INT32_SIZE_MAX];
+    uint32_t state = 1;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        // Millivolt-sized values, as in DMM responses
+        int32_t const value = (int32_t)(next_random(&state) >> 16) - 32768;
+        size_t const length = FORMAT_int32(value, text);
+        BENCH_consume((uint8_t)text[length - 1]);
+    }
+}
+
+static void bench_fixed_scale_u16_array(void *context, uint32_t iterations)
+{
+    int32_t const scale = *(int32_t const *)context;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        FIXED_scale_u16_array(g_codes, CODES, scale, g_q16);
+    }
+    BENCH_consume((uint32_t)g_q16[CODES - 1]);
+}
+
+static void
+bench_fixed_scale_u16_array_to_i16(void *context, uint32_t iterations)
+{
+    int32_t const scale = *(int32_t const *)context;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        FIXED_scale_u16_array_to_i16(g_codes, CODES, scale, g_i16);
+    }
+    BENCH_consume((uint16_t)g_i16[CODES - 1]);
+}
+
+static void bench_interleave_correct(void *context, uint32_t iterations)
+{
+    INTERLEAVE_Correction const *correction = context;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        INTERLEAVE_correct(correction, g_codes, CODES, 4095);
+    }
+    BENCH_consume(g_codes[CODES - 1]);
+}
+
+static void bench_fixed_q15_dot(void *context, uint32_t iterations)
+{
+    (void)context;
+    int64_t sum = 0;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        sum += FIXED_q15_dot(g_i16, g_i16, CODES);
+    }
+    BENCH_consume((uint32_t)sum);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t state = 1;
+    for (uint32_t i = 0; i < CODES; ++i) {
+        g_codes[i] = (uint16_t)(next_random(&state) >> 20);
+        g_operands[i] = FIXED_ONE + (FIXED_Q1616)(next_random(&state) >> 12);
+    }
+    for (uint32_t i = 0; i < CHUNK_SIZE; ++i) {
+        g_chunk[i] = (uint8_t)next_random(&state);
+    }
+    for (uint32_t i = 0; i < SAMPLE_CHUNK; ++i) {
+        g_samples[i] = (uint16_t)next_random(&state);
+    }
+    circular_buffer_init(&g_ring, g_ring_data, sizeof(g_ring_data));
+    ring_u16_init(&g_sample_ring, g_sample_ring_data, RING_SIZE);
+
+    LOG_Handle *log = LOG_init();
+    LOG_set_output(discard_output);
+
+    BENCH_init(argc, argv);
+
+    BENCH_run(
+        "circular_buffer_put_get",
+        bench_circular_buffer_put_get,
+        nullptr,
+        1000000
+    );
+    BENCH_run(
+        "circular_buffer_write_read_64",
+        bench_circular_buffer_write_read,
+        nullptr,
+        100000
+    );
+    BENCH_run(
+        "ring_u16_write_read_32",
+        bench_ring_u16_write_read,
+        nullptr,
+        100000
+    );
+    BENCH_run("LOG_write_task", bench_log_write, nullptr, 100000);
+    BENCH_run("FIXED_mul_div", bench_fixed_mul_div, nullptr, 1000000);
+    BENCH_run("FIXED_to_string", bench_fixed_to_string, nullptr, 100000);
+    BENCH_run("FORMAT_int32", bench_format_int32, nullptr, 1000000);
+
+    // 12-bit codes to Q16.16 volts and to millivolts at 3.3 V full scale
+    int32_t const volts_scale = FIXED_code_scale(FIXED_FROM_FLOAT(3.3f), 4095);
+    int32_t const millivolts_scale = FIXED_code_scale(3300, 4095);
+    BENCH_run(
+        "FIXED_scale_u16_array_1024",
+        bench_fixed_scale_u16_array,
+        (void *)&volts_scale,
+        10000
+    );
+    BENCH_run(
+        "FIXED_scale_u16_array_to_i16_1024",
+        bench_fixed_scale_u16_array_to_i16,
+        (void *)&millivolts_scale,
+        10000
+    );
+    BENCH_run("FIXED_q15_dot_1024", bench_fixed_q15_dot, nullptr, 10000);
+
+    // Runs last, as it changes the codes
+    INTERLEAVE_Correction const correction = {
+        .gain = FIXED_ONE - FIXED_ONE / 256,
+        .offset = FIXED_FROM_INT(3),
+    };
+    BENCH_run(
+        "INTERLEAVE_correct_1024",
+        bench_interleave_correct,
+        (void *)&correction,
+        10000
+    );
+
+    LOG_deinit(log);
+    return 0;
+}
@@ -0,0 +1,104 @@
+# Checks the instructions spent in hot functions against a recorded budget
+#
+# Run by the tests that budget_add_test registers, in script mode:
+#   cmake -DVALGRIND=<valgrind> -DCALLGRIND_ANNOTATE=<callgrind_annotate>
+#         -DPROGRAM=<program> -DPROGRAM_ARGS=<a,b> -DFUNCTIONS=<f,g>
+#         -DBUDGET_FILE=<file> -DTOLERANCE=<percent> -DRECORD=<ON|OFF>
+#         -DOUTPUT=<callgrind output> -P check_budget.cmake
+#
+# The program runs under callgrind, and each function is charged the
+# instructions executed in it and in everything it calls (inclusive cost).
+# With RECORD, the counts are written to BUDGET_FILE as the new budget.
+# Otherwise a function fails the check if it takes more than TOLERANCE
+# percent over its budget. The budget file holds "<function> <instructions>"
+# lines; lines starting with # are comments.
+
+foreach(var VALGRIND CALLGRIND_ANNOTATE PROGRAM FUNCTIONS BUDGET_FILE OUTPUT)
+  if(NOT DEFINED ${var})
+    message(FATAL_ERROR "check_budget.cmake needs -D${var}")
+  endif()
+endforeach()
+if(NOT DEFINED TOLERANCE)
+  set(TOLERANCE 2)
+endif()
+string(REPLACE "," ";" PROGRAM_ARGS "${PROGRAM_ARGS}")
+string(REPLACE "," ";" FUNCTIONS "${FUNCTIONS}")
+
+execute_process(
+  COMMAND ${VALGRIND} --tool=callgrind --callgrind-out-file=${OUTPUT}
+    ${PROGRAM} ${PROGRAM_ARGS}
+  RESULT_VARIABLE result
+  OUTPUT_QUIET
+  ERROR_VARIABLE valgrind_log
+)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "${PROGRAM} failed under callgrind:\n${valgrind_log}")
+endif()
+
+execute_process(
+  COMMAND ${CALLGRIND_ANNOTATE} --inclusive=yes --threshold=100 ${OUTPUT}
+  RESULT_VARIABLE result
+  OUTPUT_VARIABLE annotation
+)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "callgrind_annotate failed on ${OUTPUT}")
+endif()
+
+# Inclusive instruction count of each function, from lines such as
+#   1,234,567 (12.34%)  /path/file.c:function [/path/program]
+foreach(function IN LISTS FUNCTIONS)
+  string(REGEX MATCH "([0-9,]+) [^\n]*[ :]${function}( \\[|\n)"
+    line "${annotation}"
+  )
+  if(NOT line)
+    message(FATAL_ERROR
+      "${function} is not in the profile of ${PROGRAM}; was it inlined?"
+    )
+  endif()
+  string(REPLACE "," "" count "${CMAKE_MATCH_1}")
+  set(measured_${function} ${count})
+endforeach()
+
+if(RECORD)
+  set(content "# Instruction budgets, recorded by check_budget.cmake\n")
+  foreach(function IN LISTS FUNCTIONS)
+    string(APPEND content "${function} ${measured_${function}}\n")
+  endforeach()
+  file(WRITE ${BUDGET_FILE} "${content}")
+  message(STATUS "Recorded budgets in ${BUDGET_FILE}")
+  return()
+endif()
+
+if(NOT EXISTS ${BUDGET_FILE})
+  message(FATAL_ERROR
+    "No budget recorded in ${BUDGET_FILE}; configure with "
+    "-DPSLAB_BUDGET_RECORD=ON and run ctest -L budget to record one"
+  )
+endif()
+file(STRINGS ${BUDGET_FILE} entries REGEX "^[^#]")
+foreach(entry IN LISTS entries)
+  if(entry MATCHES "^([A-Za-z_][A-Za-z0-9_]*) +([0-9]+)$")
+    set(budget_${CMAKE_MATCH_1} ${CMAKE_MATCH_2})
+  endif()
+endforeach()
+
+set(failed "")
+foreach(function IN LISTS FUNCTIONS)
+  set(measured ${measured_${function}})
+  if(NOT DEFINED budget_${function})
+    message(STATUS "${function}: ${measured} instructions, no budget")
+    list(APPEND failed ${function})
+    continue()
+  endif()
+  set(budget ${budget_${function}})
+  math(EXPR limit "${budget} + ${budget} * ${TOLERANCE} / 100")
+  message(STATUS "${function}: ${measured} instructions, budget ${budget}")
+  if(measured GREATER limit)
+    list(APPEND failed ${function})
+  endif()
+endforeach()
+
+if(failed)
+  list(JOIN failed ", " failed)
+  message(FATAL_ERROR "Over or without a budget: ${failed}")
+endif()
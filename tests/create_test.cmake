@@ -101,3 +101,54 @@ function(cmock_add_test TEST_TARGET TEST_SRC)
 
   message(CHECK_PASS "Target ${TEST_TARGET} linked with CMock")
 endfunction()
+
+set(_BUDGET_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/check_budget.cmake)
+
+# Creates a test that runs a host program under callgrind and fails if any
+# of the tracked functions spends more instructions than its recorded budget,
+# see check_budget.cmake. Budgets are kept in PSLAB_BUDGET_DIR, one file per
+# test, and re-recorded with PSLAB_BUDGET_RECORD after a deliberate change.
+# arguments:
+#   TEST_NAME   name of the test and of its budget file
+#   TARGET      program to run
+#   ARGS        arguments of the program
+#   FUNCTIONS   functions to track
+# requires: PSLAB_TEST_BUDGETS, valgrind and callgrind_annotate
+function(budget_add_test TEST_NAME TARGET)
+  cmake_parse_arguments(BUDGET "" "" "ARGS;FUNCTIONS" ${ARGN})
+  if(NOT PSLAB_TEST_BUDGETS)
+    return()
+  endif()
+  message(CHECK_START "[TEST] Registering budget test ${TEST_NAME}")
+
+  find_program(VALGRIND_EXECUTABLE valgrind)
+  find_program(CALLGRIND_ANNOTATE_EXECUTABLE callgrind_annotate)
+  if(NOT VALGRIND_EXECUTABLE OR NOT CALLGRIND_ANNOTATE_EXECUTABLE)
+    message(FATAL_ERROR "PSLAB_TEST_BUDGETS needs valgrind")
+  endif()
+
+  # The program becomes part of the default build, for ctest to find it
+  set_property(TARGET ${TARGET} PROPERTY EXCLUDE_FROM_ALL FALSE)
+
+  # Lists are passed comma separated, as add_test splits arguments at ;
+  string(REPLACE ";" "," BUDGET_ARGS "${BUDGET_ARGS}")
+  string(REPLACE ";" "," BUDGET_FUNCTIONS "${BUDGET_FUNCTIONS}")
+
+  add_test(
+    NAME ${TEST_NAME}
+    COMMAND ${CMAKE_COMMAND}
+      -DVALGRIND=${VALGRIND_EXECUTABLE}
+      -DCALLGRIND_ANNOTATE=${CALLGRIND_ANNOTATE_EXECUTABLE}
+      -DPROGRAM=$<TARGET_FILE:${TARGET}>
+      "-DPROGRAM_ARGS=${BUDGET_ARGS}"
+      "-DFUNCTIONS=${BUDGET_FUNCTIONS}"
+      -DBUDGET_FILE=${PSLAB_BUDGET_DIR}/${TEST_NAME}.txt
+      -DTOLERANCE=${PSLAB_BUDGET_TOLERANCE}
+      -DRECORD=${PSLAB_BUDGET_RECORD}
+      -DOUTPUT=${CMAKE_CURRENT_BINARY_DIR}/${TEST_NAME}.callgrind
+      -P ${_BUDGET_SCRIPT}
+  )
+  set_tests_properties(${TEST_NAME} PROPERTIES LABELS budget)
+
+  message(CHECK_PASS "registered target ${TEST_NAME}")
+endfunction()
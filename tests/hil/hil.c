@@ -0,0 +1,501 @@
+/**
+ * @file hil.c
+ * @brief Throughput and latency regression suite against a connected board
+ *
+ * Drives the firmware over its SCPI port and measures what the host side
+ * sees:
+ *
+ * - scpi_latency_*: round trips of *IDN?, as percentiles
+ * - dmm_readings_per_s: DMM:MEASure? in a loop
+ * - dso_fetch_mb_per_s: OSCilloscope:FETCh? of one INT16 capture, repeated
+ * - stream_max_rate_sps: the highest sample rate tried at which
+ *   OSCilloscope:STReam runs without drops, that is without overruns and
+ *   with at least 90% of the samples received, and stream_mb_per_s, the
+ *   data rate received at that sample rate
+ *
+ * Results are printed as a table. With --csv <file> they are also written
+ * as CSV, one metric per line. Each --limit <metric><op><value>, with op
+ * >= or <=, checks a result; the program exits with 1 if a check fails or
+ * a measurement cannot be made, so that a CI job fails on a regression.
+ *
+ * @code
+ * hil_perf --port /dev/ttyACM0 --csv hil.csv \
+ *     --limit dso_fetch_mb_per_s>=0.8 --limit scpi_latency_p99_us<=5000
+ * @endcode
+ *
+ * The DSO input is not used for anything but timing, so the board needs no
+ * signal connected.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+// clock_gettime
+#define _DEFAULT_SOURCE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "port.h"
+
+enum {
+    HIL_LATENCY_SAMPLES = 200, // *IDN? round trips
+    HIL_LIMITS_MAX = 32,
+    HIL_RESULTS_MAX = 16,
+    HIL_STREAM_POINTS = 4096, // Acquisition buffer of the stream test
+    HIL_STREAM_SAMPLE_BYTES = 2, // INT16
+};
+
+// Least share of the sample rate a stream must deliver to count as
+// without drops
+static double const g_stream_share = 0.9;
+
+typedef struct {
+    char name[48];
+    bool at_least; // >= if true, else <=
+    double value;
+} Limit;
+
+typedef struct {
+    char const *name;
+    char const *unit;
+    double value;
+} Result;
+
+static struct {
+    double duration_s; // Length of each sustained measurement
+    Limit limits[HIL_LIMITS_MAX];
+    uint32_t limit_count;
+    Result results[HIL_RESULTS_MAX];
+    uint32_t result_count;
+    bool failed; // A measurement could not be made
+} g_hil = { .duration_s = 2.0 };
+
+// Sample rates tried by the stream test, in ascending order
+static uint32_t const g_stream_rates[] = {
+    10000,  20000,   50000,   100000,  200000,
+    500000, 1000000, 2000000, 5000000,
+};
+
+// Fetched and streamed blocks; larger than any capture
+static uint8_t g_block[1U << 20];
+
+/**
+ * @brief Monotonic time in seconds
+ */
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+static void fail(char const *what)
+{
+    fprintf(stderr, "hil: %s\n", what);
+    g_hil.failed = true;
+}
+
+static void add_result(char const *name, char const *unit, double value)
+{
+    if (g_hil.result_count < HIL_RESULTS_MAX) {
+        g_hil.results[g_hil.result_count++] = (Result){
+            .name = name,
+            .unit = unit,
+            .value = value,
+        };
+    }
+}
+
+static int compare_double(void const *a, void const *b)
+{
+    double const x = *(double const *)a;
+    double const y = *(double const *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Nearest-rank percentile of sorted samples
+ */
+static double percentile(double const *sorted, uint32_t count, uint32_t p)
+{
+    uint32_t rank = (p * count + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+    return sorted[rank - 1];
+}
+
+static void measure_latency(void)
+{
+    static double samples[HIL_LATENCY_SAMPLES];
+    char line[PORT_LINE_MAX];
+
+    for (uint32_t i = 0; i < HIL_LATENCY_SAMPLES; ++i) {
+        double const start = now_s();
+        if (!PORT_query("*IDN?", line, sizeof(line))) {
+            fail("no response to *IDN?");
+            return;
+        }
+        samples[i] = (now_s() - start) * 1e6;
+    }
+    qsort(samples, HIL_LATENCY_SAMPLES, sizeof(samples[0]), compare_double);
+
+    add_result(
+        "scpi_latency_p50_us",
+        "us",
+        percentile(samples, HIL_LATENCY_SAMPLES, 50)
+    );
+    add_result(
+        "scpi_latency_p90_us",
+        "us",
+        percentile(samples, HIL_LATENCY_SAMPLES, 90)
+    );
+    add_result(
+        "scpi_latency_p99_us",
+        "us",
+        percentile(samples, HIL_LATENCY_SAMPLES, 99)
+    );
+    add_result(
+        "scpi_latency_max_us", "us", samples[HIL_LATENCY_SAMPLES - 1]
+    );
+}
+
+static void measure_dmm(void)
+{
+    char line[PORT_LINE_MAX];
+    uint32_t readings = 0;
+
+    double const start = now_s();
+    double elapsed = 0.0;
+    do {
+        if (!PORT_query("DMM:MEASure?", line, sizeof(line))) {
+            fail("no response to DMM:MEASure?");
+            return;
+        }
+        ++readings;
+        elapsed = now_s() - start;
+    } while (elapsed < g_hil.duration_s);
+
+    if (!PORT_no_errors()) {
+        fail("DMM:MEASure? failed");
+        return;
+    }
+    add_result("dmm_readings_per_s", "1/s", readings / elapsed);
+}
+
+/**
+ * @brief Configure a CH1 capture of points samples at a sample rate
+ */
+static bool configure_dso(uint32_t points, uint32_t rate)
+{
+    char command[PORT_LINE_MAX];
+    // The timebase is per division, of ten
+    uint64_t const timebase_us = ((uint64_t)points * 100000U) / rate;
+
+    snprintf(
+        command,
+        sizeof(command),
+        "OSCilloscope:CONFigure:APPLy CH1,%llu,%u",
+        (unsigned long long)(timebase_us > 0 ? timebase_us : 1),
+        (unsigned)points
+    );
+    return PORT_send("OSCilloscope:FORMat INT16") &&
+           PORT_send("OSCilloscope:FORMat:HEADer OFF") && PORT_send(command) &&
+           PORT_no_errors();
+}
+
+static void measure_dso_fetch(void)
+{
+    double points = 0.0;
+
+    if (!PORT_query_double(
+            "OSCilloscope:CONFigure:ACQuire:POINts:MAXimum?", &points
+        ) ||
+        !configure_dso((uint32_t)points, 1000000U)) {
+        fail("cannot configure the DSO");
+        return;
+    }
+
+    double status = 0.0;
+    double const deadline = now_s() + (PORT_TIMEOUT_MS / 1000.0);
+    if (!PORT_send("OSCilloscope:INITiate")) {
+        fail("cannot start a capture");
+        return;
+    }
+    do {
+        if (!PORT_query_double("OSCilloscope:STATus:ACQuisition?", &status)) {
+            fail("no acquisition status");
+            return;
+        }
+    } while (status != 2.0 && now_s() < deadline);
+    if (status != 2.0) {
+        fail("capture did not complete");
+        return;
+    }
+
+    uint64_t bytes = 0;
+    double const start = now_s();
+    double elapsed = 0.0;
+    do {
+        if (!PORT_send("OSCilloscope:FETCh?")) {
+            fail("cannot fetch");
+            return;
+        }
+        long const length = PORT_read_block(g_block, sizeof(g_block));
+        if (length < 0) {
+            fail("OSCilloscope:FETCh? sent no block");
+            return;
+        }
+        bytes += (uint64_t)length;
+        elapsed = now_s() - start;
+    } while (elapsed < g_hil.duration_s);
+
+    add_result("dso_fetch_mb_per_s", "MB/s", (double)bytes / elapsed / 1e6);
+}
+
+/**
+ * @brief Stream at one sample rate
+ *
+ * @param rate Sample rate to try
+ * @param mb_per_s Data rate received
+ * @return Whether the stream ran without overruns
+ */
+static bool stream_at(uint32_t rate, double *mb_per_s)
+{
+    double actual_rate = 0.0;
+    if (!configure_dso(HIL_STREAM_POINTS, rate) ||
+        !PORT_query_double(
+            "OSCilloscope:CONFigure:ACQuire:SRATe?", &actual_rate
+        ) ||
+        !PORT_send("OSCilloscope:STReam:STARt")) {
+        return false;
+    }
+
+    uint64_t bytes = 0;
+    bool ok = true;
+    double const start = now_s();
+    double elapsed = 0.0;
+    do {
+        long const length = PORT_read_block(g_block, sizeof(g_block));
+        if (length < 0) {
+            ok = false;
+            break;
+        }
+        bytes += (uint64_t)length;
+        elapsed = now_s() - start;
+    } while (elapsed < g_hil.duration_s);
+
+    (void)PORT_send("OSCilloscope:STReam:STOP");
+    PORT_drain();
+
+    double overruns = 0.0;
+    if (!PORT_query_double("OSCilloscope:STReam:OVERruns?", &overruns) ||
+        !PORT_no_errors()) {
+        return false;
+    }
+    // A gap the firmware did not count still shows as missing data; the
+    // first block takes half a buffer to fill
+    double const expected =
+        actual_rate * HIL_STREAM_SAMPLE_BYTES * (elapsed * g_stream_share);
+    *mb_per_s = (double)bytes / elapsed / 1e6;
+    return ok && overruns == 0.0 && (double)bytes >= expected;
+}
+
+static void measure_stream(void)
+{
+    uint32_t best_rate = 0;
+    double best_mb_per_s = 0.0;
+
+    for (size_t i = 0; i < sizeof(g_stream_rates) / sizeof(g_stream_rates[0]);
+         ++i) {
+        double mb_per_s = 0.0;
+        if (!stream_at(g_stream_rates[i], &mb_per_s)) {
+            break;
+        }
+        best_rate = g_stream_rates[i];
+        best_mb_per_s = mb_per_s;
+    }
+
+    if (best_rate == 0) {
+        fail("no stream rate ran without drops");
+        return;
+    }
+    add_result("stream_max_rate_sps", "1/s", best_rate);
+    add_result("stream_mb_per_s", "MB/s", best_mb_per_s);
+}
+
+/**
+ * @brief Parse a limit of the form <metric>>=<value> or <metric><=<value>
+ */
+static bool parse_limit(char const *text)
+{
+    if (g_hil.limit_count >= HIL_LIMITS_MAX) {
+        return false;
+    }
+
+    Limit *const limit = &g_hil.limits[g_hil.limit_count];
+    char const *op = strstr(text, ">=");
+    limit->at_least = op != nullptr;
+    if (!op) {
+        op = strstr(text, "<=");
+    }
+    size_t const length = op ? (size_t)(op - text) : 0;
+    if (length == 0 || length >= sizeof(limit->name)) {
+        return false;
+    }
+
+    char *end = nullptr;
+    limit->value = strtod(op + 2, &end);
+    if (end == op + 2 || *end != '\0') {
+        return false;
+    }
+    memcpy(limit->name, text, length);
+    limit->name[length] = '\0';
+    ++g_hil.limit_count;
+    return true;
+}
+
+/**
+ * @brief Check a result against its limits
+ *
+ * @return "pass", "fail" or "" if there is no limit
+ */
+static char const *check(Result const *result)
+{
+    char const *status = "";
+    for (uint32_t i = 0; i < g_hil.limit_count; ++i) {
+        Limit const *const limit = &g_hil.limits[i];
+        if (strcmp(limit->name, result->name) != 0) {
+            continue;
+        }
+        bool const pass = limit->at_least ? result->value >= limit->value
+                                          : result->value <= limit->value;
+        if (!pass) {
+            return "fail";
+        }
+        status = "pass";
+    }
+    return status;
+}
+
+/**
+ * @brief Print the results and write them to the CSV file, if any
+ *
+ * @return Whether every limit passed
+ */
+static bool report(char const *csv_path)
+{
+    FILE *csv = nullptr;
+    bool passed = true;
+
+    if (csv_path) {
+        csv = fopen(csv_path, "w");
+        if (!csv) {
+            perror(csv_path);
+            return false;
+        }
+        fprintf(csv, "metric,value,unit,status\n");
+    }
+
+    printf("%-24s %14s %-6s %s\n", "metric", "value", "unit", "status");
+    for (uint32_t i = 0; i < g_hil.result_count; ++i) {
+        Result const *const result = &g_hil.results[i];
+        char const *const status = check(result);
+        passed = passed && strcmp(status, "fail") != 0;
+        printf(
+            "%-24s %14.3f %-6s %s\n",
+            result->name,
+            result->value,
+            result->unit,
+            status
+        );
+        if (csv) {
+            fprintf(
+                csv,
+                "%s,%.3f,%s,%s\n",
+                result->name,
+                result->value,
+                result->unit,
+                status
+            );
+        }
+    }
+
+    // A limit on a metric that was not measured is a failure too
+    for (uint32_t i = 0; i < g_hil.limit_count; ++i) {
+        bool found = false;
+        for (uint32_t j = 0; j < g_hil.result_count; ++j) {
+            found = found ||
+                    strcmp(g_hil.limits[i].name, g_hil.results[j].name) == 0;
+        }
+        if (!found) {
+            fprintf(stderr, "hil: %s not measured\n", g_hil.limits[i].name);
+            passed = false;
+        }
+    }
+
+    if (csv) {
+        fclose(csv);
+    }
+    return passed;
+}
+
+static void usage(void)
+{
+    fprintf(
+        stderr,
+        "usage: hil_perf --port <path> [--csv <file>] [--duration <s>]\n"
+        "                [--limit <metric>{>=|<=}<value>]...\n"
+    );
+}
+
+int main(int argc, char **argv)
+{
+    char const *port = nullptr;
+    char const *csv_path = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        bool const has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--port") == 0 && has_value) {
+            port = argv[++i];
+        } else if (strcmp(argv[i], "--csv") == 0 && has_value) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--duration") == 0 && has_value) {
+            g_hil.duration_s = strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--limit") == 0 && has_value) {
+            if (!parse_limit(argv[++i])) {
+                fprintf(stderr, "hil: bad limit %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (!port || port[0] == '\0' || g_hil.duration_s <= 0.0) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    if (!PORT_open(port)) {
+        return EXIT_FAILURE;
+    }
+
+    // Start from a known state: no stream, no pending errors
+    (void)PORT_send("OSCilloscope:STReam:STOP");
+    (void)PORT_send("*CLS");
+    PORT_drain();
+
+    measure_latency();
+    measure_dmm();
+    measure_dso_fetch();
+    measure_stream();
+
+    bool const passed = report(csv_path);
+    PORT_close();
+    return passed && !g_hil.failed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
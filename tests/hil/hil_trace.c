@@ -0,0 +1,502 @@
+/**
+ * @file hil_trace.c
+ * @brief Read the event trace of a connected board into a timeline
+ *
+ * Reads the records of the firmware's event trace (see system/trace.h)
+ * with SYSTem:TRACe? and writes them in the Trace Event Format, which
+ * chrome://tracing and https://ui.perfetto.dev display as a timeline:
+ *
+ * - The main loop tasks and the USB service interrupt are spans, each on
+ *   a track of its own
+ * - DMA and UART interrupts are instants, with the event argument
+ * - Each boot traced is a process of its own, since the cycle counter
+ *   restarts at reset; lost records are marked with an instant
+ *
+ * By default the records kept on the board are dumped, for instance after
+ * a crash and reset, with tracing stopped meanwhile so that reading does
+ * not push out the oldest records. With --follow <s>, reading goes on
+ * for that long instead, picking up new records live.
+ *
+ * With --swo <file>, records are taken from a capture of the SWO pin
+ * instead, as streamed with SYSTem:TRACe:ITM ON (see system.h). Such a
+ * capture has no cycle counter frequency, so it is given with
+ * --frequency, 250 MHz by default, and it has no sequence numbers, so
+ * records dropped on the board go unnoticed. Log text on ITM port 0 is
+ * copied to standard output.
+ *
+ * @code
+ * hil_trace --port /dev/ttyACM0 --output trace.json
+ * hil_trace --port /dev/ttyACM0 --follow 10 --output live.json
+ * hil_trace --swo swo.bin --output swo.json
+ * @endcode
+ *
+ * Timestamps are unwrapped from the 32-bit cycle counter by assuming that
+ * consecutive records are less than one wrap apart, about 17 s at
+ * 250 MHz; the main loop tasks record far more often than that.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+// clock_gettime, nanosleep
+#define _DEFAULT_SOURCE
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "system/trace.h"
+
+#include "port.h"
+
+enum {
+    TRACE_HEADER_WORDS = 3, // First, next sequence number and frequency
+    TRACE_POLL_MS = 50, // Pause between live reads that found nothing
+    ITM_LOG_PORT = 0, // Log text, see SYSTEM_LOG_SINK_ITM
+};
+
+// Core clock of records from an SWO capture, unless given
+static uint32_t const g_default_frequency = 250000000;
+
+// Tracks of the timeline, one per context
+typedef enum {
+    TRACK_MAIN,
+    TRACK_USB,
+    TRACK_DSO,
+    TRACK_UART,
+    TRACK_COUNT,
+} Track;
+
+static char const *const g_track_names[TRACK_COUNT] = {
+    [TRACK_MAIN] = "Main loop",
+    [TRACK_USB] = "USB interrupt",
+    [TRACK_DSO] = "DSO DMA interrupt",
+    [TRACK_UART] = "UART interrupts",
+};
+
+// How each event is laid out
+typedef struct {
+    char const *name;
+    char phase; // B(egin), E(nd) or i(nstant)
+    Track track;
+} EventInfo;
+
+static EventInfo const g_events[TRACE_EVENT_COUNT] = {
+    [TRACE_EVENT_BOOT] = { "Boot", 'i', TRACK_MAIN },
+    [TRACE_EVENT_PROTOCOL_BEGIN] = { "protocol_task", 'B', TRACK_MAIN },
+    [TRACE_EVENT_PROTOCOL_END] = { "protocol_task", 'E', TRACK_MAIN },
+    [TRACE_EVENT_LOG_BEGIN] = { "LOG_task", 'B', TRACK_MAIN },
+    [TRACE_EVENT_LOG_END] = { "LOG_task", 'E', TRACK_MAIN },
+    [TRACE_EVENT_USB_ISR_BEGIN] = { "USB service", 'B', TRACK_USB },
+    [TRACE_EVENT_USB_ISR_END] = { "USB service", 'E', TRACK_USB },
+    [TRACE_EVENT_DSO_DMA_HALF] = { "DMA half", 'i', TRACK_DSO },
+    [TRACE_EVENT_DSO_DMA_COMPLETE] = { "DMA complete", 'i', TRACK_DSO },
+    [TRACE_EVENT_UART_TX_COMPLETE] = { "TX complete", 'i', TRACK_UART },
+    [TRACE_EVENT_UART_RX_COMPLETE] = { "RX complete", 'i', TRACK_UART },
+    [TRACE_EVENT_UART_RX_IDLE] = { "RX idle", 'i', TRACK_UART },
+    [TRACE_EVENT_UART_RX_TIMEOUT] = { "RX timeout", 'i', TRACK_UART },
+};
+
+static_assert(sizeof(TRACE_Record) == 8, "TRACE_Record must be 8 bytes");
+
+static struct {
+    FILE *out;
+    bool first_event; // Nothing written after the opening bracket yet
+    uint32_t frequency; // Cycle counter rate from the block header
+    uint32_t boot; // Process of the current boot, 0 before the first
+    uint64_t cycles; // Unwrapped time of the last record
+    uint32_t last_cycles; // Cycle counter of the last record
+    uint64_t records;
+    uint64_t lost;
+} g_trace = { .first_event = true };
+
+// Blocks as sent by SYSTem:TRACe?, far larger than one can be
+static uint8_t g_block[1U << 16];
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+static void sleep_ms(long ms)
+{
+    struct timespec const ts = {
+        .tv_sec = ms / 1000,
+        .tv_nsec = (ms % 1000) * 1000000L,
+    };
+    (void)nanosleep(&ts, nullptr);
+}
+
+static uint32_t read_u32(uint8_t const *data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+           ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void begin_event(void)
+{
+    fputs(g_trace.first_event ? "\n" : ",\n", g_trace.out);
+    g_trace.first_event = false;
+}
+
+/**
+ * @brief Name the process of a boot and its tracks
+ */
+static void write_boot(uint32_t boot)
+{
+    begin_event();
+    fprintf(
+        g_trace.out,
+        "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%u,"
+        "\"args\":{\"name\":\"Boot %u\"}}",
+        boot,
+        boot
+    );
+    for (uint32_t track = 0; track < TRACK_COUNT; ++track) {
+        begin_event();
+        fprintf(
+            g_trace.out,
+            "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%u,\"tid\":%u,"
+            "\"args\":{\"name\":\"%s\"}}",
+            boot,
+            track,
+            g_track_names[track]
+        );
+    }
+}
+
+static double timestamp_us(void)
+{
+    return (double)g_trace.cycles * 1e6 / (double)g_trace.frequency;
+}
+
+static void write_lost(uint32_t count)
+{
+    g_trace.lost += count;
+    if (g_trace.boot == 0) {
+        return;
+    }
+    begin_event();
+    fprintf(
+        g_trace.out,
+        "{\"ph\":\"i\",\"s\":\"p\",\"name\":\"%u records lost\","
+        "\"pid\":%u,\"tid\":%u,\"ts\":%.3f}",
+        count,
+        g_trace.boot,
+        (unsigned)TRACK_MAIN,
+        timestamp_us()
+    );
+}
+
+static void write_record(TRACE_Record const *record)
+{
+    if (record->event == TRACE_EVENT_BOOT) {
+        // The cycle counter restarts with each boot
+        g_trace.boot = record->arg != 0 ? record->arg : g_trace.boot + 1;
+        g_trace.cycles = record->cycles;
+        write_boot(g_trace.boot);
+    } else if (g_trace.boot == 0) {
+        // Records of a boot whose start is no longer kept
+        g_trace.boot = 1;
+        g_trace.cycles = record->cycles;
+        write_boot(g_trace.boot);
+    } else {
+        g_trace.cycles += (uint32_t)(record->cycles - g_trace.last_cycles);
+    }
+    g_trace.last_cycles = record->cycles;
+    ++g_trace.records;
+
+    if (record->event >= TRACE_EVENT_COUNT) {
+        return;
+    }
+    EventInfo const *const info = &g_events[record->event];
+    begin_event();
+    fprintf(
+        g_trace.out,
+        "{\"ph\":\"%c\",%s\"name\":\"%s\",\"pid\":%u,\"tid\":%u,"
+        "\"ts\":%.3f,\"args\":{\"arg\":%u}}",
+        info->phase,
+        info->phase == 'i' ? "\"s\":\"t\"," : "",
+        info->name,
+        g_trace.boot,
+        (unsigned)info->track,
+        timestamp_us(),
+        (unsigned)record->arg
+    );
+}
+
+/**
+ * @brief Read one block of records and write it out
+ *
+ * @param[in,out] sequence Sequence number of the next record to read
+ * @param started Whether sequence is valid, rather than to start at the
+ *                oldest record kept
+ * @param[out] next Sequence number the board's next record will get
+ * @return Records read, or -1 on error
+ */
+static long read_records(uint32_t *sequence, bool started, uint32_t *next)
+{
+    char command[64];
+
+    if (started) {
+        snprintf(command, sizeof(command), "SYSTem:TRACe? %u", *sequence);
+    } else {
+        snprintf(command, sizeof(command), "SYSTem:TRACe?");
+    }
+    if (!PORT_send(command)) {
+        return -1;
+    }
+    long const length = PORT_read_block(g_block, sizeof(g_block));
+    if (length < (long)(TRACE_HEADER_WORDS * sizeof(uint32_t))) {
+        fprintf(stderr, "hil_trace: SYSTem:TRACe? sent no records\n");
+        return -1;
+    }
+
+    uint32_t const first = read_u32(&g_block[0]);
+    *next = read_u32(&g_block[4]);
+    g_trace.frequency = read_u32(&g_block[8]);
+    if (g_trace.frequency == 0) {
+        fprintf(stderr, "hil_trace: no cycle counter frequency\n");
+        return -1;
+    }
+    if (started && first != *sequence) {
+        write_lost(first - *sequence);
+    }
+
+    size_t const header = TRACE_HEADER_WORDS * sizeof(uint32_t);
+    long const count = (long)(((size_t)length - header) / sizeof(TRACE_Record));
+    for (long i = 0; i < count; ++i) {
+        TRACE_Record record;
+        memcpy(
+            &record,
+            &g_block[header + ((size_t)i * sizeof(TRACE_Record))],
+            sizeof(record)
+        );
+        write_record(&record);
+    }
+    *sequence = first + (uint32_t)count;
+    return count;
+}
+
+/**
+ * @brief Read the records kept, up to those recorded when reading started
+ */
+static bool dump(void)
+{
+    uint32_t sequence = 0;
+    uint32_t next = 0;
+    uint32_t end = 0;
+    bool started = false;
+
+    do {
+        long const count = read_records(&sequence, started, &next);
+        if (count < 0) {
+            return false;
+        }
+        if (!started) {
+            end = next;
+            started = true;
+        }
+        if (count == 0) {
+            break;
+        }
+    } while ((int32_t)(end - sequence) > 0);
+    return true;
+}
+
+/**
+ * @brief Read new records for a while
+ */
+static bool follow(double duration_s)
+{
+    uint32_t sequence = 0;
+    uint32_t next = 0;
+    bool started = false;
+    double const deadline = now_s() + duration_s;
+
+    while (now_s() < deadline) {
+        long const count = read_records(&sequence, started, &next);
+        if (count < 0) {
+            return false;
+        }
+        started = true;
+        if (sequence == next) {
+            sleep_ms(TRACE_POLL_MS);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Handle the payload of an ITM software source packet
+ */
+static void swo_payload(uint32_t port, uint32_t value, uint32_t size)
+{
+    // Event word waiting for its cycles word
+    static bool pending = false;
+    static uint32_t event_word = 0;
+
+    if (port == ITM_LOG_PORT) {
+        for (uint32_t i = 0; i < size; ++i) {
+            putchar((int)((value >> (8 * i)) & 0xFF));
+        }
+    } else if (port == TRACE_ITM_PORT_EVENT && size == sizeof(uint32_t)) {
+        event_word = value;
+        pending = true;
+    } else if (port == TRACE_ITM_PORT_CYCLES && size == sizeof(uint32_t)) {
+        // A cycles word without its event word starts a capture
+        if (pending) {
+            TRACE_Record const record = {
+                .cycles = value,
+                .event = (uint16_t)event_word,
+                .arg = (uint16_t)(event_word >> 16),
+            };
+            write_record(&record);
+        }
+        pending = false;
+    }
+}
+
+/**
+ * @brief Decode the ITM packets of an SWO capture
+ *
+ * Software source packets have a header of (port << 3) | size code, size
+ * code 1, 2 or 3 for 1, 2 or 4 bytes. Hardware source packets, with bit 2
+ * set, are skipped, as are synchronization, overflow and timestamp
+ * packets, whose headers have a size code of 0.
+ */
+static bool convert_swo(char const *path)
+{
+    FILE *const file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+
+    int header = 0;
+    while ((header = fgetc(file)) != EOF) {
+        uint32_t const size_code = (uint32_t)header & 0x03;
+        if (size_code == 0) {
+            // Sync bytes are 0; others may have continuation bytes
+            int byte = header;
+            while (byte != EOF && (byte & 0x80)) {
+                byte = fgetc(file);
+            }
+            continue;
+        }
+
+        uint32_t const size = size_code == 3 ? 4 : size_code;
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < size; ++i) {
+            int const byte = fgetc(file);
+            if (byte == EOF) {
+                break;
+            }
+            value |= (uint32_t)byte << (8 * i);
+        }
+        if (!(header & 0x04)) {
+            swo_payload((uint32_t)header >> 3, value, size);
+        }
+    }
+    fflush(stdout);
+    fclose(file);
+    return true;
+}
+
+static void usage(void)
+{
+    fprintf(
+        stderr,
+        "usage: hil_trace --port <path> [--output <file>] [--follow <s>]\n"
+        "       hil_trace --swo <file> [--output <file>] [--frequency <Hz>]\n"
+    );
+}
+
+int main(int argc, char **argv)
+{
+    char const *port = nullptr;
+    char const *swo = nullptr;
+    char const *output = "trace.json";
+    double follow_s = 0.0;
+    uint32_t frequency = g_default_frequency;
+
+    for (int i = 1; i < argc; ++i) {
+        bool const has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--port") == 0 && has_value) {
+            port = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && has_value) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--follow") == 0 && has_value) {
+            follow_s = strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--swo") == 0 && has_value) {
+            swo = argv[++i];
+        } else if (strcmp(argv[i], "--frequency") == 0 && has_value) {
+            frequency = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if ((!port || port[0] == '\0') == (swo == nullptr) || follow_s < 0.0 ||
+        frequency == 0) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    g_trace.out = fopen(output, "w");
+    if (!g_trace.out) {
+        perror(output);
+        return EXIT_FAILURE;
+    }
+
+    if (swo) {
+        g_trace.frequency = frequency;
+        fputs("[", g_trace.out);
+        bool const ok = convert_swo(swo);
+        fputs("\n]\n", g_trace.out);
+        fclose(g_trace.out);
+        fprintf(
+            stderr,
+            "hil_trace: %llu records written to %s\n",
+            (unsigned long long)g_trace.records,
+            output
+        );
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (!PORT_open(port)) {
+        fclose(g_trace.out);
+        return EXIT_FAILURE;
+    }
+
+    (void)PORT_send("*CLS");
+    PORT_drain();
+
+    fputs("[", g_trace.out);
+    bool ok = false;
+    if (follow_s > 0.0) {
+        ok = PORT_send("SYSTem:TRACe:STATe ON") && follow(follow_s);
+    } else {
+        // Keep the oldest records from being pushed out while reading
+        ok = PORT_send("SYSTem:TRACe:STATe OFF") && dump();
+        (void)PORT_send("SYSTem:TRACe:STATe ON");
+    }
+    fputs("\n]\n", g_trace.out);
+    ok = ok && PORT_no_errors();
+
+    fclose(g_trace.out);
+    PORT_close();
+    fprintf(
+        stderr,
+        "hil_trace: %llu records, %llu lost, written to %s\n",
+        (unsigned long long)g_trace.records,
+        (unsigned long long)g_trace.lost,
+        output
+    );
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,178 @@
+/**
+ * @file port.c
+ * @brief SCPI port of a connected board, for the host tools in tests/hil
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+// cfmakeraw
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "port.h"
+
+static int g_fd = -1;
+
+bool PORT_open(char const *path)
+{
+    g_fd = open(path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (g_fd < 0) {
+        perror(path);
+        return false;
+    }
+
+    struct termios settings;
+    if (tcgetattr(g_fd, &settings) == 0) {
+        cfmakeraw(&settings);
+        (void)tcsetattr(g_fd, TCSANOW, &settings);
+    }
+    (void)tcflush(g_fd, TCIOFLUSH);
+    return true;
+}
+
+void PORT_close(void)
+{
+    if (g_fd >= 0) {
+        close(g_fd);
+        g_fd = -1;
+    }
+}
+
+ssize_t PORT_read_some(uint8_t *data, size_t size, int timeout_ms)
+{
+    struct pollfd pfd = { .fd = g_fd, .events = POLLIN };
+
+    int const ready = poll(&pfd, 1, timeout_ms);
+    if (ready <= 0) {
+        return ready;
+    }
+    ssize_t const count = read(g_fd, data, size);
+    if (count < 0 && errno == EAGAIN) {
+        return 0;
+    }
+    return count;
+}
+
+bool PORT_read_exact(uint8_t *data, size_t size)
+{
+    size_t done = 0;
+    while (done < size) {
+        ssize_t const count =
+            PORT_read_some(&data[done], size - done, PORT_TIMEOUT_MS);
+        if (count <= 0) {
+            return false;
+        }
+        done += (size_t)count;
+    }
+    return true;
+}
+
+bool PORT_send(char const *command)
+{
+    size_t const length = strlen(command);
+    if (write(g_fd, command, length) != (ssize_t)length ||
+        write(g_fd, "\n", 1) != 1) {
+        return false;
+    }
+    return true;
+}
+
+bool PORT_read_line(char *line, size_t size)
+{
+    size_t length = 0;
+    for (;;) {
+        uint8_t byte = 0;
+        if (!PORT_read_exact(&byte, 1)) {
+            return false;
+        }
+        if (byte == '\n') {
+            break;
+        }
+        if (byte != '\r' && length + 1 < size) {
+            line[length++] = (char)byte;
+        }
+    }
+    line[length] = '\0';
+    return true;
+}
+
+bool PORT_query(char const *command, char *line, size_t size)
+{
+    return PORT_send(command) && PORT_read_line(line, size);
+}
+
+bool PORT_query_double(char const *command, double *value)
+{
+    char line[PORT_LINE_MAX];
+    char *end = nullptr;
+
+    if (!PORT_query(command, line, sizeof(line))) {
+        return false;
+    }
+    *value = strtod(line, &end);
+    return end != line;
+}
+
+long PORT_read_block(uint8_t *data, size_t size)
+{
+    uint8_t header[12] = { 0 };
+
+    if (!PORT_read_exact(header, 2) || header[0] != '#' || header[1] < '1' ||
+        header[1] > '9') {
+        return -1;
+    }
+    size_t const digits = header[1] - '0';
+    if (!PORT_read_exact(&header[2], digits)) {
+        return -1;
+    }
+    header[2 + digits] = '\0';
+    size_t const length = strtoul((char const *)&header[2], nullptr, 10);
+    if (length > size || !PORT_read_exact(data, length)) {
+        return -1;
+    }
+
+    uint8_t line_end[2];
+    if (!PORT_read_exact(line_end, 1)) {
+        return -1;
+    }
+    if (line_end[0] == '\r' && !PORT_read_exact(&line_end[1], 1)) {
+        return -1;
+    }
+    return (long)length;
+}
+
+void PORT_drain(void)
+{
+    uint8_t scratch[4096];
+    while (PORT_read_some(scratch, sizeof(scratch), PORT_QUIET_MS) > 0) {
+    }
+}
+
+bool PORT_no_errors(void)
+{
+    char line[PORT_LINE_MAX];
+    bool clean = true;
+
+    for (int i = 0; i < 16; ++i) {
+        if (!PORT_query("SYSTem:ERRor?", line, sizeof(line))) {
+            return false;
+        }
+        if (strtol(line, nullptr, 10) == 0) {
+            return clean;
+        }
+        fprintf(stderr, "firmware error %s\n", line);
+        clean = false;
+    }
+    return false;
+}
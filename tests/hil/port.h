@@ -0,0 +1,94 @@
+/**
+ * @file port.h
+ * @brief SCPI port of a connected board, for the host tools in tests/hil
+ *
+ * One port is open at a time. Reads wait at most PORT_TIMEOUT_MS for data,
+ * so that a board that stops responding fails a tool instead of hanging
+ * it.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#ifndef PSLAB_HIL_PORT_H
+#define PSLAB_HIL_PORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+enum {
+    PORT_TIMEOUT_MS = 2000, // Longest wait for a response
+    PORT_QUIET_MS = 200, // Silence that ends a drained stream
+    PORT_LINE_MAX = 256, // Longest text response
+};
+
+/**
+ * @brief Open the port raw, as the firmware's SCPI port expects
+ *
+ * @param path Device file of the port
+ * @return Whether the port could be opened; an error is printed otherwise
+ */
+bool PORT_open(char const *path);
+
+/**
+ * @brief Close the port
+ */
+void PORT_close(void);
+
+/**
+ * @brief Read some bytes, waiting at most timeout_ms for the first
+ *
+ * @return Bytes read, 0 on timeout, -1 on error
+ */
+ssize_t PORT_read_some(uint8_t *data, size_t size, int timeout_ms);
+
+/**
+ * @brief Read exactly size bytes
+ */
+bool PORT_read_exact(uint8_t *data, size_t size);
+
+/**
+ * @brief Send a command, terminated with a line feed
+ */
+bool PORT_send(char const *command);
+
+/**
+ * @brief Read a text response up to its line ending
+ *
+ * Longer responses are truncated to size - 1 characters.
+ */
+bool PORT_read_line(char *line, size_t size);
+
+/**
+ * @brief Send a command and read its text response
+ */
+bool PORT_query(char const *command, char *line, size_t size);
+
+/**
+ * @brief Send a command and parse its response as a number
+ */
+bool PORT_query_double(char const *command, double *value);
+
+/**
+ * @brief Read a definite-length arbitrary block and its line ending
+ *
+ * @return Bytes of data, or -1 if the response is not a block or does not
+ *         fit in size bytes
+ */
+long PORT_read_block(uint8_t *data, size_t size);
+
+/**
+ * @brief Discard input until the port has been quiet for PORT_QUIET_MS
+ */
+void PORT_drain(void);
+
+/**
+ * @brief Whether the firmware's error queue is empty; empties it
+ *
+ * Errors found are printed.
+ */
+bool PORT_no_errors(void);
+
+#endif // PSLAB_HIL_PORT_H
@@ -0,0 +1,93 @@
+/**
+ * @file test_arena.c
+ * @brief Unit tests for the static memory arena
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "util/arena.h"
+
+static uint8_t g_memory[4 * ARENA_ALIGN] __attribute__((aligned(ARENA_ALIGN)));
+static Arena g_arena;
+
+void setUp(void) { ARENA_init(&g_arena, g_memory, sizeof(g_memory)); }
+
+void tearDown(void) {}
+
+void test_ARENA_alloc_aligns_blocks(void)
+{
+    uint8_t *const first = ARENA_alloc(&g_arena, 1);
+    uint8_t *const second = ARENA_alloc(&g_arena, ARENA_ALIGN + 1);
+
+    TEST_ASSERT_EQUAL_PTR(g_memory, first);
+    TEST_ASSERT_EQUAL_PTR(&g_memory[ARENA_ALIGN], second);
+    TEST_ASSERT_EQUAL_UINT32(ARENA_ALIGN, ARENA_available(&g_arena));
+}
+
+void test_ARENA_alloc_fails_when_full(void)
+{
+    TEST_ASSERT_NULL(ARENA_alloc(&g_arena, sizeof(g_memory) + 1));
+    TEST_ASSERT_NULL(ARENA_alloc(&g_arena, 0));
+
+    TEST_ASSERT_NOT_NULL(ARENA_alloc(&g_arena, sizeof(g_memory)));
+    TEST_ASSERT_NULL(ARENA_alloc(&g_arena, 1));
+    TEST_ASSERT_EQUAL_UINT32(0, ARENA_available(&g_arena));
+}
+
+void test_ARENA_release_frees_later_blocks(void)
+{
+    uint8_t *const first = ARENA_alloc(&g_arena, ARENA_ALIGN);
+    uint8_t *const second = ARENA_alloc(&g_arena, ARENA_ALIGN);
+    (void)ARENA_alloc(&g_arena, ARENA_ALIGN);
+
+    ARENA_release(&g_arena, second);
+    TEST_ASSERT_EQUAL_UINT32(3 * ARENA_ALIGN, ARENA_available(&g_arena));
+    TEST_ASSERT_EQUAL_PTR(second, ARENA_alloc(&g_arena, 2 * ARENA_ALIGN));
+
+    // Blocks that were already released, and nullptr, are ignored
+    ARENA_release(&g_arena, first);
+    ARENA_release(&g_arena, second);
+    ARENA_release(&g_arena, nullptr);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(g_memory), ARENA_available(&g_arena));
+}
+
+void test_ARENA_reset(void)
+{
+    (void)ARENA_alloc(&g_arena, 3 * ARENA_ALIGN);
+    ARENA_reset(&g_arena);
+
+    TEST_ASSERT_EQUAL_UINT32(sizeof(g_memory), ARENA_available(&g_arena));
+    TEST_ASSERT_EQUAL_PTR(g_memory, ARENA_alloc(&g_arena, 1));
+}
+
+void test_ARENA_init_skips_unaligned_start(void)
+{
+    ARENA_init(&g_arena, &g_memory[1], sizeof(g_memory) - 1);
+
+    TEST_ASSERT_EQUAL_PTR(&g_memory[ARENA_ALIGN], ARENA_alloc(&g_arena, 1));
+    TEST_ASSERT_EQUAL_UINT32(2 * ARENA_ALIGN, ARENA_available(&g_arena));
+
+    // Too small to hold a single aligned byte
+    ARENA_init(&g_arena, &g_memory[1], ARENA_ALIGN - 2);
+    TEST_ASSERT_NULL(ARENA_alloc(&g_arena, 1));
+}
+
+void test_ARENA_peak_survives_release(void)
+{
+    uint8_t *const first = ARENA_alloc(&g_arena, ARENA_ALIGN);
+    (void)ARENA_alloc(&g_arena, 2 * ARENA_ALIGN + 1);
+
+    ARENA_release(&g_arena, first);
+    (void)ARENA_alloc(&g_arena, ARENA_ALIGN);
+
+    TEST_ASSERT_EQUAL_UINT32(ARENA_ALIGN, g_arena.used);
+    TEST_ASSERT_EQUAL_UINT32(4 * ARENA_ALIGN, g_arena.peak);
+
+    ARENA_reset(&g_arena);
+    TEST_ASSERT_EQUAL_UINT32(4 * ARENA_ALIGN, g_arena.peak);
+}
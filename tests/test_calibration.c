@@ -0,0 +1,223 @@
+/**
+ * @file test_calibration.c
+ * @brief Unit tests for the channel calibration table
+ *
+ * The storage sector is replaced by a RAM array behind the mocked flash
+ * driver, so that saved tables can be loaded back.
+ *
+ * @author PSLab Team
+ * @date 2025-09-02
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_flash_ll.h"
+
+#include "util/error.h"
+#include "util/fixed_point.h"
+
+#include "calibration.h"
+
+static uint8_t g_storage[FLASH_LL_STORAGE_SIZE];
+
+static void storage_read_stub(
+    uint32_t offset,
+    void *data,
+    uint32_t size,
+    int cmock_num_calls
+)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(sizeof(g_storage), offset + size);
+    memcpy(data, &g_storage[offset], size);
+}
+
+static void storage_erase_stub(int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    memset(g_storage, 0xFF, sizeof(g_storage));
+}
+
+static void storage_write_stub(
+    uint32_t offset,
+    void const *data,
+    uint32_t size,
+    int cmock_num_calls
+)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_EQUAL_UINT32(0, offset % FLASH_LL_WRITE_ALIGN);
+    TEST_ASSERT_EQUAL_UINT32(0, size % FLASH_LL_WRITE_ALIGN);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(sizeof(g_storage), offset + size);
+    memcpy(&g_storage[offset], data, size);
+}
+
+void setUp(void)
+{
+    mock_flash_ll_Init();
+    memset(g_storage, 0xFF, sizeof(g_storage));
+    FLASH_LL_read_Stub(storage_read_stub);
+    FLASH_LL_erase_Stub(storage_erase_stub);
+    FLASH_LL_write_Stub(storage_write_stub);
+    CALIBRATION_clear();
+}
+
+void tearDown(void)
+{
+    mock_flash_ll_Verify();
+    mock_flash_ll_Destroy();
+}
+
+static void assert_identity(CALIBRATION_Entry const *entry)
+{
+    TEST_ASSERT_EQUAL_INT32(FIXED_ONE, entry->gain);
+    TEST_ASSERT_EQUAL_INT32(0, entry->offset);
+}
+
+// Test: An erased sector loads as the identity correction
+void test_CALIBRATION_load_erased(void)
+{
+    CALIBRATION_Entry const entry = {
+        .gain = FIXED_from_fraction(99, 100),
+        .offset = FIXED_from_fraction(1, 100),
+    };
+    CALIBRATION_set(CALIBRATION_MODE_DMM, 1, &entry);
+
+    TEST_ASSERT_FALSE(CALIBRATION_load());
+
+    for (uint32_t ch = 0; ch < CALIBRATION_CHANNEL_COUNT; ++ch) {
+        CALIBRATION_Entry const loaded =
+            CALIBRATION_get(CALIBRATION_MODE_DMM, ch);
+        assert_identity(&loaded);
+    }
+}
+
+// Test: A saved table is loaded back unchanged
+void test_CALIBRATION_save_and_load(void)
+{
+    CALIBRATION_Entry const entry = {
+        .gain = FIXED_from_fraction(1001, 1000),
+        .offset = FIXED_from_fraction(-12, 1000),
+    };
+    CALIBRATION_set(CALIBRATION_MODE_DMM, 5, &entry);
+    CALIBRATION_save();
+
+    CALIBRATION_clear();
+    TEST_ASSERT_TRUE(CALIBRATION_load());
+
+    CALIBRATION_Entry const loaded = CALIBRATION_get(CALIBRATION_MODE_DMM, 5);
+    TEST_ASSERT_EQUAL_INT32(entry.gain, loaded.gain);
+    TEST_ASSERT_EQUAL_INT32(entry.offset, loaded.offset);
+
+    CALIBRATION_Entry const other = CALIBRATION_get(CALIBRATION_MODE_DMM, 4);
+    assert_identity(&other);
+}
+
+// Test: A corrupted table is rejected
+void test_CALIBRATION_load_corrupt(void)
+{
+    CALIBRATION_Entry const entry = {
+        .gain = FIXED_from_fraction(1001, 1000),
+        .offset = 0,
+    };
+    CALIBRATION_set(CALIBRATION_MODE_DMM, 0, &entry);
+    CALIBRATION_save();
+
+    // Flip a bit in the first entry
+    g_storage[8] ^= 0x01;
+
+    TEST_ASSERT_FALSE(CALIBRATION_load());
+    CALIBRATION_Entry const loaded = CALIBRATION_get(CALIBRATION_MODE_DMM, 0);
+    assert_identity(&loaded);
+}
+
+// Test: A failed erase is reported
+void test_CALIBRATION_save_erase_failure(void)
+{
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    FLASH_LL_erase_Stub(NULL);
+    FLASH_LL_erase_ExpectAndThrow(ERROR_HARDWARE_FAULT);
+
+    TRY {
+        CALIBRATION_save();
+        TEST_FAIL_MESSAGE("Expected exception for erase failure");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_HARDWARE_FAULT, exception);
+    }
+}
+
+// Helper expecting CALIBRATION_set to reject its arguments
+static void assert_set_rejected(
+    CALIBRATION_Mode mode,
+    uint32_t channel,
+    CALIBRATION_Entry const *entry
+)
+{
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    TRY {
+        CALIBRATION_set(mode, channel, entry);
+        TEST_FAIL_MESSAGE("Expected exception for invalid calibration");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+}
+
+// Test: Entries outside the accepted range are rejected
+void test_CALIBRATION_set_invalid(void)
+{
+    CALIBRATION_Entry const valid = CALIBRATION_ENTRY_IDENTITY;
+    CALIBRATION_Entry const invalid[] = {
+        { .gain = 0, .offset = 0 },
+        { .gain = -FIXED_ONE, .offset = 0 },
+        { .gain = CALIBRATION_GAIN_MAX + 1, .offset = 0 },
+        { .gain = FIXED_ONE, .offset = CALIBRATION_OFFSET_MAX + 1 },
+        { .gain = FIXED_ONE, .offset = -CALIBRATION_OFFSET_MAX - 1 },
+    };
+    uint32_t const count = sizeof(invalid) / sizeof(invalid[0]);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        assert_set_rejected(CALIBRATION_MODE_DMM, 0, &invalid[i]);
+    }
+    assert_set_rejected(
+        CALIBRATION_MODE_DMM, CALIBRATION_CHANNEL_COUNT, &valid
+    );
+    assert_set_rejected(CALIBRATION_MODE_COUNT, 0, &valid);
+    assert_set_rejected(CALIBRATION_MODE_DMM, 0, NULL);
+
+    // Rejected entries leave the table unchanged
+    CALIBRATION_Entry const entry = CALIBRATION_get(CALIBRATION_MODE_DMM, 0);
+    assert_identity(&entry);
+}
+
+// Test: Corrections scale, then shift
+void test_CALIBRATION_apply(void)
+{
+    CALIBRATION_Entry const identity = CALIBRATION_ENTRY_IDENTITY;
+    CALIBRATION_Entry const entry = {
+        .gain = FIXED_from_fraction(3, 2),
+        .offset = FIXED_from_fraction(-1, 4),
+    };
+
+    TEST_ASSERT_EQUAL_INT32(
+        FIXED_FROM_INT(2), CALIBRATION_apply(&identity, FIXED_FROM_INT(2))
+    );
+    TEST_ASSERT_EQUAL_INT32(
+        FIXED_from_fraction(11, 4),
+        CALIBRATION_apply(&entry, FIXED_FROM_INT(2))
+    );
+
+    // Results saturate instead of wrapping around
+    CALIBRATION_Entry const boost = {
+        .gain = CALIBRATION_GAIN_MAX,
+        .offset = CALIBRATION_OFFSET_MAX,
+    };
+    TEST_ASSERT_EQUAL_INT32(
+        FIXED_MAX, CALIBRATION_apply(&boost, FIXED_FROM_INT(20000))
+    );
+}
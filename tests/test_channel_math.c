@@ -0,0 +1,117 @@
+/**
+ * @file test_channel_math.c
+ * @brief Unit tests for the math channel of dual-channel records
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "util/channel_math.h"
+#include "util/fixed_point.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Test: The difference follows each frame, in Q15 of full scale
+void test_CHANNEL_MATH_difference(void)
+{
+    CHANNEL_MATH_Config const config = {
+        .function = CHANNEL_MATH_DIFFERENCE,
+        .sample_bits = 12,
+    };
+    uint16_t const in[] = { 2048, 1024, 0, 4095 };
+    uint16_t out[6] = { 0 };
+
+    TEST_ASSERT_EQUAL_UINT32(6, CHANNEL_MATH_apply(&config, in, 4, out));
+
+    TEST_ASSERT_EQUAL_UINT16(2048, out[0]);
+    TEST_ASSERT_EQUAL_UINT16(1024, out[1]);
+    TEST_ASSERT_EQUAL_INT16(8192, (FIXED_Q15)out[2]);
+    TEST_ASSERT_EQUAL_UINT16(0, out[3]);
+    TEST_ASSERT_EQUAL_UINT16(4095, out[4]);
+    TEST_ASSERT_EQUAL_INT16(-32760, (FIXED_Q15)out[5]);
+}
+
+// Test: The product of two half-scale samples is a quarter of full scale
+void test_CHANNEL_MATH_product(void)
+{
+    CHANNEL_MATH_Config const config = {
+        .function = CHANNEL_MATH_PRODUCT,
+        .sample_bits = 12,
+        .math_only = true,
+    };
+    uint16_t const in[] = { 2048, 2048, 4095, 4095, 4095, 0 };
+    uint16_t out[3] = { 0 };
+
+    TEST_ASSERT_EQUAL_UINT32(3, CHANNEL_MATH_apply(&config, in, 6, out));
+
+    TEST_ASSERT_EQUAL_INT16(8192, (FIXED_Q15)out[0]);
+    TEST_ASSERT_EQUAL_INT16(32752, (FIXED_Q15)out[1]); // 32760^2 / 2^15
+    TEST_ASSERT_EQUAL_INT16(0, (FIXED_Q15)out[2]);
+}
+
+// Test: The scaled sum applies both gains and saturates
+void test_CHANNEL_MATH_sum(void)
+{
+    CHANNEL_MATH_Config const config = {
+        .function = CHANNEL_MATH_SUM,
+        .gains = { FIXED_Q15_FROM_FLOAT(0.5), FIXED_Q15_FROM_FLOAT(-0.25) },
+        .sample_bits = 12,
+        .math_only = true,
+    };
+    CHANNEL_MATH_Config saturating = config;
+    saturating.gains[0] = FIXED_Q15_MAX;
+    saturating.gains[1] = FIXED_Q15_MAX;
+    uint16_t const in[] = { 2048, 1024 };
+    uint16_t const full[] = { 4095, 4095 };
+    uint16_t out[1] = { 0 };
+
+    CHANNEL_MATH_apply(&config, in, 2, out);
+    TEST_ASSERT_EQUAL_INT16(8192 - 2048, (FIXED_Q15)out[0]);
+
+    CHANNEL_MATH_apply(&saturating, full, 2, out);
+    TEST_ASSERT_EQUAL_INT16(FIXED_Q15_MAX, (FIXED_Q15)out[0]);
+}
+
+// Test: Results do not depend on the sample resolution
+void test_CHANNEL_MATH_scales_to_full_scale(void)
+{
+    CHANNEL_MATH_Config config = {
+        .function = CHANNEL_MATH_DIFFERENCE,
+        .sample_bits = 8,
+        .math_only = true,
+    };
+    uint16_t const in_8bit[] = { 128, 64 };
+    uint16_t const in_15bit[] = { 16384, 8192 };
+    uint16_t out[1] = { 0 };
+
+    CHANNEL_MATH_apply(&config, in_8bit, 2, out);
+    TEST_ASSERT_EQUAL_INT16(8192, (FIXED_Q15)out[0]);
+
+    config.sample_bits = 15;
+    CHANNEL_MATH_apply(&config, in_15bit, 2, out);
+    TEST_ASSERT_EQUAL_INT16(8192, (FIXED_Q15)out[0]);
+}
+
+// Test: Math only may overwrite its input, and ignores a partial frame
+void test_CHANNEL_MATH_in_place(void)
+{
+    CHANNEL_MATH_Config const config = {
+        .function = CHANNEL_MATH_DIFFERENCE,
+        .sample_bits = 12,
+        .math_only = true,
+    };
+    uint16_t samples[] = { 300, 100, 100, 300, 7 };
+
+    TEST_ASSERT_EQUAL_UINT32(
+        2, CHANNEL_MATH_apply(&config, samples, 5, samples)
+    );
+
+    TEST_ASSERT_EQUAL_INT16(1600, (FIXED_Q15)samples[0]);
+    TEST_ASSERT_EQUAL_INT16(-1600, (FIXED_Q15)samples[1]);
+}
@@ -0,0 +1,109 @@
+/**
+ * @file test_checksum.c
+ * @brief Unit tests for checksums computed in the background
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "mock_crc_ll.h"
+#include "util/crc.h"
+#include "util/error.h"
+
+#include "checksum.h"
+
+static uint8_t g_data[512];
+
+void setUp(void)
+{
+    for (uint32_t i = 0; i < sizeof(g_data); ++i) {
+        g_data[i] = (uint8_t)(i * 7);
+    }
+}
+
+void tearDown(void) {}
+
+// Test: A large block goes to the CRC unit, polled until it is done
+void test_CHECKSUM_offloads_large_block(void)
+{
+    CHECKSUM_Job job;
+    uint32_t crc = 0;
+
+    CRC_LL_busy_ExpectAndReturn(false);
+    CRC_LL_start_Expect(CRC_LL_CRC32, CRC32_INIT, g_data, sizeof(g_data));
+    CRC_LL_start_IgnoreArg_data();
+    CHECKSUM_start(&job, CHECKSUM_CRC32, CRC32_INIT, g_data, sizeof(g_data));
+
+    CRC_LL_done_ExpectAndReturn(false);
+    TEST_ASSERT_FALSE(CHECKSUM_result(&job, &crc));
+
+    CRC_LL_done_ExpectAndReturn(true);
+    CRC_LL_result_ExpectAndReturn(0x12345678);
+    TEST_ASSERT_TRUE(CHECKSUM_result(&job, &crc));
+    TEST_ASSERT_EQUAL_HEX32(0x12345678, crc);
+
+    // Taken: cancelling no longer touches the unit
+    CHECKSUM_cancel(&job);
+}
+
+// Test: The unit taken by another job, the block is done in software
+void test_CHECKSUM_falls_back_to_software_when_busy(void)
+{
+    CHECKSUM_Job job;
+    uint32_t crc = 0;
+
+    CRC_LL_busy_ExpectAndReturn(true);
+    CHECKSUM_start(&job, CHECKSUM_CRC16, CRC16_INIT, g_data, sizeof(g_data));
+
+    TEST_ASSERT_TRUE(CHECKSUM_result(&job, &crc));
+    TEST_ASSERT_EQUAL_HEX32(
+        CRC16_update(CRC16_INIT, g_data, sizeof(g_data)), crc
+    );
+}
+
+// Test: Without a free DMA channel, the block is done in software
+void test_CHECKSUM_falls_back_to_software_without_channel(void)
+{
+    CHECKSUM_Job job;
+    uint32_t crc = 0;
+
+    CRC_LL_busy_ExpectAndReturn(false);
+    CRC_LL_start_ExpectAnyArgsAndThrow(ERROR_RESOURCE_UNAVAILABLE);
+    CHECKSUM_start(&job, CHECKSUM_CRC32, CRC32_INIT, g_data, sizeof(g_data));
+
+    TEST_ASSERT_TRUE(CHECKSUM_result(&job, &crc));
+    TEST_ASSERT_EQUAL_HEX32(
+        CRC32_update(CRC32_INIT, g_data, sizeof(g_data)), crc
+    );
+}
+
+// Test: A short block is done in software, continuing the start value
+void test_CHECKSUM_short_block_in_software(void)
+{
+    CHECKSUM_Job job;
+    uint32_t crc = 0;
+    uint32_t const start = CRC32_update(CRC32_INIT, "1234", 4);
+
+    CHECKSUM_start(&job, CHECKSUM_CRC32, start, "56789", 5);
+
+    TEST_ASSERT_TRUE(CHECKSUM_result(&job, &crc));
+    TEST_ASSERT_EQUAL_HEX32(0x0376E6E7, crc);
+}
+
+// Test: Cancelling a job frees the unit for the next
+void test_CHECKSUM_cancel_aborts_unit(void)
+{
+    CHECKSUM_Job job;
+
+    CRC_LL_busy_ExpectAndReturn(false);
+    CRC_LL_start_ExpectAnyArgs();
+    CHECKSUM_start(&job, CHECKSUM_CRC32, CRC32_INIT, g_data, sizeof(g_data));
+
+    CRC_LL_abort_Expect();
+    CHECKSUM_cancel(&job);
+    CHECKSUM_cancel(&job);
+}
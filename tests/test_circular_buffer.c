@@ -398,3 +398,403 @@ void test_circular_buffer_boundary_conditions(void)
     // Verify data integrity
     TEST_ASSERT_EQUAL_UINT8_ARRAY(test_data, read_data, sizeof(test_data));
 }
+
+// Test block write and read spanning the end of the backing storage
+void test_circular_buffer_write_read_across_wrap(void)
+{
+    uint8_t test_data[12];
+    uint8_t read_data[12];
+    uint8_t dummy[10] = { 0 };
+    uint32_t i;
+
+    for (i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = (uint8_t)(0xA0 + i);
+    }
+
+    // Move head and tail close to the end of the storage
+    circular_buffer_write(&g_test_buffer, dummy, sizeof(dummy));
+    circular_buffer_read(&g_test_buffer, dummy, sizeof(dummy));
+    TEST_ASSERT_EQUAL_UINT32(10, g_test_buffer.head);
+
+    // Write wraps after 6 bytes
+    uint32_t bytes_written = circular_buffer_write(&g_test_buffer, test_data, sizeof(test_data));
+    TEST_ASSERT_EQUAL_UINT32(12, bytes_written);
+    TEST_ASSERT_EQUAL_UINT32(6, g_test_buffer.head);
+    TEST_ASSERT_EQUAL_UINT8(0xA0, g_test_data[10]);
+    TEST_ASSERT_EQUAL_UINT8(0xA6, g_test_data[0]);
+
+    // Read also wraps after 6 bytes
+    uint32_t bytes_read = circular_buffer_read(&g_test_buffer, read_data, sizeof(read_data));
+    TEST_ASSERT_EQUAL_UINT32(12, bytes_read);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(test_data, read_data, sizeof(test_data));
+    TEST_ASSERT_TRUE(circular_buffer_is_empty(&g_test_buffer));
+}
+
+// Test block write truncated by free space when wrapping
+void test_circular_buffer_write_across_wrap_insufficient_space(void)
+{
+    uint8_t test_data[16];
+    uint8_t dummy[12] = { 0 };
+    uint32_t i;
+
+    for (i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = (uint8_t)i;
+    }
+
+    circular_buffer_write(&g_test_buffer, dummy, sizeof(dummy));
+    circular_buffer_read(&g_test_buffer, dummy, 8);
+
+    // 4 bytes still stored, so only 11 of 16 fit (4 before wrap, 7 after)
+    uint32_t bytes_written = circular_buffer_write(&g_test_buffer, test_data, sizeof(test_data));
+    TEST_ASSERT_EQUAL_UINT32(11, bytes_written);
+    TEST_ASSERT_TRUE(circular_buffer_is_full(&g_test_buffer));
+    TEST_ASSERT_EQUAL_UINT8(10, g_test_data[6]);
+}
+
+// Test peek returns only the span up to the end of the storage
+void test_circular_buffer_peek_contiguous_across_wrap(void)
+{
+    uint8_t test_data[8];
+    uint8_t dummy[12] = { 0 };
+    uint8_t const *span = nullptr;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = (uint8_t)(0x10 + i);
+    }
+
+    circular_buffer_write(&g_test_buffer, dummy, sizeof(dummy));
+    circular_buffer_read(&g_test_buffer, dummy, sizeof(dummy));
+    circular_buffer_write(&g_test_buffer, test_data, sizeof(test_data));
+
+    uint32_t len = circular_buffer_peek_contiguous(&g_test_buffer, &span);
+    TEST_ASSERT_EQUAL_UINT32(4, len);
+    TEST_ASSERT_EQUAL_PTR(&g_test_data[12], span);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(test_data, span, len);
+
+    circular_buffer_commit_read(&g_test_buffer, len);
+    len = circular_buffer_peek_contiguous(&g_test_buffer, &span);
+    TEST_ASSERT_EQUAL_UINT32(4, len);
+    TEST_ASSERT_EQUAL_PTR(&g_test_data[0], span);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&test_data[4], span, len);
+
+    circular_buffer_commit_read(&g_test_buffer, len);
+    TEST_ASSERT_TRUE(circular_buffer_is_empty(&g_test_buffer));
+    TEST_ASSERT_EQUAL_UINT32(
+        0, circular_buffer_peek_contiguous(&g_test_buffer, &span)
+    );
+}
+
+void test_circular_buffer_peek_spans_across_wrap(void)
+{
+    uint8_t test_data[8];
+    uint8_t dummy[12] = { 0 };
+    uint8_t const *first = nullptr;
+    uint8_t const *second = nullptr;
+    uint32_t first_len = 0;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = (uint8_t)(0x20 + i);
+    }
+
+    circular_buffer_write(&g_test_buffer, dummy, sizeof(dummy));
+    circular_buffer_read(&g_test_buffer, dummy, sizeof(dummy));
+    circular_buffer_write(&g_test_buffer, test_data, sizeof(test_data));
+
+    uint32_t len = circular_buffer_peek_spans(
+        &g_test_buffer,
+        &first,
+        &first_len,
+        &second
+    );
+    TEST_ASSERT_EQUAL_UINT32(8, len);
+    TEST_ASSERT_EQUAL_UINT32(4, first_len);
+    TEST_ASSERT_EQUAL_PTR(&g_test_data[12], first);
+    TEST_ASSERT_EQUAL_PTR(&g_test_data[0], second);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(test_data, first, first_len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&test_data[4], second, len - first_len);
+
+    circular_buffer_commit_read(&g_test_buffer, len);
+    TEST_ASSERT_TRUE(circular_buffer_is_empty(&g_test_buffer));
+    TEST_ASSERT_EQUAL_UINT32(
+        0,
+        circular_buffer_peek_spans(&g_test_buffer, &first, &first_len, &second)
+    );
+    TEST_ASSERT_EQUAL_UINT32(0, first_len);
+}
+
+// Test reserve leaves the one slot that distinguishes full from empty
+void test_circular_buffer_reserve_commit_write(void)
+{
+    uint8_t *span = nullptr;
+    uint8_t read_data[15];
+
+    uint32_t len = circular_buffer_reserve_contiguous(&g_test_buffer, &span);
+    TEST_ASSERT_EQUAL_UINT32(15, len);
+    TEST_ASSERT_EQUAL_PTR(&g_test_data[0], span);
+
+    memset(span, 0x5A, len);
+    circular_buffer_commit_write(&g_test_buffer, len);
+    TEST_ASSERT_TRUE(circular_buffer_is_full(&g_test_buffer));
+    TEST_ASSERT_EQUAL_UINT32(
+        0, circular_buffer_reserve_contiguous(&g_test_buffer, &span)
+    );
+
+    // After draining part of the data the free span ends at the storage end
+    circular_buffer_read(&g_test_buffer, read_data, 10);
+    len = circular_buffer_reserve_contiguous(&g_test_buffer, &span);
+    TEST_ASSERT_EQUAL_UINT32(1, len);
+    TEST_ASSERT_EQUAL_PTR(&g_test_data[15], span);
+}
+
+// Test committing more than is stored is rejected
+void test_circular_buffer_commit_read_overflow(void)
+{
+    Error exc = 0;
+
+    circular_buffer_put(&g_test_buffer, 0x42);
+
+    TRY
+    {
+        circular_buffer_commit_read(&g_test_buffer, 2);
+    }
+    CATCH(exc) {}
+
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exc);
+    TEST_ASSERT_EQUAL_UINT32(1, circular_buffer_available(&g_test_buffer));
+}
+
+/*
+ * Producer and consumer interleavings
+ *
+ * An interrupt handler on one side can run between any two steps of the
+ * other. The staged operations, reserve then commit_write and peek then
+ * commit_read, expose those points, so the interleavings are simulated by
+ * running the other side between the stages.
+ */
+
+// Test a reserved span stays invisible to the consumer until committed
+void test_circular_buffer_spsc_staged_write_invisible(void)
+{
+    uint8_t *span = nullptr;
+    uint8_t const *readable = nullptr;
+    uint8_t byte = 0;
+
+    circular_buffer_reserve_contiguous(&g_test_buffer, &span);
+    span[0] = 0x11;
+    span[1] = 0x22;
+
+    // The consumer runs between the fill and the commit
+    TEST_ASSERT_EQUAL_UINT32(0, circular_buffer_available(&g_test_buffer));
+    TEST_ASSERT_EQUAL_UINT32(
+        0, circular_buffer_peek_contiguous(&g_test_buffer, &readable)
+    );
+    TEST_ASSERT_FALSE(circular_buffer_get(&g_test_buffer, &byte));
+
+    circular_buffer_commit_write(&g_test_buffer, 2);
+    TEST_ASSERT_TRUE(circular_buffer_get(&g_test_buffer, &byte));
+    TEST_ASSERT_EQUAL_HEX8(0x11, byte);
+    TEST_ASSERT_TRUE(circular_buffer_get(&g_test_buffer, &byte));
+    TEST_ASSERT_EQUAL_HEX8(0x22, byte);
+}
+
+// Test a peeked span is not overwritten by the producer until released
+void test_circular_buffer_spsc_staged_read_keeps_space(void)
+{
+    uint8_t const *readable = nullptr;
+    uint8_t fill[16];
+
+    memset(fill, 0xAA, sizeof(fill));
+    circular_buffer_write(&g_test_buffer, fill, 15);
+    TEST_ASSERT_EQUAL_UINT32(
+        15, circular_buffer_peek_contiguous(&g_test_buffer, &readable)
+    );
+
+    // The producer runs while the consumer is still reading the span
+    memset(fill, 0x55, sizeof(fill));
+    TEST_ASSERT_EQUAL_UINT32(0, circular_buffer_free_space(&g_test_buffer));
+    TEST_ASSERT_EQUAL_UINT32(0, circular_buffer_write(&g_test_buffer, fill, 4));
+    TEST_ASSERT_FALSE(circular_buffer_put(&g_test_buffer, 0x55));
+    for (uint32_t i = 0; i < 15; ++i) {
+        TEST_ASSERT_EQUAL_HEX8(0xAA, readable[i]);
+    }
+
+    // Released space is the producer's from then on
+    circular_buffer_commit_read(&g_test_buffer, 4);
+    TEST_ASSERT_EQUAL_UINT32(4, circular_buffer_write(&g_test_buffer, fill, 8));
+    TEST_ASSERT_EQUAL_UINT32(15, circular_buffer_available(&g_test_buffer));
+}
+
+/**
+ * @brief Linear congruential generator, for a repeatable schedule
+ */
+static uint32_t next_random(uint32_t *state)
+{
+    *state = (*state * 1664525U) + 1013904223U;
+    return *state >> 16;
+}
+
+// Test a long random interleaving of every operation on both sides keeps
+// the byte stream intact: no byte lost, repeated or reordered
+void test_circular_buffer_spsc_random_interleaving(void)
+{
+    uint32_t state = 12345;
+    uint8_t produced = 0; // Next byte of the stream to produce
+    uint8_t consumed = 0; // Next byte of the stream expected
+    uint32_t total = 0;
+    uint8_t chunk[8];
+
+    // A staged operation left open while the other side runs
+    uint8_t *reserved = nullptr;
+    uint32_t reserved_len = 0;
+    uint8_t const *peeked = nullptr;
+    uint32_t peeked_len = 0;
+
+    for (uint32_t step = 0; step < 20000; ++step) {
+        uint32_t const choice = next_random(&state);
+        uint32_t const len = 1 + (choice >> 4) % sizeof(chunk);
+
+        if (choice & 1) {
+            // Producer step
+            if (reserved) {
+                for (uint32_t i = 0; i < reserved_len; ++i) {
+                    reserved[i] = produced++;
+                }
+                circular_buffer_commit_write(&g_test_buffer, reserved_len);
+                reserved = nullptr;
+            } else if ((choice & 6) == 0) {
+                if (circular_buffer_put(&g_test_buffer, produced)) {
+                    produced++;
+                }
+            } else if ((choice & 6) == 2) {
+                for (uint32_t i = 0; i < len; ++i) {
+                    chunk[i] = (uint8_t)(produced + i);
+                }
+                produced +=
+                    (uint8_t)circular_buffer_write(&g_test_buffer, chunk, len);
+            } else {
+                uint32_t const free_len = circular_buffer_reserve_contiguous(
+                    &g_test_buffer, &reserved
+                );
+                reserved_len = free_len < len ? free_len : len;
+                if (reserved_len == 0) {
+                    reserved = nullptr;
+                }
+            }
+        } else {
+            // Consumer step
+            if (peeked) {
+                for (uint32_t i = 0; i < peeked_len; ++i) {
+                    TEST_ASSERT_EQUAL_HEX8(consumed++, peeked[i]);
+                }
+                circular_buffer_commit_read(&g_test_buffer, peeked_len);
+                total += peeked_len;
+                peeked = nullptr;
+            } else if ((choice & 6) == 0) {
+                uint8_t byte = 0;
+                if (circular_buffer_get(&g_test_buffer, &byte)) {
+                    TEST_ASSERT_EQUAL_HEX8(consumed++, byte);
+                    total++;
+                }
+            } else if ((choice & 6) == 2) {
+                uint32_t const n =
+                    circular_buffer_read(&g_test_buffer, chunk, len);
+                for (uint32_t i = 0; i < n; ++i) {
+                    TEST_ASSERT_EQUAL_HEX8(consumed++, chunk[i]);
+                }
+                total += n;
+            } else {
+                uint32_t const used =
+                    circular_buffer_peek_contiguous(&g_test_buffer, &peeked);
+                peeked_len = used < len ? used : len;
+                if (peeked_len == 0) {
+                    peeked = nullptr;
+                }
+            }
+        }
+
+        // The stored bytes are exactly those produced and not consumed
+        TEST_ASSERT_EQUAL_UINT32(
+            (uint8_t)(produced - consumed),
+            circular_buffer_available(&g_test_buffer)
+        );
+    }
+
+    // The schedule exercised both sides, across many wraps of the storage
+    TEST_ASSERT_GREATER_THAN_UINT32(20 * sizeof(g_test_data), total);
+}
+
+// Test: In overwrite mode, a put into a full buffer drops the oldest byte
+void test_circular_buffer_overwrite_put_drops_oldest(void)
+{
+    circular_buffer_set_overwrite(&g_test_buffer, true);
+
+    for (uint32_t i = 0; i < sizeof(g_test_data) + 4; ++i) {
+        TEST_ASSERT_TRUE(circular_buffer_put(&g_test_buffer, (uint8_t)i));
+    }
+
+    TEST_ASSERT_TRUE(circular_buffer_is_full(&g_test_buffer));
+    TEST_ASSERT_EQUAL_UINT32(5, circular_buffer_overwritten(&g_test_buffer));
+    uint8_t byte = 0;
+    TEST_ASSERT_TRUE(circular_buffer_get(&g_test_buffer, &byte));
+    TEST_ASSERT_EQUAL_HEX8(5, byte);
+}
+
+// Test: An overwriting write keeps the most recent bytes, in order
+void test_circular_buffer_overwrite_write_keeps_most_recent(void)
+{
+    uint8_t data[40];
+    uint8_t out[sizeof(g_test_data)];
+    for (uint32_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t)i;
+    }
+    circular_buffer_set_overwrite(&g_test_buffer, true);
+
+    TEST_ASSERT_EQUAL_UINT32(
+        10, circular_buffer_write(&g_test_buffer, data, 10)
+    );
+    TEST_ASSERT_EQUAL_UINT32(
+        10, circular_buffer_write(&g_test_buffer, &data[10], 10)
+    );
+    TEST_ASSERT_EQUAL_UINT32(5, circular_buffer_overwritten(&g_test_buffer));
+
+    // Longer than the buffer holds: only its last 15 bytes are stored
+    TEST_ASSERT_EQUAL_UINT32(
+        15, circular_buffer_write(&g_test_buffer, data, sizeof(data))
+    );
+    TEST_ASSERT_EQUAL_UINT32(45, circular_buffer_overwritten(&g_test_buffer));
+
+    TEST_ASSERT_EQUAL_UINT32(
+        15, circular_buffer_read(&g_test_buffer, out, sizeof(out))
+    );
+    for (uint32_t i = 0; i < 15; ++i) {
+        TEST_ASSERT_EQUAL_HEX8(sizeof(data) - 15 + i, out[i]);
+    }
+}
+
+// Test: Without overwrite mode, a full buffer still rejects data
+void test_circular_buffer_overwrite_off_rejects(void)
+{
+    uint8_t data[20] = { 0 };
+
+    TEST_ASSERT_EQUAL_UINT32(
+        15, circular_buffer_write(&g_test_buffer, data, sizeof(data))
+    );
+    TEST_ASSERT_FALSE(circular_buffer_put(&g_test_buffer, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, circular_buffer_overwritten(&g_test_buffer));
+}
+
+// Test: Reset clears the count of dropped bytes
+void test_circular_buffer_overwrite_reset_clears_count(void)
+{
+    uint8_t data[20] = { 0 };
+    circular_buffer_set_overwrite(&g_test_buffer, true);
+    circular_buffer_write(&g_test_buffer, data, sizeof(data));
+    TEST_ASSERT_EQUAL_UINT32(5, circular_buffer_overwritten(&g_test_buffer));
+
+    circular_buffer_reset(&g_test_buffer);
+
+    TEST_ASSERT_EQUAL_UINT32(0, circular_buffer_overwritten(&g_test_buffer));
+    TEST_ASSERT_TRUE(circular_buffer_is_empty(&g_test_buffer));
+}
@@ -0,0 +1,101 @@
+/**
+ * @file test_clock.c
+ * @brief Unit tests for core clock scaling
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "mock_platform.h"
+#include "util/error.h"
+
+#include "clock.h"
+
+// Release whatever a failed test left requested
+void setUp(void)
+{
+    while (CLOCK_get_requests() > 0) {
+        CLOCK_release();
+    }
+}
+
+void tearDown(void) {}
+
+// Helper requesting the full clock while it runs at the given speed
+static void request_at(PLATFORM_ClockSpeed speed)
+{
+    PLATFORM_get_clock_speed_ExpectAndReturn(speed);
+    if (speed != PLATFORM_CLOCK_SPEED_FULL) {
+        PLATFORM_set_clock_speed_Expect(PLATFORM_CLOCK_SPEED_FULL);
+    }
+    CLOCK_request();
+}
+
+// Test: A request restores the full clock, nested ones leave it as is
+void test_CLOCK_request_switches_to_full(void)
+{
+    request_at(PLATFORM_CLOCK_SPEED_LOW);
+    request_at(PLATFORM_CLOCK_SPEED_FULL);
+
+    TEST_ASSERT_EQUAL_UINT32(2, CLOCK_get_requests());
+
+    CLOCK_release();
+    CLOCK_release();
+    TEST_ASSERT_EQUAL_UINT32(0, CLOCK_get_requests());
+}
+
+// Test: The low clock only comes back once idle with nothing requested
+void test_CLOCK_idle_switches_to_low_after_release(void)
+{
+    request_at(PLATFORM_CLOCK_SPEED_LOW);
+
+    // Outstanding request: idle leaves the clock alone
+    CLOCK_idle();
+
+    // Releasing does not switch by itself
+    CLOCK_release();
+
+    PLATFORM_get_clock_speed_ExpectAndReturn(PLATFORM_CLOCK_SPEED_FULL);
+    PLATFORM_set_clock_speed_Expect(PLATFORM_CLOCK_SPEED_LOW);
+    CLOCK_idle();
+
+    // Already low
+    PLATFORM_get_clock_speed_ExpectAndReturn(PLATFORM_CLOCK_SPEED_LOW);
+    CLOCK_idle();
+}
+
+// Test: Releases without a matching request are ignored
+void test_CLOCK_release_unmatched(void)
+{
+    CLOCK_release();
+    TEST_ASSERT_EQUAL_UINT32(0, CLOCK_get_requests());
+
+    request_at(PLATFORM_CLOCK_SPEED_FULL);
+    CLOCK_release();
+    CLOCK_release();
+    TEST_ASSERT_EQUAL_UINT32(0, CLOCK_get_requests());
+}
+
+// Test: A request that cannot switch the clock is not counted
+void test_CLOCK_request_switch_failure(void)
+{
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    PLATFORM_get_clock_speed_ExpectAndReturn(PLATFORM_CLOCK_SPEED_LOW);
+    PLATFORM_set_clock_speed_ExpectAndThrow(
+        PLATFORM_CLOCK_SPEED_FULL, ERROR_HARDWARE_FAULT
+    );
+
+    TRY {
+        CLOCK_request();
+        TEST_FAIL_MESSAGE("Expected exception for switch failure");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_HARDWARE_FAULT, exception);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, CLOCK_get_requests());
+}
@@ -0,0 +1,106 @@
+/**
+ * @file test_copy.c
+ * @brief Unit tests for memory copies in the background
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "mock_copy_ll.h"
+#include "util/error.h"
+
+#include "copy.h"
+
+static uint8_t g_src[4096];
+static uint8_t g_dst[4096];
+static uint32_t g_calls;
+static bool g_ok;
+
+static void copied(void *context, bool ok)
+{
+    TEST_ASSERT_EQUAL_PTR(g_dst, context);
+    g_calls++;
+    g_ok = ok;
+}
+
+void setUp(void)
+{
+    for (uint32_t i = 0; i < sizeof(g_src); ++i) {
+        g_src[i] = (uint8_t)(i * 7);
+    }
+    memset(g_dst, 0, sizeof(g_dst));
+    g_calls = 0;
+    g_ok = false;
+}
+
+void tearDown(void) {}
+
+// Test: A large block goes to the DMA engine, which calls back later
+void test_COPY_offloads_large_block(void)
+{
+    COPY_LL_busy_ExpectAndReturn(false);
+    COPY_LL_start_Expect(g_dst, g_src, sizeof(g_src), copied, g_dst);
+    COPY_start(g_dst, g_src, sizeof(g_src), copied, g_dst);
+
+    TEST_ASSERT_EQUAL_UINT32(0, g_calls);
+    TEST_ASSERT_EACH_EQUAL_HEX8(0, g_dst, sizeof(g_dst));
+}
+
+// Test: A short block is copied on the spot, and called back at once
+void test_COPY_short_block_on_cpu(void)
+{
+    COPY_start(g_dst, g_src, 100, copied, g_dst);
+
+    TEST_ASSERT_EQUAL_UINT32(1, g_calls);
+    TEST_ASSERT_TRUE(g_ok);
+    TEST_ASSERT_EQUAL_MEMORY(g_src, g_dst, 100);
+    TEST_ASSERT_EQUAL_HEX8(0, g_dst[100]);
+}
+
+// Test: The engine taken by another copy, the block is copied on the CPU
+void test_COPY_falls_back_to_cpu_when_busy(void)
+{
+    COPY_LL_busy_ExpectAndReturn(true);
+    COPY_start(g_dst, g_src, sizeof(g_src), copied, g_dst);
+
+    TEST_ASSERT_EQUAL_UINT32(1, g_calls);
+    TEST_ASSERT_EQUAL_MEMORY(g_src, g_dst, sizeof(g_src));
+}
+
+// Test: Without a free DMA channel, the block is copied on the CPU
+void test_COPY_falls_back_to_cpu_without_channel(void)
+{
+    COPY_LL_busy_ExpectAndReturn(false);
+    COPY_LL_start_ExpectAnyArgsAndThrow(ERROR_RESOURCE_UNAVAILABLE);
+    COPY_start(g_dst, g_src, sizeof(g_src), copied, g_dst);
+
+    TEST_ASSERT_EQUAL_UINT32(1, g_calls);
+    TEST_ASSERT_TRUE(g_ok);
+    TEST_ASSERT_EQUAL_MEMORY(g_src, g_dst, sizeof(g_src));
+}
+
+// Test: A copy needs no callback
+void test_COPY_without_callback(void)
+{
+    COPY_start(g_dst, g_src, 16, nullptr, nullptr);
+
+    TEST_ASSERT_EQUAL_MEMORY(g_src, g_dst, 16);
+}
+
+// Test: Missing blocks are refused
+void test_COPY_null_block(void)
+{
+    Error err = ERROR_NONE;
+
+    TRY { COPY_start(nullptr, g_src, 16, copied, g_dst); }
+    CATCH(err) {}
+
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, err);
+    TEST_ASSERT_EQUAL_UINT32(0, g_calls);
+}
@@ -0,0 +1,230 @@
+/**
+ * @file test_counter.c
+ * @brief Unit tests for the reciprocal frequency counter
+ *
+ * The capture timer is mocked at 250 MHz; each test hands the counter a
+ * span of timestamps and checks the frequency and period derived from it.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_clock.h"
+#include "mock_counter_ll.h"
+
+#include "util/error.h"
+
+#include "counter.h"
+
+enum {
+    TIMER_CLOCK = 250000000, // Hz
+    GATE_TICKS = TIMER_CLOCK / 10, // Of the default 100 ms gate
+};
+
+static COUNTER_Handle *g_handle;
+static COUNTER_LL_Span g_span;
+
+static void get_span_stub(COUNTER_LL_Span *span, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    *span = g_span;
+}
+
+/**
+ * @brief Init with the default gate and open it at timestamp 0
+ */
+static COUNTER_Handle *start_counter(void)
+{
+    COUNTER_Config config = COUNTER_CONFIG_DEFAULT;
+
+    COUNTER_LL_init_Expect(1);
+    COUNTER_Handle *const handle = COUNTER_init(&config);
+
+    COUNTER_LL_get_clock_ExpectAndReturn(TIMER_CLOCK);
+    COUNTER_LL_get_time_ExpectAndReturn(0);
+    COUNTER_LL_start_Expect();
+    COUNTER_start(handle);
+    return handle;
+}
+
+/**
+ * @brief Expect a read past the gate, which ends with the given span
+ */
+static void expect_gate_end(COUNTER_LL_Span const *span)
+{
+    g_span = *span;
+    COUNTER_LL_get_time_ExpectAndReturn(GATE_TICKS);
+    COUNTER_LL_stop_Expect();
+}
+
+void setUp(void)
+{
+    mock_clock_Init();
+    mock_counter_ll_Init();
+
+    g_handle = NULL;
+    memset(&g_span, 0, sizeof(g_span));
+
+    COUNTER_LL_get_span_Stub(get_span_stub);
+    CLOCK_request_Ignore();
+    CLOCK_release_Ignore();
+}
+
+void tearDown(void)
+{
+    if (g_handle != NULL) {
+        COUNTER_LL_stop_Ignore();
+        COUNTER_LL_deinit_Ignore();
+        COUNTER_deinit(g_handle);
+    }
+
+    mock_clock_Verify();
+    mock_clock_Destroy();
+    mock_counter_ll_Verify();
+    mock_counter_ll_Destroy();
+}
+
+// Test: 100 periods of 1 kHz over the gate read as exactly 1 kHz
+void test_COUNTER_read_frequency_and_period(void)
+{
+    COUNTER_LL_Span const span = {
+        .captures = 101, .first = 1000, .last = 1000 + GATE_TICKS
+    };
+    COUNTER_Result result = { 0 };
+
+    g_handle = start_counter();
+
+    // Before the gate time has passed
+    COUNTER_LL_get_time_ExpectAndReturn(GATE_TICKS - 1);
+    TEST_ASSERT_FALSE(COUNTER_read(g_handle, &result));
+
+    expect_gate_end(&span);
+    COUNTER_LL_stop_Expect();
+    TEST_ASSERT_TRUE(COUNTER_read(g_handle, &result));
+
+    TEST_ASSERT_EQUAL_UINT32(100, result.edges);
+    TEST_ASSERT_EQUAL_UINT32(GATE_TICKS, result.ticks);
+    TEST_ASSERT_EQUAL_UINT32(TIMER_CLOCK, result.clock);
+    TEST_ASSERT_EQUAL_UINT64(1000000000ULL, result.frequency);
+    TEST_ASSERT_EQUAL_UINT64(1000000000ULL, result.period);
+}
+
+// Test: Quotients are rounded to the microhertz and the picosecond
+void test_COUNTER_read_rounds(void)
+{
+    // 3 periods over 7 ticks: 107142857.142857 Hz, 9333.333 ps
+    COUNTER_LL_Span const span = { .captures = 4, .first = 10, .last = 17 };
+    COUNTER_Result result = { 0 };
+
+    g_handle = start_counter();
+    expect_gate_end(&span);
+    COUNTER_LL_stop_Expect();
+    // The next measurement captures every eighth edge
+    COUNTER_LL_deinit_Expect();
+    COUNTER_LL_init_Expect(8);
+    TEST_ASSERT_TRUE(COUNTER_read(g_handle, &result));
+
+    TEST_ASSERT_EQUAL_UINT64(107142857142857ULL, result.frequency);
+    TEST_ASSERT_EQUAL_UINT64(9333ULL, result.period);
+}
+
+// Test: A lost edge measures again at every eighth edge
+void test_COUNTER_read_overrun_retries(void)
+{
+    COUNTER_LL_Span const lost = { .captures = 64, .overrun = true };
+    COUNTER_LL_Span const span = {
+        .captures = 1001, .first = 0, .last = GATE_TICKS
+    };
+    COUNTER_Result result = { 0 };
+
+    g_handle = start_counter();
+
+    expect_gate_end(&lost);
+    COUNTER_LL_deinit_Expect();
+    COUNTER_LL_init_Expect(8);
+    COUNTER_LL_get_clock_ExpectAndReturn(TIMER_CLOCK);
+    COUNTER_LL_get_time_ExpectAndReturn(0);
+    COUNTER_LL_start_Expect();
+    TEST_ASSERT_FALSE(COUNTER_read(g_handle, &result));
+
+    // 80 kHz, at which every edge is captured again
+    expect_gate_end(&span);
+    COUNTER_LL_stop_Expect();
+    COUNTER_LL_deinit_Expect();
+    COUNTER_LL_init_Expect(1);
+    TEST_ASSERT_TRUE(COUNTER_read(g_handle, &result));
+    TEST_ASSERT_EQUAL_UINT32(8000, result.edges);
+    TEST_ASSERT_EQUAL_UINT64(80000000000ULL, result.frequency);
+}
+
+// Test: Edges lost even at every eighth fail the measurement
+void test_COUNTER_read_overrun_at_max_prescaler(void)
+{
+    COUNTER_LL_Span const lost = { .captures = 64, .overrun = true };
+    COUNTER_Result result = { 0 };
+    Error error = ERROR_NONE;
+
+    g_handle = start_counter();
+
+    expect_gate_end(&lost);
+    COUNTER_LL_deinit_Expect();
+    COUNTER_LL_init_Expect(8);
+    COUNTER_LL_get_clock_ExpectAndReturn(TIMER_CLOCK);
+    COUNTER_LL_get_time_ExpectAndReturn(0);
+    COUNTER_LL_start_Expect();
+    TEST_ASSERT_FALSE(COUNTER_read(g_handle, &result));
+
+    expect_gate_end(&lost);
+    COUNTER_LL_stop_Expect();
+    TRY { COUNTER_read(g_handle, &result); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_UNAVAILABLE, error);
+}
+
+// Test: Without two edges in the gate the result is 0
+void test_COUNTER_read_no_signal(void)
+{
+    COUNTER_LL_Span const span = { .captures = 1, .first = 5, .last = 5 };
+    COUNTER_Result result = { .frequency = 1, .period = 1 };
+
+    g_handle = start_counter();
+    expect_gate_end(&span);
+    COUNTER_LL_stop_Expect();
+    TEST_ASSERT_TRUE(COUNTER_read(g_handle, &result));
+
+    TEST_ASSERT_EQUAL_UINT32(0, result.edges);
+    TEST_ASSERT_EQUAL_UINT64(0, result.frequency);
+    TEST_ASSERT_EQUAL_UINT64(0, result.period);
+}
+
+// Test: Reading before a start and gates out of range are refused
+void test_COUNTER_invalid_use(void)
+{
+    COUNTER_Config config = COUNTER_CONFIG_DEFAULT;
+    COUNTER_Result result = { 0 };
+    Error error = ERROR_NONE;
+
+    config.gate_time = COUNTER_GATE_TIME_MAX + 1;
+    TRY { COUNTER_init(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    config.gate_time = 0;
+    error = ERROR_NONE;
+    TRY { COUNTER_init(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    config.gate_time = COUNTER_GATE_TIME_MIN;
+    COUNTER_LL_init_Expect(1);
+    g_handle = COUNTER_init(&config);
+    error = ERROR_NONE;
+    TRY { COUNTER_read(g_handle, &result); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_DEVICE_NOT_READY, error);
+}
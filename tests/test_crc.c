@@ -0,0 +1,77 @@
+/**
+ * @file test_crc.c
+ * @brief Unit tests for the CRC-16 and CRC-32 checksums
+ *
+ * @author PSLab Team
+ * @date 2025-10-20
+ */
+
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "util/crc.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_CRC16_update_check_value(void)
+{
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, CRC16_update(CRC16_INIT, "123456789", 9));
+}
+
+void test_CRC16_update_empty(void)
+{
+    TEST_ASSERT_EQUAL_HEX16(CRC16_INIT, CRC16_update(CRC16_INIT, "", 0));
+}
+
+void test_CRC16_update_in_pieces(void)
+{
+    uint16_t const crc = CRC16_update(CRC16_INIT, "1234", 4);
+
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, CRC16_update(crc, "56789", 5));
+}
+
+void test_CRC32_update_check_value(void)
+{
+    TEST_ASSERT_EQUAL_HEX32(
+        0x0376E6E7, CRC32_update(CRC32_INIT, "123456789", 9)
+    );
+}
+
+void test_CRC32_update_in_pieces(void)
+{
+    uint32_t const crc = CRC32_update(CRC32_INIT, "1234", 4);
+
+    TEST_ASSERT_EQUAL_HEX32(0x0376E6E7, CRC32_update(crc, "56789", 5));
+}
+
+void test_CRC32_update_matches_words(void)
+{
+    // Words are taken most significant byte first
+    uint32_t const words[] = { 0x31323334, 0x35363738 };
+
+    TEST_ASSERT_EQUAL_HEX32(
+        CRC32_update_words(CRC32_INIT, words, 2),
+        CRC32_update(CRC32_INIT, "12345678", 8)
+    );
+}
+
+void test_CRC32_update_words_check_value(void)
+{
+    // "12345678", most significant byte first in each word
+    uint32_t const words[] = { 0x31323334, 0x35363738 };
+
+    TEST_ASSERT_EQUAL_HEX32(
+        0x49E3C2FB, CRC32_update_words(CRC32_INIT, words, 2)
+    );
+}
+
+void test_CRC32_update_words_in_pieces(void)
+{
+    uint32_t const words[] = { 0x31323334, 0x35363738 };
+    uint32_t const crc = CRC32_update_words(CRC32_INIT, words, 1);
+
+    TEST_ASSERT_EQUAL_HEX32(0x49E3C2FB, CRC32_update_words(crc, &words[1], 1));
+}
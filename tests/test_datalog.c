@@ -0,0 +1,453 @@
+/**
+ * @file test_datalog.c
+ * @brief Unit tests for the data logger on external SPI flash
+ *
+ * The SPI bus is mocked by a small NOR flash emulator: queued transactions
+ * are run by run_bus, which follows chip select holds across them and
+ * checks that every page program lands on erased flash after a write
+ * enable. The DMM is mocked to return a fixed scan.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_dmm.h"
+#include "mock_platform.h"
+#include "mock_spi.h"
+
+#include "util/error.h"
+
+#include "datalog.h"
+
+enum {
+    FLASH_SIZE = 1 << 16, // Density code 0x10
+    QUEUE_MAX = 8,
+    SCAN_VALUE_0 = 0x00018000, // 1.5 V
+    SCAN_VALUE_1 = -0x00004000, // -0.25 V
+    RECORD_SIZE = 6 + 2 * 4,
+};
+
+static uint8_t g_flash[FLASH_SIZE];
+static uint8_t g_id[3]; // Manufacturer, memory type, density
+static SPI_Transaction *g_queue[QUEUE_MAX];
+static uint32_t g_queued;
+static uint32_t g_tick;
+
+// Emulated flash command, from the chip select falling edge
+static struct {
+    uint8_t command;
+    uint32_t position; // Bytes since the chip select fell
+    uint32_t address;
+    bool write_enabled;
+    uint32_t busy_polls; // Status reads left with the busy bit set
+    uint32_t programs;
+    uint32_t erases;
+} g_chip;
+
+static SPI_Handle *const g_spi_handle = (SPI_Handle *)0x2468ACE0;
+static DMM_Handle *const g_dmm_handle = (DMM_Handle *)0x13579BDF;
+
+static uint8_t exchange(uint8_t tx)
+{
+    uint32_t const position = g_chip.position++;
+    uint8_t rx = 0xFF;
+
+    if (position == 0) {
+        g_chip.command = tx;
+        g_chip.address = 0;
+        if (tx == 0x06) {
+            g_chip.write_enabled = true;
+        }
+        return rx;
+    }
+
+    switch (g_chip.command) {
+    case 0x9F:
+        rx = position <= 3 ? g_id[position - 1] : 0xFF;
+        break;
+    case 0x05:
+        if (g_chip.busy_polls > 0) {
+            g_chip.busy_polls -= 1;
+            rx = 0x01;
+        } else {
+            rx = 0x00;
+        }
+        break;
+    case 0x03:
+    case 0x02:
+    case 0x20:
+        if (position <= 3) {
+            g_chip.address = (g_chip.address << 8) | tx;
+        } else if (g_chip.command == 0x03) {
+            rx = g_flash[g_chip.address++ % FLASH_SIZE];
+        } else if (g_chip.command == 0x02) {
+            TEST_ASSERT_TRUE(g_chip.write_enabled);
+            TEST_ASSERT_EQUAL_HEX8(0xFF, g_flash[g_chip.address]);
+            g_flash[g_chip.address] = tx;
+            // Page programs wrap within the page
+            g_chip.address = (g_chip.address & ~0xFFU) |
+                             ((g_chip.address + 1) & 0xFFU);
+        }
+        break;
+    default:
+        break;
+    }
+    return rx;
+}
+
+/**
+ * @brief End of a command, on the chip select rising edge
+ */
+static void release_cs(void)
+{
+    if (g_chip.command == 0x20) {
+        TEST_ASSERT_TRUE(g_chip.write_enabled);
+        TEST_ASSERT_EQUAL_UINT32(0, g_chip.address % DATALOG_SECTOR_SIZE);
+        memset(&g_flash[g_chip.address], 0xFF, DATALOG_SECTOR_SIZE);
+        g_chip.erases += 1;
+    }
+    if (g_chip.command == 0x02) {
+        g_chip.programs += 1;
+    }
+    if (g_chip.command == 0x02 || g_chip.command == 0x20) {
+        g_chip.write_enabled = false;
+        g_chip.busy_polls = 1;
+    }
+    g_chip.position = 0;
+}
+
+/**
+ * @brief Run the queued transactions against the emulated flash
+ */
+static void run_bus(void)
+{
+    for (uint32_t i = 0; i < g_queued; i++) {
+        SPI_Transaction *const transaction = g_queue[i];
+        for (uint32_t j = 0; j < transaction->size; j++) {
+            uint8_t const rx =
+                exchange(transaction->tx ? transaction->tx[j] : 0xFF);
+            if (transaction->rx) {
+                transaction->rx[j] = rx;
+            }
+        }
+        if (!transaction->hold_cs) {
+            release_cs();
+        }
+        transaction->status = SPI_STATUS_OK;
+    }
+    g_queued = 0;
+}
+
+static void
+spi_submit_stub(SPI_Handle *handle, SPI_Transaction *transaction, int n)
+{
+    (void)n;
+    TEST_ASSERT_EQUAL_PTR(g_spi_handle, handle);
+    TEST_ASSERT_LESS_THAN_UINT32(QUEUE_MAX, g_queued);
+    transaction->status = SPI_STATUS_PENDING;
+    g_queue[g_queued] = transaction;
+    g_queued += 1;
+}
+
+static uint32_t spi_pending_stub(SPI_Handle const *handle, int n)
+{
+    (void)handle;
+    (void)n;
+    return g_queued;
+}
+
+static void spi_deinit_stub(SPI_Handle *handle, int n)
+{
+    (void)handle;
+    (void)n;
+    for (uint32_t i = 0; i < g_queued; i++) {
+        g_queue[i]->status = SPI_STATUS_CANCELLED;
+    }
+    g_queued = 0;
+    g_chip.position = 0;
+}
+
+static uint32_t
+read_scan_stub(DMM_Handle *handle, FIXED_Q1616 *values, uint32_t max, int n)
+{
+    (void)handle;
+    (void)n;
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2, max);
+    values[0] = SCAN_VALUE_0;
+    values[1] = SCAN_VALUE_1;
+    return 2;
+}
+
+static uint32_t get_tick_stub(int n)
+{
+    (void)n;
+    return g_tick;
+}
+
+static uint32_t get_u32(uint8_t const *bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+           ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static DATALOG_State get_state(void)
+{
+    DATALOG_Status status = { 0 };
+    DATALOG_get_status(&status);
+    return status.state;
+}
+
+/**
+ * @brief Initialize the logger and finish the identification
+ */
+static void init_logger(void)
+{
+    SPI_init_ExpectAndReturn(0, g_spi_handle);
+    SPI_configure_ExpectAnyArgsAndReturn(31250000);
+    DATALOG_init();
+    TEST_ASSERT_EQUAL(DATALOG_STATE_DETECTING, get_state());
+    run_bus();
+    DATALOG_task();
+}
+
+static DATALOG_Config scan_config(void)
+{
+    DATALOG_Config config = {
+        .interval = 10,
+        .dmm = DMM_CONFIG_DEFAULT,
+    };
+    config.dmm.scan_count = 2;
+    config.dmm.scan_channels[0] = 0;
+    config.dmm.scan_channels[1] = 1;
+    return config;
+}
+
+/**
+ * @brief Let the logger run for ms milliseconds, a task run per tick
+ */
+static void run_for(uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; i++) {
+        g_tick += 1;
+        run_bus();
+        DATALOG_task();
+    }
+}
+
+void setUp(void)
+{
+    mock_spi_Init();
+    mock_dmm_Init();
+    mock_platform_Init();
+
+    memset(g_flash, 0xFF, sizeof(g_flash));
+    memset(&g_chip, 0, sizeof(g_chip));
+    g_id[0] = 0xEF;
+    g_id[1] = 0x40;
+    g_id[2] = 0x10;
+    g_queued = 0;
+    g_tick = 1000;
+
+    SPI_submit_Stub(spi_submit_stub);
+    SPI_pending_Stub(spi_pending_stub);
+    SPI_deinit_Stub(spi_deinit_stub);
+    DMM_read_scan_Stub(read_scan_stub);
+    DMM_deinit_Ignore();
+    PLATFORM_get_tick_Stub(get_tick_stub);
+}
+
+void tearDown(void)
+{
+    DATALOG_deinit();
+    mock_spi_Verify();
+    mock_dmm_Verify();
+    mock_spi_Destroy();
+    mock_dmm_Destroy();
+    mock_platform_Destroy();
+}
+
+// Test: The flash is identified and its size taken from the density code
+void test_DATALOG_init_detects_flash(void)
+{
+    DATALOG_Status status = { 0 };
+
+    init_logger();
+    DATALOG_get_status(&status);
+    TEST_ASSERT_EQUAL(DATALOG_STATE_READY, status.state);
+    TEST_ASSERT_EQUAL_UINT32(FLASH_SIZE, status.capacity);
+    TEST_ASSERT_EQUAL_UINT16(0, status.session);
+}
+
+// Test: A bus without a flash, which reads all ones, is an error
+void test_DATALOG_init_no_flash(void)
+{
+    memset(g_id, 0xFF, sizeof(g_id));
+    init_logger();
+    TEST_ASSERT_EQUAL(DATALOG_STATE_ERROR, get_state());
+}
+
+// Test: The session of a log already on the flash is the one continued
+void test_DATALOG_init_finds_session(void)
+{
+    DATALOG_Status status = { 0 };
+    DATALOG_Config const config = scan_config();
+
+    g_flash[0] = 0x44;
+    g_flash[1] = 0x4C;
+    g_flash[2] = 7;
+    g_flash[3] = 0;
+    init_logger();
+    DATALOG_get_status(&status);
+    TEST_ASSERT_EQUAL_UINT16(7, status.session);
+
+    DMM_init_ExpectAnyArgsAndReturn(g_dmm_handle);
+    DATALOG_start(&config);
+    DATALOG_get_status(&status);
+    TEST_ASSERT_EQUAL_UINT16(8, status.session);
+}
+
+// Test: Records are packed into pages, programmed whole after the erase of
+// their sector, and the last partial page is programmed on stop
+void test_DATALOG_records_pages(void)
+{
+    DATALOG_Status status = { 0 };
+    DATALOG_Config const config = scan_config();
+    uint32_t const per_page =
+        (DATALOG_PAGE_SIZE - 8) / RECORD_SIZE; // 17 records
+
+    init_logger();
+    DMM_init_ExpectAnyArgsAndReturn(g_dmm_handle);
+    DATALOG_start(&config);
+    TEST_ASSERT_EQUAL(DATALOG_STATE_RUNNING, get_state());
+
+    // One record now and one every 10 ms, a page and some
+    uint32_t const start = g_tick;
+    DATALOG_task();
+    run_for((per_page + 2) * 10);
+    DATALOG_stop();
+    run_for(20);
+
+    DATALOG_get_status(&status);
+    TEST_ASSERT_EQUAL(DATALOG_STATE_READY, status.state);
+    TEST_ASSERT_EQUAL_UINT32(per_page + 3, status.records);
+    TEST_ASSERT_EQUAL_UINT32(0, status.dropped);
+    TEST_ASSERT_EQUAL_UINT32(2 * DATALOG_PAGE_SIZE, status.size);
+    TEST_ASSERT_EQUAL_UINT32(1, g_chip.erases);
+    TEST_ASSERT_EQUAL_UINT32(2, g_chip.programs);
+
+    // Page headers
+    TEST_ASSERT_EQUAL_HEX8(0x44, g_flash[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x4C, g_flash[1]);
+    TEST_ASSERT_EQUAL_HEX8(1, g_flash[2]);
+    TEST_ASSERT_EQUAL_UINT32(0, get_u32(&g_flash[4]));
+    TEST_ASSERT_EQUAL_UINT32(1, get_u32(&g_flash[DATALOG_PAGE_SIZE + 4]));
+
+    // First record
+    uint8_t const *record = &g_flash[8];
+    TEST_ASSERT_EQUAL_HEX8(DATALOG_RECORD_DMM_SCAN, record[0]);
+    TEST_ASSERT_EQUAL_UINT8(2, record[1]);
+    TEST_ASSERT_EQUAL_UINT32(start, get_u32(&record[2]));
+    TEST_ASSERT_EQUAL_HEX32(SCAN_VALUE_0, get_u32(&record[6]));
+    TEST_ASSERT_EQUAL_HEX32((uint32_t)SCAN_VALUE_1, get_u32(&record[10]));
+
+    // The second record is one interval later
+    TEST_ASSERT_EQUAL_UINT32(start + 10, get_u32(&record[RECORD_SIZE + 2]));
+
+    // The second page holds the last three and ends the records
+    TEST_ASSERT_EQUAL_HEX8(
+        DATALOG_RECORD_DMM_SCAN,
+        g_flash[DATALOG_PAGE_SIZE + 8 + 2 * RECORD_SIZE]
+    );
+    TEST_ASSERT_EQUAL_HEX8(
+        0xFF, g_flash[DATALOG_PAGE_SIZE + 8 + 3 * RECORD_SIZE]
+    );
+}
+
+// Test: The log is read back through the bus
+void test_DATALOG_read(void)
+{
+    uint8_t data[16] = { 0 };
+
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        g_flash[0x100 + i] = (uint8_t)(i * 3);
+    }
+    init_logger();
+
+    DATALOG_read(0x100, data, sizeof(data));
+    TEST_ASSERT_EQUAL(SPI_STATUS_PENDING, DATALOG_read_status());
+    run_bus();
+    TEST_ASSERT_EQUAL(SPI_STATUS_OK, DATALOG_read_status());
+    TEST_ASSERT_EQUAL_MEMORY(&g_flash[0x100], data, sizeof(data));
+}
+
+// Test: Reads beyond the flash, and while recording, are refused
+void test_DATALOG_read_refused(void)
+{
+    Error error = ERROR_NONE;
+    uint8_t data[16] = { 0 };
+    DATALOG_Config const config = scan_config();
+
+    init_logger();
+    TRY { DATALOG_read(FLASH_SIZE - 8, data, sizeof(data)); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    DMM_init_ExpectAnyArgsAndReturn(g_dmm_handle);
+    DATALOG_start(&config);
+    error = ERROR_NONE;
+    TRY { DATALOG_read(0, data, sizeof(data)); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_DEVICE_NOT_READY, error);
+}
+
+// Test: Intervals below the minimum, and bursts, are refused
+void test_DATALOG_start_invalid(void)
+{
+    Error error = ERROR_NONE;
+    DATALOG_Config config = scan_config();
+
+    init_logger();
+    config.interval = DATALOG_INTERVAL_MIN - 1;
+    TRY { DATALOG_start(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    config = scan_config();
+    config.dmm.burst_samples = 100;
+    error = ERROR_NONE;
+    TRY { DATALOG_start(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+    TEST_ASSERT_EQUAL(DATALOG_STATE_READY, get_state());
+}
+
+// Test: Recording stops at the end of the flash
+void test_DATALOG_stops_when_full(void)
+{
+    DATALOG_Status status = { 0 };
+    DATALOG_Config const config = scan_config();
+
+    init_logger();
+    DMM_init_ExpectAnyArgsAndReturn(g_dmm_handle);
+    DATALOG_start(&config);
+
+    for (uint32_t i = 0; i < 100000 && get_state() != DATALOG_STATE_FULL;
+         i++) {
+        run_for(1);
+    }
+
+    DATALOG_get_status(&status);
+    TEST_ASSERT_EQUAL(DATALOG_STATE_FULL, status.state);
+    TEST_ASSERT_EQUAL_UINT32(FLASH_SIZE, status.size);
+    TEST_ASSERT_EQUAL_UINT32(FLASH_SIZE / DATALOG_SECTOR_SIZE, g_chip.erases);
+    TEST_ASSERT_EQUAL_UINT32(0, status.dropped);
+    TEST_ASSERT_EQUAL_UINT32(
+        FLASH_SIZE / DATALOG_PAGE_SIZE - 1,
+        get_u32(&g_flash[FLASH_SIZE - DATALOG_PAGE_SIZE + 4])
+    );
+}
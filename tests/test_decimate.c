@@ -0,0 +1,233 @@
+/**
+ * @file test_decimate.c
+ * @brief Unit tests for the peak-detect, averaging and filter decimation
+ *        kernels
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "util/decimate.h"
+#include "util/fixed_point.h"
+
+enum {
+    TONE_SAMPLES = 4096,
+    TONE_OUTPUTS = 64,
+};
+
+static uint16_t g_tone[TONE_SAMPLES];
+static uint16_t g_out[TONE_OUTPUTS * 4];
+
+/**
+ * @brief Fill g_tone with a sine of amplitude 1500 around mid-scale
+ *
+ * @param factor Input samples per output sample
+ * @param step Frequency in turns per output sample, in units of 2^-32
+ */
+static void make_tone(uint32_t factor, uint32_t step)
+{
+    for (uint32_t i = 0; i < TONE_SAMPLES; ++i) {
+        FIXED_Q1616 const value = FIXED_sin(i * (step / factor));
+        g_tone[i] = (uint16_t)(2048 + ((value * 1500) >> 16));
+    }
+}
+
+/**
+ * @brief Squared amplitude of the output around mid-scale
+ *
+ * Twice the mean square, which is the squared amplitude of a sine over
+ * whole cycles.
+ */
+static uint32_t tone_power(uint32_t count)
+{
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        int32_t const deviation = (int32_t)g_out[i] - 2048;
+        sum += (uint64_t)(deviation * deviation);
+    }
+    return (uint32_t)((2 * sum) / count);
+}
+
+/**
+ * @brief Largest distance of the output from mid-scale
+ */
+static uint32_t tone_peak(uint32_t count)
+{
+    uint32_t peak = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t const distance =
+            g_out[i] > 2048 ? g_out[i] - 2048U : 2048U - g_out[i];
+        if (distance > peak) {
+            peak = distance;
+        }
+    }
+    return peak;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_DECIMATE_peak_single_channel(void)
+{
+    uint16_t const in[] = { 5, 9, 1, 4, 7, 7, 7, 3000 };
+    uint16_t out[4] = { 0 };
+
+    uint32_t const written = DECIMATE_peak(in, 8, 1, 2, out);
+
+    uint16_t const expected[] = { 1, 9, 7, 3000 };
+    TEST_ASSERT_EQUAL_UINT32(4, written);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, out, 4);
+}
+
+void test_DECIMATE_peak_keeps_channels_separate(void)
+{
+    // Frames of (CH1, CH2)
+    uint16_t const in[] = { 10, 200, 30, 100, 20, 400, 0, 300 };
+    uint16_t out[4] = { 0 };
+
+    uint32_t const written = DECIMATE_peak(in, 8, 2, 2, out);
+
+    // Minimum frame, then maximum frame
+    uint16_t const expected[] = { 0, 100, 30, 400 };
+    TEST_ASSERT_EQUAL_UINT32(4, written);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, out, 4);
+}
+
+void test_DECIMATE_average_rounds_to_nearest(void)
+{
+    uint16_t const in[] = { 1, 2, 4, 4, 4, 5 };
+    uint16_t out[2] = { 0 };
+
+    uint32_t const written = DECIMATE_average(in, 6, 1, 3, out);
+
+    // 7 / 3 = 2.33 -> 2 and 13 / 3 = 4.33 -> 4
+    uint16_t const expected[] = { 2, 4 };
+    TEST_ASSERT_EQUAL_UINT32(2, written);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, out, 2);
+}
+
+void test_DECIMATE_average_dual_channel(void)
+{
+    uint16_t const in[] = { 1, 4095, 2, 4094 };
+    uint16_t out[2] = { 0 };
+
+    uint32_t const written = DECIMATE_average(in, 4, 2, 2, out);
+
+    // 1.5 rounds up to 2, 4094.5 rounds up to 4095
+    uint16_t const expected[] = { 2, 4095 };
+    TEST_ASSERT_EQUAL_UINT32(2, written);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, out, 2);
+}
+
+void test_DECIMATE_ignores_partial_group(void)
+{
+    uint16_t const in[] = { 1, 2, 3, 4, 5 };
+    uint16_t out[2] = { 0xFFFF, 0xFFFF };
+
+    TEST_ASSERT_EQUAL_UINT32(1, DECIMATE_average(in, 5, 1, 4, out));
+    TEST_ASSERT_EQUAL_UINT16(3, out[0]);
+    TEST_ASSERT_EQUAL_UINT16(0xFFFF, out[1]);
+
+    TEST_ASSERT_EQUAL_UINT32(0, DECIMATE_peak(in, 3, 1, 2, out));
+}
+
+void test_DECIMATE_filter_init_rejects_invalid_arguments(void)
+{
+    DECIMATE_Filter filter;
+
+    TEST_ASSERT_FALSE(DECIMATE_filter_init(&filter, 0, 16, 4095));
+    TEST_ASSERT_FALSE(DECIMATE_filter_init(&filter, 5, 16, 4095));
+    TEST_ASSERT_FALSE(DECIMATE_filter_init(&filter, 1, 6, 4095));
+    TEST_ASSERT_FALSE(DECIMATE_filter_init(&filter, 1, 17, 4095));
+    TEST_ASSERT_FALSE(DECIMATE_filter_init(&filter, 1, 66, 4095));
+    TEST_ASSERT_FALSE(DECIMATE_filter_init(&filter, 1, 16, 4096));
+    TEST_ASSERT_TRUE(DECIMATE_filter_init(&filter, 4, 64, 4095));
+}
+
+void test_DECIMATE_filter_settles_to_level_per_channel(void)
+{
+    DECIMATE_Filter filter;
+    static uint16_t in[2 * 8 * 64];
+    for (uint32_t i = 0; i < 2 * 8 * 64; i += 2) {
+        in[i] = 100;
+        in[i + 1] = 4095;
+    }
+
+    TEST_ASSERT_TRUE(DECIMATE_filter_init(&filter, 2, 8, 4095));
+    uint32_t const written =
+        DECIMATE_filter(&filter, in, 2 * 8 * 64, g_out, 2 * 64);
+
+    // Held back while settling: (order + taps) / 2 outputs
+    TEST_ASSERT_EQUAL_UINT32(2 * (64 - 26), written);
+    for (uint32_t i = 0; i < written; i += 2) {
+        TEST_ASSERT_EQUAL_UINT16(100, g_out[i]);
+        TEST_ASSERT_EQUAL_UINT16(4095, g_out[i + 1]);
+    }
+}
+
+void test_DECIMATE_filter_blocks_match_one_call(void)
+{
+    DECIMATE_Filter filter;
+    static uint16_t whole[TONE_OUTPUTS];
+
+    make_tone(16, UINT32_MAX / 5);
+    TEST_ASSERT_TRUE(DECIMATE_filter_init(&filter, 1, 16, 4095));
+    uint32_t const expected =
+        DECIMATE_filter(&filter, g_tone, TONE_SAMPLES, whole, TONE_OUTPUTS);
+
+    // Blocks that end mid-group carry the state over
+    TEST_ASSERT_TRUE(DECIMATE_filter_init(&filter, 1, 16, 4095));
+    uint32_t written = 0;
+    for (uint32_t base = 0; base < TONE_SAMPLES; base += 100) {
+        uint32_t const count =
+            TONE_SAMPLES - base < 100 ? TONE_SAMPLES - base : 100;
+        written += DECIMATE_filter(
+            &filter, &g_tone[base], count, &g_out[written],
+            TONE_OUTPUTS - written
+        );
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(expected, written);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(whole, g_out, written);
+}
+
+void test_DECIMATE_filter_passes_band_and_rejects_aliases(void)
+{
+    DECIMATE_Filter filter;
+
+    // 1/8 of the output rate passes with its amplitude; 64 outputs are
+    // whole cycles
+    make_tone(16, UINT32_C(1) << 29);
+    TEST_ASSERT_TRUE(DECIMATE_filter_init(&filter, 1, 16, 4095));
+    uint32_t written =
+        DECIMATE_filter(&filter, g_tone, TONE_SAMPLES, g_out, TONE_OUTPUTS);
+    TEST_ASSERT_EQUAL_UINT32(TONE_OUTPUTS, written);
+    // Within 1% of 1500^2
+    TEST_ASSERT_UINT32_WITHIN(22500, 1500 * 1500, tone_power(written));
+
+    // 0.75 times the output rate would alias to 0.25; it is filtered out
+    make_tone(16, UINT32_C(3) << 30);
+    TEST_ASSERT_TRUE(DECIMATE_filter_init(&filter, 1, 16, 4095));
+    written =
+        DECIMATE_filter(&filter, g_tone, TONE_SAMPLES, g_out, TONE_OUTPUTS);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(1, tone_peak(written));
+}
+
+void test_DECIMATE_filter_stops_at_room(void)
+{
+    DECIMATE_Filter filter;
+    static uint16_t in[4 * 8 * 64];
+    for (uint32_t i = 0; i < 4 * 8 * 64; ++i) {
+        in[i] = 2000;
+    }
+
+    TEST_ASSERT_TRUE(DECIMATE_filter_init(&filter, 4, 8, 4095));
+    TEST_ASSERT_EQUAL_UINT32(
+        8, DECIMATE_filter(&filter, in, 4 * 8 * 64, g_out, 10)
+    );
+}
@@ -0,0 +1,152 @@
+/**
+ * @file test_delta_codec.c
+ * @brief Unit tests for the delta/run-length sample codec
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "util/delta_codec.h"
+#include "util/error.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static uint32_t encode_block(
+    uint16_t const *samples,
+    uint32_t count,
+    uint8_t *out
+)
+{
+    DELTA_Encoder encoder;
+    DELTA_encoder_init(&encoder);
+    uint32_t len = DELTA_encode(&encoder, samples, count, out);
+    return len + DELTA_encode_finish(&encoder, out + len);
+}
+
+void test_DELTA_encode_small_deltas(void)
+{
+    uint16_t const samples[] = { 1, 2, 0 };
+    uint8_t out[DELTA_ENCODE_BOUND(3)];
+
+    uint32_t const len = encode_block(samples, 3, out);
+
+    // Deltas +1, +1, -2 -> zigzag 2, 2, 3 -> tagged tokens 4, 4, 6
+    uint8_t const expected[] = { 0x04, 0x04, 0x06 };
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expected), len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, out, sizeof(expected));
+}
+
+void test_DELTA_encode_collapses_runs(void)
+{
+    uint16_t const samples[] = { 5, 5, 5, 5, 6 };
+    uint8_t out[DELTA_ENCODE_BOUND(5)];
+
+    uint32_t const len = encode_block(samples, 5, out);
+
+    // Sample 5 (token 20), run of 3 (token 5), delta +1 (token 4)
+    uint8_t const expected[] = { 0x14, 0x05, 0x04 };
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expected), len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, out, sizeof(expected));
+}
+
+void test_DELTA_encode_flushes_trailing_run(void)
+{
+    uint16_t const samples[] = { 0, 0 };
+    uint8_t out[DELTA_ENCODE_BOUND(2)];
+
+    uint32_t const len = encode_block(samples, 2, out);
+
+    uint8_t const expected[] = { 0x03 };
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expected), len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, out, sizeof(expected));
+}
+
+void test_DELTA_round_trip_extremes(void)
+{
+    uint16_t const samples[] = { 0xFFFF, 0, 0x8000, 0x7FFF, 0x7FFF, 1, 0xFFFE };
+    uint32_t const count = sizeof(samples) / sizeof(samples[0]);
+    uint8_t out[DELTA_ENCODE_BOUND(sizeof(samples) / sizeof(samples[0]))];
+    uint16_t decoded[sizeof(samples) / sizeof(samples[0])] = { 0 };
+
+    uint32_t const len = encode_block(samples, count, out);
+
+    TEST_ASSERT_EQUAL_UINT32(DELTA_encoded_size(samples, count), len);
+    TEST_ASSERT_EQUAL_UINT32(count, DELTA_decode(out, len, decoded, count));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(samples, decoded, count);
+}
+
+void test_DELTA_12bit_samples_take_at_most_two_bytes(void)
+{
+    uint16_t samples[64];
+    for (uint32_t i = 0; i < 64; ++i) {
+        samples[i] = (i & 1) ? 0x0FFF : 0;
+    }
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(
+        2 * 64, DELTA_encoded_size(samples, 64)
+    );
+}
+
+void test_DELTA_chunked_encode_matches_single_pass(void)
+{
+    uint16_t samples[100];
+    for (uint32_t i = 0; i < 100; ++i) {
+        samples[i] = (uint16_t)((i / 7) * 3);
+    }
+    uint8_t single[DELTA_ENCODE_BOUND(100)];
+    uint8_t chunked[DELTA_ENCODE_BOUND(100)];
+
+    uint32_t const single_len = encode_block(samples, 100, single);
+
+    DELTA_Encoder encoder;
+    DELTA_encoder_init(&encoder);
+    uint32_t chunked_len = 0;
+    for (uint32_t i = 0; i < 100; i += 9) {
+        uint32_t const n = (100 - i) < 9 ? (100 - i) : 9;
+        chunked_len +=
+            DELTA_encode(&encoder, &samples[i], n, chunked + chunked_len);
+    }
+    chunked_len += DELTA_encode_finish(&encoder, chunked + chunked_len);
+
+    TEST_ASSERT_EQUAL_UINT32(single_len, chunked_len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(single, chunked, single_len);
+    TEST_ASSERT_EQUAL_UINT32(single_len, DELTA_encoded_size(samples, 100));
+}
+
+void test_DELTA_decode_rejects_truncated_data(void)
+{
+    uint8_t const data[] = { 0x80 };
+    uint16_t samples[4];
+    Error exc = 0;
+
+    TRY
+    {
+        DELTA_decode(data, sizeof(data), samples, 4);
+    }
+    CATCH(exc) {}
+
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exc);
+}
+
+void test_DELTA_decode_rejects_overflow(void)
+{
+    // Run of 8 samples into a 4-sample buffer
+    uint8_t const data[] = { 0x0F };
+    uint16_t samples[4];
+    Error exc = 0;
+
+    TRY
+    {
+        DELTA_decode(data, sizeof(data), samples, 4);
+    }
+    CATCH(exc) {}
+
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exc);
+}
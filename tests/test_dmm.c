@@ -17,16 +17,21 @@
 
 #include "unity.h"
 #include "mock_adc_ll.h"
+#include "mock_clock.h"
+#include "mock_platform.h"
 #include "mock_tim_ll.h"
 
 #include "util/error.h"
 #include "util/fixed_point.h"
 
+#include "calibration.h"
 #include "dmm.h"
 
 // External function declaration for testing
 // This function is intentionally non-static in dmm.c to enable testing
 extern void dmm_adc_complete_callback(uint16_t *buffer, uint32_t total_samples);
+extern void dmm_adc_injected_callback(uint16_t value);
+extern void dmm_adc_watchdog_callback(void);
 
 // Test fixtures
 static DMM_Handle *g_test_handle;
@@ -47,6 +52,19 @@ void setUp(void)
     // Initialize mocks
     mock_adc_ll_Init();
     mock_tim_ll_Init();
+    mock_platform_Init();
+
+    // The DMM claims its timer from the pool
+    TIM_LL_claim_IgnoreAndReturn(TIM_NUM_6);
+    TIM_LL_release_Ignore();
+    ADC_LL_get_timer_trigger_IgnoreAndReturn(ADC_TRIGGER_TIMER6);
+
+    // No other instrument owns the ADC unless a test says otherwise
+    ADC_LL_is_initialized_IgnoreAndReturn(false);
+
+    // The DMM holds the full clock while initialized
+    CLOCK_request_Ignore();
+    CLOCK_release_Ignore();
 }
 
 void tearDown(void)
@@ -58,14 +76,20 @@ void tearDown(void)
         TIM_LL_stop_Ignore();
         ADC_LL_deinit_Ignore();
         TIM_LL_deinit_Ignore();
+        ADC_LL_injected_deinit_Ignore();
 
         DMM_deinit(g_test_handle);
         g_test_handle = NULL;
     }
 
+    // Tests that calibrate a channel must not affect the others
+    CALIBRATION_clear();
+
     // Clean up mocks after each test
     mock_adc_ll_Destroy();
     mock_tim_ll_Destroy();
+    mock_platform_Verify();
+    mock_platform_Destroy();
 }
 
 // Helper function to capture ADC callback
@@ -83,84 +107,1010 @@ void simulate_adc_conversion(uint16_t adc_value)
         *g_captured_adc_buffer = adc_value;
     }
 
-    // Call the completion callback to notify DMM
-    if (g_stored_callback != NULL) {
-        g_stored_callback(NULL, 0);
+    // Call the completion callback to notify DMM
+    if (g_stored_callback != NULL) {
+        g_stored_callback(NULL, 0);
+    }
+}
+
+// Stub function to simulate ADC initialization success
+void adc_init_success_stub(ADC_LL_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    // Verify config is reasonable
+    TEST_ASSERT_NOT_NULL(config);
+    TEST_ASSERT_EQUAL(ADC_LL_MODE_SINGLE, config->mode);
+    TEST_ASSERT_EQUAL(ADC_TRIGGER_TIMER6, config->trigger_source);
+    TEST_ASSERT_NOT_NULL(config->output_buffer);
+    TEST_ASSERT_EQUAL(1, config->buffer_size);
+
+    // Capture the output buffer for later use
+    g_captured_adc_buffer = config->output_buffer;
+}
+
+// Test: Successful DMM initialization with default configuration
+void test_DMM_init_success_default_config(void)
+{
+    // Arrange
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+
+    // Set expectations
+    ADC_LL_set_complete_callback_Expect(dmm_adc_complete_callback);
+    ADC_LL_init_Stub(adc_init_success_stub);
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000); // 1 kHz sample rate for timer init
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000); // 1 kHz sample rate for logging
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
+    TIM_LL_start_Expect(TIM_NUM_6); // Expect timer start for initial conversion
+    ADC_LL_start_Expect(); // Expect ADC start for initial conversion
+
+    // Act
+    g_test_handle = DMM_init(&config);
+
+    // Assert
+    TEST_ASSERT_NOT_NULL(g_test_handle);
+}
+
+// Test: DMM initialization with custom configuration
+void test_DMM_init_success_custom_config(void)
+{
+    // Arrange
+    DMM_Config config = {
+        .channel = DMM_CHANNEL_5,
+        .oversampling_ratio = 64
+    };
+
+    // Set expectations
+    ADC_LL_set_complete_callback_Expect(dmm_adc_complete_callback);
+    ADC_LL_init_Ignore();
+    ADC_LL_get_sample_rate_ExpectAndReturn(2000); // 2 kHz sample rate for timer init
+    ADC_LL_get_sample_rate_ExpectAndReturn(2000); // 2 kHz sample rate for logging
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 2000, 2000);
+    TIM_LL_start_Expect(TIM_NUM_6); // Expect timer start for initial conversion
+    ADC_LL_start_Expect(); // Expect ADC start for initial conversion
+
+    // Act
+    g_test_handle = DMM_init(&config);
+
+    // Assert
+    TEST_ASSERT_NOT_NULL(g_test_handle);
+}
+
+// Test: DMM initialization with NULL config
+void test_DMM_init_null_config(void)
+{
+    // Arrange
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    // Act & Assert
+    TRY {
+        g_test_handle = DMM_init(NULL);
+        TEST_FAIL_MESSAGE("Expected exception for NULL config");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+        TEST_ASSERT_NULL(g_test_handle);
+    }
+}
+
+// Test: DMM initialization with invalid channel
+void test_DMM_init_invalid_channel(void)
+{
+    // Arrange
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    config.channel = (DMM_Channel)999; // Invalid channel
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    // Act & Assert
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for invalid channel");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+        TEST_ASSERT_NULL(g_test_handle);
+    }
+}
+
+// Test: DMM initialization with invalid oversampling ratio
+void test_DMM_init_invalid_oversampling_ratio(void)
+{
+    // Arrange
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    config.oversampling_ratio = 7; // Not power of 2
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    // Act & Assert
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for invalid oversampling ratio");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+        TEST_ASSERT_NULL(g_test_handle);
+    }
+}
+
+// Test: DMM initialization when already initialized
+void test_DMM_init_already_initialized(void)
+{
+    // Arrange
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    // First initialization
+    ADC_LL_set_complete_callback_Expect(dmm_adc_complete_callback);
+    ADC_LL_init_Ignore();
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
+    TIM_LL_start_Expect(TIM_NUM_6);
+    ADC_LL_start_Expect();
+
+    g_test_handle = DMM_init(&config);
+    TEST_ASSERT_NOT_NULL(g_test_handle);
+
+    // Act & Assert - Try to initialize again
+    TRY {
+        DMM_Handle *second_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for double initialization");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, exception);
+    }
+}
+
+// Test: DMM initialization with ADC failure
+void test_DMM_init_adc_failure(void)
+{
+    // Arrange
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    // Set expectations
+    ADC_LL_set_complete_callback_Expect(dmm_adc_complete_callback);
+    ADC_LL_init_ExpectAndThrow(NULL, ERROR_HARDWARE_FAULT);
+    ADC_LL_init_IgnoreArg_config(); // Ignore the config parameter
+
+    // Act & Assert
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for ADC initialization failure");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_HARDWARE_FAULT, exception);
+        TEST_ASSERT_NULL(g_test_handle);
+    }
+}
+
+// Test: DMM initialization with timer failure
+void test_DMM_init_timer_failure(void)
+{
+    // Arrange
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    // Set expectations - ADC init succeeds, but timer init fails
+    ADC_LL_set_complete_callback_Expect(dmm_adc_complete_callback);
+    ADC_LL_init_Ignore(); // ADC init succeeds
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000); // For timer init
+    TIM_LL_init_ExpectAndThrow(TIM_NUM_6, 1000, ERROR_HARDWARE_FAULT);
+    ADC_LL_deinit_Expect(); // Cleanup after timer failure
+
+    // Act & Assert
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for timer initialization failure");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_HARDWARE_FAULT, exception);
+        TEST_ASSERT_NULL(g_test_handle);
+    }
+}
+
+// Stub checking that a scan programs the regular sequencer
+void adc_init_scan_stub(ADC_LL_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_EQUAL(ADC_LL_MODE_SINGLE, config->mode);
+    TEST_ASSERT_EQUAL(3, config->sequence_length);
+    TEST_ASSERT_EQUAL(3, config->buffer_size);
+    TEST_ASSERT_EQUAL(ADC_LL_CHANNEL_2, config->channels[0]);
+    TEST_ASSERT_EQUAL(ADC_LL_CHANNEL_2, config->sequence[0]);
+    TEST_ASSERT_EQUAL(ADC_LL_CHANNEL_7, config->sequence[1]);
+    TEST_ASSERT_EQUAL(ADC_LL_CHANNEL_0, config->sequence[2]);
+    g_captured_adc_buffer = config->output_buffer;
+}
+
+// Test: Scan converts all channels per trigger and reads them in order
+void test_DMM_read_scan_success(void)
+{
+    // Arrange
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    config.scan_count = 3;
+    config.scan_channels[0] = DMM_CHANNEL_2;
+    config.scan_channels[1] = DMM_CHANNEL_7;
+    config.scan_channels[2] = DMM_CHANNEL_0;
+    FIXED_Q1616 voltages[4] = { 0 };
+
+    ADC_LL_set_complete_callback_Stub(capture_adc_callback_stub);
+    ADC_LL_init_Stub(adc_init_scan_stub);
+    ADC_LL_get_sample_rate_ExpectAndReturn(3000);
+    ADC_LL_get_sample_rate_ExpectAndReturn(3000);
+    // One trigger per sequence of three conversions
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
+    TIM_LL_start_Expect(TIM_NUM_6);
+    ADC_LL_start_Expect();
+
+    g_test_handle = DMM_init(&config);
+    TEST_ASSERT_NOT_NULL(g_test_handle);
+
+    // DMA writes one sample per channel
+    g_captured_adc_buffer[0] = 0;
+    g_captured_adc_buffer[1] = 2047;
+    g_captured_adc_buffer[2] = 4095;
+    g_stored_callback(NULL, 0);
+
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    ADC_LL_try_start_ExpectAndReturn(ERROR_NONE);
+
+    // Act
+    uint32_t count = DMM_read_scan(g_test_handle, voltages, 4);
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT32(3, count);
+    FIXED_Q1616 tolerance = FIXED_FROM_FLOAT(0.01f);
+    TEST_ASSERT_EQUAL_INT32(FIXED_ZERO, voltages[0]);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(1.648f), voltages[1]);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(3.3f), voltages[2]);
+}
+
+// Test: Scan results need room for every channel
+void test_DMM_read_scan_output_too_small(void)
+{
+    // Arrange
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    config.scan_count = 2;
+    config.scan_channels[0] = DMM_CHANNEL_1;
+    config.scan_channels[1] = DMM_CHANNEL_3;
+    FIXED_Q1616 voltage_out;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    ADC_LL_set_complete_callback_Expect(dmm_adc_complete_callback);
+    ADC_LL_init_Ignore();
+    ADC_LL_get_sample_rate_IgnoreAndReturn(2000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
+    TIM_LL_start_Expect(TIM_NUM_6);
+    ADC_LL_start_Expect();
+
+    g_test_handle = DMM_init(&config);
+    TEST_ASSERT_NOT_NULL(g_test_handle);
+
+    // Act & Assert - a single voltage cannot hold a two-channel scan
+    TRY {
+        DMM_read_voltage(g_test_handle, &voltage_out);
+        TEST_FAIL_MESSAGE("Expected exception for a too small output");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+}
+
+// Test: Invalid scan lists are rejected
+void test_DMM_init_invalid_scan(void)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    config.scan_count = DMM_SCAN_CHANNELS_MAX + 1;
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for too many scan channels");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+
+    config.scan_count = 2;
+    config.scan_channels[0] = DMM_CHANNEL_0;
+    config.scan_channels[1] = (DMM_Channel)16;
+    exception = CEXCEPTION_NONE;
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for invalid scan channel");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+}
+
+// Test: A shared ADC cannot scan
+void test_DMM_init_scan_shared_adc(void)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+    config.scan_count = 2;
+    config.scan_channels[0] = DMM_CHANNEL_0;
+    config.scan_channels[1] = DMM_CHANNEL_1;
+    ADC_LL_is_initialized_IgnoreAndReturn(true);
+
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for scanning a shared ADC");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, exception);
+        TEST_ASSERT_NULL(g_test_handle);
+    }
+}
+
+// Stub checking that a differential reading runs both ADCs together
+void adc_init_differential_stub(ADC_LL_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_EQUAL(ADC_LL_MODE_SIMULTANEOUS, config->mode);
+    TEST_ASSERT_EQUAL(ADC_LL_CHANNEL_2, config->channels[0]);
+    TEST_ASSERT_EQUAL(ADC_LL_CHANNEL_5, config->channels[1]);
+    TEST_ASSERT_EQUAL(2, config->buffer_size);
+    TEST_ASSERT_EQUAL(0, config->sequence_length);
+    g_captured_adc_buffer = config->output_buffer;
+}
+
+// Test: A differential reading returns both calibrated legs and their
+// difference
+void test_DMM_read_differential(void)
+{
+    // Arrange
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    config.channel = DMM_CHANNEL_2;
+    config.differential = true;
+    config.negative_channel = DMM_CHANNEL_5;
+    config.oversampling_ratio = 1;
+    DMM_Differential reading = { 0 };
+    CALIBRATION_Entry const entry = {
+        .gain = FIXED_ONE,
+        .offset = FIXED_from_fraction(-100, 1000),
+    };
+    CALIBRATION_set(CALIBRATION_MODE_DMM, 5, &entry);
+
+    ADC_LL_set_complete_callback_Stub(capture_adc_callback_stub);
+    ADC_LL_init_Stub(adc_init_differential_stub);
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
+    TIM_LL_start_Expect(TIM_NUM_6);
+    ADC_LL_start_Expect();
+
+    g_test_handle = DMM_init(&config);
+    TEST_ASSERT_NOT_NULL(g_test_handle);
+    TEST_ASSERT_FALSE(DMM_read_differential(g_test_handle, &reading));
+
+    // ADC1 and ADC2 store one sample each
+    g_captured_adc_buffer[0] = 4095;
+    g_captured_adc_buffer[1] = 2047;
+    g_stored_callback(NULL, 0);
+
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    ADC_LL_try_start_ExpectAndReturn(ERROR_NONE);
+
+    // Act
+    TEST_ASSERT_TRUE(DMM_read_differential(g_test_handle, &reading));
+
+    // Assert: 3.3 V - (1.6496 V - 0.1 V)
+    FIXED_Q1616 tolerance = FIXED_FROM_FLOAT(0.001f);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(3.3f), reading.positive);
+    TEST_ASSERT_INT32_WITHIN(
+        tolerance, FIXED_FROM_FLOAT(1.5496f), reading.negative
+    );
+    TEST_ASSERT_INT32_WITHIN(
+        tolerance, FIXED_FROM_FLOAT(1.7504f), reading.difference
+    );
+    TEST_ASSERT_EQUAL_INT32(
+        reading.positive - reading.negative, reading.difference
+    );
+}
+
+// Test: Differential readings need two channels and one conversion each
+void test_DMM_init_invalid_differential(void)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+    config.differential = true;
+
+    // Both legs on the same channel
+    config.negative_channel = config.channel;
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for a single channel");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+
+    // Averaging
+    config.negative_channel = DMM_CHANNEL_1;
+    config.average_window = 8;
+    exception = CEXCEPTION_NONE;
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for averaging");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+}
+
+// Test: A shared ADC cannot take ADC2 along
+void test_DMM_init_differential_shared_adc(void)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+    config.differential = true;
+    config.negative_channel = DMM_CHANNEL_1;
+    ADC_LL_is_initialized_IgnoreAndReturn(true);
+
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for a shared ADC");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, exception);
+        TEST_ASSERT_NULL(g_test_handle);
+    }
+}
+
+// Stub checking that averaging converts continuously into a ring
+void adc_init_average_stub(ADC_LL_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_EQUAL(ADC_LL_MODE_SINGLE, config->mode);
+    TEST_ASSERT_TRUE(config->circular);
+    TEST_ASSERT_EQUAL(8, config->buffer_size);
+    g_captured_adc_buffer = config->output_buffer;
+}
+
+// Helper initializing a DMM averaging over eight samples
+static void init_averaging_dmm(void)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    config.average_window = 8;
+
+    ADC_LL_set_complete_callback_Stub(capture_adc_callback_stub);
+    ADC_LL_set_half_complete_callback_Expect(dmm_adc_complete_callback);
+    ADC_LL_init_Stub(adc_init_average_stub);
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
+    TIM_LL_start_Expect(TIM_NUM_6);
+    ADC_LL_start_Expect();
+
+    g_test_handle = DMM_init(&config);
+    TEST_ASSERT_NOT_NULL(g_test_handle);
+}
+
+// Test: Averaging statistics cover the filled halves of the ring
+void test_DMM_read_statistics_window(void)
+{
+    DMM_Statistics statistics = { 0 };
+    init_averaging_dmm();
+
+    // Nothing to report before the first half has been filled
+    TEST_ASSERT_FALSE(DMM_read_statistics(g_test_handle, &statistics));
+
+    // DMA fills the first half, then the second
+    uint16_t const samples[] = { 1000, 1000, 3000, 3000, 0, 0, 4095, 4095 };
+    memcpy(g_captured_adc_buffer, samples, sizeof(samples));
+    g_stored_callback(g_captured_adc_buffer, 4);
+
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    TEST_ASSERT_TRUE(DMM_read_statistics(g_test_handle, &statistics));
+    TEST_ASSERT_EQUAL_UINT32(4, statistics.samples);
+
+    g_stored_callback(g_captured_adc_buffer + 4, 4);
+
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    TEST_ASSERT_TRUE(DMM_read_statistics(g_test_handle, &statistics));
+
+    // Mean code 2023.75, RMS code sqrt(53538050 / 8) = 2586.9
+    FIXED_Q1616 tolerance = FIXED_FROM_FLOAT(0.01f);
+    TEST_ASSERT_EQUAL_UINT32(8, statistics.samples);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(1.631f), statistics.mean);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(2.085f), statistics.rms);
+    TEST_ASSERT_EQUAL_INT32(FIXED_ZERO, statistics.min);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(3.3f), statistics.max);
+}
+
+// Test: Averaging readings return the mean without restarting the ADC
+void test_DMM_read_voltage_averaging(void)
+{
+    FIXED_Q1616 voltage = FIXED_MAX;
+    init_averaging_dmm();
+
+    TEST_ASSERT_FALSE(DMM_read_voltage(g_test_handle, &voltage));
+    TEST_ASSERT_EQUAL_INT32(FIXED_ZERO, voltage);
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        g_captured_adc_buffer[i] = 2047;
+    }
+    g_stored_callback(g_captured_adc_buffer, 4);
+
+    // No ADC_LL_start expected: conversions continue in the background
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    TEST_ASSERT_TRUE(DMM_read_voltage(g_test_handle, &voltage));
+    FIXED_Q1616 tolerance = FIXED_FROM_FLOAT(0.01f);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(1.649f), voltage);
+}
+
+// Test: Calibration corrects every statistic, including the RMS
+void test_DMM_read_statistics_calibrated(void)
+{
+    DMM_Statistics statistics = { 0 };
+    CALIBRATION_Entry const entry = {
+        .gain = FIXED_ONE,
+        .offset = FIXED_FROM_FLOAT(-0.1f),
+    };
+    CALIBRATION_set(CALIBRATION_MODE_DMM, 0, &entry);
+    init_averaging_dmm();
+
+    uint16_t const samples[] = { 1000, 1000, 3000, 3000, 0, 0, 4095, 4095 };
+    memcpy(g_captured_adc_buffer, samples, sizeof(samples));
+    g_stored_callback(g_captured_adc_buffer, 4);
+    g_stored_callback(g_captured_adc_buffer + 4, 4);
+
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    TEST_ASSERT_TRUE(DMM_read_statistics(g_test_handle, &statistics));
+
+    // RMS of the corrected samples, not the corrected RMS: sqrt(4.0299)
+    FIXED_Q1616 tolerance = FIXED_FROM_FLOAT(0.01f);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(1.531f), statistics.mean);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(2.007f), statistics.rms);
+    TEST_ASSERT_INT32_WITHIN(1, FIXED_FROM_FLOAT(-0.1f), statistics.min);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(3.2f), statistics.max);
+}
+
+// Test: Statistics need an averaging DMM
+void test_DMM_read_statistics_not_averaging(void)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    DMM_Statistics statistics = { 0 };
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    ADC_LL_set_complete_callback_Ignore();
+    ADC_LL_init_Stub(adc_init_success_stub);
+    ADC_LL_get_sample_rate_IgnoreAndReturn(1000);
+    TIM_LL_init_IgnoreAndReturn(1000);
+    TIM_LL_start_Ignore();
+    ADC_LL_start_Ignore();
+    g_test_handle = DMM_init(&config);
+
+    TRY {
+        DMM_read_statistics(g_test_handle, &statistics);
+        TEST_FAIL_MESSAGE("Expected exception for a non-averaging DMM");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+}
+
+// Test: Invalid averaging windows are rejected
+void test_DMM_init_invalid_average_window(void)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    config.average_window = 6; // Not a multiple of 4
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for an odd window");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+
+    config.average_window = DMM_AVERAGE_WINDOW_MAX + 4;
+    exception = CEXCEPTION_NONE;
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for an oversized window");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+
+    config.average_window = 8;
+    config.scan_count = 2;
+    config.scan_channels[0] = DMM_CHANNEL_0;
+    config.scan_channels[1] = DMM_CHANNEL_1;
+    exception = CEXCEPTION_NONE;
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for averaging a scan");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+}
+
+// Test: A shared ADC cannot average in the background
+void test_DMM_init_average_shared_adc(void)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+    config.average_window = 8;
+    ADC_LL_is_initialized_IgnoreAndReturn(true);
+
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for averaging a shared ADC");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, exception);
+        TEST_ASSERT_NULL(g_test_handle);
+    }
+}
+
+// Stub checking that free running converts into a short ring
+void adc_init_free_running_stub(ADC_LL_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_TRUE(config->circular);
+    TEST_ASSERT_EQUAL(DMM_FREE_RUNNING_RING, config->buffer_size);
+    g_captured_adc_buffer = config->output_buffer;
+}
+
+// Test: Free running publishes the newest sample with a sequence number
+void test_DMM_read_latest_free_running(void)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    config.free_running = true;
+    FIXED_Q1616 voltage = FIXED_MAX;
+    uint32_t sequence = UINT32_MAX;
+    uint32_t const half = DMM_FREE_RUNNING_RING / 2;
+
+    ADC_LL_set_complete_callback_Stub(capture_adc_callback_stub);
+    ADC_LL_set_half_complete_callback_Expect(dmm_adc_complete_callback);
+    ADC_LL_init_Stub(adc_init_free_running_stub);
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
+    TIM_LL_start_Expect(TIM_NUM_6);
+    ADC_LL_start_Expect();
+    g_test_handle = DMM_init(&config);
+    TEST_ASSERT_NOT_NULL(g_test_handle);
+
+    // Nothing published yet
+    TEST_ASSERT_FALSE(DMM_read_latest(g_test_handle, &voltage, &sequence));
+    TEST_ASSERT_EQUAL_UINT32(0, sequence);
+
+    // First half filled, newest sample last
+    g_captured_adc_buffer[half - 1] = 4095;
+    g_stored_callback(g_captured_adc_buffer, half);
+
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    TEST_ASSERT_TRUE(DMM_read_latest(g_test_handle, &voltage, &sequence));
+    TEST_ASSERT_EQUAL_UINT32(half, sequence);
+    FIXED_Q1616 tolerance = FIXED_FROM_FLOAT(0.01f);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(3.3f), voltage);
+
+    // Second half; DMM_read_voltage does not re-arm the ADC
+    g_captured_adc_buffer[DMM_FREE_RUNNING_RING - 1] = 0;
+    g_stored_callback(g_captured_adc_buffer + half, half);
+
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    TEST_ASSERT_TRUE(DMM_read_voltage(g_test_handle, &voltage));
+    TEST_ASSERT_EQUAL_INT32(FIXED_ZERO, voltage);
+
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    TEST_ASSERT_TRUE(DMM_read_latest(g_test_handle, &voltage, &sequence));
+    TEST_ASSERT_EQUAL_UINT32(DMM_FREE_RUNNING_RING, sequence);
+}
+
+// Test: Latest readings need a free-running DMM
+void test_DMM_read_latest_not_free_running(void)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    FIXED_Q1616 voltage = 0;
+    uint32_t sequence = 0;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    ADC_LL_set_complete_callback_Ignore();
+    ADC_LL_init_Stub(adc_init_success_stub);
+    ADC_LL_get_sample_rate_IgnoreAndReturn(1000);
+    TIM_LL_init_IgnoreAndReturn(1000);
+    TIM_LL_start_Ignore();
+    ADC_LL_start_Ignore();
+    g_test_handle = DMM_init(&config);
+
+    TRY {
+        DMM_read_latest(g_test_handle, &voltage, &sequence);
+        TEST_FAIL_MESSAGE("Expected exception for a single-shot DMM");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+}
+
+// Test: A shared ADC cannot free run
+void test_DMM_init_free_running_shared_adc(void)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+    config.free_running = true;
+    ADC_LL_is_initialized_IgnoreAndReturn(true);
+
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for free running a shared ADC");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, exception);
+        TEST_ASSERT_NULL(g_test_handle);
+    }
+}
+
+static uint32_t g_watch_callback_count;
+
+static void count_watch_callback(void) { g_watch_callback_count++; }
+
+// Test: A watch arms the window in codes and latches one crossing
+void test_DMM_watch_event(void)
+{
+    init_averaging_dmm();
+    g_watch_callback_count = 0;
+
+    // 1 V rounds up to code 1241 and 2 V down to 2481 of 3.3 V
+    ADC_LL_get_reference_voltage_IgnoreAndReturn(3300);
+    ADC_LL_set_watchdog_callback_Expect(dmm_adc_watchdog_callback);
+    ADC_LL_arm_watchdog_Expect(1241, 2481);
+    DMM_watch_start(
+        g_test_handle,
+        FIXED_FROM_INT(1),
+        FIXED_FROM_INT(2),
+        count_watch_callback
+    );
+    TEST_ASSERT_FALSE(DMM_watch_event(g_test_handle));
+
+    dmm_adc_watchdog_callback();
+    TEST_ASSERT_EQUAL_UINT32(1, g_watch_callback_count);
+
+    // Taking the crossing re-arms the same window
+    ADC_LL_arm_watchdog_Expect(1241, 2481);
+    TEST_ASSERT_TRUE(DMM_watch_event(g_test_handle));
+    TEST_ASSERT_FALSE(DMM_watch_event(g_test_handle));
+
+    ADC_LL_disarm_watchdog_Expect();
+    ADC_LL_set_watchdog_callback_Expect(NULL);
+    DMM_watch_stop(g_test_handle);
+
+    // Crossings after the end of a watch are not seen
+    dmm_adc_watchdog_callback();
+    TEST_ASSERT_EQUAL_UINT32(1, g_watch_callback_count);
+    TEST_ASSERT_FALSE(DMM_watch_event(g_test_handle));
+}
+
+// Test: Thresholds undo the calibration and stay within the codes
+void test_DMM_watch_calibrated_window(void)
+{
+    // Readings are twice the input voltage plus 0.5 V
+    CALIBRATION_Entry const entry = {
+        .gain = FIXED_FROM_INT(2),
+        .offset = FIXED_FROM_FLOAT(0.5f),
+    };
+    CALIBRATION_set(CALIBRATION_MODE_DMM, 0, &entry);
+    init_averaging_dmm();
+
+    // Readings of 2.5 V come from 1 V inputs; 10 V is beyond full scale
+    ADC_LL_get_reference_voltage_IgnoreAndReturn(3300);
+    ADC_LL_set_watchdog_callback_Ignore();
+    ADC_LL_arm_watchdog_Expect(1241, 4095);
+    DMM_watch_start(
+        g_test_handle, FIXED_FROM_FLOAT(2.5f), FIXED_FROM_INT(10), nullptr
+    );
+
+    // DMM_deinit ends the watch
+    ADC_LL_disarm_watchdog_Expect();
+    DMM_deinit(g_test_handle);
+    g_test_handle = NULL;
+}
+
+// Test: A watch needs a free-running or averaging DMM and a window
+void test_DMM_watch_start_invalid(void)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    ADC_LL_set_complete_callback_Ignore();
+    ADC_LL_init_Stub(adc_init_success_stub);
+    ADC_LL_get_sample_rate_IgnoreAndReturn(1000);
+    TIM_LL_init_IgnoreAndReturn(1000);
+    TIM_LL_start_Ignore();
+    ADC_LL_start_Ignore();
+    g_test_handle = DMM_init(&config);
+
+    TRY {
+        DMM_watch_start(g_test_handle, FIXED_ZERO, FIXED_FROM_INT(1), nullptr);
+        TEST_FAIL_MESSAGE("Expected exception for a single-shot DMM");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+
+    exception = CEXCEPTION_NONE;
+    TRY {
+        DMM_watch_start(g_test_handle, FIXED_FROM_INT(1), FIXED_ZERO, nullptr);
+        TEST_FAIL_MESSAGE("Expected exception for an empty window");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+}
+
+// Test: A count alternates the windows and times each rising crossing
+void test_DMM_count_crossings(void)
+{
+    uint32_t timestamps[4] = { 0 };
+    init_averaging_dmm();
+
+    // Counted above 2 V, code 2481, after falling below 1 V, code 1241
+    ADC_LL_get_reference_voltage_IgnoreAndReturn(3300);
+    PLATFORM_get_time_us_ExpectAndReturn(100);
+    ADC_LL_set_watchdog_callback_Expect(dmm_adc_watchdog_callback);
+    ADC_LL_arm_watchdog_Expect(1241, 4095);
+    DMM_count_start(
+        g_test_handle, FIXED_FROM_INT(2), FIXED_FROM_INT(1), true
+    );
+
+    // Falling below the hysteresis arms the count without counting
+    ADC_LL_arm_watchdog_Expect(0, 2481);
+    dmm_adc_watchdog_callback();
+    TEST_ASSERT_EQUAL_UINT32(0, DMM_count_events(g_test_handle));
+
+    PLATFORM_get_time_us_ExpectAndReturn(350);
+    ADC_LL_arm_watchdog_Expect(1241, 4095);
+    dmm_adc_watchdog_callback();
+    TEST_ASSERT_EQUAL_UINT32(1, DMM_count_events(g_test_handle));
+
+    // Times are taken once
+    TEST_ASSERT_EQUAL_UINT32(
+        1, DMM_count_take_timestamps(g_test_handle, timestamps, 4)
+    );
+    TEST_ASSERT_EQUAL_UINT32(250, timestamps[0]);
+    TEST_ASSERT_EQUAL_UINT32(
+        0, DMM_count_take_timestamps(g_test_handle, timestamps, 4)
+    );
+
+    ADC_LL_disarm_watchdog_Expect();
+    ADC_LL_set_watchdog_callback_Expect(NULL);
+    DMM_count_stop(g_test_handle);
+    TEST_ASSERT_EQUAL_UINT32(0, DMM_count_events(g_test_handle));
+
+    // Crossings after the end of a count are not seen
+    dmm_adc_watchdog_callback();
+}
+
+// Test: A count needs a level inside the ADC range and a hysteresis
+void test_DMM_count_start_invalid(void)
+{
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+    init_averaging_dmm();
+    ADC_LL_get_reference_voltage_IgnoreAndReturn(3300);
+
+    TRY {
+        DMM_count_start(
+            g_test_handle, FIXED_FROM_INT(1), -FIXED_FROM_INT(1), false
+        );
+        TEST_FAIL_MESSAGE("Expected exception for a negative hysteresis");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+
+    // No conversion can rise above full scale
+    exception = CEXCEPTION_NONE;
+    TRY {
+        DMM_count_start(
+            g_test_handle, FIXED_FROM_INT(10), FIXED_FROM_INT(1), false
+        );
+        TEST_FAIL_MESSAGE("Expected exception for a level beyond range");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
     }
 }
 
-// Stub function to simulate ADC initialization success
-void adc_init_success_stub(ADC_LL_Config const *config, int cmock_num_calls)
+// Stub checking that a burst fills the ring once
+void adc_init_burst_stub(ADC_LL_Config const *config, int cmock_num_calls)
 {
     (void)cmock_num_calls;
-    // Verify config is reasonable
-    TEST_ASSERT_NOT_NULL(config);
-    TEST_ASSERT_EQUAL(ADC_LL_MODE_SINGLE, config->mode);
-    TEST_ASSERT_EQUAL(ADC_TRIGGER_TIMER6, config->trigger_source);
-    TEST_ASSERT_NOT_NULL(config->output_buffer);
-    TEST_ASSERT_EQUAL(1, config->buffer_size);
-
-    // Capture the output buffer for later use
+    TEST_ASSERT_FALSE(config->circular);
+    TEST_ASSERT_EQUAL(4, config->buffer_size);
     g_captured_adc_buffer = config->output_buffer;
 }
 
-// Test: Successful DMM initialization with default configuration
-void test_DMM_init_success_default_config(void)
+// Test: A timed burst is paced by the timer and read in place
+void test_DMM_read_burst(void)
 {
-    // Arrange
     DMM_Config config = DMM_CONFIG_DEFAULT;
+    config.burst_samples = 4;
+    config.burst_rate = 100;
+    FIXED_Q1616 voltages[8] = { 0 };
 
-    // Set expectations
-    ADC_LL_set_complete_callback_Expect(dmm_adc_complete_callback);
-    ADC_LL_init_Stub(adc_init_success_stub);
-    ADC_LL_get_sample_rate_ExpectAndReturn(1000); // 1 kHz sample rate for timer init
-    ADC_LL_get_sample_rate_ExpectAndReturn(1000); // 1 kHz sample rate for logging
-    TIM_LL_init_Expect(TIM_NUM_6, 1000);
-    TIM_LL_start_Expect(TIM_NUM_6); // Expect timer start for initial conversion
-    ADC_LL_start_Expect(); // Expect ADC start for initial conversion
-
-    // Act
+    ADC_LL_set_complete_callback_Stub(capture_adc_callback_stub);
+    ADC_LL_init_Stub(adc_init_burst_stub);
+    ADC_LL_get_sample_rate_ExpectAndReturn(2000000);
+    ADC_LL_get_sample_rate_ExpectAndReturn(2000000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 100, 100);
+    TIM_LL_start_Expect(TIM_NUM_6);
+    ADC_LL_start_Expect();
     g_test_handle = DMM_init(&config);
-
-    // Assert
     TEST_ASSERT_NOT_NULL(g_test_handle);
+
+    // Nothing to read while the burst runs
+    TEST_ASSERT_EQUAL_UINT32(0, DMM_read_burst(g_test_handle, voltages, 0, 8));
+
+    uint16_t const samples[] = { 0, 4095, 0, 4095 };
+    memcpy(g_captured_adc_buffer, samples, sizeof(samples));
+    g_stored_callback(g_captured_adc_buffer, 4);
+
+    // Read from the second conversion to the end of the burst
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    TEST_ASSERT_EQUAL_UINT32(3, DMM_read_burst(g_test_handle, voltages, 1, 8));
+    FIXED_Q1616 tolerance = FIXED_FROM_FLOAT(0.01f);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(3.3f), voltages[0]);
+    TEST_ASSERT_EQUAL_INT32(FIXED_ZERO, voltages[1]);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(3.3f), voltages[2]);
+    TEST_ASSERT_EQUAL_UINT32(0, DMM_read_burst(g_test_handle, voltages, 4, 8));
 }
 
-// Test: DMM initialization with custom configuration
-void test_DMM_init_success_custom_config(void)
+// Test: Burst statistics give the RMS of the AC part of the burst
+void test_DMM_read_burst_statistics(void)
 {
-    // Arrange
-    DMM_Config config = {
-        .channel = DMM_CHANNEL_5,
-        .oversampling_ratio = 64
-    };
-
-    // Set expectations
-    ADC_LL_set_complete_callback_Expect(dmm_adc_complete_callback);
-    ADC_LL_init_Ignore();
-    ADC_LL_get_sample_rate_ExpectAndReturn(2000); // 2 kHz sample rate for timer init
-    ADC_LL_get_sample_rate_ExpectAndReturn(2000); // 2 kHz sample rate for logging
-    TIM_LL_init_Expect(TIM_NUM_6, 2000);
-    TIM_LL_start_Expect(TIM_NUM_6); // Expect timer start for initial conversion
-    ADC_LL_start_Expect(); // Expect ADC start for initial conversion
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    config.burst_samples = 4;
+    config.burst_rate = 100;
+    DMM_Statistics statistics = { 0 };
 
-    // Act
+    ADC_LL_set_complete_callback_Stub(capture_adc_callback_stub);
+    ADC_LL_init_Stub(adc_init_burst_stub);
+    ADC_LL_get_sample_rate_ExpectAndReturn(2000000);
+    ADC_LL_get_sample_rate_ExpectAndReturn(2000000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 100, 100);
+    TIM_LL_start_Expect(TIM_NUM_6);
+    ADC_LL_start_Expect();
     g_test_handle = DMM_init(&config);
 
-    // Assert
-    TEST_ASSERT_NOT_NULL(g_test_handle);
+    // Nothing to report while the burst runs
+    TEST_ASSERT_FALSE(DMM_read_burst_statistics(g_test_handle, &statistics));
+
+    uint16_t const samples[] = { 1000, 3000, 1000, 3000 };
+    memcpy(g_captured_adc_buffer, samples, sizeof(samples));
+    g_stored_callback(g_captured_adc_buffer, 4);
+
+    // Mean code 2000, AC RMS code 1000, DC-inclusive RMS code 2236.1
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    TEST_ASSERT_TRUE(DMM_read_burst_statistics(g_test_handle, &statistics));
+    FIXED_Q1616 tolerance = FIXED_FROM_FLOAT(0.01f);
+    TEST_ASSERT_EQUAL_UINT32(4, statistics.samples);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(1.612f), statistics.mean);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(0.806f), statistics.ac_rms);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(1.802f), statistics.rms);
 }
 
-// Test: DMM initialization with NULL config
-void test_DMM_init_null_config(void)
+// Test: Oversampled burst conversions must keep up with the burst rate
+void test_DMM_init_burst_rate_too_high(void)
 {
-    // Arrange
+    DMM_Config config = DMM_CONFIG_DEFAULT;
     CEXCEPTION_T exception = CEXCEPTION_NONE;
+    config.burst_samples = 4;
+    config.burst_rate = 100; // 1600 conversions per second at 16x
+
+    ADC_LL_set_complete_callback_Ignore();
+    ADC_LL_init_Stub(adc_init_burst_stub);
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
+    ADC_LL_deinit_Expect();
 
-    // Act & Assert
     TRY {
-        g_test_handle = DMM_init(NULL);
-        TEST_FAIL_MESSAGE("Expected exception for NULL config");
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for a burst rate too high");
     }
     CATCH(exception) {
         TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
@@ -168,37 +1118,88 @@ void test_DMM_init_null_config(void)
     }
 }
 
-// Test: DMM initialization with invalid channel
-void test_DMM_init_invalid_channel(void)
+// Stub checking that an aperture paces a ring of whole mains cycles
+void adc_init_aperture_stub(ADC_LL_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_TRUE(config->circular);
+    TEST_ASSERT_EQUAL(128, config->buffer_size); // 2 cycles of 64 samples
+    TEST_ASSERT_EQUAL_UINT32(3840 * 16, config->conversion_rate);
+    g_captured_adc_buffer = config->output_buffer;
+}
+
+// Test: An aperture in power-line cycles averages over the whole aperture
+void test_DMM_read_statistics_aperture(void)
+{
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    DMM_Statistics statistics = { 0 };
+    config.nplc = 2;
+    config.line_frequency = 60;
+
+    // 64 samples per cycle is as fast as the ADC goes at 16x
+    ADC_LL_get_max_sample_rate_ExpectAndReturn(
+        ADC_LL_MODE_SINGLE, ADC_LL_RESOLUTION_12BIT, 60 * 16 * 64
+    );
+    ADC_LL_set_complete_callback_Stub(capture_adc_callback_stub);
+    ADC_LL_set_half_complete_callback_Expect(dmm_adc_complete_callback);
+    ADC_LL_init_Stub(adc_init_aperture_stub);
+    ADC_LL_get_sample_rate_ExpectAndReturn(100000);
+    ADC_LL_get_sample_rate_ExpectAndReturn(100000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 3840, 3840);
+    TIM_LL_start_Expect(TIM_NUM_6);
+    ADC_LL_start_Expect();
+    g_test_handle = DMM_init(&config);
+    TEST_ASSERT_NOT_NULL(g_test_handle);
+
+    for (uint32_t i = 0; i < 128; ++i) {
+        g_captured_adc_buffer[i] = 2047;
+    }
+
+    // One cycle is not the aperture yet
+    g_stored_callback(g_captured_adc_buffer, 64);
+    TEST_ASSERT_FALSE(DMM_read_statistics(g_test_handle, &statistics));
+
+    g_stored_callback(g_captured_adc_buffer + 64, 64);
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    TEST_ASSERT_TRUE(DMM_read_statistics(g_test_handle, &statistics));
+    TEST_ASSERT_EQUAL_UINT32(128, statistics.samples);
+    FIXED_Q1616 tolerance = FIXED_FROM_FLOAT(0.01f);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(1.649f), statistics.mean);
+}
+
+// Test: Apertures need a known line frequency and no window of their own
+void test_DMM_init_invalid_aperture(void)
 {
-    // Arrange
     DMM_Config config = DMM_CONFIG_DEFAULT;
-    config.channel = (DMM_Channel)999; // Invalid channel
     CEXCEPTION_T exception = CEXCEPTION_NONE;
 
-    // Act & Assert
+    config.nplc = 1;
+    config.line_frequency = 55;
     TRY {
         g_test_handle = DMM_init(&config);
-        TEST_FAIL_MESSAGE("Expected exception for invalid channel");
+        TEST_FAIL_MESSAGE("Expected exception for a 55 Hz line");
     }
     CATCH(exception) {
         TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
-        TEST_ASSERT_NULL(g_test_handle);
     }
-}
 
-// Test: DMM initialization with invalid oversampling ratio
-void test_DMM_init_invalid_oversampling_ratio(void)
-{
-    // Arrange
-    DMM_Config config = DMM_CONFIG_DEFAULT;
-    config.oversampling_ratio = 7; // Not power of 2
-    CEXCEPTION_T exception = CEXCEPTION_NONE;
+    config.line_frequency = 50;
+    config.average_window = 8;
+    exception = CEXCEPTION_NONE;
+    TRY {
+        g_test_handle = DMM_init(&config);
+        TEST_FAIL_MESSAGE("Expected exception for an aperture with a window");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
 
-    // Act & Assert
+    config.average_window = 0;
+    config.nplc = DMM_NPLC_MAX + 1;
+    exception = CEXCEPTION_NONE;
     TRY {
         g_test_handle = DMM_init(&config);
-        TEST_FAIL_MESSAGE("Expected exception for invalid oversampling ratio");
+        TEST_FAIL_MESSAGE("Expected exception for an oversized aperture");
     }
     CATCH(exception) {
         TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
@@ -206,79 +1207,118 @@ void test_DMM_init_invalid_oversampling_ratio(void)
     }
 }
 
-// Test: DMM initialization when already initialized
-void test_DMM_init_already_initialized(void)
+// Test: DMM shares an ADC owned by another instrument
+void test_DMM_init_shared_adc(void)
 {
     // Arrange
-    DMM_Config config = DMM_CONFIG_DEFAULT;
-    CEXCEPTION_T exception = CEXCEPTION_NONE;
+    DMM_Config config = {
+        .channel = DMM_CHANNEL_5,
+        .oversampling_ratio = 64
+    };
+    ADC_LL_is_initialized_IgnoreAndReturn(true);
 
-    // First initialization
-    ADC_LL_set_complete_callback_Expect(dmm_adc_complete_callback);
-    ADC_LL_init_Ignore();
-    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
-    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
-    TIM_LL_init_Expect(TIM_NUM_6, 1000);
-    TIM_LL_start_Expect(TIM_NUM_6);
-    ADC_LL_start_Expect();
+    // Injected conversions need neither the regular group nor a timer
+    ADC_LL_injected_init_Expect(ADC_LL_CHANNEL_5, 64, 6);
+    ADC_LL_set_injected_callback_Expect(dmm_adc_injected_callback);
+    ADC_LL_injected_start_Expect();
 
+    // Act
     g_test_handle = DMM_init(&config);
+
+    // Assert
     TEST_ASSERT_NOT_NULL(g_test_handle);
 
-    // Act & Assert - Try to initialize again
-    TRY {
-        DMM_Handle *second_handle = DMM_init(&config);
-        TEST_FAIL_MESSAGE("Expected exception for double initialization");
-    }
-    CATCH(exception) {
-        TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, exception);
-    }
+    // Deinit releases only the injected channel
+    ADC_LL_injected_deinit_Expect();
+    DMM_deinit(g_test_handle);
+    g_test_handle = NULL;
 }
 
-// Test: DMM initialization with ADC failure
-void test_DMM_init_adc_failure(void)
+// Test: Reading on a shared ADC restarts the injected measurement
+void test_DMM_read_voltage_shared_adc(void)
 {
     // Arrange
     DMM_Config config = DMM_CONFIG_DEFAULT;
-    CEXCEPTION_T exception = CEXCEPTION_NONE;
+    FIXED_Q1616 voltage_out;
+    ADC_LL_is_initialized_IgnoreAndReturn(true);
+    ADC_LL_injected_init_Expect(ADC_LL_CHANNEL_0, 16, 4);
+    ADC_LL_set_injected_callback_Expect(dmm_adc_injected_callback);
+    ADC_LL_injected_start_Expect();
 
-    // Set expectations
-    ADC_LL_set_complete_callback_Expect(dmm_adc_complete_callback);
-    ADC_LL_init_ExpectAndThrow(NULL, ERROR_HARDWARE_FAULT);
-    ADC_LL_init_IgnoreArg_config(); // Ignore the config parameter
+    g_test_handle = DMM_init(&config);
+    TEST_ASSERT_NOT_NULL(g_test_handle);
 
-    // Act & Assert
-    TRY {
-        g_test_handle = DMM_init(&config);
-        TEST_FAIL_MESSAGE("Expected exception for ADC initialization failure");
-    }
-    CATCH(exception) {
-        TEST_ASSERT_EQUAL(ERROR_HARDWARE_FAULT, exception);
-        TEST_ASSERT_NULL(g_test_handle);
-    }
+    // No measurement yet
+    TEST_ASSERT_FALSE(DMM_read_voltage(g_test_handle, &voltage_out));
+
+    // Half-scale measurement completes
+    dmm_adc_injected_callback(2047);
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    ADC_LL_try_injected_start_ExpectAndReturn(ERROR_NONE);
+
+    // Act
+    bool result = DMM_read_voltage(g_test_handle, &voltage_out);
+
+    // Assert
+    TEST_ASSERT_TRUE(result);
+    // Expected: (2047 * 3.3V) / 4095 ≈ 1.648V
+    FIXED_Q1616 expected_half = FIXED_FROM_FLOAT(1.648f);
+    FIXED_Q1616 tolerance = FIXED_FROM_FLOAT(0.01f);
+    TEST_ASSERT_GREATER_OR_EQUAL_INT32(expected_half - tolerance, voltage_out);
+    TEST_ASSERT_LESS_OR_EQUAL_INT32(expected_half + tolerance, voltage_out);
 }
 
-// Test: DMM initialization with timer failure
-void test_DMM_init_timer_failure(void)
+// Test: High resolution keeps the extra bits of the oversampled sum and
+// scales readings to the wider full scale
+void test_DMM_read_voltage_high_resolution(void)
+{
+    // Arrange: a sum of 8 conversions has 15 bits, none shifted out
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    config.oversampling_ratio = 8;
+    config.high_resolution = true;
+    FIXED_Q1616 voltage_out;
+    ADC_LL_is_initialized_IgnoreAndReturn(true);
+    ADC_LL_injected_init_Expect(ADC_LL_CHANNEL_0, 8, 0);
+    ADC_LL_set_injected_callback_Expect(dmm_adc_injected_callback);
+    ADC_LL_injected_start_Expect();
+
+    g_test_handle = DMM_init(&config);
+    TEST_ASSERT_NOT_NULL(g_test_handle);
+
+    // Half of the full scale of 8 * 4095
+    dmm_adc_injected_callback(16380);
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    ADC_LL_try_injected_start_ExpectAndReturn(ERROR_NONE);
+
+    // Act
+    bool result = DMM_read_voltage(g_test_handle, &voltage_out);
+
+    // Assert
+    TEST_ASSERT_TRUE(result);
+    TEST_ASSERT_INT32_WITHIN(
+        FIXED_FROM_FLOAT(0.001f), FIXED_FROM_FLOAT(1.65f), voltage_out
+    );
+}
+
+// Test: Shared init failure leaves the injected channel free
+void test_DMM_init_shared_adc_busy(void)
 {
     // Arrange
     DMM_Config config = DMM_CONFIG_DEFAULT;
     CEXCEPTION_T exception = CEXCEPTION_NONE;
-
-    // Set expectations - ADC init succeeds, but timer init fails
-    ADC_LL_set_complete_callback_Expect(dmm_adc_complete_callback);
-    ADC_LL_init_Ignore(); // ADC init succeeds
-    ADC_LL_get_sample_rate_ExpectAndReturn(1000); // For timer init
-    TIM_LL_init_ExpectAndThrow(TIM_NUM_6, 1000, ERROR_HARDWARE_FAULT);
-    ADC_LL_deinit_Expect(); // Cleanup after timer failure
+    ADC_LL_is_initialized_IgnoreAndReturn(true);
+    ADC_LL_injected_init_ExpectAndThrow(
+        ADC_LL_CHANNEL_0, 16, 4, ERROR_RESOURCE_BUSY
+    );
+    ADC_LL_injected_deinit_Expect();
 
     // Act & Assert
     TRY {
         g_test_handle = DMM_init(&config);
-        TEST_FAIL_MESSAGE("Expected exception for timer initialization failure");
+        TEST_FAIL_MESSAGE("Expected exception for busy injected channel");
     }
     CATCH(exception) {
-        TEST_ASSERT_EQUAL(ERROR_HARDWARE_FAULT, exception);
+        TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, exception);
         TEST_ASSERT_NULL(g_test_handle);
     }
 }
@@ -293,7 +1333,7 @@ void test_DMM_deinit_valid_handle(void)
     ADC_LL_init_Ignore();
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
-    TIM_LL_init_Expect(TIM_NUM_6, 1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
     TIM_LL_start_Expect(TIM_NUM_6);
     ADC_LL_start_Expect();
 
@@ -336,7 +1376,7 @@ void test_DMM_read_voltage_success_conversion_ready(void)
     ADC_LL_init_Ignore();
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
-    TIM_LL_init_Expect(TIM_NUM_6, 1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
     TIM_LL_start_Expect(TIM_NUM_6);
     ADC_LL_start_Expect();
 
@@ -348,7 +1388,7 @@ void test_DMM_read_voltage_success_conversion_ready(void)
 
     // Expect reference voltage query and next conversion to be started
     ADC_LL_get_reference_voltage_ExpectAndReturn(3300); // 3.3V in mV
-    ADC_LL_start_Expect();
+    ADC_LL_try_start_ExpectAndReturn(ERROR_NONE);
 
     // Act
     result = DMM_read_voltage(g_test_handle, &voltage_out);
@@ -370,7 +1410,7 @@ void test_DMM_read_voltage_no_conversion_ready(void)
     ADC_LL_init_Ignore();
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
-    TIM_LL_init_Expect(TIM_NUM_6, 1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
     TIM_LL_start_Expect(TIM_NUM_6);
     ADC_LL_start_Expect();
 
@@ -387,6 +1427,57 @@ void test_DMM_read_voltage_no_conversion_ready(void)
     TEST_ASSERT_EQUAL(FIXED_ZERO, voltage_out);
 }
 
+// Test: The return-code read reports a measurement through ready
+void test_DMM_try_read_voltage_success(void)
+{
+    // Arrange
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    FIXED_Q1616 voltage_out = 0;
+    bool ready = false;
+
+    ADC_LL_set_complete_callback_Expect(dmm_adc_complete_callback);
+    ADC_LL_init_Ignore();
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
+    TIM_LL_start_Expect(TIM_NUM_6);
+    ADC_LL_start_Expect();
+
+    g_test_handle = DMM_init(&config);
+    TEST_ASSERT_NOT_NULL(g_test_handle);
+
+    // No conversion yet
+    TEST_ASSERT_EQUAL(
+        ERROR_NONE, DMM_try_read_voltage(g_test_handle, &voltage_out, &ready)
+    );
+    TEST_ASSERT_FALSE(ready);
+
+    simulate_adc_conversion(2047);
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    ADC_LL_try_start_ExpectAndReturn(ERROR_NONE);
+
+    // Act
+    Error const error =
+        DMM_try_read_voltage(g_test_handle, &voltage_out, &ready);
+
+    // Assert
+    TEST_ASSERT_EQUAL(ERROR_NONE, error);
+    TEST_ASSERT_TRUE(ready);
+    TEST_ASSERT_INT32_WITHIN(FIXED_FROM_FLOAT(0.01f), FIXED_FROM_FLOAT(1.65f), voltage_out);
+}
+
+// Test: The return-code read returns the errors DMM_read_voltage throws
+void test_DMM_try_read_voltage_invalid(void)
+{
+    FIXED_Q1616 voltage_out = 0;
+    bool ready = true;
+
+    TEST_ASSERT_EQUAL(
+        ERROR_INVALID_ARGUMENT, DMM_try_read_voltage(NULL, &voltage_out, &ready)
+    );
+    TEST_ASSERT_FALSE(ready);
+}
+
 // Test: Voltage reading with NULL handle
 void test_DMM_read_voltage_null_handle(void)
 {
@@ -416,7 +1507,7 @@ void test_DMM_read_voltage_null_output(void)
     ADC_LL_init_Ignore();
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
-    TIM_LL_init_Expect(TIM_NUM_6, 1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
     TIM_LL_start_Expect(TIM_NUM_6);
     ADC_LL_start_Expect();
 
@@ -446,7 +1537,7 @@ void test_DMM_read_voltage_adc_start_failure(void)
     ADC_LL_init_Ignore();
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
-    TIM_LL_init_Expect(TIM_NUM_6, 1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
     TIM_LL_start_Expect(TIM_NUM_6);
     ADC_LL_start_Expect(); // Initial start succeeds
 
@@ -458,7 +1549,7 @@ void test_DMM_read_voltage_adc_start_failure(void)
 
     // Expect reference voltage query and ADC restart to fail
     ADC_LL_get_reference_voltage_ExpectAndReturn(3300); // 3.3V in mV
-    ADC_LL_start_ExpectAndThrow(ERROR_HARDWARE_FAULT);
+    ADC_LL_try_start_ExpectAndReturn(ERROR_HARDWARE_FAULT);
 
     // Act - this should still return the valid measurement despite restart failure
     result = DMM_read_voltage(g_test_handle, &voltage_out);
@@ -480,7 +1571,7 @@ void test_DMM_read_voltage_timer_start_failure(void)
     ADC_LL_init_Ignore(); // ADC init succeeds
     ADC_LL_get_sample_rate_ExpectAndReturn(1000); // For timer init
     ADC_LL_get_sample_rate_ExpectAndReturn(1000); // For logging
-    TIM_LL_init_Expect(TIM_NUM_6, 1000); // Timer init succeeds
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000); // Timer init succeeds
     TIM_LL_start_Expect(TIM_NUM_6); // Timer start succeeds
     ADC_LL_start_ExpectAndThrow(ERROR_HARDWARE_FAULT); // ADC start fails
     TIM_LL_stop_Expect(TIM_NUM_6); // Cleanup after start failure
@@ -512,7 +1603,7 @@ void test_DMM_voltage_calculation_zero_adc(void)
     ADC_LL_init_Stub(adc_init_success_stub);
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
-    TIM_LL_init_Expect(TIM_NUM_6, 1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
     TIM_LL_start_Expect(TIM_NUM_6);
     ADC_LL_start_Expect();
 
@@ -523,7 +1614,7 @@ void test_DMM_voltage_calculation_zero_adc(void)
     simulate_adc_conversion(0);
 
     ADC_LL_get_reference_voltage_ExpectAndReturn(3300); // 3.3V in mV
-    ADC_LL_start_Expect(); // Only expect ADC restart, timer keeps running
+    ADC_LL_try_start_ExpectAndReturn(ERROR_NONE); // Only expect ADC restart, timer keeps running
 
     // Act
     result = DMM_read_voltage(g_test_handle, &voltage_out);
@@ -547,7 +1638,7 @@ void test_DMM_voltage_calculation_half_scale_adc(void)
     ADC_LL_init_Stub(adc_init_success_stub);
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
-    TIM_LL_init_Expect(TIM_NUM_6, 1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
     TIM_LL_start_Expect(TIM_NUM_6);
     ADC_LL_start_Expect();
 
@@ -560,7 +1651,7 @@ void test_DMM_voltage_calculation_half_scale_adc(void)
     simulate_adc_conversion(2047);
 
     ADC_LL_get_reference_voltage_ExpectAndReturn(3300); // 3.3V in mV
-    ADC_LL_start_Expect(); // Only expect ADC restart, timer keeps running
+    ADC_LL_try_start_ExpectAndReturn(ERROR_NONE); // Only expect ADC restart, timer keeps running
 
     // Act
     result = DMM_read_voltage(g_test_handle, &voltage_out);
@@ -575,6 +1666,42 @@ void test_DMM_voltage_calculation_half_scale_adc(void)
     TEST_ASSERT_LESS_OR_EQUAL_INT32(expected_half + tolerance, voltage_out);
 }
 
+// Test: Readings are corrected with the calibration of their channel
+void test_DMM_voltage_calculation_calibrated(void)
+{
+    // Arrange
+    DMM_Config config = DMM_CONFIG_DEFAULT;
+    config.oversampling_ratio = 1;
+    FIXED_Q1616 voltage_out;
+    CALIBRATION_Entry const entry = {
+        .gain = FIXED_from_fraction(101, 100),
+        .offset = FIXED_from_fraction(-50, 1000),
+    };
+    CALIBRATION_set(CALIBRATION_MODE_DMM, 0, &entry);
+
+    ADC_LL_set_complete_callback_Stub(capture_adc_callback_stub);
+    ADC_LL_init_Stub(adc_init_success_stub);
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
+    ADC_LL_get_sample_rate_ExpectAndReturn(1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
+    TIM_LL_start_Expect(TIM_NUM_6);
+    ADC_LL_start_Expect();
+
+    g_test_handle = DMM_init(&config);
+    TEST_ASSERT_NOT_NULL(g_test_handle);
+    simulate_adc_conversion(2047);
+
+    ADC_LL_get_reference_voltage_ExpectAndReturn(3300);
+    ADC_LL_try_start_ExpectAndReturn(ERROR_NONE);
+
+    // Act
+    TEST_ASSERT_TRUE(DMM_read_voltage(g_test_handle, &voltage_out));
+
+    // Assert: 1.6496 V * 1.01 - 0.05 V
+    FIXED_Q1616 tolerance = FIXED_FROM_FLOAT(0.001f);
+    TEST_ASSERT_INT32_WITHIN(tolerance, FIXED_FROM_FLOAT(1.6161f), voltage_out);
+}
+
 // Test: Voltage calculation with full-scale ADC value
 void test_DMM_voltage_calculation_full_scale_adc(void)
 {
@@ -589,7 +1716,7 @@ void test_DMM_voltage_calculation_full_scale_adc(void)
     ADC_LL_init_Stub(adc_init_success_stub);
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
-    TIM_LL_init_Expect(TIM_NUM_6, 1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
     TIM_LL_start_Expect(TIM_NUM_6);
     ADC_LL_start_Expect();
 
@@ -600,7 +1727,7 @@ void test_DMM_voltage_calculation_full_scale_adc(void)
     simulate_adc_conversion(4095);
 
     ADC_LL_get_reference_voltage_ExpectAndReturn(3300); // 3.3V in mV
-    ADC_LL_start_Expect(); // Only expect ADC restart, timer keeps running
+    ADC_LL_try_start_ExpectAndReturn(ERROR_NONE); // Only expect ADC restart, timer keeps running
 
     // Act
     result = DMM_read_voltage(g_test_handle, &voltage_out);
@@ -628,7 +1755,7 @@ void test_DMM_voltage_calculation_with_oversampling(void)
     ADC_LL_init_Stub(adc_init_success_stub);
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
     ADC_LL_get_sample_rate_ExpectAndReturn(1000);
-    TIM_LL_init_Expect(TIM_NUM_6, 1000);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
     TIM_LL_start_Expect(TIM_NUM_6);
     ADC_LL_start_Expect();
 
@@ -640,7 +1767,7 @@ void test_DMM_voltage_calculation_with_oversampling(void)
     simulate_adc_conversion(2047);
 
     ADC_LL_get_reference_voltage_ExpectAndReturn(3300); // 3.3V in mV
-    ADC_LL_start_Expect(); // Only expect ADC restart, timer keeps running
+    ADC_LL_try_start_ExpectAndReturn(ERROR_NONE); // Only expect ADC restart, timer keeps running
 
     // Act
     result = DMM_read_voltage(g_test_handle, &voltage_out);
@@ -668,7 +1795,7 @@ void test_DMM_config_validation_edge_cases(void)
         ADC_LL_init_Ignore();
         ADC_LL_get_sample_rate_ExpectAndReturn(1000);
         ADC_LL_get_sample_rate_ExpectAndReturn(1000);
-        TIM_LL_init_Expect(TIM_NUM_6, 1000);
+        TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
         TIM_LL_start_Expect(TIM_NUM_6);
         ADC_LL_start_Expect();
 
@@ -710,7 +1837,7 @@ void test_DMM_channel_mapping(void)
         ADC_LL_init_Ignore();
         ADC_LL_get_sample_rate_ExpectAndReturn(1000);
         ADC_LL_get_sample_rate_ExpectAndReturn(1000);
-        TIM_LL_init_Expect(TIM_NUM_6, 1000);
+        TIM_LL_init_ExpectAndReturn(TIM_NUM_6, 1000, 1000);
         TIM_LL_start_Expect(TIM_NUM_6);
         ADC_LL_start_Expect();
 
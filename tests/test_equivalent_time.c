@@ -0,0 +1,137 @@
+/**
+ * @file test_equivalent_time.c
+ * @brief Unit tests for equivalent-time waveform reconstruction
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "util/equivalent_time.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_ETS_find_crossing_interpolates_phase(void)
+{
+    uint16_t const samples[] = { 0, 100, 400, 1000, 1000 };
+    ETS_Crossing crossing = { 0 };
+
+    // Level 250 is half way from 100 to 400, half a period before sample 2
+    bool const found =
+        ETS_find_crossing(samples, 5, 4, 250, true, 4, &crossing);
+
+    TEST_ASSERT_TRUE(found);
+    TEST_ASSERT_EQUAL_UINT32(2, crossing.index);
+    TEST_ASSERT_EQUAL_UINT32(2, crossing.phase);
+}
+
+void test_ETS_find_crossing_searches_backwards_from_hint(void)
+{
+    // Rising crossings before samples 1 and 4
+    uint16_t const samples[] = { 0, 500, 0, 0, 500, 500 };
+    ETS_Crossing crossing = { 0 };
+
+    bool const found =
+        ETS_find_crossing(samples, 6, 5, 250, true, 2, &crossing);
+
+    TEST_ASSERT_TRUE(found);
+    TEST_ASSERT_EQUAL_UINT32(4, crossing.index);
+    TEST_ASSERT_EQUAL_UINT32(1, crossing.phase);
+}
+
+void test_ETS_find_crossing_falling(void)
+{
+    uint16_t const samples[] = { 800, 800, 200, 200 };
+    ETS_Crossing crossing = { 0 };
+
+    // Level 650 is a quarter of the way down from 800 to 200
+    bool const found =
+        ETS_find_crossing(samples, 4, 3, 650, false, 4, &crossing);
+
+    TEST_ASSERT_TRUE(found);
+    TEST_ASSERT_EQUAL_UINT32(2, crossing.index);
+    TEST_ASSERT_EQUAL_UINT32(3, crossing.phase);
+}
+
+void test_ETS_find_crossing_none(void)
+{
+    uint16_t const samples[] = { 800, 700, 600, 500 };
+    ETS_Crossing crossing = { 0 };
+
+    TEST_ASSERT_FALSE(
+        ETS_find_crossing(samples, 4, 3, 650, true, 4, &crossing)
+    );
+}
+
+void test_ETS_insert_interleaves_phases(void)
+{
+    uint16_t record[6];
+    uint16_t const first[] = { 10, 20, 30 };
+    uint16_t const second[] = { 15, 25, 35 };
+    ETS_Crossing const at_sample = { .index = 1, .phase = 0 };
+    ETS_Crossing const half_later = { .index = 1, .phase = 1 };
+
+    ETS_clear(record, 6);
+    ETS_insert(first, 3, &at_sample, 2, 2, record, 6);
+    ETS_insert(second, 3, &half_later, 2, 2, record, 6);
+
+    uint16_t const expected[] = { 10, 15, 20, 25, 30, 35 };
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, record, 6);
+}
+
+void test_ETS_insert_drops_samples_outside_record(void)
+{
+    uint16_t record[4];
+    uint16_t const samples[] = { 1, 2, 3, 4, 5 };
+    ETS_Crossing const crossing = { .index = 2, .phase = 0 };
+
+    ETS_clear(record, 4);
+    ETS_insert(samples, 5, &crossing, 2, 1, record, 4);
+
+    uint16_t const expected[] = { ETS_EMPTY, 3, ETS_EMPTY, 4 };
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, record, 4);
+}
+
+void test_ETS_insert_averages_repeated_points(void)
+{
+    uint16_t record[2];
+    uint16_t const first[] = { 100, 200 };
+    uint16_t const second[] = { 101, 300 };
+    ETS_Crossing const crossing = { .index = 0, .phase = 0 };
+
+    ETS_clear(record, 2);
+    ETS_insert(first, 2, &crossing, 1, 0, record, 2);
+    ETS_insert(second, 2, &crossing, 1, 0, record, 2);
+
+    uint16_t const expected[] = { 101, 250 };
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, record, 2);
+}
+
+void test_ETS_fill_gaps_interpolates_and_extends(void)
+{
+    uint16_t record[] = { ETS_EMPTY, 100, ETS_EMPTY, ETS_EMPTY,
+                          40,        ETS_EMPTY };
+
+    uint32_t const empty = ETS_fill_gaps(record, 6);
+
+    uint16_t const expected[] = { 100, 100, 80, 60, 40, 40 };
+    TEST_ASSERT_EQUAL_UINT32(4, empty);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, record, 6);
+}
+
+void test_ETS_fill_gaps_without_samples(void)
+{
+    uint16_t record[] = { ETS_EMPTY, ETS_EMPTY };
+
+    uint32_t const empty = ETS_fill_gaps(record, 2);
+
+    uint16_t const expected[] = { 0, 0 };
+    TEST_ASSERT_EQUAL_UINT32(2, empty);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, record, 2);
+}
@@ -415,3 +415,337 @@ void test_FIXED_to_string(void)
     TEST_ASSERT_NOT_NULL(result);
     TEST_ASSERT_EQUAL_STRING("-32768.0", result);
 }
+
+/**
+ * @brief Test per-code factors for the batch conversions
+ */
+void test_FIXED_code_scale(void)
+{
+    // 3300 mV over 4095 codes, in units of 2^-16 mV
+    TEST_ASSERT_EQUAL_INT32(52813, FIXED_code_scale(3300, 4095));
+    TEST_ASSERT_EQUAL_INT32(FIXED_SCALE, FIXED_code_scale(4095, 4095));
+
+    // Invalid ranges
+    TEST_ASSERT_EQUAL_INT32(0, FIXED_code_scale(0, 4095));
+    TEST_ASSERT_EQUAL_INT32(0, FIXED_code_scale(-3300, 4095));
+    TEST_ASSERT_EQUAL_INT32(0, FIXED_code_scale(3300, 0));
+
+    // Saturation
+    TEST_ASSERT_EQUAL_INT32(
+        FIXED_CODE_SCALE_MAX, FIXED_code_scale(INT32_MAX, 1)
+    );
+}
+
+/**
+ * @brief Test batch conversion of codes to millivolts
+ */
+void test_FIXED_scale_u16_array_to_i16(void)
+{
+    uint16_t const codes[] = { 0, 1, 2048, 4095, 1241 };
+    int16_t out[5] = { 0 };
+    int32_t const scale = FIXED_code_scale(3300, 4095);
+
+    FIXED_scale_u16_array_to_i16(codes, 5, scale, out);
+
+    // 1 code = 0.806 mV and 1241 codes = 1000.05 mV round to nearest
+    int16_t const expected[] = { 0, 1, 1650, 3300, 1000 };
+    TEST_ASSERT_EQUAL_INT16_ARRAY(expected, out, 5);
+}
+
+/**
+ * @brief Test batch conversion in place, with an odd trailing code
+ */
+void test_FIXED_scale_u16_array_to_i16_in_place(void)
+{
+    uint16_t buffer[3] = { 4095, 0, 4095 };
+    int32_t const scale = FIXED_code_scale(1000, 4095);
+
+    FIXED_scale_u16_array_to_i16(buffer, 3, scale, (int16_t *)buffer);
+
+    TEST_ASSERT_EQUAL_UINT16(1000, buffer[0]);
+    TEST_ASSERT_EQUAL_UINT16(0, buffer[1]);
+    TEST_ASSERT_EQUAL_UINT16(1000, buffer[2]);
+}
+
+/**
+ * @brief Test batch conversion of codes to Q16.16 volts
+ */
+void test_FIXED_scale_u16_array(void)
+{
+    uint16_t codes[4096];
+    FIXED_Q1616 out[4096];
+    FIXED_Q1616 const full_scale = FIXED_from_fraction(3300, 1000);
+    int32_t const scale = FIXED_code_scale(full_scale, 4095);
+
+    for (uint32_t i = 0; i < 4096; ++i) {
+        codes[i] = (uint16_t)i;
+    }
+
+    FIXED_scale_u16_array(codes, 4096, scale, out);
+
+    // Each result matches the scalar helpers within one LSB
+    for (uint32_t i = 0; i < 4096; ++i) {
+        FIXED_Q1616 const product = FIXED_mul(FIXED_FROM_INT(i), full_scale);
+        FIXED_Q1616 const scalar = FIXED_div(product, FIXED_FROM_INT(4095));
+        TEST_ASSERT_INT32_WITHIN(1, scalar, out[i]);
+    }
+    TEST_ASSERT_INT32_WITHIN(1, full_scale, out[4095]);
+    TEST_ASSERT_EQUAL_INT32(FIXED_ZERO, out[0]);
+}
+
+/**
+ * @brief Test scaling a single, possibly fractional, code
+ */
+void test_FIXED_scale_code(void)
+{
+    uint16_t codes[4096];
+    FIXED_Q1616 out[4096];
+    FIXED_Q1616 const full_scale = FIXED_from_fraction(3300, 1000);
+    int32_t const scale = FIXED_code_scale(full_scale, 4095);
+
+    for (uint32_t i = 0; i < 4096; ++i) {
+        codes[i] = (uint16_t)i;
+    }
+    FIXED_scale_u16_array(codes, 4096, scale, out);
+
+    // Integer codes match the batch conversion exactly
+    for (uint32_t i = 0; i < 4096; ++i) {
+        TEST_ASSERT_EQUAL_INT32(
+            out[i], FIXED_scale_code(FIXED_FROM_INT(i), scale)
+        );
+    }
+
+    // A fractional code lands halfway between its neighbours
+    FIXED_Q1616 const mid = FIXED_scale_code(
+        FIXED_FROM_INT(2047) + FIXED_HALF, scale
+    );
+    TEST_ASSERT_INT32_WITHIN(1, (out[2047] + out[2048]) / 2, mid);
+
+    // Negative codes round symmetrically
+    TEST_ASSERT_EQUAL_INT32(
+        -out[1000], FIXED_scale_code(-FIXED_FROM_INT(1000), scale)
+    );
+}
+
+/**
+ * @brief Test the integer square root
+ */
+void test_FIXED_isqrt64(void)
+{
+    TEST_ASSERT_EQUAL_UINT64(0, FIXED_isqrt64(0));
+    TEST_ASSERT_EQUAL_UINT64(1, FIXED_isqrt64(3));
+    TEST_ASSERT_EQUAL_UINT64(2, FIXED_isqrt64(4));
+    TEST_ASSERT_EQUAL_UINT64(65535, FIXED_isqrt64(65536ULL * 65536 - 1));
+    TEST_ASSERT_EQUAL_UINT64(UINT32_MAX, FIXED_isqrt64(UINT64_MAX));
+
+    // The root of a Q32.32 square is Q16.16
+    uint64_t const square = (uint64_t)FIXED_FROM_INT(3) * FIXED_FROM_INT(3);
+    TEST_ASSERT_EQUAL_UINT64(FIXED_FROM_INT(3), FIXED_isqrt64(square));
+}
+
+/**
+ * @brief Test the table sine at the quarter turns and in between
+ */
+void test_FIXED_sin(void)
+{
+    TEST_ASSERT_EQUAL_INT32(0, FIXED_sin(0));
+    TEST_ASSERT_EQUAL_INT32(FIXED_ONE, FIXED_sin(UINT32_C(1) << 30));
+    TEST_ASSERT_EQUAL_INT32(0, FIXED_sin(UINT32_C(2) << 30));
+    TEST_ASSERT_EQUAL_INT32(-FIXED_ONE, FIXED_sin(UINT32_C(3) << 30));
+
+    // sin(30 degrees) = 0.5, between table entries
+    TEST_ASSERT_INT32_WITHIN(1, FIXED_HALF, FIXED_sin(UINT32_MAX / 12 + 1));
+    // Odd symmetry
+    TEST_ASSERT_EQUAL_INT32(
+        -FIXED_sin(123456789), FIXED_sin(UINT32_C(0x80000000) + 123456789)
+    );
+}
+
+/**
+ * @brief Test the CORDIC phase at the quarter turns and in between
+ */
+void test_FIXED_atan2(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(0, FIXED_atan2(0, 0));
+    TEST_ASSERT_INT32_WITHIN(8, 0, (int32_t)FIXED_atan2(0, 1000));
+    TEST_ASSERT_UINT32_WITHIN(8, UINT32_C(1) << 30, FIXED_atan2(1000, 0));
+    TEST_ASSERT_UINT32_WITHIN(8, UINT32_C(2) << 30, FIXED_atan2(0, -1000));
+    TEST_ASSERT_UINT32_WITHIN(8, UINT32_C(3) << 30, FIXED_atan2(-1000, 0));
+
+    // 45 and -135 degrees, on small and on large components
+    TEST_ASSERT_UINT32_WITHIN(8, UINT32_C(1) << 29, FIXED_atan2(1, 1));
+    int64_t const large = INT64_C(1) << 60;
+    TEST_ASSERT_UINT32_WITHIN(
+        8, UINT32_C(5) << 29, FIXED_atan2(-large, -large)
+    );
+
+    // The inverse of FIXED_sin, in any quadrant
+    uint32_t const phase = 0xA0000000U + 123456789U;
+    uint32_t const quarter = UINT32_C(1) << 30;
+    int64_t const y = (int64_t)FIXED_sin(phase) * 1000;
+    int64_t const x = (int64_t)FIXED_sin(phase + quarter) * 1000;
+    TEST_ASSERT_UINT32_WITHIN(1U << 16, phase, FIXED_atan2(y, x));
+}
+
+/**
+ * @brief Test the logarithm and its inverse
+ */
+void test_FIXED_log2_exp2(void)
+{
+    TEST_ASSERT_EQUAL_INT32(0, FIXED_log2(0));
+    TEST_ASSERT_EQUAL_INT32(0, FIXED_log2(1));
+    TEST_ASSERT_EQUAL_INT32(FIXED_FROM_INT(10), FIXED_log2(1024));
+    TEST_ASSERT_EQUAL_INT32(FIXED_FROM_INT(63), FIXED_log2(UINT64_C(1) << 63));
+    // log2(1000) = 9.965784, rounded down
+    TEST_ASSERT_EQUAL_INT32(653117, FIXED_log2(1000));
+
+    TEST_ASSERT_EQUAL_UINT64(1, FIXED_exp2(0));
+    TEST_ASSERT_EQUAL_UINT64(1, FIXED_exp2(-FIXED_ONE));
+    TEST_ASSERT_EQUAL_UINT64(1024, FIXED_exp2(FIXED_FROM_INT(10)));
+    TEST_ASSERT_EQUAL_UINT64(1000, FIXED_exp2(FIXED_log2(1000)));
+    // 2^20.5 = 1482910.4
+    TEST_ASSERT_EQUAL_UINT64(
+        1482910, FIXED_exp2(FIXED_FROM_INT(20) + FIXED_HALF)
+    );
+}
+
+void test_FIXED_dds_fill(void)
+{
+    static uint32_t table[FIXED_DDS_TABLE_SIZE];
+    uint16_t out[4];
+
+    // A ramp of four codes per entry, falling back to 0 after the last
+    for (uint32_t i = 0; i < FIXED_DDS_TABLE_SIZE; ++i) {
+        uint32_t const next = (i + 1) % FIXED_DDS_TABLE_SIZE;
+        table[i] = FIXED_dds_entry((uint16_t)(4 * i), (uint16_t)(4 * next));
+    }
+
+    // Half an entry per code interpolates midway
+    uint32_t const step = UINT32_C(1) << (31 - FIXED_DDS_TABLE_BITS);
+    uint32_t phase = FIXED_dds_fill(table, 0, step, out, 4);
+    TEST_ASSERT_EQUAL_UINT16(0, out[0]);
+    TEST_ASSERT_EQUAL_UINT16(2, out[1]);
+    TEST_ASSERT_EQUAL_UINT16(4, out[2]);
+    TEST_ASSERT_EQUAL_UINT16(6, out[3]);
+    TEST_ASSERT_EQUAL_UINT32(4 * step, phase);
+
+    // The phase wraps, and the last entry falls to the first
+    phase = FIXED_dds_fill(table, UINT32_MAX - 2 * step + 1, step, out, 4);
+    TEST_ASSERT_EQUAL_UINT16(4092, out[0]);
+    TEST_ASSERT_EQUAL_UINT16(2046, out[1]);
+    TEST_ASSERT_EQUAL_UINT16(0, out[2]);
+    TEST_ASSERT_EQUAL_UINT16(2, out[3]);
+    TEST_ASSERT_EQUAL_UINT32(2 * step, phase);
+}
+
+void test_FIXED_q15_q31_conversions(void)
+{
+    TEST_ASSERT_EQUAL_INT16(16384, FIXED_Q15_FROM_FLOAT(0.5f));
+    TEST_ASSERT_EQUAL_INT32(INT32_MIN, FIXED_q15_to_q31(FIXED_Q15_MIN));
+    TEST_ASSERT_EQUAL_INT32(0x40000000, FIXED_q15_to_q31(16384));
+
+    // Rounds to nearest, and saturates just below 1
+    TEST_ASSERT_EQUAL_INT16(1, FIXED_q31_to_q15(0x8000));
+    TEST_ASSERT_EQUAL_INT16(0, FIXED_q31_to_q15(0x7FFF));
+    TEST_ASSERT_EQUAL_INT16(-1, FIXED_q31_to_q15(-0x10000));
+    TEST_ASSERT_EQUAL_INT16(FIXED_Q15_MAX, FIXED_q31_to_q15(FIXED_Q31_MAX));
+    TEST_ASSERT_EQUAL_INT16(FIXED_Q15_MIN, FIXED_q31_to_q15(FIXED_Q31_MIN));
+}
+
+void test_FIXED_q15_add_array(void)
+{
+    // An odd count covers the pairs and the last value
+    FIXED_Q15 const a[] = { 1000, 30000, -30000, -5, FIXED_Q15_MIN };
+    FIXED_Q15 const b[] = { -3000, 10000, -10000, 7, -1 };
+    FIXED_Q15 out[5];
+
+    FIXED_q15_add_array(a, b, out, 5);
+
+    TEST_ASSERT_EQUAL_INT16(-2000, out[0]);
+    TEST_ASSERT_EQUAL_INT16(FIXED_Q15_MAX, out[1]);
+    TEST_ASSERT_EQUAL_INT16(FIXED_Q15_MIN, out[2]);
+    TEST_ASSERT_EQUAL_INT16(2, out[3]);
+    TEST_ASSERT_EQUAL_INT16(FIXED_Q15_MIN, out[4]);
+}
+
+void test_FIXED_q15_scale_array(void)
+{
+    FIXED_Q15 values[] = { 1000, -1001, 3, FIXED_Q15_MIN, FIXED_Q15_MAX };
+
+    // Halving rounds to nearest, in place
+    FIXED_q15_scale_array(values, 16384, values, 5);
+    TEST_ASSERT_EQUAL_INT16(500, values[0]);
+    TEST_ASSERT_EQUAL_INT16(-500, values[1]);
+    TEST_ASSERT_EQUAL_INT16(2, values[2]);
+    TEST_ASSERT_EQUAL_INT16(-16384, values[3]);
+    TEST_ASSERT_EQUAL_INT16(16384, values[4]);
+
+    // -1 * -1 saturates just below 1
+    FIXED_Q15 const minimum[] = { FIXED_Q15_MIN };
+    FIXED_Q15 out[1];
+    FIXED_q15_scale_array(minimum, FIXED_Q15_MIN, out, 1);
+    TEST_ASSERT_EQUAL_INT16(FIXED_Q15_MAX, out[0]);
+}
+
+void test_FIXED_q15_mac_array(void)
+{
+    FIXED_Q15 const in[] = { 16384, -16384, FIXED_Q15_MIN };
+    FIXED_Q31 acc[] = { 0, 0x10000000, 0x7FFF0000 };
+
+    // Products are exact in Q31
+    FIXED_q15_mac_array(in, 16384, acc, 3);
+    TEST_ASSERT_EQUAL_INT32(0x20000000, acc[0]);
+    TEST_ASSERT_EQUAL_INT32(-0x10000000, acc[1]);
+    TEST_ASSERT_EQUAL_INT32(0x3FFF0000, acc[2]);
+
+    // Accumulating past 1 saturates
+    FIXED_q15_mac_array(in, FIXED_Q15_MIN, acc, 3);
+    FIXED_q15_mac_array(in, FIXED_Q15_MIN, acc, 3);
+    TEST_ASSERT_EQUAL_INT32(-0x60000000, acc[0]);
+    TEST_ASSERT_EQUAL_INT32(0x70000000, acc[1]);
+    TEST_ASSERT_EQUAL_INT32(FIXED_Q31_MAX, acc[2]);
+}
+
+void test_FIXED_q15_dot(void)
+{
+    FIXED_Q15 const a[] = { 3, -4, 5, FIXED_Q15_MIN, FIXED_Q15_MIN };
+    FIXED_Q15 const b[] = { 7, 2, -1, FIXED_Q15_MIN, FIXED_Q15_MIN };
+
+    TEST_ASSERT_EQUAL_INT64(0, FIXED_q15_dot(a, b, 0));
+    TEST_ASSERT_EQUAL_INT64(8, FIXED_q15_dot(a, b, 3));
+    // Exact beyond the Q31 range
+    TEST_ASSERT_EQUAL_INT64(
+        8 + (INT64_C(2) << 30), FIXED_q15_dot(a, b, 5)
+    );
+}
+
+void test_FIXED_q31_add_array(void)
+{
+    FIXED_Q31 const a[] = { 1, INT32_MAX - 1, INT32_MIN + 1 };
+    FIXED_Q31 const b[] = { -2, 5, -5 };
+    FIXED_Q31 out[3];
+
+    FIXED_q31_add_array(a, b, out, 3);
+
+    TEST_ASSERT_EQUAL_INT32(-1, out[0]);
+    TEST_ASSERT_EQUAL_INT32(FIXED_Q31_MAX, out[1]);
+    TEST_ASSERT_EQUAL_INT32(FIXED_Q31_MIN, out[2]);
+}
+
+void test_FIXED_q31_scale_array(void)
+{
+    FIXED_Q31 values[] = { 1001, -1001, FIXED_Q31_MIN, 0x40000000 };
+
+    // A quarter, rounded to nearest, in place
+    FIXED_q31_scale_array(values, 0x20000000, values, 4);
+    TEST_ASSERT_EQUAL_INT32(250, values[0]);
+    TEST_ASSERT_EQUAL_INT32(-250, values[1]);
+    TEST_ASSERT_EQUAL_INT32(-0x20000000, values[2]);
+    TEST_ASSERT_EQUAL_INT32(0x10000000, values[3]);
+
+    // -1 * -1 saturates just below 1
+    FIXED_Q31 const minimum[] = { FIXED_Q31_MIN };
+    FIXED_Q31 out[1];
+    FIXED_q31_scale_array(minimum, FIXED_Q31_MIN, out, 1);
+    TEST_ASSERT_EQUAL_INT32(FIXED_Q31_MAX, out[0]);
+}
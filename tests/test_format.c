@@ -0,0 +1,92 @@
+/**
+ * @file test_format.c
+ * @brief Unit tests for the decimal formatters
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "util/fixed_point.h"
+#include "util/format.h"
+
+static char g_buffer[32];
+
+void setUp(void) { memset(g_buffer, 'x', sizeof(g_buffer)); }
+
+void tearDown(void) {}
+
+/**
+ * @brief Format with a formatter and terminate the output for comparison
+ */
+#define FORMATTED(formatter, value)                                            \
+    (g_buffer[formatter((value), g_buffer)] = '\0', g_buffer)
+
+// Test: Unsigned values match printf, at every change of digit count
+void test_format_uint32(void)
+{
+    char expected[16];
+
+    TEST_ASSERT_EQUAL_STRING("0", FORMATTED(FORMAT_uint32, 0));
+    TEST_ASSERT_EQUAL_STRING("4294967295", FORMATTED(FORMAT_uint32, UINT32_MAX));
+
+    for (uint64_t power = 1; power <= UINT32_MAX; power *= 10) {
+        for (uint64_t value = power - 1; value <= power + 1; ++value) {
+            if (value > UINT32_MAX) {
+                break;
+            }
+            snprintf(expected, sizeof(expected), "%lu", (unsigned long)value);
+            TEST_ASSERT_EQUAL_STRING(
+                expected, FORMATTED(FORMAT_uint32, (uint32_t)value)
+            );
+        }
+    }
+}
+
+// Test: Signed values keep their sign, including the most negative one
+void test_format_int32(void)
+{
+    TEST_ASSERT_EQUAL_STRING("0", FORMATTED(FORMAT_int32, 0));
+    TEST_ASSERT_EQUAL_STRING("-1", FORMATTED(FORMAT_int32, -1));
+    TEST_ASSERT_EQUAL_STRING("3300", FORMATTED(FORMAT_int32, 3300));
+    TEST_ASSERT_EQUAL_STRING("-52", FORMATTED(FORMAT_int32, -52));
+    TEST_ASSERT_EQUAL_STRING("2147483647", FORMATTED(FORMAT_int32, INT32_MAX));
+    TEST_ASSERT_EQUAL_STRING(
+        "-2147483648", FORMATTED(FORMAT_int32, INT32_MIN)
+    );
+}
+
+// Test: Q16.16 values round to five places and drop trailing zeros
+void test_format_q1616(void)
+{
+    TEST_ASSERT_EQUAL_STRING("0.0", FORMATTED(FORMAT_q1616, FIXED_ZERO));
+    TEST_ASSERT_EQUAL_STRING("-1.0", FORMATTED(FORMAT_q1616, -FIXED_ONE));
+    TEST_ASSERT_EQUAL_STRING("0.5", FORMATTED(FORMAT_q1616, FIXED_HALF));
+    TEST_ASSERT_EQUAL_STRING("-0.5", FORMATTED(FORMAT_q1616, -FIXED_HALF));
+    TEST_ASSERT_EQUAL_STRING("0.00002", FORMATTED(FORMAT_q1616, FIXED_EPSILON));
+    TEST_ASSERT_EQUAL_STRING(
+        "3.14159", FORMATTED(FORMAT_q1616, FIXED_FROM_FLOAT(3.14159f))
+    );
+    TEST_ASSERT_EQUAL_STRING(
+        "32767.99998", FORMATTED(FORMAT_q1616, FIXED_MAX)
+    );
+    TEST_ASSERT_EQUAL_STRING("-32768.0", FORMATTED(FORMAT_q1616, FIXED_MIN));
+    TEST_ASSERT_EQUAL_STRING(
+        "-32767.99998", FORMATTED(FORMAT_q1616, -FIXED_MAX)
+    );
+    TEST_ASSERT_EQUAL_UINT32(
+        FORMAT_Q1616_SIZE_MAX, FORMAT_q1616(-FIXED_MAX, g_buffer)
+    );
+}
+
+// Test: Nothing is written past the characters reported
+void test_format_no_terminator(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(3, FORMAT_uint32(123, g_buffer));
+    TEST_ASSERT_EQUAL_INT('x', g_buffer[3]);
+}
@@ -27,6 +27,12 @@ uint32_t scpi_mock_usb_write_capture(USB_Handle *handle, uint8_t const *data, ui
     return len;
 }
 
+bool scpi_mock_usb_write_buffer_capture(USB_Handle *handle, uint8_t const *buf, uint32_t sz, int cmock_num_calls)
+{
+    // Sent at once, so the buffer is never pending
+    return scpi_mock_usb_write_capture(handle, buf, sz, cmock_num_calls) == sz;
+}
+
 uint32_t scpi_mock_usb_read_inject(USB_Handle *handle, uint8_t *buffer, uint32_t max_len, int cmock_num_calls)
 {
     (void)handle;
@@ -83,5 +89,7 @@ void scpi_run_protocol_with_usb_mocks(USB_Handle *usb_handle)
     USB_rx_ready_StubWithCallback(scpi_mock_usb_rx_ready_check);
     USB_read_StubWithCallback(scpi_mock_usb_read_inject);
     USB_write_StubWithCallback(scpi_mock_usb_write_capture);
+    USB_write_buffer_StubWithCallback(scpi_mock_usb_write_buffer_capture);
+    USB_tx_buffer_pending_IgnoreAndReturn(false);
     protocol_task();
 }
\ No newline at end of file
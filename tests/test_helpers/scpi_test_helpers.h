@@ -80,6 +80,11 @@ extern size_t g_scpi_test_injected_data_len;
  */
 uint32_t scpi_mock_usb_write_capture(USB_Handle *handle, uint8_t const *data, uint32_t len, int cmock_num_calls);
 
+/**
+ * @brief Mock USB_write_buffer implementation that captures the block data
+ */
+bool scpi_mock_usb_write_buffer_capture(USB_Handle *handle, uint8_t const *buf, uint32_t sz, int cmock_num_calls);
+
 /**
  * @brief Mock USB_read implementation that returns injected data
  */
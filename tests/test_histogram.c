@@ -0,0 +1,95 @@
+/**
+ * @file test_histogram.c
+ * @brief Unit tests for the amplitude histogram
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "util/histogram.h"
+
+static uint32_t g_bins[HISTOGRAM_BINS_MAX];
+static HISTOGRAM_State g_histogram;
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_init_clears_bins(void)
+{
+    // Arrange
+    g_bins[0] = 7;
+    g_bins[4095] = 7;
+
+    // Act
+    bool const ok = HISTOGRAM_init(&g_histogram, g_bins, 0, 4095, 1, 0);
+
+    // Assert
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_EQUAL_UINT32(4096, g_histogram.bin_count);
+    TEST_ASSERT_EQUAL_UINT32(0, g_bins[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, g_bins[4095]);
+}
+
+void test_init_rejects_bad_range(void)
+{
+    // Act & Assert - empty, too wide, and an offset past the frame
+    TEST_ASSERT_FALSE(HISTOGRAM_init(&g_histogram, g_bins, 10, 9, 1, 0));
+    TEST_ASSERT_FALSE(HISTOGRAM_init(&g_histogram, g_bins, 0, 4096, 1, 0));
+    TEST_ASSERT_FALSE(HISTOGRAM_init(&g_histogram, g_bins, 0, 4095, 2, 2));
+}
+
+void test_add_counts_codes_in_range(void)
+{
+    // Arrange - bins for codes 100 to 103
+    HISTOGRAM_init(&g_histogram, g_bins, 100, 103, 1, 0);
+    uint16_t const samples[] = { 100, 101, 101, 103, 99, 104, 0, 4095, 103 };
+
+    // Act
+    HISTOGRAM_add(&g_histogram, samples, 9);
+
+    // Assert
+    uint32_t const expected[] = { 1, 2, 0, 2 };
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(expected, g_bins, 4);
+    TEST_ASSERT_EQUAL_UINT64(5, g_histogram.counted);
+    TEST_ASSERT_EQUAL_UINT64(2, g_histogram.below);
+    TEST_ASSERT_EQUAL_UINT64(2, g_histogram.above);
+}
+
+void test_add_follows_channel_across_blocks(void)
+{
+    // Arrange - second channel of three; blocks split frames
+    HISTOGRAM_init(&g_histogram, g_bins, 0, 9, 3, 1);
+    uint16_t const first[] = { 0, 1, 0, 0 };
+    uint16_t const second[] = { 2, 0, 0 };
+    uint16_t const third[] = { 3, 0, 0, 4, 0 };
+
+    // Act
+    HISTOGRAM_add(&g_histogram, first, 4);
+    HISTOGRAM_add(&g_histogram, second, 3);
+    HISTOGRAM_add(&g_histogram, third, 5);
+
+    // Assert - only codes 1 to 4 of the second channel are counted
+    uint32_t const expected[] = { 0, 1, 1, 1, 1, 0 };
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(expected, g_bins, 6);
+    TEST_ASSERT_EQUAL_UINT64(4, g_histogram.counted);
+}
+
+void test_add_saturates_bins(void)
+{
+    // Arrange
+    HISTOGRAM_init(&g_histogram, g_bins, 0, 0, 1, 0);
+    g_bins[0] = UINT32_MAX - 1;
+    uint16_t const samples[] = { 0, 0, 0 };
+
+    // Act
+    HISTOGRAM_add(&g_histogram, samples, 3);
+
+    // Assert - the bin stops at its limit, the total keeps counting
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, g_bins[0]);
+    TEST_ASSERT_EQUAL_UINT64(3, g_histogram.counted);
+}
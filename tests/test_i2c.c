@@ -0,0 +1,288 @@
+/**
+ * @file test_i2c.c
+ * @brief Unit tests for the I2C bus transaction queue
+ *
+ * The hardware layer is mocked; the transfers started on it are captured,
+ * and their completion is simulated by calling the callback the driver
+ * registered.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_i2c_ll.h"
+#include "mock_platform.h"
+
+#include "util/error.h"
+
+#include "i2c.h"
+
+static I2C_Handle *g_handle;
+static I2C_LL_CompleteCallback g_complete;
+static I2C_LL_Transfer g_transfer;
+static uint32_t g_starts;
+static bool g_start_fails; // The next start throws
+static uint8_t g_data[4];
+static I2C_Transaction g_transactions[I2C_QUEUE_SIZE + 1];
+static uint32_t g_transaction_count;
+static I2C_Transaction *g_completed[I2C_QUEUE_SIZE + 1];
+static uint32_t g_completed_count;
+
+static void
+set_complete_callback_stub(I2C_Bus bus, I2C_LL_CompleteCallback cb, int n)
+{
+    (void)bus;
+    (void)n;
+    g_complete = cb;
+}
+
+static void start_stub(I2C_Bus bus, I2C_LL_Transfer const *transfer, int n)
+{
+    (void)bus;
+    (void)n;
+    if (g_start_fails) {
+        g_start_fails = false;
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    g_transfer = *transfer;
+    g_starts += 1;
+}
+
+static void on_complete(I2C_Transaction *transaction)
+{
+    g_completed[g_completed_count] = transaction;
+    g_completed_count += 1;
+}
+
+/**
+ * @brief A one-byte write of register 0x10 of target 0x50
+ *
+ * Transactions outlive the test, since tearDown cancels the pending ones.
+ */
+static I2C_Transaction *new_write(void)
+{
+    I2C_Transaction *const transaction =
+        &g_transactions[g_transaction_count];
+
+    g_transaction_count += 1;
+    *transaction = (I2C_Transaction){
+        .address = 0x50,
+        .read = false,
+        .reg = 0x10,
+        .reg_size = 1,
+        .data = g_data,
+        .size = 1,
+        .callback = on_complete,
+    };
+    return transaction;
+}
+
+void setUp(void)
+{
+    mock_i2c_ll_Init();
+    mock_platform_Init();
+
+    g_complete = NULL;
+    g_starts = 0;
+    g_start_fails = false;
+    g_transaction_count = 0;
+    g_completed_count = 0;
+    memset(&g_transfer, 0, sizeof(g_transfer));
+
+    PLATFORM_disable_interrupts_IgnoreAndReturn(0);
+    PLATFORM_restore_interrupts_Ignore();
+    I2C_LL_set_complete_callback_Stub(set_complete_callback_stub);
+    I2C_LL_start_Stub(start_stub);
+
+    I2C_LL_init_Expect(I2C_BUS_0);
+    g_handle = I2C_init(0);
+}
+
+void tearDown(void)
+{
+    if (g_handle != NULL) {
+        I2C_LL_deinit_Ignore();
+        I2C_deinit(g_handle);
+        g_handle = NULL;
+    }
+
+    mock_i2c_ll_Destroy();
+    mock_platform_Destroy();
+}
+
+// Test: A transaction on an idle bus starts at once, and its completion
+// reports the outcome
+void test_I2C_submit_starts_and_completes(void)
+{
+    I2C_Transaction *const read = new_write();
+    read->read = true;
+    read->reg = 0x1234;
+    read->reg_size = 2;
+    read->size = 4;
+
+    I2C_submit(g_handle, read);
+
+    TEST_ASSERT_EQUAL_UINT32(1, g_starts);
+    TEST_ASSERT_EQUAL_HEX8(0x50, g_transfer.address);
+    TEST_ASSERT_TRUE(g_transfer.read);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, g_transfer.reg);
+    TEST_ASSERT_EQUAL_UINT8(2, g_transfer.reg_size);
+    TEST_ASSERT_EQUAL_PTR(g_data, g_transfer.data);
+    TEST_ASSERT_EQUAL_UINT32(4, g_transfer.size);
+    TEST_ASSERT_EQUAL(I2C_STATUS_PENDING, read->status);
+    TEST_ASSERT_EQUAL_UINT32(1, I2C_pending(g_handle));
+
+    g_complete(I2C_BUS_0, I2C_LL_STATUS_OK);
+
+    TEST_ASSERT_EQUAL(I2C_STATUS_OK, read->status);
+    TEST_ASSERT_EQUAL_UINT32(1, g_completed_count);
+    TEST_ASSERT_EQUAL_PTR(read, g_completed[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, I2C_pending(g_handle));
+}
+
+// Test: Queued transactions run one after another in submission order
+void test_I2C_queue_order(void)
+{
+    I2C_Transaction *const first = new_write();
+    I2C_Transaction *const second = new_write();
+    second->address = 0x51;
+
+    I2C_submit(g_handle, first);
+    I2C_submit(g_handle, second);
+    TEST_ASSERT_EQUAL_UINT32(1, g_starts);
+    TEST_ASSERT_EQUAL_HEX8(0x50, g_transfer.address);
+
+    g_complete(I2C_BUS_0, I2C_LL_STATUS_NACK);
+    TEST_ASSERT_EQUAL(I2C_STATUS_NACK, first->status);
+    TEST_ASSERT_EQUAL(I2C_STATUS_PENDING, second->status);
+    TEST_ASSERT_EQUAL_UINT32(2, g_starts);
+    TEST_ASSERT_EQUAL_HEX8(0x51, g_transfer.address);
+
+    g_complete(I2C_BUS_0, I2C_LL_STATUS_OK);
+    TEST_ASSERT_EQUAL(I2C_STATUS_OK, second->status);
+    TEST_ASSERT_EQUAL_UINT32(2, g_completed_count);
+    TEST_ASSERT_EQUAL_PTR(second, g_completed[1]);
+}
+
+// Test: A full queue, or a transaction already pending, is refused
+void test_I2C_submit_busy(void)
+{
+    I2C_Transaction *queued[I2C_QUEUE_SIZE];
+    Error error = ERROR_NONE;
+
+    for (uint32_t i = 0; i < I2C_QUEUE_SIZE; i++) {
+        queued[i] = new_write();
+        I2C_submit(g_handle, queued[i]);
+    }
+
+    I2C_Transaction *const extra = new_write();
+    TRY { I2C_submit(g_handle, extra); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, error);
+    TEST_ASSERT_EQUAL(I2C_STATUS_OK, extra->status);
+
+    g_complete(I2C_BUS_0, I2C_LL_STATUS_OK);
+    error = ERROR_NONE;
+    TRY { I2C_submit(g_handle, queued[1]); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, error);
+
+    // The completed one may go again
+    I2C_submit(g_handle, queued[0]);
+    TEST_ASSERT_EQUAL_UINT32(I2C_QUEUE_SIZE, I2C_pending(g_handle));
+}
+
+// Test: A transfer the hardware refuses fails, and the next one starts
+void test_I2C_start_failure(void)
+{
+    I2C_Transaction *const first = new_write();
+    I2C_Transaction *const second = new_write();
+    I2C_Transaction *const third = new_write();
+
+    I2C_submit(g_handle, first);
+    I2C_submit(g_handle, second);
+    I2C_submit(g_handle, third);
+
+    g_start_fails = true;
+    g_complete(I2C_BUS_0, I2C_LL_STATUS_OK);
+
+    TEST_ASSERT_EQUAL(I2C_STATUS_OK, first->status);
+    TEST_ASSERT_EQUAL(I2C_STATUS_BUS_ERROR, second->status);
+    TEST_ASSERT_EQUAL(I2C_STATUS_PENDING, third->status);
+    TEST_ASSERT_EQUAL_UINT32(2, g_starts);
+    TEST_ASSERT_EQUAL_UINT32(1, I2C_pending(g_handle));
+}
+
+// Test: Deinitializing cancels the pending transactions
+void test_I2C_deinit_cancels(void)
+{
+    I2C_Transaction *const first = new_write();
+    I2C_Transaction *const second = new_write();
+
+    I2C_submit(g_handle, first);
+    I2C_submit(g_handle, second);
+
+    I2C_LL_deinit_Expect(I2C_BUS_0);
+    I2C_deinit(g_handle);
+    g_handle = NULL;
+
+    TEST_ASSERT_EQUAL(I2C_STATUS_CANCELLED, first->status);
+    TEST_ASSERT_EQUAL(I2C_STATUS_CANCELLED, second->status);
+    TEST_ASSERT_EQUAL_UINT32(2, g_completed_count);
+}
+
+// Test: The clock rate only changes on an idle bus
+void test_I2C_set_speed(void)
+{
+    Error error = ERROR_NONE;
+
+    TEST_ASSERT_EQUAL_UINT32(I2C_SPEED_DEFAULT, I2C_get_speed(g_handle));
+
+    I2C_LL_set_speed_Expect(I2C_BUS_0, 400000);
+    I2C_set_speed(g_handle, 400000);
+    TEST_ASSERT_EQUAL_UINT32(400000, I2C_get_speed(g_handle));
+
+    I2C_submit(g_handle, new_write());
+    TRY { I2C_set_speed(g_handle, 100000); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, error);
+
+    error = ERROR_NONE;
+    TRY { I2C_set_speed(g_handle, I2C_SPEED_MAX + 1); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+}
+
+// Test: Invalid transactions are refused before the queue is touched
+void test_I2C_submit_invalid(void)
+{
+    I2C_Transaction *const write = new_write();
+    Error error = ERROR_NONE;
+
+    write->address = I2C_ADDRESS_MAX + 1;
+    TRY { I2C_submit(g_handle, write); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    write->address = 0x50;
+    write->reg_size = 3;
+    error = ERROR_NONE;
+    TRY { I2C_submit(g_handle, write); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    write->reg_size = 1;
+    write->size = 0;
+    error = ERROR_NONE;
+    TRY { I2C_submit(g_handle, write); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    TEST_ASSERT_EQUAL_UINT32(0, g_starts);
+    TEST_ASSERT_EQUAL_UINT32(0, I2C_pending(g_handle));
+}
@@ -0,0 +1,182 @@
+/**
+ * @file test_interleave.c
+ * @brief Unit tests for the interleaved ADC mismatch correction
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "util/fixed_point.h"
+#include "util/interleave.h"
+
+enum {
+    TONE_SAMPLES = 4096,
+    // Sine frequency in turns per sample, in units of 2^-32: about 19.3
+    // cycles in the capture, not locked to the sample rate
+    TONE_STEP = 0x01354AC3,
+};
+
+static uint16_t g_tone[TONE_SAMPLES];
+
+/**
+ * @brief Sine of amplitude 1500 around mid-scale at sample i
+ */
+static int32_t tone(uint32_t i)
+{
+    return 2048 + ((FIXED_sin(i * (uint32_t)TONE_STEP) * 1500) >> 16);
+}
+
+/**
+ * @brief Fill g_tone with the sine, the odd samples through a mismatched
+ * ADC: odd * gain_permille / 1000 + offset
+ */
+static void make_tone(int32_t gain_permille, int32_t offset)
+{
+    for (uint32_t i = 0; i < TONE_SAMPLES; ++i) {
+        int32_t value = tone(i);
+        if (i % 2 == 1) {
+            value = ((value * gain_permille) + 500) / 1000 + offset;
+        }
+        g_tone[i] = (uint16_t)value;
+    }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_estimate_matched_adcs(void)
+{
+    // Arrange
+    make_tone(1000, 0);
+    INTERLEAVE_Correction correction;
+
+    // Act
+    bool const ok = INTERLEAVE_estimate(g_tone, TONE_SAMPLES, &correction);
+
+    // Assert - the gain within 0.1%, and mid-scale maps onto itself within
+    // a tenth of a code; the offset makes up for the gain error
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE / 1000, FIXED_ONE, correction.gain);
+    FIXED_Q1616 const mid = FIXED_FROM_INT(2048);
+    TEST_ASSERT_INT32_WITHIN(
+        FIXED_ONE / 10,
+        mid,
+        FIXED_mul(correction.gain, mid) + correction.offset
+    );
+}
+
+void test_estimate_and_correct_mismatch(void)
+{
+    // Arrange - 3% low gain and 12 codes of offset on the odd samples
+    make_tone(970, 12);
+    INTERLEAVE_Correction correction;
+
+    // Act
+    bool const ok = INTERLEAVE_estimate(g_tone, TONE_SAMPLES, &correction);
+    INTERLEAVE_correct(&correction, g_tone, TONE_SAMPLES, 4095);
+
+    // Assert - odd samples are back on the sine within rounding
+    TEST_ASSERT_TRUE(ok);
+    for (uint32_t i = 0; i < TONE_SAMPLES; ++i) {
+        TEST_ASSERT_INT32_WITHIN(2, tone(i), g_tone[i]);
+    }
+}
+
+void test_estimate_rejects_constant_signal(void)
+{
+    // Arrange - no deviation on the odd samples to take the gain from
+    for (uint32_t i = 0; i < TONE_SAMPLES; ++i) {
+        g_tone[i] = 2048;
+    }
+    INTERLEAVE_Correction correction = INTERLEAVE_CORRECTION_IDENTITY;
+
+    // Act & Assert
+    TEST_ASSERT_FALSE(INTERLEAVE_estimate(g_tone, TONE_SAMPLES, &correction));
+    TEST_ASSERT_EQUAL_INT32(FIXED_ONE, correction.gain);
+}
+
+void test_estimate_rejects_short_capture(void)
+{
+    // Arrange
+    make_tone(1000, 0);
+    INTERLEAVE_Correction correction;
+
+    // Act & Assert
+    TEST_ASSERT_FALSE(INTERLEAVE_estimate(
+        g_tone, INTERLEAVE_ESTIMATE_MIN - 2, &correction
+    ));
+}
+
+void test_estimate_rejects_large_mismatch(void)
+{
+    // Arrange - half gain on the odd samples
+    make_tone(500, 0);
+    INTERLEAVE_Correction correction;
+
+    // Act & Assert
+    TEST_ASSERT_FALSE(INTERLEAVE_estimate(g_tone, TONE_SAMPLES, &correction));
+}
+
+void test_correct_leaves_even_samples(void)
+{
+    // Arrange
+    uint16_t samples[] = { 100, 100, 200, 200, 300 };
+    INTERLEAVE_Correction const correction = {
+        .gain = FIXED_ONE + FIXED_ONE / 10,
+        .offset = FIXED_FROM_INT(-5),
+    };
+
+    // Act
+    INTERLEAVE_correct(&correction, samples, 5, 4095);
+
+    // Assert - 100 * 1.1 - 5 and 200 * 1.1 - 5; odd last sample unchanged
+    uint16_t const expected[] = { 100, 105, 200, 215, 300 };
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, samples, 5);
+}
+
+void test_correct_clamps_to_sample_range(void)
+{
+    // Arrange
+    uint16_t samples[] = { 0, 2, 0, 250 };
+    INTERLEAVE_Correction const correction = {
+        .gain = FIXED_ONE + FIXED_ONE / 8,
+        .offset = FIXED_FROM_INT(-4),
+    };
+
+    // Act - 8-bit samples
+    INTERLEAVE_correct(&correction, samples, 4, 255);
+
+    // Assert
+    uint16_t const expected[] = { 0, 0, 0, 255 };
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, samples, 4);
+}
+
+void test_combine_matches_applying_both(void)
+{
+    // Arrange
+    INTERLEAVE_Correction const first = {
+        .gain = FIXED_ONE + FIXED_ONE / 32,
+        .offset = FIXED_FROM_INT(3),
+    };
+    INTERLEAVE_Correction const second = {
+        .gain = FIXED_ONE - FIXED_ONE / 64,
+        .offset = -FIXED_HALF,
+    };
+    uint16_t twice[] = { 0, 1000, 0, 3000 };
+    uint16_t once[] = { 0, 1000, 0, 3000 };
+
+    // Act
+    INTERLEAVE_correct(&first, twice, 4, 4095);
+    INTERLEAVE_correct(&second, twice, 4, 4095);
+    INTERLEAVE_Correction const combined = INTERLEAVE_combine(&first, &second);
+    INTERLEAVE_correct(&combined, once, 4, 4095);
+
+    // Assert - the same up to the rounding between the two steps
+    TEST_ASSERT_INT32_WITHIN(1, twice[1], once[1]);
+    TEST_ASSERT_INT32_WITHIN(1, twice[3], once[3]);
+}
@@ -0,0 +1,273 @@
+/**
+ * @file test_kvstore.c
+ * @brief Unit tests for the key-value store in flash
+ *
+ * The store sectors are replaced by a RAM array behind the mocked flash
+ * driver, which checks that every write lands on erased flash.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_flash_ll.h"
+
+#include "util/error.h"
+
+#include "kvstore.h"
+
+enum {
+    SECTOR_COUNT = FLASH_LL_KV_SIZE / FLASH_LL_SECTOR_SIZE,
+};
+
+static uint8_t g_area[FLASH_LL_KV_SIZE];
+static uint32_t g_erase_counts[SECTOR_COUNT];
+static uint32_t g_write_count;
+
+static void kv_read_stub(
+    uint32_t offset,
+    void *data,
+    uint32_t size,
+    int cmock_num_calls
+)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(sizeof(g_area), offset + size);
+    memcpy(data, &g_area[offset], size);
+}
+
+static void kv_erase_stub(uint32_t offset, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_EQUAL_UINT32(0, offset % FLASH_LL_SECTOR_SIZE);
+    TEST_ASSERT_LESS_THAN_UINT32(sizeof(g_area), offset);
+    memset(&g_area[offset], 0xFF, FLASH_LL_SECTOR_SIZE);
+    g_erase_counts[offset / FLASH_LL_SECTOR_SIZE]++;
+}
+
+static void kv_write_stub(
+    uint32_t offset,
+    void const *data,
+    uint32_t size,
+    int cmock_num_calls
+)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_EQUAL_UINT32(0, offset % FLASH_LL_WRITE_ALIGN);
+    TEST_ASSERT_EQUAL_UINT32(0, size % FLASH_LL_WRITE_ALIGN);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(sizeof(g_area), offset + size);
+    for (uint32_t i = 0; i < size; ++i) {
+        TEST_ASSERT_EQUAL_HEX8(0xFF, g_area[offset + i]);
+    }
+    memcpy(&g_area[offset], data, size);
+    g_write_count++;
+}
+
+void setUp(void)
+{
+    mock_flash_ll_Init();
+    memset(g_area, 0xFF, sizeof(g_area));
+    memset(g_erase_counts, 0, sizeof(g_erase_counts));
+    g_write_count = 0;
+    FLASH_LL_kv_read_Stub(kv_read_stub);
+    FLASH_LL_kv_erase_Stub(kv_erase_stub);
+    FLASH_LL_kv_write_Stub(kv_write_stub);
+    KVSTORE_init();
+}
+
+void tearDown(void)
+{
+    mock_flash_ll_Verify();
+    mock_flash_ll_Destroy();
+}
+
+// Test: Erased flash is formatted as an empty store
+void test_KVSTORE_init_formats_erased_flash(void)
+{
+    uint32_t value = 0;
+
+    TEST_ASSERT_EQUAL_UINT32(1, g_erase_counts[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, g_erase_counts[1]);
+    TEST_ASSERT_EQUAL_UINT32(0, KVSTORE_size(0));
+    TEST_ASSERT_FALSE(KVSTORE_get(0, &value, sizeof(value)));
+}
+
+// Test: Values are found again after a reset
+void test_KVSTORE_values_survive_init(void)
+{
+    uint32_t const a = 0x12345678;
+    uint8_t const b[20] = { 1, 2, 3, 4, 5 };
+    uint32_t value = 0;
+    uint8_t buffer[20] = { 0 };
+
+    KVSTORE_set(3, &a, sizeof(a));
+    KVSTORE_set(KVSTORE_KEY_COUNT - 1, b, sizeof(b));
+    KVSTORE_init();
+
+    TEST_ASSERT_TRUE(KVSTORE_get(3, &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_HEX32(a, value);
+    TEST_ASSERT_TRUE(KVSTORE_get(KVSTORE_KEY_COUNT - 1, buffer, sizeof(b)));
+    TEST_ASSERT_EQUAL_MEMORY(b, buffer, sizeof(b));
+    TEST_ASSERT_EQUAL_UINT32(1, g_erase_counts[0]);
+}
+
+// Test: The last value written to a key is the one found
+void test_KVSTORE_set_replaces_value(void)
+{
+    uint32_t value = 0;
+
+    for (uint32_t i = 1; i <= 10; ++i) {
+        KVSTORE_set(5, &i, sizeof(i));
+    }
+    TEST_ASSERT_TRUE(KVSTORE_get(5, &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_UINT32(10, value);
+
+    KVSTORE_init();
+    TEST_ASSERT_TRUE(KVSTORE_get(5, &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_UINT32(10, value);
+}
+
+// Test: An unchanged value is not written again
+void test_KVSTORE_set_skips_unchanged_value(void)
+{
+    uint32_t const value = 42;
+
+    KVSTORE_set(1, &value, sizeof(value));
+    uint32_t const writes = g_write_count;
+    KVSTORE_set(1, &value, sizeof(value));
+
+    TEST_ASSERT_EQUAL_UINT32(writes, g_write_count);
+}
+
+// Test: A value is only taken back with the size it was stored with
+void test_KVSTORE_get_checks_size(void)
+{
+    uint32_t const value = 42;
+    uint16_t half = 7;
+
+    KVSTORE_set(2, &value, sizeof(value));
+
+    TEST_ASSERT_EQUAL_UINT32(sizeof(value), KVSTORE_size(2));
+    TEST_ASSERT_FALSE(KVSTORE_get(2, &half, sizeof(half)));
+    TEST_ASSERT_EQUAL_UINT16(7, half);
+}
+
+// Test: A removed key holds no value, also after a reset
+void test_KVSTORE_remove(void)
+{
+    uint32_t const value = 42;
+
+    KVSTORE_set(4, &value, sizeof(value));
+    KVSTORE_remove(4);
+    TEST_ASSERT_EQUAL_UINT32(0, KVSTORE_size(4));
+
+    KVSTORE_init();
+    TEST_ASSERT_EQUAL_UINT32(0, KVSTORE_size(4));
+}
+
+// Test: A full sector is compacted into the other, which takes turns
+void test_KVSTORE_compacts_when_full(void)
+{
+    uint32_t const kept = 0xCAFEF00D;
+    uint32_t value = 0;
+
+    KVSTORE_set(0, &kept, sizeof(kept));
+    // Each record takes 32 bytes, so 1000 writes fill the sector some times
+    for (uint32_t i = 0; i < 1000; ++i) {
+        KVSTORE_set(1, &i, sizeof(i));
+    }
+
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(1, g_erase_counts[1]);
+    TEST_ASSERT_UINT32_WITHIN(1, g_erase_counts[1], g_erase_counts[0] - 1);
+
+    KVSTORE_init();
+    TEST_ASSERT_TRUE(KVSTORE_get(0, &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_HEX32(kept, value);
+    TEST_ASSERT_TRUE(KVSTORE_get(1, &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_UINT32(999, value);
+}
+
+// Test: A record cut short by a reset leaves the previous value
+void test_KVSTORE_init_skips_torn_record(void)
+{
+    uint32_t const first = 1;
+    uint32_t const second = 2;
+    uint32_t value = 0;
+
+    KVSTORE_set(6, &first, sizeof(first));
+    KVSTORE_set(6, &second, sizeof(second));
+    // The value of the second record never made it to the flash
+    memset(&g_area[64], 0xFF, 16);
+
+    KVSTORE_init();
+    TEST_ASSERT_TRUE(KVSTORE_get(6, &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_UINT32(first, value);
+
+    // Writes carry on after the torn record
+    KVSTORE_set(6, &second, sizeof(second));
+    KVSTORE_init();
+    TEST_ASSERT_TRUE(KVSTORE_get(6, &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_UINT32(second, value);
+}
+
+// Test: A compaction cut short by a reset leaves the active sector
+void test_KVSTORE_init_ignores_unfinished_compaction(void)
+{
+    uint32_t const value = 42;
+    uint32_t read = 0;
+
+    KVSTORE_set(7, &value, sizeof(value));
+    // Records copied to the other sector, but not its header
+    memcpy(&g_area[FLASH_LL_SECTOR_SIZE + 16], &g_area[16], 32);
+
+    KVSTORE_init();
+    TEST_ASSERT_TRUE(KVSTORE_get(7, &read, sizeof(read)));
+    TEST_ASSERT_EQUAL_UINT32(value, read);
+    TEST_ASSERT_EQUAL_UINT32(1, g_erase_counts[0]);
+}
+
+// Test: Values that do not fit are refused, keeping the others
+void test_KVSTORE_set_out_of_memory(void)
+{
+    static uint8_t value[KVSTORE_VALUE_MAX];
+    uint32_t volatile key = 0;
+    Error err = ERROR_NONE;
+
+    TRY
+    {
+        for (key = 0; key < KVSTORE_KEY_COUNT; ++key) {
+            value[0] = (uint8_t)key;
+            KVSTORE_set(key, value, sizeof(value));
+        }
+    }
+    CATCH(err) {}
+
+    TEST_ASSERT_EQUAL(ERROR_OUT_OF_MEMORY, err);
+    TEST_ASSERT_EQUAL_UINT32(15, key);
+    TEST_ASSERT_TRUE(KVSTORE_get(14, value, sizeof(value)));
+    TEST_ASSERT_EQUAL_UINT8(14, value[0]);
+}
+
+// Test: Keys and sizes beyond the limits are refused
+void test_KVSTORE_set_invalid_arguments(void)
+{
+    static uint8_t value[KVSTORE_VALUE_MAX + 1];
+    Error err = ERROR_NONE;
+
+    TRY { KVSTORE_set(KVSTORE_KEY_COUNT, value, 4); }
+    CATCH(err) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, err);
+
+    err = ERROR_NONE;
+    TRY { KVSTORE_set(0, value, sizeof(value)); }
+    CATCH(err) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, err);
+
+    err = ERROR_NONE;
+    TRY { KVSTORE_set(0, value, 0); }
+    CATCH(err) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, err);
+}
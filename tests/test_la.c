@@ -0,0 +1,356 @@
+/**
+ * @file test_la.c
+ * @brief Unit tests for the logic analyzer
+ *
+ * The sampling DMA and the timer are mocked; captures are completed by
+ * calling the callback handed to LA_LL_init, and processed captures are
+ * fed ring blocks through the block callback.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_clock.h"
+#include "mock_la_ll.h"
+#include "mock_tim_ll.h"
+
+#include "util/error.h"
+
+#include "la.h"
+
+static uint8_t g_buffer[256] __attribute__((aligned(4)));
+static LA_Handle *g_handle;
+static LA_LL_CompleteCallback g_ll_callback;
+static LA_LL_BlockCallback g_ll_block_callback;
+static uint32_t g_completions;
+
+static void la_ll_init_stub(LA_LL_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_EQUAL(TIM_NUM_3, config->timer);
+    TEST_ASSERT_EQUAL_PTR(g_buffer, config->buffer);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(g_buffer), config->samples);
+    g_ll_callback = config->complete_callback;
+}
+
+static void
+la_ll_init_ring_stub(LA_LL_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_NOT_EQUAL(g_buffer, config->buffer);
+    TEST_ASSERT_NOT_NULL(config->block_callback);
+    TEST_ASSERT_EQUAL_UINT32(0, config->samples % 2);
+    g_ll_block_callback = config->block_callback;
+}
+
+static void on_complete(void) { g_completions++; }
+
+/**
+ * @brief Init and start a capture that passes through the ring
+ */
+static LA_Handle *start_processed(
+    LA_Storage storage,
+    uint8_t mask,
+    uint8_t pattern,
+    uint32_t size
+)
+{
+    LA_Config config = LA_CONFIG_DEFAULT;
+    config.buffer = g_buffer;
+    config.buffer_size = size;
+    config.complete_callback = on_complete;
+    config.storage = storage;
+    config.trigger_mask = mask;
+    config.trigger_pattern = pattern;
+
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_3, 1000000, 1000000);
+    LA_LL_init_Stub(la_ll_init_ring_stub);
+    LA_Handle *const handle = LA_init(&config);
+    LA_LL_start_Expect();
+    TIM_LL_start_Expect(TIM_NUM_3);
+    LA_start(handle);
+    return handle;
+}
+
+static LA_Handle *init_default(void)
+{
+    LA_Config config = LA_CONFIG_DEFAULT;
+    config.buffer = g_buffer;
+    config.buffer_size = sizeof(g_buffer);
+    config.complete_callback = on_complete;
+
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_3, 1000000, 1000000);
+    LA_LL_init_Stub(la_ll_init_stub);
+    return LA_init(&config);
+}
+
+void setUp(void)
+{
+    mock_clock_Init();
+    mock_la_ll_Init();
+    mock_tim_ll_Init();
+
+    g_handle = NULL;
+    g_ll_callback = NULL;
+    g_ll_block_callback = NULL;
+    g_completions = 0;
+    memset(g_buffer, 0, sizeof(g_buffer));
+
+    TIM_LL_claim_IgnoreAndReturn(TIM_NUM_3);
+    TIM_LL_release_Ignore();
+    CLOCK_request_Ignore();
+    CLOCK_release_Ignore();
+}
+
+void tearDown(void)
+{
+    if (g_handle != NULL) {
+        TIM_LL_stop_Ignore();
+        TIM_LL_deinit_Ignore();
+        LA_LL_stop_Ignore();
+        LA_LL_deinit_Ignore();
+        LA_LL_get_position_IgnoreAndReturn(0);
+        LA_deinit(g_handle);
+    }
+
+    mock_clock_Verify();
+    mock_clock_Destroy();
+    mock_la_ll_Verify();
+    mock_la_ll_Destroy();
+    mock_tim_ll_Verify();
+    mock_tim_ll_Destroy();
+}
+
+// Test: Init configures the timer and keeps the achieved rate
+void test_LA_init_stores_achieved_rate(void)
+{
+    LA_Config config = LA_CONFIG_DEFAULT;
+    config.buffer = g_buffer;
+    config.buffer_size = sizeof(g_buffer);
+    config.sample_rate = 7000000;
+
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_3, 7000000, 6944444);
+    LA_LL_init_Stub(la_ll_init_stub);
+    g_handle = LA_init(&config);
+
+    TEST_ASSERT_EQUAL_UINT32(6944444, LA_get_config(g_handle).sample_rate);
+    TEST_ASSERT_FALSE(LA_is_running(g_handle));
+}
+
+// Test: Out of range settings are refused before touching the hardware
+void test_LA_init_invalid_config(void)
+{
+    LA_Config config = LA_CONFIG_DEFAULT;
+    Error err = ERROR_NONE;
+
+    config.buffer = g_buffer;
+    config.sample_rate = LA_SAMPLE_RATE_MAX + 1;
+    TRY { (void)LA_init(&config); }
+    CATCH(err) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, err);
+
+    config.sample_rate = 1000;
+    config.buffer = NULL;
+    err = ERROR_NONE;
+    TRY { (void)LA_init(&config); }
+    CATCH(err) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, err);
+}
+
+// Test: Only one logic analyzer can be initialized
+void test_LA_init_twice(void)
+{
+    LA_Config config = LA_CONFIG_DEFAULT;
+    Error err = ERROR_NONE;
+
+    g_handle = init_default();
+    config.buffer = g_buffer;
+    TRY { (void)LA_init(&config); }
+    CATCH(err) {}
+
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, err);
+}
+
+// Test: A timer that cannot reach the rate releases the claimed timer
+void test_LA_init_timer_failure(void)
+{
+    LA_Config config = LA_CONFIG_DEFAULT;
+    Error err = ERROR_NONE;
+
+    config.buffer = g_buffer;
+    TIM_LL_init_ExpectAndThrow(TIM_NUM_3, 1000000, ERROR_INVALID_ARGUMENT);
+    TIM_LL_deinit_Expect(TIM_NUM_3);
+    TRY { (void)LA_init(&config); }
+    CATCH(err) {}
+
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, err);
+    // The logic analyzer can be initialized again
+    g_handle = init_default();
+}
+
+// Test: The DMA is armed before the timer starts pacing it
+void test_LA_start_arms_dma_first(void)
+{
+    g_handle = init_default();
+
+    LA_LL_start_Expect();
+    TIM_LL_start_Expect(TIM_NUM_3);
+    LA_start(g_handle);
+
+    TEST_ASSERT_TRUE(LA_is_running(g_handle));
+    LA_LL_get_position_ExpectAndReturn(100);
+    TEST_ASSERT_EQUAL_UINT32(100, LA_get_samples_acquired(g_handle));
+}
+
+// Test: The end of the DMA stops the timer and reports completion
+void test_LA_complete_stops_timer(void)
+{
+    g_handle = init_default();
+    LA_LL_start_Expect();
+    TIM_LL_start_Expect(TIM_NUM_3);
+    LA_start(g_handle);
+
+    TIM_LL_stop_Expect(TIM_NUM_3);
+    g_ll_callback(sizeof(g_buffer));
+
+    TEST_ASSERT_FALSE(LA_is_running(g_handle));
+    TEST_ASSERT_EQUAL_UINT32(1, g_completions);
+    TEST_ASSERT_EQUAL_UINT32(
+        sizeof(g_buffer), LA_get_samples_acquired(g_handle)
+    );
+}
+
+// Test: An aborted capture keeps the samples taken so far
+void test_LA_stop_keeps_position(void)
+{
+    g_handle = init_default();
+    LA_LL_start_Expect();
+    TIM_LL_start_Expect(TIM_NUM_3);
+    LA_start(g_handle);
+
+    TIM_LL_stop_Expect(TIM_NUM_3);
+    LA_LL_stop_Expect();
+    LA_LL_get_position_ExpectAndReturn(42);
+    LA_stop(g_handle);
+
+    TEST_ASSERT_FALSE(LA_is_running(g_handle));
+    TEST_ASSERT_EQUAL_UINT32(0, g_completions);
+    TEST_ASSERT_EQUAL_UINT32(42, LA_get_samples_acquired(g_handle));
+}
+
+// Test: A DMA that cannot be started leaves the analyzer stopped
+void test_LA_start_failure(void)
+{
+    Error err = ERROR_NONE;
+
+    g_handle = init_default();
+    LA_LL_start_ExpectAndThrow(ERROR_HARDWARE_FAULT);
+    LA_LL_stop_Expect();
+    TIM_LL_stop_Expect(TIM_NUM_3);
+    TRY { LA_start(g_handle); }
+    CATCH(err) {}
+
+    TEST_ASSERT_EQUAL(ERROR_HARDWARE_FAULT, err);
+    TEST_ASSERT_FALSE(LA_is_running(g_handle));
+}
+
+// Test: Calls with a stale handle are refused
+void test_LA_invalid_handle(void)
+{
+    Error err = ERROR_NONE;
+
+    TRY { LA_start(NULL); }
+    CATCH(err) {}
+
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, err);
+}
+
+// Test: A triggered capture starts at the sample entering the pattern
+void test_LA_trigger_on_pattern(void)
+{
+    // Rising edge of input 1 while input 0 is low
+    g_handle = start_processed(LA_STORAGE_RAW, 0x03, 0x02, 4);
+
+    // A pattern present at the start does not trigger
+    g_ll_block_callback((uint8_t const[]){ 0x02, 0x02, 0x03, 0x00 }, 4);
+    TEST_ASSERT_EQUAL_UINT32(0, LA_get_samples_acquired(g_handle));
+
+    g_ll_block_callback((uint8_t const[]){ 0x00, 0x06, 0x07, 0x01 }, 4);
+    TEST_ASSERT_EQUAL_UINT32(3, LA_get_samples_acquired(g_handle));
+
+    LA_LL_stop_Expect();
+    TIM_LL_stop_Expect(TIM_NUM_3);
+    g_ll_block_callback((uint8_t const[]){ 0x05, 0x04 }, 2);
+
+    TEST_ASSERT_FALSE(LA_is_running(g_handle));
+    TEST_ASSERT_EQUAL_UINT32(1, g_completions);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(
+        ((uint8_t const[]){ 0x06, 0x07, 0x01, 0x05 }), g_buffer, 4
+    );
+}
+
+// Test: Runs span blocks, and stopping stores the open run
+void test_LA_rle_encodes_runs(void)
+{
+    LA_Run runs[3];
+
+    g_handle = start_processed(LA_STORAGE_RLE, 0, 0, 8);
+    g_ll_block_callback((uint8_t const[]){ 0x01, 0x01, 0x01, 0x80 }, 4);
+    g_ll_block_callback((uint8_t const[]){ 0x80, 0x80, 0x01, 0x01 }, 4);
+    TEST_ASSERT_EQUAL_UINT32(2, LA_get_runs(g_handle));
+
+    TIM_LL_stop_Expect(TIM_NUM_3);
+    LA_LL_stop_Expect();
+    LA_stop(g_handle);
+
+    TEST_ASSERT_EQUAL_UINT32(3, LA_get_runs(g_handle));
+    TEST_ASSERT_EQUAL_UINT32(8, LA_get_samples_acquired(g_handle));
+    TEST_ASSERT_EQUAL_UINT32(0, g_completions);
+    memcpy(runs, g_buffer, sizeof(runs));
+    TEST_ASSERT_EQUAL_HEX32(0x00000301, runs[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x00000380, runs[1]);
+    TEST_ASSERT_EQUAL_HEX32(0x00000201, runs[2]);
+}
+
+// Test: A run-length capture ends when its buffer is full
+void test_LA_rle_stops_when_full(void)
+{
+    g_handle = start_processed(LA_STORAGE_RLE, 0, 0, 2);
+
+    LA_LL_stop_Expect();
+    TIM_LL_stop_Expect(TIM_NUM_3);
+    g_ll_block_callback((uint8_t const[]){ 0x01, 0x02, 0x02, 0x03 }, 4);
+
+    TEST_ASSERT_FALSE(LA_is_running(g_handle));
+    TEST_ASSERT_EQUAL_UINT32(1, g_completions);
+    TEST_ASSERT_EQUAL_UINT32(2, LA_get_runs(g_handle));
+    TEST_ASSERT_EQUAL_UINT32(3, LA_get_samples_acquired(g_handle));
+}
+
+// Test: Processed captures are limited by the CPU, and patterns by the mask
+void test_LA_processed_invalid_config(void)
+{
+    LA_Config config = LA_CONFIG_DEFAULT;
+    Error err = ERROR_NONE;
+
+    config.buffer = g_buffer;
+    config.storage = LA_STORAGE_RLE;
+    config.sample_rate = LA_SAMPLE_RATE_MAX_PROCESSED + 1;
+    TRY { (void)LA_init(&config); }
+    CATCH(err) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, err);
+
+    config.storage = LA_STORAGE_RAW;
+    config.sample_rate = 1000;
+    config.trigger_mask = 0x01;
+    config.trigger_pattern = 0x02;
+    err = ERROR_NONE;
+    TRY { (void)LA_init(&config); }
+    CATCH(err) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, err);
+}
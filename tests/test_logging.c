@@ -11,14 +11,65 @@ struct LOG_Handle {
     CircularBuffer buffer;
     uint8_t buffer_data[LOG_BUFFER_SIZE];
     bool initialized;
+    bool deferred;
+    LOG_TimestampSource timestamp_source;
+    uint32_t reserve;
+    uint32_t writers;
+    LOG_Stats stats;
+    LOG_Output output;
+    uint8_t staging[LOG_DRAIN_BUFFER_SIZE];
+    uint32_t staged;
+    uint32_t staged_sent;
 };
 
 static struct LOG_Handle *g_log_handle = nullptr;
 
+static uint32_t g_fake_time_us = 0;
+
+static uint32_t fake_time_us(void) { return g_fake_time_us; }
+
+static char g_output[256];
+static uint32_t g_output_len = 0;
+static uint32_t g_output_calls = 0;
+static uint32_t g_output_room = 0; // Bytes the fake output still accepts
+
+static uint32_t fake_output(uint8_t const *data, uint32_t size)
+{
+    uint32_t const accepted = size < g_output_room ? size : g_output_room;
+    memcpy(&g_output[g_output_len], data, accepted);
+    g_output_len += accepted;
+    g_output_room -= accepted;
+    g_output[g_output_len] = '\0';
+    ++g_output_calls;
+    return accepted;
+}
+
+// Timestamp source that logs, as an interrupt handler would in LOG_write
+static uint32_t nested_time_us(void)
+{
+    LOG_set_timestamp_source(fake_time_us);
+    LOG_write(LOG_LEVEL_ERROR, "nested %d", 2);
+    return 1;
+}
+
+static bool g_nest_on_reserve = false;
+
+// Called by logging.c once a record is reserved, before it is published
+void log_reserved_hook(void);
+void log_reserved_hook(void)
+{
+    // Log once, as an interrupt handler would between the two
+    if (g_nest_on_reserve) {
+        g_nest_on_reserve = false;
+        LOG_write(LOG_LEVEL_ERROR, "nested %d", 2);
+    }
+}
+
 void setUp(void)
 {
     // Initialize logging
     g_log_handle = LOG_init();
+    g_nest_on_reserve = false;
 }
 
 void tearDown(void)
@@ -90,7 +141,8 @@ void test_LOG_write(void)
     TEST_ASSERT_EQUAL(strlen(test_message), entry.length);
     TEST_ASSERT_EQUAL(
         bytes_written,
-        sizeof(entry.level) + sizeof(entry.length) + entry.length + 1
+        sizeof(entry.level) + sizeof(entry.timestamp) + sizeof(entry.length) +
+            entry.length + 1
     );
     // Verify the message is null-terminated
     TEST_ASSERT_EQUAL('\0', entry.message[entry.length]);
@@ -333,13 +385,14 @@ void test_LOG_buffer_reset_behavior(void)
     TEST_ASSERT_GREATER_THAN(0, bytes_written1);
     TEST_ASSERT_GREATER_THAN(0, LOG_available());
 
-    // Act - Reset the buffer
-    circular_buffer_reset(&g_log_handle->buffer);
+    // Act - Reset the buffer, along with the space reserved by writers
+    LOG_deinit(g_log_handle);
+    g_log_handle = LOG_init();
 
     // Assert - Buffer should be empty after reset
     TEST_ASSERT_EQUAL(0, LOG_available());
 
-    // Verify we can still write after reset (since LOG_init was called in setUp)
+    // Verify we can still write after reset
     int bytes_written2 = LOG_write(LOG_LEVEL_INFO, "After reset message");
     TEST_ASSERT_GREATER_THAN(0, bytes_written2);
     TEST_ASSERT_GREATER_THAN(0, LOG_available());
@@ -607,3 +660,273 @@ void test_LOG_consistent_state_on_multiple_initializations(void)
     TEST_ASSERT_EQUAL(LOG_LEVEL_INFO, entry.level);
     TEST_ASSERT_EQUAL_STRING(test_message, entry.message);
 }
+
+void test_LOG_write_deferred(void)
+{
+    // Arrange
+    LOG_set_deferred(true);
+
+    // Act
+    int bytes_written = LOG_write(
+        LOG_LEVEL_WARN, "ch %u: %d%% %08lX %.2f", 3U, -42, 0xBEEFUL, 1.5
+    );
+
+    // Assert - Only the format pointer and four arguments are stored
+    TEST_ASSERT_EQUAL(
+        sizeof(LOG_Level) + sizeof(uint32_t) + sizeof(uint16_t) +
+            sizeof(char const *) + (4 * sizeof(uintptr_t)),
+        bytes_written
+    );
+
+    LOG_Entry entry;
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL(LOG_LEVEL_WARN, entry.level);
+    TEST_ASSERT_EQUAL_STRING("ch 3: -42% 0000BEEF 1.50", entry.message);
+    TEST_ASSERT_EQUAL(strlen(entry.message), entry.length);
+    TEST_ASSERT_EQUAL(0, LOG_available());
+}
+
+void test_LOG_write_deferred_formats_strings_immediately(void)
+{
+    // Arrange
+    char name[] = "adc";
+    LOG_set_deferred(true);
+
+    // Act - The string argument may not outlive the call
+    int bytes_written = LOG_write(LOG_LEVEL_INFO, "%s ready", name);
+    name[0] = 'X';
+
+    // Assert
+    LOG_Entry entry;
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL_STRING("adc ready", entry.message);
+    TEST_ASSERT_EQUAL(
+        sizeof(entry.level) + sizeof(entry.timestamp) + sizeof(entry.length) +
+            entry.length + 1,
+        bytes_written
+    );
+}
+
+void test_LOG_write_deferred_mixed_with_formatted(void)
+{
+    // Arrange - Alternate deferred and formatted records
+    LOG_set_deferred(true);
+    TEST_ASSERT_GREATER_THAN(0, LOG_write(LOG_LEVEL_ERROR, "first %d", 1));
+    TEST_ASSERT_GREATER_THAN(
+        0, LOG_write(LOG_LEVEL_ERROR, "second %lld", 2LL)
+    );
+    LOG_set_deferred(false);
+    TEST_ASSERT_GREATER_THAN(0, LOG_write(LOG_LEVEL_DEBUG, "third %d", 3));
+
+    // Act & Assert - Records are read back in order
+    LOG_Entry entry;
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL_STRING("first 1", entry.message);
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL_STRING("second 2", entry.message);
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL(LOG_LEVEL_DEBUG, entry.level);
+    TEST_ASSERT_EQUAL_STRING("third 3", entry.message);
+    TEST_ASSERT_FALSE(LOG_read_entry(&entry));
+}
+
+void test_LOG_write_timestamp(void)
+{
+    // Arrange
+    LOG_Entry entry;
+    TEST_ASSERT_GREATER_THAN(0, LOG_write(LOG_LEVEL_INFO, "untimed"));
+    LOG_set_timestamp_source(fake_time_us);
+
+    // Act - Timestamps are taken when messages are written
+    g_fake_time_us = 1234567;
+    TEST_ASSERT_GREATER_THAN(0, LOG_write(LOG_LEVEL_INFO, "formatted"));
+    LOG_set_deferred(true);
+    g_fake_time_us = 2345678;
+    TEST_ASSERT_GREATER_THAN(0, LOG_write(LOG_LEVEL_INFO, "deferred %d", 1));
+    g_fake_time_us = 0;
+
+    // Assert
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL_UINT32(0, entry.timestamp);
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL_UINT32(1234567, entry.timestamp);
+    TEST_ASSERT_EQUAL_STRING("formatted", entry.message);
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL_UINT32(2345678, entry.timestamp);
+    TEST_ASSERT_EQUAL_STRING("deferred 1", entry.message);
+}
+
+void test_LOG_write_nested(void)
+{
+    // Arrange
+    g_nest_on_reserve = true;
+
+    // Act - The nested message is logged after the outer one is reserved
+    TEST_ASSERT_GREATER_THAN(0, LOG_write(LOG_LEVEL_INFO, "outer %d", 1));
+
+    // Assert - Both records are intact, in the order they were reserved
+    LOG_Entry entry;
+    TEST_ASSERT_FALSE(g_nest_on_reserve);
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL(LOG_LEVEL_INFO, entry.level);
+    TEST_ASSERT_EQUAL_STRING("outer 1", entry.message);
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL(LOG_LEVEL_ERROR, entry.level);
+    TEST_ASSERT_EQUAL_STRING("nested 2", entry.message);
+    TEST_ASSERT_FALSE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL(0, g_log_handle->writers);
+}
+
+void test_LOG_write_nested_timestamp(void)
+{
+    // Arrange
+    LOG_set_timestamp_source(nested_time_us);
+
+    // Act - The nested message is logged while the outer one is written
+    TEST_ASSERT_GREATER_THAN(0, LOG_write(LOG_LEVEL_INFO, "outer %d", 1));
+
+    // Assert - Both records are intact
+    LOG_Entry entry;
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL(LOG_LEVEL_ERROR, entry.level);
+    TEST_ASSERT_EQUAL_STRING("nested 2", entry.message);
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL(LOG_LEVEL_INFO, entry.level);
+    TEST_ASSERT_EQUAL_STRING("outer 1", entry.message);
+    TEST_ASSERT_FALSE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL(0, g_log_handle->writers);
+}
+
+void test_LOG_module_levels(void)
+{
+    // Arrange
+    LOG_set_level(LOG_MODULE_DEFAULT, LOG_LEVEL_ERROR);
+    int evaluated = 0;
+
+    // Act - Filtered messages do not evaluate their arguments
+    LOG_ERROR("kept %d", ++evaluated);
+#if LOG_COMPILE_TIME_LEVEL >= 1
+    LOG_WARN("dropped %d", ++evaluated);
+#endif
+
+    // Assert
+    LOG_Entry entry;
+    TEST_ASSERT_EQUAL(1, evaluated);
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+    TEST_ASSERT_EQUAL_STRING("kept 1", entry.message);
+    TEST_ASSERT_FALSE(LOG_read_entry(&entry));
+
+    TEST_ASSERT_FALSE(LOG_set_level(LOG_MODULE_COUNT, LOG_LEVEL_DEBUG));
+    TEST_ASSERT_FALSE(LOG_set_level(LOG_MODULE_DSO, (LOG_Level)4));
+    TEST_ASSERT_TRUE(LOG_set_level(LOG_MODULE_DSO, LOG_LEVEL_DEBUG));
+    TEST_ASSERT_EQUAL(LOG_LEVEL_DEBUG, LOG_get_level(LOG_MODULE_DSO));
+    TEST_ASSERT_EQUAL(LOG_LEVEL_ERROR, LOG_get_level(LOG_MODULE_DEFAULT));
+}
+
+void test_LOG_stats(void)
+{
+    // Arrange
+    LOG_Entry entry;
+    int const bytes = LOG_write(LOG_LEVEL_INFO, "LOG_Entry %d", 0);
+    TEST_ASSERT_GREATER_THAN(0, bytes);
+
+    // Act - Fill the buffer, then output one message
+    while (LOG_write(LOG_LEVEL_INFO, "LOG_Entry %d", 1) > 0) {
+    }
+    LOG_write(LOG_LEVEL_INFO, "LOG_Entry %d", 2);
+    TEST_ASSERT_EQUAL(1, LOG_task(1));
+
+    // Assert
+    LOG_Stats stats = LOG_get_stats();
+    uint32_t const fit = (LOG_BUFFER_SIZE - 1) / bytes;
+    TEST_ASSERT_EQUAL_UINT32(fit, stats.written);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.drained);
+    TEST_ASSERT_EQUAL_UINT32(fit * bytes, stats.high_water);
+    TEST_ASSERT_EQUAL_UINT32(LOG_BUFFER_SIZE - 1, stats.capacity);
+
+    // Clearing restarts the high-water mark from the buffered bytes
+    LOG_clear_stats();
+    stats = LOG_get_stats();
+    TEST_ASSERT_EQUAL_UINT32(0, stats.written);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.drained);
+    TEST_ASSERT_EQUAL_UINT32((fit - 1) * bytes, stats.high_water);
+    TEST_ASSERT_TRUE(LOG_read_entry(&entry));
+}
+
+void test_LOG_task_output_batches(void)
+{
+    // Arrange
+    g_output_len = 0;
+    g_output_calls = 0;
+    g_output_room = sizeof(g_output) - 1;
+    LOG_set_output(fake_output);
+    LOG_write(LOG_LEVEL_ERROR, "one");
+    LOG_write(LOG_LEVEL_INFO, "two");
+    LOG_write(LOG_LEVEL_DEBUG, "three");
+
+    // Act
+    int processed = LOG_task(0xF);
+
+    // Assert - All lines are passed to the output at once
+    TEST_ASSERT_EQUAL(3, processed);
+    TEST_ASSERT_EQUAL_UINT32(1, g_output_calls);
+    TEST_ASSERT_EQUAL_STRING(
+        "[ERROR] one\r\n[INFO ] two\r\n[DEBUG] three\r\n", g_output
+    );
+    LOG_set_output(nullptr);
+}
+
+void test_LOG_task_output_full(void)
+{
+    // Arrange - The output takes only part of the first batch
+    g_output_len = 0;
+    g_output_calls = 0;
+    g_output_room = 5;
+    LOG_set_output(fake_output);
+    LOG_write(LOG_LEVEL_ERROR, "one");
+    LOG_write(LOG_LEVEL_ERROR, "two");
+
+    // Act & Assert - The rest is kept until the output has room
+    TEST_ASSERT_EQUAL(2, LOG_task(0xF));
+    TEST_ASSERT_EQUAL_STRING("[ERRO", g_output);
+    LOG_write(LOG_LEVEL_ERROR, "three");
+    TEST_ASSERT_EQUAL(0, LOG_task(0xF));
+
+    g_output_room = sizeof(g_output) - 1 - g_output_len;
+    TEST_ASSERT_EQUAL(1, LOG_task(0xF));
+    TEST_ASSERT_EQUAL_STRING(
+        "[ERROR] one\r\n[ERROR] two\r\n[ERROR] three\r\n", g_output
+    );
+    LOG_set_output(nullptr);
+}
+
+void test_LOG_read_lines(void)
+{
+    // Arrange - One line is staged for an output that accepts nothing yet
+    uint8_t lines[LOG_LINE_SIZE_MAX + 16];
+    g_output_len = 0;
+    g_output_calls = 0;
+    g_output_room = 0;
+    LOG_set_output(fake_output);
+    LOG_write(LOG_LEVEL_ERROR, "one");
+    TEST_ASSERT_EQUAL(1, LOG_task(1));
+    LOG_write(LOG_LEVEL_INFO, "two");
+    LOG_write(LOG_LEVEL_DEBUG, "three");
+
+    // Act & Assert - Staged lines come first, then whole lines that fit
+    uint32_t len = LOG_read_lines(lines, 5);
+    TEST_ASSERT_EQUAL_UINT32(5, len);
+    TEST_ASSERT_EQUAL_MEMORY("[ERRO", lines, len);
+
+    len = LOG_read_lines(lines, sizeof(lines));
+    TEST_ASSERT_EQUAL_UINT32(sizeof("R] one\r\n[INFO ] two\r\n") - 1, len);
+    TEST_ASSERT_EQUAL_MEMORY("R] one\r\n[INFO ] two\r\n", lines, len);
+
+    len = LOG_read_lines(lines, sizeof(lines));
+    TEST_ASSERT_EQUAL_MEMORY("[DEBUG] three\r\n", lines, len);
+    TEST_ASSERT_EQUAL_UINT32(0, LOG_read_lines(lines, sizeof(lines)));
+    TEST_ASSERT_EQUAL_UINT32(3, LOG_get_stats().drained);
+    LOG_set_output(nullptr);
+}
@@ -0,0 +1,56 @@
+/**
+ * @file test_mask.c
+ * @brief Unit tests for the mask test
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "util/mask.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_mask_passes_samples_within_limits(void)
+{
+    // Arrange - limits are inclusive
+    MASK_Limit const limits[] = {
+        { .lower = 10, .upper = 20 },
+        { .lower = 10, .upper = 20 },
+        MASK_LIMIT_OPEN,
+    };
+    uint16_t const samples[] = { 10, 20, 4095 };
+    MASK_Result result;
+
+    // Act
+    MASK_test(limits, samples, 3, &result);
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT32(0, result.violations);
+    TEST_ASSERT_EQUAL_UINT32(MASK_NO_FAILURE, result.first);
+}
+
+void test_mask_counts_violations_from_first(void)
+{
+    // Arrange
+    MASK_Limit const limits[] = {
+        { .lower = 100, .upper = 200 },
+        { .lower = 100, .upper = 200 },
+        { .lower = 100, .upper = 200 },
+        { .lower = 100, .upper = 200 },
+    };
+    uint16_t const samples[] = { 150, 99, 150, 201 };
+    MASK_Result result;
+
+    // Act
+    MASK_test(limits, samples, 4, &result);
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT32(2, result.violations);
+    TEST_ASSERT_EQUAL_UINT32(1, result.first);
+}
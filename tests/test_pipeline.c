@@ -0,0 +1,228 @@
+/**
+ * @file test_pipeline.c
+ * @brief Unit tests for the block pipeline
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "util/pipeline.h"
+
+static PIPELINE_Block g_storage[4];
+static PIPELINE_State g_pipeline;
+
+// Sink and release records
+static uint32_t g_sink_calls;
+static bool g_sink_busy;
+static uint32_t g_sunk_count[8];
+static uint16_t const *g_sunk_data[8];
+static uint32_t g_sunk_sequence[8];
+static uint32_t g_released;
+static void const *g_released_data[8];
+
+// Stage records
+static uint32_t g_stage_calls;
+static uint16_t g_reduced[4];
+
+void setUp(void)
+{
+    g_sink_calls = 0;
+    g_sink_busy = false;
+    g_released = 0;
+    g_stage_calls = 0;
+}
+
+void tearDown(void) {}
+
+static bool record_sink(void *context, PIPELINE_Block const *block)
+{
+    (void)context;
+    if (g_sink_busy) {
+        return false;
+    }
+    g_sunk_data[g_sink_calls] = block->data;
+    g_sunk_count[g_sink_calls] = block->count;
+    g_sunk_sequence[g_sink_calls] = block->sequence;
+    g_sink_calls++;
+    return true;
+}
+
+static void record_release(void *context, void const *data)
+{
+    TEST_ASSERT_EQUAL_PTR(&g_pipeline, context);
+    g_released_data[g_released++] = data;
+}
+
+// Keeps the first sample of each pair, in a buffer of its own
+static bool halve_stage(void *context, PIPELINE_Block *block)
+{
+    (void)context;
+    uint16_t const *const samples = block->data;
+    g_stage_calls++;
+    for (uint32_t i = 0; i < block->count / 2; ++i) {
+        g_reduced[i] = samples[2 * i];
+    }
+    block->data = g_reduced;
+    block->count /= 2;
+    return true;
+}
+
+// Drops blocks of a single sample
+static bool drop_short_stage(void *context, PIPELINE_Block *block)
+{
+    (void)context;
+    g_stage_calls++;
+    return block->count > 1;
+}
+
+static void init_pipeline(PIPELINE_Stage const *stages, uint32_t count)
+{
+    bool const ok = PIPELINE_init(
+        &g_pipeline,
+        &(PIPELINE_Config){
+            .storage = g_storage,
+            .size = 4,
+            .stages = stages,
+            .stage_count = count,
+            .sink = { .function = record_sink },
+            .release = record_release,
+            .release_context = &g_pipeline,
+        }
+    );
+    TEST_ASSERT_TRUE(ok);
+}
+
+void test_init_rejects_bad_config(void)
+{
+    PIPELINE_Stage const missing[] = { { .function = nullptr } };
+
+    TEST_ASSERT_FALSE(PIPELINE_init(&g_pipeline, nullptr));
+    TEST_ASSERT_FALSE(PIPELINE_init(
+        &g_pipeline,
+        &(PIPELINE_Config){
+            .storage = g_storage, .size = 3, .sink = { record_sink } }
+    ));
+    TEST_ASSERT_FALSE(PIPELINE_init(
+        &g_pipeline, &(PIPELINE_Config){ .storage = g_storage, .size = 4 }
+    ));
+    TEST_ASSERT_FALSE(PIPELINE_init(
+        &g_pipeline,
+        &(PIPELINE_Config){
+            .storage = g_storage,
+            .size = 4,
+            .stages = missing,
+            .stage_count = 1,
+            .sink = { record_sink },
+        }
+    ));
+}
+
+void test_run_sinks_and_releases_in_order(void)
+{
+    // Arrange
+    uint16_t const first[] = { 1, 2 };
+    uint16_t const second[] = { 3 };
+    init_pipeline(nullptr, 0);
+
+    // Act
+    TEST_ASSERT_TRUE(PIPELINE_push(&g_pipeline, first, 2));
+    TEST_ASSERT_TRUE(PIPELINE_push(&g_pipeline, second, 1));
+    uint32_t const done = PIPELINE_run(&g_pipeline);
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT32(2, done);
+    TEST_ASSERT_EQUAL_UINT32(2, g_sink_calls);
+    TEST_ASSERT_EQUAL_PTR(first, g_sunk_data[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, g_sunk_count[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, g_sunk_sequence[1]);
+    TEST_ASSERT_EQUAL_UINT32(2, g_released);
+    TEST_ASSERT_EQUAL_PTR(second, g_released_data[1]);
+    TEST_ASSERT_FALSE(PIPELINE_is_busy(&g_pipeline));
+}
+
+void test_stage_reduces_block_and_pushed_data_is_released(void)
+{
+    // Arrange
+    PIPELINE_Stage const stages[] = { { .function = halve_stage } };
+    uint16_t const block[] = { 10, 11, 12, 13 };
+    init_pipeline(stages, 1);
+
+    // Act
+    PIPELINE_push(&g_pipeline, block, 4);
+    PIPELINE_run(&g_pipeline);
+
+    // Assert
+    TEST_ASSERT_EQUAL_PTR(g_reduced, g_sunk_data[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, g_sunk_count[0]);
+    TEST_ASSERT_EQUAL_UINT16(12, g_reduced[1]);
+    TEST_ASSERT_EQUAL_PTR(block, g_released_data[0]);
+}
+
+void test_stage_drops_block(void)
+{
+    // Arrange - the second stage is not reached by a dropped block
+    PIPELINE_Stage const stages[] = {
+        { .function = drop_short_stage },
+        { .function = halve_stage },
+    };
+    uint16_t const block[] = { 5 };
+    init_pipeline(stages, 2);
+
+    // Act
+    PIPELINE_push(&g_pipeline, block, 1);
+    uint32_t const done = PIPELINE_run(&g_pipeline);
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT32(1, done);
+    TEST_ASSERT_EQUAL_UINT32(1, g_stage_calls);
+    TEST_ASSERT_EQUAL_UINT32(0, g_sink_calls);
+    TEST_ASSERT_EQUAL_UINT32(1, g_pipeline.dropped);
+    TEST_ASSERT_EQUAL_PTR(block, g_released_data[0]);
+}
+
+void test_busy_sink_keeps_block_without_processing_again(void)
+{
+    // Arrange
+    PIPELINE_Stage const stages[] = { { .function = halve_stage } };
+    uint16_t const block[] = { 1, 2 };
+    init_pipeline(stages, 1);
+    PIPELINE_push(&g_pipeline, block, 2);
+
+    // Act
+    g_sink_busy = true;
+    uint32_t const refused = PIPELINE_run(&g_pipeline);
+    g_sink_busy = false;
+    uint32_t const taken = PIPELINE_run(&g_pipeline);
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT32(0, refused);
+    TEST_ASSERT_EQUAL_UINT32(1, taken);
+    TEST_ASSERT_EQUAL_UINT32(1, g_stage_calls);
+    TEST_ASSERT_EQUAL_UINT32(1, g_sunk_count[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, g_released);
+    TEST_ASSERT_EQUAL_UINT32(1, g_pipeline.consumed);
+}
+
+void test_push_counts_overruns_when_full(void)
+{
+    // Arrange - a queue of 4 holds 3 blocks
+    uint16_t const block[] = { 0 };
+    init_pipeline(nullptr, 0);
+
+    // Act
+    for (uint32_t i = 0; i < 3; ++i) {
+        TEST_ASSERT_TRUE(PIPELINE_push(&g_pipeline, block, 1));
+    }
+    bool const pushed = PIPELINE_push(&g_pipeline, block, 1);
+
+    // Assert
+    TEST_ASSERT_FALSE(pushed);
+    TEST_ASSERT_EQUAL_UINT32(1, g_pipeline.overruns);
+    TEST_ASSERT_EQUAL_UINT32(3, g_pipeline.pushed);
+    TEST_ASSERT_TRUE(PIPELINE_is_busy(&g_pipeline));
+}
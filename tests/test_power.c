@@ -0,0 +1,268 @@
+/**
+ * @file test_power.c
+ * @brief Unit tests for the power and energy meter
+ *
+ * The ADC and timer drivers are mocked and sample pairs are fed to the
+ * DMA callback directly. A 4095 mV reference makes one code a millivolt,
+ * so that the expected values are exact.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+
+#include "unity.h"
+#include "mock_adc_ll.h"
+#include "mock_clock.h"
+#include "mock_tim_ll.h"
+
+#include "util/error.h"
+#include "util/fixed_point.h"
+
+#include "power.h"
+
+// Intentionally non-static in power.c to enable testing
+extern void
+power_adc_complete_callback(uint16_t *buffer, uint32_t total_samples);
+
+enum {
+    PAIRS_PER_BLOCK = 128, // Pairs of a ring half
+    TEST_RATE = 1000, // Pairs per second
+};
+
+static POWER_Handle *g_handle;
+static ADC_LL_Config g_adc_config;
+
+static void
+adc_init_capture_stub(ADC_LL_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    g_adc_config = *config;
+}
+
+/**
+ * @brief Feed blocks of identical sample pairs to the callback
+ */
+static void feed_pairs(uint16_t voltage, uint16_t current, uint32_t blocks)
+{
+    uint16_t buffer[2 * PAIRS_PER_BLOCK];
+
+    for (uint32_t k = 0; k < PAIRS_PER_BLOCK; ++k) {
+        buffer[2 * k] = voltage;
+        buffer[2 * k + 1] = current;
+    }
+    for (uint32_t i = 0; i < blocks; ++i) {
+        power_adc_complete_callback(buffer, 2 * PAIRS_PER_BLOCK);
+    }
+}
+
+static void init_meter(POWER_Config const *config)
+{
+    ADC_LL_init_Stub(adc_init_capture_stub);
+    ADC_LL_set_complete_callback_Expect(power_adc_complete_callback);
+    ADC_LL_set_half_complete_callback_Expect(power_adc_complete_callback);
+    ADC_LL_get_reference_voltage_IgnoreAndReturn(4095);
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_6, config->sample_rate, TEST_RATE);
+    TIM_LL_start_Expect(TIM_NUM_6);
+    ADC_LL_start_Expect();
+
+    g_handle = POWER_init(config);
+    TEST_ASSERT_NOT_NULL(g_handle);
+}
+
+void setUp(void)
+{
+    g_handle = NULL;
+    mock_adc_ll_Init();
+    mock_tim_ll_Init();
+    mock_clock_Init();
+
+    TIM_LL_claim_IgnoreAndReturn(TIM_NUM_6);
+    TIM_LL_release_Ignore();
+    ADC_LL_get_timer_trigger_IgnoreAndReturn(ADC_TRIGGER_TIMER6);
+    ADC_LL_get_max_sample_rate_IgnoreAndReturn(2500000);
+    ADC_LL_is_initialized_IgnoreAndReturn(false);
+    CLOCK_request_Ignore();
+    CLOCK_release_Ignore();
+}
+
+void tearDown(void)
+{
+    if (g_handle != NULL) {
+        ADC_LL_stop_Ignore();
+        TIM_LL_stop_Ignore();
+        ADC_LL_deinit_Ignore();
+        TIM_LL_deinit_Ignore();
+        POWER_deinit(g_handle);
+        g_handle = NULL;
+    }
+
+    mock_adc_ll_Destroy();
+    mock_tim_ll_Destroy();
+    mock_clock_Destroy();
+}
+
+// Test: The two channels are converted together into a circular ring
+void test_POWER_init_simultaneous_ring(void)
+{
+    POWER_Config config = POWER_CONFIG_DEFAULT;
+    config.voltage_channel = 3;
+    config.current_channel = 5;
+    POWER_Reading reading = { 0 };
+
+    init_meter(&config);
+
+    TEST_ASSERT_EQUAL(ADC_LL_MODE_SIMULTANEOUS, g_adc_config.mode);
+    TEST_ASSERT_EQUAL(ADC_LL_CHANNEL_3, g_adc_config.channels[0]);
+    TEST_ASSERT_EQUAL(ADC_LL_CHANNEL_5, g_adc_config.channels[1]);
+    TEST_ASSERT_TRUE(g_adc_config.circular);
+    TEST_ASSERT_EQUAL_UINT32(0, g_adc_config.buffer_size % 4);
+
+    // Nothing accumulated yet
+    POWER_read(g_handle, &reading);
+    TEST_ASSERT_EQUAL_UINT64(0, reading.samples);
+    TEST_ASSERT_EQUAL_UINT32(TEST_RATE, reading.sample_rate);
+    TEST_ASSERT_EQUAL_INT64(0, reading.energy);
+}
+
+// Test: Means, RMS, power, energy and charge of a steady load
+void test_POWER_read_steady_load(void)
+{
+    POWER_Config config = POWER_CONFIG_DEFAULT;
+    config.sample_rate = TEST_RATE;
+    config.current_zero = FIXED_ONE; // Code 1000
+    POWER_Reading reading = { 0 };
+
+    init_meter(&config);
+    // 3 V and 0.5 A for 1024 pairs, 1.024 s
+    feed_pairs(3000, 1500, 8);
+    POWER_read(g_handle, &reading);
+
+    TEST_ASSERT_EQUAL_UINT64(1024, reading.samples);
+    TEST_ASSERT_EQUAL_INT64(3000000, reading.voltage_mean);
+    TEST_ASSERT_EQUAL_INT64(3000000, reading.voltage_rms);
+    TEST_ASSERT_EQUAL_INT64(500000, reading.current_mean);
+    TEST_ASSERT_EQUAL_INT64(500000, reading.current_rms);
+    TEST_ASSERT_EQUAL_INT64(1500000, reading.power_mean);
+    // 1.536 J and 0.512 C
+    TEST_ASSERT_EQUAL_INT64(1536000 / 3600, reading.energy);
+    TEST_ASSERT_EQUAL_INT64(512000 / 3600, reading.charge);
+}
+
+// Test: The gains scale the inputs to the load, and the power with both
+void test_POWER_read_gains(void)
+{
+    POWER_Config config = POWER_CONFIG_DEFAULT;
+    config.sample_rate = TEST_RATE;
+    config.voltage_gain = FIXED_FROM_INT(2);
+    config.current_gain = FIXED_FROM_INT(10);
+    POWER_Reading reading = { 0 };
+
+    init_meter(&config);
+    feed_pairs(1000, 100, 1);
+    POWER_read(g_handle, &reading);
+
+    TEST_ASSERT_EQUAL_INT64(2000000, reading.voltage_mean);
+    TEST_ASSERT_EQUAL_INT64(1000000, reading.current_mean);
+    TEST_ASSERT_EQUAL_INT64(2000000, reading.power_mean);
+}
+
+// Test: Currents below the zero are negative, their RMS is not
+void test_POWER_read_reverse_current(void)
+{
+    POWER_Config config = POWER_CONFIG_DEFAULT;
+    config.sample_rate = TEST_RATE;
+    config.current_zero = FIXED_ONE;
+    POWER_Reading reading = { 0 };
+
+    init_meter(&config);
+    // Half the time discharging at 0.2 A, half charging at 0.4 A
+    feed_pairs(2000, 1200, 4);
+    feed_pairs(2000, 600, 4);
+    POWER_read(g_handle, &reading);
+
+    TEST_ASSERT_EQUAL_INT64(-100000, reading.current_mean);
+    TEST_ASSERT_INT64_WITHIN(1, 316228, reading.current_rms);
+    TEST_ASSERT_EQUAL_INT64(-200000, reading.power_mean);
+    TEST_ASSERT_LESS_THAN_INT64(0, reading.charge);
+}
+
+// Test: Clearing starts afresh while the conversions go on
+void test_POWER_clear(void)
+{
+    POWER_Config config = POWER_CONFIG_DEFAULT;
+    config.sample_rate = TEST_RATE;
+    POWER_Reading reading = { 0 };
+
+    init_meter(&config);
+    feed_pairs(4000, 4000, 2);
+    POWER_clear(g_handle);
+    POWER_read(g_handle, &reading);
+    TEST_ASSERT_EQUAL_UINT64(0, reading.samples);
+    TEST_ASSERT_EQUAL_INT64(0, reading.voltage_mean);
+
+    feed_pairs(1000, 2000, 1);
+    POWER_read(g_handle, &reading);
+    TEST_ASSERT_EQUAL_UINT64(PAIRS_PER_BLOCK, reading.samples);
+    TEST_ASSERT_EQUAL_INT64(1000000, reading.voltage_mean);
+    TEST_ASSERT_EQUAL_INT64(2000000, reading.current_mean);
+}
+
+// Test: Invalid configurations are rejected before touching the ADC
+void test_POWER_init_invalid_config(void)
+{
+    POWER_Config configs[4] = {
+        POWER_CONFIG_DEFAULT,
+        POWER_CONFIG_DEFAULT,
+        POWER_CONFIG_DEFAULT,
+        POWER_CONFIG_DEFAULT,
+    };
+    configs[0].current_channel = configs[0].voltage_channel;
+    configs[1].voltage_channel = POWER_CHANNEL_MAX + 1;
+    configs[2].sample_rate = POWER_RATE_MAX + 1;
+    configs[3].current_gain = 0;
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        CEXCEPTION_T exception = CEXCEPTION_NONE;
+        TRY { g_handle = POWER_init(&configs[i]); }
+        CATCH(exception) {}
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+        TEST_ASSERT_NULL(g_handle);
+    }
+
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+    TRY { g_handle = POWER_init(NULL); }
+    CATCH(exception) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+}
+
+// Test: The meter needs the ADC to itself
+void test_POWER_init_adc_busy(void)
+{
+    POWER_Config const config = POWER_CONFIG_DEFAULT;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+    ADC_LL_is_initialized_IgnoreAndReturn(true);
+
+    TRY { g_handle = POWER_init(&config); }
+    CATCH(exception) {}
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, exception);
+    TEST_ASSERT_NULL(g_handle);
+}
+
+// Test: A failed ADC init leaves the meter free for another try
+void test_POWER_init_adc_failure(void)
+{
+    POWER_Config const config = POWER_CONFIG_DEFAULT;
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    ADC_LL_init_ExpectAnyArgsAndThrow(ERROR_HARDWARE_FAULT);
+
+    TRY { g_handle = POWER_init(&config); }
+    CATCH(exception) {}
+    TEST_ASSERT_EQUAL(ERROR_HARDWARE_FAULT, exception);
+    TEST_ASSERT_NULL(g_handle);
+
+    // The meter can be initialized again
+    init_meter(&config);
+}
@@ -0,0 +1,133 @@
+/**
+ * @file test_profile.c
+ * @brief Unit tests for the zone profiler
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "mock_platform.h"
+
+#include "profile.h"
+
+void setUp(void) { PROFILE_clear(); }
+
+void tearDown(void) {}
+
+// Helper recording one run of a zone between two cycle counts
+static void run_zone(PROFILE_Zone zone, uint32_t start, uint32_t end)
+{
+    PLATFORM_get_cycles_ExpectAndReturn(start);
+    uint32_t const begin = PROFILE_begin();
+    PLATFORM_get_cycles_ExpectAndReturn(end);
+    PROFILE_end(zone, begin);
+}
+
+// Test: Runs are counted with their shortest, longest and total duration
+void test_PROFILE_end_records_runs(void)
+{
+    run_zone(PROFILE_ZONE_LOG, 1000, 1300);
+    run_zone(PROFILE_ZONE_LOG, 2000, 2100);
+    run_zone(PROFILE_ZONE_LOG, 3000, 3500);
+
+    PROFILE_Stats const stats = PROFILE_get(PROFILE_ZONE_LOG);
+
+    TEST_ASSERT_EQUAL_UINT32(3, stats.count);
+    TEST_ASSERT_EQUAL_UINT32(100, stats.min);
+    TEST_ASSERT_EQUAL_UINT32(500, stats.max);
+    TEST_ASSERT_EQUAL_UINT64(900, stats.total);
+}
+
+// Test: A run across the cycle counter wrap has its true duration
+void test_PROFILE_end_counter_wraps(void)
+{
+    run_zone(PROFILE_ZONE_USB, UINT32_MAX - 15, 16);
+
+    PROFILE_Stats const stats = PROFILE_get(PROFILE_ZONE_USB);
+
+    TEST_ASSERT_EQUAL_UINT32(1, stats.count);
+    TEST_ASSERT_EQUAL_UINT32(32, stats.min);
+    TEST_ASSERT_EQUAL_UINT32(32, stats.max);
+}
+
+// Test: Zones are kept apart, and the macros time the code between them
+void test_PROFILE_macros_time_zone(void)
+{
+    PLATFORM_get_cycles_ExpectAndReturn(50);
+    PLATFORM_get_cycles_ExpectAndReturn(250);
+
+    PROFILE_BEGIN(PROFILE_ZONE_DSO_ISR);
+    PROFILE_END(PROFILE_ZONE_DSO_ISR);
+
+    TEST_ASSERT_EQUAL_UINT32(200, PROFILE_get(PROFILE_ZONE_DSO_ISR).max);
+    TEST_ASSERT_EQUAL_UINT32(0, PROFILE_get(PROFILE_ZONE_PROTOCOL).count);
+}
+
+// Test: Clearing discards all runs
+void test_PROFILE_clear(void)
+{
+    run_zone(PROFILE_ZONE_PROTOCOL, 0, 400);
+
+    PROFILE_clear();
+    run_zone(PROFILE_ZONE_PROTOCOL, 0, 700);
+
+    PROFILE_Stats const stats = PROFILE_get(PROFILE_ZONE_PROTOCOL);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.count);
+    TEST_ASSERT_EQUAL_UINT32(700, stats.min);
+}
+
+// Test: Zones out of range are neither recorded nor reported
+void test_PROFILE_invalid_zone(void)
+{
+    run_zone(PROFILE_ZONE_COUNT, 0, 100);
+
+    PROFILE_Stats const stats = PROFILE_get(PROFILE_ZONE_COUNT);
+
+    TEST_ASSERT_EQUAL_UINT32(0, stats.count);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.max);
+}
+
+// Test: Durations kept by the caller are updated like those of a zone
+void test_PROFILE_record_caller_stats(void)
+{
+    PROFILE_Stats stats = { 0 };
+
+    PLATFORM_get_cycles_ExpectAndReturn(600);
+    PROFILE_record(&stats, 100);
+    PLATFORM_get_cycles_ExpectAndReturn(1200);
+    PROFILE_record(&stats, 1000);
+
+    TEST_ASSERT_EQUAL_UINT32(2, stats.count);
+    TEST_ASSERT_EQUAL_UINT32(200, stats.min);
+    TEST_ASSERT_EQUAL_UINT32(500, stats.max);
+    TEST_ASSERT_EQUAL_UINT64(700, stats.total);
+    TEST_ASSERT_EQUAL_UINT32(0, PROFILE_get(PROFILE_ZONE_PROTOCOL).count);
+}
+
+// Test: A boot stage keeps the time of its first mark
+void test_PROFILE_boot_mark_keeps_first(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(0, PROFILE_get_boot_time(PROFILE_BOOT_USB));
+
+    PLATFORM_get_time_us_ExpectAndReturn(1850);
+    PROFILE_boot_mark(PROFILE_BOOT_USB);
+
+    // Marked already, the clock is not read again
+    PROFILE_boot_mark(PROFILE_BOOT_USB);
+    PROFILE_clear();
+
+    TEST_ASSERT_EQUAL_UINT32(1850, PROFILE_get_boot_time(PROFILE_BOOT_USB));
+    TEST_ASSERT_EQUAL_UINT32(0, PROFILE_get_boot_time(PROFILE_BOOT_READY));
+}
+
+// Test: Boot stages out of range are neither marked nor reported
+void test_PROFILE_boot_mark_invalid_stage(void)
+{
+    PROFILE_boot_mark(PROFILE_BOOT_COUNT);
+
+    TEST_ASSERT_EQUAL_UINT32(0, PROFILE_get_boot_time(PROFILE_BOOT_COUNT));
+}
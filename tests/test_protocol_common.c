@@ -21,14 +21,20 @@
 #include <stdio.h>
 
 #include "unity.h"
+#include "mock_bridge.h"
 #include "mock_dmm.h"
 #include "mock_dso.h"
+#include "mock_uart.h"
 #include "mock_usb.h"
 #include "mock_system.h"
+#include "mock_profile.h"
+#include "mock_update.h"
 #include "scpi_test_helpers.h"
 
+#include "util/crc.h"
 #include "util/error.h"
 #include "util/fixed_point.h"
+#include "util/logging.h"
 #include "util/util.h"
 
 #include "application/protocol.h"
@@ -44,6 +50,7 @@ static USB_Handle *g_mock_usb_handle;
 static CircularBuffer g_mock_usb_rx_buffer;
 static uint8_t g_mock_usb_rx_data[SCPI_TEST_USB_BUFFER_SIZE];
 static uint32_t g_mock_system_tick;
+static bool g_dmm_ready = true; // Reported by the reads that succeed
 
 void setUp(void)
 {
@@ -62,7 +69,15 @@ void setUp(void)
 
     // Initialize mocks
     mock_usb_Init();
+    mock_uart_Init();
     mock_system_Init();
+    mock_bridge_Init();
+
+    // Boot stages are marked by whichever test sends a response first
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
 }
 
 void tearDown(void)
@@ -71,12 +86,15 @@ void tearDown(void)
     if (protocol_is_initialized()) {
         // Set up mock expectations for cleanup
         USB_deinit_Ignore();
+        UART_deinit_Ignore();
         protocol_deinit();
     }
 
     // Clean up mocks
     mock_usb_Destroy();
+    mock_uart_Destroy();
     mock_system_Destroy();
+    mock_bridge_Destroy();
 }
 
 // ============================================================================
@@ -172,6 +190,8 @@ void test_protocol_init_success(void)
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Expect(g_mock_usb_handle, NULL, 1);
     USB_set_rx_callback_IgnoreArg_callback(); // Don't care about callback function
+    USB_set_event_driven_Expect(g_mock_usb_handle, true);
+    USB_flush_Ignore();
 
     // Act
     bool result = protocol_init();
@@ -204,6 +224,8 @@ void test_protocol_init_multiple_calls(void)
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Expect(g_mock_usb_handle, NULL, 1);
     USB_set_rx_callback_IgnoreArg_callback();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
 
     bool first_result = protocol_init();
     TEST_ASSERT_TRUE(first_result);
@@ -225,6 +247,8 @@ void test_protocol_deinit_when_initialized(void)
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Expect(g_mock_usb_handle, NULL, 1);
     USB_set_rx_callback_IgnoreArg_callback();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
 
     bool init_result = protocol_init();
     TEST_ASSERT_TRUE(init_result);
@@ -265,6 +289,8 @@ void test_protocol_task_with_no_usb_data(void)
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Expect(g_mock_usb_handle, NULL, 1);
     USB_set_rx_callback_IgnoreArg_callback();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
 
     protocol_init();
 
@@ -290,6 +316,8 @@ void test_scpi_idn_query(void)
     USB_init_IgnoreArg_rx_buffer();
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
     protocol_init();
 
     // Set up USB communication mocks
@@ -320,6 +348,8 @@ void test_scpi_rst_command(void)
     USB_init_IgnoreArg_rx_buffer();
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
     protocol_init();
 
     // Set up USB communication mocks
@@ -339,6 +369,77 @@ void test_scpi_rst_command(void)
     TEST_ASSERT_EQUAL(0, strlen(response)); // No response expected
 }
 
+// Test: A service request toggles the ring indicator on the interrupt
+// endpoint and carries the status byte
+void test_scpi_service_request_notification(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Ignore();
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+
+    // ESB and RQS set in the status byte; the first request raises the ring
+    // indicator, the next one drops it again
+    USB_notify_Expect(g_mock_usb_handle, 0x6000 | USB_SERIAL_STATE_RING);
+    USB_notify_Expect(g_mock_usb_handle, 0x6000);
+
+    // Act
+    scpi_inject_usb_command("*SRE 32;*ESE 1;*OPC\n");
+    protocol_task();
+    scpi_inject_usb_command("*CLS;*OPC\n");
+    protocol_task();
+
+    // Assert - no response expected
+    TEST_ASSERT_EQUAL(0, strlen(scpi_get_captured_response()));
+}
+
+// Test: Instrument events enabled in the OPERation register raise a service
+// request once they are latched
+void test_scpi_operation_event_service_request(void)
+{
+    extern void protocol_operation_event(uint16_t bits);
+
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Ignore();
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+
+    scpi_inject_usb_command("*SRE 128;:STATus:OPERation:ENABle 256\n");
+    protocol_task();
+
+    // A disabled event raises no request
+    protocol_operation_event(1U << 9);
+    protocol_task();
+
+    // Act - OPER and RQS set in the status byte
+    USB_notify_Expect(g_mock_usb_handle, 0xC000 | USB_SERIAL_STATE_RING);
+    protocol_operation_event(1U << 8);
+    protocol_task();
+
+    // Assert - both events are in the register, and reading clears it
+    scpi_inject_usb_command("STATus:OPERation?;*STB?\n");
+    protocol_task();
+    TEST_ASSERT_EQUAL_STRING("768;0\r\n", scpi_get_captured_response());
+}
+
 void test_scpi_tst_query(void)
 {
     // Arrange
@@ -346,6 +447,8 @@ void test_scpi_tst_query(void)
     USB_init_IgnoreArg_rx_buffer();
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
     protocol_init();
 
     USB_task_Expect(g_mock_usb_handle);
@@ -372,6 +475,8 @@ void test_scpi_system_error_query(void)
     USB_init_IgnoreArg_rx_buffer();
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
     protocol_init();
 
     USB_task_Expect(g_mock_usb_handle);
@@ -391,9 +496,954 @@ void test_scpi_system_error_query(void)
     TEST_ASSERT_TRUE(strstr(response, "0,") != NULL);
 }
 
-// ============================================================================
-// USB Communication and Error Handling Tests
-// ============================================================================
+void test_scpi_system_profile_query(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+
+    PROFILE_Stats const idle = { 0 };
+    PROFILE_Stats const log = { .count = 4, .min = 100, .max = 700,
+                                .total = 1200 };
+    PROFILE_get_frequency_ExpectAndReturn(250000000);
+    for (uint32_t zone = 0; zone < PROFILE_ZONE_COUNT; ++zone) {
+        PROFILE_get_ExpectAndReturn(
+            (PROFILE_Zone)zone, zone == PROFILE_ZONE_LOG ? log : idle
+        );
+    }
+
+    scpi_inject_usb_command("SYST:PROF?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert - Frequency, then count, min, max and mean of each zone
+    TEST_ASSERT_EQUAL_STRING(
+        "250000000,0,0,0,0,0,0,0,0,4,100,700,300,0,0,0,0,0,0,0,0\r\n",
+        scpi_get_captured_response()
+    );
+}
+
+void test_scpi_system_boot_query(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+
+    // No response has been sent yet when the query runs
+    uint32_t const times[PROFILE_BOOT_COUNT] = { 1200, 1250, 1900, 2000, 0 };
+    for (uint32_t stage = 0; stage < PROFILE_BOOT_COUNT; ++stage) {
+        PROFILE_get_boot_time_ExpectAndReturn(
+            (PROFILE_BootStage)stage, times[stage]
+        );
+    }
+
+    scpi_inject_usb_command("SYST:BOOT?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert - One time per stage in microseconds
+    TEST_ASSERT_EQUAL_STRING(
+        "1200,1250,1900,2000,0\r\n", scpi_get_captured_response()
+    );
+}
+
+// Stub timing every command handler run at 100 cycles
+static void record_stub(PROFILE_Stats *stats, uint32_t start, int n)
+{
+    (void)start;
+    (void)n;
+    stats->min = 100;
+    stats->max = 100;
+    stats->total += 100;
+    stats->count += 1;
+}
+
+void test_scpi_system_statistics_commands_query(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+
+    PROFILE_record_StubWithCallback(record_stub);
+    PROFILE_get_frequency_ExpectAndReturn(250000000);
+
+    scpi_inject_usb_command(
+        "SYST:STAT:COMM:CLE\n*IDN?;*IDN?\nSYST:STAT:COMM?\n"
+    );
+
+    // Act
+    protocol_task();
+
+    // Assert - Frequency, then pattern, count, min, max and mean of each
+    // command called since the clear, the query itself still running
+    TEST_ASSERT_EQUAL_STRING(
+        "FOSSASIA,PSLab,1.0,v1.0.0;FOSSASIA,PSLab,1.0,v1.0.0\r\n"
+        "250000000,*IDN?,2,100,100,100,"
+        "SYSTem:STATistics:COMMands:CLEar,1,100,100,100\r\n",
+        scpi_get_captured_response()
+    );
+}
+
+void test_scpi_system_memory_query(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+
+    SYSTEM_HeapStats const heap = {
+        .size = 46080, .used = 512, .peak = 1024, .headroom = 45056
+    };
+    SYSTEM_get_heap_stats_ExpectAndReturn(heap);
+
+    scpi_inject_usb_command("SYST:MEM?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert - Heap figures, then the sample memory, empty after reset. Its
+    // peak depends on the tests run before.
+    char const *const response = scpi_get_captured_response();
+    char const heap_prefix[] = "46080,512,1024,45056,311296,0,";
+    char const samples_suffix[] = ",311296\r\n";
+    size_t const length = strlen(response);
+    TEST_ASSERT_EQUAL_STRING_LEN(
+        heap_prefix, response, sizeof(heap_prefix) - 1
+    );
+    TEST_ASSERT_GREATER_THAN(sizeof(samples_suffix) - 1, length);
+    TEST_ASSERT_EQUAL_STRING(
+        samples_suffix, &response[length - (sizeof(samples_suffix) - 1)]
+    );
+}
+
+void test_scpi_system_stack_query(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+
+    SYSTEM_StackStats const stacks = {
+        .main = { .size = 4096, .peak = 1480 },
+        .interrupt = { .size = 2048, .peak = 312 },
+    };
+    SYSTEM_get_stack_stats_ExpectAndReturn(stacks);
+
+    scpi_inject_usb_command("SYST:STAC?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert - Size and deepest use of the main, then the interrupt stack
+    TEST_ASSERT_EQUAL_STRING(
+        "4096,1480,2048,312\r\n", scpi_get_captured_response()
+    );
+}
+
+void test_scpi_system_irq_query(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+
+    SYSTEM_IrqInfo info[] = {
+        { .name = "ADC1", .priority = 1, .enabled = true },
+        { .name = "USART1", .priority = 7, .enabled = false },
+    };
+    SYSTEM_get_irq_info_ExpectAndReturn(NULL, SYSTEM_IRQ_INFO_MAX, 2);
+    SYSTEM_get_irq_info_IgnoreArg_info();
+    SYSTEM_get_irq_info_ReturnArrayThruPtr_info(info, 2);
+
+    scpi_inject_usb_command("SYST:IRQ?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert - Name, priority and enabled state of each interrupt
+    TEST_ASSERT_EQUAL_STRING(
+        "ADC1,1,1,USART1,7,0\r\n", scpi_get_captured_response()
+    );
+}
+
+void test_scpi_system_time_sof_query(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+
+    uint32_t frame = 183948;
+    uint32_t time_us = 183951227;
+    USB_get_frame_stamp_ExpectAnyArgsAndReturn(true);
+    USB_get_frame_stamp_ReturnThruPtr_frame(&frame);
+    USB_get_frame_stamp_ReturnThruPtr_time_us(&time_us);
+
+    scpi_inject_usb_command("SYST:TIME:SOF?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert - Frame count, then its local time
+    TEST_ASSERT_EQUAL_STRING(
+        "183948,183951227\r\n", scpi_get_captured_response()
+    );
+}
+
+void test_scpi_system_log_level(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+    LOG_init();
+    LOG_set_level(LOG_MODULE_DSO, LOG_LEVEL_ERROR);
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+
+    scpi_inject_usb_command("SYST:LOG:LEV DSO,DEB;LEV? DSO;LEV? DMM\n");
+
+    // Act
+    protocol_task();
+
+    // Assert - Only the DSO module level changed
+    TEST_ASSERT_EQUAL_STRING("DEB;ERR\r\n", scpi_get_captured_response());
+    TEST_ASSERT_EQUAL(LOG_LEVEL_DEBUG, LOG_get_level(LOG_MODULE_DSO));
+    TEST_ASSERT_EQUAL(LOG_LEVEL_ERROR, LOG_get_level(LOG_MODULE_DMM));
+}
+
+void test_scpi_system_log_statistics_query(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+    LOG_init();
+    LOG_clear_stats();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+
+    char expected[64];
+    snprintf(
+        expected,
+        sizeof(expected),
+        "0,0,0,%zu,%d\r\n",
+        LOG_available(),
+        LOG_BUFFER_SIZE - 1
+    );
+    scpi_inject_usb_command("SYST:LOG:STAT?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert - Written, dropped, drained, high-water mark and capacity
+    TEST_ASSERT_EQUAL_STRING(expected, scpi_get_captured_response());
+}
+
+void test_scpi_system_log_sink(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+    SYSTEM_set_log_sink_Expect(SYSTEM_LOG_SINK_QUERY);
+    SYSTEM_get_log_sink_ExpectAndReturn(SYSTEM_LOG_SINK_QUERY);
+
+    scpi_inject_usb_command("SYST:LOG:SINK QUER;SINK?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("QUER\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_system_communicate_serial_query(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+    UART_LineConfig config = UART_LINE_CONFIG_DEFAULT;
+    config.baudrate = 2000000;
+    config.parity = UART_LINE_PARITY_ODD;
+    config.stop_bits = UART_LINE_STOP_BITS_2;
+    SYSTEM_get_uart_config_ExpectAndReturn(config);
+
+    scpi_inject_usb_command("SYST:COMM:SER?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("2000000,ODD,2\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_system_communicate_bridge(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+    BRIDGE_start_Expect(1);
+    size_t bus = 1;
+    BRIDGE_active_ExpectAnyArgsAndReturn(true);
+    BRIDGE_active_ReturnThruPtr_uart_bus(&bus);
+
+    scpi_inject_usb_command("SYST:COMM:BRID 1;BRID?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("1\r\n", scpi_get_captured_response());
+}
+
+static char g_uart_input[64]; // Commands the UART session receives
+static size_t g_uart_input_len;
+static char g_uart_output[64]; // Responses it sends
+static size_t g_uart_output_len;
+static uint32_t g_uart_baudrate; // Set by the last UART_configure
+static bool g_uart_flow_control;
+
+static bool mock_uart_rx_ready_check(UART_Handle *handle, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    return g_uart_input_len > 0;
+}
+
+static uint32_t mock_uart_read_inject(UART_Handle *handle, uint8_t *buffer, uint32_t max_len, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    uint32_t const count = g_uart_input_len < max_len ? (uint32_t)g_uart_input_len : max_len;
+    memcpy(buffer, g_uart_input, count);
+    memmove(g_uart_input, g_uart_input + count, g_uart_input_len - count);
+    g_uart_input_len -= count;
+    return count;
+}
+
+static uint32_t mock_uart_write_capture(UART_Handle *handle, uint8_t const *data, uint32_t len, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    TEST_ASSERT_LESS_THAN(sizeof(g_uart_output), g_uart_output_len + len);
+    memcpy(g_uart_output + g_uart_output_len, data, len);
+    g_uart_output_len += len;
+    g_uart_output[g_uart_output_len] = '\0';
+    return len;
+}
+
+static void mock_uart_configure_capture(UART_Handle *handle, UART_LineConfig const *config, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    g_uart_baudrate = config->baudrate;
+    g_uart_flow_control = config->flow_control;
+}
+
+static void inject_uart_command(char const *command)
+{
+    size_t const len = strlen(command);
+    memcpy(g_uart_input + g_uart_input_len, command, len);
+    g_uart_input_len += len;
+}
+
+/**
+ * @brief Initialize the protocol and open a UART session on bus 1
+ */
+static void open_uart_session(UART_Handle *uart_handle)
+{
+    g_uart_input_len = 0;
+    g_uart_output_len = 0;
+    g_uart_output[0] = '\0';
+
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Ignore();
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+    UART_rx_ready_StubWithCallback(mock_uart_rx_ready_check);
+    UART_read_StubWithCallback(mock_uart_read_inject);
+    UART_write_StubWithCallback(mock_uart_write_capture);
+    UART_init_ExpectAndReturn(1, NULL, NULL, uart_handle);
+    UART_init_IgnoreArg_rx_buffer();
+    UART_init_IgnoreArg_tx_buffer();
+    UART_configure_StubWithCallback(mock_uart_configure_capture);
+
+    scpi_inject_usb_command("SYST:COMM:SESS:UART 1,921600\n");
+    protocol_task();
+}
+
+void test_scpi_system_communicate_session_uart(void)
+{
+    // Arrange
+    UART_Handle *uart_handle = (UART_Handle *)0x87654321;
+    open_uart_session(uart_handle);
+    TEST_ASSERT_EQUAL_UINT32(921600, g_uart_baudrate);
+    TEST_ASSERT_FALSE(g_uart_flow_control);
+
+    // Act: each session has its own status registers and error queue
+    inject_uart_command("SYST:COMM:SESS?;*ESE 4;*ESE?;FOO\n");
+    protocol_task();
+    scpi_inject_usb_command("SYST:COMM:SESS?;SESS:CAT?;*ESE?;:SYST:ERR?\n");
+    protocol_task();
+    inject_uart_command("SYST:ERR?\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING(
+        "1;4\r\n-113,\"Undefined header;FOO\"\r\n", g_uart_output
+    );
+    TEST_ASSERT_EQUAL_STRING(
+        "0;CDC,UART1,OFF;0;0,\"No error\"\r\n", scpi_get_captured_response()
+    );
+}
+
+void test_scpi_system_communicate_session_uart_flow_control(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Ignore();
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+    UART_rx_ready_StubWithCallback(mock_uart_rx_ready_check);
+    UART_init_ExpectAndReturn(1, NULL, NULL, (UART_Handle *)0x87654321);
+    UART_init_IgnoreArg_rx_buffer();
+    UART_init_IgnoreArg_tx_buffer();
+    UART_configure_StubWithCallback(mock_uart_configure_capture);
+    g_uart_input_len = 0;
+
+    // Act
+    scpi_inject_usb_command("SYST:COMM:SESS:UART 1,115200,HARD\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT32(115200, g_uart_baudrate);
+    TEST_ASSERT_TRUE(g_uart_flow_control);
+}
+
+void test_scpi_system_communicate_session_close(void)
+{
+    // Arrange
+    UART_Handle *uart_handle = (UART_Handle *)0x87654321;
+    open_uart_session(uart_handle);
+
+    // Act: session 0 stays open, the UART session closes itself
+    scpi_inject_usb_command("SYST:COMM:SESS:CLOS 0;:SYST:ERR?\n");
+    protocol_task();
+    inject_uart_command("SYST:COMM:SESS:CLOS\n");
+    protocol_task();
+    UART_deinit_Expect(uart_handle);
+    scpi_inject_usb_command("SYST:COMM:SESS:CAT?\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING(
+        "-224,\"Illegal parameter value\"\r\nCDC,OFF,OFF\r\n",
+        scpi_get_captured_response()
+    );
+}
+
+void test_scpi_system_communicate_session_refused(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Ignore();
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+    UART_init_ExpectAndThrow(7, NULL, NULL, ERROR_INVALID_ARGUMENT);
+    UART_init_IgnoreArg_rx_buffer();
+    UART_init_IgnoreArg_tx_buffer();
+    // The bridge holds the USB bridge port
+    USB_init_ExpectAndThrow(
+        USB_INTERFACE_BRIDGE, NULL, NULL, ERROR_RESOURCE_BUSY
+    );
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+
+    scpi_inject_usb_command("SYST:COMM:SESS:UART 7;:SYST:ERR?\n");
+    scpi_inject_usb_command("SYST:COMM:SESS:USB;:SYST:ERR?\n");
+    scpi_inject_usb_command("SYST:COMM:SESS:CAT?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING(
+        "-224,\"Illegal parameter value\"\r\n"
+        "-200,\"Execution error\"\r\nCDC,OFF,OFF\r\n",
+        scpi_get_captured_response()
+    );
+}
+
+static uint32_t g_update_offset;
+static uint8_t g_update_data[16];
+static uint32_t g_update_size;
+
+/**
+ * @brief Mock UPDATE_write capturing the part written
+ */
+static void mock_update_write_capture(uint32_t offset, void const *data, uint32_t size, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(sizeof(g_update_data), size);
+    g_update_offset = offset;
+    memcpy(g_update_data, data, size);
+    g_update_size = size;
+}
+
+void test_scpi_system_update_data(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+    UPDATE_write_StubWithCallback(mock_update_write_capture);
+    UPDATE_get_state_ExpectAndReturn(UPDATE_STATE_RECEIVING);
+
+    scpi_inject_usb_command("SYST:UPD:DATA 1024,#15AB\nCD;STAT?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert - The block is passed on as is, newline included
+    TEST_ASSERT_EQUAL_UINT32(1024, g_update_offset);
+    TEST_ASSERT_EQUAL_UINT32(5, g_update_size);
+    TEST_ASSERT_EQUAL_MEMORY("AB\nCD", g_update_data, 5);
+    TEST_ASSERT_EQUAL_STRING("REC\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_system_update_apply_not_ready(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+    UPDATE_apply_ExpectAndThrow(ERROR_DEVICE_NOT_READY);
+
+    scpi_inject_usb_command("SYST:UPD:APPL;:SYST:ERR?\n");
+
+    // Act - No reset without a sealed image
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_NOT_NULL(strstr(scpi_get_captured_response(), "-221,"));
+}
+
+// ============================================================================
+// Binary Protocol Tests
+// ============================================================================
+
+static USB_Handle *g_mock_usb_bulk_handle = (USB_Handle *)0x2468ACE0;
+static uint8_t g_bulk_rx[64];
+static uint32_t g_bulk_rx_len;
+static uint8_t g_bulk_tx[64];
+static uint32_t g_bulk_tx_len;
+
+/**
+ * @brief Mock USB_read returning binary requests on the bulk interface
+ */
+static uint32_t mock_usb_read_split(USB_Handle *handle, uint8_t *buffer, uint32_t max_len, int cmock_num_calls)
+{
+    if (handle != g_mock_usb_bulk_handle) {
+        return mock_usb_read_inject(handle, buffer, max_len, cmock_num_calls);
+    }
+
+    uint32_t const len = g_bulk_rx_len < max_len ? g_bulk_rx_len : max_len;
+    memcpy(buffer, g_bulk_rx, len);
+    memmove(g_bulk_rx, g_bulk_rx + len, g_bulk_rx_len - len);
+    g_bulk_rx_len -= len;
+    return len;
+}
+
+/**
+ * @brief Mock USB_write capturing bulk and SCPI output separately
+ */
+static uint32_t mock_usb_write_split(USB_Handle *handle, uint8_t const *data, uint32_t len, int cmock_num_calls)
+{
+    if (handle != g_mock_usb_bulk_handle) {
+        return mock_usb_write_capture(handle, data, len, cmock_num_calls);
+    }
+
+    memcpy(g_bulk_tx + g_bulk_tx_len, data, len);
+    g_bulk_tx_len += len;
+    return len;
+}
+
+/**
+ * @brief Queue a binary request, with its CRC, on the bulk interface
+ */
+static void inject_binary_request(uint8_t opcode, uint8_t tag, uint8_t const *payload, uint16_t len)
+{
+    uint8_t *frame = g_bulk_rx + g_bulk_rx_len;
+    frame[0] = 0xB5;
+    frame[1] = opcode;
+    frame[2] = tag;
+    frame[3] = (uint8_t)len;
+    frame[4] = (uint8_t)(len >> 8);
+    memcpy(&frame[5], payload, len);
+    uint16_t const crc = CRC16_update(CRC16_INIT, &frame[1], 4U + len);
+    frame[5 + len] = (uint8_t)crc;
+    frame[6 + len] = (uint8_t)(crc >> 8);
+    g_bulk_rx_len += 7U + len;
+}
+
+/**
+ * @brief Initialize the protocol, expecting the bulk interface to open
+ */
+static void setup_bulk_interface(uint32_t tx_free)
+{
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    USB_init_ExpectAndReturn(USB_INTERFACE_BULK, NULL, NULL, g_mock_usb_bulk_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_split);
+    USB_write_StubWithCallback(mock_usb_write_split);
+    USB_tx_free_space_IgnoreAndReturn(tx_free);
+    g_bulk_rx_len = 0;
+    g_bulk_tx_len = 0;
+}
+
+/**
+ * @brief Initialize the protocol and enable the binary protocol
+ */
+static void setup_binary_protocol(void)
+{
+    setup_bulk_interface(4096);
+}
+
+void test_scpi_system_communicate_binary(void)
+{
+    // Arrange
+    setup_binary_protocol();
+    USB_task_Expect(g_mock_usb_handle);
+    scpi_inject_usb_command("SYST:COMM:BIN ON;BIN?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("1\r\n", scpi_get_captured_response());
+    TEST_ASSERT_EQUAL(0, g_bulk_tx_len);
+}
+
+void test_binary_ping_pipelined_after_corrupt_request(void)
+{
+    // Arrange - A request with a broken CRC, then two pings
+    setup_binary_protocol();
+    USB_task_Expect(g_mock_usb_handle);
+    scpi_inject_usb_command("SYST:COMM:BIN ON\n");
+    inject_binary_request(0x00, 1, (uint8_t const *)"x", 1);
+    g_bulk_rx[6] ^= 0xFF;
+    inject_binary_request(0x00, 2, (uint8_t const *)"hi", 2);
+    inject_binary_request(0x00, 3, nullptr, 0);
+
+    // Act
+    protocol_task();
+
+    // Assert - Both pings answered in one pass, the broken request dropped
+    uint8_t const expected[] = { 0xB5, 0x80, 2, 0, 2, 0, 0, 0, 'h', 'i' };
+    TEST_ASSERT_EQUAL(sizeof(expected) + 2 + 10, g_bulk_tx_len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, g_bulk_tx, sizeof(expected));
+    uint16_t const crc = CRC16_update(CRC16_INIT, &expected[1], 9);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t)crc, g_bulk_tx[10]);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t)(crc >> 8), g_bulk_tx[11]);
+    TEST_ASSERT_EQUAL_HEX8(3, g_bulk_tx[14]);
+}
+
+void test_binary_dmm_read(void)
+{
+    // Arrange
+    setup_binary_protocol();
+    USB_task_Expect(g_mock_usb_handle);
+    scpi_inject_usb_command("SYST:COMM:BIN ON\n");
+    uint8_t const channel = 2;
+    inject_binary_request(0x01, 9, &channel, 1);
+
+    DMM_Handle *dmm = (DMM_Handle *)0x11111111;
+    FIXED_Q1616 voltage = FIXED_from_int(3);
+    DMM_init_ExpectAnyArgsAndReturn(dmm);
+    SYSTEM_get_tick_IgnoreAndReturn(0);
+    DMM_try_read_voltage_ExpectAndReturn(dmm, NULL, NULL, ERROR_NONE);
+    DMM_try_read_voltage_IgnoreArg_voltage_out(); DMM_try_read_voltage_IgnoreArg_ready();
+    DMM_try_read_voltage_ReturnThruPtr_voltage_out(&voltage);
+    DMM_try_read_voltage_ReturnThruPtr_ready(&g_dmm_ready);
+    DMM_deinit_Expect(dmm);
+
+    // Act
+    protocol_task();
+
+    // Assert - Status ERROR_NONE and 3.0 V in Q16.16
+    uint8_t const expected[] = { 0xB5, 0x81, 9, 0, 4, 0, 0, 0, 0, 0, 3, 0 };
+    TEST_ASSERT_EQUAL(sizeof(expected) + 2, g_bulk_tx_len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, g_bulk_tx, sizeof(expected));
+}
+
+/**
+ * @brief Queue 32-bit little-endian words on the bulk interface
+ */
+static void inject_bulk_words(uint32_t const *words, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t byte = 0; byte < 4; ++byte) {
+            g_bulk_rx[g_bulk_rx_len++] = (uint8_t)(words[i] >> (8 * byte));
+        }
+    }
+}
+
+void test_scpi_system_test_usb_prbs_with_sink(void)
+{
+    // Arrange - Room for 8 words on each pass
+    setup_bulk_interface(32);
+    SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
+    USB_task_Expect(g_mock_usb_handle);
+    scpi_inject_usb_command("SYST:TEST:USB PRBS,1,ON\n");
+
+    // Act - Start, then sink the first two words and the fourth
+    protocol_task();
+    uint32_t const host[] = { 0x00042021, 0x04080601, 0x1255994F };
+    inject_bulk_words(host, 3);
+    USB_task_Expect(g_mock_usb_handle);
+    USB_task_Expect(g_mock_usb_bulk_handle);
+    protocol_task();
+
+    // Assert - The xorshift32 sequence, one pass after the other
+    TEST_ASSERT_EQUAL(64, g_bulk_tx_len);
+    uint8_t const expected[] = { 0x21, 0x20, 0x04, 0x00, 0x01, 0x06, 0x08, 0x04 };
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, g_bulk_tx, sizeof(expected));
+    TEST_ASSERT_EQUAL_HEX8(0xC5, g_bulk_tx[8]);
+    TEST_ASSERT_EQUAL_HEX8(0x9D, g_bulk_tx[11]);
+
+    // Act - The results of the second the test ran, then once it is over
+    advance_system_time(1000);
+    scpi_clear_captured_response();
+    USB_task_Expect(g_mock_usb_handle);
+    USB_task_Expect(g_mock_usb_bulk_handle);
+    scpi_inject_usb_command("SYST:TEST:USB?\n");
+    protocol_task();
+    USB_task_Expect(g_mock_usb_handle);
+    USB_task_Expect(g_mock_usb_bulk_handle);
+    scpi_inject_usb_command("SYST:TEST:USB?\n");
+    protocol_task();
+
+    // Assert - 64 bytes sent, 12 received with the missing word one error
+    TEST_ASSERT_EQUAL_STRING(
+        "1,1000,64,64,12,12,1\r\n0,1000,64,64,12,12,1\r\n",
+        scpi_get_captured_response()
+    );
+    TEST_ASSERT_EQUAL(64, g_bulk_tx_len);
+}
+
+void test_scpi_system_test_usb_refused_with_binary_protocol(void)
+{
+    // Arrange
+    setup_binary_protocol();
+    USB_task_Expect(g_mock_usb_handle);
+    scpi_inject_usb_command("SYST:COMM:BIN ON;:SYST:TEST:USB COUN,1;:SYST:ERR?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_NOT_NULL(strstr(scpi_get_captured_response(), "-200,"));
+    TEST_ASSERT_EQUAL(0, g_bulk_tx_len);
+}
+
+// ============================================================================
+// USB Communication and Error Handling Tests
+// ============================================================================
+
+void test_usb_command_burst_single_flush(void)
+{
+    // Arrange
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    protocol_init();
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+    USB_flush_Expect(g_mock_usb_handle);
+
+    // A burst longer than one USB packet, several lines and queries
+    for (int i = 0; i < 10; i++) {
+        scpi_inject_usb_command("*OPC?;*OPC?\n");
+    }
+
+    // Act
+    protocol_task();
+
+    // Assert - All answered in one pass, flushed once
+    char expected[100] = "";
+    for (int i = 0; i < 10; i++) {
+        strcat(expected, "1;1\r\n");
+    }
+    TEST_ASSERT_EQUAL_STRING(expected, scpi_get_captured_response());
+}
 
 void test_usb_data_fragmentation(void)
 {
@@ -402,6 +1452,8 @@ void test_usb_data_fragmentation(void)
     USB_init_IgnoreArg_rx_buffer();
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
     protocol_init();
 
     USB_task_Expect(g_mock_usb_handle);
@@ -441,6 +1493,8 @@ void test_invalid_scpi_command(void)
     USB_init_IgnoreArg_rx_buffer();
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
     protocol_init();
 
     USB_task_Expect(g_mock_usb_handle);
@@ -476,6 +1530,8 @@ void test_multiple_commands_in_sequence(void)
     USB_init_IgnoreArg_rx_buffer();
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
     protocol_init();
 
     // Process multiple commands in sequence
@@ -509,6 +1565,8 @@ void test_protocol_state_reset(void)
     USB_init_IgnoreArg_rx_buffer();
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
     protocol_init();
 
     // Reset and expect proper cleanup
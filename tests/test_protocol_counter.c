@@ -0,0 +1,192 @@
+/**
+ * @file test_protocol_counter.c
+ * @brief Unit tests for the frequency counter SCPI commands
+ *
+ * The counter is mocked; its measurement completes on a later pass of the
+ * protocol task, which then answers the deferred query.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_usb.h"
+#include "mock_counter.h"
+#include "mock_system.h"
+#include "mock_profile.h"
+#include "scpi_test_helpers.h"
+
+#include "util/error.h"
+
+#include "application/protocol.h"
+
+// Define global variables required by scpi_test_helpers
+char g_scpi_test_captured_response[SCPI_TEST_RESPONSE_BUFFER_SIZE];
+size_t g_scpi_test_captured_response_len;
+char g_scpi_test_injected_data[SCPI_TEST_USB_BUFFER_SIZE];
+size_t g_scpi_test_injected_data_len;
+
+static USB_Handle *g_mock_usb_handle;
+static COUNTER_Handle *g_mock_counter_handle;
+static COUNTER_Config g_counter_config;
+static bool g_measurement_done;
+static uint32_t g_tick;
+
+static COUNTER_Handle *
+counter_init_stub(COUNTER_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    g_counter_config = *config;
+    return g_mock_counter_handle;
+}
+
+/**
+ * @brief A 1 kHz measurement, read once g_measurement_done is set
+ */
+static bool counter_read_stub(
+    COUNTER_Handle *handle,
+    COUNTER_Result *result,
+    int cmock_num_calls
+)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    if (!g_measurement_done) {
+        return false;
+    }
+    *result = (COUNTER_Result){
+        .frequency = 1000000000ULL,
+        .period = 1000000000ULL,
+        .edges = 100,
+        .ticks = 25000000,
+        .clock = 250000000,
+    };
+    return true;
+}
+
+static uint32_t system_get_tick_stub(int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    return g_tick;
+}
+
+void setUp(void)
+{
+    g_mock_usb_handle = (USB_Handle *)0x12345678; // Mock handle
+    g_mock_counter_handle = (COUNTER_Handle *)0x13579BDF; // Mock handle
+    memset(&g_counter_config, 0, sizeof(g_counter_config));
+    g_measurement_done = true;
+    g_tick = 0;
+    g_scpi_test_injected_data_len = 0;
+
+    scpi_clear_captured_response();
+    memset(g_scpi_test_injected_data, 0, sizeof(g_scpi_test_injected_data));
+
+    mock_usb_Init();
+    mock_counter_Init();
+    mock_system_Init();
+
+    // Responses mark the end of the boot sequence
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
+
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    COUNTER_init_Stub(counter_init_stub);
+    COUNTER_read_Stub(counter_read_stub);
+    SYSTEM_get_tick_Stub(system_get_tick_stub);
+}
+
+void tearDown(void)
+{
+    if (protocol_is_initialized()) {
+        USB_deinit_Ignore();
+        COUNTER_deinit_Ignore();
+        protocol_deinit();
+    }
+
+    mock_usb_Destroy();
+    mock_counter_Destroy();
+    mock_system_Destroy();
+}
+
+// Test: The frequency is answered in microhertz once the gate has passed
+void test_scpi_frequency_measure(void)
+{
+    g_measurement_done = false;
+    COUNTER_start_Expect(g_mock_counter_handle);
+    scpi_inject_usb_command("FREQ:MEAS?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_UINT32(100, g_counter_config.gate_time);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+
+    // The measurement is done by the next pass
+    g_measurement_done = true;
+    COUNTER_deinit_Expect(g_mock_counter_handle);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("1000000000\r\n", scpi_get_captured_response());
+}
+
+// Test: The period is answered in picoseconds, over the gate time set
+void test_scpi_frequency_period_with_gate(void)
+{
+    COUNTER_start_Expect(g_mock_counter_handle);
+    COUNTER_deinit_Expect(g_mock_counter_handle);
+    scpi_inject_usb_command("FREQ:GATE 1000\n");
+    scpi_inject_usb_command("FREQ:GATE?\n");
+    scpi_inject_usb_command("FREQ:PER?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_UINT32(1000, g_counter_config.gate_time);
+    TEST_ASSERT_EQUAL_STRING(
+        "1000\r\n1000000000\r\n", scpi_get_captured_response()
+    );
+}
+
+// Test: Gates out of range are refused and keep the previous one
+void test_scpi_frequency_gate_invalid(void)
+{
+    scpi_inject_usb_command("FREQ:GATE 0\n");
+    scpi_inject_usb_command("FREQ:GATE 10001\n");
+    scpi_inject_usb_command("FREQ:GATE?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_STRING("100\r\n", scpi_get_captured_response());
+
+    scpi_clear_captured_response();
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// Test: A measurement that never completes times out with an error
+void test_scpi_frequency_measure_timeout(void)
+{
+    g_measurement_done = false;
+    COUNTER_start_Expect(g_mock_counter_handle);
+    scpi_inject_usb_command("FREQ:MEAS?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Past two gate times and the margin
+    g_tick = 1201;
+    COUNTER_deinit_Expect(g_mock_counter_handle);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
@@ -0,0 +1,213 @@
+/**
+ * @file test_protocol_datalog.c
+ * @brief Unit tests for the data logger SCPI commands
+ *
+ * The logger is mocked; its status is set by the tests, and a read is
+ * completed by filling the buffer it was given and setting its status.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_usb.h"
+#include "mock_datalog.h"
+#include "mock_system.h"
+#include "mock_profile.h"
+#include "scpi_test_helpers.h"
+
+#include "util/error.h"
+
+#include "application/protocol.h"
+
+// Define global variables required by scpi_test_helpers
+char g_scpi_test_captured_response[SCPI_TEST_RESPONSE_BUFFER_SIZE];
+size_t g_scpi_test_captured_response_len;
+char g_scpi_test_injected_data[SCPI_TEST_USB_BUFFER_SIZE];
+size_t g_scpi_test_injected_data_len;
+
+static USB_Handle *g_mock_usb_handle;
+static DATALOG_Status g_status; // Status the logger reports
+static DATALOG_Config g_started; // Settings of the last start
+static uint8_t *g_read_data; // Buffer of the last read
+static SPI_Status g_read_status;
+
+static void get_status_stub(DATALOG_Status *status, int n)
+{
+    (void)n;
+    *status = g_status;
+}
+
+static void start_stub(DATALOG_Config const *config, int n)
+{
+    (void)n;
+    g_started = *config;
+    g_status.state = DATALOG_STATE_RUNNING;
+}
+
+static void start_not_ready_stub(DATALOG_Config const *config, int n)
+{
+    (void)config;
+    (void)n;
+    THROW(ERROR_DEVICE_NOT_READY);
+}
+
+static void read_stub(uint32_t address, uint8_t *data, uint32_t size, int n)
+{
+    (void)n;
+    // Bytes that tell where they were read from
+    g_read_data = data;
+    for (uint32_t i = 0; i < size; i++) {
+        g_read_data[i] = (uint8_t)(address + i);
+    }
+    g_read_status = SPI_STATUS_PENDING;
+}
+
+static SPI_Status read_status_stub(int n)
+{
+    (void)n;
+    return g_read_status;
+}
+
+void setUp(void)
+{
+    g_mock_usb_handle = (USB_Handle *)0x12345678; // Mock handle
+    g_status = (DATALOG_Status){
+        .state = DATALOG_STATE_READY,
+        .capacity = 1 << 20,
+        .session = 3,
+    };
+    memset(&g_started, 0, sizeof(g_started));
+    g_read_data = NULL;
+    g_read_status = SPI_STATUS_OK;
+    g_scpi_test_injected_data_len = 0;
+
+    scpi_clear_captured_response();
+    memset(g_scpi_test_injected_data, 0, sizeof(g_scpi_test_injected_data));
+
+    mock_usb_Init();
+    mock_datalog_Init();
+    mock_system_Init();
+
+    // Responses mark the end of the boot sequence
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
+
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    DATALOG_get_status_Stub(get_status_stub);
+    DATALOG_start_Stub(start_stub);
+    DATALOG_read_Stub(read_stub);
+    DATALOG_read_status_Stub(read_status_stub);
+    DATALOG_stop_Ignore();
+    DATALOG_deinit_Ignore();
+    SYSTEM_get_tick_IgnoreAndReturn(0);
+}
+
+void tearDown(void)
+{
+    if (protocol_is_initialized()) {
+        USB_deinit_Ignore();
+        protocol_deinit();
+    }
+
+    mock_usb_Destroy();
+    mock_datalog_Destroy();
+    mock_system_Destroy();
+}
+
+// Test: The first command takes the logger, and the status is answered
+void test_scpi_log_status(void)
+{
+    DATALOG_init_Expect();
+    scpi_inject_usb_command("LOG:STAT?;CAP?;SESS?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING(
+        "READY;1048576;3\r\n", scpi_get_captured_response()
+    );
+
+    // Only once
+    scpi_clear_captured_response();
+    g_status.records = 12;
+    g_status.dropped = 1;
+    scpi_inject_usb_command("LOG:COUN?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("12,1\r\n", scpi_get_captured_response());
+}
+
+// Test: A start records the channels and interval set before it
+void test_scpi_log_start(void)
+{
+    DATALOG_init_Expect();
+    scpi_inject_usb_command("LOG:CHAN 2,0,5\n");
+    scpi_inject_usb_command("LOG:INT 250\n");
+    scpi_inject_usb_command("LOG:STAR\n");
+    scpi_inject_usb_command("LOG:STAT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_STRING("RUN\r\n", scpi_get_captured_response());
+    TEST_ASSERT_EQUAL_UINT32(250, g_started.interval);
+    TEST_ASSERT_EQUAL_UINT32(3, g_started.dmm.scan_count);
+    TEST_ASSERT_EQUAL(2, g_started.dmm.scan_channels[0]);
+    TEST_ASSERT_EQUAL(0, g_started.dmm.scan_channels[1]);
+    TEST_ASSERT_EQUAL(5, g_started.dmm.scan_channels[2]);
+}
+
+// Test: Intervals below the minimum are refused
+void test_scpi_log_interval_invalid(void)
+{
+    scpi_inject_usb_command("LOG:INT 5\n");
+    scpi_inject_usb_command("LOG:INT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("1000\r\n", scpi_get_captured_response());
+}
+
+// Test: A start the logger refuses is an execution error
+void test_scpi_log_start_refused(void)
+{
+    DATALOG_init_Expect();
+    DATALOG_start_Stub(start_not_ready_stub);
+    scpi_inject_usb_command("LOG:STAR\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// Test: A read of the log is answered as a block once it completes
+void test_scpi_log_data(void)
+{
+    DATALOG_init_Expect();
+    scpi_inject_usb_command("LOG:DATA? 256,4\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_NOT_NULL(g_read_data);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+
+    g_read_status = SPI_STATUS_OK;
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL(8, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(
+        "#14\x00\x01\x02\x03\r\n", scpi_get_captured_response(), 8
+    );
+}
+
+// Test: Reads larger than a query's share are refused before the flash is
+// touched
+void test_scpi_log_data_too_large(void)
+{
+    scpi_inject_usb_command("LOG:DATA? 0,4097\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_NULL(g_read_data);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
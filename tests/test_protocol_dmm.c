@@ -24,6 +24,8 @@
 #include "mock_dmm.h"
 #include "mock_dso.h"
 #include "mock_system.h"
+#include "mock_profile.h"
+#include "mock_calibration.h"
 #include "scpi_test_helpers.h"
 
 #include "util/error.h"
@@ -44,6 +46,7 @@ static DMM_Handle *g_mock_dmm_handle;
 static CircularBuffer g_mock_usb_rx_buffer;
 static uint8_t g_mock_usb_rx_data[SCPI_TEST_USB_BUFFER_SIZE];
 static uint32_t g_mock_system_tick;
+static bool g_dmm_ready = true; // Reported by the reads that succeed
 
 void setUp(void)
 {
@@ -65,6 +68,13 @@ void setUp(void)
     mock_usb_Init();
     mock_dmm_Init();
     mock_system_Init();
+    mock_calibration_Init();
+
+    // Responses mark the end of the boot sequence
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
 }
 
 void tearDown(void)
@@ -81,6 +91,7 @@ void tearDown(void)
     mock_usb_Destroy();
     mock_dmm_Destroy();
     mock_system_Destroy();
+    mock_calibration_Destroy();
 }
 
 // ============================================================================
@@ -173,6 +184,8 @@ static void setup_protocol_for_dmm_test(void)
     USB_init_IgnoreArg_rx_buffer();
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
     protocol_init();
 
     USB_task_Expect(g_mock_usb_handle);
@@ -333,9 +346,10 @@ void test_scpi_fetch_voltage_dc_with_cached_value(void)
 
     // Mock reading from active DMM handle
     SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
-    DMM_read_voltage_ExpectAndReturn(NULL, NULL, true); DMM_read_voltage_IgnoreArg_handle(); DMM_read_voltage_IgnoreArg_voltage_out();
+    DMM_try_read_voltage_ExpectAndReturn(NULL, NULL, NULL, ERROR_NONE); DMM_try_read_voltage_IgnoreArg_handle(); DMM_try_read_voltage_IgnoreArg_voltage_out(); DMM_try_read_voltage_IgnoreArg_ready();
     FIXED_Q1616 voltage_out = FIXED_FROM_FLOAT(1.65f);
-    DMM_read_voltage_ReturnThruPtr_voltage_out(&voltage_out);
+    DMM_try_read_voltage_ReturnThruPtr_voltage_out(&voltage_out);
+    DMM_try_read_voltage_ReturnThruPtr_ready(&g_dmm_ready);
     DMM_deinit_Expect(NULL); DMM_deinit_IgnoreArg_handle();
 
     scpi_inject_usb_command("DMM:FETC:VOLT:DC?\n");
@@ -387,9 +401,10 @@ void test_scpi_read_voltage_dc_complete_flow(void)
 
     // Expect FETCH sequence
     SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
-    DMM_read_voltage_ExpectAndReturn(NULL, NULL, true); DMM_read_voltage_IgnoreArg_handle(); DMM_read_voltage_IgnoreArg_voltage_out();
+    DMM_try_read_voltage_ExpectAndReturn(NULL, NULL, NULL, ERROR_NONE); DMM_try_read_voltage_IgnoreArg_handle(); DMM_try_read_voltage_IgnoreArg_voltage_out(); DMM_try_read_voltage_IgnoreArg_ready();
     FIXED_Q1616 voltage_out = FIXED_FROM_FLOAT(2.75f);
-    DMM_read_voltage_ReturnThruPtr_voltage_out(&voltage_out);
+    DMM_try_read_voltage_ReturnThruPtr_voltage_out(&voltage_out);
+    DMM_try_read_voltage_ReturnThruPtr_ready(&g_dmm_ready);
     DMM_deinit_Expect(NULL); DMM_deinit_IgnoreArg_handle();
 
     scpi_inject_usb_command("DMM:READ:VOLT:DC?\n");
@@ -416,9 +431,10 @@ void test_scpi_measure_voltage_dc_complete_flow(void)
     DMM_deinit_Expect(NULL); DMM_deinit_IgnoreArg_handle();
     DMM_init_ExpectAndReturn(NULL, g_mock_dmm_handle); DMM_init_IgnoreArg_config();
     SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
-    DMM_read_voltage_ExpectAndReturn(NULL, NULL, true); DMM_read_voltage_IgnoreArg_handle(); DMM_read_voltage_IgnoreArg_voltage_out();
+    DMM_try_read_voltage_ExpectAndReturn(NULL, NULL, NULL, ERROR_NONE); DMM_try_read_voltage_IgnoreArg_handle(); DMM_try_read_voltage_IgnoreArg_voltage_out(); DMM_try_read_voltage_IgnoreArg_ready();
     FIXED_Q1616 voltage_out = FIXED_FROM_FLOAT(0.85f);
-    DMM_read_voltage_ReturnThruPtr_voltage_out(&voltage_out);
+    DMM_try_read_voltage_ReturnThruPtr_voltage_out(&voltage_out);
+    DMM_try_read_voltage_ReturnThruPtr_ready(&g_dmm_ready);
     DMM_deinit_Expect(NULL); DMM_deinit_IgnoreArg_handle();
 
     scpi_inject_usb_command("DMM:MEAS:VOLT:DC?\n");
@@ -446,8 +462,8 @@ void test_dmm_read_timeout_handling(void)
     // Time will advance by 200ms on each call, causing timeout after ~6 calls
     SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_advancing);
 
-    // DMM_read_voltage should return false (not ready) for all calls during timeout
-    DMM_read_voltage_IgnoreAndReturn(false);
+    // DMM_try_read_voltage should report no reading for all calls during timeout
+    DMM_try_read_voltage_IgnoreAndReturn(ERROR_NONE);
 
     scpi_inject_usb_command("DMM:READ:VOLT:DC?\n");
 
@@ -528,10 +544,11 @@ void test_dmm_multiple_measurements_same_channel(void)
     DMM_deinit_Expect(NULL); DMM_deinit_IgnoreArg_handle();
     DMM_init_ExpectAndReturn(NULL, g_mock_dmm_handle); DMM_init_IgnoreArg_config();
     SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
-    DMM_read_voltage_ExpectAndReturn(NULL, NULL, true);
-    DMM_read_voltage_IgnoreArg_handle(); DMM_read_voltage_IgnoreArg_voltage_out();
+    DMM_try_read_voltage_ExpectAndReturn(NULL, NULL, NULL, ERROR_NONE);
+    DMM_try_read_voltage_IgnoreArg_handle(); DMM_try_read_voltage_IgnoreArg_voltage_out(); DMM_try_read_voltage_IgnoreArg_ready();
     FIXED_Q1616 voltage_out1 = FIXED_FROM_FLOAT(1.23f);
-    DMM_read_voltage_ReturnThruPtr_voltage_out(&voltage_out1);
+    DMM_try_read_voltage_ReturnThruPtr_voltage_out(&voltage_out1);
+    DMM_try_read_voltage_ReturnThruPtr_ready(&g_dmm_ready);
     DMM_deinit_Expect(NULL); DMM_deinit_IgnoreArg_handle();
 
     scpi_inject_usb_command("DMM:READ:VOLT:DC?\n");
@@ -550,10 +567,11 @@ void test_dmm_multiple_measurements_same_channel(void)
     DMM_deinit_Expect(NULL); DMM_deinit_IgnoreArg_handle();
     DMM_init_ExpectAndReturn(NULL, g_mock_dmm_handle); DMM_init_IgnoreArg_config();
     SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
-    DMM_read_voltage_ExpectAndReturn(NULL, NULL, true);
-    DMM_read_voltage_IgnoreArg_handle(); DMM_read_voltage_IgnoreArg_voltage_out();
+    DMM_try_read_voltage_ExpectAndReturn(NULL, NULL, NULL, ERROR_NONE);
+    DMM_try_read_voltage_IgnoreArg_handle(); DMM_try_read_voltage_IgnoreArg_voltage_out(); DMM_try_read_voltage_IgnoreArg_ready();
     FIXED_Q1616 voltage_out2 = FIXED_FROM_FLOAT(3.45f);
-    DMM_read_voltage_ReturnThruPtr_voltage_out(&voltage_out2);
+    DMM_try_read_voltage_ReturnThruPtr_voltage_out(&voltage_out2);
+    DMM_try_read_voltage_ReturnThruPtr_ready(&g_dmm_ready);
     DMM_deinit_Expect(NULL); DMM_deinit_IgnoreArg_handle();
 
     scpi_inject_usb_command("DMM:READ:VOLT:DC?\n");
@@ -563,4 +581,818 @@ void test_dmm_multiple_measurements_same_channel(void)
 
     // Assert
     TEST_ASSERT_TRUE(strstr(scpi_get_captured_response(), "3449") != NULL);
-}
\ No newline at end of file
+}
+// ============================================================================
+// Scan Tests
+// ============================================================================
+
+static DMM_Config g_captured_scan_config;
+
+static DMM_Handle *mock_dmm_init_capture(DMM_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    g_captured_scan_config = *config;
+    return g_mock_dmm_handle;
+}
+
+static uint32_t mock_dmm_read_scan(DMM_Handle *handle, FIXED_Q1616 *voltages_out, uint32_t max_count, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    TEST_ASSERT_EQUAL_UINT32(3, max_count);
+    voltages_out[0] = FIXED_FROM_FLOAT(0.5f);
+    voltages_out[1] = FIXED_FROM_FLOAT(1.0f);
+    voltages_out[2] = FIXED_FROM_FLOAT(3.0f);
+    return 3;
+}
+
+void test_scpi_scan_voltage_dc_returns_all_channels(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+
+    DMM_init_StubWithCallback(mock_dmm_init_capture);
+    SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
+    DMM_read_scan_StubWithCallback(mock_dmm_read_scan);
+    DMM_deinit_Expect(g_mock_dmm_handle);
+
+    scpi_inject_usb_command("DMM:SCAN? 4,0,9\n");
+
+    // Act
+    protocol_task();
+
+    // Assert - a single init converts the whole list in order
+    TEST_ASSERT_EQUAL_UINT32(3, g_captured_scan_config.scan_count);
+    TEST_ASSERT_EQUAL(DMM_CHANNEL_4, g_captured_scan_config.scan_channels[0]);
+    TEST_ASSERT_EQUAL(DMM_CHANNEL_0, g_captured_scan_config.scan_channels[1]);
+    TEST_ASSERT_EQUAL(DMM_CHANNEL_9, g_captured_scan_config.scan_channels[2]);
+    TEST_ASSERT_EQUAL_STRING("500,1000,3000\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_scan_voltage_dc_requires_channels(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+
+    scpi_inject_usb_command("DMM:SCAN?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert - nothing was initialized and an error is queued
+    scpi_clear_captured_response();
+    scpi_inject_usb_command("SYST:ERR?\n");
+
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+
+    protocol_task();
+
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+static bool mock_dmm_read_differential(DMM_Handle *handle, DMM_Differential *reading_out, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    reading_out->difference = FIXED_FROM_FLOAT(-0.25f);
+    reading_out->positive = FIXED_FROM_FLOAT(1.0f);
+    reading_out->negative = FIXED_FROM_FLOAT(1.25f);
+    return true;
+}
+
+void test_scpi_differential_voltage_dc_returns_difference_and_legs(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+
+    DMM_init_StubWithCallback(mock_dmm_init_capture);
+    SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
+    DMM_read_differential_StubWithCallback(mock_dmm_read_differential);
+    DMM_deinit_Expect(g_mock_dmm_handle);
+
+    scpi_inject_usb_command("DMM:DIFF? 3,6\n");
+
+    // Act
+    protocol_task();
+
+    // Assert - one init samples both channels together
+    TEST_ASSERT_TRUE(g_captured_scan_config.differential);
+    TEST_ASSERT_EQUAL(DMM_CHANNEL_3, g_captured_scan_config.channel);
+    TEST_ASSERT_EQUAL(DMM_CHANNEL_6, g_captured_scan_config.negative_channel);
+    TEST_ASSERT_EQUAL_UINT32(0, g_captured_scan_config.scan_count);
+    TEST_ASSERT_EQUAL_STRING("-250,1000,1250\r\n", scpi_get_captured_response());
+}
+
+// ============================================================================
+// Averaging Tests
+// ============================================================================
+
+/**
+ * @brief Helper to re-arm the USB mocks before the next protocol_task
+ */
+static void prepare_next_command(void)
+{
+    scpi_clear_captured_response();
+    USB_task_Expect(g_mock_usb_handle);
+    USB_rx_ready_StubWithCallback(mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_capture);
+}
+
+static bool mock_dmm_read_statistics(DMM_Handle *handle, DMM_Statistics *statistics_out, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    statistics_out->mean = FIXED_FROM_FLOAT(1.0f);
+    statistics_out->rms = FIXED_FROM_FLOAT(1.5f);
+    statistics_out->min = FIXED_FROM_FLOAT(0.25f);
+    statistics_out->max = FIXED_FROM_FLOAT(2.0f);
+    statistics_out->samples = 64;
+    return true;
+}
+
+/**
+ * @brief Helper to configure a 64-sample window and start averaging
+ */
+static void start_averaging(void)
+{
+    DMM_init_StubWithCallback(mock_dmm_init_capture);
+    DMM_deinit_Expect(g_mock_dmm_handle);
+    scpi_inject_usb_command("DMM:CONF:AVER 64\n");
+    protocol_task();
+    TEST_ASSERT_EQUAL_UINT32(64, g_captured_scan_config.average_window);
+
+    prepare_next_command();
+    scpi_inject_usb_command("DMM:INIT\n");
+    protocol_task();
+    TEST_ASSERT_EQUAL_UINT32(64, g_captured_scan_config.average_window);
+}
+
+void test_scpi_configure_average_query(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    DMM_init_StubWithCallback(mock_dmm_init_capture);
+    DMM_deinit_Expect(g_mock_dmm_handle);
+    scpi_inject_usb_command("DMM:CONF:AVER 128\n");
+    protocol_task();
+
+    // Act
+    prepare_next_command();
+    scpi_inject_usb_command("DMM:CONF:AVER?\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("128\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_configure_average_invalid_window(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    DMM_init_ExpectAndThrow(NULL, ERROR_INVALID_ARGUMENT);
+    DMM_init_IgnoreArg_config();
+    scpi_inject_usb_command("DMM:CONF:AVER 6\n");
+    protocol_task();
+
+    // Act - the rejected window is not stored
+    prepare_next_command();
+    scpi_inject_usb_command("DMM:CONF:AVER?\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("0\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_configure_nplc_replaces_average(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    DMM_init_StubWithCallback(mock_dmm_init_capture);
+    DMM_deinit_Expect(g_mock_dmm_handle);
+    scpi_inject_usb_command("DMM:CONF:AVER 64\n");
+    protocol_task();
+
+    // Act
+    prepare_next_command();
+    DMM_deinit_Expect(g_mock_dmm_handle);
+    scpi_inject_usb_command("DMM:CONF:LFR 60\n");
+    protocol_task();
+    prepare_next_command();
+    DMM_deinit_Expect(g_mock_dmm_handle);
+    scpi_inject_usb_command("DMM:CONF:NPLC 10\n");
+    protocol_task();
+
+    // Assert - the DMM picks the window for the aperture
+    TEST_ASSERT_EQUAL_UINT32(10, g_captured_scan_config.nplc);
+    TEST_ASSERT_EQUAL_UINT32(60, g_captured_scan_config.line_frequency);
+    TEST_ASSERT_EQUAL_UINT32(0, g_captured_scan_config.average_window);
+
+    prepare_next_command();
+    scpi_inject_usb_command("DMM:CONF:NPLC?;AVER?;LFR?\n");
+    protocol_task();
+    TEST_ASSERT_EQUAL_STRING("10;0;60\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_configure_line_frequency_invalid(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+
+    // Act - rejected before any DMM_init
+    scpi_inject_usb_command("DMM:CONF:LFR 55\n");
+    protocol_task();
+
+    // Assert
+    prepare_next_command();
+    scpi_inject_usb_command("DMM:CONF:LFR?\n");
+    protocol_task();
+    TEST_ASSERT_EQUAL_STRING("50\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_fetch_averaging_keeps_measurement(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    start_averaging();
+
+    // Act - no DMM_deinit expected, conversions continue
+    prepare_next_command();
+    SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
+    FIXED_Q1616 voltage_out = FIXED_FROM_FLOAT(1.5f);
+    DMM_try_read_voltage_ExpectAndReturn(g_mock_dmm_handle, NULL, NULL, ERROR_NONE);
+    DMM_try_read_voltage_IgnoreArg_voltage_out(); DMM_try_read_voltage_IgnoreArg_ready();
+    DMM_try_read_voltage_ReturnThruPtr_voltage_out(&voltage_out);
+    DMM_try_read_voltage_ReturnThruPtr_ready(&g_dmm_ready);
+    scpi_inject_usb_command("DMM:FETC?\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("1500\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_fetch_statistics_returns_window(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    start_averaging();
+
+    // Act
+    prepare_next_command();
+    SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
+    DMM_read_statistics_StubWithCallback(mock_dmm_read_statistics);
+    scpi_inject_usb_command("DMM:FETC:STAT?\n");
+    protocol_task();
+
+    // Assert - mean, RMS, min and max in mV, then the sample count
+    TEST_ASSERT_EQUAL_STRING(
+        "1000,1500,250,2000,64\r\n", scpi_get_captured_response()
+    );
+}
+
+void test_scpi_fetch_statistics_requires_averaging(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    scpi_inject_usb_command("DMM:FETC:STAT?\n");
+    protocol_task();
+
+    // Act
+    prepare_next_command();
+    scpi_inject_usb_command("SYST:ERR?\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// ============================================================================
+// Free-Running Tests
+// ============================================================================
+
+static DMM_Config g_captured_continuous_config;
+
+static DMM_Handle *mock_dmm_init_continuous(DMM_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    g_captured_continuous_config = *config;
+    return g_mock_dmm_handle;
+}
+
+void test_scpi_initiate_continuous_starts_free_running(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    DMM_init_StubWithCallback(mock_dmm_init_continuous);
+    scpi_inject_usb_command("DMM:INIT:CONT ON\n");
+
+    // Act
+    protocol_task();
+    TEST_ASSERT_TRUE(g_captured_continuous_config.free_running);
+
+    prepare_next_command();
+    scpi_inject_usb_command("DMM:INIT:CONT?\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("1\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_read_free_running_skips_initiate(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    DMM_init_StubWithCallback(mock_dmm_init_continuous);
+    scpi_inject_usb_command("DMM:INIT:CONT ON\n");
+    protocol_task();
+
+    // Act - no DMM_init or DMM_deinit expected, only a read of the latest
+    prepare_next_command();
+    SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
+    FIXED_Q1616 voltage_out = FIXED_FROM_FLOAT(0.5f);
+    DMM_try_read_voltage_ExpectAndReturn(g_mock_dmm_handle, NULL, NULL, ERROR_NONE);
+    DMM_try_read_voltage_IgnoreArg_voltage_out(); DMM_try_read_voltage_IgnoreArg_ready();
+    DMM_try_read_voltage_ReturnThruPtr_voltage_out(&voltage_out);
+    DMM_try_read_voltage_ReturnThruPtr_ready(&g_dmm_ready);
+    scpi_inject_usb_command("DMM:READ?\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("500\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_initiate_continuous_off_stops_measurement(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    DMM_init_StubWithCallback(mock_dmm_init_continuous);
+    scpi_inject_usb_command("DMM:INIT:CONT ON\n");
+    protocol_task();
+
+    // Act
+    prepare_next_command();
+    DMM_deinit_Expect(g_mock_dmm_handle);
+    scpi_inject_usb_command("DMM:INIT:CONT OFF\n");
+    protocol_task();
+
+    prepare_next_command();
+    scpi_inject_usb_command("DMM:INIT:CONT?\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("0\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_watch_requires_continuous(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    scpi_inject_usb_command("DMM:WATC ON\n");
+    protocol_task();
+
+    // Act
+    prepare_next_command();
+    scpi_inject_usb_command("SYST:ERR?\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING(
+        "-221,\"Settings conflict\"\r\n", scpi_get_captured_response()
+    );
+}
+
+void test_scpi_watch_event_latches_crossing(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    DMM_init_StubWithCallback(mock_dmm_init_continuous);
+    scpi_inject_usb_command("DMM:INIT:CONT ON\n");
+    protocol_task();
+
+    // Act
+    prepare_next_command();
+    DMM_watch_start_Expect(
+        g_mock_dmm_handle, FIXED_FROM_INT(1), FIXED_FROM_INT(2), NULL
+    );
+    DMM_watch_start_IgnoreArg_callback();
+    scpi_inject_usb_command("DMM:WATC:LIM 1000,2000;:DMM:WATC ON\n");
+    protocol_task();
+
+    prepare_next_command();
+    DMM_watch_event_ExpectAndReturn(g_mock_dmm_handle, true);
+    scpi_inject_usb_command("DMM:WATC:EVEN?;:DMM:WATC:LIM?\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("1;1000,2000\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_count_reports_events_and_times(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    DMM_init_StubWithCallback(mock_dmm_init_continuous);
+    scpi_inject_usb_command("DMM:INIT:CONT ON\n");
+    protocol_task();
+
+    // Act
+    prepare_next_command();
+    DMM_count_start_Expect(
+        g_mock_dmm_handle, FIXED_FROM_INT(1), FIXED_FROM_FLOAT(0.5f), true
+    );
+    scpi_inject_usb_command(
+        "DMM:COUN:LEV 1000,500;:DMM:COUN:TIM ON;:DMM:COUN ON\n"
+    );
+    protocol_task();
+
+    prepare_next_command();
+    DMM_count_events_ExpectAndReturn(g_mock_dmm_handle, 7);
+    DMM_count_take_timestamps_ExpectAnyArgsAndReturn(0);
+    scpi_inject_usb_command(
+        "DMM:COUN:EVEN?;:DMM:COUN:TIM:DAT?;:DMM:COUN:LEV?\n"
+    );
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("7;0;1000,500\r\n", scpi_get_captured_response());
+}
+
+// ============================================================================
+// Calibration Tests
+// ============================================================================
+
+static CALIBRATION_Entry g_captured_calibration;
+
+static void mock_calibration_set_capture(CALIBRATION_Mode mode, uint32_t channel, CALIBRATION_Entry const *entry, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_EQUAL(CALIBRATION_MODE_DMM, mode);
+    TEST_ASSERT_EQUAL_UINT32(3, channel);
+    g_captured_calibration = *entry;
+}
+
+void test_scpi_calibration_value_sets_channel(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    CALIBRATION_set_StubWithCallback(mock_calibration_set_capture);
+
+    // Act - gain in ppm, offset in uV
+    scpi_inject_usb_command("DMM:CAL 3,1250000,-125000\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_INT32(FIXED_from_fraction(5, 4), g_captured_calibration.gain);
+    TEST_ASSERT_EQUAL_INT32(FIXED_from_fraction(-1, 8), g_captured_calibration.offset);
+}
+
+void test_scpi_calibration_value_query(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    CALIBRATION_Entry const entry = {
+        .gain = FIXED_from_fraction(5, 4),
+        .offset = FIXED_from_fraction(-1, 8),
+    };
+    CALIBRATION_get_ExpectAndReturn(CALIBRATION_MODE_DMM, 3, entry);
+
+    // Act
+    scpi_inject_usb_command("DMM:CAL? 3\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("1250000,-125000\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_calibration_value_invalid(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    CALIBRATION_set_ExpectAnyArgsAndThrow(ERROR_INVALID_ARGUMENT);
+    scpi_inject_usb_command("DMM:CAL 3,0,0\n");
+    protocol_task();
+
+    // Act
+    prepare_next_command();
+    scpi_inject_usb_command("SYST:ERR?\n");
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_calibration_store(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    CALIBRATION_save_Expect();
+
+    // Act
+    scpi_inject_usb_command("DMM:CAL:STOR\n");
+    protocol_task();
+
+    // Assert - nothing queued
+    prepare_next_command();
+    scpi_inject_usb_command("SYST:ERR:COUN?\n");
+    protocol_task();
+    TEST_ASSERT_EQUAL_STRING("0\r\n", scpi_get_captured_response());
+}
+
+// ============================================================================
+// Burst Tests
+// ============================================================================
+
+static uint32_t mock_dmm_read_burst(DMM_Handle *handle, FIXED_Q1616 *voltages_out, uint32_t offset, uint32_t max_count, int cmock_num_calls)
+{
+    (void)handle;
+    FIXED_Q1616 const burst[] = {
+        FIXED_FROM_FLOAT(0.5f), FIXED_FROM_FLOAT(1.0f), FIXED_FROM_FLOAT(3.0f)
+    };
+    uint32_t count = 0;
+
+    // Still running on the first poll
+    if (cmock_num_calls == 0) {
+        return 0;
+    }
+    while (offset + count < 3 && count < max_count) {
+        voltages_out[count] = burst[offset + count];
+        count++;
+    }
+    return count;
+}
+
+void test_scpi_read_array_voltage_dc_returns_block(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    DMM_init_StubWithCallback(mock_dmm_init_capture);
+    SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
+    DMM_read_burst_StubWithCallback(mock_dmm_read_burst);
+    char const expected[] = "#16\xF4\x01\xE8\x03\xB8\x0B\r\n";
+
+    // The burst is started, the query waits for it
+    scpi_inject_usb_command("DMM:READ:ARR? 3,500\n");
+    protocol_task();
+    TEST_ASSERT_EQUAL_UINT32(3, g_captured_scan_config.burst_samples);
+    TEST_ASSERT_EQUAL_UINT32(500, g_captured_scan_config.burst_rate);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+
+    // Act - The burst has completed by the next pass
+    prepare_next_command();
+    USB_write_buffer_StubWithCallback(scpi_mock_usb_write_buffer_capture);
+    USB_tx_buffer_pending_IgnoreAndReturn(false);
+    DMM_deinit_Expect(g_mock_dmm_handle);
+    protocol_task();
+
+    // Assert - Little-endian millivolts
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_read_array_voltage_dc_invalid_rate(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+
+    // Act
+    scpi_inject_usb_command("DMM:READ:ARR? 16,0\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    protocol_task();
+
+    // Assert - Nothing was initialized
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+static bool mock_dmm_read_burst_statistics(DMM_Handle *handle, DMM_Statistics *statistics_out, int cmock_num_calls)
+{
+    (void)handle;
+
+    // Still running on the first poll
+    if (cmock_num_calls == 0) {
+        return false;
+    }
+    statistics_out->mean = FIXED_FROM_FLOAT(1.65f);
+    statistics_out->ac_rms = FIXED_FROM_FLOAT(0.7071f);
+    statistics_out->samples = 1024;
+    return true;
+}
+
+void test_scpi_read_voltage_ac_returns_rms(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    DMM_init_StubWithCallback(mock_dmm_init_capture);
+    SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
+    DMM_read_burst_statistics_StubWithCallback(mock_dmm_read_burst_statistics);
+
+    // The default burst is started, the query waits for it
+    scpi_inject_usb_command("DMM:READ:VOLT:AC?\n");
+    protocol_task();
+    TEST_ASSERT_EQUAL_UINT32(1024, g_captured_scan_config.burst_samples);
+    TEST_ASSERT_EQUAL_UINT32(10240, g_captured_scan_config.burst_rate);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+
+    // Act - The burst has completed by the next pass
+    prepare_next_command();
+    DMM_deinit_Expect(g_mock_dmm_handle);
+    protocol_task();
+
+    // Assert - Only the RMS about the mean, in millivolts
+    TEST_ASSERT_EQUAL_STRING("707\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_configure_voltage_ac_sets_burst(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    DMM_init_StubWithCallback(mock_dmm_init_capture);
+    DMM_deinit_Expect(g_mock_dmm_handle);
+    scpi_inject_usb_command("DMM:CONF:VOLT:AC 2,20000,1000\n");
+    protocol_task();
+
+    // Act
+    prepare_next_command();
+    SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
+    DMM_read_burst_statistics_StubWithCallback(mock_dmm_read_burst_statistics);
+    scpi_inject_usb_command("DMM:READ:VOLT:AC?\n");
+    protocol_task();
+
+    // Assert - The reading uses the configured channel and burst
+    TEST_ASSERT_EQUAL(DMM_CHANNEL_2, g_captured_scan_config.channel);
+    TEST_ASSERT_EQUAL_UINT32(1000, g_captured_scan_config.burst_samples);
+    TEST_ASSERT_EQUAL_UINT32(20000, g_captured_scan_config.burst_rate);
+}
+
+void test_scpi_configure_voltage_ac_invalid_count(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+
+    // Act
+    scpi_inject_usb_command("DMM:CONF:VOLT:AC 0,10000,0\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    protocol_task();
+
+    // Assert - Nothing was initialized
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// ============================================================================
+// Data Format Tests
+// ============================================================================
+
+void test_scpi_format_q16_scan_returns_block(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+
+    DMM_init_StubWithCallback(mock_dmm_init_capture);
+    SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
+    DMM_read_scan_StubWithCallback(mock_dmm_read_scan);
+    DMM_deinit_Expect(g_mock_dmm_handle);
+    char const expected[] = "#212"
+                            "\x00\x80\x00\x00"
+                            "\x00\x00\x01\x00"
+                            "\x00\x00\x03\x00"
+                            "\r\n";
+
+    scpi_inject_usb_command("DMM:FORM Q16\n");
+    scpi_inject_usb_command("DMM:SCAN? 4,0,9\n");
+
+    // Act
+    protocol_task();
+
+    // Assert - Little-endian Q16.16 volts
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_format_query(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+
+    scpi_inject_usb_command("DMM:FORM REAL,32\n");
+    scpi_inject_usb_command("DMM:FORM?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("REAL,32\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_format_invalid_length(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+
+    scpi_inject_usb_command("DMM:FORM INT,16\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+
+    // Act
+    protocol_task();
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// ============================================================================
+// Converging Read Tests
+// ============================================================================
+
+static FIXED_Q1616 g_latest_voltage; // Published by the free-running DMM
+static uint32_t g_latest_sequence;
+
+static bool mock_dmm_read_latest(DMM_Handle *handle, FIXED_Q1616 *voltage_out, uint32_t *sequence_out, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    *voltage_out = g_latest_voltage;
+    *sequence_out = g_latest_sequence;
+    return true;
+}
+
+/**
+ * @brief Publish a new conversion and run the protocol task once more
+ */
+static void publish_latest(FIXED_Q1616 voltage)
+{
+    g_latest_voltage = voltage;
+    g_latest_sequence += 8;
+    prepare_next_command();
+    protocol_task();
+}
+
+void test_scpi_read_converge_stable_input_returns_early(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    DMM_init_StubWithCallback(mock_dmm_init_capture);
+    SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
+    DMM_read_latest_StubWithCallback(mock_dmm_read_latest);
+    DMM_deinit_Ignore();
+    g_latest_voltage = FIXED_FROM_FLOAT(1.0f);
+    g_latest_sequence = 8;
+
+    // Act - One new conversion per pass, all the same
+    scpi_inject_usb_command("DMM:READ:CONV? 10\n");
+    protocol_task();
+    for (int i = 0; i < 3; ++i) {
+        TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+        publish_latest(FIXED_FROM_FLOAT(1.0f));
+    }
+
+    // Assert - Converged as soon as the spread is trusted
+    TEST_ASSERT_TRUE(g_captured_scan_config.free_running);
+    TEST_ASSERT_EQUAL_UINT32(0, g_captured_scan_config.average_window);
+    TEST_ASSERT_EQUAL_STRING("1000,4,0\r\n", scpi_get_captured_response());
+
+    // FETCh repeats the mean
+    prepare_next_command();
+    scpi_inject_usb_command("DMM:FETC?\n");
+    protocol_task();
+    TEST_ASSERT_EQUAL_STRING("1000\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_read_converge_noisy_input_times_out(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+    DMM_init_StubWithCallback(mock_dmm_init_capture);
+    SYSTEM_get_tick_StubWithCallback(mock_system_get_tick_impl);
+    DMM_read_latest_StubWithCallback(mock_dmm_read_latest);
+    DMM_deinit_Ignore();
+    g_latest_voltage = FIXED_FROM_FLOAT(1.0f);
+    g_latest_sequence = 8;
+
+    // Act - Repeated conversions count once; the timeout ends the reading
+    scpi_inject_usb_command("DMM:READ:CONV? 1000,200\n");
+    protocol_task();
+    prepare_next_command();
+    protocol_task();
+    publish_latest(FIXED_FROM_FLOAT(1.125f));
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+    advance_system_time(201);
+    publish_latest(FIXED_FROM_FLOAT(1.0f));
+
+    // Assert - Mean, readings and standard error in µV
+    TEST_ASSERT_EQUAL_STRING("1041,3,41667\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_read_converge_invalid_resolution(void)
+{
+    // Arrange
+    setup_protocol_for_dmm_test();
+
+    // Act
+    scpi_inject_usb_command("DMM:READ:CONV? 0\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    protocol_task();
+
+    // Assert - Nothing was initialized
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
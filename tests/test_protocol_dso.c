@@ -21,12 +21,15 @@
 #include <stdio.h>
 
 #include "unity.h"
+#include "mock_checksum.h"
 #include "mock_usb.h"
 #include "mock_dmm.h"
 #include "mock_dso.h"
 #include "mock_system.h"
+#include "mock_profile.h"
 #include "scpi_test_helpers.h"
 
+#include "util/crc.h"
 #include "util/error.h"
 #include "util/fixed_point.h"
 #include "util/util.h"
@@ -71,6 +74,12 @@ void setUp(void)
     mock_usb_Init();
     mock_dso_Init();
     mock_system_Init();
+
+    // Responses mark the end of the boot sequence
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
 }
 
 void tearDown(void)
@@ -135,15 +144,66 @@ static void simulate_dso_acquisition_completion(void)
     dso_complete_callback();
 }
 
+/**
+ * @brief Run the protocol task until a deferred query has been answered
+ */
+static void run_protocol_until_response(void)
+{
+    for (int i = 0; i < 10 && g_scpi_test_captured_response_len == 0; ++i) {
+        scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    }
+}
+
 /**
  * @brief Helper to initialize protocol for DSO tests
  */
+/**
+ * @brief Mock CHECKSUM_start computing the CRC-32 at once
+ */
+static void mock_checksum_start_impl(
+    CHECKSUM_Job *job,
+    CHECKSUM_Kind kind,
+    uint32_t crc,
+    void const *data,
+    uint32_t size,
+    int cmock_num_calls
+)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_EQUAL(CHECKSUM_CRC32, kind);
+    job->offloaded = false;
+    job->crc = CRC32_update(crc, data, size);
+}
+
+static bool mock_checksum_result_impl(
+    CHECKSUM_Job *job,
+    uint32_t *crc,
+    int cmock_num_calls
+)
+{
+    (void)cmock_num_calls;
+    *crc = job->crc;
+    return true;
+}
+
+/**
+ * @brief Let stream blocks with headers be checksummed in software
+ */
+static void setup_stream_checksum(void)
+{
+    CHECKSUM_start_Stub(mock_checksum_start_impl);
+    CHECKSUM_result_Stub(mock_checksum_result_impl);
+    CHECKSUM_cancel_Ignore();
+}
+
 static void setup_protocol_for_dso_test(void)
 {
     USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
     USB_init_IgnoreArg_rx_buffer();
     USB_init_IgnoreArg_tx_buffer();
     USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
     protocol_init();
 }
 
@@ -159,7 +219,9 @@ void test_scpi_configure_oscilloscope_channel_ch1(void)
     // Mock DSO configuration success
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
 
     // Act
     scpi_inject_usb_command("CONFigure:OSCilloscope:CHANnel CH1\n");
@@ -177,7 +239,9 @@ void test_scpi_configure_oscilloscope_channel_ch2(void)
 
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
 
     // Act
     scpi_inject_usb_command("OSC:CONF:CHAN CH2\n");
@@ -195,7 +259,9 @@ void test_scpi_configure_oscilloscope_channel_dual(void)
 
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_DUAL_CHANNEL, 2000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_DUAL_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
 
     // Act
     scpi_inject_usb_command("OSC:CONF:CHAN CH1CH2\n");
@@ -228,7 +294,9 @@ void test_scpi_configure_oscilloscope_channel_query(void)
     // Configure CH1 first
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
 
     // Mock the get_config call to return CH1 configuration
     DSO_Config mock_config = {
@@ -259,7 +327,9 @@ void test_scpi_configure_oscilloscope_timebase(void)
 
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
 
     // Act
     scpi_inject_usb_command("OSC:CONF:TIME 500\n"); // 500 µs/div
@@ -278,7 +348,9 @@ void test_scpi_configure_oscilloscope_timebase_query(void)
     // Configure timebase first
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
 
     // Act
     scpi_inject_usb_command("OSC:CONF:TIME 200\n");
@@ -298,7 +370,9 @@ void test_scpi_configure_oscilloscope_acquire_points(void)
 
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
 
     // Act
     scpi_inject_usb_command("OSC:CONF:ACQ:POIN 1024\n");
@@ -317,7 +391,9 @@ void test_scpi_configure_oscilloscope_acquire_points_query(void)
     // Configure points first
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 3000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 3000000
+    );
 
     // Act
     scpi_inject_usb_command("OSC:CONF:ACQ:POIN 2048\n");
@@ -330,6 +406,20 @@ void test_scpi_configure_oscilloscope_acquire_points_query(void)
     TEST_ASSERT_TRUE(strstr(response, "2048") != NULL);
 }
 
+void test_scpi_configure_oscilloscope_acquire_points_max_query(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:CONF:ACQ:POIN:MAX?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert: all 304 KB of sample memory, in 16-bit samples
+    char const *response = scpi_get_captured_response();
+    TEST_ASSERT_TRUE(strstr(response, "155648") != NULL);
+}
+
 void test_scpi_configure_oscilloscope_acquire_srate_query(void)
 {
     // Arrange
@@ -338,7 +428,9 @@ void test_scpi_configure_oscilloscope_acquire_srate_query(void)
     // Configure DSO first
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
 
     // Mock the get_config call to return sample rate
     DSO_Config mock_config = {
@@ -362,6 +454,24 @@ void test_scpi_configure_oscilloscope_acquire_srate_query(void)
     TEST_ASSERT_TRUE(strstr(response, "1500000") != NULL);
 }
 
+void test_scpi_configure_oscilloscope_acquire_stime_query(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Without a DSO, the default configuration is reported
+    DSO_get_sample_time_ns_ExpectAndReturn(NULL, 1233);
+    DSO_get_sample_time_ns_IgnoreArg_config();
+
+    // Act
+    scpi_inject_usb_command("OSC:CONF:ACQ:STIM?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    char const *response = scpi_get_captured_response();
+    TEST_ASSERT_TRUE(strstr(response, "1233") != NULL);
+}
+
 // ============================================================================
 // SCPI Command Tests - DSO Operation Commands
 // ============================================================================
@@ -374,8 +484,10 @@ void test_scpi_initiate_oscilloscope_success(void)
     // Configure DSO first
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
-    DSO_start_Expect(g_mock_dso_handle);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
 
     // Act
     scpi_inject_usb_command("OSC:CONF:CHAN CH1\n");
@@ -391,10 +503,12 @@ void test_scpi_initiate_oscilloscope_not_configured(void)
 {
     // Arrange
     setup_protocol_for_dso_test();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_start_Expect(g_mock_dso_handle);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
 
     // Act
     scpi_inject_usb_command("OSC:INIT\n");
@@ -411,10 +525,12 @@ void test_scpi_fetch_oscilloscope_data_success(void)
     setup_protocol_for_dso_test();
 
     // Configure and initiate DSO first
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_start_Expect(g_mock_dso_handle);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
     // Simulate acquisition in progress for one tick
     // This is necessary for the tick mock to be called, which sets the acquisition complete flag
     DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, true);
@@ -453,18 +569,226 @@ void test_scpi_fetch_oscilloscope_data_not_initiated(void)
     TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
 }
 
+void test_scpi_fetch_oscilloscope_data_deferred_until_complete(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
+    DSO_init_IgnoreArg_config();
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+    // The query and its first resume find the acquisition running
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, true);
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, true);
+    SYSTEM_get_tick_IgnoreAndReturn(g_mock_system_tick);
+
+    scpi_inject_usb_command("OSC:CONF:CHAN CH1\n");
+    scpi_inject_usb_command("OSC:INIT\n");
+    scpi_inject_usb_command("OSC:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Nothing is sent, not even a line ending, while the capture runs
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+
+    // Act - The next protocol task run after completion answers
+    simulate_dso_acquisition_completion();
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, false);
+    DSO_stop_Expect(g_mock_dso_handle);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - A data block ending the response line
+    char const *response = scpi_get_captured_response();
+    TEST_ASSERT_TRUE(g_scpi_test_captured_response_len > 2);
+    TEST_ASSERT_TRUE(response[0] == '#');
+    TEST_ASSERT_EQUAL_MEMORY(
+        "\r\n", response + g_scpi_test_captured_response_len - 2, 2
+    );
+}
+
+void test_scpi_abort_oscilloscope_ends_deferred_fetch(void)
+{
+    // Arrange - A fetch waiting for a running capture
+    setup_protocol_for_dso_test();
+
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
+    DSO_init_IgnoreArg_config();
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, true);
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, true);
+    SYSTEM_get_tick_IgnoreAndReturn(g_mock_system_tick);
+
+    scpi_inject_usb_command("OSC:CONF:CHAN CH1\n");
+    scpi_inject_usb_command("OSC:INIT\n");
+    scpi_inject_usb_command("OSC:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Act - ABORt is processed while the fetch is pending
+    DSO_stop_Expect(g_mock_dso_handle);
+    DSO_deinit_Expect(g_mock_dso_handle);
+    scpi_inject_usb_command("OSC:ABOR\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - The fetch fails without a response
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_opc_query_waits_for_acquisition(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
+    DSO_init_IgnoreArg_config();
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, true);
+    SYSTEM_get_tick_IgnoreAndReturn(g_mock_system_tick);
+
+    scpi_inject_usb_command("OSC:CONF:CHAN CH1\n");
+    scpi_inject_usb_command("OSC:INIT;*OPC?\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Neither the answer nor the next command while the capture runs
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+
+    // Act - The next protocol task run after completion answers
+    simulate_dso_acquisition_completion();
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, false);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - Then the held command runs
+    TEST_ASSERT_EQUAL_STRING(
+        "1\r\n0,\"No error\"\r\n", scpi_get_captured_response()
+    );
+}
+
+void test_scpi_fetch_oscilloscope_data_holds_input_while_sending(void)
+{
+    // Arrange - A completed capture
+    setup_protocol_for_dso_test();
+    USB_rx_ready_StubWithCallback(scpi_mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(scpi_mock_usb_read_inject);
+    USB_write_StubWithCallback(scpi_mock_usb_write_capture);
+    USB_write_buffer_StubWithCallback(scpi_mock_usb_write_buffer_capture);
+
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
+    DSO_init_IgnoreArg_config();
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+    scpi_inject_usb_command("OSC:CONF:CHAN CH1\n");
+    scpi_inject_usb_command("OSC:INIT\n");
+    USB_task_Expect(g_mock_usb_handle);
+    protocol_task();
+    simulate_dso_acquisition_completion();
+
+    // The samples are handed to USB in place
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, false);
+    DSO_stop_Expect(g_mock_dso_handle);
+    scpi_inject_usb_command("OSC:FETC?\n");
+    USB_task_Expect(g_mock_usb_handle);
+    protocol_task();
+    TEST_ASSERT_TRUE(scpi_get_captured_response()[0] == '#');
+
+    // Act - A command arriving while the samples are still being sent
+    scpi_clear_captured_response();
+    scpi_inject_usb_command("*IDN?\n");
+    USB_task_Expect(g_mock_usb_handle);
+    USB_tx_buffer_pending_ExpectAndReturn(g_mock_usb_handle, true);
+    protocol_task();
+
+    // Assert - It waits until the samples are out
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+    USB_task_Expect(g_mock_usb_handle);
+    USB_tx_buffer_pending_ExpectAndReturn(g_mock_usb_handle, false);
+    protocol_task();
+    TEST_ASSERT_TRUE(strstr(scpi_get_captured_response(), "PSLab") != NULL);
+}
+
+static uint16_t *g_record_buffers[2];
+static int g_record_switches;
+
+/**
+ * @brief Mock DSO_set_config implementation that records the buffers used
+ */
+static void mock_dso_set_config_record(
+    DSO_Handle *handle,
+    DSO_Config const *config,
+    int cmock_num_calls
+)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    if (g_record_switches < 2) {
+        g_record_buffers[g_record_switches] = config->buffer;
+    }
+    g_record_switches++;
+}
+
+void test_scpi_fetch_oscilloscope_data_alternates_records(void)
+{
+    // Arrange - Two records, the first capture complete
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
+    DSO_init_IgnoreArg_config();
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+    scpi_inject_usb_command("OSC:CONF:ACQ:REC 2\n");
+    scpi_inject_usb_command("OSC:INIT\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    simulate_dso_acquisition_completion();
+
+    g_record_switches = 0;
+    DSO_is_acquisition_in_progress_IgnoreAndReturn(false);
+    DSO_stop_Ignore();
+    DSO_get_config_IgnoreAndReturn((DSO_Config)DSO_CONFIG_DEFAULT);
+    DSO_set_config_StubWithCallback(mock_dso_set_config_record);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+
+    // Act - Each fetch starts the next capture into the other record
+    scpi_inject_usb_command("OSC:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    simulate_dso_acquisition_completion();
+    scpi_inject_usb_command("OSC:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(2, g_record_switches);
+    TEST_ASSERT_NOT_NULL(g_record_buffers[0]);
+    TEST_ASSERT_NOT_NULL(g_record_buffers[1]);
+    TEST_ASSERT_TRUE(g_record_buffers[0] != g_record_buffers[1]);
+}
+
 void test_scpi_read_oscilloscope_complete_flow(void)
 {
     // Arrange
     setup_protocol_for_dso_test();
 
     // Mock the complete READ flow (INIT + FETCH)
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
     // READ checks for acquisition in progress and aborts if true
     DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, false);
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_start_Expect(g_mock_dso_handle);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
     // Simulate acquisition in progress for three ticks
     DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, true);
     DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, true);
@@ -479,7 +803,7 @@ void test_scpi_read_oscilloscope_complete_flow(void)
     // Act
     scpi_inject_usb_command("OSC:CONF:CHAN CH2\n");
     scpi_inject_usb_command("OSC:READ?\n");
-    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    run_protocol_until_response();
 
     // Assert
     char const *response = scpi_get_captured_response();
@@ -494,16 +818,29 @@ void test_scpi_measure_oscilloscope_complete_flow(void)
     setup_protocol_for_dso_test();
 
     // Mock the complete MEASURE flow (CONF + READ)
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_DUAL_CHANNEL, 2000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_DUAL_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
     DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, false);
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_start_Expect(g_mock_dso_handle);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
     DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, true);
     DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, true);
     DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, true);
     DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, false);
     DSO_stop_Expect(g_mock_dso_handle);
+    DSO_Config const dual_config = { .mode = DSO_MODE_DUAL_CHANNEL };
+    DSO_get_config_ExpectAndReturn(g_mock_dso_handle, dual_config);
+    DSO_Measurements const measurements[] = {
+        { 3300, 1650, 2333, 1000000, 1000000, 5000, 500 },
+        { 0, 1200, 1200, 0, 0, 0, 0 },
+    };
+    for (uint32_t channel = 0; channel < 2; ++channel) {
+        DSO_measure_Expect(g_mock_dso_handle, channel, NULL);
+        DSO_measure_IgnoreArg_out();
+        DSO_measure_ReturnThruPtr_out(&measurements[channel]);
+    }
 
 
     // Set up SYSTEM_get_tick mock to complete acquisition after a few calls
@@ -511,13 +848,14 @@ void test_scpi_measure_oscilloscope_complete_flow(void)
 
     // Act
     scpi_inject_usb_command("OSC:MEAS? CH1CH2\n");
-    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
-
-    // Assert
-    char const *response = scpi_get_captured_response();
-    TEST_ASSERT_TRUE(strlen(response) > 0);
-    // Should contain binary data block marker
-    TEST_ASSERT_TRUE(response[0] == '#');
+    run_protocol_until_response();
+
+    // Assert - Seven values per channel instead of the samples
+    TEST_ASSERT_EQUAL_STRING(
+        "3300,1650,2333,1000000,1000000,5000,500,"
+        "0,1200,1200,0,0,0,0\r\n",
+        scpi_get_captured_response()
+    );
 }
 
 void test_scpi_abort_oscilloscope(void)
@@ -528,8 +866,10 @@ void test_scpi_abort_oscilloscope(void)
     // Configure and start acquisition first
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
-    DSO_start_Expect(g_mock_dso_handle);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
     DSO_stop_Expect(g_mock_dso_handle);
     DSO_deinit_Expect(g_mock_dso_handle);
 
@@ -567,8 +907,10 @@ void test_scpi_status_oscilloscope_acquisition_query_running_complete(void)
     // Configure and start acquisition
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
-    DSO_start_Expect(g_mock_dso_handle);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
     DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, true);
 
     // Act
@@ -596,6 +938,27 @@ void test_scpi_status_oscilloscope_acquisition_query_running_complete(void)
     TEST_ASSERT_TRUE(strstr(response2, "2") != NULL);
 }
 
+void test_scpi_status_oscilloscope_integrity_query(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    DSO_Diagnostics const diagnostics = {
+        .adc_overruns = 3,
+        .dma_errors = 1,
+        .capture_affected = true,
+    };
+    DSO_get_diagnostics_ExpectAndReturn(NULL, diagnostics);
+
+    // Act
+    scpi_inject_usb_command("OSC:STAT:INT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    char const *response = scpi_get_captured_response();
+    TEST_ASSERT_TRUE(strstr(response, "3,1,0,1") != NULL);
+}
+
 // ============================================================================
 // DSO Error Handling Tests
 // ============================================================================
@@ -608,7 +971,9 @@ void test_dso_configuration_invalid_sample_rate(void)
     // Mock sample rate validation failure
     DSO_init_ExpectAndThrow(NULL, ERROR_INVALID_ARGUMENT);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 1000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 1000000
+    );
 
     // Act
     scpi_inject_usb_command("OSC:CONF:TIME 1\n"); // Very fast timebase causing invalid sample rate
@@ -627,10 +992,12 @@ void test_dso_start_failure(void)
     // Configure DSO first
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
 
     // Mock DSO start failure
-    DSO_start_ExpectAndThrow(g_mock_dso_handle, ERROR_HARDWARE_FAULT);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_HARDWARE_FAULT);
 
     // Act
     scpi_inject_usb_command("OSC:CONF:CHAN CH1\n");
@@ -650,8 +1017,10 @@ void test_dso_configuration_during_acquisition(void)
     // Configure and start acquisition
     DSO_init_ExpectAndReturn(NULL, g_mock_dso_handle);
     DSO_init_IgnoreArg_config();
-    DSO_get_max_sample_rate_ExpectAndReturn(DSO_MODE_SINGLE_CHANNEL, 2000000);
-    DSO_start_Expect(g_mock_dso_handle);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
     DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, true);
 
     // Act
@@ -664,3 +1033,1777 @@ void test_dso_configuration_during_acquisition(void)
     // Assert - Should generate SCPI error for configuration during acquisition
     TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
 }
+
+// ============================================================================
+// DSO Streaming Tests
+// ============================================================================
+
+static DSO_Config g_captured_dso_config;
+
+/**
+ * @brief Mock DSO_init implementation that captures the applied configuration
+ */
+static DSO_Handle *mock_dso_init_capture(DSO_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    g_captured_dso_config = *config;
+    return g_mock_dso_handle;
+}
+
+/**
+ * @brief Helper to start an oscilloscope stream with default configuration
+ */
+static void start_oscilloscope_stream(void)
+{
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+
+    scpi_inject_usb_command("OSC:STR\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+}
+
+void test_scpi_stream_oscilloscope_start_configures_continuous(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    start_oscilloscope_stream();
+
+    // Assert
+    TEST_ASSERT_TRUE(g_captured_dso_config.continuous);
+    TEST_ASSERT_NOT_NULL(g_captured_dso_config.block_callback);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len); // No response
+}
+
+void test_scpi_stream_oscilloscope_pushes_block(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    start_oscilloscope_stream();
+    uint16_t const block[] = { 0x0102, 0x0304, 0x0506, 0x0708 };
+    char const expected[] = "#18\x02\x01\x04\x03\x06\x05\x08\x07\r\n";
+
+    // Act - block completes, protocol task pushes it without a query
+    g_captured_dso_config.block_callback(block, 4);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_stream_oscilloscope_returns_sent_blocks(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    start_oscilloscope_stream();
+    uint16_t const first[] = { 0x0102, 0x0304 };
+    uint16_t const second[] = { 0x0506, 0x0708 };
+    char const expected[] = "#14\x02\x01\x04\x03\r\n#14\x06\x05\x08\x07\r\n";
+
+    // Act - both halves are lent before the task runs; they are sent in
+    // order and each is returned before the next one goes out
+    g_captured_dso_config.block_callback(first, 2);
+    g_captured_dso_config.block_callback(second, 2);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    DSO_release_block_Expect(g_mock_dso_handle, first);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    DSO_release_block_Expect(g_mock_dso_handle, second);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+/**
+ * @brief Read a little-endian uint32 from a captured response
+ */
+static uint32_t response_uint32(size_t offset)
+{
+    uint8_t const *bytes = (uint8_t const *)&g_scpi_test_captured_response[offset];
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+           ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+void test_scpi_stream_oscilloscope_decimates_after_gap(void)
+{
+    // Arrange - Stream headers and automatic decimation
+    setup_protocol_for_dso_test();
+    setup_stream_checksum();
+    scpi_inject_usb_command("OSC:FORM:HEAD ON\n");
+    scpi_inject_usb_command("OSC:STR:DEC:AUTO ON\n");
+    start_oscilloscope_stream();
+    DSO_get_config_IgnoreAndReturn(g_captured_dso_config);
+    uint16_t const first[] = { 0x0102, 0x0304, 0x0506, 0x0708 };
+    uint16_t const second[] = { 0x0100, 0x0300, 0x0500, 0x0700 };
+
+    // Act - The second half completes while the first is lent, so the DSO
+    // pauses until the first is returned, and the third follows a gap
+    g_captured_dso_config.block_callback(first, 4);
+    g_captured_dso_config.block_callback(second, 4);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    DSO_release_block_Expect(g_mock_dso_handle, first);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    g_captured_dso_config.block_callback(first, 4);
+    DSO_release_block_Expect(g_mock_dso_handle, second);
+    DSO_release_block_Expect(g_mock_dso_handle, first);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - The first two blocks are sent as they are, each a 24-byte
+    // header, the samples and the CRC of both
+    TEST_ASSERT_EQUAL(122, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY("#236", g_scpi_test_captured_response, 4);
+    TEST_ASSERT_EQUAL(2, g_scpi_test_captured_response[4]); // Version
+    TEST_ASSERT_EQUAL(24, g_scpi_test_captured_response[4 + 1]); // Size
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response[4 + 3]); // No gap
+    TEST_ASSERT_EQUAL(0, response_uint32(4 + 4)); // Sequence
+    TEST_ASSERT_EQUAL(1, response_uint32(4 + 12)); // Decimation
+    TEST_ASSERT_EQUAL(4, response_uint32(4 + 20)); // Samples
+    TEST_ASSERT_EQUAL_MEMORY(first, &g_scpi_test_captured_response[28], 8);
+    TEST_ASSERT_EQUAL_HEX32(
+        CRC32_update(CRC32_INIT, &g_scpi_test_captured_response[4], 32),
+        response_uint32(36)
+    );
+    TEST_ASSERT_EQUAL_MEMORY("\r\n", &g_scpi_test_captured_response[40], 2);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response[46 + 3]);
+    TEST_ASSERT_EQUAL(1, response_uint32(46 + 4));
+    TEST_ASSERT_EQUAL_MEMORY(second, &g_scpi_test_captured_response[70], 8);
+
+    // The third follows the pause, averaged down by 2
+    uint16_t const averaged[] = { 0x0203, 0x0607 };
+    TEST_ASSERT_EQUAL_MEMORY("#232", &g_scpi_test_captured_response[84], 4);
+    TEST_ASSERT_EQUAL(1, g_scpi_test_captured_response[88 + 3]); // Gap
+    TEST_ASSERT_EQUAL(2, response_uint32(88 + 4)); // Sequence
+    TEST_ASSERT_EQUAL(1, response_uint32(88 + 8)); // Gaps
+    TEST_ASSERT_EQUAL(2, response_uint32(88 + 12)); // Decimation
+    TEST_ASSERT_EQUAL(
+        g_captured_dso_config.sample_rate / 2, response_uint32(88 + 16)
+    );
+    TEST_ASSERT_EQUAL(2, response_uint32(88 + 20)); // Samples
+    TEST_ASSERT_EQUAL_MEMORY(averaged, &g_scpi_test_captured_response[112], 4);
+    TEST_ASSERT_EQUAL_HEX32(
+        CRC32_update(CRC32_INIT, &g_scpi_test_captured_response[88], 28),
+        response_uint32(116)
+    );
+}
+
+void test_scpi_stream_oscilloscope_math_only_difference(void)
+{
+    // Arrange - A dual-channel stream of the difference alone
+    setup_protocol_for_dso_test();
+    DSO_Config dual = DSO_CONFIG_DEFAULT;
+    dual.mode = DSO_MODE_DUAL_CHANNEL;
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_get_config_IgnoreAndReturn(dual);
+    DSO_get_max_sample_rate_IgnoreAndReturn(2000000);
+    DSO_set_config_Ignore();
+    DSO_is_acquisition_in_progress_IgnoreAndReturn(false);
+    DSO_try_start_IgnoreAndReturn(ERROR_NONE);
+    scpi_inject_usb_command("OSC:CONF:CHAN CH1CH2\n");
+    scpi_inject_usb_command("OSC:STR:MATH DIFF\n");
+    scpi_inject_usb_command("OSC:STR:MATH:ONLY ON\n");
+    scpi_inject_usb_command("OSC:STR\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    uint16_t const block[] = { 0x0200, 0x0100, 0x0100, 0x0300 };
+    // 4096 - 2048 and 2048 - 6144 in Q15 of the 12-bit full scale
+    char const expected[] = "#14\x00\x08\x00\xF0\r\n";
+
+    // Act - The block is copied out by the math, so it goes back at once
+    g_captured_dso_config.block_callback(block, 4);
+    DSO_release_block_Expect(g_mock_dso_handle, block);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(
+        expected, g_scpi_test_captured_response, sizeof(expected) - 1
+    );
+}
+
+void test_scpi_stream_oscilloscope_math_requires_dual_channel(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_IgnoreAndReturn(2000000);
+
+    // Act - The default single-channel stream carries no pairs of samples
+    scpi_inject_usb_command("OSC:STR:MATH PROD\n");
+    scpi_inject_usb_command("OSC:STR\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_stream_oscilloscope_counts_overruns(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    start_oscilloscope_stream();
+    uint16_t const block[] = { 0, 0, 0, 0 };
+    DSO_Diagnostics diagnostics = { 0 };
+    diagnostics.stream_pauses = 2;
+
+    // Act - a fourth block overflows the queue and is returned at once
+    g_captured_dso_config.block_callback(block, 4);
+    g_captured_dso_config.block_callback(block, 4);
+    g_captured_dso_config.block_callback(block, 4);
+    DSO_release_block_Expect(g_mock_dso_handle, block);
+    g_captured_dso_config.block_callback(block, 4);
+
+    DSO_get_diagnostics_ExpectAndReturn(g_mock_dso_handle, diagnostics);
+    scpi_inject_usb_command("OSC:STR:OVER?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - the DSO's pauses plus the dropped block, then the first block
+    TEST_ASSERT_EQUAL_MEMORY("3\r\n#18", scpi_get_captured_response(), 6);
+}
+
+void test_scpi_stream_oscilloscope_rejects_initiate(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    start_oscilloscope_stream();
+
+    // Act
+    scpi_inject_usb_command("OSC:INIT\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - Should generate SCPI error
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_stream_oscilloscope_stop(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    start_oscilloscope_stream();
+    DSO_Config running_config = g_captured_dso_config;
+    DSO_Diagnostics const diagnostics = { 0 };
+    DSO_get_diagnostics_ExpectAndReturn(g_mock_dso_handle, diagnostics);
+    DSO_stop_Expect(g_mock_dso_handle);
+    DSO_get_config_ExpectAndReturn(g_mock_dso_handle, running_config);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_set_config_Expect(g_mock_dso_handle, NULL);
+    DSO_set_config_IgnoreArg_config();
+
+    // Act
+    scpi_inject_usb_command("OSC:STR:STOP\n");
+    scpi_inject_usb_command("OSC:STR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("0\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_stream_record_rate_default(void)
+{
+    // Arrange - 256-sample blocks, at most one every 2 ms
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+
+    // Act
+    scpi_inject_usb_command("OSC:STR:REC:RATE?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("128000\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_stream_record_rejects_running_stream(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    start_oscilloscope_stream();
+
+    // Act
+    scpi_inject_usb_command("OSC:STR:REC\n");
+    scpi_inject_usb_command("OSC:STR:REC?;:SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING(
+        "0;-200,\"Execution error\"\r\n", scpi_get_captured_response()
+    );
+}
+
+/**
+ * @brief Helper to start roll mode with default configuration
+ */
+static void start_oscilloscope_roll(void)
+{
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+
+    scpi_inject_usb_command("OSC:ROLL\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+}
+
+void test_scpi_roll_oscilloscope_start_configures_ring(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    start_oscilloscope_roll();
+    scpi_inject_usb_command("OSC:ROLL?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - continuous, without a consumer for the halves
+    TEST_ASSERT_TRUE(g_captured_dso_config.continuous);
+    TEST_ASSERT_NULL(g_captured_dso_config.block_callback);
+    TEST_ASSERT_EQUAL_STRING("1\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_fetch_oscilloscope_new_sends_new_samples(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    start_oscilloscope_roll();
+    for (uint16_t i = 0; i < 8; ++i) {
+        g_captured_dso_config.buffer[i] = (uint16_t)(0x0100 + i);
+    }
+    DSO_get_config_IgnoreAndReturn(g_captured_dso_config);
+    DSO_get_samples_written_ExpectAndReturn(g_mock_dso_handle, 5);
+    DSO_get_samples_written_ExpectAndReturn(g_mock_dso_handle, 8);
+    // Samples 0 to 3, the fifth waiting for its pair; then 4 to 7
+    char const expected[] =
+        "#18\x00\x01\x01\x01\x02\x01\x03\x01\r\n"
+        "#18\x04\x01\x05\x01\x06\x01\x07\x01\r\n";
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC:NEW?\n");
+    scpi_inject_usb_command("OSC:FETC:NEW?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_fetch_oscilloscope_new_skips_overwritten_samples(void)
+{
+    // Arrange - 600 samples written into the 512-sample ring
+    setup_protocol_for_dso_test();
+    start_oscilloscope_roll();
+    DSO_get_config_IgnoreAndReturn(g_captured_dso_config);
+    DSO_get_samples_written_ExpectAndReturn(g_mock_dso_handle, 600);
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC:NEW?\n");
+    scpi_inject_usb_command("OSC:ROLL:SKIP?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - the newest half buffer is sent, the rest is counted
+    char const *response = scpi_get_captured_response();
+    TEST_ASSERT_EQUAL_MEMORY("#3512", response, 5);
+    TEST_ASSERT_EQUAL_STRING(
+        "344\r\n", &response[g_scpi_test_captured_response_len - 5]
+    );
+}
+
+void test_scpi_fetch_oscilloscope_new_requires_roll(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC:NEW?\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_roll_oscilloscope_stop(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    start_oscilloscope_roll();
+    DSO_stop_Expect(g_mock_dso_handle);
+    DSO_get_config_ExpectAndReturn(g_mock_dso_handle, g_captured_dso_config);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_set_config_Expect(g_mock_dso_handle, NULL);
+    DSO_set_config_IgnoreArg_config();
+
+    // Act
+    scpi_inject_usb_command("OSC:ROLL:STOP\n");
+    scpi_inject_usb_command("OSC:ROLL?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("0\r\n", scpi_get_captured_response());
+}
+
+/**
+ * @brief Helper to start histogram mode with default configuration
+ */
+static void start_oscilloscope_histogram(char const *command)
+{
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+
+    scpi_inject_usb_command(command);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+}
+
+void test_scpi_histogram_oscilloscope_bins_blocks(void)
+{
+    // Arrange - bins for codes 1 and 2
+    setup_protocol_for_dso_test();
+    start_oscilloscope_histogram("OSC:HIST:RANG 1,2;:OSC:HIST\n");
+    uint16_t const block[] = { 0, 1, 2, 2, 5 };
+    char const expected[] =
+        "#18\x01\x00\x00\x00\x02\x00\x00\x00\r\n3,1,1\r\n";
+
+    // Act - the block is binned and returned by the task
+    g_captured_dso_config.block_callback(block, 5);
+    DSO_release_block_Expect(g_mock_dso_handle, block);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    scpi_inject_usb_command("OSC:FETC:HIST?\n");
+    scpi_inject_usb_command("OSC:HIST:COUN?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_TRUE(g_captured_dso_config.continuous);
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_histogram_oscilloscope_channel_not_captured(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act - the default capture is CH1 alone
+    scpi_inject_usb_command("OSC:HIST CH2\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_histogram_oscilloscope_range_rejects_wide_range(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:HIST:RANG 0,4096\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_histogram_oscilloscope_stop_bins_queued_blocks(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    start_oscilloscope_histogram("OSC:HIST\n");
+    uint16_t const block[] = { 7, 7 };
+    g_captured_dso_config.block_callback(block, 2);
+    DSO_stop_Expect(g_mock_dso_handle);
+    DSO_release_block_Expect(g_mock_dso_handle, block);
+    DSO_get_config_ExpectAndReturn(g_mock_dso_handle, g_captured_dso_config);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_set_config_Expect(g_mock_dso_handle, NULL);
+    DSO_set_config_IgnoreArg_config();
+
+    // Act
+    scpi_inject_usb_command("OSC:HIST:STOP\n");
+    scpi_inject_usb_command("OSC:HIST?;HIST:COUN?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("0;2,0,0\r\n", scpi_get_captured_response());
+}
+
+// ============================================================================
+// DSO Mask Test Tests
+// ============================================================================
+
+/**
+ * @brief Helper to upload a mask for a 4-sample capture and acquire it
+ *
+ * The first two samples are limited to 0x0101 to 0x0202, the others pass.
+ */
+static void acquire_four_samples_with_mask(void)
+{
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, false);
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, false);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+
+    scpi_inject_usb_command("OSC:CONF:ACQ:POIN 4\n");
+    scpi_inject_usb_command(
+        "OSC:MASK:DATA 0,#18\x01\x01\x02\x02\x01\x01\x02\x02\n"
+    );
+    scpi_inject_usb_command("OSC:MASK ON\n");
+    scpi_inject_usb_command("OSC:INIT\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    g_captured_dso_config.buffer[0] = 0x0123;
+    g_captured_dso_config.buffer[1] = 0x0456;
+    g_captured_dso_config.buffer[2] = 0x0789;
+    g_captured_dso_config.buffer[3] = 0x0ABC;
+    dso_complete_callback();
+
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, false);
+    DSO_stop_Expect(g_mock_dso_handle);
+}
+
+void test_scpi_fetch_oscilloscope_mask_reports_first_failure(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    acquire_four_samples_with_mask();
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC:MASK?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - 0x0456 is above its limit, the open samples pass
+    TEST_ASSERT_EQUAL_STRING("0,1,1\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_fetch_oscilloscope_mask_requires_mask_test(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC:MASK?\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_mask_oscilloscope_state_requires_mask(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:MASK ON\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+static USB_Handle *g_mock_usb_bulk_handle = (USB_Handle *)0x2468ACE0;
+static uint32_t g_bulk_write_len;
+
+/**
+ * @brief Mock USB_write implementation that counts bytes sent on the bulk
+ * interface and captures everything else as SCPI responses
+ */
+static uint32_t mock_usb_write_split(USB_Handle *handle, uint8_t const *data, uint32_t len, int cmock_num_calls)
+{
+    if (handle == g_mock_usb_bulk_handle) {
+        g_bulk_write_len += len;
+        return len;
+    }
+    return scpi_mock_usb_write_capture(handle, data, len, cmock_num_calls);
+}
+
+/**
+ * @brief Mock USB_write_buffer implementation, split like mock_usb_write_split
+ */
+static bool mock_usb_write_buffer_split(USB_Handle *handle, uint8_t const *buf, uint32_t sz, int cmock_num_calls)
+{
+    return mock_usb_write_split(handle, buf, sz, cmock_num_calls) == sz;
+}
+
+void test_scpi_stream_oscilloscope_interface_bulk(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    USB_init_ExpectAndReturn(USB_INTERFACE_BULK, NULL, NULL, g_mock_usb_bulk_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+
+    // Act
+    scpi_inject_usb_command("OSC:STR:INT BULK\n");
+    scpi_inject_usb_command("OSC:STR:INT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("BULK\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_stream_oscilloscope_interface_iso(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    USB_init_ExpectAndReturn(USB_INTERFACE_ISO, NULL, NULL, g_mock_usb_bulk_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+
+    // Act
+    scpi_inject_usb_command("OSC:STR:INT ISO\n");
+    scpi_inject_usb_command("OSC:STR:INT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("ISO\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_stream_oscilloscope_interface_iso_unavailable(void)
+{
+    // Arrange: a build without the isochronous interface
+    setup_protocol_for_dso_test();
+    USB_init_ExpectAndThrow(
+        USB_INTERFACE_ISO, NULL, NULL, ERROR_RESOURCE_UNAVAILABLE
+    );
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+
+    // Act
+    scpi_inject_usb_command("OSC:STR:INT ISO\n");
+    scpi_inject_usb_command("OSC:STR:INT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert: the stream stays on the serial port
+    TEST_ASSERT_EQUAL_STRING("CDC\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_stream_oscilloscope_bulk_pushes_block(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    USB_init_ExpectAndReturn(USB_INTERFACE_BULK, NULL, NULL, g_mock_usb_bulk_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    scpi_inject_usb_command("OSC:STR:INT BULK\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    DSO_get_max_sample_rate_ExpectAndReturn(
+
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+    scpi_inject_usb_command("OSC:STR\n");
+    USB_task_Expect(g_mock_usb_handle);
+    USB_task_Expect(g_mock_usb_bulk_handle);
+    USB_rx_ready_StubWithCallback(scpi_mock_usb_rx_ready_check);
+    USB_read_StubWithCallback(scpi_mock_usb_read_inject);
+    USB_write_StubWithCallback(mock_usb_write_split);
+    USB_write_buffer_StubWithCallback(mock_usb_write_buffer_split);
+    protocol_task();
+
+    uint16_t const block[] = { 0, 0, 0, 0 };
+    g_bulk_write_len = 0;
+    scpi_clear_captured_response();
+
+    // Act
+    g_captured_dso_config.block_callback(block, 4);
+    USB_task_Expect(g_mock_usb_handle);
+    USB_task_Expect(g_mock_usb_bulk_handle);
+    protocol_task();
+
+    // Assert - "#18" + 8 data bytes + "\r\n" on bulk, nothing on the CDC port
+    TEST_ASSERT_EQUAL(13, g_bulk_write_len);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+}
+
+// ============================================================================
+// DSO Data Format Tests
+// ============================================================================
+
+/**
+ * @brief Helper to complete a 4-sample acquisition with known sample values
+ */
+static void acquire_four_samples(void)
+{
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+
+    scpi_inject_usb_command("OSC:CONF:ACQ:POIN 4\n");
+    scpi_inject_usb_command("OSC:INIT\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    g_captured_dso_config.buffer[0] = 0x0123;
+    g_captured_dso_config.buffer[1] = 0x0456;
+    g_captured_dso_config.buffer[2] = 0x0789;
+    g_captured_dso_config.buffer[3] = 0x0ABC;
+    dso_complete_callback();
+
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, false);
+    DSO_stop_Expect(g_mock_dso_handle);
+}
+
+void test_scpi_fetch_oscilloscope_data_packed(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+    char const expected[] = "#16\x23\x61\x45\x89\xC7\xAB\r\n";
+
+    // Act
+    scpi_inject_usb_command("OSC:FORM PACK\n");
+    scpi_inject_usb_command("OSC:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_fetch_oscilloscope_data_int8(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+    char const expected[] = "#14\x12\x45\x78\xAB\r\n";
+
+    // Act
+    scpi_inject_usb_command("OSC:FORM INT8\n");
+    scpi_inject_usb_command("OSC:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_fetch_oscilloscope_data_delta(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+    // Deltas 0x123, 0x333, 0x333, 0x333 as tagged zigzag varints
+    char const expected[] = "#18\x8C\x09\xCC\x19\xCC\x19\xCC\x19\r\n";
+
+    // Act
+    scpi_inject_usb_command("OSC:FORM DELT\n");
+    scpi_inject_usb_command("OSC:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_fetch_oscilloscope_data_millivolts(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+    DSO_get_reference_voltage_ExpectAndReturn(3300);
+    // 235, 895, 1555 and 2215 mV as little-endian 16-bit words
+    char const expected[] = "#18\xEB\x00\x7F\x03\x13\x06\xA7\x08\r\n";
+
+    // Act
+    scpi_inject_usb_command("OSC:FORM MVOL\n");
+    scpi_inject_usb_command("OSC:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_fetch_oscilloscope_data_repeated_from_cache(void)
+{
+    // Arrange - the millivolts are only converted for the first fetch
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+    DSO_get_reference_voltage_ExpectAndReturn(3300);
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, false);
+    DSO_stop_Expect(g_mock_dso_handle);
+    char const expected[] = "#18\xEB\x00\x7F\x03\x13\x06\xA7\x08\r\n"
+                            "#18\xEB\x00\x7F\x03\x13\x06\xA7\x08\r\n";
+
+    // Act
+    scpi_inject_usb_command("OSC:FORM MVOL\n");
+    scpi_inject_usb_command("OSC:FETC?\n");
+    scpi_inject_usb_command("OSC:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_fetch_oscilloscope_data_with_header(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+    DSO_Config config = g_captured_dso_config;
+    config.sample_rate = 2000000;
+    DSO_get_config_ExpectAndReturn(g_mock_dso_handle, config);
+    DSO_Diagnostics const diagnostics = { .capture_affected = true };
+    DSO_get_diagnostics_ExpectAndReturn(g_mock_dso_handle, diagnostics);
+    DSO_get_trigger_index_ExpectAndReturn(g_mock_dso_handle, 0);
+    DSO_get_start_time_us_ExpectAndReturn(g_mock_dso_handle, 0x12345678);
+    uint32_t sof_frame = 0x00000ABC;
+    uint32_t sof_time_us = 0x12346000;
+    USB_get_frame_stamp_ExpectAnyArgsAndReturn(true);
+    USB_get_frame_stamp_ReturnThruPtr_frame(&sof_frame);
+    USB_get_frame_stamp_ReturnThruPtr_time_us(&sof_time_us);
+    // Version 1, 40 bytes, one channel (CH1), PACKed, 12 bits, affected,
+    // no decimation; 2 MSa/s, 4 points, trigger index 0, start time,
+    // sequence 1, one segment, frame stamp; then the packed samples
+    char const expected[] =
+        "#246"
+        "\x01\x28\x01\x01\x01\x0C\x01\x00"
+        "\x80\x84\x1E\x00\x04\x00\x00\x00"
+        "\x00\x00\x00\x00\x78\x56\x34\x12"
+        "\x01\x00\x00\x00\x01\x00\x00\x00"
+        "\xBC\x0A\x00\x00\x00\x60\x34\x12"
+        "\x23\x61\x45\x89\xC7\xAB\r\n";
+
+    // Act
+    scpi_inject_usb_command("OSC:FORM PACK\n");
+    scpi_inject_usb_command("OSC:FORM:HEAD ON\n");
+    scpi_inject_usb_command("OSC:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_format_oscilloscope_header_query(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:FORM:HEAD?\n");
+    scpi_inject_usb_command("OSC:FORM:HEAD ON\n");
+    scpi_inject_usb_command("OSC:FORM:HEAD?\n");
+    scpi_inject_usb_command("OSC:FORM:HEAD OFF\n");
+    scpi_inject_usb_command("OSC:FORM:HEAD?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - Off by default
+    TEST_ASSERT_EQUAL_STRING("0\r\n1\r\n0\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_fetch_oscilloscope_data_one_channel(void)
+{
+    // Arrange - the four samples as two CH1CH2 frames
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+    DSO_Config config = g_captured_dso_config;
+    config.mode = DSO_MODE_DUAL_CHANNEL;
+    DSO_get_config_ExpectAndReturn(g_mock_dso_handle, config);
+    // 0x0456 and 0x0ABC as little-endian 16-bit words
+    char const expected[] = "#14\x56\x04\xBC\x0A\r\n";
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC? CH2\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_fetch_oscilloscope_data_window(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+    DSO_get_config_ExpectAndReturn(g_mock_dso_handle, g_captured_dso_config);
+    // Samples 1 and 2, sent in place: 0x0456 and 0x0789
+    char const expected[] = "#14\x56\x04\x89\x07\r\n";
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC? 1,2\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_fetch_oscilloscope_data_window_strided_frames(void)
+{
+    // Arrange - the four samples as two CH1CH2 frames
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+    DSO_Config config = g_captured_dso_config;
+    config.mode = DSO_MODE_DUAL_CHANNEL;
+    DSO_get_config_ExpectAndReturn(g_mock_dso_handle, config);
+    // Every other frame from the first, cut to the one in the record
+    char const expected[] = "#14\x23\x01\x56\x04\r\n";
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC? 0,5,2\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_fetch_oscilloscope_data_channel_not_captured(void)
+{
+    // Arrange - CH1 only
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+    DSO_get_config_ExpectAndReturn(g_mock_dso_handle, g_captured_dso_config);
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC? CH2\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_calibration_oscilloscope_interleave_estimates(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+    DSO_calibrate_interleave_Expect(g_mock_dso_handle);
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    scpi_clear_captured_response();
+    scpi_inject_usb_command("OSC:CAL:INT\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_NO_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_calibration_oscilloscope_interleave_fails(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+    DSO_calibrate_interleave_ExpectAndThrow(
+        g_mock_dso_handle, ERROR_CALIBRATION_FAILED
+    );
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    scpi_clear_captured_response();
+    scpi_inject_usb_command("OSC:CAL:INT\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING(
+        "-340,\"Calibration failed\"\r\n", scpi_get_captured_response()
+    );
+}
+
+void test_scpi_calibration_oscilloscope_interleave_needs_capture(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:CAL:INT\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_calibration_oscilloscope_interleave_query(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    INTERLEAVE_Correction const correction = {
+        .gain = FIXED_ONE + FIXED_ONE / 1000,
+        .offset = -FIXED_HALF,
+    };
+    DSO_get_interleave_ExpectAndReturn(correction);
+    DSO_reset_interleave_Expect();
+
+    // Act
+    scpi_inject_usb_command("OSC:CAL:INT?\n");
+    scpi_inject_usb_command("OSC:CAL:INT:RES\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - 65601 / 65536 in ppm, and half a code
+    TEST_ASSERT_EQUAL_STRING("1000992,-500000\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_stream_oscilloscope_delta_pushes_block(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    scpi_inject_usb_command("OSC:FORM DELT\n");
+    start_oscilloscope_stream();
+    uint16_t const block[] = { 5, 5, 5, 5 };
+    // First sample, then a run of three repeats
+    char const expected[] = "#12\x14\x05\r\n";
+
+    // Act - the encoded copy is sent, so the block is returned at once
+    DSO_release_block_Expect(g_mock_dso_handle, block);
+    g_captured_dso_config.block_callback(block, 4);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_format_oscilloscope_data_rejected_while_streaming(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    start_oscilloscope_stream();
+
+    // Act
+    scpi_inject_usb_command("OSC:FORM DELT\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_format_oscilloscope_data_query(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:FORM?\n");
+    scpi_inject_usb_command("OSC:FORM PACK\n");
+    scpi_inject_usb_command("OSC:FORM?\n");
+    scpi_inject_usb_command("OSC:FORM MVOLTS\n");
+    scpi_inject_usb_command("OSC:FORM?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("INT16\r\nPACK\r\nMVOL\r\n", scpi_get_captured_response());
+}
+
+// ============================================================================
+// DSO Decimation Tests
+// ============================================================================
+
+void test_scpi_configure_oscilloscope_acquire_type_peak(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+
+    // Act
+    scpi_inject_usb_command("OSC:CONF:ACQ:TYPE PEAK\n");
+    scpi_inject_usb_command("OSC:CONF:ACQ:TYPE?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - 512 points at 100 us/div is 512 kSa/s, so 3x oversampling
+    TEST_ASSERT_EQUAL(DSO_DECIMATION_PEAK, g_captured_dso_config.decimation);
+    TEST_ASSERT_EQUAL(3, g_captured_dso_config.decimation_factor);
+    TEST_ASSERT_EQUAL(512000, g_captured_dso_config.sample_rate);
+    TEST_ASSERT_EQUAL_STRING("PEAK\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_configure_oscilloscope_acquire_type_filter(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 20000000
+    );
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 20000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+
+    // Act
+    scpi_inject_usb_command("OSC:CONF:ACQ:TYPE FILT\n");
+    scpi_inject_usb_command("OSC:CONF:ACQ:TYPE?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - 39x fits at 512 kSa/s; the filter rounds down to even
+    TEST_ASSERT_EQUAL(DSO_DECIMATION_FILTER, g_captured_dso_config.decimation);
+    TEST_ASSERT_EQUAL(38, g_captured_dso_config.decimation_factor);
+    TEST_ASSERT_EQUAL_STRING("FILT\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_configure_oscilloscope_acquire_type_invalid(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:CONF:ACQ:TYPE FAST\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_configure_oscilloscope_channel_quad(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_QUAD_CHANNEL, DSO_RESOLUTION_12BIT, 1000000
+    );
+
+    // Act
+    scpi_inject_usb_command("OSC:CONF:CHAN CH1CH2CH3CH4\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(DSO_MODE_QUAD_CHANNEL, g_captured_dso_config.mode);
+    TEST_ASSERT_EQUAL(0, strlen(scpi_get_captured_response()));
+}
+
+void test_scpi_configure_oscilloscope_acquire_resolution_8bit(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_8BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+
+    // Act
+    scpi_inject_usb_command("OSC:CONF:ACQ:RES 8\n");
+    scpi_inject_usb_command("OSC:CONF:ACQ:RES?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(DSO_RESOLUTION_8BIT, g_captured_dso_config.resolution);
+    TEST_ASSERT_EQUAL_STRING("8\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_configure_oscilloscope_acquire_resolution_high(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_HIGH, 250000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+
+    // Act
+    scpi_inject_usb_command("OSC:CONF:ACQ:RES 15\n");
+    scpi_inject_usb_command("OSC:CONF:ACQ:RES?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(DSO_RESOLUTION_HIGH, g_captured_dso_config.resolution);
+    TEST_ASSERT_EQUAL_STRING("15\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_configure_oscilloscope_acquire_resolution_invalid(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:CONF:ACQ:RES 6\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// ============================================================================
+// DSO Trigger Tests
+// ============================================================================
+
+void test_scpi_trigger_oscilloscope_mode_configures_dso(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+
+    // Act
+    scpi_inject_usb_command("OSC:TRIG RIS\n");
+    scpi_inject_usb_command("OSC:TRIG?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(DSO_TRIGGER_RISING, g_captured_dso_config.trigger_mode);
+    TEST_ASSERT_FALSE(g_captured_dso_config.continuous);
+    TEST_ASSERT_EQUAL_STRING("RIS\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_trigger_oscilloscope_level_out_of_range(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:TRIG:LEV 4096\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_trigger_oscilloscope_rejected_pretrigger_is_restored(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    DSO_init_ExpectAndThrow(NULL, ERROR_INVALID_ARGUMENT);
+    DSO_init_IgnoreArg_config();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+
+    // Act - pretrigger must be smaller than the 512-sample default buffer
+    scpi_inject_usb_command("OSC:TRIG:PRET 600\n");
+    scpi_inject_usb_command("OSC:TRIG:PRET?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("0\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_trigger_oscilloscope_position_query(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_get_trigger_index_ExpectAndReturn(g_mock_dso_handle, 100);
+
+    // Act
+    scpi_inject_usb_command("OSC:TRIG FALL\n");
+    scpi_inject_usb_command("OSC:TRIG:POS?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("100\r\n", scpi_get_captured_response());
+}
+
+// ============================================================================
+// DSO Segmented Capture Tests
+// ============================================================================
+
+void test_scpi_segment_oscilloscope_count_configures_dso(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+
+    // Act
+    scpi_inject_usb_command("OSC:SEGM 4\n");
+    scpi_inject_usb_command("OSC:SEGM?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(4, g_captured_dso_config.segments);
+    TEST_ASSERT_EQUAL_STRING("4\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_segment_oscilloscope_count_out_of_range(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:SEGM 65\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_segment_oscilloscope_timestamps_query(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_get_segments_acquired_ExpectAndReturn(g_mock_dso_handle, 2);
+    DSO_get_segment_ExpectAndReturn(
+        g_mock_dso_handle,
+        0,
+        (DSO_Segment){ .trigger_index = 10, .timestamp_us = 1500 }
+    );
+    DSO_get_segment_ExpectAndReturn(
+        g_mock_dso_handle,
+        1,
+        (DSO_Segment){ .trigger_index = 20, .timestamp_us = 4200 }
+    );
+
+    // Act
+    scpi_inject_usb_command("OSC:SEGM 2\n");
+    scpi_inject_usb_command("OSC:SEGM:TIME?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("1500,4200\r\n", scpi_get_captured_response());
+}
+
+// ============================================================================
+// DSO Averaging Tests
+// ============================================================================
+
+void test_scpi_average_oscilloscope_count_configures_dso(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+
+    // Act
+    scpi_inject_usb_command("OSC:AVER 16\n");
+    scpi_inject_usb_command("OSC:AVER?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - the accumulator is reserved behind the buffer
+    TEST_ASSERT_EQUAL(16, g_captured_dso_config.averages);
+    TEST_ASSERT_NOT_NULL(g_captured_dso_config.accumulator);
+    TEST_ASSERT_EQUAL_STRING("16\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_average_oscilloscope_count_out_of_range(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:AVER 0\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_average_oscilloscope_acquired_query(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_get_averages_acquired_ExpectAndReturn(g_mock_dso_handle, 5);
+
+    // Act
+    scpi_inject_usb_command("OSC:AVER 8\n");
+    scpi_inject_usb_command("OSC:AVER:ACQ?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("5\r\n", scpi_get_captured_response());
+}
+
+/**
+ * @brief DSO_get_equivalent_time stub filling the record with a ramp
+ */
+static uint32_t mock_dso_equivalent_time(DSO_Handle *handle, uint32_t steps, uint16_t *record, uint32_t size, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    for (uint32_t i = 0; i < size; ++i) {
+        record[i] = (uint16_t)(i * steps);
+    }
+    return 8;
+}
+
+void test_scpi_fetch_oscilloscope_etime_sends_record(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    acquire_four_samples();
+    DSO_get_equivalent_time_StubWithCallback(mock_dso_equivalent_time);
+    char const expected[] = "#18\x00\x00\x04\x00\x08\x00\x0C\x00\r\n";
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC:ETIM? 4\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(expected) - 1, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_scpi_test_captured_response, sizeof(expected) - 1);
+}
+
+void test_scpi_fetch_oscilloscope_etime_steps_out_of_range(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC:ETIM? 65\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_fetch_oscilloscope_measure_not_initiated(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC:MEAS?\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_fetch_oscilloscope_spectrum_peaks(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_try_start_ExpectAndReturn(g_mock_dso_handle, ERROR_NONE);
+    scpi_inject_usb_command("OSC:CONF:ACQ:POIN 64\n");
+    scpi_inject_usb_command("OSC:INIT\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    dso_complete_callback();
+
+    // 64 kHz over 64 points puts bin k at k kHz
+    DSO_Config config = g_captured_dso_config;
+    config.sample_rate = 64000;
+    FIXED_Q1616 bins[32] = { 0 };
+    bins[5] = FIXED_FROM_INT(1000);
+    bins[10] = FIXED_FROM_INT(200);
+    bins[20] = FIXED_FROM_INT(50);
+    DSO_is_acquisition_in_progress_ExpectAndReturn(g_mock_dso_handle, false);
+    DSO_stop_Expect(g_mock_dso_handle);
+    DSO_get_config_ExpectAndReturn(g_mock_dso_handle, config);
+    DSO_get_spectrum_Expect(g_mock_dso_handle, 0, 64, NULL, NULL);
+    DSO_get_spectrum_IgnoreArg_work();
+    DSO_get_spectrum_IgnoreArg_bins();
+    DSO_get_spectrum_ReturnArrayThruPtr_bins(bins, 32);
+    // 1 mV per code
+    DSO_get_reference_voltage_ExpectAndReturn(4095);
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC:SPEC:PEAK? 2\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - Frequency in mHz and amplitude in µV of the two strongest
+    TEST_ASSERT_EQUAL_STRING(
+        "5000000,1000000,10000000,200000\r\n", scpi_get_captured_response()
+    );
+}
+
+void test_scpi_fetch_oscilloscope_spectrum_peaks_out_of_range(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC:SPEC:PEAK? 17\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+void test_scpi_fetch_oscilloscope_spectrum_not_initiated(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("OSC:FETC:SPEC:DIST?\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// ============================================================================
+// DSO Setup Tests
+// ============================================================================
+
+/**
+ * @brief Mock DSO_set_config implementation that captures the configuration
+ */
+static void mock_dso_set_config_capture(DSO_Handle *handle, DSO_Config const *config, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    g_captured_dso_config = *config;
+}
+
+void test_scpi_configure_oscilloscope_apply(void)
+{
+    // Arrange - One reconfiguration for all three parameters
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_DUAL_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+
+    // Act
+    scpi_inject_usb_command("OSC:CONF:APPL CH1CH2,200,1000\n");
+    scpi_inject_usb_command("OSC:CONF:TIME?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - 1000 points over 2 ms
+    TEST_ASSERT_EQUAL(DSO_MODE_DUAL_CHANNEL, g_captured_dso_config.mode);
+    TEST_ASSERT_EQUAL(1000, g_captured_dso_config.buffer_size);
+    TEST_ASSERT_EQUAL(500000, g_captured_dso_config.sample_rate);
+    TEST_ASSERT_EQUAL_STRING("200\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_configure_oscilloscope_apply_rejected_keeps_timebase(void)
+{
+    // Arrange - 1000 points in 10 µs is beyond the ADC
+    setup_protocol_for_dso_test();
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+
+    // Act
+    scpi_inject_usb_command("OSC:CONF:APPL CH1,1,1000\n");
+    scpi_inject_usb_command("OSC:CONF:TIME?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL_STRING("100\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_save_recall_setup(void)
+{
+    // Arrange - CH2 is configured and saved, then replaced by CH1CH2
+    setup_protocol_for_dso_test();
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    scpi_inject_usb_command("OSC:CONF:CHAN CH2\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    DSO_Config const saved_config = g_captured_dso_config;
+
+    DSO_get_config_ExpectAndReturn(g_mock_dso_handle, saved_config);
+    DSO_is_acquisition_in_progress_IgnoreAndReturn(false);
+    DSO_get_config_ExpectAndReturn(g_mock_dso_handle, saved_config);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_DUAL_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    DSO_set_config_StubWithCallback(mock_dso_set_config_capture);
+    scpi_inject_usb_command("*SAV 1\n");
+    scpi_inject_usb_command("OSC:CONF:CHAN CH1CH2\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL(DSO_MODE_DUAL_CHANNEL, g_captured_dso_config.mode);
+
+    // Act
+    DSO_get_config_ExpectAndReturn(g_mock_dso_handle, g_captured_dso_config);
+    DSO_get_max_sample_rate_ExpectAndReturn(
+        DSO_MODE_SINGLE_CHANNEL, DSO_RESOLUTION_12BIT, 2000000
+    );
+    scpi_inject_usb_command("*RCL 1\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(DSO_MODE_SINGLE_CHANNEL, g_captured_dso_config.mode);
+    TEST_ASSERT_EQUAL(DSO_CHANNEL_1, g_captured_dso_config.channel);
+}
+
+void test_scpi_recall_setup_empty_slot(void)
+{
+    // Arrange
+    setup_protocol_for_dso_test();
+
+    // Act
+    scpi_inject_usb_command("*RCL 3\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// ============================================================================
+// DSO Autoset Tests
+// ============================================================================
+
+static DSO_Measurements g_autoset_signal; // Found by the second probe
+static uint32_t g_autoset_probes;
+
+static DSO_Config mock_dso_get_config_captured(DSO_Handle *handle, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    return g_captured_dso_config;
+}
+
+/**
+ * @brief Mock DSO_try_start implementation completing the probe at once
+ */
+static Error mock_dso_try_start_complete(DSO_Handle *handle, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    g_autoset_probes++;
+    dso_complete_callback();
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Mock DSO_measure implementation finding the signal from the second
+ * probe on
+ */
+static void mock_dso_measure_autoset(DSO_Handle *handle, uint32_t channel, DSO_Measurements *out, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    TEST_ASSERT_EQUAL(0, channel);
+    *out = g_autoset_probes >= 2 ? g_autoset_signal : (DSO_Measurements){ 0 };
+}
+
+static void setup_autoset_mocks(void)
+{
+    g_autoset_probes = 0;
+    DSO_get_max_sample_rate_IgnoreAndReturn(2000000);
+    DSO_init_StubWithCallback(mock_dso_init_capture);
+    DSO_set_config_StubWithCallback(mock_dso_set_config_capture);
+    DSO_get_config_StubWithCallback(mock_dso_get_config_captured);
+    DSO_is_acquisition_in_progress_IgnoreAndReturn(false);
+    DSO_try_start_StubWithCallback(mock_dso_try_start_complete);
+    DSO_measure_StubWithCallback(mock_dso_measure_autoset);
+    DSO_stop_Ignore();
+    SYSTEM_get_tick_IgnoreAndReturn(0);
+}
+
+void test_scpi_autoset_oscilloscope_sets_timebase(void)
+{
+    // Arrange - A 1 kHz signal, too slow for the first probe
+    setup_protocol_for_dso_test();
+    setup_autoset_mocks();
+    g_autoset_signal = (DSO_Measurements){
+        .peak_to_peak_mv = 2000,
+        .frequency_mhz = 1000000,
+        .period_ns = 1000000,
+    };
+
+    // Act
+    scpi_inject_usb_command("OSC:AUTO;*OPC?\n");
+    run_protocol_until_response();
+    scpi_inject_usb_command("OSC:CONF:TIME?;ACQ:POIN?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert - Two periods over 2000 points, at 1 MS/s
+    TEST_ASSERT_EQUAL(2, g_autoset_probes);
+    TEST_ASSERT_EQUAL_STRING("1\r\n200;2000\r\n", scpi_get_captured_response());
+    TEST_ASSERT_EQUAL(2000, g_captured_dso_config.buffer_size);
+    TEST_ASSERT_EQUAL(1000000, g_captured_dso_config.sample_rate);
+}
+
+void test_scpi_autoset_oscilloscope_fast_signal_keeps_min_points(void)
+{
+    // Arrange - 200 kHz leaves too few points at 1 µs / div
+    setup_protocol_for_dso_test();
+    setup_autoset_mocks();
+    g_autoset_probes = 1; // Found by the first probe
+    g_autoset_signal = (DSO_Measurements){
+        .peak_to_peak_mv = 2000,
+        .frequency_mhz = 200000000,
+        .period_ns = 5000,
+    };
+
+    // Act
+    scpi_inject_usb_command("OSC:AUTO;*WAI;:OSC:CONF:TIME?;ACQ:POIN?\n");
+    run_protocol_until_response();
+
+    // Assert - 100 points at 2 MS/s
+    TEST_ASSERT_EQUAL_STRING("5;100\r\n", scpi_get_captured_response());
+}
+
+void test_scpi_autoset_oscilloscope_no_signal_restores_setup(void)
+{
+    // Arrange - A swing below the noise floor on every probe
+    setup_protocol_for_dso_test();
+    setup_autoset_mocks();
+    g_autoset_signal = (DSO_Measurements){
+        .peak_to_peak_mv = 10,
+        .frequency_mhz = 1000000,
+        .period_ns = 1000000,
+    };
+
+    // Act
+    scpi_inject_usb_command("OSC:AUTO;*OPC?\n");
+    run_protocol_until_response();
+    scpi_inject_usb_command("OSC:CONF:TIME?;ACQ:POIN?;:SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    // Assert
+    TEST_ASSERT_EQUAL(4, g_autoset_probes);
+    TEST_ASSERT_EQUAL_STRING(
+        "1\r\n100;512;-200,\"Execution error\"\r\n",
+        scpi_get_captured_response()
+    );
+}
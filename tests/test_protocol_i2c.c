@@ -0,0 +1,241 @@
+/**
+ * @file test_protocol_i2c.c
+ * @brief Unit tests for the I2C bus pass-through SCPI commands
+ *
+ * The bus is mocked; the transactions the protocol submits are captured,
+ * and their completion is simulated by setting their status and calling
+ * their callbacks.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_usb.h"
+#include "mock_i2c.h"
+#include "mock_system.h"
+#include "mock_profile.h"
+#include "scpi_test_helpers.h"
+
+#include "util/error.h"
+
+#include "application/protocol.h"
+
+// Define global variables required by scpi_test_helpers
+char g_scpi_test_captured_response[SCPI_TEST_RESPONSE_BUFFER_SIZE];
+size_t g_scpi_test_captured_response_len;
+char g_scpi_test_injected_data[SCPI_TEST_USB_BUFFER_SIZE];
+size_t g_scpi_test_injected_data_len;
+
+static USB_Handle *g_mock_usb_handle;
+static I2C_Handle *g_mock_i2c_handle;
+static I2C_Transaction *g_submitted[4];
+static uint32_t g_submitted_count;
+static uint32_t g_deinit_count;
+static uint32_t g_tick;
+
+static void
+i2c_submit_stub(I2C_Handle *handle, I2C_Transaction *transaction, int n)
+{
+    (void)handle;
+    (void)n;
+    TEST_ASSERT_LESS_THAN_UINT32(4, g_submitted_count);
+    transaction->status = I2C_STATUS_PENDING;
+    g_submitted[g_submitted_count] = transaction;
+    g_submitted_count += 1;
+}
+
+/**
+ * @brief Cancel the pending transactions, as the bus would
+ */
+static void i2c_deinit_stub(I2C_Handle *handle, int n)
+{
+    (void)handle;
+    (void)n;
+    for (uint32_t i = 0; i < g_submitted_count; i++) {
+        if (g_submitted[i]->status == I2C_STATUS_PENDING) {
+            g_submitted[i]->status = I2C_STATUS_CANCELLED;
+        }
+    }
+    g_deinit_count += 1;
+}
+
+static uint32_t system_get_tick_stub(int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    return g_tick;
+}
+
+/**
+ * @brief Complete a submitted transaction as the bus would
+ */
+static void complete(I2C_Transaction *transaction, I2C_Status status)
+{
+    transaction->status = status;
+    if (transaction->callback) {
+        transaction->callback(transaction);
+    }
+}
+
+void setUp(void)
+{
+    g_mock_usb_handle = (USB_Handle *)0x12345678; // Mock handle
+    g_mock_i2c_handle = (I2C_Handle *)0x2468ACE0; // Mock handle
+    g_submitted_count = 0;
+    g_deinit_count = 0;
+    g_tick = 0;
+    g_scpi_test_injected_data_len = 0;
+
+    scpi_clear_captured_response();
+    memset(g_scpi_test_injected_data, 0, sizeof(g_scpi_test_injected_data));
+
+    mock_usb_Init();
+    mock_i2c_Init();
+    mock_system_Init();
+
+    // Responses mark the end of the boot sequence
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
+
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    I2C_submit_Stub(i2c_submit_stub);
+    I2C_deinit_Stub(i2c_deinit_stub);
+    SYSTEM_get_tick_Stub(system_get_tick_stub);
+}
+
+void tearDown(void)
+{
+    if (protocol_is_initialized()) {
+        USB_deinit_Ignore();
+        protocol_deinit();
+    }
+
+    mock_usb_Destroy();
+    mock_i2c_Destroy();
+    mock_system_Destroy();
+}
+
+// Test: A write is queued with a copy of its bytes and returns at once
+void test_scpi_i2c_write_queued(void)
+{
+    I2C_init_ExpectAndReturn(0, g_mock_i2c_handle);
+    scpi_inject_usb_command("BUS:I2C:WRIT 80,16,1,2,255\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_UINT32(1, g_submitted_count);
+    I2C_Transaction const *const write = g_submitted[0];
+    TEST_ASSERT_EQUAL_HEX8(0x50, write->address);
+    TEST_ASSERT_FALSE(write->read);
+    TEST_ASSERT_EQUAL_HEX16(0x10, write->reg);
+    TEST_ASSERT_EQUAL_UINT8(1, write->reg_size);
+    TEST_ASSERT_EQUAL_UINT32(3, write->size);
+    TEST_ASSERT_EQUAL_HEX8(1, write->data[0]);
+    TEST_ASSERT_EQUAL_HEX8(2, write->data[1]);
+    TEST_ASSERT_EQUAL_HEX8(255, write->data[2]);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+}
+
+// Test: A read answers its bytes once the bus has completed it
+void test_scpi_i2c_read(void)
+{
+    I2C_init_ExpectAndReturn(0, g_mock_i2c_handle);
+    scpi_inject_usb_command("BUS:I2C:READ? 104,117,2\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_UINT32(1, g_submitted_count);
+    I2C_Transaction *const read = g_submitted[0];
+    TEST_ASSERT_EQUAL_HEX8(0x68, read->address);
+    TEST_ASSERT_TRUE(read->read);
+    TEST_ASSERT_EQUAL_HEX16(0x75, read->reg);
+    TEST_ASSERT_EQUAL_UINT32(2, read->size);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+
+    read->data[0] = 0x12;
+    read->data[1] = 0x34;
+    complete(read, I2C_STATUS_OK);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("18,52\r\n", scpi_get_captured_response());
+}
+
+// Test: A write that fails is reported by the next I2C command
+void test_scpi_i2c_write_failure_reported(void)
+{
+    I2C_init_ExpectAndReturn(0, g_mock_i2c_handle);
+    scpi_inject_usb_command("BUS:I2C:WRIT 80,16,1\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    complete(g_submitted[0], I2C_STATUS_NACK);
+
+    scpi_inject_usb_command("BUS:I2C:WRIT 80,17,2\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_UINT32(2, g_submitted_count);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// Test: A read the bus never completes times out and releases the bus
+void test_scpi_i2c_read_timeout(void)
+{
+    I2C_init_ExpectAndReturn(0, g_mock_i2c_handle);
+    scpi_inject_usb_command("BUS:I2C:READ? 80,0,1\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    g_tick = 1001;
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_UINT32(1, g_deinit_count);
+
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// Test: The register address takes the size set, and addresses out of
+// range are refused before the bus is touched
+void test_scpi_i2c_register_size(void)
+{
+    scpi_inject_usb_command("BUS:I2C:WRIT 128,0,1\n");
+    scpi_inject_usb_command("BUS:I2C:WRIT 80,256,1\n");
+    scpi_inject_usb_command("BUS:I2C:REG:SIZE 3\n");
+    scpi_inject_usb_command("BUS:I2C:REG:SIZE 2\n");
+    scpi_inject_usb_command("BUS:I2C:REG:SIZE?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_UINT32(0, g_submitted_count);
+    TEST_ASSERT_EQUAL_STRING("2\r\n", scpi_get_captured_response());
+
+    I2C_init_ExpectAndReturn(0, g_mock_i2c_handle);
+    scpi_inject_usb_command("BUS:I2C:WRIT 80,4660,7\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_UINT32(1, g_submitted_count);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, g_submitted[0]->reg);
+    TEST_ASSERT_EQUAL_UINT8(2, g_submitted[0]->reg_size);
+    TEST_ASSERT_EQUAL_UINT32(1, g_submitted[0]->size);
+}
+
+// Test: The clock rate set before the bus is used is applied when it is
+void test_scpi_i2c_frequency(void)
+{
+    scpi_inject_usb_command("BUS:I2C:FREQ 400000\n");
+    scpi_inject_usb_command("BUS:I2C:FREQ 2000000\n");
+    scpi_inject_usb_command("BUS:I2C:FREQ?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("400000\r\n", scpi_get_captured_response());
+
+    I2C_init_ExpectAndReturn(0, g_mock_i2c_handle);
+    I2C_set_speed_Expect(g_mock_i2c_handle, 400000);
+    scpi_inject_usb_command("BUS:I2C:WRIT 80,16,1\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_UINT32(1, g_submitted_count);
+}
@@ -0,0 +1,250 @@
+/**
+ * @file test_protocol_la.c
+ * @brief Unit tests for the logic analyzer SCPI commands
+ *
+ * The logic analyzer is mocked; captures are completed by calling the
+ * callback the protocol hands to LA_init.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_usb.h"
+#include "mock_la.h"
+#include "mock_system.h"
+#include "mock_profile.h"
+#include "scpi_test_helpers.h"
+
+#include "util/error.h"
+
+#include "application/protocol.h"
+
+// Define global variables required by scpi_test_helpers
+char g_scpi_test_captured_response[SCPI_TEST_RESPONSE_BUFFER_SIZE];
+size_t g_scpi_test_captured_response_len;
+char g_scpi_test_injected_data[SCPI_TEST_USB_BUFFER_SIZE];
+size_t g_scpi_test_injected_data_len;
+
+static USB_Handle *g_mock_usb_handle;
+static LA_Handle *g_mock_la_handle;
+static LA_Config g_la_config;
+
+/**
+ * @brief Capture the configuration the protocol initializes with
+ */
+static LA_Handle *la_init_stub(LA_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    g_la_config = *config;
+    return g_mock_la_handle;
+}
+
+static LA_Config la_get_config_stub(
+    LA_Handle const *handle,
+    int cmock_num_calls
+)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    return g_la_config;
+}
+
+void setUp(void)
+{
+    g_mock_usb_handle = (USB_Handle *)0x12345678; // Mock handle
+    g_mock_la_handle = (LA_Handle *)0x2468ACE0; // Mock handle
+    memset(&g_la_config, 0, sizeof(g_la_config));
+    g_scpi_test_injected_data_len = 0;
+
+    scpi_clear_captured_response();
+    memset(g_scpi_test_injected_data, 0, sizeof(g_scpi_test_injected_data));
+
+    mock_usb_Init();
+    mock_la_Init();
+    mock_system_Init();
+
+    // Responses mark the end of the boot sequence
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
+
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    LA_init_Stub(la_init_stub);
+    LA_get_config_Stub(la_get_config_stub);
+}
+
+void tearDown(void)
+{
+    if (protocol_is_initialized()) {
+        USB_deinit_Ignore();
+        LA_deinit_Ignore();
+        protocol_deinit();
+    }
+
+    mock_usb_Destroy();
+    mock_la_Destroy();
+    mock_system_Destroy();
+}
+
+// Test: The rate query returns the rate the timer achieved
+void test_scpi_la_srate_reports_achieved_rate(void)
+{
+    LA_is_running_IgnoreAndReturn(false);
+
+    scpi_inject_usb_command("LA:CONF:ACQ:SRAT 7000000\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_UINT32(7000000, g_la_config.sample_rate);
+
+    g_la_config.sample_rate = 6944444;
+    scpi_clear_captured_response();
+    scpi_inject_usb_command("LA:CONF:ACQ:SRAT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_STRING("6944444\r\n", scpi_get_captured_response());
+}
+
+// Test: Rates above the limit are refused without touching the analyzer
+void test_scpi_la_srate_out_of_range(void)
+{
+    scpi_inject_usb_command("LA:CONF:ACQ:SRAT 20000001\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// Test: The largest capture is the sample memory
+void test_scpi_la_points_max_query(void)
+{
+    scpi_inject_usb_command("LA:CONF:ACQ:POIN:MAX?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_STRING("32768\r\n", scpi_get_captured_response());
+}
+
+// Test: Fetching before a capture is an error
+void test_scpi_la_fetch_not_initiated(void)
+{
+    scpi_inject_usb_command("LA:FETC?\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// Test: A completed capture is fetched as one byte per sample
+void test_scpi_la_fetch_completed_capture(void)
+{
+    LA_start_Expect(g_mock_la_handle);
+    scpi_inject_usb_command("LA:CONF:ACQ 4\n");
+    scpi_inject_usb_command("LA:INIT\n");
+    LA_is_running_IgnoreAndReturn(false);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_UINT32(4, g_la_config.buffer_size);
+
+    memcpy(g_la_config.buffer, "\x01\x02\x04\x80", 4);
+    g_la_config.complete_callback();
+    LA_get_samples_acquired_ExpectAndReturn(g_mock_la_handle, 4);
+    scpi_inject_usb_command("LA:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL(9, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(
+        "#14\x01\x02\x04\x80\r\n", scpi_get_captured_response(), 9
+    );
+}
+
+// Test: The status follows the capture from running to complete
+void test_scpi_la_status_acquisition(void)
+{
+    scpi_inject_usb_command("LA:STAT:ACQ?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("0\r\n", scpi_get_captured_response());
+
+    scpi_clear_captured_response();
+    LA_start_Expect(g_mock_la_handle);
+    LA_is_running_ExpectAndReturn(g_mock_la_handle, true);
+    scpi_inject_usb_command("LA:INIT\n");
+    scpi_inject_usb_command("LA:STAT:ACQ?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("1\r\n", scpi_get_captured_response());
+
+    scpi_clear_captured_response();
+    g_la_config.complete_callback();
+    LA_is_running_ExpectAndReturn(g_mock_la_handle, false);
+    scpi_inject_usb_command("LA:STAT:ACQ?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("2\r\n", scpi_get_captured_response());
+}
+
+// Test: Run-length storage holds a run in four bytes of the sample memory
+void test_scpi_la_storage_rle(void)
+{
+    LA_is_running_IgnoreAndReturn(false);
+
+    scpi_inject_usb_command("LA:CONF:ACQ:STOR RLE\n");
+    scpi_inject_usb_command("LA:CONF:ACQ:STOR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("RLE\r\n", scpi_get_captured_response());
+    TEST_ASSERT_EQUAL(LA_STORAGE_RLE, g_la_config.storage);
+
+    scpi_clear_captured_response();
+    scpi_inject_usb_command("LA:CONF:ACQ:POIN:MAX?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("8192\r\n", scpi_get_captured_response());
+}
+
+// Test: A run-length fetch sends the runs, four bytes each
+void test_scpi_la_fetch_runs(void)
+{
+    LA_is_running_IgnoreAndReturn(false);
+    LA_start_Expect(g_mock_la_handle);
+    scpi_inject_usb_command("LA:CONF:ACQ:STOR RLE\n");
+    scpi_inject_usb_command("LA:INIT\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    memcpy(g_la_config.buffer, "\x01\x10\x00\x00\x80\x02\x00\x00", 8);
+    g_la_config.complete_callback();
+    LA_get_runs_ExpectAndReturn(g_mock_la_handle, 2);
+    scpi_inject_usb_command("LA:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL(13, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(
+        "#18\x01\x10\x00\x00\x80\x02\x00\x00\r\n",
+        scpi_get_captured_response(),
+        13
+    );
+}
+
+// Test: The trigger pattern is limited to the masked inputs
+void test_scpi_la_trigger_pattern(void)
+{
+    LA_is_running_IgnoreAndReturn(false);
+
+    scpi_inject_usb_command("LA:TRIG:PATT 3,2\n");
+    scpi_inject_usb_command("LA:TRIG:PATT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("3,2\r\n", scpi_get_captured_response());
+    TEST_ASSERT_EQUAL_HEX8(0x03, g_la_config.trigger_mask);
+    TEST_ASSERT_EQUAL_HEX8(0x02, g_la_config.trigger_pattern);
+
+    scpi_clear_captured_response();
+    scpi_inject_usb_command("LA:TRIG:PATT 1,2\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
@@ -0,0 +1,192 @@
+/**
+ * @file test_protocol_power.c
+ * @brief Unit tests for the power meter SCPI commands
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_usb.h"
+#include "mock_power.h"
+#include "mock_system.h"
+#include "mock_profile.h"
+#include "scpi_test_helpers.h"
+
+#include "util/error.h"
+#include "util/fixed_point.h"
+
+#include "application/protocol.h"
+
+// Define global variables required by scpi_test_helpers
+char g_scpi_test_captured_response[SCPI_TEST_RESPONSE_BUFFER_SIZE];
+size_t g_scpi_test_captured_response_len;
+char g_scpi_test_injected_data[SCPI_TEST_USB_BUFFER_SIZE];
+size_t g_scpi_test_injected_data_len;
+
+static USB_Handle *g_mock_usb_handle;
+static POWER_Handle *g_mock_power_handle;
+static POWER_Config g_power_config;
+
+static POWER_Handle *
+power_init_stub(POWER_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    g_power_config = *config;
+    return g_mock_power_handle;
+}
+
+/**
+ * @brief One hour at 3.3 V and 0.5 A, sampled at 1 kHz
+ */
+static void power_read_stub(
+    POWER_Handle *handle,
+    POWER_Reading *reading,
+    int cmock_num_calls
+)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    *reading = (POWER_Reading){
+        .samples = 3600000,
+        .sample_rate = 1000,
+        .voltage_mean = 3300000,
+        .voltage_rms = 3300000,
+        .current_mean = 500000,
+        .current_rms = 500000,
+        .power_mean = 1650000,
+        .energy = 1650000,
+        .charge = 500000,
+    };
+}
+
+void setUp(void)
+{
+    g_mock_usb_handle = (USB_Handle *)0x12345678; // Mock handle
+    g_mock_power_handle = (POWER_Handle *)0x2468ACE0; // Mock handle
+    memset(&g_power_config, 0, sizeof(g_power_config));
+    g_scpi_test_injected_data_len = 0;
+
+    scpi_clear_captured_response();
+    memset(g_scpi_test_injected_data, 0, sizeof(g_scpi_test_injected_data));
+
+    mock_usb_Init();
+    mock_power_Init();
+    mock_system_Init();
+
+    // Responses mark the end of the boot sequence
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
+
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    POWER_init_Stub(power_init_stub);
+    POWER_read_Stub(power_read_stub);
+}
+
+void tearDown(void)
+{
+    if (protocol_is_initialized()) {
+        USB_deinit_Ignore();
+        POWER_deinit_Ignore();
+        protocol_deinit();
+    }
+
+    mock_usb_Destroy();
+    mock_power_Destroy();
+    mock_system_Destroy();
+}
+
+// Test: The configuration and scaling set are passed to the meter
+void test_scpi_power_configure_and_initiate(void)
+{
+    scpi_inject_usb_command("POW:CONF 2,3,1000\n");
+    scpi_inject_usb_command("POW:SCAL 2000000,10000000,1500000\n");
+    scpi_inject_usb_command("POW:CONF?\n");
+    scpi_inject_usb_command("POW:SCAL?\n");
+    scpi_inject_usb_command("POW:INIT\n");
+    scpi_inject_usb_command("POW:STAT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_STRING(
+        "2,3,1000\r\n2000000,10000000,1500000\r\n1\r\n",
+        scpi_get_captured_response()
+    );
+    TEST_ASSERT_EQUAL_UINT32(2, g_power_config.voltage_channel);
+    TEST_ASSERT_EQUAL_UINT32(3, g_power_config.current_channel);
+    TEST_ASSERT_EQUAL_UINT32(1000, g_power_config.sample_rate);
+    TEST_ASSERT_EQUAL_INT32(2 * FIXED_ONE, g_power_config.voltage_gain);
+    TEST_ASSERT_EQUAL_INT32(10 * FIXED_ONE, g_power_config.current_gain);
+}
+
+// Test: The accumulated values are answered with the time they cover
+void test_scpi_power_fetch(void)
+{
+    scpi_inject_usb_command("POW:INIT\n");
+    scpi_inject_usb_command("POW:FETC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_STRING(
+        "3600000,3300000,3300000,500000,500000,1650000,1650000,500000\r\n",
+        scpi_get_captured_response()
+    );
+}
+
+// Test: The configuration is refused while the meter runs
+void test_scpi_power_configure_while_running(void)
+{
+    scpi_inject_usb_command("POW:INIT\n");
+    scpi_inject_usb_command("POW:CONF 2,3\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+
+    scpi_clear_captured_response();
+    POWER_deinit_Expect(g_mock_power_handle);
+    scpi_inject_usb_command("POW:ABOR\n");
+    scpi_inject_usb_command("POW:CONF 2,3\n");
+    scpi_inject_usb_command("POW:CONF?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("2,3,10000\r\n", scpi_get_captured_response());
+}
+
+// Test: Fetching and clearing need a running meter
+void test_scpi_power_fetch_stopped(void)
+{
+    scpi_inject_usb_command("POW:FETC?\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+
+    scpi_clear_captured_response();
+    scpi_inject_usb_command("POW:CLE\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// Test: A busy ADC is an execution error
+void test_scpi_power_initiate_busy(void)
+{
+    POWER_init_Stub(NULL);
+    POWER_init_ExpectAnyArgsAndThrow(ERROR_RESOURCE_BUSY);
+    scpi_inject_usb_command("POW:INIT\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_inject_usb_command("POW:STAT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING(
+        "-200,\"Execution error\"\r\n0\r\n", scpi_get_captured_response()
+    );
+}
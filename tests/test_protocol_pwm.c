@@ -0,0 +1,193 @@
+/**
+ * @file test_protocol_pwm.c
+ * @brief Unit tests for the PWM generator SCPI commands
+ *
+ * The generator is mocked; the configuration the protocol initializes it
+ * with, and the pulses it changes while running, are captured and checked.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_usb.h"
+#include "mock_pwm.h"
+#include "mock_system.h"
+#include "mock_profile.h"
+#include "scpi_test_helpers.h"
+
+#include "util/error.h"
+
+#include "application/protocol.h"
+
+// Define global variables required by scpi_test_helpers
+char g_scpi_test_captured_response[SCPI_TEST_RESPONSE_BUFFER_SIZE];
+size_t g_scpi_test_captured_response_len;
+char g_scpi_test_injected_data[SCPI_TEST_USB_BUFFER_SIZE];
+size_t g_scpi_test_injected_data_len;
+
+static USB_Handle *g_mock_usb_handle;
+static PWM_Handle *g_mock_pwm_handle;
+static PWM_Config g_pwm_config;
+static uint32_t g_channel_index;
+static PWM_Channel g_channel;
+
+/**
+ * @brief Capture the configuration the protocol initializes with
+ */
+static PWM_Handle *
+pwm_init_stub(PWM_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    g_pwm_config = *config;
+    return g_mock_pwm_handle;
+}
+
+/**
+ * @brief Report a frequency 1 Hz off the requested one
+ */
+static PWM_Config
+pwm_get_config_stub(PWM_Handle const *handle, int cmock_num_calls)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    PWM_Config config = g_pwm_config;
+    config.frequency -= 1;
+    return config;
+}
+
+static void pwm_set_channel_stub(
+    PWM_Handle *handle,
+    uint32_t index,
+    PWM_Channel const *channel,
+    int cmock_num_calls
+)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    g_channel_index = index;
+    g_channel = *channel;
+}
+
+void setUp(void)
+{
+    g_mock_usb_handle = (USB_Handle *)0x12345678; // Mock handle
+    g_mock_pwm_handle = (PWM_Handle *)0x1F2E3D4C; // Mock handle
+    memset(&g_pwm_config, 0, sizeof(g_pwm_config));
+    memset(&g_channel, 0, sizeof(g_channel));
+    g_channel_index = UINT32_MAX;
+    g_scpi_test_injected_data_len = 0;
+
+    scpi_clear_captured_response();
+    memset(g_scpi_test_injected_data, 0, sizeof(g_scpi_test_injected_data));
+
+    mock_usb_Init();
+    mock_pwm_Init();
+    mock_system_Init();
+
+    // Responses mark the end of the boot sequence
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
+
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    PWM_init_Stub(pwm_init_stub);
+    PWM_get_config_Stub(pwm_get_config_stub);
+    PWM_set_channel_Stub(pwm_set_channel_stub);
+}
+
+void tearDown(void)
+{
+    if (protocol_is_initialized()) {
+        USB_deinit_Ignore();
+        PWM_deinit_Ignore();
+        protocol_deinit();
+    }
+
+    mock_usb_Destroy();
+    mock_pwm_Destroy();
+    mock_system_Destroy();
+}
+
+// Test: Settings are kept while the output is off
+void test_scpi_pwm_settings_without_output(void)
+{
+    scpi_inject_usb_command("PWM:FREQ 20000\n");
+    scpi_inject_usb_command("PWM:DUTY 2,250000\n");
+    scpi_inject_usb_command("PWM:PHAS 2,500000\n");
+    scpi_inject_usb_command("PWM:ENAB 1,OFF\n");
+    scpi_inject_usb_command("PWM:FREQ?;DUTY? 2;PHAS? 2;ENAB? 1;OUTP?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_STRING(
+        "20000;250000;500000;0;0\r\n", scpi_get_captured_response()
+    );
+}
+
+// Test: Switching the output on runs the settings, and the query returns
+// the frequency achieved
+void test_scpi_pwm_output_on(void)
+{
+    PWM_start_Expect(g_mock_pwm_handle);
+    scpi_inject_usb_command("PWM:FREQ 3000\n");
+    scpi_inject_usb_command("PWM:PHAS 2,250000\n");
+    scpi_inject_usb_command("PWM:OUTP ON\n");
+    scpi_inject_usb_command("PWM:OUTP?;FREQ?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_UINT32(3000, g_pwm_config.frequency);
+    TEST_ASSERT_EQUAL_UINT32(250000, g_pwm_config.channels[1].phase);
+    TEST_ASSERT_EQUAL_UINT32(500000, g_pwm_config.channels[0].duty);
+    TEST_ASSERT_EQUAL_STRING("1;2999\r\n", scpi_get_captured_response());
+}
+
+// Test: A pulse changed while on is loaded without a restart
+void test_scpi_pwm_duty_while_on(void)
+{
+    PWM_start_Expect(g_mock_pwm_handle);
+    scpi_inject_usb_command("PWM:OUTP ON\n");
+    scpi_inject_usb_command("PWM:DUTY 1,100000\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_UINT32(0, g_channel_index);
+    TEST_ASSERT_EQUAL_UINT32(100000, g_channel.duty);
+    TEST_ASSERT_TRUE(g_channel.enabled);
+
+    // A new frequency restarts the generator
+    PWM_deinit_Expect(g_mock_pwm_handle);
+    PWM_start_Expect(g_mock_pwm_handle);
+    scpi_inject_usb_command("PWM:FREQ 5000\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_UINT32(5000, g_pwm_config.frequency);
+    TEST_ASSERT_EQUAL_UINT32(100000, g_pwm_config.channels[0].duty);
+}
+
+// Test: Channels and values out of range are refused
+void test_scpi_pwm_out_of_range(void)
+{
+    scpi_inject_usb_command("PWM:DUTY 3,100\n");
+    scpi_inject_usb_command("PWM:DUTY 1,1000001\n");
+    scpi_inject_usb_command("PWM:PHAS 1,1000000\n");
+    scpi_inject_usb_command("PWM:FREQ 0\n");
+    scpi_inject_usb_command("PWM:DUTY? 1;PHAS? 1;FREQ?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_STRING("500000;0;1000\r\n", scpi_get_captured_response());
+
+    scpi_clear_captured_response();
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
@@ -0,0 +1,183 @@
+/**
+ * @file test_protocol_sequence.c
+ * @brief Unit tests for the sequence engine SCPI commands
+ *
+ * The programs run IEEE 488.2 commands of the protocol itself, so that no
+ * instrument needs mocking.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_usb.h"
+#include "mock_system.h"
+#include "mock_profile.h"
+#include "scpi_test_helpers.h"
+
+#include "util/error.h"
+
+#include "application/protocol.h"
+
+// Define global variables required by scpi_test_helpers
+char g_scpi_test_captured_response[SCPI_TEST_RESPONSE_BUFFER_SIZE];
+size_t g_scpi_test_captured_response_len;
+char g_scpi_test_injected_data[SCPI_TEST_USB_BUFFER_SIZE];
+size_t g_scpi_test_injected_data_len;
+
+static USB_Handle *g_mock_usb_handle;
+
+/**
+ * @brief Inject SEQuence:DEFine with the program as its block
+ */
+static void define_program(char const *program)
+{
+    char command[SCPI_TEST_USB_BUFFER_SIZE];
+    size_t const length = strlen(program);
+
+    (void)snprintf(
+        command, sizeof(command), "SEQ:DEF #3%03zu%s\n", length, program
+    );
+    scpi_inject_usb_command(command);
+}
+
+void setUp(void)
+{
+    g_mock_usb_handle = (USB_Handle *)0x12345678; // Mock handle
+    g_scpi_test_injected_data_len = 0;
+
+    scpi_clear_captured_response();
+    memset(g_scpi_test_injected_data, 0, sizeof(g_scpi_test_injected_data));
+
+    mock_usb_Init();
+    mock_system_Init();
+
+    // Responses mark the end of the boot sequence
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
+
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+}
+
+void tearDown(void)
+{
+    if (protocol_is_initialized()) {
+        USB_deinit_Ignore();
+        protocol_deinit();
+    }
+
+    mock_usb_Destroy();
+    mock_system_Destroy();
+}
+
+// Test: The responses of a program go to the result table, not the host
+void test_scpi_sequence_run(void)
+{
+    define_program("*ESE 5\n*ESE?\n\n*ESE?\n");
+    scpi_inject_usb_command("SEQ:RUN\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("", scpi_get_captured_response());
+
+    scpi_inject_usb_command("SEQ:STAT?\n");
+    scpi_inject_usb_command("SEQ:RES?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING(
+        "DONE\r\n#2202,NONE,5\r\n4,NONE,5\r\n\r\n", scpi_get_captured_response()
+    );
+}
+
+// Test: Limit checks set the verdict of the response before
+void test_scpi_sequence_limit(void)
+{
+    define_program("*ESE 5\n*ESE?\nSEQ:LIM 0,10\n*ESE?\nSEQ:LIM 6,10\n");
+    scpi_inject_usb_command("SEQ:RUN\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    scpi_inject_usb_command("SEQ:FAIL?\n");
+    scpi_inject_usb_command("SEQ:RES?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING(
+        "1\r\n#2202,PASS,5\r\n4,FAIL,5\r\n\r\n", scpi_get_captured_response()
+    );
+}
+
+// Test: A failing line stops the program at that line
+void test_scpi_sequence_error(void)
+{
+    define_program("*ESE 0\n*ESE?\nBOGUS\n*ESE?\n");
+    scpi_inject_usb_command("SEQ:RUN\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    scpi_inject_usb_command("SEQ:STAT?;LINE?\n");
+    scpi_inject_usb_command("SEQ:RES?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING(
+        "ERR;3\r\n#2102,NONE,0\r\n\r\n", scpi_get_captured_response()
+    );
+}
+
+// Test: A delay holds the next line until it is over
+void test_scpi_sequence_wait(void)
+{
+    SYSTEM_get_tick_IgnoreAndReturn(1000);
+    define_program("SEQ:WAIT 100\n*ESE?\n");
+    scpi_inject_usb_command("SEQ:RUN\n");
+    scpi_inject_usb_command("SEQ:STAT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("RUN\r\n", scpi_get_captured_response());
+
+    scpi_clear_captured_response();
+    SYSTEM_get_tick_IgnoreAndReturn(1100);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    scpi_inject_usb_command("SEQ:STAT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("DONE\r\n", scpi_get_captured_response());
+}
+
+// Test: Sequence steps are refused outside of a program
+void test_scpi_sequence_steps_outside_program(void)
+{
+    scpi_inject_usb_command("SEQ:WAIT 10\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_inject_usb_command("SEQ:LIM 0,1\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING(
+        "-200,\"Execution error\"\r\n-200,\"Execution error\"\r\n",
+        scpi_get_captured_response()
+    );
+}
+
+// Test: Running needs a program, and a reset stops a running one
+void test_scpi_sequence_run_and_reset(void)
+{
+    scpi_inject_usb_command("SEQ:DEF #10\n");
+    scpi_inject_usb_command("SEQ:RUN\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+
+    scpi_clear_captured_response();
+    SYSTEM_get_tick_IgnoreAndReturn(0);
+    define_program("SEQ:WAIT 1000\n*ESE?\n");
+    scpi_inject_usb_command("SEQ:RUN\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    scpi_inject_usb_command("*RST\n");
+    scpi_inject_usb_command("SEQ:STAT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("IDLE\r\n", scpi_get_captured_response());
+}
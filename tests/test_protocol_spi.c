@@ -0,0 +1,255 @@
+/**
+ * @file test_protocol_spi.c
+ * @brief Unit tests for the SPI bus pass-through SCPI commands
+ *
+ * The bus is mocked; the transactions the protocol submits are captured,
+ * and their completion is simulated by setting their status and calling
+ * their callbacks.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_usb.h"
+#include "mock_spi.h"
+#include "mock_system.h"
+#include "mock_profile.h"
+#include "scpi_test_helpers.h"
+
+#include "util/error.h"
+
+#include "application/protocol.h"
+
+// Define global variables required by scpi_test_helpers
+char g_scpi_test_captured_response[SCPI_TEST_RESPONSE_BUFFER_SIZE];
+size_t g_scpi_test_captured_response_len;
+char g_scpi_test_injected_data[SCPI_TEST_USB_BUFFER_SIZE];
+size_t g_scpi_test_injected_data_len;
+
+static USB_Handle *g_mock_usb_handle;
+static SPI_Handle *g_mock_spi_handle;
+static SPI_Transaction *g_submitted[4];
+static uint32_t g_submitted_count;
+static uint32_t g_deinit_count;
+static uint32_t g_tick;
+static SPI_Config g_bus_config; // Settings the bus reports
+
+static void
+spi_submit_stub(SPI_Handle *handle, SPI_Transaction *transaction, int n)
+{
+    (void)handle;
+    (void)n;
+    TEST_ASSERT_LESS_THAN_UINT32(4, g_submitted_count);
+    transaction->status = SPI_STATUS_PENDING;
+    g_submitted[g_submitted_count] = transaction;
+    g_submitted_count += 1;
+}
+
+/**
+ * @brief Cancel the pending transactions, as the bus would
+ */
+static void spi_deinit_stub(SPI_Handle *handle, int n)
+{
+    (void)handle;
+    (void)n;
+    for (uint32_t i = 0; i < g_submitted_count; i++) {
+        if (g_submitted[i]->status == SPI_STATUS_PENDING) {
+            g_submitted[i]->status = SPI_STATUS_CANCELLED;
+        }
+    }
+    g_deinit_count += 1;
+}
+
+static void
+spi_get_config_stub(SPI_Handle const *handle, SPI_Config *config, int n)
+{
+    (void)handle;
+    (void)n;
+    *config = g_bus_config;
+}
+
+static uint32_t system_get_tick_stub(int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    return g_tick;
+}
+
+/**
+ * @brief Complete a submitted transaction as the bus would
+ */
+static void complete(SPI_Transaction *transaction, SPI_Status status)
+{
+    transaction->status = status;
+    if (transaction->callback) {
+        transaction->callback(transaction);
+    }
+}
+
+void setUp(void)
+{
+    g_mock_usb_handle = (USB_Handle *)0x12345678; // Mock handle
+    g_mock_spi_handle = (SPI_Handle *)0x2468ACE0; // Mock handle
+    g_submitted_count = 0;
+    g_deinit_count = 0;
+    g_tick = 0;
+    g_bus_config = (SPI_Config){
+        .speed = 976562,
+        .mode = SPI_MODE_0,
+        .lsb_first = false,
+    };
+    g_scpi_test_injected_data_len = 0;
+
+    scpi_clear_captured_response();
+    memset(g_scpi_test_injected_data, 0, sizeof(g_scpi_test_injected_data));
+
+    mock_usb_Init();
+    mock_spi_Init();
+    mock_system_Init();
+
+    // Responses mark the end of the boot sequence
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
+
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    SPI_submit_Stub(spi_submit_stub);
+    SPI_deinit_Stub(spi_deinit_stub);
+    SPI_get_config_Stub(spi_get_config_stub);
+    SYSTEM_get_tick_Stub(system_get_tick_stub);
+}
+
+void tearDown(void)
+{
+    if (protocol_is_initialized()) {
+        USB_deinit_Ignore();
+        protocol_deinit();
+    }
+
+    mock_usb_Destroy();
+    mock_spi_Destroy();
+    mock_system_Destroy();
+}
+
+// Test: A transfer sends its block and answers the bytes received as a
+// block once the bus has completed it
+void test_scpi_spi_transfer(void)
+{
+    SPI_init_ExpectAndReturn(0, g_mock_spi_handle);
+    scpi_inject_usb_command("BUS:SPI:TRAN? #14\x9F\x01\x02\x03\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_UINT32(1, g_submitted_count);
+    SPI_Transaction *const transfer = g_submitted[0];
+    TEST_ASSERT_EQUAL_UINT32(4, transfer->size);
+    TEST_ASSERT_FALSE(transfer->hold_cs);
+    TEST_ASSERT_EQUAL_MEMORY("\x9F\x01\x02\x03", transfer->tx, 4);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+
+    uint8_t const reply[4] = { 0xFF, 0xEF, 0x40, 0x18 };
+    memcpy(transfer->rx, reply, sizeof(reply));
+    complete(transfer, SPI_STATUS_OK);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL(8, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(
+        "#14\xFF\xEF\x40\x18\r\n", scpi_get_captured_response(), 8
+    );
+}
+
+// Test: A transfer can keep the chip select low for the next one
+void test_scpi_spi_transfer_hold(void)
+{
+    SPI_init_ExpectAndReturn(0, g_mock_spi_handle);
+    scpi_inject_usb_command("BUS:SPI:TRAN? #12\x02\x10,ON\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_UINT32(1, g_submitted_count);
+    TEST_ASSERT_TRUE(g_submitted[0]->hold_cs);
+    TEST_ASSERT_EQUAL_UINT32(2, g_submitted[0]->size);
+}
+
+// Test: A transfer that fails answers an error instead of its bytes
+void test_scpi_spi_transfer_failure(void)
+{
+    SPI_init_ExpectAndReturn(0, g_mock_spi_handle);
+    scpi_inject_usb_command("BUS:SPI:TRAN? #11\x05\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    complete(g_submitted[0], SPI_STATUS_DMA_ERROR);
+
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// Test: A transfer the bus never completes times out and releases the bus
+void test_scpi_spi_transfer_timeout(void)
+{
+    SPI_init_ExpectAndReturn(0, g_mock_spi_handle);
+    scpi_inject_usb_command("BUS:SPI:TRAN? #11\x05\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    g_tick = 101;
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_UINT32(1, g_deinit_count);
+
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// Test: Settings made before the bus is used are applied when it is, and
+// the clock rate reached is answered from then on
+void test_scpi_spi_settings(void)
+{
+    scpi_inject_usb_command("BUS:SPI:FREQ 20000000\n");
+    scpi_inject_usb_command("BUS:SPI:FREQ 100000000\n");
+    scpi_inject_usb_command("BUS:SPI:MODE 3\n");
+    scpi_inject_usb_command("BUS:SPI:MODE 4\n");
+    scpi_inject_usb_command("BUS:SPI:ORD LSB\n");
+    scpi_inject_usb_command("BUS:SPI:FREQ?;MODE?;ORD?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING(
+        "20000000;3;LSB\r\n", scpi_get_captured_response()
+    );
+
+    g_bus_config = (SPI_Config){
+        .speed = 15625000,
+        .mode = SPI_MODE_3,
+        .lsb_first = true,
+    };
+    SPI_init_ExpectAndReturn(0, g_mock_spi_handle);
+    SPI_configure_ExpectAnyArgsAndReturn(15625000);
+    scpi_inject_usb_command("BUS:SPI:TRAN? #11\x05\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_UINT32(1, g_submitted_count);
+
+    complete(g_submitted[0], SPI_STATUS_OK);
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    scpi_clear_captured_response();
+    scpi_inject_usb_command("BUS:SPI:FREQ?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("15625000\r\n", scpi_get_captured_response());
+}
+
+// Test: An empty block is refused before the bus is touched
+void test_scpi_spi_transfer_empty(void)
+{
+    scpi_inject_usb_command("BUS:SPI:TRAN? #10\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_UINT32(0, g_submitted_count);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
@@ -0,0 +1,203 @@
+/**
+ * @file test_protocol_sweep.c
+ * @brief Unit tests for the frequency response sweep SCPI commands
+ *
+ * The sweep is mocked; its status and points are set by the tests.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_usb.h"
+#include "mock_sweep.h"
+#include "mock_system.h"
+#include "mock_profile.h"
+#include "scpi_test_helpers.h"
+
+#include "util/error.h"
+#include "util/fixed_point.h"
+
+#include "application/protocol.h"
+
+// Define global variables required by scpi_test_helpers
+char g_scpi_test_captured_response[SCPI_TEST_RESPONSE_BUFFER_SIZE];
+size_t g_scpi_test_captured_response_len;
+char g_scpi_test_injected_data[SCPI_TEST_USB_BUFFER_SIZE];
+size_t g_scpi_test_injected_data_len;
+
+static USB_Handle *g_mock_usb_handle;
+static SWEEP_Status g_status; // Status the sweep reports
+static SWEEP_Config g_started; // Settings of the last start
+static SWEEP_Point g_points[2]; // Points the sweep reports
+static uint32_t g_point_count;
+
+static void get_status_stub(SWEEP_Status *status, int n)
+{
+    (void)n;
+    *status = g_status;
+}
+
+static void start_stub(SWEEP_Config const *config, int n)
+{
+    (void)n;
+    g_started = *config;
+    g_status = (SWEEP_Status){
+        .state = SWEEP_STATE_RUNNING,
+        .points = config->points,
+        .completed = 0,
+    };
+}
+
+static void start_busy_stub(SWEEP_Config const *config, int n)
+{
+    (void)config;
+    (void)n;
+    THROW(ERROR_RESOURCE_BUSY);
+}
+
+static SWEEP_Point const *get_points_stub(uint32_t *count, int n)
+{
+    (void)n;
+    *count = g_point_count;
+    return g_points;
+}
+
+void setUp(void)
+{
+    g_mock_usb_handle = (USB_Handle *)0x12345678; // Mock handle
+    g_status = (SWEEP_Status){ .state = SWEEP_STATE_IDLE };
+    memset(&g_started, 0, sizeof(g_started));
+    memset(g_points, 0, sizeof(g_points));
+    g_point_count = 0;
+    g_scpi_test_injected_data_len = 0;
+
+    scpi_clear_captured_response();
+    memset(g_scpi_test_injected_data, 0, sizeof(g_scpi_test_injected_data));
+
+    mock_usb_Init();
+    mock_sweep_Init();
+    mock_system_Init();
+
+    // Responses mark the end of the boot sequence
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
+
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    SWEEP_get_status_Stub(get_status_stub);
+    SWEEP_start_Stub(start_stub);
+    SWEEP_get_points_Stub(get_points_stub);
+    SYSTEM_get_tick_IgnoreAndReturn(0);
+}
+
+void tearDown(void)
+{
+    if (protocol_is_initialized()) {
+        USB_deinit_Ignore();
+        SWEEP_stop_Ignore();
+        protocol_deinit();
+    }
+
+    mock_usb_Destroy();
+    mock_sweep_Destroy();
+    mock_system_Destroy();
+}
+
+// Test: A start runs with the settings made before it
+void test_scpi_sweep_settings(void)
+{
+    scpi_inject_usb_command("SWE:FREQ 20000,10\n");
+    scpi_inject_usb_command("SWE:POIN 50;SPAC LIN;SETT 5;CYCL 8\n");
+    scpi_inject_usb_command("SWE:VOLT 500,1000\n");
+    scpi_inject_usb_command("SWE:FREQ?;POIN?;SPAC?;VOLT?;SETT?;CYCL?\n");
+    scpi_inject_usb_command("SWE:INIT\n");
+    scpi_inject_usb_command("SWE:STAT?;COUN?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_STRING(
+        "20000,10;50;LIN;500,1000;5;8\r\nRUN;0,50\r\n",
+        scpi_get_captured_response()
+    );
+    TEST_ASSERT_EQUAL_UINT32(20000, g_started.start);
+    TEST_ASSERT_EQUAL_UINT32(10, g_started.stop);
+    TEST_ASSERT_EQUAL_UINT32(50, g_started.points);
+    TEST_ASSERT_FALSE(g_started.logarithmic);
+    TEST_ASSERT_EQUAL_INT32(FIXED_FROM_FLOAT(0.5), g_started.amplitude);
+    TEST_ASSERT_EQUAL_INT32(FIXED_FROM_FLOAT(1.0), g_started.offset);
+    TEST_ASSERT_EQUAL_UINT32(5, g_started.settle);
+    TEST_ASSERT_EQUAL_UINT32(8, g_started.cycles);
+}
+
+// Test: Settings out of range are refused and the previous ones kept
+void test_scpi_sweep_settings_invalid(void)
+{
+    scpi_inject_usb_command("SWE:FREQ 0,100\n");
+    scpi_inject_usb_command("SWE:FREQ 100,62501\n");
+    scpi_inject_usb_command("SWE:POIN 257\n");
+    scpi_inject_usb_command("SWE:CYCL 0\n");
+    scpi_inject_usb_command("SWE:VOLT 3301,0\n");
+    scpi_inject_usb_command("SWE:FREQ?;POIN?;CYCL?;VOLT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_STRING(
+        "100,10000;21;4;1000,1650\r\n", scpi_get_captured_response()
+    );
+}
+
+// Test: *OPC? waits for the sweep to end
+void test_scpi_sweep_opc(void)
+{
+    scpi_inject_usb_command("SWE:INIT;*OPC?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL(0, g_scpi_test_captured_response_len);
+
+    g_status.state = SWEEP_STATE_DONE;
+    g_status.completed = g_status.points;
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("1\r\n", scpi_get_captured_response());
+}
+
+// Test: The points are answered as a block of 12 bytes each
+void test_scpi_sweep_data(void)
+{
+    g_points[0] = (SWEEP_Point){
+        .frequency = 0x04030201,
+        .gain_cdb = -602,
+        .phase_cdeg = 0x0C0B0A09,
+    };
+    g_point_count = 1;
+    scpi_inject_usb_command("SWE:DATA?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL(18, g_scpi_test_captured_response_len);
+    TEST_ASSERT_EQUAL_MEMORY(
+        "#212\x01\x02\x03\x04\xA6\xFD\xFF\xFF\x09\x0A\x0B\x0C\r\n",
+        scpi_get_captured_response(),
+        18
+    );
+}
+
+// Test: A start the sweep refuses is an execution error
+void test_scpi_sweep_initiate_busy(void)
+{
+    SWEEP_start_Stub(start_busy_stub);
+    scpi_inject_usb_command("SWE:INIT\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_inject_usb_command("SWE:STAT?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING(
+        "-200,\"Execution error\"\r\nIDLE\r\n", scpi_get_captured_response()
+    );
+}
@@ -0,0 +1,189 @@
+/**
+ * @file test_protocol_sync.c
+ * @brief Unit tests for the synchronized instrument start SCPI commands
+ *
+ * The synchronized start is mocked; the calls the commands make on it are
+ * checked.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_usb.h"
+#include "mock_sync.h"
+#include "mock_system.h"
+#include "mock_profile.h"
+#include "scpi_test_helpers.h"
+
+#include "util/error.h"
+
+#include "application/protocol.h"
+
+// Define global variables required by scpi_test_helpers
+char g_scpi_test_captured_response[SCPI_TEST_RESPONSE_BUFFER_SIZE];
+size_t g_scpi_test_captured_response_len;
+char g_scpi_test_injected_data[SCPI_TEST_USB_BUFFER_SIZE];
+size_t g_scpi_test_injected_data_len;
+
+static USB_Handle *g_mock_usb_handle;
+
+void setUp(void)
+{
+    g_mock_usb_handle = (USB_Handle *)0x12345678; // Mock handle
+    g_scpi_test_injected_data_len = 0;
+
+    scpi_clear_captured_response();
+    memset(g_scpi_test_injected_data, 0, sizeof(g_scpi_test_injected_data));
+
+    mock_usb_Init();
+    mock_sync_Init();
+    mock_system_Init();
+
+    // Responses mark the end of the boot sequence
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
+
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+}
+
+void tearDown(void)
+{
+    if (protocol_is_initialized()) {
+        USB_deinit_Ignore();
+        SYNC_cancel_Ignore();
+        protocol_deinit();
+    }
+
+    mock_usb_Destroy();
+    mock_sync_Verify();
+    mock_sync_Destroy();
+    mock_system_Destroy();
+}
+
+// Test: Arming holds the starts, and INITiate:ALL releases them
+void test_scpi_initiate_all(void)
+{
+    SYNC_arm_Expect();
+    scpi_inject_usb_command("INIT:ALL:ARM\n");
+    scpi_inject_usb_command("INIT:ALL:ARM?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("1\r\n", scpi_get_captured_response());
+
+    scpi_clear_captured_response();
+    SYNC_start_ExpectAndReturn(2);
+    scpi_inject_usb_command("INIT:ALL\n");
+    scpi_inject_usb_command("INIT:ALL:ARM?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("0\r\n", scpi_get_captured_response());
+}
+
+// Test: Arming off drops the held starts
+void test_scpi_initiate_all_arm_off(void)
+{
+    SYNC_arm_Expect();
+    SYNC_cancel_Expect();
+    scpi_inject_usb_command("INIT:ALL:ARM ON\n");
+    scpi_inject_usb_command("INIT:ALL:ARM OFF\n");
+    scpi_inject_usb_command("INIT:ALL:ARM?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("0\r\n", scpi_get_captured_response());
+}
+
+// Test: A reset drops an armed start
+void test_scpi_initiate_all_reset(void)
+{
+    SYNC_arm_Expect();
+    SYNC_cancel_Expect();
+    scpi_inject_usb_command("INIT:ALL:ARM\n");
+    scpi_inject_usb_command("*RST\n");
+    scpi_inject_usb_command("INIT:ALL:ARM?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("0\r\n", scpi_get_captured_response());
+}
+
+// Test: Starting without arming is an error
+void test_scpi_initiate_all_not_armed(void)
+{
+    scpi_inject_usb_command("INIT:ALL\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// Test: With the external source, starts stay held until the edge
+void test_scpi_initiate_all_source_external(void)
+{
+    SYNC_set_source_Expect(SYNC_SOURCE_EXTERNAL);
+    SYNC_set_trigger_output_Expect(true);
+    SYNC_arm_Expect();
+    SYNC_start_ExpectAndReturn(1);
+    SYNC_is_armed_ExpectAndReturn(true);
+    scpi_inject_usb_command("INIT:ALL:SOUR EXT\n");
+    scpi_inject_usb_command("INIT:ALL:OUTP ON\n");
+    scpi_inject_usb_command("INIT:ALL:ARM\n");
+    scpi_inject_usb_command("INIT:ALL\n");
+    scpi_inject_usb_command("INIT:ALL:ARM?\n");
+    scpi_inject_usb_command("INIT:ALL:SOUR?\n");
+    scpi_inject_usb_command("INIT:ALL:OUTP?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("1\r\nEXT\r\n1\r\n", scpi_get_captured_response());
+
+    // A reset drops a start waiting for its edge, restores the immediate
+    // start and releases the output
+    scpi_clear_captured_response();
+    SYNC_cancel_Expect();
+    SYNC_set_source_Expect(SYNC_SOURCE_IMMEDIATE);
+    SYNC_set_trigger_output_Expect(false);
+    scpi_inject_usb_command("*RST\n");
+    scpi_inject_usb_command("INIT:ALL:SOUR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("IMM\r\n", scpi_get_captured_response());
+}
+
+// Test: With the oscilloscope source, starts wait for its trigger
+void test_scpi_initiate_all_source_oscilloscope(void)
+{
+    SYNC_set_source_Expect(SYNC_SOURCE_OSCILLOSCOPE);
+    SYNC_arm_Expect();
+    SYNC_start_ExpectAndReturn(1);
+    SYNC_is_armed_ExpectAndReturn(true);
+    scpi_inject_usb_command("INIT:ALL:SOUR OSC\n");
+    scpi_inject_usb_command("INIT:ALL:ARM\n");
+    scpi_inject_usb_command("INIT:ALL\n");
+    scpi_inject_usb_command("INIT:ALL:ARM?\n");
+    scpi_inject_usb_command("INIT:ALL:SOUR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("1\r\nOSC\r\n", scpi_get_captured_response());
+
+    scpi_clear_captured_response();
+    SYNC_cancel_Expect();
+    SYNC_set_source_Expect(SYNC_SOURCE_IMMEDIATE);
+    scpi_inject_usb_command("*RST\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+}
+
+// Test: Trigger settings refused while armed are errors
+void test_scpi_initiate_all_source_while_armed(void)
+{
+    SYNC_set_source_ExpectAndThrow(
+        SYNC_SOURCE_EXTERNAL,
+        ERROR_RESOURCE_BUSY
+    );
+    scpi_inject_usb_command("INIT:ALL:SOUR EXT\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
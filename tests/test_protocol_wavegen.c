@@ -0,0 +1,275 @@
+/**
+ * @file test_protocol_wavegen.c
+ * @brief Unit tests for the waveform generator SCPI commands
+ *
+ * The generator is mocked; the configuration the protocol initializes it
+ * with is captured and checked.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_usb.h"
+#include "mock_wavegen.h"
+#include "mock_system.h"
+#include "mock_profile.h"
+#include "scpi_test_helpers.h"
+
+#include "util/error.h"
+#include "util/fixed_point.h"
+
+#include "application/protocol.h"
+
+// Define global variables required by scpi_test_helpers
+char g_scpi_test_captured_response[SCPI_TEST_RESPONSE_BUFFER_SIZE];
+size_t g_scpi_test_captured_response_len;
+char g_scpi_test_injected_data[SCPI_TEST_USB_BUFFER_SIZE];
+size_t g_scpi_test_injected_data_len;
+
+static USB_Handle *g_mock_usb_handle;
+static WAVEGEN_Handle *g_mock_wavegen_handle;
+static WAVEGEN_Config g_wavegen_config;
+static uint16_t g_wavegen_samples[8];
+static uint32_t g_achieved_frequency; // 0 to achieve the requested one
+
+/**
+ * @brief Capture the configuration the protocol initializes with
+ */
+static WAVEGEN_Handle *
+wavegen_init_stub(WAVEGEN_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    g_wavegen_config = *config;
+    if (config->shape == WAVEGEN_SHAPE_ARBITRARY) {
+        memcpy(
+            g_wavegen_samples,
+            config->samples,
+            sizeof(uint16_t) * config->sample_count
+        );
+    }
+    return g_mock_wavegen_handle;
+}
+
+static WAVEGEN_Config wavegen_get_config_stub(
+    WAVEGEN_Handle const *handle,
+    int cmock_num_calls
+)
+{
+    (void)handle;
+    (void)cmock_num_calls;
+    WAVEGEN_Config config = g_wavegen_config;
+    if (g_achieved_frequency != 0) {
+        config.frequency = g_achieved_frequency;
+    }
+    return config;
+}
+
+static WAVEGEN_Handle *
+wavegen_init_refuse_stub(WAVEGEN_Config const *config, int cmock_num_calls)
+{
+    (void)config;
+    (void)cmock_num_calls;
+    THROW(ERROR_INVALID_ARGUMENT);
+    return NULL;
+}
+
+void setUp(void)
+{
+    g_mock_usb_handle = (USB_Handle *)0x12345678; // Mock handle
+    g_mock_wavegen_handle = (WAVEGEN_Handle *)0x2468ACE0; // Mock handle
+    memset(&g_wavegen_config, 0, sizeof(g_wavegen_config));
+    memset(g_wavegen_samples, 0, sizeof(g_wavegen_samples));
+    g_achieved_frequency = 0;
+    g_scpi_test_injected_data_len = 0;
+
+    scpi_clear_captured_response();
+    memset(g_scpi_test_injected_data, 0, sizeof(g_scpi_test_injected_data));
+
+    mock_usb_Init();
+    mock_wavegen_Init();
+    mock_system_Init();
+
+    // Responses mark the end of the boot sequence
+    PROFILE_boot_mark_Ignore();
+    // Command handlers are timed
+    PROFILE_begin_IgnoreAndReturn(0);
+    PROFILE_record_Ignore();
+
+    USB_init_ExpectAndReturn(0, NULL, NULL, g_mock_usb_handle);
+    USB_init_IgnoreArg_rx_buffer();
+    USB_init_IgnoreArg_tx_buffer();
+    USB_set_rx_callback_Ignore();
+    USB_set_event_driven_Ignore();
+    USB_flush_Ignore();
+    protocol_init();
+
+    WAVEGEN_init_Stub(wavegen_init_stub);
+    WAVEGEN_get_config_Stub(wavegen_get_config_stub);
+}
+
+void tearDown(void)
+{
+    if (protocol_is_initialized()) {
+        USB_deinit_Ignore();
+        WAVEGEN_deinit_Ignore();
+        protocol_deinit();
+    }
+
+    mock_usb_Destroy();
+    mock_wavegen_Destroy();
+    mock_system_Destroy();
+}
+
+// Test: Settings are kept while the output is off
+void test_scpi_wavegen_settings_without_output(void)
+{
+    scpi_inject_usb_command("WAV:FUNC SQU\n");
+    scpi_inject_usb_command("WAV:FREQ 5000\n");
+    scpi_inject_usb_command("WAV:VOLT:AMPL 500\n");
+    scpi_inject_usb_command("WAV:FUNC?;FREQ?;VOLT:AMPL?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_STRING("SQU;5000;500\r\n", scpi_get_captured_response());
+}
+
+// Test: Switching the output on plays the settings, in volts
+void test_scpi_wavegen_output_on(void)
+{
+    WAVEGEN_start_Expect(g_mock_wavegen_handle);
+    scpi_inject_usb_command("WAV:FUNC TRI\n");
+    scpi_inject_usb_command("WAV:VOLT:OFFS 1000\n");
+    scpi_inject_usb_command("WAV:OUTP ON\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL(WAVEGEN_SHAPE_TRIANGLE, g_wavegen_config.shape);
+    TEST_ASSERT_EQUAL_UINT32(1000, g_wavegen_config.frequency);
+    TEST_ASSERT_EQUAL_INT32(FIXED_ONE, g_wavegen_config.offset);
+
+    scpi_inject_usb_command("WAV:OUTP?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("1\r\n", scpi_get_captured_response());
+}
+
+// Test: A change while the output is on restarts it, and the query
+// returns the frequency achieved
+void test_scpi_wavegen_retune_while_on(void)
+{
+    WAVEGEN_start_Ignore();
+    scpi_inject_usb_command("WAV:OUTP ON\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    WAVEGEN_deinit_Expect(g_mock_wavegen_handle);
+    scpi_inject_usb_command("WAV:FREQ 7000\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_UINT32(7000, g_wavegen_config.frequency);
+
+    g_achieved_frequency = 6998;
+    WAVEGEN_deinit_Expect(g_mock_wavegen_handle);
+    scpi_inject_usb_command("WAV:FREQ 7000\n");
+    scpi_inject_usb_command("WAV:FREQ?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+    TEST_ASSERT_EQUAL_STRING("6998\r\n", scpi_get_captured_response());
+}
+
+// Test: DDS mode passes the frequency to the millihertz, and reports the
+// frequency achieved
+void test_scpi_wavegen_dds_millihertz(void)
+{
+    WAVEGEN_start_Expect(g_mock_wavegen_handle);
+    scpi_inject_usb_command("WAV:MODE DDS\n");
+    scpi_inject_usb_command("WAV:FREQ:MILL 1234567\n");
+    scpi_inject_usb_command("WAV:OUTP ON\n");
+    scpi_inject_usb_command("WAV:MODE?;FREQ?;FREQ:MILL?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL(WAVEGEN_MODE_DDS, g_wavegen_config.mode);
+    TEST_ASSERT_EQUAL_UINT32(1234, g_wavegen_config.frequency);
+    TEST_ASSERT_EQUAL_UINT32(567, g_wavegen_config.millihertz);
+    TEST_ASSERT_EQUAL_STRING(
+        "DDS;1235;1234567\r\n", scpi_get_captured_response()
+    );
+}
+
+// Test: Table mode rounds the frequency to the Hz
+void test_scpi_wavegen_table_rounds_millihertz(void)
+{
+    WAVEGEN_start_Expect(g_mock_wavegen_handle);
+    scpi_inject_usb_command("WAV:FREQ:MILL 2500600\n");
+    scpi_inject_usb_command("WAV:OUTP ON\n");
+    scpi_inject_usb_command("WAV:MODE?;FREQ:MILL?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL(WAVEGEN_MODE_TABLE, g_wavegen_config.mode);
+    TEST_ASSERT_EQUAL_UINT32(2501, g_wavegen_config.frequency);
+    TEST_ASSERT_EQUAL_UINT32(0, g_wavegen_config.millihertz);
+    TEST_ASSERT_EQUAL_STRING("TABL;2501000\r\n", scpi_get_captured_response());
+}
+
+// Test: Uploaded codes are played by the arbitrary function
+void test_scpi_wavegen_arbitrary_upload(void)
+{
+    // Little-endian codes 257, 4095 and 2049, free of NUL bytes
+    scpi_inject_usb_command("WAV:DATA 0,#14\x01\x01\xFF\x0F\n");
+    scpi_inject_usb_command("WAV:DATA 2,#12\x01\x08\n");
+    scpi_inject_usb_command("WAV:DATA:POIN 3\n");
+    scpi_inject_usb_command("WAV:FUNC ARB\n");
+    WAVEGEN_start_Expect(g_mock_wavegen_handle);
+    scpi_inject_usb_command("WAV:OUTP ON\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL(WAVEGEN_SHAPE_ARBITRARY, g_wavegen_config.shape);
+    TEST_ASSERT_EQUAL_UINT32(3, g_wavegen_config.sample_count);
+    TEST_ASSERT_EQUAL_UINT16(257, g_wavegen_samples[0]);
+    TEST_ASSERT_EQUAL_UINT16(4095, g_wavegen_samples[1]);
+    TEST_ASSERT_EQUAL_UINT16(2049, g_wavegen_samples[2]);
+}
+
+// Test: A block too large for the input buffer is streamed into the
+// upload, and the rest of its line is still parsed
+void test_scpi_wavegen_streamed_upload(void)
+{
+    char command[SCPI_TEST_USB_BUFFER_SIZE];
+    int len = snprintf(command, sizeof(command), "WAV:DATA 0,#3400");
+    // Little-endian code 257, repeated, free of NUL bytes
+    memset(&command[len], 0x01, 400);
+    len += 400;
+    snprintf(&command[len], sizeof(command) - len, ";:WAV:DATA:POIN?\n");
+    scpi_inject_usb_command(command);
+    scpi_inject_usb_command("WAV:DATA:POIN 8\n");
+    scpi_inject_usb_command("WAV:FUNC ARB\n");
+    WAVEGEN_start_Expect(g_mock_wavegen_handle);
+    scpi_inject_usb_command("WAV:OUTP ON\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_STRING("0\r\n", scpi_get_captured_response());
+    TEST_ASSERT_EQUAL_UINT32(8, g_wavegen_config.sample_count);
+    TEST_ASSERT_EQUAL_UINT16(257, g_wavegen_samples[0]);
+    TEST_ASSERT_EQUAL_UINT16(257, g_wavegen_samples[7]);
+}
+
+// Test: Codes beyond the DAC range are refused
+void test_scpi_wavegen_data_out_of_range(void)
+{
+    scpi_inject_usb_command("WAV:DATA 0,#12\x01\x10\n");
+    scpi_inject_usb_command("SYST:ERR?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_SCPI_ERROR(scpi_get_captured_response());
+}
+
+// Test: Settings the generator refuses leave the output off
+void test_scpi_wavegen_output_refused(void)
+{
+    WAVEGEN_init_Stub(wavegen_init_refuse_stub);
+    scpi_inject_usb_command("WAV:OUTP ON\n");
+    scpi_inject_usb_command("WAV:OUTP?\n");
+    scpi_run_protocol_with_usb_mocks(g_mock_usb_handle);
+
+    TEST_ASSERT_EQUAL_STRING("0\r\n", scpi_get_captured_response());
+}
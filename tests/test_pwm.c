@@ -0,0 +1,174 @@
+/**
+ * @file test_pwm.c
+ * @brief Unit tests for the PWM generator
+ *
+ * The timer is mocked with 62500 counts per period, as at 1 kHz; the
+ * pulses loaded into its channel pairs are checked against the duty
+ * cycles and phases.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "unity.h"
+#include "mock_clock.h"
+#include "mock_tim_ll.h"
+
+#include "util/error.h"
+
+#include "pwm.h"
+
+enum {
+    PERIOD_COUNTS = 62500,
+};
+
+static PWM_Handle *g_handle;
+
+/**
+ * @brief Expect the timer and both outputs to be set up at 1 kHz
+ */
+static void expect_init(uint32_t start1, uint32_t width1)
+{
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_4, 1000, 1000);
+    TIM_LL_get_period_ExpectAndReturn(TIM_NUM_4, PERIOD_COUNTS);
+    TIM_LL_pwm_init_Expect(TIM_NUM_4, TIM_LL_CHANNEL_1);
+    TIM_LL_pwm_set_pulse_Expect(TIM_NUM_4, TIM_LL_CHANNEL_1, start1, width1);
+    TIM_LL_pwm_init_Expect(TIM_NUM_4, TIM_LL_CHANNEL_3);
+    TIM_LL_pwm_set_pulse_Expect(TIM_NUM_4, TIM_LL_CHANNEL_3, 0, 31250);
+}
+
+void setUp(void)
+{
+    mock_clock_Init();
+    mock_tim_ll_Init();
+
+    g_handle = NULL;
+
+    CLOCK_request_Ignore();
+    CLOCK_release_Ignore();
+}
+
+void tearDown(void)
+{
+    if (g_handle != NULL) {
+        TIM_LL_stop_Ignore();
+        TIM_LL_pwm_enable_Ignore();
+        TIM_LL_deinit_Ignore();
+        PWM_deinit(g_handle);
+    }
+
+    mock_clock_Verify();
+    mock_clock_Destroy();
+    mock_tim_ll_Verify();
+    mock_tim_ll_Destroy();
+}
+
+// Test: Duty cycles and phases become pulses in timer counts
+void test_PWM_init_pulses(void)
+{
+    PWM_Config config = PWM_CONFIG_DEFAULT;
+    config.channels[0].duty = 250000;
+    config.channels[0].phase = 500000;
+
+    expect_init(31250, 15625);
+    g_handle = PWM_init(&config);
+
+    PWM_Config const achieved = PWM_get_config(g_handle);
+    TEST_ASSERT_EQUAL_UINT32(1000, achieved.frequency);
+    TEST_ASSERT_FALSE(PWM_is_running(g_handle));
+}
+
+// Test: Starting reloads the pulses and drives the enabled outputs only
+void test_PWM_start_drives_enabled_outputs(void)
+{
+    PWM_Config config = PWM_CONFIG_DEFAULT;
+    config.channels[0].enabled = false;
+
+    expect_init(0, 31250);
+    g_handle = PWM_init(&config);
+
+    TIM_LL_pwm_set_pulse_Expect(TIM_NUM_4, TIM_LL_CHANNEL_1, 0, 31250);
+    TIM_LL_pwm_set_pulse_Expect(TIM_NUM_4, TIM_LL_CHANNEL_3, 0, 31250);
+    TIM_LL_pwm_enable_Expect(TIM_NUM_4, TIM_LL_CHANNEL_1, false);
+    TIM_LL_pwm_enable_Expect(TIM_NUM_4, TIM_LL_CHANNEL_3, true);
+    TIM_LL_start_Expect(TIM_NUM_4);
+    PWM_start(g_handle);
+    TEST_ASSERT_TRUE(PWM_is_running(g_handle));
+
+    TIM_LL_stop_Expect(TIM_NUM_4);
+    TIM_LL_pwm_enable_Expect(TIM_NUM_4, TIM_LL_CHANNEL_1, false);
+    TIM_LL_pwm_enable_Expect(TIM_NUM_4, TIM_LL_CHANNEL_3, false);
+    PWM_stop(g_handle);
+    TEST_ASSERT_FALSE(PWM_is_running(g_handle));
+}
+
+// Test: A running channel takes a new pulse, and a phase rounding up to a
+// whole period starts the period
+void test_PWM_set_channel(void)
+{
+    PWM_Config config = PWM_CONFIG_DEFAULT;
+    PWM_Channel const channel = {
+        .enabled = true, .duty = PWM_PPM_FULL, .phase = 999999
+    };
+
+    expect_init(0, 31250);
+    g_handle = PWM_init(&config);
+
+    TIM_LL_pwm_set_pulse_Expect(TIM_NUM_4, TIM_LL_CHANNEL_1, 0, 31250);
+    TIM_LL_pwm_set_pulse_Expect(TIM_NUM_4, TIM_LL_CHANNEL_3, 0, 31250);
+    TIM_LL_pwm_enable_Expect(TIM_NUM_4, TIM_LL_CHANNEL_1, true);
+    TIM_LL_pwm_enable_Expect(TIM_NUM_4, TIM_LL_CHANNEL_3, true);
+    TIM_LL_start_Expect(TIM_NUM_4);
+    PWM_start(g_handle);
+
+    TIM_LL_pwm_set_pulse_Expect(
+        TIM_NUM_4, TIM_LL_CHANNEL_3, 0, PERIOD_COUNTS
+    );
+    TIM_LL_pwm_enable_Expect(TIM_NUM_4, TIM_LL_CHANNEL_3, true);
+    PWM_set_channel(g_handle, 1, &channel);
+
+    TEST_ASSERT_EQUAL_UINT32(
+        PWM_PPM_FULL, PWM_get_config(g_handle).channels[1].duty
+    );
+}
+
+// Test: A timer in use by an acquisition is left to it
+void test_PWM_init_timer_busy(void)
+{
+    PWM_Config config = PWM_CONFIG_DEFAULT;
+    Error error = ERROR_NONE;
+
+    TIM_LL_init_ExpectAndThrow(TIM_NUM_4, 1000, ERROR_RESOURCE_BUSY);
+    TRY { PWM_init(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, error);
+}
+
+// Test: Invalid configurations are refused before the timer is touched
+void test_PWM_init_invalid(void)
+{
+    PWM_Config config = PWM_CONFIG_DEFAULT;
+    Error error = ERROR_NONE;
+
+    config.frequency = PWM_FREQUENCY_MAX + 1;
+    TRY { PWM_init(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    config.frequency = 1000;
+    config.channels[1].duty = PWM_PPM_FULL + 1;
+    error = ERROR_NONE;
+    TRY { PWM_init(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    config.channels[1].duty = 0;
+    config.channels[1].phase = PWM_PPM_FULL;
+    error = ERROR_NONE;
+    TRY { PWM_init(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+}
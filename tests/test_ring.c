@@ -0,0 +1,171 @@
+/**
+ * @file test_ring.c
+ * @brief Unit tests for the typed ring buffers
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "util/error.h"
+#include "util/ring.h"
+
+enum {
+    RING_SIZE = 8,
+};
+
+typedef struct {
+    uint32_t tick;
+    uint16_t count;
+    uint8_t channel;
+} Descriptor;
+
+RING_DEFINE(DescriptorRing, descriptor_ring, Descriptor)
+
+static uint16_t g_storage[RING_SIZE];
+static RingU16 g_ring;
+
+void setUp(void)
+{
+    memset(g_storage, 0, sizeof(g_storage));
+    ring_u16_init(&g_ring, g_storage, RING_SIZE);
+}
+
+void tearDown(void) {}
+
+// Test: Sizes that are not a power of two, and missing storage, are refused
+void test_ring_init_invalid(void)
+{
+    RingU16 ring;
+    Error error = ERROR_NONE;
+
+    TRY { ring_u16_init(&ring, g_storage, 6); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    error = ERROR_NONE;
+    TRY { ring_u16_init(&ring, NULL, RING_SIZE); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+}
+
+// Test: Elements come out whole and in order, one slot short of the size
+void test_ring_put_get(void)
+{
+    uint16_t value = 0;
+
+    TEST_ASSERT_TRUE(ring_u16_is_empty(&g_ring));
+    for (uint16_t i = 0; i < RING_SIZE - 1; i++) {
+        TEST_ASSERT_TRUE(ring_u16_put(&g_ring, (uint16_t)(0x1000 + i)));
+    }
+    TEST_ASSERT_TRUE(ring_u16_is_full(&g_ring));
+    TEST_ASSERT_FALSE(ring_u16_put(&g_ring, 0xFFFF));
+    TEST_ASSERT_EQUAL_UINT32(RING_SIZE - 1, ring_u16_available(&g_ring));
+    TEST_ASSERT_EQUAL_UINT32(0, ring_u16_free_space(&g_ring));
+
+    for (uint16_t i = 0; i < RING_SIZE - 1; i++) {
+        TEST_ASSERT_TRUE(ring_u16_get(&g_ring, &value));
+        TEST_ASSERT_EQUAL_HEX16(0x1000 + i, value);
+    }
+    TEST_ASSERT_FALSE(ring_u16_get(&g_ring, &value));
+}
+
+// Test: Bulk writes and reads wrap around the end of the storage and stop
+// at the free space and the elements stored
+void test_ring_write_read_wrap(void)
+{
+    uint16_t const first[5] = { 1, 2, 3, 4, 5 };
+    uint16_t const second[6] = { 6, 7, 8, 9, 10, 11 };
+    uint16_t out[8] = { 0 };
+
+    TEST_ASSERT_EQUAL_UINT32(5, ring_u16_write(&g_ring, first, 5));
+    TEST_ASSERT_EQUAL_UINT32(3, ring_u16_read(&g_ring, out, 3));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(first, out, 3);
+
+    // Five slots free, across the end of the storage
+    TEST_ASSERT_EQUAL_UINT32(5, ring_u16_write(&g_ring, second, 6));
+    TEST_ASSERT_EQUAL_UINT32(7, ring_u16_read(&g_ring, out, 8));
+    uint16_t const expected[7] = { 4, 5, 6, 7, 8, 9, 10 };
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, out, 7);
+    TEST_ASSERT_TRUE(ring_u16_is_empty(&g_ring));
+}
+
+// Test: Spans in place stop at the end of the storage, and commits beyond
+// what is there are refused
+void test_ring_contiguous_spans(void)
+{
+    uint16_t const data[6] = { 1, 2, 3, 4, 5, 6 };
+    uint16_t *span = NULL;
+    uint16_t const *readable = NULL;
+    Error error = ERROR_NONE;
+
+    ring_u16_write(&g_ring, data, 6);
+    ring_u16_read(&g_ring, (uint16_t[6]){ 0 }, 6);
+
+    // Head at 6: two slots to the end, then the rest from the start
+    TEST_ASSERT_EQUAL_UINT32(2, ring_u16_reserve_contiguous(&g_ring, &span));
+    TEST_ASSERT_EQUAL_PTR(&g_storage[6], span);
+    span[0] = 0xA0;
+    span[1] = 0xA1;
+    ring_u16_commit_write(&g_ring, 2);
+    TEST_ASSERT_EQUAL_UINT32(5, ring_u16_reserve_contiguous(&g_ring, &span));
+    TEST_ASSERT_EQUAL_PTR(&g_storage[0], span);
+
+    TEST_ASSERT_EQUAL_UINT32(2, ring_u16_peek_contiguous(&g_ring, &readable));
+    TEST_ASSERT_EQUAL_HEX16(0xA1, readable[1]);
+
+    TRY { ring_u16_commit_read(&g_ring, 3); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    ring_u16_commit_read(&g_ring, 2);
+    TEST_ASSERT_TRUE(ring_u16_is_empty(&g_ring));
+
+    error = ERROR_NONE;
+    TRY { ring_u16_commit_write(&g_ring, RING_SIZE); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+}
+
+// Test: A ring of structures moves them whole
+void test_ring_structures(void)
+{
+    Descriptor storage[4];
+    DescriptorRing ring;
+    Descriptor const in[3] = {
+        { .tick = 100, .count = 16, .channel = 1 },
+        { .tick = 200, .count = 32, .channel = 2 },
+        { .tick = 300, .count = 64, .channel = 3 },
+    };
+    Descriptor out[3] = { 0 };
+
+    descriptor_ring_init(&ring, storage, 4);
+    TEST_ASSERT_TRUE(descriptor_ring_put(&ring, in[0]));
+    TEST_ASSERT_EQUAL_UINT32(2, descriptor_ring_write(&ring, &in[1], 2));
+    TEST_ASSERT_TRUE(descriptor_ring_is_full(&ring));
+
+    TEST_ASSERT_TRUE(descriptor_ring_get(&ring, &out[0]));
+    TEST_ASSERT_EQUAL_UINT32(2, descriptor_ring_read(&ring, &out[1], 3));
+    for (uint32_t i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_UINT32(in[i].tick, out[i].tick);
+        TEST_ASSERT_EQUAL_UINT16(in[i].count, out[i].count);
+        TEST_ASSERT_EQUAL_UINT8(in[i].channel, out[i].channel);
+    }
+}
+
+// Test: 32-bit rings keep the full width of their elements
+void test_ring_u32(void)
+{
+    uint32_t storage[4];
+    RingU32 ring;
+    uint32_t value = 0;
+
+    ring_u32_init(&ring, storage, 4);
+    TEST_ASSERT_TRUE(ring_u32_put(&ring, 0xDEADBEEF));
+    TEST_ASSERT_TRUE(ring_u32_get(&ring, &value));
+    TEST_ASSERT_EQUAL_HEX32(0xDEADBEEF, value);
+}
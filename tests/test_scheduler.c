@@ -0,0 +1,179 @@
+/**
+ * @file test_scheduler.c
+ * @brief Unit tests for the cooperative task scheduler
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "mock_platform.h"
+#include "util/error.h"
+
+#include "scheduler.h"
+
+enum { NO_TASK = 0xFF };
+
+static uint32_t g_runs[3];
+static uint32_t g_last;
+
+static void task_a(void)
+{
+    ++g_runs[0];
+    g_last = 0;
+}
+
+static void task_b(void)
+{
+    ++g_runs[1];
+    g_last = 1;
+}
+
+static void task_c(void)
+{
+    ++g_runs[2];
+    g_last = 2;
+}
+
+void setUp(void)
+{
+    SCHEDULER_init();
+    g_runs[0] = 0;
+    g_runs[1] = 0;
+    g_runs[2] = 0;
+    g_last = NO_TASK;
+}
+
+void tearDown(void) {}
+
+// Helper running one scheduler step at the given tick
+static bool step_at(uint32_t tick)
+{
+    PLATFORM_get_tick_ExpectAndReturn(tick);
+    g_last = NO_TASK;
+    return SCHEDULER_step();
+}
+
+// Helper registering a task at the given tick
+static void add_at(uint32_t tick, SCHEDULER_Task const *task)
+{
+    PLATFORM_get_tick_ExpectAndReturn(tick);
+    SCHEDULER_add(task);
+}
+
+// Test: A periodic task runs once per period
+void test_SCHEDULER_step_periodic(void)
+{
+    add_at(100, &(SCHEDULER_Task){ .function = task_a, .period = 10 });
+
+    TEST_ASSERT_TRUE(step_at(100));
+    TEST_ASSERT_FALSE(step_at(105));
+    TEST_ASSERT_FALSE(step_at(109));
+    TEST_ASSERT_TRUE(step_at(110));
+    TEST_ASSERT_FALSE(step_at(110));
+
+    TEST_ASSERT_EQUAL_UINT32(2, g_runs[0]);
+}
+
+// Test: Missed periods run once instead of in a burst
+void test_SCHEDULER_step_skips_missed_periods(void)
+{
+    add_at(100, &(SCHEDULER_Task){ .function = task_a, .period = 10 });
+
+    TEST_ASSERT_TRUE(step_at(100));
+    TEST_ASSERT_TRUE(step_at(155));
+    TEST_ASSERT_FALSE(step_at(160));
+    TEST_ASSERT_TRUE(step_at(165));
+
+    TEST_ASSERT_EQUAL_UINT32(3, g_runs[0]);
+}
+
+// Test: Periods are measured across tick wrap-around
+void test_SCHEDULER_step_tick_wraps(void)
+{
+    uint32_t const start = UINT32_MAX - 4;
+    add_at(start, &(SCHEDULER_Task){ .function = task_a, .period = 10 });
+
+    TEST_ASSERT_TRUE(step_at(start));
+    TEST_ASSERT_FALSE(step_at(2));
+    TEST_ASSERT_TRUE(step_at(5));
+}
+
+// Test: Posted events make only their waiting tasks ready, once
+void test_SCHEDULER_post_wakes_waiting_tasks(void)
+{
+    add_at(0, &(SCHEDULER_Task){ .function = task_a,
+                                 .events = SCHEDULER_EVENT_USB_RX });
+    add_at(0, &(SCHEDULER_Task){ .function = task_b,
+                                 .events = SCHEDULER_EVENT_DSO });
+
+    TEST_ASSERT_FALSE(step_at(0));
+
+    SCHEDULER_post(SCHEDULER_EVENT_DSO);
+    SCHEDULER_post(SCHEDULER_EVENT_DSO);
+    TEST_ASSERT_TRUE(step_at(1));
+    TEST_ASSERT_EQUAL_UINT32(1, g_last);
+    TEST_ASSERT_FALSE(step_at(2));
+
+    TEST_ASSERT_EQUAL_UINT32(0, g_runs[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, g_runs[1]);
+}
+
+// Test: The highest priority ready task runs first, ties in order added
+void test_SCHEDULER_step_priority(void)
+{
+    add_at(0, &(SCHEDULER_Task){ .function = task_a,
+                                 .period = 1,
+                                 .priority = 2 });
+    add_at(0, &(SCHEDULER_Task){ .function = task_b,
+                                 .period = 1,
+                                 .priority = 1 });
+    add_at(0, &(SCHEDULER_Task){ .function = task_c,
+                                 .period = 1,
+                                 .priority = 1 });
+
+    TEST_ASSERT_TRUE(step_at(0));
+    TEST_ASSERT_EQUAL_UINT32(1, g_last);
+    TEST_ASSERT_TRUE(step_at(0));
+    TEST_ASSERT_EQUAL_UINT32(2, g_last);
+    TEST_ASSERT_TRUE(step_at(0));
+    TEST_ASSERT_EQUAL_UINT32(0, g_last);
+    TEST_ASSERT_FALSE(step_at(0));
+}
+
+// Helper expecting SCHEDULER_add to throw the given error
+static void assert_add_rejected(SCHEDULER_Task const *task, CEXCEPTION_T error)
+{
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+
+    TRY {
+        SCHEDULER_add(task);
+        TEST_FAIL_MESSAGE("Expected exception for rejected task");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(error, exception);
+    }
+}
+
+// Test: Invalid tasks and a full task table are rejected
+void test_SCHEDULER_add_invalid(void)
+{
+    assert_add_rejected(nullptr, ERROR_INVALID_ARGUMENT);
+    assert_add_rejected(
+        &(SCHEDULER_Task){ .period = 1 }, ERROR_INVALID_ARGUMENT
+    );
+    assert_add_rejected(
+        &(SCHEDULER_Task){ .function = task_a }, ERROR_INVALID_ARGUMENT
+    );
+
+    for (uint32_t i = 0; i < SCHEDULER_TASKS_MAX; ++i) {
+        add_at(0, &(SCHEDULER_Task){ .function = task_a, .period = 1 });
+    }
+    assert_add_rejected(
+        &(SCHEDULER_Task){ .function = task_a, .period = 1 },
+        ERROR_OUT_OF_MEMORY
+    );
+}
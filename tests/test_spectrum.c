@@ -0,0 +1,200 @@
+/**
+ * @file test_spectrum.c
+ * @brief Unit tests for the fixed-point amplitude spectrum
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "util/fixed_point.h"
+#include "util/spectrum.h"
+
+enum {
+    SIZE = 128,
+    BINS = SIZE / 2,
+    OFFSET = 2048, // Mid-scale of a 12-bit ADC
+};
+
+static uint16_t g_samples[2 * SIZE];
+static int32_t g_work[2 * SIZE];
+static FIXED_Q1616 g_bins[BINS];
+
+// One period of a sine of amplitude 1000 in 16 and 8 steps
+static int32_t const g_sine_16[] = { 0,    383,  707,  924,  1000, 924,
+                                     707,  383,  0,    -383, -707, -924,
+                                     -1000, -924, -707, -383 };
+static int32_t const g_sine_8[] = { 0, 707, 1000, 707, 0, -707, -1000, -707 };
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Sample value at index i of a sine with the given period (16, 8 or 4)
+static int32_t sine(uint32_t i, uint32_t period, int32_t amplitude)
+{
+    int32_t value = 0;
+    if (period == 16) {
+        value = g_sine_16[i % 16];
+    } else if (period == 8) {
+        value = g_sine_8[i % 8];
+    } else {
+        value = g_sine_16[(i * 4) % 16];
+    }
+    return (value * amplitude) / 1000;
+}
+
+// Test: A sine centred on a bin reads its amplitude in that bin
+void test_SPECTRUM_compute_sine_on_bin(void)
+{
+    for (uint32_t i = 0; i < SIZE; ++i) {
+        g_samples[i] = (uint16_t)(OFFSET + sine(i, 8, 1000));
+    }
+
+    TEST_ASSERT_TRUE(SPECTRUM_compute(g_samples, SIZE, 1, g_work, g_bins));
+
+    // Period 8 of 128 samples is bin 16; the window spreads it over three
+    // neighbours either side
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, FIXED_FROM_INT(1000), g_bins[16]);
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, FIXED_FROM_INT(681), g_bins[15]);
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, FIXED_FROM_INT(681), g_bins[17]);
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, FIXED_FROM_INT(197), g_bins[14]);
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, FIXED_FROM_INT(16), g_bins[19]);
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, 0, g_bins[0]);
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, 0, g_bins[12]);
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, 0, g_bins[40]);
+}
+
+// Test: Interleaved channels are transformed on their own
+void test_SPECTRUM_compute_stride(void)
+{
+    for (uint32_t i = 0; i < SIZE; ++i) {
+        g_samples[2 * i] = (uint16_t)(OFFSET + sine(i, 16, 500));
+        g_samples[(2 * i) + 1] = (uint16_t)(OFFSET + sine(i, 8, 1000));
+    }
+
+    TEST_ASSERT_TRUE(SPECTRUM_compute(g_samples, SIZE, 2, g_work, g_bins));
+
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, FIXED_FROM_INT(500), g_bins[8]);
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, 0, g_bins[16]);
+}
+
+// Test: A constant signal has an empty spectrum
+void test_SPECTRUM_compute_constant(void)
+{
+    for (uint32_t i = 0; i < SIZE; ++i) {
+        g_samples[i] = OFFSET;
+    }
+
+    TEST_ASSERT_TRUE(SPECTRUM_compute(g_samples, SIZE, 1, g_work, g_bins));
+
+    for (uint32_t k = 0; k < BINS; ++k) {
+        TEST_ASSERT_EQUAL_INT32(0, g_bins[k]);
+    }
+}
+
+// Test: Sizes that are not supported powers of two are rejected
+void test_SPECTRUM_compute_invalid_size(void)
+{
+    TEST_ASSERT_FALSE(SPECTRUM_compute(g_samples, 48, 1, g_work, g_bins));
+    TEST_ASSERT_FALSE(SPECTRUM_compute(g_samples, 8, 1, g_work, g_bins));
+    TEST_ASSERT_FALSE(SPECTRUM_compute(g_samples, SIZE, 0, g_work, g_bins));
+}
+
+// Test: Peaks are returned by decreasing amplitude
+void test_SPECTRUM_find_peaks(void)
+{
+    uint32_t peaks[4] = { 0 };
+    for (uint32_t i = 0; i < SIZE; ++i) {
+        g_samples[i] =
+            (uint16_t)(OFFSET + sine(i, 16, 300) + sine(i, 4, 1000));
+    }
+    TEST_ASSERT_TRUE(SPECTRUM_compute(g_samples, SIZE, 1, g_work, g_bins));
+
+    uint32_t const found = SPECTRUM_find_peaks(g_bins, BINS, peaks, 2);
+
+    TEST_ASSERT_EQUAL_UINT32(2, found);
+    TEST_ASSERT_EQUAL_UINT32(32, peaks[0]);
+    TEST_ASSERT_EQUAL_UINT32(8, peaks[1]);
+}
+
+// Test: Harmonic distortion of a tone with a 1% second harmonic
+void test_SPECTRUM_distortion(void)
+{
+    SPECTRUM_Distortion result;
+    for (uint32_t i = 0; i < SIZE; ++i) {
+        g_samples[i] =
+            (uint16_t)(OFFSET + sine(i, 16, 1000) + sine(i, 8, 10));
+    }
+    TEST_ASSERT_TRUE(SPECTRUM_compute(g_samples, SIZE, 1, g_work, g_bins));
+
+    SPECTRUM_distortion(g_bins, BINS, 5, &result);
+
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE / 100, FIXED_FROM_INT(8),
+                             result.fundamental);
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE * 5, FIXED_FROM_INT(1000),
+                             result.amplitude);
+    TEST_ASSERT_EQUAL_UINT32(4, result.harmonics);
+    // 20 * log10(10 / 1000) = -40 dB
+    TEST_ASSERT_INT32_WITHIN(100, -4000, result.thd_cdb);
+    TEST_ASSERT_TRUE(result.snr_cdb > 4000);
+}
+
+// Test: The phasor of a sine reads its amplitude and phase, not its offset
+void test_SPECTRUM_phasor(void)
+{
+    SPECTRUM_Phasor phasor;
+    uint32_t const step = UINT32_C(1) << 28; // A sixteenth of a turn
+    for (uint32_t i = 0; i < SIZE; ++i) {
+        g_samples[2 * i] = (uint16_t)(OFFSET + sine(i, 16, 1000));
+        g_samples[(2 * i) + 1] = (uint16_t)(OFFSET + sine(i + 4, 16, 500));
+    }
+
+    // sin is cos 90 degrees late
+    TEST_ASSERT_TRUE(SPECTRUM_phasor(g_samples, SIZE, 2, step, &phasor));
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, 0, phasor.real);
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, FIXED_FROM_INT(-1000), phasor.imag);
+
+    // A quarter period ahead, cos itself
+    TEST_ASSERT_TRUE(
+        SPECTRUM_phasor(&g_samples[1], SIZE, 2, step, &phasor)
+    );
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, FIXED_FROM_INT(500), phasor.real);
+    TEST_ASSERT_INT32_WITHIN(FIXED_ONE, 0, phasor.imag);
+
+    TEST_ASSERT_FALSE(SPECTRUM_phasor(g_samples, 1, 2, step, &phasor));
+    TEST_ASSERT_FALSE(SPECTRUM_phasor(g_samples, SIZE, 0, step, &phasor));
+}
+
+// Test: Gain and phase from a stimulus to a halved, delayed response
+void test_SPECTRUM_response(void)
+{
+    SPECTRUM_Phasor stimulus;
+    SPECTRUM_Phasor response;
+    SPECTRUM_Response result;
+    uint32_t const step = UINT32_C(1) << 28;
+    for (uint32_t i = 0; i < SIZE; ++i) {
+        g_samples[2 * i] = (uint16_t)(OFFSET + sine(i, 16, 1000));
+        // 90 degrees late, three quarters of a period ahead
+        g_samples[(2 * i) + 1] = (uint16_t)(OFFSET + sine(i + 12, 16, 500));
+    }
+    TEST_ASSERT_TRUE(SPECTRUM_phasor(g_samples, SIZE, 2, step, &stimulus));
+    TEST_ASSERT_TRUE(
+        SPECTRUM_phasor(&g_samples[1], SIZE, 2, step, &response)
+    );
+
+    SPECTRUM_response(&stimulus, &response, &result);
+
+    // 20 * log10(500 / 1000) = -6.02 dB
+    TEST_ASSERT_INT32_WITHIN(2, -602, result.gain_cdb);
+    TEST_ASSERT_INT32_WITHIN(10, -9000, result.phase_cdeg);
+
+    // The other way round, the response leads
+    SPECTRUM_response(&response, &stimulus, &result);
+    TEST_ASSERT_INT32_WITHIN(2, 602, result.gain_cdb);
+    TEST_ASSERT_INT32_WITHIN(10, 9000, result.phase_cdeg);
+}
@@ -0,0 +1,330 @@
+/**
+ * @file test_spi.c
+ * @brief Unit tests for the SPI bus transaction queue
+ *
+ * The hardware layer is mocked; the transfers started on it are captured,
+ * and their completion is simulated by calling the callback the driver
+ * registered.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_clock.h"
+#include "mock_platform.h"
+#include "mock_spi_ll.h"
+
+#include "util/error.h"
+
+#include "spi.h"
+
+static SPI_Handle *g_handle;
+static SPI_LL_CompleteCallback g_complete;
+static SPI_LL_Transfer g_transfer;
+static uint32_t g_starts;
+static bool g_start_fails; // The next start throws
+static uint8_t g_tx[4];
+static uint8_t g_rx[4];
+static SPI_Transaction g_transactions[SPI_QUEUE_SIZE + 1];
+static uint32_t g_transaction_count;
+static SPI_Transaction *g_completed[SPI_QUEUE_SIZE + 1];
+static uint32_t g_completed_count;
+
+static void
+set_complete_callback_stub(SPI_Bus bus, SPI_LL_CompleteCallback cb, int n)
+{
+    (void)bus;
+    (void)n;
+    g_complete = cb;
+}
+
+static void start_stub(SPI_Bus bus, SPI_LL_Transfer const *transfer, int n)
+{
+    (void)bus;
+    (void)n;
+    if (g_start_fails) {
+        g_start_fails = false;
+        THROW(ERROR_HARDWARE_FAULT);
+    }
+    g_transfer = *transfer;
+    g_starts += 1;
+}
+
+static void on_complete(SPI_Transaction *transaction)
+{
+    g_completed[g_completed_count] = transaction;
+    g_completed_count += 1;
+}
+
+/**
+ * @brief A four-byte exchange that releases the chip select
+ *
+ * Transactions outlive the test, since tearDown cancels the pending ones.
+ */
+static SPI_Transaction *new_transfer(void)
+{
+    SPI_Transaction *const transaction =
+        &g_transactions[g_transaction_count];
+
+    g_transaction_count += 1;
+    *transaction = (SPI_Transaction){
+        .tx = g_tx,
+        .rx = g_rx,
+        .size = sizeof(g_tx),
+        .hold_cs = false,
+        .callback = on_complete,
+    };
+    return transaction;
+}
+
+void setUp(void)
+{
+    mock_clock_Init();
+    mock_platform_Init();
+    mock_spi_ll_Init();
+
+    g_complete = NULL;
+    g_starts = 0;
+    g_start_fails = false;
+    g_transaction_count = 0;
+    g_completed_count = 0;
+    memset(&g_transfer, 0, sizeof(g_transfer));
+
+    PLATFORM_disable_interrupts_IgnoreAndReturn(0);
+    PLATFORM_restore_interrupts_Ignore();
+    SPI_LL_set_complete_callback_Stub(set_complete_callback_stub);
+    SPI_LL_start_Stub(start_stub);
+
+    SPI_LL_init_Expect(SPI_BUS_0);
+    CLOCK_request_Expect();
+    SPI_LL_configure_ExpectAnyArgsAndReturn(976562);
+    g_handle = SPI_init(0);
+}
+
+void tearDown(void)
+{
+    if (g_handle != NULL) {
+        SPI_LL_deinit_Ignore();
+        CLOCK_release_Ignore();
+        SPI_deinit(g_handle);
+        g_handle = NULL;
+    }
+
+    mock_clock_Destroy();
+    mock_platform_Destroy();
+    mock_spi_ll_Destroy();
+}
+
+// Test: A transaction on an idle bus starts at once, and its completion
+// reports the outcome
+void test_SPI_submit_starts_and_completes(void)
+{
+    SPI_Transaction *const transfer = new_transfer();
+    transfer->hold_cs = true;
+
+    SPI_submit(g_handle, transfer);
+
+    TEST_ASSERT_EQUAL_UINT32(1, g_starts);
+    TEST_ASSERT_EQUAL_PTR(g_tx, g_transfer.tx);
+    TEST_ASSERT_EQUAL_PTR(g_rx, g_transfer.rx);
+    TEST_ASSERT_EQUAL_UINT32(4, g_transfer.size);
+    TEST_ASSERT_TRUE(g_transfer.hold_cs);
+    TEST_ASSERT_EQUAL(SPI_STATUS_PENDING, transfer->status);
+    TEST_ASSERT_EQUAL_UINT32(1, SPI_pending(g_handle));
+
+    g_complete(SPI_BUS_0, SPI_LL_STATUS_OK);
+
+    TEST_ASSERT_EQUAL(SPI_STATUS_OK, transfer->status);
+    TEST_ASSERT_EQUAL_UINT32(1, g_completed_count);
+    TEST_ASSERT_EQUAL_PTR(transfer, g_completed[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, SPI_pending(g_handle));
+}
+
+// Test: Queued transactions run one after another in submission order
+void test_SPI_queue_order(void)
+{
+    SPI_Transaction *const first = new_transfer();
+    SPI_Transaction *const second = new_transfer();
+    second->size = 2;
+
+    SPI_submit(g_handle, first);
+    SPI_submit(g_handle, second);
+    TEST_ASSERT_EQUAL_UINT32(1, g_starts);
+    TEST_ASSERT_EQUAL_UINT32(4, g_transfer.size);
+
+    g_complete(SPI_BUS_0, SPI_LL_STATUS_BUS_ERROR);
+    TEST_ASSERT_EQUAL(SPI_STATUS_BUS_ERROR, first->status);
+    TEST_ASSERT_EQUAL(SPI_STATUS_PENDING, second->status);
+    TEST_ASSERT_EQUAL_UINT32(2, g_starts);
+    TEST_ASSERT_EQUAL_UINT32(2, g_transfer.size);
+
+    g_complete(SPI_BUS_0, SPI_LL_STATUS_OK);
+    TEST_ASSERT_EQUAL(SPI_STATUS_OK, second->status);
+    TEST_ASSERT_EQUAL_UINT32(2, g_completed_count);
+    TEST_ASSERT_EQUAL_PTR(second, g_completed[1]);
+}
+
+// Test: A failed transaction that held the chip select cancels the rest of
+// its command, and the transaction after that runs
+void test_SPI_failed_command_cancelled(void)
+{
+    SPI_Transaction *const command = new_transfer();
+    SPI_Transaction *const address = new_transfer();
+    SPI_Transaction *const page = new_transfer();
+    SPI_Transaction *const next = new_transfer();
+    command->hold_cs = true;
+    address->hold_cs = true;
+
+    SPI_submit(g_handle, command);
+    SPI_submit(g_handle, address);
+    SPI_submit(g_handle, page);
+    SPI_submit(g_handle, next);
+
+    g_complete(SPI_BUS_0, SPI_LL_STATUS_DMA_ERROR);
+
+    TEST_ASSERT_EQUAL(SPI_STATUS_DMA_ERROR, command->status);
+    TEST_ASSERT_EQUAL(SPI_STATUS_CANCELLED, address->status);
+    TEST_ASSERT_EQUAL(SPI_STATUS_CANCELLED, page->status);
+    TEST_ASSERT_EQUAL(SPI_STATUS_PENDING, next->status);
+    TEST_ASSERT_EQUAL_UINT32(2, g_starts);
+    TEST_ASSERT_EQUAL_UINT32(1, SPI_pending(g_handle));
+}
+
+// Test: A full queue, or a transaction already pending, is refused
+void test_SPI_submit_busy(void)
+{
+    SPI_Transaction *queued[SPI_QUEUE_SIZE];
+    Error error = ERROR_NONE;
+
+    for (uint32_t i = 0; i < SPI_QUEUE_SIZE; i++) {
+        queued[i] = new_transfer();
+        SPI_submit(g_handle, queued[i]);
+    }
+
+    SPI_Transaction *const extra = new_transfer();
+    TRY { SPI_submit(g_handle, extra); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, error);
+    TEST_ASSERT_EQUAL(SPI_STATUS_OK, extra->status);
+
+    g_complete(SPI_BUS_0, SPI_LL_STATUS_OK);
+    error = ERROR_NONE;
+    TRY { SPI_submit(g_handle, queued[1]); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, error);
+
+    // The completed one may go again
+    SPI_submit(g_handle, queued[0]);
+    TEST_ASSERT_EQUAL_UINT32(SPI_QUEUE_SIZE, SPI_pending(g_handle));
+}
+
+// Test: A transfer the hardware refuses fails, and the next one starts
+void test_SPI_start_failure(void)
+{
+    SPI_Transaction *const first = new_transfer();
+    SPI_Transaction *const second = new_transfer();
+    SPI_Transaction *const third = new_transfer();
+
+    SPI_submit(g_handle, first);
+    SPI_submit(g_handle, second);
+    SPI_submit(g_handle, third);
+
+    g_start_fails = true;
+    g_complete(SPI_BUS_0, SPI_LL_STATUS_OK);
+
+    TEST_ASSERT_EQUAL(SPI_STATUS_OK, first->status);
+    TEST_ASSERT_EQUAL(SPI_STATUS_BUS_ERROR, second->status);
+    TEST_ASSERT_EQUAL(SPI_STATUS_PENDING, third->status);
+    TEST_ASSERT_EQUAL_UINT32(2, g_starts);
+    TEST_ASSERT_EQUAL_UINT32(1, SPI_pending(g_handle));
+}
+
+// Test: Deinitializing cancels the pending transactions and releases the
+// system clock
+void test_SPI_deinit_cancels(void)
+{
+    SPI_Transaction *const first = new_transfer();
+    SPI_Transaction *const second = new_transfer();
+
+    SPI_submit(g_handle, first);
+    SPI_submit(g_handle, second);
+
+    SPI_LL_deinit_Expect(SPI_BUS_0);
+    CLOCK_release_Expect();
+    SPI_deinit(g_handle);
+    g_handle = NULL;
+
+    TEST_ASSERT_EQUAL(SPI_STATUS_CANCELLED, first->status);
+    TEST_ASSERT_EQUAL(SPI_STATUS_CANCELLED, second->status);
+    TEST_ASSERT_EQUAL_UINT32(2, g_completed_count);
+}
+
+// Test: Settings only change on an idle bus, and the clock rate reached is
+// kept
+void test_SPI_configure(void)
+{
+    SPI_Config config = { 0 };
+    Error error = ERROR_NONE;
+
+    SPI_get_config(g_handle, &config);
+    TEST_ASSERT_EQUAL_UINT32(976562, config.speed);
+    TEST_ASSERT_EQUAL(SPI_MODE_0, config.mode);
+    TEST_ASSERT_FALSE(config.lsb_first);
+
+    config = (SPI_Config){
+        .speed = 20000000,
+        .mode = SPI_MODE_3,
+        .lsb_first = true,
+    };
+    SPI_LL_configure_ExpectAnyArgsAndReturn(15625000);
+    TEST_ASSERT_EQUAL_UINT32(15625000, SPI_configure(g_handle, &config));
+    SPI_get_config(g_handle, &config);
+    TEST_ASSERT_EQUAL_UINT32(15625000, config.speed);
+    TEST_ASSERT_EQUAL(SPI_MODE_3, config.mode);
+    TEST_ASSERT_TRUE(config.lsb_first);
+
+    SPI_submit(g_handle, new_transfer());
+    TRY { SPI_configure(g_handle, &config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, error);
+
+    config.speed = SPI_SPEED_MAX + 1;
+    error = ERROR_NONE;
+    TRY { SPI_configure(g_handle, &config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+}
+
+// Test: Invalid transactions are refused before the queue is touched
+void test_SPI_submit_invalid(void)
+{
+    SPI_Transaction *const transfer = new_transfer();
+    Error error = ERROR_NONE;
+
+    transfer->tx = NULL;
+    transfer->rx = NULL;
+    TRY { SPI_submit(g_handle, transfer); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    transfer->tx = g_tx;
+    transfer->size = 0;
+    error = ERROR_NONE;
+    TRY { SPI_submit(g_handle, transfer); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    transfer->size = SPI_TRANSFER_MAX + 1;
+    error = ERROR_NONE;
+    TRY { SPI_submit(g_handle, transfer); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    TEST_ASSERT_EQUAL_UINT32(0, g_starts);
+    TEST_ASSERT_EQUAL_UINT32(0, SPI_pending(g_handle));
+}
@@ -0,0 +1,136 @@
+/**
+ * @file test_stats.c
+ * @brief Unit tests for the sample summary statistics
+ *
+ * @author PSLab Team
+ * @date 2025-10-15
+ */
+
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "util/fixed_point.h"
+#include "util/stats.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_STATS_summarize_block(void)
+{
+    uint16_t const samples[] = { 10, 4, 7, 1 };
+    STATS_Summary summary = STATS_SUMMARY_EMPTY;
+
+    STATS_summarize(samples, 4, &summary);
+
+    TEST_ASSERT_EQUAL_UINT32(4, summary.count);
+    TEST_ASSERT_EQUAL_UINT32(22, summary.sum);
+    TEST_ASSERT_EQUAL_UINT64(166, summary.sum_squares);
+    TEST_ASSERT_EQUAL_UINT16(1, summary.min);
+    TEST_ASSERT_EQUAL_UINT16(10, summary.max);
+}
+
+void test_STATS_summarize_empty(void)
+{
+    STATS_Summary summary = { .count = 3, .sum = 3, .min = 1, .max = 1 };
+
+    STATS_summarize(nullptr, 0, &summary);
+
+    TEST_ASSERT_EQUAL_UINT32(0, summary.count);
+    TEST_ASSERT_EQUAL_INT32(FIXED_ZERO, STATS_mean(&summary));
+    TEST_ASSERT_EQUAL_INT32(FIXED_ZERO, STATS_rms(&summary));
+}
+
+void test_STATS_merge_matches_whole_block(void)
+{
+    uint16_t const samples[] = { 100, 3000, 5, 4095, 2048, 17 };
+    STATS_Summary whole = STATS_SUMMARY_EMPTY;
+    STATS_Summary first = STATS_SUMMARY_EMPTY;
+    STATS_Summary second = STATS_SUMMARY_EMPTY;
+
+    STATS_summarize(samples, 6, &whole);
+    STATS_summarize(samples, 2, &first);
+    STATS_summarize(samples + 2, 4, &second);
+    STATS_merge(&first, &second);
+
+    TEST_ASSERT_EQUAL_UINT32(whole.count, first.count);
+    TEST_ASSERT_EQUAL_UINT32(whole.sum, first.sum);
+    TEST_ASSERT_EQUAL_UINT64(whole.sum_squares, first.sum_squares);
+    TEST_ASSERT_EQUAL_UINT16(5, first.min);
+    TEST_ASSERT_EQUAL_UINT16(4095, first.max);
+}
+
+void test_STATS_mean_keeps_fraction(void)
+{
+    uint16_t const samples[] = { 1, 2, 2, 2 };
+    STATS_Summary summary = STATS_SUMMARY_EMPTY;
+
+    STATS_summarize(samples, 4, &summary);
+
+    TEST_ASSERT_EQUAL_INT32(FIXED_FROM_FLOAT(1.75f), STATS_mean(&summary));
+}
+
+void test_STATS_rms_of_constant_is_constant(void)
+{
+    uint16_t const samples[] = { 4095, 4095, 4095, 4095 };
+    STATS_Summary summary = STATS_SUMMARY_EMPTY;
+
+    STATS_summarize(samples, 4, &summary);
+
+    TEST_ASSERT_EQUAL_INT32(FIXED_FROM_INT(4095), STATS_rms(&summary));
+}
+
+void test_STATS_rms_of_square_wave(void)
+{
+    // RMS of 0 and 3 alternating is 3 / sqrt(2)
+    uint16_t const samples[] = { 0, 3, 0, 3 };
+    STATS_Summary summary = STATS_SUMMARY_EMPTY;
+
+    STATS_summarize(samples, 4, &summary);
+
+    TEST_ASSERT_INT32_WITHIN(1, 139022, STATS_rms(&summary));
+}
+
+void test_STATS_ac_rms_removes_mean(void)
+{
+    // 2048 +- 3 alternating: the AC part is 3, whatever the offset
+    uint16_t const samples[] = { 2045, 2051, 2045, 2051 };
+    STATS_Summary summary = STATS_SUMMARY_EMPTY;
+
+    STATS_summarize(samples, 4, &summary);
+
+    TEST_ASSERT_EQUAL_INT32(FIXED_FROM_INT(3), STATS_ac_rms(&summary));
+}
+
+void test_STATS_ac_rms_of_constant_is_zero(void)
+{
+    uint16_t const samples[] = { 4095, 4095, 4095 };
+    STATS_Summary summary = STATS_SUMMARY_EMPTY;
+
+    STATS_summarize(samples, 3, &summary);
+
+    TEST_ASSERT_EQUAL_INT32(FIXED_ZERO, STATS_ac_rms(&summary));
+}
+
+void test_STATS_ac_rms_keeps_fraction(void)
+{
+    // One code step in four samples: variance 3 / 16, root 0.4330
+    uint16_t const samples[] = { 1000, 1000, 1000, 1001 };
+    STATS_Summary summary = STATS_SUMMARY_EMPTY;
+
+    STATS_summarize(samples, 4, &summary);
+
+    TEST_ASSERT_INT32_WITHIN(1, 28378, STATS_ac_rms(&summary));
+}
+
+void test_STATS_full_scale_saturates(void)
+{
+    uint16_t const samples[] = { UINT16_MAX, UINT16_MAX };
+    STATS_Summary summary = STATS_SUMMARY_EMPTY;
+
+    STATS_summarize(samples, 2, &summary);
+
+    TEST_ASSERT_EQUAL_INT32(FIXED_MAX, STATS_mean(&summary));
+    TEST_ASSERT_EQUAL_INT32(FIXED_MAX, STATS_rms(&summary));
+}
@@ -0,0 +1,366 @@
+/**
+ * @file test_sweep.c
+ * @brief Unit tests for the frequency response sweep
+ *
+ * The oscilloscope is mocked to fill its buffer with the generator's sine
+ * on channel 0 and, on channel 1, that of a circuit halving it 90 degrees
+ * late, at the sample rate and the frequency last configured; the DSO
+ * timer achieves any rate exactly.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_dso.h"
+#include "mock_platform.h"
+#include "mock_wavegen.h"
+
+#include "util/error.h"
+#include "util/fixed_point.h"
+
+#include "sweep.h"
+
+enum {
+    OFFSET = 2048, // Mid-scale of a 12-bit ADC
+    STIMULUS = 1000, // Codes of channel 0 sine amplitude
+    RESPONSE = 500, // Codes of channel 1 sine amplitude
+    RATE_MAX = 2000000,
+    TASK_CALLS_MAX = 100000,
+};
+
+static DSO_Handle *const g_dso_handle = (DSO_Handle *)0x2468ACE0;
+static WAVEGEN_Handle *const g_wavegen_handle = (WAVEGEN_Handle *)0x13579BDF;
+
+static DSO_Config g_dso_config;
+static WAVEGEN_Config g_wavegen_config;
+static bool g_dso_open;
+static bool g_wavegen_open;
+static bool g_capture_hangs;
+static uint32_t g_wavegen_inits;
+static uint32_t g_rate_max;
+static uint32_t g_tick;
+
+static DSO_Handle *dso_init_stub(DSO_Config const *config, int n)
+{
+    (void)n;
+    TEST_ASSERT_FALSE(g_dso_open);
+    TEST_ASSERT_EQUAL(DSO_MODE_DUAL_CHANNEL, config->mode);
+    TEST_ASSERT_NOT_NULL(config->complete_callback);
+    g_dso_config = *config;
+    g_dso_open = true;
+    return g_dso_handle;
+}
+
+static void dso_deinit_stub(DSO_Handle *handle, int n)
+{
+    (void)n;
+    TEST_ASSERT_EQUAL_PTR(g_dso_handle, handle);
+    g_dso_open = false;
+}
+
+static DSO_Config dso_get_config_stub(DSO_Handle *handle, int n)
+{
+    (void)n;
+    TEST_ASSERT_EQUAL_PTR(g_dso_handle, handle);
+    return g_dso_config;
+}
+
+static void
+dso_set_config_stub(DSO_Handle *handle, DSO_Config const *config, int n)
+{
+    (void)n;
+    TEST_ASSERT_EQUAL_PTR(g_dso_handle, handle);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(g_rate_max, config->sample_rate);
+    g_dso_config = *config;
+}
+
+static uint32_t
+dso_get_max_sample_rate_stub(DSO_Mode mode, DSO_Resolution resolution, int n)
+{
+    (void)n;
+    TEST_ASSERT_EQUAL(DSO_MODE_DUAL_CHANNEL, mode);
+    TEST_ASSERT_EQUAL(DSO_RESOLUTION_12BIT, resolution);
+    return g_rate_max;
+}
+
+// Code of a sine of the given amplitude at a phase in 2^-32 turns
+static uint16_t sine_code(uint32_t phase, int32_t amplitude)
+{
+    int64_t const value = (int64_t)FIXED_sin(phase) * amplitude;
+    return (uint16_t)(OFFSET + (value / FIXED_ONE));
+}
+
+static void dso_start_stub(DSO_Handle *handle, int n)
+{
+    (void)n;
+    TEST_ASSERT_EQUAL_PTR(g_dso_handle, handle);
+    TEST_ASSERT_TRUE(g_wavegen_open);
+    if (g_capture_hangs) {
+        return;
+    }
+
+    uint64_t const frequency =
+        ((uint64_t)g_wavegen_config.frequency * 1000) +
+        g_wavegen_config.millihertz;
+    uint64_t const rate = (uint64_t)g_dso_config.sample_rate * 1000;
+    uint32_t const step = (uint32_t)((frequency << 32) / rate);
+    uint32_t const quarter = UINT32_C(1) << 30;
+    uint32_t phase = 0;
+    for (uint32_t i = 0; i < g_dso_config.buffer_size / 2; ++i) {
+        g_dso_config.buffer[2 * i] = sine_code(phase, STIMULUS);
+        g_dso_config.buffer[(2 * i) + 1] =
+            sine_code(phase - quarter, RESPONSE);
+        phase += step;
+    }
+    g_dso_config.complete_callback();
+}
+
+static WAVEGEN_Handle *wavegen_init_stub(WAVEGEN_Config const *config, int n)
+{
+    (void)n;
+    TEST_ASSERT_FALSE(g_wavegen_open);
+    TEST_ASSERT_EQUAL(WAVEGEN_MODE_DDS, config->mode);
+    TEST_ASSERT_EQUAL(WAVEGEN_SHAPE_SINE, config->shape);
+    g_wavegen_config = *config;
+    g_wavegen_open = true;
+    g_wavegen_inits += 1;
+    return g_wavegen_handle;
+}
+
+static void wavegen_deinit_stub(WAVEGEN_Handle *handle, int n)
+{
+    (void)n;
+    TEST_ASSERT_EQUAL_PTR(g_wavegen_handle, handle);
+    g_wavegen_open = false;
+}
+
+static WAVEGEN_Config
+wavegen_get_config_stub(WAVEGEN_Handle const *handle, int n)
+{
+    (void)n;
+    TEST_ASSERT_EQUAL_PTR(g_wavegen_handle, handle);
+    return g_wavegen_config;
+}
+
+static uint32_t get_tick_stub(int n)
+{
+    (void)n;
+    return g_tick;
+}
+
+static SWEEP_State get_state(void)
+{
+    SWEEP_Status status;
+    SWEEP_get_status(&status);
+    return status.state;
+}
+
+// Run the task a millisecond apart until the sweep is over
+static void run_sweep(void)
+{
+    for (uint32_t i = 0; i < TASK_CALLS_MAX; ++i) {
+        if (get_state() != SWEEP_STATE_RUNNING) {
+            return;
+        }
+        g_tick += 1;
+        SWEEP_task();
+    }
+    TEST_FAIL_MESSAGE("Sweep did not end");
+}
+
+void setUp(void)
+{
+    mock_dso_Init();
+    mock_wavegen_Init();
+    mock_platform_Init();
+
+    memset(&g_dso_config, 0, sizeof(g_dso_config));
+    memset(&g_wavegen_config, 0, sizeof(g_wavegen_config));
+    g_dso_open = false;
+    g_wavegen_open = false;
+    g_capture_hangs = false;
+    g_wavegen_inits = 0;
+    g_rate_max = RATE_MAX;
+    g_tick = 1000;
+
+    DSO_init_Stub(dso_init_stub);
+    DSO_deinit_Stub(dso_deinit_stub);
+    DSO_get_config_Stub(dso_get_config_stub);
+    DSO_set_config_Stub(dso_set_config_stub);
+    DSO_get_max_sample_rate_Stub(dso_get_max_sample_rate_stub);
+    DSO_start_Stub(dso_start_stub);
+    WAVEGEN_init_Stub(wavegen_init_stub);
+    WAVEGEN_deinit_Stub(wavegen_deinit_stub);
+    WAVEGEN_get_config_Stub(wavegen_get_config_stub);
+    WAVEGEN_start_Ignore();
+    PLATFORM_get_tick_Stub(get_tick_stub);
+}
+
+void tearDown(void)
+{
+    SWEEP_stop();
+    mock_dso_Verify();
+    mock_wavegen_Verify();
+    mock_dso_Destroy();
+    mock_wavegen_Destroy();
+    mock_platform_Destroy();
+}
+
+// Test: Each point reads the circuit's gain and phase at the frequency played
+void test_SWEEP_measures_points(void)
+{
+    SWEEP_Config config = SWEEP_CONFIG_DEFAULT;
+    config.points = 3;
+
+    SWEEP_start(&config);
+    TEST_ASSERT_EQUAL(SWEEP_STATE_RUNNING, get_state());
+    run_sweep();
+
+    SWEEP_Status status;
+    SWEEP_get_status(&status);
+    TEST_ASSERT_EQUAL(SWEEP_STATE_DONE, status.state);
+    TEST_ASSERT_EQUAL_UINT32(3, status.points);
+    TEST_ASSERT_EQUAL_UINT32(3, status.completed);
+    TEST_ASSERT_FALSE(g_dso_open);
+    TEST_ASSERT_FALSE(g_wavegen_open);
+    TEST_ASSERT_EQUAL_UINT32(3, g_wavegen_inits);
+
+    uint32_t count = 0;
+    SWEEP_Point const *points = SWEEP_get_points(&count);
+    TEST_ASSERT_EQUAL_UINT32(3, count);
+    // 100 Hz, 1 kHz and 10 kHz, a decade apart
+    uint32_t const expected[] = { 100000, 1000000, 10000000 };
+    for (uint32_t i = 0; i < count; ++i) {
+        TEST_ASSERT_UINT32_WITHIN(
+            expected[i] / 1000, expected[i], points[i].frequency
+        );
+        // 20 * log10(500 / 1000) = -6.02 dB
+        TEST_ASSERT_INT32_WITHIN(2, -602, points[i].gain_cdb);
+        TEST_ASSERT_INT32_WITHIN(10, -9000, points[i].phase_cdeg);
+    }
+}
+
+// Test: Linear spacing, and the stimulus set from the configuration
+void test_SWEEP_linear_spacing(void)
+{
+    SWEEP_Config config = SWEEP_CONFIG_DEFAULT;
+    config.start = 1000;
+    config.stop = 3000;
+    config.points = 3;
+    config.logarithmic = false;
+    config.amplitude = FIXED_FROM_FLOAT(0.5);
+
+    SWEEP_start(&config);
+    TEST_ASSERT_EQUAL_INT32(FIXED_FROM_FLOAT(0.5), g_wavegen_config.amplitude);
+    TEST_ASSERT_EQUAL_INT32(config.offset, g_wavegen_config.offset);
+    run_sweep();
+
+    uint32_t count = 0;
+    SWEEP_Point const *points = SWEEP_get_points(&count);
+    TEST_ASSERT_EQUAL_UINT32(3, count);
+    TEST_ASSERT_UINT32_WITHIN(1000, 1000000, points[0].frequency);
+    TEST_ASSERT_UINT32_WITHIN(2000, 2000000, points[1].frequency);
+    TEST_ASSERT_UINT32_WITHIN(3000, 3000000, points[2].frequency);
+}
+
+// Test: Too slow an ADC for the configured periods captures more of them
+void test_SWEEP_more_cycles_at_slow_rate(void)
+{
+    SWEEP_Config config = SWEEP_CONFIG_DEFAULT;
+    config.start = 30000;
+    config.points = 1;
+    g_rate_max = 100000;
+
+    // 1024 frames at up to 100 kHz hold at least 308 periods of 30 kHz
+    SWEEP_start(&config);
+    TEST_ASSERT_UINT32_WITHIN(500, 99500, g_dso_config.sample_rate);
+    run_sweep();
+
+    uint32_t count = 0;
+    SWEEP_Point const *points = SWEEP_get_points(&count);
+    TEST_ASSERT_EQUAL(SWEEP_STATE_DONE, get_state());
+    TEST_ASSERT_EQUAL_UINT32(1, count);
+    TEST_ASSERT_UINT32_WITHIN(30000, 30000000, points[0].frequency);
+    TEST_ASSERT_INT32_WITHIN(2, -602, points[0].gain_cdb);
+    TEST_ASSERT_INT32_WITHIN(10, -9000, points[0].phase_cdeg);
+}
+
+// Test: A capture that never completes ends the sweep in error
+void test_SWEEP_capture_timeout(void)
+{
+    SWEEP_Config config = SWEEP_CONFIG_DEFAULT;
+    g_capture_hangs = true;
+
+    SWEEP_start(&config);
+    run_sweep();
+
+    SWEEP_Status status;
+    SWEEP_get_status(&status);
+    TEST_ASSERT_EQUAL(SWEEP_STATE_ERROR, status.state);
+    TEST_ASSERT_EQUAL_UINT32(0, status.completed);
+    TEST_ASSERT_FALSE(g_dso_open);
+    TEST_ASSERT_FALSE(g_wavegen_open);
+}
+
+// Test: Invalid settings and a second start are refused
+void test_SWEEP_start_errors(void)
+{
+    CEXCEPTION_T error = CEXCEPTION_NONE;
+    SWEEP_Config config = SWEEP_CONFIG_DEFAULT;
+
+    TRY { SWEEP_start(nullptr); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    config.points = SWEEP_POINTS_MAX + 1;
+    error = CEXCEPTION_NONE;
+    TRY { SWEEP_start(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    config = (SWEEP_Config)SWEEP_CONFIG_DEFAULT;
+    config.stop = SWEEP_FREQUENCY_MAX + 1;
+    error = CEXCEPTION_NONE;
+    TRY { SWEEP_start(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+    TEST_ASSERT_FALSE(g_dso_open);
+
+    config = (SWEEP_Config)SWEEP_CONFIG_DEFAULT;
+    SWEEP_start(&config);
+    error = CEXCEPTION_NONE;
+    TRY { SWEEP_start(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, error);
+    TEST_ASSERT_EQUAL(SWEEP_STATE_RUNNING, get_state());
+}
+
+// Test: Stopping keeps the points measured so far
+void test_SWEEP_stop_keeps_points(void)
+{
+    SWEEP_Config config = SWEEP_CONFIG_DEFAULT;
+
+    SWEEP_start(&config);
+    while (get_state() == SWEEP_STATE_RUNNING) {
+        uint32_t count = 0;
+        (void)SWEEP_get_points(&count);
+        if (count == 2) {
+            break;
+        }
+        g_tick += 1;
+        SWEEP_task();
+    }
+    SWEEP_stop();
+
+    uint32_t count = 0;
+    (void)SWEEP_get_points(&count);
+    TEST_ASSERT_EQUAL(SWEEP_STATE_IDLE, get_state());
+    TEST_ASSERT_EQUAL_UINT32(2, count);
+    TEST_ASSERT_FALSE(g_dso_open);
+    TEST_ASSERT_FALSE(g_wavegen_open);
+}
@@ -0,0 +1,146 @@
+/**
+ * @file test_sync.c
+ * @brief Unit tests for the synchronized instrument start
+ *
+ * The timers are mocked; the starts held and released through them are
+ * checked.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "unity.h"
+#include "mock_tim_ll.h"
+
+#include "util/error.h"
+
+#include "sync.h"
+
+void setUp(void) { mock_tim_ll_Init(); }
+
+void tearDown(void)
+{
+    mock_tim_ll_Verify();
+    mock_tim_ll_Destroy();
+}
+
+// Test: Arming holds the timer starts until the synchronized start
+void test_SYNC_arm_and_start(void)
+{
+    TIM_LL_sync_arm_Expect();
+    SYNC_arm();
+
+    TIM_LL_sync_is_armed_ExpectAndReturn(true);
+    TEST_ASSERT_TRUE(SYNC_is_armed());
+
+    TIM_LL_sync_is_armed_ExpectAndReturn(true);
+    TIM_LL_sync_start_ExpectAndReturn(3);
+    TEST_ASSERT_EQUAL_UINT32(3, SYNC_start());
+}
+
+// Test: Starting without arming is refused before the timers are touched
+void test_SYNC_start_not_armed(void)
+{
+    Error error = ERROR_NONE;
+
+    TIM_LL_sync_is_armed_ExpectAndReturn(false);
+    TRY { SYNC_start(); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_UNAVAILABLE, error);
+}
+
+// Test: Cancelling drops the held starts
+void test_SYNC_cancel(void)
+{
+    TIM_LL_sync_is_armed_ExpectAndReturn(true);
+    TIM_LL_sync_cancel_Expect();
+    SYNC_cancel();
+
+    TIM_LL_sync_is_armed_ExpectAndReturn(false);
+    TEST_ASSERT_FALSE(SYNC_is_armed());
+}
+
+// Test: The external source enables the trigger input
+void test_SYNC_set_source_external(void)
+{
+    TIM_LL_sync_is_armed_ExpectAndReturn(false);
+    TIM_LL_sync_set_trigger_input_Expect(true);
+    SYNC_set_source(SYNC_SOURCE_EXTERNAL);
+    TEST_ASSERT_EQUAL(SYNC_SOURCE_EXTERNAL, SYNC_get_source());
+
+    TIM_LL_sync_is_armed_ExpectAndReturn(false);
+    TIM_LL_sync_set_trigger_input_Expect(false);
+    SYNC_set_source(SYNC_SOURCE_IMMEDIATE);
+    TEST_ASSERT_EQUAL(SYNC_SOURCE_IMMEDIATE, SYNC_get_source());
+}
+
+// Test: The trigger pins are not switched while armed
+void test_SYNC_trigger_settings_while_armed(void)
+{
+    Error error = ERROR_NONE;
+
+    TIM_LL_sync_is_armed_ExpectAndReturn(true);
+    TRY { SYNC_set_source(SYNC_SOURCE_EXTERNAL); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, error);
+
+    error = ERROR_NONE;
+    TIM_LL_sync_is_armed_ExpectAndReturn(true);
+    TRY { SYNC_set_trigger_output(true); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_RESOURCE_BUSY, error);
+    TEST_ASSERT_FALSE(SYNC_get_trigger_output());
+}
+
+// Test: An instrument source starts the held timers on its first event
+void test_SYNC_instrument_source(void)
+{
+    TIM_LL_sync_is_armed_ExpectAndReturn(false);
+    TIM_LL_sync_set_trigger_input_Expect(false);
+    SYNC_set_source(SYNC_SOURCE_OSCILLOSCOPE);
+
+    // Events before the start are ignored
+    SYNC_signal(SYNC_SOURCE_OSCILLOSCOPE);
+
+    TIM_LL_sync_arm_Expect();
+    SYNC_arm();
+    TIM_LL_sync_is_armed_ExpectAndReturn(true);
+    TIM_LL_sync_held_ExpectAndReturn(2);
+    TEST_ASSERT_EQUAL_UINT32(2, SYNC_start());
+
+    // Only the event of the source starts them, and only once
+    SYNC_signal(SYNC_SOURCE_MULTIMETER);
+    TIM_LL_sync_fire_ExpectAndReturn(2);
+    SYNC_signal(SYNC_SOURCE_OSCILLOSCOPE);
+    SYNC_signal(SYNC_SOURCE_OSCILLOSCOPE);
+
+    TIM_LL_sync_is_armed_ExpectAndReturn(false);
+    TIM_LL_sync_set_trigger_input_Expect(false);
+    SYNC_set_source(SYNC_SOURCE_IMMEDIATE);
+}
+
+// Test: Cancelling drops a start waiting for an instrument event
+void test_SYNC_cancel_instrument_source(void)
+{
+    TIM_LL_sync_is_armed_ExpectAndReturn(false);
+    TIM_LL_sync_set_trigger_input_Expect(false);
+    SYNC_set_source(SYNC_SOURCE_MULTIMETER);
+
+    TIM_LL_sync_arm_Expect();
+    SYNC_arm();
+    TIM_LL_sync_is_armed_ExpectAndReturn(true);
+    TIM_LL_sync_held_ExpectAndReturn(1);
+    SYNC_start();
+
+    TIM_LL_sync_is_armed_ExpectAndReturn(true);
+    TIM_LL_sync_cancel_Expect();
+    SYNC_cancel();
+    SYNC_signal(SYNC_SOURCE_MULTIMETER);
+
+    TIM_LL_sync_is_armed_ExpectAndReturn(false);
+    TIM_LL_sync_set_trigger_input_Expect(false);
+    SYNC_set_source(SYNC_SOURCE_IMMEDIATE);
+}
@@ -12,6 +12,7 @@
 
 #include "util/error.h"
 #include "uart.h"
+#include "system/syscalls.h"
 
 
 // Forward declarations of functions we'll test
@@ -23,8 +24,6 @@ _ssize_t _read_r(struct _reent *r, int fd, void *buf, size_t cnt);
 _ssize_t _write_r(struct _reent *r, int fd, void const *buf, size_t cnt);
 int _fstat_r(struct _reent *r, int fd, struct stat *st);
 int _isatty_r(struct _reent *r, int fd);
-void syscalls_init(UART_Handle *handle);
-void syscalls_deinit(UART_Handle *handle);
 
 // Test fixtures
 static struct _reent test_reent;
@@ -61,6 +60,7 @@ void setUp(void)
 void tearDown(void)
 {
     // Deinitialize syscalls with the handle
+    syscalls_set_overflow(SYSCALLS_OVERFLOW_KEEP);
     syscalls_deinit(test_uart_handle);
 
     // Deinitialize UART
@@ -218,6 +218,55 @@ void test_write_r_tx_buffer_full(void)
     TEST_ASSERT_EQUAL(EAGAIN, test_reent._errno);
 }
 
+// Test that the drop policy takes what does not fit instead of failing
+void test_write_r_tx_buffer_full_drops(void)
+{
+    // Arrange
+    char filler_data[250];
+    char test_data[] = "Test data";
+    size_t data_len = strlen(test_data);
+    uint32_t const dropped = syscalls_get_dropped();
+
+    memset(filler_data, 'X', sizeof(filler_data));
+    syscalls_set_overflow(SYSCALLS_OVERFLOW_DROP);
+
+    UART_LL_tx_busy_ExpectAndReturn(UART_BUS_0, false);
+    UART_LL_start_dma_tx_ExpectAnyArgs();
+    _ssize_t filler_result =
+        _write_r(&test_reent, STDOUT_FILENO, filler_data, sizeof(filler_data));
+    TEST_ASSERT_EQUAL(sizeof(filler_data), filler_result);
+
+    // Act - only 5 of the 9 bytes fit the 255 the ring holds
+    UART_LL_tx_busy_ExpectAndReturn(UART_BUS_0, true);
+    _ssize_t result = _write_r(&test_reent, STDOUT_FILENO, test_data, data_len);
+
+    // Assert - all reported written, the rest counted as dropped
+    TEST_ASSERT_EQUAL(data_len, result);
+    TEST_ASSERT_EQUAL(0, test_reent._errno);
+    TEST_ASSERT_EQUAL_UINT32(dropped + 4, syscalls_get_dropped());
+}
+
+// Test that invalid buffering and overflow settings are rejected
+void test_syscalls_settings_invalid(void)
+{
+    Error caught_error = ERROR_NONE;
+
+    TRY {
+        syscalls_set_buffering((SYSCALLS_Buffering)3);
+        TEST_FAIL_MESSAGE("Expected ERROR_INVALID_ARGUMENT to be thrown");
+    } CATCH(caught_error) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, caught_error);
+    }
+
+    caught_error = ERROR_NONE;
+    TRY {
+        syscalls_set_overflow((SYSCALLS_Overflow)2);
+        TEST_FAIL_MESSAGE("Expected ERROR_INVALID_ARGUMENT to be thrown");
+    } CATCH(caught_error) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, caught_error);
+    }
+}
+
 // Test multiple consecutive writes
 void test_multiple_writes(void)
 {
@@ -0,0 +1,151 @@
+/**
+ * @file test_trace.c
+ * @brief Unit tests for the event trace ring
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "mock_platform.h"
+
+#include "trace.h"
+
+void setUp(void)
+{
+    PLATFORM_disable_interrupts_IgnoreAndReturn(0);
+    PLATFORM_restore_interrupts_Ignore();
+    TRACE_set_enabled(true);
+    TRACE_clear();
+}
+
+void tearDown(void) {}
+
+// Helper recording one event at a cycle count
+static void record_at(TRACE_Event event, uint16_t arg, uint32_t cycles)
+{
+    PLATFORM_get_cycles_ExpectAndReturn(cycles);
+    TRACE_record(event, arg);
+}
+
+// Test: Records are read back in order, with their sequence numbers
+void test_TRACE_read_returns_records_in_order(void)
+{
+    uint32_t const start = TRACE_get_sequence();
+    record_at(TRACE_EVENT_PROTOCOL_BEGIN, 0, 100);
+    record_at(TRACE_EVENT_USB_ISR_BEGIN, 3, 150);
+    record_at(TRACE_EVENT_PROTOCOL_END, 0, 400);
+
+    TRACE_Record records[8];
+    uint32_t sequence = start;
+    uint32_t const count = TRACE_read(&sequence, records, 8);
+
+    TEST_ASSERT_EQUAL_UINT32(3, count);
+    TEST_ASSERT_EQUAL_UINT32(start, sequence);
+    TEST_ASSERT_EQUAL_UINT32(start + 3, TRACE_get_sequence());
+    TEST_ASSERT_EQUAL_UINT16(TRACE_EVENT_PROTOCOL_BEGIN, records[0].event);
+    TEST_ASSERT_EQUAL_UINT32(100, records[0].cycles);
+    TEST_ASSERT_EQUAL_UINT16(TRACE_EVENT_USB_ISR_BEGIN, records[1].event);
+    TEST_ASSERT_EQUAL_UINT16(3, records[1].arg);
+    TEST_ASSERT_EQUAL_UINT32(400, records[2].cycles);
+}
+
+// Test: A reader resumes where the previous read ended
+void test_TRACE_read_resumes(void)
+{
+    uint32_t const start = TRACE_get_sequence();
+    for (uint16_t i = 0; i < 5; ++i) {
+        record_at(TRACE_EVENT_LOG_BEGIN, i, i);
+    }
+
+    TRACE_Record records[2];
+    uint32_t sequence = start;
+    uint32_t count = TRACE_read(&sequence, records, 2);
+    TEST_ASSERT_EQUAL_UINT32(2, count);
+
+    sequence += count;
+    count = TRACE_read(&sequence, records, 2);
+    TEST_ASSERT_EQUAL_UINT32(2, count);
+    TEST_ASSERT_EQUAL_UINT32(start + 2, sequence);
+    TEST_ASSERT_EQUAL_UINT16(2, records[0].arg);
+    TEST_ASSERT_EQUAL_UINT16(3, records[1].arg);
+}
+
+// Test: Once the ring wraps, a read starts at the oldest record kept
+void test_TRACE_read_skips_overwritten_records(void)
+{
+    uint32_t const start = TRACE_get_sequence();
+    for (uint32_t i = 0; i < TRACE_CAPACITY + 10; ++i) {
+        record_at(TRACE_EVENT_UART_RX_IDLE, (uint16_t)i, i);
+    }
+
+    TRACE_Record records[4];
+    uint32_t sequence = start;
+    uint32_t const count = TRACE_read(&sequence, records, 4);
+
+    TEST_ASSERT_EQUAL_UINT32(4, count);
+    TEST_ASSERT_EQUAL_UINT32(start + 10, sequence);
+    TEST_ASSERT_EQUAL_UINT16(10, records[0].arg);
+}
+
+// Test: A sequence number ahead of the ring also reads from the oldest
+void test_TRACE_read_sequence_ahead(void)
+{
+    record_at(TRACE_EVENT_LOG_END, 7, 70);
+
+    TRACE_Record records[4];
+    uint32_t sequence = TRACE_get_sequence() + 100;
+    uint32_t const count = TRACE_read(&sequence, records, 4);
+
+    TEST_ASSERT_EQUAL_UINT32(1, count);
+    TEST_ASSERT_EQUAL_UINT32(TRACE_get_sequence() - 1, sequence);
+    TEST_ASSERT_EQUAL_UINT16(7, records[0].arg);
+}
+
+// Test: Clearing discards records but keeps the numbering
+void test_TRACE_clear_keeps_sequence(void)
+{
+    record_at(TRACE_EVENT_LOG_BEGIN, 0, 10);
+    uint32_t const before = TRACE_get_sequence();
+
+    TRACE_clear();
+
+    TRACE_Record records[4];
+    uint32_t sequence = 0;
+    TEST_ASSERT_EQUAL_UINT32(0, TRACE_read(&sequence, records, 4));
+    TEST_ASSERT_EQUAL_UINT32(before, TRACE_get_sequence());
+}
+
+// Test: Nothing is recorded while tracing is disabled
+void test_TRACE_disabled_records_nothing(void)
+{
+    uint32_t const before = TRACE_get_sequence();
+
+    TRACE_set_enabled(false);
+    TRACE_record(TRACE_EVENT_DSO_DMA_HALF, 1);
+
+    TEST_ASSERT_FALSE(TRACE_is_enabled());
+    TEST_ASSERT_EQUAL_UINT32(before, TRACE_get_sequence());
+}
+
+// Test: Initialization keeps an intact ring and marks the boot
+void test_TRACE_init_keeps_records(void)
+{
+    PLATFORM_get_cycles_IgnoreAndReturn(0);
+    TRACE_init();
+    TRACE_init();
+
+    uint32_t const start = TRACE_get_sequence() - 2;
+    TRACE_Record records[4];
+    uint32_t sequence = start;
+    uint32_t const count = TRACE_read(&sequence, records, 4);
+
+    TEST_ASSERT_EQUAL_UINT32(2, count);
+    TEST_ASSERT_EQUAL_UINT16(TRACE_EVENT_BOOT, records[0].event);
+    TEST_ASSERT_EQUAL_UINT16(TRACE_EVENT_BOOT, records[1].event);
+    TEST_ASSERT_EQUAL_UINT16(records[0].arg + 1, records[1].arg);
+}
@@ -5,6 +5,7 @@
 #include "unity.h"
 #include "mock_uart_ll.h"
 #include "mock_platform.h"
+#include "mock_trace.h"
 
 #include "util/error.h"
 
@@ -27,6 +28,8 @@ void setUp(void)
     // Initialize mocks
     mock_uart_ll_Init();
     mock_platform_Init();
+    mock_trace_Init();
+    TRACE_record_Ignore();
 }
 
 void tearDown(void)
@@ -227,6 +230,47 @@ void test_UART_write_with_nearly_full_buffer(void)
     TEST_ASSERT_EQUAL(3, bytes_written);
 }
 
+void test_UART_write_sends_wrapped_data_in_one_transfer(void)
+{
+    // Arrange
+    size_t bus = 0;
+    uint8_t test_data[10];
+    uint8_t skip_data[250];
+
+    UART_LL_init_Expect(UART_BUS_0, g_rx_data, sizeof(g_rx_data));
+    UART_LL_set_idle_callback_Ignore();
+    UART_LL_set_rx_complete_callback_Ignore();
+    UART_LL_set_tx_complete_callback_Ignore();
+
+    g_test_handle = UART_init(bus, &g_rx_buffer, &g_tx_buffer);
+
+    // Move the ring indices to 6 bytes before the end
+    circular_buffer_write(&g_tx_buffer, skip_data, sizeof(skip_data));
+    circular_buffer_read(&g_tx_buffer, skip_data, sizeof(skip_data));
+    for (uint32_t i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = (uint8_t)(0x30 + i);
+    }
+
+    // Both spans go out in a single transfer: 6 at the end, 4 at the start
+    UART_LL_tx_busy_ExpectAndReturn(UART_BUS_0, false);
+    UART_LL_start_dma_tx_wrapped_Expect(
+        UART_BUS_0,
+        &g_tx_data[250],
+        6,
+        g_tx_data,
+        4
+    );
+
+    // Act
+    uint32_t bytes_written =
+        UART_write(g_test_handle, test_data, sizeof(test_data));
+
+    // Assert
+    TEST_ASSERT_EQUAL(sizeof(test_data), bytes_written);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(test_data, &g_tx_data[250], 6);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&test_data[6], g_tx_data, 4);
+}
+
 void test_UART_write_with_null_handle(void)
 {
     // Arrange
@@ -377,7 +421,7 @@ void test_UART_flush_with_valid_handle_no_timeout(void)
 
     // Setup expectation - TX is not busy so transmission completes immediately
     UART_LL_tx_busy_ExpectAndReturn(UART_BUS_0, false);
-    PLATFORM_get_tick_ExpectAndReturn(100);
+    PLATFORM_get_time_us64_ExpectAndReturn(100000);
 
     // Act - flush with no timeout (0 means wait indefinitely)
     bool result = UART_flush(g_test_handle, 0);
@@ -401,7 +445,7 @@ void test_UART_flush_with_timeout_success(void)
 
     // Setup expectation - TX is not busy so no transmission needed
     UART_LL_tx_busy_ExpectAndReturn(UART_BUS_0, false);
-    PLATFORM_get_tick_ExpectAndReturn(1000);
+    PLATFORM_get_time_us64_ExpectAndReturn(1000000);
 
     // Act - flush with timeout (should succeed immediately since buffer is empty)
     bool result = UART_flush(g_test_handle, 100); // 100ms timeout
@@ -414,7 +458,7 @@ void test_UART_flush_with_timeout_failure(void)
 {
     // Arrange
     size_t bus = 0;
-    uint32_t current_time = 1000;
+    uint64_t current_time = 1000000;
     uint8_t test_data[] = {0x01, 0x02, 0x03, 0x04};
 
     // Set up expectations for init
@@ -434,8 +478,8 @@ void test_UART_flush_with_timeout_failure(void)
     UART_LL_start_dma_tx_Expect(UART_BUS_0, test_data, sizeof(test_data));
 
     // Mock time calls - start time, then time that exceeds timeout
-    PLATFORM_get_tick_ExpectAndReturn(current_time);  // start_time
-    PLATFORM_get_tick_ExpectAndReturn(current_time + 150);  // elapsed check - exceeds timeout
+    PLATFORM_get_time_us64_ExpectAndReturn(current_time);  // start_time
+    PLATFORM_get_time_us64_ExpectAndReturn(current_time + 150000);  // elapsed check - exceeds timeout
 
     // Act
     bool result = UART_flush(g_test_handle, 100); // 100ms timeout
@@ -444,6 +488,72 @@ void test_UART_flush_with_timeout_failure(void)
     TEST_ASSERT_FALSE(result);
 }
 
+void test_UART_flush_timeout_is_not_rounded_to_ticks(void)
+{
+    // Arrange
+    size_t bus = 0;
+    uint64_t current_time = 1000000;
+    uint8_t test_data[] = {0x01, 0x02, 0x03, 0x04};
+
+    // Set up expectations for init
+    UART_LL_init_Expect(UART_BUS_0, g_rx_data, sizeof(g_rx_data));
+    UART_LL_set_idle_callback_Ignore();
+    UART_LL_set_rx_complete_callback_Ignore();
+    UART_LL_set_tx_complete_callback_Ignore();
+
+    g_test_handle = UART_init(bus, &g_rx_buffer, &g_tx_buffer);
+    circular_buffer_write(&g_tx_buffer, test_data, sizeof(test_data));
+
+    // Setup expectations - TX starts but never completes
+    UART_LL_tx_busy_ExpectAndReturn(UART_BUS_0, false);
+    UART_LL_start_dma_tx_Expect(UART_BUS_0, test_data, sizeof(test_data));
+
+    // Still waiting 1 us before the timeout, expired exactly on it
+    PLATFORM_get_time_us64_ExpectAndReturn(current_time);
+    PLATFORM_get_time_us64_ExpectAndReturn(current_time + 999);
+    PLATFORM_get_time_us64_ExpectAndReturn(current_time + 1000);
+
+    // Act
+    bool result = UART_flush(g_test_handle, 1); // 1ms timeout
+
+    // Assert
+    TEST_ASSERT_FALSE(result);
+}
+
+void test_UART_flush_long_timeout_expires(void)
+{
+    // Arrange
+    size_t bus = 0;
+    uint64_t current_time = 1000000;
+    uint8_t test_data[] = {0x01, 0x02, 0x03, 0x04};
+    uint32_t const timeout = 5000000; // ms, beyond the 32-bit us clock
+    uint64_t const timeout_us = (uint64_t)timeout * 1000;
+
+    // Set up expectations for init
+    UART_LL_init_Expect(UART_BUS_0, g_rx_data, sizeof(g_rx_data));
+    UART_LL_set_idle_callback_Ignore();
+    UART_LL_set_rx_complete_callback_Ignore();
+    UART_LL_set_tx_complete_callback_Ignore();
+
+    g_test_handle = UART_init(bus, &g_rx_buffer, &g_tx_buffer);
+    circular_buffer_write(&g_tx_buffer, test_data, sizeof(test_data));
+
+    // Setup expectations - TX starts but never completes
+    UART_LL_tx_busy_ExpectAndReturn(UART_BUS_0, false);
+    UART_LL_start_dma_tx_Expect(UART_BUS_0, test_data, sizeof(test_data));
+
+    // Past the wrap of a 32-bit us clock, then expired on the timeout
+    PLATFORM_get_time_us64_ExpectAndReturn(current_time);
+    PLATFORM_get_time_us64_ExpectAndReturn(current_time + UINT32_MAX + 1ULL);
+    PLATFORM_get_time_us64_ExpectAndReturn(current_time + timeout_us);
+
+    // Act
+    bool result = UART_flush(g_test_handle, timeout);
+
+    // Assert
+    TEST_ASSERT_FALSE(result);
+}
+
 void test_UART_flush_with_null_handle(void)
 {
     // Act
@@ -1078,3 +1188,370 @@ void test_UART_enable_passthrough_with_same_handle(void)
 
     UART_deinit(handle);
 }
+
+static UART_LL_LineConfig g_ll_config;
+
+static void capture_ll_config(
+    UART_Bus bus,
+    UART_LL_LineConfig const *config,
+    int num_calls
+)
+{
+    (void)bus;
+    (void)num_calls;
+    g_ll_config = *config;
+}
+
+void test_UART_configure(void)
+{
+    // Arrange - A byte is waiting in the RX buffer
+    UART_LL_init_Expect(UART_BUS_0, g_rx_data, sizeof(g_rx_data));
+    UART_LL_set_idle_callback_Ignore();
+    UART_LL_set_rx_complete_callback_Ignore();
+    UART_LL_set_tx_complete_callback_Ignore();
+    g_test_handle = UART_init(0, &g_rx_buffer, &g_tx_buffer);
+    g_rx_buffer.head = 1;
+
+    UART_LL_get_max_baudrate_ExpectAndReturn(UART_BUS_0, false, 15625000);
+    UART_LL_configure_StubWithCallback(capture_ll_config);
+    UART_LL_tx_busy_IgnoreAndReturn(false);
+
+    // Act - Above the highest 16x baudrate
+    UART_LineConfig config = UART_LINE_CONFIG_DEFAULT;
+    config.baudrate = 20000000;
+    config.parity = UART_LINE_PARITY_EVEN;
+    config.stop_bits = UART_LINE_STOP_BITS_2;
+    UART_configure(g_test_handle, &config);
+
+    // Assert - 8x oversampling is picked and unread bytes are discarded
+    TEST_ASSERT_EQUAL_UINT32(20000000, g_ll_config.baudrate);
+    TEST_ASSERT_EQUAL(UART_LL_PARITY_EVEN, g_ll_config.parity);
+    TEST_ASSERT_EQUAL(UART_LL_STOP_BITS_2, g_ll_config.stop_bits);
+    TEST_ASSERT_TRUE(g_ll_config.oversampling_8);
+    TEST_ASSERT_EQUAL_UINT32(0, g_rx_buffer.head);
+    TEST_ASSERT_EQUAL_UINT32(20000000, UART_get_config(g_test_handle).baudrate);
+}
+
+void test_UART_configure_invalid(void)
+{
+    // Arrange
+    UART_LL_init_Expect(UART_BUS_0, g_rx_data, sizeof(g_rx_data));
+    UART_LL_set_idle_callback_Ignore();
+    UART_LL_set_rx_complete_callback_Ignore();
+    UART_LL_set_tx_complete_callback_Ignore();
+    g_test_handle = UART_init(0, &g_rx_buffer, &g_tx_buffer);
+
+    UART_LineConfig config = UART_LINE_CONFIG_DEFAULT;
+    config.parity = (UART_LineParity)3;
+    Error caught_error = ERROR_NONE;
+
+    // Act
+    TRY {
+        UART_configure(g_test_handle, &config);
+    } CATCH(caught_error) {
+        // Expected to catch an error
+    }
+
+    // Assert - Rejected before reaching the hardware
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, caught_error);
+    TEST_ASSERT_EQUAL_UINT32(115200, UART_get_config(g_test_handle).baudrate);
+}
+
+void test_UART_set_loopback(void)
+{
+    // Arrange - A byte is waiting in the RX buffer
+    UART_LL_init_Expect(UART_BUS_0, g_rx_data, sizeof(g_rx_data));
+    UART_LL_set_idle_callback_Ignore();
+    UART_LL_set_rx_complete_callback_Ignore();
+    UART_LL_set_tx_complete_callback_Ignore();
+    g_test_handle = UART_init(0, &g_rx_buffer, &g_tx_buffer);
+    g_rx_buffer.head = 1;
+
+    UART_LL_set_loopback_Expect(UART_BUS_0, true);
+
+    // Act
+    UART_set_loopback(g_test_handle, true);
+
+    // Assert - Reception restarts, as after UART_configure
+    TEST_ASSERT_EQUAL_UINT32(0, g_rx_buffer.head);
+    TEST_ASSERT_EQUAL_UINT32(0, g_rx_buffer.tail);
+}
+
+static UART_LL_IdleCallback g_idle_callback;
+
+static void capture_idle_callback(
+    UART_Bus bus,
+    UART_LL_IdleCallback callback,
+    int num_calls
+)
+{
+    (void)bus;
+    (void)num_calls;
+    g_idle_callback = callback;
+}
+
+void test_UART_rx_overrun_detected(void)
+{
+    // Arrange
+    UART_LL_init_Expect(UART_BUS_0, g_rx_data, sizeof(g_rx_data));
+    UART_LL_set_idle_callback_StubWithCallback(capture_idle_callback);
+    UART_LL_set_rx_complete_callback_Ignore();
+    UART_LL_set_tx_complete_callback_Ignore();
+    g_test_handle = UART_init(0, &g_rx_buffer, &g_tx_buffer);
+
+    // Act - 200 bytes unread, then the DMA writes 156 more
+    g_idle_callback(UART_BUS_0, 200);
+    TEST_ASSERT_EQUAL_UINT32(0, UART_get_rx_overruns(g_test_handle));
+    g_idle_callback(UART_BUS_0, 100);
+
+    // Assert - Lapped data is counted and discarded on the next read
+    TEST_ASSERT_EQUAL_UINT32(1, UART_get_rx_overruns(g_test_handle));
+    uint8_t read_buffer[16];
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_0, 100);
+    TEST_ASSERT_EQUAL_UINT32(
+        0, UART_read(g_test_handle, read_buffer, sizeof(read_buffer))
+    );
+}
+
+static UART_LL_RxCompleteCallback g_rx_complete_callback;
+
+static void capture_rx_complete_callback(
+    UART_Bus bus,
+    UART_LL_RxCompleteCallback callback,
+    int num_calls
+)
+{
+    (void)bus;
+    (void)num_calls;
+    g_rx_complete_callback = callback;
+}
+
+void test_UART_rx_overrun_detected_without_callback(void)
+{
+    // Arrange - a polled reader, no RX callback and no flow control
+    UART_LL_init_Expect(UART_BUS_0, g_rx_data, sizeof(g_rx_data));
+    UART_LL_set_idle_callback_Ignore();
+    UART_LL_set_rx_complete_callback_StubWithCallback(
+        capture_rx_complete_callback
+    );
+    UART_LL_set_tx_complete_callback_Ignore();
+    g_test_handle = UART_init(0, &g_rx_buffer, &g_tx_buffer);
+
+    // Act - the half and end events of a lap the reader does not read
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_0, 128);
+    g_rx_complete_callback(UART_BUS_0);
+    TEST_ASSERT_EQUAL_UINT32(0, UART_get_rx_overruns(g_test_handle));
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_0, 256);
+    g_rx_complete_callback(UART_BUS_0);
+
+    // Assert - the head moved on both events, so the lap is counted
+    TEST_ASSERT_EQUAL_UINT32(1, UART_get_rx_overruns(g_test_handle));
+}
+
+void test_UART_flow_control_pauses_rx(void)
+{
+    // Arrange - Flow control on, with a 256-byte RX buffer
+    UART_LL_init_Expect(UART_BUS_1, g_rx_data, sizeof(g_rx_data));
+    UART_LL_set_idle_callback_StubWithCallback(capture_idle_callback);
+    UART_LL_set_rx_complete_callback_Ignore();
+    UART_LL_set_tx_complete_callback_Ignore();
+    g_test_handle = UART_init(1, &g_rx_buffer, &g_tx_buffer);
+
+    UART_LL_get_max_baudrate_ExpectAndReturn(UART_BUS_1, false, 15625000);
+    UART_LL_configure_StubWithCallback(capture_ll_config);
+    UART_LL_tx_busy_IgnoreAndReturn(false);
+    UART_LineConfig config = UART_LINE_CONFIG_DEFAULT;
+    config.flow_control = true;
+    UART_configure(g_test_handle, &config);
+    TEST_ASSERT_TRUE(g_ll_config.flow_control);
+
+    PLATFORM_disable_interrupts_IgnoreAndReturn(0);
+    PLATFORM_restore_interrupts_Ignore();
+
+    // Act & Assert - Below half the buffer, reception goes on
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_1, 100);
+    g_idle_callback(UART_BUS_1, 100);
+
+    // Half the buffer unread pauses it
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_1, 130);
+    UART_LL_set_rx_paused_Expect(UART_BUS_1, true);
+    g_idle_callback(UART_BUS_1, 130);
+
+    // Reading below half resumes it
+    uint8_t read_buffer[16];
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_1, 130);
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_1, 130);
+    UART_LL_set_rx_paused_Expect(UART_BUS_1, false);
+    TEST_ASSERT_EQUAL_UINT32(
+        16, UART_read(g_test_handle, read_buffer, sizeof(read_buffer))
+    );
+    TEST_ASSERT_EQUAL_UINT32(0, UART_get_rx_overruns(g_test_handle));
+}
+
+void test_UART_rx_peek_and_consume(void)
+{
+    // Arrange - Ten bytes received across the end of the buffer
+    UART_LL_init_Expect(UART_BUS_0, g_rx_data, sizeof(g_rx_data));
+    UART_LL_set_idle_callback_Ignore();
+    UART_LL_set_rx_complete_callback_Ignore();
+    UART_LL_set_tx_complete_callback_Ignore();
+    g_test_handle = UART_init(0, &g_rx_buffer, &g_tx_buffer);
+    g_rx_buffer.head = 250;
+    g_rx_buffer.tail = 250;
+
+    // Act & Assert - Read in place, straight from the DMA buffer
+    uint8_t const *data = nullptr;
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_0, 4);
+    TEST_ASSERT_EQUAL_UINT32(6, UART_rx_peek(g_test_handle, &data));
+    TEST_ASSERT_EQUAL_PTR(&g_rx_data[250], data);
+    UART_rx_consume(g_test_handle, 6);
+
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_0, 4);
+    TEST_ASSERT_EQUAL_UINT32(4, UART_rx_peek(g_test_handle, &data));
+    TEST_ASSERT_EQUAL_PTR(g_rx_data, data);
+    UART_rx_consume(g_test_handle, 4);
+
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_0, 4);
+    TEST_ASSERT_EQUAL_UINT32(0, UART_rx_peek(g_test_handle, &data));
+    TEST_ASSERT_NULL(data);
+    TEST_ASSERT_EQUAL_UINT32(0, UART_get_rx_overruns(g_test_handle));
+}
+
+static UART_LL_TxCompleteCallback g_tx_complete_callback;
+
+static void capture_tx_complete_callback(
+    UART_Bus bus,
+    UART_LL_TxCompleteCallback callback,
+    int num_calls
+)
+{
+    (void)bus;
+    (void)num_calls;
+    g_tx_complete_callback = callback;
+}
+
+void test_UART_passthrough_tx_complete_sends_new_rx_data(void)
+{
+    // Arrange - Two buses in passthrough
+    CircularBuffer rx_buffer2, tx_buffer2;
+    uint8_t rx_data2[256], tx_data2[256];
+    circular_buffer_init(&rx_buffer2, rx_data2, sizeof(rx_data2));
+    circular_buffer_init(&tx_buffer2, tx_data2, sizeof(tx_data2));
+
+    UART_LL_init_Expect(UART_BUS_0, g_rx_data, sizeof(g_rx_data));
+    UART_LL_set_idle_callback_Ignore();
+    UART_LL_set_rx_complete_callback_Ignore();
+    UART_LL_set_tx_complete_callback_StubWithCallback(
+        capture_tx_complete_callback
+    );
+    UART_Handle *handle1 = UART_init(0, &g_rx_buffer, &g_tx_buffer);
+    UART_LL_init_Expect(UART_BUS_1, rx_data2, sizeof(rx_data2));
+    UART_Handle *handle2 = UART_init(1, &rx_buffer2, &tx_buffer2);
+
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_0, 0);
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_1, 0);
+    UART_enable_passthrough(handle1, handle2);
+
+    // Act - Bus 0 RX DMA wrote 4 bytes while bus 1 was sending
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_0, 4);
+    UART_LL_tx_busy_ExpectAndReturn(UART_BUS_1, false);
+    UART_LL_start_dma_tx_Expect(UART_BUS_1, g_rx_data, 4);
+    g_tx_complete_callback(UART_BUS_1, 0);
+
+    // Cleanup
+    UART_disable_passthrough(handle1, handle2);
+    UART_LL_deinit_Ignore();
+    UART_LL_set_idle_callback_Ignore();
+    UART_LL_set_rx_complete_callback_Ignore();
+    UART_LL_set_tx_complete_callback_Ignore();
+    UART_deinit(handle1);
+    UART_deinit(handle2);
+}
+
+static UART_LL_IdleCallback g_rx_timeout_callback;
+static uint32_t g_rx_timeout_bit_times;
+
+static void capture_rx_timeout(
+    UART_Bus bus,
+    uint32_t bit_times,
+    UART_LL_IdleCallback callback,
+    int num_calls
+)
+{
+    (void)bus;
+    (void)num_calls;
+    g_rx_timeout_bit_times = bit_times;
+    g_rx_timeout_callback = callback;
+}
+
+static uint32_t g_rx_callback_calls;
+static uint32_t g_rx_callback_bytes;
+
+static void count_rx_callback(UART_Handle *handle, uint32_t bytes_available)
+{
+    (void)handle;
+    ++g_rx_callback_calls;
+    g_rx_callback_bytes = bytes_available;
+}
+
+// Helper initializing bus 0 with a 64 byte threshold and a 500 us timeout
+static void init_with_rx_timeout(void)
+{
+    UART_LL_init_Expect(UART_BUS_0, g_rx_data, sizeof(g_rx_data));
+    UART_LL_set_idle_callback_StubWithCallback(capture_idle_callback);
+    UART_LL_set_rx_complete_callback_Ignore();
+    UART_LL_set_tx_complete_callback_Ignore();
+    g_test_handle = UART_init(0, &g_rx_buffer, &g_tx_buffer);
+
+    g_rx_callback_calls = 0;
+    UART_LL_get_dma_position_ExpectAndReturn(UART_BUS_0, 0);
+    UART_set_rx_callback(g_test_handle, count_rx_callback, 64);
+    UART_LL_set_rx_timeout_StubWithCallback(capture_rx_timeout);
+    UART_set_rx_timeout(g_test_handle, 500);
+}
+
+void test_UART_rx_timeout_since_first_byte(void)
+{
+    // Arrange - 500 us at 115200 baud, rounded up
+    init_with_rx_timeout();
+    TEST_ASSERT_EQUAL_UINT32(58, g_rx_timeout_bit_times);
+    TEST_ASSERT_NOT_NULL(g_rx_timeout_callback);
+
+    // Act & Assert - Five bytes stay below the threshold until the timeout
+    UART_LL_get_dma_position_IgnoreAndReturn(5);
+    PLATFORM_get_time_us_ExpectAndReturn(1000);
+    g_idle_callback(UART_BUS_0, 5);
+    PLATFORM_get_time_us_ExpectAndReturn(1499);
+    g_idle_callback(UART_BUS_0, 5);
+    TEST_ASSERT_EQUAL_UINT32(0, g_rx_callback_calls);
+
+    PLATFORM_get_time_us_ExpectAndReturn(1500);
+    g_idle_callback(UART_BUS_0, 5);
+    TEST_ASSERT_EQUAL_UINT32(1, g_rx_callback_calls);
+    TEST_ASSERT_EQUAL_UINT32(5, g_rx_callback_bytes);
+
+    // The threshold still triggers without a timeout
+    UART_LL_get_dma_position_IgnoreAndReturn(69);
+    g_idle_callback(UART_BUS_0, 69);
+    TEST_ASSERT_EQUAL_UINT32(2, g_rx_callback_calls);
+    TEST_ASSERT_EQUAL_UINT32(69, g_rx_callback_bytes);
+}
+
+void test_UART_rx_timeout_quiet_line(void)
+{
+    // Arrange
+    init_with_rx_timeout();
+
+    // Act - The USART reports a quiet line after three bytes
+    UART_LL_get_dma_position_IgnoreAndReturn(3);
+    g_rx_timeout_callback(UART_BUS_0, 3);
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT32(1, g_rx_callback_calls);
+    TEST_ASSERT_EQUAL_UINT32(3, g_rx_callback_bytes);
+
+    // Nothing new, nothing to report
+    UART_rx_consume(g_test_handle, 3);
+    g_rx_timeout_callback(UART_BUS_0, 3);
+    TEST_ASSERT_EQUAL_UINT32(1, g_rx_callback_calls);
+}
@@ -0,0 +1,287 @@
+/**
+ * @file test_update.c
+ * @brief Unit tests for A/B firmware updates
+ *
+ * The update area is replaced by a RAM array behind the mocked flash
+ * driver, which checks that every write lands on erased flash.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_flash_ll.h"
+
+#include "util/crc.h"
+#include "util/error.h"
+
+#include "update.h"
+
+enum {
+    SECTOR_COUNT = FLASH_LL_UPDATE_SIZE / FLASH_LL_SECTOR_SIZE,
+    CHECKSUM_OFFSET = 0x24C,
+    IMAGE_SIZE_OFFSET = 0x250,
+    IMAGE_CRC_OFFSET = 0x254,
+};
+
+static uint8_t g_area[FLASH_LL_UPDATE_SIZE];
+static uint32_t g_erase_counts[SECTOR_COUNT];
+
+static void update_read_stub(
+    uint32_t offset,
+    void *data,
+    uint32_t size,
+    int cmock_num_calls
+)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(sizeof(g_area), offset + size);
+    memcpy(data, &g_area[offset], size);
+}
+
+static void update_erase_stub(uint32_t offset, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_EQUAL_UINT32(0, offset % FLASH_LL_SECTOR_SIZE);
+    TEST_ASSERT_LESS_THAN_UINT32(sizeof(g_area), offset);
+    memset(&g_area[offset], 0xFF, FLASH_LL_SECTOR_SIZE);
+    g_erase_counts[offset / FLASH_LL_SECTOR_SIZE]++;
+}
+
+static void update_write_stub(
+    uint32_t offset,
+    void const *data,
+    uint32_t size,
+    int cmock_num_calls
+)
+{
+    (void)cmock_num_calls;
+    TEST_ASSERT_EQUAL_UINT32(0, offset % FLASH_LL_WRITE_ALIGN);
+    TEST_ASSERT_EQUAL_UINT32(0, size % FLASH_LL_WRITE_ALIGN);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(sizeof(g_area), offset + size);
+    for (uint32_t i = 0; i < size; ++i) {
+        TEST_ASSERT_EQUAL_HEX8(0xFF, g_area[offset + i]);
+    }
+    memcpy(&g_area[offset], data, size);
+}
+
+void setUp(void)
+{
+    mock_flash_ll_Init();
+    memset(g_area, 0, sizeof(g_area));
+    memset(g_erase_counts, 0, sizeof(g_erase_counts));
+    FLASH_LL_update_read_Stub(update_read_stub);
+    FLASH_LL_update_erase_Stub(update_erase_stub);
+    FLASH_LL_update_write_Stub(update_write_stub);
+}
+
+void tearDown(void)
+{
+    mock_flash_ll_Verify();
+    mock_flash_ll_Destroy();
+}
+
+static uint32_t area_word(uint32_t offset)
+{
+    uint32_t word = 0;
+    memcpy(&word, &g_area[offset], sizeof(word));
+    return word;
+}
+
+/**
+ * @brief Write a test image of the given size in 128 byte parts
+ */
+static void write_image(uint32_t size)
+{
+    uint8_t part[128];
+
+    for (uint32_t offset = 0; offset < size; offset += sizeof(part)) {
+        uint32_t const left = size - offset;
+        uint32_t const chunk = left < sizeof(part) ? left : sizeof(part);
+        for (uint32_t i = 0; i < chunk; ++i) {
+            part[i] = (uint8_t)((offset + i) * 7U);
+        }
+        UPDATE_write(offset, part, chunk);
+    }
+}
+
+// Test: Starting an update invalidates the previous image
+void test_UPDATE_begin_erases_first_sector(void)
+{
+    UPDATE_begin();
+
+    TEST_ASSERT_EQUAL(UPDATE_STATE_RECEIVING, UPDATE_get_state());
+    TEST_ASSERT_EQUAL_UINT32(1, g_erase_counts[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, g_erase_counts[1]);
+}
+
+// Test: Parts are refused once the image is sealed
+void test_UPDATE_write_after_finish(void)
+{
+    uint8_t const part[16] = { 0 };
+    Error err = ERROR_NONE;
+
+    UPDATE_begin();
+    write_image(1024);
+    UPDATE_finish();
+
+    TRY { UPDATE_write(0, part, sizeof(part)); }
+    CATCH(err) {}
+
+    TEST_ASSERT_EQUAL(ERROR_DEVICE_NOT_READY, err);
+}
+
+// Test: Parts must start on the flash programming unit
+void test_UPDATE_write_misaligned(void)
+{
+    uint8_t const part[16] = { 0 };
+    Error err = ERROR_NONE;
+
+    UPDATE_begin();
+    TRY { UPDATE_write(2056, part, sizeof(part)); }
+    CATCH(err) {}
+
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, err);
+}
+
+// Test: Parts past the end of the update area are refused
+void test_UPDATE_write_too_large(void)
+{
+    uint8_t const part[32] = { 0 };
+    Error err = ERROR_NONE;
+
+    UPDATE_begin();
+    TRY { UPDATE_write(FLASH_LL_UPDATE_SIZE - 16, part, sizeof(part)); }
+    CATCH(err) {}
+
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, err);
+}
+
+// Test: Each sector is erased once, as the image reaches it
+void test_UPDATE_write_erases_sectors_once(void)
+{
+    UPDATE_begin();
+    write_image(3 * FLASH_LL_SECTOR_SIZE - 512);
+
+    TEST_ASSERT_EQUAL_UINT32(1, g_erase_counts[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, g_erase_counts[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, g_erase_counts[2]);
+    TEST_ASSERT_EQUAL_UINT32(0, g_erase_counts[3]);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t)(5000 * 7U), g_area[5000]);
+}
+
+// Test: The first block is only programmed when the image is sealed
+void test_UPDATE_first_block_programmed_last(void)
+{
+    UPDATE_begin();
+    write_image(2048);
+
+    TEST_ASSERT_EQUAL_HEX8(0xFF, g_area[0]);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t)(1024 * 7U), g_area[1024]);
+
+    UPDATE_finish();
+
+    TEST_ASSERT_EQUAL_HEX8((uint8_t)(4 * 7U), g_area[4]);
+    TEST_ASSERT_EQUAL(UPDATE_STATE_READY, UPDATE_get_state());
+}
+
+// Test: The sealed image carries what the bootloader checks
+void test_UPDATE_finish_seals_image(void)
+{
+    enum { size = 3000 };
+    static uint32_t words[size / 4];
+
+    UPDATE_begin();
+    write_image(size);
+    UPDATE_finish();
+
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < 7; ++i) {
+        sum += area_word(i * 4);
+    }
+    TEST_ASSERT_EQUAL_HEX32(0, sum + area_word(CHECKSUM_OFFSET));
+    TEST_ASSERT_EQUAL_UINT32(size, area_word(IMAGE_SIZE_OFFSET));
+
+    memcpy(words, g_area, size);
+    uint32_t crc = CRC32_update_words(CRC32_INIT, words, IMAGE_SIZE_OFFSET / 4);
+    crc = CRC32_update_words(
+        crc,
+        &words[IMAGE_CRC_OFFSET / 4 + 1],
+        size / 4 - (IMAGE_CRC_OFFSET / 4 + 1)
+    );
+    TEST_ASSERT_EQUAL_HEX32(crc, area_word(IMAGE_CRC_OFFSET));
+}
+
+// Test: Sectors the image skips are erased before it is sealed
+void test_UPDATE_finish_erases_gaps(void)
+{
+    uint8_t const part[16] = { 1, 2, 3 };
+    uint32_t const last = 2 * FLASH_LL_SECTOR_SIZE;
+
+    // The previous image is still in the sector the new one skips
+    memset(&g_area[FLASH_LL_SECTOR_SIZE], 0x5A, FLASH_LL_SECTOR_SIZE);
+    UPDATE_begin();
+    write_image(2048);
+    UPDATE_write(last, part, sizeof(part));
+    UPDATE_finish();
+
+    TEST_ASSERT_EQUAL_UINT32(1, g_erase_counts[1]);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, g_area[FLASH_LL_SECTOR_SIZE]);
+    TEST_ASSERT_EQUAL_HEX8(3, g_area[last + 2]);
+}
+
+// Test: A short last part is padded like erased flash
+void test_UPDATE_write_pads_last_part(void)
+{
+    uint8_t const part[5] = { 1, 2, 3, 4, 5 };
+
+    UPDATE_begin();
+    write_image(2048);
+    UPDATE_write(2048, part, sizeof(part));
+    UPDATE_finish();
+
+    TEST_ASSERT_EQUAL_HEX8(5, g_area[2052]);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, g_area[2053]);
+    TEST_ASSERT_EQUAL_UINT32(2056, area_word(IMAGE_SIZE_OFFSET));
+}
+
+// Test: An image without a complete vector table cannot be sealed
+void test_UPDATE_finish_too_short(void)
+{
+    Error err = ERROR_NONE;
+
+    UPDATE_begin();
+    write_image(256);
+    TRY { UPDATE_finish(); }
+    CATCH(err) {}
+
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, err);
+    TEST_ASSERT_EQUAL(UPDATE_STATE_RECEIVING, UPDATE_get_state());
+}
+
+// Test: Only a sealed image can be applied
+void test_UPDATE_apply_not_ready(void)
+{
+    Error err = ERROR_NONE;
+
+    UPDATE_begin();
+    write_image(1024);
+    TRY { UPDATE_apply(); }
+    CATCH(err) {}
+
+    TEST_ASSERT_EQUAL(ERROR_DEVICE_NOT_READY, err);
+}
+
+// Test: Applying a sealed image asks the bootloader to swap banks
+void test_UPDATE_apply_requests_swap(void)
+{
+    UPDATE_begin();
+    write_image(1024);
+    UPDATE_finish();
+
+    FLASH_LL_request_bank_swap_Expect();
+    UPDATE_apply();
+}
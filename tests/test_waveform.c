@@ -0,0 +1,162 @@
+/**
+ * @file test_waveform.c
+ * @brief Unit tests for the waveform measurement engine
+ *
+ * @author PSLab Team
+ * @date 2025-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "util/error.h"
+#include "util/fixed_point.h"
+
+#include "waveform.h"
+
+enum {
+    SQUARE_PERIOD = 10,
+    SQUARE_CYCLES = 4,
+    SQUARE_SAMPLES = SQUARE_PERIOD * SQUARE_CYCLES,
+    // One sample period in measured time units
+    SAMPLE_TIME = 1 << WAVEFORM_TIME_FRAC_BITS,
+};
+
+static uint16_t g_samples[2 * SQUARE_SAMPLES];
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Fill g_samples with a square wave, high for the last samples of a period
+static void fill_square(uint32_t high_samples, uint32_t stride)
+{
+    for (uint32_t i = 0; i < SQUARE_SAMPLES; ++i) {
+        uint32_t const phase = i % SQUARE_PERIOD;
+        bool const high = phase >= SQUARE_PERIOD - high_samples;
+        g_samples[i * stride] = high ? 1000 : 0;
+    }
+}
+
+// Helper expecting WAVEFORM_measure to reject its arguments
+static void assert_measure_rejected(
+    uint16_t const *samples,
+    uint32_t count,
+    uint32_t stride
+)
+{
+    CEXCEPTION_T exception = CEXCEPTION_NONE;
+    WAVEFORM_Measurements result;
+
+    TRY {
+        WAVEFORM_measure(samples, count, stride, &result);
+        TEST_FAIL_MESSAGE("Expected exception for invalid arguments");
+    }
+    CATCH(exception) {
+        TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, exception);
+    }
+}
+
+// Test: Amplitude statistics of a square wave
+void test_WAVEFORM_measure_square_amplitude(void)
+{
+    WAVEFORM_Measurements result;
+    fill_square(SQUARE_PERIOD / 2, 1);
+
+    WAVEFORM_measure(g_samples, SQUARE_SAMPLES, 1, &result);
+
+    TEST_ASSERT_EQUAL_UINT16(0, result.min);
+    TEST_ASSERT_EQUAL_UINT16(1000, result.max);
+    TEST_ASSERT_EQUAL_INT32(FIXED_FROM_INT(500), result.mean);
+    // sqrt(500000) = 707.10678 = 46340950 / 2^16
+    TEST_ASSERT_INT32_WITHIN(1, 46340950, result.rms);
+}
+
+// Test: Period and duty cycle over the complete cycles of a square wave
+void test_WAVEFORM_measure_square_timing(void)
+{
+    WAVEFORM_Measurements result;
+    fill_square(3, 1);
+
+    WAVEFORM_measure(g_samples, SQUARE_SAMPLES, 1, &result);
+
+    TEST_ASSERT_EQUAL_UINT32(SQUARE_CYCLES - 1, result.cycles);
+    TEST_ASSERT_EQUAL_UINT32(SQUARE_PERIOD * SAMPLE_TIME, result.period);
+    TEST_ASSERT_INT32_WITHIN(1, FIXED_FROM_FLOAT(0.3F), result.duty_cycle);
+}
+
+// Test: The rise time is interpolated between samples on the edge
+void test_WAVEFORM_measure_rise_time(void)
+{
+    WAVEFORM_Measurements result;
+    uint16_t const ramp[] = { 0, 0, 0, 250, 500, 750, 1000, 1000, 1000 };
+
+    WAVEFORM_measure(ramp, sizeof(ramp) / sizeof(ramp[0]), 1, &result);
+
+    // 10% at 2.4 samples, 90% at 5.6 samples
+    TEST_ASSERT_UINT32_WITHIN(2, 3.2F * SAMPLE_TIME, result.rise_time);
+    TEST_ASSERT_EQUAL_UINT32(0, result.cycles);
+    TEST_ASSERT_EQUAL_UINT32(0, result.period);
+}
+
+// Test: Noise within the hysteresis band does not add edges
+void test_WAVEFORM_measure_ignores_noise_near_midpoint(void)
+{
+    WAVEFORM_Measurements result;
+    fill_square(SQUARE_PERIOD / 2, 1);
+    // Dither around the midpoint on each rising edge
+    for (uint32_t i = SQUARE_PERIOD / 2; i < SQUARE_SAMPLES;
+         i += SQUARE_PERIOD) {
+        g_samples[i] = 520;
+        g_samples[i + 1] = 480;
+    }
+
+    WAVEFORM_measure(g_samples, SQUARE_SAMPLES, 1, &result);
+
+    TEST_ASSERT_EQUAL_UINT32(SQUARE_CYCLES - 1, result.cycles);
+    TEST_ASSERT_UINT32_WITHIN(
+        SAMPLE_TIME, SQUARE_PERIOD * SAMPLE_TIME, result.period
+    );
+}
+
+// Test: A channel of interleaved frames is measured on its own
+void test_WAVEFORM_measure_stride(void)
+{
+    WAVEFORM_Measurements result;
+    fill_square(SQUARE_PERIOD / 2, 2);
+    for (uint32_t i = 0; i < SQUARE_SAMPLES; ++i) {
+        g_samples[(2 * i) + 1] = 3000;
+    }
+
+    WAVEFORM_measure(g_samples, SQUARE_SAMPLES, 2, &result);
+
+    TEST_ASSERT_EQUAL_UINT16(1000, result.max);
+    TEST_ASSERT_EQUAL_UINT32(SQUARE_PERIOD * SAMPLE_TIME, result.period);
+}
+
+// Test: A signal swinging less than WAVEFORM_SWING_MIN has no timing
+void test_WAVEFORM_measure_flat_signal(void)
+{
+    WAVEFORM_Measurements result;
+    for (uint32_t i = 0; i < SQUARE_SAMPLES; ++i) {
+        g_samples[i] = 2000 + (i % 2) * (WAVEFORM_SWING_MIN - 1);
+    }
+
+    WAVEFORM_measure(g_samples, SQUARE_SAMPLES, 1, &result);
+
+    TEST_ASSERT_EQUAL_UINT32(0, result.cycles);
+    TEST_ASSERT_EQUAL_UINT32(0, result.period);
+    TEST_ASSERT_EQUAL_UINT32(0, result.rise_time);
+    TEST_ASSERT_EQUAL_INT32(0, result.duty_cycle);
+}
+
+// Test: Invalid buffers and sizes are rejected
+void test_WAVEFORM_measure_invalid(void)
+{
+    assert_measure_rejected(nullptr, 4, 1);
+    assert_measure_rejected(g_samples, 0, 1);
+    assert_measure_rejected(g_samples, WAVEFORM_SAMPLES_MAX + 1, 1);
+    assert_measure_rejected(g_samples, 4, 0);
+}
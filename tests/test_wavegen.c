@@ -0,0 +1,279 @@
+/**
+ * @file test_wavegen.c
+ * @brief Unit tests for the waveform generator
+ *
+ * The DAC and the timer are mocked; the table handed to DAC_LL_init is
+ * checked against the requested shape, and in DDS mode the ring is refilled
+ * through the captured block callback.
+ *
+ * @author PSLab Team
+ * @date 2026-10-14
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+#include "mock_clock.h"
+#include "mock_dac_ll.h"
+#include "mock_tim_ll.h"
+
+#include "util/error.h"
+#include "util/fixed_point.h"
+
+#include "wavegen.h"
+
+static WAVEGEN_Handle *g_handle;
+static DAC_LL_Config g_dac_config;
+
+static void dac_ll_init_stub(DAC_LL_Config const *config, int cmock_num_calls)
+{
+    (void)cmock_num_calls;
+    g_dac_config = *config;
+}
+
+/**
+ * @brief Init a standard shape at 1 kHz, which gets 1000 codes
+ */
+static WAVEGEN_Handle *init_shape(WAVEGEN_Shape shape)
+{
+    WAVEGEN_Config config = WAVEGEN_CONFIG_DEFAULT;
+    config.shape = shape;
+
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_7, 1000000, 1000000);
+    return WAVEGEN_init(&config);
+}
+
+void setUp(void)
+{
+    mock_clock_Init();
+    mock_dac_ll_Init();
+    mock_tim_ll_Init();
+
+    g_handle = NULL;
+    memset(&g_dac_config, 0, sizeof(g_dac_config));
+
+    DAC_LL_init_Stub(dac_ll_init_stub);
+    CLOCK_request_Ignore();
+    CLOCK_release_Ignore();
+}
+
+void tearDown(void)
+{
+    if (g_handle != NULL) {
+        TIM_LL_stop_Ignore();
+        TIM_LL_deinit_Ignore();
+        DAC_LL_stop_Ignore();
+        DAC_LL_deinit_Ignore();
+        WAVEGEN_deinit(g_handle);
+    }
+
+    mock_clock_Verify();
+    mock_clock_Destroy();
+    mock_dac_ll_Verify();
+    mock_dac_ll_Destroy();
+    mock_tim_ll_Verify();
+    mock_tim_ll_Destroy();
+}
+
+// Test: A sine over the full range swings from 0 to 4095 around 1.65 V
+void test_WAVEGEN_sine_table(void)
+{
+    g_handle = init_shape(WAVEGEN_SHAPE_SINE);
+
+    TEST_ASSERT_EQUAL(TIM_NUM_7, g_dac_config.timer);
+    TEST_ASSERT_EQUAL_UINT32(1000, g_dac_config.count);
+    TEST_ASSERT_EQUAL_UINT16(2047, g_dac_config.samples[0]);
+    TEST_ASSERT_EQUAL_UINT16(4095, g_dac_config.samples[250]);
+    TEST_ASSERT_EQUAL_UINT16(2047, g_dac_config.samples[500]);
+    TEST_ASSERT_EQUAL_UINT16(0, g_dac_config.samples[750]);
+}
+
+// Test: The other standard shapes follow their definitions
+void test_WAVEGEN_standard_shapes(void)
+{
+    g_handle = init_shape(WAVEGEN_SHAPE_SQUARE);
+    TEST_ASSERT_EQUAL_UINT16(4095, g_dac_config.samples[0]);
+    TEST_ASSERT_EQUAL_UINT16(4095, g_dac_config.samples[499]);
+    TEST_ASSERT_EQUAL_UINT16(0, g_dac_config.samples[500]);
+    TEST_ASSERT_EQUAL_UINT16(0, g_dac_config.samples[999]);
+    TIM_LL_stop_Ignore();
+    TIM_LL_deinit_Ignore();
+    DAC_LL_stop_Ignore();
+    DAC_LL_deinit_Ignore();
+    WAVEGEN_deinit(g_handle);
+
+    g_handle = init_shape(WAVEGEN_SHAPE_TRIANGLE);
+    TEST_ASSERT_EQUAL_UINT16(0, g_dac_config.samples[0]);
+    TEST_ASSERT_EQUAL_UINT16(2047, g_dac_config.samples[250]);
+    TEST_ASSERT_EQUAL_UINT16(4095, g_dac_config.samples[500]);
+    TEST_ASSERT_EQUAL_UINT16(2047, g_dac_config.samples[750]);
+    WAVEGEN_deinit(g_handle);
+
+    g_handle = init_shape(WAVEGEN_SHAPE_SAWTOOTH);
+    TEST_ASSERT_EQUAL_UINT16(0, g_dac_config.samples[0]);
+    TEST_ASSERT_EQUAL_UINT16(2047, g_dac_config.samples[500]);
+    TEST_ASSERT_UINT16_WITHIN(5, 4091, g_dac_config.samples[999]);
+}
+
+// Test: Voltages beyond the output range are clipped
+void test_WAVEGEN_clips_to_range(void)
+{
+    WAVEGEN_Config config = WAVEGEN_CONFIG_DEFAULT;
+    config.shape = WAVEGEN_SHAPE_SQUARE;
+    config.amplitude = FIXED_from_int(3);
+
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_7, 1000000, 1000000);
+    g_handle = WAVEGEN_init(&config);
+
+    TEST_ASSERT_EQUAL_UINT16(4095, g_dac_config.samples[0]);
+    TEST_ASSERT_EQUAL_UINT16(0, g_dac_config.samples[999]);
+}
+
+// Test: Low frequencies are limited by the table, and the achieved
+// frequency is kept
+void test_WAVEGEN_frequency(void)
+{
+    WAVEGEN_Config config = WAVEGEN_CONFIG_DEFAULT;
+    config.frequency = 10;
+
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_7, 40960, 40967);
+    g_handle = WAVEGEN_init(&config);
+
+    TEST_ASSERT_EQUAL_UINT32(WAVEGEN_SAMPLES_MAX, g_dac_config.count);
+    WAVEGEN_Config const actual = WAVEGEN_get_config(g_handle);
+    TEST_ASSERT_EQUAL_UINT32(10, actual.frequency);
+    TEST_ASSERT_EQUAL_UINT32(WAVEGEN_SAMPLES_MAX, actual.sample_count);
+}
+
+// Test: Arbitrary codes are copied into the table
+void test_WAVEGEN_arbitrary(void)
+{
+    uint16_t samples[] = { 0, 1000, 4095, 3000 };
+    WAVEGEN_Config config = WAVEGEN_CONFIG_DEFAULT;
+    config.shape = WAVEGEN_SHAPE_ARBITRARY;
+    config.frequency = 250000;
+    config.samples = samples;
+    config.sample_count = 4;
+
+    TIM_LL_init_ExpectAndReturn(TIM_NUM_7, 1000000, 1000000);
+    g_handle = WAVEGEN_init(&config);
+    samples[0] = 1;
+
+    TEST_ASSERT_EQUAL_UINT32(4, g_dac_config.count);
+    TEST_ASSERT_NOT_EQUAL(samples, g_dac_config.samples);
+    TEST_ASSERT_EQUAL_UINT16(0, g_dac_config.samples[0]);
+    TEST_ASSERT_EQUAL_UINT16(3000, g_dac_config.samples[3]);
+}
+
+// Test: Invalid configurations are refused before the hardware is touched
+void test_WAVEGEN_init_invalid(void)
+{
+    uint16_t samples[] = { 0, 4096 };
+    WAVEGEN_Config config = WAVEGEN_CONFIG_DEFAULT;
+    Error error = ERROR_NONE;
+
+    config.frequency = WAVEGEN_FREQUENCY_MAX + 1;
+    TRY { WAVEGEN_init(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    config.shape = WAVEGEN_SHAPE_ARBITRARY;
+    config.frequency = 1000;
+    config.samples = samples;
+    config.sample_count = 2;
+    error = ERROR_NONE;
+    TRY { WAVEGEN_init(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    samples[1] = 4095;
+    config.frequency = WAVEGEN_SAMPLE_RATE_MAX;
+    error = ERROR_NONE;
+    TRY { WAVEGEN_init(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    // DDS synthesizes standard shapes only
+    config.mode = WAVEGEN_MODE_DDS;
+    config.frequency = 1000;
+    error = ERROR_NONE;
+    TRY { WAVEGEN_init(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+
+    config.shape = WAVEGEN_SHAPE_SINE;
+    config.millihertz = 1000;
+    error = ERROR_NONE;
+    TRY { WAVEGEN_init(&config); }
+    CATCH(error) {}
+    TEST_ASSERT_EQUAL(ERROR_INVALID_ARGUMENT, error);
+}
+
+// Test: DDS streams a ring that the DMA interrupt refills, one period per
+// ring at 1953.125 Hz
+void test_WAVEGEN_dds_ring(void)
+{
+    WAVEGEN_Config config = WAVEGEN_CONFIG_DEFAULT;
+    config.mode = WAVEGEN_MODE_DDS;
+    config.frequency = 1953;
+    config.millihertz = 125;
+
+    TIM_LL_init_ExpectAndReturn(
+        TIM_NUM_7, WAVEGEN_DDS_SAMPLE_RATE, WAVEGEN_DDS_SAMPLE_RATE
+    );
+    g_handle = WAVEGEN_init(&config);
+    TEST_ASSERT_EQUAL_UINT32(512, g_dac_config.count);
+    TEST_ASSERT_NOT_NULL(g_dac_config.block_callback);
+
+    // Start fills both halves from phase 0
+    DAC_LL_start_Expect();
+    TIM_LL_start_Expect(TIM_NUM_7);
+    WAVEGEN_start(g_handle);
+    TEST_ASSERT_EQUAL_UINT16(2047, g_dac_config.samples[0]);
+    TEST_ASSERT_EQUAL_UINT16(4095, g_dac_config.samples[128]);
+    TEST_ASSERT_EQUAL_UINT16(2047, g_dac_config.samples[256]);
+    TEST_ASSERT_EQUAL_UINT16(0, g_dac_config.samples[384]);
+
+    // The phase continues into each refilled half
+    g_dac_config.samples[0] = 1;
+    g_dac_config.samples[128] = 1;
+    g_dac_config.block_callback(g_dac_config.samples, 256);
+    TEST_ASSERT_EQUAL_UINT16(2047, g_dac_config.samples[0]);
+    TEST_ASSERT_EQUAL_UINT16(4095, g_dac_config.samples[128]);
+}
+
+// Test: DDS resolves the frequency to the millihertz
+void test_WAVEGEN_dds_millihertz(void)
+{
+    WAVEGEN_Config config = WAVEGEN_CONFIG_DEFAULT;
+    config.mode = WAVEGEN_MODE_DDS;
+    config.millihertz = 1;
+
+    TIM_LL_init_ExpectAndReturn(
+        TIM_NUM_7, WAVEGEN_DDS_SAMPLE_RATE, WAVEGEN_DDS_SAMPLE_RATE
+    );
+    g_handle = WAVEGEN_init(&config);
+
+    WAVEGEN_Config const actual = WAVEGEN_get_config(g_handle);
+    TEST_ASSERT_EQUAL(WAVEGEN_MODE_DDS, actual.mode);
+    TEST_ASSERT_EQUAL_UINT32(1000, actual.frequency);
+    TEST_ASSERT_EQUAL_UINT32(1, actual.millihertz);
+}
+
+// Test: Start arms the DAC before the timer, and stop halts both
+void test_WAVEGEN_start_stop(void)
+{
+    g_handle = init_shape(WAVEGEN_SHAPE_SINE);
+
+    DAC_LL_start_Expect();
+    TIM_LL_start_Expect(TIM_NUM_7);
+    WAVEGEN_start(g_handle);
+    TEST_ASSERT_TRUE(WAVEGEN_is_running(g_handle));
+
+    TIM_LL_stop_Expect(TIM_NUM_7);
+    DAC_LL_stop_Expect();
+    WAVEGEN_stop(g_handle);
+    TEST_ASSERT_FALSE(WAVEGEN_is_running(g_handle));
+}